@@ -19,18 +19,38 @@
 //
 
 #define _CUPS_MAXSAVE	32		// Maximum number of saves
+#define _CUPS_ACHUNK	512		// Number of elements per chunk
+#define _CUPS_AMAXFLAT	2048		// Maximum elements before switching to chunks
+#define _CUPS_AMINCHUNK	1024		// Minimum elements before switching back to a flat array
+#define _CUPS_AMINTABLE	32		// Minimum size of hash table
 
 
 //
 // Types and structures...
 //
 
+typedef struct _cups_achunk_s		// Chunk of array elements
+{
+  size_t		num_elements;	// Number of elements in chunk
+  void			*elements[_CUPS_ACHUNK];
+					// Elements
+} _cups_achunk_t;
+
+typedef struct _cups_aslot_s		// Hash table slot
+{
+  size_t		index,		// Element index or `SIZE_MAX` if empty
+			hash;		// Hash value
+} _cups_aslot_t;
+
 struct _cups_array_s			// CUPS array structure
 {
   // The current implementation uses an insertion sort into an array of
-  // sorted pointers.  We leave the array type private/opaque so that we
-  // can change the underlying implementation without affecting the users
-  // of this API.
+  // sorted pointers.  Once an array grows past _CUPS_AMAXFLAT elements, the
+  // pointers are moved into fixed-size chunks with a sorted directory of
+  // starting indices (a two-level B-tree), so that adding or removing an
+  // element only moves the pointers in a single chunk.  We leave the array
+  // type private/opaque so that we can change the underlying implementation
+  // without affecting the users of this API.
 
   size_t		num_elements,	// Number of array elements
 			alloc_elements,	// Allocated array elements
@@ -39,7 +59,12 @@ struct _cups_array_s			// CUPS array structure
 			num_saved,	// Number of saved elements
 			saved[_CUPS_MAXSAVE];
 					// Saved elements
-  void			**elements;	// Array elements
+  void			**elements;	// Array elements (flat array)
+  size_t		num_chunks,	// Number of chunks
+			alloc_chunks,	// Allocated chunks
+			*chunk_starts,	// Index of first element in each chunk
+			chunk;		// Last chunk used
+  _cups_achunk_t	**chunks;	// Array element chunks
   cups_array_cb_t	compare;	// Element comparison function
   bool			unique;		// Are all elements unique?
   void			*data;		// User data passed to compare
@@ -48,6 +73,9 @@ struct _cups_array_s			// CUPS array structure
 			*hash;		// Hash array
   cups_acopy_cb_t	copyfunc;	// Copy function
   cups_afree_cb_t	freefunc;	// Free function
+  cups_array_cb_t	equal;		// Equality function for hashed arrays
+  size_t		table_size;	// Size of hash table (power of 2)
+  _cups_aslot_t		*table;		// Hash table for hashed arrays
 };
 
 
@@ -56,7 +84,19 @@ struct _cups_array_s			// CUPS array structure
 //
 
 static bool	cups_array_add(cups_array_t *a, void *e, bool insert);
+static bool	cups_array_add_chunk(cups_array_t *a, size_t n);
+static void	**cups_array_element(cups_array_t *a, size_t n);
 static size_t	cups_array_find(cups_array_t *a, void *e, size_t prev, int *rdiff);
+static void	cups_array_free_chunks(cups_array_t *a);
+static void	cups_array_hash_add(cups_array_t *a, size_t n);
+static size_t	cups_array_hash_find(cups_array_t *a, void *e, size_t hash);
+static void	cups_array_hash_remove(cups_array_t *a, size_t slot);
+static bool	cups_array_hash_resize(cups_array_t *a, size_t size);
+static void	**cups_array_insert_at(cups_array_t *a, size_t n);
+static size_t	cups_array_locate(cups_array_t *a, size_t n, size_t *offset);
+static bool	cups_array_make_chunks(cups_array_t *a);
+static void	cups_array_remove_at(cups_array_t *a, size_t n);
+static void	cups_array_sort(cups_array_t *a, void **e, void **temp, size_t num_e);
 
 
 //
@@ -81,6 +121,169 @@ cupsArrayAdd(cups_array_t *a,		// I - Array
 }
 
 
+//
+// 'cupsArrayAddBatch()' - Add multiple elements to an array.
+//
+// This function adds "num_e" elements to an array.  The result is the same as
+// calling @link cupsArrayAdd@ for each element in order, however elements
+// added to a sorted array are sorted and merged with the existing elements in
+// a single pass, which is much faster for large numbers of elements.
+//
+// If any of the elements is `NULL`, no elements are added and `false` is
+// returned.
+//
+
+bool					// O - `true` on success, `false` on failure
+cupsArrayAddBatch(cups_array_t *a,	// I - Array
+                  void         **e,	// I - Elements
+                  size_t       num_e)	// I - Number of elements
+{
+  size_t	i,			// Looping var
+		j,			// Looping var
+		k,			// Looping var
+		m,			// Looping var
+		num_elements,		// Number of elements after merge
+		current,		// Current element before merge
+		saved[_CUPS_MAXSAVE];	// Saved elements before merge
+  void		**batch,		// Sorted copy of new elements
+		**merged,		// Merged elements
+		*last,			// Last element added
+		*element;		// Current existing element
+  int		diff;			// Comparison result
+
+
+  // Range check input...
+  if (!a || (num_e > 0 && !e))
+    return (false);
+  else if (num_e == 0)
+    return (true);
+
+  for (i = 0; i < num_e; i ++)
+  {
+    if (!e[i])
+      return (false);
+  }
+
+  if (!a->compare || (num_e * 32) < a->num_elements)
+  {
+    // Unsorted arrays, or a few elements added to a large array, are faster to
+    // add one at a time...
+    for (i = 0; i < num_e; i ++)
+    {
+      if (!cups_array_add(a, e[i], false))
+        return (false);
+    }
+
+    return (true);
+  }
+
+  // Copy and sort the new elements...
+  num_elements = a->num_elements + num_e;
+
+  if ((batch = _cupsMemAlloc(CUPS_MEMTYPE_ARRAY, 2 * num_e * sizeof(void *))) == NULL)
+    return (false);
+
+  if ((merged = _cupsMemAlloc(CUPS_MEMTYPE_ARRAY, num_elements * sizeof(void *))) == NULL)
+  {
+    _cupsMemFree(batch);
+    return (false);
+  }
+
+  for (i = 0; i < num_e; i ++)
+  {
+    if (!a->copyfunc)
+    {
+      batch[i] = e[i];
+    }
+    else if ((batch[i] = (a->copyfunc)(e[i], a->data)) == NULL)
+    {
+      // Unable to copy, free the copies so far and return...
+      if (a->freefunc)
+      {
+        while (i > 0)
+          (a->freefunc)(batch[-- i], a->data);
+      }
+
+      _cupsMemFree(batch);
+      _cupsMemFree(merged);
+
+      return (false);
+    }
+  }
+
+  last = batch[num_e - 1];
+
+  cups_array_sort(a, batch, batch + num_e, num_e);
+
+  current = a->current;
+  memcpy(saved, a->saved, sizeof(saved));
+
+  // Merge the existing and new elements, keeping new elements at the end of
+  // any run of equal elements...
+  for (i = 0, j = 0, k = 0; k < num_elements; k ++)
+  {
+    if (i < a->num_elements)
+    {
+      element = *cups_array_element(a, i);
+
+      if (j < num_e)
+      {
+        if ((diff = (*(a->compare))(batch[j], element, a->data)) == 0)
+          a->unique = false;
+      }
+      else
+      {
+        diff = 0;
+      }
+    }
+    else
+    {
+      element = NULL;
+      diff    = -1;
+    }
+
+    if (diff >= 0)
+    {
+      // Copy existing element, updating the current and saved elements...
+      merged[k] = element;
+
+      if (current == i)
+        a->current = k;
+
+      for (m = 0; m < a->num_saved; m ++)
+      {
+        if (saved[m] == i)
+          a->saved[m] = k;
+      }
+
+      i ++;
+    }
+    else
+    {
+      // Copy new element...
+      merged[k] = batch[j ++];
+
+      if (merged[k] == last)
+        a->insert = k;
+    }
+  }
+
+  // Replace the existing elements...
+  cups_array_free_chunks(a);
+  _cupsMemFree(a->elements);
+  _cupsMemFree(batch);
+
+  a->elements       = merged;
+  a->alloc_elements = num_elements;
+  a->num_elements   = num_elements;
+
+  if (a->num_elements >= _CUPS_AMAXFLAT)
+    cups_array_make_chunks(a);
+
+  return (true);
+}
+
+
 //
 // 'cupsArrayAddStrings()' - Add zero or more delimited strings to an array.
 //
@@ -128,7 +331,7 @@ cupsArrayAddStrings(cups_array_t *a,	// I - Array
     if (!cupsArrayFind(a, (void *)s))
       status = cupsArrayAdd(a, (void *)s);
   }
-  else if ((buffer = strdup(s)) == NULL)
+  else if ((buffer = _cupsMemStrdup(CUPS_MEMTYPE_ARRAY, s)) == NULL)
   {
     status = false;
   }
@@ -182,7 +385,7 @@ cupsArrayAddStrings(cups_array_t *a,	// I - Array
         status &= cupsArrayAdd(a, start);
     }
 
-    free(buffer);
+    _cupsMemFree(buffer);
   }
 
   return (status);
@@ -207,14 +410,23 @@ cupsArrayClear(cups_array_t *a)		// I - Array
   if (a->freefunc)
   {
     size_t	i;			// Looping var
-    void	**e;			// Current element
 
-    for (i = a->num_elements, e = a->elements; i > 0; i --, e ++)
-      (a->freefunc)(*e, a->data);
+    for (i = 0; i < a->num_elements; i ++)
+      (a->freefunc)(*cups_array_element(a, i), a->data);
   }
 
-  // Set the number of elements to 0; we don't actually free the memory
+  // Set the number of elements to 0; we don't actually free the flat array
   // here - that is done in cupsArrayDelete()...
+  cups_array_free_chunks(a);
+
+  if (a->table)
+  {
+    size_t	i;			// Looping var
+
+    for (i = 0; i < a->table_size; i ++)
+      a->table[i].index = SIZE_MAX;
+  }
+
   a->num_elements = 0;
   a->current      = SIZE_MAX;
   a->insert       = SIZE_MAX;
@@ -241,9 +453,12 @@ cupsArrayDelete(cups_array_t *a)	// I - Array
   cupsArrayClear(a);
 
   // Free the other buffers...
-  free(a->elements);
-  free(a->hash);
-  free(a);
+  _cupsMemFree(a->elements);
+  _cupsMemFree(a->chunks);
+  _cupsMemFree(a->chunk_starts);
+  _cupsMemFree(a->hash);
+  _cupsMemFree(a->table);
+  _cupsMemFree(a);
 }
 
 
@@ -262,11 +477,13 @@ cupsArrayDup(cups_array_t *a)		// I - Array
     return (NULL);
 
   // Allocate memory for the array...
-  da = calloc(1, sizeof(cups_array_t));
+  da = _cupsMemCalloc(CUPS_MEMTYPE_ARRAY, 1, sizeof(cups_array_t));
   if (!da)
     return (NULL);
 
   da->compare   = a->compare;
+  da->equal     = a->equal;
+  da->hashfunc  = a->hashfunc;
   da->copyfunc  = a->copyfunc;
   da->freefunc  = a->freefunc;
   da->data      = a->data;
@@ -277,13 +494,27 @@ cupsArrayDup(cups_array_t *a)		// I - Array
 
   memcpy(da->saved, a->saved, sizeof(a->saved));
 
+  if (a->table)
+  {
+    // Copy the hash table...
+    if ((da->table = _cupsMemAlloc(CUPS_MEMTYPE_ARRAY, a->table_size * sizeof(_cups_aslot_t))) == NULL)
+    {
+      _cupsMemFree(da);
+      return (NULL);
+    }
+
+    memcpy(da->table, a->table, a->table_size * sizeof(_cups_aslot_t));
+    da->table_size = a->table_size;
+  }
+
   if (a->num_elements)
   {
     // Allocate memory for the elements...
-    da->elements = malloc((size_t)a->num_elements * sizeof(void *));
+    da->elements = _cupsMemAlloc(CUPS_MEMTYPE_ARRAY, (size_t)a->num_elements * sizeof(void *));
     if (!da->elements)
     {
-      free(da);
+      _cupsMemFree(da->table);
+      _cupsMemFree(da);
       return (NULL);
     }
 
@@ -291,10 +522,21 @@ cupsArrayDup(cups_array_t *a)		// I - Array
     if (a->copyfunc)
     {
       // Use the copy function to make a copy of each element...
-      size_t	i;			// Looping var
+      size_t		i;		// Looping var
+      cups_array_iter_t	iter;		// Iterator
+
+      cupsArrayIterInit(a, &iter);
 
       for (i = 0; i < a->num_elements; i ++)
-	da->elements[i] = (a->copyfunc)(a->elements[i], a->data);
+	da->elements[i] = (a->copyfunc)(cupsArrayIterNext(&iter), a->data);
+    }
+    else if (a->chunks)
+    {
+      // Copy raw pointers from each chunk...
+      size_t	i;			// Looping var
+
+      for (i = 0; i < a->num_chunks; i ++)
+        memcpy(da->elements + a->chunk_starts[i], a->chunks[i]->elements, a->chunks[i]->num_elements * sizeof(void *));
     }
     else
     {
@@ -329,7 +571,21 @@ cupsArrayFind(cups_array_t *a,		// I - Array
     return (NULL);
 
   // Look for a match...
-  if (a->hash)
+  if (a->table)
+  {
+    // Look in the hash table...
+    if ((current = cups_array_hash_find(a, e, (*(a->hashfunc))(e, a->data))) < a->table_size)
+    {
+      a->current = a->table[current].index;
+
+      return (*cups_array_element(a, a->current));
+    }
+
+    a->current = SIZE_MAX;
+
+    return (NULL);
+  }
+  else if (a->hash)
   {
     if ((hash = (*(a->hashfunc))(e, a->data)) >= a->hashsize)
     {
@@ -353,7 +609,7 @@ cupsArrayFind(cups_array_t *a,		// I - Array
     if (!a->unique && a->compare)
     {
       // The array is not unique, find the first match...
-      while (current > 0 && !(*(a->compare))(e, a->elements[current - 1], a->data))
+      while (current > 0 && !(*(a->compare))(e, *cups_array_element(a, current - 1), a->data))
         current --;
     }
 
@@ -362,7 +618,7 @@ cupsArrayFind(cups_array_t *a,		// I - Array
     if (hash < a->hashsize)
       a->hash[hash] = current;
 
-    return (a->elements[current]);
+    return (*cups_array_element(a, current));
   }
   else
   {
@@ -402,7 +658,7 @@ cupsArrayGetCurrent(cups_array_t *a)	// I - Array
 
   // Return the current element...
   if (a->current < a->num_elements)
-    return (a->elements[a->current]);
+    return (*cups_array_element(a, a->current));
   else
     return (NULL);
 }
@@ -463,7 +719,7 @@ cupsArrayGetElement(cups_array_t *a,	// I - Array
 
   a->current = n;
 
-  return (a->elements[n]);
+  return (*cups_array_element(a, n));
 }
 
 
@@ -542,7 +798,8 @@ cupsArrayGetUserData(cups_array_t *a)	// I - Array
 // This function inserts an element in an array.  When inserting an element
 // in a sorted array, non-unique elements are inserted at the beginning of the
 // run of identical elements.  For unsorted arrays, the element is inserted at
-// the beginning of the array.
+// the beginning of the array.  For hashed arrays, the element is appended to
+// the end of the array.
 //
 
 bool					// O - `true` on success, `false` on failure
@@ -558,6 +815,155 @@ cupsArrayInsert(cups_array_t *a,	// I - Array
 }
 
 
+//
+// 'cupsArrayIterInit()' - Initialize an iterator for an array.
+//
+// This function initializes an iterator for traversing an array with the
+// @link cupsArrayIterNext@ and @link cupsArrayIterPrev@ functions.  Iterators
+// do not change the array, so multiple threads can traverse the same array at
+// the same time as long as no thread modifies it.
+//
+// ```
+// cups_array_iter_t iter;
+// void *e;
+//
+// cupsArrayIterInit(a, &iter);
+// while ((e = cupsArrayIterNext(&iter)) != NULL)
+// {
+//   ... do something with "e"
+// }
+// ```
+//
+
+void
+cupsArrayIterInit(cups_array_t      *a,	// I - Array
+                  cups_array_iter_t *iter)	// I - Iterator
+{
+  if (!iter)
+    return;
+
+  iter->array  = a;
+  iter->index  = SIZE_MAX;
+  iter->chunk  = 0;
+  iter->offset = 0;
+}
+
+
+//
+// 'cupsArrayIterNext()' - Get the next element using an iterator.
+//
+// This function returns the next element in the array.  The first call after
+// @link cupsArrayIterInit@ returns the first element.  Once the last element
+// has been returned, `NULL` is returned and the iterator is reset.
+//
+
+void *					// O - Next element or `NULL`
+cupsArrayIterNext(cups_array_iter_t *iter)	// I - Iterator
+{
+  cups_array_t	*a;			// Array
+
+
+  // Range check input...
+  if (!iter || (a = iter->array) == NULL)
+    return (NULL);
+
+  if (iter->index == SIZE_MAX)
+  {
+    // Start at the first element...
+    iter->index  = 0;
+    iter->chunk  = 0;
+    iter->offset = 0;
+  }
+  else
+  {
+    // Move to the next element...
+    iter->index ++;
+    iter->offset ++;
+
+    if (a->chunks && iter->chunk < a->num_chunks && iter->offset >= a->chunks[iter->chunk]->num_elements)
+    {
+      iter->chunk ++;
+      iter->offset = 0;
+    }
+  }
+
+  if (iter->index >= a->num_elements)
+  {
+    iter->index = SIZE_MAX;
+    return (NULL);
+  }
+  else if (a->chunks)
+  {
+    return (a->chunks[iter->chunk]->elements[iter->offset]);
+  }
+  else
+  {
+    return (a->elements[iter->index]);
+  }
+}
+
+
+//
+// 'cupsArrayIterPrev()' - Get the previous element using an iterator.
+//
+// This function returns the previous element in the array.  The first call
+// after @link cupsArrayIterInit@ returns the last element.  Once the first
+// element has been returned, `NULL` is returned and the iterator is reset.
+//
+
+void *					// O - Previous element or `NULL`
+cupsArrayIterPrev(cups_array_iter_t *iter)	// I - Iterator
+{
+  cups_array_t	*a;			// Array
+
+
+  // Range check input...
+  if (!iter || (a = iter->array) == NULL)
+    return (NULL);
+
+  if (a->num_elements == 0 || iter->index == 0 || (iter->index != SIZE_MAX && iter->index >= a->num_elements))
+  {
+    iter->index = SIZE_MAX;
+    return (NULL);
+  }
+  else if (iter->index == SIZE_MAX)
+  {
+    // Start at the last element...
+    iter->index = a->num_elements - 1;
+
+    if (a->chunks)
+    {
+      iter->chunk  = a->num_chunks - 1;
+      iter->offset = a->chunks[iter->chunk]->num_elements - 1;
+    }
+  }
+  else
+  {
+    // Move to the previous element...
+    iter->index --;
+
+    if (!a->chunks)
+    {
+      iter->offset = iter->index;
+    }
+    else if (iter->offset > 0)
+    {
+      iter->offset --;
+    }
+    else
+    {
+      iter->chunk --;
+      iter->offset = a->chunks[iter->chunk]->num_elements - 1;
+    }
+  }
+
+  if (a->chunks)
+    return (a->chunks[iter->chunk]->elements[iter->offset]);
+  else
+    return (a->elements[iter->index]);
+}
+
+
 //
 // 'cupsArrayNew()' - Create a new array with callback functions.
 //
@@ -627,7 +1033,7 @@ cupsArrayNew(cups_array_cb_t  f,	// I - Comparison callback function or `NULL` f
 
 
   // Allocate memory for the array...
-  if ((a = calloc(1, sizeof(cups_array_t))) == NULL)
+  if ((a = _cupsMemCalloc(CUPS_MEMTYPE_ARRAY, 1, sizeof(cups_array_t))) == NULL)
     return (NULL);
 
   a->compare   = f;
@@ -641,11 +1047,11 @@ cupsArrayNew(cups_array_cb_t  f,	// I - Comparison callback function or `NULL` f
   {
     a->hashfunc  = hf;
     a->hashsize  = hsize;
-    a->hash      = malloc((size_t)hsize * sizeof(size_t));
+    a->hash      = _cupsMemAlloc(CUPS_MEMTYPE_ARRAY, (size_t)hsize * sizeof(size_t));
 
     if (!a->hash)
     {
-      free(a);
+      _cupsMemFree(a);
       return (NULL);
     }
 
@@ -659,6 +1065,59 @@ cupsArrayNew(cups_array_cb_t  f,	// I - Comparison callback function or `NULL` f
 }
 
 
+//
+// 'cupsArrayNewHashed()' - Create a new hashed array.
+//
+// This function creates a new unsorted array that uses a hash table for
+// finding elements.  Finding, adding, and removing elements take constant time
+// on average.
+//
+// The hash callback function ("hf") receives a pointer to an element and the
+// user data pointer ("d") and returns a hash value for the element.  Unlike
+// @link cupsArrayNew@, the hash value can use the full range of `size_t`.
+//
+// The equality callback function ("f") receives pointers to two elements and
+// the user data pointer ("d") and returns `0` when the elements are equal.
+// Elements that are equal must have the same hash value.
+//
+// The copy ("cf") and free ("ff") callback functions are used as described for
+// @link cupsArrayNew@.
+//
+// Elements are kept in the order they are added.  Removing an element moves
+// the last element of the array into its place.
+//
+
+cups_array_t *				// O - Array
+cupsArrayNewHashed(cups_ahash_cb_t hf,	// I - Hash callback function
+                   cups_array_cb_t f,	// I - Equality callback function
+                   void            *d,	// I - User data or `NULL`
+                   cups_acopy_cb_t cf,	// I - Copy callback function or `NULL` for none
+                   cups_afree_cb_t ff)	// I - Free callback function or `NULL` for none
+{
+  cups_array_t	*a;			// Array
+
+
+  // Range check input...
+  if (!hf || !f)
+    return (NULL);
+
+  // Create an unsorted array and then add the hash table...
+  if ((a = cupsArrayNew(NULL, d, NULL, 0, cf, ff)) == NULL)
+    return (NULL);
+
+  a->hashfunc = hf;
+  a->equal    = f;
+
+  if (!cups_array_hash_resize(a, _CUPS_AMINTABLE))
+  {
+    cupsArrayDelete(a);
+    return (NULL);
+  }
+
+  return (a);
+}
+
+
 //
 // 'cupsArrayNewStrings()' - Create a new array of delimited strings.
 //
@@ -690,7 +1149,9 @@ cupsArrayNewStrings(const char *s,	// I - Delimited strings or `NULL` to create
 // 'cupsArrayRemove()' - Remove an element from an array.
 //
 // This function removes an element from an array.  If more than one element
-// matches "e", only the first matching element is removed.
+// matches "e", only the first matching element is removed.  For hashed arrays,
+// the last element of the array is moved into the place of the removed
+// element.
 //
 
 bool					// O - `true` on success, `false` on failure
@@ -706,19 +1167,72 @@ cupsArrayRemove(cups_array_t *a,	// I - Array
   if (!a || a->num_elements == 0 || !e)
     return (false);
 
+  if (a->table)
+  {
+    // Find the element in the hash table...
+    size_t	slot,			// Hash table slot
+		last;			// Last element
+
+    if ((slot = cups_array_hash_find(a, e, (*(a->hashfunc))(e, a->data))) >= a->table_size)
+      return (false);
+
+    current = a->table[slot].index;
+    last    = a->num_elements - 1;
+
+    if (a->freefunc)
+      (a->freefunc)(*cups_array_element(a, current), a->data);
+
+    cups_array_hash_remove(a, slot);
+
+    if (current < last)
+    {
+      // Move the last element into the removed element's place...
+      size_t	mask = a->table_size - 1;
+					// Mask for slot
+      void	*element = *cups_array_element(a, last);
+					// Last element
+
+      *cups_array_element(a, current) = element;
+
+      for (slot = (*(a->hashfunc))(element, a->data) & mask; a->table[slot].index != last; slot = (slot + 1) & mask);
+
+      a->table[slot].index = current;
+    }
+
+    cups_array_remove_at(a, last);
+
+    // Update the current, inserted, and saved elements...
+    if (a->current == current)
+      a->current = current ? current - 1 : SIZE_MAX;
+    else if (a->current == last)
+      a->current = current;
+
+    if (a->insert == current)
+      a->insert = SIZE_MAX;
+    else if (a->insert == last)
+      a->insert = current;
+
+    for (i = 0; i < a->num_saved; i ++)
+    {
+      if (a->saved[i] == current)
+        a->saved[i] = current ? current - 1 : SIZE_MAX;
+      else if (a->saved[i] == last)
+        a->saved[i] = current;
+    }
+
+    return (true);
+  }
+
   // See if the element is in the array...
   current = cups_array_find(a, e, a->current, &diff);
   if (diff)
     return (false);
 
   // Yes, now remove it...
-  a->num_elements --;
-
   if (a->freefunc)
-    (a->freefunc)(a->elements[current], a->data);
+    (a->freefunc)(*cups_array_element(a, current), a->data);
 
-  if (current < a->num_elements)
-    memmove(a->elements + current, a->elements + current + 1, (a->num_elements - current) * sizeof(void *));
+  cups_array_remove_at(a, current);
 
   if (current <= a->current)
   {
@@ -761,7 +1275,7 @@ cupsArrayRestore(cups_array_t *a)	// I - Array
   a->current = a->saved[a->num_saved];
 
   if (a->current < a->num_elements)
-    return (a->elements[a->current]);
+    return (*cups_array_element(a, a->current));
   else
     return (NULL);
 }
@@ -803,33 +1317,21 @@ cups_array_add(cups_array_t *a,		// I - Array
   size_t	i,			// Looping var
 		current;		// Current element
   int		diff;			// Comparison with current element
+  void		**element;		// New element
 
 
-  // Verify we have room for the new element...
-  if (a->num_elements >= a->alloc_elements)
+  // Find the insertion point for the new element; if there is no compare
+  // function or elements, just add it to the beginning or end...
+  if (a->table)
   {
-    // Allocate additional elements; start with 16 elements, then double the
-    // size until 1024 elements, then add 1024 elements thereafter...
-    void	**temp;			// New array elements
-    size_t	count;			// New allocation count
-
-    if (a->alloc_elements == 0)
-      count = 16;
-    else if (a->alloc_elements < 1024)
-      count = a->alloc_elements * 2;
-    else
-      count = a->alloc_elements + 1024;
-
-    if ((temp = realloc(a->elements, count * sizeof(void *))) == NULL)
+    // Hashed arrays always append, making sure there is room in the hash
+    // table first...
+    if ((a->num_elements + 1) * 2 > a->table_size && !cups_array_hash_resize(a, 2 * a->table_size))
       return (false);
 
-    a->alloc_elements = count;
-    a->elements       = temp;
+    current = a->num_elements;
   }
-
-  // Find the insertion point for the new element; if there is no compare
-  // function or elements, just add it to the beginning or end...
-  if (!a->num_elements || !a->compare)
+  else if (!a->num_elements || !a->compare)
   {
     // No elements or comparison function, insert/append as needed...
     if (insert)
@@ -856,7 +1358,7 @@ cups_array_add(cups_array_t *a,		// I - Array
       if (insert)
       {
         // Insert at beginning of run...
-	while (current > 0 && !(*(a->compare))(e, a->elements[current - 1], a->data))
+	while (current > 0 && !(*(a->compare))(e, *cups_array_element(a, current - 1), a->data))
           current --;
       }
       else
@@ -866,17 +1368,32 @@ cups_array_add(cups_array_t *a,		// I - Array
 	{
           current ++;
 	}
-	while (current < a->num_elements && !(*(a->compare))(e, a->elements[current], a->data));
+	while (current < a->num_elements && !(*(a->compare))(e, *cups_array_element(a, current), a->data));
       }
     }
   }
 
+  // Copy the element as needed...
+  if (a->copyfunc && (e = (a->copyfunc)(e, a->data)) == NULL)
+    return (false);
+
   // Insert or append the element...
-  if (current < a->num_elements)
+  if ((element = cups_array_insert_at(a, current)) == NULL)
   {
-    // Shift other elements to the right...
-    memmove(a->elements + current + 1, a->elements + current, (a->num_elements - current) * sizeof(void *));
+    if (a->copyfunc && a->freefunc)
+      (a->freefunc)(e, a->data);
+
+    return (false);
+  }
+
+  *element = e;
+
+  if (a->table)
+    cups_array_hash_add(a, current);
 
+  if (current < (a->num_elements - 1))
+  {
+    // Update the current and saved elements that were shifted to the right...
     if (a->current >= current)
       a->current ++;
 
@@ -887,23 +1404,83 @@ cups_array_add(cups_array_t *a,		// I - Array
     }
   }
 
-  if (a->copyfunc)
+  a->insert = current;
+
+  return (true);
+}
+
+
+//
+// 'cups_array_add_chunk()' - Add an empty chunk to the directory.
+//
+
+static bool				// O - `true` on success, `false` on failure
+cups_array_add_chunk(cups_array_t *a,	// I - Array
+                     size_t       n)	// I - Position of new chunk
+{
+  _cups_achunk_t	*chunk;		// New chunk
+
+
+  if (a->num_chunks >= a->alloc_chunks)
   {
-    if ((a->elements[current] = (a->copyfunc)(e, a->data)) == NULL)
+    // Grow the chunk directory...
+    _cups_achunk_t	**temp;		// New chunks
+    size_t		*starts,	// New chunk starts
+			count = a->alloc_chunks ? 2 * a->alloc_chunks : 16;
+					// New allocation count
+
+    if ((temp = _cupsMemRealloc(CUPS_MEMTYPE_ARRAY, a->chunks, count * sizeof(_cups_achunk_t *))) == NULL)
+      return (false);
+
+    a->chunks = temp;
+
+    if ((starts = _cupsMemRealloc(CUPS_MEMTYPE_ARRAY, a->chunk_starts, count * sizeof(size_t))) == NULL)
       return (false);
+
+    a->chunk_starts = starts;
+    a->alloc_chunks = count;
   }
-  else
+
+  if ((chunk = _cupsMemAlloc(CUPS_MEMTYPE_ARRAY, sizeof(_cups_achunk_t))) == NULL)
+    return (false);
+
+  chunk->num_elements = 0;
+
+  if (n < a->num_chunks)
   {
-    a->elements[current] = e;
+    memmove(a->chunks + n + 1, a->chunks + n, (a->num_chunks - n) * sizeof(_cups_achunk_t *));
+    memmove(a->chunk_starts + n + 1, a->chunk_starts + n, (a->num_chunks - n) * sizeof(size_t));
   }
 
-  a->num_elements ++;
-  a->insert = current;
+  a->chunks[n]       = chunk;
+  a->chunk_starts[n] = n > 0 ? a->chunk_starts[n - 1] + a->chunks[n - 1]->num_elements : 0;
+  a->num_chunks ++;
 
   return (true);
 }
 
 
+//
+// 'cups_array_element()' - Get a pointer to the N-th element in the array.
+//
+
+static void **				// O - Pointer to element
+cups_array_element(cups_array_t *a,	// I - Array
+                   size_t       n)	// I - Index into array, starting at 0
+{
+  size_t	chunk,			// Chunk containing the element
+		offset;			// Offset within chunk
+
+
+  if (!a->chunks)
+    return (a->elements + n);
+
+  chunk = cups_array_locate(a, n, &offset);
+
+  return (a->chunks[chunk]->elements + offset);
+}
+
+
 //
 // 'cups_array_find()' - Find an element in the array.
 //
@@ -926,7 +1503,7 @@ cups_array_find(cups_array_t *a,	// I - Array
     if (prev < a->num_elements)
     {
       // Start search on either side of previous...
-      if ((diff = (*(a->compare))(e, a->elements[prev], a->data)) == 0 || (diff < 0 && prev == 0) || (diff > 0 && prev == (a->num_elements - 1)))
+      if ((diff = (*(a->compare))(e, *cups_array_element(a, prev), a->data)) == 0 || (diff < 0 && prev == 0) || (diff > 0 && prev == (a->num_elements - 1)))
       {
         // Exact or edge match, return it!
 	*rdiff = diff;
@@ -956,7 +1533,7 @@ cups_array_find(cups_array_t *a,	// I - Array
     do
     {
       current = (left + right) / 2;
-      diff    = (*(a->compare))(e, a->elements[current], a->data);
+      diff    = (*(a->compare))(e, *cups_array_element(a, current), a->data);
 
       if (diff == 0)
 	break;
@@ -970,13 +1547,13 @@ cups_array_find(cups_array_t *a,	// I - Array
     if (diff != 0)
     {
       // Check the last 1 or 2 elements...
-      if ((diff = (*(a->compare))(e, a->elements[left], a->data)) <= 0)
+      if ((diff = (*(a->compare))(e, *cups_array_element(a, left), a->data)) <= 0)
       {
         current = left;
       }
       else
       {
-        diff    = (*(a->compare))(e, a->elements[right], a->data);
+        diff    = (*(a->compare))(e, *cups_array_element(a, right), a->data);
         current = right;
       }
     }
@@ -986,12 +1563,34 @@ cups_array_find(cups_array_t *a,	// I - Array
     // Do a linear pointer search...
     diff = 1;
 
-    for (current = 0; current < a->num_elements; current ++)
+    if (a->chunks)
     {
-      if (a->elements[current] == e)
+      // Search each chunk...
+      size_t	chunk,			// Current chunk
+		offset;			// Offset within chunk
+
+      for (chunk = 0, current = a->num_elements; chunk < a->num_chunks && diff; chunk ++)
       {
-        diff = 0;
-        break;
+        for (offset = 0; offset < a->chunks[chunk]->num_elements; offset ++)
+        {
+          if (a->chunks[chunk]->elements[offset] == e)
+          {
+            current = a->chunk_starts[chunk] + offset;
+            diff    = 0;
+            break;
+          }
+        }
+      }
+    }
+    else
+    {
+      for (current = 0; current < a->num_elements; current ++)
+      {
+	if (a->elements[current] == e)
+	{
+	  diff = 0;
+	  break;
+	}
       }
     }
   }
@@ -1001,3 +1600,451 @@ cups_array_find(cups_array_t *a,	// I - Array
 
   return (current);
 }
+
+
+//
+// 'cups_array_free_chunks()' - Free all chunks in the array.
+//
+
+static void
+cups_array_free_chunks(cups_array_t *a)	// I - Array
+{
+  size_t	i;			// Looping var
+
+
+  for (i = 0; i < a->num_chunks; i ++)
+    _cupsMemFree(a->chunks[i]);
+
+  _cupsMemFree(a->chunks);
+  _cupsMemFree(a->chunk_starts);
+
+  a->chunks       = NULL;
+  a->chunk_starts = NULL;
+  a->num_chunks   = 0;
+  a->alloc_chunks = 0;
+  a->chunk        = 0;
+}
+
+
+//
+// 'cups_array_hash_add()' - Add the N-th element to the hash table.
+//
+// The hash table must have at least one empty slot.
+//
+
+static void
+cups_array_hash_add(cups_array_t *a,	// I - Array
+                    size_t       n)	// I - Element index
+{
+  size_t	hash,			// Hash value
+		slot,			// Current slot
+		mask = a->table_size - 1;
+					// Mask for slot
+
+
+  hash = (*(a->hashfunc))(*cups_array_element(a, n), a->data);
+
+  for (slot = hash & mask; a->table[slot].index != SIZE_MAX; slot = (slot + 1) & mask);
+
+  a->table[slot].index = n;
+  a->table[slot].hash  = hash;
+}
+
+
+//
+// 'cups_array_hash_find()' - Find the hash table slot for an element.
+//
+
+static size_t				// O - Slot or `SIZE_MAX` if not found
+cups_array_hash_find(cups_array_t *a,	// I - Array
+                     void         *e,	// I - Element
+                     size_t       hash)	// I - Hash value for element
+{
+  size_t	slot,			// Current slot
+		mask = a->table_size - 1;
+					// Mask for slot
+
+
+  for (slot = hash & mask; a->table[slot].index != SIZE_MAX; slot = (slot + 1) & mask)
+  {
+    if (a->table[slot].hash == hash && !(*(a->equal))(e, *cups_array_element(a, a->table[slot].index), a->data))
+      return (slot);
+  }
+
+  return (SIZE_MAX);
+}
+
+
+//
+// 'cups_array_hash_remove()' - Remove a slot from the hash table.
+//
+// Later slots in the same probe sequence are moved up so that no "deleted"
+// markers are needed.
+//
+
+static void
+cups_array_hash_remove(cups_array_t *a,	// I - Array
+                       size_t       slot)	// I - Slot to remove
+{
+  size_t	next,			// Next slot
+		home,			// Home slot for next slot
+		mask = a->table_size - 1;
+					// Mask for slot
+
+
+  for (next = (slot + 1) & mask; a->table[next].index != SIZE_MAX; next = (next + 1) & mask)
+  {
+    // Move the next slot up if its home slot is not between the empty slot
+    // and itself...
+    home = a->table[next].hash & mask;
+
+    if (((next - home) & mask) >= ((next - slot) & mask))
+    {
+      a->table[slot] = a->table[next];
+      slot           = next;
+    }
+  }
+
+  a->table[slot].index = SIZE_MAX;
+}
+
+
+//
+// 'cups_array_hash_resize()' - Resize the hash table.
+//
+
+static bool				// O - `true` on success, `false` on failure
+cups_array_hash_resize(cups_array_t *a,	// I - Array
+                       size_t       size)	// I - New size (power of 2)
+{
+  size_t	i,			// Looping var
+		slot,			// Current slot
+		mask = size - 1;	// Mask for slot
+  _cups_aslot_t	*table;			// New hash table
+
+
+  if ((table = _cupsMemAlloc(CUPS_MEMTYPE_ARRAY, size * sizeof(_cups_aslot_t))) == NULL)
+    return (false);
+
+  for (i = 0; i < size; i ++)
+    table[i].index = SIZE_MAX;
+
+  for (i = 0; i < a->table_size; i ++)
+  {
+    if (a->table[i].index == SIZE_MAX)
+      continue;
+
+    for (slot = a->table[i].hash & mask; table[slot].index != SIZE_MAX; slot = (slot + 1) & mask);
+
+    table[slot] = a->table[i];
+  }
+
+  _cupsMemFree(a->table);
+
+  a->table      = table;
+  a->table_size = size;
+
+  return (true);
+}
+
+
+//
+// 'cups_array_insert_at()' - Make room for a new element in the array.
+//
+// The new element is not initialized.
+//
+
+static void **				// O - Pointer to new element or `NULL` on error
+cups_array_insert_at(cups_array_t *a,	// I - Array
+                     size_t       n)	// I - Index of new element
+{
+  size_t	i,			// Looping var
+		chunk,			// Current chunk
+		offset;			// Offset within chunk
+  _cups_achunk_t *cptr;			// Current chunk
+
+
+  if (!a->chunks && a->num_elements >= _CUPS_AMAXFLAT && !cups_array_make_chunks(a))
+    return (NULL);
+
+  if (!a->chunks)
+  {
+    // Verify we have room for the new element...
+    if (a->num_elements >= a->alloc_elements)
+    {
+      // Allocate additional elements; start with 16 elements, then double the
+      // size...
+      void	**temp;			// New array elements
+      size_t	count;			// New allocation count
+
+      if (a->alloc_elements == 0)
+	count = 16;
+      else
+	count = a->alloc_elements * 2;
+
+      if ((temp = _cupsMemRealloc(CUPS_MEMTYPE_ARRAY, a->elements, count * sizeof(void *))) == NULL)
+	return (NULL);
+
+      a->alloc_elements = count;
+      a->elements       = temp;
+    }
+
+    // Shift other elements to the right...
+    if (n < a->num_elements)
+      memmove(a->elements + n + 1, a->elements + n, (a->num_elements - n) * sizeof(void *));
+
+    a->num_elements ++;
+
+    return (a->elements + n);
+  }
+
+  // Find the chunk for the new element, appending to the last chunk as
+  // needed...
+  if (n >= a->num_elements)
+  {
+    chunk  = a->num_chunks - 1;
+    offset = a->chunks[chunk]->num_elements;
+  }
+  else
+  {
+    chunk = cups_array_locate(a, n, &offset);
+  }
+
+  if (a->chunks[chunk]->num_elements >= _CUPS_ACHUNK)
+  {
+    // Chunk is full...
+    if (offset == _CUPS_ACHUNK)
+    {
+      // Start a new chunk after this one...
+      if (!cups_array_add_chunk(a, chunk + 1))
+        return (NULL);
+
+      chunk ++;
+      offset = 0;
+    }
+    else
+    {
+      // Split the chunk in half...
+      if (!cups_array_add_chunk(a, chunk + 1))
+        return (NULL);
+
+      cptr = a->chunks[chunk + 1];
+
+      memcpy(cptr->elements, a->chunks[chunk]->elements + _CUPS_ACHUNK / 2, (_CUPS_ACHUNK / 2) * sizeof(void *));
+      cptr->num_elements                = _CUPS_ACHUNK / 2;
+      a->chunks[chunk]->num_elements    = _CUPS_ACHUNK / 2;
+      a->chunk_starts[chunk + 1]       -= _CUPS_ACHUNK / 2;
+
+      if (offset > _CUPS_ACHUNK / 2)
+      {
+        chunk ++;
+        offset -= _CUPS_ACHUNK / 2;
+      }
+    }
+  }
+
+  // Shift other elements in the chunk to the right...
+  cptr = a->chunks[chunk];
+
+  if (offset < cptr->num_elements)
+    memmove(cptr->elements + offset + 1, cptr->elements + offset, (cptr->num_elements - offset) * sizeof(void *));
+
+  cptr->num_elements ++;
+
+  for (i = chunk + 1; i < a->num_chunks; i ++)
+    a->chunk_starts[i] ++;
+
+  a->num_elements ++;
+  a->chunk = chunk;
+
+  return (cptr->elements + offset);
+}
+
+
+//
+// 'cups_array_locate()' - Find the chunk containing the N-th element.
+//
+
+static size_t				// O - Chunk index
+cups_array_locate(cups_array_t *a,	// I - Array
+                  size_t       n,	// I - Index into array, starting at 0
+                  size_t       *offset)	// O - Offset within chunk
+{
+  size_t	left,			// Left side of search
+		right,			// Right side of search
+		current;		// Current chunk
+
+
+  // Check the last chunk used since most access is sequential...
+  if (a->chunk < a->num_chunks && n >= a->chunk_starts[a->chunk] && (n - a->chunk_starts[a->chunk]) < a->chunks[a->chunk]->num_elements)
+  {
+    *offset = n - a->chunk_starts[a->chunk];
+    return (a->chunk);
+  }
+
+  // Do a binary search for the last chunk starting at or before the element...
+  for (left = 0, right = a->num_chunks; (right - left) > 1;)
+  {
+    current = (left + right) / 2;
+
+    if (a->chunk_starts[current] <= n)
+      left = current;
+    else
+      right = current;
+  }
+
+  a->chunk = left;
+  *offset  = n - a->chunk_starts[left];
+
+  return (left);
+}
+
+
+//
+// 'cups_array_make_chunks()' - Move the elements of a flat array into chunks.
+//
+
+static bool				// O - `true` on success, `false` on failure
+cups_array_make_chunks(cups_array_t *a)	// I - Array
+{
+  size_t		i;		// Looping var
+  _cups_achunk_t	*cptr;		// Current chunk
+
+
+  // Move the elements into half-full chunks...
+  for (i = 0; i < a->num_elements; i += _CUPS_ACHUNK / 2)
+  {
+    if (!cups_array_add_chunk(a, a->num_chunks))
+    {
+      cups_array_free_chunks(a);
+      return (false);
+    }
+
+    cptr               = a->chunks[a->num_chunks - 1];
+    cptr->num_elements = a->num_elements - i > _CUPS_ACHUNK / 2 ? _CUPS_ACHUNK / 2 : a->num_elements - i;
+
+    memcpy(cptr->elements, a->elements + i, cptr->num_elements * sizeof(void *));
+  }
+
+  _cupsMemFree(a->elements);
+
+  a->elements       = NULL;
+  a->alloc_elements = 0;
+
+  return (true);
+}
+
+
+//
+// 'cups_array_remove_at()' - Remove the N-th element from the array.
+//
+
+static void
+cups_array_remove_at(cups_array_t *a,	// I - Array
+                     size_t       n)	// I - Index of element
+{
+  size_t	i,			// Looping var
+		chunk,			// Current chunk
+		offset;			// Offset within chunk
+  _cups_achunk_t *cptr;			// Current chunk
+
+
+  a->num_elements --;
+
+  if (!a->chunks)
+  {
+    // Shift other elements to the left...
+    if (n < a->num_elements)
+      memmove(a->elements + n, a->elements + n + 1, (a->num_elements - n) * sizeof(void *));
+
+    return;
+  }
+
+  // Remove the element from its chunk...
+  chunk = cups_array_locate(a, n, &offset);
+  cptr  = a->chunks[chunk];
+
+  cptr->num_elements --;
+
+  if (offset < cptr->num_elements)
+    memmove(cptr->elements + offset, cptr->elements + offset + 1, (cptr->num_elements - offset) * sizeof(void *));
+
+  for (i = chunk + 1; i < a->num_chunks; i ++)
+    a->chunk_starts[i] --;
+
+  if (cptr->num_elements == 0 && a->num_chunks > 1)
+  {
+    // Remove the empty chunk...
+    _cupsMemFree(cptr);
+
+    a->num_chunks --;
+
+    if (chunk < a->num_chunks)
+    {
+      memmove(a->chunks + chunk, a->chunks + chunk + 1, (a->num_chunks - chunk) * sizeof(_cups_achunk_t *));
+      memmove(a->chunk_starts + chunk, a->chunk_starts + chunk + 1, (a->num_chunks - chunk) * sizeof(size_t));
+    }
+  }
+
+  if (a->num_elements < _CUPS_AMINCHUNK)
+  {
+    // Move the remaining elements back into a flat array...
+    void	**temp;			// Flat array
+
+    if ((temp = _cupsMemAlloc(CUPS_MEMTYPE_ARRAY, _CUPS_AMAXFLAT * sizeof(void *))) != NULL)
+    {
+      for (i = 0; i < a->num_chunks; i ++)
+        memcpy(temp + a->chunk_starts[i], a->chunks[i]->elements, a->chunks[i]->num_elements * sizeof(void *));
+
+      cups_array_free_chunks(a);
+
+      a->elements       = temp;
+      a->alloc_elements = _CUPS_AMAXFLAT;
+    }
+  }
+}
+
+
+//
+// 'cups_array_sort()' - Sort elements using a stable merge sort.
+//
+
+static void
+cups_array_sort(cups_array_t *a,	// I - Array
+                void         **e,	// I - Elements
+                void         **temp,	// I - Temporary storage
+                size_t       num_e)	// I - Number of elements
+{
+  size_t	i,			// Looping var
+		j,			// Looping var
+		k,			// Looping var
+		mid;			// Middle element
+  int		diff;			// Comparison result
+
+
+  if (num_e < 2)
+    return;
+
+  // Sort each half...
+  mid = num_e / 2;
+
+  cups_array_sort(a, e, temp, mid);
+  cups_array_sort(a, e + mid, temp + mid, num_e - mid);
+
+  // Then merge them, keeping equal elements in their original order...
+  for (i = 0, j = mid, k = 0; i < mid && j < num_e; k ++)
+  {
+    if ((diff = (*(a->compare))(e[i], e[j], a->data)) == 0)
+      a->unique = false;
+
+    if (diff <= 0)
+      temp[k] = e[i ++];
+    else
+      temp[k] = e[j ++];
+  }
+
+  while (i < mid)
+    temp[k ++] = e[i ++];
+
+  memcpy(e, temp, k * sizeof(void *));
+}
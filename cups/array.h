@@ -34,12 +34,21 @@ typedef void *(*cups_acopy_cb_t)(void *element, void *data);
 typedef void (*cups_afree_cb_t)(void *element, void *data);
 					// Array element free function
 
+typedef struct cups_array_iter_s	// Array iterator (private fields)
+{
+  cups_array_t	*array;			// Array
+  size_t	index,			// Index of current element
+		chunk,			// Current chunk
+		offset;			// Offset within chunk
+} cups_array_iter_t;
+
 
 //
 // Functions...
 //
 
 extern bool		cupsArrayAdd(cups_array_t *a, void *e) _CUPS_PUBLIC;
+extern bool		cupsArrayAddBatch(cups_array_t *a, void **e, size_t num_e) _CUPS_PUBLIC;
 extern bool		cupsArrayAddStrings(cups_array_t *a, const char *s, char delim) _CUPS_PUBLIC;
 extern void		cupsArrayClear(cups_array_t *a) _CUPS_PUBLIC;
 extern void		cupsArrayDelete(cups_array_t *a) _CUPS_PUBLIC;
@@ -56,7 +65,11 @@ extern void		*cupsArrayGetNext(cups_array_t *a) _CUPS_PUBLIC;
 extern void		*cupsArrayGetPrev(cups_array_t *a) _CUPS_PUBLIC;
 extern void		*cupsArrayGetUserData(cups_array_t *a) _CUPS_PUBLIC;
 extern bool		cupsArrayInsert(cups_array_t *a, void *e) _CUPS_PUBLIC;
+extern void		cupsArrayIterInit(cups_array_t *a, cups_array_iter_t *iter) _CUPS_PUBLIC;
+extern void		*cupsArrayIterNext(cups_array_iter_t *iter) _CUPS_PUBLIC;
+extern void		*cupsArrayIterPrev(cups_array_iter_t *iter) _CUPS_PUBLIC;
 extern cups_array_t	*cupsArrayNew(cups_array_cb_t f, void *d, cups_ahash_cb_t hf, size_t hsize, cups_acopy_cb_t cf, cups_afree_cb_t ff) _CUPS_PUBLIC;
+extern cups_array_t	*cupsArrayNewHashed(cups_ahash_cb_t hf, cups_array_cb_t f, void *d, cups_acopy_cb_t cf, cups_afree_cb_t ff) _CUPS_PUBLIC;
 extern cups_array_t	*cupsArrayNewStrings(const char *s, char delim) _CUPS_PUBLIC;
 extern bool		cupsArrayRemove(cups_array_t *a, void *e) _CUPS_PUBLIC;
 extern void		*cupsArrayRestore(cups_array_t *a) _CUPS_PUBLIC;
@@ -22,10 +22,51 @@
 #endif // SO_PEERCRED && AF_LOCAL
 
 
+//
+// Local constants...
+//
+
+#define _CUPS_AUTH_CACHE_MAX	16	// Maximum number of cached servers
+
+
+//
+// Local types...
+//
+
+typedef struct _cups_auth_cache_s	// Cached authentication for a server
+{
+  char		key[HTTP_MAX_VALUE + HTTP_MAX_HOST + 8];
+					// "username@hostname:port[+tls]"
+  time_t	atime;			// Last use
+  char		scheme[8],		// "Basic", "Bearer", or "Digest"
+		*authstring;		// Authorization data for Basic and Bearer
+  char		userpass[HTTP_MAX_VALUE],
+					// Username:password for Digest
+		algorithm[65],		// Digest algorithm
+		nonce[HTTP_MAX_VALUE],	// Digest nonce
+		opaque[HTTP_MAX_VALUE],	// Digest opaque value
+		qop[HTTP_MAX_VALUE],	// Digest quality of protection
+		realm[HTTP_MAX_VALUE];	// Realm
+  unsigned	nonce_count;		// Last Digest nonce count
+} _cups_auth_cache_t;
+
+
+//
+// Local globals...
+//
+
+static _cups_auth_cache_t auth_cache[_CUPS_AUTH_CACHE_MAX];
+					// Cached authentication
+static cups_mutex_t	auth_cache_mutex = CUPS_MUTEX_INITIALIZER;
+					// Mutex for cached authentication
+
+
 //
 // Local functions...
 //
 
+static _cups_auth_cache_t *cups_auth_cache_find(http_t *http, char *key, size_t keysize);
+static void		cups_auth_cache_save(http_t *http, const char *scheme);
 static const char	*cups_auth_find(const char *www_authenticate, const char *scheme);
 static const char	*cups_auth_param(const char *scheme, const char *name, char *value, size_t valsize);
 static const char	*cups_auth_scheme(const char *www_authenticate, char *scheme, size_t schemesize);
@@ -66,8 +107,10 @@ cupsDoAuthentication(
   DEBUG_printf("2cupsDoAuthentication: digest_tries=%d, userpass=\"%s\"", http->digest_tries, http->userpass);
   DEBUG_printf("2cupsDoAuthentication: WWW-Authenticate=\"%s\"", httpGetField(http, HTTP_FIELD_WWW_AUTHENTICATE));
 
-  // Clear the current authentication string...
+  // Clear the current authentication string and any cached authentication
+  // that got us here...
   httpSetAuthString(http, NULL, NULL);
+  cups_auth_cache_save(http, NULL);
 
   // See if we can do local authentication...
   if (http->digest_tries < 3)
@@ -206,6 +249,10 @@ cupsDoAuthentication(
   {
     DEBUG_printf("1cupsDoAuthentication: authstring=\"%s\".", http->authstring);
 
+    // Remember how we authenticated so new connections to this server can
+    // send the Authorization field with the first request...
+    cups_auth_cache_save(http, scheme);
+
     return (true);
   }
   else
@@ -218,6 +265,179 @@ cupsDoAuthentication(
 }
 
 
+//
+// '_cupsSetCachedAuth()' - Set the authentication string for a new connection
+//                          from the cached authentication for the server.
+//
+// This allows a new connection to send the Authorization field with its first
+// request instead of waiting for a 401 response.  The cache is updated by
+// @link cupsDoAuthentication@.
+//
+
+bool					// O - `true` if cached authentication was used, `false` otherwise
+_cupsSetCachedAuth(
+    http_t     *http,			// I - Connection to server
+    const char *method,			// I - Request method ("GET", "POST", "PUT")
+    const char *resource)		// I - Resource path
+{
+  bool			ret = false;	// Return value
+  _cups_auth_cache_t	*cache;		// Cached authentication
+  char			key[HTTP_MAX_VALUE + HTTP_MAX_HOST + 8];
+					// Cache key
+
+
+  if (!http || http->authstring || http->digest_tries)
+    return (false);
+
+  cupsMutexLock(&auth_cache_mutex);
+
+  if ((cache = cups_auth_cache_find(http, key, sizeof(key))) != NULL)
+  {
+    DEBUG_printf("4_cupsSetCachedAuth: Using cached \"%s\" authentication for \"%s\".", cache->scheme, key);
+
+    cache->atime = time(NULL);
+
+    if (cache->authstring)
+    {
+      // Basic or Bearer...
+      httpSetAuthString(http, cache->scheme, cache->authstring);
+      ret = true;
+    }
+    else
+    {
+      // Digest with the next nonce count...
+      cupsCopyString(http->userpass, cache->userpass, sizeof(http->userpass));
+      cupsCopyString(http->algorithm, cache->algorithm, sizeof(http->algorithm));
+      cupsCopyString(http->nonce, cache->nonce, sizeof(http->nonce));
+      cupsCopyString(http->opaque, cache->opaque, sizeof(http->opaque));
+      cupsCopyString(http->qop, cache->qop, sizeof(http->qop));
+      cupsCopyString(http->realm, cache->realm, sizeof(http->realm));
+
+      http->nonce_count = cache->nonce_count;
+
+      if ((ret = _httpSetDigestAuthString(http, NULL, method, resource)) == true)
+      {
+        // Leave room for the nonce count the caller uses when it updates the
+        // Digest string...
+        cache->nonce_count = http->nonce_count + 1;
+      }
+    }
+  }
+
+  cupsMutexUnlock(&auth_cache_mutex);
+
+  return (ret);
+}
+
+
+//
+// 'cups_auth_cache_find()' - Find the cached authentication for a connection.
+//
+// The cache mutex must be locked by the caller.
+//
+
+static _cups_auth_cache_t *		// O - Cached authentication or `NULL` if none
+cups_auth_cache_find(http_t *http,	// I - Connection to server
+                     char   *key,	// I - Key buffer
+                     size_t keysize)	// I - Size of key buffer
+{
+  size_t		i;		// Looping var
+  _cups_auth_cache_t	*cache;		// Current cache entry
+
+
+  // Credentials learned over TLS are never sent on an unencrypted
+  // connection to the same host and port...
+  snprintf(key, keysize, "%s@%s:%d%s", cupsGetUser(), http->hostname, http->hostaddr ? httpAddrGetPort(http->hostaddr) : 0, http->tls ? "+tls" : "");
+
+  for (i = _CUPS_AUTH_CACHE_MAX, cache = auth_cache; i > 0; i --, cache ++)
+  {
+    if (cache->key[0] && !strcmp(cache->key, key))
+      return (cache);
+  }
+
+  return (NULL);
+}
+
+
+//
+// 'cups_auth_cache_save()' - Save or remove the cached authentication for a
+//                            connection.
+//
+
+static void
+cups_auth_cache_save(http_t     *http,	// I - Connection to server
+                     const char *scheme)// I - Scheme used or `NULL` to remove
+{
+  size_t		i;		// Looping var
+  _cups_auth_cache_t	*cache,		// Cached authentication
+			*oldest;	// Oldest cache entry
+  char			key[HTTP_MAX_VALUE + HTTP_MAX_HOST + 8];
+					// Cache key
+  const char		*data;		// Authorization data
+
+
+  // Only cache schemes that can be sent before the server asks...
+  if (scheme && _cups_strcasecmp(scheme, "Basic") && _cups_strcasecmp(scheme, "Bearer") && _cups_strcasecmp(scheme, "Digest"))
+    return;
+
+  cupsMutexLock(&auth_cache_mutex);
+
+  if ((cache = cups_auth_cache_find(http, key, sizeof(key))) == NULL && scheme)
+  {
+    // Replace the oldest entry...
+    for (i = _CUPS_AUTH_CACHE_MAX, cache = auth_cache, oldest = auth_cache; i > 0; i --, cache ++)
+    {
+      if (cache->atime < oldest->atime)
+        oldest = cache;
+    }
+
+    cache = oldest;
+  }
+
+  if (cache)
+  {
+    // Clear the old values...
+    _cupsMemFree(cache->authstring);
+    memset(cache, 0, sizeof(_cups_auth_cache_t));
+
+    if (scheme)
+    {
+      // Copy the new values...
+      cupsCopyString(cache->key, key, sizeof(cache->key));
+      cupsCopyString(cache->scheme, scheme, sizeof(cache->scheme));
+      cupsCopyString(cache->realm, http->realm, sizeof(cache->realm));
+
+      cache->atime = time(NULL);
+
+      if (_cups_strcasecmp(scheme, "Digest"))
+      {
+        // Basic or Bearer - save the data after the scheme name...
+        if ((data = strchr(http->authstring, ' ')) != NULL)
+          cache->authstring = _cupsMemStrdup(CUPS_MEMTYPE_HTTP, data + 1);
+
+        if (!cache->authstring)
+          cache->key[0] = '\0';
+      }
+      else
+      {
+        // Digest - save the values needed to compute the next response...
+        cupsCopyString(cache->userpass, http->userpass, sizeof(cache->userpass));
+        cupsCopyString(cache->algorithm, http->algorithm, sizeof(cache->algorithm));
+        cupsCopyString(cache->nonce, http->nonce, sizeof(cache->nonce));
+        cupsCopyString(cache->opaque, http->opaque, sizeof(cache->opaque));
+        cupsCopyString(cache->qop, http->qop, sizeof(cache->qop));
+
+        // Leave room for the nonce count the caller uses when it updates the
+        // Digest string...
+        cache->nonce_count = http->nonce_count + 1;
+      }
+    }
+  }
+
+  cupsMutexUnlock(&auth_cache_mutex);
+}
+
+
 //
 // 'cups_auth_find()' - Find the named WWW-Authenticate scheme.
 //
@@ -455,9 +675,9 @@ cups_do_local_auth(http_t *http)	// I - HTTP connection to server
 #if defined(SO_PEERCRED) && defined(AF_LOCAL)
   const char		*www_auth;	// WWW-Authenticate header
   struct passwd		pwd;		// Password information
-  struct passwd		*result;	// Auxiliary pointer
+  struct passwd		*result = NULL;	// Auxiliary pointer
   const char		*username;	// Current username
-  _cups_globals_t *cg = _cupsGlobals();	// Global data
+  char			*pw_buf;	// Buffer for password information
 
   // See if we can authenticate using the peer credentials provided over a
   // domain socket; if so, specify "PeerCred username" as the authentication
@@ -469,8 +689,16 @@ cups_do_local_auth(http_t *http)	// I - HTTP connection to server
     // Verify that the current cupsGetUser() matches the current UID...
     username = cupsGetUser();
 
-    getpwnam_r(username, &pwd, cg->pw_buf, PW_BUF_SIZE, &result);
-    if (result && pwd.pw_uid == getuid())
+    if ((pw_buf = _cupsBufferGet(PW_BUF_SIZE)) != NULL)
+    {
+      getpwnam_r(username, &pwd, pw_buf, PW_BUF_SIZE, &result);
+      if (result && pwd.pw_uid != getuid())
+        result = NULL;
+
+      _cupsBufferRelease(pw_buf);
+    }
+
+    if (result)
     {
       httpSetAuthString(http, "PeerCred", username);
 
@@ -23,6 +23,43 @@ typedef int64_t ssize_t;			// @private@
 #  endif // _WIN32 && !__CUPS_SSIZE_T_DEFINED
 
 
+//
+// Common types...
+//
+
+typedef struct _cups_hash_s cups_hash_t;// Incremental hash/HMAC context
+
+typedef enum cups_memtype_e		// Memory usage categories
+{
+  CUPS_MEMTYPE_OTHER,			// Other memory
+  CUPS_MEMTYPE_ARRAY,			// Arrays
+  CUPS_MEMTYPE_DNSSD,			// DNS-SD services and queries
+  CUPS_MEMTYPE_FILE,			// Files and directories
+  CUPS_MEMTYPE_HTTP,			// HTTP connections and addresses
+  CUPS_MEMTYPE_IPP,			// IPP messages
+  CUPS_MEMTYPE_JSON,			// JSON values and JWTs
+  CUPS_MEMTYPE_RASTER,			// Raster streams
+  CUPS_MEMTYPE_STRING,			// Shared strings
+  CUPS_MEMTYPE_TLS,			// TLS credentials and sessions
+  CUPS_MEMTYPE_MAX			// Number of memory categories @private@
+} cups_memtype_t;
+
+typedef struct cups_memstats_s		// Memory usage statistics
+{
+  size_t	bytes,			// Bytes currently allocated
+		peak_bytes,		// Maximum bytes allocated
+		allocs,			// Allocations currently in use
+		total_allocs;		// Total number of allocations
+} cups_memstats_t;
+
+typedef void *(*cups_malloc_cb_t)(void *cb_data, size_t size);
+					// Memory allocation callback
+typedef void *(*cups_realloc_cb_t)(void *cb_data, void *ptr, size_t size);
+					// Memory reallocation callback
+typedef void (*cups_free_cb_t)(void *cb_data, void *ptr);
+					// Memory free callback
+
+
 //
 // This header defines several macros that add compiler-specific attributes for
 // functions:
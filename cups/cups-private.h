@@ -36,6 +36,15 @@ extern "C" {
 #  define _(x) x
 
 
+//
+// Constants...
+//
+
+#  ifndef _WIN32
+#    define PW_BUF_SIZE 16384		// Size of struct passwd buffers, as per glibc manual page
+#  endif // !_WIN32
+
+
 //
 // Types...
 //
@@ -48,6 +57,13 @@ typedef struct _cups_buffer_s		// Read/write buffer
 			d[1];		// Data buffer
 } _cups_buffer_t;
 
+typedef struct _cups_pwg_custom_s	// PWG media data for custom sizes
+{
+  pwg_media_t		media;		// PWG media data
+  char			pwg_name[65],	// PWG media name
+			ppd_name[41];	// PPD media name
+} _cups_pwg_custom_t;
+
 typedef struct _cups_raster_error_s	// Error buffer structure
 {
   char	*start,				// Start of buffer
@@ -76,57 +92,56 @@ typedef struct _cups_globals_s		// CUPS global state data
 {
   // Multiple places...
   const char		*datadir,	// Data directory (CUPS_DATADIR environment var)
-			*sysconfig;	// System config files (CUPS_SERVERROOT environment var)
-  char			*userconfig;	// User-specific config files
-#ifndef _WIN32
-#define PW_BUF_SIZE 16384		// As per glibc manual page
-  char			pw_buf[PW_BUF_SIZE];
-					// Big buffer for struct passwd buffers
-#endif
+			*sysconfig,	// System config files (CUPS_SERVERROOT environment var)
+			*userconfig;	// User-specific config files
 
   // debug.c
 #  ifdef DEBUG
   int			thread_id;	// Friendly thread ID
+  _cups_debug_trace_t	*debug_trace;	// Trace buffer
 #  endif // DEBUG
 
   // file.c
   cups_file_t		*stdio_files[3];// stdin, stdout, stderr
 
-  // http.c
-  char			http_date[256];	// Date+time buffer
-
   // http-addr.c
-  unsigned		ip_addr;	// Packed IPv4 address
-  char			*ip_ptrs[2];	// Pointer to packed address
-  struct hostent	hostent;	// Host entry for IP address
-  char			hostname[1024];	// Hostname
   int			need_res_init;	// Need to reinitialize resolver?
 
   // http-support.c
-  char			http_status[256];
-					// Unknown HTTP statuses
+  char			http_status[16];// Unknown HTTP statuses
+  time_t		http_date_time;	// Time for cached date string
+  char			http_date[256];	// Cached date string
 
   // ipp.c
+  time_t		ipp_date_time;	// Time for cached RFC-2579 date/time data
   ipp_uchar_t		ipp_date[11];	// RFC-2579 date/time data
   _cups_buffer_t	*cups_buffers;	// Buffer list
 
   // ipp-support.c
   int			ipp_port;	// IPP port number
-  char			ipp_unknown[255];
-					// Unknown error statuses
+  char			ipp_unknown[16];// Unknown error statuses
 
   // lang*.c
-  cups_lang_t		*lang_default;	// Default (current) language
+  cups_lang_t		*lang_default,	// Default (current) language
+			*lang_last;	// Last language found by cupsLangFind
   cups_encoding_t	lang_encoding;	// Current encoding
   char			lang_name[32];	// Current language name
 
   // pwg-media.c
-  cups_array_t		*leg_size_lut,	// Lookup table for legacy names
-			*ppd_size_lut,	// Lookup table for PPD names
-			*pwg_size_lut;	// Lookup table for PWG names
-  pwg_media_t		pwg_media;	// PWG media data for custom size
-  char			pwg_name[65],	// PWG media name for custom size
-			ppd_name[41];	// PPD media name for custom size
+  _cups_pwg_custom_t	*pwg_custom;	// PWG media data for custom sizes, if any
+  pwg_media_t		*pwg_near_media;// Last standard size from _pwgMediaNearSize
+  int			pwg_near_width,	// Last width for _pwgMediaNearSize
+			pwg_near_length,// Last length for _pwgMediaNearSize
+			pwg_near_epsilon;// Last tolerance for _pwgMediaNearSize
+
+  // rand.c
+#  if !defined(_WIN32) && !defined(__APPLE__)
+  bool			rand_seeded;	// Has the generator been seeded?
+  unsigned		rand_forks;	// Fork count when seeded
+  uint32_t		rand_key[8];	// ChaCha20 key
+  size_t		rand_avail;	// Bytes available in buffer
+  unsigned char		rand_buffer[256];// Random bytes
+#  endif // !_WIN32 && !__APPLE__
 
   // raster-error.c
   _cups_raster_error_t	raster_error;	// Raster error information
@@ -137,9 +152,6 @@ typedef struct _cups_globals_s		// CUPS global state data
   char			*last_status_message;
 					// Last IPP status-message
 
-  // tempfile.c
-  char			tempfile[1024];	// cupsTempFd/File buffer
-
   // usersys.c
   _cups_digestoptions_t	digestoptions;	// DigestOptions setting
   _cups_uatokens_t	uatokens;	// UserAgentTokens setting
@@ -187,16 +199,34 @@ typedef struct _cups_dconstres_s	// Constraint/resolver
   ipp_t	*collection;			// Collection containing attrs
 } _cups_dconstres_t;
 
+typedef struct _cups_dcvalue_s		// Constraint string value
+{
+  const char	*value;			// Value
+  uint64_t	matches[];		// Bitset of constraints matching value
+} _cups_dcvalue_t;
+
+typedef struct _cups_dcindex_s		// Constraint index for an attribute
+{
+  const char	*name;			// Attribute name
+  cups_array_t	*values;		// String values
+  uint64_t	bits[];			// Bitsets of constraints using the attribute and using string values
+} _cups_dcindex_t;
+
 struct _cups_dinfo_s			// Destination capability and status information
 {
   int			version;	// IPP version
   const char		*uri;		// Printer URI
   char			*resource;	// Resource path
   ipp_t			*attrs;		// Printer attributes
+  cups_array_t		*fetched;	// Attributes fetched so far for lazy destination information
   size_t		num_defaults;	// Number of default options
   cups_option_t		*defaults;	// Default options
   cups_array_t		*constraints;	// Job constraints
   cups_array_t		*resolvers;	// Job resolvers
+  size_t		constraint_words;
+					// Number of words in constraint bitsets
+  cups_array_t		*constraint_index;
+					// Index of constraint attributes
   bool			localizations;	// Localization information loaded?
   cups_array_t		*media_db;	// Media database
   _cups_media_db_t	min_size,	// Minimum size
@@ -223,8 +253,10 @@ extern void		_cupsAppleSetUseLastPrinter(int uselast) _CUPS_PRIVATE;
 #  endif // __APPLE__
 extern char		*_cupsBufferGet(size_t size) _CUPS_PRIVATE;
 extern void		_cupsBufferRelease(char *b) _CUPS_PRIVATE;
+extern void		_cupsConfFlush(const char *filename) _CUPS_PRIVATE;
 extern http_t		*_cupsConnect(void) _CUPS_PRIVATE;
 extern char		*_cupsCreateDest(const char *name, const char *info, const char *device_id, const char *device_uri, char *uri, size_t urisize) _CUPS_PRIVATE;
+extern ipp_t		*_cupsDoStreamRequest(http_t *http, ipp_t *request, const char *resource, ipp_stream_cb_t stream_cb, void *stream_data) _CUPS_INTERNAL;
 extern ipp_attribute_t	*_cupsEncodeOption(ipp_t *ipp, ipp_tag_t group_tag, _ipp_option_t *map, const char *name, const char *value) _CUPS_PRIVATE;
 extern const char	*_cupsGetDestResource(cups_dest_t *dest, unsigned flags, char *resource, size_t resourcesize) _CUPS_PRIVATE;
 extern size_t		_cupsGetDests(http_t *http, ipp_op_t op, const char *name, cups_dest_t **dests, cups_ptype_t type, cups_ptype_t mask) _CUPS_PRIVATE;
@@ -233,6 +265,7 @@ extern char		*_cupsGetUserDefault(char *name, size_t namesize) _CUPS_INTERNAL;
 extern void		_cupsGlobalLock(void) _CUPS_PRIVATE;
 extern void		_cupsGlobalUnlock(void) _CUPS_PRIVATE;
 extern _cups_globals_t	*_cupsGlobals(void) _CUPS_PRIVATE;
+extern bool		_cupsSetCachedAuth(http_t *http, const char *method, const char *resource) _CUPS_INTERNAL;
 extern void		_cupsSetDefaults(void) _CUPS_INTERNAL;
 extern void		_cupsSetError(ipp_status_t status, const char *message, bool localize) _CUPS_PRIVATE;
 extern void		_cupsSetHTTPError(http_status_t status) _CUPS_INTERNAL;
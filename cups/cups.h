@@ -181,7 +181,8 @@ enum cups_dest_flags_e			// Flags for @link cupsConnectDest@ and @link cupsEnumD
   CUPS_DEST_FLAGS_RESOLVING = 0x10,		// The destination address is being resolved
   CUPS_DEST_FLAGS_CONNECTING = 0x20,		// A connection is being established
   CUPS_DEST_FLAGS_CANCELED = 0x40,		// Operation was canceled
-  CUPS_DEST_FLAGS_DEVICE = 0x80			// For @link cupsConnectDest@: Connect to device
+  CUPS_DEST_FLAGS_DEVICE = 0x80,		// For @link cupsConnectDest@: Connect to device
+  CUPS_DEST_FLAGS_LAZY = 0x100			// For @link cupsCopyDestInfo@: Get printer attributes as needed
 };
 typedef unsigned cups_dest_flags_t;	// Combined flags for @link cupsConnectDest@ and @link cupsEnumDests@
 
@@ -241,6 +242,9 @@ typedef struct cups_option_s		// Printer Options
   char		*value;			// Value of option
 } cups_option_t;
 
+typedef struct _cups_options_s cups_options_t;
+					// Option set with hashed lookups
+
 typedef struct cups_dest_s		// Destination
 {
   char		*name,			// Printer or class name
@@ -285,15 +289,24 @@ typedef struct cups_media_s		// Media information
 typedef bool (*cups_cert_san_cb_t)(const char *common_name, const char *subject_alt_name, void *user_data);
 					// Certificate signing subjectAltName callback
 
+typedef void (*cups_cred_cb_t)(void *cb_data, const char *common_name, bool success);
+					// @link cupsCreateCredentialsAsync@ callback
+
 typedef bool (*cups_dest_cb_t)(void *user_data, cups_dest_flags_t flags, cups_dest_t *dest);
 			      		// Destination enumeration callback
 
+typedef bool (*cups_job_cb_t)(void *cb_data, const cups_job_t *job);
+					// @link cupsGetJobsIter@ callback
+
 typedef const char *(*cups_oauth_cb_t)(http_t *http, const char *realm, const char *scope, const char *resource, void *user_data);
 					// OAuth callback
 
 typedef const char *(*cups_password_cb_t)(const char *prompt, http_t *http, const char *method, const char *resource, void *user_data);
 					// New password callback
 
+typedef void (*cups_response_cb_t)(http_t *http, ipp_t *response, void *user_data);
+					// @link cupsSendRequestAsync@ callback
+
 
 //
 // Functions...
@@ -317,7 +330,9 @@ extern size_t		cupsCopyDest(cups_dest_t *dest, size_t num_dests, cups_dest_t **d
 extern cups_dinfo_t	*cupsCopyDestInfo(http_t *http, cups_dest_t *dest, cups_dest_flags_t dflags) _CUPS_PUBLIC;
 extern int		cupsCopyDestConflicts(http_t *http, cups_dest_t *dest, cups_dinfo_t *info, size_t num_options, cups_option_t *options, const char *new_option, const char *new_value, size_t *num_conflicts, cups_option_t **conflicts, size_t *num_resolved, cups_option_t **resolved) _CUPS_PUBLIC;
 extern size_t		cupsCopyString(char *dst, const char *src, size_t dstsize) _CUPS_PUBLIC;
+extern int		cupsCreateAnonymousFd(bool in_memory) _CUPS_PUBLIC;
 extern bool		cupsCreateCredentials(const char *path, bool ca_cert, cups_credpurpose_t purpose, cups_credtype_t type, cups_credusage_t usage, const char *organization, const char *org_unit, const char *locality, const char *state_province, const char *country, const char *common_name, const char *email, size_t num_alt_names, const char * const *alt_names, const char *root_name, time_t expiration_date) _CUPS_PUBLIC;
+extern bool		cupsCreateCredentialsAsync(const char *path, bool ca_cert, cups_credpurpose_t purpose, cups_credtype_t type, cups_credusage_t usage, const char *organization, const char *org_unit, const char *locality, const char *state_province, const char *country, const char *common_name, const char *email, size_t num_alt_names, const char * const *alt_names, const char *root_name, time_t expiration_date, cups_cred_cb_t cb, void *cb_data) _CUPS_PUBLIC;
 extern bool		cupsCreateCredentialsRequest(const char *path, cups_credpurpose_t purpose, cups_credtype_t type, cups_credusage_t usage, const char *organization, const char *org_unit, const char *locality, const char *state_province, const char *country, const char *common_name, const char *email, size_t num_alt_names, const char * const *alt_names) _CUPS_PUBLIC;
 extern ipp_status_t	cupsCreateDestJob(http_t *http, cups_dest_t *dest, cups_dinfo_t *info, int *job_id, const char *title, size_t num_options, cups_option_t *options) _CUPS_PUBLIC;
 extern int		cupsCreateTempFd(const char *prefix, const char *suffix, char *filename, size_t len) _CUPS_PUBLIC;
@@ -327,6 +342,7 @@ extern bool		cupsDoAuthentication(http_t *http, const char *method, const char *
 extern ipp_t		*cupsDoFileRequest(http_t *http, ipp_t *request, const char *resource, const char *filename) _CUPS_PUBLIC;
 extern ipp_t		*cupsDoIORequest(http_t *http, ipp_t *request, const char *resource, int infile, int outfile) _CUPS_PUBLIC;
 extern ipp_t		*cupsDoRequest(http_t *http, ipp_t *request, const char *resource) _CUPS_PUBLIC;
+extern size_t		cupsDoRequests(http_t *http, size_t num_requests, ipp_t **requests, const char *resource, ipp_t **responses) _CUPS_PUBLIC;
 
 extern ipp_attribute_t	*cupsEncodeOption(ipp_t *ipp, ipp_tag_t group_tag, const char *name, const char *value) _CUPS_PUBLIC;
 extern void		cupsEncodeOptions(ipp_t *ipp, size_t num_options, cups_option_t *options, ipp_tag_t group_tag) _CUPS_PUBLIC;
@@ -348,6 +364,7 @@ extern char		*cupsGetCredentialsInfo(const char *credentials, char *buffer, size
 extern http_trust_t	cupsGetCredentialsTrust(const char *path, const char *common_name, const char *credentials) _CUPS_PUBLIC;
 extern const char	*cupsGetDefault(http_t *http) _CUPS_PUBLIC;
 extern cups_dest_t	*cupsGetDest(const char *name, const char *instance, size_t num_dests, cups_dest_t *dests) _CUPS_PUBLIC;
+extern ipp_status_t	cupsGetDestJobsStatus(http_t *http, cups_dest_t *dest, cups_dinfo_t *info, size_t num_jobs, const int *job_ids, ipp_jstate_t *job_states) _CUPS_PUBLIC;
 extern bool		cupsGetDestMediaByIndex(http_t *http, cups_dest_t *dest, cups_dinfo_t *dinfo, size_t n, unsigned flags, cups_media_t *media) _CUPS_PUBLIC;
 extern bool		cupsGetDestMediaByName(http_t *http, cups_dest_t *dest, cups_dinfo_t *dinfo, const char *name, unsigned flags, cups_media_t *media) _CUPS_PUBLIC;
 extern bool		cupsGetDestMediaBySize(http_t *http, cups_dest_t *dest, cups_dinfo_t *dinfo, int width, int length, unsigned flags, cups_media_t *media) _CUPS_PUBLIC;
@@ -359,21 +376,30 @@ extern http_encryption_t cupsGetEncryption(void) _CUPS_PUBLIC;
 extern ipp_status_t	cupsGetError(void) _CUPS_PUBLIC;
 extern const char	*cupsGetErrorString(void) _CUPS_PUBLIC;
 extern http_status_t	cupsGetFd(http_t *http, const char *resource, int fd) _CUPS_PUBLIC;
+extern http_status_t	cupsGetFdParallel(http_t *http, const char *resource, int fd, off_t offset, size_t num_streams) _CUPS_PUBLIC;
 extern http_status_t	cupsGetFile(http_t *http, const char *resource, const char *filename) _CUPS_PUBLIC;
+extern http_status_t	cupsGetFileParallel(http_t *http, const char *resource, const char *filename, bool resume, size_t num_streams) _CUPS_PUBLIC;
 extern long		cupsGetIntegerOption(const char *name, size_t num_options, cups_option_t *options) _CUPS_PUBLIC;
 extern size_t		cupsGetJobs(http_t *http, cups_job_t **jobs, const char *name, bool myjobs, cups_whichjobs_t whichjobs) _CUPS_PUBLIC;
+extern bool		cupsGetJobsIter(http_t *http, const char *name, bool myjobs, cups_whichjobs_t whichjobs, size_t first_index, size_t limit, cups_job_cb_t cb, void *cb_data) _CUPS_PUBLIC;
+extern bool		cupsGetMemoryStats(cups_memtype_t type, cups_memstats_t *stats) _CUPS_PUBLIC;
 extern cups_dest_t	*cupsGetNamedDest(http_t *http, const char *name, const char *instance) _CUPS_PUBLIC;
 extern const char	*cupsGetOption(const char *name, size_t num_options, cups_option_t *options) _CUPS_PUBLIC;
 extern const char	*cupsGetPassword(const char *prompt, http_t *http, const char *method, const char *resource) _CUPS_PUBLIC;
 extern unsigned		cupsGetRand(void) _CUPS_PUBLIC;
+extern void		cupsGetRandBytes(void *buffer, size_t bytes) _CUPS_PUBLIC;
 extern ipp_t		*cupsGetResponse(http_t *http, const char *resource) _CUPS_PUBLIC;
 extern const char	*cupsGetServer(void) _CUPS_PUBLIC;
 extern const char	*cupsGetUser(void) _CUPS_PUBLIC;
 extern const char	*cupsGetUserAgent(void) _CUPS_PUBLIC;
 
 extern ssize_t		cupsHashData(const char *algorithm, const void *data, size_t datalen, unsigned char *hash, size_t hashsize) _CUPS_PUBLIC;
+extern ssize_t		cupsHashFinish(cups_hash_t *ctx, unsigned char *hash, size_t hashsize) _CUPS_PUBLIC;
+extern cups_hash_t	*cupsHashInit(const char *algorithm) _CUPS_PUBLIC;
 extern const char	*cupsHashString(const unsigned char *hash, size_t hashsize, char *buffer, size_t bufsize) _CUPS_PUBLIC;
+extern bool		cupsHashUpdate(cups_hash_t *ctx, const void *data, size_t datalen) _CUPS_PUBLIC;
 extern ssize_t		cupsHMACData(const char *algorithm, const unsigned char *key, size_t keylen, const void *data, size_t datalen, unsigned char *hash, size_t hashsize) _CUPS_PUBLIC;
+extern cups_hash_t	*cupsHMACInit(const char *algorithm, const unsigned char *key, size_t keylen) _CUPS_PUBLIC;
 
 extern const char	*cupsLocalizeDestMedia(http_t *http, cups_dest_t *dest, cups_dinfo_t *info, unsigned flags, cups_media_t *media) _CUPS_PUBLIC;
 extern const char	*cupsLocalizeDestOption(http_t *http, cups_dest_t *dest, cups_dinfo_t *info, const char *option) _CUPS_PUBLIC;
@@ -381,6 +407,17 @@ extern const char	*cupsLocalizeDestValue(http_t *http, cups_dest_t *dest, cups_d
 extern char		*cupsLocalizeNotifySubject(cups_lang_t *lang, ipp_t *event) _CUPS_PUBLIC;
 extern char		*cupsLocalizeNotifyText(cups_lang_t *lang, ipp_t *event) _CUPS_PUBLIC;
 
+extern bool		cupsOptionsAdd(cups_options_t *opts, const char *name, const char *value) _CUPS_PUBLIC;
+extern bool		cupsOptionsAddArray(cups_options_t *opts, size_t num_options, cups_option_t *options) _CUPS_PUBLIC;
+extern void		cupsOptionsDelete(cups_options_t *opts) _CUPS_PUBLIC;
+extern const char	*cupsOptionsGet(cups_options_t *opts, const char *name) _CUPS_PUBLIC;
+extern size_t		cupsOptionsGetArray(cups_options_t *opts, cups_option_t **options) _CUPS_PUBLIC;
+extern size_t		cupsOptionsGetCount(cups_options_t *opts) _CUPS_PUBLIC;
+extern const char	*cupsOptionsGetName(cups_options_t *opts, size_t n) _CUPS_PUBLIC;
+extern const char	*cupsOptionsGetValue(cups_options_t *opts, size_t n) _CUPS_PUBLIC;
+extern cups_options_t	*cupsOptionsNew(void) _CUPS_PUBLIC;
+extern bool		cupsOptionsRemove(cups_options_t *opts, const char *name) _CUPS_PUBLIC;
+
 extern size_t		cupsParseOptions(const char *arg, size_t num_options, cups_option_t **options) _CUPS_PUBLIC;
 extern http_status_t	cupsPutFd(http_t *http, const char *resource, int fd) _CUPS_PUBLIC;
 extern http_status_t	cupsPutFile(http_t *http, const char *resource, const char *filename) _CUPS_PUBLIC;
@@ -391,11 +428,15 @@ extern size_t		cupsRemoveOption(const char *name, size_t num_options, cups_optio
 
 extern bool		cupsSaveCredentials(const char *path, const char *common_name, const char *credentials, const char *key) _CUPS_PUBLIC;
 extern http_status_t	cupsSendRequest(http_t *http, ipp_t *request, const char *resource, size_t length) _CUPS_PUBLIC;
+extern bool		cupsSendRequestAsync(http_loop_t *loop, http_t *http, ipp_t *request, const char *resource, cups_response_cb_t cb, void *cb_data) _CUPS_PUBLIC;
 extern void		cupsSetOAuthCB(cups_oauth_cb_t cb, void *data) _CUPS_PUBLIC;
+extern bool		cupsSetAllocator(cups_malloc_cb_t malloc_cb, cups_realloc_cb_t realloc_cb, cups_free_cb_t free_cb, void *cb_data) _CUPS_PUBLIC;
 extern bool		cupsSetClientCredentials(const char *credentials, const char *key) _CUPS_PUBLIC;
+extern bool		cupsSetCredentialsKeyPool(cups_credtype_t type, size_t num_keys) _CUPS_PUBLIC;
 extern void		cupsSetDefaultDest(const char *name, const char *instance, size_t num_dests, cups_dest_t *dests) _CUPS_PUBLIC;
 extern bool		cupsSetDests(http_t *http, size_t num_dests, cups_dest_t *dests) _CUPS_PUBLIC;
 extern void		cupsSetEncryption(http_encryption_t e) _CUPS_PUBLIC;
+extern bool		cupsSetMemoryStats(bool enable) _CUPS_PUBLIC;
 extern void		cupsSetPasswordCB(cups_password_cb_t cb, void *user_data) _CUPS_PUBLIC;
 extern void		cupsSetServer(const char *server) _CUPS_PUBLIC;
 extern bool		cupsSetServerCredentials(const char *path, const char *common_name, bool auto_create) _CUPS_PUBLIC;
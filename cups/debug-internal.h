@@ -28,6 +28,12 @@ extern "C" {
 // Newlines are not required on the end of messages, as both add one when
 // writing the output.
 //
+// When the CUPS_DEBUG_TRACE environment variable is set, messages are not
+// formatted or written as they are logged.  Instead, the time, thread, format
+// string, and raw arguments of each message are recorded in a per-thread ring
+// buffer of CUPS_DEBUG_TRACE (default 4096) messages that is formatted by
+// DEBUG_dump or when the program exits.
+//
 // If the first character is a digit, then it represents the "log level" of the
 // message from 0 to 9.  The default level is 1.  The following defines the
 // current levels we use:
@@ -58,10 +64,14 @@ extern "C" {
 //
 
 #  ifdef DEBUG
+typedef struct _cups_debug_trace_s _cups_debug_trace_t;
+					// Per-thread trace buffer
+
 extern int	_cups_debug_fd _CUPS_INTERNAL;
 extern int	_cups_debug_level _CUPS_INTERNAL;
 extern void	_cups_debug_printf(const char *format, ...) _CUPS_FORMAT(1,2) _CUPS_INTERNAL;
 extern void	_cups_debug_puts(const char *s) _CUPS_INTERNAL;
+extern void	_cups_debug_release(_cups_debug_trace_t *trace) _CUPS_INTERNAL;
 #  endif // DEBUG
 
 
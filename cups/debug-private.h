@@ -29,10 +29,18 @@ extern "C" {
 // CUPS_DEBUG_LEVEL, and CUPS_DEBUG_FILTER environment variables.  The 1 on the
 // end forces the values to override the environment.
 //
+//   DEBUG_dump()
+//
+// The DEBUG_dump macro writes any messages recorded in the trace buffers when
+// the CUPS_DEBUG_TRACE environment variable is set.  Recorded messages are
+// also written when the program exits.
+//
 
 #  ifdef DEBUG
+#    define DEBUG_dump() _cups_debug_dump()
 #    define DEBUG_set(logfile,level,filter) _cups_debug_set(logfile,level,filter,1)
 #  else
+#    define DEBUG_dump()
 #    define DEBUG_set(logfile,level,filter)
 #  endif // DEBUG
 
@@ -41,6 +49,7 @@ extern "C" {
 // Prototypes...
 //
 
+extern void	_cups_debug_dump(void) _CUPS_PRIVATE;
 extern void	_cups_debug_set(const char *logfile, const char *level, const char *filter, int force) _CUPS_PRIVATE;
 #  ifdef _WIN32
 extern int	_cups_gettimeofday(struct timeval *tv, void *tz) _CUPS_PRIVATE;
@@ -34,6 +34,40 @@ _cups_gettimeofday(struct timeval *tv,	// I  - Timeval struct
 
 
 #ifdef DEBUG
+//
+// Local constants...
+//
+
+#  define _CUPS_TRACE_DATA	220	// Bytes of raw arguments per trace event
+#  define _CUPS_TRACE_EVENTS	2048	// Default number of trace events per thread
+
+
+//
+// Local types...
+//
+
+typedef struct _cups_trace_event_s	// Trace event
+{
+  const char		*format;	// Format string (call site)
+  struct timeval	curtime;	// Time of event
+  int			thread_id;	// Thread ID
+  unsigned		seq;		// Sequence number in buffer
+  unsigned short	length;		// Bytes of raw arguments
+  bool			truncated;	// Were arguments truncated?
+  unsigned char		data[_CUPS_TRACE_DATA];
+					// Raw arguments
+} _cups_trace_event_t;
+
+struct _cups_debug_trace_s		// Per-thread trace buffer
+{
+  _cups_debug_trace_t	*next;		// Next trace buffer
+  bool			in_use;		// Is a thread using this buffer?
+  cups_atomic_t		count;		// Number of recorded events
+  unsigned		dumped;		// Number of dumped events
+  _cups_trace_event_t	events[1];	// Ring buffer of events
+};
+
+
 //
 // Globals...
 //
@@ -50,6 +84,12 @@ int			_cups_debug_level = 1;
 
 static regex_t		*debug_filter = NULL;
 					// Filter expression for messages
+static const char	debug_puts_format[] = "%s";
+					// Format for recorded DEBUG_puts messages
+static _cups_debug_trace_t *debug_traces = NULL;
+					// Trace buffers
+static size_t		debug_trace_size = 0;
+					// Number of trace events per thread (0 = no tracing)
 static int		debug_init = 0;	// Did we initialize debugging?
 static cups_mutex_t	debug_init_mutex = CUPS_MUTEX_INITIALIZER,
 					// Mutex to control initialization
@@ -58,16 +98,91 @@ static cups_mutex_t	debug_init_mutex = CUPS_MUTEX_INITIALIZER,
 
 
 //
-// 'debug_thread_id()' - Return an integer representing the current thread.
+// Local functions...
 //
 
-static int				// O - Local thread ID
-debug_thread_id(void)
+static int	debug_thread_id(void);
+static int	debug_trace_compare(_cups_trace_event_t *a, _cups_trace_event_t *b);
+static size_t	debug_trace_format(_cups_trace_event_t *event, char *buffer, size_t bufsize);
+static void	debug_trace_record(const char *format, va_list ap);
+
+
+//
+// '_cups_debug_dump()' - Write recorded trace events to the log.
+//
+// Events from all threads are written in time order to the log file or to the
+// standard error if no log file is set.  Events that are recorded while the
+// buffers are being copied may be skipped.
+//
+
+void
+_cups_debug_dump(void)
 {
-  _cups_globals_t *cg = _cupsGlobals();	// Global data
+  _cups_debug_trace_t	*trace;		// Current trace buffer
+  _cups_trace_event_t	*events,	// Copy of events
+			*event;		// Current event
+  size_t		i,		// Looping var
+			num_events,	// Number of events
+			alloc_events;	// Allocated events
+  unsigned		first,		// First event to copy
+			last;		// Last event to copy
+  int			fd;		// Output file
+  char			buffer[2048];	// Output buffer
+  size_t		bytes;		// Number of bytes in buffer
 
 
-  return (cg->thread_id);
+  cupsMutexLock(&debug_init_mutex);
+
+  if (!debug_traces)
+  {
+    cupsMutexUnlock(&debug_init_mutex);
+    return;
+  }
+
+  // Copy the events from all of the trace buffers...
+  for (trace = debug_traces, alloc_events = 0; trace; trace = trace->next)
+    alloc_events += debug_trace_size;
+
+  if ((events = (_cups_trace_event_t *)_cupsMemAlloc(CUPS_MEMTYPE_OTHER, alloc_events * sizeof(_cups_trace_event_t))) == NULL)
+  {
+    cupsMutexUnlock(&debug_init_mutex);
+    return;
+  }
+
+  for (trace = debug_traces, num_events = 0; trace; trace = trace->next)
+  {
+    last  = (unsigned)cupsAtomicGet(&trace->count);
+    first = (last - trace->dumped) > debug_trace_size ? last - (unsigned)debug_trace_size : trace->dumped;
+
+    for (i = num_events; first != last; first ++)
+      events[i ++] = trace->events[first & (debug_trace_size - 1)];
+
+    // Drop any events that were overwritten while copying...
+    last = (unsigned)cupsAtomicGet(&trace->count);
+
+    for (event = events + num_events; event < (events + i); event ++)
+    {
+      if ((last - event->seq) < debug_trace_size)
+        events[num_events ++] = *event;
+    }
+
+    trace->dumped = last;
+  }
+
+  // Sort the events by time and write them out...
+  qsort(events, num_events, sizeof(_cups_trace_event_t), (int (*)(const void *, const void *))debug_trace_compare);
+
+  fd = _cups_debug_fd >= 0 ? _cups_debug_fd : 2;
+
+  for (i = num_events, event = events; i > 0; i --, event ++)
+  {
+    if ((bytes = debug_trace_format(event, buffer, sizeof(buffer))) > 0)
+      write(fd, buffer, bytes);
+  }
+
+  cupsMutexUnlock(&debug_init_mutex);
+
+  _cupsMemFree(events);
 }
 
 
@@ -91,6 +206,18 @@ _cups_debug_printf(const char *format,	// I - Printf-style format string
   if (!debug_init)
     _cups_debug_set(getenv("CUPS_DEBUG_LOG"), getenv("CUPS_DEBUG_LEVEL"), getenv("CUPS_DEBUG_FILTER"), 0);
 
+  if (debug_trace_size)
+  {
+    // Record the message for _cups_debug_dump...
+    if (isdigit(format[0]) && (format[0] - '0') > _cups_debug_level)
+      return;
+
+    va_start(ap, format);
+    debug_trace_record(format, ap);
+    va_end(ap);
+    return;
+  }
+
   if (_cups_debug_fd < 0)
     return;
 
@@ -154,6 +281,16 @@ _cups_debug_puts(const char *s)		// I - String to output
   if (!debug_init)
     _cups_debug_set(getenv("CUPS_DEBUG_LOG"), getenv("CUPS_DEBUG_LEVEL"), getenv("CUPS_DEBUG_FILTER"), 0);
 
+  if (debug_trace_size)
+  {
+    // Record the message for _cups_debug_dump...
+    if (isdigit(s[0]) && (s[0] - '0') > _cups_debug_level)
+      return;
+
+    _cups_debug_printf(debug_puts_format, s);
+    return;
+  }
+
   if (_cups_debug_fd < 0)
     return;
 
@@ -195,6 +332,23 @@ _cups_debug_puts(const char *s)		// I - String to output
 }
 
 
+//
+// '_cups_debug_release()' - Release a thread's trace buffer for use by another thread.
+//
+
+void
+_cups_debug_release(
+    _cups_debug_trace_t *trace)		// I - Trace buffer or `NULL`
+{
+  if (!trace)
+    return;
+
+  cupsMutexLock(&debug_init_mutex);
+  trace->in_use = false;
+  cupsMutexUnlock(&debug_init_mutex);
+}
+
+
 //
 // '_cups_debug_set()' - Enable or disable debug logging.
 //
@@ -205,6 +359,9 @@ _cups_debug_set(const char *logfile,	// I - Log file or NULL
 		const char *filter,	// I - Filter string or NULL
 		int        force)	// I - Force initialization
 {
+  const char	*trace;			// CUPS_DEBUG_TRACE environment variable
+
+
   cupsMutexLock(&debug_init_mutex);
 
   if (!debug_init || force)
@@ -250,18 +407,33 @@ _cups_debug_set(const char *logfile,	// I - Log file or NULL
 
     if (filter)
     {
-      if ((debug_filter = (regex_t *)calloc(1, sizeof(regex_t))) == NULL)
+      if ((debug_filter = (regex_t *)_cupsMemCalloc(CUPS_MEMTYPE_OTHER, 1, sizeof(regex_t))) == NULL)
       {
 	fputs("Unable to allocate memory for CUPS_DEBUG_FILTER - results not filtered.\n", stderr);
       }
       else if (regcomp(debug_filter, filter, REG_EXTENDED))
       {
 	fputs("Bad regular expression in CUPS_DEBUG_FILTER - results not filtered.\n", stderr);
-	free(debug_filter);
+	_cupsMemFree(debug_filter);
 	debug_filter = NULL;
       }
     }
 
+    if (!debug_trace_size && (trace = getenv("CUPS_DEBUG_TRACE")) != NULL && *trace && strcmp(trace, "0"))
+    {
+      // Record messages in per-thread trace buffers, rounding the number of
+      // events up to a power of 2...
+      size_t	size = (size_t)strtoul(trace, NULL, 10);
+					// Requested number of events
+
+      if (size < 64)
+        size = _CUPS_TRACE_EVENTS;
+
+      for (debug_trace_size = 64; debug_trace_size < size && debug_trace_size < 1048576; debug_trace_size *= 2);
+
+      atexit(_cups_debug_dump);
+    }
+
     debug_init = 1;
   }
 
@@ -269,7 +441,523 @@ _cups_debug_set(const char *logfile,	// I - Log file or NULL
 }
 
 
+//
+// 'debug_thread_id()' - Return an integer representing the current thread.
+//
+
+static int				// O - Local thread ID
+debug_thread_id(void)
+{
+  _cups_globals_t *cg = _cupsGlobals();	// Global data
+
+
+  return (cg->thread_id);
+}
+
+
+//
+// 'debug_trace_compare()' - Compare two trace events by time.
+//
+
+static int				// O - Result of comparison
+debug_trace_compare(
+    _cups_trace_event_t *a,		// I - First event
+    _cups_trace_event_t *b)		// I - Second event
+{
+  if (a->curtime.tv_sec != b->curtime.tv_sec)
+    return (a->curtime.tv_sec < b->curtime.tv_sec ? -1 : 1);
+  else if (a->curtime.tv_usec != b->curtime.tv_usec)
+    return (a->curtime.tv_usec < b->curtime.tv_usec ? -1 : 1);
+  else if (a->thread_id != b->thread_id)
+    return (a->thread_id < b->thread_id ? -1 : 1);
+  else if (a->seq != b->seq)
+    return ((int)(a->seq - b->seq) < 0 ? -1 : 1);
+  else
+    return (0);
+}
+
+
+//
+// 'debug_trace_format()' - Format a trace event as a log line.
+//
+// The arguments are decoded using the same walk of the format string that
+// @code debug_trace_record@ used to store them.
+//
+
+static size_t				// O - Number of bytes in line or `0` if filtered
+debug_trace_format(
+    _cups_trace_event_t *event,		// I - Event
+    char                *buffer,	// I - Line buffer
+    size_t              bufsize)	// I - Size of line buffer
+{
+  const char		*format = event->format;
+					// Pointer into format string
+  char			*bufptr,	// Pointer into buffer
+			*bufend,	// End of buffer
+			tformat[100],	// Format for one argument
+			*tptr,		// Pointer into argument format
+			type = '\0';	// Format type character
+  const unsigned char	*dataptr = event->data,
+					// Pointer into raw arguments
+			*dataend = event->data + event->length;
+					// End of raw arguments
+  int			width = 0,	// Width of field
+			ivalue;		// Width or precision argument
+  long long		llvalue;	// Integer argument
+  double		dvalue;		// Floating point argument
+  void			*pvalue;	// Pointer argument
+  size_t		len;		// Length of string argument
+  bool			done = false;	// Ran out of arguments?
+
+
+  // Skip the log level and filter as needed...
+  if (format != debug_puts_format && isdigit(*format & 255))
+    format ++;
+
+  if (debug_filter && format != debug_puts_format && regexec(debug_filter, format, 0, NULL, 0))
+    return (0);
+
+  snprintf(buffer, bufsize, "T%03d %02d:%02d:%02d.%06d  ", event->thread_id, (int)((event->curtime.tv_sec / 3600) % 24), (int)((event->curtime.tv_sec / 60) % 60), (int)(event->curtime.tv_sec % 60), (int)event->curtime.tv_usec);
+
+  bufptr = buffer + strlen(buffer);
+  bufend = buffer + bufsize - 2;
+
+#  define DEBUG_TRACE_GET(v) if ((size_t)(dataend - dataptr) < sizeof(v)) { done = true; break; } memcpy(&(v), dataptr, sizeof(v)); dataptr += sizeof(v)
+
+  while (*format && bufptr < bufend && !done)
+  {
+    if (*format != '%' || format[1] == '%')
+    {
+      // Literal text...
+      if (*format == '%')
+        format ++;
+
+      *bufptr++ = *format++;
+      continue;
+    }
+
+    // Copy the format for this argument, substituting '*' values...
+    tptr    = tformat;
+    *tptr++ = *format++;
+
+    while (*format && strchr(" -+#\'0", *format) && tptr < (tformat + 40))
+      *tptr++ = *format++;
+
+    if (*format == '*')
+    {
+      format ++;
+      DEBUG_TRACE_GET(ivalue);
+      width = ivalue;
+      snprintf(tptr, sizeof(tformat) - (size_t)(tptr - tformat), "%d", ivalue);
+      tptr += strlen(tptr);
+    }
+    else
+    {
+      for (width = 0; isdigit(*format & 255); format ++)
+      {
+        width = width * 10 + *format - '0';
+
+        if (tptr < (tformat + 60))
+          *tptr++ = *format;
+      }
+    }
+
+    if (*format == '.')
+    {
+      *tptr++ = *format++;
+
+      if (*format == '*')
+      {
+        format ++;
+        DEBUG_TRACE_GET(ivalue);
+        snprintf(tptr, sizeof(tformat) - (size_t)(tptr - tformat), "%d", ivalue);
+        tptr += strlen(tptr);
+      }
+      else
+      {
+        for (; isdigit(*format & 255); format ++)
+        {
+          if (tptr < (tformat + 90))
+            *tptr++ = *format;
+        }
+      }
+    }
+
+    // Skip the size, all integers are stored as long long values...
+    while (*format == 'h' || *format == 'l' || *format == 'L')
+      format ++;
+
+    if (!*format)
+      break;
+
+    type = *format++;
+
+    switch (type)
+    {
+      case 'E' : // Floating point formats
+      case 'G' :
+      case 'e' :
+      case 'f' :
+      case 'g' :
+          DEBUG_TRACE_GET(dvalue);
+          *tptr++ = type;
+          *tptr   = '\0';
+          snprintf(bufptr, (size_t)(bufend - bufptr), tformat, dvalue);
+          break;
+
+      case 'B' : // Integer formats
+      case 'X' :
+      case 'b' :
+      case 'd' :
+      case 'i' :
+      case 'o' :
+      case 'u' :
+      case 'x' :
+          DEBUG_TRACE_GET(llvalue);
+          *tptr++ = 'l';
+          *tptr++ = 'l';
+          *tptr++ = type;
+          *tptr   = '\0';
+          snprintf(bufptr, (size_t)(bufend - bufptr), tformat, llvalue);
+          break;
+
+      case 'p' : // Pointer value
+          DEBUG_TRACE_GET(pvalue);
+          *tptr++ = type;
+          *tptr   = '\0';
+          snprintf(bufptr, (size_t)(bufend - bufptr), tformat, pvalue);
+          break;
+
+      case 'c' : // Character or character array
+          if (width <= 1)
+            width = 1;
+
+          if ((len = (size_t)width) > (size_t)(dataend - dataptr))
+          {
+            len  = (size_t)(dataend - dataptr);
+            done = true;
+          }
+
+          if (len > (size_t)(bufend - bufptr))
+            len = (size_t)(bufend - bufptr);
+
+          memcpy(bufptr, dataptr, len);
+          bufptr[len] = '\0';
+          dataptr += len;
+          break;
+
+      case 's' : // String
+          if (dataptr >= dataend)
+          {
+            done = true;
+            break;
+          }
+
+          // Copy the string, replacing control chars and \ with C character
+          // escapes like cupsFormatString...
+          for (; *dataptr && dataptr < dataend && bufptr < (bufend - 4); dataptr ++)
+          {
+            if (*dataptr >= ' ' && !strchr("\\\'\"", *dataptr))
+            {
+              *bufptr++ = (char)*dataptr;
+            }
+            else
+            {
+              *bufptr++ = '\\';
+
+              if (*dataptr == '\n')
+              {
+                *bufptr++ = 'n';
+              }
+              else if (*dataptr == '\r')
+              {
+                *bufptr++ = 'r';
+              }
+              else if (*dataptr == '\t')
+              {
+                *bufptr++ = 't';
+              }
+              else if (*dataptr >= ' ')
+              {
+                *bufptr++ = (char)*dataptr;
+              }
+              else
+              {
+                *bufptr++ = '0';
+                *bufptr++ = (char)('0' + *dataptr / 8);
+                *bufptr++ = (char)('0' + (*dataptr & 7));
+              }
+            }
+          }
+
+          *bufptr = '\0';
+          dataptr ++;
+          break;
+
+      default : // Output count and unknown formats
+          *bufptr = '\0';
+          break;
+    }
+
+    if (!done || type == 'c')
+      bufptr += strlen(bufptr);
+  }
+
+#  undef DEBUG_TRACE_GET
+
+  if ((done || event->truncated) && bufptr < (bufend - 3))
+  {
+    memcpy(bufptr, "...", 3);
+    bufptr += 3;
+  }
+
+  if (bufptr > buffer && bufptr[-1] != '\n')
+    *bufptr++ = '\n';
+
+  return ((size_t)(bufptr - buffer));
+}
+
+
+//
+// 'debug_trace_record()' - Record a message in the current thread's trace buffer.
+//
+// The arguments are stored without formatting - integers are stored as
+// `long long` values, strings are copied, and other values are stored as-is
+// until the event is full.
+//
+
+static void
+debug_trace_record(const char *format,	// I - Printf-style format string
+                   va_list    ap)	// I - Pointer to additional arguments
+{
+  _cups_globals_t	*cg = _cupsGlobals();
+					// Global data
+  _cups_debug_trace_t	*trace;		// Trace buffer
+  _cups_trace_event_t	*event;		// Event
+  unsigned char		*dataptr,	// Pointer into raw arguments
+			*dataend;	// End of raw arguments
+  const char		*fmt;		// Pointer into format string
+  char			size,		// Size character (h, l, L)
+			type;		// Format type character
+  int			width,		// Width of field
+			ivalue;		// Width or precision argument
+  long long		llvalue;	// Integer argument
+  double		dvalue;		// Floating point argument
+  void			*pvalue;	// Pointer argument
+  const char		*svalue;	// String argument
+  size_t		len;		// Length of string or characters
+  unsigned		seq;		// Sequence number of event
+
+
+  if (!cg)
+    return;
+
+  if ((trace = cg->debug_trace) == NULL)
+  {
+    // Find an unused trace buffer or allocate a new one...
+    cupsMutexLock(&debug_init_mutex);
+
+    for (trace = debug_traces; trace; trace = trace->next)
+    {
+      if (!trace->in_use)
+        break;
+    }
+
+    if (!trace && (trace = (_cups_debug_trace_t *)_cupsMemCalloc(CUPS_MEMTYPE_OTHER, 1, sizeof(_cups_debug_trace_t) + (debug_trace_size - 1) * sizeof(_cups_trace_event_t))) != NULL)
+    {
+      trace->next  = debug_traces;
+      debug_traces = trace;
+    }
+
+    if (trace)
+      trace->in_use = true;
+
+    cupsMutexUnlock(&debug_init_mutex);
+
+    if ((cg->debug_trace = trace) == NULL)
+      return;
+  }
+
+  seq   = (unsigned)trace->count;
+  event = trace->events + (seq & (debug_trace_size - 1));
+
+  event->format    = format;
+  event->thread_id = cg->thread_id;
+  event->seq       = seq;
+  event->truncated = false;
+
+  gettimeofday(&event->curtime, NULL);
+
+#  define DEBUG_TRACE_PUT(v) if ((size_t)(dataend - dataptr) < sizeof(v)) { event->truncated = true; dataend = dataptr; break; } memcpy(dataptr, &(v), sizeof(v)); dataptr += sizeof(v)
+
+  for (fmt = format, dataptr = event->data, dataend = event->data + sizeof(event->data); *fmt && dataptr < dataend;)
+  {
+    if (*fmt++ != '%')
+      continue;
+
+    if (*fmt == '%')
+    {
+      fmt ++;
+      continue;
+    }
+
+    while (*fmt && strchr(" -+#\'0", *fmt))
+      fmt ++;
+
+    if (*fmt == '*')
+    {
+      fmt ++;
+      width = ivalue = va_arg(ap, int);
+      DEBUG_TRACE_PUT(ivalue);
+    }
+    else
+    {
+      for (width = 0; isdigit(*fmt & 255); fmt ++)
+        width = width * 10 + *fmt - '0';
+    }
+
+    if (*fmt == '.')
+    {
+      fmt ++;
+
+      if (*fmt == '*')
+      {
+        fmt ++;
+        ivalue = va_arg(ap, int);
+        DEBUG_TRACE_PUT(ivalue);
+      }
+      else
+      {
+        while (isdigit(*fmt & 255))
+          fmt ++;
+      }
+    }
+
+    if (*fmt == 'l' && fmt[1] == 'l')
+    {
+      size = 'L';
+      fmt  += 2;
+    }
+    else if (*fmt == 'h' || *fmt == 'l' || *fmt == 'L')
+    {
+      size = *fmt++;
+    }
+    else
+    {
+      size = 0;
+    }
+
+    if (!*fmt)
+      break;
+
+    switch (type = *fmt++)
+    {
+      case 'E' : // Floating point formats
+      case 'G' :
+      case 'e' :
+      case 'f' :
+      case 'g' :
+          dvalue = va_arg(ap, double);
+          DEBUG_TRACE_PUT(dvalue);
+          break;
+
+      case 'd' : // Signed integer formats
+      case 'i' :
+          if (size == 'L')
+            llvalue = va_arg(ap, long long);
+          else if (size == 'l')
+            llvalue = va_arg(ap, long);
+          else if (size == 'h')
+            llvalue = (short)va_arg(ap, int);
+          else
+            llvalue = va_arg(ap, int);
+
+          DEBUG_TRACE_PUT(llvalue);
+          break;
+
+      case 'B' : // Unsigned integer formats
+      case 'X' :
+      case 'b' :
+      case 'o' :
+      case 'u' :
+      case 'x' :
+          if (size == 'L')
+            llvalue = (long long)va_arg(ap, unsigned long long);
+          else if (size == 'l')
+            llvalue = (long long)va_arg(ap, unsigned long);
+          else if (size == 'h')
+            llvalue = (unsigned short)va_arg(ap, unsigned);
+          else
+            llvalue = va_arg(ap, unsigned);
+
+          DEBUG_TRACE_PUT(llvalue);
+          break;
+
+      case 'p' : // Pointer value
+          pvalue = va_arg(ap, void *);
+          DEBUG_TRACE_PUT(pvalue);
+          break;
+
+      case 'c' : // Character or character array
+          if (width <= 1)
+          {
+            *dataptr++ = (unsigned char)va_arg(ap, int);
+          }
+          else
+          {
+            if ((len = (size_t)width) > (size_t)(dataend - dataptr))
+            {
+              len              = (size_t)(dataend - dataptr);
+              event->truncated = true;
+            }
+
+            memcpy(dataptr, va_arg(ap, char *), len);
+            dataptr += len;
+          }
+          break;
+
+      case 's' : // String
+          if ((svalue = va_arg(ap, const char *)) == NULL)
+            svalue = "(null)";
+
+          for (; *svalue && dataptr < (dataend - 1); svalue ++)
+            *dataptr++ = (unsigned char)*svalue;
+
+          *dataptr++ = '\0';
+
+          if (*svalue)
+          {
+            event->truncated = true;
+            dataend          = dataptr;
+          }
+          break;
+
+      case 'n' : // Output number of chars so far (not supported)
+          (void)va_arg(ap, int *);
+          break;
+    }
+  }
+
+#  undef DEBUG_TRACE_PUT
+
+  event->length = (unsigned short)(dataptr - event->data);
+
+  // Publish the event...
+  cupsAtomicInc(&trace->count);
+}
+
+
 #else
+//
+// '_cups_debug_dump()' - Write recorded trace events to the log.
+//
+
+void
+_cups_debug_dump(void)
+{
+}
+
+
 //
 // '_cups_debug_set()' - Enable or disable debug logging.
 //
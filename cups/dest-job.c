@@ -237,6 +237,205 @@ cupsFinishDestDocument(
 }
 
 
+//
+// 'cupsGetDestJobsStatus()' - Get the current states of several jobs.
+//
+// This function gets the current "job-state" values for the jobs listed in the
+// "job_ids" array and stores them in the corresponding elements of the
+// "job_states" array.  Jobs that do not exist or whose state cannot be
+// determined get a state of `0`.
+//
+// When the destination supports the "job-ids" operation attribute, the states
+// are queried using a single Get-Jobs request.  Otherwise, or if the Get-Jobs
+// request fails, the jobs are queried using pipelined Get-Job-Attributes
+// requests.
+//
+// Returns `IPP_STATUS_OK` when the states of all jobs are found.
+//
+
+ipp_status_t				// O - IPP status code
+cupsGetDestJobsStatus(
+    http_t       *http,			// I - Connection to destination
+    cups_dest_t  *dest,			// I - Destination
+    cups_dinfo_t *info,			// I - Destination information
+    size_t       num_jobs,		// I - Number of jobs
+    const int    *job_ids,		// I - Job IDs
+    ipp_jstate_t *job_states)		// O - Job states or `0` if not known
+{
+  size_t		i,		// Looping var
+			hint,		// Next job to check
+			num_requests;	// Number of Get-Job-Attributes requests
+  ipp_t			*request,	// IPP request
+			*response,	// IPP response
+			**requests,	// Get-Job-Attributes requests
+			**responses;	// Get-Job-Attributes responses
+  ipp_attribute_t	*attr;		// Current attribute
+  size_t		*jobs;		// Index for each request
+  int			job_id;		// Current job ID
+  ipp_jstate_t		job_state;	// Current job state
+  ipp_status_t		status = IPP_STATUS_OK;
+					// Return status
+  static const char * const requested_attrs[] =
+  {					// Requested attributes
+    "job-id",
+    "job-state"
+  };
+
+
+  DEBUG_printf("cupsGetDestJobsStatus(http=%p, dest=%p(%s/%s), info=%p, num_jobs=%u, job_ids=%p, job_states=%p)", (void *)http, (void *)dest, dest ? dest->name : NULL, dest ? dest->instance : NULL, (void *)info, (unsigned)num_jobs, (void *)job_ids, (void *)job_states);
+
+  // Get the default connection as needed...
+  if (!http)
+    http = _cupsConnect();
+
+  // Range check input...
+  if (!http || !dest || !info || (num_jobs > 0 && (!job_ids || !job_states)) || num_jobs > INT_MAX)
+  {
+    _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(EINVAL), false);
+    DEBUG_puts("1cupsGetDestJobsStatus: Bad arguments.");
+    return (IPP_STATUS_ERROR_INTERNAL);
+  }
+
+  if (num_jobs == 0)
+    return (IPP_STATUS_OK);
+
+  memset(job_states, 0, num_jobs * sizeof(ipp_jstate_t));
+
+  // Use a single Get-Jobs request if the printer supports "job-ids"...
+  if (ippGetBoolean(ippFindAttribute(info->attrs, "job-ids-supported", IPP_TAG_BOOLEAN), 0))
+  {
+    request = ippNewRequest(IPP_OP_GET_JOBS);
+
+    ippSetVersion(request, info->version / 10, info->version % 10);
+
+    ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_URI, "printer-uri", NULL, info->uri);
+    ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_NAME, "requesting-user-name", NULL, cupsGetUser());
+    ippAddIntegers(request, IPP_TAG_OPERATION, IPP_TAG_INTEGER, "job-ids", num_jobs, job_ids);
+    ippAddStrings(request, IPP_TAG_OPERATION, IPP_TAG_KEYWORD, "requested-attributes", sizeof(requested_attrs) / sizeof(requested_attrs[0]), NULL, requested_attrs);
+
+    response = cupsDoRequest(http, request, info->resource);
+    status   = cupsGetError();
+
+    DEBUG_printf("1cupsGetDestJobsStatus: Get-Jobs %s (%s)", ippErrorString(status), cupsGetErrorString());
+
+    // Save the state of each job in the response; the jobs are usually
+    // returned in the order they were requested...
+    for (attr = ippGetFirstAttribute(response), job_id = 0, job_state = 0, hint = 0;; attr = ippGetNextAttribute(response))
+    {
+      if (!attr || ippGetGroupTag(attr) != IPP_TAG_JOB)
+      {
+        if (job_id > 0 && job_state)
+        {
+          for (i = 0; i < num_jobs; i ++, hint ++)
+          {
+            if (hint >= num_jobs)
+              hint = 0;
+
+            if (job_ids[hint] == job_id && !job_states[hint])
+            {
+              job_states[hint ++] = job_state;
+              break;
+            }
+          }
+        }
+
+        if (!attr)
+          break;
+
+        job_id    = 0;
+        job_state = 0;
+      }
+      else if (ippGetValueTag(attr) == IPP_TAG_INTEGER && !strcmp(ippGetName(attr), "job-id"))
+      {
+        job_id = ippGetInteger(attr, 0);
+      }
+      else if (ippGetValueTag(attr) == IPP_TAG_ENUM && !strcmp(ippGetName(attr), "job-state"))
+      {
+        job_state = (ipp_jstate_t)ippGetInteger(attr, 0);
+      }
+    }
+
+    ippDelete(response);
+
+    if (status <= IPP_STATUS_OK_EVENTS_COMPLETE)
+    {
+      // Jobs missing from a successful response do not exist or are not
+      // visible to the current user...
+      for (i = 0; i < num_jobs; i ++)
+      {
+        if (!job_states[i])
+        {
+          _cupsSetError(IPP_STATUS_ERROR_NOT_FOUND, strerror(ENOENT), false);
+          return (IPP_STATUS_ERROR_NOT_FOUND);
+        }
+      }
+
+      return (IPP_STATUS_OK);
+    }
+
+    // Otherwise fall back on individual Get-Job-Attributes requests...
+    status = IPP_STATUS_OK;
+  }
+
+  // Query any remaining jobs using pipelined Get-Job-Attributes requests...
+  for (i = 0, num_requests = 0; i < num_jobs; i ++)
+  {
+    if (!job_states[i])
+      num_requests ++;
+  }
+
+  if (num_requests == 0)
+    return (IPP_STATUS_OK);
+
+  if ((requests = _cupsMemCalloc(CUPS_MEMTYPE_OTHER, num_requests, 2 * sizeof(ipp_t *) + sizeof(size_t))) == NULL)
+  {
+    _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(ENOMEM), false);
+    return (IPP_STATUS_ERROR_INTERNAL);
+  }
+
+  responses = requests + num_requests;
+  jobs      = (size_t *)(responses + num_requests);
+
+  for (i = 0, num_requests = 0; i < num_jobs; i ++)
+  {
+    if (job_states[i])
+      continue;
+
+    request = ippNewRequest(IPP_OP_GET_JOB_ATTRIBUTES);
+
+    ippSetVersion(request, info->version / 10, info->version % 10);
+
+    ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_URI, "printer-uri", NULL, info->uri);
+    ippAddInteger(request, IPP_TAG_OPERATION, IPP_TAG_INTEGER, "job-id", job_ids[i]);
+    ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_NAME, "requesting-user-name", NULL, cupsGetUser());
+    ippAddStrings(request, IPP_TAG_OPERATION, IPP_TAG_KEYWORD, "requested-attributes", sizeof(requested_attrs) / sizeof(requested_attrs[0]), NULL, requested_attrs);
+
+    jobs[num_requests]       = i;
+    requests[num_requests ++] = request;
+  }
+
+  cupsDoRequests(http, num_requests, requests, info->resource, responses);
+
+  for (i = 0; i < num_requests; i ++)
+  {
+    if ((attr = ippFindAttribute(responses[i], "job-state", IPP_TAG_ENUM)) != NULL)
+      job_states[jobs[i]] = (ipp_jstate_t)ippGetInteger(attr, 0);
+    else if (!responses[i])
+      status = IPP_STATUS_ERROR_SERVICE_UNAVAILABLE;
+    else if ((status = ippGetStatusCode(responses[i])) <= IPP_STATUS_OK_EVENTS_COMPLETE)
+      status = IPP_STATUS_ERROR_NOT_FOUND;
+
+    ippDelete(responses[i]);
+  }
+
+  _cupsMemFree(requests);
+
+  DEBUG_printf("1cupsGetDestJobsStatus: Returning %s", ippErrorString(status));
+
+  return (status);
+}
+
+
 //
 // 'cupsStartDestDocument()' - Start a new document.
 //
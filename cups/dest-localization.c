@@ -9,6 +9,17 @@
 //
 
 #include "cups-private.h"
+#include <sys/stat.h>
+
+
+//
+// Local globals...
+//
+
+static cups_array_t	*cups_strings_loaded = NULL;
+					// Strings files loaded by this process
+static cups_mutex_t	cups_strings_mutex = CUPS_MUTEX_INITIALIZER;
+					// Mutex for loaded strings files
 
 
 //
@@ -16,6 +27,9 @@
 //
 
 static void	cups_load_localizations(http_t *http, cups_dinfo_t *dinfo);
+static bool	cups_strings_cache_file(const char *uri, cups_lang_t *lang, char *filename, size_t filesize);
+static bool	cups_strings_cache_load(cups_lang_t *lang, const char *filename, int config_time);
+static bool	cups_strings_find(const char *key, bool add);
 
 
 //
@@ -257,6 +271,11 @@ cupsLocalizeDestValue(
 // 'cups_load_localizations()' - Load the localization strings for a
 //                               destination.
 //
+// The strings for each "printer-strings-uri" and language are only loaded
+// once per process.  Printers that report "printer-config-change-time" also
+// have their strings file cached on disk so that other processes do not need
+// to fetch it again until the printer configuration changes.
+//
 
 static void
 cups_load_localizations(
@@ -265,17 +284,23 @@ cups_load_localizations(
 {
   http_t		*http2;		// Connection for strings file
   http_status_t		status;		// Request status
-  ipp_attribute_t	*attr;		// "printer-strings-uri" attribute
+  ipp_attribute_t	*attr,		// "printer-strings-uri" attribute
+			*cattr;		// "printer-config-change-time" attribute
   char			scheme[32],	// URI scheme
   			userpass[256],	// Username/password info
   			hostname[256],	// Hostname
   			resource[1024],	// Resource
   			http_hostname[256],
   					// Hostname of connection
+			key[1280],	// Loaded strings key
+			cachefile[1024],// Cache filename
 			tempfile[1024];	// Temporary filename
   int			port;		// Port number
   http_encryption_t	encryption;	// Encryption to use
   cups_file_t		*temp;		// Temporary file
+  cups_lang_t		*lang;		// Default language
+  int			config_time;	// Printer configuration change time
+  bool			have_cache;	// Have a cache file?
 
 
   // See if there are any localizations...
@@ -287,6 +312,28 @@ cups_load_localizations(
     return;
   }
 
+  // See if this process has already loaded the strings...
+  lang        = cupsLangDefault();
+  cattr       = ippFindAttribute(dinfo->attrs, "printer-config-change-time", IPP_TAG_INTEGER);
+  config_time = ippGetInteger(cattr, 0);
+
+  snprintf(key, sizeof(key), "%s\t%d\t%s", cupsLangGetName(lang), config_time, attr->values[0].string.text);
+
+  if (cups_strings_find(key, false))
+  {
+    dinfo->localizations = true;
+    DEBUG_printf("4cups_load_localizations: Already loaded \"%s\".", attr->values[0].string.text);
+    return;
+  }
+
+  // Then see if we have a current copy on disk...
+  if ((have_cache = cattr && cups_strings_cache_file(attr->values[0].string.text, lang, cachefile, sizeof(cachefile))) && cups_strings_cache_load(lang, cachefile, config_time))
+  {
+    dinfo->localizations = true;
+    cups_strings_find(key, true);
+    return;
+  }
+
   // Pull apart the URI and determine whether we need to try a different
   // server...
   if (httpSeparateURI(HTTP_URI_CODING_ALL, attr->values[0].string.text, scheme, sizeof(scheme), userpass, sizeof(userpass), hostname, sizeof(hostname), &port, resource, sizeof(resource)) < HTTP_URI_STATUS_OK)
@@ -319,8 +366,21 @@ cups_load_localizations(
     }
   }
 
-  // Get a temporary file...
-  if ((temp = cupsCreateTempFile(NULL, ".strings", tempfile, sizeof(tempfile))) == NULL)
+  // Get a temporary file, in the cache directory if possible...
+  if (have_cache)
+  {
+    snprintf(tempfile, sizeof(tempfile), "%s.%d", cachefile, (int)getpid());
+
+    if ((temp = cupsFileOpen(tempfile, "w")) != NULL)
+    {
+      cupsFilePrintf(temp, "/* printer-config-change-time=%d */\n", config_time);
+      cupsFileFlush(temp);
+    }
+  }
+  else
+    temp = cupsCreateTempFile(NULL, ".strings", tempfile, sizeof(tempfile));
+
+  if (!temp)
   {
     DEBUG_printf("4cups_load_localizations: Unable to create temporary file: %s", cupsGetErrorString());
     if (http2 != http)
@@ -336,12 +396,121 @@ cups_load_localizations(
   if (status == HTTP_STATUS_OK)
   {
     // Got the file, read it...
-    dinfo->localizations = cupsLangLoadStrings(cupsLangDefault(), tempfile, NULL);
+    dinfo->localizations = cupsLangLoadStrings(lang, tempfile, NULL);
+
+    if (dinfo->localizations)
+    {
+      cups_strings_find(key, true);
+
+      if (have_cache && !rename(tempfile, cachefile))
+      {
+        DEBUG_printf("4cups_load_localizations: Saved cache file \"%s\".", cachefile);
+        tempfile[0] = '\0';
+      }
+    }
   }
 
   // Cleanup...
-  unlink(tempfile);
+  if (tempfile[0])
+    unlink(tempfile);
 
   if (http2 != http)
     httpClose(http2);
 }
+
+
+//
+// 'cups_strings_cache_file()' - Get the strings cache filename for a printer.
+//
+
+static bool				// O - `true` on success, `false` if no cache is available
+cups_strings_cache_file(
+    const char  *uri,			// I - "printer-strings-uri" value
+    cups_lang_t *lang,			// I - Language
+    char        *filename,		// I - Filename buffer
+    size_t      filesize)		// I - Size of filename buffer
+{
+  unsigned char	hash[32];		// SHA-256 hash of URI
+  char		hashstr[65];		// Hash string
+  _cups_globals_t *cg = _cupsGlobals();	// Pointer to library globals
+
+
+  if (!cg->userconfig || cupsHashData("sha2-256", uri, strlen(uri), hash, sizeof(hash)) < 0)
+    return (false);
+
+  snprintf(filename, filesize, "%s/dinfo", cg->userconfig);
+
+  if ((mkdir(cg->userconfig, 0700) && errno != EEXIST) || (mkdir(filename, 0700) && errno != EEXIST))
+    return (false);
+
+  snprintf(filename, filesize, "%s/dinfo/%s-%s.strings", cg->userconfig, cupsHashString(hash, sizeof(hash), hashstr, sizeof(hashstr)), cupsLangGetName(lang));
+
+  return (true);
+}
+
+
+//
+// 'cups_strings_cache_load()' - Load a cached strings file.
+//
+// The cached strings are only used when the printer reports the same
+// "printer-config-change-time" value as when the file was saved.
+//
+
+static bool				// O - `true` if loaded, `false` otherwise
+cups_strings_cache_load(
+    cups_lang_t *lang,			// I - Language
+    const char  *filename,		// I - Cache filename
+    int         config_time)		// I - "printer-config-change-time" value
+{
+  cups_file_t	*fp;			// Cache file
+  char		line[256];		// First line from file
+  int		cache_time;		// Cached "printer-config-change-time" value
+
+
+  if ((fp = cupsFileOpen(filename, "r")) == NULL)
+    return (false);
+
+  if (!cupsFileGets(fp, line, sizeof(line)) || sscanf(line, "/* printer-config-change-time=%d */", &cache_time) != 1 || cache_time != config_time)
+  {
+    DEBUG_printf("4cups_strings_cache_load: Cache file \"%s\" is out of date.", filename);
+    cupsFileClose(fp);
+    return (false);
+  }
+
+  cupsFileClose(fp);
+
+  DEBUG_printf("4cups_strings_cache_load: Using cache file \"%s\".", filename);
+
+  return (cupsLangLoadStrings(lang, filename, NULL));
+}
+
+
+//
+// 'cups_strings_find()' - Find or add a loaded strings file.
+//
+
+static bool				// O - `true` if found/added, `false` otherwise
+cups_strings_find(const char *key,	// I - Language, config time, and URI
+                  bool       add)	// I - Add the key?
+{
+  bool	ret;				// Return value
+
+
+  cupsMutexLock(&cups_strings_mutex);
+
+  if (add)
+  {
+    if (!cups_strings_loaded)
+      cups_strings_loaded = cupsArrayNewStrings(NULL, '\0');
+
+    ret = cupsArrayAdd(cups_strings_loaded, (void *)key);
+  }
+  else
+  {
+    ret = cupsArrayFind(cups_strings_loaded, (void *)key) != NULL;
+  }
+
+  cupsMutexUnlock(&cups_strings_mutex);
+
+  return (ret);
+}
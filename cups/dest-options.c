@@ -9,6 +9,8 @@
 //
 
 #include "cups-private.h"
+#include "file-private.h"
+#include <sys/stat.h>
 
 
 //
@@ -25,17 +27,28 @@
 static void		cups_add_dconstres(cups_array_t *a, ipp_t *collection);
 static bool		cups_collection_contains(ipp_t *test, ipp_t *match);
 static size_t		cups_collection_string(ipp_attribute_t *attr, char *buffer, size_t bufsize) _CUPS_NONNULL((1,2));
+static int		cups_compare_dcindex(_cups_dcindex_t *a, _cups_dcindex_t *b);
 static int		cups_compare_dconstres(_cups_dconstres_t *a, _cups_dconstres_t *b);
+static int		cups_compare_dcvalue(_cups_dcvalue_t *a, _cups_dcvalue_t *b);
 static int		cups_compare_media_db(_cups_media_db_t *a, _cups_media_db_t *b);
 static _cups_media_db_t	*cups_copy_media_db(_cups_media_db_t *mdb);
 static void		cups_create_cached(http_t *http, cups_dinfo_t *dinfo, unsigned flags);
+static void		cups_create_constraint_index(cups_dinfo_t *dinfo);
 static void		cups_create_constraints(cups_dinfo_t *dinfo);
 static void		cups_create_defaults(cups_dinfo_t *dinfo);
 static void		cups_create_media_db(cups_dinfo_t *dinfo, unsigned flags);
+static bool		cups_dinfo_cache_file(const char *uri, char *filename, size_t filesize);
+static ipp_t		*cups_dinfo_cache_load(http_t *http, const char *filename, const char *uri, const char *resource);
+static void		cups_dinfo_cache_save(const char *filename, ipp_t *response);
+static _cups_media_db_t	*cups_find_close_media_db(cups_array_t *db, _cups_media_db_t *key);
+static void		cups_free_dcindex(_cups_dcindex_t *idx);
 static void		cups_free_media_db(_cups_media_db_t *mdb);
 static bool		cups_get_media_db(http_t *http, cups_dinfo_t *dinfo, pwg_media_t *pwg, unsigned flags, cups_media_t *media);
 static bool		cups_is_close_media_db(_cups_media_db_t *a, _cups_media_db_t *b);
+static bool		cups_ready_changed(ipp_t *ready, ipp_t *current);
+static bool		cups_test_constraint(cups_dinfo_t *dinfo, _cups_dconstres_t *c, const char *new_option, const char *new_value, size_t num_options, cups_option_t *options, size_t *num_matching, cups_option_t **matching);
 static cups_array_t	*cups_test_constraints(cups_dinfo_t *dinfo, const char *new_option, const char *new_value, size_t num_options, cups_option_t *options, size_t *num_conflicts, cups_option_t **conflicts);
+static void		cups_update_attrs(http_t *http, cups_dinfo_t *dinfo, const char *name);
 static void		cups_update_ready(http_t *http, cups_dinfo_t *dinfo);
 
 
@@ -166,11 +179,13 @@ cupsCheckDestSupported(
   // Lookup the attribute...
   if (strstr(option, "-supported"))
   {
+    cups_update_attrs(http, dinfo, option);
     attr = ippFindAttribute(dinfo->attrs, option, IPP_TAG_ZERO);
   }
   else
   {
     snprintf(temp, sizeof(temp), "%s-supported", option);
+    cups_update_attrs(http, dinfo, temp);
     attr = ippFindAttribute(dinfo->attrs, temp, IPP_TAG_ZERO);
   }
 
@@ -389,6 +404,8 @@ cupsCopyDestConflicts(
     return (0);
 
   // Load constraints as needed...
+  cups_update_attrs(http, dinfo, NULL);
+
   if (!dinfo->constraints)
     cups_create_constraints(dinfo);
 
@@ -559,6 +576,18 @@ cupsCopyDestConflicts(
 // The caller is responsible for calling @link cupsFreeDestInfo@ on the return
 // value. @code NULL@ is returned on error.
 //
+// Printer attributes are cached in the per-user configuration directory for
+// printers that report the "printer-config-change-time" attribute.  The cached
+// attributes are shared by all processes run by the user and are only used
+// while the printer reports the same configuration change time.
+//
+// When "dflags" includes `CUPS_DEST_FLAGS_LAZY`, only the printer description
+// attributes are requested initially.  Individual "xxx-default" and
+// "xxx-supported" attributes are then requested as needed by the
+// @link cupsCheckDestSupported@, @link cupsFindDestDefault@, and
+// @link cupsFindDestSupported@ functions, and the remaining attributes are
+// requested as needed by the other functions.
+//
 
 cups_dinfo_t *				// O - Destination information
 cupsCopyDestInfo(
@@ -572,8 +601,11 @@ cupsCopyDestInfo(
   int		tries;			// Number of tries so far
   unsigned	delay;			// Current retry delay
   const char	*uri;			// Printer URI
-  char		resource[1024];		// Resource path
-  int		version;		// IPP version
+  char		resource[1024],		// Resource path
+		cachefile[1024];	// Attribute cache file
+  bool		have_cache;		// Have an attribute cache file?
+  int		version,		// IPP version
+		major, minor;		// IPP version numbers
   ipp_status_t	status;			// Status of request
   static const char * const requested_attrs[] =
   {					// Requested attributes
@@ -581,6 +613,10 @@ cupsCopyDestInfo(
     "media-col-database",
     "printer-description"
   };
+  static const char * const lazy_attrs[] =
+  {					// Requested attributes for lazy information
+    "printer-description"
+  };
 
 
   DEBUG_printf("cupsCopyDestInfo(http=%p, dest=%p(%s))", (void *)http, (void *)dest, dest ? dest->name : "");
@@ -596,7 +632,7 @@ cupsCopyDestInfo(
     if ((http = _cupsConnect()) == NULL)
       return (NULL);
 
-    dflags = CUPS_DEST_FLAGS_NONE;
+    dflags &= (cups_dest_flags_t)~CUPS_DEST_FLAGS_DEVICE;
   }
 
   // Get the printer URI and resource path...
@@ -606,6 +642,16 @@ cupsCopyDestInfo(
     return (NULL);
   }
 
+  // Use cached attributes as needed...
+  if ((have_cache = cups_dinfo_cache_file(uri, cachefile, sizeof(cachefile))) && (response = cups_dinfo_cache_load(http, cachefile, uri, resource)) != NULL)
+  {
+    major   = ippGetVersion(response, &minor);
+    version = major * 10 + minor;
+    dflags  &= (cups_dest_flags_t)~CUPS_DEST_FLAGS_LAZY;
+
+    goto create_dinfo;
+  }
+
   // Get the supported attributes...
   delay   = 1;
   tries   = 0;
@@ -619,7 +665,10 @@ cupsCopyDestInfo(
     ippSetVersion(request, version / 10, version % 10);
     ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_URI, "printer-uri", NULL, uri);
     ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_NAME, "requesting-user-name", NULL, cupsGetUser());
-    ippAddStrings(request, IPP_TAG_OPERATION, IPP_TAG_KEYWORD, "requested-attributes", sizeof(requested_attrs) / sizeof(requested_attrs[0]), NULL, requested_attrs);
+    if (dflags & CUPS_DEST_FLAGS_LAZY)
+      ippAddStrings(request, IPP_TAG_OPERATION, IPP_TAG_KEYWORD, "requested-attributes", sizeof(lazy_attrs) / sizeof(lazy_attrs[0]), NULL, lazy_attrs);
+    else
+      ippAddStrings(request, IPP_TAG_OPERATION, IPP_TAG_KEYWORD, "requested-attributes", sizeof(requested_attrs) / sizeof(requested_attrs[0]), NULL, requested_attrs);
     response = cupsDoRequest(http, request, resource);
     status   = cupsGetError();
 
@@ -659,8 +708,13 @@ cupsCopyDestInfo(
     return (NULL);
   }
 
+  if (have_cache && !(dflags & CUPS_DEST_FLAGS_LAZY))
+    cups_dinfo_cache_save(cachefile, response);
+
   // Allocate a cups_dinfo_t structure and return it...
-  if ((dinfo = calloc(1, sizeof(cups_dinfo_t))) == NULL)
+  create_dinfo:
+
+  if ((dinfo = _cupsMemCalloc(CUPS_MEMTYPE_OTHER, 1, sizeof(cups_dinfo_t))) == NULL)
   {
     _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(errno), 0);
     ippDelete(response);
@@ -674,6 +728,9 @@ cupsCopyDestInfo(
   dinfo->resource = _cupsStrAlloc(resource);
   dinfo->attrs    = response;
 
+  if (dflags & CUPS_DEST_FLAGS_LAZY)
+    dinfo->fetched = cupsArrayNewStrings(NULL, ',');
+
   return (dinfo);
 }
 
@@ -711,6 +768,8 @@ cupsFindDestDefault(
 
   // Find and return the attribute...
   snprintf(name, sizeof(name), "%s-default", option);
+  cups_update_attrs(http, dinfo, name);
+
   return (ippFindAttribute(dinfo->attrs, name, IPP_TAG_ZERO));
 }
 
@@ -724,6 +783,10 @@ cupsFindDestDefault(
 // @code ippGetResolution@, @code ippGetString@, and @code ippGetValueTag@
 // functions to inspect the default value(s) as needed.
 //
+// The ready values are queried at most every 30 seconds.  For printers that
+// report the "printer-config-change-time" attribute, they are only queried
+// again after the printer's configuration has changed.
+//
 
 ipp_attribute_t	*			// O - Default attribute or @code NULL@ for none
 cupsFindDestReady(
@@ -787,6 +850,8 @@ cupsFindDestSupported(
 
   // Find and return the attribute...
   snprintf(name, sizeof(name), "%s-supported", option);
+  cups_update_attrs(http, dinfo, name);
+
   return (ippFindAttribute(dinfo->attrs, name, IPP_TAG_ZERO));
 }
 
@@ -806,8 +871,11 @@ cupsFreeDestInfo(cups_dinfo_t *dinfo)	// I - Destination information
   // Free memory and return...
   _cupsStrFree(dinfo->resource);
 
+  cupsArrayDelete(dinfo->fetched);
+
   cupsArrayDelete(dinfo->constraints);
   cupsArrayDelete(dinfo->resolvers);
+  cupsArrayDelete(dinfo->constraint_index);
 
   cupsArrayDelete(dinfo->media_db);
 
@@ -818,7 +886,7 @@ cupsFreeDestInfo(cups_dinfo_t *dinfo)	// I - Destination information
 
   ippDelete(dinfo->attrs);
 
-  free(dinfo);
+  _cupsMemFree(dinfo);
 }
 
 
@@ -1127,7 +1195,7 @@ cups_add_dconstres(
   if ((attr = ippFindAttribute(collection, "resolver-name", IPP_TAG_NAME)) == NULL)
     return;
 
-  if ((temp = calloc(1, sizeof(_cups_dconstres_t))) == NULL)
+  if ((temp = _cupsMemCalloc(CUPS_MEMTYPE_OTHER, 1, sizeof(_cups_dconstres_t))) == NULL)
     return;
 
   temp->name       = attr->values[0].string.text;
@@ -1473,6 +1541,19 @@ cups_collection_string(
 }
 
 
+//
+// 'cups_compare_dcindex()' - Compare two constraint index entries.
+//
+
+static int				// O - Result of comparison
+cups_compare_dcindex(
+    _cups_dcindex_t *a,			// I - First index entry
+    _cups_dcindex_t *b)			// I - Second index entry
+{
+  return (strcmp(a->name, b->name));
+}
+
+
 //
 // 'cups_compare_dconstres()' - Compare to resolver entries.
 //
@@ -1486,6 +1567,19 @@ cups_compare_dconstres(
 }
 
 
+//
+// 'cups_compare_dcvalue()' - Compare two constraint values.
+//
+
+static int				// O - Result of comparison
+cups_compare_dcvalue(
+    _cups_dcvalue_t *a,			// I - First value
+    _cups_dcvalue_t *b)			// I - Second value
+{
+  return (strcmp(a->value, b->value));
+}
+
+
 //
 // 'cups_compare_media_db()' - Compare two media entries.
 //
@@ -1516,7 +1610,7 @@ cups_copy_media_db(
   _cups_media_db_t *temp;		// New media entry
 
 
-  if ((temp = calloc(1, sizeof(_cups_media_db_t))) == NULL)
+  if ((temp = _cupsMemCalloc(CUPS_MEMTYPE_OTHER, 1, sizeof(_cups_media_db_t))) == NULL)
     return (NULL);
 
   if (mdb->color)
@@ -1576,6 +1670,8 @@ cups_create_cached(http_t       *http,	// I - Connection to destination
   {
     DEBUG_puts("4cups_create_cached: supported media");
 
+    cups_update_attrs(http, dinfo, NULL);
+
     if (!dinfo->media_db)
       cups_create_media_db(dinfo, CUPS_MEDIA_FLAGS_DEFAULT);
 
@@ -1623,6 +1719,111 @@ cups_create_cached(http_t       *http,	// I - Connection to destination
 }
 
 
+//
+// 'cups_create_constraint_index()' - Create the index of constraint attributes.
+//
+// Each attribute used by a constraint gets a bitset of the constraints using
+// it and, for string values, a bitset of the constraints matching each value.
+// This lets @code cups_test_constraints@ skip most constraints with a few word
+// operations per attribute.  The index is not created if memory runs out, in
+// which case all constraints are tested.
+//
+
+static void
+cups_create_constraint_index(
+    cups_dinfo_t *dinfo)		// I - Destination information
+{
+  size_t		i, j,		// Looping vars
+			count,		// Number of constraints
+			words;		// Number of words in bitsets
+  uint64_t		bit;		// Bit for current constraint
+  _cups_dconstres_t	*c;		// Current constraint
+  ipp_attribute_t	*attr;		// Current attribute
+  _cups_dcindex_t	*idx,		// Current index entry
+			ikey;		// Search key
+  _cups_dcvalue_t	*dval,		// Current value
+			vkey;		// Search key
+
+
+  count = cupsArrayGetCount(dinfo->constraints);
+  words = (count + 63) / 64;
+
+  dinfo->constraint_words = words;
+  dinfo->constraint_index = cupsArrayNew((cups_array_cb_t)cups_compare_dcindex, NULL, NULL, 0, NULL, (cups_afree_cb_t)cups_free_dcindex);
+
+  for (i = 0; i < count; i ++)
+  {
+    c   = (_cups_dconstres_t *)cupsArrayGetElement(dinfo->constraints, i);
+    bit = (uint64_t)1 << (i % 64);
+
+    for (attr = ippGetFirstAttribute(c->collection); attr; attr = ippGetNextAttribute(c->collection))
+    {
+      if ((ikey.name = ippGetName(attr)) == NULL)
+        continue;
+
+      if ((idx = (_cups_dcindex_t *)cupsArrayFind(dinfo->constraint_index, &ikey)) == NULL)
+      {
+        if ((idx = _cupsMemCalloc(CUPS_MEMTYPE_OTHER, 1, sizeof(_cups_dcindex_t) + 2 * words * sizeof(uint64_t))) == NULL)
+          goto error;
+
+        idx->name   = ikey.name;
+        idx->values = cupsArrayNew((cups_array_cb_t)cups_compare_dcvalue, NULL, NULL, 0, NULL, (cups_afree_cb_t)_cupsMemFree);
+
+        cupsArrayAdd(dinfo->constraint_index, idx);
+      }
+
+      idx->bits[i / 64] |= bit;
+
+      switch (ippGetValueTag(attr))
+      {
+	case IPP_TAG_TEXT :
+	case IPP_TAG_NAME :
+	case IPP_TAG_KEYWORD :
+	case IPP_TAG_CHARSET :
+	case IPP_TAG_URI :
+	case IPP_TAG_URISCHEME :
+	case IPP_TAG_MIMETYPE :
+	case IPP_TAG_LANGUAGE :
+	case IPP_TAG_TEXTLANG :
+	case IPP_TAG_NAMELANG :
+	    // String values are matched exactly, so record which constraints
+	    // match each value...
+	    idx->bits[words + i / 64] |= bit;
+
+	    for (j = 0; j < ippGetCount(attr); j ++)
+	    {
+	      if ((vkey.value = ippGetString(attr, j, NULL)) == NULL)
+	        continue;
+
+	      if ((dval = (_cups_dcvalue_t *)cupsArrayFind(idx->values, &vkey)) == NULL)
+	      {
+		if ((dval = _cupsMemCalloc(CUPS_MEMTYPE_OTHER, 1, sizeof(_cups_dcvalue_t) + words * sizeof(uint64_t))) == NULL)
+		  goto error;
+
+		dval->value = vkey.value;
+		cupsArrayAdd(idx->values, dval);
+	      }
+
+	      dval->matches[i / 64] |= bit;
+	    }
+	    break;
+
+	default :
+	    break;
+      }
+    }
+  }
+
+  return;
+
+  // If we get here, we ran out of memory...
+  error:
+
+  cupsArrayDelete(dinfo->constraint_index);
+  dinfo->constraint_index = NULL;
+}
+
+
 //
 // 'cups_create_constraints()' - Create the constraints and resolvers arrays.
 //
@@ -1636,8 +1837,8 @@ cups_create_constraints(
   _ipp_value_t		*val;		// Current value
 
 
-  dinfo->constraints = cupsArrayNew(NULL, NULL, NULL, 0, NULL, (cups_afree_cb_t)free);
-  dinfo->resolvers   = cupsArrayNew((cups_array_cb_t)cups_compare_dconstres, NULL, NULL, 0, NULL, (cups_afree_cb_t)free);
+  dinfo->constraints = cupsArrayNew(NULL, NULL, NULL, 0, NULL, (cups_afree_cb_t)_cupsMemFree);
+  dinfo->resolvers   = cupsArrayNew((cups_array_cb_t)cups_compare_dconstres, NULL, NULL, 0, NULL, (cups_afree_cb_t)_cupsMemFree);
 
   if ((attr = ippFindAttribute(dinfo->attrs, "job-constraints-supported",
 			       IPP_TAG_BEGIN_COLLECTION)) != NULL)
@@ -1652,6 +1853,8 @@ cups_create_constraints(
     for (i = attr->num_values, val = attr->values; i > 0; i --, val ++)
       cups_add_dconstres(dinfo->resolvers, val->collection);
   }
+
+  cups_create_constraint_index(dinfo);
 }
 
 
@@ -1959,6 +2162,220 @@ cups_create_media_db(
 }
 
 
+//
+// 'cups_dinfo_cache_file()' - Get the attribute cache filename for a printer.
+//
+
+static bool				// O - `true` on success, `false` if no cache is available
+cups_dinfo_cache_file(
+    const char *uri,			// I - Printer URI
+    char       *filename,		// I - Filename buffer
+    size_t     filesize)		// I - Size of filename buffer
+{
+  unsigned char	hash[32];		// SHA-256 hash of URI
+  char		hashstr[65];		// Hash string
+  _cups_globals_t *cg = _cupsGlobals();	// Pointer to library globals
+
+
+  if (!cg->userconfig || cupsHashData("sha2-256", uri, strlen(uri), hash, sizeof(hash)) < 0)
+    return (false);
+
+  snprintf(filename, filesize, "%s/dinfo", cg->userconfig);
+
+  if ((mkdir(cg->userconfig, 0700) && errno != EEXIST) || (mkdir(filename, 0700) && errno != EEXIST))
+    return (false);
+
+  snprintf(filename, filesize, "%s/dinfo/%s.ipp", cg->userconfig, cupsHashString(hash, sizeof(hash), hashstr, sizeof(hashstr)));
+
+  return (true);
+}
+
+
+//
+// 'cups_dinfo_cache_load()' - Load cached attributes for a printer.
+//
+// The cached attributes are only used when the printer reports the same
+// "printer-config-change-time" value.  The current printer state values are
+// copied from the validation response to the cached attributes.
+//
+
+static ipp_t *				// O - Cached attributes or `NULL` if not valid
+cups_dinfo_cache_load(
+    http_t     *http,			// I - Connection to destination
+    const char *filename,		// I - Cache filename
+    const char *uri,			// I - Printer URI
+    const char *resource)		// I - Resource path
+{
+  int		fd;			// Cache file
+  ipp_t		*cached,		// Cached attributes
+		*request,		// Get-Printer-Attributes request
+		*response;		// Current printer state
+  ipp_attribute_t *attr,		// Current attribute
+		*cattr;			// Cached attribute
+  int		major, minor;		// IPP version numbers
+  ipp_state_t	state;			// Read state
+  static const char * const requested_attrs[] =
+  {					// Requested attributes
+    "printer-config-change-time",
+    "printer-is-accepting-jobs",
+    "printer-state",
+    "printer-state-change-time",
+    "printer-state-message",
+    "printer-state-reasons",
+    "printer-up-time"
+  };
+
+
+  // Read the cache file...
+  if ((fd = open(filename, O_RDONLY | O_BINARY)) < 0)
+    return (NULL);
+
+  cached = ippNew();
+  state  = ippReadFile(fd, cached);
+
+  close(fd);
+
+  if (state != IPP_STATE_DATA || (cattr = ippFindAttribute(cached, "printer-config-change-time", IPP_TAG_INTEGER)) == NULL)
+  {
+    DEBUG_printf("3cups_dinfo_cache_load: Ignoring bad cache file \"%s\".", filename);
+    ippDelete(cached);
+    return (NULL);
+  }
+
+  // Validate it against the printer's current configuration change time...
+  major   = ippGetVersion(cached, &minor);
+  request = ippNewRequest(IPP_OP_GET_PRINTER_ATTRIBUTES);
+
+  ippSetVersion(request, major, minor);
+  ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_URI, "printer-uri", NULL, uri);
+  ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_NAME, "requesting-user-name", NULL, cupsGetUser());
+  ippAddStrings(request, IPP_TAG_OPERATION, IPP_TAG_KEYWORD, "requested-attributes", sizeof(requested_attrs) / sizeof(requested_attrs[0]), NULL, requested_attrs);
+
+  response = cupsDoRequest(http, request, resource);
+
+  if (cupsGetError() > IPP_STATUS_OK_IGNORED_OR_SUBSTITUTED || (attr = ippFindAttribute(response, "printer-config-change-time", IPP_TAG_INTEGER)) == NULL || ippGetInteger(attr, 0) != ippGetInteger(cattr, 0))
+  {
+    DEBUG_printf("3cups_dinfo_cache_load: Cache file \"%s\" is out of date.", filename);
+    ippDelete(cached);
+    ippDelete(response);
+    return (NULL);
+  }
+
+  // Update the printer state values...
+  for (attr = ippGetFirstAttribute(response); attr; attr = ippGetNextAttribute(response))
+  {
+    if (ippGetGroupTag(attr) != IPP_TAG_PRINTER || !ippGetName(attr))
+      continue;
+
+    if ((cattr = ippFindAttribute(cached, ippGetName(attr), IPP_TAG_ZERO)) != NULL)
+      ippDeleteAttribute(cached, cattr);
+
+    ippCopyAttribute(cached, attr, false);
+  }
+
+  ippDelete(response);
+
+  DEBUG_printf("3cups_dinfo_cache_load: Using cache file \"%s\".", filename);
+
+  return (cached);
+}
+
+
+//
+// 'cups_dinfo_cache_save()' - Save printer attributes to the cache.
+//
+// Only printers that report "printer-config-change-time" are cached.  The
+// file is replaced atomically so that other processes never see a partial
+// file.
+//
+
+static void
+cups_dinfo_cache_save(
+    const char *filename,		// I - Cache filename
+    ipp_t      *response)		// I - Printer attributes
+{
+  int		fd;			// Cache file
+  char		tempfile[1024];		// Temporary cache file
+  ipp_state_t	state;			// Write state
+  static cups_atomic_t temp_count = 0;	// Temporary file counter
+
+
+  if (!ippFindAttribute(response, "printer-config-change-time", IPP_TAG_INTEGER))
+  {
+    unlink(filename);
+    return;
+  }
+
+  // Make the temporary filename unique for each thread in this process...
+  snprintf(tempfile, sizeof(tempfile), "%s.%d.%d", filename, (int)getpid(), (int)cupsAtomicInc(&temp_count));
+
+  if ((fd = open(tempfile, O_WRONLY | O_CREAT | O_EXCL | O_BINARY, 0600)) < 0)
+    return;
+
+  ippSetState(response, IPP_STATE_IDLE);
+  state = ippWriteFile(fd, response);
+
+  if (close(fd) || state != IPP_STATE_DATA || rename(tempfile, filename))
+    unlink(tempfile);
+  else
+    DEBUG_printf("3cups_dinfo_cache_save: Saved cache file \"%s\".", filename);
+}
+
+
+//
+// 'cups_find_close_media_db()' - Find the first close media size.
+//
+// The media database is sorted by width and then length, so a binary search
+// finds the first entry within the width tolerance and only the entries within
+// that band of widths need to be checked.  The current element of the array is
+// left at the returned entry.
+//
+
+static _cups_media_db_t *		// O - First close entry or `NULL` if none
+cups_find_close_media_db(
+    cups_array_t     *db,		// I - Media database
+    _cups_media_db_t *key)		// I - Search key
+{
+  size_t		left,		// Left side of search
+			right,		// Right side of search
+			current;	// Current element
+  _cups_media_db_t	*mdb;		// Current media database entry
+
+
+  for (left = 0, right = cupsArrayGetCount(db); left < right;)
+  {
+    current = (left + right) / 2;
+    mdb     = (_cups_media_db_t *)cupsArrayGetElement(db, current);
+
+    if (mdb->width < (key->width - 176))
+      left = current + 1;
+    else
+      right = current;
+  }
+
+  for (mdb = (_cups_media_db_t *)cupsArrayGetElement(db, left); mdb && mdb->width <= (key->width + 176); mdb = (_cups_media_db_t *)cupsArrayGetNext(db))
+  {
+    if (cups_is_close_media_db(mdb, key))
+      return (mdb);
+  }
+
+  return (NULL);
+}
+
+
+//
+// 'cups_free_dcindex()' - Free a constraint index entry.
+//
+
+static void
+cups_free_dcindex(
+    _cups_dcindex_t *idx)		// I - Index entry
+{
+  cupsArrayDelete(idx->values);
+  _cupsMemFree(idx);
+}
+
+
 //
 // 'cups_free_media_cb()' - Free a media entry.
 //
@@ -1980,7 +2397,7 @@ cups_free_media_db(
   if (mdb->type)
     _cupsStrFree(mdb->type);
 
-  free(mdb);
+  _cupsMemFree(mdb);
 }
 
 
@@ -2009,6 +2426,8 @@ cups_get_media_db(http_t       *http,	// I - Connection to destination
   }
   else
   {
+    cups_update_attrs(http, dinfo, NULL);
+
     if (!dinfo->media_db)
       cups_create_media_db(dinfo, CUPS_MEDIA_FLAGS_DEFAULT);
 
@@ -2097,13 +2516,7 @@ cups_get_media_db(http_t       *http,	// I - Connection to destination
   else
   {
     // Find a close size...
-    for (mdb = (_cups_media_db_t *)cupsArrayGetFirst(db); mdb; mdb = (_cups_media_db_t *)cupsArrayGetNext(db))
-    {
-      if (cups_is_close_media_db(mdb, &key))
-        break;
-    }
-
-    if (!mdb)
+    if ((mdb = cups_find_close_media_db(db, &key)) == NULL)
       return (false);
 
     best = mdb;
@@ -2192,26 +2605,63 @@ cups_is_close_media_db(
 
 
 //
-// 'cups_test_constraints()' - Test constraints.
+// 'cups_ready_changed()' - Determine whether the printer configuration has
+//                          changed since the xxx-ready attributes were queried.
 //
 
-static cups_array_t *			// O - Active constraints
-cups_test_constraints(
-    cups_dinfo_t  *dinfo,		// I - Destination information
-    const char    *new_option,		// I - Newly selected option
-    const char    *new_value,		// I - Newly selected value
-    size_t        num_options,		// I - Number of options
-    cups_option_t *options,		// I - Options
-    size_t        *num_conflicts,	// O - Number of conflicting options
-    cups_option_t **conflicts)		// O - Conflicting options
+static bool				// O - `true` if changed, `false` otherwise
+cups_ready_changed(ipp_t *ready,	// I - xxx-ready attributes
+                   ipp_t *current)	// I - Current configuration change time
+{
+  ipp_attribute_t	*rattr,		// Attribute from xxx-ready query
+			*cattr;		// Current attribute
+  const ipp_uchar_t	*rdate,		// Date from xxx-ready query
+			*cdate;		// Current date
+
+
+  // printer-config-change-time is relative to printer-up-time...
+  rattr = ippFindAttribute(ready, "printer-config-change-time", IPP_TAG_INTEGER);
+  cattr = ippFindAttribute(current, "printer-config-change-time", IPP_TAG_INTEGER);
+
+  if (!cattr || ippGetInteger(rattr, 0) != ippGetInteger(cattr, 0))
+    return (true);
+
+  // ... so make sure the printer hasn't been restarted...
+  rattr = ippFindAttribute(ready, "printer-up-time", IPP_TAG_INTEGER);
+  cattr = ippFindAttribute(current, "printer-up-time", IPP_TAG_INTEGER);
+
+  if (rattr && cattr && ippGetInteger(cattr, 0) < ippGetInteger(rattr, 0))
+    return (true);
+
+  // and compare the absolute change date and time, if reported...
+  rattr = ippFindAttribute(ready, "printer-config-change-date-time", IPP_TAG_DATE);
+  cattr = ippFindAttribute(current, "printer-config-change-date-time", IPP_TAG_DATE);
+
+  if (rattr && cattr && (rdate = ippGetDate(rattr, 0)) != NULL && (cdate = ippGetDate(cattr, 0)) != NULL && memcmp(rdate, cdate, 11))
+    return (true);
+
+  return (false);
+}
+
+
+//
+// 'cups_test_constraint()' - Test a single constraint.
+//
+
+static bool				// O - `true` if the constraint is active, `false` otherwise
+cups_test_constraint(
+    cups_dinfo_t      *dinfo,		// I - Destination information
+    _cups_dconstres_t *c,		// I - Constraint
+    const char        *new_option,	// I - Newly selected option
+    const char        *new_value,	// I - Newly selected value
+    size_t            num_options,	// I - Number of options
+    cups_option_t     *options,		// I - Options
+    size_t            *num_matching,	// O - Number of matching options
+    cups_option_t     **matching)	// O - Matching options
 {
   size_t		i,		// Looping var
 			count;		// Number of values
   bool			match;		// Value matches?
-  size_t		num_matching;	// Number of matching options
-  cups_option_t		*matching;	// Matching options
-  _cups_dconstres_t	*c;		// Current constraint
-  cups_array_t		*active = NULL;	// Active constraints
   ipp_t			*col;		// Collection value
   ipp_attribute_t	*attr;		// Current attribute
   _ipp_value_t		*attrval;	// Current attribute value
@@ -2223,142 +2673,218 @@ cups_test_constraints(
   ipp_res_t		units_value;	// Resolution units
 
 
-  for (c = (_cups_dconstres_t *)cupsArrayGetFirst(dinfo->constraints); c; c = (_cups_dconstres_t *)cupsArrayGetNext(dinfo->constraints))
+  for (attr = ippGetFirstAttribute(c->collection); attr; attr = ippGetNextAttribute(c->collection))
   {
-    num_matching = 0;
-    matching     = NULL;
+    // Get the value for the current attribute in the constraint...
+    if (new_option && new_value && !strcmp(attr->name, new_option))
+      value = new_value;
+    else if ((value = cupsGetOption(attr->name, num_options, options)) == NULL)
+      value = cupsGetOption(attr->name, dinfo->num_defaults, dinfo->defaults);
 
-    for (attr = ippGetFirstAttribute(c->collection); attr; attr = ippGetNextAttribute(c->collection))
+    if (!value)
     {
-      // Get the value for the current attribute in the constraint...
-      if (new_option && new_value && !strcmp(attr->name, new_option))
-        value = new_value;
-      else if ((value = cupsGetOption(attr->name, num_options, options)) == NULL)
-        value = cupsGetOption(attr->name, dinfo->num_defaults, dinfo->defaults);
-
-      if (!value)
-      {
-        // Not set so this constraint does not apply...
-        break;
-      }
+      // Not set so this constraint does not apply...
+      break;
+    }
 
-      match = false;
+    match = false;
 
-      switch (attr->value_tag)
-      {
-        case IPP_TAG_INTEGER :
-        case IPP_TAG_ENUM :
-	    int_value = atoi(value);
+    switch (attr->value_tag)
+    {
+      case IPP_TAG_INTEGER :
+      case IPP_TAG_ENUM :
+	  int_value = atoi(value);
 
-	    for (i = attr->num_values, attrval = attr->values; i > 0; i --, attrval ++)
+	  for (i = attr->num_values, attrval = attr->values; i > 0; i --, attrval ++)
+	  {
+	    if (attrval->integer == int_value)
 	    {
-	      if (attrval->integer == int_value)
-	      {
-		match = true;
-		break;
-	      }
-            }
-            break;
+	      match = true;
+	      break;
+	    }
+          }
+          break;
 
-        case IPP_TAG_BOOLEAN :
-	    int_value = !strcmp(value, "true");
+      case IPP_TAG_BOOLEAN :
+	  int_value = !strcmp(value, "true");
 
-	    for (i = attr->num_values, attrval = attr->values; i > 0; i --, attrval ++)
+	  for (i = attr->num_values, attrval = attr->values; i > 0; i --, attrval ++)
+	  {
+	    if (attrval->boolean == int_value)
 	    {
-	      if (attrval->boolean == int_value)
-	      {
-		match = true;
-		break;
-	      }
-            }
-            break;
-
-        case IPP_TAG_RANGE :
-	    int_value = atoi(value);
+	      match = true;
+	      break;
+	    }
+          }
+          break;
 
-	    for (i = attr->num_values, attrval = attr->values; i > 0; i --, attrval ++)
-	    {
-	      if (int_value >= attrval->range.lower && int_value <= attrval->range.upper)
-	      {
-		match = true;
-		break;
-	      }
-            }
-            break;
+      case IPP_TAG_RANGE :
+	  int_value = atoi(value);
 
-        case IPP_TAG_RESOLUTION :
-	    if (sscanf(value, "%dx%d%15s", &xres_value, &yres_value, temp) != 3)
+	  for (i = attr->num_values, attrval = attr->values; i > 0; i --, attrval ++)
+	  {
+	    if (int_value >= attrval->range.lower && int_value <= attrval->range.upper)
 	    {
-	      if (sscanf(value, "%d%15s", &xres_value, temp) != 2)
-		break;
-
-	      yres_value = xres_value;
+	      match = true;
+	      break;
 	    }
+          }
+          break;
 
-	    if (!strcmp(temp, "dpi"))
-	      units_value = IPP_RES_PER_INCH;
-	    else if (!strcmp(temp, "dpc") || !strcmp(temp, "dpcm"))
-	      units_value = IPP_RES_PER_CM;
-	    else
+      case IPP_TAG_RESOLUTION :
+	  if (sscanf(value, "%dx%d%15s", &xres_value, &yres_value, temp) != 3)
+	  {
+	    if (sscanf(value, "%d%15s", &xres_value, temp) != 2)
 	      break;
 
-	    for (i = attr->num_values, attrval = attr->values; i > 0; i --, attrval ++)
+	    yres_value = xres_value;
+	  }
+
+	  if (!strcmp(temp, "dpi"))
+	    units_value = IPP_RES_PER_INCH;
+	  else if (!strcmp(temp, "dpc") || !strcmp(temp, "dpcm"))
+	    units_value = IPP_RES_PER_CM;
+	  else
+	    break;
+
+	  for (i = attr->num_values, attrval = attr->values; i > 0; i --, attrval ++)
+	  {
+	    if (attrval->resolution.xres == xres_value && attrval->resolution.yres == yres_value && attrval->resolution.units == units_value)
 	    {
-	      if (attrval->resolution.xres == xres_value && attrval->resolution.yres == yres_value && attrval->resolution.units == units_value)
-	      {
-	      	match = true;
-		break;
-	      }
+	      match = true;
+	      break;
 	    }
-            break;
+	  }
+          break;
 
-	case IPP_TAG_TEXT :
-	case IPP_TAG_NAME :
-	case IPP_TAG_KEYWORD :
-	case IPP_TAG_CHARSET :
-	case IPP_TAG_URI :
-	case IPP_TAG_URISCHEME :
-	case IPP_TAG_MIMETYPE :
-	case IPP_TAG_LANGUAGE :
-	case IPP_TAG_TEXTLANG :
-	case IPP_TAG_NAMELANG :
-	    for (i = attr->num_values, attrval = attr->values; i > 0; i --, attrval ++)
+      case IPP_TAG_TEXT :
+      case IPP_TAG_NAME :
+      case IPP_TAG_KEYWORD :
+      case IPP_TAG_CHARSET :
+      case IPP_TAG_URI :
+      case IPP_TAG_URISCHEME :
+      case IPP_TAG_MIMETYPE :
+      case IPP_TAG_LANGUAGE :
+      case IPP_TAG_TEXTLANG :
+      case IPP_TAG_NAMELANG :
+	  for (i = attr->num_values, attrval = attr->values; i > 0; i --, attrval ++)
+	  {
+	    if (!strcmp(attrval->string.text, value))
 	    {
-	      if (!strcmp(attrval->string.text, value))
-	      {
-		match = true;
-		break;
-	      }
-            }
-	    break;
+	      match = true;
+	      break;
+	    }
+          }
+	  break;
 
-        case IPP_TAG_BEGIN_COLLECTION :
-            col = ippNew();
-            _cupsEncodeOption(col, IPP_TAG_ZERO, NULL, ippGetName(attr), value);
+      case IPP_TAG_BEGIN_COLLECTION :
+          col = ippNew();
+          _cupsEncodeOption(col, IPP_TAG_ZERO, NULL, ippGetName(attr), value);
 
-            for (i = 0, count = ippGetCount(attr); i < count; i ++)
+          for (i = 0, count = ippGetCount(attr); i < count; i ++)
+          {
+            if (cups_collection_contains(col, ippGetCollection(attr, i)))
             {
-              if (cups_collection_contains(col, ippGetCollection(attr, i)))
-              {
-                match = true;
-                break;
-	      }
-            }
+              match = true;
+              break;
+	    }
+          }
 
-            ippDelete(col);
-            break;
+          ippDelete(col);
+          break;
 
-        default :
-            break;
-      }
+      default :
+          break;
+    }
+
+    if (!match)
+      break;
+
+    *num_matching = cupsAddOption(attr->name, value, *num_matching, matching);
+  }
+
+  return (attr == NULL);
+}
+
+
+//
+// 'cups_test_constraints()' - Test constraints.
+//
+// The constraint index is used to skip constraints that cannot apply because
+// one of their attributes is not set or has a string value that does not
+// match.  The remaining constraints are then tested individually.
+//
+
+static cups_array_t *			// O - Active constraints
+cups_test_constraints(
+    cups_dinfo_t  *dinfo,		// I - Destination information
+    const char    *new_option,		// I - Newly selected option
+    const char    *new_value,		// I - Newly selected value
+    size_t        num_options,		// I - Number of options
+    cups_option_t *options,		// I - Options
+    size_t        *num_conflicts,	// O - Number of conflicting options
+    cups_option_t **conflicts)		// O - Conflicting options
+{
+  size_t		i, j,		// Looping vars
+			count,		// Number of constraints
+			words;		// Number of words in bitsets
+  uint64_t		*candidates = NULL;
+					// Bitset of candidate constraints
+  size_t		num_matching;	// Number of matching options
+  cups_option_t		*matching;	// Matching options
+  _cups_dconstres_t	*c;		// Current constraint
+  cups_array_t		*active = NULL;	// Active constraints
+  _cups_dcindex_t	*idx;		// Current index entry
+  _cups_dcvalue_t	*dval,		// Matching value
+			vkey;		// Search key
+
+
+  count = cupsArrayGetCount(dinfo->constraints);
+  words = dinfo->constraint_words;
 
-      if (!match)
-        break;
+  if (dinfo->constraint_index && (candidates = _cupsMemAlloc(CUPS_MEMTYPE_OTHER, words * sizeof(uint64_t))) != NULL)
+  {
+    // Start with all constraints and then remove the ones that can't apply...
+    memset(candidates, 0xff, words * sizeof(uint64_t));
+
+    for (idx = (_cups_dcindex_t *)cupsArrayGetFirst(dinfo->constraint_index); idx; idx = (_cups_dcindex_t *)cupsArrayGetNext(dinfo->constraint_index))
+    {
+      if (new_option && new_value && !strcmp(idx->name, new_option))
+        vkey.value = new_value;
+      else if ((vkey.value = cupsGetOption(idx->name, num_options, options)) == NULL)
+        vkey.value = cupsGetOption(idx->name, dinfo->num_defaults, dinfo->defaults);
 
-      num_matching = cupsAddOption(attr->name, value, num_matching, &matching);
+      if (!vkey.value)
+      {
+        // Not set, constraints using this attribute don't apply...
+        for (j = 0; j < words; j ++)
+          candidates[j] &= ~idx->bits[j];
+      }
+      else if ((dval = (_cups_dcvalue_t *)cupsArrayFind(idx->values, &vkey)) != NULL)
+      {
+        // Only constraints with a matching string value apply...
+        for (j = 0; j < words; j ++)
+          candidates[j] &= ~idx->bits[words + j] | dval->matches[j];
+      }
+      else
+      {
+        // No string values match, only non-string constraints apply...
+        for (j = 0; j < words; j ++)
+          candidates[j] &= ~idx->bits[words + j];
+      }
     }
+  }
+
+  for (i = 0; i < count; i ++)
+  {
+    if (candidates && !(candidates[i / 64] & ((uint64_t)1 << (i % 64))))
+      continue;
 
-    if (!attr)
+    c            = (_cups_dconstres_t *)cupsArrayGetElement(dinfo->constraints, i);
+    num_matching = 0;
+    matching     = NULL;
+
+    if (cups_test_constraint(dinfo, c, new_option, new_value, num_options, options, &num_matching, &matching))
     {
       if (!active)
         active = cupsArrayNew(NULL, NULL, NULL, 0, NULL, NULL);
@@ -2369,7 +2895,7 @@ cups_test_constraints(
       {
         cups_option_t	*moption;	// Matching option
 
-        for (i = num_matching, moption = matching; i > 0; i --, moption ++)
+        for (j = num_matching, moption = matching; j > 0; j --, moption ++)
           *num_conflicts = cupsAddOption(moption->name, moption->value, *num_conflicts, conflicts);
       }
     }
@@ -2377,19 +2903,97 @@ cups_test_constraints(
     cupsFreeOptions(num_matching, matching);
   }
 
+  _cupsMemFree(candidates);
+
   return (active);
 }
 
 
+//
+// 'cups_update_attrs()' - Get printer attributes for lazy destination information.
+//
+// When "name" is `NULL`, all of the attributes that were not requested by
+// @link cupsCopyDestInfo@ are requested.  Otherwise only the named attribute
+// is requested, once.  Nothing is done for destination information that
+// already has all of the attributes.
+//
+
+static void
+cups_update_attrs(http_t       *http,	// I - Connection to destination
+                  cups_dinfo_t *dinfo,	// I - Destination information
+                  const char   *name)	// I - Attribute name or `NULL` for all
+{
+  ipp_t			*request,	// Get-Printer-Attributes request
+			*response;	// Supported attributes
+  ipp_attribute_t	*attr;		// Current attribute
+  static const char * const requested_attrs[] =
+  {					// Requested attributes
+    "job-template",
+    "media-col-database"
+  };
+
+
+  if (!dinfo->fetched || (name && cupsArrayFind(dinfo->fetched, (void *)name)))
+    return;
+
+  DEBUG_printf("3cups_update_attrs(http=%p, dinfo=%p, name=\"%s\")", (void *)http, (void *)dinfo, name);
+
+  request = ippNewRequest(IPP_OP_GET_PRINTER_ATTRIBUTES);
+
+  ippSetVersion(request, dinfo->version / 10, dinfo->version % 10);
+  ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_URI, "printer-uri", NULL, dinfo->uri);
+  ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_NAME, "requesting-user-name", NULL, cupsGetUser());
+  if (name)
+    ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_KEYWORD, "requested-attributes", NULL, name);
+  else
+    ippAddStrings(request, IPP_TAG_OPERATION, IPP_TAG_KEYWORD, "requested-attributes", sizeof(requested_attrs) / sizeof(requested_attrs[0]), NULL, requested_attrs);
+
+  if ((response = cupsDoRequest(http, request, dinfo->resource)) == NULL || cupsGetError() > IPP_STATUS_OK_IGNORED_OR_SUBSTITUTED)
+  {
+    // Try again next time...
+    DEBUG_printf("4cups_update_attrs: Get-Printer-Attributes returned %s (%s)", ippErrorString(cupsGetError()), cupsGetErrorString());
+    ippDelete(response);
+    return;
+  }
+
+  // Add any new printer attributes...
+  for (attr = ippGetFirstAttribute(response); attr; attr = ippGetNextAttribute(response))
+  {
+    if (ippGetGroupTag(attr) == IPP_TAG_PRINTER && ippGetName(attr) && !ippFindAttribute(dinfo->attrs, ippGetName(attr), IPP_TAG_ZERO))
+      ippCopyAttribute(dinfo->attrs, attr, false);
+  }
+
+  ippDelete(response);
+
+  if (name)
+  {
+    cupsArrayAdd(dinfo->fetched, (void *)name);
+  }
+  else
+  {
+    // Have everything now...
+    cupsArrayDelete(dinfo->fetched);
+    dinfo->fetched = NULL;
+  }
+}
+
+
 //
 // 'cups_update_ready()' - Update xxx-ready attributes for the printer.
 //
+// The xxx-ready attributes are queried at most once every 30 seconds.  For
+// printers that report "printer-config-change-time", only the configuration
+// change time is queried after that and the xxx-ready attributes are only
+// queried again when the printer configuration (including the loaded media)
+// has changed or the printer has been restarted.
+//
 
 static void
 cups_update_ready(http_t       *http,	// I - Connection to destination
                   cups_dinfo_t *dinfo)	// I - Destination information
 {
-  ipp_t	*request;			// Get-Printer-Attributes request
+  ipp_t	*request,			// Get-Printer-Attributes request
+	*response;			// Current configuration change time
   static const char * const pattrs[] =	// Printer attributes we want
   {
     "finishings-col-ready",
@@ -2397,7 +3001,10 @@ cups_update_ready(http_t       *http,	// I - Connection to destination
     "job-finishings-col-ready",
     "job-finishings-ready",
     "media-col-ready",
-    "media-ready"
+    "media-ready",
+    "printer-config-change-date-time",
+    "printer-config-change-time",
+    "printer-up-time"
   };
 
 
@@ -2405,6 +3012,31 @@ cups_update_ready(http_t       *http,	// I - Connection to destination
   if ((time(NULL) - dinfo->ready_time) < _CUPS_MEDIA_READY_TTL)
     return;
 
+  if (ippFindAttribute(dinfo->ready_attrs, "printer-config-change-time", IPP_TAG_INTEGER))
+  {
+    // See if the printer configuration has changed...
+    bool	changed;		// Has the configuration changed?
+
+    request = ippNewRequest(IPP_OP_GET_PRINTER_ATTRIBUTES);
+    ippSetVersion(request, dinfo->version / 10, dinfo->version % 10);
+
+    ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_URI, "printer-uri", NULL, dinfo->uri);
+    ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_NAME, "requesting-user-name", NULL, cupsGetUser());
+    ippAddStrings(request, IPP_TAG_OPERATION, IPP_CONST_TAG(IPP_TAG_KEYWORD), "requested-attributes", 3, NULL, pattrs + 6);
+
+    response = cupsDoRequest(http, request, dinfo->resource);
+    changed  = cupsGetError() > IPP_STATUS_OK_IGNORED_OR_SUBSTITUTED || cups_ready_changed(dinfo->ready_attrs, response);
+
+    ippDelete(response);
+
+    if (!changed)
+    {
+      DEBUG_puts("3cups_update_ready: Configuration has not changed.");
+      dinfo->ready_time = time(NULL);
+      return;
+    }
+  }
+
   // Free any previous results...
   if (dinfo->cached_flags & CUPS_MEDIA_FLAGS_READY)
   {
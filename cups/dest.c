@@ -42,6 +42,8 @@
 
 #define _CUPS_DNSSD_GET_DESTS	250	// Milliseconds for cupsGetDests
 #define _CUPS_DNSSD_MAXTIME	50	// Milliseconds for maximum quantum of time
+#define _CUPS_DNSSD_MAX_PROBES	16	// Default maximum number of concurrent device probes
+#define _CUPS_DNSSD_PROBE_TIME	30000	// Milliseconds for device probes without a timeout
 
 
 //
@@ -53,6 +55,8 @@ typedef enum _cups_dnssd_state_e	// Enumerated device state
   _CUPS_DNSSD_NEW,
   _CUPS_DNSSD_QUERY,
   _CUPS_DNSSD_PENDING,
+  _CUPS_DNSSD_PROBE,
+  _CUPS_DNSSD_PROBED,
   _CUPS_DNSSD_ACTIVE,
   _CUPS_DNSSD_INCOMPATIBLE,
   _CUPS_DNSSD_ERROR
@@ -71,6 +75,8 @@ typedef struct _cups_dnssd_data_s	// Enumeration data
   cups_dest_t		*dests;		// lpoptions destinations
   char			def_name[1024],	// Default printer name, if any
 			*def_instance;	// Default printer instance, if any
+  int			probe_cancel;	// Cancel device probes?
+  struct timeval	probe_end;	// Deadline for device probes
 } _cups_dnssd_data_t;
 
 typedef struct _cups_dnssd_device_s	// Enumerated device
@@ -82,6 +88,7 @@ typedef struct _cups_dnssd_device_s	// Enumerated device
 			*domain;	// Domain name
   cups_ptype_t		type;		// Device registration type
   cups_dest_t		dest;		// Destination record
+  _cups_dnssd_data_t	*data;		// Enumeration data for device probes
 } _cups_dnssd_device_t;
 
 typedef struct _cups_dnssd_resdata_s	// Data for resolving URI
@@ -122,9 +129,14 @@ static CFStringRef	appleGetPrinter(CFArrayRef locations, CFStringRef network, CF
 static cups_dest_t	*cups_add_dest(const char *name, const char *instance, size_t *num_dests, cups_dest_t **dests);
 static int		cups_compare_dests(cups_dest_t *a, cups_dest_t *b);
 static void		cups_dest_browse_cb(cups_dnssd_browse_t *browse, void *cb_data, cups_dnssd_flags_t flags, uint32_t if_index, const char *name, const char *regtype, const char *domain);
+static int		cups_dest_cache_check(const char *filename);
+static int		cups_dest_cache_file(char *filename, size_t filesize);
+static void		cups_dest_cache_save(const char *filename, size_t num_dests, cups_dest_t *dests);
+static void		*cups_dest_cache_thread(void *data);
 static int		cups_dnssd_compare_devices(_cups_dnssd_device_t *a, _cups_dnssd_device_t *b);
 static void		cups_dnssd_free_device(_cups_dnssd_device_t *device, _cups_dnssd_data_t *data);
 static _cups_dnssd_device_t *cups_dnssd_get_device(_cups_dnssd_data_t *data, const char *serviceName, const char *regtype, const char *replyDomain);
+static void		*cups_dnssd_probe_device(_cups_dnssd_device_t *device);
 static void		cups_dest_query_cb(cups_dnssd_query_t *query, void *cb_data, cups_dnssd_flags_t flags, uint32_t if_index, const char *fullname, uint16_t rrtype, const void *qdata, uint16_t qlen);
 static const char	*cups_dest_resolve(cups_dest_t *dest, const char *uri, int msec, int *cancel, cups_dest_cb_t cb, void *user_data);
 static bool		cups_dest_resolve_cb(void *context);
@@ -132,11 +144,13 @@ static void		cups_dnssd_unquote(char *dst, const char *src, size_t dstsize);
 static int		cups_elapsed(struct timeval *t);
 static bool		cups_enum_dests(http_t *http, unsigned flags, int msec, int *cancel, cups_ptype_t type, cups_ptype_t mask, cups_dest_cb_t cb, void *user_data);
 static size_t		cups_find_dest(const char *name, const char *instance, size_t num_dests, cups_dest_t *dests, size_t prev, int *rdiff);
+static size_t		cups_get_all_dests(http_t *http, cups_dest_t **dests);
 static bool		cups_get_cb(_cups_getdata_t *data, unsigned flags, cups_dest_t *dest);
 static char		*cups_get_default(const char *filename, char *namebuf, size_t namesize, const char **instance);
 static size_t		cups_get_dests(const char *filename, const char *match_name, const char *match_inst, bool load_all, bool user_default_set, size_t num_dests, cups_dest_t **dests);
 static char		*cups_make_string(ipp_attribute_t *attr, char *buffer, size_t bufsize);
 static bool		cups_name_cb(_cups_namedata_t *data, unsigned flags, cups_dest_t *dest);
+static int		cups_put_option(FILE *fp, cups_option_t *option);
 static void		cups_queue_name(char *name, const char *serviceName, size_t namesize);
 static void		dnssd_error_cb(void *cb_data, const char *message);
 
@@ -190,7 +204,7 @@ cupsAddDest(const char  *name,		// I  - Destination name
     if (instance && parent && parent->num_options > 0)
     {
       // Copy options from parent...
-      dest->options = calloc(sizeof(cups_option_t), (size_t)parent->num_options);
+      dest->options = _cupsMemCalloc(CUPS_MEMTYPE_OTHER, sizeof(cups_option_t), (size_t)parent->num_options);
 
       if (dest->options)
       {
@@ -428,7 +442,8 @@ _cupsAppleSetUseLastPrinter(
 // will block until a connection is made, the timeout expires, the integer
 // pointed to by "cancel" is non-zero, or the callback function (or block)
 // returns `0`.  The caller is responsible for calling @link httpClose@ on the
-// returned connection.
+// returned connection, or @link httpReleaseConnection@ to return it to the
+// idle connection pool for reuse by a later call.
 //
 // The caller can pass `CUPS_DEST_FLAGS_DEVICE` for the "flags" argument to
 // connect directly to the device associated with the destination.  Otherwise,
@@ -528,6 +543,20 @@ cupsConnectDest(
     return (NULL);
   }
 
+  if (!strcmp(scheme, "ipps") || port == 443)
+    encryption = HTTP_ENCRYPTION_ALWAYS;
+  else
+    encryption = HTTP_ENCRYPTION_IF_REQUESTED;
+
+  // Use an idle connection from the pool, if any...
+  if (!(flags & CUPS_DEST_FLAGS_UNCONNECTED) && (http = _httpGetIdleConnection(hostname, port, AF_UNSPEC, encryption)) != NULL)
+  {
+    if (cb)
+      (*cb)(user_data, CUPS_DEST_FLAGS_NONE, dest);
+
+    return (http);
+  }
+
   // Lookup the address for the server...
   if (cb)
     (*cb)(user_data, CUPS_DEST_FLAGS_UNCONNECTED | CUPS_DEST_FLAGS_RESOLVING, dest);
@@ -553,11 +582,6 @@ cupsConnectDest(
   }
 
   // Create the HTTP object pointing to the server referenced by the URI...
-  if (!strcmp(scheme, "ipps") || port == 443)
-    encryption = HTTP_ENCRYPTION_ALWAYS;
-  else
-    encryption = HTTP_ENCRYPTION_IF_REQUESTED;
-
   http = httpConnect(hostname, port, addrlist, AF_UNSPEC, encryption, 1, 0, NULL);
   httpAddrFreeList(addrlist);
 
@@ -637,7 +661,7 @@ cupsCopyDest(cups_dest_t *dest,		// I  - Destination to copy
   {
     new_dest->is_default = dest->is_default;
 
-    if ((new_dest->options = calloc(sizeof(cups_option_t), (size_t)dest->num_options)) == NULL)
+    if ((new_dest->options = _cupsMemCalloc(CUPS_MEMTYPE_OTHER, sizeof(cups_option_t), (size_t)dest->num_options)) == NULL)
       return (cupsRemoveDest(dest->name, dest->instance, num_dests, dests));
 
     new_dest->num_options = dest->num_options;
@@ -746,6 +770,12 @@ _cupsCreateDest(const char *name,	// I - Printer name
 // Enumeration happens on the current thread and does not return until all
 // destinations have been enumerated or the callback function returns `false`.
 //
+// When "flags" includes `CUPS_DEST_FLAGS_DEVICE`, discovered printers are
+// resolved and queried for their current state, description, and location
+// before they are reported.  The probes run concurrently, up to the number of
+// probes specified by the `CUPS_DEST_MAX_PROBES` environment variable (default
+// 16), and must complete within the "msec" timeout.
+//
 // Note: The callback function will likely receive multiple updates for the same
 // destinations - it is up to the caller to suppress any duplicate destinations.
 //
@@ -787,7 +817,7 @@ cupsFreeDests(size_t      num_dests,	// I - Number of destinations
     cupsFreeOptions(dest->num_options, dest->options);
   }
 
-  free(dests);
+  _cupsMemFree(dests);
 }
 
 
@@ -1024,7 +1054,7 @@ cupsGetDestWithURI(const char *name,	// I - Desired printer name or `NULL`
   }
 
   // Create the destination...
-  if ((dest = calloc(1, sizeof(cups_dest_t))) == NULL)
+  if ((dest = _cupsMemCalloc(CUPS_MEMTYPE_OTHER, 1, sizeof(cups_dest_t))) == NULL)
   {
     _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(errno), 0);
     return (NULL);
@@ -1297,6 +1327,13 @@ _cupsGetDests(http_t       *http,	// I  - Connection to server or `CUPS_HTTP_DEF
 // Use the @link cupsFreeDests@ function to free the destination list and
 // the @link cupsGetDest@ function to find a particular destination.
 //
+// If the `CUPS_DEST_CACHE` environment variable is set to a number of seconds
+// and "http" is @code CUPS_HTTP_DEFAULT@, the destinations are saved to a
+// per-user cache file and returned from it for up to that many seconds.  The
+// cache is refreshed in the background once it is half that age, and is not
+// used when the server, the user default printer, or the lpoptions files
+// change.
+//
 //
 //
 
@@ -1304,7 +1341,14 @@ size_t					// O - Number of destinations
 cupsGetDests(http_t      *http,		// I - Connection to server or @code CUPS_HTTP_DEFAULT@
              cups_dest_t **dests)	// O - Destinations
 {
-  _cups_getdata_t data;                 // Enumeration data
+  size_t	num_dests;		// Number of destinations
+  char		cachefile[1024];	// Destination cache file
+  int		max_age,		// Maximum age of cache
+		cache_age;		// Current age of cache
+  cups_thread_t	thread;			// Refresh thread
+  static cups_mutex_t refresh_mutex = CUPS_MUTEX_INITIALIZER;
+					// Mutex for refresh thread
+  static time_t	refresh_time = 0;	// Time of last refresh
 
 
   DEBUG_printf("cupsGetDests(http=%p, dests=%p)", (void *)http, (void *)dests);
@@ -1317,42 +1361,37 @@ cupsGetDests(http_t      *http,		// I - Connection to server or @code CUPS_HTTP_
     return (0);
   }
 
-  // Connect to the server as needed...
-  if (!http)
+  // Use the destination cache as needed...
+  if (!http && (max_age = cups_dest_cache_file(cachefile, sizeof(cachefile))) > 0)
   {
-    if ((http = _cupsConnect()) == NULL)
+    if ((cache_age = cups_dest_cache_check(cachefile)) >= 0 && cache_age < max_age && (num_dests = cups_get_dests(cachefile, NULL, NULL, true, false, 0, dests)) > 0)
     {
-      *dests = NULL;
+      DEBUG_printf("1cupsGetDests: Using %u cached destinations, %d seconds old.", (unsigned)num_dests, cache_age);
 
-      return (0);
-    }
-  }
+      if (cache_age >= max_age / 2)
+      {
+        // Refresh the cache in the background, at most once per interval...
+        cupsMutexLock(&refresh_mutex);
+        if (refresh_time <= (time(NULL) - max_age / 2) && (thread = cupsThreadCreate((cups_thread_func_t)cups_dest_cache_thread, NULL)) != CUPS_THREAD_INVALID)
+        {
+          refresh_time = time(NULL);
+          cupsThreadDetach(thread);
+        }
+        cupsMutexUnlock(&refresh_mutex);
+      }
 
-  // Grab the printers and classes...
-  data.num_dests = 0;
-  data.dests     = NULL;
+      _cupsSetError(IPP_STATUS_OK, NULL, 0);
 
-  if (!httpAddrIsLocalhost(httpGetAddress(http)))
-  {
-    // When talking to a remote cupsd, just enumerate printers on the remote cupsd.
-    cups_enum_dests(http, 0, _CUPS_DNSSD_GET_DESTS, NULL, 0, CUPS_PTYPE_DISCOVERED, (cups_dest_cb_t)cups_get_cb, &data);
-  }
-  else
-  {
-    // When talking to a local cupsd, enumerate both local printers and ones we
-    // can find on the network...
-    cups_enum_dests(http, 0, _CUPS_DNSSD_GET_DESTS, NULL, 0, 0, (cups_dest_cb_t)cups_get_cb, &data);
-  }
-
-  // Return the number of destinations...
-  *dests = data.dests;
+      return (num_dests);
+    }
 
-  if (data.num_dests > 0)
-    _cupsSetError(IPP_STATUS_OK, NULL, 0);
+    if ((num_dests = cups_get_all_dests(http, dests)) > 0)
+      cups_dest_cache_save(cachefile, num_dests, *dests);
 
-  DEBUG_printf("1cupsGetDests: Returning %u destinations.", (unsigned)data.num_dests);
+    return (num_dests);
+  }
 
-  return (data.num_dests);
+  return (cups_get_all_dests(http, dests));
 }
 
 
@@ -1705,31 +1744,7 @@ cupsSetDests(http_t      *http,		// I - Connection to server or @code CUPS_HTTP_
           wrote = true;
 	}
 
-        if (option->value[0])
-	{
-	  if (strchr(option->value, ' ') || strchr(option->value, '\\') || strchr(option->value, '\"') || strchr(option->value, '\''))
-	  {
-	    // Quote the value...
-	    fprintf(fp, " %s=\"", option->name);
-
-	    for (val = option->value; *val; val ++)
-	    {
-	      if (strchr("\"\'\\", *val))
-	        putc('\\', fp);
-
-              putc(*val, fp);
-	    }
-
-	    putc('\"', fp);
-          }
-	  else
-	  {
-	    // Store the literal value...
-	    fprintf(fp, " %s=%s", option->name, option->value);
-          }
-	}
-	else
-	  fprintf(fp, " %s", option->name);
+        cups_put_option(fp, option);
       }
 
       if (wrote)
@@ -1742,6 +1757,9 @@ cupsSetDests(http_t      *http,		// I - Connection to server or @code CUPS_HTTP_
 
   fclose(fp);
 
+  // Make sure the new lpoptions file is read the next time...
+  _cupsConfFlush(filename);
+
 #ifdef __APPLE__
   // Set the default printer for this location - this allows command-line
   // and GUI applications to share the same default destination...
@@ -1988,9 +2006,9 @@ cups_add_dest(const char  *name,	// I  - Name of destination
 
   // Add new destination...
   if (*num_dests == 0)
-    dest = malloc(sizeof(cups_dest_t));
+    dest = _cupsMemAlloc(CUPS_MEMTYPE_OTHER, sizeof(cups_dest_t));
   else
-    dest = realloc(*dests, sizeof(cups_dest_t) * (size_t)(*num_dests + 1));
+    dest = _cupsMemRealloc(CUPS_MEMTYPE_OTHER, *dests, sizeof(cups_dest_t) * (size_t)(*num_dests + 1));
 
   if (!dest)
     return (NULL);
@@ -2075,6 +2093,179 @@ cups_dest_browse_cb(
   // Get the device...
   cups_dnssd_get_device(data, serviceName, regtype, replyDomain);
 }
+
+
+//
+// 'cups_dest_cache_check()' - Check whether the destination cache is usable.
+//
+// The cache is only usable when it was written for the current server and
+// user default printer, and is newer than the lpoptions files.
+//
+
+static int				// O - Age of cache in seconds or `-1` if not usable
+cups_dest_cache_check(
+    const char *filename)		// I - Cache filename
+{
+  int		age = -1;		// Age of cache
+  struct stat	cinfo,			// Cache file information
+		linfo;			// lpoptions file information
+  char		lpoptions[1024],	// lpoptions filename
+		defname[256],		// User default printer
+		*user_default;		// User default printer, if any
+  const char	*value;			// Value from cache file
+  cups_conf_t	*conf;			// Cache file
+  _cups_globals_t *cg = _cupsGlobals();	// Pointer to library globals
+
+
+  if (stat(filename, &cinfo))
+    return (-1);
+
+  snprintf(lpoptions, sizeof(lpoptions), "%s/lpoptions", cg->sysconfig);
+  if (!stat(lpoptions, &linfo) && linfo.st_mtime >= cinfo.st_mtime)
+    return (-1);
+
+  if (cg->userconfig)
+  {
+    snprintf(lpoptions, sizeof(lpoptions), "%s/lpoptions", cg->userconfig);
+    if (!stat(lpoptions, &linfo) && linfo.st_mtime >= cinfo.st_mtime)
+      return (-1);
+  }
+
+  if ((conf = cupsConfOpen(filename)) == NULL)
+    return (-1);
+
+  user_default = _cupsGetUserDefault(defname, sizeof(defname));
+
+  if ((value = cupsConfGetValue(conf, "Server")) != NULL && !strcmp(value, cupsGetServer()))
+  {
+    if ((value = cupsConfGetValue(conf, "UserDefault")) == NULL)
+      value = "";
+
+    if (!strcmp(value, user_default ? user_default : ""))
+      age = (int)(time(NULL) - cinfo.st_mtime);
+  }
+
+  cupsConfClose(conf);
+
+  DEBUG_printf("7cups_dest_cache_check(filename=\"%s\"): Returning %d.", filename, age);
+
+  return (age);
+}
+
+
+//
+// 'cups_dest_cache_file()' - Get the destination cache filename.
+//
+// The cache is enabled by setting the `CUPS_DEST_CACHE` environment variable
+// to the maximum age of the cache in seconds.
+//
+
+static int				// O - Maximum age of cache in seconds or `0` if disabled
+cups_dest_cache_file(char   *filename,	// I - Filename buffer
+                     size_t filesize)	// I - Size of filename buffer
+{
+  const char	*value;			// CUPS_DEST_CACHE value
+  int		max_age;		// Maximum age of cache
+  _cups_globals_t *cg = _cupsGlobals();	// Pointer to library globals
+
+
+  if ((value = getenv("CUPS_DEST_CACHE")) == NULL || (max_age = atoi(value)) <= 0 || !cg->userconfig)
+    return (0);
+
+  snprintf(filename, filesize, "%s/dests.cache", cg->userconfig);
+
+  return (max_age);
+}
+
+
+//
+// 'cups_dest_cache_save()' - Save destinations to the cache.
+//
+// The file uses the lpoptions format with additional "Server" and
+// "UserDefault" lines for validation, and is replaced atomically.
+//
+
+static void
+cups_dest_cache_save(
+    const char  *filename,		// I - Cache filename
+    size_t      num_dests,		// I - Number of destinations
+    cups_dest_t *dests)			// I - Destinations
+{
+  size_t	i, j;			// Looping vars
+  int		linelen;		// Length of current line
+  cups_dest_t	*dest;			// Current destination
+  cups_option_t	*option;		// Current option
+  FILE		*fp;			// Cache file
+  char		tempfile[1024],		// Temporary cache file
+		defname[256],		// User default printer
+		*user_default;		// User default printer, if any
+  _cups_globals_t *cg = _cupsGlobals();	// Pointer to library globals
+
+
+  if (mkdir(cg->userconfig, 0700) && errno != EEXIST)
+    return;
+
+  snprintf(tempfile, sizeof(tempfile), "%s.%d", filename, (int)getpid());
+  if ((fp = fopen(tempfile, "w")) == NULL)
+    return;
+
+  user_default = _cupsGetUserDefault(defname, sizeof(defname));
+
+  fputs("# Destination cache written by libcups, do not edit.\n", fp);
+  fprintf(fp, "Server %s\n", cupsGetServer());
+  if (user_default)
+    fprintf(fp, "UserDefault %s\n", user_default);
+
+  for (i = num_dests, dest = dests; i > 0; i --, dest ++)
+  {
+    linelen = fprintf(fp, "%s %s", dest->is_default ? "Default" : "Dest", dest->name);
+    if (dest->instance)
+      linelen += fprintf(fp, "/%s", dest->instance);
+
+    for (j = dest->num_options, option = dest->options; j > 0; j --, option ++)
+    {
+      // Skip options that would overflow the 8k line limit for lpoptions
+      // files...
+      if ((linelen + strlen(option->name) + 2 * strlen(option->value) + 4) >= 8192)
+        continue;
+
+      linelen += cups_put_option(fp, option);
+    }
+
+    fputs("\n", fp);
+  }
+
+  if (fclose(fp) || rename(tempfile, filename))
+    unlink(tempfile);
+}
+
+
+//
+// 'cups_dest_cache_thread()' - Refresh the destination cache in the background.
+//
+
+static void *				// O - Thread exit status
+cups_dest_cache_thread(void *data)	// I - Thread data (unused)
+{
+  char		cachefile[1024];	// Cache filename
+  size_t	num_dests;		// Number of destinations
+  cups_dest_t	*dests;			// Destinations
+
+
+  (void)data;
+
+  if (cups_dest_cache_file(cachefile, sizeof(cachefile)) > 0)
+  {
+    if ((num_dests = cups_get_all_dests(CUPS_HTTP_DEFAULT, &dests)) > 0)
+      cups_dest_cache_save(cachefile, num_dests, dests);
+
+    cupsFreeDests(num_dests, dests);
+  }
+
+  return (NULL);
+}
+
+
 //
 // 'cups_dnssd_compare_device()' - Compare two devices.
 //
@@ -2106,7 +2297,7 @@ cups_dnssd_free_device(
 
   cupsFreeOptions(device->dest.num_options, device->dest.options);
 
-  free(device);
+  _cupsMemFree(device);
 }
 
 
@@ -2178,7 +2369,7 @@ cups_dnssd_get_device(
     // No, add the device...
     DEBUG_printf("6cups_dnssd_get_device: Adding '%s' for %s with domain '%s'.", serviceName, !strcmp(regtype, "_ipps._tcp") ? "IPPS" : "IPP", replyDomain);
 
-    if ((device = calloc(sizeof(_cups_dnssd_device_t), 1)) == NULL)
+    if ((device = _cupsMemCalloc(CUPS_MEMTYPE_OTHER, sizeof(_cups_dnssd_device_t), 1)) == NULL)
       return (NULL);
 
     device->dest.name = _cupsStrAlloc(name);
@@ -2561,6 +2752,95 @@ cups_dest_resolve_cb(void *context)	// I - Resolve data
 }
 
 
+//
+// 'cups_dnssd_probe_device()' - Resolve and query a discovered device.
+//
+// This function runs on a device probe thread.  The device is not reported or
+// otherwise touched by the enumeration loop until its state is changed to
+// `_CUPS_DNSSD_PROBED`.
+//
+
+static void *				// O - Thread exit status
+cups_dnssd_probe_device(
+    _cups_dnssd_device_t *device)	// I - Device
+{
+  _cups_dnssd_data_t *data = device->data;
+					// Enumeration data
+  int		msec;			// Remaining time in milliseconds
+  struct timeval curtime;		// Current time
+  const char	*uri;			// Device URI
+  char		scheme[32],		// URI scheme
+		userpass[256],		// Username and password (unused)
+		hostname[256],		// Hostname
+		resource[1024],		// Resource path
+		value[2048];		// Attribute value
+  int		port;			// Port number
+  http_t	*http;			// Connection to device
+  ipp_t		*request,		// IPP request
+		*response;		// IPP response
+  ipp_attribute_t *attr;		// Current attribute
+  static const char * const pattrs[] =	// Attributes we're interested in
+  {
+    "printer-info",
+    "printer-is-accepting-jobs",
+    "printer-location",
+    "printer-make-and-model",
+    "printer-state",
+    "printer-state-message",
+    "printer-state-reasons"
+  };
+
+
+  DEBUG_printf("5cups_dnssd_probe_device(device=%p(%s))", (void *)device, device->fullname);
+
+  gettimeofday(&curtime, NULL);
+  msec = (int)((data->probe_end.tv_sec - curtime.tv_sec) * 1000 + (data->probe_end.tv_usec - curtime.tv_usec) / 1000);
+
+  if (msec > 0 && !data->probe_cancel && (uri = cupsGetOption("device-uri", device->dest.num_options, device->dest.options)) != NULL)
+  {
+    // Resolve the device URI as needed...
+    if (strstr(uri, "._tcp"))
+      uri = cups_dest_resolve(&device->dest, uri, msec, &data->probe_cancel, NULL, NULL);
+
+    msec -= cups_elapsed(&curtime);
+
+    if (uri && msec > 0 && httpSeparateURI(HTTP_URI_CODING_ALL, uri, scheme, sizeof(scheme), userpass, sizeof(userpass), hostname, sizeof(hostname), &port, resource, sizeof(resource)) >= HTTP_URI_STATUS_OK && (http = httpConnect(hostname, port, NULL, AF_UNSPEC, (!strcmp(scheme, "ipps") || port == 443) ? HTTP_ENCRYPTION_ALWAYS : HTTP_ENCRYPTION_IF_REQUESTED, true, msec, &data->probe_cancel)) != NULL)
+    {
+      // Get the current printer attributes...
+      if ((msec -= cups_elapsed(&curtime)) > 0)
+      {
+	httpSetTimeout(http, msec / 1000.0, NULL, NULL);
+
+	request = ippNewRequest(IPP_OP_GET_PRINTER_ATTRIBUTES);
+	ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_URI, "printer-uri", NULL, uri);
+	ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_NAME, "requesting-user-name", NULL, cupsGetUser());
+	ippAddStrings(request, IPP_TAG_OPERATION, IPP_TAG_KEYWORD, "requested-attributes", sizeof(pattrs) / sizeof(pattrs[0]), NULL, pattrs);
+
+	if ((response = cupsDoRequest(http, request, resource)) != NULL)
+	{
+	  for (attr = ippGetFirstAttribute(response); attr; attr = ippGetNextAttribute(response))
+	  {
+	    if (ippGetGroupTag(attr) == IPP_TAG_PRINTER && ippGetName(attr))
+	      device->dest.num_options = cupsAddOption(ippGetName(attr), cups_make_string(attr, value, sizeof(value)), device->dest.num_options, &device->dest.options);
+	  }
+
+	  ippDelete(response);
+	}
+      }
+
+      httpClose(http);
+    }
+  }
+
+  // Let the enumeration loop report the device...
+  cupsRWLockWrite(&data->rwlock);
+  device->state = _CUPS_DNSSD_PROBED;
+  cupsRWUnlock(&data->rwlock);
+
+  return (NULL);
+}
+
+
 //
 // 'cups_dnssd_unquote()' - Unquote a name string.
 //
@@ -2645,6 +2925,8 @@ cups_enum_dests(
 		completed;		// Number of completed queries
   int		remaining;		// Remainder of timeout
   struct timeval curtime;               // Current time
+  cups_thread_pool_t *pool = NULL;	// Device probe threads
+  const char	*max_probes;		// CUPS_DEST_MAX_PROBES value
   _cups_dnssd_data_t data;		// Data for callback
   _cups_dnssd_device_t *device;         // Current device
   cups_dnssd_t	*dnssd = NULL;		// DNS-SD context
@@ -2655,8 +2937,6 @@ cups_enum_dests(
   DEBUG_printf("cups_enum_dests(flags=%x, msec=%d, cancel=%p, type=%x, mask=%x, cb=%p, user_data=%p)", flags, msec, (void *)cancel, type, mask, (void *)cb, (void *)user_data);
 
   // Range check input...
-  (void)flags;
-
   if (!cb)
   {
     DEBUG_puts("1cups_enum_dests: No callback, returning 0.");
@@ -2836,6 +3116,25 @@ cups_enum_dests(
 
   gettimeofday(&curtime, NULL);
 
+  if (flags & CUPS_DEST_FLAGS_DEVICE)
+  {
+    // Probe discovered devices concurrently, all within the timeout...
+    if ((max_probes = getenv("CUPS_DEST_MAX_PROBES")) == NULL || atoi(max_probes) <= 0)
+      max_probes = NULL;
+
+    pool = cupsThreadPoolNew(max_probes ? (size_t)atoi(max_probes) : _CUPS_DNSSD_MAX_PROBES, 0);
+
+    data.probe_end = curtime;
+    data.probe_end.tv_sec  += (msec > 0 ? msec : _CUPS_DNSSD_PROBE_TIME) / 1000;
+    data.probe_end.tv_usec += ((msec > 0 ? msec : _CUPS_DNSSD_PROBE_TIME) % 1000) * 1000;
+
+    while (data.probe_end.tv_usec >= 1000000)
+    {
+      data.probe_end.tv_sec ++;
+      data.probe_end.tv_usec -= 1000000;
+    }
+  }
+
   while (remaining > 0 && (!cancel || !*cancel))
   {
     // Check for input...
@@ -2868,7 +3167,17 @@ cups_enum_dests(
           DEBUG_puts("1cups_enum_dests: Query failed.");
         }
       }
-      else if (device->query && device->state == _CUPS_DNSSD_PENDING)
+      else if (pool && device->query && device->state == _CUPS_DNSSD_PENDING && (device->type & mask) == type)
+      {
+        DEBUG_printf("1cups_enum_dests: Probing \"%s\".", device->fullname);
+
+        device->data  = &data;
+        device->state = _CUPS_DNSSD_PROBE;
+
+        if (!cupsThreadPoolAdd(pool, (cups_thread_func_t)cups_dnssd_probe_device, device))
+          device->state = _CUPS_DNSSD_PROBED;
+      }
+      else if (device->query && (device->state == _CUPS_DNSSD_PENDING || device->state == _CUPS_DNSSD_PROBED))
       {
         completed ++;
 
@@ -2940,6 +3249,9 @@ cups_enum_dests(
   // Return...
   enum_finished:
 
+  data.probe_cancel = 1;
+  cupsThreadPoolDelete(pool);
+
   cupsDNSSDDelete(dnssd);
 
   cupsFreeDests(data.num_dests, data.dests);
@@ -3036,6 +3348,57 @@ cups_find_dest(const char  *name,	// I - Destination name
 }
 
 
+//
+// 'cups_get_all_dests()' - Get the list of destinations from the server and
+//                          network.
+//
+
+static size_t				// O - Number of destinations
+cups_get_all_dests(http_t      *http,	// I - Connection to server or `CUPS_HTTP_DEFAULT`
+                   cups_dest_t **dests)	// O - Destinations
+{
+  _cups_getdata_t data;                 // Enumeration data
+
+
+  // Connect to the server as needed...
+  if (!http)
+  {
+    if ((http = _cupsConnect()) == NULL)
+    {
+      *dests = NULL;
+
+      return (0);
+    }
+  }
+
+  // Grab the printers and classes...
+  data.num_dests = 0;
+  data.dests     = NULL;
+
+  if (!httpAddrIsLocalhost(httpGetAddress(http)))
+  {
+    // When talking to a remote cupsd, just enumerate printers on the remote cupsd.
+    cups_enum_dests(http, 0, _CUPS_DNSSD_GET_DESTS, NULL, 0, CUPS_PTYPE_DISCOVERED, (cups_dest_cb_t)cups_get_cb, &data);
+  }
+  else
+  {
+    // When talking to a local cupsd, enumerate both local printers and ones we
+    // can find on the network...
+    cups_enum_dests(http, 0, _CUPS_DNSSD_GET_DESTS, NULL, 0, 0, (cups_dest_cb_t)cups_get_cb, &data);
+  }
+
+  // Return the number of destinations...
+  *dests = data.dests;
+
+  if (data.num_dests > 0)
+    _cupsSetError(IPP_STATUS_OK, NULL, 0);
+
+  DEBUG_printf("7cups_get_all_dests: Returning %u destinations.", (unsigned)data.num_dests);
+
+  return (data.num_dests);
+}
+
+
 //
 // 'cups_get_cb()' - Collect enumerated destinations.
 //
@@ -3070,22 +3433,23 @@ cups_get_default(const char *filename,	// I - File to read
 		 size_t     namesize,	// I - Size of name buffer
 		 const char **instance)	// I - Instance
 {
-  cups_file_t	*fp;			// lpoptions file
-  char		line[8192],		// Line from file
-		*value,			// Value for line
-		*nameptr;		// Pointer into name
-  int		linenum;		// Current line
+  cups_conf_t	*conf;			// lpoptions file
+  size_t	i,			// Looping var
+		count;			// Number of directives
+  const char	*directive,		// Directive from file
+		*value;			// Value for directive
+  char		*nameptr;		// Pointer into name
 
 
   *namebuf = '\0';
 
-  if ((fp = cupsFileOpen(filename, "r")) != NULL)
+  if ((conf = cupsConfOpen(filename)) != NULL)
   {
-    linenum  = 0;
-
-    while (cupsFileGetConf(fp, line, sizeof(line), &value, &linenum))
+    for (i = 0, count = cupsConfGetCount(conf); i < count; i ++)
     {
-      if (!_cups_strcasecmp(line, "default") && value)
+      directive = cupsConfGetDirective(conf, i, &value, NULL);
+
+      if (!_cups_strcasecmp(directive, "default") && value)
       {
         cupsCopyString(namebuf, value, namesize);
 
@@ -3102,7 +3466,7 @@ cups_get_default(const char *filename,	// I - File to read
       }
     }
 
-    cupsFileClose(fp);
+    cupsConfClose(conf);
   }
 
   return (*namebuf ? namebuf : NULL);
@@ -3123,10 +3487,14 @@ cups_get_dests(
     size_t      num_dests,		// I - Number of destinations
     cups_dest_t **dests)		// IO - Destinations
 {
-  size_t	i;			// Looping var
+  size_t	i,			// Looping var
+		n,			// Current directive
+		count;			// Number of directives
   cups_dest_t	*dest;			// Current destination
-  cups_file_t	*fp;			// File pointer
-  char		line[8192],		// Line from file
+  cups_conf_t	*conf;			// lpoptions file
+  const char	*directive,		// Directive from file
+		*value;			// Value for directive
+  char		line[8192],		// Copy of value
 		*lineptr,		// Pointer into line
 		*name,			// Name of destination/option
 		*instance;		// Instance of destination
@@ -3136,27 +3504,30 @@ cups_get_dests(
   DEBUG_printf("7cups_get_dests(filename=\"%s\", match_name=\"%s\", match_inst=\"%s\", load_all=%s, user_default_set=%s, num_dests=%u, dests=%p)", filename, match_name, match_inst, load_all ? "true" : "false", user_default_set ? "true" : "false", (unsigned)num_dests, (void *)dests);
 
   // Try to open the file...
-  if ((fp = cupsFileOpen(filename, "r")) == NULL)
+  if ((conf = cupsConfOpen(filename)) == NULL)
     return (num_dests);
 
   // Read each printer; each line looks like:
   //
   //   Dest name[/instance] options
   //   Default name[/instance] options
-  linenum = 0;
-
-  while (cupsFileGetConf(fp, line, sizeof(line), &lineptr, &linenum))
+  for (n = 0, count = cupsConfGetCount(conf); n < count; n ++)
   {
     // See what type of line it is...
-    DEBUG_printf("9cups_get_dests: linenum=%d line=\"%s\" lineptr=\"%s\"", linenum, line, lineptr);
+    directive = cupsConfGetDirective(conf, n, &value, &linenum);
+
+    DEBUG_printf("9cups_get_dests: linenum=%d directive=\"%s\" value=\"%s\"", linenum, directive, value);
 
-    if ((_cups_strcasecmp(line, "dest") && _cups_strcasecmp(line, "default")) || !lineptr)
+    if ((_cups_strcasecmp(directive, "dest") && _cups_strcasecmp(directive, "default")) || !value)
     {
       DEBUG_puts("9cups_get_dests: Not a dest or default line...");
       continue;
     }
 
-    name = lineptr;
+    // Copy the value so we can separate the name, instance, and options...
+    cupsCopyString(line, value, sizeof(line));
+
+    name = lineptr = line;
 
     // Search for an instance...
     while (!isspace(*lineptr & 255) && *lineptr && *lineptr != '/')
@@ -3216,7 +3587,7 @@ cups_get_dests(
       break;
 
     // Set this as default if needed...
-    if (!user_default_set && !_cups_strcasecmp(line, "default"))
+    if (!user_default_set && !_cups_strcasecmp(directive, "default"))
     {
       DEBUG_puts("9cups_get_dests: Setting as default...");
 
@@ -3227,8 +3598,8 @@ cups_get_dests(
     }
   }
 
-  // Close the file and return...
-  cupsFileClose(fp);
+  // Release the file and return...
+  cupsConfClose(conf);
 
   return (num_dests);
 }
@@ -3339,6 +3710,51 @@ cups_name_cb(_cups_namedata_t *data,    // I - Data from cupsGetNamedDest
 }
 
 
+//
+// 'cups_put_option()' - Write an option to an lpoptions file.
+//
+
+static int				// O - Number of bytes written
+cups_put_option(FILE          *fp,	// I - File
+                cups_option_t *option)	// I - Option
+{
+  int		bytes;			// Bytes written
+  const char	*val;			// Pointer into value
+
+
+  if (!option->value[0])
+    return (fprintf(fp, " %s", option->name));
+
+  if (strchr(option->value, ' ') || strchr(option->value, '\\') || strchr(option->value, '\"') || strchr(option->value, '\''))
+  {
+    // Quote the value...
+    bytes = fprintf(fp, " %s=\"", option->name);
+
+    for (val = option->value; *val; val ++)
+    {
+      if (strchr("\"\'\\", *val))
+      {
+	putc('\\', fp);
+	bytes ++;
+      }
+
+      putc(*val, fp);
+      bytes ++;
+    }
+
+    putc('\"', fp);
+    bytes ++;
+
+    return (bytes);
+  }
+  else
+  {
+    // Store the literal value...
+    return (fprintf(fp, " %s=%s", option->name, option->value));
+  }
+}
+
+
 //
 // 'cups_queue_name()' - Create a local queue name based on the service name.
 //
@@ -70,7 +70,23 @@ cupsDirClose(cups_dir_t *dp)		// I - Directory pointer
     FindClose(dp->dir);
 
   // Free memory used...
-  free(dp);
+  _cupsMemFree(dp);
+}
+
+
+//
+// 'cupsDirGetInfo()' - Get the file information for the last directory entry.
+//
+
+const struct stat *			// O - File information or `NULL` on error
+cupsDirGetInfo(cups_dir_t *dp)		// I - Directory pointer
+{
+  // Range check input...
+  if (!dp || !dp->entry.filename[0])
+    return (NULL);
+
+  // The file information is always read with the directory entry...
+  return (&(dp->entry.fileinfo));
 }
 
 
@@ -89,7 +105,7 @@ cupsDirOpen(const char *directory)	// I - Directory name
     return (NULL);
 
   // Allocate memory for the directory structure...
-  dp = (cups_dir_t *)calloc(1, sizeof(cups_dir_t));
+  dp = (cups_dir_t *)_cupsMemCalloc(CUPS_MEMTYPE_FILE, 1, sizeof(cups_dir_t));
   if (!dp)
     return (NULL);
 
@@ -155,6 +171,18 @@ cupsDirRead(cups_dir_t *dp)		// I - Directory pointer
 }
 
 
+//
+// 'cupsDirReadName()' - Read the next directory entry without its file information.
+//
+
+cups_dentry_t *				// O - Directory entry or @code NULL@ if there are no more
+cupsDirReadName(cups_dir_t *dp)		// I - Directory pointer
+{
+  // Windows returns the file information with each entry...
+  return (cupsDirRead(dp));
+}
+
+
 //
 // 'cupsDirRewind()' - Rewind to the start of the directory.
 //
@@ -166,6 +194,8 @@ cupsDirRewind(cups_dir_t *dp)		// I - Directory pointer
   if (!dp)
     return;
 
+  dp->entry.filename[0] = '\0';
+
   // Close an open directory handle...
   if (dp->dir != INVALID_HANDLE_VALUE)
   {
@@ -194,6 +224,7 @@ struct _cups_dir_s			// Directory data structure
   char		directory[1024];	// Directory filename
   DIR		*dir;			// Directory file
   cups_dentry_t	entry;			// Directory entry
+  bool		have_info;		// Have the file information for entry?
 };
 
 
@@ -212,7 +243,45 @@ cupsDirClose(cups_dir_t *dp)		// I - Directory pointer
 
   // Close the directory and free memory...
   closedir(dp->dir);
-  free(dp);
+  _cupsMemFree(dp);
+}
+
+
+//
+// 'cupsDirGetInfo()' - Get the file information for the last directory entry.
+//
+// This function gets the file information for the last entry returned by
+// @link cupsDirReadName@, calling `stat` as needed, and stores it in the
+// `fileinfo` member of the directory entry.
+//
+
+const struct stat *			// O - File information or `NULL` on error
+cupsDirGetInfo(cups_dir_t *dp)		// I - Directory pointer
+{
+  char		filename[1024];		// Full filename
+
+
+  DEBUG_printf("2cupsDirGetInfo(dp=%p)", (void *)dp);
+
+  // Range check input...
+  if (!dp || !dp->entry.filename[0])
+    return (NULL);
+
+  // Get the file information as needed...
+  if (!dp->have_info)
+  {
+    snprintf(filename, sizeof(filename), "%s/%s", dp->directory, dp->entry.filename);
+
+    if (stat(filename, &(dp->entry.fileinfo)))
+    {
+      DEBUG_printf("3cupsDirGetInfo: stat() failed for \"%s\" - %s...", filename, strerror(errno));
+      return (NULL);
+    }
+
+    dp->have_info = true;
+  }
+
+  return (&(dp->entry.fileinfo));
 }
 
 
@@ -233,7 +302,7 @@ cupsDirOpen(const char *directory)	// I - Directory name
     return (NULL);
 
   // Allocate memory for the directory structure...
-  dp = (cups_dir_t *)calloc(1, sizeof(cups_dir_t));
+  dp = (cups_dir_t *)_cupsMemCalloc(CUPS_MEMTYPE_FILE, 1, sizeof(cups_dir_t));
   if (!dp)
     return (NULL);
 
@@ -241,7 +310,7 @@ cupsDirOpen(const char *directory)	// I - Directory name
   dp->dir = opendir(directory);
   if (!dp->dir)
   {
-    free(dp);
+    _cupsMemFree(dp);
     return (NULL);
   }
 
@@ -260,12 +329,41 @@ cupsDirOpen(const char *directory)	// I - Directory name
 cups_dentry_t *				// O - Directory entry or @code NULL@ when there are no more
 cupsDirRead(cups_dir_t *dp)		// I - Directory pointer
 {
-  struct dirent	*entry;			// Pointer to entry
-  char		filename[1024];		// Full filename
+  cups_dentry_t	*dent;			// Directory entry
 
 
   DEBUG_printf("2cupsDirRead(dp=%p)", (void *)dp);
 
+  // Read entries until we can get the file information for one...
+  while ((dent = cupsDirReadName(dp)) != NULL)
+  {
+    if (cupsDirGetInfo(dp))
+      return (dent);
+  }
+
+  return (NULL);
+}
+
+
+//
+// 'cupsDirReadName()' - Read the next directory entry without its file information.
+//
+// This function reads the next directory entry like @link cupsDirRead@ but
+// only sets the `filename` member and the file type bits (`S_IFMT`) of the
+// `fileinfo.st_mode` member, which are usually provided by the directory
+// itself.  Call @link cupsDirGetInfo@ to get the rest of the file
+// information when needed.
+//
+
+cups_dentry_t *				// O - Directory entry or @code NULL@ when there are no more
+cupsDirReadName(cups_dir_t *dp)		// I - Directory pointer
+{
+  struct dirent	*entry;			// Pointer to entry
+  mode_t	type = 0;		// File type
+
+
+  DEBUG_printf("2cupsDirReadName(dp=%p)", (void *)dp);
+
   // Range check input...
   if (!dp)
     return (NULL);
@@ -276,24 +374,55 @@ cupsDirRead(cups_dir_t *dp)		// I - Directory pointer
     // Read the next entry...
     if ((entry = readdir(dp->dir)) == NULL)
     {
-      DEBUG_puts("3cupsDirRead: readdir() returned a NULL pointer!");
+      DEBUG_puts("3cupsDirReadName: readdir() returned a NULL pointer!");
+      dp->entry.filename[0] = '\0';
       return (NULL);
     }
 
-    DEBUG_printf("4cupsDirRead: readdir() returned \"%s\"...", entry->d_name);
+    DEBUG_printf("4cupsDirReadName: readdir() returned \"%s\"...", entry->d_name);
 
     // Skip "." and ".."...
     if (!strcmp(entry->d_name, ".") || !strcmp(entry->d_name, ".."))
       continue;
 
-    // Copy the name over and get the file information...
+    // Copy the name over and get the file type, if available...
     cupsCopyString(dp->entry.filename, entry->d_name, sizeof(dp->entry.filename));
+    memset(&(dp->entry.fileinfo), 0, sizeof(dp->entry.fileinfo));
+    dp->have_info = false;
 
-    snprintf(filename, sizeof(filename), "%s/%s", dp->directory, entry->d_name);
+#ifdef DT_UNKNOWN
+    switch (entry->d_type)
+    {
+      case DT_BLK :
+          type = S_IFBLK;
+          break;
+      case DT_CHR :
+          type = S_IFCHR;
+          break;
+      case DT_DIR :
+          type = S_IFDIR;
+          break;
+      case DT_FIFO :
+          type = S_IFIFO;
+          break;
+      case DT_REG :
+          type = S_IFREG;
+          break;
+      case DT_SOCK :
+          type = S_IFSOCK;
+          break;
+      default : // Symbolic links and unknown types need stat()
+          type = 0;
+          break;
+    }
+#endif // DT_UNKNOWN
 
-    if (stat(filename, &(dp->entry.fileinfo)))
+    if (type)
+    {
+      dp->entry.fileinfo.st_mode = type;
+    }
+    else if (!cupsDirGetInfo(dp))
     {
-      DEBUG_printf("3cupsDirRead: stat() failed for \"%s\" - %s...", filename, strerror(errno));
       continue;
     }
 
@@ -318,5 +447,7 @@ cupsDirRewind(cups_dir_t *dp)		// I - Directory pointer
 
   // Rewind the directory...
   rewinddir(dp->dir);
+
+  dp->entry.filename[0] = '\0';
 }
 #endif // _WIN32
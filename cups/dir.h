@@ -38,8 +38,10 @@ typedef struct cups_dentry_s		// Directory entry type
 //
 
 extern void		cupsDirClose(cups_dir_t *dp) _CUPS_PUBLIC;
+extern const struct stat *cupsDirGetInfo(cups_dir_t *dp) _CUPS_PUBLIC;
 extern cups_dir_t	*cupsDirOpen(const char *directory) _CUPS_PUBLIC;
 extern cups_dentry_t	*cupsDirRead(cups_dir_t *dp) _CUPS_PUBLIC;
+extern cups_dentry_t	*cupsDirReadName(cups_dir_t *dp) _CUPS_PUBLIC;
 extern void		cupsDirRewind(cups_dir_t *dp) _CUPS_PUBLIC;
 
 
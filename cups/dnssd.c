@@ -39,6 +39,13 @@
 #endif // HAVE_MDNSRESPONDER
 
 
+//
+// Constants...
+//
+
+#define _CUPS_DNSSD_CACHE_TTL	120	// Lifetime of cached resolves in seconds (RFC 6762 host record TTL)
+
+
 //
 // Private structures...
 //
@@ -68,6 +75,11 @@ struct _cups_dnssd_s			// DNS-SD context
   AvahiClient		*client;	// Avahi client connection
   AvahiSimplePoll	*poll;		// Avahi poll class
   cups_thread_t		monitor;	// Monitoring thread
+  size_t		num_fds;	// Number of polled file descriptors
+  int			fds[8];		// Polled file descriptors
+  int			timeout,	// Avahi timeout in milliseconds
+			wait;		// Maximum time to wait in poll
+  struct timeval	poll_time;	// Time of last poll
   AvahiDomainBrowser	*dbrowser;	// Domain browser
   size_t		num_domains;	// Number of domains
   char			domains[32][256];// Domains
@@ -106,8 +118,12 @@ struct _cups_dnssd_query_s		// DNS-SD query request
 struct _cups_dnssd_resolve_s		// DNS-SD resolve request
 {
   cups_dnssd_t		*dnssd;		// DNS-SD context
+  uint32_t		if_index;	// Interface index for request
+  char			*fullname;	// Full service name for request
   cups_dnssd_resolve_cb_t cb;		// Resolve callback
   void			*cb_data;	// Resolve callback data
+  cups_dnssd_resolve_t	*leader;	// Resolve request being shared, if any
+  size_t		num_followers;	// Number of requests sharing this one
 
 #ifdef HAVE_MDNSRESPONDER
   DNSServiceRef		ref;		// Resolve reference
@@ -137,16 +153,45 @@ struct _cups_dnssd_service_s		// DNS-SD service registration
 #endif // HAVE_MDNSRESPONDER
 };
 
+typedef struct _cups_dnssd_cache_s	// DNS-SD resolve cache entry
+{
+  char			*fullname;	// Full service name
+  uint32_t		if_index,	// Interface index for request
+			res_index;	// Interface index for result
+  char			*host;		// Hostname
+  uint16_t		port;		// Port number
+  size_t		num_txt;	// Number of TXT key/value pairs
+  cups_option_t		*txt;		// TXT key/value pairs
+  time_t		expires;	// Expiration time
+} _cups_dnssd_cache_t;
+
+
+//
+// Local globals...
+//
+
+static cups_array_t	*dnssd_cache = NULL;
+					// Resolves shared by all contexts
+static cups_mutex_t	dnssd_cache_mutex = CUPS_MUTEX_INITIALIZER;
+					// Mutex for resolve cache
+
 
 //
 // Local functions...
 //
 
+static void		cache_add(cups_dnssd_resolve_t *resolve, uint32_t if_index, const char *fullname, const char *host, uint16_t port, size_t num_txt, cups_option_t *txt);
+static int		cache_compare(_cups_dnssd_cache_t *a, _cups_dnssd_cache_t *b, void *data);
+static _cups_dnssd_cache_t *cache_copy(uint32_t if_index, const char *name, const char *type, const char *domain);
+static void		cache_delete(_cups_dnssd_cache_t *entry);
+static void		cache_remove(const char *name, const char *type, const char *domain);
 static void		delete_browse(cups_dnssd_browse_t *browse);
 static void		delete_query(cups_dnssd_query_t *query);
 static void		delete_resolve(cups_dnssd_resolve_t *resolve);
 static void		delete_service(cups_dnssd_service_t *service);
+static cups_dnssd_t	*new_dnssd(cups_dnssd_error_cb_t error_cb, void *cb_data, bool threaded);
 static void		report_error(cups_dnssd_t *dnssd, const char *message, ...) _CUPS_FORMAT(2,3);
+static void		report_resolve(cups_dnssd_resolve_t *resolve, cups_dnssd_flags_t flags, uint32_t if_index, const char *fullname, const char *host, uint16_t port, size_t num_txt, cups_option_t *txt);
 
 #ifdef HAVE_MDNSRESPONDER
 static void		*mdns_monitor(cups_dnssd_t *dnssd);
@@ -289,7 +334,7 @@ cupsDNSSDBrowseNew(
     return (NULL);
 
   // Allocate memory for the browser...
-  if ((browse = (cups_dnssd_browse_t *)calloc(1, sizeof(cups_dnssd_browse_t))) == NULL)
+  if ((browse = (cups_dnssd_browse_t *)_cupsMemCalloc(CUPS_MEMTYPE_DNSSD, 1, sizeof(cups_dnssd_browse_t))) == NULL)
     return (NULL);
 
   browse->dnssd   = dnssd;
@@ -305,7 +350,7 @@ cupsDNSSDBrowseNew(
     if ((dnssd->browses = cupsArrayNew(NULL, NULL, NULL, 0, NULL, (cups_afree_cb_t)delete_browse)) == NULL)
     {
       // Unable to create...
-      free(browse);
+      _cupsMemFree(browse);
       browse = NULL;
       goto done;
     }
@@ -318,7 +363,7 @@ cupsDNSSDBrowseNew(
   if ((error = DNSServiceBrowse(&browse->ref, kDNSServiceFlagsShareConnection, if_index, types, domain, (DNSServiceBrowseReply)mdns_browse_cb, browse)) != kDNSServiceErr_NoError)
   {
     report_error(dnssd, "Unable to create DNS-SD browse request: %s", mdns_strerror(error));
-    free(browse);
+    _cupsMemFree(browse);
     browse = NULL;
     goto done;
   }
@@ -338,7 +383,7 @@ cupsDNSSDBrowseNew(
   if (!browse->browsers[0])
   {
     report_error(dnssd, "Unable to create DNS-SD browse request: %s", avahi_strerror(avahi_client_errno(dnssd->client)));
-    free(browse);
+    _cupsMemFree(browse);
     browse = NULL;
 
     if (!dnssd->in_callback)
@@ -559,12 +604,21 @@ cupsDNSSDDecodeTXT(
 void
 cupsDNSSDDelete(cups_dnssd_t *dnssd)	// I - DNS-SD context
 {
+  size_t	i,			// Looping var
+		count;			// Number of resolves
+
+
   if (!dnssd)
     return;
 
   DEBUG_puts("2cupsDNSSDDelete: Write locking rwlock.");
   cupsRWLockWrite(&dnssd->rwlock);
 
+  // Resolves are deleted in no particular order, so drop the links between
+  // shared requests first...
+  for (i = 0, count = cupsArrayGetCount(dnssd->resolves); i < count; i ++)
+    ((cups_dnssd_resolve_t *)cupsArrayGetElement(dnssd->resolves, i))->leader = NULL;
+
   cupsArrayDelete(dnssd->browses);
   cupsArrayDelete(dnssd->queries);
   cupsArrayDelete(dnssd->resolves);
@@ -574,23 +628,32 @@ cupsDNSSDDelete(cups_dnssd_t *dnssd)	// I - DNS-SD context
   cupsRWUnlock(&dnssd->rwlock);
 
 #ifdef HAVE_MDNSRESPONDER
-  cupsThreadCancel(dnssd->monitor);
-  cupsThreadWait(dnssd->monitor);
+  if (dnssd->monitor)
+  {
+    cupsThreadCancel(dnssd->monitor);
+    cupsThreadWait(dnssd->monitor);
+  }
+
   DNSServiceRefDeallocate(dnssd->ref);
 
 #elif _WIN32
 
 #else // HAVE_AVAHI
-  avahi_domain_browser_free(dnssd->dbrowser);
+  if (dnssd->dbrowser)
+    avahi_domain_browser_free(dnssd->dbrowser);
 
-  cupsThreadCancel(dnssd->monitor);
-  cupsThreadWait(dnssd->monitor);
+  if (dnssd->monitor)
+  {
+    cupsThreadCancel(dnssd->monitor);
+    cupsThreadWait(dnssd->monitor);
+  }
 
-  avahi_simple_poll_free(dnssd->poll);
+  if (dnssd->poll)
+    avahi_simple_poll_free(dnssd->poll);
 #endif // HAVE_MDNSRESPONDER
 
   cupsRWDestroy(&dnssd->rwlock);
-  free(dnssd);
+  _cupsMemFree(dnssd);
 }
 
 
@@ -624,6 +687,129 @@ cupsDNSSDGetConfigChanges(
 }
 
 
+//
+// 'cupsDNSSDGetFds()' - Get the file descriptors to watch for DNS-SD responses.
+//
+// This function copies up to "max_fds" file descriptors that an application
+// event loop should watch for input to the "fds" array.  When any of them is
+// readable, or after the number of milliseconds returned in the "timeout"
+// argument (`-1` for no timeout), the application calls
+// @link cupsDNSSDProcess@.  Call this function again after each call to
+// @link cupsDNSSDProcess@ since the file descriptors and timeout can change.
+//
+// Contexts created using @link cupsDNSSDNew@ process responses on their own
+// thread and have no file descriptors to watch.
+//
+
+size_t					// O - Number of file descriptors
+cupsDNSSDGetFds(cups_dnssd_t *dnssd,	// I - DNS-SD context
+                int          *fds,	// I - File descriptor array
+                size_t       max_fds,	// I - Size of file descriptor array
+                int          *timeout)	// O - Timeout in milliseconds or `-1` for none
+{
+  size_t	num_fds = 0;		// Number of file descriptors
+
+
+  if (timeout)
+    *timeout = -1;
+
+  if (!dnssd || dnssd->monitor || !fds || max_fds == 0)
+    return (0);
+
+#ifdef HAVE_MDNSRESPONDER
+  fds[0]  = (int)DNSServiceRefSockFD(dnssd->ref);
+  num_fds = 1;
+
+#elif _WIN32
+
+#else // HAVE_AVAHI
+  cupsMutexLock(&dnssd->mutex);
+
+  if ((num_fds = dnssd->num_fds) > max_fds)
+    num_fds = max_fds;
+
+  memcpy(fds, dnssd->fds, num_fds * sizeof(int));
+
+  if (timeout && dnssd->timeout >= 0)
+  {
+    // Return the time remaining until the next Avahi timeout...
+    struct timeval	curtime;	// Current time
+    long		elapsed;	// Milliseconds since last poll
+
+    gettimeofday(&curtime, NULL);
+
+    elapsed = 1000 * (curtime.tv_sec - dnssd->poll_time.tv_sec) + (curtime.tv_usec - dnssd->poll_time.tv_usec) / 1000;
+
+    *timeout = elapsed < dnssd->timeout ? dnssd->timeout - (int)elapsed : 0;
+  }
+
+  cupsMutexUnlock(&dnssd->mutex);
+#endif // HAVE_MDNSRESPONDER
+
+  return (num_fds);
+}
+
+
+//
+// 'cupsDNSSDGetTXTView()' - Find a key in a TXT record without copying.
+//
+// This function looks up the value for "key" in the DNS TXT record encoding
+// without allocating memory, which is cheaper than calling
+// @link cupsDNSSDDecodeTXT@ when only a few keys are needed.  The returned
+// pointer points into the TXT record data and is *not* nul-terminated - the
+// length of the value is returned in the "length" argument.  Keys are compared
+// case-insensitively, and a key without a value returns a zero-length value.
+//
+
+const char *				// O - Pointer to value or `NULL` if not found
+cupsDNSSDGetTXTView(
+    const unsigned char *txtrec,	// I - TXT record data
+    uint16_t            txtlen,		// I - TXT record length
+    const char          *key,		// I - Key to find
+    size_t              *length)	// O - Length of value
+{
+  size_t	keylen,			// Length of key to find
+		pairlen;		// Length of key/value pair
+  const unsigned char *txtptr,		// Pointer into TXT record data
+		*txtend;		// End of TXT record data
+
+
+  // Range check input...
+  if (length)
+    *length = 0;
+  if (!txtrec || !txtlen || !key || !length)
+    return (NULL);
+
+  // Loop through the record...
+  keylen = strlen(key);
+
+  for (txtptr = txtrec, txtend = txtrec + txtlen; txtptr < txtend; txtptr += pairlen)
+  {
+    // Format is a length byte followed by "key=value"
+    pairlen = *txtptr++;
+    if (pairlen == 0 || (txtptr + pairlen) > txtend)
+      break;				// Bogus length
+
+    if (pairlen >= keylen && !_cups_strncasecmp((const char *)txtptr, key, keylen))
+    {
+      if (pairlen == keylen)
+      {
+        // Key without a value...
+        return ((const char *)txtptr + pairlen);
+      }
+      else if (txtptr[keylen] == '=')
+      {
+        // Key with a value...
+        *length = pairlen - keylen - 1;
+        return ((const char *)txtptr + keylen + 1);
+      }
+    }
+  }
+
+  return (NULL);
+}
+
+
 //
 // 'cupsDNSSDNew()' - Create a new DNS-SD context.
 //
@@ -632,114 +818,105 @@ cupsDNSSDGetConfigChanges(
 // browses, queries, or resolves, unregister any services, and free the DNS-SD
 // context.
 //
+// Callbacks are run on a background thread that monitors the DNS-SD service.
+// Use @link cupsDNSSDNewInline@ to run the callbacks from an application's
+// own event loop instead.
+//
 
 cups_dnssd_t *				// O - DNS-SD context
 cupsDNSSDNew(
     cups_dnssd_error_cb_t error_cb,	// I - Error callback function
     void                  *cb_data)	// I - Error callback data
 {
-  cups_dnssd_t	*dnssd;			// DNS-SD context
-
-
   DEBUG_printf("cupsDNSSDNew(error_cb=%p, cb_data=%p)", (void *)error_cb, cb_data);
 
-  // Allocate memory...
-  if ((dnssd = (cups_dnssd_t *)calloc(1, sizeof(cups_dnssd_t))) == NULL)
-  {
-    DEBUG_puts("2cupsDNSSDNew: Unable to allocate memory, returning NULL.");
-    return (NULL);
-  }
-
-  // Save the error callback...
-  dnssd->cb      = error_cb;
-  dnssd->cb_data = cb_data;
+  return (new_dnssd(error_cb, cb_data, true));
+}
 
-  // Initialize the rwlock...
-  cupsRWInit(&dnssd->rwlock);
 
-  // Setup the DNS-SD connection and monitor thread...
-#ifdef HAVE_MDNSRESPONDER
-  DNSServiceErrorType error;		// Error code
+//
+// 'cupsDNSSDNewInline()' - Create a new DNS-SD context without a monitoring
+//                          thread.
+//
+// This function creates a new DNS-SD context like @link cupsDNSSDNew@, but no
+// background thread is started.  Instead, the application watches the file
+// descriptors returned by @link cupsDNSSDGetFds@ for input and calls
+// @link cupsDNSSDProcess@ to run the browse, query, resolve, and service
+// callbacks on its own thread.
+//
 
-  if ((error = DNSServiceCreateConnection(&dnssd->ref)) != kDNSServiceErr_NoError)
-  {
-    // Unable to create connection...
-    report_error(dnssd, "Unable to initialize DNS-SD: %s", mdns_strerror(error));
-    cupsDNSSDDelete(dnssd);
-    DEBUG_puts("2cupsDNSSDNew: Unable to create DNS-SD thread - returning NULL.");
-    return (NULL);
-  }
+cups_dnssd_t *				// O - DNS-SD context
+cupsDNSSDNewInline(
+    cups_dnssd_error_cb_t error_cb,	// I - Error callback function
+    void                  *cb_data)	// I - Error callback data
+{
+  DEBUG_printf("cupsDNSSDNewInline(error_cb=%p, cb_data=%p)", (void *)error_cb, cb_data);
 
-  // Monitor for hostname changes...
-  httpGetHostname(NULL, dnssd->hostname, sizeof(dnssd->hostname));
-  dnssd->hostname_ref = dnssd->ref;
-  if ((error = DNSServiceQueryRecord(&dnssd->hostname_ref, kDNSServiceFlagsShareConnection, kDNSServiceInterfaceIndexLocalOnly, "1.0.0.127.in-addr.arpa.", kDNSServiceType_PTR, kDNSServiceClass_IN, (DNSServiceQueryRecordReply)mdns_hostname_cb, dnssd)) != kDNSServiceErr_NoError)
-  {
-    report_error(dnssd, "Unable to query PTR record for local hostname: %s", mdns_strerror(error));
-    dnssd->hostname_ref = NULL;
-  }
+  return (new_dnssd(error_cb, cb_data, false));
+}
 
-  // Start the background monitoring thread...
-  if ((dnssd->monitor = cupsThreadCreate((void *(*)(void *))mdns_monitor, dnssd)) == 0)
-  {
-    report_error(dnssd, "Unable to create DNS-SD thread: %s", strerror(errno));
-    cupsDNSSDDelete(dnssd);
-    DEBUG_puts("2cupsDNSSDNew: Unable to create DNS-SD thread - returning NULL.");
-    return (NULL);
-  }
 
-  DEBUG_printf("2cupsDNSSDNew: dnssd->monitor=%p", (void *)dnssd->monitor);
+//
+// 'cupsDNSSDProcess()' - Process pending DNS-SD responses.
+//
+// This function waits up to "msec" milliseconds for responses from the DNS-SD
+// service and runs the corresponding callbacks on the calling thread.  Pass `0`
+// to process only the responses that are already available.  It can only be
+// used with contexts created using @link cupsDNSSDNewInline@.
+//
+// `false` is returned if the connection to the DNS-SD service fails.
+//
 
-#elif _WIN32
+bool					// O - `true` on success, `false` on error
+cupsDNSSDProcess(cups_dnssd_t *dnssd,	// I - DNS-SD context
+                 int          msec)	// I - Timeout in milliseconds or `-1` to wait indefinitely
+{
+  bool	ret = false;			// Return value
 
-#else // HAVE_AVAHI
-  int error;				// Error code
 
-  // Initialize the mutex used to control access to the socket
-  cupsMutexInit(&dnssd->mutex);
+  DEBUG_printf("cupsDNSSDProcess(dnssd=%p, msec=%d)", (void *)dnssd, msec);
 
-  // Create a polled interface for Avahi requests...
-  if ((dnssd->poll = avahi_simple_poll_new()) == NULL)
-  {
-    // Unable to create the background thread...
-    report_error(dnssd, "Unable to initialize DNS-SD: %s", strerror(errno));
-    cupsDNSSDDelete(dnssd);
-    DEBUG_puts("2cupsDNSSDNew: Unable to create simple poll - returning NULL.");
-    return (NULL);
-  }
+  if (!dnssd || dnssd->monitor)
+    return (false);
 
-  avahi_simple_poll_set_func(dnssd->poll, (AvahiPollFunc)avahi_poll_cb, dnssd);
+#ifdef HAVE_MDNSRESPONDER
+  DNSServiceErrorType	error;		// Current error
+  struct pollfd		polldata;	// Polling data
+  int			pstatus;	// Poll status
 
-  DEBUG_printf("2cupsDNSSDNew: dnssd->poll=%p", (void *)dnssd->poll);
+  polldata.fd     = DNSServiceRefSockFD(dnssd->ref);
+  polldata.events = POLLERR | POLLHUP | POLLIN;
 
-  if ((dnssd->client = avahi_client_new(avahi_simple_poll_get(dnssd->poll), AVAHI_CLIENT_NO_FAIL, (AvahiClientCallback)avahi_client_cb, dnssd, &error)) == NULL)
+  // Process responses until no more are available...
+  while ((pstatus = poll(&polldata, 1, msec)) > 0 && (polldata.revents & POLLIN))
   {
-    // Unable to create the client...
-    report_error(dnssd, "Unable to initialize DNS-SD: %s", avahi_strerror(error));
-    avahi_simple_poll_free(dnssd->poll);
-    cupsDNSSDDelete(dnssd);
-    DEBUG_puts("2cupsDNSSDNew: Unable to create Avahi client - returning NULL.");
-    return (NULL);
+    if ((error = DNSServiceProcessResult(dnssd->ref)) != kDNSServiceErr_NoError)
+    {
+      report_error(dnssd, "Unable to read response from DNS-SD service: %s", mdns_strerror(error));
+      return (false);
+    }
+
+    msec = 0;
   }
 
-  DEBUG_printf("2cupsDNSSDNew: dnssd->client=%p", (void *)dnssd->client);
+  ret = pstatus >= 0 && !(polldata.revents & (POLLERR | POLLHUP));
 
-  if ((dnssd->monitor = cupsThreadCreate((void *(*)(void *))avahi_monitor, dnssd)) == 0)
-  {
-    report_error(dnssd, "Unable to create DNS-SD thread: %s", strerror(errno));
-    cupsDNSSDDelete(dnssd);
-    DEBUG_puts("2cupsDNSSDNew: Unable to create DNS-SD thread - returning NULL.");
-    return (NULL);
-  }
+#elif _WIN32
 
-  DEBUG_printf("2cupsDNSSDNew: dnssd->monitor=%p", (void *)dnssd->monitor);
+#else // HAVE_AVAHI
+  DEBUG_puts("2cupsDNSSDProcess: Locking mutex.");
+  cupsMutexLock(&dnssd->mutex);
 
-  dnssd->dbrowser = avahi_domain_browser_new(dnssd->client, AVAHI_IF_UNSPEC, AVAHI_PROTO_UNSPEC, /*domain*/NULL, AVAHI_DOMAIN_BROWSER_BROWSE, /*flags*/0, (AvahiDomainBrowserCallback)avahi_domain_cb, dnssd);
+  dnssd->wait = msec;
+  ret         = avahi_simple_poll_iterate(dnssd->poll, -1) >= 0;
+
+  DEBUG_puts("2cupsDNSSDProcess: Unlocking mutex.");
+  cupsMutexUnlock(&dnssd->mutex);
 #endif // HAVE_MDNSRESPONDER
 
-  DEBUG_printf("2cupsDNSSDNew: Returning %p.", (void *)dnssd);
+  DEBUG_printf("1cupsDNSSDProcess: Returning %s.", ret ? "true" : "false");
 
-  return (dnssd);
+  return (ret);
 }
 
 
@@ -824,7 +1001,7 @@ cupsDNSSDQueryNew(
     return (NULL);
 
   // Allocate memory for the resolver...
-  if ((query = (cups_dnssd_query_t *)calloc(1, sizeof(cups_dnssd_query_t))) == NULL)
+  if ((query = (cups_dnssd_query_t *)_cupsMemCalloc(CUPS_MEMTYPE_DNSSD, 1, sizeof(cups_dnssd_query_t))) == NULL)
     return (NULL);
 
   query->dnssd   = dnssd;
@@ -841,7 +1018,7 @@ cupsDNSSDQueryNew(
     if ((dnssd->queries = cupsArrayNew(NULL, NULL, NULL, 0, NULL, (cups_afree_cb_t)delete_query)) == NULL)
     {
       // Unable to create...
-      free(query);
+      _cupsMemFree(query);
       query = NULL;
       goto done;
     }
@@ -854,7 +1031,7 @@ cupsDNSSDQueryNew(
   if ((error = DNSServiceQueryRecord(&query->ref, kDNSServiceFlagsShareConnection, if_index, fullname, rrtype, kDNSServiceClass_IN, (DNSServiceQueryRecordReply)mdns_query_cb, query)) != kDNSServiceErr_NoError)
   {
     report_error(dnssd, "Unable to create DNS-SD query request: %s", mdns_strerror(error));
-    free(query);
+    _cupsMemFree(query);
     query = NULL;
     goto done;
   }
@@ -881,7 +1058,7 @@ cupsDNSSDQueryNew(
   if (!query->browser)
   {
     report_error(dnssd, "Unable to create DNS-SD query request: %s", avahi_strerror(avahi_client_errno(dnssd->client)));
-    free(query);
+    _cupsMemFree(query);
     query = NULL;
     goto done;
   }
@@ -912,10 +1089,26 @@ cupsDNSSDResolveDelete(
   {
     cups_dnssd_t *dnssd = res->dnssd;
 
+    cups_dnssd_resolve_t *leader = res->leader;
+					// Shared resolve request, if any
+
     DEBUG_puts("2cupsDNSSDResolveDelete: Write locking rwlock.");
     cupsRWLockWrite(&dnssd->rwlock);
 
-    cupsArrayRemove(dnssd->resolves, res);
+    if (res->num_followers > 0)
+    {
+      // Other requests are sharing this one, just stop reporting to the
+      // caller...
+      res->cb = NULL;
+    }
+    else
+    {
+      cupsArrayRemove(dnssd->resolves, res);
+
+      // Remove the shared request if this was the last one using it...
+      if (leader && !leader->cb && leader->num_followers == 0)
+        cupsArrayRemove(dnssd->resolves, leader);
+    }
 
     DEBUG_puts("2cupsDNSSDResolveDelete: Unlocking rwlock.");
     cupsRWUnlock(&dnssd->rwlock);
@@ -961,6 +1154,13 @@ cupsDNSSDResolveGetContext(
 // }
 // ```
 //
+// Services that were resolved by any DNS-SD context in the current process
+// within the last two minutes are reported from a cache, in which case the
+// resolve callback is called before this function returns.  The cached
+// entry is discarded when a browse request reports that the service has
+// been removed.  Requests for a service that is already being resolved by the
+// same context share the existing mDNSResponder or Avahi request.
+//
 
 cups_dnssd_resolve_t *			// O - Resolve request or `NULL` on error
 cupsDNSSDResolveNew(
@@ -972,7 +1172,12 @@ cupsDNSSDResolveNew(
     cups_dnssd_resolve_cb_t resolve_cb,	// I - Resolve callback function
     void                    *cb_data)	// I - Resolve callback data
 {
-  cups_dnssd_resolve_t	*resolve;	// Resolve request
+  cups_dnssd_resolve_t	*resolve,	// Resolve request
+			*temp;		// Existing resolve request
+  _cups_dnssd_cache_t	*cached;	// Cached result, if any
+  size_t		i,		// Looping var
+			count;		// Number of resolve requests
+  char			fullname[1024];	// Full service name
 
 
   DEBUG_printf("cupsDNSSDResolveNew(dnssd=%p, if_index=%u, name=\"%s\", type=\"%s\", domain=\"%s\", resolve_cb=%p, cb_data=%p)", (void *)dnssd, (unsigned)if_index, name, type, domain, (void *)resolve_cb, cb_data);
@@ -985,15 +1190,50 @@ cupsDNSSDResolveNew(
   }
 
   // Allocate memory for the resolver...
-  if ((resolve = (cups_dnssd_resolve_t *)calloc(1, sizeof(cups_dnssd_resolve_t))) == NULL)
+  if ((resolve = (cups_dnssd_resolve_t *)_cupsMemCalloc(CUPS_MEMTYPE_DNSSD, 1, sizeof(cups_dnssd_resolve_t))) == NULL)
   {
     DEBUG_printf("2cupsDNSSDResolveNew: Unable to allocate memory: %s", strerror(errno));
     return (NULL);
   }
 
-  resolve->dnssd   = dnssd;
-  resolve->cb      = resolve_cb;
-  resolve->cb_data = cb_data;
+  resolve->dnssd    = dnssd;
+  resolve->if_index = if_index;
+  resolve->cb       = resolve_cb;
+  resolve->cb_data  = cb_data;
+
+  // Use a recent result from any context in this process, if available...
+  if ((cached = cache_copy(if_index, name, type, domain)) != NULL)
+  {
+    DEBUG_printf("2cupsDNSSDResolveNew: Using cached result for \"%s\".", cached->fullname);
+    goto add_resolve;
+  }
+
+  // Share an identical request that is still running in this context...
+  if (cupsDNSSDAssembleFullName(fullname, sizeof(fullname), name, type, domain ? domain : "local.") && (resolve->fullname = _cupsMemStrdup(CUPS_MEMTYPE_DNSSD, fullname)) != NULL)
+  {
+    DEBUG_puts("2cupsDNSSDResolveNew: Write locking rwlock.");
+    cupsRWLockWrite(&dnssd->rwlock);
+
+    for (i = 0, count = cupsArrayGetCount(dnssd->resolves); i < count; i ++)
+    {
+      temp = (cups_dnssd_resolve_t *)cupsArrayGetElement(dnssd->resolves, i);
+
+      if (!temp->leader && temp->fullname && temp->if_index == if_index && !_cups_strcasecmp(temp->fullname, fullname))
+      {
+        DEBUG_printf("2cupsDNSSDResolveNew: Sharing resolver %p.", (void *)temp);
+        resolve->leader = temp;
+        temp->num_followers ++;
+        cupsArrayAdd(dnssd->resolves, resolve);
+        break;
+      }
+    }
+
+    DEBUG_puts("2cupsDNSSDResolveNew: Unlocking rwlock.");
+    cupsRWUnlock(&dnssd->rwlock);
+
+    if (resolve->leader)
+      return (resolve);
+  }
 
 #ifdef HAVE_MDNSRESPONDER
   DNSServiceErrorType error;		// Error, if any
@@ -1002,7 +1242,8 @@ cupsDNSSDResolveNew(
   if ((error = DNSServiceResolve(&resolve->ref, kDNSServiceFlagsShareConnection, if_index, name, type, domain, (DNSServiceResolveReply)mdns_resolve_cb, resolve)) != kDNSServiceErr_NoError)
   {
     report_error(dnssd, "Unable to create DNS-SD query request: %s", mdns_strerror(error));
-    free(resolve);
+    _cupsMemFree(resolve->fullname);
+    _cupsMemFree(resolve);
     return (NULL);
   }
 
@@ -1028,11 +1269,14 @@ cupsDNSSDResolveNew(
   if (!resolve->resolver)
   {
     report_error(dnssd, "Unable to create DNS-SD resolve request: %s", avahi_strerror(avahi_client_errno(dnssd->client)));
-    free(resolve);
+    _cupsMemFree(resolve->fullname);
+    _cupsMemFree(resolve);
     return (NULL);
   }
 #endif // HAVE_MDNSRESPONDER
 
+  add_resolve:
+
   DEBUG_puts("2cupsDNSSDResolveNew: Write locking rwlock.");
   cupsRWLockWrite(&dnssd->rwlock);
 
@@ -1044,7 +1288,8 @@ cupsDNSSDResolveNew(
     {
       // Unable to create...
       DEBUG_printf("2cupsDNSSDResolveNew: Unable to allocate memory: %s", strerror(errno));
-      free(resolve);
+      _cupsMemFree(resolve->fullname);
+      _cupsMemFree(resolve);
       resolve = NULL;
 
       goto done;
@@ -1059,6 +1304,15 @@ cupsDNSSDResolveNew(
   DEBUG_puts("2cupsDNSSDResolveNew: Unlocking rwlock.");
   cupsRWUnlock(&dnssd->rwlock);
 
+  if (cached)
+  {
+    // Report the cached result...
+    if (resolve)
+      (resolve_cb)(resolve, cb_data, CUPS_DNSSD_FLAGS_NONE, cached->res_index, cached->fullname, cached->host, cached->port, cached->num_txt, cached->txt);
+
+    cache_delete(cached);
+  }
+
   return (resolve);
 }
 
@@ -1281,7 +1535,7 @@ cupsDNSSDServiceAdd(
     txtrec = avahi_string_list_add_printf(txtrec, "%s=%s", txt[i].name, txt[i].value);
 
   // Copy the registration type...
-  if ((regtype = strdup(types)) == NULL)
+  if ((regtype = _cupsMemStrdup(CUPS_MEMTYPE_DNSSD, types)) == NULL)
   {
     report_error(service->dnssd, "Unable to duplicate registration types: %s", strerror(errno));
     ret = false;
@@ -1322,7 +1576,7 @@ cupsDNSSDServiceAdd(
     }
   }
 
-  free(regtype);
+  _cupsMemFree(regtype);
 
   if (txtrec)
     avahi_string_list_free(txtrec);
@@ -1417,13 +1671,13 @@ cupsDNSSDServiceNew(
     return (NULL);
 
   // Allocate memory for the service...
-  if ((service = (cups_dnssd_service_t *)calloc(1, sizeof(cups_dnssd_service_t))) == NULL)
+  if ((service = (cups_dnssd_service_t *)_cupsMemCalloc(CUPS_MEMTYPE_DNSSD, 1, sizeof(cups_dnssd_service_t))) == NULL)
     return (NULL);
 
   service->dnssd    = dnssd;
   service->cb       = cb;
   service->cb_data  = cb_data;
-  service->name     = strdup(name);
+  service->name     = _cupsMemStrdup(CUPS_MEMTYPE_DNSSD, name);
   service->if_index = if_index;
 
 #ifdef HAVE_MDNSRESPONDER
@@ -1434,8 +1688,8 @@ cupsDNSSDServiceNew(
   if (!service->group)
   {
     report_error(dnssd, "Unable to create DNS-SD service registration: %s", avahi_strerror(avahi_client_errno(dnssd->client)));
-    free(service->name);
-    free(service);
+    _cupsMemFree(service->name);
+    _cupsMemFree(service);
     service = NULL;
     return (NULL);
   }
@@ -1452,8 +1706,8 @@ cupsDNSSDServiceNew(
     if ((dnssd->services = cupsArrayNew(NULL, NULL, NULL, 0, NULL, (cups_afree_cb_t)delete_service)) == NULL)
     {
       // Unable to create...
-      free(service->name);
-      free(service);
+      _cupsMemFree(service->name);
+      _cupsMemFree(service);
       service = NULL;
       goto done;
     }
@@ -1610,6 +1864,185 @@ cupsDNSSDServiceSetLocation(
 }
 
 
+//
+// 'cache_add()' - Add a resolve result to the cache.
+//
+
+static void
+cache_add(
+    cups_dnssd_resolve_t *resolve,	// I - Resolve request
+    uint32_t             if_index,	// I - Interface index for result
+    const char           *fullname,	// I - Full service name
+    const char           *host,		// I - Hostname
+    uint16_t             port,		// I - Port number
+    size_t               num_txt,	// I - Number of TXT key/value pairs
+    cups_option_t        *txt)		// I - TXT key/value pairs
+{
+  size_t		i;		// Looping var
+  _cups_dnssd_cache_t	key,		// Search key
+			*entry;		// Cache entry
+  time_t		curtime = time(NULL);
+					// Current time
+
+
+  if (!fullname || !host)
+    return;
+
+  cupsMutexLock(&dnssd_cache_mutex);
+
+  if (!dnssd_cache && (dnssd_cache = cupsArrayNew((cups_array_cb_t)cache_compare, NULL, NULL, 0, NULL, (cups_afree_cb_t)cache_delete)) == NULL)
+    goto done;
+
+  // Remove expired entries and any previous result for this request...
+  key.fullname = (char *)fullname;
+  key.if_index = resolve->if_index;
+
+  for (i = cupsArrayGetCount(dnssd_cache); i > 0; i --)
+  {
+    entry = (_cups_dnssd_cache_t *)cupsArrayGetElement(dnssd_cache, i - 1);
+
+    if (entry->expires <= curtime || !cache_compare(entry, &key, NULL))
+      cupsArrayRemove(dnssd_cache, entry);
+  }
+
+  // Add the new entry...
+  if ((entry = (_cups_dnssd_cache_t *)_cupsMemCalloc(CUPS_MEMTYPE_DNSSD, 1, sizeof(_cups_dnssd_cache_t))) == NULL)
+    goto done;
+
+  entry->fullname  = _cupsMemStrdup(CUPS_MEMTYPE_DNSSD, fullname);
+  entry->if_index  = resolve->if_index;
+  entry->res_index = if_index;
+  entry->host      = _cupsMemStrdup(CUPS_MEMTYPE_DNSSD, host);
+  entry->port      = port;
+  entry->expires   = curtime + _CUPS_DNSSD_CACHE_TTL;
+
+  for (i = 0; i < num_txt; i ++)
+    entry->num_txt = cupsAddOption(txt[i].name, txt[i].value, entry->num_txt, &entry->txt);
+
+  if (!entry->fullname || !entry->host || !cupsArrayAdd(dnssd_cache, entry))
+    cache_delete(entry);
+
+  done:
+
+  cupsMutexUnlock(&dnssd_cache_mutex);
+}
+
+
+//
+// 'cache_compare()' - Compare two resolve cache entries.
+//
+
+static int				// O - Result of comparison
+cache_compare(_cups_dnssd_cache_t *a,	// I - First entry
+              _cups_dnssd_cache_t *b,	// I - Second entry
+              void                *data)// I - Callback data (unused)
+{
+  (void)data;
+
+  if (a->if_index < b->if_index)
+    return (-1);
+  else if (a->if_index > b->if_index)
+    return (1);
+  else
+    return (_cups_strcasecmp(a->fullname, b->fullname));
+}
+
+
+//
+// 'cache_copy()' - Copy an unexpired resolve result from the cache.
+//
+
+static _cups_dnssd_cache_t *		// O - Copy of cache entry or `NULL` if none
+cache_copy(uint32_t   if_index,		// I - Interface index for request
+           const char *name,		// I - Service name
+           const char *type,		// I - Service type
+           const char *domain)		// I - Domain name or `NULL` for default
+{
+  size_t		i;		// Looping var
+  char			fullname[1024];	// Full service name
+  _cups_dnssd_cache_t	key,		// Search key
+			*entry,		// Cache entry
+			*copy = NULL;	// Copy of cache entry
+
+
+  if (!cupsDNSSDAssembleFullName(fullname, sizeof(fullname), name, type, domain ? domain : "local."))
+    return (NULL);
+
+  key.fullname = fullname;
+  key.if_index = if_index;
+
+  cupsMutexLock(&dnssd_cache_mutex);
+
+  if ((entry = (_cups_dnssd_cache_t *)cupsArrayFind(dnssd_cache, &key)) != NULL && entry->expires > time(NULL) && (copy = (_cups_dnssd_cache_t *)_cupsMemCalloc(CUPS_MEMTYPE_DNSSD, 1, sizeof(_cups_dnssd_cache_t))) != NULL)
+  {
+    copy->fullname  = _cupsMemStrdup(CUPS_MEMTYPE_DNSSD, entry->fullname);
+    copy->if_index  = entry->if_index;
+    copy->res_index = entry->res_index;
+    copy->host      = _cupsMemStrdup(CUPS_MEMTYPE_DNSSD, entry->host);
+    copy->port      = entry->port;
+    copy->expires   = entry->expires;
+
+    for (i = 0; i < entry->num_txt; i ++)
+      copy->num_txt = cupsAddOption(entry->txt[i].name, entry->txt[i].value, copy->num_txt, &copy->txt);
+
+    if (!copy->fullname || !copy->host)
+    {
+      cache_delete(copy);
+      copy = NULL;
+    }
+  }
+
+  cupsMutexUnlock(&dnssd_cache_mutex);
+
+  return (copy);
+}
+
+
+//
+// 'cache_delete()' - Free a resolve cache entry.
+//
+
+static void
+cache_delete(_cups_dnssd_cache_t *entry)// I - Cache entry
+{
+  _cupsMemFree(entry->fullname);
+  _cupsMemFree(entry->host);
+  cupsFreeOptions(entry->num_txt, entry->txt);
+  _cupsMemFree(entry);
+}
+
+
+//
+// 'cache_remove()' - Remove cached resolve results for a service.
+//
+
+static void
+cache_remove(const char *name,		// I - Service name
+             const char *type,		// I - Service type
+             const char *domain)	// I - Domain name
+{
+  size_t		i;		// Looping var
+  char			fullname[1024];	// Full service name
+  _cups_dnssd_cache_t	*entry;		// Cache entry
+
+
+  if (!name || !type || !cupsDNSSDAssembleFullName(fullname, sizeof(fullname), name, type, domain ? domain : "local."))
+    return;
+
+  cupsMutexLock(&dnssd_cache_mutex);
+
+  for (i = cupsArrayGetCount(dnssd_cache); i > 0; i --)
+  {
+    entry = (_cups_dnssd_cache_t *)cupsArrayGetElement(dnssd_cache, i - 1);
+
+    if (!_cups_strcasecmp(entry->fullname, fullname))
+      cupsArrayRemove(dnssd_cache, entry);
+  }
+
+  cupsMutexUnlock(&dnssd_cache_mutex);
+}
+
+
 //
 // 'delete_browse()' - Delete a browse request.
 //
@@ -1630,7 +2063,7 @@ delete_browse(
     avahi_service_browser_free(browse->browsers[i]);
 #endif // HAVE_MDNSRESPONDER
 
-  free(browse);
+  _cupsMemFree(browse);
 }
 
 
@@ -1661,15 +2094,24 @@ static void
 delete_resolve(
     cups_dnssd_resolve_t *resolve)	// I - Resolve request
 {
+  if (resolve->leader)
+    resolve->leader->num_followers --;
+
+  // Resolves answered from the cache or sharing another request have no
+  // reference/resolver...
 #ifdef HAVE_MDNSRESPONDER
-  DNSServiceRefDeallocate(resolve->ref);
+  if (resolve->ref)
+    DNSServiceRefDeallocate(resolve->ref);
 
 #elif _WIN32
 
 #else // HAVE_AVAHI
-  avahi_service_resolver_free(resolve->resolver);
+  if (resolve->resolver)
+    avahi_service_resolver_free(resolve->resolver);
 #endif // HAVE_MDNSRESPONDER
 
+  _cupsMemFree(resolve->fullname);
+  _cupsMemFree(resolve);
 }
 
 
@@ -1681,7 +2123,7 @@ static void
 delete_service(
     cups_dnssd_service_t *service)	// I - Service
 {
-  free(service->name);
+  _cupsMemFree(service->name);
 
 #ifdef HAVE_MDNSRESPONDER
   size_t	i;			// Looping var
@@ -1695,7 +2137,131 @@ delete_service(
   avahi_entry_group_free(service->group);
 #endif // HAVE_MDNSRESPONDER
 
-  free(service);
+  _cupsMemFree(service);
+}
+
+
+//
+// 'new_dnssd()' - Create a new DNS-SD context.
+//
+
+static cups_dnssd_t *			// O - DNS-SD context
+new_dnssd(
+    cups_dnssd_error_cb_t error_cb,	// I - Error callback function
+    void                  *cb_data,	// I - Error callback data
+    bool                  threaded)	// I - Start a monitoring thread?
+{
+  cups_dnssd_t	*dnssd;			// DNS-SD context
+
+
+  // Allocate memory...
+  if ((dnssd = (cups_dnssd_t *)_cupsMemCalloc(CUPS_MEMTYPE_DNSSD, 1, sizeof(cups_dnssd_t))) == NULL)
+  {
+    DEBUG_puts("3new_dnssd: Unable to allocate memory, returning NULL.");
+    return (NULL);
+  }
+
+  // Save the error callback...
+  dnssd->cb      = error_cb;
+  dnssd->cb_data = cb_data;
+
+  // Initialize the rwlock...
+  cupsRWInit(&dnssd->rwlock);
+
+  // Setup the DNS-SD connection and monitor thread...
+#ifdef HAVE_MDNSRESPONDER
+  DNSServiceErrorType error;		// Error code
+
+  if ((error = DNSServiceCreateConnection(&dnssd->ref)) != kDNSServiceErr_NoError)
+  {
+    // Unable to create connection...
+    report_error(dnssd, "Unable to initialize DNS-SD: %s", mdns_strerror(error));
+    cupsDNSSDDelete(dnssd);
+    DEBUG_puts("3new_dnssd: Unable to create DNS-SD thread - returning NULL.");
+    return (NULL);
+  }
+
+  // Monitor for hostname changes...
+  httpGetHostname(NULL, dnssd->hostname, sizeof(dnssd->hostname));
+  dnssd->hostname_ref = dnssd->ref;
+  if ((error = DNSServiceQueryRecord(&dnssd->hostname_ref, kDNSServiceFlagsShareConnection, kDNSServiceInterfaceIndexLocalOnly, "1.0.0.127.in-addr.arpa.", kDNSServiceType_PTR, kDNSServiceClass_IN, (DNSServiceQueryRecordReply)mdns_hostname_cb, dnssd)) != kDNSServiceErr_NoError)
+  {
+    report_error(dnssd, "Unable to query PTR record for local hostname: %s", mdns_strerror(error));
+    dnssd->hostname_ref = NULL;
+  }
+
+  // Start the background monitoring thread...
+  if (threaded && (dnssd->monitor = cupsThreadCreate((void *(*)(void *))mdns_monitor, dnssd)) == 0)
+  {
+    report_error(dnssd, "Unable to create DNS-SD thread: %s", strerror(errno));
+    cupsDNSSDDelete(dnssd);
+    DEBUG_puts("3new_dnssd: Unable to create DNS-SD thread - returning NULL.");
+    return (NULL);
+  }
+
+  DEBUG_printf("3new_dnssd: dnssd->monitor=%p", (void *)dnssd->monitor);
+
+#elif _WIN32
+
+#else // HAVE_AVAHI
+  int error;				// Error code
+
+  // Initialize the mutex used to control access to the socket
+  cupsMutexInit(&dnssd->mutex);
+
+  // Create a polled interface for Avahi requests...
+  if ((dnssd->poll = avahi_simple_poll_new()) == NULL)
+  {
+    // Unable to create the background thread...
+    report_error(dnssd, "Unable to initialize DNS-SD: %s", strerror(errno));
+    cupsDNSSDDelete(dnssd);
+    DEBUG_puts("3new_dnssd: Unable to create simple poll - returning NULL.");
+    return (NULL);
+  }
+
+  avahi_simple_poll_set_func(dnssd->poll, (AvahiPollFunc)avahi_poll_cb, dnssd);
+
+  DEBUG_printf("3new_dnssd: dnssd->poll=%p", (void *)dnssd->poll);
+
+  if ((dnssd->client = avahi_client_new(avahi_simple_poll_get(dnssd->poll), AVAHI_CLIENT_NO_FAIL, (AvahiClientCallback)avahi_client_cb, dnssd, &error)) == NULL)
+  {
+    // Unable to create the client...
+    report_error(dnssd, "Unable to initialize DNS-SD: %s", avahi_strerror(error));
+    cupsDNSSDDelete(dnssd);
+    DEBUG_puts("3new_dnssd: Unable to create Avahi client - returning NULL.");
+    return (NULL);
+  }
+
+  DEBUG_printf("3new_dnssd: dnssd->client=%p", (void *)dnssd->client);
+
+  dnssd->wait = -1;
+
+  if (threaded && (dnssd->monitor = cupsThreadCreate((void *(*)(void *))avahi_monitor, dnssd)) == 0)
+  {
+    report_error(dnssd, "Unable to create DNS-SD thread: %s", strerror(errno));
+    cupsDNSSDDelete(dnssd);
+    DEBUG_puts("3new_dnssd: Unable to create DNS-SD thread - returning NULL.");
+    return (NULL);
+  }
+
+  DEBUG_printf("3new_dnssd: dnssd->monitor=%p", (void *)dnssd->monitor);
+
+  dnssd->dbrowser = avahi_domain_browser_new(dnssd->client, AVAHI_IF_UNSPEC, AVAHI_PROTO_UNSPEC, /*domain*/NULL, AVAHI_DOMAIN_BROWSER_BROWSE, /*flags*/0, (AvahiDomainBrowserCallback)avahi_domain_cb, dnssd);
+
+  if (!threaded)
+  {
+    // Run the poll loop once to get the file descriptors and timeout for
+    // cupsDNSSDGetFds...
+    cupsMutexLock(&dnssd->mutex);
+    dnssd->wait = 0;
+    avahi_simple_poll_iterate(dnssd->poll, -1);
+    cupsMutexUnlock(&dnssd->mutex);
+  }
+#endif // HAVE_MDNSRESPONDER
+
+  DEBUG_printf("3new_dnssd: Returning %p.", (void *)dnssd);
+
+  return (dnssd);
 }
 
 
@@ -1727,6 +2293,65 @@ report_error(cups_dnssd_t *dnssd,	// I - DNS-SD context
 }
 
 
+//
+// 'report_resolve()' - Report a resolve result to a request and any requests
+//                      sharing it.
+//
+// The list of sharing requests is copied first since the callbacks may
+// delete their own requests.
+//
+
+static void
+report_resolve(
+    cups_dnssd_resolve_t *resolve,	// I - Resolve request
+    cups_dnssd_flags_t   flags,		// I - Flags
+    uint32_t             if_index,	// I - Interface index
+    const char           *fullname,	// I - Full service name
+    const char           *host,		// I - Hostname
+    uint16_t             port,		// I - Port number
+    size_t               num_txt,	// I - Number of TXT key/value pairs
+    cups_option_t        *txt)		// I - TXT key/value pairs
+{
+  cups_dnssd_t		*dnssd = resolve->dnssd;
+					// DNS-SD context
+  cups_dnssd_resolve_cb_t cb = resolve->cb;
+					// Resolve callback
+  cups_array_t		*followers = NULL;
+					// Requests sharing this one
+  cups_dnssd_resolve_t	*follower;	// Current request
+  size_t		i,		// Looping var
+			count;		// Number of requests
+
+
+  if (resolve->num_followers > 0)
+  {
+    DEBUG_puts("3report_resolve: Read locking rwlock.");
+    cupsRWLockRead(&dnssd->rwlock);
+
+    followers = cupsArrayNew(NULL, NULL, NULL, 0, NULL, NULL);
+
+    for (i = 0, count = cupsArrayGetCount(dnssd->resolves); i < count; i ++)
+    {
+      follower = (cups_dnssd_resolve_t *)cupsArrayGetElement(dnssd->resolves, i);
+
+      if (follower->leader == resolve)
+        cupsArrayAdd(followers, follower);
+    }
+
+    DEBUG_puts("3report_resolve: Unlocking rwlock.");
+    cupsRWUnlock(&dnssd->rwlock);
+  }
+
+  if (cb)
+    (cb)(resolve, resolve->cb_data, flags, if_index, fullname, host, port, num_txt, txt);
+
+  for (follower = (cups_dnssd_resolve_t *)cupsArrayGetFirst(followers); follower; follower = (cups_dnssd_resolve_t *)cupsArrayGetNext(followers))
+    (follower->cb)(follower, follower->cb_data, flags, if_index, fullname, host, port, num_txt, txt);
+
+  cupsArrayDelete(followers);
+}
+
+
 #ifdef HAVE_MDNSRESPONDER
 //
 // 'mdns_browse_cb()' - Handle DNS-SD browse callbacks from mDNSResponder.
@@ -1761,6 +2386,10 @@ mdns_browse_cb(
   if (domain && *domain == '.')
     domain ++;				// Eliminate leading period
 
+  // Forget cached resolves for removed services...
+  if (error == kDNSServiceErr_NoError && !(flags & kDNSServiceFlagsAdd))
+    cache_remove(name, temp, domain);
+
   // Call the browse callback...
   (browse->cb)(browse, browse->cb_data, mdns_to_cups(flags, error), if_index, name, temp, domain);
 }
@@ -1837,6 +2466,7 @@ mdns_hostname_cb(
     // Copy the new hostname...
     cupsCopyString(dnssd->hostname, temp, sizeof(dnssd->hostname));
     dnssd->config_changes ++;
+    _httpHostnameChanged();
 
     // Notify services of the change...
     for (service = (cups_dnssd_service_t *)cupsArrayGetFirst(dnssd->services); service; service = (cups_dnssd_service_t *)cupsArrayGetNext(dnssd->services))
@@ -1938,7 +2568,10 @@ mdns_resolve_cb(
 
   num_txt = cupsDNSSDDecodeTXT(txtrec, txtlen, &txt);
 
-  (resolve->cb)(resolve, resolve->cb_data, mdns_to_cups(flags, error), if_index, fullname, host, ntohs(port), num_txt, txt);
+  if (error == kDNSServiceErr_NoError)
+    cache_add(resolve, if_index, fullname, host, ntohs(port), num_txt, txt);
+
+  report_resolve(resolve, mdns_to_cups(flags, error), if_index, fullname, host, ntohs(port), num_txt, txt);
 
   cupsFreeOptions(num_txt, txt);
 }
@@ -2160,6 +2793,7 @@ avahi_browse_cb(
         break;
     case AVAHI_BROWSER_REMOVE :
         cups_flags = CUPS_DNSSD_FLAGS_NONE;
+        cache_remove(name, type, domain);
         break;
     case AVAHI_BROWSER_FAILURE :
         cups_flags = CUPS_DNSSD_FLAGS_ERROR;
@@ -2205,6 +2839,7 @@ avahi_client_cb(
     cupsRWLockWrite(&dnssd->rwlock);
 
     dnssd->config_changes ++;
+    _httpHostnameChanged();
 
     for (service = (cups_dnssd_service_t *)cupsArrayGetFirst(dnssd->services); service; service = (cups_dnssd_service_t *)cupsArrayGetNext(dnssd->services))
       (service->cb)(service, service->cb_data, CUPS_DNSSD_FLAGS_HOST_CHANGE);
@@ -2337,6 +2972,17 @@ avahi_poll_cb(struct pollfd *ufds,	// I - File descriptors for poll
 
   DEBUG_printf("3avahi_poll_cb(ufds=%p, nfds=%u, timeout=%d, dnssd=%p)", (void *)ufds, nfds, timeout, (void *)dnssd);
 
+  // Save the file descriptors and timeout for cupsDNSSDGetFds, and limit the
+  // time cupsDNSSDProcess waits...
+  for (dnssd->num_fds = 0; dnssd->num_fds < nfds && dnssd->num_fds < (sizeof(dnssd->fds) / sizeof(dnssd->fds[0])); dnssd->num_fds ++)
+    dnssd->fds[dnssd->num_fds] = ufds[dnssd->num_fds].fd;
+
+  dnssd->timeout = timeout;
+  gettimeofday(&dnssd->poll_time, NULL);
+
+  if (dnssd->wait >= 0 && (timeout < 0 || timeout > dnssd->wait))
+    timeout = dnssd->wait;
+
   DEBUG_puts("4avahi_poll_cb: Unlocking mutex.");
   cupsMutexUnlock(&dnssd->mutex);
 
@@ -2447,8 +3093,12 @@ avahi_resolve_cb(
   cupsDNSSDAssembleFullName(fullname, sizeof(fullname), name, type, domain);
   DEBUG_printf("4avahi_resolve_cb: fullname=\"%s\"", fullname);
 
-  // Do the resolve callback and free the TXT record stuff...
-  (resolve->cb)(resolve, resolve->cb_data, event == AVAHI_RESOLVER_FAILURE ? CUPS_DNSSD_FLAGS_ERROR : CUPS_DNSSD_FLAGS_NONE, (uint32_t)if_index, fullname, host, port, num_txt, txt);
+  // Cache successful resolves, do the resolve callback, and free the TXT
+  // record stuff...
+  if (event != AVAHI_RESOLVER_FAILURE)
+    cache_add(resolve, (uint32_t)if_index, fullname, host, port, num_txt, txt);
+
+  report_resolve(resolve, event == AVAHI_RESOLVER_FAILURE ? CUPS_DNSSD_FLAGS_ERROR : CUPS_DNSSD_FLAGS_NONE, (uint32_t)if_index, fullname, host, port, num_txt, txt);
 
   cupsFreeOptions(num_txt, txt);
 }
@@ -92,7 +92,10 @@ extern char		*cupsDNSSDCopyComputerName(cups_dnssd_t *dnssd, char *buffer, size_
 extern char		*cupsDNSSDCopyHostName(cups_dnssd_t *dnssd, char *buffer, size_t bufsize) _CUPS_PUBLIC;
 extern void		cupsDNSSDDelete(cups_dnssd_t *dnssd) _CUPS_PUBLIC;
 extern size_t		cupsDNSSDGetConfigChanges(cups_dnssd_t *dnssd) _CUPS_PUBLIC;
+extern size_t		cupsDNSSDGetFds(cups_dnssd_t *dnssd, int *fds, size_t max_fds, int *timeout) _CUPS_PUBLIC;
 extern cups_dnssd_t	*cupsDNSSDNew(cups_dnssd_error_cb_t error_cb, void *cb_data) _CUPS_PUBLIC;
+extern cups_dnssd_t	*cupsDNSSDNewInline(cups_dnssd_error_cb_t error_cb, void *cb_data) _CUPS_PUBLIC;
+extern bool		cupsDNSSDProcess(cups_dnssd_t *dnssd, int msec) _CUPS_PUBLIC;
 
 extern void		cupsDNSSDBrowseDelete(cups_dnssd_browse_t *browser) _CUPS_PUBLIC;
 extern cups_dnssd_t	*cupsDNSSDBrowseGetContext(cups_dnssd_browse_t *browser) _CUPS_PUBLIC;
@@ -116,6 +119,7 @@ extern bool		cupsDNSSDServiceSetLocation(cups_dnssd_service_t *service, const ch
 
 extern bool		cupsDNSSDAssembleFullName(char *fullname, size_t fullsize, const char *name, const char *type, const char *domain);
 extern size_t		cupsDNSSDDecodeTXT(const unsigned char *txtrec, uint16_t txtlen, cups_option_t **txt) _CUPS_PUBLIC;
+extern const char	*cupsDNSSDGetTXTView(const unsigned char *txtrec, uint16_t txtlen, const char *key, size_t *length) _CUPS_PUBLIC;
 extern bool		cupsDNSSDSeparateFullName(const char *fullname, char *name, size_t namesize, char *type, size_t typesize, char *domain, size_t domainsize);
 
 
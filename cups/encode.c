@@ -12,6 +12,15 @@
 #include "cups-private.h"
 
 
+//
+// Constants...
+//
+
+#define _IPP_OPTION_BUCKETS	128	// Number of perfect hash buckets
+#define _IPP_OPTION_SEEDS	65536	// Number of seeds to try for each bucket
+#define _IPP_OPTION_SLOTS	256	// Number of perfect hash slots
+
+
 //
 // Local list of option names, the value tags they should use, and the list of
 // supported operations...
@@ -273,11 +282,36 @@ static const _ipp_option_t ipp_options[] =
 };
 
 
+//
+// Local globals...
+//
+
+static bool		ipp_option_hashed = false;
+					// Is the perfect hash table valid?
+static uint16_t		ipp_option_seeds[_IPP_OPTION_BUCKETS];
+					// Seed for each bucket
+static uint8_t		ipp_option_slots[_IPP_OPTION_SLOTS];
+					// Option index plus 1 for each slot
+#ifdef _WIN32
+static cups_mutex_t	ipp_option_mutex = CUPS_MUTEX_INITIALIZER;
+					// Mutex for perfect hash table
+static bool		ipp_option_init = false;
+					// Perfect hash table initialized?
+#else
+static pthread_once_t	ipp_option_once = PTHREAD_ONCE_INIT;
+					// One-time initialization of perfect hash table
+#endif // _WIN32
+
+
 //
 // Local functions...
 //
 
 static int	compare_ipp_options(_ipp_option_t *a, _ipp_option_t *b);
+static uint64_t	ipp_option_hash(const char *name);
+static void	ipp_option_init_hash(void);
+static void	ipp_option_init_once(void);
+static size_t	ipp_option_slot(uint64_t hash, uint16_t seed);
 
 
 //
@@ -298,7 +332,10 @@ _cupsEncodeOption(
 			*val,		// Pointer to option value
 			*copy,		// Copy of option value
 			*sep,		// Option separator
+			*dst,		// Pointer into copy
 			quote;		// Quote character
+  const char		*src;		// Pointer into value
+  char			vbuffer[1024];	// Buffer for short multiple values
   ipp_attribute_t	*attr;		// IPP attribute
   ipp_tag_t		value_tag;	// IPP value tag
   ipp_t			*collection;	// Collection value
@@ -360,57 +397,69 @@ _cupsEncodeOption(
     return (NULL);
   }
 
+  copy = NULL;
+
   if (count > 1)
   {
-    // Make a copy of the value we can fiddle with...
-    if ((copy = strdup(value)) == NULL)
+    // Use a buffer for the separated values, which are never longer than the
+    // original value...
+    if (strlen(value) < sizeof(vbuffer))
+    {
+      dst = vbuffer;
+    }
+    else if ((dst = copy = _cupsMemAlloc(CUPS_MEMTYPE_OTHER, strlen(value) + 1)) == NULL)
     {
       // Ran out of memory!
       DEBUG_puts("1_cupsEncodeOption: Ran out of memory for value copy.");
       ippDeleteAttribute(ipp, attr);
       return (NULL);
     }
-
-    val = copy;
   }
   else
   {
     // Since we have a single value, use the value directly...
-    val  = (char *)value;
-    copy = NULL;
+    dst = NULL;
   }
 
   // Scan the value string for values...
-  for (i = 0, sep = val; i < count; val = sep, i ++)
+  for (i = 0, src = value; i < count; i ++)
   {
-    // Find the end of this value and mark it if needed...
     if (count > 1)
     {
-      for (quote = 0; *sep; sep ++)
+      // Copy this value to the buffer, removing escapes, in a single pass...
+      for (val = dst, quote = 0; *src; src ++)
       {
-	if (*sep == quote)
+	if (*src == quote)
 	{
 	  // Finish quoted value...
 	  quote = 0;
 	}
-	else if (!quote && (*sep == '\'' || *sep == '\"'))
+	else if (!quote && (*src == '\'' || *src == '\"'))
 	{
 	  // Handle quoted option value...
-	  quote = *sep;
+	  quote = *src;
 	}
-	else if (*sep == ',')
+	else if (*src == ',' && !quote)
 	{
 	  break;
 	}
-	else if (*sep == '\\' && sep[1])
+	else if (*src == '\\' && src[1])
 	{
-	  // Skip quoted character...
-	  memmove(sep, sep + 1, strlen(sep));
+	  // Copy quoted character...
+	  src ++;
 	}
+
+        *dst++ = *src;
       }
 
-      if (*sep == ',')
-	*sep++ = '\0';
+      *dst++ = '\0';
+
+      if (*src == ',')
+        src ++;
+    }
+    else
+    {
+      val = (char *)value;
     }
 
     // Copy the option value(s) over as needed by the type...
@@ -504,7 +553,7 @@ _cupsEncodeOption(
 	    cupsFreeOptions(num_cols, cols);
 
 	    if (copy)
-	      free(copy);
+	      _cupsMemFree(copy);
 
 	    ippDeleteAttribute(ipp, attr);
 	    return (NULL);
@@ -522,7 +571,7 @@ _cupsEncodeOption(
   }
 
   if (copy)
-    free(copy);
+    _cupsMemFree(copy);
 
   return (attr);
 }
@@ -702,7 +751,26 @@ _ipp_option_t *				// O - Attribute information
 _ippFindOption(const char *name)	// I - Option/attribute name
 {
   _ipp_option_t	key;			// Search key
+  uint64_t	hash;			// Hash of name
+  size_t	slot;			// Perfect hash slot
+
+
+  if (!name)
+    return (NULL);
+
+  // Use the perfect hash table as a single probe...
+  ipp_option_init_hash();
+
+  if (ipp_option_hashed)
+  {
+    hash = ipp_option_hash(name);
+    slot = ipp_option_slots[ipp_option_slot(hash, ipp_option_seeds[(hash >> 32) & (_IPP_OPTION_BUCKETS - 1)])];
 
+    if (slot && !strcmp(ipp_options[slot - 1].name, name))
+      return ((_ipp_option_t *)(ipp_options + slot - 1));
+    else
+      return (NULL);
+  }
 
   // Lookup the proper value and group tags for this option...
   key.name = name;
@@ -725,3 +793,157 @@ compare_ipp_options(_ipp_option_t *a,	// I - First option
 {
   return (strcmp(a->name, b->name));
 }
+
+
+//
+// 'ipp_option_hash()' - Compute the 64-bit FNV-1a hash of an option name.
+//
+
+static uint64_t				// O - Hash value
+ipp_option_hash(const char *name)	// I - Option name
+{
+  uint64_t	hash = 14695981039346656037ULL;
+					// Hash value
+
+
+  while (*name)
+  {
+    hash ^= (uint64_t)(*name++ & 255);
+    hash *= 1099511628211ULL;
+  }
+
+  return (hash);
+}
+
+
+//
+// 'ipp_option_init_hash()' - Initialize the perfect hash table.
+//
+
+static void
+ipp_option_init_hash(void)
+{
+#ifdef _WIN32
+  cupsMutexLock(&ipp_option_mutex);
+  if (!ipp_option_init)
+  {
+    ipp_option_init_once();
+    ipp_option_init = true;
+  }
+  cupsMutexUnlock(&ipp_option_mutex);
+
+#else
+  pthread_once(&ipp_option_once, ipp_option_init_once);
+#endif // _WIN32
+}
+
+
+//
+// 'ipp_option_init_once()' - Build the perfect hash table.
+//
+// The table uses "hash and displace": each option is assigned to a bucket from
+// its name hash and each bucket gets a seed that maps all of its options to
+// unused slots.  Buckets are placed from largest to smallest.  If no seed
+// works for a bucket, lookups fall back to a binary search.
+//
+
+static void
+ipp_option_init_once(void)
+{
+  size_t	i,			// Looping var
+		b,			// Current bucket
+		count,			// Bucket size
+		max_count = 0,		// Largest bucket size
+		num_options = sizeof(ipp_options) / sizeof(ipp_options[0]);
+					// Number of options
+  uint64_t	hashes[_IPP_OPTION_SLOTS];
+					// Option name hashes
+  uint8_t	counts[_IPP_OPTION_BUCKETS],
+					// Number of options per bucket
+		used[_IPP_OPTION_SLOTS];// Slots used by the current seed
+  uint32_t	seed;			// Current seed
+
+
+  if (num_options >= _IPP_OPTION_SLOTS)
+    return;
+
+  // Hash the option names and count the options in each bucket...
+  memset(counts, 0, sizeof(counts));
+
+  for (i = 0; i < num_options; i ++)
+  {
+    hashes[i] = ipp_option_hash(ipp_options[i].name);
+    b         = (hashes[i] >> 32) & (_IPP_OPTION_BUCKETS - 1);
+
+    if (++ counts[b] > max_count)
+      max_count = counts[b];
+  }
+
+  // Place the buckets from largest to smallest...
+  for (count = max_count; count > 0; count --)
+  {
+    for (b = 0; b < _IPP_OPTION_BUCKETS; b ++)
+    {
+      if (counts[b] != count)
+        continue;
+
+      for (seed = 0; seed < _IPP_OPTION_SEEDS; seed ++)
+      {
+        // See if this seed puts all of the options in empty slots...
+        memset(used, 0, sizeof(used));
+
+        for (i = 0; i < num_options; i ++)
+        {
+          size_t slot;			// Slot for option
+
+          if (((hashes[i] >> 32) & (_IPP_OPTION_BUCKETS - 1)) != b)
+            continue;
+
+          slot = ipp_option_slot(hashes[i], (uint16_t)seed);
+
+          if (ipp_option_slots[slot] || used[slot])
+            break;
+
+          used[slot] = (uint8_t)(i + 1);
+        }
+
+        if (i >= num_options)
+          break;
+      }
+
+      if (seed >= _IPP_OPTION_SEEDS)
+      {
+        // Unable to place this bucket, use binary search...
+        DEBUG_printf("ipp_option_init_once: Unable to place bucket %u.", (unsigned)b);
+        return;
+      }
+
+      ipp_option_seeds[b] = (uint16_t)seed;
+
+      for (i = 0; i < _IPP_OPTION_SLOTS; i ++)
+      {
+        if (used[i])
+          ipp_option_slots[i] = used[i];
+      }
+    }
+  }
+
+  ipp_option_hashed = true;
+}
+
+
+//
+// 'ipp_option_slot()' - Compute the perfect hash slot for a hash and seed.
+//
+
+static size_t				// O - Slot number
+ipp_option_slot(uint64_t hash,		// I - Option name hash
+                uint16_t seed)		// I - Bucket seed
+{
+  hash ^= (seed + 1) * 0x9e3779b97f4a7c15ULL;
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdULL;
+  hash ^= hash >> 33;
+
+  return ((size_t)hash & (_IPP_OPTION_SLOTS - 1));
+}
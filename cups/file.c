@@ -18,44 +18,405 @@
 #include "debug-internal.h"
 #include <sys/stat.h>
 #include <sys/types.h>
+#ifndef _WIN32
+#  include <sys/mman.h>
+#endif // !_WIN32
 #include <zlib.h>
+#ifdef HAVE_ZSTD
+#  include <zstd.h>
+#endif // HAVE_ZSTD
+
+
+//
+// Local constants...
+//
+
+#define _CUPS_FILE_BUFSIZE	4096	// Default buffer size
+#define _CUPS_FILE_MAX_BUFSIZE	67108864
+					// Maximum buffer size
+#define _CUPS_FILE_MAX_THREADS	64	// Maximum compression threads
+#define _CUPS_FILE_PZ_BLOCK	131072	// Parallel compression block size
+#define _CUPS_FILE_PZ_DICT	32768	// Parallel compression dictionary size
+#define _CUPS_FILE_MAX_QDEPTH	256	// Maximum read-ahead/write-behind depth
+#define _CUPS_FILE_MIN_INDEX	65536	// Minimum seek index interval
+#define _CUPS_CONF_HASH		64	// Size of configuration directive hash table
+#ifdef __APPLE__
+#  define _CUPS_CONF_NSEC(st)	(st).st_mtimespec.tv_nsec
+#elif defined(_WIN32)
+#  define _CUPS_CONF_NSEC(st)	0
+#else
+#  define _CUPS_CONF_NSEC(st)	(st).st_mtim.tv_nsec
+#endif // __APPLE__
 
 
 //
 // Internal structures...
 //
 
+typedef struct _cups_pzjob_s		// Parallel compression job
+{
+  cups_thread_t	thread;			// Compression thread
+  int		level;			// Compression level
+  Bytef		*in;			// Input block
+  size_t	inlen;			// Length of input block
+  Bytef		*dict;			// Dictionary from previous block
+  size_t	dictlen;		// Length of dictionary
+  Bytef		*out;			// Compressed output
+  size_t	outsize,		// Size of output buffer
+		outlen;			// Length of compressed output
+  uLong		crc;			// CRC-32 of input block
+  bool		ok;			// Compressed successfully?
+} _cups_pzjob_t;
+
+typedef struct _cups_zpoint_s		// gzip seek index point
+{
+  off_t		out,			// Uncompressed offset
+		in;			// Compressed offset of next byte
+  int		bits,			// Unused bits in previous byte
+		bitbyte;		// Previous byte, if bits > 0
+  uInt		winlen;			// Length of window
+  Bytef		window[32768];		// Decompression window
+} _cups_zpoint_t;
+
+typedef struct _cups_conf_line_s	// Configuration file line
+{
+  char		*directive,		// Directive name
+		*value;			// Value or `NULL`
+  int		linenum;		// Line number
+  size_t	prev;			// Previous line with the same hash plus 1
+} _cups_conf_line_t;
+
+struct _cups_conf_s			// Parsed configuration file
+{
+  cups_conf_t	*next;			// Next cached file
+  char		*filename;		// Filename
+  size_t	refcount;		// Number of references
+  off_t		size;			// Size of file
+  time_t	mtime;			// Modification time of file
+  long		mtime_nsec;		// Nanoseconds of modification time
+  size_t	num_lines,		// Number of lines
+		alloc_lines;		// Allocated lines
+  _cups_conf_line_t *lines;		// Lines
+  size_t	hash[_CUPS_CONF_HASH];	// Last line for each hash value plus 1
+};
+
 struct _cups_file_s			// CUPS file structure...
 {
   int		fd;			// File descriptor
   bool		compressed;		// Compression used?
   char		mode,			// Mode ('r' or 'w')
-		buf[4096],		// Buffer
+		*buf,			// Buffer
 		*ptr,			// Pointer into buffer
 		*end;			// End of buffer data
+  size_t	bufsize;		// Size of buffer and compression buffer
   bool		is_stdio,		// stdin/out/err?
 		eof;			// End of file?
   off_t		pos,			// Position in file
 		bufpos;			// File position for start of buffer
+  char		*map;			// Memory-mapped file data, if any
+  size_t	mapsize;		// Size of memory-mapped file data
+  size_t	qdepth;			// Read-ahead/write-behind depth in buffers
+  off_t		qpos,			// File descriptor position or -1 if unknown
+		qlimit;			// End of read-ahead or start of write-behind
 
   z_stream	stream;			// (De)compression stream
-  Bytef		cbuf[4096];		// (De)compression buffer
+  Bytef		*cbuf;			// (De)compression buffer
   uLong		crc;			// (De)compression CRC
+  int		level;			// Compression level
+  _cups_zpoint_t *seekidx;		// gzip seek index points
+  size_t	num_seekidx,		// Number of seek index points
+		alloc_seekidx,		// Allocated seek index points
+		seekinterval;		// Seek index interval or 0 for none
+  bool		nocrc;			// Skip CRC check after using seek index?
+  _cups_pzjob_t	*pzjobs;		// Parallel compression jobs
+  size_t	pznum,			// Number of parallel compression jobs
+		pzfirst,		// Oldest pending job
+		pzcount,		// Number of pending jobs
+		pzcur;			// Job being filled
+#ifdef HAVE_ZSTD
+  ZSTD_CCtx	*zcctx;			// Zstandard compression context
+  ZSTD_DCtx	*zdctx;			// Zstandard decompression context
+  ZSTD_inBuffer	zin;			// Zstandard decompression input
+  size_t	zremaining;		// Zstandard bytes remaining in frame
+#endif // HAVE_ZSTD
 
   char		*printf_buffer;		// cupsFilePrintf buffer
   size_t	printf_size;		// Size of cupsFilePrintf buffer
+  cups_hash_t	*hash;			// Hash of uncompressed data written, if any
+
+  char		defbuf[_CUPS_FILE_BUFSIZE];
+					// Default buffer
+  Bytef		defcbuf[_CUPS_FILE_BUFSIZE];
+					// Default (de)compression buffer
 };
 
 
+//
+// Local globals...
+//
+
+static cups_mutex_t	cups_conf_mutex = CUPS_MUTEX_INITIALIZER;
+					// Mutex for cached configuration files
+static cups_conf_t	*cups_conf_cache = NULL;
+					// Cached configuration files
+
+
 //
 // Local functions...
 //
 
 static bool	cups_compress(cups_file_t *fp, const char *buf, size_t bytes);
+static void	cups_conf_free(cups_conf_t *conf);
+static size_t	cups_conf_hash(const char *directive);
+static cups_conf_t *cups_conf_read(const char *filename);
+static void	cups_conf_release(cups_conf_t *conf);
+static void	cups_decompress_end(cups_file_t *fp);
 static ssize_t	cups_fill(cups_file_t *fp);
+static bool	cups_pz_compress(cups_file_t *fp, const char *buf, size_t bytes);
+static void	cups_pz_free(cups_file_t *fp);
+static bool	cups_pz_submit(cups_file_t *fp);
+static void	*cups_pz_thread(_cups_pzjob_t *job);
+static bool	cups_pz_write(cups_file_t *fp);
+#ifndef _WIN32
+static void	cups_map(cups_file_t *fp);
+#endif // !_WIN32
+static void	cups_index_add(cups_file_t *fp, off_t out);
+static int	cups_index_inflate(cups_file_t *fp);
+static bool	cups_index_seek(cups_file_t *fp, off_t pos);
 static int	cups_open(const char *filename, int mode);
+static void	cups_queue(cups_file_t *fp, size_t bytes);
 static ssize_t	cups_read(cups_file_t *fp, char *buf, size_t bytes);
 static bool	cups_write(cups_file_t *fp, const char *buf, size_t bytes);
+#ifdef HAVE_ZSTD
+static bool	cups_zstd_compress(cups_file_t *fp, const char *buf, size_t bytes, bool finish);
+#endif // HAVE_ZSTD
+
+
+//
+// '_cupsConfFlush()' - Remove a file from the configuration file cache.
+//
+// Pass `NULL` to remove all files from the cache.
+//
+
+void
+_cupsConfFlush(const char *filename)	// I - Filename or `NULL` for all files
+{
+  cups_conf_t	*conf,			// Current file
+		*prev,			// Previous file
+		*next;			// Next file
+
+
+  cupsMutexLock(&cups_conf_mutex);
+
+  for (conf = cups_conf_cache, prev = NULL; conf; conf = next)
+  {
+    next = conf->next;
+
+    if (!filename || !strcmp(conf->filename, filename))
+    {
+      if (prev)
+        prev->next = next;
+      else
+        cups_conf_cache = next;
+
+      cups_conf_release(conf);
+    }
+    else
+    {
+      prev = conf;
+    }
+  }
+
+  cupsMutexUnlock(&cups_conf_mutex);
+}
+
+
+//
+// 'cupsConfClose()' - Release a parsed configuration file.
+//
+
+void
+cupsConfClose(cups_conf_t *conf)	// I - Configuration file
+{
+  if (!conf)
+    return;
+
+  cupsMutexLock(&cups_conf_mutex);
+  cups_conf_release(conf);
+  cupsMutexUnlock(&cups_conf_mutex);
+}
+
+
+//
+// 'cupsConfGetCount()' - Get the number of directives in a configuration file.
+//
+
+size_t					// O - Number of directives
+cupsConfGetCount(cups_conf_t *conf)	// I - Configuration file
+{
+  return (conf ? conf->num_lines : 0);
+}
+
+
+//
+// 'cupsConfGetDirective()' - Get a directive from a configuration file.
+//
+// This function gets the directives in a configuration file in the order they
+// appear in the file, as returned by @link cupsFileGetConf@.  The "n" argument
+// specifies the directive number from `0` to `cupsConfGetCount(conf) - 1`.
+//
+
+const char *				// O - Directive name or `NULL` if none
+cupsConfGetDirective(
+    cups_conf_t *conf,			// I - Configuration file
+    size_t      n,			// I - Directive number (starting at `0`)
+    const char  **value,		// O - Value or `NULL` if none
+    int         *linenum)		// O - Line number or `NULL`
+{
+  _cups_conf_line_t	*line;		// Line
+
+
+  if (!conf || n >= conf->num_lines)
+  {
+    if (value)
+      *value = NULL;
+    if (linenum)
+      *linenum = 0;
+
+    return (NULL);
+  }
+
+  line = conf->lines + n;
+
+  if (value)
+    *value = line->value;
+  if (linenum)
+    *linenum = line->linenum;
+
+  return (line->directive);
+}
+
+
+//
+// 'cupsConfGetValue()' - Get the value of a directive in a configuration file.
+//
+// This function returns the value of the last directive with the given name
+// and a value, so that later directives override earlier ones.  Directive
+// names are not case sensitive.
+//
+
+const char *				// O - Value or `NULL` if not found
+cupsConfGetValue(cups_conf_t *conf,	// I - Configuration file
+                 const char  *directive)// I - Directive name
+{
+  size_t		i;		// Line number plus 1
+  _cups_conf_line_t	*line;		// Current line
+
+
+  if (!conf || !directive)
+    return (NULL);
+
+  for (i = conf->hash[cups_conf_hash(directive)]; i > 0; i = line->prev)
+  {
+    line = conf->lines + i - 1;
+
+    if (line->value && !_cups_strcasecmp(line->directive, directive))
+      return (line->value);
+  }
+
+  return (NULL);
+}
+
+
+//
+// 'cupsConfOpen()' - Open a parsed configuration file.
+//
+// This function reads a configuration file using @link cupsFileGetConf@ and
+// returns the parsed directives.  Parsed files are cached by filename and
+// shared by all threads, so opening the same file again only checks the
+// modification time and size of the file, re-reading it when they change.
+//
+// Call @link cupsConfClose@ to release the returned object when done.
+//
+
+cups_conf_t *				// O - Configuration file or `NULL` on error
+cupsConfOpen(const char *filename)	// I - Filename
+{
+  cups_conf_t	*conf,			// Configuration file
+		*prev,			// Previous file
+		*next;			// Next file
+  struct stat	fileinfo;		// File information
+
+
+  // Range check input...
+  if (!filename)
+  {
+    errno = EINVAL;
+    return (NULL);
+  }
+
+  if (stat(filename, &fileinfo))
+    return (NULL);
+
+  // See if we have an up-to-date copy in the cache...
+  cupsMutexLock(&cups_conf_mutex);
+
+  for (conf = cups_conf_cache, prev = NULL; conf; prev = conf, conf = conf->next)
+  {
+    if (!strcmp(conf->filename, filename))
+      break;
+  }
+
+  if (conf)
+  {
+    if (conf->size == fileinfo.st_size && conf->mtime == fileinfo.st_mtime && conf->mtime_nsec == (long)_CUPS_CONF_NSEC(fileinfo))
+    {
+      conf->refcount ++;
+      cupsMutexUnlock(&cups_conf_mutex);
+
+      return (conf);
+    }
+
+    // The file has changed, remove the old copy from the cache...
+    if (prev)
+      prev->next = conf->next;
+    else
+      cups_conf_cache = conf->next;
+
+    cups_conf_release(conf);
+  }
+
+  cupsMutexUnlock(&cups_conf_mutex);
+
+  // Read the file outside the lock...
+  if ((conf = cups_conf_read(filename)) == NULL)
+    return (NULL);
+
+  // Add it to the cache, replacing any copy added by another thread...
+  cupsMutexLock(&cups_conf_mutex);
+
+  for (prev = NULL, next = cups_conf_cache; next; prev = next, next = next->next)
+  {
+    if (!strcmp(next->filename, filename))
+    {
+      if (prev)
+        prev->next = next->next;
+      else
+        cups_conf_cache = next->next;
+
+      cups_conf_release(next);
+      break;
+    }
+  }
+
+  conf->next      = cups_conf_cache;
+  conf->refcount  = 2;
+  cups_conf_cache = conf;
+
+  cupsMutexUnlock(&cups_conf_mutex);
+
+  return (conf);
+}
 
 
 //
@@ -85,8 +446,49 @@ cupsFileClose(cups_file_t *fp)		// I - CUPS file
     if (fp->mode == 'r')
     {
       // Free decompression data...
-      inflateEnd(&fp->stream);
+      cups_decompress_end(fp);
+    }
+    else if (fp->pzjobs)
+    {
+      // Compress the last block and write all pending blocks...
+      unsigned char	trailer[10];	// Final block, CRC, and length
+
+      if (fp->pzjobs[fp->pzcur].inlen > 0)
+        status = cups_pz_submit(fp);
+
+      while (fp->pzcount > 0)
+      {
+        if (!cups_pz_write(fp))
+          status = false;
+      }
+
+      cups_pz_free(fp);
+
+      // Write an empty final block followed by the CRC and length...
+      trailer[0] = 0x03;
+      trailer[1] = 0x00;
+      trailer[2] = (unsigned char)fp->crc;
+      trailer[3] = (unsigned char)(fp->crc >> 8);
+      trailer[4] = (unsigned char)(fp->crc >> 16);
+      trailer[5] = (unsigned char)(fp->crc >> 24);
+      trailer[6] = (unsigned char)fp->pos;
+      trailer[7] = (unsigned char)(fp->pos >> 8);
+      trailer[8] = (unsigned char)(fp->pos >> 16);
+      trailer[9] = (unsigned char)(fp->pos >> 24);
+
+      if (status)
+        status = cups_write(fp, (char *)trailer, sizeof(trailer));
+    }
+#ifdef HAVE_ZSTD
+    else if (fp->zcctx)
+    {
+      // Flush any remaining compressed data and free the compressor...
+      status = cups_zstd_compress(fp, NULL, 0, true);
+
+      ZSTD_freeCCtx(fp->zcctx);
+      fp->zcctx = NULL;
     }
+#endif // HAVE_ZSTD
     else
     {
       // Flush any remaining compressed data...
@@ -103,7 +505,7 @@ cupsFileClose(cups_file_t *fp)		// I - CUPS file
 	  status = cups_write(fp, (char *)fp->cbuf, (size_t)(fp->stream.next_out - fp->cbuf));
 
 	  fp->stream.next_out  = fp->cbuf;
-	  fp->stream.avail_out = sizeof(fp->cbuf);
+	  fp->stream.avail_out = (uInt)fp->bufsize;
 	}
 
         if (done || !status)
@@ -139,9 +541,21 @@ cupsFileClose(cups_file_t *fp)		// I - CUPS file
   mode = fp->mode;
 
   if (fp->printf_buffer)
-    free(fp->printf_buffer);
+    _cupsMemFree(fp->printf_buffer);
+
+  _cupsMemFree(fp->seekidx);
+
+  cups_pz_free(fp);
+
+  if (fp->buf != fp->defbuf)
+    _cupsMemFree(fp->buf);
 
-  free(fp);
+#ifndef _WIN32
+  if (fp->map)
+    munmap(fp->map, fp->mapsize);
+#endif // !_WIN32
+
+  _cupsMemFree(fp);
 
   // Close the file, returning the close status...
   if (mode == 's')
@@ -288,6 +702,14 @@ cupsFileFlush(cups_file_t *fp)		// I - CUPS file
 int					// O - Character or `-1` on end of file
 cupsFileGetChar(cups_file_t *fp)	// I - CUPS file
 {
+  // Return buffered characters right away...
+  if (fp && fp->mode == 'r' && fp->ptr < fp->end && !fp->eof)
+  {
+    fp->pos ++;
+
+    return (*(fp->ptr)++ & 255);
+  }
+
   // Range check input...
   if (!fp || (fp->mode != 'r' && fp->mode != 's'))
     return (-1);
@@ -432,7 +854,9 @@ cupsFileGetLine(cups_file_t *fp,	// I - File to read from
 {
   int		ch;			// Character from file
   char		*ptr,			// Current position in line buffer
-		*end;			// End of line buffer
+		*end,			// End of line buffer
+		*eol;			// End of line in file buffer
+  size_t	count;			// Number of bytes to copy
 
 
   // Range check input...
@@ -448,8 +872,21 @@ cupsFileGetLine(cups_file_t *fp,	// I - File to read from
         break;
     }
 
-    *ptr++ = ch = *(fp->ptr)++;
-    fp->pos ++;
+    // Copy everything up to and including the next CR or LF...
+    if ((count = (size_t)(fp->end - fp->ptr)) > (size_t)(end - ptr))
+      count = (size_t)(end - ptr);
+
+    if ((eol = memchr(fp->ptr, '\n', count)) != NULL)
+      count = (size_t)(eol - fp->ptr) + 1;
+    if ((eol = memchr(fp->ptr, '\r', count)) != NULL)
+      count = (size_t)(eol - fp->ptr) + 1;
+
+    memcpy(ptr, fp->ptr, count);
+    ptr     += count;
+    fp->ptr += count;
+    fp->pos += (off_t)count;
+
+    ch = ptr[-1];
 
     if (ch == '\r')
     {
@@ -492,7 +929,9 @@ cupsFileGets(cups_file_t *fp,		// I - CUPS file
 {
   int		ch;			// Character from file
   char		*ptr,			// Current position in line buffer
-		*end;			// End of line buffer
+		*end,			// End of line buffer
+		*eol;			// End of line in file buffer
+  size_t	count;			// Number of bytes to copy
 
 
   // Range check input...
@@ -513,6 +952,24 @@ cupsFileGets(cups_file_t *fp,		// I - CUPS file
       }
     }
 
+    // Copy everything up to the next CR or LF...
+    if ((count = (size_t)(fp->end - fp->ptr)) > (size_t)(end - ptr))
+      count = (size_t)(end - ptr);
+
+    if ((eol = memchr(fp->ptr, '\n', count)) != NULL)
+      count = (size_t)(eol - fp->ptr);
+    if ((eol = memchr(fp->ptr, '\r', count)) != NULL)
+      count = (size_t)(eol - fp->ptr);
+
+    memcpy(ptr, fp->ptr, count);
+    ptr     += count;
+    fp->ptr += count;
+    fp->pos += (off_t)count;
+
+    if (ptr >= end || fp->ptr >= fp->end)
+      continue;
+
+    // Skip the CR or LF that ends the line...
     ch = *(fp->ptr)++;
     fp->pos ++;
 
@@ -530,18 +987,9 @@ cupsFileGets(cups_file_t *fp,		// I - CUPS file
         fp->ptr ++;
 	fp->pos ++;
       }
-
-      break;
-    }
-    else if (ch == '\n')
-    {
-      // Line feed ends a line...
-      break;
-    }
-    else
-    {
-      *ptr++ = (char)ch;
     }
+
+    break;
   }
 
   *ptr = '\0';
@@ -550,9 +998,77 @@ cupsFileGets(cups_file_t *fp,		// I - CUPS file
 }
 
 
+//
+// 'cupsFileGetView()' - Get a pointer to the next bytes in a file.
+//
+// This function returns a pointer to up to "bytes" bytes (`0` for all bytes
+// that are available) from the file without copying, and advances the file
+// position by the number of bytes returned in "length".  Fewer bytes than
+// requested can be returned, and the pointer is only valid until the next
+// call using the file.  For files that are opened in memory-mapped mode
+// ("rm"), the returned data remains valid until the file is closed.
+//
+
+const char *				// O - Pointer to bytes or `NULL` on end of file or error
+cupsFileGetView(cups_file_t *fp,	// I - CUPS file
+                size_t      bytes,	// I - Maximum number of bytes or `0` for all available
+                size_t      *length)	// O - Number of bytes
+{
+  const char	*data;			// Pointer to data
+  size_t	count;			// Number of bytes
+
+
+  // Range check input...
+  if (length)
+    *length = 0;
+
+  if (!fp || !length || (fp->mode != 'r' && fp->mode != 's') || fp->eof)
+    return (NULL);
+
+  // If the input buffer is empty, try to read more data...
+  if (fp->ptr >= fp->end)
+  {
+    if (cups_fill(fp) <= 0)
+      return (NULL);
+  }
+
+  // Return the buffered data...
+  if ((count = (size_t)(fp->end - fp->ptr)) > bytes && bytes > 0)
+    count = bytes;
+
+  data     = fp->ptr;
+  fp->ptr += count;
+  fp->pos += (off_t)count;
+  *length  = count;
+
+  return (data);
+}
+
+
+//
+// 'cupsFileGetCompression()' - Return the compression used for a file.
+//
+
+cups_file_compression_t			// O - Compression
+cupsFileGetCompression(cups_file_t *fp)	// I - CUPS file
+{
+  if (!fp || !fp->compressed)
+    return (CUPS_FILE_COMPRESSION_NONE);
+
+#ifdef HAVE_ZSTD
+  if (fp->zcctx || fp->zdctx)
+    return (CUPS_FILE_COMPRESSION_ZSTD);
+#endif // HAVE_ZSTD
+
+  return (CUPS_FILE_COMPRESSION_GZIP);
+}
+
+
 //
 // 'cupsFileIsCompressed()' - Return whether a file is compressed.
 //
+// Use @link cupsFileGetCompression@ to determine which compression is used.
+//
 
 bool					// O - `true` if compressed, `false` if not
 cupsFileIsCompressed(cups_file_t *fp)	// I - CUPS file
@@ -607,9 +1123,16 @@ cupsFileNumber(cups_file_t *fp)		// I - CUPS file
 // existing file, "a" to append to an existing file or create a new file,
 // or "s" to open a socket connection.
 //
+// When opening for reading ("r"), an optional "m" ("rm") maps uncompressed
+// regular files into memory so that reads, seeks, and @link cupsFileGetView@
+// use the file data directly.  The mapping reflects the size of the file when
+// it was opened, so data appended later is not seen.
+//
 // When opening for writing ("w"), an optional number from `1` to `9` can be
-// supplied which enables Flate compression of the file.  Compression is
-// not supported for the "a" (append) mode.
+// supplied which enables Flate compression of the file.  Alternately, "z"
+// ("wz") enables Zstandard compression, optionally followed by a compression
+// level from `1` to `9` ("wz9").  Compression is not supported for the "a"
+// (append) mode.  Files are decompressed automatically when reading.
 //
 // When opening a socket connection, the filename is a string of the form
 // "address:port" or "hostname:port". The socket will make an IPv4 or IPv6
@@ -629,7 +1152,7 @@ cupsFileOpen(const char *filename,	// I - Name of file
 
 
   // Range check input...
-  if (!filename || !mode || (*mode != 'r' && *mode != 'w' && *mode != 'a' && *mode != 's') || (*mode == 'a' && isdigit(mode[1] & 255)))
+  if (!filename || !mode || (*mode != 'r' && *mode != 'w' && *mode != 'a' && *mode != 's') || (*mode == 'a' && (isdigit(mode[1] & 255) || mode[1] == 'z')))
     return (NULL);
 
   // Open the file...
@@ -712,9 +1235,15 @@ cupsFileOpen(const char *filename,	// I - Name of file
 // The "mode" argument can be "r" to read, "w" to write, "a" to append,
 // or "s" to treat the file descriptor as a bidirectional socket connection.
 //
+// When opening for reading ("r"), an optional "m" ("rm") maps uncompressed
+// regular files into memory.  The file descriptor must be positioned at the
+// beginning of the file for the mapping to be used.
+//
 // When opening for writing ("w"), an optional number from `1` to `9` can be
-// supplied which enables Flate compression of the file.  Compression is
-// not supported for the "a" (append) mode.
+// supplied which enables Flate compression of the file.  Alternately, "z"
+// ("wz") enables Zstandard compression, optionally followed by a compression
+// level from `1` to `9` ("wz9").  Compression is not supported for the "a"
+// (append) mode.
 //
 
 cups_file_t *				// O - CUPS file or `NULL` if the file could not be opened
@@ -725,15 +1254,18 @@ cupsFileOpenFd(int        fd,		// I - File descriptor
 
 
   // Range check input...
-  if (fd < 0 || !mode || (*mode != 'r' && *mode != 'w' && *mode != 'a' && *mode != 's') || (*mode == 'a' && isdigit(mode[1] & 255)))
+  if (fd < 0 || !mode || (*mode != 'r' && *mode != 'w' && *mode != 'a' && *mode != 's') || (*mode == 'a' && (isdigit(mode[1] & 255) || mode[1] == 'z')))
     return (NULL);
 
   // Allocate memory...
-  if ((fp = calloc(1, sizeof(cups_file_t))) == NULL)
+  if ((fp = _cupsMemCalloc(CUPS_MEMTYPE_FILE, 1, sizeof(cups_file_t))) == NULL)
     return (NULL);
 
   // Open the file...
-  fp->fd = fd;
+  fp->fd      = fd;
+  fp->buf     = fp->defbuf;
+  fp->cbuf    = fp->defcbuf;
+  fp->bufsize = sizeof(fp->defbuf);
 
   switch (*mode)
   {
@@ -744,7 +1276,7 @@ cupsFileOpenFd(int        fd,		// I - File descriptor
 
 	fp->mode = 'w';
 	fp->ptr  = fp->buf;
-	fp->end  = fp->buf + sizeof(fp->buf);
+	fp->end  = fp->buf + fp->bufsize;
 
 	if (mode[1] >= '1' && mode[1] <= '9')
 	{
@@ -768,21 +1300,50 @@ cupsFileOpenFd(int        fd,		// I - File descriptor
 	  cups_write(fp, (char *)header, 10);
 
           // Initialize the compressor...
-          if (deflateInit2(&(fp->stream), mode[1] - '0', Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) < Z_OK)
+          fp->level = mode[1] - '0';
+
+          if (deflateInit2(&(fp->stream), fp->level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) < Z_OK)
           {
-            free(fp);
+            _cupsMemFree(fp);
 	    return (NULL);
           }
 
 	  fp->stream.next_out  = fp->cbuf;
-	  fp->stream.avail_out = sizeof(fp->cbuf);
+	  fp->stream.avail_out = (uInt)fp->bufsize;
 	  fp->compressed       = true;
 	  fp->crc              = crc32(0L, Z_NULL, 0);
 	}
+	else if (mode[1] == 'z')
+	{
+#ifdef HAVE_ZSTD
+	  // Open a Zstandard compressed stream...
+	  if ((fp->zcctx = ZSTD_createCCtx()) == NULL)
+	  {
+	    _cupsMemFree(fp);
+	    return (NULL);
+	  }
+
+	  if (mode[2] >= '1' && mode[2] <= '9')
+	    ZSTD_CCtx_setParameter(fp->zcctx, ZSTD_c_compressionLevel, mode[2] - '0');
+
+	  fp->compressed = true;
+
+#else
+	  // Zstandard not supported...
+	  _cupsMemFree(fp);
+	  errno = EINVAL;
+	  return (NULL);
+#endif // HAVE_ZSTD
+	}
         break;
 
     case 'r' :
 	fp->mode = 'r';
+
+#ifndef _WIN32
+        if (mode[1] == 'm')
+          cups_map(fp);
+#endif // !_WIN32
 	break;
 
     case 's' :
@@ -854,10 +1415,44 @@ cupsFilePrintf(cups_file_t *fp,		// I - CUPS file
   if (!fp || !format || (fp->mode != 'w' && fp->mode != 's'))
     return (false);
 
+  if (fp->mode == 'w')
+  {
+    // Format directly into the file buffer when the string fits...
+    va_start(ap, format);
+    bytes = vsnprintf(fp->ptr, (size_t)(fp->end - fp->ptr), format, ap);
+    va_end(ap);
+
+    if (bytes < 0)
+      return (false);
+
+    if (bytes >= (fp->end - fp->ptr) && (size_t)bytes < fp->bufsize)
+    {
+      // Flush the buffer and try again...
+      if (!cupsFileFlush(fp))
+        return (false);
+
+      va_start(ap, format);
+      bytes = vsnprintf(fp->ptr, (size_t)(fp->end - fp->ptr), format, ap);
+      va_end(ap);
+    }
+
+    if (bytes < (fp->end - fp->ptr))
+    {
+      fp->ptr += bytes;
+      fp->pos += bytes;
+
+      if (fp->is_stdio && !cupsFileFlush(fp))
+	return (false);
+      else
+	return (true);
+    }
+  }
+
+  // Otherwise format into the printf buffer...
   if (!fp->printf_buffer)
   {
     // Start with an 1k printf buffer...
-    if ((fp->printf_buffer = malloc(1024)) == NULL)
+    if ((fp->printf_buffer = _cupsMemAlloc(CUPS_MEMTYPE_FILE, 1024)) == NULL)
       return (false);
 
     fp->printf_size = 1024;
@@ -874,10 +1469,10 @@ cupsFilePrintf(cups_file_t *fp,		// I - CUPS file
     char	*temp;			// Temporary buffer pointer
 
     if (bytes > 65535)
-      return (-1);
+      return (false);
 
-    if ((temp = realloc(fp->printf_buffer, (size_t)(bytes + 1))) == NULL)
-      return (-1);
+    if ((temp = _cupsMemRealloc(CUPS_MEMTYPE_FILE, fp->printf_buffer, (size_t)(bytes + 1))) == NULL)
+      return (false);
 
     fp->printf_buffer = temp;
     fp->printf_size   = (size_t)(bytes + 1);
@@ -894,7 +1489,7 @@ cupsFilePrintf(cups_file_t *fp,		// I - CUPS file
 
     fp->pos += bytes;
 
-    return ((int)bytes);
+    return (true);
   }
 
   if ((fp->ptr + bytes) > fp->end)
@@ -905,7 +1500,7 @@ cupsFilePrintf(cups_file_t *fp,		// I - CUPS file
 
   fp->pos += bytes;
 
-  if ((size_t)bytes > sizeof(fp->buf))
+  if ((size_t)bytes > fp->bufsize)
   {
     if (fp->compressed)
       return (cups_compress(fp, fp->printf_buffer, (size_t)bytes));
@@ -933,6 +1528,15 @@ bool					// O - `true` on success, `false` on error
 cupsFilePutChar(cups_file_t *fp,	// I - CUPS file
                 int         c)		// I - Character to write
 {
+  // Buffer characters right away when there is room...
+  if (fp && fp->mode == 'w' && fp->ptr < fp->end)
+  {
+    *(fp->ptr) ++ = (char)c;
+    fp->pos ++;
+
+    return (true);
+  }
+
   // Range check input...
   if (!fp || (fp->mode != 'w' && fp->mode != 's'))
     return (false);
@@ -1050,7 +1654,7 @@ cupsFilePuts(cups_file_t *fp,		// I - CUPS file
 
   fp->pos += bytes;
 
-  if (bytes > sizeof(fp->buf))
+  if (bytes > fp->bufsize)
   {
     if (fp->compressed)
       return (cups_compress(fp, s, bytes) > 0);
@@ -1139,7 +1743,16 @@ cupsFileRewind(cups_file_t *fp)		// I - CUPS file
     return (-1);
 
   // Handle special cases...
-  if (fp->bufpos == 0)
+  if (fp->map)
+  {
+    // Memory-mapped file...
+    fp->pos = 0;
+    fp->ptr = fp->map;
+    fp->eof = false;
+
+    return (0);
+  }
+  else if (fp->bufpos == 0)
   {
     // No seeking necessary...
     fp->pos = 0;
@@ -1156,13 +1769,14 @@ cupsFileRewind(cups_file_t *fp)		// I - CUPS file
   // Otherwise, seek in the file and cleanup any compression buffers...
   if (fp->compressed)
   {
-    inflateEnd(&fp->stream);
+    cups_decompress_end(fp);
     fp->compressed = false;
   }
 
   if (lseek(fp->fd, 0, SEEK_SET))
     return (-1);
 
+  fp->qpos   = -1;
   fp->bufpos = 0;
   fp->pos    = 0;
   fp->ptr    = NULL;
@@ -1189,7 +1803,19 @@ cupsFileSeek(cups_file_t *fp,		// I - CUPS file
     return (-1);
 
   // Handle special cases...
-  if (pos == 0)
+  if (fp->map)
+  {
+    // Memory-mapped file...
+    if (pos > (off_t)fp->mapsize)
+      return (-1);
+
+    fp->pos = pos;
+    fp->ptr = fp->map + pos;
+    fp->eof = false;
+
+    return (pos);
+  }
+  else if (pos == 0)
     return (cupsFileRewind(fp));
 
   if (fp->ptr)
@@ -1217,14 +1843,30 @@ cupsFileSeek(cups_file_t *fp,		// I - CUPS file
   // Seek forwards or backwards...
   fp->eof = false;
 
-  if (pos < fp->bufpos)
+  if (cups_index_seek(fp, pos))
+  {
+    // Decompress from the nearest seek index point...
+    while ((bytes = cups_fill(fp)) > 0)
+    {
+      if (pos >= fp->bufpos && pos < (fp->bufpos + bytes))
+	break;
+    }
+
+    if (bytes <= 0)
+      return (-1);
+
+    fp->ptr = fp->buf + pos - fp->bufpos;
+    fp->pos = pos;
+  }
+  else if (pos < fp->bufpos)
   {
     // Need to seek backwards...
     if (fp->compressed)
     {
-      inflateEnd(&fp->stream);
+      cups_decompress_end(fp);
 
       lseek(fp->fd, 0, SEEK_SET);
+      fp->qpos   = -1;
       fp->bufpos = 0;
       fp->pos    = 0;
       fp->ptr    = NULL;
@@ -1245,6 +1887,7 @@ cupsFileSeek(cups_file_t *fp,		// I - CUPS file
     else
     {
       fp->bufpos = lseek(fp->fd, pos, SEEK_SET);
+      fp->qpos   = -1;
       fp->pos    = fp->bufpos;
       fp->ptr    = NULL;
       fp->end    = NULL;
@@ -1270,6 +1913,7 @@ cupsFileSeek(cups_file_t *fp,		// I - CUPS file
     else
     {
       fp->bufpos = lseek(fp->fd, pos, SEEK_SET);
+      fp->qpos   = -1;
       fp->pos    = fp->bufpos;
       fp->ptr    = NULL;
       fp->end    = NULL;
@@ -1280,6 +1924,257 @@ cupsFileSeek(cups_file_t *fp,		// I - CUPS file
 }
 
 
+//
+// 'cupsFileSetCompressionThreads()' - Set the number of threads used to compress a file.
+//
+// This function enables parallel gzip compression for a file opened for
+// writing with gzip compression (for example "w9").  Data is compressed in
+// 128k blocks by up to "num_threads" threads, and the blocks are written in
+// order as a single gzip stream that can be read by @link cupsFileOpen@ and
+// other gzip decompressors.  A value of `0` or `1` uses a single thread.
+//
+// This function must be called before any data is written to the file.
+//
+
+bool					// O - `true` on success, `false` on error
+cupsFileSetCompressionThreads(
+    cups_file_t *fp,			// I - CUPS file
+    size_t      num_threads)		// I - Number of threads
+{
+  size_t	i;			// Looping var
+  _cups_pzjob_t	*job;			// Current job
+
+
+  // Range check input...
+  if (!fp || fp->mode != 'w' || !fp->compressed || fp->level == 0 || fp->pzjobs || fp->pos > 0 || num_threads > _CUPS_FILE_MAX_THREADS)
+    return (false);
+
+  if (num_threads < 2)
+    return (true);
+
+  // Allocate the compression jobs...
+  if ((fp->pzjobs = _cupsMemCalloc(CUPS_MEMTYPE_FILE, num_threads, sizeof(_cups_pzjob_t))) == NULL)
+    return (false);
+
+  fp->pznum   = num_threads;
+  fp->pzfirst = 0;
+  fp->pzcount = 0;
+  fp->pzcur   = 0;
+
+  for (i = 0, job = fp->pzjobs; i < num_threads; i ++, job ++)
+  {
+    job->level   = fp->level;
+    job->outsize = _CUPS_FILE_PZ_BLOCK + _CUPS_FILE_PZ_BLOCK / 8 + 1024;
+
+    if ((job->in = _cupsMemAlloc(CUPS_MEMTYPE_FILE, _CUPS_FILE_PZ_BLOCK)) == NULL || (job->dict = _cupsMemAlloc(CUPS_MEMTYPE_FILE, _CUPS_FILE_PZ_DICT)) == NULL || (job->out = _cupsMemAlloc(CUPS_MEMTYPE_FILE, job->outsize)) == NULL)
+    {
+      cups_pz_free(fp);
+      return (false);
+    }
+  }
+
+  // The single-threaded compressor is no longer needed...
+  deflateEnd(&fp->stream);
+
+  return (true);
+}
+
+
+//
+// 'cupsFileSetBufferSize()' - Set the size of the I/O buffers for a file.
+//
+// This function sets the size of the buffers used to read, write, and
+// (de)compress data for the file.  Larger buffers reduce the number of
+// system calls for large files.  Sizes smaller than 4096 bytes use the
+// default size of 4096 bytes, and the maximum size is 64MiB.
+//
+// Any pending output is written before the buffer size is changed.  Files
+// opened for reading must not have been read from yet.
+//
+
+bool					// O - `true` on success, `false` on error
+cupsFileSetBufferSize(
+    cups_file_t *fp,			// I - CUPS file
+    size_t      bufsize)		// I - Buffer size in bytes
+{
+  char		*buf;			// New buffers
+
+
+  // Range check input...
+  if (!fp || bufsize > _CUPS_FILE_MAX_BUFSIZE)
+    return (false);
+
+  if (bufsize < _CUPS_FILE_BUFSIZE)
+    bufsize = _CUPS_FILE_BUFSIZE;
+
+  if (bufsize == fp->bufsize)
+    return (true);
+
+  if (fp->mode == 'w')
+  {
+    // Write any pending output...
+    if (!cupsFileFlush(fp))
+      return (false);
+
+    if (fp->compressed && fp->stream.next_out > fp->cbuf)
+    {
+      if (!cups_write(fp, (char *)fp->cbuf, (size_t)(fp->stream.next_out - fp->cbuf)))
+        return (false);
+    }
+  }
+  else if (fp->ptr || fp->map)
+  {
+    // Already reading from the file...
+    return (false);
+  }
+
+  // Allocate the new buffer and compression buffer...
+  if (bufsize == _CUPS_FILE_BUFSIZE)
+  {
+    buf = fp->defbuf;
+  }
+  else if ((buf = _cupsMemAlloc(CUPS_MEMTYPE_FILE, 2 * bufsize)) == NULL)
+  {
+    return (false);
+  }
+
+  if (fp->buf != fp->defbuf)
+    _cupsMemFree(fp->buf);
+
+  fp->buf     = buf;
+  fp->cbuf    = buf == fp->defbuf ? fp->defcbuf : (Bytef *)buf + bufsize;
+  fp->bufsize = bufsize;
+
+  if (fp->mode == 'w')
+  {
+    fp->ptr = fp->buf;
+    fp->end = fp->buf + fp->bufsize;
+
+    if (fp->compressed)
+    {
+      fp->stream.next_out  = fp->cbuf;
+      fp->stream.avail_out = (uInt)fp->bufsize;
+    }
+  }
+
+  return (true);
+}
+
+
+//
+// 'cupsFileSetHash()' - Hash the data written to a file.
+//
+// This function adds the uncompressed data written to a file to the hash or
+// HMAC context "ctx" as it is written, so that a digest of the file contents
+// is available without a second pass over the data.  Pass `NULL` to stop
+// hashing.  Any pending output is written before the hash is changed.
+//
+// The hash context remains owned by the caller and must not be finished until
+// hashing is stopped or the file is closed.
+//
+
+bool					// O - `true` on success, `false` on error
+cupsFileSetHash(cups_file_t *fp,	// I - CUPS file
+                cups_hash_t *ctx)	// I - Hash context or `NULL` for none
+{
+  // Range check input...
+  if (!fp || (fp->mode != 'w' && fp->mode != 's'))
+    return (false);
+
+  // Write any pending output using the old hash...
+  if (fp->mode == 'w' && !cupsFileFlush(fp))
+    return (false);
+
+  fp->hash = ctx;
+
+  return (true);
+}
+
+
+//
+// 'cupsFileSetQueueDepth()' - Set the read-ahead or write-behind depth for a file.
+//
+// This function sets the number of buffers that are read ahead of the current
+// position for files opened for reading, or written behind the current
+// position for files opened for writing.  Reads ask the operating system to
+// start loading the next "depth" buffers while the current buffer is used, so
+// that files on slow or network storage do not cost a full round-trip for each
+// buffer.  Writes start writing each group of "depth" buffers to storage
+// without waiting, and wait for the previous group to finish so that at most
+// two groups of buffers are pending.  A depth of `0` disables read-ahead and
+// write-behind, and the maximum depth is 256.
+//
+// Read-ahead and write-behind are hints that only apply to regular files on
+// platforms that support them; this function still returns `true` for other
+// files and platforms.
+//
+
+bool					// O - `true` on success, `false` on error
+cupsFileSetQueueDepth(
+    cups_file_t *fp,			// I - CUPS file
+    size_t      depth)			// I - Number of buffers
+{
+  // Range check input...
+  if (!fp || (fp->mode != 'r' && fp->mode != 'w') || depth > _CUPS_FILE_MAX_QDEPTH)
+    return (false);
+
+  fp->qdepth = depth;
+  fp->qpos   = -1;
+  fp->qlimit = 0;
+
+#ifdef HAVE_POSIX_FADVISE
+  // Tell the OS we will be reading sequentially...
+  if (fp->mode == 'r' && !fp->map)
+    posix_fadvise(fp->fd, 0, 0, depth ? POSIX_FADV_SEQUENTIAL : POSIX_FADV_NORMAL);
+#endif // HAVE_POSIX_FADVISE
+
+  return (true);
+}
+
+
+//
+// 'cupsFileSetSeekIndex()' - Set the seek index interval for a compressed file.
+//
+// This function enables a seek index for a gzip-compressed file opened for
+// reading.  As the file is decompressed, the decompression state is saved
+// at deflate block boundaries every "interval" bytes of uncompressed data,
+// allowing @link cupsFileSeek@ to resume decompression from the nearest saved
+// point instead of decompressing from the beginning of the file.  Each point
+// uses about 32k of memory.  Intervals smaller than 64k use the minimum
+// interval of 64k, and an interval of `0` disables the seek index.
+//
+// The seek index only covers the parts of the file that have been read.
+//
+
+bool					// O - `true` on success, `false` on error
+cupsFileSetSeekIndex(
+    cups_file_t *fp,			// I - CUPS file
+    size_t      interval)		// I - Uncompressed bytes between points or `0` to disable
+{
+  // Range check input...
+  if (!fp || fp->mode != 'r' || fp->map)
+    return (false);
+
+  if (interval == 0)
+  {
+    // Disable the seek index...
+    _cupsMemFree(fp->seekidx);
+
+    fp->seekidx       = NULL;
+    fp->num_seekidx   = 0;
+    fp->alloc_seekidx = 0;
+  }
+  else if (interval < _CUPS_FILE_MIN_INDEX)
+  {
+    interval = _CUPS_FILE_MIN_INDEX;
+  }
+
+  fp->seekinterval = interval;
+
+  return (true);
+}
+
+
 //
 // 'cupsFileStderr()' - Return a CUPS file associated with stderr.
 //
@@ -1418,7 +2313,7 @@ cupsFileWrite(cups_file_t *fp,		// I - CUPS file
 
   fp->pos += (off_t)bytes;
 
-  if (bytes > sizeof(fp->buf))
+  if (bytes > fp->bufsize)
   {
     if (fp->compressed)
       return (cups_compress(fp, buf, bytes));
@@ -1446,6 +2341,17 @@ cups_compress(cups_file_t *fp,		// I - CUPS file
   int	status;				// Deflate status
 
 
+  if (fp->hash)
+    cupsHashUpdate(fp->hash, buf, bytes);
+
+  if (fp->pzjobs)
+    return (cups_pz_compress(fp, buf, bytes));
+
+#ifdef HAVE_ZSTD
+  if (fp->zcctx)
+    return (cups_zstd_compress(fp, buf, bytes, false));
+#endif // HAVE_ZSTD
+
   // Update the CRC...
   fp->crc = crc32(fp->crc, (const Bytef *)buf, (uInt)bytes);
 
@@ -1456,13 +2362,13 @@ cups_compress(cups_file_t *fp,		// I - CUPS file
   while (fp->stream.avail_in > 0)
   {
     // Flush the current buffer...
-    if (fp->stream.avail_out < (uInt)(sizeof(fp->cbuf) / 8))
+    if (fp->stream.avail_out < (uInt)(fp->bufsize / 8))
     {
       if (!cups_write(fp, (char *)fp->cbuf, (size_t)(fp->stream.next_out - fp->cbuf)))
         return (false);
 
       fp->stream.next_out  = fp->cbuf;
-      fp->stream.avail_out = sizeof(fp->cbuf);
+      fp->stream.avail_out = (uInt)fp->bufsize;
     }
 
     if ((status = deflate(&(fp->stream), Z_NO_FLUSH)) < Z_OK && status != Z_BUF_ERROR)
@@ -1473,6 +2379,169 @@ cups_compress(cups_file_t *fp,		// I - CUPS file
 }
 
 
+//
+// 'cups_conf_free()' - Free a parsed configuration file.
+//
+
+static void
+cups_conf_free(cups_conf_t *conf)	// I - Configuration file
+{
+  size_t		i;		// Looping var
+  _cups_conf_line_t	*line;		// Current line
+
+
+  for (i = conf->num_lines, line = conf->lines; i > 0; i --, line ++)
+    _cupsMemFree(line->directive);
+
+  _cupsMemFree(conf->lines);
+  _cupsMemFree(conf->filename);
+  _cupsMemFree(conf);
+}
+
+
+//
+// 'cups_conf_hash()' - Compute the hash value of a directive name.
+//
+
+static size_t				// O - Hash value
+cups_conf_hash(const char *directive)	// I - Directive name
+{
+  size_t	hash;			// Hash value
+
+
+  for (hash = 0; *directive; directive ++)
+    hash = hash * 33 + (size_t)_cups_tolower(*directive);
+
+  return (hash % _CUPS_CONF_HASH);
+}
+
+
+//
+// 'cups_conf_read()' - Read and parse a configuration file.
+//
+
+static cups_conf_t *			// O - Configuration file or `NULL` on error
+cups_conf_read(const char *filename)	// I - Filename
+{
+  cups_conf_t		*conf;		// Configuration file
+  cups_file_t		*fp;		// File
+  struct stat		fileinfo;	// File information
+  char			buf[8192],	// Line from file
+			*value;		// Value from line
+  int			linenum = 0;	// Current line number
+  size_t		dirlen,		// Length of directive
+			vallen,		// Length of value
+			hash;		// Hash value
+  _cups_conf_line_t	*line;		// Current line
+
+
+  if ((fp = cupsFileOpen(filename, "r")) == NULL)
+    return (NULL);
+
+  if (fstat(cupsFileNumber(fp), &fileinfo) || (conf = _cupsMemCalloc(CUPS_MEMTYPE_FILE, 1, sizeof(cups_conf_t))) == NULL)
+  {
+    cupsFileClose(fp);
+    return (NULL);
+  }
+
+  if ((conf->filename = _cupsMemStrdup(CUPS_MEMTYPE_FILE, filename)) == NULL)
+    goto error;
+
+  conf->size       = fileinfo.st_size;
+  conf->mtime      = fileinfo.st_mtime;
+  conf->mtime_nsec = (long)_CUPS_CONF_NSEC(fileinfo);
+
+  while (cupsFileGetConf(fp, buf, sizeof(buf), &value, &linenum))
+  {
+    if (conf->num_lines >= conf->alloc_lines)
+    {
+      size_t		alloc_lines = conf->alloc_lines ? 2 * conf->alloc_lines : 16;
+					// New number of lines
+      _cups_conf_line_t	*lines;		// New lines
+
+      if ((lines = _cupsMemRealloc(CUPS_MEMTYPE_FILE, conf->lines, alloc_lines * sizeof(_cups_conf_line_t))) == NULL)
+        goto error;
+
+      conf->lines       = lines;
+      conf->alloc_lines = alloc_lines;
+    }
+
+    // Copy the directive and value into a single allocation...
+    line   = conf->lines + conf->num_lines;
+    dirlen = strlen(buf) + 1;
+    vallen = value ? strlen(value) + 1 : 0;
+
+    if ((line->directive = _cupsMemAlloc(CUPS_MEMTYPE_FILE, dirlen + vallen)) == NULL)
+      goto error;
+
+    memcpy(line->directive, buf, dirlen);
+
+    if (value)
+    {
+      line->value = line->directive + dirlen;
+      memcpy(line->value, value, vallen);
+    }
+    else
+    {
+      line->value = NULL;
+    }
+
+    line->linenum = linenum;
+
+    // Add the line to the hash table...
+    hash             = cups_conf_hash(buf);
+    line->prev       = conf->hash[hash];
+    conf->hash[hash] = ++ conf->num_lines;
+  }
+
+  cupsFileClose(fp);
+
+  return (conf);
+
+  // If we get here there was an error...
+  error:
+
+  cupsFileClose(fp);
+  cups_conf_free(conf);
+
+  return (NULL);
+}
+
+
+//
+// 'cups_conf_release()' - Release a reference to a configuration file.
+//
+// The caller must hold the configuration file mutex.
+//
+
+static void
+cups_conf_release(cups_conf_t *conf)	// I - Configuration file
+{
+  if (-- conf->refcount == 0)
+    cups_conf_free(conf);
+}
+
+
+//
+// 'cups_decompress_end()' - Free the decompressor for a file.
+//
+
+static void
+cups_decompress_end(cups_file_t *fp)	// I - CUPS file
+{
+#ifdef HAVE_ZSTD
+  if (fp->zdctx)
+  {
+    ZSTD_freeDCtx(fp->zdctx);
+    fp->zdctx = NULL;
+    return;
+  }
+#endif // HAVE_ZSTD
+
+  inflateEnd(&fp->stream);
+}
+
+
 //
 // 'cups_fill()' - Fill the input buffer.
 //
@@ -1486,6 +2555,14 @@ cups_fill(cups_file_t *fp)		// I - CUPS file
 			*end;		// End of buffer
 
 
+  if (fp->map)
+  {
+    // Memory-mapped files have no more data past the end of the mapping...
+    fp->eof = true;
+
+    return (0);
+  }
+
   if (fp->ptr && fp->end)
     fp->bufpos += fp->end - fp->buf;
 
@@ -1498,7 +2575,7 @@ cups_fill(cups_file_t *fp)		// I - CUPS file
       fp->compressed = false;
 
       // Read the first bytes in the file to determine if we have a gzip'd file...
-      if ((bytes = cups_read(fp, (char *)fp->buf, sizeof(fp->buf))) < 0)
+      if ((bytes = cups_read(fp, (char *)fp->buf, fp->bufsize)) < 0)
       {
         // Can't read from file!
         fp->eof = true;
@@ -1506,11 +2583,36 @@ cups_fill(cups_file_t *fp)		// I - CUPS file
 	return (-1);
       }
 
-      if (bytes < 10 || fp->buf[0] != 0x1f || (fp->buf[1] & 255) != 0x8b || fp->buf[2] != 8 || (fp->buf[3] & 0xe0) != 0)
+#ifdef HAVE_ZSTD
+      if (bytes >= 4 && (fp->buf[0] & 255) == 0x28 && (fp->buf[1] & 255) == 0xb5 && (fp->buf[2] & 255) == 0x2f && (fp->buf[3] & 255) == 0xfd)
       {
-        // Not a gzip'd file!
-	fp->ptr = fp->buf;
-	fp->end = fp->buf + bytes;
+        // Zstandard frame, setup the decompressor...
+        if ((fp->zdctx = ZSTD_createDCtx()) == NULL)
+        {
+          fp->eof = true;
+          errno   = ENOMEM;
+
+          return (-1);
+        }
+
+        memcpy(fp->cbuf, fp->buf, (size_t)bytes);
+
+        fp->zin.src    = fp->cbuf;
+        fp->zin.size   = (size_t)bytes;
+        fp->zin.pos    = 0;
+        fp->zremaining = 0;
+	fp->ptr        = fp->buf;
+	fp->end        = fp->buf;
+        fp->compressed = true;
+        continue;
+      }
+#endif // HAVE_ZSTD
+
+      if (bytes < 10 || fp->buf[0] != 0x1f || (fp->buf[1] & 255) != 0x8b || fp->buf[2] != 8 || (fp->buf[3] & 0xe0) != 0)
+      {
+        // Not a gzip'd file!
+	fp->ptr = fp->buf;
+	fp->end = fp->buf + bytes;
 
 	return (bytes);
       }
@@ -1612,6 +2714,7 @@ cups_fill(cups_file_t *fp)		// I - CUPS file
       fp->stream.avail_in  = (uInt)bytes;
       fp->stream.avail_out = 0;
       fp->crc              = crc32(0L, Z_NULL, 0);
+      fp->nocrc            = false;
 
       if (inflateInit2(&(fp->stream), -15) != Z_OK)
       {
@@ -1630,10 +2733,63 @@ cups_fill(cups_file_t *fp)		// I - CUPS file
       if (fp->eof)
 	return (0);
 
+#ifdef HAVE_ZSTD
+      if (fp->zdctx)
+      {
+        ZSTD_outBuffer	out;		// Output buffer
+
+        // Fill the decompression buffer as needed...
+        if (fp->zin.pos >= fp->zin.size)
+        {
+	  if ((bytes = cups_read(fp, (char *)fp->cbuf, fp->bufsize)) <= 0)
+	  {
+	    fp->eof = true;
+
+	    if (bytes == 0 && fp->zremaining)
+	    {
+	      // Truncated frame...
+	      errno = EIO;
+	      return (-1);
+	    }
+
+	    return (bytes);
+	  }
+
+	  fp->zin.src  = fp->cbuf;
+	  fp->zin.size = (size_t)bytes;
+	  fp->zin.pos  = 0;
+        }
+
+        // Decompress data from the buffer...
+        out.dst  = fp->buf;
+        out.size = fp->bufsize;
+        out.pos  = 0;
+
+        fp->zremaining = ZSTD_decompressStream(fp->zdctx, &out, &fp->zin);
+
+        if (ZSTD_isError(fp->zremaining))
+        {
+	  fp->eof = true;
+	  errno   = EIO;
+
+	  return (-1);
+        }
+
+        // Return the decompressed data...
+        fp->ptr = fp->buf;
+        fp->end = fp->buf + out.pos;
+
+        if (out.pos > 0)
+          return ((ssize_t)out.pos);
+
+        continue;
+      }
+#endif // HAVE_ZSTD
+
       // Fill the decompression buffer as needed...
       if (fp->stream.avail_in == 0)
       {
-	if ((bytes = cups_read(fp, (char *)fp->cbuf, sizeof(fp->cbuf))) <= 0)
+	if ((bytes = cups_read(fp, (char *)fp->cbuf, fp->bufsize)) <= 0)
 	{
 	  fp->eof = true;
 
@@ -1646,9 +2802,12 @@ cups_fill(cups_file_t *fp)		// I - CUPS file
 
       // Decompress data from the buffer...
       fp->stream.next_out  = (Bytef *)fp->buf;
-      fp->stream.avail_out = sizeof(fp->buf);
+      fp->stream.avail_out = (uInt)fp->bufsize;
 
-      status = inflate(&(fp->stream), Z_NO_FLUSH);
+      if (fp->seekinterval)
+        status = cups_index_inflate(fp);
+      else
+        status = inflate(&(fp->stream), Z_NO_FLUSH);
 
       if (fp->stream.next_out > (Bytef *)fp->buf)
         fp->crc = crc32(fp->crc, (Bytef *)fp->buf, (uInt)(fp->stream.next_out - (Bytef *)fp->buf));
@@ -1686,7 +2845,7 @@ cups_fill(cups_file_t *fp)		// I - CUPS file
 
 	tcrc = ((((((uLong)trailer[3] << 8) | (uLong)trailer[2]) << 8) | (uLong)trailer[1]) << 8) | (uLong)trailer[0];
 
-	if (tcrc != fp->crc)
+	if (tcrc != fp->crc && !fp->nocrc)
 	{
 	  // Bad CRC, mark end-of-file...
 	  fp->eof = true;
@@ -1708,7 +2867,7 @@ cups_fill(cups_file_t *fp)		// I - CUPS file
 	return (-1);
       }
 
-      bytes = (ssize_t)sizeof(fp->buf) - (ssize_t)fp->stream.avail_out;
+      bytes = (ssize_t)fp->bufsize - (ssize_t)fp->stream.avail_out;
 
       // Return the decompressed data...
       fp->ptr = fp->buf;
@@ -1720,7 +2879,7 @@ cups_fill(cups_file_t *fp)		// I - CUPS file
   }
 
   // Read a buffer's full of data...
-  if ((bytes = cups_read(fp, fp->buf, sizeof(fp->buf))) <= 0)
+  if ((bytes = cups_read(fp, fp->buf, fp->bufsize)) <= 0)
   {
     // Can't read from file!
     fp->eof = true;
@@ -1739,6 +2898,215 @@ cups_fill(cups_file_t *fp)		// I - CUPS file
 }
 
 
+#ifndef _WIN32
+//
+// 'cups_map()' - Map an uncompressed regular file into memory.
+//
+// The file is left in buffered mode when it cannot be mapped.
+//
+
+static void
+cups_map(cups_file_t *fp)		// I - CUPS file
+{
+  struct stat	fileinfo;		// File information
+  char		*map;			// Mapped data
+
+
+  // Only map non-empty regular files that we are reading from the start...
+  if (fstat(fp->fd, &fileinfo) || !S_ISREG(fileinfo.st_mode) || fileinfo.st_size <= 0 || (uintmax_t)fileinfo.st_size > SIZE_MAX || lseek(fp->fd, 0, SEEK_CUR) != 0)
+    return;
+
+  if ((map = mmap(NULL, (size_t)fileinfo.st_size, PROT_READ, MAP_PRIVATE, fp->fd, 0)) == MAP_FAILED)
+  {
+    DEBUG_printf("cups_map: mmap failed - %s", strerror(errno));
+    return;
+  }
+
+  // gzip'd and Zstandard files are decompressed through the normal buffer...
+  if (fileinfo.st_size >= 10 && (map[0] & 255) == 0x1f && (map[1] & 255) == 0x8b && map[2] == 8 && (map[3] & 0xe0) == 0)
+  {
+    munmap(map, (size_t)fileinfo.st_size);
+    return;
+  }
+
+#  ifdef HAVE_ZSTD
+  if (fileinfo.st_size >= 4 && (map[0] & 255) == 0x28 && (map[1] & 255) == 0xb5 && (map[2] & 255) == 0x2f && (map[3] & 255) == 0xfd)
+  {
+    munmap(map, (size_t)fileinfo.st_size);
+    return;
+  }
+#  endif // HAVE_ZSTD
+
+#  ifdef MADV_SEQUENTIAL
+  madvise(map, (size_t)fileinfo.st_size, MADV_SEQUENTIAL);
+#  endif // MADV_SEQUENTIAL
+
+  fp->map     = map;
+  fp->mapsize = (size_t)fileinfo.st_size;
+  fp->ptr     = map;
+  fp->end     = map + fp->mapsize;
+}
+#endif // !_WIN32
+
+
+//
+// 'cups_index_add()' - Add a seek index point at the current deflate block boundary.
+//
+
+static void
+cups_index_add(cups_file_t *fp,		// I - CUPS file
+               off_t       out)		// I - Uncompressed offset
+{
+  _cups_zpoint_t	*point;		// New point
+  int			bits;		// Unused bits in previous byte
+  off_t			in;		// Compressed offset
+
+
+  // The previous byte must still be in the input buffer if it is needed...
+  bits = fp->stream.data_type & 7;
+
+  if (bits && fp->stream.next_in == fp->cbuf)
+    return;
+
+  if ((in = lseek(fp->fd, 0, SEEK_CUR)) < 0)
+  {
+    // Not seekable, disable the seek index...
+    fp->seekinterval = 0;
+    return;
+  }
+
+  if (fp->num_seekidx >= fp->alloc_seekidx)
+  {
+    size_t		alloc_seekidx = fp->alloc_seekidx ? 2 * fp->alloc_seekidx : 16;
+					// New allocation
+    _cups_zpoint_t	*seekidx;	// New points
+
+    if ((seekidx = _cupsMemRealloc(CUPS_MEMTYPE_FILE, fp->seekidx, alloc_seekidx * sizeof(_cups_zpoint_t))) == NULL)
+      return;
+
+    fp->seekidx       = seekidx;
+    fp->alloc_seekidx = alloc_seekidx;
+  }
+
+  point          = fp->seekidx + fp->num_seekidx;
+  point->out     = out;
+  point->in      = in - (off_t)fp->stream.avail_in;
+  point->bits    = bits;
+  point->bitbyte = bits ? fp->stream.next_in[-1] : 0;
+  point->winlen  = sizeof(point->window);
+
+  if (inflateGetDictionary(&(fp->stream), point->window, &point->winlen) == Z_OK)
+    fp->num_seekidx ++;
+}
+
+
+//
+// 'cups_index_inflate()' - Decompress data, adding seek index points as needed.
+//
+
+static int				// O - zlib status
+cups_index_inflate(cups_file_t *fp)	// I - CUPS file
+{
+  int		status;			// zlib status
+  off_t		out,			// Current uncompressed offset
+		next;			// Offset for the next point
+
+
+  do
+  {
+    // Stop at each deflate block boundary...
+    if ((status = inflate(&(fp->stream), Z_BLOCK)) != Z_OK)
+      break;
+
+    if ((fp->stream.data_type & 128) && !(fp->stream.data_type & 64))
+    {
+      // At the end of a block that is not the last block...
+      out  = fp->bufpos + (off_t)(fp->stream.next_out - (Bytef *)fp->buf);
+      next = (fp->num_seekidx ? fp->seekidx[fp->num_seekidx - 1].out : 0) + (off_t)fp->seekinterval;
+
+      if (out >= next)
+        cups_index_add(fp, out);
+    }
+  }
+  while (fp->stream.avail_out > 0 && fp->stream.avail_in > 0 && fp->seekinterval);
+
+  return (status);
+}
+
+
+//
+// 'cups_index_seek()' - Restart decompression at the nearest seek index point.
+//
+
+static bool				// O - `true` if restarted, `false` otherwise
+cups_index_seek(cups_file_t *fp,	// I - CUPS file
+                off_t       pos)	// I - Uncompressed position
+{
+  size_t		left,		// Left side of search
+			right,		// Right side of search
+			current;	// Current point
+  _cups_zpoint_t	*point;		// Nearest point
+
+
+  if (!fp->num_seekidx || fp->seekidx[0].out > pos)
+    return (false);
+
+  // Find the last point at or before the position...
+  for (left = 0, right = fp->num_seekidx - 1; left < right;)
+  {
+    current = (left + right + 1) / 2;
+
+    if (fp->seekidx[current].out <= pos)
+      left = current;
+    else
+      right = current - 1;
+  }
+
+  point = fp->seekidx + left;
+
+  // Don't bother if we can get there faster by decompressing forwards...
+  if (fp->compressed && pos >= fp->bufpos && point->out <= (fp->bufpos + (fp->end - fp->buf)))
+    return (false);
+
+  DEBUG_printf("4cups_index_seek(fp=%p, pos=%ld): Using point at out=%ld, in=%ld.", (void *)fp, (long)pos, (long)point->out, (long)point->in);
+
+  // Reset or restart the decompressor at the point...
+  if (lseek(fp->fd, point->in, SEEK_SET) < 0)
+    return (false);
+
+  if (fp->compressed)
+  {
+    if (inflateReset(&(fp->stream)) != Z_OK)
+      return (false);
+  }
+  else
+  {
+    memset(&(fp->stream), 0, sizeof(fp->stream));
+
+    if (inflateInit2(&(fp->stream), -15) != Z_OK)
+      return (false);
+
+    fp->compressed = true;
+  }
+
+  if (point->bits)
+    inflatePrime(&(fp->stream), point->bits, point->bitbyte >> (8 - point->bits));
+
+  inflateSetDictionary(&(fp->stream), point->window, point->winlen);
+
+  fp->stream.next_in  = fp->cbuf;
+  fp->stream.avail_in = 0;
+  fp->qpos            = -1;
+  fp->bufpos          = point->out;
+  fp->ptr             = fp->buf;
+  fp->end             = fp->buf;
+  fp->eof             = false;
+  fp->nocrc           = true;
+
+  return (true);
+}
+
+
 //
 // 'cups_open()' - Safely open a file for writing.
 //
@@ -1814,6 +3182,275 @@ cups_open(const char *filename,		// I - Filename
 }
 
 
+//
+// 'cups_pz_compress()' - Queue data for parallel compression.
+//
+
+static bool				// O - `true` on success, `false` on error
+cups_pz_compress(cups_file_t *fp,	// I - CUPS file
+                 const char  *buf,	// I - Buffer
+		 size_t      bytes)	// I - Number bytes
+{
+  _cups_pzjob_t	*job;			// Current job
+  size_t	count;			// Number of bytes to copy
+
+
+  while (bytes > 0)
+  {
+    // Copy as much as possible to the current block...
+    job = fp->pzjobs + fp->pzcur;
+
+    if ((count = _CUPS_FILE_PZ_BLOCK - job->inlen) > bytes)
+      count = bytes;
+
+    memcpy(job->in + job->inlen, buf, count);
+
+    job->inlen += count;
+    buf        += count;
+    bytes      -= count;
+
+    // Start compressing full blocks...
+    if (job->inlen == _CUPS_FILE_PZ_BLOCK && !cups_pz_submit(fp))
+      return (false);
+  }
+
+  return (true);
+}
+
+
+//
+// 'cups_pz_free()' - Free parallel compression jobs.
+//
+
+static void
+cups_pz_free(cups_file_t *fp)		// I - CUPS file
+{
+  size_t	i;			// Looping var
+  _cups_pzjob_t	*job;			// Current job
+
+
+  if (!fp->pzjobs)
+    return;
+
+  for (i = 0, job = fp->pzjobs; i < fp->pznum; i ++, job ++)
+  {
+    if (job->thread != CUPS_THREAD_INVALID)
+      cupsThreadWait(job->thread);
+
+    _cupsMemFree(job->in);
+    _cupsMemFree(job->dict);
+    _cupsMemFree(job->out);
+  }
+
+  _cupsMemFree(fp->pzjobs);
+
+  fp->pzjobs = NULL;
+  fp->pznum  = 0;
+}
+
+
+//
+// 'cups_pz_submit()' - Start compressing the current block.
+//
+// The oldest block is written when all jobs are busy.
+//
+
+static bool				// O - `true` on success, `false` on error
+cups_pz_submit(cups_file_t *fp)		// I - CUPS file
+{
+  _cups_pzjob_t	*job = fp->pzjobs + fp->pzcur,
+					// Current job
+		*prev;			// Previous job
+
+
+  // Copy the end of the previous block to use as the dictionary, since the
+  // previous job can be reused while this one is still running...
+  if (fp->pzcount > 0)
+  {
+    prev         = fp->pzjobs + (fp->pzcur + fp->pznum - 1) % fp->pznum;
+    job->dictlen = prev->inlen < _CUPS_FILE_PZ_DICT ? prev->inlen : _CUPS_FILE_PZ_DICT;
+
+    memcpy(job->dict, prev->in + prev->inlen - job->dictlen, job->dictlen);
+  }
+  else
+  {
+    job->dictlen = 0;
+  }
+
+  // Compress the block, falling back to the current thread as needed...
+  if ((job->thread = cupsThreadCreate((cups_thread_func_t)cups_pz_thread, job)) == CUPS_THREAD_INVALID)
+    cups_pz_thread(job);
+
+  fp->pzcount ++;
+  fp->pzcur = (fp->pzcur + 1) % fp->pznum;
+
+  // Write the oldest block if we need its job for the next block...
+  if (fp->pzcount == fp->pznum && !cups_pz_write(fp))
+    return (false);
+
+  fp->pzjobs[fp->pzcur].inlen = 0;
+
+  return (true);
+}
+
+
+//
+// 'cups_pz_thread()' - Compress a block as a separate raw deflate stream.
+//
+// Ending the block with a sync flush allows blocks to be concatenated into a
+// single deflate stream.
+//
+
+static void *				// O - Thread exit status
+cups_pz_thread(_cups_pzjob_t *job)	// I - Compression job
+{
+  z_stream	stream;			// Compression stream
+  Bytef		*out;			// New output buffer
+  int		status;			// Deflate status
+
+
+  job->ok     = false;
+  job->outlen = 0;
+  job->crc    = crc32(crc32(0L, Z_NULL, 0), job->in, (uInt)job->inlen);
+
+  memset(&stream, 0, sizeof(stream));
+
+  if (deflateInit2(&stream, job->level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) < Z_OK)
+    return (NULL);
+
+  if (job->dictlen > 0 && deflateSetDictionary(&stream, job->dict, (uInt)job->dictlen) != Z_OK)
+  {
+    deflateEnd(&stream);
+    return (NULL);
+  }
+
+  stream.next_in  = job->in;
+  stream.avail_in = (uInt)job->inlen;
+
+  for (;;)
+  {
+    stream.next_out  = job->out + job->outlen;
+    stream.avail_out = (uInt)(job->outsize - job->outlen);
+
+    status      = deflate(&stream, Z_SYNC_FLUSH);
+    job->outlen = job->outsize - stream.avail_out;
+
+    if (status < Z_OK && status != Z_BUF_ERROR)
+      break;
+
+    if (stream.avail_out > 0)
+    {
+      // Done with this block...
+      job->ok = true;
+      break;
+    }
+
+    // Expand the output buffer...
+    if ((out = _cupsMemRealloc(CUPS_MEMTYPE_FILE, job->out, 2 * job->outsize)) == NULL)
+      break;
+
+    job->out     = out;
+    job->outsize *= 2;
+  }
+
+  deflateEnd(&stream);
+
+  return (NULL);
+}
+
+
+//
+// 'cups_pz_write()' - Write the oldest compressed block.
+//
+
+static bool				// O - `true` on success, `false` on error
+cups_pz_write(cups_file_t *fp)		// I - CUPS file
+{
+  _cups_pzjob_t	*job = fp->pzjobs + fp->pzfirst;
+					// Oldest job
+
+
+  if (job->thread != CUPS_THREAD_INVALID)
+  {
+    cupsThreadWait(job->thread);
+    job->thread = CUPS_THREAD_INVALID;
+  }
+
+  fp->pzfirst = (fp->pzfirst + 1) % fp->pznum;
+  fp->pzcount --;
+
+  if (!job->ok)
+    return (false);
+
+  fp->crc = crc32_combine(fp->crc, job->crc, (z_off_t)job->inlen);
+
+  return (cups_write(fp, (char *)job->out, job->outlen));
+}
+
+
+//
+// 'cups_queue()' - Queue read-ahead or write-behind for a file.
+//
+
+static void
+cups_queue(cups_file_t *fp,		// I - CUPS file
+           size_t      bytes)		// I - Number of bytes just read or written
+{
+  off_t	window;				// Size of read-ahead/write-behind
+
+
+  // Update the position of the file descriptor, getting it as needed...
+  if (fp->qpos >= 0)
+  {
+    fp->qpos += (off_t)bytes;
+  }
+  else if ((fp->qpos = lseek(fp->fd, 0, SEEK_CUR)) < 0)
+  {
+    // Not a regular file, disable read-ahead/write-behind...
+    fp->qdepth = 0;
+    return;
+  }
+  else
+  {
+    // Start a new read-ahead or write-behind window...
+    fp->qlimit = fp->mode == 'r' ? fp->qpos : fp->qpos - (off_t)bytes;
+  }
+
+  window = (off_t)(fp->qdepth * fp->bufsize);
+
+  if (fp->mode == 'r')
+  {
+#ifdef HAVE_POSIX_FADVISE
+    // Ask for the next window once half of the current one has been read...
+    if (fp->qpos + window / 2 >= fp->qlimit)
+    {
+      posix_fadvise(fp->fd, fp->qlimit, fp->qpos + window - fp->qlimit, POSIX_FADV_WILLNEED);
+      fp->qlimit = fp->qpos + window;
+    }
+#endif // HAVE_POSIX_FADVISE
+  }
+  else
+  {
+#ifdef HAVE_SYNC_FILE_RANGE
+    // Start writing each full window and wait for the previous one...
+    if (fp->qpos - fp->qlimit >= window)
+    {
+      if (sync_file_range(fp->fd, fp->qlimit, fp->qpos - fp->qlimit, SYNC_FILE_RANGE_WRITE))
+      {
+        fp->qdepth = 0;
+        return;
+      }
+
+      if (fp->qlimit >= window)
+        sync_file_range(fp->fd, fp->qlimit - window, window, SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+
+      fp->qlimit = fp->qpos;
+    }
+#endif // HAVE_SYNC_FILE_RANGE
+  }
+}
+
+
 //
 // 'cups_read()' - Read from a file descriptor.
 //
@@ -1851,6 +3488,10 @@ cups_read(cups_file_t *fp,		// I - CUPS file
       return (-1);
   }
 
+  // Queue the next read-ahead as needed...
+  if (fp->qdepth && total > 0)
+    cups_queue(fp, (size_t)total);
+
   // Return the total number of bytes read...
   return (total);
 }
@@ -1868,6 +3509,10 @@ cups_write(cups_file_t *fp,		// I - CUPS file
   ssize_t	count;			// Count this time
 
 
+  // Hash uncompressed data, compressed data is hashed by cups_compress()...
+  if (fp->hash && !fp->compressed)
+    cupsHashUpdate(fp->hash, buf, bytes);
+
   // Loop until all bytes are written...
   while (bytes > 0)
   {
@@ -1895,8 +3540,53 @@ cups_write(cups_file_t *fp,		// I - CUPS file
     // Update the counts for the last write call...
     bytes -= (size_t)count;
     buf   += count;
+
+    // Queue the next write-behind as needed...
+    if (fp->qdepth)
+      cups_queue(fp, (size_t)count);
   }
 
   // Return the total number of bytes written...
   return (true);
 }
+
+
+#ifdef HAVE_ZSTD
+//
+// 'cups_zstd_compress()' - Compress a buffer of data using Zstandard.
+//
+
+static bool				// O - `true` on success, `false` on error
+cups_zstd_compress(cups_file_t *fp,	// I - CUPS file
+                   const char  *buf,	// I - Buffer
+		   size_t      bytes,	// I - Number bytes
+		   bool        finish)	// I - `true` to finish the frame
+{
+  ZSTD_inBuffer		in;		// Input buffer
+  ZSTD_outBuffer	out;		// Output buffer
+  size_t		remaining;	// Bytes remaining to flush
+
+
+  in.src  = buf;
+  in.size = bytes;
+  in.pos  = 0;
+
+  do
+  {
+    out.dst  = fp->cbuf;
+    out.size = fp->bufsize;
+    out.pos  = 0;
+
+    remaining = ZSTD_compressStream2(fp->zcctx, &out, &in, finish ? ZSTD_e_end : ZSTD_e_continue);
+
+    if (ZSTD_isError(remaining))
+      return (false);
+
+    if (out.pos > 0 && !cups_write(fp, (char *)fp->cbuf, out.pos))
+      return (false);
+  }
+  while (finish ? remaining > 0 : in.pos < in.size);
+
+  return (true);
+}
+#endif // HAVE_ZSTD
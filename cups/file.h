@@ -33,21 +33,36 @@ extern "C" {
 // Types and structures...
 //
 
+typedef struct _cups_conf_s cups_conf_t;// Parsed configuration file
 typedef struct _cups_file_s cups_file_t;// CUPS file type
 
+typedef enum cups_file_compression_e	// File compression
+{
+  CUPS_FILE_COMPRESSION_NONE,		// No compression
+  CUPS_FILE_COMPRESSION_GZIP,		// gzip compression
+  CUPS_FILE_COMPRESSION_ZSTD		// Zstandard compression
+} cups_file_compression_t;
+
 
 //
 // Prototypes...
 //
 
+extern void		cupsConfClose(cups_conf_t *conf) _CUPS_PUBLIC;
+extern size_t		cupsConfGetCount(cups_conf_t *conf) _CUPS_PUBLIC;
+extern const char	*cupsConfGetDirective(cups_conf_t *conf, size_t n, const char **value, int *linenum) _CUPS_PUBLIC;
+extern const char	*cupsConfGetValue(cups_conf_t *conf, const char *directive) _CUPS_PUBLIC;
+extern cups_conf_t	*cupsConfOpen(const char *filename) _CUPS_PUBLIC;
 extern bool		cupsFileClose(cups_file_t *fp) _CUPS_PUBLIC;
 extern bool		cupsFileEOF(cups_file_t *fp) _CUPS_PUBLIC;
 extern const char	*cupsFileFind(const char *filename, const char *path, bool executable, char *buffer, size_t bufsize) _CUPS_PUBLIC;
 extern bool		cupsFileFlush(cups_file_t *fp) _CUPS_PUBLIC;
 extern int		cupsFileGetChar(cups_file_t *fp) _CUPS_PUBLIC;
+extern cups_file_compression_t cupsFileGetCompression(cups_file_t *fp) _CUPS_PUBLIC;
 extern char		*cupsFileGetConf(cups_file_t *fp, char *buf, size_t buflen, char **value, int *linenum) _CUPS_PUBLIC;
 extern size_t		cupsFileGetLine(cups_file_t *fp, char *buf, size_t buflen) _CUPS_PUBLIC;
 extern char		*cupsFileGets(cups_file_t *fp, char *buf, size_t buflen) _CUPS_PUBLIC;
+extern const char	*cupsFileGetView(cups_file_t *fp, size_t bytes, size_t *length) _CUPS_PUBLIC;
 extern bool		cupsFileIsCompressed(cups_file_t *fp) _CUPS_PUBLIC;
 extern bool		cupsFileLock(cups_file_t *fp, bool block) _CUPS_PUBLIC;
 extern int		cupsFileNumber(cups_file_t *fp) _CUPS_PUBLIC;
@@ -61,6 +76,11 @@ extern bool		cupsFilePuts(cups_file_t *fp, const char *s) _CUPS_PUBLIC;
 extern ssize_t		cupsFileRead(cups_file_t *fp, char *buf, size_t bytes) _CUPS_PUBLIC;
 extern off_t		cupsFileRewind(cups_file_t *fp) _CUPS_PUBLIC;
 extern off_t		cupsFileSeek(cups_file_t *fp, off_t pos) _CUPS_PUBLIC;
+extern bool		cupsFileSetBufferSize(cups_file_t *fp, size_t bufsize) _CUPS_PUBLIC;
+extern bool		cupsFileSetCompressionThreads(cups_file_t *fp, size_t num_threads) _CUPS_PUBLIC;
+extern bool		cupsFileSetHash(cups_file_t *fp, cups_hash_t *ctx) _CUPS_PUBLIC;
+extern bool		cupsFileSetQueueDepth(cups_file_t *fp, size_t depth) _CUPS_PUBLIC;
+extern bool		cupsFileSetSeekIndex(cups_file_t *fp, size_t interval) _CUPS_PUBLIC;
 extern cups_file_t	*cupsFileStderr(void) _CUPS_PUBLIC;
 extern cups_file_t	*cupsFileStdin(void) _CUPS_PUBLIC;
 extern cups_file_t	*cupsFileStdout(void) _CUPS_PUBLIC;
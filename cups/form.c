@@ -16,7 +16,7 @@
 // Local functions...
 //
 
-static const char	*decode_string(const char *data, char *buffer, size_t bufsize);
+static const char	*decode_string(const char *data, char *buffer, size_t bufsize, char *delim);
 static char		*encode_string(const char *s, char *bufptr, char *bufend);
 
 
@@ -36,7 +36,8 @@ cupsFormDecode(const char    *data,	// I - URL-encoded form data
 {
   size_t	num_vars = 0;		// Number of variables
   char		name[1024],		// Variable name
-		value[4096];		// Variable value
+		value[4096],		// Variable value
+		delim;			// Delimiter after name or value
 
 
   DEBUG_printf("cupsFormDecode(data=\"%s\", vars=%p)", data, (void *)vars);
@@ -66,9 +67,9 @@ cupsFormDecode(const char    *data,	// I - URL-encoded form data
   {
     // Get the name and value...
     DEBUG_printf("2cupsFormDecode: LOOP data=%p, *data='%c'", data, data ? *data : '?');
-    data = decode_string(data, name, sizeof(name));
+    data = decode_string(data, name, sizeof(name), &delim);
 
-    if (!data || *data != '=')
+    if (!data || delim != '=')
     {
       DEBUG_printf("2cupsFormDecode: NAMEERROR data=%p, *data='%c'", data, data ? *data : '?');
       goto decode_error;
@@ -77,14 +78,14 @@ cupsFormDecode(const char    *data,	// I - URL-encoded form data
     DEBUG_printf("2cupsFormDecode: name=\"%s\"", name);
     data ++;
 
-    data = decode_string(data, value, sizeof(value));
+    data = decode_string(data, value, sizeof(value), &delim);
 
-    if (!data || (*data && *data != '&'))
+    if (!data || (delim && delim != '&'))
     {
       DEBUG_printf("2cupsFormDecode: VALUEERROR data=%p, *data='%c'", data, data ? *data : '?');
       goto decode_error;
     }
-    else if (*data)
+    else if (delim)
     {
       data ++;
 
@@ -119,6 +120,101 @@ cupsFormDecode(const char    *data,	// I - URL-encoded form data
 }
 
 
+//
+// 'cupsFormDecodeBuffer()' - Decode URL-encoded form data in place.
+//
+// This function decodes URL-encoded form data in the mutable string "data",
+// storing up to "max_vars" variables in the array "vars".  The names and
+// values of the variables point into "data", so no memory is allocated.
+// Variables are returned in the order they appear in the form data, including
+// any duplicate names.
+//
+// The contents of "data" are undefined if the form data cannot be decoded.
+//
+
+size_t					// O - Number of variables or `0` on error
+cupsFormDecodeBuffer(
+    char          *data,		// I - URL-encoded form data
+    size_t        max_vars,		// I - Maximum number of variables
+    cups_option_t *vars)		// I - Array of variables
+{
+  size_t	num_vars = 0;		// Number of variables
+  char		*dataend,		// End of form data
+		*name,			// Variable name
+		*value,			// Variable value
+		delim;			// Delimiter after name or value
+
+
+  DEBUG_printf("cupsFormDecodeBuffer(data=\"%s\", max_vars=%u, vars=%p)", data, (unsigned)max_vars, (void *)vars);
+
+  // Range check...
+  if (!data || !*data || max_vars == 0 || !vars)
+    return (0);
+
+  // If the data starts with a "http:", "https:", or "/" prefix, skip past the
+  // URL/path portion to the "query string" portion...
+  if (!strncmp(data, "http://", 7) || !strncmp(data, "https://", 8) || *data == '/')
+  {
+    if ((data = strchr(data, '?')) == NULL)
+      goto decode_error;
+
+    data ++;
+  }
+
+  // Scan the string for "name=value" pairs, unescaping them in place.  The
+  // decoded string is never longer than the encoded string...
+  dataend = data + strlen(data);
+
+  while (*data)
+  {
+    if (num_vars >= max_vars)
+    {
+      DEBUG_puts("2cupsFormDecodeBuffer: Too many variables.");
+      goto decode_error;
+    }
+
+    // Get the name and value...
+    name = data;
+    data = (char *)decode_string(data, name, (size_t)(dataend - data + 1), &delim);
+
+    if (!data || delim != '=')
+      goto decode_error;
+
+    data ++;
+    value = data;
+    data  = (char *)decode_string(data, value, (size_t)(dataend - data + 1), &delim);
+
+    if (!data || (delim && delim != '&'))
+      goto decode_error;
+    else if (delim)
+    {
+      data ++;
+
+      if (!*data)
+        goto decode_error;
+    }
+
+    // Add the variable...
+    vars[num_vars].name  = name;
+    vars[num_vars].value = value;
+    num_vars ++;
+  }
+
+  DEBUG_printf("2cupsFormDecodeBuffer: Returning %lu", (unsigned long)num_vars);
+
+  return (num_vars);
+
+  // If we get here there was an error in the form data...
+  decode_error:
+
+  _cupsSetError(IPP_STATUS_ERROR_INTERNAL, _("Invalid form data."), 1);
+
+  DEBUG_puts("2cupsFormDecodeBuffer: Returning 0");
+
+  return (0);
+}
+
+
 //
 // 'cupsFormEncode()' - Encode options as URL-encoded form data.
 //
@@ -133,12 +229,46 @@ cupsFormEncode(const char    *url,	// I - URL or `NULL` for none
                size_t        num_vars,	// I - Number of variables
                cups_option_t *vars)	// I - Variables
 {
-  char	buffer[65536],			// Temporary buffer
-	prefix = '\0',			// Prefix character, if any
-	*bufptr = buffer,		// Current position in buffer
-	*bufend = buffer + sizeof(buffer) - 1;
-					// End of buffer
+  char	buffer[65536];			// Temporary buffer
+
+
+  if (!cupsFormEncodeBuffer(url, num_vars, vars, buffer, sizeof(buffer)))
+    return (NULL);
+
+  return (strdup(buffer));
+}
+
+
+//
+// 'cupsFormEncodeBuffer()' - Encode options as URL-encoded form data in a buffer.
+//
+// This function encodes a CUPS options array as URL-encoded form data with an
+// optional URL prefix, storing the nul-terminated result in the specified
+// buffer.
+//
+
+char *					// O - URL-encoded form data or `NULL` on error
+cupsFormEncodeBuffer(
+    const char    *url,			// I - URL or `NULL` for none
+    size_t        num_vars,		// I - Number of variables
+    cups_option_t *vars,		// I - Variables
+    char          *buffer,		// I - Buffer
+    size_t        bufsize)		// I - Size of buffer
+{
+  char	prefix = '\0',			// Prefix character, if any
+	*bufptr,			// Current position in buffer
+	*bufend;			// End of buffer
+
+
+  // Range check input...
+  if (!buffer || bufsize < 2 || (num_vars > 0 && !vars))
+  {
+    _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(EINVAL), 0);
+    return (NULL);
+  }
 
+  bufptr = buffer;
+  bufend = buffer + bufsize - 1;
 
   // Start with the URL, if present...
   if (url)
@@ -157,7 +287,9 @@ cupsFormEncode(const char    *url,	// I - URL or `NULL` for none
       return (NULL);
     }
 
-    httpAssembleURI(HTTP_URI_CODING_ALL, buffer, sizeof(buffer), scheme, NULL, host, port, resource);
+    if (httpAssembleURI(HTTP_URI_CODING_ALL, buffer, bufsize, scheme, NULL, host, port, resource) < HTTP_URI_STATUS_OK)
+      goto encode_error;
+
     bufptr = buffer + strlen(buffer);
 
     // Check whether the URL included some initial query parameters...
@@ -201,10 +333,10 @@ cupsFormEncode(const char    *url,	// I - URL or `NULL` for none
     vars ++;
   }
 
-  // Nul-terminate and return a copy...
+  // Nul-terminate and return the buffer...
   *bufptr = '\0';
 
-  return (strdup(buffer));
+  return (buffer);
 
   // Report encoding errors here...
   encode_error:
@@ -218,11 +350,16 @@ cupsFormEncode(const char    *url,	// I - URL or `NULL` for none
 //
 // 'decode_string()' - Decode a URL-encoded string.
 //
+// The buffer may be the data string itself since decoded strings are never
+// longer than the encoded string.  The delimiter is returned separately since
+// the nul terminator may overwrite it in that case.
+//
 
 static const char *                     // O - New pointer into string or `NULL` on error
 decode_string(const char *data,         // I - Pointer into data string
               char       *buffer,       // I - String buffer
-              size_t     bufsize)       // I - Size of string buffer
+              size_t     bufsize,       // I - Size of string buffer
+              char       *delim)        // O - Delimiter character ('&', '=', or nul)
 {
   int	ch;				// Current character
   char	*ptr,				// Pointer info buffer
@@ -270,7 +407,8 @@ decode_string(const char *data,         // I - Pointer into data string
       *ptr++ = (char)ch;
   }
 
-  *ptr = '\0';
+  *delim = *data;
+  *ptr   = '\0';
 
   return (data);
 }
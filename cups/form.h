@@ -20,7 +20,9 @@ extern "C" {
 //
 
 extern size_t	cupsFormDecode(const char *data, cups_option_t **vars) _CUPS_PUBLIC;
+extern size_t	cupsFormDecodeBuffer(char *data, size_t max_vars, cups_option_t *vars) _CUPS_PUBLIC;
 extern char	*cupsFormEncode(const char *url, size_t num_vars, cups_option_t *vars) _CUPS_PUBLIC;
+extern char	*cupsFormEncodeBuffer(const char *url, size_t num_vars, cups_option_t *vars, char *buffer, size_t bufsize) _CUPS_PUBLIC;
 
 
 #  ifdef __cplusplus
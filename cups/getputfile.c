@@ -19,6 +19,48 @@
 #endif // _WIN32 || __EMX__
 
 
+//
+// Local constants...
+//
+
+#define _CUPS_GET_MAX_STREAMS	16	// Maximum number of parallel streams
+#define _CUPS_GET_SEGMENT	1048576	// Minimum size of a ranged GET
+
+
+//
+// Local types...
+//
+
+typedef struct _cups_get_range_s	// Ranged GET segment
+{
+  http_t	*http;			// Connection or `NULL` for a new one
+  const char	*host;			// Hostname for new connection
+  int		port;			// Port number for new connection
+  http_encryption_t encryption;		// Encryption for new connection
+  char		*authstring;		// Authorization for new connection
+  bool		auth;			// Authenticate on 401 responses?
+  const char	*resource;		// Resource name
+  const char	*if_modified_since;	// If-Modified-Since value or `NULL`
+  const char	*if_range;		// If-Range value or `NULL`
+  int		fd;			// File descriptor
+  off_t		start,			// First byte of segment
+		end,			// Last byte of segment or `-1` for the rest
+		total;			// Total length of resource or `-1` if unknown
+  http_status_t	status;			// Status of segment
+} _cups_get_range_t;
+
+
+//
+// Local functions...
+//
+
+static bool		cups_get_content_range(http_t *http, off_t *first, off_t *last, off_t *total);
+static http_status_t	cups_get_request(http_t *http, const char *resource, const char *if_modified_since, const char *range, const char *if_range, bool auth);
+static http_status_t	cups_get_segment(_cups_get_range_t *range, bool first);
+static void		*cups_get_thread(_cups_get_range_t *range);
+static bool		cups_pwrite(int fd, const char *buffer, size_t bytes, off_t offset);
+
+
 //
 // 'cupsGetFd()' - Get a file from the server.
 //
@@ -35,8 +77,6 @@ cupsGetFd(http_t     *http,		// I - Connection to server or @code CUPS_HTTP_DEFA
   http_status_t	status;			// HTTP status from server
   char		if_modified_since[HTTP_MAX_VALUE];
 					// If-Modified-Since header
-  int		new_auth = 0;		// Using new auth information?
-  int		digest;			// Are we using Digest authentication?
 
 
   // Range check input...
@@ -57,112 +97,250 @@ cupsGetFd(http_t     *http,		// I - Connection to server or @code CUPS_HTTP_DEFA
   // Then send GET requests to the HTTP server...
   cupsCopyString(if_modified_since, httpGetField(http, HTTP_FIELD_IF_MODIFIED_SINCE), sizeof(if_modified_since));
 
-  do
+  status = cups_get_request(http, resource, if_modified_since, NULL, NULL, true);
+
+  // See if we actually got the file or an error...
+  if (status == HTTP_STATUS_OK)
   {
-    if (!_cups_strcasecmp(httpGetField(http, HTTP_FIELD_CONNECTION), "close"))
-    {
-      httpClearFields(http);
-      if (!httpReconnect(http, 30000, NULL))
-      {
-	status = HTTP_STATUS_ERROR;
-	break;
-      }
-    }
+    // Yes, copy the file...
+    while ((bytes = httpRead(http, buffer, sizeof(buffer))) > 0)
+      write(fd, buffer, (size_t)bytes);
+  }
+  else
+  {
+    _cupsSetHTTPError(status);
+    httpFlush(http);
+  }
 
-    httpClearFields(http);
-    httpSetField(http, HTTP_FIELD_IF_MODIFIED_SINCE, if_modified_since);
+  // Return the request status...
+  DEBUG_printf("1cupsGetFd: Returning %d...", status);
 
-    digest = http->authstring && !strncmp(http->authstring, "Digest ", 7);
+  return (status);
+}
 
-    if (digest && !new_auth)
-    {
-      // Update the Digest authentication string...
-      _httpSetDigestAuthString(http, http->nextnonce, "GET", resource);
-    }
 
-    httpSetField(http, HTTP_FIELD_AUTHORIZATION, http->authstring);
+//
+// 'cupsGetFdParallel()' - Get a file from the server using ranged requests.
+//
+// This function gets the resource starting at byte "offset", for example to
+// resume an interrupted download, and writes the data at the same offset in
+// the file descriptor "fd", which must refer to a regular file.  When
+// "num_streams" is greater than 1 and the server supports ranged requests,
+// large resources are split into up to "num_streams" ranges that are
+// retrieved in parallel over additional connections to the same server.
+//
+// This function returns @code HTTP_STATUS_OK@ when the file is successfully
+// retrieved, including when "offset" is already the length of the resource.
+//
 
-    if (!httpWriteRequest(http, "GET", resource))
-    {
-      if (httpReconnect(http, 30000, NULL))
-      {
-        status = HTTP_STATUS_UNAUTHORIZED;
-        continue;
-      }
-      else
-      {
-        status = HTTP_STATUS_ERROR;
-	break;
-      }
-    }
+http_status_t				// O - HTTP status
+cupsGetFdParallel(
+    http_t     *http,			// I - Connection to server or @code CUPS_HTTP_DEFAULT@
+    const char *resource,		// I - Resource name
+    int        fd,			// I - File descriptor
+    off_t      offset,			// I - Starting offset in resource
+    size_t     num_streams)		// I - Maximum number of parallel streams
+{
+  http_status_t	status;			// HTTP status from server
+  char		if_modified_since[HTTP_MAX_VALUE],
+					// If-Modified-Since header
+		if_range[HTTP_MAX_VALUE];
+					// If-Range header
+  const char	*value;			// Response field value
+  _cups_get_range_t first,		// First segment
+		ranges[_CUPS_GET_MAX_STREAMS];
+					// Remaining segments
+  cups_thread_t	threads[_CUPS_GET_MAX_STREAMS];
+					// Segment threads
+  off_t		start,			// Start of remaining segments
+		total,			// Total length of resource
+		length;			// Length of each segment
+  size_t	i,			// Looping var
+		count;			// Number of segments
 
-    new_auth = 0;
 
-    while ((status = httpUpdate(http)) == HTTP_STATUS_CONTINUE);
+  // Range check input...
+  DEBUG_printf("cupsGetFdParallel(http=%p, resource=\"%s\", fd=%d, offset=%ld, num_streams=%u)", (void *)http, resource, fd, (long)offset, (unsigned)num_streams);
 
-    if (status == HTTP_STATUS_UNAUTHORIZED)
-    {
-      // Flush any error message...
-      httpFlush(http);
+  if (!resource || fd < 0 || offset < 0)
+  {
+    if (http)
+      http->error = EINVAL;
 
-      // See if we can do authentication...
-      new_auth = 1;
+    return (HTTP_STATUS_ERROR);
+  }
 
-      if (!cupsDoAuthentication(http, "GET", resource))
-      {
-        status = HTTP_STATUS_CUPS_AUTHORIZATION_CANCELED;
-        break;
-      }
+  if (!http)
+    if ((http = _cupsConnect()) == NULL)
+      return (HTTP_STATUS_SERVICE_UNAVAILABLE);
 
-      if (!httpReconnect(http, 30000, NULL))
-      {
-        status = HTTP_STATUS_ERROR;
-        break;
-      }
+#ifdef _WIN32
+  // Positioned writes use lseek and write, so only use a single stream...
+  num_streams = 1;
+#else
+  if (num_streams < 1)
+    num_streams = 1;
+  else if (num_streams > _CUPS_GET_MAX_STREAMS)
+    num_streams = _CUPS_GET_MAX_STREAMS;
+#endif // _WIN32
+
+#ifdef AF_LOCAL
+  if (http->hostaddr && httpAddrGetFamily(http->hostaddr) == AF_LOCAL)
+    num_streams = 1;
+#endif // AF_LOCAL
+
+  // Get the first segment, or everything after "offset" when using a single
+  // stream...
+  cupsCopyString(if_modified_since, httpGetField(http, HTTP_FIELD_IF_MODIFIED_SINCE), sizeof(if_modified_since));
 
-      continue;
-    }
-    else if (status == HTTP_STATUS_UPGRADE_REQUIRED)
-    {
-      // Flush any error message...
-      httpFlush(http);
+  memset(&first, 0, sizeof(first));
+  first.http              = http;
+  first.auth              = true;
+  first.resource          = resource;
+  first.if_modified_since = if_modified_since;
+  first.fd                = fd;
+  first.start             = offset;
+  first.end               = num_streams > 1 ? offset + _CUPS_GET_SEGMENT - 1 : -1;
 
-      // Reconnect...
-      if (!httpReconnect(http, 30000, NULL))
-      {
-        status = HTTP_STATUS_ERROR;
-        break;
-      }
+  if ((status = cups_get_segment(&first, true)) == HTTP_STATUS_RANGE_NOT_SATISFIABLE && offset > 0 && first.total == offset)
+  {
+    // Already have the whole resource...
+    status = HTTP_STATUS_OK;
+  }
 
-      // Upgrade with encryption...
-      httpSetEncryption(http, HTTP_ENCRYPTION_REQUIRED);
+  if (status != HTTP_STATUS_PARTIAL_CONTENT)
+  {
+    // Got the whole resource or an error...
+    if (status != HTTP_STATUS_OK)
+      _cupsSetHTTPError(status);
 
-      // Try again, this time with encryption enabled...
-      continue;
-    }
+    DEBUG_printf("1cupsGetFdParallel: Returning %d...", status);
+
+    return (status);
   }
-  while (status == HTTP_STATUS_UNAUTHORIZED || status == HTTP_STATUS_UPGRADE_REQUIRED);
 
-  // See if we actually got the file or an error...
-  if (status == HTTP_STATUS_OK)
+  if (first.end < 0)
   {
-    // Yes, copy the file...
-    while ((bytes = httpRead(http, buffer, sizeof(buffer))) > 0)
-      write(fd, buffer, (size_t)bytes);
+    // Got everything after "offset"...
+    DEBUG_puts("1cupsGetFdParallel: Returning 200...");
+
+    return (HTTP_STATUS_OK);
+  }
+
+  // Use the entity tag or modification date to make sure the remaining
+  // segments come from the same version of the resource...
+  if ((value = httpGetField(http, HTTP_FIELD_ETAG)) != NULL && *value && strncmp(value, "W/", 2))
+    cupsCopyString(if_range, value, sizeof(if_range));
+  else if ((value = httpGetField(http, HTTP_FIELD_LAST_MODIFIED)) != NULL)
+    cupsCopyString(if_range, value, sizeof(if_range));
+  else
+    if_range[0] = '\0';
+
+  start = first.end + 1;
+  total = first.total;
+
+  if (total < 0)
+  {
+    // Unknown length, get the rest over the current connection...
+    first.start = start;
+    first.end   = -1;
+
+    if ((status = cups_get_segment(&first, false)) == HTTP_STATUS_PARTIAL_CONTENT)
+      status = HTTP_STATUS_OK;
+    else
+      _cupsSetHTTPError(status);
+
+    DEBUG_printf("1cupsGetFdParallel: Returning %d...", status);
+
+    return (status);
   }
+
+  if (start >= total)
+  {
+    DEBUG_puts("1cupsGetFdParallel: Returning 200...");
+
+    return (HTTP_STATUS_OK);
+  }
+
+  // Split the rest of the resource into segments of at least
+  // _CUPS_GET_SEGMENT bytes...
+  if ((total - start) < ((off_t)num_streams * _CUPS_GET_SEGMENT))
+    count = (size_t)((total - start + _CUPS_GET_SEGMENT - 1) / _CUPS_GET_SEGMENT);
   else
+    count = num_streams;
+
+  length = (total - start + (off_t)count - 1) / (off_t)count;
+
+  DEBUG_printf("2cupsGetFdParallel: Getting %ld bytes in %u segments.", (long)(total - start), (unsigned)count);
+
+  memset(ranges, 0, sizeof(ranges));
+  memset(threads, 0, sizeof(threads));
+
+  for (i = 0; i < count; i ++)
   {
-    _cupsSetHTTPError(status);
-    httpFlush(http);
+    ranges[i].http       = i == 0 ? http : NULL;
+    ranges[i].auth       = i == 0;
+    ranges[i].host       = http->hostname;
+    ranges[i].port       = httpAddrGetPort(http->hostaddr);
+    ranges[i].encryption = http->encryption;
+    ranges[i].resource   = resource;
+    ranges[i].if_range   = if_range;
+    ranges[i].fd         = fd;
+    ranges[i].start      = start + (off_t)i * length;
+    ranges[i].end        = ranges[i].start + length - 1;
+    ranges[i].status     = HTTP_STATUS_ERROR;
+
+    if (ranges[i].end >= total)
+      ranges[i].end = total - 1;
+
+    if (i > 0)
+    {
+      // Only Basic and Bearer credentials can be reused as-is on another
+      // connection...
+      if (http->authstring && (!strncmp(http->authstring, "Basic ", 6) || !strncmp(http->authstring, "Bearer ", 7)))
+        ranges[i].authstring = _cupsMemStrdup(CUPS_MEMTYPE_HTTP, http->authstring);
+
+      threads[i] = cupsThreadCreate((cups_thread_func_t)cups_get_thread, ranges + i);
+    }
   }
 
-  // Return the request status...
-  DEBUG_printf("1cupsGetFd: Returning %d...", status);
+  // Get the first segment over the current connection and then wait for the
+  // others...
+  ranges[0].status = cups_get_segment(ranges + 0, false);
+
+  for (i = 1; i < count; i ++)
+  {
+    if (threads[i] != CUPS_THREAD_INVALID)
+      cupsThreadWait(threads[i]);
+
+    _cupsMemFree(ranges[i].authstring);
+  }
+
+  // Retry any failed segments over the current connection...
+  for (i = 0, status = HTTP_STATUS_OK; i < count && status == HTTP_STATUS_OK; i ++)
+  {
+    if (ranges[i].status == HTTP_STATUS_PARTIAL_CONTENT)
+      continue;
+
+    DEBUG_printf("2cupsGetFdParallel: Retrying segment %u (status %d).", (unsigned)i, ranges[i].status);
+
+    ranges[i].http = http;
+    ranges[i].auth = true;
+
+    if ((status = cups_get_segment(ranges + i, false)) == HTTP_STATUS_PARTIAL_CONTENT)
+      status = HTTP_STATUS_OK;
+  }
+
+  if (status != HTTP_STATUS_OK)
+    _cupsSetHTTPError(status);
+
+  DEBUG_printf("1cupsGetFdParallel: Returning %d...", status);
 
   return (status);
 }
 
 
+
 //
 // 'cupsGetFile()' - Get a file from the server.
 //
@@ -209,6 +387,68 @@ cupsGetFile(http_t     *http,		// I - Connection to server or @code CUPS_HTTP_DE
   return (status);
 }
 
+//
+// 'cupsGetFileParallel()' - Get a file from the server using ranged requests.
+//
+// This function gets the resource using @link cupsGetFdParallel@.  When
+// "resume" is `true`, an existing file is kept and only the bytes after its
+// current length are retrieved.  Otherwise the file is created or truncated
+// and removed if the resource cannot be retrieved.
+//
+// This function returns @code HTTP_STATUS_OK@ when the file is successfully
+// retrieved.
+//
+
+http_status_t				// O - HTTP status
+cupsGetFileParallel(
+    http_t     *http,			// I - Connection to server or @code CUPS_HTTP_DEFAULT@
+    const char *resource,		// I - Resource name
+    const char *filename,		// I - Filename
+    bool       resume,			// I - `true` to resume a partial file, `false` to replace it
+    size_t     num_streams)		// I - Maximum number of parallel streams
+{
+  int		fd;			// File descriptor
+  struct stat	fileinfo;		// File information
+  off_t		offset = 0;		// Starting offset
+  http_status_t	status;			// Status
+
+
+  // Range check input...
+  if (!http || !resource || !filename)
+  {
+    if (http)
+      http->error = EINVAL;
+
+    return (HTTP_STATUS_ERROR);
+  }
+
+  // Create or open the file...
+  if ((fd = open(filename, resume ? O_WRONLY | O_CREAT : O_WRONLY | O_CREAT | O_TRUNC, 0666)) < 0)
+  {
+    // Couldn't open the file!
+    http->error = errno;
+
+    return (HTTP_STATUS_ERROR);
+  }
+
+  if (resume && !fstat(fd, &fileinfo))
+    offset = fileinfo.st_size;
+
+  // Get the file...
+  status = cupsGetFdParallel(http, resource, fd, offset, num_streams);
+
+  // If the file couldn't be gotten, then remove the file unless we are
+  // resuming...
+  close(fd);
+
+  if (status != HTTP_STATUS_OK && !resume)
+    unlink(filename);
+
+  // Return the HTTP status code...
+  return (status);
+}
+
+
 
 //
 // 'cupsPutFd()' - Put a file on the server.
@@ -245,9 +485,12 @@ cupsPutFd(http_t     *http,		// I - Connection to server or @code CUPS_HTTP_DEFA
     if ((http = _cupsConnect()) == NULL)
       return (HTTP_STATUS_SERVICE_UNAVAILABLE);
 
-  // Then send PUT requests to the HTTP server...
+  // Then send PUT requests to the HTTP server, using any cached authentication
+  // for the server...
   retries = 0;
 
+  _cupsSetCachedAuth(http, "PUT", resource);
+
   do
   {
     if (!_cups_strcasecmp(httpGetField(http, HTTP_FIELD_CONNECTION), "close"))
@@ -301,19 +544,21 @@ cupsPutFd(http_t     *http,		// I - Connection to server or @code CUPS_HTTP_DEFA
       // Copy the file...
       lseek(fd, 0, SEEK_SET);
 
-      while ((bytes = read(fd, buffer, sizeof(buffer))) > 0)
+      do
       {
 	if (httpWait(http, 0))
 	{
           if ((status = httpUpdate(http)) != HTTP_STATUS_CONTINUE)
             break;
 	}
-	else if (httpWrite(http, buffer, (size_t)bytes) < 0)
+
+	if ((bytes = _httpWriteFile(http, fd)) < 0)
 	{
 	  status = HTTP_STATUS_ERROR;
 	  break;
 	}
       }
+      while (bytes > 0);
     }
 
     if (status == HTTP_STATUS_CONTINUE)
@@ -452,3 +697,356 @@ cupsPutFile(http_t     *http,		// I - Connection to server or @code CUPS_HTTP_DE
 
   return (status);
 }
+
+//
+// 'cups_get_content_range()' - Get the Content-Range values from a response.
+//
+// Unspecified ("*") values are returned as -1.
+//
+
+static bool				// O - `true` on success, `false` on error
+cups_get_content_range(
+    http_t *http,			// I - HTTP connection
+    off_t  *first,			// O - First byte
+    off_t  *last,			// O - Last byte
+    off_t  *total)			// O - Total length
+{
+  const char	*value;			// Content-Range value
+  char		*ptr;			// Pointer into value
+
+
+  *first = *last = *total = -1;
+
+  if ((value = httpGetField(http, HTTP_FIELD_CONTENT_RANGE)) == NULL || _cups_strncasecmp(value, "bytes ", 6))
+    return (false);
+
+  for (value += 6; *value == ' '; value ++);
+
+  if (*value == '*')
+  {
+    value ++;
+  }
+  else
+  {
+    *first = (off_t)strtoll(value, &ptr, 10);
+    if (ptr == value || *ptr != '-')
+      return (false);
+
+    value  = ptr + 1;
+    *last  = (off_t)strtoll(value, &ptr, 10);
+    if (ptr == value || *last < *first)
+      return (false);
+
+    value = ptr;
+  }
+
+  if (*value != '/')
+    return (false);
+
+  if (value[1] != '*')
+  {
+    *total = (off_t)strtoll(value + 1, &ptr, 10);
+    if (ptr == (value + 1))
+      return (false);
+  }
+
+  return (true);
+}
+
+
+//
+// 'cups_get_request()' - Send a GET request, handling authentication and upgrades.
+//
+
+static http_status_t			// O - HTTP status
+cups_get_request(
+    http_t     *http,			// I - Connection to server
+    const char *resource,		// I - Resource name
+    const char *if_modified_since,	// I - If-Modified-Since value or `NULL`
+    const char *range,			// I - Range value or `NULL`
+    const char *if_range,		// I - If-Range value or `NULL`
+    bool       auth)			// I - Authenticate on 401 responses?
+{
+  http_status_t	status;			// HTTP status from server
+  int		new_auth = 0;		// Using new auth information?
+  int		digest;			// Are we using Digest authentication?
+
+
+  // Send GET requests to the HTTP server, using any cached authentication for
+  // the server...
+  _cupsSetCachedAuth(http, "GET", resource);
+
+  do
+  {
+    if (!_cups_strcasecmp(httpGetField(http, HTTP_FIELD_CONNECTION), "close"))
+    {
+      httpClearFields(http);
+      if (!httpReconnect(http, 30000, NULL))
+      {
+	status = HTTP_STATUS_ERROR;
+	break;
+      }
+    }
+
+    httpClearFields(http);
+    httpSetField(http, HTTP_FIELD_IF_MODIFIED_SINCE, if_modified_since);
+    httpSetField(http, HTTP_FIELD_RANGE, range);
+
+    if (if_range && *if_range)
+      httpSetField(http, HTTP_FIELD_IF_RANGE, if_range);
+
+    digest = http->authstring && !strncmp(http->authstring, "Digest ", 7);
+
+    if (digest && !new_auth)
+    {
+      // Update the Digest authentication string...
+      _httpSetDigestAuthString(http, http->nextnonce, "GET", resource);
+    }
+
+    httpSetField(http, HTTP_FIELD_AUTHORIZATION, http->authstring);
+
+    if (!httpWriteRequest(http, "GET", resource))
+    {
+      if (httpReconnect(http, 30000, NULL))
+      {
+        status = HTTP_STATUS_UNAUTHORIZED;
+        continue;
+      }
+      else
+      {
+        status = HTTP_STATUS_ERROR;
+	break;
+      }
+    }
+
+    new_auth = 0;
+
+    while ((status = httpUpdate(http)) == HTTP_STATUS_CONTINUE);
+
+    if (status == HTTP_STATUS_UNAUTHORIZED)
+    {
+      // Flush any error message...
+      httpFlush(http);
+
+      if (!auth)
+        break;
+
+      // See if we can do authentication...
+      new_auth = 1;
+
+      if (!cupsDoAuthentication(http, "GET", resource))
+      {
+        status = HTTP_STATUS_CUPS_AUTHORIZATION_CANCELED;
+        break;
+      }
+
+      if (!httpReconnect(http, 30000, NULL))
+      {
+        status = HTTP_STATUS_ERROR;
+        break;
+      }
+
+      continue;
+    }
+    else if (status == HTTP_STATUS_UPGRADE_REQUIRED)
+    {
+      // Flush any error message...
+      httpFlush(http);
+
+      // Reconnect...
+      if (!httpReconnect(http, 30000, NULL))
+      {
+        status = HTTP_STATUS_ERROR;
+        break;
+      }
+
+      // Upgrade with encryption...
+      httpSetEncryption(http, HTTP_ENCRYPTION_REQUIRED);
+
+      // Try again, this time with encryption enabled...
+      continue;
+    }
+  }
+  while (status == HTTP_STATUS_UNAUTHORIZED || status == HTTP_STATUS_UPGRADE_REQUIRED);
+
+  return (status);
+}
+
+
+//
+// 'cups_get_segment()' - Get a segment of a resource.
+//
+// The data is written to the file at the same offset as in the resource.
+// For the first segment, a 200 response from a server that does not support
+// ranged requests is accepted and the whole resource replaces the contents of
+// the file, since any data already in the file may be from another version of
+// the resource.
+//
+
+static http_status_t			// O - HTTP status
+cups_get_segment(
+    _cups_get_range_t *range,		// I - Segment
+    bool              first)		// I - First segment?
+{
+  http_t	*http = range->http;	// HTTP connection
+  http_status_t	status;			// HTTP status from server
+  char		value[256],		// Range value
+		buffer[8192];		// Buffer for file
+  ssize_t	bytes;			// Number of bytes read
+  off_t		pos,			// Current position in file
+		rfirst,			// First byte in response
+		rlast;			// Last byte in response
+
+
+  if (range->end >= 0)
+    snprintf(value, sizeof(value), "bytes=%lld-%lld", (long long)range->start, (long long)range->end);
+  else
+    snprintf(value, sizeof(value), "bytes=%lld-", (long long)range->start);
+
+  DEBUG_printf("3cups_get_segment(range=%p(%s), first=%s)", (void *)range, value, first ? "true" : "false");
+
+  status = cups_get_request(http, range->resource, first ? range->if_modified_since : NULL, value, first ? NULL : range->if_range, range->auth);
+
+  if (status == HTTP_STATUS_PARTIAL_CONTENT)
+  {
+    // Validate the range that was returned...
+    if (!cups_get_content_range(http, &rfirst, &rlast, &range->total) || rfirst != range->start || (range->end >= 0 && rlast > range->end))
+    {
+      DEBUG_printf("4cups_get_segment: Bad Content-Range \"%s\".", httpGetField(http, HTTP_FIELD_CONTENT_RANGE));
+      httpFlush(http);
+      return (HTTP_STATUS_ERROR);
+    }
+
+    if (range->end >= 0)
+      range->end = rlast;
+
+    pos = range->start;
+  }
+  else if (status == HTTP_STATUS_OK && first)
+  {
+    // Server ignored the Range field, replace the file with the whole
+    // resource...
+    range->end   = -1;
+    range->total = -1;
+
+    if (range->start > 0)
+    {
+#ifdef _WIN32
+      if (_chsize(range->fd, 0))
+#else
+      if (ftruncate(range->fd, 0))
+#endif // _WIN32
+      {
+        DEBUG_printf("4cups_get_segment: Unable to truncate file: %s", strerror(errno));
+        httpFlush(http);
+        return (HTTP_STATUS_ERROR);
+      }
+
+      range->start = 0;
+    }
+
+    pos = 0;
+  }
+  else
+  {
+    if (status == HTTP_STATUS_RANGE_NOT_SATISFIABLE)
+      cups_get_content_range(http, &rfirst, &rlast, &range->total);
+    else if (status == HTTP_STATUS_OK)
+      status = HTTP_STATUS_PRECONDITION_FAILED;	// Resource changed
+
+    httpFlush(http);
+    return (status);
+  }
+
+  // Copy the data...
+  while ((bytes = httpRead(http, buffer, sizeof(buffer))) > 0)
+  {
+    if (!cups_pwrite(range->fd, buffer, (size_t)bytes, pos))
+    {
+      httpFlush(http);
+      return (HTTP_STATUS_ERROR);
+    }
+
+    pos += bytes;
+  }
+
+  if (bytes < 0 || (range->end >= 0 && pos <= range->end))
+    return (HTTP_STATUS_ERROR);
+
+  return (status);
+}
+
+
+//
+// 'cups_get_thread()' - Get a segment of a resource over a new connection.
+//
+
+static void *				// O - Thread exit status
+cups_get_thread(
+    _cups_get_range_t *range)		// I - Segment
+{
+  http_t	*http;			// HTTP connection
+  char		*data;			// Authorization data
+
+
+  if ((http = httpAcquireConnection(range->host, range->port, AF_UNSPEC, range->encryption, true, 30000, NULL)) == NULL)
+  {
+    range->status = HTTP_STATUS_ERROR;
+    return (NULL);
+  }
+
+  if (range->authstring && (data = strchr(range->authstring, ' ')) != NULL)
+  {
+    *data++ = '\0';
+    httpSetAuthString(http, range->authstring, data);
+  }
+
+  range->http   = http;
+  range->status = cups_get_segment(range, false);
+  range->http   = NULL;
+
+  httpReleaseConnection(http);
+
+  return (NULL);
+}
+
+
+//
+// 'cups_pwrite()' - Write a buffer at the specified offset in a file.
+//
+
+static bool				// O - `true` on success, `false` on error
+cups_pwrite(int        fd,		// I - File descriptor
+	    const char *buffer,		// I - Buffer
+	    size_t     bytes,		// I - Number of bytes
+	    off_t      offset)		// I - Offset in file
+{
+  ssize_t	written;		// Bytes written
+
+
+#ifdef _WIN32
+  if (lseek(fd, offset, SEEK_SET) < 0)
+    return (false);
+#endif // _WIN32
+
+  while (bytes > 0)
+  {
+#ifdef _WIN32
+    if ((written = write(fd, buffer, (unsigned)bytes)) < 0)
+#else
+    if ((written = pwrite(fd, buffer, bytes, offset)) < 0)
+#endif // _WIN32
+    {
+      if (errno == EINTR || errno == EAGAIN)
+        continue;
+
+      return (false);
+    }
+
+    buffer += written;
+    bytes  -= (size_t)written;
+    offset += written;
+  }
+
+  return (true);
+}
@@ -15,6 +15,38 @@
 #endif // !_WIN32
 
 
+//
+// Local types...
+//
+
+typedef union _cups_memhdr_u		// Memory statistics header
+{
+  struct
+  {
+    size_t		size;		// Size of allocation
+    cups_memtype_t	type;		// Type of allocation
+  }			info;		// Allocation information
+  long double		ld;		// Alignment for long double
+  long long		ll;		// Alignment for long long
+  void			*ptr;		// Alignment for pointers
+} _cups_memhdr_t;
+
+
+//
+// Local macros...
+//
+
+#ifdef _WIN32
+#  define CUPS_MEM_ADD(v,n)	((size_t)InterlockedExchangeAdd64((LONG64 volatile *)&(v), (LONG64)(n)) + (size_t)(n))
+#  define CUPS_MEM_CAS(v,o,n)	((size_t)InterlockedCompareExchange64((LONG64 volatile *)&(v), (LONG64)(n), (LONG64)(o)) == (o))
+#  define CUPS_MEM_GET(v)	((size_t)InterlockedCompareExchange64((LONG64 volatile *)&(v), 0, 0))
+#else
+#  define CUPS_MEM_ADD(v,n)	__atomic_add_fetch(&(v), (size_t)(n), __ATOMIC_RELAXED)
+#  define CUPS_MEM_CAS(v,o,n)	__atomic_compare_exchange_n(&(v), &(o), (n), false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)
+#  define CUPS_MEM_GET(v)	__atomic_load_n(&(v), __ATOMIC_RELAXED)
+#endif // _WIN32
+
+
 //
 // Local globals...
 //
@@ -31,6 +63,28 @@ static pthread_once_t	cups_globals_key_once = PTHREAD_ONCE_INIT;
 #endif // !_WIN32
 static cups_mutex_t	cups_global_mutex = CUPS_MUTEX_INITIALIZER;
 					// Global critical section
+#ifndef _WIN32
+static const char	*cups_datadir = NULL,
+					// Data directory
+			*cups_sysconfig = NULL,
+					// System config files
+			*cups_userconfig = NULL;
+					// User-specific config files
+#endif // !_WIN32
+static cups_malloc_cb_t	cups_mem_malloc_cb = NULL;
+					// Allocation callback
+static cups_realloc_cb_t cups_mem_realloc_cb = NULL;
+					// Reallocation callback
+static cups_free_cb_t	cups_mem_free_cb = NULL;
+					// Free callback
+static void		*cups_mem_cb_data = NULL;
+					// Allocator callback data
+static bool		cups_mem_enabled = false;
+					// Collect memory statistics?
+static size_t		cups_mem_used = 0;
+					// Has memory been allocated?
+static cups_memstats_t	cups_mem_stats[CUPS_MEMTYPE_MAX];
+					// Memory statistics
 
 
 //
@@ -45,6 +99,98 @@ static void		cups_globals_free(_cups_globals_t *g);
 #ifndef _WIN32
 static void		cups_globals_init(void);
 #endif // !_WIN32
+static void		cups_mem_add(cups_memtype_t type, size_t size);
+static void		cups_mem_remove(cups_memtype_t type, size_t size);
+
+
+//
+// 'cupsGetMemoryStats()' - Get the memory usage statistics for a subsystem.
+//
+// This function copies the current memory usage statistics for the specified
+// subsystem into "stats".  Statistics are only collected when enabled using
+// the @link cupsSetMemoryStats@ function.
+//
+
+bool					// O - `true` on success, `false` if statistics are not enabled
+cupsGetMemoryStats(
+    cups_memtype_t  type,		// I - Subsystem
+    cups_memstats_t *stats)		// O - Memory usage statistics
+{
+  if (stats)
+    memset(stats, 0, sizeof(cups_memstats_t));
+
+  if (!stats || type < CUPS_MEMTYPE_OTHER || type >= CUPS_MEMTYPE_MAX || !cups_mem_enabled)
+    return (false);
+
+  stats->bytes        = CUPS_MEM_GET(cups_mem_stats[type].bytes);
+  stats->peak_bytes   = CUPS_MEM_GET(cups_mem_stats[type].peak_bytes);
+  stats->allocs       = CUPS_MEM_GET(cups_mem_stats[type].allocs);
+  stats->total_allocs = CUPS_MEM_GET(cups_mem_stats[type].total_allocs);
+
+  return (true);
+}
+
+
+//
+// 'cupsSetAllocator()' - Set the memory allocation functions used by CUPS.
+//
+// This function sets the callbacks used by all CUPS library functions to
+// allocate, reallocate, and free memory.  Passing `NULL` for all three
+// callbacks restores the standard C library functions.
+//
+// The "realloc_cb" callback must accept a `NULL` pointer and the "free_cb"
+// callback must accept a `NULL` pointer.  Memory that the documentation says
+// must be freed using `free` is still allocated using the standard C library.
+//
+// > Note: This function must be called before any other CUPS library
+// > function.  It returns `false` if the callbacks are incomplete or the
+// > library has already allocated memory.
+//
+
+bool					// O - `true` on success, `false` on error
+cupsSetAllocator(
+    cups_malloc_cb_t  malloc_cb,	// I - Allocation callback or `NULL` for default
+    cups_realloc_cb_t realloc_cb,	// I - Reallocation callback or `NULL` for default
+    cups_free_cb_t    free_cb,		// I - Free callback or `NULL` for default
+    void              *cb_data)		// I - Callback data
+{
+  if ((malloc_cb || realloc_cb || free_cb) && (!malloc_cb || !realloc_cb || !free_cb))
+    return (false);
+
+  if (CUPS_MEM_GET(cups_mem_used))
+    return (false);
+
+  cups_mem_malloc_cb  = malloc_cb;
+  cups_mem_realloc_cb = realloc_cb;
+  cups_mem_free_cb    = free_cb;
+  cups_mem_cb_data    = cb_data;
+
+  return (true);
+}
+
+
+//
+// 'cupsSetMemoryStats()' - Enable or disable memory usage statistics.
+//
+// This function enables or disables the collection of per-subsystem memory
+// usage statistics that are reported by the @link cupsGetMemoryStats@
+// function.  Each allocation uses a small amount of additional memory when
+// statistics are enabled.
+//
+// > Note: This function must be called before any other CUPS library
+// > function.  It returns `false` if the library has already allocated memory.
+//
+
+bool					// O - `true` on success, `false` on error
+cupsSetMemoryStats(bool enable)		// I - `true` to collect statistics, `false` otherwise
+{
+  if (CUPS_MEM_GET(cups_mem_used))
+    return (false);
+
+  cups_mem_enabled = enable;
+
+  return (true);
+}
 
 
 //
@@ -97,6 +243,179 @@ _cupsGlobalUnlock(void)
 }
 
 
+//
+// '_cupsMemAlloc()' - Allocate memory.
+//
+
+void *					// O - Pointer to memory or `NULL` on error
+_cupsMemAlloc(cups_memtype_t type,	// I - Subsystem
+              size_t         size)	// I - Number of bytes
+{
+  _cups_memhdr_t	*hdr;		// Memory statistics header
+
+
+  if (!CUPS_MEM_GET(cups_mem_used))
+    CUPS_MEM_ADD(cups_mem_used, 1);
+
+  if (!cups_mem_enabled)
+  {
+    if (cups_mem_malloc_cb)
+      return ((cups_mem_malloc_cb)(cups_mem_cb_data, size));
+    else
+      return (malloc(size));
+  }
+
+  if (size > (SIZE_MAX - sizeof(_cups_memhdr_t)))
+    return (NULL);
+
+  if (cups_mem_malloc_cb)
+    hdr = (cups_mem_malloc_cb)(cups_mem_cb_data, size + sizeof(_cups_memhdr_t));
+  else
+    hdr = malloc(size + sizeof(_cups_memhdr_t));
+
+  if (!hdr)
+    return (NULL);
+
+  hdr->info.size = size;
+  hdr->info.type = type;
+
+  cups_mem_add(type, size);
+
+  return (hdr + 1);
+}
+
+
+//
+// '_cupsMemCalloc()' - Allocate and clear memory.
+//
+
+void *					// O - Pointer to memory or `NULL` on error
+_cupsMemCalloc(cups_memtype_t type,	// I - Subsystem
+               size_t         count,	// I - Number of elements
+               size_t         size)	// I - Size of each element
+{
+  void	*ptr;				// Pointer to memory
+
+
+  if (size && count > (SIZE_MAX / size))
+    return (NULL);
+
+  if (!cups_mem_enabled && !cups_mem_malloc_cb)
+  {
+    // Use calloc so that large allocations can use zeroed pages...
+    if (!CUPS_MEM_GET(cups_mem_used))
+      CUPS_MEM_ADD(cups_mem_used, 1);
+
+    return (calloc(count, size));
+  }
+
+  if ((ptr = _cupsMemAlloc(type, count * size)) != NULL)
+    memset(ptr, 0, count * size);
+
+  return (ptr);
+}
+
+
+//
+// '_cupsMemFree()' - Free memory.
+//
+
+void
+_cupsMemFree(void *ptr)			// I - Pointer to memory
+{
+  _cups_memhdr_t	*hdr;		// Memory statistics header
+
+
+  if (!ptr)
+    return;
+
+  if (cups_mem_enabled)
+  {
+    hdr = (_cups_memhdr_t *)ptr - 1;
+    ptr = hdr;
+
+    cups_mem_remove(hdr->info.type, hdr->info.size);
+  }
+
+  if (cups_mem_free_cb)
+    (cups_mem_free_cb)(cups_mem_cb_data, ptr);
+  else
+    free(ptr);
+}
+
+
+//
+// '_cupsMemRealloc()' - Reallocate memory.
+//
+
+void *					// O - Pointer to memory or `NULL` on error
+_cupsMemRealloc(cups_memtype_t type,	// I - Subsystem
+                void           *ptr,	// I - Pointer to memory or `NULL`
+                size_t         size)	// I - Number of bytes
+{
+  _cups_memhdr_t	*hdr,		// Memory statistics header
+			*newhdr;	// New memory statistics header
+
+
+  if (!ptr)
+    return (_cupsMemAlloc(type, size));
+
+  if (!cups_mem_enabled)
+  {
+    if (cups_mem_realloc_cb)
+      return ((cups_mem_realloc_cb)(cups_mem_cb_data, ptr, size));
+    else
+      return (realloc(ptr, size));
+  }
+
+  if (size > (SIZE_MAX - sizeof(_cups_memhdr_t)))
+    return (NULL);
+
+  hdr = (_cups_memhdr_t *)ptr - 1;
+
+  if (cups_mem_realloc_cb)
+    newhdr = (cups_mem_realloc_cb)(cups_mem_cb_data, hdr, size + sizeof(_cups_memhdr_t));
+  else
+    newhdr = realloc(hdr, size + sizeof(_cups_memhdr_t));
+
+  if (!newhdr)
+    return (NULL);
+
+  cups_mem_remove(newhdr->info.type, newhdr->info.size);
+
+  newhdr->info.size = size;
+  newhdr->info.type = type;
+
+  cups_mem_add(type, size);
+
+  return (newhdr + 1);
+}
+
+
+//
+// '_cupsMemStrdup()' - Duplicate a string.
+//
+
+char *					// O - New string or `NULL` on error
+_cupsMemStrdup(cups_memtype_t type,	// I - Subsystem
+               const char     *s)	// I - String
+{
+  char		*news;			// New string
+  size_t	len;			// Length of string
+
+
+  if (!s)
+    return (NULL);
+
+  len = strlen(s) + 1;
+
+  if ((news = _cupsMemAlloc(type, len)) != NULL)
+    memcpy(news, s, len);
+
+  return (news);
+}
+
+
 #ifdef _WIN32
 //
 // 'DllMain()' - Main entry for library.
@@ -119,6 +438,7 @@ DllMain(HINSTANCE hinst,		// I - DLL module handle
   {
     case DLL_PROCESS_ATTACH :		// Called on library initialization
         InitializeCriticalSection(&cups_global_mutex);
+        cupsMutexSetName(&cups_global_mutex, "cups_global_mutex");
 
         if ((cups_globals_key = TlsAlloc()) == TLS_OUT_OF_INDEXES)
           return (FALSE);
@@ -153,7 +473,7 @@ DllMain(HINSTANCE hinst,		// I - DLL module handle
 static _cups_globals_t *		// O - Pointer to global data
 cups_globals_alloc(void)
 {
-  _cups_globals_t *cg = malloc(sizeof(_cups_globals_t));
+  _cups_globals_t *cg = _cupsMemAlloc(CUPS_MEMTYPE_OTHER, sizeof(_cups_globals_t));
 					// Pointer to global data
 #ifdef _WIN32
   HKEY		key;			// Registry key
@@ -248,6 +568,66 @@ cups_globals_alloc(void)
   cg->userconfig = userconfig;
 
 #else
+  // Use the directories shared by all threads...
+  cg->datadir    = cups_datadir;
+  cg->sysconfig  = cups_sysconfig;
+  cg->userconfig = cups_userconfig;
+#endif // _WIN32
+
+  return (cg);
+}
+
+
+//
+// 'cups_globals_free()' - Free global data.
+//
+
+static void
+cups_globals_free(_cups_globals_t *cg)	// I - Pointer to global data
+{
+  _cups_buffer_t	*buffer,	// Current read/write buffer
+			*next;		// Next buffer
+
+
+  if (cg->last_status_message)
+    _cupsStrFree(cg->last_status_message);
+
+  for (buffer = cg->cups_buffers; buffer; buffer = next)
+  {
+    next = buffer->next;
+    _cupsMemFree(buffer);
+  }
+
+  httpReleaseConnection(cg->http);
+
+  _httpFreeCredentials(cg->credentials);
+
+  cupsFileClose(cg->stdio_files[0]);
+  cupsFileClose(cg->stdio_files[1]);
+  cupsFileClose(cg->stdio_files[2]);
+
+  _cupsMemFree(cg->pwg_custom);
+  _cupsMemFree(cg->raster_error.start);
+
+#ifdef DEBUG
+  _cups_debug_release(cg->debug_trace);
+#endif // DEBUG
+
+  _cupsMemFree(cg);
+}
+
+
+#ifndef _WIN32
+//
+// 'cups_globals_init()' - Initialize the data shared by all threads.
+//
+// The data and configuration directories do not change for the life of the
+// process, so they are determined once rather than for each thread.
+//
+
+static void
+cups_globals_init(void)
+{
   const char	*home = getenv("HOME");	// HOME environment variable
   char		homedir[1024],		// Home directory from account
 		temp[1024];		// Temporary directory string
@@ -265,17 +645,17 @@ cups_globals_alloc(void)
   {
     // When running setuid/setgid, don't allow environment variables to override
     // the system directories...
-    cg->datadir   = CUPS_DATADIR;
-    cg->sysconfig = CUPS_SERVERROOT;
+    cups_datadir   = CUPS_DATADIR;
+    cups_sysconfig = CUPS_SERVERROOT;
   }
   else
   {
     // Allow directories to be overridden by environment variables.
-    if ((cg->datadir = getenv("CUPS_DATADIR")) == NULL)
-      cg->datadir = CUPS_DATADIR;
+    if ((cups_datadir = getenv("CUPS_DATADIR")) == NULL)
+      cups_datadir = CUPS_DATADIR;
 
-    if ((cg->sysconfig = getenv("CUPS_SERVERROOT")) == NULL)
-      cg->sysconfig = CUPS_SERVERROOT;
+    if ((cups_sysconfig = getenv("CUPS_SERVERROOT")) == NULL)
+      cups_sysconfig = CUPS_SERVERROOT;
   }
 
 #  ifdef __APPLE__
@@ -285,13 +665,19 @@ cups_globals_alloc(void)
 #  endif // __APPLE__
   {
     struct passwd	pw;		// User info
-    struct passwd	*result;	// Auxiliary pointer
+    struct passwd	*result = NULL;	// Auxiliary pointer
+    char		*pw_buf;	// Buffer for user info
 
-    getpwuid_r(getuid(), &pw, cg->pw_buf, PW_BUF_SIZE, &result);
-    if (result)
+    if ((pw_buf = malloc(PW_BUF_SIZE)) != NULL)
     {
-      cupsCopyString(homedir, pw.pw_dir, sizeof(homedir));
-      home = homedir;
+      getpwuid_r(getuid(), &pw, pw_buf, PW_BUF_SIZE, &result);
+      if (result)
+      {
+	cupsCopyString(homedir, pw.pw_dir, sizeof(homedir));
+	home = homedir;
+      }
+
+      free(pw_buf);
     }
   }
 
@@ -333,60 +719,63 @@ cups_globals_alloc(void)
 #  endif // __APPLE__
 
   // Can't use _cupsStrAlloc since it causes a loop with debug logging enabled
-  cg->userconfig = strdup(temp);
-#endif // _WIN32
+  cups_userconfig = strdup(temp);
 
-  return (cg);
+  // Register the global data for this thread...
+  pthread_key_create(&cups_globals_key, (void (*)(void *))cups_globals_free);
+
+  cupsMutexSetName(&cups_global_mutex, "cups_global_mutex");
 }
+#endif // !_WIN32
 
 
 //
-// 'cups_globals_free()' - Free global data.
+// 'cups_mem_add()' - Record an allocation.
 //
 
 static void
-cups_globals_free(_cups_globals_t *cg)	// I - Pointer to global data
+cups_mem_add(cups_memtype_t type,	// I - Subsystem
+             size_t         size)	// I - Number of bytes
 {
-  _cups_buffer_t	*buffer,	// Current read/write buffer
-			*next;		// Next buffer
-
-
-  if (cg->last_status_message)
-    _cupsStrFree(cg->last_status_message);
+  cups_memstats_t	*stats;		// Subsystem statistics
+  size_t		bytes,		// Current bytes
+			peak;		// Peak bytes
 
-  for (buffer = cg->cups_buffers; buffer; buffer = next)
-  {
-    next = buffer->next;
-    free(buffer);
-  }
-
-  cupsArrayDelete(cg->leg_size_lut);
-  cupsArrayDelete(cg->ppd_size_lut);
-  cupsArrayDelete(cg->pwg_size_lut);
 
-  httpClose(cg->http);
+  if (type < CUPS_MEMTYPE_OTHER || type >= CUPS_MEMTYPE_MAX)
+    type = CUPS_MEMTYPE_OTHER;
 
-  _httpFreeCredentials(cg->credentials);
+  stats = cups_mem_stats + type;
+  bytes = CUPS_MEM_ADD(stats->bytes, size);
 
-  cupsFileClose(cg->stdio_files[0]);
-  cupsFileClose(cg->stdio_files[1]);
-  cupsFileClose(cg->stdio_files[2]);
+  CUPS_MEM_ADD(stats->allocs, 1);
+  CUPS_MEM_ADD(stats->total_allocs, 1);
 
-  free(cg->userconfig);
-  free(cg->raster_error.start);
-  free(cg);
+  // Update the peak usage, handling concurrent updates from other threads...
+  for (peak = CUPS_MEM_GET(stats->peak_bytes); bytes > peak; peak = CUPS_MEM_GET(stats->peak_bytes))
+  {
+    if (CUPS_MEM_CAS(stats->peak_bytes, peak, bytes))
+      break;
+  }
 }
 
 
-#ifndef _WIN32
 //
-// 'cups_globals_init()' - Initialize environment variables.
+// 'cups_mem_remove()' - Record a free.
 //
 
 static void
-cups_globals_init(void)
+cups_mem_remove(cups_memtype_t type,	// I - Subsystem
+                size_t         size)	// I - Number of bytes
 {
-  // Register the global data for this thread...
-  pthread_key_create(&cups_globals_key, (void (*)(void *))cups_globals_free);
+  cups_memstats_t	*stats;		// Subsystem statistics
+
+
+  if (type < CUPS_MEMTYPE_OTHER || type >= CUPS_MEMTYPE_MAX)
+    type = CUPS_MEMTYPE_OTHER;
+
+  stats = cups_mem_stats + type;
+
+  CUPS_MEM_ADD(stats->bytes, 0 - size);
+  CUPS_MEM_ADD(stats->allocs, (size_t)-1);
 }
-#endif // !_WIN32
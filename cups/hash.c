@@ -27,11 +27,34 @@
 // implementations over some imaginary notion of "guaranteed security"...
 //
 
+//
+// Private types...
+//
+
+struct _cups_hash_s			// Incremental hash/HMAC context
+{
+  char		algorithm[16];		// Algorithm name
+  size_t	blocksize;		// HMAC block size or `0` for a plain hash
+  unsigned char	opad[128];		// HMAC outer key block (K' ^ opad)
+  bool		is_md5;			// Use the built-in MD5 implementation?
+  _cups_md5_state_t md5;		// MD5 state
+#ifdef HAVE_OPENSSL
+  EVP_MD_CTX	*ctx;			// Message digest context
+#else // HAVE_GNUTLS
+  gnutls_hash_hd_t ctx;			// Hash context
+  unsigned	hashlen;		// Length of hash
+#endif // HAVE_OPENSSL
+};
+
+
 //
 // Local functions...
 //
 
 static ssize_t	hash_data(const char *algorithm, unsigned char *hash, size_t hashsize, const void *a, size_t alen, const void *b, size_t blen);
+static ssize_t	hash_finish(cups_hash_t *ctx, unsigned char *hash, size_t hashsize);
+static bool	hash_init(cups_hash_t *ctx, const char *algorithm);
+static void	hash_update(cups_hash_t *ctx, const void *data, size_t datalen);
 
 
 //
@@ -65,6 +88,95 @@ cupsHashData(const char    *algorithm,	// I - Algorithm name
 }
 
 
+//
+// 'cupsHashFinish()' - Finish an incremental hash or HMAC.
+//
+// This function stores the hash or HMAC of the data passed to
+// @link cupsHashUpdate@ in the "hash" buffer and frees the context.  The "hash"
+// argument points to a buffer of "hashsize" bytes and should be at least 64
+// bytes in length for all of the supported algorithms.  Pass `NULL` for "hash"
+// to discard the context without computing a result.
+//
+// The returned hash is binary data.
+//
+
+ssize_t					// O - Size of hash or `-1` on error
+cupsHashFinish(cups_hash_t   *ctx,	// I - Hash context
+               unsigned char *hash,	// I - Hash buffer or `NULL` to discard
+               size_t        hashsize)	// I - Size of hash buffer
+{
+  ssize_t	ret;			// Return value
+  unsigned char	inner[64];		// Inner HMAC hash
+
+
+  if (!ctx)
+  {
+    _cupsSetError(IPP_STATUS_ERROR_INTERNAL, _("Bad arguments to function"), 1);
+    return (-1);
+  }
+
+  if (hash && ctx->blocksize)
+  {
+    // HMAC = H(K' ^ opad, H(K' ^ ipad, data))
+    if ((ret = hash_finish(ctx, inner, sizeof(inner))) >= 0 && hash_init(ctx, ctx->algorithm))
+    {
+      hash_update(ctx, ctx->opad, ctx->blocksize);
+      hash_update(ctx, inner, (size_t)ret);
+    }
+    else
+    {
+      _cupsMemFree(ctx);
+      return (-1);
+    }
+  }
+
+  ret = hash_finish(ctx, hash, hashsize);
+
+  _cupsMemFree(ctx);
+
+  return (ret);
+}
+
+
+//
+// 'cupsHashInit()' - Start an incremental hash.
+//
+// This function creates a context for hashing data that is not available in a
+// single buffer.  The "algorithm" argument can be any of the algorithms
+// supported by @link cupsHashData@.  Data is added with @link cupsHashUpdate@
+// and the final hash is returned by @link cupsHashFinish@.
+//
+
+cups_hash_t *				// O - Hash context or `NULL` on error
+cupsHashInit(const char *algorithm)	// I - Algorithm name
+{
+  cups_hash_t	*ctx;			// Hash context
+
+
+  if (!algorithm)
+  {
+    _cupsSetError(IPP_STATUS_ERROR_INTERNAL, _("Bad arguments to function"), 1);
+    return (NULL);
+  }
+
+  if ((ctx = _cupsMemCalloc(CUPS_MEMTYPE_OTHER, 1, sizeof(cups_hash_t))) == NULL)
+  {
+    _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(errno), 0);
+    return (NULL);
+  }
+
+  if (!hash_init(ctx, algorithm))
+  {
+    _cupsMemFree(ctx);
+    return (NULL);
+  }
+
+  cupsCopyString(ctx->algorithm, algorithm, sizeof(ctx->algorithm));
+
+  return (ctx);
+}
+
+
 //
 // 'cupsHashString()' - Format a hash value as a hexadecimal string.
 //
@@ -180,6 +292,96 @@ cupsHMACData(
 }
 
 
+//
+// 'cupsHashUpdate()' - Add data to an incremental hash or HMAC.
+//
+
+bool					// O - `true` on success, `false` on error
+cupsHashUpdate(cups_hash_t *ctx,	// I - Hash context
+               const void  *data,	// I - Data to hash
+               size_t      datalen)	// I - Length of data to hash
+{
+  if (!ctx || (!data && datalen > 0))
+    return (false);
+
+  if (datalen > 0)
+    hash_update(ctx, data, datalen);
+
+  return (true);
+}
+
+
+//
+// 'cupsHMACInit()' - Start an incremental HMAC.
+//
+// This function creates a context for computing the HMAC of data that is not
+// available in a single buffer.  The "algorithm" argument can be any of the
+// algorithms supported by @link cupsHMACData@.  Data is added with
+// @link cupsHashUpdate@ and the final HMAC is returned by
+// @link cupsHashFinish@.
+//
+
+cups_hash_t *				// O - Hash context or `NULL` on error
+cupsHMACInit(
+    const char          *algorithm,	// I - Hash algorithm
+    const unsigned char *key,		// I - Key
+    size_t              keylen)		// I - Length of key
+{
+  cups_hash_t	*ctx;			// Hash context
+  size_t	i,			// Looping var
+		b;			// Block size
+  unsigned char	buffer[128],		// Inner key block
+		hkey[128];		// Hashed key buffer
+  ssize_t	hashlen;		// Length of hash
+
+
+  // Range check input...
+  if (!algorithm || !key || keylen == 0)
+  {
+    _cupsSetError(IPP_STATUS_ERROR_INTERNAL, _("Bad arguments to function"), 1);
+    return (NULL);
+  }
+
+  // Determine the block size...
+  if (!strcmp(algorithm, "sha2-384") || !strncmp(algorithm, "sha2-512", 8))
+    b = 128;
+  else
+    b = 64;
+
+  // If the key length is larger than the block size, hash it and use that
+  // instead...
+  if (keylen > b)
+  {
+    if ((hashlen = hash_data(algorithm, hkey, sizeof(hkey), key, keylen, NULL, 0)) < 0)
+      return (NULL);
+
+    key    = hkey;
+    keylen = (size_t)hashlen;
+  }
+
+  if ((ctx = cupsHashInit(algorithm)) == NULL)
+    return (NULL);
+
+  // Start the inner hash with K' ^ ipad and save K' ^ opad for the outer
+  // hash...
+  for (i = 0; i < b && i < keylen; i ++)
+  {
+    buffer[i]    = key[i] ^ 0x36;
+    ctx->opad[i] = key[i] ^ 0x5c;
+  }
+  for (; i < b; i ++)
+  {
+    buffer[i]    = 0x36;
+    ctx->opad[i] = 0x5c;
+  }
+
+  ctx->blocksize = b;
+  hash_update(ctx, buffer, b);
+
+  return (ctx);
+}
+
+
 //
 // 'hash_data()' - Hash up to two blocks of data.
 //
@@ -192,34 +394,88 @@ hash_data(const char    *algorithm,	// I - Algorithm
           size_t        alen,		// I - Length of first block
           const void    *b,		// I - Second block or `NULL` for none
           size_t        blen)		// I - Length of second block or `0` for none
+{
+  cups_hash_t	ctx;			// Hash context
+
+
+  if (!hash_init(&ctx, algorithm))
+    return (-1);
+
+  hash_update(&ctx, a, alen);
+  if (b && blen)
+    hash_update(&ctx, b, blen);
+
+  return (hash_finish(&ctx, hash, hashsize));
+}
+
+
+//
+// 'hash_finish()' - Finish a hash and free the digest context.
+//
+
+static ssize_t				// O - Size of hash or `-1` on error
+hash_finish(cups_hash_t   *ctx,		// I - Hash context
+            unsigned char *hash,	// I - Hash buffer or `NULL` to discard
+            size_t        hashsize)	// I - Size of hash buffer
 {
   unsigned	hashlen;		// Length of hash
   unsigned char	hashtemp[64];		// Temporary hash buffer
+
+
+  if (ctx->is_md5)
+  {
+    _cupsMD5Finish(&ctx->md5, hashtemp);
+    hashlen = 16;
+  }
+  else
+  {
+#ifdef HAVE_OPENSSL
+    EVP_DigestFinal(ctx->ctx, hashtemp, &hashlen);
+    EVP_MD_CTX_free(ctx->ctx);
+#else // HAVE_GNUTLS
+    gnutls_hash_deinit(ctx->ctx, hashtemp);
+    hashlen = ctx->hashlen;
+#endif // HAVE_OPENSSL
+  }
+
+  if (!hash)
+    return (0);
+
+  if (hashlen > hashsize)
+  {
+    _cupsSetError(IPP_STATUS_ERROR_INTERNAL, _("Hash buffer too small."), 1);
+    return (-1);
+  }
+
+  memcpy(hash, hashtemp, hashlen);
+
+  return ((ssize_t)hashlen);
+}
+
+
+//
+// 'hash_init()' - Initialize a hash context.
+//
+
+static bool				// O - `true` on success, `false` on error
+hash_init(cups_hash_t *ctx,		// I - Hash context
+          const char  *algorithm)	// I - Algorithm name
+{
 #ifdef HAVE_OPENSSL
   const EVP_MD	*md = NULL;		// Message digest implementation
-  EVP_MD_CTX	*ctx;			// Context
 #else // HAVE_GNUTLS
   gnutls_digest_algorithm_t alg = GNUTLS_DIG_UNKNOWN;
 					// Algorithm
-  gnutls_hash_hd_t ctx;			// Context
 #endif // HAVE_OPENSSL
 
 
   if (!strcmp(algorithm, "md5"))
   {
     // Some versions of GNU TLS and OpenSSL disable MD5 without warning...
-    _cups_md5_state_t	state;		// MD5 state info
+    ctx->is_md5 = true;
+    _cupsMD5Init(&ctx->md5);
 
-    if (hashsize < 16)
-      goto too_small;
-
-    _cupsMD5Init(&state);
-    _cupsMD5Append(&state, a, (int)alen);
-    if (b && blen)
-      _cupsMD5Append(&state, b, (int)blen);
-    _cupsMD5Finish(&state, hash);
-
-    return (16);
+    return (true);
   }
 
 #ifdef HAVE_OPENSSL
@@ -245,21 +501,12 @@ hash_data(const char    *algorithm,	// I - Algorithm
     md = EVP_sha512();
   }
 
-  if (md)
+  if (md && (ctx->ctx = EVP_MD_CTX_new()) != NULL)
   {
-    ctx = EVP_MD_CTX_new();
-    EVP_DigestInit(ctx, md);
-    EVP_DigestUpdate(ctx, a, alen);
-    if (b && blen)
-      EVP_DigestUpdate(ctx, b, blen);
-    EVP_DigestFinal(ctx, hashtemp, &hashlen);
-
-    if (hashlen > hashsize)
-      goto too_small;
+    ctx->is_md5 = false;
+    EVP_DigestInit(ctx->ctx, md);
 
-    memcpy(hash, hashtemp, hashlen);
-
-    return ((ssize_t)hashlen);
+    return (true);
   }
 
 #else // HAVE_GNUTLS
@@ -285,34 +532,52 @@ hash_data(const char    *algorithm,	// I - Algorithm
     alg = GNUTLS_DIG_SHA512;
   }
 
-  if (alg != GNUTLS_DIG_UNKNOWN)
+  if (alg != GNUTLS_DIG_UNKNOWN && !gnutls_hash_init(&ctx->ctx, alg))
   {
-    hashlen = gnutls_hash_get_len(alg);
-
-    if (hashlen > hashsize)
-      goto too_small;
-
-    gnutls_hash_init(&ctx, alg);
-    gnutls_hash(ctx, a, alen);
-    if (b && blen)
-      gnutls_hash(ctx, b, blen);
-    gnutls_hash_deinit(ctx, hashtemp);
+    ctx->is_md5  = false;
+    ctx->hashlen = gnutls_hash_get_len(alg);
 
-    memcpy(hash, hashtemp, hashlen);
-
-    return ((ssize_t)hashlen);
+    return (true);
   }
 #endif // HAVE_OPENSSL
 
   // Unknown hash algorithm...
   _cupsSetError(IPP_STATUS_ERROR_INTERNAL, _("Unknown hash algorithm."), 1);
 
-  return (-1);
+  return (false);
+}
 
-  // We get here if the buffer is too small.
-  too_small:
 
-  _cupsSetError(IPP_STATUS_ERROR_INTERNAL, _("Hash buffer too small."), 1);
-  return (-1);
-}
+//
+// 'hash_update()' - Add data to a hash.
+//
 
+static void
+hash_update(cups_hash_t *ctx,		// I - Hash context
+            const void  *data,		// I - Data
+            size_t      datalen)	// I - Length of data
+{
+  if (ctx->is_md5)
+  {
+    const unsigned char *ptr = (const unsigned char *)data;
+					// Pointer into data
+
+    // The MD5 implementation uses an int length...
+    while (datalen > INT_MAX)
+    {
+      _cupsMD5Append(&ctx->md5, ptr, INT_MAX);
+      ptr     += INT_MAX;
+      datalen -= INT_MAX;
+    }
+
+    _cupsMD5Append(&ctx->md5, ptr, (int)datalen);
+  }
+  else
+  {
+#ifdef HAVE_OPENSSL
+    EVP_DigestUpdate(ctx->ctx, data, datalen);
+#else // HAVE_GNUTLS
+    gnutls_hash(ctx->ctx, data, datalen);
+#endif // HAVE_OPENSSL
+  }
+}
@@ -22,6 +22,29 @@
 #endif // __APPLE__
 
 
+//
+// Local globals...
+//
+
+static cups_mutex_t	http_hostname_mutex = CUPS_MUTEX_INITIALIZER;
+					// Mutex for cached hostname
+static size_t		http_hostname_changes = 0,
+					// Number of hostname/network changes
+			http_hostname_cached = 0;
+					// Changes when hostname was cached
+static char		http_hostname_key[256] = "",
+					// Local hostname from gethostname()
+			http_hostname_fqdn[256] = "";
+					// Cached FQDN for local hostname
+
+
+//
+// Local functions...
+//
+
+static int	http_addr_listen(http_addr_t *addr, int port, bool multiple);
+
+
 //
 // 'httpAddrClose()' - Close a socket created by @link httpAddrConnect@ or
 //                     @link httpAddrListen@.
@@ -295,107 +318,98 @@ int					// O - Socket or `-1` on error
 httpAddrListen(http_addr_t *addr,	// I - Address to bind to
                int         port)	// I - Port number to bind to
 {
-  int		fd = -1,		// Socket
-		val,			// Socket value
-                status;			// Bind status
-
-
   // Range check input...
   if (!addr || port < 0)
     return (-1);
 
-  // Make sure the network stack is initialized...
-  httpInitialize();
+  return (http_addr_listen(addr, port, false));
+}
 
-  // Create the socket and set options...
-  if ((fd = socket(addr->addr.sa_family, SOCK_STREAM, 0)) < 0)
-  {
-    _cupsSetHTTPError(HTTP_STATUS_ERROR);
-    return (-1);
-  }
 
-  val = 1;
-  if (setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, CUPS_SOCAST &val, sizeof(val)))
-    DEBUG_printf("2httpAddrListen: setsockopt(SO_REUSEADDR) failed: %s", strerror(errno));
+//
+// 'httpAddrListenMultiple()' - Create multiple listening sockets bound to the
+//                              same address and port.
+//
+// This function creates "num_fds" listening sockets for the same address and
+// port using the `SO_REUSEPORT` socket option, allowing a server to accept
+// connections on several threads.  The kernel distributes new connections
+// between the sockets.
+//
+// The sockets are non-blocking so that @link httpAcceptConnections@ can accept
+// all pending connections on a socket.  If "port" is `0`, all of the sockets
+// use the port number assigned to the first socket.
+//
+// Multiple listening sockets are not supported for domain sockets or on
+// platforms without `SO_REUSEPORT`.
+//
 
-#ifdef IPV6_V6ONLY
-  if (addr->addr.sa_family == AF_INET6)
+size_t					// O - Number of sockets created (`num_fds` on success, `0` on error)
+httpAddrListenMultiple(
+    http_addr_t *addr,			// I - Address to bind to
+    int         port,			// I - Port number to bind to
+    size_t      num_fds,		// I - Number of sockets to create
+    int         *fds)			// O - Sockets
+{
+#ifdef SO_REUSEPORT
+  size_t	i;			// Looping var
+#endif // SO_REUSEPORT
+
+
+  // Range check input...
+  if (!addr || port < 0 || num_fds == 0 || !fds)
   {
-    if (setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, CUPS_SOCAST &val, sizeof(val)))
-      DEBUG_printf("2httpAddrListen: setsockopt(IPv6_V6ONLY) failed: %s", strerror(errno));
+    _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(EINVAL), 0);
+    return (0);
   }
-#endif // IPV6_V6ONLY
 
-  // Bind the socket...
-#ifdef AF_LOCAL
-  if (addr->addr.sa_family == AF_LOCAL)
+#ifdef SO_REUSEPORT
+#  ifdef AF_LOCAL
+  if (addr->addr.sa_family == AF_LOCAL && num_fds > 1)
   {
-    mode_t	mask;			// Umask setting
+    _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(EINVAL), 0);
+    return (0);
+  }
+#  endif // AF_LOCAL
 
-    // Remove any existing domain socket file...
-    if ((status = unlink(addr->un.sun_path)) < 0)
+  for (i = 0; i < num_fds; i ++)
+  {
+    if ((fds[i] = http_addr_listen(addr, port, true)) < 0)
     {
-      if (errno == ENOENT)
-        status = 0;
-      else
-        DEBUG_printf("2httpAddrListen: Unable to unlink '%s': %s",
-addr->un.sun_path, strerror(errno));
+      while (i > 0)
+      {
+        i --;
+        httpAddrClose(NULL, fds[i]);
+      }
+
+      return (0);
     }
 
-    if (!status)
+    if (i == 0 && port == 0)
     {
-      // Save the current umask and set it to 0 so that all users can access
-      // the domain socket...
-      mask = umask(0);
-
-      // Bind the domain socket...
-      status = bind(fd, (struct sockaddr *)addr, (socklen_t)httpAddrGetLength(addr));
+      // Use the assigned port number for the remaining sockets...
+      http_addr_t	temp;		// Socket address
+      socklen_t		templen = sizeof(temp);
+					// Length of socket address
 
-      // Restore the umask and fix permissions...
-      umask(mask);
+      if (!getsockname(fds[0], (struct sockaddr *)&temp, &templen))
+        port = httpAddrGetPort(&temp);
     }
   }
-  else
-#endif // AF_LOCAL
-  {
-    httpAddrSetPort(addr, port);
-
-    status = bind(fd, (struct sockaddr *)addr, (socklen_t)httpAddrGetLength(addr));
-  }
 
-  if (status)
-  {
-    _cupsSetHTTPError(HTTP_STATUS_ERROR);
-
-    close(fd);
-
-    return (-1);
-  }
+  return (num_fds);
 
-  // Listen...
-  if (listen(fd, INT_MAX))
+#else
+  if (num_fds > 1)
   {
-    _cupsSetHTTPError(HTTP_STATUS_ERROR);
-
-    close(fd);
-
-    return (-1);
+    _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(ENOTSUP), 0);
+    return (0);
   }
 
-  // Close on exec...
-#ifndef _WIN32
-  if (fcntl(fd, F_SETFD, fcntl(fd, F_GETFD) | FD_CLOEXEC))
-    DEBUG_printf("2httpAddrListen: fcntl(F_SETFD, FD_CLOEXEC) failed: %s", strerror(errno));
-#endif // !_WIN32
-
-#ifdef SO_NOSIGPIPE
-  // Disable SIGPIPE for this socket.
-  val = 1;
-  if (setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, CUPS_SOCAST &val, sizeof(val)))
-    DEBUG_printf("2httpAddrListen: setsockopt(SO_NOSIGPIPE) failed: %s", strerror(errno));
-#endif // SO_NOSIGPIPE
+  if ((fds[0] = http_addr_listen(addr, port, true)) < 0)
+    return (0);
 
-  return (fd);
+  return (1);
+#endif // SO_REUSEPORT
 }
 
 
@@ -479,7 +493,9 @@ httpAddrLookup(
 // was used in the call to @link httpConnect@ or the address of the client for
 // the connection from @link httpAcceptConnection@.
 //
-// When "http" is `NULL`, return the FQDN for the local system.
+// When "http" is `NULL`, return the FQDN for the local system.  The FQDN is
+// cached until the local hostname changes or a DNS-SD context reports a
+// hostname or network change.
 //
 
 const char *				// O - FQDN for connection or system
@@ -505,13 +521,33 @@ httpGetHostname(http_t *http,		// I - HTTP connection or NULL
   else
   {
     // Return the hostname...
+    char	name[256],		// Local hostname
+		fqdn[256],		// FQDN for local hostname
+		*ptr;			// Pointer into FQDN
+    size_t	changes;		// Number of hostname/network changes
+
     if (!s || slen <= 1)
       return (NULL);
 
-    if (gethostname(s, (size_t)slen) < 0)
-      cupsCopyString(s, "localhost", (size_t)slen);
+    if (gethostname(name, sizeof(name)) < 0)
+      cupsCopyString(name, "localhost", sizeof(name));
+    else
+      name[sizeof(name) - 1] = '\0';
+
+    // Use the cached FQDN if the hostname and network have not changed...
+    cupsMutexLock(&http_hostname_mutex);
+    changes = http_hostname_changes;
+    if (http_hostname_fqdn[0] && http_hostname_cached == changes && !strcmp(name, http_hostname_key))
+    {
+      cupsCopyString(s, http_hostname_fqdn, slen);
+      cupsMutexUnlock(&http_hostname_mutex);
+      return (s);
+    }
+    cupsMutexUnlock(&http_hostname_mutex);
 
-    if (!strchr(s, '.'))
+    cupsCopyString(fqdn, name, sizeof(fqdn));
+
+    if (!strchr(fqdn, '.'))
     {
 #ifdef HAVE_SCDYNAMICSTORECOPYCOMPUTERNAME
       // The hostname is not a FQDN, so use the local hostname from the
@@ -527,7 +563,7 @@ httpGetHostname(http_t *http,		// I - HTTP connection or NULL
                                       kCFStringEncodingUTF8))
       {
         // Append ".local." to the hostname we get...
-        snprintf(s, (size_t)slen, "%s.local.", localStr);
+        snprintf(fqdn, sizeof(fqdn), "%s.local.", localStr);
       }
 
       if (local)
@@ -539,17 +575,30 @@ httpGetHostname(http_t *http,		// I - HTTP connection or NULL
       // The hostname is not a FQDN, so look it up...
       struct hostent	*host;		// Host entry to get FQDN
 
-      if ((host = gethostbyname(s)) != NULL && host->h_name)
+      if ((host = gethostbyname(fqdn)) != NULL && host->h_name)
       {
         // Use the resolved hostname...
-	cupsCopyString(s, host->h_name, (size_t)slen);
+	cupsCopyString(fqdn, host->h_name, sizeof(fqdn));
       }
 #endif // HAVE_SCDYNAMICSTORECOPYCOMPUTERNAME
     }
 
     // Make sure .local hostnames end with a period...
-    if (strlen(s) > 6 && !strcmp(s + strlen(s) - 6, ".local"))
-      cupsConcatString(s, ".", (size_t)slen);
+    if (strlen(fqdn) > 6 && !strcmp(fqdn + strlen(fqdn) - 6, ".local"))
+      cupsConcatString(fqdn, ".", sizeof(fqdn));
+
+    // Convert the hostname to lowercase and cache it...
+    for (ptr = fqdn; *ptr; ptr ++)
+      *ptr = (char)_cups_tolower((int)*ptr);
+
+    cupsMutexLock(&http_hostname_mutex);
+    cupsCopyString(http_hostname_key, name, sizeof(http_hostname_key));
+    cupsCopyString(http_hostname_fqdn, fqdn, sizeof(http_hostname_fqdn));
+    http_hostname_cached = changes;
+    cupsMutexUnlock(&http_hostname_mutex);
+
+    cupsCopyString(s, fqdn, slen);
+    return (s);
   }
 
   // Convert the hostname to lowercase as needed...
@@ -579,10 +628,13 @@ httpResolveHostname(http_t *http,	// I - HTTP connection
   if (!http)
     return (NULL);
 
-  if (isdigit(http->hostname[0] & 255) || http->hostname[0] == '[')
+  if (!http->resolved && (isdigit(http->hostname[0] & 255) || http->hostname[0] == '['))
   {
+    // Only do the (slow) reverse lookup once per connection...
     char	temp[1024];		// Temporary string
 
+    http->resolved = true;
+
     if (httpAddrLookup(http->hostaddr, temp, sizeof(temp)))
       cupsCopyString(http->hostname, temp, sizeof(http->hostname));
     else
@@ -624,3 +676,142 @@ httpAddrSetPort(http_addr_t *addr,	// I - Address
   if (addr->addr.sa_family == AF_INET)
     addr->ipv4.sin_port = htons(port);
 }
+
+
+//
+// '_httpHostnameChanged()' - Note that the local hostname or network changed.
+//
+// This function invalidates the FQDN cached by @link httpGetHostname@.  It is
+// called by the DNS-SD code whenever the configuration change count is
+// incremented.
+//
+
+void
+_httpHostnameChanged(void)
+{
+  cupsMutexLock(&http_hostname_mutex);
+  http_hostname_changes ++;
+  cupsMutexUnlock(&http_hostname_mutex);
+}
+
+
+//
+// 'http_addr_listen()' - Create a listening socket.
+//
+
+static int				// O - Socket or `-1` on error
+http_addr_listen(http_addr_t *addr,	// I - Address to bind to
+                 int         port,	// I - Port number to bind to
+                 bool        multiple)	// I - Allow multiple listeners for the address?
+{
+  int		fd = -1,		// Socket
+		val,			// Socket value
+                status;			// Bind status
+
+
+  // Make sure the network stack is initialized...
+  httpInitialize();
+
+  // Create the socket and set options...
+  if ((fd = socket(addr->addr.sa_family, SOCK_STREAM, 0)) < 0)
+  {
+    _cupsSetHTTPError(HTTP_STATUS_ERROR);
+    return (-1);
+  }
+
+  val = 1;
+  if (setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, CUPS_SOCAST &val, sizeof(val)))
+    DEBUG_printf("2httpAddrListen: setsockopt(SO_REUSEADDR) failed: %s", strerror(errno));
+
+#ifdef SO_REUSEPORT
+  if (multiple && setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, CUPS_SOCAST &val, sizeof(val)))
+  {
+    _cupsSetHTTPError(HTTP_STATUS_ERROR);
+    close(fd);
+    return (-1);
+  }
+#endif // SO_REUSEPORT
+
+#ifdef IPV6_V6ONLY
+  if (addr->addr.sa_family == AF_INET6)
+  {
+    if (setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, CUPS_SOCAST &val, sizeof(val)))
+      DEBUG_printf("2httpAddrListen: setsockopt(IPv6_V6ONLY) failed: %s", strerror(errno));
+  }
+#endif // IPV6_V6ONLY
+
+  // Bind the socket...
+#ifdef AF_LOCAL
+  if (addr->addr.sa_family == AF_LOCAL)
+  {
+    mode_t	mask;			// Umask setting
+
+    // Remove any existing domain socket file...
+    if ((status = unlink(addr->un.sun_path)) < 0)
+    {
+      if (errno == ENOENT)
+        status = 0;
+      else
+        DEBUG_printf("2httpAddrListen: Unable to unlink '%s': %s",
+addr->un.sun_path, strerror(errno));
+    }
+
+    if (!status)
+    {
+      // Save the current umask and set it to 0 so that all users can access
+      // the domain socket...
+      mask = umask(0);
+
+      // Bind the domain socket...
+      status = bind(fd, (struct sockaddr *)addr, (socklen_t)httpAddrGetLength(addr));
+
+      // Restore the umask and fix permissions...
+      umask(mask);
+    }
+  }
+  else
+#endif // AF_LOCAL
+  {
+    httpAddrSetPort(addr, port);
+
+    status = bind(fd, (struct sockaddr *)addr, (socklen_t)httpAddrGetLength(addr));
+  }
+
+  if (status)
+  {
+    _cupsSetHTTPError(HTTP_STATUS_ERROR);
+
+    close(fd);
+
+    return (-1);
+  }
+
+  // Listen...
+  if (listen(fd, INT_MAX))
+  {
+    _cupsSetHTTPError(HTTP_STATUS_ERROR);
+
+    close(fd);
+
+    return (-1);
+  }
+
+  // Close on exec...
+#ifndef _WIN32
+  if (fcntl(fd, F_SETFD, fcntl(fd, F_GETFD) | FD_CLOEXEC))
+    DEBUG_printf("2httpAddrListen: fcntl(F_SETFD, FD_CLOEXEC) failed: %s", strerror(errno));
+
+  // Make multiple listeners non-blocking for httpAcceptConnections...
+  if (multiple && fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK))
+    DEBUG_printf("2httpAddrListen: fcntl(F_SETFL, O_NONBLOCK) failed: %s", strerror(errno));
+#endif // !_WIN32
+
+#ifdef SO_NOSIGPIPE
+  // Disable SIGPIPE for this socket.
+  val = 1;
+  if (setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, CUPS_SOCAST &val, sizeof(val)))
+    DEBUG_printf("2httpAddrListen: setsockopt(SO_NOSIGPIPE) failed: %s", strerror(errno));
+#endif // SO_NOSIGPIPE
+
+  return (fd);
+}
@@ -21,6 +21,68 @@
 #endif // _WIN32
 
 
+//
+// Local constants...
+//
+
+#define _HTTP_ADDR_CACHE_MAX	64	// Maximum number of cached lookups
+#define _HTTP_ADDR_CACHE_TTL	60	// Seconds to cache successful lookups
+#define _HTTP_ADDR_CACHE_NEG	5	// Seconds to cache failed lookups
+#define _HTTP_ADDR_RESOLVE_DELAY 0.05	// Seconds to wait for IPv6 addresses after IPv4 (RFC 8305)
+
+
+//
+// Local types...
+//
+
+typedef struct _http_addr_cache_s	// Cached hostname lookup
+{
+  char			hostname[256];	// Hostname
+  char			service[32];	// Service name or port number
+  int			family;		// Address family
+  time_t		expires;	// Expiration time
+  int			error;		// getaddrinfo() error, if any
+  http_addrlist_t	*addrlist;	// Address list or `NULL` on error
+} _http_addr_cache_t;
+
+typedef struct _http_addr_lookup_s	// Background hostname lookup
+{
+  cups_mutex_t		mutex;		// Mutex for lookup
+  cups_cond_t		cond;		// Condition for lookup
+  int			users;		// Number of users (caller and thread)
+  bool			done;		// Is the lookup done?
+  char			*hostname,	// Hostname
+			*service;	// Service name or port number
+  int			error;		// getaddrinfo() error, if any
+  http_addrlist_t	*addrlist;	// Address list or `NULL` on error
+} _http_addr_lookup_t;
+
+
+//
+// Local globals...
+//
+
+static _http_addr_cache_t http_addr_cache[_HTTP_ADDR_CACHE_MAX];
+					// Address lookup cache
+static cups_mutex_t	http_addr_mutex = CUPS_MUTEX_INITIALIZER;
+					// Mutex for address lookup cache
+
+
+//
+// Local functions...
+//
+
+static bool		http_addr_cache_copy(const char *hostname, int family, const char *service, http_addrlist_t **addrlist, int *error);
+static void		http_addr_cache_save(const char *hostname, int family, const char *service, http_addrlist_t *addrlist, int error);
+static http_addrlist_t	*http_addr_lookup(const char *hostname, int family, const char *service, int *error);
+#ifdef AF_INET6
+static http_addrlist_t	*http_addr_lookup_any(const char *hostname, const char *service, int *error);
+static void		http_addr_lookup_free(_http_addr_lookup_t *lookup);
+static void		*http_addr_lookup_thread(_http_addr_lookup_t *lookup);
+#endif // AF_INET6
+static http_addrlist_t	*http_addr_next(http_addrlist_t **next, int family, bool *alternate);
+
+
 //
 // 'httpAddrConnect()' - Connect to any of the addresses in the list with a
 //                       timeout and optional cancel.
@@ -43,6 +105,10 @@ httpAddrConnect(
   int			nfds,		// Number of file descriptors
 			fds[100];	// Socket file descriptors
   http_addrlist_t	*addrs[100];	// Addresses
+  http_addrlist_t	*next[2];	// Next addresses for each family
+  int			family;		// Preferred address family
+  bool			alternate = false;
+					// Try other address families next?
 #ifdef O_NONBLOCK
   struct pollfd		pfds[100];	// Polled file descriptors
 #endif // O_NONBLOCK
@@ -72,6 +138,24 @@ httpAddrConnect(
   if (msec <= 0)
     msec = INT_MAX;
 
+  // Alternate between the address family of the first address and the other
+  // families, starting a new attempt every 100ms until one connects (RFC 8305
+  // "Happy Eyeballs")...
+  if (addrlist)
+  {
+    family  = httpAddrGetFamily(&addrlist->addr);
+    next[0] = addrlist;
+
+    for (next[1] = addrlist->next; next[1] && httpAddrGetFamily(&next[1]->addr) == family; next[1] = next[1]->next);
+
+    addrlist = http_addr_next(next, family, &alternate);
+  }
+  else
+  {
+    family  = AF_UNSPEC;
+    next[0] = next[1] = NULL;
+  }
+
   // Loop through each address until we connect or run out of addresses...
   nfds      = 0;
   remaining = msec;
@@ -99,7 +183,7 @@ httpAddrConnect(
         // Don't abort yet, as this could just be an issue with the local
 	// system not being configured with IPv4/IPv6/domain socket enabled.
 	// Just skip this address.
-        addrlist = addrlist->next;
+        addrlist = http_addr_next(next, family, &alternate);
 	continue;
       }
 
@@ -170,7 +254,7 @@ httpAddrConnect(
       {
 	DEBUG_printf("1httpAddrConnect: Unable to connect to %s:%d: %s", httpAddrGetString(&(addrlist->addr), temp, sizeof(temp)), httpAddrGetPort(&(addrlist->addr)), strerror(errno));
 	httpAddrClose(NULL, fds[nfds]);
-	addrlist = addrlist->next;
+	addrlist = http_addr_next(next, family, &alternate);
 	continue;
       }
 
@@ -181,7 +265,7 @@ httpAddrConnect(
 
       addrs[nfds] = addrlist;
       nfds ++;
-      addrlist = addrlist->next;
+      addrlist = http_addr_next(next, family, &alternate);
     }
 
     if (!addrlist && nfds == 0)
@@ -364,7 +448,7 @@ httpAddrCopyList(
 
   while (src)
   {
-    if ((current = malloc(sizeof(http_addrlist_t))) == NULL)
+    if ((current = _cupsMemAlloc(CUPS_MEMTYPE_HTTP, sizeof(http_addrlist_t))) == NULL)
     {
       current = dst;
 
@@ -373,7 +457,7 @@ httpAddrCopyList(
         prev    = current;
         current = current->next;
 
-        free(prev);
+        _cupsMemFree(prev);
       }
 
       return (NULL);
@@ -396,6 +480,35 @@ httpAddrCopyList(
 }
 
 
+//
+// 'httpAddrFlushCache()' - Flush the cache of hostname lookups.
+//
+// @link httpAddrGetList@ caches the addresses for a hostname for a short time
+// so that repeated connections to the same host do not each need a DNS
+// lookup.  Failed lookups are cached for a shorter time.  This function
+// discards all cached lookups, for example after a change in the network
+// configuration.
+//
+
+void
+httpAddrFlushCache(void)
+{
+  size_t		i;		// Looping var
+  _http_addr_cache_t	*cache;		// Current cache entry
+
+
+  cupsMutexLock(&http_addr_mutex);
+
+  for (i = _HTTP_ADDR_CACHE_MAX, cache = http_addr_cache; i > 0; i --, cache ++)
+  {
+    httpAddrFreeList(cache->addrlist);
+    memset(cache, 0, sizeof(_http_addr_cache_t));
+  }
+
+  cupsMutexUnlock(&http_addr_mutex);
+}
+
+
 //
 // 'httpAddrFreeList()' - Free an address list.
 //
@@ -412,7 +525,7 @@ httpAddrFreeList(
   {
     next = addrlist->next;
 
-    free(addrlist);
+    _cupsMemFree(addrlist);
 
     addrlist = next;
   }
@@ -422,6 +535,9 @@ httpAddrFreeList(
 //
 // 'httpAddrGetList()' - Get a list of addresses for a hostname.
 //
+// The results of hostname lookups are cached for a short time - use
+// @link httpAddrFlushCache@ to discard cached lookups.
+//
 
 http_addrlist_t	*			// O - List of addresses or NULL
 httpAddrGetList(const char *hostname,	// I - Hostname, IP address, or NULL for passive listen address
@@ -479,7 +595,7 @@ httpAddrGetList(const char *hostname,	// I - Hostname, IP address, or NULL for p
   if (hostname && hostname[0] == '/')
   {
     // Domain socket address...
-    if ((first = (http_addrlist_t *)calloc(1, sizeof(http_addrlist_t))) != NULL)
+    if ((first = (http_addrlist_t *)_cupsMemCalloc(CUPS_MEMTYPE_HTTP, 1, sizeof(http_addrlist_t))) != NULL)
     {
       addr = first;
       first->addr.un.sun_family = AF_LOCAL;
@@ -490,17 +606,8 @@ httpAddrGetList(const char *hostname,	// I - Hostname, IP address, or NULL for p
 #endif // AF_LOCAL
   if (!hostname || _cups_strcasecmp(hostname, "localhost"))
   {
-    struct addrinfo	hints,		// Address lookup hints
-			*results,	// Address lookup results
-			*current;	// Current result
     int			error;		// getaddrinfo() error
 
-    // Lookup the address as needed...
-    memset(&hints, 0, sizeof(hints));
-    hints.ai_family   = family;
-    hints.ai_flags    = hostname ? 0 : AI_PASSIVE;
-    hints.ai_socktype = SOCK_STREAM;
-
     if (hostname && *hostname == '[')
     {
       // Remove brackets from numeric IPv6 address...
@@ -530,43 +637,16 @@ httpAddrGetList(const char *hostname,	// I - Hostname, IP address, or NULL for p
       }
     }
 
-    if ((error = getaddrinfo(hostname, service, &hints, &results)) == 0)
-    {
-      // Copy the results to our own address list structure...
-      for (current = results; current; current = current->ai_next)
-      {
-        if (current->ai_family == AF_INET || current->ai_family == AF_INET6)
-	{
-	  // Copy the address over...
-	  temp = (http_addrlist_t *)calloc(1, sizeof(http_addrlist_t));
-	  if (!temp)
-	  {
-	    httpAddrFreeList(first);
-	    freeaddrinfo(results);
-	    _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(errno), 0);
-	    return (NULL);
-	  }
-
-          if (current->ai_family == AF_INET6)
-	    memcpy(&(temp->addr.ipv6), current->ai_addr,
-	           sizeof(temp->addr.ipv6));
-	  else
-	    memcpy(&(temp->addr.ipv4), current->ai_addr,
-	           sizeof(temp->addr.ipv4));
-
-          // Append the address to the list...
-	  if (!first)
-	    first = temp;
-
-	  if (addr)
-	    addr->next = temp;
-
-	  addr = temp;
-	}
-      }
+#ifdef AF_INET6
+    if (hostname && family == AF_UNSPEC && !strchr(hostname, ':') && strspn(hostname, "0123456789.") < strlen(hostname))
+      first = http_addr_lookup_any(hostname, service, &error);
+    else
+#endif // AF_INET6
+      first = http_addr_lookup(hostname, family, service, &error);
 
-      // Free the results from getaddrinfo()...
-      freeaddrinfo(results);
+    if (first)
+    {
+      for (addr = first; addr->next; addr = addr->next);
     }
     else
     {
@@ -578,6 +658,9 @@ httpAddrGetList(const char *hostname,	// I - Hostname, IP address, or NULL for p
 #  else
       _cupsSetError(IPP_STATUS_ERROR_INTERNAL, gai_strerror(error), 0);
 #  endif // _WIN32
+
+      if (error == EAI_MEMORY)
+        return (NULL);
     }
   }
 
@@ -639,7 +722,7 @@ httpAddrGetList(const char *hostname,	// I - Hostname, IP address, or NULL for p
       if (family != AF_INET)
       {
         // Add [::1] to the address list...
-	temp = (http_addrlist_t *)calloc(1, sizeof(http_addrlist_t));
+	temp = (http_addrlist_t *)_cupsMemCalloc(CUPS_MEMTYPE_HTTP, 1, sizeof(http_addrlist_t));
 	if (!temp)
 	{
 	  _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(errno), 0);
@@ -665,7 +748,7 @@ httpAddrGetList(const char *hostname,	// I - Hostname, IP address, or NULL for p
 #endif // AF_INET6
       {
         // Add 127.0.0.1 to the address list...
-	temp = (http_addrlist_t *)calloc(1, sizeof(http_addrlist_t));
+	temp = (http_addrlist_t *)_cupsMemCalloc(CUPS_MEMTYPE_HTTP, 1, sizeof(http_addrlist_t));
 	if (!temp)
 	{
 	  _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(errno), 0);
@@ -691,7 +774,7 @@ httpAddrGetList(const char *hostname,	// I - Hostname, IP address, or NULL for p
       if (family != AF_INET)
       {
         // Add [::] to the address list...
-	temp = (http_addrlist_t *)calloc(1, sizeof(http_addrlist_t));
+	temp = (http_addrlist_t *)_cupsMemCalloc(CUPS_MEMTYPE_HTTP, 1, sizeof(http_addrlist_t));
 	if (!temp)
 	{
 	  _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(errno), 0);
@@ -712,7 +795,7 @@ httpAddrGetList(const char *hostname,	// I - Hostname, IP address, or NULL for p
 #endif // AF_INET6
       {
         // Add 0.0.0.0 to the address list...
-	temp = (http_addrlist_t *)calloc(1, sizeof(http_addrlist_t));
+	temp = (http_addrlist_t *)_cupsMemCalloc(CUPS_MEMTYPE_HTTP, 1, sizeof(http_addrlist_t));
 	if (!temp)
 	{
 	  _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(errno), 0);
@@ -735,3 +818,379 @@ httpAddrGetList(const char *hostname,	// I - Hostname, IP address, or NULL for p
   // Return the address list...
   return (first);
 }
+
+
+//
+// 'http_addr_cache_copy()' - Copy a cached hostname lookup.
+//
+
+static bool				// O - `true` if found, `false` otherwise
+http_addr_cache_copy(
+    const char      *hostname,		// I - Hostname
+    int             family,		// I - Address family
+    const char      *service,		// I - Service name or port number
+    http_addrlist_t **addrlist,		// O - Copy of address list
+    int             *error)		// O - getaddrinfo() error, if any
+{
+  bool			ret = false;	// Return value
+  size_t		i;		// Looping var
+  _http_addr_cache_t	*cache;		// Current cache entry
+  time_t		curtime = time(NULL);
+					// Current time
+
+
+  if (!service)
+    service = "";
+
+  cupsMutexLock(&http_addr_mutex);
+
+  for (i = _HTTP_ADDR_CACHE_MAX, cache = http_addr_cache; i > 0; i --, cache ++)
+  {
+    if (cache->expires > curtime && cache->family == family && !_cups_strcasecmp(cache->hostname, hostname) && !strcmp(cache->service, service))
+    {
+      *addrlist = httpAddrCopyList(cache->addrlist);
+      *error    = cache->error;
+      ret       = true;
+      break;
+    }
+  }
+
+  cupsMutexUnlock(&http_addr_mutex);
+
+  DEBUG_printf("4http_addr_cache_copy(hostname=\"%s\", family=%d, service=\"%s\") returning %s", hostname, family, service, ret ? "true" : "false");
+
+  return (ret);
+}
+
+
+//
+// 'http_addr_cache_save()' - Save a hostname lookup in the cache.
+//
+// The oldest (or an expired) entry is replaced when the cache is full.
+//
+
+static void
+http_addr_cache_save(
+    const char      *hostname,		// I - Hostname
+    int             family,		// I - Address family
+    const char      *service,		// I - Service name or port number
+    http_addrlist_t *addrlist,		// I - Address list or `NULL` on error
+    int             error)		// I - getaddrinfo() error, if any
+{
+  size_t		i;		// Looping var
+  _http_addr_cache_t	*cache,		// Current cache entry
+			*oldest;	// Entry to replace
+  http_addrlist_t	*copy = NULL;	// Copy of address list
+
+
+  if (strlen(hostname) >= sizeof(cache->hostname) || (service && strlen(service) >= sizeof(cache->service)))
+    return;
+
+  if (addrlist && (copy = httpAddrCopyList(addrlist)) == NULL)
+    return;
+
+  if (!service)
+    service = "";
+
+  cupsMutexLock(&http_addr_mutex);
+
+  for (i = _HTTP_ADDR_CACHE_MAX, cache = http_addr_cache, oldest = http_addr_cache; i > 0; i --, cache ++)
+  {
+    if (cache->family == family && !_cups_strcasecmp(cache->hostname, hostname) && !strcmp(cache->service, service))
+    {
+      oldest = cache;
+      break;
+    }
+    else if (cache->expires < oldest->expires)
+    {
+      oldest = cache;
+    }
+  }
+
+  httpAddrFreeList(oldest->addrlist);
+
+  cupsCopyString(oldest->hostname, hostname, sizeof(oldest->hostname));
+  cupsCopyString(oldest->service, service, sizeof(oldest->service));
+  oldest->family   = family;
+  oldest->expires  = time(NULL) + (copy ? _HTTP_ADDR_CACHE_TTL : _HTTP_ADDR_CACHE_NEG);
+  oldest->error    = error;
+  oldest->addrlist = copy;
+
+  cupsMutexUnlock(&http_addr_mutex);
+}
+
+
+//
+// 'http_addr_lookup()' - Look up the addresses for a hostname.
+//
+// Lookups are cached for a short time - successful lookups and lookups for
+// hostnames that do not exist are both cached.
+//
+
+static http_addrlist_t *		// O - Address list or `NULL` on error
+http_addr_lookup(
+    const char *hostname,		// I - Hostname or `NULL` for passive listen address
+    int        family,			// I - Address family or `AF_UNSPEC`
+    const char *service,		// I - Service name or port number
+    int        *error)			// O - getaddrinfo() error, if any
+{
+  http_addrlist_t	*first = NULL,	// First address in list
+			*addr = NULL,	// Current address in list
+			*temp;		// New address
+  struct addrinfo	hints,		// Address lookup hints
+			*results,	// Address lookup results
+			*current;	// Current result
+
+
+  // Use the cached lookup, if any...
+  if (hostname && http_addr_cache_copy(hostname, family, service, &first, error))
+  {
+    if (!first && !*error)
+      *error = EAI_MEMORY;
+
+    return (first);
+  }
+
+  // Lookup the address as needed...
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family   = family;
+  hints.ai_flags    = hostname ? 0 : AI_PASSIVE;
+  hints.ai_socktype = SOCK_STREAM;
+
+  if ((*error = getaddrinfo(hostname, service, &hints, &results)) != 0)
+  {
+    // Cache lookups for hostnames that don't exist...
+    if (hostname && (*error == EAI_NONAME
+#ifdef EAI_NODATA
+        || *error == EAI_NODATA
+#endif // EAI_NODATA
+        ))
+      http_addr_cache_save(hostname, family, service, NULL, *error);
+
+    return (NULL);
+  }
+
+  // Copy the results to our own address list structure...
+  for (current = results; current; current = current->ai_next)
+  {
+    if (current->ai_family == AF_INET || current->ai_family == AF_INET6)
+    {
+      // Copy the address over...
+      if ((temp = (http_addrlist_t *)_cupsMemCalloc(CUPS_MEMTYPE_HTTP, 1, sizeof(http_addrlist_t))) == NULL)
+      {
+	httpAddrFreeList(first);
+	freeaddrinfo(results);
+	*error = EAI_MEMORY;
+	return (NULL);
+      }
+
+      if (current->ai_family == AF_INET6)
+	memcpy(&(temp->addr.ipv6), current->ai_addr, sizeof(temp->addr.ipv6));
+      else
+	memcpy(&(temp->addr.ipv4), current->ai_addr, sizeof(temp->addr.ipv4));
+
+      // Append the address to the list...
+      if (!first)
+	first = temp;
+
+      if (addr)
+	addr->next = temp;
+
+      addr = temp;
+    }
+  }
+
+  // Free the results from getaddrinfo()...
+  freeaddrinfo(results);
+
+  if (hostname && first)
+    http_addr_cache_save(hostname, family, service, first, 0);
+
+  return (first);
+}
+
+
+#ifdef AF_INET6
+//
+// 'http_addr_lookup_any()' - Look up the IPv6 and IPv4 addresses for a hostname.
+//
+// The IPv6 lookup runs in a background thread while the IPv4 lookup runs in
+// the caller's thread.  Once the IPv4 addresses are known, the IPv6 lookup
+// only gets a short "resolution delay" to finish (RFC 8305), so a slow AAAA
+// lookup doesn't hold up connections to IPv4 addresses.  A late IPv6 lookup
+// still finishes in the background and is cached for later connections.
+//
+
+static http_addrlist_t *		// O - Address list or `NULL` on error
+http_addr_lookup_any(
+    const char *hostname,		// I - Hostname
+    const char *service,		// I - Service name or port number
+    int        *error)			// O - getaddrinfo() error, if any
+{
+  _http_addr_lookup_t	*lookup;	// Background lookup
+  cups_thread_t		thread;		// Background lookup thread
+  http_addrlist_t	*ipv4,		// IPv4 addresses
+			*ipv6 = NULL,	// IPv6 addresses
+			*addr;		// Current address
+  int			ipv4error,	// IPv4 lookup error
+			ipv6error = 0;	// IPv6 lookup error
+  bool			last;		// Last user of background lookup?
+
+
+  if (http_addr_cache_copy(hostname, AF_INET6, service, &ipv6, &ipv6error))
+  {
+    // Use the cached IPv6 addresses...
+    ipv4 = http_addr_lookup(hostname, AF_INET, service, &ipv4error);
+  }
+  else
+  {
+    // Start the IPv6 lookup in the background...
+    if ((lookup = (_http_addr_lookup_t *)_cupsMemCalloc(CUPS_MEMTYPE_HTTP, 1, sizeof(_http_addr_lookup_t))) == NULL)
+      return (http_addr_lookup(hostname, AF_UNSPEC, service, error));
+
+    cupsMutexInit(&lookup->mutex);
+    cupsCondInit(&lookup->cond);
+
+    lookup->users    = 2;
+    lookup->hostname = _cupsMemStrdup(CUPS_MEMTYPE_HTTP, hostname);
+    lookup->service  = service ? _cupsMemStrdup(CUPS_MEMTYPE_HTTP, service) : NULL;
+
+    if (!lookup->hostname || (service && !lookup->service) || (thread = cupsThreadCreate((cups_thread_func_t)http_addr_lookup_thread, lookup)) == CUPS_THREAD_INVALID)
+    {
+      http_addr_lookup_free(lookup);
+      return (http_addr_lookup(hostname, AF_UNSPEC, service, error));
+    }
+
+    cupsThreadDetach(thread);
+
+    // Look up the IPv4 addresses while the IPv6 lookup runs...
+    ipv4 = http_addr_lookup(hostname, AF_INET, service, &ipv4error);
+
+    // Then wait for the IPv6 lookup - briefly if we have IPv4 addresses...
+    cupsMutexLock(&lookup->mutex);
+
+    if (ipv4)
+    {
+      if (!lookup->done)
+        cupsCondWait(&lookup->cond, &lookup->mutex, _HTTP_ADDR_RESOLVE_DELAY);
+    }
+    else
+    {
+      while (!lookup->done)
+        cupsCondWait(&lookup->cond, &lookup->mutex, 0.0);
+    }
+
+    if (lookup->done)
+    {
+      ipv6             = lookup->addrlist;
+      ipv6error        = lookup->error;
+      lookup->addrlist = NULL;
+    }
+    else
+    {
+      DEBUG_printf("4http_addr_lookup_any: IPv6 lookup for \"%s\" still running, using IPv4 addresses.", hostname);
+    }
+
+    last = -- lookup->users == 0;
+
+    cupsMutexUnlock(&lookup->mutex);
+
+    if (last)
+      http_addr_lookup_free(lookup);
+  }
+
+  // Return the IPv6 addresses followed by the IPv4 addresses...
+  if (ipv6)
+  {
+    for (addr = ipv6; addr->next; addr = addr->next);
+
+    addr->next = ipv4;
+    *error     = 0;
+
+    return (ipv6);
+  }
+
+  *error = ipv4 ? 0 : ipv4error ? ipv4error : ipv6error;
+
+  return (ipv4);
+}
+
+
+//
+// 'http_addr_lookup_free()' - Free a background hostname lookup.
+//
+
+static void
+http_addr_lookup_free(
+    _http_addr_lookup_t *lookup)	// I - Background lookup
+{
+  cupsCondDestroy(&lookup->cond);
+  cupsMutexDestroy(&lookup->mutex);
+  httpAddrFreeList(lookup->addrlist);
+  _cupsMemFree(lookup->hostname);
+  _cupsMemFree(lookup->service);
+  _cupsMemFree(lookup);
+}
+
+
+//
+// 'http_addr_lookup_thread()' - Look up the IPv6 addresses for a hostname.
+//
+
+static void *				// O - Thread exit status
+http_addr_lookup_thread(
+    _http_addr_lookup_t *lookup)	// I - Background lookup
+{
+  http_addrlist_t	*addrlist;	// IPv6 addresses
+  int			error;		// getaddrinfo() error, if any
+  bool			last;		// Last user of lookup?
+
+
+  addrlist = http_addr_lookup(lookup->hostname, AF_INET6, lookup->service, &error);
+
+  cupsMutexLock(&lookup->mutex);
+
+  lookup->addrlist = addrlist;
+  lookup->error    = error;
+  lookup->done     = true;
+  last             = -- lookup->users == 0;
+
+  cupsCondBroadcast(&lookup->cond);
+  cupsMutexUnlock(&lookup->mutex);
+
+  if (last)
+    http_addr_lookup_free(lookup);
+
+  return (NULL);
+}
+#endif // AF_INET6
+
+
+//
+// 'http_addr_next()' - Get the next address to connect to.
+//
+// Addresses alternate between the preferred address family (the family of the
+// first address in the list) and other families, as recommended by RFC 8305.
+//
+
+static http_addrlist_t *		// O - Next address or `NULL` for none
+http_addr_next(
+    http_addrlist_t **next,		// IO - Next addresses for the preferred and other families
+    int             family,		// I  - Preferred address family
+    bool            *alternate)		// IO - Use other families next?
+{
+  int			i;		// Which family to use
+  http_addrlist_t	*addr;		// Address
+
+
+  i = ((*alternate && next[1]) || !next[0]) ? 1 : 0;
+
+  if ((addr = next[i]) != NULL)
+  {
+    for (next[i] = addr->next; next[i] && (httpAddrGetFamily(&next[i]->addr) == family) != (i == 0); next[i] = next[i]->next);
+
+    *alternate = i == 0;
+  }
+
+  return (addr);
+}
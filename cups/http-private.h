@@ -51,11 +51,14 @@ extern "C" {
 //
 
 #  define _HTTP_MAX_SBUFFER	65536	// Size of (de)compression buffer
+#  define _HTTP_MAX_BUFSIZE	16777216// Maximum size of I/O buffers
+#  define _HTTP_MAX_SENDFILE	1048576	// Maximum size of file writes
 
 #  define _HTTP_TLS_NONE	0	// No TLS options
 #  define _HTTP_TLS_ALLOW_RC4	1	// Allow RC4 cipher suites
 #  define _HTTP_TLS_ALLOW_DH	2	// Allow DH/DHE key negotiation
 #  define _HTTP_TLS_DENY_CBC	4	// Deny CBC cipher suites
+#  define _HTTP_TLS_ALLOW_KTLS	8	// Allow kernel TLS offload
 #  define _HTTP_TLS_SET_DEFAULT 128     // Setting the default TLS options
 
 #  define _HTTP_TLS_SSL3	0	// Min/max version is SSL/3.0
@@ -93,8 +96,12 @@ typedef enum _http_coding_e		// HTTP content coding enumeration
   _HTTP_CODING_IDENTITY,		// No content coding
   _HTTP_CODING_GZIP,			// LZ77+gzip compression
   _HTTP_CODING_DEFLATE,			// LZ77+zlib compression
-  _HTTP_CODING_GUNZIP,			// LZ77+gzip decompression
-  _HTTP_CODING_INFLATE			// LZ77+zlib decompression
+  _HTTP_CODING_ZSTD,			// Zstandard compression
+  _HTTP_CODING_BROTLI,			// Brotli compression
+  _HTTP_CODING_GUNZIP,			// LZ77+gzip decompression (first decompression value)
+  _HTTP_CODING_INFLATE,			// LZ77+zlib decompression
+  _HTTP_CODING_UNZSTD,			// Zstandard decompression
+  _HTTP_CODING_UNBROTLI			// Brotli decompression
 } _http_coding_t;
 
 typedef enum _http_mode_e		// HTTP mode enumeration
@@ -110,6 +117,7 @@ struct _http_s				// HTTP connection structure
   					// Name of connected host
   http_addr_t		*hostaddr;	// Current host address and port
   http_addrlist_t	*hostlist;	// List of valid addresses
+  bool			resolved;	// Has the address been looked up?
   int			fd;		// File descriptor for this socket
   bool			blocking;	// To block or not to block
   int			error;		// Last error on read
@@ -133,8 +141,11 @@ struct _http_s				// HTTP connection structure
   http_encoding_t	data_encoding;	// Chunked or not
   off_t			data_remaining;	// Number of bytes left
   int			used;		// Number of bytes used in buffer
-  char			buffer[HTTP_MAX_BUFFER];
-					// Buffer for incoming data
+  char			*buffer;	// Pointer to unread incoming data
+  char			*rbuffer;	// Buffer for incoming data
+  size_t		rsize;		// Size of incoming data buffer
+  char			rdefault[HTTP_MAX_BUFFER];
+					// Default buffer for incoming data
   char			algorithm[65],	// Algorithm from WWW-Authenticate
 			nextnonce[HTTP_MAX_VALUE],
 					// Next nonce value from Authentication-Info
@@ -151,9 +162,12 @@ struct _http_s				// HTTP connection structure
   _http_tls_credentials_t *tls_credentials;
 					// TLS credentials
   bool			tls_upgrade;	// `true` if we are doing an upgrade
-  char			wbuffer[HTTP_MAX_BUFFER];
-					// Buffer for outgoing data
+  char			*wbuffer;	// Buffer for outgoing data
+  size_t		wsize;		// Size of outgoing data buffer
+  char			wdefault[HTTP_MAX_BUFFER];
+					// Default buffer for outgoing data
   int			wused;		// Write buffer bytes used
+  bool			coalesce;	// Coalesce response writes?
 					// TLS credentials
   http_timeout_cb_t	timeout_cb;	// Timeout callback
   void			*timeout_data;	// User data pointer
@@ -162,6 +176,11 @@ struct _http_s				// HTTP connection structure
   _http_coding_t	coding;		// _HTTP_CODING_xxx
   void			*stream;	// (De)compression stream
   unsigned char		*sbuffer;	// (De)compression buffer
+  http_stats_t		stats;		// Connection statistics
+  double		request_time;	// Time of last request
+  http_state_cb_t	state_cb;	// State change callback
+  void			*state_data;	// State change callback data
+  cups_hash_t		*hash;		// Hash of message body data read, if any
 };
 
 
@@ -179,13 +198,18 @@ extern const char *_cups_hstrerror(int error);
 // Prototypes...
 //
 
+extern bool		_httpCheckConnection(http_t *http) _CUPS_PRIVATE;
 extern _http_tls_credentials_t *_httpCreateCredentials(const char *credentials, const char *key) _CUPS_PRIVATE;
 extern char		*_httpDecodeURI(char *dst, const char *src, size_t dstsize) _CUPS_PRIVATE;
 extern void		_httpDisconnect(http_t *http) _CUPS_PRIVATE;
 extern char		*_httpEncodeURI(char *dst, const char *src, size_t dstsize) _CUPS_PRIVATE;
 extern void		_httpFreeCredentials(_http_tls_credentials_t *hcreds) _CUPS_PRIVATE;
+extern http_t		*_httpGetIdleConnection(const char *host, int port, int family, http_encryption_t encryption) _CUPS_PRIVATE;
+extern void		_httpHostnameChanged(void) _CUPS_INTERNAL;
+extern ssize_t		_httpReadFile(http_t *http, int fd) _CUPS_PRIVATE;
 extern bool		_httpSetDigestAuthString(http_t *http, const char *nonce, const char *method, const char *resource) _CUPS_PRIVATE;
 extern const char	*_httpStatusString(cups_lang_t *lang, http_status_t status) _CUPS_PRIVATE;
+extern bool		_httpTLSCanSendfile(http_t *http) _CUPS_PRIVATE;
 extern void		_httpTLSInitialize(void) _CUPS_PRIVATE;
 extern size_t		_httpTLSPending(http_t *http) _CUPS_PRIVATE;
 extern int		_httpTLSRead(http_t *http, char *buf, int len) _CUPS_PRIVATE;
@@ -196,6 +220,7 @@ extern int		_httpTLSWrite(http_t *http, const char *buf, int len) _CUPS_PRIVATE;
 extern bool		_httpUpdate(http_t *http, http_status_t *status) _CUPS_PRIVATE;
 extern _http_tls_credentials_t *_httpUseCredentials(_http_tls_credentials_t *hcreds) _CUPS_PRIVATE;
 extern bool		_httpWait(http_t *http, int msec, bool usessl) _CUPS_PRIVATE;
+extern ssize_t		_httpWriteFile(http_t *http, int fd) _CUPS_PRIVATE;
 
 
 #  ifdef __cplusplus
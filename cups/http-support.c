@@ -99,6 +99,7 @@ static const char * const http_states[] =
 // Local functions...
 //
 
+static const char	*http_check_encoded(const char *src, const char *term);
 static const char	*http_copy_decode(char *dst, const char *src, size_t dstsize, const char *term, bool decode);
 static char		*http_copy_encode(char *dst, const char *src, char *dstend, const char *reserved, const char *term, bool encode);
 static void 		http_resolve_cb(cups_dnssd_resolve_t *res, void *cb_data, cups_dnssd_flags_t flags, uint32_t if_index, const char *fullname, const char *host, uint16_t port, size_t num_txt, cups_option_t *txt);
@@ -626,11 +627,19 @@ httpGetDateString(time_t t,		// I - Time in seconds
 		  size_t slen)		// I - Size of string buffer
 {
   struct tm	tdate;			// UNIX date/time data
+  _cups_globals_t *cg = _cupsGlobals();	// Global data
 
 
-  gmtime_r(&t, &tdate);
+  // Reuse the last date string formatted by this thread for the same time...
+  if (t != cg->http_date_time || !cg->http_date[0])
+  {
+    gmtime_r(&t, &tdate);
 
-  snprintf(s, slen, "%s, %02d %s %d %02d:%02d:%02d GMT", http_days[tdate.tm_wday], tdate.tm_mday, http_months[tdate.tm_mon], tdate.tm_year + 1900, tdate.tm_hour, tdate.tm_min, tdate.tm_sec);
+    snprintf(cg->http_date, sizeof(cg->http_date), "%s, %02d %s %d %02d:%02d:%02d GMT", http_days[tdate.tm_wday], tdate.tm_mday, http_months[tdate.tm_mon], tdate.tm_year + 1900, tdate.tm_hour, tdate.tm_min, tdate.tm_sec);
+    cg->http_date_time = t;
+  }
+
+  cupsCopyString(s, cg->http_date, slen);
 
   return (s);
 }
@@ -977,6 +986,218 @@ httpSeparateURI(
 }
 
 
+//
+// 'httpSeparateURIView()' - Separate a Universal Resource Identifier into its
+//                           components without copying them.
+//
+// This function separates a URI like @link httpSeparateURI@ with
+// `HTTP_URI_CODING_MOST`, but instead of copying and decoding each component
+// it returns the offset and length of each component in the original string.
+// Components are not percent-decoded, IPv6 addresses do not include the
+// surrounding brackets, and a scheme that is not present in the URI, such as
+// for "//server/ipp" or "/filename", has a length of 0.  A resource that is
+// empty or starts with "?" has an implied "/" at the start.
+//
+
+http_uri_status_t			// O - Result of separation
+httpSeparateURIView(
+    const char      *uri,		// I - Universal Resource Identifier
+    http_uri_view_t *view)		// O - URI components
+{
+  const char		*ptr,		// Pointer into URI
+			*start,		// Start of component
+			*scheme;	// Scheme name
+  size_t		schemelen;	// Length of scheme name
+  http_uri_status_t	status;		// Result of separation
+
+
+  // Range check input...
+  if (view)
+    memset(view, 0, sizeof(http_uri_view_t));
+
+  if (!uri || !view)
+    return (HTTP_URI_STATUS_BAD_ARGUMENTS);
+
+  if (!*uri)
+    return (HTTP_URI_STATUS_BAD_URI);
+
+  // Grab the scheme portion of the URI...
+  status = HTTP_URI_STATUS_OK;
+
+  if (!strncmp(uri, "//", 2))
+  {
+    // Workaround for HP IPP client bug...
+    scheme    = "ipp";
+    schemelen = 3;
+    ptr       = uri;
+    status    = HTTP_URI_STATUS_MISSING_SCHEME;
+  }
+  else if (*uri == '/')
+  {
+    // Filename...
+    scheme    = "file";
+    schemelen = 4;
+    ptr       = uri;
+    status    = HTTP_URI_STATUS_MISSING_SCHEME;
+  }
+  else
+  {
+    // Standard URI with scheme...
+    for (ptr = uri; *ptr && strchr("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-+.", *ptr); ptr ++);
+
+    if (*ptr != ':' || *uri == '.' || ptr == uri)
+      return (HTTP_URI_STATUS_BAD_SCHEME);
+
+    scheme    = uri;
+    schemelen = (size_t)(ptr - uri);
+
+    view->scheme.length = schemelen;
+
+    ptr ++;
+  }
+
+  // Set the default port number...
+  if (schemelen == 4 && !strncmp(scheme, "http", 4))
+    view->port = 80;
+  else if (schemelen == 5 && !strncmp(scheme, "https", 5))
+    view->port = 443;
+  else if ((schemelen == 3 && !strncmp(scheme, "ipp", 3)) || (schemelen == 4 && !strncmp(scheme, "ipps", 4)))
+    view->port = 631;
+  else if (schemelen == 3 && !_cups_strncasecmp(scheme, "lpd", 3))
+    view->port = 515;
+  else if (schemelen == 6 && !strncmp(scheme, "socket", 6))
+    view->port = 9100;
+  else if ((schemelen != 4 || strncmp(scheme, "file", 4)) && (schemelen != 6 || strncmp(scheme, "mailto", 6)) && (schemelen != 3 || strncmp(scheme, "tel", 3)))
+    status = HTTP_URI_STATUS_UNKNOWN_SCHEME;
+
+  // Now see if we have a hostname...
+  if (!strncmp(ptr, "//", 2))
+  {
+    // Yes, grab the username, if any...
+    ptr += 2;
+
+    if ((start = strpbrk(ptr, "@/")) != NULL && *start == '@')
+    {
+      start = ptr;
+
+      if ((ptr = http_check_encoded(ptr, "@")) == NULL)
+        return (HTTP_URI_STATUS_BAD_USERNAME);
+
+      view->username.offset = (size_t)(start - uri);
+      view->username.length = (size_t)(ptr - start);
+
+      ptr ++;
+    }
+
+    // Then the hostname/IP address...
+    if (*ptr == '[')
+    {
+      // Grab IPv6 address...
+      ptr ++;
+      if (*ptr == 'v')
+      {
+        // Skip IPvFuture ("vXXXX.") prefix...
+        ptr ++;
+
+        while (isxdigit(*ptr & 255))
+          ptr ++;
+
+        if (*ptr != '.')
+	  return (HTTP_URI_STATUS_BAD_HOSTNAME);
+
+        ptr ++;
+      }
+
+      start = ptr;
+
+      if ((ptr = http_check_encoded(ptr, "]")) == NULL || *ptr != ']')
+        return (HTTP_URI_STATUS_BAD_HOSTNAME);
+
+      view->host.offset = (size_t)(start - uri);
+      view->host.length = (size_t)(ptr - start);
+
+      // Validate the address up to any zone separator...
+      for (; start < ptr && *start != '+' && *start != '%'; start ++)
+      {
+	if (*start != ':' && *start != '.' && !isxdigit(*start & 255))
+	  return (HTTP_URI_STATUS_BAD_HOSTNAME);
+      }
+
+      ptr ++;
+    }
+    else
+    {
+      // Validate the hostname or IPv4 address...
+      for (start = ptr; *ptr && !strchr(":?/", *ptr); ptr ++)
+      {
+        if (!strchr("abcdefghijklmnopqrstuvwxyz"	// unreserved
+		    "ABCDEFGHIJKLMNOPQRSTUVWXYZ"	// unreserved
+		    "0123456789"			// unreserved
+		    "-._~"				// unreserved
+		    "%"					// pct-encoded
+		    "!$&'()*+,;="			// sub-delims
+		    "\\", *ptr))			// SMB domain
+	  return (HTTP_URI_STATUS_BAD_HOSTNAME);
+      }
+
+      if (http_check_encoded(start, ":?/") == NULL)
+        return (HTTP_URI_STATUS_BAD_HOSTNAME);
+
+      view->host.offset = (size_t)(start - uri);
+      view->host.length = (size_t)(ptr - start);
+    }
+
+    // Validate hostname for file scheme - only empty and localhost are
+    // acceptable.
+    if (schemelen == 4 && !strncmp(scheme, "file", 4) && view->host.length > 0 && (view->host.length != 9 || strncmp(uri + view->host.offset, "localhost", 9)))
+      return (HTTP_URI_STATUS_BAD_HOSTNAME);
+
+    // See if we have a port number...
+    if (*ptr == ':')
+    {
+      // Yes, collect the port number...
+      char	*portend;		// End of port number
+
+      if (!isdigit(ptr[1] & 255))
+      {
+        view->port = 0;
+        return (HTTP_URI_STATUS_BAD_PORT);
+      }
+
+      view->port = (int)strtol(ptr + 1, &portend, 10);
+      ptr        = portend;
+
+      if (view->port <= 0 || view->port > 65535 || (*ptr != '/' && *ptr))
+      {
+        view->port = 0;
+        return (HTTP_URI_STATUS_BAD_PORT);
+      }
+    }
+  }
+
+  // The remaining portion is the resource string...
+  if (*ptr == '?' || !*ptr)
+    status = HTTP_URI_STATUS_MISSING_RESOURCE;
+
+  view->resource.offset = (size_t)(ptr - uri);
+
+  if ((start = http_check_encoded(ptr, "?")) == NULL)
+    return (HTTP_URI_STATUS_BAD_RESOURCE);
+
+  // The query string is not decoded, so only check for control characters...
+  for (ptr = start; *ptr; ptr ++)
+  {
+    if ((*ptr & 255) <= 0x20 || (*ptr & 255) >= 0x7f)
+      return (HTTP_URI_STATUS_BAD_RESOURCE);
+  }
+
+  view->resource.length = (size_t)(ptr - uri) - view->resource.offset;
+
+  // Return the URI separation status...
+  return (status);
+}
+
+
 //
 // '_httpSetDigestAuthString()' - Calculate a Digest authentication response
 //                                using the appropriate RFC 2068/2617/7616
@@ -1027,12 +1248,18 @@ _httpSetDigestAuthString(
   {
     // Follow RFC 2617/7616...
     int		i;			// Looping var
+    unsigned char cnonce_bytes[32];	// Random cnonce bytes
     char	cnonce[65];		// cnonce value
     const char	*hashalg;		// Hashing algorithm
     const char	*qop;			// Quality of Protection
 
-    for (i = 0; i < 64; i ++)
-      cnonce[i] = "0123456789ABCDEF"[cupsGetRand() & 15];
+    cupsGetRandBytes(cnonce_bytes, sizeof(cnonce_bytes));
+
+    for (i = 0; i < 32; i ++)
+    {
+      cnonce[2 * i]     = "0123456789ABCDEF"[cnonce_bytes[i] >> 4];
+      cnonce[2 * i + 1] = "0123456789ABCDEF"[cnonce_bytes[i] & 15];
+    }
     cnonce[64] = '\0';
 
     if (!_cups_strcasecmp(http->qop, "auth"))
@@ -1622,6 +1849,33 @@ httpResolveURI(
 }
 
 
+//
+// 'http_check_encoded()' - Check a percent-encoded URI component.
+//
+
+static const char *			// O - Pointer to terminating character or `NULL` on error
+http_check_encoded(const char *src,	// I - Source pointer
+                   const char *term)	// I - Terminating characters
+{
+  for (; *src && !strchr(term, *src); src ++)
+  {
+    if (*src == '%')
+    {
+      if (!isxdigit(src[1] & 255) || !isxdigit(src[2] & 255))
+        return (NULL);			// Bad hex-encoded character
+
+      src += 2;
+    }
+    else if ((*src & 255) <= 0x20 || (*src & 255) >= 0x7f)
+    {
+      return (NULL);			// Bad control character
+    }
+  }
+
+  return (src);
+}
+
+
 //
 // 'http_copy_decode()' - Copy and decode a URI.
 //
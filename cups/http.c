@@ -20,7 +20,81 @@
 #  include <sys/time.h>
 #  include <sys/resource.h>
 #endif // _WIN32
+#include <sys/stat.h>
+#ifdef HAVE_SENDFILE
+#  include <sys/sendfile.h>
+#endif // HAVE_SENDFILE
 #include <zlib.h>
+#ifdef HAVE_ZSTD
+#  include <zstd.h>
+#endif // HAVE_ZSTD
+#ifdef HAVE_BROTLI
+#  include <brotli/decode.h>
+#  include <brotli/encode.h>
+#endif // HAVE_BROTLI
+#ifndef MSG_DONTWAIT
+#  define MSG_DONTWAIT 0
+#endif // !MSG_DONTWAIT
+
+
+//
+// Local constants...
+//
+
+#ifdef HAVE_BROTLI
+#  define _HTTP_BROTLI_CODING	"br, "	// Brotli in Accept-Encoding
+#else
+#  define _HTTP_BROTLI_CODING	""
+#endif // HAVE_BROTLI
+#ifdef HAVE_ZSTD
+#  define _HTTP_ZSTD_CODING	"zstd, "// Zstandard in Accept-Encoding
+#else
+#  define _HTTP_ZSTD_CODING	""
+#endif // HAVE_ZSTD
+
+
+//
+// Local types...
+//
+
+typedef struct _http_loop_conn_s	// Event loop connection
+{
+  http_t		*http;		// HTTP connection
+  http_loop_events_t	events;		// Events to watch for
+  int			msec;		// Idle timeout in milliseconds
+  double		deadline;	// Time of next timeout event
+  http_loop_cb_t	cb;		// Callback function
+  void			*cb_data;	// Callback data
+  bool			removed;	// Removed from loop?
+} _http_loop_conn_t;
+
+struct _http_loop_s			// Event loop
+{
+  size_t		num_conns,	// Number of connections
+			alloc_conns;	// Allocated connections
+  _http_loop_conn_t	*conns;		// Connections
+  struct pollfd		*pfds;		// Polled file descriptors
+  size_t		alloc_pfds;	// Allocated file descriptors
+  bool			running;	// Dispatching callbacks?
+  int			wake_fds[2];	// Wakeup pipe (socket on Windows)
+};
+
+typedef struct _http_stream_s		// Content coding stream
+{
+  z_stream		z;		// ZLIB stream and (de)compression buffer pointers
+  void			*ctx;		// Zstandard or Brotli state
+  bool			more;		// More decompressed data may be available?
+  char			*pptr;		// Pointer into peek buffer
+  size_t		pused;		// Number of bytes in peek buffer
+  char			pbuffer[HTTP_MAX_BUFFER];
+					// Peek buffer for decompressors that cannot be copied
+} _http_stream_t;
+
+typedef struct _http_pool_s		// Idle connection pool entry
+{
+  http_t		*http;		// Idle connection
+  time_t		idle;		// Time when connection became idle
+} _http_pool_t;
 
 
 //
@@ -28,21 +102,39 @@
 //
 
 static void		http_add_field(http_t *http, http_field_t field, const char *value, bool append);
+static int		http_content_coding_compress(http_t *http, bool finish);
+static int		http_content_coding_decompress(http_t *http);
 static void		http_content_coding_finish(http_t *http);
+static bool		http_content_coding_pending(http_t *http);
 static void		http_content_coding_start(http_t *http, const char *value);
+static void		http_copy_hostname(char *dst, const char *host, size_t dstsize);
 static http_t		*http_create(const char *host, int port, http_addrlist_t *addrlist, int family, http_encryption_t encryption, bool blocking, _http_mode_t mode);
+static double		http_current_time(void);
 #ifdef DEBUG
 static void		http_debug_hex(const char *prefix, const char *buffer, int bytes);
 #endif // DEBUG
+static bool		http_fill_buffer(http_t *http, const char *func);
+static _http_loop_conn_t	*http_loop_find(http_loop_t *loop, http_t *http);
+static http_t		*http_pool_purge(time_t curtime, bool all);
+static bool		http_put(http_t *http, const char *s, size_t len);
+static bool		http_put_field(http_t *http, const char *name, const char *value);
 static ssize_t		http_read(http_t *http, char *buffer, size_t length);
 static ssize_t		http_read_buffered(http_t *http, char *buffer, size_t length);
 static ssize_t		http_read_chunk(http_t *http, char *buffer, size_t length);
+static void		http_read_done(http_t *http);
 static bool		http_send(http_t *http, http_state_t request, const char *uri);
+#ifdef HAVE_SENDFILE
+static ssize_t		http_sendfile(http_t *http, int fd, size_t length);
+#endif // HAVE_SENDFILE
 static ssize_t		http_write(http_t *http, const char *buffer, size_t length);
 static ssize_t		http_write_chunk(http_t *http, const char *buffer, size_t length);
 static off_t		http_set_length(http_t *http);
 static void		http_set_timeout(int fd, double timeout);
 static void		http_set_wait(http_t *http);
+#ifdef HAVE_SPLICE
+static ssize_t		http_splice(http_t *http, int fd, size_t length);
+#endif // HAVE_SPLICE
+static bool		http_tls_start(http_t *http);
 static bool		http_tls_upgrade(http_t *http);
 
 
@@ -51,7 +143,7 @@ static bool		http_tls_upgrade(http_t *http);
 //
 
 static const char * const http_fields[HTTP_FIELD_MAX] =
-{
+{					// Field names (keep sorted for httpFieldValue)
   "Accept",
   "Accept-CH",
   "Accept-Encoding",
@@ -143,6 +235,16 @@ static const char * const http_fields[HTTP_FIELD_MAX] =
   "X-Content-Options",
   "X-Frame-Options"
 };
+static cups_mutex_t	http_pool_mutex = CUPS_MUTEX_INITIALIZER;
+					// Mutex for idle connection pool
+static _http_pool_t	*http_pool = NULL;
+					// Idle connection pool
+static size_t		http_pool_count = 0,
+					// Number of idle connections
+			http_pool_max = 32;
+					// Maximum number of idle connections
+static int		http_pool_timeout = 30;
+					// Maximum idle time in seconds
 
 
 //
@@ -160,30 +262,37 @@ httpAcceptConnection(int  fd,		// I - Listen socket file descriptor
   http_t		*http;		// HTTP connection
   http_addrlist_t	addrlist;	// Dummy address list
   socklen_t		addrlen;	// Length of address
-  int			val;		// Socket option value
+  int			cfd,		// Client socket
+			val;		// Socket option value
 
 
   // Range check input...
   if (fd < 0)
     return (NULL);
 
-  // Create the client connection...
+  // Accept the client and get the remote address...
   memset(&addrlist, 0, sizeof(addrlist));
 
-  if ((http = http_create(NULL, 0, &addrlist, AF_UNSPEC, HTTP_ENCRYPTION_IF_REQUESTED, blocking, _HTTP_MODE_SERVER)) == NULL)
-    return (NULL);
-
-  // Accept the client and get the remote address...
   addrlen = sizeof(http_addr_t);
 
-  if ((http->fd = accept(fd, (struct sockaddr *)&(http->hostlist->addr), &addrlen)) < 0)
+#ifdef HAVE_ACCEPT4
+  if ((cfd = accept4(fd, (struct sockaddr *)&(addrlist.addr), &addrlen, SOCK_CLOEXEC)) < 0)
+#else
+  if ((cfd = accept(fd, (struct sockaddr *)&(addrlist.addr), &addrlen)) < 0)
+#endif // HAVE_ACCEPT4
   {
     _cupsSetHTTPError(HTTP_STATUS_ERROR);
-    httpClose(http);
+    return (NULL);
+  }
 
+  // Create the client connection...
+  if ((http = http_create(NULL, 0, &addrlist, AF_UNSPEC, HTTP_ENCRYPTION_IF_REQUESTED, blocking, _HTTP_MODE_SERVER)) == NULL)
+  {
+    httpAddrClose(NULL, cfd);
     return (NULL);
   }
 
+  http->fd       = cfd;
   http->hostaddr = &(http->hostlist->addr);
 
   if (httpAddrIsLocalhost(http->hostaddr))
@@ -205,16 +314,141 @@ httpAcceptConnection(int  fd,		// I - Listen socket file descriptor
   if (setsockopt(http->fd, IPPROTO_TCP, TCP_NODELAY, CUPS_SOCAST &val, sizeof(val)))
     DEBUG_printf("httpAcceptConnection: setsockopt(TCP_NODELAY) failed - %s", strerror(errno));
 
-#ifdef FD_CLOEXEC
+#if defined(FD_CLOEXEC) && !defined(HAVE_ACCEPT4)
   // Close this socket when starting another process...
   if (fcntl(http->fd, F_SETFD, FD_CLOEXEC))
     DEBUG_printf("httpAcceptConnection: fcntl(F_SETFD, FD_CLOEXEC) failed - %s", strerror(errno));
-#endif // FD_CLOEXEC
+#endif // FD_CLOEXEC && !HAVE_ACCEPT4
 
   return (http);
 }
 
 
+//
+// 'httpAcceptConnections()' - Accept pending HTTP client connections.
+//
+// This function accepts up to "max_https" pending HTTP client connections from
+// the specified listening socket "fd", stopping when no more connections are
+// pending.  The "blocking" argument specifies whether the new HTTP connections
+// are blocking.
+//
+// The listening socket must be non-blocking, as created by
+// @link httpAddrListenMultiple@, to accept more than one connection at a time.
+//
+
+size_t					// O - Number of connections accepted
+httpAcceptConnections(
+    int    fd,				// I - Listen socket file descriptor
+    bool   blocking,			// I - `true` if the connections should be blocking, `false` otherwise
+    size_t max_https,			// I - Maximum number of connections to accept
+    http_t **https)			// O - HTTP connections
+{
+  size_t	num_https = 0;		// Number of connections
+
+
+  // Range check input...
+  if (fd < 0 || max_https == 0 || !https)
+  {
+    _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(EINVAL), 0);
+    return (0);
+  }
+
+#ifdef _WIN32
+  max_https = 1;
+#else
+  if (!(fcntl(fd, F_GETFL) & O_NONBLOCK))
+    max_https = 1;
+#endif // _WIN32
+
+  // Accept connections until there are none left...
+  while (num_https < max_https && (https[num_https] = httpAcceptConnection(fd, blocking)) != NULL)
+    num_https ++;
+
+  DEBUG_printf("2httpAcceptConnections: Accepted %u connections.", (unsigned)num_https);
+
+  return (num_https);
+}
+
+
+//
+// 'httpAcquireConnection()' - Get a pooled connection or connect to a server.
+//
+// This function returns an idle connection to the specified server from the
+// connection pool or, if none is available, creates a new connection with
+// @link httpConnect@.  Idle connections are matched by hostname, port, address
+// family, encryption, and the current client TLS credentials and are checked
+// to make sure the server has not closed them.
+//
+// Call @link httpReleaseConnection@ to return the connection to the pool when
+// you are done with it, or @link httpClose@ to close it.
+//
+
+http_t *				// O - HTTP connection or `NULL` on error
+httpAcquireConnection(
+    const char        *host,		// I - Host to connect to
+    int               port,		// I - Port number
+    int               family,		// I - Address family to use or `AF_UNSPEC` for any
+    http_encryption_t encryption,	// I - Type of encryption to use
+    bool              blocking,		// I - `true` for blocking connection, `false` for non-blocking
+    int               msec,		// I - Connection timeout in milliseconds, 0 means don't connect
+    int               *cancel)		// I - Pointer to "cancel" variable
+{
+  http_t	*http;			// HTTP connection
+
+
+  DEBUG_printf("httpAcquireConnection(host=\"%s\", port=%d, family=%d, encryption=%d, blocking=%s, msec=%d, cancel=%p)", host, port, family, encryption, blocking ? "true" : "false", msec, (void *)cancel);
+
+  // Range check input...
+  if (!host)
+  {
+    _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(EINVAL), 0);
+    return (NULL);
+  }
+
+  // Look for an idle connection and then fall back to a new connection...
+  if ((http = _httpGetIdleConnection(host, port, family, encryption)) != NULL)
+  {
+    DEBUG_printf("1httpAcquireConnection: Reusing idle connection %p.", (void *)http);
+    httpSetBlocking(http, blocking);
+    return (http);
+  }
+
+  return (httpConnect(host, port, NULL, family, encryption, blocking, msec, cancel));
+}
+
+
+//
+// '_httpCheckConnection()' - Check whether a connection is still established.
+//
+// This function checks whether the server has closed the connection.  Data
+// received on an unencrypted connection that is waiting for a new request
+// also means the server is closing the connection.
+//
+
+bool					// O - `true` if connected, `false` otherwise
+_httpCheckConnection(http_t *http)	// I - HTTP connection
+{
+  char		ch;			// Connection check byte
+  ssize_t	n;			// Number of bytes
+
+
+  if (!http || http->fd < 0)
+    return (false);
+
+#ifdef _WIN32
+  if ((n = recv(http->fd, &ch, 1, MSG_PEEK)) == 0 || (n < 0 && WSAGetLastError() != WSAEWOULDBLOCK))
+#else
+  if ((n = recv(http->fd, &ch, 1, MSG_PEEK | MSG_DONTWAIT)) == 0 || (n < 0 && errno != EWOULDBLOCK && errno != EAGAIN))
+#endif // _WIN32
+    return (false);
+
+  if (n > 0 && !http->tls && http->state == HTTP_STATE_WAITING && http->used == 0)
+    return (false);
+
+  return (true);
+}
+
+
 //
 // 'httpClearCookie()' - Clear the cookie value(s).
 //
@@ -227,7 +461,7 @@ httpClearCookie(http_t *http)		// I - HTTP connection
 
   if (http->cookie)
   {
-    free(http->cookie);
+    _cupsMemFree(http->cookie);
     http->cookie = NULL;
   }
 }
@@ -249,7 +483,7 @@ httpClearFields(http_t *http)		// I - HTTP connection
   {
     for (field = HTTP_FIELD_ACCEPT; field < HTTP_FIELD_MAX; field ++)
     {
-      free(http->fields[field]);
+      _cupsMemFree(http->fields[field]);
       http->fields[field] = NULL;
     }
 
@@ -287,11 +521,16 @@ httpClose(http_t *http)			// I - HTTP connection
 
   httpClearFields(http);
 
-  free(http->fields[HTTP_FIELD_HOST]);
-  free(http->authstring);
-  free(http->cookie);
+  _cupsMemFree(http->fields[HTTP_FIELD_HOST]);
+  _cupsMemFree(http->authstring);
+  _cupsMemFree(http->cookie);
 
-  free(http);
+  if (http->rbuffer != http->rdefault)
+    _cupsMemFree(http->rbuffer);
+  if (http->wbuffer != http->wdefault)
+    _cupsMemFree(http->wbuffer);
+
+  _cupsMemFree(http);
 }
 
 
@@ -370,13 +609,30 @@ _httpDisconnect(http_t *http)		// I - HTTP connection
 http_field_t				// O - Field index
 httpFieldValue(const char *name)	// I - String name
 {
-  int	i;				// Looping var
+  int	left,				// Left side of search
+	right,				// Right side of search
+	current,			// Current field
+	result;				// Result of comparison
 
 
-  for (i = 0; i < HTTP_FIELD_MAX; i ++)
+  if (!name)
+    return (HTTP_FIELD_UNKNOWN);
+
+  // The http_fields array is sorted (case-insensitively) so do a binary
+  // search...
+  left  = 0;
+  right = HTTP_FIELD_MAX - 1;
+
+  while (left <= right)
   {
-    if (!_cups_strcasecmp(name, http_fields[i]))
-      return ((http_field_t)i);
+    current = (left + right) / 2;
+
+    if ((result = _cups_strcasecmp(name, http_fields[current])) == 0)
+      return ((http_field_t)current);
+    else if (result < 0)
+      right = current - 1;
+    else
+      left = current + 1;
   }
 
   return (HTTP_FIELD_UNKNOWN);
@@ -526,13 +782,18 @@ httpGetContentEncoding(http_t *http)	// I - HTTP connection
 		*start,			// Start of coding value
 		*end;			// End of coding value
     double	qvalue;			// "qvalue" for coding
-    struct lconv *loc = localeconv();	// Locale data
     static const char * const codings[] =
     {					// Supported content codings
+#ifdef HAVE_BROTLI
+      "br",
+#endif // HAVE_BROTLI
       "deflate",
       "gzip",
       "x-deflate",
-      "x-gzip"
+      "x-gzip",
+#ifdef HAVE_ZSTD
+      "zstd",
+#endif // HAVE_ZSTD
     };
 
     cupsCopyString(temp, http->fields[HTTP_FIELD_ACCEPT_ENCODING], sizeof(temp));
@@ -549,7 +810,7 @@ httpGetContentEncoding(http_t *http)	// I - HTTP connection
       {
         // Grab the qvalue as needed...
         if (!strncmp(end, ";q=", 3))
-          qvalue = _cupsStrScand(end + 3, NULL, loc);
+          qvalue = _cupsStrScand(end + 3, NULL, NULL);
 
         // Skip past all attributes...
         *end++ = '\0';
@@ -665,6 +926,82 @@ httpGetField(http_t       *http,	// I - HTTP connection
 }
 
 
+//
+// '_httpGetIdleConnection()' - Get a matching idle connection from the pool.
+//
+
+http_t *				// O - Idle connection or `NULL` if none
+_httpGetIdleConnection(
+    const char        *host,		// I - Hostname
+    int               port,		// I - Port number
+    int               family,		// I - Address family or `AF_UNSPEC`
+    http_encryption_t encryption)	// I - Encryption
+{
+  http_t	*http;			// Current connection
+  char		hostname[HTTP_MAX_HOST];// Hostname for connection
+  _http_tls_credentials_t *creds;	// Client credentials
+  size_t	i;			// Looping var
+
+
+  // Close any expired connections...
+  while ((http = http_pool_purge(time(NULL), false)) != NULL)
+    httpClose(http);
+
+  // Match the key used by http_create...
+  http_copy_hostname(hostname, host, sizeof(hostname));
+
+  if (port == 443)
+    encryption = HTTP_ENCRYPTION_ALWAYS;
+
+  creds = _cupsGlobals()->credentials;
+
+  for (;;)
+  {
+    // Find the most recently used connection that matches...
+    http = NULL;
+
+    cupsMutexLock(&http_pool_mutex);
+
+    for (i = http_pool_count; i > 0; i --)
+    {
+      http_t *temp = http_pool[i - 1].http;
+					// Pooled connection
+
+      if (strcmp(temp->hostname, hostname) || temp->encryption != encryption || (temp->tls && temp->tls_credentials != creds))
+        continue;
+
+      if (family != AF_UNSPEC && httpAddrGetFamily(temp->hostaddr) != family)
+        continue;
+
+#ifdef AF_LOCAL
+      if (httpAddrGetFamily(temp->hostaddr) != AF_LOCAL && httpAddrGetPort(temp->hostaddr) != port)
+#else
+      if (httpAddrGetPort(temp->hostaddr) != port)
+#endif // AF_LOCAL
+        continue;
+
+      http = temp;
+
+      http_pool_count --;
+      if (i <= http_pool_count)
+        memmove(http_pool + i - 1, http_pool + i, (http_pool_count - i + 1) * sizeof(_http_pool_t));
+      break;
+    }
+
+    cupsMutexUnlock(&http_pool_mutex);
+
+    // Make sure the server hasn't closed it...
+    if (!http || _httpCheckConnection(http))
+      break;
+
+    DEBUG_printf("4_httpGetIdleConnection: Idle connection %p was closed by the server.", (void *)http);
+    httpClose(http);
+  }
+
+  return (http);
+}
+
+
 //
 // 'httpGetKeepAlive()' - Get the current Keep-Alive state of the connection.
 //
@@ -788,10 +1125,11 @@ httpGets(http_t *http,			// I - HTTP connection
 {
   char		*lineptr,		// Pointer into line
 		*lineend,		// End of line
-		*bufptr,		// Pointer into input buffer
-	        *bufend;		// Pointer to end of buffer
-  ssize_t	bytes;			// Number of bytes read
-  int		eol;			// End-of-line?
+		*bufeol,		// End of line in input buffer
+		*crptr,			// Carriage return in line
+		*ptr;			// Pointer into line
+  size_t	count;			// Number of bytes to copy
+  bool		eol;			// End-of-line?
 
 
   DEBUG_printf("2httpGets(http=%p, line=%p, length=%u)", (void *)http, (void *)line, (unsigned)length);
@@ -803,120 +1141,46 @@ httpGets(http_t *http,			// I - HTTP connection
   http->error = 0;
   lineptr     = line;
   lineend     = line + length - 1;
-  eol         = 0;
+  eol         = false;
 
   while (lineptr < lineend)
   {
     // Pre-load the buffer as needed...
-#ifdef _WIN32
-    WSASetLastError(0);
-#else
-    errno = 0;
-#endif // _WIN32
-
-    while (http->used == 0)
-    {
-      // No newline; see if there is more data to be read...
-      while (!_httpWait(http, http->wait_value, 1))
-      {
-	if (http->timeout_cb && (*http->timeout_cb)(http, http->timeout_data))
-	  continue;
+    if (http->used == 0 && !http_fill_buffer(http, "httpGets"))
+      return (NULL);
 
-        DEBUG_puts("3httpGets: Timed out!");
-#ifdef _WIN32
-        http->error = WSAETIMEDOUT;
-#else
-        http->error = ETIMEDOUT;
-#endif // _WIN32
-        return (NULL);
-      }
-
-      bytes = http_read(http, http->buffer + http->used, (size_t)(HTTP_MAX_BUFFER - http->used));
-
-      DEBUG_printf("4httpGets: read " CUPS_LLFMT " bytes.", CUPS_LLCAST bytes);
-
-      if (bytes < 0)
-      {
-        // Nope, can't get a line this time...
-#ifdef _WIN32
-        DEBUG_printf("3httpGets: recv() error %d!", WSAGetLastError());
-
-        if (WSAGetLastError() == WSAEINTR)
-        {
-	  continue;
-	}
-	else if (WSAGetLastError() == WSAEWOULDBLOCK)
-	{
-	  if (http->timeout_cb && (*http->timeout_cb)(http, http->timeout_data))
-	    continue;
-
-	  http->error = WSAGetLastError();
-	}
-	else if (WSAGetLastError() != http->error)
-	{
-	  http->error = WSAGetLastError();
-	  continue;
-	}
+    // Now copy as much of the current line as possible...
+    if ((bufeol = memchr(http->buffer, 0x0a, (size_t)http->used)) != NULL)
+      count = (size_t)(bufeol - http->buffer);
+    else
+      count = (size_t)http->used;
 
-#else
-        DEBUG_printf("3httpGets: recv() error %d!", errno);
+    if (count > (size_t)(lineend - lineptr))
+      count = (size_t)(lineend - lineptr);
+    else if (bufeol)
+      eol = true;
 
-        if (errno == EINTR)
-        {
-	  continue;
-	}
-	else if (errno == EWOULDBLOCK || errno == EAGAIN)
-	{
-	  if (http->timeout_cb && (*http->timeout_cb)(http, http->timeout_data))
-	    continue;
-	  else if (!http->timeout_cb && errno == EAGAIN)
-	    continue;
+    memcpy(lineptr, http->buffer, count);
 
-	  http->error = errno;
-	}
-	else if (errno != http->error)
-	{
-	  http->error = errno;
-	  continue;
-	}
-#endif // _WIN32
+    http->used   -= (int)(count + (eol ? 1 : 0));
+    http->buffer += count + (eol ? 1 : 0);
 
-        return (NULL);
-      }
-      else if (bytes == 0)
+    // Strip carriage returns...
+    if ((crptr = memchr(lineptr, 0x0d, count)) != NULL)
+    {
+      for (ptr = crptr; ptr < (lineptr + count); ptr ++)
       {
-	http->error = EPIPE;
-
-        return (NULL);
+        if (*ptr != 0x0d)
+          *crptr++ = *ptr;
       }
 
-      // Yup, update the amount used...
-      http->used += (int)bytes;
+      lineptr = crptr;
     }
-
-    // Now copy as much of the current line as possible...
-    for (bufptr = http->buffer, bufend = http->buffer + http->used; lineptr < lineend && bufptr < bufend;)
+    else
     {
-      if (*bufptr == 0x0a)
-      {
-        eol = 1;
-	bufptr ++;
-	break;
-      }
-      else if (*bufptr == 0x0d)
-      {
-	bufptr ++;
-      }
-      else
-      {
-	*lineptr++ = *bufptr++;
-      }
+      lineptr += count;
     }
 
-    http->used -= (int)(bufptr - http->buffer);
-    if (http->used > 0)
-      memmove(http->buffer, bufptr, (size_t)http->used);
-
     if (eol)
     {
       // End of line...
@@ -936,6 +1200,67 @@ httpGets(http_t *http,			// I - HTTP connection
 }
 
 
+//
+// 'httpGetsView()' - Get a line of text from a HTTP connection without copying
+//                    it.
+//
+// This function reads a line of text like @link httpGets@ but returns a
+// pointer to the line in the connection's input buffer, which is valid until
+// the next read from the connection.  The line is not nul-terminated - its
+// length, without the trailing CR LF, is returned in "length".  `NULL` is
+// returned if the line is longer than the input buffer.
+//
+
+const char *				// O - Line or `NULL`
+httpGetsView(http_t *http,		// I - HTTP connection
+             size_t *length)		// O - Length of line
+{
+  char		*line,			// Start of line
+		*bufeol;		// End of line in input buffer
+
+
+  DEBUG_printf("2httpGetsView(http=%p, length=%p)", (void *)http, (void *)length);
+
+  if (length)
+    *length = 0;
+
+  if (!http || !length)
+    return (NULL);
+
+  http->error = 0;
+
+  // Read until the buffer contains a full line...
+  while ((bufeol = http->used > 0 ? memchr(http->buffer, 0x0a, (size_t)http->used) : NULL) == NULL)
+  {
+    if (http->used >= http->rsize)
+    {
+      DEBUG_puts("3httpGetsView: Line too long!");
+      http->error = EMSGSIZE;
+      return (NULL);
+    }
+
+    if (!http_fill_buffer(http, "httpGetsView"))
+      return (NULL);
+  }
+
+  line         = http->buffer;
+  http->used   -= (int)(bufeol - line + 1);
+  http->buffer = bufeol + 1;
+
+  // Strip the trailing carriage return...
+  if (bufeol > line && bufeol[-1] == 0x0d)
+    bufeol --;
+
+  http->activity = time(NULL);
+
+  *length = (size_t)(bufeol - line);
+
+  DEBUG_printf("3httpGetsView: Returning \"%.*s\"", (int)*length, line);
+
+  return (line);
+}
+
+
 //
 // 'httpGetState()' - Get the current state of the HTTP request.
 //
@@ -947,6 +1272,33 @@ httpGetState(http_t *http)		// I - HTTP connection
 }
 
 
+//
+// 'httpGetStats()' - Get the statistics for a HTTP connection.
+//
+// This function copies the statistics for the connection to "stats".  The
+// byte and call counts and the time spent waiting for data accumulate over the
+// life of the connection while the other times are for the last connect,
+// handshake, or request.
+//
+
+bool					// O - `true` on success, `false` on error
+httpGetStats(http_t       *http,	// I - HTTP connection
+             http_stats_t *stats)	// O - Connection statistics
+{
+  if (!http || !stats)
+  {
+    if (stats)
+      memset(stats, 0, sizeof(http_stats_t));
+
+    return (false);
+  }
+
+  *stats = http->stats;
+
+  return (true);
+}
+
+
 //
 // 'httpGetStatus()' - Get the status of the last HTTP request.
 //
@@ -1142,13 +1494,431 @@ httpIsEncrypted(http_t *http)		// I - HTTP connection
 
 
 //
-// 'httpPeek()' - Peek at data from a HTTP connection.
+// 'httpLoopAdd()' - Add a connection to an event loop.
 //
-// This function copies available data from the given HTTP connection, reading
-// a buffer as needed.  The data is still available for reading using
-// @link httpRead@.
+// This function adds a connection to the event loop or updates the events,
+// timeout, and callback for a connection that is already in the loop.
 //
-// For non-blocking connections the usual timeouts apply.
+// The "events" argument specifies the events to watch for -
+// `HTTP_LOOP_READ` to be notified when data can be read from the connection
+// and/or `HTTP_LOOP_WRITE` to be notified when data can be written to the
+// connection.  Errors are always reported using `HTTP_LOOP_ERROR`.
+//
+// The "msec" argument specifies an idle timeout in milliseconds - when no
+// other event is reported for that long the callback is called with
+// `HTTP_LOOP_TIMEOUT`.  Specify `0` for no timeout.
+//
+// The callback is called from @link httpLoopRun@ with the events that are
+// ready and should return `true` to keep watching the connection or `false` to
+// remove it from the loop.  Connections should be non-blocking (see
+// @link httpSetBlocking@) so that the callback can use @link httpUpdate@,
+// @link httpRead@, and @link httpWrite@ without stalling other connections.
+// The callback may add and remove connections, but must not delete the loop.
+//
+
+bool					// O - `true` on success, `false` on error
+httpLoopAdd(
+    http_loop_t        *loop,		// I - Event loop
+    http_t             *http,		// I - HTTP connection
+    http_loop_events_t events,		// I - Events to watch for (`HTTP_LOOP_READ` and/or `HTTP_LOOP_WRITE`)
+    int                msec,		// I - Idle timeout in milliseconds or `0` for none
+    http_loop_cb_t     cb,		// I - Callback function
+    void               *cb_data)	// I - Callback data
+{
+  _http_loop_conn_t	*conn;		// Connection
+
+
+  DEBUG_printf("httpLoopAdd(loop=%p, http=%p, events=%u, msec=%d, cb=%p, cb_data=%p)", (void *)loop, (void *)http, events, msec, (void *)cb, cb_data);
+
+  if (!loop || !http || !cb || (events & (unsigned)~(HTTP_LOOP_READ | HTTP_LOOP_WRITE)))
+  {
+    _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(EINVAL), 0);
+    return (false);
+  }
+
+  if ((conn = http_loop_find(loop, http)) == NULL)
+  {
+    if (loop->num_conns >= loop->alloc_conns)
+    {
+      if ((conn = _cupsMemRealloc(CUPS_MEMTYPE_HTTP, loop->conns, (loop->alloc_conns + 16) * sizeof(_http_loop_conn_t))) == NULL)
+      {
+	_cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(errno), 0);
+	return (false);
+      }
+
+      loop->conns       = conn;
+      loop->alloc_conns += 16;
+    }
+
+    conn = loop->conns + loop->num_conns;
+    loop->num_conns ++;
+
+    memset(conn, 0, sizeof(_http_loop_conn_t));
+    conn->http = http;
+  }
+
+  conn->events   = events;
+  conn->msec     = msec > 0 ? msec : 0;
+  conn->deadline = msec > 0 ? http_current_time() + 0.001 * msec : 0.0;
+  conn->cb       = cb;
+  conn->cb_data  = cb_data;
+
+  return (true);
+}
+
+
+//
+// 'httpLoopDelete()' - Delete an event loop.
+//
+// This function frees the memory used by an event loop.  The connections in the
+// loop are not closed.
+//
+
+void
+httpLoopDelete(http_loop_t *loop)	// I - Event loop
+{
+  if (!loop)
+    return;
+
+#ifdef _WIN32
+  closesocket(loop->wake_fds[0]);
+#else
+  close(loop->wake_fds[0]);
+  close(loop->wake_fds[1]);
+#endif // _WIN32
+
+  _cupsMemFree(loop->conns);
+  _cupsMemFree(loop->pfds);
+  _cupsMemFree(loop);
+}
+
+
+//
+// 'httpLoopNew()' - Create an event loop for HTTP connections.
+//
+// This function creates an event loop that monitors any number of HTTP
+// connections from a single thread.  Connections are added with
+// @link httpLoopAdd@ and events are dispatched with @link httpLoopRun@.  The
+// event loop is not thread-safe and must only be used from one thread at a
+// time.
+//
+
+http_loop_t *				// O - Event loop or `NULL` on error
+httpLoopNew(void)
+{
+  http_loop_t	*loop;			// Event loop
+#ifdef _WIN32
+  http_addr_t	addr;			// Loopback address for wakeup socket
+  socklen_t	addrlen;		// Length of address
+  u_long	nonblocking = 1;	// Non-blocking I/O
+#endif // _WIN32
+
+
+  if ((loop = _cupsMemCalloc(CUPS_MEMTYPE_HTTP, 1, sizeof(http_loop_t))) == NULL)
+  {
+    _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(errno), 0);
+    return (NULL);
+  }
+
+  // Create the non-blocking wakeup pipe for httpLoopWake - Windows can only
+  // poll sockets, so use a UDP socket that is connected to itself there...
+#ifdef _WIN32
+  memset(&addr, 0, sizeof(addr));
+  addr.ipv4.sin_family      = AF_INET;
+  addr.ipv4.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addrlen                   = sizeof(addr.ipv4);
+
+  if ((loop->wake_fds[0] = (int)socket(AF_INET, SOCK_DGRAM, 0)) < 0)
+  {
+    _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(errno), 0);
+    _cupsMemFree(loop);
+    return (NULL);
+  }
+
+  if (bind(loop->wake_fds[0], (struct sockaddr *)&addr, addrlen) || getsockname(loop->wake_fds[0], (struct sockaddr *)&addr, &addrlen) || connect(loop->wake_fds[0], (struct sockaddr *)&addr, addrlen) || ioctlsocket(loop->wake_fds[0], FIONBIO, &nonblocking))
+  {
+    _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(errno), 0);
+    closesocket(loop->wake_fds[0]);
+    _cupsMemFree(loop);
+    return (NULL);
+  }
+
+  loop->wake_fds[1] = loop->wake_fds[0];
+
+#else
+  if (pipe(loop->wake_fds))
+  {
+    _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(errno), 0);
+    _cupsMemFree(loop);
+    return (NULL);
+  }
+
+  fcntl(loop->wake_fds[0], F_SETFL, fcntl(loop->wake_fds[0], F_GETFL) | O_NONBLOCK);
+  fcntl(loop->wake_fds[0], F_SETFD, FD_CLOEXEC);
+  fcntl(loop->wake_fds[1], F_SETFL, fcntl(loop->wake_fds[1], F_GETFL) | O_NONBLOCK);
+  fcntl(loop->wake_fds[1], F_SETFD, FD_CLOEXEC);
+#endif // _WIN32
+
+  return (loop);
+}
+
+
+//
+// 'httpLoopRemove()' - Remove a connection from an event loop.
+//
+// This function removes a connection from the event loop.  The connection is
+// not closed.
+//
+
+bool					// O - `true` on success, `false` if not in loop
+httpLoopRemove(http_loop_t *loop,	// I - Event loop
+               http_t      *http)	// I - HTTP connection
+{
+  _http_loop_conn_t	*conn;		// Connection
+
+
+  if ((conn = http_loop_find(loop, http)) == NULL)
+    return (false);
+
+  if (loop->running)
+  {
+    // Defer compacting the array until the callbacks are done...
+    conn->removed = true;
+  }
+  else
+  {
+    loop->num_conns --;
+
+    if (conn < (loop->conns + loop->num_conns))
+      memmove(conn, conn + 1, (size_t)(loop->conns + loop->num_conns - conn) * sizeof(_http_loop_conn_t));
+  }
+
+  return (true);
+}
+
+
+//
+// 'httpLoopRun()' - Wait for and dispatch events on an event loop.
+//
+// This function waits up to "msec" milliseconds for events on the connections
+// in the loop and then calls the callback for each connection with events.
+// Specify `-1` to wait indefinitely.  Data that is already buffered by a
+// connection, including decrypted TLS data, is reported as `HTTP_LOOP_READ`
+// without waiting.  The wait also ends early when another thread calls
+// @link httpLoopWake@.
+//
+// The number of connections that were dispatched is returned, which will be
+// `0` if no events occurred before the wait time expired, the loop was woken
+// up, or the loop contains no connections.  `-1` is returned on error.
+//
+
+int					// O - Number of dispatched connections or `-1` on error
+httpLoopRun(http_loop_t *loop,		// I - Event loop
+            int         msec)		// I - Milliseconds to wait or `-1` for indefinitely
+{
+  size_t		i,		// Looping var
+			num_conns;	// Number of connections to poll
+  _http_loop_conn_t	*conn;		// Current connection
+  struct pollfd		*pfd;		// Current polled file descriptor
+  http_loop_events_t	events;		// Ready events
+  double		curtime,	// Current time
+			deadline;	// Earliest deadline
+  int			nfds,		// Result from poll()
+			count = 0;	// Number of dispatched connections
+
+
+  DEBUG_printf("httpLoopRun(loop=%p, msec=%d)", (void *)loop, msec);
+
+  if (!loop || loop->running)
+  {
+    _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(EINVAL), 0);
+    return (-1);
+  }
+
+  if ((num_conns = loop->num_conns) == 0)
+    return (0);
+
+  if ((num_conns + 1) > loop->alloc_pfds)
+  {
+    if ((pfd = _cupsMemRealloc(CUPS_MEMTYPE_HTTP, loop->pfds, (num_conns + 1) * sizeof(struct pollfd))) == NULL)
+    {
+      _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(errno), 0);
+      return (-1);
+    }
+
+    loop->pfds       = pfd;
+    loop->alloc_pfds = num_conns + 1;
+  }
+
+  // Build the poll list, figuring out how long to wait...
+  curtime  = http_current_time();
+  deadline = msec < 0 ? 0.0 : curtime + 0.001 * msec;
+
+  for (i = num_conns, conn = loop->conns, pfd = loop->pfds; i > 0; i --, conn ++, pfd ++)
+  {
+    pfd->fd      = conn->http->fd;
+    pfd->events  = 0;
+    pfd->revents = 0;
+
+    if (conn->events & HTTP_LOOP_READ)
+      pfd->events |= POLLIN;
+    if (conn->events & HTTP_LOOP_WRITE)
+      pfd->events |= POLLOUT;
+
+    if (pfd->fd < 0 || ((conn->events & HTTP_LOOP_READ) && httpGetReady(conn->http)))
+      deadline = curtime;
+    else if (conn->deadline > 0.0 && (deadline == 0.0 || conn->deadline < deadline))
+      deadline = conn->deadline;
+  }
+
+  // The wakeup pipe follows the connections...
+  pfd->fd      = loop->wake_fds[0];
+  pfd->events  = POLLIN;
+  pfd->revents = 0;
+
+  if (deadline == 0.0)
+    msec = -1;
+  else if (deadline <= curtime)
+    msec = 0;
+  else
+    msec = (int)ceil(1000.0 * (deadline - curtime));
+
+  do
+  {
+    nfds = poll(loop->pfds, (nfds_t)(num_conns + 1), msec);
+  }
+#ifdef _WIN32
+  while (nfds < 0 && (WSAGetLastError() == WSAEINTR || WSAGetLastError() == WSAEWOULDBLOCK));
+#else
+  while (nfds < 0 && (errno == EINTR || errno == EAGAIN));
+#endif // _WIN32
+
+  if (nfds < 0)
+  {
+    _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(errno), 0);
+    return (-1);
+  }
+
+  if (loop->pfds[num_conns].revents & POLLIN)
+  {
+    // Drain the wakeup pipe...
+    char	buffer[64];		// Wakeup data
+
+#ifdef _WIN32
+    while (recv(loop->wake_fds[0], buffer, sizeof(buffer), 0) > 0);
+#else
+    while (read(loop->wake_fds[0], buffer, sizeof(buffer)) > 0);
+#endif // _WIN32
+  }
+
+  // Dispatch events - the callbacks may add connections (which can move the
+  // array) and remove connections (which are only marked until we are done),
+  // so always index from the start of the array...
+  curtime       = http_current_time();
+  loop->running = true;
+
+  for (i = 0; i < num_conns; i ++)
+  {
+    conn = loop->conns + i;
+    pfd  = loop->pfds + i;
+
+    if (conn->removed)
+      continue;
+
+    events = HTTP_LOOP_NONE;
+
+    if (pfd->fd < 0 || (pfd->revents & (POLLERR | POLLNVAL)))
+      events |= HTTP_LOOP_ERROR;
+    if ((conn->events & HTTP_LOOP_READ) && (pfd->fd >= 0 && ((pfd->revents & (POLLIN | POLLHUP)) || httpGetReady(conn->http))))
+      events |= HTTP_LOOP_READ;
+    else if (pfd->revents & POLLHUP)
+      events |= HTTP_LOOP_ERROR;
+    if ((conn->events & HTTP_LOOP_WRITE) && (pfd->revents & POLLOUT))
+      events |= HTTP_LOOP_WRITE;
+
+    if (!events && conn->deadline > 0.0 && conn->deadline <= curtime)
+      events = HTTP_LOOP_TIMEOUT;
+
+    if (!events)
+      continue;
+
+    DEBUG_printf("2httpLoopRun: Dispatching events=%u for http=%p.", events, (void *)conn->http);
+
+    count ++;
+
+    if (!(conn->cb)(loop, conn->http, events, conn->cb_data))
+    {
+      loop->conns[i].removed = true;
+    }
+    else
+    {
+      conn = loop->conns + i;
+
+      if (conn->msec > 0)
+        conn->deadline = http_current_time() + 0.001 * conn->msec;
+    }
+  }
+
+  // Compact the connection array...
+  loop->running = false;
+
+  for (i = 0, conn = loop->conns; i < loop->num_conns;)
+  {
+    if (conn->removed)
+    {
+      loop->num_conns --;
+
+      if (i < loop->num_conns)
+	memmove(conn, conn + 1, (loop->num_conns - i) * sizeof(_http_loop_conn_t));
+    }
+    else
+    {
+      i ++;
+      conn ++;
+    }
+  }
+
+  return (count);
+}
+
+
+//
+// 'httpLoopWake()' - Wake up an event loop.
+//
+// This function causes a call to @link httpLoopRun@ that is waiting for events
+// on another thread to return early, for example so the thread can add
+// connections to the loop.  If the loop is not waiting, the next call to
+// @link httpLoopRun@ returns without waiting.
+//
+// Unlike the other event loop functions, this function may be called from any
+// thread.
+//
+
+void
+httpLoopWake(http_loop_t *loop)		// I - Event loop
+{
+  if (!loop)
+    return;
+
+  // The pipe is non-blocking - if it is full then a wakeup is already
+  // pending...
+#ifdef _WIN32
+  if (send(loop->wake_fds[1], "", 1, 0) < 0)
+#else
+  if (write(loop->wake_fds[1], "", 1) < 0)
+#endif // _WIN32
+    DEBUG_printf("httpLoopWake: Unable to write wakeup - %s", strerror(errno));
+}
+
+
+//
+// 'httpPeek()' - Peek at data from a HTTP connection.
+//
+// This function copies available data from the given HTTP connection, reading
+// a buffer as needed.  The data is still available for reading using
+// @link httpRead@.
+//
+// For non-blocking connections the usual timeouts apply.
 //
 
 ssize_t					// O - Number of bytes copied
@@ -1158,6 +1928,7 @@ httpPeek(http_t *http,			// I - HTTP connection
 {
   ssize_t	bytes;			// Bytes read
   char		len[32];		// Length string
+  bool		pending;		// Decompressed data pending?
 
 
   DEBUG_printf("httpPeek(http=%p, buffer=%p, length=" CUPS_LLFMT ")", (void *)http, (void *)buffer, CUPS_LLCAST length);
@@ -1171,7 +1942,9 @@ httpPeek(http_t *http,			// I - HTTP connection
   if (length <= 0)
     return (0);
 
-  if (http->data_encoding == HTTP_ENCODING_CHUNKED && http->data_remaining <= 0)
+  pending = http->coding >= _HTTP_CODING_GUNZIP && http_content_coding_pending(http);
+
+  if (http->data_encoding == HTTP_ENCODING_CHUNKED && http->data_remaining <= 0 && !pending)
   {
     DEBUG_puts("2httpPeek: Getting chunk length...");
 
@@ -1202,7 +1975,7 @@ httpPeek(http_t *http,			// I - HTTP connection
 
   DEBUG_printf("2httpPeek: data_remaining=" CUPS_LLFMT, CUPS_LLCAST http->data_remaining);
 
-  if (http->data_remaining <= 0 && http->data_encoding != HTTP_ENCODING_FIELDS)
+  if (http->data_remaining <= 0 && http->data_encoding != HTTP_ENCODING_FIELDS && !pending)
   {
     // A zero-length chunk ends a transfer; unless we are reading POST data, go idle...
     if (http->coding >= _HTTP_CODING_GUNZIP)
@@ -1218,17 +1991,20 @@ httpPeek(http_t *http,			// I - HTTP connection
 
     DEBUG_printf("1httpPeek: 0-length chunk, set state to %s.", httpStateString(http->state));
 
+    if (http->state_cb)
+      (http->state_cb)(http, http->state, http->state_data);
+
     // Prevent future reads for this request...
     http->data_encoding = HTTP_ENCODING_FIELDS;
 
     return (0);
   }
-  else if (length > (size_t)http->data_remaining)
+  else if (http->coding == _HTTP_CODING_IDENTITY && length > (size_t)http->data_remaining)
   {
     length = (size_t)http->data_remaining;
   }
 
-  if (http->used == 0 && (http->coding == _HTTP_CODING_IDENTITY || (http->coding >= _HTTP_CODING_GUNZIP && ((z_stream *)http->stream)->avail_in == 0)))
+  if (http->used == 0 && (http->coding == _HTTP_CODING_IDENTITY || (http->coding >= _HTTP_CODING_GUNZIP && !pending)))
   {
     // Buffer small reads for better performance...
     ssize_t	buflen;			// Length of read for buffer
@@ -1244,13 +2020,14 @@ httpPeek(http_t *http,			// I - HTTP connection
       }
     }
 
-    if ((size_t)http->data_remaining > sizeof(http->buffer))
-      buflen = sizeof(http->buffer);
+    if ((size_t)http->data_remaining > http->rsize)
+      buflen = (ssize_t)http->rsize;
     else
       buflen = (ssize_t)http->data_remaining;
 
     DEBUG_printf("2httpPeek: Reading %d bytes into buffer.", (int)buflen);
-    bytes = http_read(http, http->buffer, (size_t)buflen);
+    http->buffer = http->rbuffer;
+    bytes        = http_read(http, http->buffer, (size_t)buflen);
 
     DEBUG_printf("2httpPeek: Read " CUPS_LLFMT " bytes into buffer.", CUPS_LLCAST bytes);
     if (bytes > 0)
@@ -1267,6 +2044,8 @@ httpPeek(http_t *http,			// I - HTTP connection
   {
     int		zerr;			// Decompressor error
     z_stream	stream;			// Copy of decompressor stream
+    _http_stream_t *hstream = (_http_stream_t *)http->stream;
+					// Content coding stream
 
     memset(&stream, 0, sizeof(stream));
 
@@ -1291,26 +2070,101 @@ httpPeek(http_t *http,			// I - HTTP connection
       memcpy(http->sbuffer + ((z_stream *)http->stream)->avail_in, http->buffer, buflen);
       ((z_stream *)http->stream)->avail_in += buflen;
       http->used            -= (int)buflen;
+      http->buffer          += buflen;
       http->data_remaining  -= (off_t)buflen;
-
-      if (http->used > 0)
-        memmove(http->buffer, http->buffer + buflen, (size_t)http->used);
     }
 
     DEBUG_printf("2httpPeek: length=%d, avail_in=%d", (int)length, (int)((z_stream *)http->stream)->avail_in);
 
-    if (inflateCopy(&stream, (z_stream *)http->stream) != Z_OK)
+    if (http->coding == _HTTP_CODING_GUNZIP || http->coding == _HTTP_CODING_INFLATE)
     {
-      DEBUG_puts("2httpPeek: Unable to copy decompressor stream.");
-      http->error = ENOMEM;
-      return (-1);
+      // Decompress using a copy of the ZLIB stream...
+      if (inflateCopy(&stream, (z_stream *)http->stream) != Z_OK)
+      {
+	DEBUG_puts("2httpPeek: Unable to copy decompressor stream.");
+	http->error = ENOMEM;
+	return (-1);
+      }
+
+      stream.next_out  = (Bytef *)buffer;
+      stream.avail_out = (uInt)length;
+
+      zerr = inflate(&stream, Z_SYNC_FLUSH);
+      inflateEnd(&stream);
     }
+    else
+    {
+      // Other decompressors cannot be copied, so decompress into the peek
+      // buffer that httpRead returns from first.  These decompressors may
+      // need a complete block of input before producing any output...
+      zerr = Z_OK;
 
-    stream.next_out  = (Bytef *)buffer;
-    stream.avail_out = (uInt)length;
+      while (hstream->pused == 0 && zerr == Z_OK)
+      {
+        ssize_t	buflen;			// Additional bytes for buffer
+
+        if (hstream->z.avail_in > 0 || hstream->more)
+        {
+	  hstream->z.next_out  = (Bytef *)hstream->pbuffer;
+	  hstream->z.avail_out = sizeof(hstream->pbuffer);
+
+	  zerr = http_content_coding_decompress(http);
+
+	  hstream->pptr  = hstream->pbuffer;
+	  hstream->pused = sizeof(hstream->pbuffer) - hstream->z.avail_out;
+
+	  if (hstream->pused > 0 || zerr != Z_OK)
+	    break;
+        }
+
+        if ((buflen = HTTP_MAX_BUFFER - (ssize_t)hstream->z.avail_in) <= 0)
+          break;
+
+	if (hstream->z.avail_in > 0 && hstream->z.next_in > http->sbuffer)
+	  memmove(http->sbuffer, hstream->z.next_in, hstream->z.avail_in);
+
+	hstream->z.next_in = http->sbuffer;
+
+        DEBUG_printf("2httpPeek: Reading up to %d more bytes of data into decompression buffer.", (int)buflen);
+
+	if (http->data_remaining > 0)
+	{
+	  if (buflen > http->data_remaining)
+	    buflen = (ssize_t)http->data_remaining;
+
+	  bytes = http_read_buffered(http, (char *)http->sbuffer + hstream->z.avail_in, (size_t)buflen);
+	}
+	else if (http->data_encoding == HTTP_ENCODING_CHUNKED)
+	{
+	  bytes = http_read_chunk(http, (char *)http->sbuffer + hstream->z.avail_in, (size_t)buflen);
+	}
+	else
+	{
+	  bytes = 0;
+	}
+
+	if (bytes < 0)
+	  return (bytes);
+	else if (bytes == 0)
+	  break;
+
+	http->data_remaining -= bytes;
+	hstream->z.avail_in  += (uInt)bytes;
 
-    zerr = inflate(&stream, Z_SYNC_FLUSH);
-    inflateEnd(&stream);
+	if (http->data_remaining <= 0 && http->data_encoding == HTTP_ENCODING_CHUNKED)
+	{
+	  // Read the trailing blank line now...
+	  httpGets(http, len, sizeof(len));
+	}
+      }
+
+      if (length > hstream->pused)
+        length = hstream->pused;
+
+      memcpy(buffer, hstream->pptr, length);
+
+      stream.avail_out = 0;
+    }
 
     if (zerr < Z_OK)
     {
@@ -1323,7 +2177,7 @@ httpPeek(http_t *http,			// I - HTTP connection
       return (-1);
     }
 
-    bytes = (ssize_t)(length - ((z_stream *)http->stream)->avail_out);
+    bytes = (ssize_t)(length - stream.avail_out);
   }
   else if (http->used > 0)
   {
@@ -1435,11 +2289,26 @@ httpRead(http_t *http,			// I - HTTP connection
   if (length <= 0)
     return (0);
 
-  if (http->coding >= _HTTP_CODING_GUNZIP)
+  if (http->coding >= _HTTP_CODING_GUNZIP && ((_http_stream_t *)http->stream)->pused > 0)
+  {
+    // Return data decompressed by httpPeek first...
+    _http_stream_t *stream = (_http_stream_t *)http->stream;
+					// Content coding stream
+
+    if (length > stream->pused)
+      length = stream->pused;
+
+    memcpy(buffer, stream->pptr, length);
+    stream->pptr  += length;
+    stream->pused -= length;
+
+    bytes = (ssize_t)length;
+  }
+  else if (http->coding >= _HTTP_CODING_GUNZIP)
   {
     do
     {
-      if (((z_stream *)http->stream)->avail_in > 0)
+      if (((z_stream *)http->stream)->avail_in > 0 || ((_http_stream_t *)http->stream)->more)
       {
 	int	zerr;			// Decompressor error
 
@@ -1448,7 +2317,7 @@ httpRead(http_t *http,			// I - HTTP connection
 	((z_stream *)http->stream)->next_out  = (Bytef *)buffer;
 	((z_stream *)http->stream)->avail_out = (uInt)length;
 
-	if ((zerr = inflate((z_stream *)http->stream, Z_SYNC_FLUSH)) < Z_OK)
+	if ((zerr = http_content_coding_decompress(http)) < Z_OK)
 	{
 	  DEBUG_printf("2httpRead: zerr=%d", zerr);
 #ifdef DEBUG
@@ -1567,22 +2436,108 @@ httpRead(http_t *http,			// I - HTTP connection
     }
   }
 
+  if (bytes > 0 && http->hash)
+    cupsHashUpdate(http->hash, buffer, (size_t)bytes);
+
   if ((http->coding == _HTTP_CODING_IDENTITY ||
-       (http->coding >= _HTTP_CODING_GUNZIP && ((z_stream *)http->stream)->avail_in == 0)) &&
+       (http->coding >= _HTTP_CODING_GUNZIP && !http_content_coding_pending(http))) &&
       ((http->data_remaining <= 0 && http->data_encoding == HTTP_ENCODING_LENGTH) ||
        (http->data_encoding == HTTP_ENCODING_CHUNKED && bytes == 0)))
+    http_read_done(http);
+
+  return (bytes);
+}
+
+
+//
+// '_httpReadFile()' - Read the next block of message body into a file.
+//
+// This function reads the next block of the message body and writes it to
+// file "fd".  When possible, uncompressed data is moved from the socket to the
+// file directly with `splice()` to avoid copying the data through user space,
+// and the file space for a known content length is reserved with
+// `posix_fallocate()`.  Call it repeatedly until it returns `0` at the end of
+// the message body.
+//
+
+ssize_t					// O - Number of bytes written, `0` at end of message body, or `-1` on error
+_httpReadFile(http_t *http,		// I - HTTP connection
+              int    fd)		// I - File descriptor
+{
+  ssize_t	bytes;			// Bytes read/written
+  char		buffer[32768];		// Copy buffer
+
+
+  DEBUG_printf("_httpReadFile(http=%p, fd=%d)", (void *)http, fd);
+
+  if (!http || fd < 0)
+    return (-1);
+
+#ifdef HAVE_SPLICE
+  if (!http->tls && !http->hash && http->coding == _HTTP_CODING_IDENTITY && http->used == 0 && http->data_remaining > 0 && (http->data_encoding == HTTP_ENCODING_CHUNKED || http->data_encoding == HTTP_ENCODING_LENGTH))
   {
-    if (http->coding >= _HTTP_CODING_GUNZIP)
-      http_content_coding_finish(http);
+    struct stat	fileinfo;		// File information
+    off_t	offset;			// Current file offset
+    size_t	length;			// Number of bytes to receive
 
-    if (http->state == HTTP_STATE_LOCK_RECV || http->state == HTTP_STATE_POST_RECV || http->state == HTTP_STATE_PROPFIND_RECV || http->state == HTTP_STATE_PROPPATCH_RECV)
-      http->state ++;
-    else if (http->state == HTTP_STATE_COPY_SEND || http->state == HTTP_STATE_DELETE_SEND || http->state == HTTP_STATE_GET_SEND || http->state == HTTP_STATE_LOCK_SEND || http->state == HTTP_STATE_MOVE_SEND || http->state == HTTP_STATE_POST_SEND || http->state == HTTP_STATE_PROPFIND_SEND || http->state == HTTP_STATE_PROPPATCH_SEND)
-      http->state = HTTP_STATE_WAITING;
-    else
-      http->state = HTTP_STATE_STATUS;
+    if (!fstat(fd, &fileinfo) && S_ISREG(fileinfo.st_mode) && (offset = lseek(fd, 0, SEEK_CUR)) >= 0)
+    {
+      if (http->data_remaining > _HTTP_MAX_SENDFILE)
+        length = _HTTP_MAX_SENDFILE;
+      else
+        length = (size_t)http->data_remaining;
+
+#  ifdef HAVE_POSIX_FALLOCATE
+      if (http->data_encoding == HTTP_ENCODING_LENGTH && offset + http->data_remaining > fileinfo.st_size)
+        posix_fallocate(fd, offset, http->data_remaining);
+#  endif // HAVE_POSIX_FALLOCATE
 
-    DEBUG_printf("1httpRead: End of content, set state to %s.", httpStateString(http->state));
+      DEBUG_printf("2_httpReadFile: Receiving " CUPS_LLFMT " bytes with splice().", CUPS_LLCAST length);
+
+      http->activity = time(NULL);
+      http->error    = 0;
+
+      if ((bytes = http_splice(http, fd, length)) < 0)
+        return (-1);
+
+      if ((size_t)bytes < length)
+      {
+        // Connection closed early, discard any space reserved past the data...
+        if (ftruncate(fd, offset + bytes))
+          DEBUG_printf("2_httpReadFile: Unable to truncate file: %s", strerror(errno));
+
+        if (!bytes)
+          return (-1);
+      }
+
+      http->data_remaining -= bytes;
+
+      if (http->data_remaining <= 0)
+      {
+        if (http->data_encoding == HTTP_ENCODING_CHUNKED)
+        {
+          // Read the trailing blank line now...
+	  char	len[32];		// Length string
+
+          httpGets(http, len, sizeof(len));
+        }
+        else
+        {
+          // Finish the request like httpRead does...
+          http_read_done(http);
+        }
+      }
+
+      return (bytes);
+    }
+  }
+#endif // HAVE_SPLICE
+
+  // Copy the data through a buffer...
+  if ((bytes = httpRead(http, buffer, sizeof(buffer))) > 0 && write(fd, buffer, (size_t)bytes) < bytes)
+  {
+    http->error = errno;
+    return (-1);
   }
 
   return (bytes);
@@ -1786,6 +2741,7 @@ httpReconnect(http_t *http,		// I - HTTP connection
 	      int    *cancel)		// I - Pointer to "cancel" variable
 {
   http_addrlist_t	*addr;		// Connected address
+  double		start;		// Start time
 #ifdef DEBUG
   http_addrlist_t	*current;	// Current address
   char			temp[256];	// Temporary address string
@@ -1817,12 +2773,16 @@ httpReconnect(http_t *http,		// I - HTTP connection
     http->fd = -1;
   }
 
+  if (http->hostaddr)
+    http->stats.reconnects ++;
+
   // Reset all state (except fields, which may be reused)...
   http->state           = HTTP_STATE_WAITING;
   http->version         = HTTP_VERSION_1_1;
   http->keep_alive      = HTTP_KEEPALIVE_OFF;
   http->data_encoding   = HTTP_ENCODING_FIELDS;
   http->used            = 0;
+  http->buffer          = http->rbuffer;
   http->data_remaining  = 0;
   http->hostaddr        = NULL;
   http->wused           = 0;
@@ -1833,7 +2793,12 @@ httpReconnect(http_t *http,		// I - HTTP connection
     DEBUG_printf("2httpReconnect: Address %s:%d", httpAddrGetString(&(current->addr), temp, sizeof(temp)), httpAddrGetPort(&(current->addr)));
 #endif // DEBUG
 
-  if ((addr = httpAddrConnect(http->hostlist, &(http->fd), msec, cancel)) == NULL)
+  start = http_current_time();
+  addr  = httpAddrConnect(http->hostlist, &(http->fd), msec, cancel);
+
+  http->stats.connect_time = http_current_time() - start;
+
+  if (!addr)
   {
     // Unable to connect...
 #ifdef _WIN32
@@ -1859,7 +2824,7 @@ httpReconnect(http_t *http,		// I - HTTP connection
   if (http->encryption == HTTP_ENCRYPTION_ALWAYS)
   {
     // Always do encryption via SSL.
-    if (!_httpTLSStart(http))
+    if (!http_tls_start(http))
     {
       httpAddrClose(NULL, http->fd);
       http->fd = -1;
@@ -1878,6 +2843,79 @@ httpReconnect(http_t *http,		// I - HTTP connection
 }
 
 
+//
+// 'httpReleaseConnection()' - Return a connection to the connection pool.
+//
+// This function returns a client connection to the idle connection pool so
+// that a later call to @link httpAcquireConnection@ or @link cupsConnectDest@
+// can reuse it.  The connection's fields, cookie, and authorization string are
+// cleared first.  Connections that are not waiting for a new request, that the
+// server will not keep open, or that do not fit in the pool are closed.
+//
+
+void
+httpReleaseConnection(http_t *http)	// I - HTTP connection
+{
+  const char	*connection;		// Connection: field value
+  _http_pool_t	*entry;			// Pool entry
+
+
+  DEBUG_printf("httpReleaseConnection(http=%p)", (void *)http);
+
+  // Range check input...
+  if (!http)
+    return;
+
+  // See if the connection can be reused...
+  connection = http->fields[HTTP_FIELD_CONNECTION];
+
+  if (http->mode != _HTTP_MODE_CLIENT || http->fd < 0 || !http->hostaddr || http->state != HTTP_STATE_WAITING || http->version < HTTP_VERSION_1_1 || http->used > 0 || http->wused > 0 || http->coding != _HTTP_CODING_IDENTITY || (connection && !_cups_strcasecmp(connection, "close")))
+  {
+    DEBUG_puts("1httpReleaseConnection: Closing connection.");
+    httpClose(http);
+    return;
+  }
+
+  // Clear any per-request state...
+  httpClearFields(http);
+  httpClearCookie(http);
+  httpSetAuthString(http, NULL, NULL);
+
+  http->userpass[0]  = '\0';
+  http->digest_tries = 0;
+  http->timeout_cb   = NULL;
+  http->timeout_data = NULL;
+  http->hash         = NULL;
+
+  // Add the connection to the end of the pool...
+  cupsMutexLock(&http_pool_mutex);
+
+  if ((http_pool_count & 15) == 0)
+  {
+    if ((entry = _cupsMemRealloc(CUPS_MEMTYPE_HTTP, http_pool, (http_pool_count + 16) * sizeof(_http_pool_t))) == NULL)
+    {
+      cupsMutexUnlock(&http_pool_mutex);
+      httpClose(http);
+      return;
+    }
+
+    http_pool = entry;
+  }
+
+  entry       = http_pool + http_pool_count;
+  entry->http = http;
+  entry->idle = time(NULL);
+
+  http_pool_count ++;
+
+  cupsMutexUnlock(&http_pool_mutex);
+
+  // Close any expired or excess connections...
+  while ((http = http_pool_purge(time(NULL), false)) != NULL)
+    httpClose(http);
+}
+
+
 //
 // 'httpSetAuthString()' - Set the current authorization string.
 //
@@ -1896,14 +2934,14 @@ httpSetAuthString(http_t     *http,	// I - HTTP connection
   if (!http)
     return;
 
-  free(http->authstring);
+  _cupsMemFree(http->authstring);
 
   if (scheme)
   {
     // Set the current authorization string...
     size_t len = strlen(scheme) + (data ? strlen(data) + 1 : 0) + 1;
 
-    if ((http->authstring = malloc(len)) != NULL)
+    if ((http->authstring = _cupsMemAlloc(CUPS_MEMTYPE_HTTP, len)) != NULL)
     {
       if (data)
 	snprintf(http->authstring, len, "%s %s", scheme, data);
@@ -1939,6 +2977,131 @@ httpSetBlocking(http_t *http,		// I - HTTP connection
 }
 
 
+//
+// 'httpSetBufferSizes()' - Set the sizes of the I/O buffers for a connection.
+//
+// This function sets the size of the incoming ("rsize") and outgoing ("wsize")
+// data buffers used by a connection.  Larger buffers reduce the number of
+// system calls and TLS records for bulk transfers such as print jobs and large
+// IPP responses.  A size of `0` (or any size up to `HTTP_MAX_BUFFER`) selects
+// the default buffer that is part of the connection object.  Sizes larger
+// than 16MiB are not supported.
+//
+// Any buffered output is flushed as needed, and any buffered input is
+// preserved.  The function fails if the buffered input does not fit in the
+// new incoming buffer.
+//
+
+bool					// O - `true` on success, `false` on error
+httpSetBufferSizes(http_t *http,	// I - HTTP connection
+                   size_t rsize,	// I - Size of incoming data buffer in bytes or `0` for default
+                   size_t wsize)	// I - Size of outgoing data buffer in bytes or `0` for default
+{
+  char	*rbuffer,			// New incoming data buffer
+	*wbuffer;			// New outgoing data buffer
+
+
+  // Range check input...
+  if (!http || rsize > _HTTP_MAX_BUFSIZE || wsize > _HTTP_MAX_BUFSIZE)
+  {
+    _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(EINVAL), 0);
+    return (false);
+  }
+
+  if (rsize < sizeof(http->rdefault))
+    rsize = sizeof(http->rdefault);
+  if (wsize < sizeof(http->wdefault))
+    wsize = sizeof(http->wdefault);
+
+  if ((size_t)http->used > rsize)
+  {
+    _cupsSetError(IPP_STATUS_ERROR_INTERNAL, _("Pending input does not fit in buffer."), 1);
+    return (false);
+  }
+
+  // Allocate the new buffers as needed...
+  if (rsize == sizeof(http->rdefault))
+    rbuffer = http->rdefault;
+  else if (rsize == http->rsize)
+    rbuffer = http->rbuffer;
+  else if ((rbuffer = _cupsMemAlloc(CUPS_MEMTYPE_HTTP, rsize)) == NULL)
+  {
+    _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(errno), 0);
+    return (false);
+  }
+
+  if (wsize == sizeof(http->wdefault))
+    wbuffer = http->wdefault;
+  else if (wsize == http->wsize)
+    wbuffer = http->wbuffer;
+  else if ((wbuffer = _cupsMemAlloc(CUPS_MEMTYPE_HTTP, wsize)) == NULL)
+  {
+    _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(errno), 0);
+
+    if (rbuffer != http->rbuffer && rbuffer != http->rdefault)
+      _cupsMemFree(rbuffer);
+
+    return (false);
+  }
+
+  // Move any pending input to the start of the new buffer...
+  if (http->used > 0)
+    memmove(rbuffer, http->buffer, (size_t)http->used);
+
+  if (http->rbuffer != rbuffer && http->rbuffer != http->rdefault)
+    _cupsMemFree(http->rbuffer);
+
+  http->buffer  = rbuffer;
+  http->rbuffer = rbuffer;
+  http->rsize   = rsize;
+
+  // Flush or copy any pending output...
+  if ((size_t)http->wused > wsize)
+    httpFlushWrite(http);
+
+  if (http->wused > 0 && wbuffer != http->wbuffer)
+    memcpy(wbuffer, http->wbuffer, (size_t)http->wused);
+
+  if (http->wbuffer != wbuffer && http->wbuffer != http->wdefault)
+    _cupsMemFree(http->wbuffer);
+
+  http->wbuffer = wbuffer;
+  http->wsize   = wsize;
+
+  return (true);
+}
+
+
+//
+// 'httpSetConnectionPool()' - Set the limits for the idle connection pool.
+//
+// This function sets the maximum number of idle connections ("max_idle") kept
+// by @link httpReleaseConnection@ and the number of seconds ("timeout") an idle
+// connection is kept before it is closed.  A "max_idle" value of `0` disables
+// the pool and closes all idle connections.  The defaults are 32 connections
+// and 30 seconds.
+//
+
+void
+httpSetConnectionPool(size_t max_idle,	// I - Maximum number of idle connections
+                      int    timeout)	// I - Maximum idle time in seconds
+{
+  http_t	*http;			// Expired connection
+
+
+  cupsMutexLock(&http_pool_mutex);
+
+  http_pool_max = max_idle;
+  if (timeout > 0)
+    http_pool_timeout = timeout;
+
+  cupsMutexUnlock(&http_pool_mutex);
+
+  while ((http = http_pool_purge(time(NULL), max_idle == 0)) != NULL)
+    httpClose(http);
+}
+
+
 //
 // 'httpSetCookie()' - Set the cookie value(s).
 //
@@ -1950,10 +3113,10 @@ httpSetCookie(http_t     *http,		// I - Connection
   if (!http)
     return;
 
-  free(http->cookie);
+  _cupsMemFree(http->cookie);
 
   if (cookie)
-    http->cookie = strdup(cookie);
+    http->cookie = _cupsMemStrdup(CUPS_MEMTYPE_HTTP, cookie);
   else
     http->cookie = NULL;
 }
@@ -1978,9 +3141,9 @@ httpSetDefaultField(http_t       *http,	// I - HTTP connection
   if (!http || field <= HTTP_FIELD_UNKNOWN || field >= HTTP_FIELD_MAX)
     return;
 
-  free(http->default_fields[field]);
+  _cupsMemFree(http->default_fields[field]);
 
-  http->default_fields[field] = value ? strdup(value) : NULL;
+  http->default_fields[field] = value ? _cupsMemStrdup(CUPS_MEMTYPE_HTTP, value) : NULL;
 }
 
 
@@ -2016,7 +3179,7 @@ httpSetEncryption(
 
     http->encryption = e;
     if (e != HTTP_ENCRYPTION_IF_REQUESTED && !http->tls)
-      return (_httpTLSStart(http));
+      return (http_tls_start(http));
     else
       return (true);
   }
@@ -2060,6 +3223,28 @@ httpSetField(http_t       *http,	// I - HTTP connection
 }
 
 
+//
+// 'httpSetHash()' - Hash the message body data read from a connection.
+//
+// This function adds the (decoded and decompressed) message body data returned
+// by @link httpRead@ to the hash or HMAC context "ctx", so that a digest of a
+// document is available as soon as it has been received.  Data returned by
+// @link httpPeek@ is hashed when it is later read.  Pass `NULL` to stop
+// hashing.
+//
+// The hash context remains owned by the caller and must not be finished until
+// hashing is stopped or the connection is closed.
+//
+
+void
+httpSetHash(http_t      *http,		// I - HTTP connection
+            cups_hash_t *ctx)		// I - Hash context or `NULL` for none
+{
+  if (http)
+    http->hash = ctx;
+}
+
+
 //
 // 'httpSetKeepAlive()' - Set the current Keep-Alive state of a connection.
 //
@@ -2107,6 +3292,28 @@ httpSetLength(http_t *http,		// I - HTTP connection
 }
 
 
+//
+// 'httpSetStateCallback()' - Set a callback for HTTP state changes.
+//
+// This function sets a callback that is called with the new state whenever
+// the state of the connection changes after reading a message header with
+// @link httpUpdate@ or after reading or writing the end of a message body.
+//
+
+void
+httpSetStateCallback(
+    http_t          *http,		// I - HTTP connection
+    http_state_cb_t cb,			// I - Callback function or `NULL` for none
+    void            *cb_data)		// I - Callback data pointer
+{
+  if (!http)
+    return;
+
+  http->state_cb   = cb;
+  http->state_data = cb_data;
+}
+
+
 //
 // 'httpSetTimeout()' - Set read/write timeouts and an optional callback.
 //
@@ -2145,6 +3352,32 @@ httpSetTimeout(
 }
 
 
+//
+// 'httpSetWriteCoalescing()' - Set whether to coalesce response writes.
+//
+// This function controls whether a server connection sends each response as
+// soon as it is written.  When coalescing is enabled, responses with a known
+// length and no content coding stay in the write buffer until it is full, the
+// connection needs to wait for more request data, or @link httpFlushWrite@ is
+// called.  This allows the responses to pipelined requests to be sent
+// together.
+//
+
+void
+httpSetWriteCoalescing(
+    http_t *http,			// I - HTTP connection
+    bool   coalesce)			// I - `true` to coalesce response writes, `false` to send them immediately
+{
+  if (!http)
+    return;
+
+  http->coalesce = coalesce;
+
+  if (!coalesce)
+    httpFlushWrite(http);
+}
+
+
 //
 // 'httpShutdown()' - Shutdown one side of a HTTP connection.
 //
@@ -2181,6 +3414,7 @@ _httpUpdate(http_t        *http,	// I - HTTP connection
 		*value;			// Pointer to value on line
   http_field_t	field;			// Field index
   int		major, minor;		// HTTP version numbers
+  http_state_t	state;			// Previous state
 
 
   DEBUG_printf("_httpUpdate(http=%p, status=%p), state=%s", (void *)http, (void *)status, httpStateString(http->state));
@@ -2213,7 +3447,7 @@ _httpUpdate(http_t        *http,	// I - HTTP connection
 
     if (http->status == HTTP_STATUS_SWITCHING_PROTOCOLS && !http->tls)
     {
-      if (!_httpTLSStart(http))
+      if (!http_tls_start(http))
       {
         httpAddrClose(NULL, http->fd);
         http->fd = -1;
@@ -2234,6 +3468,11 @@ _httpUpdate(http_t        *http,	// I - HTTP connection
       return (false);
     }
 
+    if (http->mode == _HTTP_MODE_CLIENT && http->request_time > 0.0)
+      http->stats.response_time = http_current_time() - http->request_time;
+
+    state = http->state;
+
     switch (http->state)
     {
       case HTTP_STATE_COPY :
@@ -2270,6 +3509,9 @@ _httpUpdate(http_t        *http,	// I - HTTP connection
 	  break;
     }
 
+    if (http->state != state && http->state_cb)
+      (http->state_cb)(http, http->state, http->state_data);
+
     DEBUG_puts("1_httpUpdate: Calling http_content_coding_start.");
     http_content_coding_start(http,
                               httpGetField(http, HTTP_FIELD_CONTENT_ENCODING));
@@ -2292,6 +3534,9 @@ _httpUpdate(http_t        *http,	// I - HTTP connection
 
     http->version = (http_version_t)(major * 100 + minor);
     *status       = http->status = (http_status_t)intstatus;
+
+    if (http->request_time > 0.0)
+      http->stats.first_byte_time = http_current_time() - http->request_time;
   }
   else if ((value = strchr(line, ':')) != NULL)
   {
@@ -2351,8 +3596,8 @@ httpUpdate(http_t *http)		// I - HTTP connection
 
   DEBUG_printf("httpUpdate(http=%p), state=%s", (void *)http, httpStateString(http->state));
 
-  // Flush pending data, if any...
-  if (http->wused)
+  // Flush pending data, if any, unless responses are being coalesced...
+  if (http->wused && !http->coalesce)
   {
     DEBUG_puts("2httpUpdate: flushing buffer...");
 
@@ -2397,6 +3642,7 @@ _httpWait(http_t *http,			// I - HTTP connection
 {
   struct pollfd		pfd;		// Polled file descriptor
   int			nfds;		// Result from select()/poll()
+  double		start;		// Start time
 
 
   DEBUG_printf("4_httpWait(http=%p, msec=%d, usessl=%d)", (void *)http, msec, usessl);
@@ -2417,6 +3663,7 @@ _httpWait(http_t *http,			// I - HTTP connection
   // Then try polling the socket...
   pfd.fd     = http->fd;
   pfd.events = POLLIN;
+  start      = msec ? http_current_time() : 0.0;
 
   do
   {
@@ -2428,6 +3675,9 @@ _httpWait(http_t *http,			// I - HTTP connection
   while (nfds < 0 && (errno == EINTR || errno == EAGAIN));
 #endif // _WIN32
 
+  if (msec)
+    http->stats.wait_time += http_current_time() - start;
+
   DEBUG_printf("5_httpWait: returning with nfds=%d, errno=%d...", nfds, errno);
 
   return (nfds > 0);
@@ -2454,7 +3704,7 @@ httpWait(http_t *http,			// I - HTTP connection
     return (true);
   }
 
-  if (http->coding >= _HTTP_CODING_GUNZIP && ((z_stream *)http->stream)->avail_in > 0)
+  if (http->coding >= _HTTP_CODING_GUNZIP && http_content_coding_pending(http))
   {
     DEBUG_puts("3httpWait: Returning 1 since there is buffered data ready.");
     return (true);
@@ -2501,7 +3751,7 @@ httpWrite(http_t     *http,		// I - HTTP connection
   http->activity = time(NULL);
 
   // Buffer small writes for better performance...
-  if (http->coding == _HTTP_CODING_GZIP || http->coding == _HTTP_CODING_DEFLATE)
+  if (http->coding > _HTTP_CODING_IDENTITY && http->coding < _HTTP_CODING_GUNZIP)
   {
     DEBUG_printf("1httpWrite: http->coding=%d", http->coding);
 
@@ -2518,7 +3768,7 @@ httpWrite(http_t     *http,		// I - HTTP connection
       ((z_stream *)http->stream)->next_in   = (Bytef *)buffer;
       ((z_stream *)http->stream)->avail_in  = (uInt)length;
 
-      while (deflate((z_stream *)http->stream, Z_NO_FLUSH) == Z_OK)
+      while (http_content_coding_compress(http, false) == Z_OK)
       {
         DEBUG_printf("1httpWrite: avail_out=%d", ((z_stream *)http->stream)->avail_out);
 
@@ -2551,14 +3801,14 @@ httpWrite(http_t     *http,		// I - HTTP connection
   }
   else if (length > 0)
   {
-    if (http->wused && (length + (size_t)http->wused) > sizeof(http->wbuffer))
+    if (http->wused && (length + (size_t)http->wused) > http->wsize)
     {
       DEBUG_printf("2httpWrite: Flushing buffer (wused=%d, length=" CUPS_LLFMT ")", http->wused, CUPS_LLCAST length);
 
       httpFlushWrite(http);
     }
 
-    if ((length + (size_t)http->wused) <= sizeof(http->wbuffer) && length < sizeof(http->wbuffer))
+    if ((length + (size_t)http->wused) <= http->wsize && length < http->wsize)
     {
       // Write to buffer...
       DEBUG_printf("2httpWrite: Copying " CUPS_LLFMT " bytes to wbuffer...", CUPS_LLCAST length);
@@ -2593,10 +3843,10 @@ httpWrite(http_t     *http,		// I - HTTP connection
       (http->data_encoding == HTTP_ENCODING_LENGTH && http->data_remaining == 0))
   {
     // Finished with the transfer; unless we are sending POST or PUT data, go idle...
-    if (http->coding == _HTTP_CODING_GZIP || http->coding == _HTTP_CODING_DEFLATE)
+    if (http->coding > _HTTP_CODING_IDENTITY && http->coding < _HTTP_CODING_GUNZIP)
       http_content_coding_finish(http);
 
-    if (http->wused)
+    if (http->wused && (!http->coalesce || http->data_encoding == HTTP_ENCODING_CHUNKED || http->coding != _HTTP_CODING_IDENTITY))
     {
       if (httpFlushWrite(http) < 0)
         return (-1);
@@ -2620,6 +3870,9 @@ httpWrite(http_t     *http,		// I - HTTP connection
       http->state = HTTP_STATE_STATUS;
 
     DEBUG_printf("2httpWrite: Changed state to %s.", httpStateString(http->state));
+
+    if (http->state_cb)
+      (http->state_cb)(http, http->state, http->state_data);
   }
 
   DEBUG_printf("1httpWrite: Returning " CUPS_LLFMT ".", CUPS_LLCAST bytes);
@@ -2628,6 +3881,95 @@ httpWrite(http_t     *http,		// I - HTTP connection
 }
 
 
+//
+// '_httpWriteFile()' - Write the next block of a file to a HTTP connection.
+//
+// This function writes the next block of data from the current position of
+// file "fd".  When possible, regular files are sent to the socket directly
+// with `sendfile()` to avoid copying the data through user space - this
+// includes TLS connections whose record encryption is done by the kernel.
+// Call it repeatedly until it returns `0` at the end of the file.
+//
+
+ssize_t					// O - Number of bytes written, `0` at end of file, or `-1` on error
+_httpWriteFile(http_t *http,		// I - HTTP connection
+               int    fd)		// I - File descriptor
+{
+  ssize_t	bytes;			// Bytes read/written
+  char		buffer[32768];		// Copy buffer
+
+
+  DEBUG_printf("_httpWriteFile(http=%p, fd=%d)", (void *)http, fd);
+
+  if (!http || fd < 0)
+    return (-1);
+
+#ifdef HAVE_SENDFILE
+  if ((!http->tls || _httpTLSCanSendfile(http)) && http->coding == _HTTP_CODING_IDENTITY && (http->data_encoding == HTTP_ENCODING_CHUNKED || http->data_encoding == HTTP_ENCODING_LENGTH))
+  {
+    struct stat	fileinfo;		// File information
+    off_t	offset;			// Current file offset
+    size_t	length;			// Number of bytes to send
+
+    if (!fstat(fd, &fileinfo) && S_ISREG(fileinfo.st_mode) && (offset = lseek(fd, 0, SEEK_CUR)) >= 0)
+    {
+      if (offset >= fileinfo.st_size)
+        return (0);
+
+      if ((fileinfo.st_size - offset) > _HTTP_MAX_SENDFILE)
+        length = _HTTP_MAX_SENDFILE;
+      else
+        length = (size_t)(fileinfo.st_size - offset);
+
+      if (http->data_encoding == HTTP_ENCODING_LENGTH && (off_t)length > http->data_remaining)
+        length = (size_t)http->data_remaining;
+
+      DEBUG_printf("2_httpWriteFile: Sending " CUPS_LLFMT " bytes with sendfile().", CUPS_LLCAST length);
+
+      http->activity = time(NULL);
+
+      if (http->wused && httpFlushWrite(http) < 0)
+        return (-1);
+
+      if (http->data_encoding == HTTP_ENCODING_CHUNKED)
+      {
+	char	header[16];		// Chunk header
+
+        snprintf(header, sizeof(header), "%x\r\n", (unsigned)length);
+        if (http_write(http, header, strlen(header)) < 0)
+          return (-1);
+
+        if ((bytes = http_sendfile(http, fd, length)) < 0 || (size_t)bytes != length)
+          return (-1);
+
+        if (http_write(http, "\r\n", 2) < 0)
+          return (-1);
+      }
+      else
+      {
+        if ((bytes = http_sendfile(http, fd, length)) < 0)
+          return (-1);
+
+        http->data_remaining -= bytes;
+
+        // Finish the request like httpWrite does...
+        if (http->data_remaining <= 0 && httpWrite(http, "", 0) < 0)
+          return (-1);
+      }
+
+      return (bytes);
+    }
+  }
+#endif // HAVE_SENDFILE
+
+  // Copy the file through a buffer...
+  if ((bytes = read(fd, buffer, sizeof(buffer))) > 0)
+    bytes = httpWrite(http, buffer, (size_t)bytes);
+
+  return (bytes);
+}
+
+
 //
 // 'httpWriteRequest()' - Write a HTTP request.
 //
@@ -2687,6 +4029,8 @@ httpWriteResponse(http_t        *http,	// I - HTTP connection
   http_encoding_t	old_encoding;	// Old data_encoding value
   off_t			old_remaining;	// Old data_remaining value
   cups_lang_t		*lang;		// Response language
+  bool			coalesce;	// Coalesce the header with the body?
+  char			line[1024];	// Status line
 
 
   // Range check input...
@@ -2743,7 +4087,7 @@ httpWriteResponse(http_t        *http,	// I - HTTP connection
 
   // Set the Accept-Encoding field if it isn't already...
   if (!http->fields[HTTP_FIELD_ACCEPT_ENCODING])
-    httpSetField(http, HTTP_FIELD_ACCEPT_ENCODING, http->default_fields[HTTP_FIELD_ACCEPT_ENCODING] ? http->default_fields[HTTP_FIELD_ACCEPT_ENCODING] : "gzip, deflate, identity");
+    httpSetField(http, HTTP_FIELD_ACCEPT_ENCODING, http->default_fields[HTTP_FIELD_ACCEPT_ENCODING] ? http->default_fields[HTTP_FIELD_ACCEPT_ENCODING] : _HTTP_ZSTD_CODING _HTTP_BROTLI_CODING "gzip, deflate, identity");
 
   // Get the response language, if any...
   lang = cupsLangFind(http->fields[HTTP_FIELD_CONTENT_LANGUAGE]);
@@ -2753,7 +4097,11 @@ httpWriteResponse(http_t        *http,	// I - HTTP connection
   old_remaining       = http->data_remaining;
   http->data_encoding = HTTP_ENCODING_FIELDS;
 
-  if (httpPrintf(http, "HTTP/%d.%d %d %s\r\n", http->version / 100, http->version % 100, (int)status, _httpStatusString(lang, status)) < 0)
+  // The status line, fields, and trailing blank line are assembled in the
+  // write buffer...
+  snprintf(line, sizeof(line), "HTTP/%d.%d %d %s\r\n", http->version / 100, http->version % 100, (int)status, _httpStatusString(lang, status));
+
+  if (!http_put(http, line, strlen(line)))
   {
     http->status = HTTP_STATUS_ERROR;
     return (false);
@@ -2764,12 +4112,14 @@ httpWriteResponse(http_t        *http,	// I - HTTP connection
     // 100 Continue doesn't have the rest of the response headers...
     int		i;			// Looping var
     const char	*value;			// Field value
+    static const char * const clickjack = "X-Frame-Options: DENY\r\nContent-Security-Policy: frame-ancestors 'none'\r\n";
+					// Click-jacking defense fields
 
     for (i = 0; i < HTTP_FIELD_MAX; i ++)
     {
       if ((value = httpGetField(http, i)) != NULL && *value)
       {
-	if (httpPrintf(http, "%s: %s\r\n", http_fields[i], value) < 1)
+	if (!http_put_field(http, http_fields[i], value))
 	{
 	  http->status = HTTP_STATUS_ERROR;
 	  return (false);
@@ -2781,13 +4131,13 @@ httpWriteResponse(http_t        *http,	// I - HTTP connection
     {
       if (strchr(http->cookie, ';'))
       {
-        if (httpPrintf(http, "Set-Cookie: %s\r\n", http->cookie) < 1)
+        if (!http_put_field(http, "Set-Cookie", http->cookie))
 	{
 	  http->status = HTTP_STATUS_ERROR;
 	  return (false);
 	}
       }
-      else if (httpPrintf(http, "Set-Cookie: %s; path=/; httponly;%s\r\n", http->cookie, http->tls ? " secure;" : "") < 1)
+      else if (!http_put(http, "Set-Cookie: ", 12) || !http_put(http, http->cookie, strlen(http->cookie)) || !http_put(http, "; path=/; httponly;", 19) || (http->tls && !http_put(http, " secure;", 8)) || !http_put(http, "\r\n", 2))
       {
 	http->status = HTTP_STATUS_ERROR;
 	return (false);
@@ -2795,20 +4145,34 @@ httpWriteResponse(http_t        *http,	// I - HTTP connection
     }
 
     // "Click-jacking" defense...
-    if (httpPrintf(http, "X-Frame-Options: DENY\r\nContent-Security-Policy: frame-ancestors 'none'\r\n") < 1)
+    if (!http_put(http, clickjack, strlen(clickjack)))
     {
       http->status = HTTP_STATUS_ERROR;
       return (false);
     }
   }
 
-  if (httpWrite(http, "\r\n", 2) < 2)
+  if (!http_put(http, "\r\n", 2))
   {
     http->status = HTTP_STATUS_ERROR;
     return (false);
   }
 
-  if (httpFlushWrite(http) < 0)
+  // Send the header now unless it can be coalesced with an uncompressed body
+  // of known length...
+  if (http->coalesce && status != HTTP_STATUS_CONTINUE && status != HTTP_STATUS_SWITCHING_PROTOCOLS)
+  {
+    const char *encoding = httpGetField(http, HTTP_FIELD_CONTENT_ENCODING);
+					// Content-Encoding value
+
+    coalesce = httpGetField(http, HTTP_FIELD_CONTENT_LENGTH)[0] && _cups_strcasecmp(httpGetField(http, HTTP_FIELD_TRANSFER_ENCODING), "chunked") && (!*encoding || !strcmp(encoding, "identity"));
+  }
+  else
+  {
+    coalesce = false;
+  }
+
+  if (!coalesce && httpFlushWrite(http) < 0)
   {
     http->status = HTTP_STATUS_ERROR;
     return (false);
@@ -2898,7 +4262,7 @@ http_add_field(http_t       *http,	// I - HTTP connection
 
   if (!append && http->fields[field])
   {
-    free(http->fields[field]);
+    _cupsMemFree(http->fields[field]);
 
     http->fields[field] = NULL;
   }
@@ -2924,7 +4288,7 @@ http_add_field(http_t       *http,	// I - HTTP connection
     // Expand the field value...
     char *mcombined;			// New value string
 
-    if ((mcombined = realloc(http->fields[field], total + 1)) != NULL)
+    if ((mcombined = _cupsMemRealloc(CUPS_MEMTYPE_HTTP, http->fields[field], total + 1)) != NULL)
     {
       http->fields[field] = mcombined;
       cupsConcatString(mcombined, ", ", total + 1);
@@ -2934,7 +4298,7 @@ http_add_field(http_t       *http,	// I - HTTP connection
   else
   {
     // Allocate the field value...
-    http->fields[field] = strdup(value);
+    http->fields[field] = _cupsMemStrdup(CUPS_MEMTYPE_HTTP, value);
   }
 
   DEBUG_printf("1http_add_field: append=%s, field=%d(%s), value=\"%s\".", append ? "true" : "false", field, http_fields[field], http->fields[field]);
@@ -2948,79 +4312,300 @@ http_add_field(http_t       *http,	// I - HTTP connection
 
 
 //
-// 'http_content_coding_finish()' - Finish doing any content encoding.
+// 'http_content_coding_compress()' - Compress data for the current content
+//                                    coding.
+//
+// The return value uses the ZLIB status codes - `Z_OK` when more compression
+// is possible, `Z_BUF_ERROR` when no progress can be made, and `Z_STREAM_END`
+// when the stream has been finished.
 //
 
-static void
-http_content_coding_finish(
-    http_t *http)			// I - HTTP connection
+static int				// O - ZLIB status code
+http_content_coding_compress(
+    http_t *http,			// I - HTTP connection
+    bool   finish)			// I - Finish the stream?
 {
-  int		zerr;			// Compression status
-  Byte		dummy[1];		// Dummy read buffer
-  size_t	bytes;			// Number of bytes to write
-
+  _http_stream_t	*stream = (_http_stream_t *)http->stream;
+					// Content coding stream
 
-  DEBUG_printf("http_content_coding_finish(http=%p)", (void *)http);
-  DEBUG_printf("1http_content_coding_finishing: http->coding=%d", http->coding);
 
   switch (http->coding)
   {
     case _HTTP_CODING_DEFLATE :
     case _HTTP_CODING_GZIP :
-        ((z_stream *)http->stream)->next_in  = dummy;
-        ((z_stream *)http->stream)->avail_in = 0;
+        return (deflate(&stream->z, finish ? Z_FINISH : Z_NO_FLUSH));
 
-        do
+#ifdef HAVE_ZSTD
+    case _HTTP_CODING_ZSTD :
         {
-          zerr  = deflate((z_stream *)http->stream, Z_FINISH);
-	  bytes = _HTTP_MAX_SBUFFER - ((z_stream *)http->stream)->avail_out;
+          ZSTD_inBuffer	in;		// Input buffer
+          ZSTD_outBuffer out;		// Output buffer
+	  size_t	remaining;	// Bytes remaining to be flushed
 
-          if (bytes > 0)
-	  {
-	    DEBUG_printf("1http_content_coding_finish: Writing trailing chunk, len=%d", (int)bytes);
+          if (!finish && stream->z.avail_in == 0 && stream->z.avail_out > 0)
+            return (Z_BUF_ERROR);
+
+          in.src   = stream->z.next_in;
+          in.size  = stream->z.avail_in;
+          in.pos   = 0;
+          out.dst  = stream->z.next_out;
+          out.size = stream->z.avail_out;
+          out.pos  = 0;
+
+          remaining = ZSTD_compressStream2((ZSTD_CCtx *)stream->ctx, &out, &in, finish ? ZSTD_e_end : ZSTD_e_continue);
+
+          if (ZSTD_isError(remaining))
+            return (Z_STREAM_ERROR);
+
+          stream->z.next_in   += in.pos;
+          stream->z.avail_in  -= (uInt)in.pos;
+          stream->z.next_out  += out.pos;
+          stream->z.avail_out -= (uInt)out.pos;
+
+          return (finish && remaining == 0 ? Z_STREAM_END : Z_OK);
+        }
+#endif // HAVE_ZSTD
+
+#ifdef HAVE_BROTLI
+    case _HTTP_CODING_BROTLI :
+        {
+          size_t	avail_in = stream->z.avail_in,
+					// Input bytes available
+			avail_out = stream->z.avail_out;
+					// Output bytes available
+          const uint8_t	*next_in = stream->z.next_in;
+					// Next input byte
+          uint8_t	*next_out = stream->z.next_out;
+					// Next output byte
+
+          if (!finish && avail_in == 0 && avail_out > 0)
+            return (Z_BUF_ERROR);
+
+          if (!BrotliEncoderCompressStream((BrotliEncoderState *)stream->ctx, finish ? BROTLI_OPERATION_FINISH : BROTLI_OPERATION_PROCESS, &avail_in, &next_in, &avail_out, &next_out, NULL))
+            return (Z_STREAM_ERROR);
+
+          stream->z.next_in   = (Bytef *)next_in;
+          stream->z.avail_in  = (uInt)avail_in;
+          stream->z.next_out  = next_out;
+          stream->z.avail_out = (uInt)avail_out;
+
+          return (finish && BrotliEncoderIsFinished((BrotliEncoderState *)stream->ctx) ? Z_STREAM_END : Z_OK);
+        }
+#endif // HAVE_BROTLI
+
+    default :
+        return (Z_STREAM_ERROR);
+  }
+}
+
+
+//
+// 'http_content_coding_decompress()' - Decompress data for the current content
+//                                      coding.
+//
+// The return value uses the ZLIB status codes - `Z_OK` or `Z_STREAM_END` on
+// success and a negative value on error.
+//
+
+static int				// O - ZLIB status code
+http_content_coding_decompress(
+    http_t *http)			// I - HTTP connection
+{
+  int			zerr;		// Decompressor status
+  _http_stream_t	*stream = (_http_stream_t *)http->stream;
+					// Content coding stream
 
-	    if (http->data_encoding == HTTP_ENCODING_CHUNKED)
-	      http_write_chunk(http, (char *)http->sbuffer, bytes);
-	    else
-	      http_write(http, (char *)http->sbuffer, bytes);
+
+  switch (http->coding)
+  {
+    case _HTTP_CODING_INFLATE :
+    case _HTTP_CODING_GUNZIP :
+        if ((zerr = inflate(&stream->z, Z_SYNC_FLUSH)) == Z_BUF_ERROR)
+          zerr = Z_OK;			// No progress is not an error
+        break;
+
+#ifdef HAVE_ZSTD
+    case _HTTP_CODING_UNZSTD :
+        {
+          ZSTD_inBuffer	in;		// Input buffer
+          ZSTD_outBuffer out;		// Output buffer
+
+          in.src   = stream->z.next_in;
+          in.size  = stream->z.avail_in;
+          in.pos   = 0;
+          out.dst  = stream->z.next_out;
+          out.size = stream->z.avail_out;
+          out.pos  = 0;
+
+          zerr = ZSTD_isError(ZSTD_decompressStream((ZSTD_DCtx *)stream->ctx, &out, &in)) ? Z_DATA_ERROR : Z_OK;
+
+          stream->z.next_in   += in.pos;
+          stream->z.avail_in  -= (uInt)in.pos;
+          stream->z.next_out  += out.pos;
+          stream->z.avail_out -= (uInt)out.pos;
+        }
+        break;
+#endif // HAVE_ZSTD
+
+#ifdef HAVE_BROTLI
+    case _HTTP_CODING_UNBROTLI :
+        {
+          size_t	avail_in = stream->z.avail_in,
+					// Input bytes available
+			avail_out = stream->z.avail_out;
+					// Output bytes available
+          const uint8_t	*next_in = stream->z.next_in;
+					// Next input byte
+          uint8_t	*next_out = stream->z.next_out;
+					// Next output byte
+
+          switch (BrotliDecoderDecompressStream((BrotliDecoderState *)stream->ctx, &avail_in, &next_in, &avail_out, &next_out, NULL))
+          {
+            case BROTLI_DECODER_RESULT_ERROR :
+                zerr = Z_DATA_ERROR;
+                break;
+            case BROTLI_DECODER_RESULT_SUCCESS :
+                zerr = Z_STREAM_END;
+                break;
+            default :
+                zerr = Z_OK;
+                break;
           }
 
-          ((z_stream *)http->stream)->next_out  = (Bytef *)http->sbuffer;
-          ((z_stream *)http->stream)->avail_out = (uInt)_HTTP_MAX_SBUFFER;
-	}
-        while (zerr == Z_OK);
+          stream->z.next_in   = (Bytef *)next_in;
+          stream->z.avail_in  = (uInt)avail_in;
+          stream->z.next_out  = next_out;
+          stream->z.avail_out = (uInt)avail_out;
+        }
+        break;
+#endif // HAVE_BROTLI
+
+    default :
+        zerr = Z_STREAM_ERROR;
+        break;
+  }
+
+  // A full output buffer means the decompressor may be holding more data...
+  stream->more = zerr >= Z_OK && stream->z.avail_out == 0;
+
+  return (zerr);
+}
+
+
+//
+// 'http_content_coding_finish()' - Finish doing any content encoding.
+//
+
+static void
+http_content_coding_finish(
+    http_t *http)			// I - HTTP connection
+{
+  int		zerr;			// Compression status
+  Byte		dummy[1];		// Dummy read buffer
+  size_t	bytes;			// Number of bytes to write
+  _http_stream_t *stream = (_http_stream_t *)http->stream;
+					// Content coding stream
+
+
+  DEBUG_printf("http_content_coding_finish(http=%p)", (void *)http);
+  DEBUG_printf("1http_content_coding_finishing: http->coding=%d", http->coding);
 
-        deflateEnd((z_stream *)http->stream);
+  if (http->coding == _HTTP_CODING_IDENTITY || !stream)
+    return;
+
+  if (http->coding < _HTTP_CODING_GUNZIP)
+  {
+    // Flush any remaining compressed data...
+    stream->z.next_in  = dummy;
+    stream->z.avail_in = 0;
+
+    do
+    {
+      zerr  = http_content_coding_compress(http, true);
+      bytes = _HTTP_MAX_SBUFFER - stream->z.avail_out;
 
-        free(http->sbuffer);
-        free(http->stream);
+      if (bytes > 0)
+      {
+	DEBUG_printf("1http_content_coding_finish: Writing trailing chunk, len=%d", (int)bytes);
+
+	if (http->data_encoding == HTTP_ENCODING_CHUNKED)
+	  http_write_chunk(http, (char *)http->sbuffer, bytes);
+	else
+	  http_write(http, (char *)http->sbuffer, bytes);
+      }
 
-        http->sbuffer = NULL;
-        http->stream  = NULL;
+      stream->z.next_out  = (Bytef *)http->sbuffer;
+      stream->z.avail_out = (uInt)_HTTP_MAX_SBUFFER;
+    }
+    while (zerr == Z_OK);
+  }
 
-        if (http->wused)
-          httpFlushWrite(http);
+  switch (http->coding)
+  {
+    case _HTTP_CODING_DEFLATE :
+    case _HTTP_CODING_GZIP :
+        deflateEnd(&stream->z);
         break;
 
     case _HTTP_CODING_INFLATE :
     case _HTTP_CODING_GUNZIP :
-        inflateEnd((z_stream *)http->stream);
+        inflateEnd(&stream->z);
+        break;
 
-        free(http->sbuffer);
-        free(http->stream);
+#ifdef HAVE_ZSTD
+    case _HTTP_CODING_ZSTD :
+        ZSTD_freeCCtx((ZSTD_CCtx *)stream->ctx);
+        break;
 
-        http->sbuffer = NULL;
-        http->stream  = NULL;
+    case _HTTP_CODING_UNZSTD :
+        ZSTD_freeDCtx((ZSTD_DCtx *)stream->ctx);
         break;
+#endif // HAVE_ZSTD
+
+#ifdef HAVE_BROTLI
+    case _HTTP_CODING_BROTLI :
+        BrotliEncoderDestroyInstance((BrotliEncoderState *)stream->ctx);
+        break;
+
+    case _HTTP_CODING_UNBROTLI :
+        BrotliDecoderDestroyInstance((BrotliDecoderState *)stream->ctx);
+        break;
+#endif // HAVE_BROTLI
 
     default :
         break;
   }
 
+  _cupsMemFree(http->sbuffer);
+  _cupsMemFree(http->stream);
+
+  http->sbuffer = NULL;
+  http->stream  = NULL;
+
+  if (http->coding < _HTTP_CODING_GUNZIP && http->wused)
+    httpFlushWrite(http);
+
   http->coding = _HTTP_CODING_IDENTITY;
 }
 
 
+//
+// 'http_content_coding_pending()' - Determine whether decompressed data may be
+//                                   pending.
+//
+
+static bool				// O - `true` if data is pending, `false` otherwise
+http_content_coding_pending(
+    http_t *http)			// I - HTTP connection
+{
+  _http_stream_t	*stream = (_http_stream_t *)http->stream;
+					// Content coding stream
+
+
+  return (stream && (stream->z.avail_in > 0 || stream->more || stream->pused > 0));
+}
+
+
 //
 // 'http_content_coding_start()' - Start doing content encoding.
 //
@@ -3031,7 +4616,10 @@ http_content_coding_start(
     const char *value)			// I - Value of Content-Encoding
 {
   int			zerr;		// Error/status
-  _http_coding_t	coding;		// Content coding value
+  _http_coding_t	coding,		// Content coding value
+			encoder,	// Compressing content coding
+			decoder;	// Decompressing content coding
+  _http_stream_t	*stream;	// Content coding stream
 
 
   DEBUG_printf("http_content_coding_start(http=%p, value=\"%s\")", (void *)http, value);
@@ -3043,132 +4631,178 @@ http_content_coding_start(
   }
   else if (!strcmp(value, "x-gzip") || !strcmp(value, "gzip"))
   {
-    if (http->state == HTTP_STATE_GET_SEND ||
-        http->state == HTTP_STATE_POST_SEND)
-      coding = http->mode == _HTTP_MODE_SERVER ? _HTTP_CODING_GZIP :
-                                                 _HTTP_CODING_GUNZIP;
-    else if (http->state == HTTP_STATE_POST_RECV ||
-             http->state == HTTP_STATE_PUT_RECV)
-      coding = http->mode == _HTTP_MODE_CLIENT ? _HTTP_CODING_GZIP :
-                                                 _HTTP_CODING_GUNZIP;
-    else
-    {
-      DEBUG_puts("1http_content_coding_start: Not doing content coding.");
-      return;
-    }
+    encoder = _HTTP_CODING_GZIP;
+    decoder = _HTTP_CODING_GUNZIP;
   }
   else if (!strcmp(value, "x-deflate") || !strcmp(value, "deflate"))
   {
-    if (http->state == HTTP_STATE_GET_SEND ||
-        http->state == HTTP_STATE_POST_SEND)
-      coding = http->mode == _HTTP_MODE_SERVER ? _HTTP_CODING_DEFLATE :
-                                                 _HTTP_CODING_INFLATE;
-    else if (http->state == HTTP_STATE_POST_RECV ||
-             http->state == HTTP_STATE_PUT_RECV)
-      coding = http->mode == _HTTP_MODE_CLIENT ? _HTTP_CODING_DEFLATE :
-                                                 _HTTP_CODING_INFLATE;
-    else
-    {
-      DEBUG_puts("1http_content_coding_start: Not doing content coding.");
-      return;
-    }
+    encoder = _HTTP_CODING_DEFLATE;
+    decoder = _HTTP_CODING_INFLATE;
+  }
+#ifdef HAVE_ZSTD
+  else if (!strcmp(value, "zstd"))
+  {
+    encoder = _HTTP_CODING_ZSTD;
+    decoder = _HTTP_CODING_UNZSTD;
+  }
+#endif // HAVE_ZSTD
+#ifdef HAVE_BROTLI
+  else if (!strcmp(value, "br"))
+  {
+    encoder = _HTTP_CODING_BROTLI;
+    decoder = _HTTP_CODING_UNBROTLI;
+  }
+#endif // HAVE_BROTLI
+  else
+  {
+    DEBUG_puts("1http_content_coding_start: Not doing content coding.");
+    return;
   }
+
+  if (http->state == HTTP_STATE_GET_SEND ||
+      http->state == HTTP_STATE_POST_SEND)
+    coding = http->mode == _HTTP_MODE_SERVER ? encoder : decoder;
+  else if (http->state == HTTP_STATE_POST_RECV ||
+	   http->state == HTTP_STATE_PUT_RECV)
+    coding = http->mode == _HTTP_MODE_CLIENT ? encoder : decoder;
   else
   {
     DEBUG_puts("1http_content_coding_start: Not doing content coding.");
     return;
   }
 
+  if (coding < _HTTP_CODING_GUNZIP && http->wused)
+    httpFlushWrite(http);
+
+  if ((http->sbuffer = _cupsMemAlloc(CUPS_MEMTYPE_HTTP, _HTTP_MAX_SBUFFER)) == NULL)
+  {
+    http->status = HTTP_STATUS_ERROR;
+    http->error  = errno;
+    return;
+  }
+
+  if ((stream = _cupsMemCalloc(CUPS_MEMTYPE_HTTP, 1, sizeof(_http_stream_t))) == NULL)
+  {
+    _cupsMemFree(http->sbuffer);
+
+    http->sbuffer = NULL;
+    http->status  = HTTP_STATUS_ERROR;
+    http->error   = errno;
+    return;
+  }
+
   switch (coding)
   {
     case _HTTP_CODING_DEFLATE :
     case _HTTP_CODING_GZIP :
-        if (http->wused)
-          httpFlushWrite(http);
-
-        if ((http->sbuffer = malloc(_HTTP_MAX_SBUFFER)) == NULL)
-        {
-          http->status = HTTP_STATUS_ERROR;
-          http->error  = errno;
-          return;
-        }
-
         // Window size for compression is 11 bits - optimal based on PWG Raster
         // sample files on pwg.org.  -11 is raw deflate, 27 is gzip, per ZLIB
         // documentation.
-	if ((http->stream = calloc(1, sizeof(z_stream))) == NULL)
-	{
-          free(http->sbuffer);
-
-          http->sbuffer = NULL;
-          http->status  = HTTP_STATUS_ERROR;
-          http->error   = errno;
-          return;
-	}
-
-        if ((zerr = deflateInit2((z_stream *)http->stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, coding == _HTTP_CODING_DEFLATE ? -11 : 27, 7, Z_DEFAULT_STRATEGY)) < Z_OK)
-        {
-          free(http->sbuffer);
-          free(http->stream);
-
-          http->sbuffer = NULL;
-          http->stream  = NULL;
-          http->status  = HTTP_STATUS_ERROR;
-          http->error   = zerr == Z_MEM_ERROR ? ENOMEM : EINVAL;
-          return;
-        }
-
-	((z_stream *)http->stream)->next_out  = (Bytef *)http->sbuffer;
-	((z_stream *)http->stream)->avail_out = (uInt)_HTTP_MAX_SBUFFER;
+        zerr = deflateInit2(&stream->z, Z_DEFAULT_COMPRESSION, Z_DEFLATED, coding == _HTTP_CODING_DEFLATE ? -11 : 27, 7, Z_DEFAULT_STRATEGY);
         break;
 
     case _HTTP_CODING_INFLATE :
     case _HTTP_CODING_GUNZIP :
-        if ((http->sbuffer = malloc(_HTTP_MAX_SBUFFER)) == NULL)
-        {
-          http->status = HTTP_STATUS_ERROR;
-          http->error  = errno;
-          return;
-        }
-
         // Window size for decompression is up to 15 bits (maximum supported).
         // -15 is raw inflate, 31 is gunzip, per ZLIB documentation.
-	if ((http->stream = calloc(1, sizeof(z_stream))) == NULL)
-	{
-          free(http->sbuffer);
+        zerr = inflateInit2(&stream->z, coding == _HTTP_CODING_INFLATE ? -15 : 31);
+        break;
 
-          http->sbuffer = NULL;
-          http->status  = HTTP_STATUS_ERROR;
-          http->error   = errno;
-          return;
-	}
+#ifdef HAVE_ZSTD
+    case _HTTP_CODING_ZSTD :
+        zerr = (stream->ctx = ZSTD_createCCtx()) != NULL ? Z_OK : Z_MEM_ERROR;
+        break;
+
+    case _HTTP_CODING_UNZSTD :
+        zerr = (stream->ctx = ZSTD_createDCtx()) != NULL ? Z_OK : Z_MEM_ERROR;
+        break;
+#endif // HAVE_ZSTD
 
-        if ((zerr = inflateInit2((z_stream *)http->stream, coding == _HTTP_CODING_INFLATE ? -15 : 31)) < Z_OK)
+#ifdef HAVE_BROTLI
+    case _HTTP_CODING_BROTLI :
+        // Quality 5 gives most of the size benefit at a fraction of the CPU
+        // cost of the default (11) for streamed content.
+        if ((stream->ctx = BrotliEncoderCreateInstance(NULL, NULL, NULL)) != NULL)
         {
-          free(http->sbuffer);
-          free(http->stream);
-
-          http->sbuffer = NULL;
-          http->stream  = NULL;
-          http->status  = HTTP_STATUS_ERROR;
-          http->error   = zerr == Z_MEM_ERROR ? ENOMEM : EINVAL;
-          return;
+          BrotliEncoderSetParameter((BrotliEncoderState *)stream->ctx, BROTLI_PARAM_QUALITY, 5);
+          zerr = Z_OK;
         }
+        else
+        {
+          zerr = Z_MEM_ERROR;
+        }
+        break;
 
-        ((z_stream *)http->stream)->avail_in = 0;
-        ((z_stream *)http->stream)->next_in  = http->sbuffer;
+    case _HTTP_CODING_UNBROTLI :
+        zerr = (stream->ctx = BrotliDecoderCreateInstance(NULL, NULL, NULL)) != NULL ? Z_OK : Z_MEM_ERROR;
         break;
+#endif // HAVE_BROTLI
 
     default :
+        zerr = Z_STREAM_ERROR;
         break;
   }
 
+  if (zerr < Z_OK)
+  {
+    _cupsMemFree(http->sbuffer);
+    _cupsMemFree(stream);
+
+    http->sbuffer = NULL;
+    http->status  = HTTP_STATUS_ERROR;
+    http->error   = zerr == Z_MEM_ERROR ? ENOMEM : EINVAL;
+    return;
+  }
+
+  if (coding < _HTTP_CODING_GUNZIP)
+  {
+    stream->z.next_out  = (Bytef *)http->sbuffer;
+    stream->z.avail_out = (uInt)_HTTP_MAX_SBUFFER;
+  }
+  else
+  {
+    stream->z.avail_in = 0;
+    stream->z.next_in  = http->sbuffer;
+  }
+
+  http->stream = stream;
   http->coding = coding;
 
   DEBUG_printf("1http_content_coding_start: http->coding now %d.", http->coding);
 }
 
 
+//
+// 'http_copy_hostname()' - Copy a hostname in the form used for connections.
+//
+
+static void
+http_copy_hostname(char       *dst,	// I - Destination buffer
+                   const char *host,	// I - Hostname or numeric address
+                   size_t     dstsize)	// I - Size of destination buffer
+{
+  if (!strncmp(host, "fe80::", 6))
+  {
+    // IPv6 link local address, convert to IPvFuture format...
+    char	*zoneid;		// Pointer to zoneid separator
+
+    snprintf(dst, dstsize, "[v1.%s]", host);
+    if ((zoneid = strchr(dst, '%')) != NULL)
+      *zoneid = '+';
+  }
+  else if (isxdigit(host[0]) && isxdigit(host[1]) && isxdigit(host[2]) && isxdigit(host[3]) && host[4] == ':')
+  {
+    // IPv6 address, convert to URI format...
+    snprintf(dst, dstsize, "[%s]", host);
+  }
+  else
+  {
+    // Not an IPv6 numeric address...
+    cupsCopyString(dst, host, dstsize);
+  }
+}
+
+
 //
 // 'http_create()' - Create an unconnected HTTP connection.
 //
@@ -3211,7 +4845,7 @@ http_create(
     return (NULL);
 
   // Allocate memory for the structure...
-  if ((http = calloc(sizeof(http_t), 1)) == NULL)
+  if ((http = _cupsMemCalloc(CUPS_MEMTYPE_HTTP, sizeof(http_t), 1)) == NULL)
   {
     _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(errno), 0);
     httpAddrFreeList(myaddrlist);
@@ -3226,101 +4860,339 @@ http_create(
   http->fd       = -1;
   http->status   = HTTP_STATUS_CONTINUE;
   http->version  = HTTP_VERSION_1_1;
+  http->buffer   = http->rdefault;
+  http->rbuffer  = http->rdefault;
+  http->rsize    = sizeof(http->rdefault);
+  http->wbuffer  = http->wdefault;
+  http->wsize    = sizeof(http->wdefault);
 
   if (host)
   {
     DEBUG_printf("5http_create: host=\"%s\"", host);
 
-    if (!strncmp(host, "fe80::", 6))
+    http_copy_hostname(http->hostname, host, sizeof(http->hostname));
+
+    DEBUG_printf("5http_create: http->hostname=\"%s\"", http->hostname);
+  }
+
+  if (port == 443)			// Always use encryption for https
+    http->encryption = HTTP_ENCRYPTION_ALWAYS;
+  else
+    http->encryption = encryption;
+
+  http_set_wait(http);
+
+  // Return the new structure...
+  return (http);
+}
+
+
+//
+// 'http_current_time()' - Return the current time in seconds.
+//
+
+static double				// O - Current time
+http_current_time(void)
+{
+  struct timeval	curtime;	// Current time
+
+
+  gettimeofday(&curtime, NULL);
+
+  return (curtime.tv_sec + 0.000001 * curtime.tv_usec);
+}
+
+
+#ifdef DEBUG
+//
+// 'http_debug_hex()' - Do a hex dump of a buffer.
+//
+
+static void
+http_debug_hex(const char *prefix,	// I - Prefix for line
+               const char *buffer,	// I - Buffer to dump
+               int        bytes)	// I - Bytes to dump
+{
+  int	i, j,				// Looping vars
+	ch;				// Current character
+  char	line[255],			// Line buffer
+	*start,				// Start of line after prefix
+	*ptr;				// Pointer into line
+
+
+  if (_cups_debug_fd < 0 || _cups_debug_level < 6)
+    return;
+
+  DEBUG_printf("9%s: %d bytes:", prefix, bytes);
+
+  snprintf(line, sizeof(line), "9%s: ", prefix);
+  start = line + strlen(line);
+
+  for (i = 0; i < bytes; i += 16)
+  {
+    for (j = 0, ptr = start; j < 16 && (i + j) < bytes; j ++, ptr += 2)
+      snprintf(ptr, 3, "%02X", buffer[i + j] & 255);
+
+    while (j < 16)
+    {
+      memcpy(ptr, "  ", 3);
+      ptr += 2;
+      j ++;
+    }
+
+    memcpy(ptr, "  ", 3);
+    ptr += 2;
+
+    for (j = 0; j < 16 && (i + j) < bytes; j ++)
+    {
+      ch = buffer[i + j] & 255;
+
+      if (ch < ' ' || ch >= 127)
+	ch = '.';
+
+      *ptr++ = (char)ch;
+    }
+
+    *ptr = '\0';
+    DEBUG_puts(line);
+  }
+}
+#endif // DEBUG
+
+
+//
+// 'http_fill_buffer()' - Read more data into the input buffer.
+//
+// Any data remaining in the input buffer is moved to the start of the buffer
+// before reading.
+//
+
+static bool				// O - `true` on success, `false` on error
+http_fill_buffer(http_t     *http,	// I - HTTP connection
+                 const char *func)	// I - Calling function (for debug messages)
+{
+  ssize_t	bytes;			// Number of bytes read
+
+
+  (void)func;
+
+#ifdef _WIN32
+  WSASetLastError(0);
+#else
+  errno = 0;
+#endif // _WIN32
+
+  for (;;)
+  {
+    // See if there is more data to be read...
+    while (!_httpWait(http, http->wait_value, 1))
     {
-      // IPv6 link local address, convert to IPvFuture format...
-      char	*zoneid;		// Pointer to zoneid separator
+      if (http->timeout_cb && (*http->timeout_cb)(http, http->timeout_data))
+	continue;
 
-      snprintf(http->hostname, sizeof(http->hostname), "[v1.%s]", host);
-      if ((zoneid = strchr(http->hostname, '%')) != NULL)
-        *zoneid = '+';
+      DEBUG_printf("3%s: Timed out!", func);
+#ifdef _WIN32
+      http->error = WSAETIMEDOUT;
+#else
+      http->error = ETIMEDOUT;
+#endif // _WIN32
+      return (false);
     }
-    else if (isxdigit(host[0]) && isxdigit(host[1]) && isxdigit(host[2]) && isxdigit(host[3]) && host[4] == ':')
+
+    // Move any remaining data to the start of the buffer...
+    if (http->used > 0 && http->buffer != http->rbuffer)
+      memmove(http->rbuffer, http->buffer, (size_t)http->used);
+
+    http->buffer = http->rbuffer;
+
+    bytes = http_read(http, http->buffer + http->used, (size_t)(http->rsize - http->used));
+
+    DEBUG_printf("4%s: read " CUPS_LLFMT " bytes.", func, CUPS_LLCAST bytes);
+
+    if (bytes < 0)
     {
-      // IPv6 address, convert to URI format...
-      snprintf(http->hostname, sizeof(http->hostname), "[%s]", host);
+      // Nope, can't get a line this time...
+#ifdef _WIN32
+      DEBUG_printf("3%s: recv() error %d!", func, WSAGetLastError());
+
+      if (WSAGetLastError() == WSAEINTR)
+      {
+	continue;
+      }
+      else if (WSAGetLastError() == WSAEWOULDBLOCK)
+      {
+	if (http->timeout_cb && (*http->timeout_cb)(http, http->timeout_data))
+	  continue;
+
+	http->error = WSAGetLastError();
+      }
+      else if (WSAGetLastError() != http->error)
+      {
+	http->error = WSAGetLastError();
+	continue;
+      }
+
+#else
+      DEBUG_printf("3%s: recv() error %d!", func, errno);
+
+      if (errno == EINTR)
+      {
+	continue;
+      }
+      else if (errno == EWOULDBLOCK || errno == EAGAIN)
+      {
+	if (http->timeout_cb && (*http->timeout_cb)(http, http->timeout_data))
+	  continue;
+	else if (!http->timeout_cb && errno == EAGAIN)
+	  continue;
+
+	http->error = errno;
+      }
+      else if (errno != http->error)
+      {
+	http->error = errno;
+	continue;
+      }
+#endif // _WIN32
+
+      return (false);
     }
-    else
+    else if (bytes == 0)
     {
-      // Not an IPv6 numeric address...
-      cupsCopyString(http->hostname, host, sizeof(http->hostname));
+      http->error = EPIPE;
+
+      return (false);
     }
 
-    DEBUG_printf("5http_create: http->hostname=\"%s\"", http->hostname);
+    // Yup, update the amount used...
+    http->used += (int)bytes;
+
+    return (true);
+  }
+}
+
+
+//
+// 'http_loop_find()' - Find a connection in an event loop.
+//
+
+static _http_loop_conn_t *		// O - Connection or `NULL` if not found
+http_loop_find(http_loop_t *loop,	// I - Event loop
+               http_t      *http)	// I - HTTP connection
+{
+  size_t		i;		// Looping var
+  _http_loop_conn_t	*conn;		// Current connection
+
+
+  if (!loop || !http)
+    return (NULL);
+
+  for (i = loop->num_conns, conn = loop->conns; i > 0; i --, conn ++)
+  {
+    if (conn->http == http && !conn->removed)
+      return (conn);
+  }
+
+  return (NULL);
+}
+
+
+//
+// 'http_pool_purge()' - Remove the oldest connection from the pool if it has
+//                       expired or the pool is full.
+//
+
+static http_t *				// O - Connection to close or `NULL` if none
+http_pool_purge(time_t curtime,		// I - Current time
+                bool   all)		// I - Remove all connections?
+{
+  http_t	*http = NULL;		// Connection to close
+
+
+  cupsMutexLock(&http_pool_mutex);
+
+  if (http_pool_count > 0 && (all || http_pool_count > http_pool_max || (curtime - http_pool[0].idle) > http_pool_timeout))
+  {
+    http = http_pool[0].http;
+
+    http_pool_count --;
+    if (http_pool_count > 0)
+      memmove(http_pool, http_pool + 1, http_pool_count * sizeof(_http_pool_t));
   }
 
-  if (port == 443)			// Always use encryption for https
-    http->encryption = HTTP_ENCRYPTION_ALWAYS;
-  else
-    http->encryption = encryption;
-
-  http_set_wait(http);
+  cupsMutexUnlock(&http_pool_mutex);
 
-  // Return the new structure...
   return (http);
 }
 
 
-#ifdef DEBUG
 //
-// 'http_debug_hex()' - Do a hex dump of a buffer.
+// 'http_put()' - Add header data to the write buffer.
+//
+// The buffer is only flushed when it is full so that the complete header is
+// normally sent in a single write, along with any body data that follows.
 //
 
-static void
-http_debug_hex(const char *prefix,	// I - Prefix for line
-               const char *buffer,	// I - Buffer to dump
-               int        bytes)	// I - Bytes to dump
+static bool				// O - `true` on success, `false` on error
+http_put(http_t     *http,		// I - HTTP connection
+         const char *s,			// I - Header data
+         size_t     len)		// I - Length of header data
 {
-  int	i, j,				// Looping vars
-	ch;				// Current character
-  char	line[255],			// Line buffer
-	*start,				// Start of line after prefix
-	*ptr;				// Pointer into line
+  if (len > (http->wsize - (size_t)http->wused))
+  {
+    // Flush the buffer to make room...
+    if (http->wused && httpFlushWrite(http) < 0)
+      return (false);
 
+    if (len > http->wsize)
+      return (http_write(http, s, len) >= 0);
+  }
 
-  if (_cups_debug_fd < 0 || _cups_debug_level < 6)
-    return;
+  memcpy(http->wbuffer + http->wused, s, len);
+  http->wused += (int)len;
 
-  DEBUG_printf("9%s: %d bytes:", prefix, bytes);
+  return (true);
+}
 
-  snprintf(line, sizeof(line), "9%s: ", prefix);
-  start = line + strlen(line);
 
-  for (i = 0; i < bytes; i += 16)
-  {
-    for (j = 0, ptr = start; j < 16 && (i + j) < bytes; j ++, ptr += 2)
-      snprintf(ptr, 3, "%02X", buffer[i + j] & 255);
+//
+// 'http_put_field()' - Add a "Name: value" header line to the write buffer.
+//
 
-    while (j < 16)
-    {
-      memcpy(ptr, "  ", 3);
-      ptr += 2;
-      j ++;
-    }
+static bool				// O - `true` on success, `false` on error
+http_put_field(http_t     *http,	// I - HTTP connection
+               const char *name,	// I - Field name
+               const char *value)	// I - Field value
+{
+  size_t	namelen = strlen(name),	// Length of field name
+		valuelen = strlen(value);
+					// Length of field value
 
-    memcpy(ptr, "  ", 3);
-    ptr += 2;
 
-    for (j = 0; j < 16 && (i + j) < bytes; j ++)
-    {
-      ch = buffer[i + j] & 255;
+  DEBUG_printf("5http_put_field: %s: %s", name, value);
 
-      if (ch < ' ' || ch >= 127)
-	ch = '.';
+  if ((namelen + valuelen + 4) <= (http->wsize - (size_t)http->wused))
+  {
+    // Copy the whole line at once...
+    char *ptr = http->wbuffer + http->wused;
+					// Pointer into write buffer
 
-      *ptr++ = (char)ch;
-    }
+    memcpy(ptr, name, namelen);
+    ptr += namelen;
+    *ptr++ = ':';
+    *ptr++ = ' ';
+    memcpy(ptr, value, valuelen);
+    ptr += valuelen;
+    *ptr++ = '\r';
+    *ptr++ = '\n';
 
-    *ptr = '\0';
-    DEBUG_puts(line);
+    http->wused = (int)(ptr - http->wbuffer);
+
+    return (true);
   }
+
+  return (http_put(http, name, namelen) && http_put(http, ": ", 2) && http_put(http, value, valuelen) && http_put(http, "\r\n", 2));
 }
-#endif // DEBUG
 
 
 //
@@ -3340,6 +5212,13 @@ http_read(http_t *http,			// I - HTTP connection
 
   DEBUG_printf("7http_read(http=%p, buffer=%p, length=" CUPS_LLFMT ")", (void *)http, (void *)buffer, CUPS_LLCAST length);
 
+  if (http->coalesce && http->wused)
+  {
+    // Send coalesced responses before waiting for more data...
+    if (httpFlushWrite(http) < 0)
+      return (-1);
+  }
+
   if (!http->blocking || http->timeout_value > 0.0)
   {
     while (!httpWait(http, http->wait_value))
@@ -3357,9 +5236,15 @@ http_read(http_t *http,			// I - HTTP connection
   do
   {
     if (http->tls)
+    {
+      http->stats.tls_reads ++;
       bytes = _httpTLSRead(http, buffer, (int)length);
+    }
     else
+    {
+      http->stats.read_calls ++;
       bytes = recv(http->fd, buffer, length, 0);
+    }
 
     if (bytes < 0)
     {
@@ -3405,6 +5290,9 @@ http_read(http_t *http,			// I - HTTP connection
   while (bytes < 0);
 
   DEBUG_printf("8http_read: Read " CUPS_LLFMT " bytes into buffer.", CUPS_LLCAST bytes);
+
+  if (bytes > 0)
+    http->stats.bytes_read += (size_t)bytes;
 #ifdef DEBUG
   if (bytes > 0)
     http_debug_hex("http_read", buffer, (int)bytes);
@@ -3424,6 +5312,9 @@ http_read(http_t *http,			// I - HTTP connection
 // 'http_read_buffered()' - Do a buffered read from a HTTP connection.
 //
 // This function reads data from the HTTP buffer or from the socket, as needed.
+// Reads of at least the input buffer size go directly into the caller's
+// buffer, while smaller reads fill the input buffer so that the following
+// reads (and any chunk header) do not need another system call.
 //
 
 static ssize_t				// O - Number of bytes read or -1 on error
@@ -3446,13 +5337,33 @@ http_read_buffered(http_t *http,	// I - HTTP connection
     DEBUG_printf("8http_read: Grabbing %d bytes from input buffer.", (int)bytes);
 
     memcpy(buffer, http->buffer, (size_t)bytes);
-    http->used -= (int)bytes;
+    http->used   -= (int)bytes;
+    http->buffer += bytes;
+  }
+  else if (length < http->rsize)
+  {
+    // Fill the input buffer and copy from it...
+    http->buffer = http->rbuffer;
+
+    if ((bytes = http_read(http, http->rbuffer, http->rsize)) > 0)
+    {
+      DEBUG_printf("8http_read_buffered: Read %d bytes into input buffer.", (int)bytes);
+
+      http->used = (int)bytes;
+
+      if ((size_t)bytes > length)
+        bytes = (ssize_t)length;
 
-    if (http->used > 0)
-      memmove(http->buffer, http->buffer + bytes, (size_t)http->used);
+      memcpy(buffer, http->buffer, (size_t)bytes);
+      http->used   -= (int)bytes;
+      http->buffer += bytes;
+    }
   }
   else
+  {
+    // Read directly into the caller's buffer...
     bytes = http_read(http, buffer, length);
+  }
 
   return (bytes);
 }
@@ -3520,6 +5431,30 @@ http_read_chunk(http_t *http,		// I - HTTP connection
 }
 
 
+//
+// 'http_read_done()' - Finish reading the message body and update the state.
+//
+
+static void
+http_read_done(http_t *http)		// I - HTTP connection
+{
+  if (http->coding >= _HTTP_CODING_GUNZIP)
+    http_content_coding_finish(http);
+
+  if (http->state == HTTP_STATE_LOCK_RECV || http->state == HTTP_STATE_POST_RECV || http->state == HTTP_STATE_PROPFIND_RECV || http->state == HTTP_STATE_PROPPATCH_RECV)
+    http->state ++;
+  else if (http->state == HTTP_STATE_COPY_SEND || http->state == HTTP_STATE_DELETE_SEND || http->state == HTTP_STATE_GET_SEND || http->state == HTTP_STATE_LOCK_SEND || http->state == HTTP_STATE_MOVE_SEND || http->state == HTTP_STATE_POST_SEND || http->state == HTTP_STATE_PROPFIND_SEND || http->state == HTTP_STATE_PROPPATCH_SEND)
+    http->state = HTTP_STATE_WAITING;
+  else
+    http->state = HTTP_STATE_STATUS;
+
+  DEBUG_printf("1http_read_done: End of content, set state to %s.", httpStateString(http->state));
+
+  if (http->state_cb)
+    (http->state_cb)(http, http->state, http->state_data);
+}
+
+
 //
 // 'http_send()' - Send a request with all fields and the trailing blank line.
 //
@@ -3531,7 +5466,9 @@ http_send(http_t       *http,		// I - HTTP connection
 {
   int		i;			// Looping var
   char		buf[1024];		// Encoded URI buffer
-  const char	*value;			// Field value
+  const char	*value,			// Field value
+		*encoding;		// Content-Encoding value
+  bool		expect = false;		// Expecting 100-continue?
   static const char * const codes[HTTP_STATE_MAX] =
   {					// Request code strings
     NULL,	// WAITING
@@ -3616,7 +5553,8 @@ http_send(http_t       *http,		// I - HTTP connection
   if (request == HTTP_STATE_LOCK || request == HTTP_STATE_POST || request == HTTP_STATE_PROPFIND || request == HTTP_STATE_PROPPATCH || request == HTTP_STATE_PUT)
     http->state ++;
 
-  http->status = HTTP_STATUS_CONTINUE;
+  http->status       = HTTP_STATUS_CONTINUE;
+  http->request_time = http_current_time();
 
   if (http->encryption == HTTP_ENCRYPTION_REQUIRED && !http->tls)
   {
@@ -3624,7 +5562,9 @@ http_send(http_t       *http,		// I - HTTP connection
     httpSetField(http, HTTP_FIELD_UPGRADE, "TLS/1.2,TLS/1.1,TLS/1.0");
   }
 
-  if (httpPrintf(http, "%s %s HTTP/1.1\r\n", codes[request], buf) < 1)
+  // The request line, fields, and trailing blank line are assembled in the
+  // write buffer...
+  if (!http_put(http, codes[request], strlen(codes[request])) || !http_put(http, " ", 1) || !http_put(http, buf, strlen(buf)) || !http_put(http, " HTTP/1.1\r\n", 11))
   {
     http->status = HTTP_STATUS_ERROR;
     return (false);
@@ -3634,17 +5574,19 @@ http_send(http_t       *http,		// I - HTTP connection
   {
     if ((value = httpGetField(http, i)) != NULL && *value)
     {
-      DEBUG_printf("5http_send: %s: %s", http_fields[i], value);
-
       if (i == HTTP_FIELD_HOST)
       {
-	if (httpPrintf(http, "Host: %s:%d\r\n", value, httpAddrGetPort(http->hostaddr)) < 1)
+        char	host[1024];		// Host value with port
+
+        snprintf(host, sizeof(host), "%s:%d", value, httpAddrGetPort(http->hostaddr));
+
+	if (!http_put_field(http, "Host", host))
 	{
 	  http->status = HTTP_STATUS_ERROR;
 	  return (false);
 	}
       }
-      else if (httpPrintf(http, "%s: %s\r\n", http_fields[i], value) < 1)
+      else if (!http_put_field(http, http_fields[i], value))
       {
 	http->status = HTTP_STATUS_ERROR;
 	return (false);
@@ -3654,7 +5596,7 @@ http_send(http_t       *http,		// I - HTTP connection
 
   if (http->cookie)
   {
-    if (httpPrintf(http, "Cookie: $Version=0; %s\r\n", http->cookie) < 1)
+    if (!http_put(http, "Cookie: $Version=0; ", 20) || !http_put(http, http->cookie, strlen(http->cookie)) || !http_put(http, "\r\n", 2))
     {
       http->status = HTTP_STATUS_ERROR;
       return (false);
@@ -3665,21 +5607,30 @@ http_send(http_t       *http,		// I - HTTP connection
 
   if (http->expect == HTTP_STATUS_CONTINUE && http->mode == _HTTP_MODE_CLIENT && (http->state == HTTP_STATE_LOCK_RECV || http->state == HTTP_STATE_POST_RECV || http->state == HTTP_STATE_PROPFIND_RECV || http->state == HTTP_STATE_PROPPATCH_RECV || http->state == HTTP_STATE_PUT_RECV))
   {
-    if (httpPrintf(http, "Expect: 100-continue\r\n") < 1)
+    expect = true;
+
+    if (!http_put_field(http, "Expect", "100-continue"))
     {
       http->status = HTTP_STATUS_ERROR;
       return (false);
     }
   }
 
-  if (httpPrintf(http, "\r\n") < 1)
+  if (!http_put(http, "\r\n", 2))
   {
     http->status = HTTP_STATUS_ERROR;
     return (false);
   }
 
-  if (httpFlushWrite(http) < 0)
-    return (false);
+  // Send the header now unless it can go out with the first bytes of an
+  // uncompressed request body of known length...
+  encoding = httpGetField(http, HTTP_FIELD_CONTENT_ENCODING);
+
+  if (expect || strtoll(httpGetField(http, HTTP_FIELD_CONTENT_LENGTH), NULL, 10) <= 0 || !_cups_strcasecmp(httpGetField(http, HTTP_FIELD_TRANSFER_ENCODING), "chunked") || (*encoding && strcmp(encoding, "identity")))
+  {
+    if (httpFlushWrite(http) < 0)
+      return (false);
+  }
 
   http_set_length(http);
   httpClearFields(http);
@@ -3687,7 +5638,7 @@ http_send(http_t       *http,		// I - HTTP connection
   // Some authentication strings can only be used once...
   if (http->fields[HTTP_FIELD_AUTHORIZATION] && http->authstring)
   {
-    free(http->authstring);
+    _cupsMemFree(http->authstring);
     http->authstring = NULL;
   }
 
@@ -3695,6 +5646,96 @@ http_send(http_t       *http,		// I - HTTP connection
 }
 
 
+#ifdef HAVE_SENDFILE
+//
+// 'http_sendfile()' - Send data from a file to a HTTP connection.
+//
+
+static ssize_t				// O - Number of bytes sent or -1 on error
+http_sendfile(http_t *http,		// I - HTTP connection
+              int    fd,		// I - File descriptor
+              size_t length)		// I - Number of bytes to send
+{
+  ssize_t	tbytes,			// Total bytes sent
+		bytes;			// Bytes sent
+
+
+  DEBUG_printf("7http_sendfile(http=%p, fd=%d, length=" CUPS_LLFMT ")", (void *)http, fd, CUPS_LLCAST length);
+
+  http->error = 0;
+  tbytes      = 0;
+
+  while (length > 0)
+  {
+    if (http->timeout_value > 0.0)
+    {
+      struct pollfd	pfd;		// Polled file descriptor
+      int		nfds;		// Result from poll()
+
+      do
+      {
+	pfd.fd     = http->fd;
+	pfd.events = POLLOUT;
+
+	while ((nfds = poll(&pfd, 1, http->wait_value)) < 0)
+	{
+	  if (errno == EINTR || errno == EAGAIN)
+	    break;
+        }
+
+        if (nfds < 0)
+	{
+	  http->error = errno;
+	  return (-1);
+	}
+	else if (nfds == 0 && (!http->timeout_cb || !(*http->timeout_cb)(http, http->timeout_data)))
+	{
+	  http->error = EWOULDBLOCK;
+	  return (-1);
+	}
+      }
+      while (nfds <= 0);
+    }
+
+    http->stats.write_calls ++;
+
+    if ((bytes = sendfile(http->fd, fd, NULL, length)) < 0)
+    {
+      if (errno == EINTR)
+        continue;
+      else if (errno == EWOULDBLOCK || errno == EAGAIN)
+      {
+	if (http->timeout_cb && (*http->timeout_cb)(http, http->timeout_data))
+          continue;
+        else if (!http->timeout_cb && errno == EAGAIN)
+	  continue;
+      }
+
+      http->error = errno;
+
+      DEBUG_printf("8http_sendfile: error writing data (%s).", strerror(http->error));
+
+      return (-1);
+    }
+    else if (bytes == 0)
+    {
+      // File is shorter than expected...
+      break;
+    }
+
+    tbytes += bytes;
+    length -= (size_t)bytes;
+
+    http->stats.bytes_written += (size_t)bytes;
+  }
+
+  DEBUG_printf("8http_sendfile: Returning " CUPS_LLFMT ".", CUPS_LLCAST tbytes);
+
+  return (tbytes);
+}
+#endif // HAVE_SENDFILE
+
+
 //
 // 'http_set_length()' - Set the data_encoding and data_remaining values.
 //
@@ -3784,6 +5825,127 @@ http_set_wait(http_t *http)		// I - HTTP connection
 }
 
 
+#ifdef HAVE_SPLICE
+//
+// 'http_splice()' - Receive data from a HTTP connection into a file.
+//
+// Data is moved from the socket to the file through a pipe so that it is
+// never copied to user space.  Fewer than "length" bytes are returned only
+// when the connection is closed.
+//
+
+static ssize_t				// O - Number of bytes received or -1 on error
+http_splice(http_t *http,		// I - HTTP connection
+            int    fd,			// I - File descriptor
+            size_t length)		// I - Number of bytes to receive
+{
+  int		pipefd[2];		// Pipe between socket and file
+  ssize_t	tbytes,			// Total bytes received
+		bytes,			// Bytes received
+		pbytes;			// Bytes moved from pipe to file
+  size_t	pused;			// Bytes in the pipe
+
+
+  DEBUG_printf("7http_splice(http=%p, fd=%d, length=" CUPS_LLFMT ")", (void *)http, fd, CUPS_LLCAST length);
+
+  if (pipe(pipefd))
+  {
+    http->error = errno;
+    return (-1);
+  }
+
+  tbytes = 0;
+
+  while (length > 0)
+  {
+    if (!http->blocking || http->timeout_value > 0.0)
+    {
+      while (!httpWait(http, http->wait_value))
+      {
+	if (http->timeout_cb && (*http->timeout_cb)(http, http->timeout_data))
+	  continue;
+
+	DEBUG_puts("8http_splice: Timeout.");
+	http->error = ETIMEDOUT;
+	tbytes      = -1;
+	goto done;
+      }
+    }
+
+    http->stats.read_calls ++;
+
+    if ((bytes = splice(http->fd, NULL, pipefd[1], NULL, length, SPLICE_F_MOVE | SPLICE_F_NONBLOCK)) < 0)
+    {
+      if (errno == EINTR || errno == EWOULDBLOCK || errno == EAGAIN)
+        continue;
+
+      http->error = errno;
+      tbytes      = -1;
+
+      DEBUG_printf("8http_splice: error reading data (%s).", strerror(http->error));
+      goto done;
+    }
+    else if (bytes == 0)
+    {
+      // Connection closed...
+      http->error = EPIPE;
+      break;
+    }
+
+    http->stats.bytes_read += (size_t)bytes;
+
+    for (pused = (size_t)bytes; pused > 0; pused -= (size_t)pbytes)
+    {
+      if ((pbytes = splice(pipefd[0], NULL, fd, NULL, pused, SPLICE_F_MOVE)) <= 0)
+      {
+        if (pbytes < 0 && errno == EINTR)
+        {
+          pbytes = 0;
+          continue;
+        }
+
+        http->error = pbytes < 0 ? errno : EIO;
+        tbytes      = -1;
+
+	DEBUG_printf("8http_splice: error writing data (%s).", strerror(http->error));
+	goto done;
+      }
+    }
+
+    tbytes += bytes;
+    length -= (size_t)bytes;
+  }
+
+  done:
+
+  close(pipefd[0]);
+  close(pipefd[1]);
+
+  return (tbytes);
+}
+#endif // HAVE_SPLICE
+
+
+//
+// 'http_tls_start()' - Start TLS encryption and record the handshake time.
+//
+
+static bool				// O - `true` on success, `false` on failure
+http_tls_start(http_t *http)		// I - HTTP connection
+{
+  bool		ret;			// Return value
+  double	start;			// Start time
+
+
+  start = http_current_time();
+  ret   = _httpTLSStart(http);
+
+  http->stats.tls_time = http_current_time() - start;
+
+  return (ret);
+}
+
+
 //
 // 'http_tls_upgrade()' - Force upgrade to TLS encryption.
 //
@@ -3914,9 +6076,15 @@ http_write(http_t     *http,		// I - HTTP connection
     }
 
     if (http->tls)
+    {
+      http->stats.tls_writes ++;
       bytes = _httpTLSWrite(http, buffer, (int)length);
+    }
     else
+    {
+      http->stats.write_calls ++;
       bytes = send(http->fd, buffer, length, 0);
+    }
 
     DEBUG_printf("8http_write: Write of " CUPS_LLFMT " bytes returned " CUPS_LLFMT ".", CUPS_LLCAST length, CUPS_LLCAST bytes);
 
@@ -3966,6 +6134,8 @@ http_write(http_t     *http,		// I - HTTP connection
     buffer += bytes;
     tbytes += bytes;
     length -= (size_t)bytes;
+
+    http->stats.bytes_written += (size_t)bytes;
   }
 
 #ifdef DEBUG
@@ -225,6 +225,16 @@ typedef enum http_keepalive_e		// HTTP keep-alive values
   HTTP_KEEPALIVE_ON			// Use keep alive
 } http_keepalive_t;
 
+enum http_loop_e			// @link httpLoopAdd@ event bit values
+{
+  HTTP_LOOP_NONE = 0,			// No events
+  HTTP_LOOP_READ = 1,			// Connection has data to read
+  HTTP_LOOP_WRITE = 2,			// Connection can be written without blocking
+  HTTP_LOOP_ERROR = 4,			// Connection has an error or is closed
+  HTTP_LOOP_TIMEOUT = 8			// Connection has been idle for the timeout
+};
+typedef unsigned http_loop_events_t;	// @link httpLoopAdd@ event bitfield
+
 enum http_resolve_e			// @link httpResolveURI@ options bit values
 {
   HTTP_RESOLVE_DEFAULT = 0,		// Resolve with default options
@@ -413,10 +423,47 @@ typedef struct http_addrlist_s		// Socket address list, which is used to enumera
   http_addr_t		addr;		// Address
 } http_addrlist_t;
 
+typedef struct http_stats_s		// HTTP connection statistics
+{
+  size_t		bytes_read,	// Number of bytes read
+			bytes_written,	// Number of bytes written
+			read_calls,	// Number of socket read system calls
+			write_calls,	// Number of socket write system calls
+			tls_reads,	// Number of TLS record reads
+			tls_writes,	// Number of TLS record writes
+			reconnects;	// Number of reconnects
+  double		connect_time,	// Seconds for the last connect
+			tls_time,	// Seconds for the last TLS handshake
+			first_byte_time,// Seconds from the last request to the start of its response
+			response_time,	// Seconds from the last request to the end of its response header
+			wait_time;	// Total seconds spent waiting for data in @link httpWait@
+} http_stats_t;
+
+typedef struct http_uri_part_s		// Component of a URI
+{
+  size_t		offset,		// Offset of component in URI string
+			length;		// Length of component in bytes
+} http_uri_part_t;
+
+typedef struct http_uri_view_s		// Components of a URI, as returned by @link httpSeparateURIView@
+{
+  http_uri_part_t	scheme,		// Scheme (http, https, etc.)
+			username,	// Username (and password)
+			host,		// Hostname or IP address
+			resource;	// Resource path and query string
+  int			port;		// Port number to use
+} http_uri_view_t;
+
 typedef struct _http_s http_t;		// HTTP connection type
 
+typedef struct _http_loop_s http_loop_t;// HTTP event loop
+
+typedef bool (*http_loop_cb_t)(http_loop_t *loop, http_t *http, http_loop_events_t events, void *cb_data);
+					// @link httpLoopAdd@ callback
 typedef bool (*http_resolve_cb_t)(void *data);
 					// @link httpResolveURI@ callback
+typedef void (*http_state_cb_t)(http_t *http, http_state_t state, void *cb_data);
+					// @link httpSetStateCallback@ callback
 typedef bool (*http_timeout_cb_t)(http_t *http, void *user_data);
 					// HTTP timeout callback
 
@@ -426,9 +473,12 @@ typedef bool (*http_timeout_cb_t)(http_t *http, void *user_data);
 //
 
 extern http_t		*httpAcceptConnection(int fd, bool blocking) _CUPS_PUBLIC;
+extern size_t		httpAcceptConnections(int fd, bool blocking, size_t max_https, http_t **https) _CUPS_PUBLIC;
+extern http_t		*httpAcquireConnection(const char *host, int port, int family, http_encryption_t encryption, bool blocking, int msec, int *cancel) _CUPS_PUBLIC;
 extern bool		httpAddrClose(http_addr_t *addr, int fd) _CUPS_PUBLIC;
 extern http_addrlist_t	*httpAddrConnect(http_addrlist_t *addrlist, int *sock, int msec, int *cancel) _CUPS_PUBLIC;
 extern http_addrlist_t	*httpAddrCopyList(http_addrlist_t *src) _CUPS_PUBLIC;
+extern void		httpAddrFlushCache(void) _CUPS_PUBLIC;
 extern void		httpAddrFreeList(http_addrlist_t *addrlist) _CUPS_PUBLIC;
 extern int		httpAddrGetFamily(http_addr_t *addr) _CUPS_PUBLIC;
 extern size_t		httpAddrGetLength(const http_addr_t *addr) _CUPS_PUBLIC;
@@ -439,6 +489,7 @@ extern bool		httpAddrIsAny(const http_addr_t *addr) _CUPS_PUBLIC;
 extern bool		httpAddrIsEqual(const http_addr_t *addr1, const http_addr_t *addr2) _CUPS_PUBLIC;
 extern bool		httpAddrIsLocalhost(const http_addr_t *addr) _CUPS_PUBLIC;
 extern int		httpAddrListen(http_addr_t *addr, int port) _CUPS_PUBLIC;
+extern size_t		httpAddrListenMultiple(http_addr_t *addr, int port, size_t num_fds, int *fds) _CUPS_PUBLIC;
 extern char		*httpAddrLookup(const http_addr_t *addr, char *name, size_t namelen) _CUPS_PUBLIC;
 extern void		httpAddrSetPort(http_addr_t *addr, int port) _CUPS_PUBLIC;
 extern http_uri_status_t httpAssembleURI(http_uri_coding_t encoding, char *uri, size_t urilen, const char *scheme, const char *username, const char *host, int port, const char *resource) _CUPS_PUBLIC;
@@ -479,36 +530,52 @@ extern size_t		httpGetPending(http_t *http) _CUPS_PUBLIC;
 extern size_t		httpGetReady(http_t *http) _CUPS_PUBLIC;
 extern size_t		httpGetRemaining(http_t *http) _CUPS_PUBLIC;
 extern http_state_t	httpGetState(http_t *http) _CUPS_PUBLIC;
+extern bool		httpGetStats(http_t *http, http_stats_t *stats) _CUPS_PUBLIC;
 extern http_status_t	httpGetStatus(http_t *http) _CUPS_PUBLIC;
 extern char		*httpGetSubField(http_t *http, http_field_t field, const char *name, char *value, size_t valuelen) _CUPS_PUBLIC;
 extern http_version_t	httpGetVersion(http_t *http) _CUPS_PUBLIC;
 extern char		*httpGets(http_t *http, char *line, size_t length) _CUPS_PUBLIC;
+extern const char	*httpGetsView(http_t *http, size_t *length) _CUPS_PUBLIC;
 
 extern void		httpInitialize(void) _CUPS_PUBLIC;
 extern bool		httpIsChunked(http_t *http) _CUPS_PUBLIC;
 extern bool		httpIsEncrypted(http_t *http) _CUPS_PUBLIC;
 
+extern bool		httpLoopAdd(http_loop_t *loop, http_t *http, http_loop_events_t events, int msec, http_loop_cb_t cb, void *cb_data) _CUPS_PUBLIC;
+extern void		httpLoopDelete(http_loop_t *loop) _CUPS_PUBLIC;
+extern http_loop_t	*httpLoopNew(void) _CUPS_PUBLIC;
+extern bool		httpLoopRemove(http_loop_t *loop, http_t *http) _CUPS_PUBLIC;
+extern int		httpLoopRun(http_loop_t *loop, int msec) _CUPS_PUBLIC;
+extern void		httpLoopWake(http_loop_t *loop) _CUPS_PUBLIC;
+
 extern ssize_t		httpPeek(http_t *http, char *buffer, size_t length) _CUPS_PUBLIC;
 extern ssize_t		httpPrintf(http_t *http, const char *format, ...) _CUPS_FORMAT(2, 3) _CUPS_PUBLIC;
 
 extern ssize_t		httpRead(http_t *http, char *buffer, size_t length) _CUPS_PUBLIC;
 extern http_state_t	httpReadRequest(http_t *http, char *resource, size_t resourcelen) _CUPS_PUBLIC;
 extern bool		httpReconnect(http_t *http, int msec, int *cancel) _CUPS_PUBLIC;
+extern void		httpReleaseConnection(http_t *http) _CUPS_PUBLIC;
 extern const char	*httpResolveHostname(http_t *http, char *buffer, size_t bufsize) _CUPS_PUBLIC;
 extern const char	*httpResolveURI(const char *uri, char *resolved_uri, size_t resolved_size, http_resolve_t options, http_resolve_cb_t cb, void *cb_data) _CUPS_PUBLIC;
 
 extern http_uri_status_t httpSeparateURI(http_uri_coding_t decoding, const char *uri, char *scheme, size_t schemelen, char *username, size_t usernamelen, char *host, size_t hostlen, int *port, char *resource, size_t resourcelen) _CUPS_PUBLIC;
+extern http_uri_status_t httpSeparateURIView(const char *uri, http_uri_view_t *view) _CUPS_PUBLIC;
 extern void		httpSetAuthString(http_t *http, const char *scheme, const char *data) _CUPS_PUBLIC;
 extern void		httpSetBlocking(http_t *http, bool b) _CUPS_PUBLIC;
+extern bool		httpSetBufferSizes(http_t *http, size_t rsize, size_t wsize) _CUPS_PUBLIC;
+extern void		httpSetConnectionPool(size_t max_idle, int timeout) _CUPS_PUBLIC;
 extern void		httpSetCookie(http_t *http, const char *cookie) _CUPS_PUBLIC;
 extern bool		httpSetCredentialsAndKey(http_t *http, const char *credentials, const char *key) _CUPS_PUBLIC;
 extern void		httpSetDefaultField(http_t *http, http_field_t field, const char *value) _CUPS_PUBLIC;
 extern bool		httpSetEncryption(http_t *http, http_encryption_t e) _CUPS_PUBLIC;
 extern void		httpSetExpect(http_t *http, http_status_t expect) _CUPS_PUBLIC;
 extern void		httpSetField(http_t *http, http_field_t field, const char *value) _CUPS_PUBLIC;
+extern void		httpSetHash(http_t *http, cups_hash_t *ctx) _CUPS_PUBLIC;
 extern void		httpSetKeepAlive(http_t *http, http_keepalive_t keep_alive) _CUPS_PUBLIC;
 extern void		httpSetLength(http_t *http, size_t length) _CUPS_PUBLIC;
+extern void		httpSetStateCallback(http_t *http, http_state_cb_t cb, void *cb_data) _CUPS_PUBLIC;
 extern void		httpSetTimeout(http_t *http, double timeout, http_timeout_cb_t cb, void *user_data) _CUPS_PUBLIC;
+extern void		httpSetWriteCoalescing(http_t *http, bool coalesce) _CUPS_PUBLIC;
 extern void		httpShutdown(http_t *http) _CUPS_PUBLIC;
 extern const char	*httpStateString(http_state_t state) _CUPS_PUBLIC;
 extern const char	*httpStatusString(http_status_t status) _CUPS_PUBLIC;
@@ -0,0 +1,876 @@
+//
+// HTTP benchmark program for CUPS.
+//
+// Copyright © 2026 by OpenPrinting.
+//
+// Licensed under Apache License v2.0.  See the file "LICENSE" for more
+// information.
+//
+// Usage:
+//
+//   ./httpbench [--csv] [--no-tls] [-b BYTES] [-k KEYPATH] [-r BYTES] [-t SECONDS]
+//
+
+#include <config.h>
+#include <cups/cups.h>
+#include <cups/thread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <time.h>
+#ifdef _WIN32
+#  include <direct.h>
+#  define mkdir(d,p) _mkdir(d)
+#else
+#  include <sys/socket.h>
+#  include <unistd.h>
+#endif // _WIN32
+
+
+//
+// Local types...
+//
+
+typedef enum _httpbench_test_e		// Benchmark tests
+{
+  _HTTPBENCH_POST,			// httpWrite of a request body
+  _HTTPBENCH_GET,			// httpRead of a response body
+  _HTTPBENCH_GETS,			// httpGets of lines of text
+  _HTTPBENCH_REQUEST,			// Small request/response round trips
+  _HTTPBENCH_HANDSHAKE,			// Connection (and TLS) setup
+  _HTTPBENCH_MAX
+} _httpbench_test_t;
+
+typedef enum _httpbench_coding_e	// Message body codings
+{
+  _HTTPBENCH_IDENTITY,			// Content-Length
+  _HTTPBENCH_CHUNKED,			// Transfer-Encoding: chunked
+  _HTTPBENCH_GZIP,			// Transfer-Encoding: chunked + Content-Encoding: gzip
+  _HTTPBENCH_CODING_MAX
+} _httpbench_coding_t;
+
+typedef struct _httpbench_server_s	// Loopback server
+{
+  int		fd;			// Listener socket
+  int		port;			// Listener port
+  cups_thread_t	thread;			// Server thread
+  cups_mutex_t	mutex;			// Mutex for state
+  cups_cond_t	cond;			// Condition for completed connections
+  bool		tls,			// Encrypt new connections?
+		lines,			// Exchange lines of text instead of requests?
+		done;			// Stop accepting connections?
+  size_t	num_conns;		// Number of completed connections
+  http_stats_t	stats;			// Statistics for completed connections
+  const char	*data;			// Response data
+  size_t	datasize;		// Size of response data
+} _httpbench_server_t;
+
+typedef struct _httpbench_result_s	// Benchmark results
+{
+  size_t	count,			// Number of requests or connections
+		bytes,			// Number of body bytes transferred
+		syscalls;		// Number of socket system calls (both ends)
+  double	secs,			// Elapsed time
+		*times;			// Time for each request or connection
+  size_t	num_times,		// Number of times
+		alloc_times;		// Allocated times
+} _httpbench_result_t;
+
+
+//
+// Local globals...
+//
+
+static const char * const bench_codings[] =
+{					// Coding names (also the resource path)
+  "identity",
+  "chunked",
+  "gzip"
+};
+static const char * const bench_tests[] =
+{					// Test names
+  "post",
+  "get",
+  "gets",
+  "request",
+  "handshake"
+};
+
+
+//
+// Local functions...
+//
+
+static bool	add_time(_httpbench_result_t *result, double secs);
+static bool	bench_lines(http_t *http, const char *data, size_t bytes);
+static bool	bench_request(http_t *http, _httpbench_test_t test, _httpbench_coding_t coding, const char *data, size_t bytes);
+static bool	bench_run(_httpbench_server_t *server, bool tls, _httpbench_test_t test, _httpbench_coding_t coding, const char *data, size_t bytes, double duration, _httpbench_result_t *result);
+static void	*bench_server(_httpbench_server_t *server);
+static bool	bench_server_lines(http_t *http);
+static bool	bench_server_request(_httpbench_server_t *server, http_t *http);
+static int	compare_doubles(const double *a, const double *b);
+static http_t	*connect_server(_httpbench_server_t *server, bool tls);
+static double	get_time(void);
+static void	init_data(char *data, size_t datasize);
+static int	usage(FILE *out);
+static void	wait_server(_httpbench_server_t *server, size_t num_conns, http_stats_t *stats);
+
+
+//
+// 'main()' - Benchmark the HTTP client and server data paths over loopback.
+//
+
+int					// O - Exit status
+main(int  argc,				// I - Number of command-line args
+     char *argv[])			// I - Command-line arguments
+{
+  int			i;		// Looping var
+  bool			csv = false,	// Produce CSV output?
+			use_tls = true,	// Run the TLS tests?
+			tls;		// Current transport
+  int			transport;	// Current transport index
+  size_t		body_size = 1048576,
+					// Size of bulk message bodies
+			small_size = 256;
+					// Size of request/response bodies
+  const char		*keypath = ".httpbench";
+					// Directory for server credentials
+  double		duration = 1.0;	// Minimum duration of each test
+  char			*data;		// Message body data
+  http_addrlist_t	*addrlist;	// Loopback address
+  http_addr_t		laddr;		// Listener address
+  socklen_t		laddrlen;	// Length of listener address
+  _httpbench_server_t	server;		// Loopback server
+  _httpbench_test_t	test;		// Current test
+  _httpbench_coding_t	coding,		// Current coding
+			last_coding;	// Last coding for test
+  _httpbench_result_t	result;		// Test results
+  size_t		datasize,	// Size of message body data
+			bytes,		// Message body size for test
+			p50,		// Index of median time
+			p99;		// Index of 99th percentile time
+
+
+  // Parse command-line...
+  for (i = 1; i < argc; i ++)
+  {
+    if (!strcmp(argv[i], "--csv"))
+    {
+      csv = true;
+    }
+    else if (!strcmp(argv[i], "--help"))
+    {
+      return (usage(stdout));
+    }
+    else if (!strcmp(argv[i], "--no-tls"))
+    {
+      use_tls = false;
+    }
+    else if (!strcmp(argv[i], "-b") && (i + 1) < argc)
+    {
+      i ++;
+      if ((body_size = (size_t)strtoul(argv[i], NULL, 10)) < 1)
+        return (usage(stderr));
+    }
+    else if (!strcmp(argv[i], "-k") && (i + 1) < argc)
+    {
+      i ++;
+      keypath = argv[i];
+    }
+    else if (!strcmp(argv[i], "-r") && (i + 1) < argc)
+    {
+      i ++;
+      if ((small_size = (size_t)strtoul(argv[i], NULL, 10)) < 1)
+        return (usage(stderr));
+    }
+    else if (!strcmp(argv[i], "-t") && (i + 1) < argc)
+    {
+      i ++;
+      if ((duration = atof(argv[i])) <= 0.0)
+        return (usage(stderr));
+    }
+    else
+    {
+      return (usage(stderr));
+    }
+  }
+
+  // Create the message body data...
+  if ((datasize = body_size > small_size ? body_size : small_size) < 80)
+    datasize = 80;
+
+  if ((data = malloc(datasize)) == NULL)
+  {
+    perror("httpbench: Unable to allocate memory");
+    return (1);
+  }
+
+  init_data(data, datasize);
+
+  // Start the loopback server...
+  memset(&server, 0, sizeof(server));
+  cupsMutexInit(&server.mutex);
+  cupsCondInit(&server.cond);
+
+  server.data     = data;
+  server.datasize = datasize;
+
+  laddrlen = sizeof(laddr);
+
+  if ((addrlist = httpAddrGetList("127.0.0.1", AF_INET, "0")) == NULL || (server.fd = httpAddrListen(&addrlist->addr, 0)) < 0 || getsockname(server.fd, (struct sockaddr *)&laddr, &laddrlen))
+  {
+    fprintf(stderr, "httpbench: Unable to listen on loopback: %s\n", cupsGetErrorString());
+    return (1);
+  }
+
+  httpAddrFreeList(addrlist);
+
+  server.port = httpAddrGetPort(&laddr);
+
+  if (use_tls)
+  {
+    if (access(keypath, 0))
+      mkdir(keypath, 0700);
+
+    if (!cupsSetServerCredentials(keypath, "localhost", true))
+    {
+      fprintf(stderr, "httpbench: Unable to create server credentials in \"%s\": %s\n", keypath, cupsGetErrorString());
+      return (1);
+    }
+  }
+
+  if ((server.thread = cupsThreadCreate((cups_thread_func_t)bench_server, &server)) == CUPS_THREAD_INVALID)
+  {
+    perror("httpbench: Unable to create server thread");
+    return (1);
+  }
+
+  // Run the tests...
+  if (csv)
+    puts("transport,test,coding,bytes,count,seconds,reqs_per_sec,bytes_per_sec,syscalls_per_req,p50_ms,p99_ms");
+  else
+    printf("%-5s %-9s %-8s %8s %8s %10s %10s %9s %8s %8s\n", "Trans", "Test", "Coding", "Bytes", "Count", "Reqs/sec", "MBytes/sec", "Sys/req", "p50 ms", "p99 ms");
+
+  memset(&result, 0, sizeof(result));
+
+  for (transport = 0; transport < (use_tls ? 2 : 1); transport ++)
+  {
+    tls = transport > 0;
+
+    for (test = _HTTPBENCH_POST; test < _HTTPBENCH_MAX; test ++)
+    {
+      // Bulk transfers use each coding, the rest only use Content-Length...
+      last_coding = (test == _HTTPBENCH_POST || test == _HTTPBENCH_GET) ? _HTTPBENCH_GZIP : _HTTPBENCH_IDENTITY;
+      bytes       = test == _HTTPBENCH_REQUEST ? small_size : test == _HTTPBENCH_HANDSHAKE ? 0 : body_size;
+
+      if (test == _HTTPBENCH_GETS)
+      {
+        // httpGets needs complete lines...
+        if ((bytes -= bytes % 80) == 0)
+          bytes = 80;
+      }
+
+      for (coding = _HTTPBENCH_IDENTITY; coding <= last_coding; coding ++)
+      {
+        if (!bench_run(&server, tls, test, coding, data, bytes, duration, &result))
+        {
+          fprintf(stderr, "httpbench: %s %s %s failed: %s\n", tls ? "https" : "http", bench_tests[test], bench_codings[coding], cupsGetErrorString());
+          return (1);
+        }
+
+        qsort(result.times, result.num_times, sizeof(double), (int (*)(const void *, const void *))compare_doubles);
+
+        p50 = result.num_times / 2;
+        p99 = result.num_times * 99 / 100;
+
+        if (csv)
+          printf("%s,%s,%s,%u,%u,%.6f,%.1f,%.1f,%.2f,%.4f,%.4f\n", tls ? "https" : "http", bench_tests[test], bench_codings[coding], (unsigned)bytes, (unsigned)result.count, result.secs, result.count / result.secs, result.bytes / result.secs, (double)result.syscalls / result.count, 1000.0 * result.times[p50], 1000.0 * result.times[p99]);
+        else
+          printf("%-5s %-9s %-8s %8u %8u %10.1f %10.3f %9.2f %8.3f %8.3f\n", tls ? "https" : "http", bench_tests[test], bench_codings[coding], (unsigned)bytes, (unsigned)result.count, result.count / result.secs, result.bytes / result.secs / 1048576.0, (double)result.syscalls / result.count, 1000.0 * result.times[p50], 1000.0 * result.times[p99]);
+      }
+    }
+  }
+
+  // Stop the server by waking it up with one last connection...
+  cupsMutexLock(&server.mutex);
+  server.done = true;
+  cupsMutexUnlock(&server.mutex);
+
+  httpClose(connect_server(&server, false));
+  cupsThreadWait(server.thread);
+  httpAddrClose(NULL, server.fd);
+
+  cupsCondDestroy(&server.cond);
+  cupsMutexDestroy(&server.mutex);
+
+  free(result.times);
+  free(data);
+
+  return (0);
+}
+
+
+//
+// 'add_time()' - Add a request or connection time to the results.
+//
+
+static bool				// O - `true` on success, `false` on error
+add_time(_httpbench_result_t *result,	// I - Results
+         double              secs)	// I - Time in seconds
+{
+  if (result->num_times >= result->alloc_times)
+  {
+    double	*times;			// New times array
+    size_t	alloc_times = result->alloc_times ? 2 * result->alloc_times : 1024;
+					// New allocation
+
+
+    if ((times = realloc(result->times, alloc_times * sizeof(double))) == NULL)
+      return (false);
+
+    result->times       = times;
+    result->alloc_times = alloc_times;
+  }
+
+  result->times[result->num_times ++] = secs;
+
+  return (true);
+}
+
+
+//
+// 'bench_lines()' - Send lines of text and read the byte count that comes back.
+//
+// The lines are written with httpWrite and terminated by a blank line, and the
+// server reads them with httpGets.  No HTTP framing is used since httpGets
+// does not track the length of a message body.
+//
+
+static bool				// O - `true` on success, `false` on error
+bench_lines(http_t     *http,		// I - HTTP connection
+            const char *data,		// I - Lines of text
+            size_t     bytes)		// I - Number of bytes
+{
+  char		line[256];		// Line from server
+  size_t	pos,			// Position in data
+		count;			// Bytes to write
+
+
+  for (pos = 0; pos < bytes; pos += count)
+  {
+    if ((count = bytes - pos) > 65536)
+      count = 65536;
+
+    if (httpWrite(http, data + pos, count) < 0)
+      return (false);
+  }
+
+  if (httpWrite(http, "\r\n", 2) < 0 || httpFlushWrite(http) < 0)
+    return (false);
+
+  if (!httpGets(http, line, sizeof(line)))
+    return (false);
+
+  if ((count = (size_t)strtoul(line, NULL, 10)) != bytes)
+  {
+    fprintf(stderr, "httpbench: Server got %u bytes of lines, expected %u.\n", (unsigned)count, (unsigned)bytes);
+    return (false);
+  }
+
+  return (true);
+}
+
+
+//
+// 'bench_request()' - Send a single request and read its response.
+//
+
+static bool				// O - `true` on success, `false` on error
+bench_request(
+    http_t              *http,		// I - HTTP connection
+    _httpbench_test_t   test,		// I - Test
+    _httpbench_coding_t coding,		// I - Message body coding
+    const char          *data,		// I - Message body data
+    size_t              bytes)		// I - Size of message body
+{
+  char		resource[256],		// Resource path
+		buffer[65536];		// Read buffer
+  size_t	pos,			// Position in data
+		count;			// Bytes to write
+  ssize_t	rbytes;			// Bytes read
+  http_status_t	status;			// Response status
+
+
+  // Send the request...
+  if (test == _HTTPBENCH_GETS)
+    return (bench_lines(http, data, bytes));
+
+  snprintf(resource, sizeof(resource), "/%s/%u", bench_codings[coding], (unsigned)bytes);
+
+  httpClearFields(http);
+
+  if (test == _HTTPBENCH_GET || test == _HTTPBENCH_REQUEST)
+  {
+    if (!httpWriteRequest(http, "GET", resource))
+      return (false);
+  }
+  else
+  {
+    if (coding == _HTTPBENCH_IDENTITY)
+      httpSetLength(http, bytes);
+    else
+      httpSetField(http, HTTP_FIELD_TRANSFER_ENCODING, "chunked");
+
+    if (!httpWriteRequest(http, "POST", resource))
+      return (false);
+
+    if (coding == _HTTPBENCH_GZIP)
+      httpSetField(http, HTTP_FIELD_CONTENT_ENCODING, "gzip");
+
+    for (pos = 0; pos < bytes; pos += count)
+    {
+      if ((count = bytes - pos) > sizeof(buffer))
+        count = sizeof(buffer);
+
+      if (httpWrite(http, data + pos, count) < 0)
+        return (false);
+    }
+
+    if (coding != _HTTPBENCH_IDENTITY && httpWrite(http, "", 0) < 0)
+      return (false);
+
+    if (httpFlushWrite(http) < 0)
+      return (false);
+  }
+
+  // Read the response...
+  while ((status = httpUpdate(http)) == HTTP_STATUS_CONTINUE);
+
+  if (status != HTTP_STATUS_OK)
+    return (false);
+
+  for (count = 0; (rbytes = httpRead(http, buffer, sizeof(buffer))) > 0; count += (size_t)rbytes);
+
+  if (rbytes < 0 || (test != _HTTPBENCH_POST && count != bytes))
+  {
+    fprintf(stderr, "httpbench: Got %u bytes in response, expected %u.\n", (unsigned)count, (unsigned)bytes);
+    return (false);
+  }
+
+  return (true);
+}
+
+
+//
+// 'bench_run()' - Run a test until the minimum duration has passed.
+//
+
+static bool				// O - `true` on success, `false` on error
+bench_run(
+    _httpbench_server_t *server,	// I - Loopback server
+    bool                tls,		// I - Use TLS?
+    _httpbench_test_t   test,		// I - Test
+    _httpbench_coding_t coding,		// I - Message body coding
+    const char          *data,		// I - Message body data
+    size_t              bytes,		// I - Size of message body
+    double              duration,	// I - Minimum duration
+    _httpbench_result_t *result)	// O - Results
+{
+  bool		ret = true;		// Return value
+  http_t	*http;			// Client connection
+  http_stats_t	before,			// Server statistics before test
+		after,			// Server statistics after test
+		stats;			// Client statistics
+  size_t	num_conns;		// Number of completed connections
+  double	start,			// Start time
+		rstart;			// Start time for request
+
+
+  result->count     = 0;
+  result->bytes     = 0;
+  result->syscalls  = 0;
+  result->num_times = 0;
+
+  // Wait for any previous connections to finish...
+  cupsMutexLock(&server->mutex);
+  server->tls   = tls;
+  server->lines = test == _HTTPBENCH_GETS;
+  before        = server->stats;
+  num_conns   = server->num_conns;
+  cupsMutexUnlock(&server->mutex);
+
+  start = get_time();
+
+  if (test == _HTTPBENCH_HANDSHAKE)
+  {
+    // Time connection (and TLS handshake) setup...
+    do
+    {
+      rstart = get_time();
+
+      if ((http = connect_server(server, tls)) == NULL)
+      {
+        ret = false;
+        break;
+      }
+
+      add_time(result, get_time() - rstart);
+      httpGetStats(http, &stats);
+      httpClose(http);
+
+      num_conns ++;
+      result->count ++;
+      result->syscalls += stats.read_calls + stats.write_calls;
+
+      // Let the server finish with the connection before starting the next
+      // one, otherwise the connect time includes waiting for the server...
+      wait_server(server, num_conns, NULL);
+    }
+    while ((get_time() - start) < duration);
+
+    result->secs = get_time() - start;
+  }
+  else
+  {
+    // Send requests over a single persistent connection...
+    if ((http = connect_server(server, tls)) == NULL)
+      return (false);
+
+    start = get_time();
+
+    do
+    {
+      rstart = get_time();
+
+      if (!bench_request(http, test, coding, data, bytes))
+      {
+        ret = false;
+        break;
+      }
+
+      add_time(result, get_time() - rstart);
+
+      result->count ++;
+      result->bytes += bytes;
+    }
+    while ((get_time() - start) < duration);
+
+    result->secs = get_time() - start;
+
+    httpGetStats(http, &stats);
+    httpClose(http);
+
+    num_conns ++;
+    result->syscalls += stats.read_calls + stats.write_calls;
+  }
+
+  // Add the server's system calls...
+  wait_server(server, num_conns, &after);
+
+  result->syscalls += after.read_calls + after.write_calls - before.read_calls - before.write_calls;
+
+  return (ret && result->count > 0);
+}
+
+
+//
+// 'bench_server()' - Accept and process connections from the client.
+//
+
+static void *				// O - Thread exit status
+bench_server(_httpbench_server_t *server)// I - Loopback server
+{
+  http_t	*http;			// Server connection
+  http_stats_t	stats;			// Connection statistics
+  bool		tls,			// Encrypt the connection?
+		lines;			// Exchange lines of text?
+
+
+  while ((http = httpAcceptConnection(server->fd, true)) != NULL)
+  {
+    cupsMutexLock(&server->mutex);
+    tls   = server->tls;
+    lines = server->lines;
+    if (server->done)
+    {
+      cupsMutexUnlock(&server->mutex);
+      httpClose(http);
+      break;
+    }
+    cupsMutexUnlock(&server->mutex);
+
+    // Process requests until the client closes the connection...
+    if (!tls || httpSetEncryption(http, HTTP_ENCRYPTION_ALWAYS))
+    {
+      if (lines)
+        while (bench_server_lines(http));
+      else
+        while (bench_server_request(server, http));
+    }
+
+    httpGetStats(http, &stats);
+    httpClose(http);
+
+    // Update the statistics for the client...
+    cupsMutexLock(&server->mutex);
+
+    server->num_conns ++;
+    server->stats.read_calls  += stats.read_calls;
+    server->stats.write_calls += stats.write_calls;
+
+    cupsCondBroadcast(&server->cond);
+    cupsMutexUnlock(&server->mutex);
+  }
+
+  return (NULL);
+}
+
+
+//
+// 'bench_server_lines()' - Read lines of text from the client.
+//
+// Lines are read until a blank line, and then the number of bytes that were
+// read (including the CR LF at the end of each line) is sent back.
+//
+
+static bool				// O - `true` to continue, `false` to close
+bench_server_lines(http_t *http)	// I - Server connection
+{
+  char		line[1024];		// Line from client
+  size_t	bytes = 0;		// Bytes read
+
+
+  while (httpGets(http, line, sizeof(line)))
+  {
+    if (!line[0])
+      return (httpPrintf(http, "%u\r\n", (unsigned)bytes) > 0 && httpFlushWrite(http) >= 0);
+
+    bytes += strlen(line) + 2;
+  }
+
+  return (false);
+}
+
+
+//
+// 'bench_server_request()' - Process a single request from the client.
+//
+// The resource path is "/CODING/BYTES" - POST request bodies are read and
+// discarded, while GET responses send BYTES bytes using the named coding.
+//
+
+static bool				// O - `true` to continue, `false` to close
+bench_server_request(
+    _httpbench_server_t *server,	// I - Loopback server
+    http_t              *http)		// I - Server connection
+{
+  http_state_t	state;			// Request state
+  http_status_t	status;			// Request status
+  char		resource[256],		// Resource path
+		*bytesptr,		// Pointer to message body size
+		buffer[65536];		// Read buffer
+  size_t	bytes,			// Size of message body
+		count,			// Bytes written/read
+		pos;			// Position in data
+  _httpbench_coding_t coding;		// Message body coding
+
+
+  if ((state = httpReadRequest(http, resource, sizeof(resource))) == HTTP_STATE_WAITING)
+    return (true);
+  else if (state != HTTP_STATE_GET && state != HTTP_STATE_POST)
+    return (false);
+
+  while ((status = httpUpdate(http)) == HTTP_STATUS_CONTINUE);
+
+  if (status != HTTP_STATUS_OK)
+    return (false);
+
+  // Figure out the coding and size...
+  if ((bytesptr = strchr(resource + 1, '/')) == NULL)
+    return (false);
+
+  *bytesptr++ = '\0';
+  bytes       = (size_t)strtoul(bytesptr, NULL, 10);
+
+  for (coding = _HTTPBENCH_IDENTITY; coding < _HTTPBENCH_CODING_MAX; coding ++)
+  {
+    if (!strcmp(resource + 1, bench_codings[coding]))
+      break;
+  }
+
+  if (bytes > server->datasize || coding >= _HTTPBENCH_CODING_MAX)
+    return (false);
+
+  if (state == HTTP_STATE_POST)
+  {
+    // Read and discard the request body...
+    if (coding == _HTTPBENCH_GZIP)
+      httpSetField(http, HTTP_FIELD_CONTENT_ENCODING, "gzip");
+
+    while (httpRead(http, buffer, sizeof(buffer)) > 0);
+
+    // Send an empty response...
+    httpClearFields(http);
+    httpSetField(http, HTTP_FIELD_CONTENT_LENGTH, "0");
+
+    return (httpWriteResponse(http, HTTP_STATUS_OK));
+  }
+
+  // Send the response body...
+  httpClearFields(http);
+  httpSetField(http, HTTP_FIELD_CONTENT_TYPE, "application/octet-stream");
+
+  if (coding == _HTTPBENCH_IDENTITY)
+  {
+    httpSetLength(http, bytes);
+  }
+  else
+  {
+    httpSetLength(http, 0);
+
+    if (coding == _HTTPBENCH_GZIP)
+      httpSetField(http, HTTP_FIELD_CONTENT_ENCODING, "gzip");
+  }
+
+  if (!httpWriteResponse(http, HTTP_STATUS_OK))
+    return (false);
+
+  for (pos = 0; pos < bytes; pos += count)
+  {
+    if ((count = bytes - pos) > sizeof(buffer))
+      count = sizeof(buffer);
+
+    if (httpWrite(http, server->data + pos, count) < 0)
+      return (false);
+  }
+
+  if (coding != _HTTPBENCH_IDENTITY && httpWrite(http, "", 0) < 0)
+    return (false);
+
+  return (httpFlushWrite(http) >= 0);
+}
+
+
+//
+// 'compare_doubles()' - Compare two times.
+//
+
+static int				// O - Result of comparison
+compare_doubles(const double *a,	// I - First time
+                const double *b)	// I - Second time
+{
+  if (*a < *b)
+    return (-1);
+  else if (*a > *b)
+    return (1);
+  else
+    return (0);
+}
+
+
+//
+// 'connect_server()' - Connect to the loopback server.
+//
+
+static http_t *				// O - HTTP connection
+connect_server(
+    _httpbench_server_t *server,	// I - Loopback server
+    bool                tls)		// I - Use TLS?
+{
+  return (httpConnect("127.0.0.1", server->port, NULL, AF_INET, tls ? HTTP_ENCRYPTION_ALWAYS : HTTP_ENCRYPTION_IF_REQUESTED, true, 30000, NULL));
+}
+
+
+//
+// 'get_time()' - Get the current time in seconds.
+//
+
+static double				// O - Time in seconds
+get_time(void)
+{
+#ifdef CLOCK_MONOTONIC
+  struct timespec	curtime;	// Current time
+
+
+  clock_gettime(CLOCK_MONOTONIC, &curtime);
+  return (curtime.tv_sec + 0.000000001 * curtime.tv_nsec);
+
+#else
+  struct timeval	curtime;	// Current time
+
+
+  gettimeofday(&curtime, NULL);
+  return (curtime.tv_sec + 0.000001 * curtime.tv_usec);
+#endif // CLOCK_MONOTONIC
+}
+
+
+//
+// 'init_data()' - Initialize the message body data.
+//
+// The data consists of 78 character lines of text terminated by CR LF so that
+// it compresses like a typical document and can be read with httpGets.
+//
+
+static void
+init_data(char   *data,			// I - Data buffer
+          size_t datasize)		// I - Size of data buffer
+{
+  size_t	i;			// Looping var
+
+
+  for (i = 0; i < datasize; i ++)
+  {
+    if ((i % 80) == 78)
+      data[i] = '\r';
+    else if ((i % 80) == 79)
+      data[i] = '\n';
+    else
+      data[i] = (char)('A' + (i * 7 + i / 57) % 26);
+  }
+}
+
+
+//
+// 'usage()' - Show program usage.
+//
+
+static int				// O - Exit status
+usage(FILE *out)			// I - Output file
+{
+  fputs("Usage: httpbench [OPTIONS]\n", out);
+  fputs("Options:\n", out);
+  fputs("  --csv         Produce CSV output for regression tracking.\n", out);
+  fputs("  --help        Show program help.\n", out);
+  fputs("  --no-tls      Only run the unencrypted tests.\n", out);
+  fputs("  -b BYTES      Set the size of bulk message bodies (default 1048576).\n", out);
+  fputs("  -k KEYPATH    Set the directory for server credentials (default \".httpbench\").\n", out);
+  fputs("  -r BYTES      Set the size of request/response bodies (default 256).\n", out);
+  fputs("  -t SECONDS    Set the minimum duration of each test (default 1.0).\n", out);
+
+  return (out == stdout ? 0 : 1);
+}
+
+
+//
+// 'wait_server()' - Wait for the server to finish with the client's connections.
+//
+
+static void
+wait_server(_httpbench_server_t *server,// I - Loopback server
+            size_t              num_conns,
+					// I - Number of completed connections
+            http_stats_t        *stats)	// O - Server statistics or `NULL`
+{
+  cupsMutexLock(&server->mutex);
+
+  while (server->num_conns < num_conns)
+    cupsCondWait(&server->cond, &server->mutex, 1.0);
+
+  if (stats)
+    *stats = server->stats;
+
+  cupsMutexUnlock(&server->mutex);
+}
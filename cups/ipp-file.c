@@ -37,6 +37,12 @@ struct _ipp_file_s			// IPP data file
   void			*cb_data;	// Callback data
   char			*buffer;	// Output buffer
   size_t		alloc_buffer;	// Size of output buffer
+  off_t			rpos;		// File position of read buffer
+  char			*rptr,		// Current position in read buffer
+			*rend,		// End of read buffer
+			rbuffer[8192];	// Read buffer
+  char			*wptr,		// Current position in write buffer
+			wbuffer[32768];	// Write buffer
 };
 
 
@@ -46,7 +52,13 @@ struct _ipp_file_s			// IPP data file
 
 static bool	expand_buffer(ipp_file_t *file, size_t buffer_size);
 static bool	parse_value(ipp_file_t *file, ipp_t *ipp, ipp_attribute_t **attr, size_t element);
+static int	read_char(ipp_file_t *file);
 static bool	report_error(ipp_file_t *file, const char *message, ...) _CUPS_FORMAT(2,3);
+static bool	write_attributes(ipp_file_t *file, ipp_t *ipp, bool with_groups);
+static bool	write_data(ipp_file_t *file, const char *data, size_t len);
+static bool	write_flush(ipp_file_t *file);
+static bool	write_indent(ipp_file_t *file, int indent);
+static bool	write_int(ipp_file_t *file, int value);
 static bool	write_string(ipp_file_t *file, const char *s, size_t len);
 
 
@@ -66,15 +78,24 @@ ippFileClose(ipp_file_t *file)		// I - IPP data file
   if (!file || !file->fp)
     return (false);
 
-  if ((ret = cupsFileClose(file->fp)) == false)
+  ret = file->mode != 'w' || write_flush(file);
+
+  if (!cupsFileClose(file->fp))
+    ret = false;
+
+  if (!ret)
     _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(errno), 0);
 
-  free(file->filename);
+  _cupsMemFree(file->filename);
 
   file->fp       = NULL;
   file->filename = NULL;
   file->mode     = '\0';
   file->attrs    = NULL;
+  file->rpos     = 0;
+  file->rptr     = file->rbuffer;
+  file->rend     = file->rbuffer;
+  file->wptr     = file->wbuffer;
 
   return (ret);
 }
@@ -103,8 +124,8 @@ ippFileDelete(ipp_file_t *file)		// I - IPP data file
   }
 
   cupsFreeOptions(file->num_vars, file->vars);
-  free(file->buffer);
-  free(file);
+  _cupsMemFree(file->buffer);
+  _cupsMemFree(file);
 
   return (true);
 }
@@ -126,9 +147,11 @@ ippFileExpandVars(ipp_file_t *file,	// I - IPP data file
 {
   char		*dstptr,		// Pointer into destination
 		*dstend,		// End of destination
-		temp[256],		// Temporary string
-		*tempptr;		// Pointer into temporary string
-  const char	*value;			// Value to substitute
+		temp[256];		// Temporary string
+  const char	*srcptr,		// Pointer into source string
+		*srcnext,		// Next character after variable
+		*value;			// Value to substitute
+  size_t	len;			// Length of literal text or name
 
 
   // Range check input...
@@ -144,73 +167,85 @@ ippFileExpandVars(ipp_file_t *file,	// I - IPP data file
 
   while (*src)
   {
-    if (*src == '$')
+    if (*src != '$')
     {
-      // Substitute a string/number...
-      if (!strncmp(src, "$$", 2))
-      {
-        // Literal $
-        value = "$";
-	src   += 2;
-      }
-      else if (!strncmp(src, "$ENV[", 5))
-      {
-        // Environment variable
-	cupsCopyString(temp, src + 5, sizeof(temp));
+      // Copy literal text up to the next variable...
+      if ((srcptr = strchr(src, '$')) == NULL)
+        srcptr = src + strlen(src);
 
-	for (tempptr = temp; *tempptr; tempptr ++)
-	{
-	  if (*tempptr == ']')
-	    break;
-	}
+      len = (size_t)(srcptr - src);
+
+      if (dstptr < dstend)
+        memcpy(dstptr, src, len < (size_t)(dstend - dstptr) ? len : (size_t)(dstend - dstptr));
+
+      dstptr += len;
+      src    = srcptr;
+      continue;
+    }
+
+    // Substitute a string/number...
+    if (src[1] == '$')
+    {
+      // Literal $
+      value = "$";
+      src   += 2;
+    }
+    else if (!strncmp(src, "$ENV[", 5))
+    {
+      // Environment variable
+      src += 5;
+
+      if ((srcptr = strchr(src, ']')) == NULL)
+        srcptr = src + strlen(src);
 
-        if (*tempptr)
-	  *tempptr++ = '\0';
+      if ((len = (size_t)(srcptr - src)) >= sizeof(temp))
+        len = sizeof(temp) - 1;
+
+      memcpy(temp, src, len);
+      temp[len] = '\0';
+
+      value = getenv(temp);
+      src   = *srcptr ? srcptr + 1 : srcptr;
+    }
+    else
+    {
+      // $name or ${name}
+      if (src[1] == '{')
+      {
+	src += 2;
 
-	value = getenv(temp);
-        src   += tempptr - temp + 5;
+	if ((srcptr = strchr(src, '}')) == NULL)
+	  srcnext = srcptr = src + strlen(src);
+	else
+	  srcnext = srcptr + 1;
       }
       else
       {
-        // $name or ${name}
-        if (src[1] == '{')
+	for (srcptr = ++ src; *srcptr; srcptr ++)
 	{
-	  src += 2;
-	  cupsCopyString(temp, src, sizeof(temp));
-	  if ((tempptr = strchr(temp, '}')) != NULL)
-	    *tempptr = '\0';
-	  else
-	    tempptr = temp + strlen(temp);
+	  if (!isalnum(*srcptr & 255) && *srcptr != '-' && *srcptr != '_')
+	    break;
 	}
-	else
-	{
-	  cupsCopyString(temp, src + 1, sizeof(temp));
 
-	  for (tempptr = temp; *tempptr; tempptr ++)
-	  {
-	    if (!isalnum(*tempptr & 255) && *tempptr != '-' && *tempptr != '_')
-	      break;
-	  }
+	srcnext = srcptr;
+      }
 
-	  if (*tempptr)
-	    *tempptr = '\0';
-        }
+      if ((len = (size_t)(srcptr - src)) >= sizeof(temp))
+        len = sizeof(temp) - 1;
 
-        value = ippFileGetVar(file, temp);
-        src   += tempptr - temp + 1;
-      }
+      memcpy(temp, src, len);
+      temp[len] = '\0';
 
-      if (value)
-      {
-        if (dstptr < dstend)
-          cupsCopyString(dstptr, value, (size_t)(dstend - dstptr + 1));
-	dstptr += strlen(value);
-      }
+      value = ippFileGetVar(file, temp);
+      src   = srcnext;
+    }
+
+    if (value)
+    {
+      if (dstptr < dstend)
+	cupsCopyString(dstptr, value, (size_t)(dstend - dstptr + 1));
+      dstptr += strlen(value);
     }
-    else if (dstptr < dstend)
-      *dstptr++ = *src++;
-    else
-      dstptr ++;
   }
 
   if (dstptr < dstend)
@@ -286,7 +321,8 @@ ippFileGetLineNumber(ipp_file_t *file)	// I - IPP data file
 //
 // 'ippFileGetVar()' - Get the value of an IPP data file variable.
 //
-// This function returns the value of an IPP data file variable.  `NULL` is
+// This function returns the value of an IPP data file variable.  Variables
+// that are not set in the file are looked up in its parent files.  `NULL` is
 // returned if the variable is not set.
 //
 
@@ -301,12 +337,14 @@ ippFileGetVar(ipp_file_t *file,		// I - IPP data file
     return (NULL);
   else if (!strcmp(name, "user"))
     return (cupsGetUser());
-  else if ((value = cupsGetOption(name, file->num_vars, file->vars)) != NULL)
-    return (value);
-  else if (file->parent)
-    return (cupsGetOption(name, file->parent->num_vars, file->parent->vars));
-  else
-    return (NULL);
+
+  for (; file; file = file->parent)
+  {
+    if ((value = cupsGetOption(name, file->num_vars, file->vars)) != NULL)
+      return (value);
+  }
+
+  return (NULL);
 }
 
 
@@ -328,7 +366,7 @@ ippFileNew(ipp_file_t      *parent,	// I - Parent data file or `NULL` for none
 
 
   // Allocate memory...
-  if ((file = (ipp_file_t *)calloc(1, sizeof(ipp_file_t))) == NULL)
+  if ((file = (ipp_file_t *)_cupsMemCalloc(CUPS_MEMTYPE_IPP, 1, sizeof(ipp_file_t))) == NULL)
     return (NULL);
 
   // Set callbacks and parent...
@@ -336,6 +374,9 @@ ippFileNew(ipp_file_t      *parent,	// I - Parent data file or `NULL` for none
   file->attr_cb  = attr_cb;
   file->error_cb = error_cb;
   file->cb_data  = cb_data;
+  file->rptr     = file->rbuffer;
+  file->rend     = file->rbuffer;
+  file->wptr     = file->wbuffer;
 
   return (file);
 }
@@ -378,10 +419,14 @@ ippFileOpen(ipp_file_t *file,		// I - IPP data file
 
   // Save the file information and return...
   file->fp       = fp;
-  file->filename = strdup(filename);
+  file->filename = _cupsMemStrdup(CUPS_MEMTYPE_IPP, filename);
   file->mode     = *mode;
   file->column   = 0;
   file->linenum  = 1;
+  file->rpos     = 0;
+  file->rptr     = file->rbuffer;
+  file->rend     = file->rbuffer;
+  file->wptr     = file->wbuffer;
 
   return (true);
 }
@@ -762,7 +807,8 @@ ippFileReadToken(ipp_file_t *file,	// I - IPP data file
   int	ch,				// Character from file
 	quote = 0;			// Quoting character
   char	*tokptr = token,		// Pointer into token buffer
-	*tokend = token + tokensize - 1;// End of token buffer
+	*tokend = token + tokensize - 1,// End of token buffer
+	*ptr;				// Pointer into read buffer
 
 
   // Range check input...
@@ -777,9 +823,9 @@ ippFileReadToken(ipp_file_t *file,	// I - IPP data file
   }
 
   // Skip whitespace and comments...
-  DEBUG_printf("1ippFileReadToken: linenum=%d, pos=%ld", file->linenum, (long)cupsFileTell(file->fp));
+  DEBUG_printf("1ippFileReadToken: linenum=%d, pos=%ld", file->linenum, (long)(file->rpos + (file->rptr - file->rbuffer)));
 
-  while ((ch = cupsFileGetChar(file->fp)) != EOF)
+  while ((ch = read_char(file)) != EOF)
   {
     if (_cups_isspace(ch))
     {
@@ -787,24 +833,30 @@ ippFileReadToken(ipp_file_t *file,	// I - IPP data file
       if (ch == '\n')
       {
         file->linenum ++;
-        DEBUG_printf("1ippFileReadToken: LF in leading whitespace, linenum=%d, pos=%ld", file->linenum, (long)cupsFileTell(file->fp));
+        DEBUG_printf("1ippFileReadToken: LF in leading whitespace, linenum=%d, pos=%ld", file->linenum, (long)(file->rpos + (file->rptr - file->rbuffer)));
       }
     }
     else if (ch == '#')
     {
-      // Comment...
+      // Comment, skip to the end of the line a buffer at a time...
       DEBUG_puts("1ippFileReadToken: Skipping comment in leading whitespace...");
 
-      while ((ch = cupsFileGetChar(file->fp)) != EOF)
+      while ((ch = read_char(file)) != EOF && ch != '\n')
       {
-        if (ch == '\n')
+        if ((ptr = memchr(file->rptr, '\n', (size_t)(file->rend - file->rptr))) != NULL)
+        {
+          file->rptr = ptr + 1;
+          ch         = '\n';
           break;
+        }
+
+        file->rptr = file->rend;
       }
 
       if (ch == '\n')
       {
         file->linenum ++;
-        DEBUG_printf("1ippFileReadToken: LF at end of comment, linenum=%d, pos=%ld", file->linenum, (long)cupsFileTell(file->fp));
+        DEBUG_printf("1ippFileReadToken: LF at end of comment, linenum=%d, pos=%ld", file->linenum, (long)(file->rpos + (file->rptr - file->rbuffer)));
       }
       else
         break;
@@ -825,7 +877,7 @@ ippFileReadToken(ipp_file_t *file,	// I - IPP data file
     if (ch == '\n')
     {
       file->linenum ++;
-      DEBUG_printf("1ippFileReadToken: LF in token, linenum=%d, pos=%ld", file->linenum, (long)cupsFileTell(file->fp));
+      DEBUG_printf("1ippFileReadToken: LF in token, linenum=%d, pos=%ld", file->linenum, (long)(file->rpos + (file->rptr - file->rbuffer)));
     }
 
     if (ch == quote)
@@ -847,12 +899,12 @@ ippFileReadToken(ipp_file_t *file,	// I - IPP data file
       // Start of quoted text or regular expression...
       quote = ch;
 
-      DEBUG_printf("1ippFileReadToken: Start of quoted string, quote=%c, pos=%ld", quote, (long)cupsFileTell(file->fp));
+      DEBUG_printf("1ippFileReadToken: Start of quoted string, quote=%c, pos=%ld", quote, (long)(file->rpos + (file->rptr - file->rbuffer)));
     }
     else if (!quote && ch == '#')
     {
       // Start of comment...
-      cupsFileSeek(file->fp, cupsFileTell(file->fp) - 1);
+      file->rptr --;
       *tokptr = '\0';
       DEBUG_printf("1ippFileReadToken: Returning \"%s\" before comment.", token);
       return (true);
@@ -863,7 +915,7 @@ ippFileReadToken(ipp_file_t *file,	// I - IPP data file
       if (tokptr > token)
       {
         // Return the preceding token first...
-	cupsFileSeek(file->fp, cupsFileTell(file->fp) - 1);
+	file->rptr --;
       }
       else
       {
@@ -880,9 +932,9 @@ ippFileReadToken(ipp_file_t *file,	// I - IPP data file
       if (ch == '\\')
       {
         // Quoted character...
-        DEBUG_printf("1ippFileReadToken: Quoted character at pos=%ld", (long)cupsFileTell(file->fp));
+        DEBUG_printf("1ippFileReadToken: Quoted character at pos=%ld", (long)(file->rpos + (file->rptr - file->rbuffer)));
 
-        if ((ch = cupsFileGetChar(file->fp)) == EOF)
+        if ((ch = read_char(file)) == EOF)
         {
 	  *token = '\0';
 	  DEBUG_puts("1ippFileReadToken: EOF");
@@ -891,7 +943,7 @@ ippFileReadToken(ipp_file_t *file,	// I - IPP data file
 	else if (ch == '\n')
 	{
 	  file->linenum ++;
-	  DEBUG_printf("1ippFileReadToken: quoted LF, linenum=%d, pos=%ld", file->linenum, (long)cupsFileTell(file->fp));
+	  DEBUG_printf("1ippFileReadToken: quoted LF, linenum=%d, pos=%ld", file->linenum, (long)(file->rpos + (file->rptr - file->rbuffer)));
 	}
 	else if (ch == 'a')
 	  ch = '\a';
@@ -913,6 +965,20 @@ ippFileReadToken(ipp_file_t *file,	// I - IPP data file
       {
         // Add to current token...
 	*tokptr++ = (char)ch;
+
+        // Then copy any following ordinary characters straight from the
+        // read buffer...
+        for (ptr = file->rptr; ptr < file->rend && tokptr < tokend; ptr ++)
+        {
+          ch = *ptr & 255;
+
+          if (ch == quote || ch == '\\' || ch == '\n' || (!quote && (_cups_isspace(ch) || ch == '\'' || ch == '\"' || ch == '#' || ch == '{' || ch == '}' || ch == ',')))
+            break;
+
+          *tokptr++ = (char)ch;
+        }
+
+        file->rptr = ptr;
       }
       else
       {
@@ -924,7 +990,7 @@ ippFileReadToken(ipp_file_t *file,	// I - IPP data file
     }
 
     // Get the next character...
-    ch = cupsFileGetChar(file->fp);
+    ch = read_char(file);
   }
 
   *tokptr = '\0';
@@ -948,9 +1014,21 @@ ippFileRestorePosition(ipp_file_t *file)// I - IPP data file
   if (!file || file->mode != 'r' || file->save_line == 0)
     return (false);
 
-  // Seek back to the saved position...
-  if (cupsFileSeek(file->fp, file->save_pos) != file->save_pos)
-    return (false);
+  if (file->save_pos >= file->rpos && file->save_pos <= (file->rpos + (file->rend - file->rbuffer)))
+  {
+    // Saved position is still in the read buffer...
+    file->rptr = file->rbuffer + (file->save_pos - file->rpos);
+  }
+  else
+  {
+    // Seek back to the saved position and discard the read buffer...
+    if (cupsFileSeek(file->fp, file->save_pos) != file->save_pos)
+      return (false);
+
+    file->rpos = file->save_pos;
+    file->rptr = file->rbuffer;
+    file->rend = file->rbuffer;
+  }
 
   file->linenum   = file->save_line;
   file->save_pos  = 0;
@@ -975,7 +1053,7 @@ ippFileSavePosition(ipp_file_t *file)	// I - IPP data file
     return (false);
 
   // Save the current position...
-  file->save_pos  = cupsFileTell(file->fp);
+  file->save_pos  = file->rpos + (file->rptr - file->rbuffer);
   file->save_line = file->linenum;
 
   return (true);
@@ -1154,15 +1232,6 @@ ippFileWriteAttributes(
     ipp_t      *ipp,			// I - IPP attributes to write
     bool       with_groups)		// I - `true` to include GROUPs, `false` otherwise
 {
-  bool			ret = true;	// Return value
-  ipp_attribute_t	*attr;		// Current attribute
-  const char		*name;		// Attribute name
-  ipp_tag_t		group_tag,	// Group tag
-			value_tag;	// Value tag
-  size_t		i,		// Looping var
-			count;		// Number of values
-
-
   // Range check input...
   if (!file || file->mode != 'w' || !ipp)
   {
@@ -1173,140 +1242,13 @@ ippFileWriteAttributes(
   // Make sure we are on a new line...
   if (file->column)
   {
-    cupsFilePutChar(file->fp, '\n');
-    file->column = 0;
-  }
-
-  // Loop through the attributes...
-  for (attr = ippGetFirstAttribute(ipp); attr; attr = ippGetNextAttribute(ipp))
-  {
-    if ((name = ippGetName(attr)) == NULL)
-      continue;
-
-    if (file->attr_cb && !(*file->attr_cb)(file, file->cb_data, name))
-      continue;
-
-    count     = ippGetCount(attr);
-    group_tag = ippGetGroupTag(attr);
-    value_tag = ippGetValueTag(attr);
-
-    if (with_groups && group_tag != IPP_TAG_ZERO && group_tag != file->group_tag)
-    {
-      ret &= ippFileWriteToken(file, "GROUP");
-      ret &= ippFileWriteTokenf(file, "%s\n", ippTagString(group_tag));
-      file->group_tag = group_tag;
-    }
-
-    ret &= ippFileWriteToken(file, group_tag == IPP_TAG_ZERO ? "MEMBER" : "ATTR");
-    ret &= ippFileWriteToken(file, ippTagString(value_tag));
-    ret &= ippFileWriteToken(file, name);
-
-    switch (value_tag)
-    {
-      case IPP_TAG_INTEGER :
-      case IPP_TAG_ENUM :
-	  for (i = 0; i < count; i ++)
-	    ret &= cupsFilePrintf(file->fp, "%s%d", i ? "," : " ", ippGetInteger(attr, i));
-	  break;
-
-      case IPP_TAG_BOOLEAN :
-	  ret &= cupsFilePuts(file->fp, ippGetBoolean(attr, 0) ? " true" : " false");
-
-	  for (i = 1; i < count; i ++)
-	    ret &= cupsFilePuts(file->fp, ippGetBoolean(attr, 1) ? ",true" : ",false");
-	  break;
-
-      case IPP_TAG_RANGE :
-	  for (i = 0; i < count; i ++)
-	  {
-	    int upper, lower = ippGetRange(attr, i, &upper);
-					// Upper/lower range values
-
-	    ret &= cupsFilePrintf(file->fp, "%s%d-%d", i ? "," : " ", lower, upper);
-	  }
-	  break;
-
-      case IPP_TAG_RESOLUTION :
-	  for (i = 0; i < count; i ++)
-	  {
-	    ipp_res_t	units;		// Resolution units
-	    int		yres, xres = ippGetResolution(attr, i, &yres, &units);
-					// X/Y resolution
-
-            if (xres == yres)
-	      ret &= cupsFilePrintf(file->fp, "%s%d%s", i ? "," : " ", xres, units == IPP_RES_PER_INCH ? "dpi" : "dpcm");
-	    else
-	      ret &= cupsFilePrintf(file->fp, "%s%dx%d%s", i ? "," : " ", xres, yres, units == IPP_RES_PER_INCH ? "dpi" : "dpcm");
-	  }
-	  break;
-
-      case IPP_TAG_DATE :
-	  for (i = 0; i < count; i ++)
-	  {
-	    time_t	utctime = ippDateToTime(ippGetDate(attr, i));
-					// Date/time value
-            struct tm	utcdate;	// Date/time components
-
-	    // Get the UTC date and time corresponding to this date value...
-            gmtime_r(&utctime, &utcdate);
-
-	    ret &= cupsFilePrintf(file->fp, "%s%04d-%02d-%02dT%02d:%02d:%02dZ", i ? "," : " ", utcdate.tm_year + 1900, utcdate.tm_mon + 1, utcdate.tm_mday, utcdate.tm_hour, utcdate.tm_min, utcdate.tm_sec);
-	  }
-	  break;
-
-      case IPP_TAG_STRING :
-	  for (i = 0; i < count; i ++)
-	  {
-	    size_t	len;		// Length of octetString
-	    const char	*s = (const char *)ippGetOctetString(attr, i, &len);
-					// octetString value
-
-	    ret &= cupsFilePuts(file->fp, i ? "," : " ");
-	    ret &= write_string(file, s, len);
-	  }
-	  break;
-
-      case IPP_TAG_TEXT :
-      case IPP_TAG_TEXTLANG :
-      case IPP_TAG_NAME :
-      case IPP_TAG_NAMELANG :
-      case IPP_TAG_KEYWORD :
-      case IPP_TAG_URI :
-      case IPP_TAG_URISCHEME :
-      case IPP_TAG_CHARSET :
-      case IPP_TAG_LANGUAGE :
-      case IPP_TAG_MIMETYPE :
-	  for (i = 0; i < count; i ++)
-	  {
-	    const char *s = ippGetString(attr, i, NULL);
-					// String value
-
-	    ret &= cupsFilePuts(file->fp, i ? "," : " ");
-	    ret &= write_string(file, s, strlen(s));
-	  }
-	  break;
-
-      case IPP_TAG_BEGIN_COLLECTION :
-	  file->indent += 4;
-	  for (i = 0; i < count; i ++)
-	  {
-	    ret &= cupsFilePuts(file->fp, i ? ",{\n" : " {\n");
-	    ret &= ippFileWriteAttributes(file, ippGetCollection(attr, i), false);
-	    ret &= cupsFilePrintf(file->fp, "%*s}", file->indent - 4, "");
-	  }
-	  file->indent -= 4;
-	  break;
-
-      default :
-	  /* Out-of-band value */
-	  break;
-    }
+    if (!write_data(file, "\n", 1))
+      return (false);
 
-    // Finish with a newline after the attribute definition
-    ret &= cupsFilePutChar(file->fp, '\n');
+    file->column = 0;
   }
 
-  return (ret);
+  return (write_attributes(file, ipp, with_groups));
 }
 
 
@@ -1359,7 +1301,7 @@ ippFileWriteComment(ipp_file_t *file,	// I - IPP data file
   // Make sure we start on a new line...
   if (file->column > 0)
   {
-    ret &= cupsFilePutChar(file->fp, '\n');
+    ret &= write_data(file, "\n", 1);
     file->column = 0;
   }
 
@@ -1370,9 +1312,10 @@ ippFileWriteComment(ipp_file_t *file,	// I - IPP data file
       ptr ++;
 
     // Write this line...
-    ret &= cupsFilePrintf(file->fp, "%*s# ", file->indent, "");
-    ret &= cupsFileWrite(file->fp, start, (size_t)(ptr - start));
-    ret &= cupsFilePutChar(file->fp, '\n');
+    ret &= write_indent(file, file->indent);
+    ret &= write_data(file, "# ", 2);
+    ret &= write_data(file, start, (size_t)(ptr - start));
+    ret &= write_data(file, "\n", 1);
 
     // Skip newline, if any...
     if (*ptr)
@@ -1411,7 +1354,7 @@ ippFileWriteToken(ipp_file_t *file,	// I - IPP data file
     // Add newline before '}' as needed and unindent...
     if (file->column > 0)
     {
-      ret &= cupsFilePutChar(file->fp, '\n');
+      ret &= write_data(file, "\n", 1);
       file->column = 0;
     }
 
@@ -1421,12 +1364,12 @@ ippFileWriteToken(ipp_file_t *file,	// I - IPP data file
 
   if (file->column == 0 && file->indent > 0)
   {
-    ret &= cupsFilePrintf(file->fp, "%*s", file->indent, "");
+    ret &= write_indent(file, file->indent);
     file->column += file->indent;
   }
   else if (strcmp(token, "{") && strcmp(token, "}"))
   {
-    ret &= cupsFilePutChar(file->fp, ' ');
+    ret &= write_data(file, " ", 1);
     file->column ++;
   }
 
@@ -1445,20 +1388,20 @@ ippFileWriteToken(ipp_file_t *file,	// I - IPP data file
   else if (!strcmp(token, "{"))
   {
     // Add newline after '{' and indent...
-    ret &= cupsFilePuts(file->fp, "{\n");
+    ret &= write_data(file, "{\n", 2);
     file->column = 0;
     file->indent += 4;
   }
   else if (!strcmp(token, "}"))
   {
     // Add newline after '}'...
-    ret &= cupsFilePuts(file->fp, "}\n");
+    ret &= write_data(file, "}\n", 2);
     file->column = 0;
   }
   else
   {
     // Just write the string as-is...
-    ret &= cupsFilePuts(file->fp, token);
+    ret &= write_data(file, token, strlen(token));
 
     if ((ptr = token + strlen(token) - 1) >= token && *ptr == '\n')
     {
@@ -1539,7 +1482,7 @@ expand_buffer(ipp_file_t *file,		// I - IPP data file
     return (true);
 
   // Try allocating/expanding the current buffer...
-  if ((buffer = realloc(file->buffer, buffer_size)) == NULL)
+  if ((buffer = _cupsMemRealloc(CUPS_MEMTYPE_IPP, file->buffer, buffer_size)) == NULL)
     return (false);
 
   // Save new buffer and size...
@@ -1820,6 +1763,49 @@ parse_value(ipp_file_t      *file,	// I  - IPP data file
 }
 
 
+//
+// 'read_char()' - Read a character from an IPP data file.
+//
+// Characters are returned from the read buffer, which is refilled in large
+// blocks so that the tokenizer can scan runs of characters directly.
+//
+
+static int				// O - Character or `EOF`
+read_char(ipp_file_t *file)		// I - IPP data file
+{
+  size_t	keep = 0;		// Bytes to keep
+  ssize_t	bytes;			// Bytes read
+
+
+  if (file->rptr < file->rend)
+    return (*(file->rptr)++ & 255);
+
+  // Keep any saved position in the buffer so that restoring it does not
+  // need to seek...
+  if (file->save_line && file->save_pos >= file->rpos && file->save_pos < (file->rpos + (file->rend - file->rbuffer)))
+  {
+    keep = (size_t)(file->rpos + (file->rend - file->rbuffer) - file->save_pos);
+
+    if (keep > (sizeof(file->rbuffer) / 2))
+      keep = 0;
+    else
+      memmove(file->rbuffer, file->rend - keep, keep);
+  }
+
+  // Refill the read buffer...
+  file->rpos += (file->rend - file->rbuffer) - (off_t)keep;
+  file->rptr = file->rbuffer + keep;
+  file->rend = file->rbuffer + keep;
+
+  if ((bytes = cupsFileRead(file->fp, file->rend, sizeof(file->rbuffer) - keep)) <= 0)
+    return (EOF);
+
+  file->rend += bytes;
+
+  return (*(file->rptr)++ & 255);
+}
+
+
 //
 // 'report_error()' - Report an error.
 //
@@ -1846,9 +1832,304 @@ report_error(
 }
 
 
+//
+// 'write_attributes()' - Write attributes to an IPP data file.
+//
+// Each attribute is formatted in a single pass into the write buffer.  The
+// current column must be 0.
+//
+
+static bool				// O - `true` on success, `false` on failure
+write_attributes(ipp_file_t *file,	// I - IPP data file
+                 ipp_t      *ipp,	// I - IPP attributes to write
+                 bool       with_groups)// I - `true` to include GROUPs, `false` otherwise
+{
+  bool			ret = true;	// Return value
+  ipp_attribute_t	*attr;		// Current attribute
+  const char		*name,		// Attribute name
+			*s;		// String value
+  ipp_tag_t		group_tag,	// Group tag
+			value_tag;	// Value tag
+  size_t		i,		// Looping var
+			count,		// Number of values
+			len;		// Length of string
+  int			lower,		// Lower range value
+			upper,		// Upper range value
+			xres,		// X resolution
+			yres;		// Y resolution
+  ipp_res_t		units;		// Resolution units
+  time_t		utctime;	// Date/time value
+  struct tm		utcdate;	// Date/time components
+  char			date[32];	// Formatted date/time
+
+
+  // Loop through the attributes...
+  for (attr = ippGetFirstAttribute(ipp); attr && ret; attr = ippGetNextAttribute(ipp))
+  {
+    if ((name = ippGetName(attr)) == NULL)
+      continue;
+
+    if (file->attr_cb && !(*file->attr_cb)(file, file->cb_data, name))
+      continue;
+
+    count     = ippGetCount(attr);
+    group_tag = ippGetGroupTag(attr);
+    value_tag = ippGetValueTag(attr);
+
+    if (with_groups && group_tag != IPP_TAG_ZERO && group_tag != file->group_tag)
+    {
+      s = ippTagString(group_tag);
+
+      ret &= write_indent(file, file->indent);
+      ret &= write_data(file, "GROUP ", 6);
+      ret &= write_data(file, s, strlen(s));
+      ret &= write_data(file, "\n", 1);
+
+      file->group_tag = group_tag;
+    }
+
+    // Write the directive, value tag, and name...
+    s = ippTagString(value_tag);
+
+    ret &= write_indent(file, file->indent);
+    if (group_tag == IPP_TAG_ZERO)
+      ret &= write_data(file, "MEMBER ", 7);
+    else
+      ret &= write_data(file, "ATTR ", 5);
+    ret &= write_data(file, s, strlen(s));
+    ret &= write_data(file, " ", 1);
+
+    if (strpbrk(name, " \t\'\"\\"))
+      ret &= write_string(file, name, strlen(name));
+    else
+      ret &= write_data(file, name, strlen(name));
+
+    // Then the values...
+    switch (value_tag)
+    {
+      case IPP_TAG_INTEGER :
+      case IPP_TAG_ENUM :
+	  for (i = 0; i < count; i ++)
+	  {
+	    ret &= write_data(file, i ? "," : " ", 1);
+	    ret &= write_int(file, ippGetInteger(attr, i));
+	  }
+	  break;
+
+      case IPP_TAG_BOOLEAN :
+	  for (i = 0; i < count; i ++)
+	  {
+	    if (ippGetBoolean(attr, i))
+	      ret &= write_data(file, i ? ",true" : " true", 5);
+	    else
+	      ret &= write_data(file, i ? ",false" : " false", 6);
+	  }
+	  break;
+
+      case IPP_TAG_RANGE :
+	  for (i = 0; i < count; i ++)
+	  {
+	    lower = ippGetRange(attr, i, &upper);
+
+	    ret &= write_data(file, i ? "," : " ", 1);
+	    ret &= write_int(file, lower);
+	    ret &= write_data(file, "-", 1);
+	    ret &= write_int(file, upper);
+	  }
+	  break;
+
+      case IPP_TAG_RESOLUTION :
+	  for (i = 0; i < count; i ++)
+	  {
+	    xres = ippGetResolution(attr, i, &yres, &units);
+
+	    ret &= write_data(file, i ? "," : " ", 1);
+	    ret &= write_int(file, xres);
+
+            if (xres != yres)
+            {
+	      ret &= write_data(file, "x", 1);
+	      ret &= write_int(file, yres);
+	    }
+
+	    if (units == IPP_RES_PER_INCH)
+	      ret &= write_data(file, "dpi", 3);
+	    else
+	      ret &= write_data(file, "dpcm", 4);
+	  }
+	  break;
+
+      case IPP_TAG_DATE :
+	  for (i = 0; i < count; i ++)
+	  {
+	    // Get the UTC date and time corresponding to this date value...
+	    utctime = ippDateToTime(ippGetDate(attr, i));
+            gmtime_r(&utctime, &utcdate);
+
+	    len = (size_t)snprintf(date, sizeof(date), "%s%04d-%02d-%02dT%02d:%02d:%02dZ", i ? "," : " ", utcdate.tm_year + 1900, utcdate.tm_mon + 1, utcdate.tm_mday, utcdate.tm_hour, utcdate.tm_min, utcdate.tm_sec);
+	    ret &= write_data(file, date, len);
+	  }
+	  break;
+
+      case IPP_TAG_STRING :
+	  for (i = 0; i < count; i ++)
+	  {
+	    s = (const char *)ippGetOctetString(attr, i, &len);
+
+	    ret &= write_data(file, i ? "," : " ", 1);
+	    ret &= write_string(file, s, len);
+	  }
+	  break;
+
+      case IPP_TAG_TEXT :
+      case IPP_TAG_TEXTLANG :
+      case IPP_TAG_NAME :
+      case IPP_TAG_NAMELANG :
+      case IPP_TAG_KEYWORD :
+      case IPP_TAG_URI :
+      case IPP_TAG_URISCHEME :
+      case IPP_TAG_CHARSET :
+      case IPP_TAG_LANGUAGE :
+      case IPP_TAG_MIMETYPE :
+	  for (i = 0; i < count; i ++)
+	  {
+	    s = ippGetString(attr, i, NULL);
+
+	    ret &= write_data(file, i ? "," : " ", 1);
+	    ret &= write_string(file, s, strlen(s));
+	  }
+	  break;
+
+      case IPP_TAG_BEGIN_COLLECTION :
+	  file->indent += 4;
+	  for (i = 0; i < count; i ++)
+	  {
+	    ret &= write_data(file, i ? ",{\n" : " {\n", 3);
+	    ret &= write_attributes(file, ippGetCollection(attr, i), false);
+	    ret &= write_indent(file, file->indent - 4);
+	    ret &= write_data(file, "}", 1);
+	  }
+	  file->indent -= 4;
+	  break;
+
+      default :
+	  /* Out-of-band value */
+	  break;
+    }
+
+    // Finish with a newline after the attribute definition
+    ret &= write_data(file, "\n", 1);
+    file->column = 0;
+  }
+
+  return (ret);
+}
+
+
+//
+// 'write_data()' - Write data to the write buffer.
+//
+
+static bool				// O - `true` on success, `false` on failure
+write_data(ipp_file_t *file,		// I - IPP data file
+           const char *data,		// I - Data to write
+           size_t     len)		// I - Length of data
+{
+  if (len > (size_t)(file->wbuffer + sizeof(file->wbuffer) - file->wptr))
+  {
+    // Flush the buffer and write large data directly...
+    if (!write_flush(file))
+      return (false);
+
+    if (len >= sizeof(file->wbuffer))
+      return (cupsFileWrite(file->fp, data, len));
+  }
+
+  memcpy(file->wptr, data, len);
+  file->wptr += len;
+
+  return (true);
+}
+
+
+//
+// 'write_flush()' - Flush the write buffer.
+//
+
+static bool				// O - `true` on success, `false` on failure
+write_flush(ipp_file_t *file)		// I - IPP data file
+{
+  size_t	len = (size_t)(file->wptr - file->wbuffer);
+					// Number of bytes in buffer
+
+
+  file->wptr = file->wbuffer;
+
+  return (len == 0 || cupsFileWrite(file->fp, file->wbuffer, len));
+}
+
+
+//
+// 'write_indent()' - Write indentation.
+//
+
+static bool				// O - `true` on success, `false` on failure
+write_indent(ipp_file_t *file,		// I - IPP data file
+             int        indent)		// I - Number of spaces
+{
+  bool		ret = true;		// Return value
+  int		count;			// Spaces to write
+  static const char spaces[] = "                                ";
+					// Spaces
+
+
+  for (; indent > 0 && ret; indent -= count)
+  {
+    if ((count = indent) > (int)(sizeof(spaces) - 1))
+      count = (int)(sizeof(spaces) - 1);
+
+    ret = write_data(file, spaces, (size_t)count);
+  }
+
+  return (ret);
+}
+
+
+//
+// 'write_int()' - Write an integer value.
+//
+
+static bool				// O - `true` on success, `false` on failure
+write_int(ipp_file_t *file,		// I - IPP data file
+          int        value)		// I - Value
+{
+  char		buffer[16],		// Formatted value
+		*bufptr = buffer + sizeof(buffer);
+					// Pointer into buffer
+  unsigned	uvalue = value < 0 ? 0U - (unsigned)value : (unsigned)value;
+					// Absolute value
+
+
+  do
+  {
+    *--bufptr = (char)('0' + uvalue % 10);
+    uvalue /= 10;
+  }
+  while (uvalue > 0);
+
+  if (value < 0)
+    *--bufptr = '-';
+
+  return (write_data(file, bufptr, (size_t)(buffer + sizeof(buffer) - bufptr)));
+}
+
+
 //
 // 'write_string()' - Write a quoted string value.
 //
+// Spans of characters that do not need quoting are copied to the write buffer
+// as a whole.
+//
 
 static bool				// O - `true` on success, `false` on failure
 write_string(ipp_file_t *file,		// I - IPP data file
@@ -1856,43 +2137,36 @@ write_string(ipp_file_t *file,		// I - IPP data file
              size_t     len)		// I - Length of string
 {
   bool		ret = true;		// Return value
-  const char	*start,			// Start of string
+  const char	*start,			// Start of span
 		*ptr,			// Pointer into string
 		*end;			// End of string
+  char		quoted[2];		// Quoted character
 
 
   // Start with a double quote...
-  ret &= cupsFilePutChar(file->fp, '\"');
-  file->column ++;
+  ret &= write_data(file, "\"", 1);
+  file->column += (int)len + 2;
 
   // Loop through the string...
   for (start = s, end = s + len, ptr = start; ptr < end; ptr ++)
   {
     if (*ptr == '\"' || *ptr == '\\')
     {
-      // Something that needs to be quoted...
-      if (ptr > start)
-      {
-        // Write lead-in text...
-	ret &= cupsFileWrite(file->fp, start, (size_t)(ptr - start));
-	file->column += ptr - start;
-      }
+      // Something that needs to be quoted, write the lead-in text and then
+      // quote the " or \...
+      quoted[0] = '\\';
+      quoted[1] = *ptr;
+
+      ret &= write_data(file, start, (size_t)(ptr - start));
+      ret &= write_data(file, quoted, 2);
 
-      // Then quote the " or \...
-      ret &= cupsFilePrintf(file->fp, "\\%c", *ptr);
       start = ptr + 1;
       file->column ++;
     }
   }
 
-  if (ptr > start)
-  {
-    ret &= cupsFileWrite(file->fp, start, (size_t)(ptr - start));
-    file->column += ptr - start;
-  }
-
-  ret &= cupsFilePutChar(file->fp, '\"');
-  file->column ++;
+  ret &= write_data(file, start, (size_t)(ptr - start));
+  ret &= write_data(file, "\"", 1);
 
   return (ret);
 }
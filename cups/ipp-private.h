@@ -12,6 +12,7 @@
 #ifndef _CUPS_IPP_PRIVATE_H_
 #  define _CUPS_IPP_PRIVATE_H_
 #  include "cups.h"
+#  include "thread.h"
 #  ifdef __cplusplus
 extern "C" {
 #  endif // __cplusplus
@@ -24,6 +25,14 @@ extern "C" {
 #  define IPP_BUF_SIZE	(IPP_MAX_LENGTH + 2)
 					// Size of buffer
 #  define _IPP_MAX_FIND	8		// Size of find stack
+#  define _IPP_ARENA_ALIGN	16		// Alignment of arena allocations
+#  define _IPP_ARENA_SIZE	16384		// Size of arena memory blocks
+#  define _IPP_INDEX_HASH	256		// Size of name index hash
+#  define _IPP_INDEX_MIN	32		// Minimum attributes for name index
+#  define _IPP_INLINE_NAME	64		// Maximum inline attribute name length
+#  define _IPP_INLINE_VALUE	32		// Inline storage for a single string value
+#  define _IPP_RA_CACHE		32		// Size of requested-attributes cache
+#  define _IPP_RA_MAX_VALUES	64		// Maximum cached requested-attributes values
 
 
 //
@@ -103,6 +112,11 @@ struct _ipp_attribute_s			// IPP attribute
   ipp_tag_t	group_tag,		// Job/Printer/Operation group tag
 		value_tag;		// What type of value is it?
   char		*name;			// Name of attribute
+  size_t	alloc_size;		// Allocated size of attribute
+  unsigned short inline_size,		// Size of inline string storage
+		inline_used;		// Bytes used in inline string storage
+  ipp_uchar_t	*encoded;		// Encoded attribute from ippFreeze, if any
+  size_t	encoded_len;		// Length of encoded attribute
   size_t	num_values;		// Number of values
   _ipp_value_t	values[1];		// Values
 };
@@ -114,6 +128,27 @@ typedef struct _ipp_find_s		// IPP find data
   bool			atend;		// At the end of the message?
 } _ipp_find_t;
 
+struct _ipp_path_s			// Compiled IPP attribute path
+{
+  size_t		num_names;	// Number of names in path
+  char			*names[1];	// Names
+};
+
+typedef struct _ipp_arena_block_s	// IPP arena memory block
+{
+  struct _ipp_arena_block_s *next;	// Next (older) block
+  size_t		size,		// Size of block data
+			used;		// Bytes used in block
+  unsigned char		*data;		// Block data (follows the header)
+} _ipp_arena_block_t;
+
+typedef struct _ipp_arena_s		// IPP message arena
+{
+  cups_atomic_t		use;		// Use count (messages sharing the arena)
+  _ipp_arena_block_t	*blocks;	// Memory blocks, newest first
+  _ipp_arena_block_t	*spare;		// Spare blocks kept by ippReset
+} _ipp_arena_t;
+
 struct _ipp_s				// IPP Request/Response/Notification
 {
   ipp_state_t		state;		// State of request
@@ -123,10 +158,21 @@ struct _ipp_s				// IPP Request/Response/Notification
   ipp_attribute_t	*current;	// Current attribute (for read/write)
   ipp_tag_t		curtag;		// Current attribute group tag
   ipp_attribute_t	*prev;		// Previous attribute (for read)
-  size_t		use;		// Use count
+  cups_atomic_t		use;		// Use count
   _ipp_find_t		fstack[_IPP_MAX_FIND];
 					// Find stack
   _ipp_find_t		*find;		// Current find
+  _ipp_arena_t		*arena;		// Arena allocator or `NULL` for heap
+  size_t		num_attrs;	// Number of attributes
+  cups_array_t		*index;		// Name index for large messages
+  ipp_stream_cb_t	stream_cb;	// Streaming attribute callback, if any
+  void			*stream_data;	// Streaming callback data
+  bool			frozen;		// Has the message been frozen?
+  bool			length_valid,	// Is the cached length valid?
+			length_col,	// Is the cached length for a collection?
+			length_nested;	// Does the cached length include collections?
+  size_t		length;		// Cached length from ipp_length
+  ipp_uchar_t		*frozen_data;	// Encoded attributes for frozen message
 };
 
 typedef struct _ipp_option_s		// Attribute mapping data
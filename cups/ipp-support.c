@@ -12,6 +12,41 @@
 #include "cups-private.h"
 
 
+//
+// Local types...
+//
+
+typedef struct _ipp_name_s		// Sorted name index entry
+{
+  const char	*name;			// Name
+  int		value;			// Value
+} _ipp_name_t;
+
+typedef struct _ipp_enum_s		// Enum attribute
+{
+  const char		*attrname;	// Attribute name
+  const char * const	*strings;	// Enum strings or `NULL` for operations
+  size_t		num_strings;	// Number of enum strings
+  int			first;		// Value of first string
+} _ipp_enum_t;
+
+typedef struct _ipp_ra_s		// Cached requested-attributes array
+{
+  ipp_op_t		op;		// Operation code
+  size_t		hash,		// Hash of values
+			num_values;	// Number of values
+  char			**values;	// Copy of values
+  cups_array_t		*ra;		// Requested attributes array
+} _ipp_ra_t;
+
+typedef struct _ipp_sbuf_s		// String output buffer
+{
+  char			*ptr,		// Current position in buffer
+			*end;		// End of buffer (less nul)
+  size_t		len;		// Length of output
+} _ipp_sbuf_t;
+
+
 //
 // Local globals...
 //
@@ -593,12 +628,77 @@ static const char * const ipp_system_states[] =
   "stopped"
 };
 
+static const _ipp_enum_t ipp_enums[] =	// Enum attributes, sorted by name
+{
+  { "document-state", ipp_document_states, sizeof(ipp_document_states) / sizeof(ipp_document_states[0]), 3 },
+  { "finishings", ipp_finishings, sizeof(ipp_finishings) / sizeof(ipp_finishings[0]), 3 },
+  { "finishings-actual", ipp_finishings, sizeof(ipp_finishings) / sizeof(ipp_finishings[0]), 3 },
+  { "finishings-default", ipp_finishings, sizeof(ipp_finishings) / sizeof(ipp_finishings[0]), 3 },
+  { "finishings-ready", ipp_finishings, sizeof(ipp_finishings) / sizeof(ipp_finishings[0]), 3 },
+  { "finishings-supported", ipp_finishings, sizeof(ipp_finishings) / sizeof(ipp_finishings[0]), 3 },
+  { "job-collation-type", ipp_job_collation_types, sizeof(ipp_job_collation_types) / sizeof(ipp_job_collation_types[0]), 3 },
+  { "job-collation-type-actual", ipp_job_collation_types, sizeof(ipp_job_collation_types) / sizeof(ipp_job_collation_types[0]), 3 },
+  { "job-finishings", ipp_finishings, sizeof(ipp_finishings) / sizeof(ipp_finishings[0]), 3 },
+  { "job-finishings-default", ipp_finishings, sizeof(ipp_finishings) / sizeof(ipp_finishings[0]), 3 },
+  { "job-finishings-supported", ipp_finishings, sizeof(ipp_finishings) / sizeof(ipp_finishings[0]), 3 },
+  { "job-state", ipp_job_states, sizeof(ipp_job_states) / sizeof(ipp_job_states[0]), IPP_JSTATE_PENDING },
+  { "operations-supported", NULL, 0, 0 },
+  { "orientation-requested", ipp_orientation_requesteds, sizeof(ipp_orientation_requesteds) / sizeof(ipp_orientation_requesteds[0]), 3 },
+  { "orientation-requested-actual", ipp_orientation_requesteds, sizeof(ipp_orientation_requesteds) / sizeof(ipp_orientation_requesteds[0]), 3 },
+  { "orientation-requested-default", ipp_orientation_requesteds, sizeof(ipp_orientation_requesteds) / sizeof(ipp_orientation_requesteds[0]), 3 },
+  { "orientation-requested-supported", ipp_orientation_requesteds, sizeof(ipp_orientation_requesteds) / sizeof(ipp_orientation_requesteds[0]), 3 },
+  { "print-quality", ipp_print_qualities, sizeof(ipp_print_qualities) / sizeof(ipp_print_qualities[0]), 3 },
+  { "print-quality-actual", ipp_print_qualities, sizeof(ipp_print_qualities) / sizeof(ipp_print_qualities[0]), 3 },
+  { "print-quality-default", ipp_print_qualities, sizeof(ipp_print_qualities) / sizeof(ipp_print_qualities[0]), 3 },
+  { "print-quality-supported", ipp_print_qualities, sizeof(ipp_print_qualities) / sizeof(ipp_print_qualities[0]), 3 },
+  { "printer-state", ipp_printer_states, sizeof(ipp_printer_states) / sizeof(ipp_printer_states[0]), IPP_PSTATE_IDLE },
+  { "resource-state", ipp_resource_states, sizeof(ipp_resource_states) / sizeof(ipp_resource_states[0]), IPP_RSTATE_PENDING },
+  { "system-state", ipp_system_states, sizeof(ipp_system_states) / sizeof(ipp_system_states[0]), IPP_SSTATE_IDLE }
+};
+
+#ifdef _WIN32
+static cups_mutex_t	ipp_index_mutex = CUPS_MUTEX_INITIALIZER;
+					// Mutex for sorted name indices
+static bool		ipp_index_ready = false;
+					// Have the indices been built?
+#else
+static pthread_once_t	ipp_index_once = PTHREAD_ONCE_INIT;
+					// One-time initialization of sorted name indices
+#endif // _WIN32
+static size_t		ipp_num_ra_index = 0;
+					// Number of registered names
+static _ipp_ra_t	ipp_ra_cache[_IPP_RA_CACHE];
+					// Cached requested-attributes arrays
+static _ipp_name_t	*ipp_ra_index = NULL;
+					// Sorted registered attribute and group names
+static cups_mutex_t	ipp_ra_mutex = CUPS_MUTEX_INITIALIZER;
+					// Mutex for cached requested-attributes arrays
+static _ipp_name_t	ipp_finishings_index[sizeof(ipp_finishings) / sizeof(ipp_finishings[0]) + sizeof(ipp_finishings_vendor) / sizeof(ipp_finishings_vendor[0])],
+					// Sorted finishings names
+			ipp_ops_index[sizeof(ipp_std_ops) / sizeof(ipp_std_ops[0]) + sizeof(ipp_cups_ops) / sizeof(ipp_cups_ops[0]) + sizeof(ipp_cups_ops2) / sizeof(ipp_cups_ops2[0])],
+					// Sorted operation names
+			ipp_status_index[sizeof(ipp_status_oks) / sizeof(ipp_status_oks[0]) + sizeof(ipp_status_400s) / sizeof(ipp_status_400s[0]) + sizeof(ipp_status_500s) / sizeof(ipp_status_500s[0]) + sizeof(ipp_status_1000s) / sizeof(ipp_status_1000s[0])],
+					// Sorted status code names
+			ipp_tags_index[sizeof(ipp_tag_names) / sizeof(ipp_tag_names[0])];
+					// Sorted tag names
+
 
 //
 // Local functions...
 //
 
-static size_t	ipp_col_string(ipp_t *col, char *buffer, size_t bufsize);
+static size_t	ipp_add_names(_ipp_name_t *index, size_t num_index, const char * const *names, size_t num_names, int first);
+static void	ipp_attr_string(ipp_attribute_t *attr, _ipp_sbuf_t *sbuf);
+static void	ipp_col_string(ipp_t *col, _ipp_sbuf_t *sbuf);
+static int	ipp_compare_names(_ipp_name_t *a, _ipp_name_t *b);
+static int	ipp_compare_names_nocase(_ipp_name_t *a, _ipp_name_t *b);
+static const _ipp_enum_t *ipp_find_enum(const char *attrname);
+static const _ipp_name_t *ipp_find_name(const _ipp_name_t *index, size_t num_index, const char *name, bool nocase);
+static void	ipp_init_names(void);
+static void	ipp_init_names_once(void);
+static void	ipp_sbuf_putc(_ipp_sbuf_t *sbuf, char ch);
+static void	ipp_sbuf_putint(_ipp_sbuf_t *sbuf, int value, size_t digits);
+static void	ipp_sbuf_puts(_ipp_sbuf_t *sbuf, const char *s, size_t len);
 
 
 //
@@ -616,212 +716,38 @@ ippAttributeString(
     char            *buffer,		// I - String buffer or NULL
     size_t          bufsize)		// I - Size of string buffer
 {
-  int		i;			// Looping var
-  char		*bufptr,		// Pointer into buffer
-		*bufend,		// End of buffer
-		temp[256];		// Temporary string
-  const char	*ptr,			// Pointer into string
-		*end;			// Pointer to end of string
-  _ipp_value_t	*val;			// Current value
+  _ipp_sbuf_t	sbuf;			// String buffer
 
 
   // Range check input...
   if (!attr || !attr->name)
   {
-    if (buffer)
+    if (buffer && bufsize > 0)
       *buffer = '\0';
 
     return (0);
   }
 
   // Setup buffer pointers...
-  bufptr = buffer;
-  if (buffer)
-    bufend = buffer + bufsize - 1;
+  if (buffer && bufsize > 0)
+  {
+    sbuf.ptr = buffer;
+    sbuf.end = buffer + bufsize - 1;
+  }
   else
-    bufend = NULL;
-
-  // Loop through the values...
-  for (i = attr->num_values, val = attr->values; i > 0; i --, val ++)
   {
-    if (val > attr->values)
-    {
-      if (buffer && bufptr < bufend)
-        *bufptr++ = ',';
-      else
-        bufptr ++;
-    }
-
-    switch (attr->value_tag & ~IPP_TAG_CUPS_CONST)
-    {
-      case IPP_TAG_ENUM :
-          ptr = ippEnumString(attr->name, val->integer);
-
-          if (buffer && bufptr < bufend)
-            cupsCopyString(bufptr, ptr, (size_t)(bufend - bufptr + 1));
-
-          bufptr += strlen(ptr);
-          break;
-
-      case IPP_TAG_INTEGER :
-          if (buffer && bufptr < bufend)
-            bufptr += snprintf(bufptr, (size_t)(bufend - bufptr + 1), "%d", val->integer);
-          else
-            bufptr += snprintf(temp, sizeof(temp), "%d", val->integer);
-          break;
-
-      case IPP_TAG_BOOLEAN :
-          if (buffer && bufptr < bufend)
-            cupsCopyString(bufptr, val->boolean ? "true" : "false", (size_t)(bufend - bufptr + 1));
-
-          bufptr += val->boolean ? 4 : 5;
-          break;
-
-      case IPP_TAG_RANGE :
-          if (buffer && bufptr < bufend)
-            bufptr += snprintf(bufptr, (size_t)(bufend - bufptr + 1), "%d-%d", val->range.lower, val->range.upper);
-          else
-            bufptr += snprintf(temp, sizeof(temp), "%d-%d", val->range.lower, val->range.upper);
-          break;
-
-      case IPP_TAG_RESOLUTION :
-	  if (val->resolution.xres == val->resolution.yres)
-	  {
-	    if (buffer && bufptr < bufend)
-	      bufptr += snprintf(bufptr, (size_t)(bufend - bufptr + 1), "%d%s", val->resolution.xres, val->resolution.units == IPP_RES_PER_INCH ? "dpi" : "dpcm");
-	    else
-	      bufptr += snprintf(temp, sizeof(temp), "%d%s", val->resolution.xres, val->resolution.units == IPP_RES_PER_INCH ? "dpi" : "dpcm");
-	  }
-	  else if (buffer && bufptr < bufend)
-            bufptr += snprintf(bufptr, (size_t)(bufend - bufptr + 1), "%dx%d%s", val->resolution.xres, val->resolution.yres, val->resolution.units == IPP_RES_PER_INCH ? "dpi" : "dpcm");
-          else
-            bufptr += snprintf(temp, sizeof(temp), "%dx%d%s", val->resolution.xres, val->resolution.yres, val->resolution.units == IPP_RES_PER_INCH ? "dpi" : "dpcm");
-          break;
-
-      case IPP_TAG_DATE :
-          {
-            unsigned year;		// Year
-
-            year = ((unsigned)val->date[0] << 8) + (unsigned)val->date[1];
-
-	    if (val->date[9] == 0 && val->date[10] == 0)
-	      snprintf(temp, sizeof(temp), "%04u-%02u-%02uT%02u:%02u:%02uZ",
-		       year, val->date[2], val->date[3], val->date[4],
-		       val->date[5], val->date[6]);
-	    else
-	      snprintf(temp, sizeof(temp),
-	               "%04u-%02u-%02uT%02u:%02u:%02u%c%02u%02u",
-		       year, val->date[2], val->date[3], val->date[4],
-		       val->date[5], val->date[6], val->date[8], val->date[9],
-		       val->date[10]);
-
-            if (buffer && bufptr < bufend)
-              cupsCopyString(bufptr, temp, (size_t)(bufend - bufptr + 1));
-
-            bufptr += strlen(temp);
-          }
-          break;
-
-      case IPP_TAG_TEXT :
-      case IPP_TAG_NAME :
-      case IPP_TAG_KEYWORD :
-      case IPP_TAG_CHARSET :
-      case IPP_TAG_URI :
-      case IPP_TAG_URISCHEME :
-      case IPP_TAG_MIMETYPE :
-      case IPP_TAG_LANGUAGE :
-      case IPP_TAG_TEXTLANG :
-      case IPP_TAG_NAMELANG :
-	  if (!val->string.text)
-	    break;
-
-          for (ptr = val->string.text; *ptr; ptr ++)
-          {
-            if (*ptr == '\\' || *ptr == '\"' || *ptr == '[')
-            {
-              if (buffer && bufptr < bufend)
-                *bufptr = '\\';
-              bufptr ++;
-            }
-
-            if (buffer && bufptr < bufend)
-              *bufptr = *ptr;
-            bufptr ++;
-          }
-
-          if (val->string.language)
-          {
-           /*
-            * Add "[language]" to end of string...
-            */
-
-            if (buffer && bufptr < bufend)
-              *bufptr = '[';
-            bufptr ++;
-
-            if (buffer && bufptr < bufend)
-              cupsCopyString(bufptr, val->string.language, (size_t)(bufend - bufptr));
-            bufptr += strlen(val->string.language);
-
-            if (buffer && bufptr < bufend)
-              *bufptr = ']';
-            bufptr ++;
-          }
-          break;
-
-      case IPP_TAG_BEGIN_COLLECTION :
-          if (buffer && bufptr < bufend)
-            bufptr += ipp_col_string(val->collection, bufptr, (size_t)(bufend - bufptr + 1));
-          else
-            bufptr += ipp_col_string(val->collection, NULL, 0);
-          break;
-
-      case IPP_TAG_STRING :
-          for (ptr = val->unknown.data, end = ptr + val->unknown.length;
-               ptr < end; ptr ++)
-          {
-            if (*ptr == '\\' || _cups_isspace(*ptr))
-            {
-              if (buffer && bufptr < bufend)
-                *bufptr = '\\';
-              bufptr ++;
+    sbuf.ptr = sbuf.end = NULL;
+  }
 
-              if (buffer && bufptr < bufend)
-                *bufptr = *ptr;
-              bufptr ++;
-            }
-            else if (!isprint(*ptr & 255))
-            {
-              if (buffer && bufptr < bufend)
-                bufptr += snprintf(bufptr, (size_t)(bufend - bufptr + 1), "\\%03o", *ptr & 255);
-              else
-                bufptr += snprintf(temp, sizeof(temp), "\\%03o", *ptr & 255);
-            }
-            else
-            {
-              if (buffer && bufptr < bufend)
-                *bufptr = *ptr;
-              bufptr ++;
-            }
-          }
-          break;
+  sbuf.len = 0;
 
-      default :
-          ptr = ippTagString(attr->value_tag);
-          if (buffer && bufptr < bufend)
-            cupsCopyString(bufptr, ptr, (size_t)(bufend - bufptr + 1));
-          bufptr += strlen(ptr);
-          break;
-    }
-  }
+  // Format the values, nul-terminate, and return...
+  ipp_attr_string(attr, &sbuf);
 
-  // Nul-terminate and return...
-  if (buffer && bufptr < bufend)
-    *bufptr = '\0';
-  else if (bufend)
-    *bufend = '\0';
+  if (sbuf.ptr)
+    *sbuf.ptr = '\0';
 
-  return ((size_t)(bufptr - buffer));
+  return (sbuf.len);
 }
 
 
@@ -842,17 +768,30 @@ ippAttributeString(
 // `cupsArrayFind(array, "attribute-name")` will return a non-NULL pointer.  The
 // array must be freed using @link cupsArrayDelete@.
 //
+// The arrays for commonly used lists of registered values are cached, so
+// repeated calls with the same operation and "requested-attributes" values
+// only need to copy the cached array.
+//
 
 cups_array_t *				// O - CUPS array or `NULL` if all
 ippCreateRequestedArray(ipp_t *request)	// I - IPP request
 {
-  size_t		i, j,		// Looping vars
+  size_t		i,		// Looping var
 			count;		// Number of values
   bool			added;		// Was name added?
   ipp_op_t		op;		// IPP operation code
   ipp_attribute_t	*requested;	// requested-attributes attribute
   cups_array_t		*ra;		// Requested attributes array
-  const char		*value;		// Current value
+  const char		*value,		// Current value
+			*ptr;		// Pointer into value
+  size_t		hash,		// Hash of values
+			len;		// Length of values
+  _ipp_ra_t		*entry;		// Cache entry
+  char			**values,	// Copy of values for cache entry
+			*s;		// Pointer into copy of values
+  const _ipp_name_t	*n;		// Registered name
+  bool			registered = true;
+					// Are all values registered names?
   // The following lists come from the current IANA IPP registry of attributes
   static const char * const document_description[] =
   {					// document-description group
@@ -1987,6 +1926,42 @@ ippCreateRequestedArray(ipp_t *request)	// I - IPP request
     "xri-security-supported",
     "xri-uri-scheme-supported"
   };
+  static const char * const groups[] =
+  {					// Group keywords
+    "all",
+    "document-description",
+    "document-template",
+    "job-description",
+    "job-template",
+    "printer-description",
+    "resource-description",
+    "resource-status",
+    "resource-template",
+    "subscription-description",
+    "subscription-template",
+    "system-description",
+    "system-status"
+  };
+  static const struct
+  {
+    const char * const	*names;		// Names
+    size_t		num_names;	// Number of names
+  }			lists[] =
+  {					// Registered name lists
+    { groups, sizeof(groups) / sizeof(groups[0]) },
+    { document_description, sizeof(document_description) / sizeof(document_description[0]) },
+    { document_template, sizeof(document_template) / sizeof(document_template[0]) },
+    { job_description, sizeof(job_description) / sizeof(job_description[0]) },
+    { job_template, sizeof(job_template) / sizeof(job_template[0]) },
+    { printer_description, sizeof(printer_description) / sizeof(printer_description[0]) },
+    { resource_description, sizeof(resource_description) / sizeof(resource_description[0]) },
+    { resource_status, sizeof(resource_status) / sizeof(resource_status[0]) },
+    { resource_template, sizeof(resource_template) / sizeof(resource_template[0]) },
+    { subscription_description, sizeof(subscription_description) / sizeof(subscription_description[0]) },
+    { subscription_template, sizeof(subscription_template) / sizeof(subscription_template[0]) },
+    { system_description, sizeof(system_description) / sizeof(system_description[0]) },
+    { system_status, sizeof(system_status) / sizeof(system_status[0]) }
+  };
 
 
   // Get the requested-attributes attribute...
@@ -2023,8 +1998,77 @@ ippCreateRequestedArray(ipp_t *request)	// I - IPP request
   if (count == 1 && !strcmp(ippGetString(requested, 0, NULL), "all"))
     return (NULL);
 
-  // Create an array using "strcmp" as the comparison function...
-  ra = cupsArrayNew((cups_array_cb_t)strcmp, NULL, NULL, 0, NULL, NULL);
+  // See if we have a cached array for these values...
+  for (i = 0, hash = (size_t)op, len = 0; i < count; i ++)
+  {
+    if ((value = ippGetString(requested, i, NULL)) == NULL)
+      return (NULL);
+
+    for (ptr = value; *ptr; ptr ++)
+      hash = hash * 33 + (unsigned char)*ptr;
+
+    hash = hash * 33 + '/';
+    len  += (size_t)(ptr - value) + 1;
+  }
+
+  cupsMutexLock(&ipp_ra_mutex);
+
+  if (!ipp_ra_index)
+  {
+    // Build a sorted index of the registered names so that arrays can use the
+    // static strings instead of the request values...
+    size_t	num_names;		// Number of registered names
+
+    for (i = 0, num_names = 0; i < (sizeof(lists) / sizeof(lists[0])); i ++)
+      num_names += lists[i].num_names;
+
+    if ((ipp_ra_index = _cupsMemAlloc(CUPS_MEMTYPE_IPP, num_names * sizeof(_ipp_name_t))) != NULL)
+    {
+      for (i = 0; i < (sizeof(lists) / sizeof(lists[0])); i ++)
+        ipp_num_ra_index = ipp_add_names(ipp_ra_index, ipp_num_ra_index, lists[i].names, lists[i].num_names, 0);
+
+      qsort(ipp_ra_index, ipp_num_ra_index, sizeof(_ipp_name_t), (int (*)(const void *, const void *))ipp_compare_names);
+    }
+  }
+
+  entry = ipp_ra_cache + hash % _IPP_RA_CACHE;
+
+  if (entry->ra && entry->hash == hash && entry->op == op && entry->num_values == count)
+  {
+    for (i = 0; i < count; i ++)
+    {
+      if (strcmp(entry->values[i], ippGetString(requested, i, NULL)))
+	break;
+    }
+
+    if (i >= count)
+    {
+      ra = cupsArrayDup(entry->ra);
+      cupsMutexUnlock(&ipp_ra_mutex);
+
+      return (ra);
+    }
+  }
+
+  cupsMutexUnlock(&ipp_ra_mutex);
+
+  // Only arrays of registered names are cached...
+  for (i = 0; i < count && registered; i ++)
+  {
+    if (!ipp_find_name(ipp_ra_index, ipp_num_ra_index, ippGetString(requested, i, NULL), false))
+      registered = false;
+  }
+
+  // Create an array using "strcmp" as the comparison function.  Arrays with
+  // unregistered names keep their own copies of the strings so that they do
+  // not depend on the request...
+  if (registered)
+    ra = cupsArrayNew((cups_array_cb_t)strcmp, NULL, NULL, 0, NULL, NULL);
+  else
+    ra = cupsArrayNew((cups_array_cb_t)strcmp, NULL, NULL, 0, (cups_acopy_cb_t)_cupsStrAlloc, (cups_afree_cb_t)_cupsStrFree);
+
+  if (!ra)
+    return (NULL);
 
   for (i = 0; i < count; i ++)
   {
@@ -2033,102 +2077,128 @@ ippCreateRequestedArray(ipp_t *request)	// I - IPP request
 
     if (!strcmp(value, "document-description") || (!strcmp(value, "all") && (op == IPP_OP_GET_JOB_ATTRIBUTES || op == IPP_OP_GET_JOBS || op == IPP_OP_GET_DOCUMENT_ATTRIBUTES || op == IPP_OP_GET_DOCUMENTS)))
     {
-      for (j = 0; j < (sizeof(document_description) / sizeof(document_description[0])); j ++)
-        cupsArrayAdd(ra, (void *)document_description[j]);
+      cupsArrayAddBatch(ra, (void **)document_description, sizeof(document_description) / sizeof(document_description[0]));
 
       added = true;
     }
 
     if (!strcmp(value, "document-template") || !strcmp(value, "all"))
     {
-      for (j = 0; j < (sizeof(document_template) / sizeof(document_template[0])); j ++)
-        cupsArrayAdd(ra, (void *)document_template[j]);
+      cupsArrayAddBatch(ra, (void **)document_template, sizeof(document_template) / sizeof(document_template[0]));
 
       added = true;
     }
 
     if (!strcmp(value, "job-description") || (!strcmp(value, "all") && (op == IPP_OP_GET_JOB_ATTRIBUTES || op == IPP_OP_GET_JOBS)))
     {
-      for (j = 0; j < (sizeof(job_description) / sizeof(job_description[0])); j ++)
-        cupsArrayAdd(ra, (void *)job_description[j]);
+      cupsArrayAddBatch(ra, (void **)job_description, sizeof(job_description) / sizeof(job_description[0]));
 
       added = true;
     }
 
     if (!strcmp(value, "job-template") || (!strcmp(value, "all") && (op == IPP_OP_GET_JOB_ATTRIBUTES || op == IPP_OP_GET_JOBS || op == IPP_OP_GET_PRINTER_ATTRIBUTES || op == IPP_OP_GET_OUTPUT_DEVICE_ATTRIBUTES)))
     {
-      for (j = 0; j < (sizeof(job_template) / sizeof(job_template[0])); j ++)
-        cupsArrayAdd(ra, (void *)job_template[j]);
+      cupsArrayAddBatch(ra, (void **)job_template, sizeof(job_template) / sizeof(job_template[0]));
 
       added = true;
     }
 
     if (!strcmp(value, "printer-description") || (!strcmp(value, "all") && (op == IPP_OP_GET_PRINTER_ATTRIBUTES || op == IPP_OP_GET_OUTPUT_DEVICE_ATTRIBUTES || op == IPP_OP_GET_PRINTERS || op == IPP_OP_CUPS_GET_DEFAULT || op == IPP_OP_CUPS_GET_PRINTERS || op == IPP_OP_CUPS_GET_CLASSES)))
     {
-      for (j = 0; j < (sizeof(printer_description) / sizeof(printer_description[0])); j ++)
-        cupsArrayAdd(ra, (void *)printer_description[j]);
+      cupsArrayAddBatch(ra, (void **)printer_description, sizeof(printer_description) / sizeof(printer_description[0]));
 
       added = true;
     }
 
     if (!strcmp(value, "resource-description") || (!strcmp(value, "all") && (op == IPP_OP_GET_RESOURCE_ATTRIBUTES || op == IPP_OP_GET_RESOURCES)))
     {
-      for (j = 0; j < (sizeof(resource_description) / sizeof(resource_description[0])); j ++)
-        cupsArrayAdd(ra, (void *)resource_description[j]);
+      cupsArrayAddBatch(ra, (void **)resource_description, sizeof(resource_description) / sizeof(resource_description[0]));
 
       added = true;
     }
 
     if (!strcmp(value, "resource-status") || (!strcmp(value, "all") && (op == IPP_OP_GET_RESOURCE_ATTRIBUTES || op == IPP_OP_GET_RESOURCES)))
     {
-      for (j = 0; j < (sizeof(resource_status) / sizeof(resource_status[0])); j ++)
-        cupsArrayAdd(ra, (void *)resource_status[j]);
+      cupsArrayAddBatch(ra, (void **)resource_status, sizeof(resource_status) / sizeof(resource_status[0]));
 
       added = true;
     }
 
     if (!strcmp(value, "resource-template") || (!strcmp(value, "all") && (op == IPP_OP_GET_RESOURCE_ATTRIBUTES || op == IPP_OP_GET_RESOURCES || op == IPP_OP_GET_SYSTEM_ATTRIBUTES)))
     {
-      for (j = 0; j < (sizeof(resource_template) / sizeof(resource_template[0])); j ++)
-        cupsArrayAdd(ra, (void *)resource_template[j]);
+      cupsArrayAddBatch(ra, (void **)resource_template, sizeof(resource_template) / sizeof(resource_template[0]));
 
       added = true;
     }
 
     if (!strcmp(value, "subscription-description") || (!strcmp(value, "all") && (op == IPP_OP_GET_SUBSCRIPTION_ATTRIBUTES || op == IPP_OP_GET_SUBSCRIPTIONS)))
     {
-      for (j = 0; j < (sizeof(subscription_description) / sizeof(subscription_description[0])); j ++)
-        cupsArrayAdd(ra, (void *)subscription_description[j]);
+      cupsArrayAddBatch(ra, (void **)subscription_description, sizeof(subscription_description) / sizeof(subscription_description[0]));
 
       added = true;
     }
 
     if (!strcmp(value, "subscription-template") || (!strcmp(value, "all") && (op == IPP_OP_GET_SUBSCRIPTION_ATTRIBUTES || op == IPP_OP_GET_SUBSCRIPTIONS)))
     {
-      for (j = 0; j < (sizeof(subscription_template) / sizeof(subscription_template[0])); j ++)
-        cupsArrayAdd(ra, (void *)subscription_template[j]);
+      cupsArrayAddBatch(ra, (void **)subscription_template, sizeof(subscription_template) / sizeof(subscription_template[0]));
 
       added = true;
     }
 
     if (!strcmp(value, "system-description") || (!strcmp(value, "all") && op == IPP_OP_GET_SYSTEM_ATTRIBUTES))
     {
-      for (j = 0; j < (sizeof(system_description) / sizeof(system_description[0])); j ++)
-        cupsArrayAdd(ra, (void *)system_description[j]);
+      cupsArrayAddBatch(ra, (void **)system_description, sizeof(system_description) / sizeof(system_description[0]));
 
       added = true;
     }
 
     if (!strcmp(value, "system-status") || (!strcmp(value, "all") && op == IPP_OP_GET_SYSTEM_ATTRIBUTES))
     {
-      for (j = 0; j < (sizeof(system_status) / sizeof(system_status[0])); j ++)
-        cupsArrayAdd(ra, (void *)system_status[j]);
+      cupsArrayAddBatch(ra, (void **)system_status, sizeof(system_status) / sizeof(system_status[0]));
 
       added = true;
     }
 
     if (!added)
-      cupsArrayAdd(ra, (void *)value);
+    {
+      if (registered && (n = ipp_find_name(ipp_ra_index, ipp_num_ra_index, value, false)) != NULL)
+        cupsArrayAdd(ra, (void *)n->name);
+      else
+        cupsArrayAdd(ra, (void *)value);
+    }
+  }
+
+  if (registered && count <= _IPP_RA_MAX_VALUES && (values = _cupsMemAlloc(CUPS_MEMTYPE_IPP, count * sizeof(char *) + len)) != NULL)
+  {
+    // Copy the values so the cache entry doesn't depend on the request...
+    for (i = 0, s = (char *)(values + count); i < count; i ++)
+    {
+      value     = ippGetString(requested, i, NULL);
+      len       = strlen(value) + 1;
+      values[i] = s;
+
+      memcpy(s, value, len);
+      s += len;
+    }
+
+    // Replace any array in the cache entry and return a copy.  The array only
+    // references static strings, so copies of a replaced array stay valid...
+    cupsMutexLock(&ipp_ra_mutex);
+
+    entry = ipp_ra_cache + hash % _IPP_RA_CACHE;
+
+    _cupsMemFree(entry->values);
+    cupsArrayDelete(entry->ra);
+
+    entry->op         = op;
+    entry->hash       = hash;
+    entry->num_values = count;
+    entry->values     = values;
+    entry->ra         = ra;
+
+    ra = cupsArrayDup(ra);
+
+    cupsMutexUnlock(&ipp_ra_mutex);
   }
 
   return (ra);
@@ -2143,35 +2213,21 @@ const char *				// O - Enum string
 ippEnumString(const char *attrname,	// I - Attribute name
               int        enumvalue)	// I - Enum value
 {
-  _cups_globals_t *cg = _cupsGlobals();	// Pointer to library globals
+  _cups_globals_t	*cg = _cupsGlobals();
+					// Pointer to library globals
+  const _ipp_enum_t	*e;		// Enum attribute
 
 
   // Check for standard enum values...
-  if (!strcmp(attrname, "document-state") && enumvalue >= 3 && enumvalue < (3 + (int)(sizeof(ipp_document_states) / sizeof(ipp_document_states[0]))))
-    return (ipp_document_states[enumvalue - 3]);
-  else if (!strcmp(attrname, "finishings") || !strcmp(attrname, "finishings-actual") || !strcmp(attrname, "finishings-default") || !strcmp(attrname, "finishings-ready") || !strcmp(attrname, "finishings-supported") || !strcmp(attrname, "job-finishings") || !strcmp(attrname, "job-finishings-default") || !strcmp(attrname, "job-finishings-supported"))
+  if ((e = ipp_find_enum(attrname)) != NULL)
   {
-    if (enumvalue >= 3 && enumvalue < (3 + (int)(sizeof(ipp_finishings) / sizeof(ipp_finishings[0]))))
-      return (ipp_finishings[enumvalue - 3]);
-    else if (enumvalue >= 0x40000000 && enumvalue < (0x40000000 + (int)(sizeof(ipp_finishings_vendor) / sizeof(ipp_finishings_vendor[0]))))
+    if (!e->strings)
+      return (ippOpString((ipp_op_t)enumvalue));
+    else if (enumvalue >= e->first && enumvalue < (e->first + (int)e->num_strings))
+      return (e->strings[enumvalue - e->first]);
+    else if (e->strings == ipp_finishings && enumvalue >= 0x40000000 && enumvalue < (0x40000000 + (int)(sizeof(ipp_finishings_vendor) / sizeof(ipp_finishings_vendor[0]))))
       return (ipp_finishings_vendor[enumvalue - 0x40000000]);
   }
-  else if ((!strcmp(attrname, "job-collation-type") || !strcmp(attrname, "job-collation-type-actual")) && enumvalue >= 3 && enumvalue < (3 + (int)(sizeof(ipp_job_collation_types) / sizeof(ipp_job_collation_types[0]))))
-    return (ipp_job_collation_types[enumvalue - 3]);
-  else if (!strcmp(attrname, "job-state") && enumvalue >= IPP_JSTATE_PENDING && enumvalue <= IPP_JSTATE_COMPLETED)
-    return (ipp_job_states[enumvalue - IPP_JSTATE_PENDING]);
-  else if (!strcmp(attrname, "operations-supported"))
-    return (ippOpString((ipp_op_t)enumvalue));
-  else if ((!strcmp(attrname, "orientation-requested") || !strcmp(attrname, "orientation-requested-actual") || !strcmp(attrname, "orientation-requested-default") || !strcmp(attrname, "orientation-requested-supported")) && enumvalue >= 3 && enumvalue < (3 + (int)(sizeof(ipp_orientation_requesteds) / sizeof(ipp_orientation_requesteds[0]))))
-    return (ipp_orientation_requesteds[enumvalue - 3]);
-  else if ((!strcmp(attrname, "print-quality") || !strcmp(attrname, "print-quality-actual") || !strcmp(attrname, "print-quality-default") || !strcmp(attrname, "print-quality-supported")) && enumvalue >= 3 && enumvalue < (3 + (int)(sizeof(ipp_print_qualities) / sizeof(ipp_print_qualities[0]))))
-    return (ipp_print_qualities[enumvalue - 3]);
-  else if (!strcmp(attrname, "printer-state") && enumvalue >= IPP_PSTATE_IDLE && enumvalue <= IPP_PSTATE_STOPPED)
-    return (ipp_printer_states[enumvalue - IPP_PSTATE_IDLE]);
-  else if (!strcmp(attrname, "resource-state") && enumvalue >= IPP_RSTATE_PENDING && enumvalue <= IPP_RSTATE_ABORTED)
-    return (ipp_resource_states[enumvalue - IPP_RSTATE_PENDING]);
-  else if (!strcmp(attrname, "system-state") && enumvalue >= IPP_SSTATE_IDLE && enumvalue <= IPP_SSTATE_STOPPED)
-    return (ipp_system_states[enumvalue - IPP_SSTATE_IDLE]);
 
   // Not a standard enum value, just return the decimal equivalent...
   snprintf(cg->ipp_unknown, sizeof(cg->ipp_unknown), "%d", enumvalue);
@@ -2187,9 +2243,9 @@ int					// O - Enum value or `-1` if unknown
 ippEnumValue(const char *attrname,	// I - Attribute name
              const char *enumstring)	// I - Enum string
 {
-  size_t	i,			// Looping var
-		num_strings;		// Number of strings to compare
-  const char * const *strings;		// Strings to compare
+  size_t		i;		// Looping var
+  const _ipp_enum_t	*e;		// Enum attribute
+  const _ipp_name_t	*n;		// Finishings name
 
 
   // If the string is just a number, return it...
@@ -2197,81 +2253,26 @@ ippEnumValue(const char *attrname,	// I - Attribute name
     return ((int)strtol(enumstring, NULL, 0));
 
   // Otherwise look up the string...
-  if (!strcmp(attrname, "document-state"))
-  {
-    num_strings = sizeof(ipp_document_states) / sizeof(ipp_document_states[0]);
-    strings     = ipp_document_states;
-  }
-  else if (!strcmp(attrname, "finishings") ||
-	   !strcmp(attrname, "finishings-actual") ||
-	   !strcmp(attrname, "finishings-default") ||
-	   !strcmp(attrname, "finishings-ready") ||
-	   !strcmp(attrname, "finishings-supported"))
-  {
-    for (i = 0; i < (sizeof(ipp_finishings_vendor) / sizeof(ipp_finishings_vendor[0])); i ++)
-    {
-      if (!strcmp(enumstring, ipp_finishings_vendor[i]))
-	return (i + 0x40000000);
-    }
-
-    num_strings = sizeof(ipp_finishings) / sizeof(ipp_finishings[0]);
-    strings     = ipp_finishings;
-  }
-  else if (!strcmp(attrname, "job-collation-type") ||
-           !strcmp(attrname, "job-collation-type-actual"))
-  {
-    num_strings = sizeof(ipp_job_collation_types) / sizeof(ipp_job_collation_types[0]);
-    strings     = ipp_job_collation_types;
-  }
-  else if (!strcmp(attrname, "job-state"))
-  {
-    num_strings = sizeof(ipp_job_states) / sizeof(ipp_job_states[0]);
-    strings     = ipp_job_states;
-  }
-  else if (!strcmp(attrname, "operations-supported"))
-  {
+  if ((e = ipp_find_enum(attrname)) == NULL)
+    return (-1);
+  else if (!e->strings)
     return (ippOpValue(enumstring));
-  }
-  else if (!strcmp(attrname, "orientation-requested") ||
-           !strcmp(attrname, "orientation-requested-actual") ||
-           !strcmp(attrname, "orientation-requested-default") ||
-           !strcmp(attrname, "orientation-requested-supported"))
-  {
-    num_strings = sizeof(ipp_orientation_requesteds) / sizeof(ipp_orientation_requesteds[0]);
-    strings     = ipp_orientation_requesteds;
-  }
-  else if (!strcmp(attrname, "print-quality") ||
-           !strcmp(attrname, "print-quality-actual") ||
-           !strcmp(attrname, "print-quality-default") ||
-           !strcmp(attrname, "print-quality-supported"))
-  {
-    num_strings = sizeof(ipp_print_qualities) / sizeof(ipp_print_qualities[0]);
-    strings     = ipp_print_qualities;
-  }
-  else if (!strcmp(attrname, "printer-state"))
-  {
-    num_strings = sizeof(ipp_printer_states) / sizeof(ipp_printer_states[0]);
-    strings     = ipp_printer_states;
-  }
-  else if (!strcmp(attrname, "resource-state"))
-  {
-    num_strings = sizeof(ipp_resource_states) / sizeof(ipp_resource_states[0]);
-    strings     = ipp_resource_states;
-  }
-  else if (!strcmp(attrname, "system-state"))
-  {
-    num_strings = sizeof(ipp_system_states) / sizeof(ipp_system_states[0]);
-    strings     = ipp_system_states;
-  }
-  else
+
+  if (e->strings == ipp_finishings)
   {
-    return (-1);
+    // Finishings has a lot of values, use the sorted index...
+    ipp_init_names();
+
+    if ((n = ipp_find_name(ipp_finishings_index, sizeof(ipp_finishings_index) / sizeof(ipp_finishings_index[0]), enumstring, false)) != NULL)
+      return (n->value);
+    else
+      return (-1);
   }
 
-  for (i = 0; i < num_strings; i ++)
+  for (i = 0; i < e->num_strings; i ++)
   {
-    if (!strcmp(enumstring, strings[i]))
-      return (i + 3);
+    if (!strcmp(enumstring, e->strings[i]))
+      return ((int)i + e->first);
   }
 
   return (-1);
@@ -2316,14 +2317,13 @@ ippErrorString(ipp_status_t error)	// I - Error status
 ipp_status_t				// O - IPP status code
 ippErrorValue(const char *name)		// I - Name
 {
-  size_t	i;			// Looping var
+  const _ipp_name_t	*n;		// Status code name
 
 
-  for (i = 0; i < (sizeof(ipp_status_oks) / sizeof(ipp_status_oks[0])); i ++)
-  {
-    if (!_cups_strcasecmp(name, ipp_status_oks[i]))
-      return ((ipp_status_t)i);
-  }
+  ipp_init_names();
+
+  if ((n = ipp_find_name(ipp_status_index, sizeof(ipp_status_index) / sizeof(ipp_status_index[0]), name, true)) != NULL)
+    return ((ipp_status_t)n->value);
 
   if (!_cups_strcasecmp(name, "redirection-other-site"))
     return (IPP_STATUS_REDIRECTION_OTHER_SITE);
@@ -2331,24 +2331,6 @@ ippErrorValue(const char *name)		// I - Name
   if (!_cups_strcasecmp(name, "cups-see-other"))
     return (IPP_STATUS_CUPS_SEE_OTHER);
 
-  for (i = 0; i < (sizeof(ipp_status_400s) / sizeof(ipp_status_400s[0])); i ++)
-  {
-    if (!_cups_strcasecmp(name, ipp_status_400s[i]))
-      return ((ipp_status_t)(i + 0x400));
-  }
-
-  for (i = 0; i < (sizeof(ipp_status_500s) / sizeof(ipp_status_500s[0])); i ++)
-  {
-    if (!_cups_strcasecmp(name, ipp_status_500s[i]))
-      return ((ipp_status_t)(i + 0x500));
-  }
-
-  for (i = 0; i < (sizeof(ipp_status_1000s) / sizeof(ipp_status_1000s[0])); i ++)
-  {
-    if (!_cups_strcasecmp(name, ipp_status_1000s[i]))
-      return ((ipp_status_t)(i + 0x1000));
-  }
-
   return ((ipp_status_t)-1);
 }
 
@@ -2408,33 +2390,20 @@ ippOpString(ipp_op_t op)		// I - Operation ID
 ipp_op_t				// O - Operation ID
 ippOpValue(const char *name)		// I - Textual name
 {
-  size_t	i;			// Looping var
+  const _ipp_name_t	*n;		// Operation name
 
 
   if (!strncmp(name, "0x", 2))
     return ((ipp_op_t)strtol(name + 2, NULL, 16));
 
-  for (i = 0; i < (sizeof(ipp_std_ops) / sizeof(ipp_std_ops[0])); i ++)
-  {
-    if (!_cups_strcasecmp(name, ipp_std_ops[i]))
-      return ((ipp_op_t)i);
-  }
+  ipp_init_names();
+
+  if ((n = ipp_find_name(ipp_ops_index, sizeof(ipp_ops_index) / sizeof(ipp_ops_index[0]), name, true)) != NULL)
+    return ((ipp_op_t)n->value);
 
   if (!_cups_strcasecmp(name, "windows-ext"))
     return (IPP_OP_PRIVATE);
 
-  for (i = 0; i < (sizeof(ipp_cups_ops) / sizeof(ipp_cups_ops[0])); i ++)
-  {
-    if (!_cups_strcasecmp(name, ipp_cups_ops[i]))
-      return ((ipp_op_t)(i + 0x4001));
-  }
-
-  for (i = 0; i < (sizeof(ipp_cups_ops2) / sizeof(ipp_cups_ops2[0])); i ++)
-  {
-    if (!_cups_strcasecmp(name, ipp_cups_ops2[i]))
-      return ((ipp_op_t)(i + 0x4027));
-  }
-
   if (!_cups_strcasecmp(name, "Create-Job-Subscription"))
     return (IPP_OP_CREATE_JOB_SUBSCRIPTIONS);
 
@@ -2505,14 +2474,13 @@ ippTagString(ipp_tag_t tag)		// I - Tag value
 ipp_tag_t				// O - Tag value
 ippTagValue(const char *name)		// I - Tag name
 {
-  size_t	i;			// Looping var
+  const _ipp_name_t	*n;		// Tag name
 
 
-  for (i = 0; i < (sizeof(ipp_tag_names) / sizeof(ipp_tag_names[0])); i ++)
-  {
-    if (!_cups_strcasecmp(name, ipp_tag_names[i]))
-      return ((ipp_tag_t)i);
-  }
+  ipp_init_names();
+
+  if ((n = ipp_find_name(ipp_tags_index, sizeof(ipp_tags_index) / sizeof(ipp_tags_index[0]), name, true)) != NULL)
+    return ((ipp_tag_t)n->value);
 
   if (!_cups_strcasecmp(name, "operation"))
     return (IPP_TAG_OPERATION);
@@ -2542,63 +2510,437 @@ ippTagValue(const char *name)		// I - Tag name
 
 
 //
-// 'ipp_col_string()' - Convert a collection to a string.
+// 'ipp_add_names()' - Add names to a sorted name index.
 //
 
-static size_t				// O - Number of bytes
-ipp_col_string(ipp_t  *col,		// I - Collection attribute
-               char   *buffer,		// I - Buffer or NULL
-               size_t bufsize)		// I - Size of buffer
+static size_t				// O - New number of index entries
+ipp_add_names(
+    _ipp_name_t        *index,		// I - Name index
+    size_t             num_index,	// I - Current number of index entries
+    const char * const *names,		// I - Names
+    size_t             num_names,	// I - Number of names
+    int                first)		// I - Value of first name
 {
-  char			*bufptr,	// Position in buffer
-			*bufend,	// End of buffer
-			prefix = '{',	// Prefix character
-			temp[256];	// Temporary string
-  ipp_attribute_t	*attr;		// Current member attribute
+  size_t	i;			// Looping var
 
 
-  if (!col)
+  for (i = 0; i < num_names; i ++, num_index ++)
   {
-    if (buffer)
-      *buffer = '\0';
+    index[num_index].name  = names[i];
+    index[num_index].value = first + (int)i;
+  }
 
-    return (0);
+  return (num_index);
+}
+
+
+//
+// 'ipp_attr_string()' - Convert an attribute's values to a string.
+//
+
+static void
+ipp_attr_string(ipp_attribute_t *attr,	// I - Attribute
+                _ipp_sbuf_t     *sbuf)	// I - String buffer
+{
+  size_t	i;			// Looping var
+  const char	*ptr,			// Pointer into string
+		*start,			// Start of run of characters
+		*end;			// Pointer to end of string
+  _ipp_value_t	*val;			// Current value
+
+
+  for (i = attr->num_values, val = attr->values; i > 0; i --, val ++)
+  {
+    if (val > attr->values)
+      ipp_sbuf_putc(sbuf, ',');
+
+    switch (attr->value_tag & ~IPP_TAG_CUPS_CONST)
+    {
+      case IPP_TAG_ENUM :
+          ptr = ippEnumString(attr->name, val->integer);
+          ipp_sbuf_puts(sbuf, ptr, strlen(ptr));
+          break;
+
+      case IPP_TAG_INTEGER :
+          ipp_sbuf_putint(sbuf, val->integer, 1);
+          break;
+
+      case IPP_TAG_BOOLEAN :
+          if (val->boolean)
+            ipp_sbuf_puts(sbuf, "true", 4);
+          else
+            ipp_sbuf_puts(sbuf, "false", 5);
+          break;
+
+      case IPP_TAG_RANGE :
+          ipp_sbuf_putint(sbuf, val->range.lower, 1);
+          ipp_sbuf_putc(sbuf, '-');
+          ipp_sbuf_putint(sbuf, val->range.upper, 1);
+          break;
+
+      case IPP_TAG_RESOLUTION :
+          ipp_sbuf_putint(sbuf, val->resolution.xres, 1);
+
+	  if (val->resolution.xres != val->resolution.yres)
+	  {
+	    ipp_sbuf_putc(sbuf, 'x');
+	    ipp_sbuf_putint(sbuf, val->resolution.yres, 1);
+	  }
+
+          if (val->resolution.units == IPP_RES_PER_INCH)
+            ipp_sbuf_puts(sbuf, "dpi", 3);
+          else
+            ipp_sbuf_puts(sbuf, "dpcm", 4);
+          break;
+
+      case IPP_TAG_DATE :
+          // YYYY-MM-DDTHH:MM:SSZ or YYYY-MM-DDTHH:MM:SS+HHMM
+          ipp_sbuf_putint(sbuf, (val->date[0] << 8) + val->date[1], 4);
+          ipp_sbuf_putc(sbuf, '-');
+          ipp_sbuf_putint(sbuf, val->date[2], 2);
+          ipp_sbuf_putc(sbuf, '-');
+          ipp_sbuf_putint(sbuf, val->date[3], 2);
+          ipp_sbuf_putc(sbuf, 'T');
+          ipp_sbuf_putint(sbuf, val->date[4], 2);
+          ipp_sbuf_putc(sbuf, ':');
+          ipp_sbuf_putint(sbuf, val->date[5], 2);
+          ipp_sbuf_putc(sbuf, ':');
+          ipp_sbuf_putint(sbuf, val->date[6], 2);
+
+	  if (val->date[9] == 0 && val->date[10] == 0)
+	  {
+	    ipp_sbuf_putc(sbuf, 'Z');
+	  }
+	  else
+	  {
+	    ipp_sbuf_putc(sbuf, (char)val->date[8]);
+	    ipp_sbuf_putint(sbuf, val->date[9], 2);
+	    ipp_sbuf_putint(sbuf, val->date[10], 2);
+	  }
+          break;
+
+      case IPP_TAG_TEXT :
+      case IPP_TAG_NAME :
+      case IPP_TAG_KEYWORD :
+      case IPP_TAG_CHARSET :
+      case IPP_TAG_URI :
+      case IPP_TAG_URISCHEME :
+      case IPP_TAG_MIMETYPE :
+      case IPP_TAG_LANGUAGE :
+      case IPP_TAG_TEXTLANG :
+      case IPP_TAG_NAMELANG :
+	  if (!val->string.text)
+	    break;
+
+          // Copy runs of characters that don't need quoting...
+          for (ptr = val->string.text; *ptr;)
+          {
+            start = ptr;
+            ptr   += strcspn(ptr, "\\\"[");
+
+            ipp_sbuf_puts(sbuf, start, (size_t)(ptr - start));
+
+            if (*ptr)
+            {
+              ipp_sbuf_putc(sbuf, '\\');
+              ipp_sbuf_putc(sbuf, *ptr++);
+            }
+          }
+
+          if (val->string.language)
+          {
+            // Add "[language]" to end of string...
+            ipp_sbuf_putc(sbuf, '[');
+            ipp_sbuf_puts(sbuf, val->string.language, strlen(val->string.language));
+            ipp_sbuf_putc(sbuf, ']');
+          }
+          break;
+
+      case IPP_TAG_BEGIN_COLLECTION :
+          ipp_col_string(val->collection, sbuf);
+          break;
+
+      case IPP_TAG_STRING :
+          for (ptr = start = val->unknown.data, end = ptr + val->unknown.length; ptr < end; ptr ++)
+          {
+            if (*ptr == '\\' || _cups_isspace(*ptr) || !isprint(*ptr & 255))
+            {
+              ipp_sbuf_puts(sbuf, start, (size_t)(ptr - start));
+              ipp_sbuf_putc(sbuf, '\\');
+
+              if (*ptr == '\\' || _cups_isspace(*ptr))
+              {
+                ipp_sbuf_putc(sbuf, *ptr);
+              }
+              else
+              {
+                ipp_sbuf_putc(sbuf, (char)('0' + ((*ptr >> 6) & 3)));
+                ipp_sbuf_putc(sbuf, (char)('0' + ((*ptr >> 3) & 7)));
+                ipp_sbuf_putc(sbuf, (char)('0' + (*ptr & 7)));
+              }
+
+              start = ptr + 1;
+            }
+          }
+
+          ipp_sbuf_puts(sbuf, start, (size_t)(ptr - start));
+          break;
+
+      default :
+          ptr = ippTagString(attr->value_tag);
+          ipp_sbuf_puts(sbuf, ptr, strlen(ptr));
+          break;
+    }
   }
+}
 
-  bufptr = buffer;
-  bufend = buffer + bufsize - 1;
+
+//
+// 'ipp_col_string()' - Convert a collection to a string.
+//
+
+static void
+ipp_col_string(ipp_t       *col,	// I - Collection attribute
+               _ipp_sbuf_t *sbuf)	// I - String buffer
+{
+  char			prefix = '{';	// Prefix character
+  ipp_attribute_t	*attr;		// Current member attribute
+
+
+  if (!col)
+    return;
 
   for (attr = col->attrs; attr; attr = attr->next)
   {
     if (!attr->name)
       continue;
 
-    if (buffer && bufptr < bufend)
-      *bufptr = prefix;
-    bufptr ++;
+    ipp_sbuf_putc(sbuf, prefix);
     prefix = ' ';
 
-    if (buffer && bufptr < bufend)
-      bufptr += snprintf(bufptr, (size_t)(bufend - bufptr + 1), "%s=", attr->name);
+    ipp_sbuf_puts(sbuf, attr->name, strlen(attr->name));
+    ipp_sbuf_putc(sbuf, '=');
+    ipp_attr_string(attr, sbuf);
+  }
+
+  if (prefix == '{')
+    ipp_sbuf_putc(sbuf, prefix);
+
+  ipp_sbuf_putc(sbuf, '}');
+}
+
+
+//
+// 'ipp_compare_names()' - Compare two names.
+//
+
+static int				// O - Result of comparison
+ipp_compare_names(_ipp_name_t *a,	// I - First name
+                  _ipp_name_t *b)	// I - Second name
+{
+  return (strcmp(a->name, b->name));
+}
+
+
+//
+// 'ipp_compare_names_nocase()' - Compare two names, ignoring case.
+//
+
+static int				// O - Result of comparison
+ipp_compare_names_nocase(
+    _ipp_name_t *a,			// I - First name
+    _ipp_name_t *b)			// I - Second name
+{
+  return (_cups_strcasecmp(a->name, b->name));
+}
+
+
+//
+// 'ipp_find_enum()' - Find an enum attribute.
+//
+
+static const _ipp_enum_t *		// O - Enum attribute or `NULL` if not found
+ipp_find_enum(const char *attrname)	// I - Attribute name
+{
+  size_t	left,			// Left side of search
+		right,			// Right side of search
+		current;		// Current element
+  int		result;			// Result of comparison
+
+
+  for (left = 0, right = sizeof(ipp_enums) / sizeof(ipp_enums[0]); left < right;)
+  {
+    current = (left + right) / 2;
+
+    if ((result = strcmp(attrname, ipp_enums[current].attrname)) == 0)
+      return (ipp_enums + current);
+    else if (result < 0)
+      right = current;
+    else
+      left = current + 1;
+  }
+
+  return (NULL);
+}
+
+
+//
+// 'ipp_find_name()' - Find a name in a sorted name index.
+//
+
+static const _ipp_name_t *		// O - Index entry or `NULL` if not found
+ipp_find_name(
+    const _ipp_name_t *index,		// I - Name index
+    size_t            num_index,	// I - Number of index entries
+    const char        *name,		// I - Name to find
+    bool              nocase)		// I - Ignore case?
+{
+  size_t	left,			// Left side of search
+		right,			// Right side of search
+		current;		// Current element
+  int		result;			// Result of comparison
+
+
+  for (left = 0, right = num_index; left < right;)
+  {
+    current = (left + right) / 2;
+
+    if (nocase)
+      result = _cups_strcasecmp(name, index[current].name);
     else
-      bufptr += strlen(attr->name) + 1;
+      result = strcmp(name, index[current].name);
 
-    if (buffer && bufptr < bufend)
-      bufptr += ippAttributeString(attr, bufptr, (size_t)(bufend - bufptr + 1));
+    if (result == 0)
+      return (index + current);
+    else if (result < 0)
+      right = current;
     else
-      bufptr += ippAttributeString(attr, temp, sizeof(temp));
+      left = current + 1;
   }
 
-  if (prefix == '{')
+  return (NULL);
+}
+
+
+//
+// 'ipp_init_names()' - Make sure the sorted name indices are built.
+//
+
+static void
+ipp_init_names(void)
+{
+#ifdef _WIN32
+  cupsMutexLock(&ipp_index_mutex);
+  if (!ipp_index_ready)
   {
-    if (buffer && bufptr < bufend)
-      *bufptr = prefix;
-    bufptr ++;
+    ipp_init_names_once();
+    ipp_index_ready = true;
   }
+  cupsMutexUnlock(&ipp_index_mutex);
+
+#else
+  pthread_once(&ipp_index_once, ipp_init_names_once);
+#endif // _WIN32
+}
+
+
+//
+// 'ipp_init_names_once()' - Build the sorted name indices.
+//
+
+static void
+ipp_init_names_once(void)
+{
+  size_t	num_index;		// Number of index entries
+
+
+  num_index = ipp_add_names(ipp_finishings_index, 0, ipp_finishings, sizeof(ipp_finishings) / sizeof(ipp_finishings[0]), 3);
+  num_index = ipp_add_names(ipp_finishings_index, num_index, ipp_finishings_vendor, sizeof(ipp_finishings_vendor) / sizeof(ipp_finishings_vendor[0]), 0x40000000);
+  qsort(ipp_finishings_index, num_index, sizeof(_ipp_name_t), (int (*)(const void *, const void *))ipp_compare_names);
+
+  num_index = ipp_add_names(ipp_ops_index, 0, ipp_std_ops, sizeof(ipp_std_ops) / sizeof(ipp_std_ops[0]), 0);
+  num_index = ipp_add_names(ipp_ops_index, num_index, ipp_cups_ops, sizeof(ipp_cups_ops) / sizeof(ipp_cups_ops[0]), 0x4001);
+  num_index = ipp_add_names(ipp_ops_index, num_index, ipp_cups_ops2, sizeof(ipp_cups_ops2) / sizeof(ipp_cups_ops2[0]), 0x4027);
+  qsort(ipp_ops_index, num_index, sizeof(_ipp_name_t), (int (*)(const void *, const void *))ipp_compare_names_nocase);
+
+  num_index = ipp_add_names(ipp_status_index, 0, ipp_status_oks, sizeof(ipp_status_oks) / sizeof(ipp_status_oks[0]), 0);
+  num_index = ipp_add_names(ipp_status_index, num_index, ipp_status_400s, sizeof(ipp_status_400s) / sizeof(ipp_status_400s[0]), 0x400);
+  num_index = ipp_add_names(ipp_status_index, num_index, ipp_status_500s, sizeof(ipp_status_500s) / sizeof(ipp_status_500s[0]), 0x500);
+  num_index = ipp_add_names(ipp_status_index, num_index, ipp_status_1000s, sizeof(ipp_status_1000s) / sizeof(ipp_status_1000s[0]), 0x1000);
+  qsort(ipp_status_index, num_index, sizeof(_ipp_name_t), (int (*)(const void *, const void *))ipp_compare_names_nocase);
+
+  num_index = ipp_add_names(ipp_tags_index, 0, ipp_tag_names, sizeof(ipp_tag_names) / sizeof(ipp_tag_names[0]), 0);
+  qsort(ipp_tags_index, num_index, sizeof(_ipp_name_t), (int (*)(const void *, const void *))ipp_compare_names_nocase);
+}
+
+
+//
+// 'ipp_sbuf_putc()' - Add a character to a string buffer.
+//
+
+static void
+ipp_sbuf_putc(_ipp_sbuf_t *sbuf,	// I - String buffer
+              char        ch)		// I - Character
+{
+  if (sbuf->ptr < sbuf->end)
+    *(sbuf->ptr)++ = ch;
 
-  if (buffer && bufptr < bufend)
-    *bufptr = '}';
-  bufptr ++;
+  sbuf->len ++;
+}
+
+
+//
+// 'ipp_sbuf_putint()' - Add a decimal integer to a string buffer.
+//
+
+static void
+ipp_sbuf_putint(_ipp_sbuf_t *sbuf,	// I - String buffer
+                int         value,	// I - Integer value
+                size_t      digits)	// I - Minimum number of digits
+{
+  char		temp[16],		// Temporary string
+		*tempptr = temp + sizeof(temp);
+					// Pointer into temporary string
+  unsigned	uvalue;			// Unsigned value
+
+
+  // Convert the absolute value, least significant digit first...
+  uvalue = value < 0 ? 0U - (unsigned)value : (unsigned)value;
+
+  do
+  {
+    *--tempptr = (char)('0' + uvalue % 10);
+    uvalue     /= 10;
+  }
+  while (uvalue > 0 || (size_t)(temp + sizeof(temp) - tempptr) < digits);
+
+  if (value < 0)
+    *--tempptr = '-';
+
+  ipp_sbuf_puts(sbuf, tempptr, (size_t)(temp + sizeof(temp) - tempptr));
+}
+
+
+//
+// 'ipp_sbuf_puts()' - Add characters to a string buffer.
+//
+
+static void
+ipp_sbuf_puts(_ipp_sbuf_t *sbuf,	// I - String buffer
+              const char  *s,		// I - Characters
+              size_t      len)		// I - Number of characters
+{
+  size_t	count;			// Number of characters to copy
+
+
+  if (sbuf->ptr < sbuf->end)
+  {
+    if ((count = (size_t)(sbuf->end - sbuf->ptr)) > len)
+      count = len;
+
+    memcpy(sbuf->ptr, s, count);
+    sbuf->ptr += count;
+  }
 
-  return ((size_t)(bufptr - buffer));
+  sbuf->len += len;
 }
@@ -16,20 +16,82 @@
 #endif // _WIN32
 
 
+//
+// Local types...
+//
+
+typedef struct _ipp_buffer_s		// Memory buffer for ippReadBuffer
+{
+  const ipp_uchar_t	*ptr,		// Current position in buffer
+			*end;		// End of buffer
+} _ipp_buffer_t;
+
+typedef struct _ipp_wbuffer_s		// Batched write buffer
+{
+  void			*dst;		// Destination or `NULL` for memory only
+  ipp_io_cb_t		cb;		// Write callback function or `NULL`
+  ipp_uchar_t		*start,		// Start of buffer
+			*ptr,		// Current position in buffer
+			*end;		// End of buffer
+} _ipp_wbuffer_t;
+
+
+//
+// Local globals...
+//
+
+static cups_mutex_t	ipp_regex_mutex = CUPS_MUTEX_INITIALIZER;
+					// Mutex for compiled regular expressions
+static regex_t		ipp_lang_re,	// naturalLanguage regular expression
+			ipp_mime_re;	// mimeMediaType regular expression
+static int		ipp_lang_status = -1,
+					// regcomp() status for naturalLanguage
+			ipp_mime_status = -1;
+					// regcomp() status for mimeMediaType
+
+
 //
 // Local functions...
 //
 
 static ipp_attribute_t	*ipp_add_attr(ipp_t *ipp, const char *name, ipp_tag_t group_tag, ipp_tag_t value_tag, size_t num_values);
-static void		ipp_free_values(ipp_attribute_t *attr, size_t element, size_t count);
+static void		ipp_attr_relocate(ipp_attribute_t *attr, const char *olddata, uintptr_t oldaddr, size_t alloc_size);
+static char		*ipp_attr_strdup(ipp_t *ipp, ipp_attribute_t *attr, const char *s);
+static void		ipp_attr_strfree(ipp_t *ipp, ipp_attribute_t *attr, char *s);
+static void		*ipp_arena_alloc(_ipp_arena_t *arena, size_t size);
+static void		ipp_arena_release(_ipp_arena_t *arena);
+static void		ipp_arena_reset(_ipp_arena_t *arena, ipp_t *ipp);
+static void		*ipp_calloc(ipp_t *ipp, size_t size);
+static const char	*ipp_check_keyword(const char *s);
+static const char	*ipp_check_utf8(const char *s, bool text);
+static int		ipp_compare_attrs(ipp_attribute_t *a, ipp_attribute_t *b, void *data);
+static ipp_attribute_t	*ipp_find_first(ipp_t *ipp, const char *name);
+static ipp_attribute_t	*ipp_find_path(ipp_t *ipp, ipp_path_t *path, size_t level, ipp_tag_t type);
+static void		ipp_free(ipp_t *ipp, void *ptr);
+static void		ipp_free_attrs(ipp_t *ipp);
+static void		ipp_free_values(ipp_t *ipp, ipp_attribute_t *attr, size_t element, size_t count);
+static void		ipp_freeze(ipp_t *ipp);
 static char		*ipp_get_code(const char *locale, char *buffer, size_t bufsize) _CUPS_NONNULL(1,2);
+static size_t		ipp_hash_attr(ipp_attribute_t *attr, void *data);
+static void		ipp_index_add(ipp_t *ipp, ipp_attribute_t *attr);
+static void		ipp_index_clear(ipp_t *ipp);
+static ipp_t		*ipp_init_request(ipp_t *request, ipp_op_t op);
 static char		*ipp_lang_code(const char *locale, char *buffer, size_t bufsize) _CUPS_NONNULL(1,2);
 static size_t		ipp_length(ipp_t *ipp, int collection);
+static bool		ipp_length_cached(ipp_t *ipp, bool collection);
+static ipp_t		*ipp_new(_ipp_arena_t *arena);
+static ssize_t		ipp_read_buffer(_ipp_buffer_t *buf, ipp_uchar_t *buffer, size_t length);
 static ssize_t		ipp_read_http(http_t *http, ipp_uchar_t *buffer, size_t length);
 static ssize_t		ipp_read_file(int *fd, ipp_uchar_t *buffer, size_t length);
+static int		ipp_regcomp(regex_t *re, int *status, const char *pattern);
 static void		ipp_set_error(ipp_status_t status, const char *format, ...);
 static _ipp_value_t	*ipp_set_value(ipp_t *ipp, ipp_attribute_t **attr, size_t element);
+static char		*ipp_strdup(ipp_t *ipp, const char *s);
+static bool		ipp_stream_attr(ipp_t *ipp, ipp_attribute_t *attr);
+static void		ipp_strfree(ipp_t *ipp, char *s);
+static ssize_t		ipp_write_batch(_ipp_wbuffer_t *wbuf, ipp_uchar_t *buffer, size_t length);
 static ssize_t		ipp_write_file(int *fd, ipp_uchar_t *buffer, size_t length);
+static bool		ipp_write_flush(_ipp_wbuffer_t *wbuf);
 
 
 //
@@ -50,7 +112,7 @@ _cupsBufferGet(size_t size)		// I - Size required
 
   if (!buffer)
   {
-    if ((buffer = malloc(sizeof(_cups_buffer_t) + size - 1)) == NULL)
+    if ((buffer = _cupsMemAlloc(CUPS_MEMTYPE_OTHER, sizeof(_cups_buffer_t) + size - 1)) == NULL)
       return (NULL);
 
     buffer->next     = cg->cups_buffers;
@@ -198,7 +260,7 @@ ippAddCollection(ipp_t      *ipp,	// I - IPP message
   attr->values[0].collection = value;
 
   if (value)
-    value->use ++;
+    cupsAtomicInc(&value->use);
 
   return (attr);
 }
@@ -245,7 +307,7 @@ ippAddCollections(
     for (i = num_values, value = attr->values; i > 0; i --, value ++)
     {
       value->collection = (ipp_t *)*values++;
-      value->collection->use ++;
+      cupsAtomicInc(&value->collection->use);
     }
   }
 
@@ -289,7 +351,7 @@ ippAddCredentialsString(
     return (NULL);
 
   // Copy the value string and figure out the number of values...
-  if ((cvalue = strdup(credentials)) == NULL)
+  if ((cvalue = _cupsMemStrdup(CUPS_MEMTYPE_IPP, credentials)) == NULL)
     return (NULL);
 
   for (num_values = 0, cptr = cvalue; cptr;)
@@ -334,12 +396,12 @@ ippAddCredentialsString(
       }
 
       if (*cstart)
-        attr->values[i++].string.text = _cupsStrAlloc(cstart);
+        attr->values[i++].string.text = ipp_strdup(ipp, cstart);
     }
   }
 
   // Free the copied string and return...
-  free(cvalue);
+  _cupsMemFree(cvalue);
 
   return (attr);
 }
@@ -519,7 +581,7 @@ ippAddOctetString(ipp_t      *ipp,	// I - IPP message
 
   if (data)
   {
-    if ((attr->values[0].unknown.data = malloc((size_t)datalen)) == NULL)
+    if ((attr->values[0].unknown.data = ipp_calloc(ipp, (size_t)datalen)) == NULL)
     {
       ippDeleteAttribute(ipp, attr);
       return (NULL);
@@ -854,16 +916,16 @@ ippAddString(ipp_t      *ipp,		// I - IPP message
   else
   {
     if (language)
-      attr->values[0].string.language = _cupsStrAlloc(ipp_lang_code(language, code, sizeof(code)));
+      attr->values[0].string.language = ipp_attr_strdup(ipp, attr, ipp_lang_code(language, code, sizeof(code)));
 
     if (value)
     {
       if (value_tag == IPP_TAG_CHARSET)
-	attr->values[0].string.text = _cupsStrAlloc(ipp_get_code(value, code, sizeof(code)));
+	attr->values[0].string.text = ipp_attr_strdup(ipp, attr, ipp_get_code(value, code, sizeof(code)));
       else if (value_tag == IPP_TAG_LANGUAGE)
-	attr->values[0].string.text = _cupsStrAlloc(ipp_lang_code(value, code, sizeof(code)));
+	attr->values[0].string.text = ipp_attr_strdup(ipp, attr, ipp_lang_code(value, code, sizeof(code)));
       else
-	attr->values[0].string.text = _cupsStrAlloc(value);
+	attr->values[0].string.text = ipp_attr_strdup(ipp, attr, value);
     }
   }
 
@@ -1157,7 +1219,7 @@ ippAddStrings(
         if ((int)value_tag & IPP_TAG_CUPS_CONST)
           value->string.language = (char *)language;
         else
-          value->string.language = _cupsStrAlloc(ipp_lang_code(language, code, sizeof(code)));
+          value->string.language = ipp_attr_strdup(ipp, attr, ipp_lang_code(language, code, sizeof(code)));
       }
       else
       {
@@ -1170,11 +1232,11 @@ ippAddStrings(
       if ((int)value_tag & IPP_TAG_CUPS_CONST)
         value->string.text = (char *)*values++;
       else if (value_tag == IPP_TAG_CHARSET)
-	value->string.text = _cupsStrAlloc(ipp_get_code(*values++, code, sizeof(code)));
+	value->string.text = ipp_attr_strdup(ipp, attr, ipp_get_code(*values++, code, sizeof(code)));
       else if (value_tag == IPP_TAG_LANGUAGE)
-	value->string.text = _cupsStrAlloc(ipp_lang_code(*values++, code, sizeof(code)));
+	value->string.text = ipp_attr_strdup(ipp, attr, ipp_lang_code(*values++, code, sizeof(code)));
       else
-	value->string.text = _cupsStrAlloc(*values++);
+	value->string.text = ipp_attr_strdup(ipp, attr, *values++);
     }
   }
 
@@ -1182,6 +1244,71 @@ ippAddStrings(
 }
 
 
+//
+// 'ippCompilePath()' - Compile a hierarchical attribute name for lookups.
+//
+// This function splits an attribute name containing a hierarchical list of
+// attribute and member names separated by slashes, for example
+// "media-col/media-size/x-dimension", for use with @link ippFindPath@.
+// Compiled paths can be used with any number of messages and threads, and
+// have no limit on the number of names in the path.
+//
+// The returned path must be freed using @link ippDeletePath@.
+//
+
+ipp_path_t *				// O - Compiled path or `NULL` on error
+ippCompilePath(const char *name)	// I - Attribute name
+{
+  ipp_path_t	*path;			// Compiled path
+  size_t	i,			// Looping var
+		num_names,		// Number of names in path
+		len;			// Length of attribute name
+  const char	*ptr;			// Pointer into attribute name
+  char		*s;			// Pointer into path name
+
+
+  // Range check input...
+  if (!name || !*name)
+    return (NULL);
+
+  // Allocate memory for the path, names, and a copy of the attribute name...
+  for (num_names = 1, ptr = name; *ptr; ptr ++)
+  {
+    if (*ptr == '/')
+      num_names ++;
+  }
+
+  len = strlen(name) + 1;
+
+  if ((path = _cupsMemCalloc(CUPS_MEMTYPE_IPP, 1, sizeof(ipp_path_t) + (num_names - 1) * sizeof(char *) + len)) == NULL)
+    return (NULL);
+
+  s = (char *)(path->names + num_names);
+  memcpy(s, name, len);
+
+  // Split the names...
+  while (s)
+  {
+    path->names[path->num_names ++] = s;
+
+    if ((s = strchr(s, '/')) != NULL)
+      *s++ = '\0';
+  }
+
+  for (i = 0; i < path->num_names; i ++)
+  {
+    if (!path->names[i][0])
+    {
+      // Empty names are not allowed...
+      _cupsMemFree(path);
+      return (NULL);
+    }
+  }
+
+  return (path);
+}
+
+
 //
 // 'ippContainsInteger()' - Determine whether an attribute contains the
 //                          specified value or is within the list of ranges.
@@ -1314,6 +1441,9 @@ ippContainsString(
 // only be done as long as the original source IPP message will not be freed for
 // the life of the destination.
 //
+// Collection values from a message that has been frozen with @link ippFreeze@
+// cannot change and are always shared by reference rather than copied.
+//
 
 
 ipp_attribute_t *			// O - New attribute
@@ -1387,7 +1517,7 @@ ippCopyAttribute(
 	{
 	  // Otherwise do a normal reference counted copy...
 	  for (i = srcattr->num_values, srcval = srcattr->values, dstval = dstattr->values; i > 0; i --, srcval ++, dstval ++)
-	    dstval->string.text = _cupsStrAlloc(srcval->string.text);
+	    dstval->string.text = ipp_attr_strdup(dst, dstattr, srcval->string.text);
 	}
         break;
 
@@ -1407,11 +1537,11 @@ ippCopyAttribute(
 	  for (i = srcattr->num_values, srcval = srcattr->values, dstval = dstattr->values; i > 0; i --, srcval ++, dstval ++)
 	  {
 	    if (srcval == srcattr->values)
-              dstval->string.language = _cupsStrAlloc(srcval->string.language);
+              dstval->string.language = ipp_attr_strdup(dst, dstattr, srcval->string.language);
 	    else
               dstval->string.language = dstattr->values[0].string.language;
 
-	    dstval->string.text = _cupsStrAlloc(srcval->string.text);
+	    dstval->string.text = ipp_attr_strdup(dst, dstattr, srcval->string.text);
           }
         }
         break;
@@ -1434,9 +1564,18 @@ ippCopyAttribute(
 	{
 	  for (i = srcattr->num_values, srcval = srcattr->values, dstattr = NULL; i > 0; i --, srcval ++)
 	  {
-	    if (srcval->collection)
+	    if (srcval->collection && srcval->collection->frozen)
+	    {
+	      // Frozen collections cannot change, so share them...
+	      if (dstattr)
+		ippSetCollection(dst, &dstattr, ippGetCount(dstattr), srcval->collection);
+	      else
+		dstattr = ippAddCollection(dst, srcattr->group_tag, srcattr->name, srcval->collection);
+	    }
+	    else if (srcval->collection)
 	    {
-	      ipp_t *col = ippNew();	// Copy of collection
+	      ipp_t *col = ipp_new(dst->arena);
+					// Copy of collection
 
 	      ippCopyAttributes(col, srcval->collection, false, /*cb*/NULL, /*cb_data*/NULL);
 
@@ -1445,7 +1584,7 @@ ippCopyAttribute(
 	      else
 		dstattr = ippAddCollection(dst, srcattr->group_tag, srcattr->name, col);
 
-              col->use --;
+              cupsAtomicDec(&col->use);
 	    }
 	  }
 	}
@@ -1462,7 +1601,7 @@ ippCopyAttribute(
 
 	  if (dstval->unknown.length > 0)
 	  {
-	    if ((dstval->unknown.data = malloc((size_t)dstval->unknown.length)) == NULL)
+	    if ((dstval->unknown.data = ipp_calloc(dst, (size_t)dstval->unknown.length)) == NULL)
 	      dstval->unknown.length = 0;
 	    else
 	      memcpy(dstval->unknown.data, srcval->unknown.data, (size_t)dstval->unknown.length);
@@ -1471,6 +1610,13 @@ ippCopyAttribute(
         break; // anti-compiler-warning-code
   }
 
+  // Quick copies of frozen attributes can share the encoded form, too...
+  if (quickcopy && dstattr && srcattr->encoded)
+  {
+    dstattr->encoded     = srcattr->encoded;
+    dstattr->encoded_len = srcattr->encoded_len;
+  }
+
   return (dstattr);
 }
 
@@ -1631,17 +1777,12 @@ ippDateToTime(const ipp_uchar_t *date)	// I - RFC 2579 date info
 void
 ippDelete(ipp_t *ipp)			// I - IPP message
 {
-  ipp_attribute_t	*attr,		// Current attribute
-			*next;		// Next attribute
-
-
   DEBUG_printf("ippDelete(ipp=%p)", (void *)ipp);
 
   if (!ipp)
     return;
 
-  ipp->use --;
-  if (ipp->use > 0)
+  if (cupsAtomicDec(&ipp->use) > 0)
   {
     DEBUG_printf("4debug_retain: %p IPP message (use=%u)", (void *)ipp, (unsigned)ipp->use);
     return;
@@ -1649,21 +1790,12 @@ ippDelete(ipp_t *ipp)			// I - IPP message
 
   DEBUG_printf("4debug_free: %p IPP message", (void *)ipp);
 
-  for (attr = ipp->attrs; attr != NULL; attr = next)
-  {
-    next = attr->next;
-
-    DEBUG_printf("4debug_free: %p %s %s%s (%u values)", (void *)attr, attr->name, attr->num_values > 1 ? "1setOf " : "", ippTagString(attr->value_tag), (unsigned)attr->num_values);
-
-    ipp_free_values(attr, 0, attr->num_values);
-
-    if (attr->name)
-      _cupsStrFree(attr->name);
+  ipp_free_attrs(ipp);
 
-    free(attr);
-  }
-
-  free(ipp);
+  if (ipp->arena)
+    ipp_arena_release(ipp->arena);	// Frees the message, too
+  else
+    _cupsMemFree(ipp);
 }
 
 
@@ -1683,7 +1815,7 @@ ippDeleteAttribute(
   DEBUG_printf("ippDeleteAttribute(ipp=%p, attr=%p(%s))", (void *)ipp, (void *)attr, attr ? attr->name : "(null)");
 
   // Range check input...
-  if (!attr)
+  if (!attr || (ipp && ipp->frozen))
     return;
 
   DEBUG_printf("4debug_free: %p %s %s%s (%u values)", (void *)attr, attr->name, attr->num_values > 1 ? "1setOf " : "", ippTagString(attr->value_tag), (unsigned)attr->num_values);
@@ -1704,21 +1836,39 @@ ippDeleteAttribute(
 	if (current == ipp->last)
 	  ipp->last = prev;
 
+        ipp->num_attrs --;
+        ipp->length_valid = false;
         break;
       }
     }
 
     if (!current)
       return;
+
+    // The index only tracks the first attribute with a given name, so start
+    // over if we are deleting it...
+    if (ipp->index && attr->name && cupsArrayFind(ipp->index, attr) == attr)
+      ipp_index_clear(ipp);
   }
 
   // Free memory used by the attribute...
-  ipp_free_values(attr, 0, attr->num_values);
+  ipp_free_values(ipp, attr, 0, attr->num_values);
 
   if (attr->name)
-    _cupsStrFree(attr->name);
+    ipp_attr_strfree(ipp, attr, attr->name);
+
+  ipp_free(ipp, attr);
+}
+
 
-  free(attr);
+//
+// 'ippDeletePath()' - Free a compiled attribute path.
+//
+
+void
+ippDeletePath(ipp_path_t *path)		// I - Compiled path
+{
+  _cupsMemFree(path);
 }
 
 
@@ -1743,7 +1893,7 @@ ippDeleteValues(
     size_t          count)		// I  - Number of values to delete
 {
   // Range check input...
-  if (!ipp || !attr || !*attr || element >= (*attr)->num_values || !count || (element + count) >= (*attr)->num_values)
+  if (!ipp || ipp->frozen || !attr || !*attr || element >= (*attr)->num_values || !count || (element + count) >= (*attr)->num_values)
     return (false);
 
   // If we are deleting all values, just delete the attribute entirely.
@@ -1755,7 +1905,10 @@ ippDeleteValues(
   }
 
   // Otherwise free the values in question and return.
-  ipp_free_values(*attr, element, count);
+  ipp_free_values(ipp, *attr, element, count);
+
+  (*attr)->encoded  = NULL;
+  ipp->length_valid = false;
 
   return (true);
 }
@@ -1857,7 +2010,7 @@ ippFindNextAttribute(ipp_t      *ipp,	// I - IPP message
 
     if (!ipp->find->attr)
     {
-      ipp->find->attr = ipp->attrs;
+      ipp->find->attr = ipp_find_first(ipp, parent);
       ipp->find->idx  = 0;
     }
 
@@ -1870,7 +2023,7 @@ ippFindNextAttribute(ipp_t      *ipp,	// I - IPP message
   }
   else
   {
-    attr = ipp->attrs;
+    attr = ipp_find_first(ipp, name);
   }
 
   for (; attr != NULL; attr = attr->next)
@@ -1911,6 +2064,120 @@ ippFindNextAttribute(ipp_t      *ipp,	// I - IPP message
 }
 
 
+//
+// 'ippFindPath()' - Find an attribute using a compiled path.
+//
+// This function finds the first attribute matching a path compiled using
+// @link ippCompilePath@, searching every value of each collection attribute in
+// the path.  Unlike @link ippFindAttribute@, the find position used by
+// @link ippFindNextAttribute@ is not changed.
+//
+
+ipp_attribute_t *			// O - Matching attribute or `NULL` if none
+ippFindPath(ipp_t      *ipp,		// I - IPP message
+            ipp_path_t *path,		// I - Compiled path
+            ipp_tag_t  type)		// I - Type of attribute
+{
+  // Range check input...
+  if (!ipp || !path)
+    return (NULL);
+
+  // Search for the attribute...
+  return (ipp_find_path(ipp, path, 0, type));
+}
+
+
+//
+// 'ippFreeze()' - Make an IPP message read-only.
+//
+// This function makes the IPP message and any collections it contains
+// read-only and caches the encoded form of each attribute so that
+// @link ippWriteIO@ can copy it directly.  Once frozen, attributes cannot be
+// added, changed, or deleted - the message can only be read, copied, written,
+// and deleted.
+//
+// Quick copies of frozen attributes made using @link ippCopyAttribute@ or
+// @link ippCopyAttributes@ share the cached encoding, so the frozen message
+// must not be deleted while any quick copies are in use.
+//
+
+bool					// O - `true` on success, `false` on error
+ippFreeze(ipp_t *ipp)			// I - IPP message
+{
+  ipp_attribute_t	*attr,		// Current attribute
+			*next;		// Next attribute
+  ipp_t			temp;		// Single attribute message
+  _ipp_wbuffer_t	wbuf;		// Write buffer
+  ipp_uchar_t		*start;		// Start of encoded attribute
+  size_t		length;		// Length of encoded attribute
+
+
+  DEBUG_printf("ippFreeze(ipp=%p)", (void *)ipp);
+
+  if (!ipp)
+    return (false);
+  else if (ipp->frozen)
+    return (true);
+
+  // Allocate a buffer for the encoded attributes - each one is written as a
+  // separate message with an 8-byte header, group tag, and end tag, which are
+  // then discarded...
+  length = ippGetLength(ipp) + 10;
+
+  if ((wbuf.start = ipp_calloc(ipp, length)) == NULL)
+    return (false);
+
+  wbuf.dst = NULL;
+  wbuf.cb  = NULL;
+  wbuf.ptr = wbuf.start;
+  wbuf.end = wbuf.start + length;
+
+  for (attr = ipp->attrs; attr; attr = attr->next)
+  {
+    if (!attr->name || attr->group_tag == IPP_TAG_ZERO)
+      continue;
+
+    memset(&temp, 0, sizeof(temp));
+    temp.attrs = temp.last = attr;
+
+    start      = wbuf.ptr;
+    next       = attr->next;
+    attr->next = NULL;
+
+    if (ippWriteIO(&wbuf, (ipp_io_cb_t)ipp_write_batch, true, NULL, &temp) != IPP_STATE_DATA)
+    {
+      DEBUG_printf("1ippFreeze: Unable to encode \"%s\".", attr->name);
+
+      attr->next = next;
+
+      for (attr = ipp->attrs; attr; attr = attr->next)
+        attr->encoded = NULL;
+
+      ipp_free(ipp, wbuf.start);
+      return (false);
+    }
+
+    attr->next = next;
+
+    length = (size_t)(wbuf.ptr - start) - 10;
+    memmove(start, start + 9, length);
+
+    attr->encoded     = start;
+    attr->encoded_len = length;
+    wbuf.ptr          = start + length;
+  }
+
+  ipp->frozen_data = wbuf.start;
+
+  // Build the name index now rather than on the first lookup, and freeze any
+  // collections...
+  ipp_find_first(ipp, "");
+  ipp_freeze(ipp);
+
+  return (true);
+}
+
+
 //
 // 'ippGetBoolean()' - Get a boolean value for an attribute.
 //
@@ -2330,28 +2597,48 @@ ippGetVersion(ipp_t *ipp,		// I - IPP message
 ipp_t *					// O - New IPP message
 ippNew(void)
 {
-  ipp_t			*temp;		// New IPP message
-  _cups_globals_t	*cg = _cupsGlobals();
-					// Global data
+  ipp_t	*temp;				// New IPP message
 
 
   DEBUG_puts("ippNew()");
 
-  if ((temp = (ipp_t *)calloc(1, sizeof(ipp_t))) != NULL)
-  {
-    // Set default version - usually 2.0...
-    DEBUG_printf("4debug_alloc: %p IPP message", (void *)temp);
+  temp = ipp_new(NULL);
 
-    if (cg->server_version == 0)
-      _cupsSetDefaults();
+  DEBUG_printf("1ippNew: Returning %p", (void *)temp);
 
-    temp->request.any.version[0] = (ipp_uchar_t)(cg->server_version / 10);
-    temp->request.any.version[1] = (ipp_uchar_t)(cg->server_version % 10);
-    temp->use                    = 1;
-    temp->find                   = temp->fstack;
-  }
+  return (temp);
+}
 
-  DEBUG_printf("1ippNew: Returning %p", (void *)temp);
+
+//
+// 'ippNewArena()' - Allocate a new IPP message using an arena allocator.
+//
+// This function creates a new IPP message whose attributes, values, strings,
+// and collections are all allocated from a single memory arena owned by the
+// message.  The arena is released all at once by @link ippDelete@, which makes
+// building and freeing large messages much cheaper than with @link ippNew@.
+//
+// Memory used by deleted attributes and replaced values is not reclaimed
+// until the message is deleted, so arena messages are best suited to messages
+// that are built or read once and then discarded.
+//
+
+ipp_t *					// O - New IPP message
+ippNewArena(void)
+{
+  _ipp_arena_t	*arena;			// Arena allocator
+  ipp_t		*temp;			// New IPP message
+
+
+  DEBUG_puts("ippNewArena()");
+
+  if ((arena = (_ipp_arena_t *)_cupsMemCalloc(CUPS_MEMTYPE_IPP, 1, sizeof(_ipp_arena_t))) == NULL)
+    return (NULL);
+
+  if ((temp = ipp_new(arena)) == NULL)
+    _cupsMemFree(arena);
+
+  DEBUG_printf("1ippNewArena: Returning %p", (void *)temp);
 
   return (temp);
 }
@@ -2368,37 +2655,26 @@ ippNew(void)
 ipp_t *					// O - IPP request message
 ippNewRequest(ipp_op_t op)		// I - Operation code
 {
-  ipp_t		*request;		// IPP request message
-  cups_lang_t	*language;		// Current language localization
-  static int	request_id = 0;		// Current request ID
-  static cups_mutex_t request_mutex = CUPS_MUTEX_INITIALIZER;
-					// Mutex for request ID
-
-
   DEBUG_printf("ippNewRequest(op=%02x(%s))", op, ippOpString(op));
 
-  // Create a new IPP message...
-  if ((request = ippNew()) == NULL)
-    return (NULL);
-
-  // Set the operation and request ID...
-  cupsMutexLock(&request_mutex);
-
-  request->request.op.operation_id = op;
-  request->request.op.request_id   = ++request_id;
-
-  cupsMutexUnlock(&request_mutex);
+  return (ipp_init_request(ippNew(), op));
+}
 
-  // Use UTF-8 as the character set...
-  ippAddString(request, IPP_TAG_OPERATION, IPP_CONST_TAG(IPP_TAG_CHARSET), "attributes-charset", NULL, "utf-8");
 
-  // Get the language from the current locale...
-  language = cupsLangDefault();
+//
+//  'ippNewRequestArena()' - Allocate a new IPP request message using an arena
+//                           allocator.
+//
+// This function is identical to @link ippNewRequest@ but creates the message
+// using @link ippNewArena@.
+//
 
-  ippAddString(request, IPP_TAG_OPERATION, IPP_CONST_TAG(IPP_TAG_LANGUAGE), "attributes-natural-language", NULL, cupsLangGetName(language));
+ipp_t *					// O - IPP request message
+ippNewRequestArena(ipp_op_t op)		// I - Operation code
+{
+  DEBUG_printf("ippNewRequestArena(op=%02x(%s))", op, ippOpString(op));
 
-  // Return the new request...
-  return (request);
+  return (ipp_init_request(ippNewArena(), op));
 }
 
 
@@ -2488,6 +2764,39 @@ ippRead(http_t *http,			// I - HTTP connection
 }
 
 
+//
+// 'ippReadBuffer()' - Read an IPP message from a memory buffer.
+//
+// This function reads a complete IPP message from the "data" buffer.  Any data
+// following the end of the IPP message (such as an attached document) is
+// ignored.
+//
+// When "ipp" was created using @link ippNewArena@ or @link ippNewRequestArena@,
+// octetString and other binary values reference the bytes in "data" directly
+// rather than being copied, so the buffer must remain valid and unchanged for
+// the life of the message.  String values are always copied.
+//
+
+ipp_state_t				// O - Current state
+ippReadBuffer(const void *data,		// I - IPP message data
+              size_t     datalen,	// I - Length of data in bytes
+              ipp_t      *ipp)		// I - IPP message
+{
+  _ipp_buffer_t	buf;			// Memory buffer
+
+
+  DEBUG_printf("ippReadBuffer(data=%p, datalen=%u, ipp=%p)", data, (unsigned)datalen, (void *)ipp);
+
+  if (!data)
+    return (IPP_STATE_ERROR);
+
+  buf.ptr = (const ipp_uchar_t *)data;
+  buf.end = buf.ptr + datalen;
+
+  return (ippReadIO(&buf, (ipp_io_cb_t)ipp_read_buffer, true, NULL, ipp));
+}
+
+
 //
 // 'ippReadFile()' - Read data for an IPP message from a file.
 //
@@ -2528,7 +2837,7 @@ ippReadIO(void        *src,		// I - Data source
   DEBUG_printf("ippReadIO(src=%p, cb=%p, blocking=%d, parent=%p, ipp=%p)", (void *)src, (void *)cb, blocking, (void *)parent, (void *)ipp);
   DEBUG_printf("2ippReadIO: ipp->state=%d", ipp ? ipp->state : IPP_STATE_ERROR);
 
-  if (!src || !ipp)
+  if (!src || !ipp || ipp->frozen)
     return (IPP_STATE_ERROR);
 
   if ((buffer = (unsigned char *)_cupsBufferGet(IPP_BUF_SIZE)) == NULL)
@@ -2591,6 +2900,14 @@ ippReadIO(void        *src,		// I - Data source
 	    // No more attributes left...
             DEBUG_puts("2ippReadIO: IPP_TAG_END.");
 
+            if (ipp->stream_cb && ipp->current)
+            {
+              attr = NULL;
+
+              if (!ipp_stream_attr(ipp, ipp->current))
+                goto rollback;
+            }
+
 	    ipp->state = IPP_STATE_DATA;
 	    break;
 	  }
@@ -2609,6 +2926,17 @@ ippReadIO(void        *src,		// I - Data source
 	      DEBUG_printf("1ippReadIO: bad tag 0x%02x.", tag);
 	      goto rollback;
             }
+            else if (ipp->stream_cb)
+            {
+              // Deliver the previous attribute and the group tag...
+              attr = NULL;
+
+              if (ipp->current && !ipp_stream_attr(ipp, ipp->current))
+                goto rollback;
+
+              if (!(ipp->stream_cb)(ipp->stream_data, tag, NULL))
+                goto rollback;
+            }
             else if (ipp->curtag == tag)
             {
 	      ipp->prev = ippAddSeparator(ipp);
@@ -2756,6 +3084,15 @@ ippReadIO(void        *src,		// I - Data source
 
 	    buffer[n] = '\0';
 
+            if (ipp->stream_cb && ipp->current)
+            {
+              // Deliver the previous attribute before starting a new one...
+              attr = NULL;
+
+              if (!ipp_stream_attr(ipp, ipp->current))
+                goto rollback;
+            }
+
             if (ipp->current)
 	      ipp->prev = ipp->current;
 
@@ -2876,7 +3213,7 @@ ippReadIO(void        *src,		// I - Data source
 		}
 
 		buffer[n] = '\0';
-		value->string.text = _cupsStrAlloc((char *)buffer);
+		value->string.text = ipp_attr_strdup(ipp, attr, (char *)buffer);
 		DEBUG_printf("2ippReadIO: value=\"%s\"", value->string.text);
 	        break;
 
@@ -2978,7 +3315,7 @@ ippReadIO(void        *src,		// I - Data source
 		memcpy(string, bufptr + 2, (size_t)n);
 		string[n] = '\0';
 
-		value->string.language = _cupsStrAlloc((char *)string);
+		value->string.language = ipp_attr_strdup(ipp, attr, (char *)string);
 
                 bufptr += 2 + n;
 		n = (bufptr[0] << 8) | bufptr[1];
@@ -2991,12 +3328,12 @@ ippReadIO(void        *src,		// I - Data source
 		}
 
 		bufptr[2 + n] = '\0';
-                value->string.text = _cupsStrAlloc((char *)bufptr + 2);
+                value->string.text = ipp_attr_strdup(ipp, attr, (char *)bufptr + 2);
 	        break;
 
             case IPP_TAG_BEGIN_COLLECTION :
 	        // Oh boy, here comes a collection value, so read it...
-                value->collection = ippNew();
+                value->collection = ipp_new(ipp->arena);
 
                 if (n > 0)
 		{
@@ -3047,7 +3384,8 @@ ippReadIO(void        *src,		// I - Data source
 		}
 
 		buffer[n] = '\0';
-		attr->name = _cupsStrAlloc((char *)buffer);
+		attr->name = ipp_strdup(ipp, (char *)buffer);
+		ipp_index_add(ipp, attr);
 
 	        // Since collection members are encoded differently than
 		// regular attributes, make sure we don't start with an
@@ -3068,9 +3406,25 @@ ippReadIO(void        *src,		// I - Data source
 
                 value->unknown.length = (size_t)n;
 
-	        if (n > 0)
+	        if (n > 0 && ipp->arena && cb == (ipp_io_cb_t)ipp_read_buffer)
+	        {
+	          // Reference the value in the caller's buffer - arena messages
+	          // never free individual values...
+	          _ipp_buffer_t *buf = (_ipp_buffer_t *)src;
+					// Memory buffer
+
+	          if ((buf->end - buf->ptr) < n)
+	          {
+	            DEBUG_puts("1ippReadIO: Unable to read unsupported value.");
+		    goto rollback;
+	          }
+
+		  value->unknown.data = (void *)buf->ptr;
+		  buf->ptr            += n;
+	        }
+	        else if (n > 0)
 		{
-		  if ((value->unknown.data = malloc((size_t)n)) == NULL)
+		  if ((value->unknown.data = ipp_calloc(ipp, (size_t)n)) == NULL)
 		  {
 		    _cupsSetHTTPError(HTTP_STATUS_ERROR);
 		    DEBUG_puts("1ippReadIO: Unable to allocate value");
@@ -3122,29 +3476,145 @@ ippReadIO(void        *src,		// I - Data source
 
 
 //
-// 'ippRestore()' - Restore a previously saved find position.
+// 'ippReadIOStream()' - Read an IPP message, streaming attributes to a callback.
+//
+// This function reads an IPP message like @link ippReadIO@, but instead of
+// accumulating attributes in "ipp" it calls the "stream_cb" function as each
+// attribute is completed.  The "attr" argument to the callback is only valid
+// until the callback returns and is then deleted, so the message only ever
+// holds the attribute currently being read.  The message header (version,
+// operation or status code, and request ID) is available from "ipp" as usual.
+//
+// The callback is also called with a `NULL` attribute pointer for each group
+// tag, including repeated group tags that separate objects in a response such
+// as the job groups in a Get-Jobs response.
+//
+// The callback returns `true` to continue reading or `false` to stop, in which
+// case `IPP_STATE_ERROR` is returned.
+//
+// For constant memory use, "ipp" should be created using @link ippNew@ rather
+// than @link ippNewArena@.
 //
 
-void
-ippRestore(ipp_t *ipp)			// I - IPP message
+ipp_state_t				// O - Current state
+ippReadIOStream(
+    void            *src,		// I - Data source
+    ipp_io_cb_t     cb,			// I - Read callback function
+    bool            blocking,		// I - Use blocking IO?
+    ipp_t           *ipp,		// I - IPP message
+    ipp_stream_cb_t stream_cb,		// I - Attribute callback function
+    void            *stream_data)	// I - Attribute callback data
 {
-  if (ipp)
-  {
-    if (ipp->find > ipp->fstack)
-      ipp->find --;
-    else
-      ipp->find = NULL;
-  }
-}
+  ipp_state_t	state;			// Current state
 
 
-//
-// 'ippSave()' - Save the current find position.
-//
+  DEBUG_printf("ippReadIOStream(src=%p, cb=%p, blocking=%d, ipp=%p, stream_cb=%p, stream_data=%p)", (void *)src, (void *)cb, blocking, (void *)ipp, (void *)stream_cb, stream_data);
 
-void
-ippSave(ipp_t *ipp)			// I - IPP message
-{
+  if (!ipp || !stream_cb)
+    return (IPP_STATE_ERROR);
+
+  ipp->stream_cb   = stream_cb;
+  ipp->stream_data = stream_data;
+
+  state = ippReadIO(src, cb, blocking, NULL, ipp);
+
+  ipp->stream_cb   = NULL;
+  ipp->stream_data = NULL;
+
+  return (state);
+}
+
+
+//
+// 'ippReadStream()' - Read an IPP message from a HTTP connection, streaming
+//                     attributes to a callback.
+//
+// This function reads an IPP message like @link ippRead@, calling the
+// "stream_cb" function as each attribute is completed.  See
+// @link ippReadIOStream@ for details.
+//
+
+ipp_state_t				// O - Current state
+ippReadStream(
+    http_t          *http,		// I - HTTP connection
+    ipp_t           *ipp,		// I - IPP message
+    ipp_stream_cb_t stream_cb,		// I - Attribute callback function
+    void            *stream_data)	// I - Attribute callback data
+{
+  DEBUG_printf("ippReadStream(http=%p, ipp=%p, stream_cb=%p, stream_data=%p)", (void *)http, (void *)ipp, (void *)stream_cb, stream_data);
+
+  if (!http)
+    return (IPP_STATE_ERROR);
+
+  return (ippReadIOStream(http, (ipp_io_cb_t)ipp_read_http, http->blocking, ipp, stream_cb, stream_data));
+}
+
+
+//
+// 'ippReset()' - Clear an IPP message so it can be reused.
+//
+// This function deletes all of the attributes in an IPP message and resets
+// the message header and state to those of a new message, so that a server can
+// reuse the same message for each request or response.  Messages created with
+// @link ippNewArena@ or @link ippNewRequestArena@ keep their memory blocks for
+// the new attributes.
+//
+
+void
+ippReset(ipp_t *ipp)			// I - IPP message
+{
+  cups_atomic_t		use;		// Use count
+  _ipp_arena_t		*arena;		// Arena allocator
+  _cups_globals_t	*cg = _cupsGlobals();
+					// Global data
+
+
+  DEBUG_printf("ippReset(ipp=%p)", (void *)ipp);
+
+  if (!ipp)
+    return;
+
+  ipp_free_attrs(ipp);
+
+  use   = cupsAtomicGet(&ipp->use);
+  arena = ipp->arena;
+
+  memset(ipp, 0, sizeof(ipp_t));
+
+  ipp->request.any.version[0] = (ipp_uchar_t)(cg->server_version / 10);
+  ipp->request.any.version[1] = (ipp_uchar_t)(cg->server_version % 10);
+  ipp->use                    = use;
+  ipp->find                   = ipp->fstack;
+
+  if ((ipp->arena = arena) != NULL)
+    ipp_arena_reset(arena, ipp);
+}
+
+
+//
+// 'ippRestore()' - Restore a previously saved find position.
+//
+
+void
+ippRestore(ipp_t *ipp)			// I - IPP message
+{
+  if (ipp)
+  {
+    if (ipp->find > ipp->fstack)
+      ipp->find --;
+    else
+      ipp->find = NULL;
+  }
+}
+
+
+//
+// 'ippSave()' - Save the current find position.
+//
+
+void
+ippSave(ipp_t *ipp)			// I - IPP message
+{
   if (ipp && ipp->find < (ipp->fstack + _IPP_MAX_FIND))
   {
     ipp->find[1] = ipp->find[0];
@@ -3219,7 +3689,7 @@ ippSetCollection(
       ippDelete(value->collection);
 
     value->collection = colvalue;
-    colvalue->use ++;
+    cupsAtomicInc(&colvalue->use);
   }
 
   return (value != NULL);
@@ -3284,11 +3754,12 @@ ippSetGroupTag(
     ipp_tag_t       group_tag)		// I  - Group tag
 {
   // Range check input - group tag must be 0x01 to 0x0F, per RFC 8011...
-  if (!ipp || !attr || !*attr || group_tag < IPP_TAG_ZERO || group_tag == IPP_TAG_END || group_tag >= IPP_TAG_UNSUPPORTED_VALUE)
+  if (!ipp || ipp->frozen || !attr || !*attr || group_tag < IPP_TAG_ZERO || group_tag == IPP_TAG_END || group_tag >= IPP_TAG_UNSUPPORTED_VALUE)
     return (false);
 
   // Set the group tag and return...
   (*attr)->group_tag = group_tag;
+  ipp->length_valid  = false;
 
   return (true);
 }
@@ -3350,16 +3821,21 @@ ippSetName(ipp_t           *ipp,	// I  - IPP message
 
 
   // Range check input...
-  if (!ipp || !attr || !*attr || !name)
+  if (!ipp || ipp->frozen || !attr || !*attr || !name)
     return (false);
 
   // Set the value and return...
-  if ((temp = _cupsStrAlloc(name)) != NULL)
+  if ((temp = ipp_strdup(ipp, name)) != NULL)
   {
+    (*attr)->encoded  = NULL;
+    ipp->length_valid = false;
+
     if ((*attr)->name)
-      _cupsStrFree((*attr)->name);
+      ipp_attr_strfree(ipp, *attr, (*attr)->name);
 
     (*attr)->name = temp;
+
+    ipp_index_clear(ipp);
   }
 
   return (temp != NULL);
@@ -3410,7 +3886,7 @@ ippSetOctetString(
       if (value->unknown.data)
       {
         // Free previous data...
-	free(value->unknown.data);
+	ipp_free(ipp, value->unknown.data);
 
 	value->unknown.data   = NULL;
         value->unknown.length = 0;
@@ -3420,7 +3896,7 @@ ippSetOctetString(
       {
 	void	*temp;			// Temporary data pointer
 
-	if ((temp = malloc((size_t)datalen)) != NULL)
+	if ((temp = ipp_calloc(ipp, (size_t)datalen)) != NULL)
 	{
 	  memcpy(temp, data, (size_t)datalen);
 
@@ -3651,10 +4127,10 @@ ippSetString(ipp_t           *ipp,	// I  - IPP message
     {
       value->string.text = (char *)strvalue;
     }
-    else if ((temp = _cupsStrAlloc(strvalue)) != NULL)
+    else if ((temp = ipp_strdup(ipp, strvalue)) != NULL)
     {
       if (value->string.text)
-        _cupsStrFree(value->string.text);
+        ipp_attr_strfree(ipp, *attr, value->string.text);
 
       value->string.text = temp;
     }
@@ -3867,7 +4343,7 @@ ippSetValueTag(
 
 
   // Range check input...
-  if (!ipp || !attr || !*attr)
+  if (!ipp || ipp->frozen || !attr || !*attr)
     return (false);
 
   // If there is no change, return immediately...
@@ -3876,6 +4352,9 @@ ippSetValueTag(
   if (value_tag == temp_tag)
     return (true);
 
+  (*attr)->encoded  = NULL;
+  ipp->length_valid = false;
+
   // Otherwise implement changes as needed...
   switch (value_tag)
   {
@@ -3888,7 +4367,7 @@ ippSetValueTag(
     case IPP_TAG_ADMINDEFINE :
         // Free any existing values...
         if ((*attr)->num_values > 0)
-          ipp_free_values(*attr, 0, (*attr)->num_values);
+          ipp_free_values(ipp, *attr, 0, (*attr)->num_values);
 
         // Set out-of-band value...
         (*attr)->value_tag = value_tag;
@@ -3925,13 +4404,13 @@ ippSetValueTag(
         if (ipp->attrs && ipp->attrs->next && ipp->attrs->next->name && !strcmp(ipp->attrs->next->name, "attributes-natural-language") && (ipp->attrs->next->value_tag & IPP_TAG_CUPS_MASK) == IPP_TAG_LANGUAGE)
         {
           // Use the language code from the IPP message...
-	  (*attr)->values[0].string.language = _cupsStrAlloc(ipp->attrs->next->values[0].string.text);
+	  (*attr)->values[0].string.language = ipp_strdup(ipp, ipp->attrs->next->values[0].string.text);
         }
         else
         {
           // Otherwise, use the language code corresponding to the locale...
 	  language = cupsLangDefault();
-	  (*attr)->values[0].string.language = _cupsStrAlloc(ipp_lang_code(cupsLangGetName(language), code, sizeof(code)));
+	  (*attr)->values[0].string.language = ipp_strdup(ipp, ipp_lang_code(cupsLangGetName(language), code, sizeof(code)));
         }
 
         for (i = (*attr)->num_values - 1, value = (*attr)->values + 1; i > 0; i --, value ++)
@@ -3941,7 +4420,7 @@ ippSetValueTag(
         {
           // Make copies of all values...
 	  for (i = (*attr)->num_values, value = (*attr)->values; i > 0; i --, value ++)
-	    value->string.text = _cupsStrAlloc(value->string.text);
+	    value->string.text = ipp_strdup(ipp, value->string.text);
         }
 
         (*attr)->value_tag = IPP_TAG_NAMELANG;
@@ -4003,8 +4482,14 @@ const ipp_uchar_t *			// O - RFC-2579 date/time data
 ippTimeToDate(time_t t)			// I - Time in seconds
 {
   struct tm	unixdate;		// UNIX unixdate/time info
-  ipp_uchar_t	*date = _cupsGlobals()->ipp_date;
-					// RFC-2579 date/time data
+  _cups_globals_t *cg = _cupsGlobals();	// Global data
+  ipp_uchar_t	*date = cg->ipp_date;	// RFC-2579 date/time data
+
+
+  // Reuse the last date/time converted by this thread for the same time (the
+  // month is never 0 once converted)...
+  if (t == cg->ipp_date_time && date[2])
+    return (date);
 
 
   // RFC-2579 date/time format is:
@@ -4036,6 +4521,8 @@ ippTimeToDate(time_t t)			// I - Time in seconds
   date[9]  = 0;
   date[10] = 0;
 
+  cg->ipp_date_time = t;
+
   return (date);
 }
 
@@ -4062,7 +4549,6 @@ ippValidateAttribute(
 		uri_status;		// URI separation status
   const char	*ptr;			// Pointer into string
   ipp_attribute_t *colattr;		// Collection attribute
-  regex_t	re;			// Regular expression
   ipp_uchar_t	*date;			// Current date value
 
 
@@ -4071,11 +4557,7 @@ ippValidateAttribute(
     return (true);
 
   // Validate the attribute name.
-  for (ptr = attr->name; *ptr; ptr ++)
-  {
-    if (!isalnum(*ptr & 255) && *ptr != '-' && *ptr != '.' && *ptr != '_')
-      break;
-  }
+  ptr = ipp_check_keyword(attr->name);
 
   if (*ptr || ptr == attr->name)
   {
@@ -4239,38 +4721,7 @@ ippValidateAttribute(
     case IPP_TAG_TEXTLANG :
         for (i = 0; i < attr->num_values; i ++)
 	{
-	  for (ptr = attr->values[i].string.text; *ptr; ptr ++)
-	  {
-	    if ((*ptr & 0xe0) == 0xc0)
-	    {
-	      if ((ptr[1] & 0xc0) != 0x80)
-	        break;
-
-	      ptr ++;
-	    }
-	    else if ((*ptr & 0xf0) == 0xe0)
-	    {
-	      if ((ptr[1] & 0xc0) != 0x80 || (ptr[2] & 0xc0) != 0x80)
-	        break;
-
-	      ptr += 2;
-	    }
-	    else if ((*ptr & 0xf8) == 0xf0)
-	    {
-	      if ((ptr[1] & 0xc0) != 0x80 || (ptr[2] & 0xc0) != 0x80 || (ptr[3] & 0xc0) != 0x80)
-	        break;
-
-	      ptr += 3;
-	    }
-	    else if (*ptr & 0x80)
-	    {
-	      break;
-	    }
-	    else if ((*ptr < ' ' && *ptr != '\n' && *ptr != '\r' && *ptr != '\t') || *ptr == 0x7f)
-	    {
-	      break;
-	    }
-	  }
+	  ptr = ipp_check_utf8(attr->values[i].string.text, true);
 
           if (*ptr)
           {
@@ -4298,38 +4749,7 @@ ippValidateAttribute(
     case IPP_TAG_NAMELANG :
         for (i = 0; i < attr->num_values; i ++)
 	{
-	  for (ptr = attr->values[i].string.text; *ptr; ptr ++)
-	  {
-	    if ((*ptr & 0xe0) == 0xc0)
-	    {
-	      if ((ptr[1] & 0xc0) != 0x80)
-	        break;
-
-	      ptr ++;
-	    }
-	    else if ((*ptr & 0xf0) == 0xe0)
-	    {
-	      if ((ptr[1] & 0xc0) != 0x80 || (ptr[2] & 0xc0) != 0x80)
-	        break;
-
-	      ptr += 2;
-	    }
-	    else if ((*ptr & 0xf8) == 0xf0)
-	    {
-	      if ((ptr[1] & 0xc0) != 0x80 || (ptr[2] & 0xc0) != 0x80 || (ptr[3] & 0xc0) != 0x80)
-	        break;
-
-	      ptr += 3;
-	    }
-	    else if (*ptr & 0x80)
-	    {
-	      break;
-	    }
-	    else if (*ptr < ' ' || *ptr == 0x7f)
-	    {
-	      break;
-	    }
-	  }
+	  ptr = ipp_check_utf8(attr->values[i].string.text, false);
 
 	  if (*ptr)
 	  {
@@ -4354,13 +4774,9 @@ ippValidateAttribute(
         break;
 
     case IPP_TAG_KEYWORD :
-        for (i = 0; i < attr->num_values; i ++)
+	for (i = 0; i < attr->num_values; i ++)
 	{
-	  for (ptr = attr->values[i].string.text; *ptr; ptr ++)
-	  {
-	    if (!isalnum(*ptr & 255) && *ptr != '-' && *ptr != '.' && *ptr != '_')
-	      break;
-	  }
+	  ptr = ipp_check_keyword(attr->values[i].string.text);
 
 	  if (*ptr || ptr == attr->values[i].string.text)
 	  {
@@ -4448,7 +4864,7 @@ ippValidateAttribute(
         // The following regular expression is derived from the ABNF for
 	// language tags in RFC 4646.  All I can say is that this is the
 	// easiest way to check the values...
-        if ((r = regcomp(&re,
+        if ((r = ipp_regcomp(&ipp_lang_re, &ipp_lang_status,
 			 "^("
 			 "(([a-z]{2,3}(-[a-z][a-z][a-z]){0,3})|[a-z]{4,8})"
 								// language
@@ -4461,41 +4877,36 @@ ippValidateAttribute(
 			 "x(-[a-z0-9]{1,8})+"			// privateuse
 			 "|"
 			 "[a-z]{1,3}(-[a-z][0-9]{2,8}){1,2}"	// grandfathered
-			 ")$",
-			 REG_NOSUB | REG_EXTENDED)) != 0)
+			 ")$")) != 0)
         {
           char	temp[256];		// Temporary error string
 
-          regerror(r, &re, temp, sizeof(temp));
+          regerror(r, &ipp_lang_re, temp, sizeof(temp));
 	  ipp_set_error(IPP_STATUS_ERROR_INTERNAL, _("Unable to compile naturalLanguage regular expression: %s."), temp);
 	  return (false);
         }
 
         for (i = 0; i < attr->num_values; i ++)
 	{
-	  if (regexec(&re, attr->values[i].string.text, 0, NULL, 0))
+	  if (regexec(&ipp_lang_re, attr->values[i].string.text, 0, NULL, 0))
 	  {
 	    ipp_set_error(IPP_STATUS_ERROR_BAD_REQUEST, _("\"%s\": Bad naturalLanguage value \"%s\" - bad characters (RFC 8011 section 5.1.9)."), attr->name, attr->values[i].string.text);
-	    regfree(&re);
 	    return (false);
 	  }
 
 	  if (strlen(attr->values[i].string.text) > (IPP_MAX_LANGUAGE - 1))
 	  {
 	    ipp_set_error(IPP_STATUS_ERROR_BAD_REQUEST, _("\"%s\": Bad naturalLanguage value \"%s\" - bad length %d (RFC 8011 section 5.1.9)."), attr->name, attr->values[i].string.text, (int)strlen(attr->values[i].string.text));
-	    regfree(&re);
 	    return (false);
 	  }
 	}
-
-	regfree(&re);
         break;
 
     case IPP_TAG_MIMETYPE :
         // The following regular expression is derived from the ABNF for
 	// MIME media types in RFC 2045 and 4288.  All I can say is that this is
 	// the easiest way to check the values...
-        if ((r = regcomp(&re,
+        if ((r = ipp_regcomp(&ipp_mime_re, &ipp_mime_status,
 			 "^"
 			 "[-a-zA-Z0-9!#$&.+^_]{1,127}"		// type-name
 			 "/"
@@ -4503,34 +4914,29 @@ ippValidateAttribute(
 			 "(;[-a-zA-Z0-9!#$&.+^_]{1,127}="	// parameter=
 			 "([-a-zA-Z0-9!#$&.+^_]{1,127}|\"[^\"]*\"))*"
 			 					// value
-			 "$",
-			 REG_NOSUB | REG_EXTENDED)) != 0)
+			 "$")) != 0)
         {
           char	temp[256];		// Temporary error string
 
-          regerror(r, &re, temp, sizeof(temp));
+          regerror(r, &ipp_mime_re, temp, sizeof(temp));
 	  ipp_set_error(IPP_STATUS_ERROR_BAD_REQUEST, _("Unable to compile mimeMediaType regular expression: %s."), temp);
 	  return (false);
         }
 
         for (i = 0; i < attr->num_values; i ++)
 	{
-	  if (regexec(&re, attr->values[i].string.text, 0, NULL, 0))
+	  if (regexec(&ipp_mime_re, attr->values[i].string.text, 0, NULL, 0))
 	  {
 	    ipp_set_error(IPP_STATUS_ERROR_BAD_REQUEST, _("\"%s\": Bad mimeMediaType value \"%s\" - bad characters (RFC 8011 section 5.1.10)."), attr->name, attr->values[i].string.text);
-	    regfree(&re);
 	    return (false);
 	  }
 
 	  if (strlen(attr->values[i].string.text) > (IPP_MAX_MIMETYPE - 1))
 	  {
 	    ipp_set_error(IPP_STATUS_ERROR_BAD_REQUEST, _("\"%s\": Bad mimeMediaType value \"%s\" - bad length %d (RFC 8011 section 5.1.10)."), attr->name, attr->values[i].string.text, (int)strlen(attr->values[i].string.text));
-	    regfree(&re);
 	    return (false);
 	  }
 	}
-
-	regfree(&re);
         break;
 
     default :
@@ -4585,6 +4991,58 @@ ippWrite(http_t *http,			// I - HTTP connection
 }
 
 
+//
+// 'ippWriteBuffer()' - Write an IPP message to a newly allocated memory buffer.
+//
+// This function encodes the IPP message "ipp" into a single buffer that is
+// sized using @link ippGetLength@.  The buffer is returned in "data" and must be
+// freed using the `free` function.
+//
+
+bool					// O - `true` on success, `false` on error
+ippWriteBuffer(ipp_t  *ipp,		// I - IPP message
+               void   **data,		// O - IPP message data
+               size_t *datalen)		// O - Length of data in bytes
+{
+  _ipp_wbuffer_t	wbuf;		// Write buffer
+  size_t		length;		// Length of message
+
+
+  DEBUG_printf("ippWriteBuffer(ipp=%p, data=%p, datalen=%p)", (void *)ipp, (void *)data, (void *)datalen);
+
+  if (data)
+    *data = NULL;
+  if (datalen)
+    *datalen = 0;
+
+  if (!ipp || !data || !datalen)
+    return (false);
+
+  length = ippGetLength(ipp);
+
+  if ((wbuf.start = malloc(length)) == NULL)
+    return (false);
+
+  wbuf.dst = NULL;
+  wbuf.cb  = NULL;
+  wbuf.ptr = wbuf.start;
+  wbuf.end = wbuf.start + length;
+
+  ipp->state = IPP_STATE_IDLE;
+
+  if (ippWriteIO(&wbuf, (ipp_io_cb_t)ipp_write_batch, true, NULL, ipp) != IPP_STATE_DATA)
+  {
+    free(wbuf.start);
+    return (false);
+  }
+
+  *data    = wbuf.start;
+  *datalen = (size_t)(wbuf.ptr - wbuf.start);
+
+  return (true);
+}
+
+
 //
 // 'ippWriteFile()' - Write data for an IPP message to a file.
 //
@@ -4625,6 +5083,35 @@ ippWriteIO(void        *dst,		// I - Destination
   if (!dst || !ipp)
     return (IPP_STATE_ERROR);
 
+  if (!parent && cb != (ipp_io_cb_t)ipp_write_batch)
+  {
+    // Gather the encoded message into large blocks so that the callback sees
+    // a few big writes rather than one or more writes per attribute...
+    _ipp_wbuffer_t	wbuf;		// Write buffer
+    ipp_state_t		state;		// Current state
+
+    if ((wbuf.start = (ipp_uchar_t *)_cupsBufferGet(IPP_BUF_SIZE)) == NULL)
+    {
+      DEBUG_puts("1ippWriteIO: Unable to get batch buffer");
+      return (IPP_STATE_ERROR);
+    }
+
+    wbuf.dst = dst;
+    wbuf.cb  = cb;
+    wbuf.ptr = wbuf.start;
+    wbuf.end = wbuf.start + IPP_BUF_SIZE;
+
+    if ((state = ippWriteIO(&wbuf, (ipp_io_cb_t)ipp_write_batch, blocking, NULL, ipp)) != IPP_STATE_ERROR && !ipp_write_flush(&wbuf))
+    {
+      DEBUG_puts("1ippWriteIO: Could not write IPP data...");
+      state = IPP_STATE_ERROR;
+    }
+
+    _cupsBufferRelease((char *)wbuf.start);
+
+    return (state);
+  }
+
   if ((buffer = (unsigned char *)_cupsBufferGet(IPP_BUF_SIZE)) == NULL)
   {
     DEBUG_puts("1ippWriteIO: Unable to get write buffer");
@@ -4706,6 +5193,26 @@ ippWriteIO(void        *dst,		// I - Destination
 	    {
 	      continue;
 	    }
+
+	    if (attr->encoded)
+	    {
+	      // Copy the attribute as encoded by ippFreeze...
+	      DEBUG_printf("1ippWriteIO: %s (%u encoded bytes)", attr->name, (unsigned)attr->encoded_len);
+
+	      if ((bufptr > buffer && (*cb)(dst, buffer, (size_t)(bufptr - buffer)) < 0) || (*cb)(dst, attr->encoded, attr->encoded_len) < 0)
+	      {
+		DEBUG_puts("1ippWriteIO: Could not write IPP attribute...");
+		_cupsBufferRelease((char *)buffer);
+		return (IPP_STATE_ERROR);
+	      }
+
+	      // If blocking is disabled and we aren't at the end of the attribute
+	      // list, stop here...
+	      if (!blocking && ipp->current)
+		break;
+
+	      continue;
+	    }
 	  }
 
 	  DEBUG_printf("1ippWriteIO: %s (%s%s)", attr->name, attr->num_values > 1 ? "1setOf " : "", ippTagString(attr->value_tag));
@@ -5340,7 +5847,9 @@ ipp_add_attr(ipp_t      *ipp,		// I - IPP message
              ipp_tag_t  value_tag,	// I - Value tag or IPP_TAG_ZERO
              size_t     num_values)	// I - Number of values
 {
-  size_t		alloc_values;	// Number of values to allocate
+  size_t		alloc_values,	// Number of values to allocate
+			alloc_size,	// Size of attribute
+			inline_size = 0;// Size of inline string storage
   ipp_attribute_t	*attr;		// New attribute
 
 
@@ -5350,21 +5859,42 @@ ipp_add_attr(ipp_t      *ipp,		// I - IPP message
   if (!ipp)
     return (NULL);
 
+  // Frozen messages cannot be changed...
+  if (ipp->frozen)
+    return (NULL);
+
+  ipp->length_valid = false;
+
   // Allocate memory, rounding the allocation up as needed...
   if (num_values <= 1)
     alloc_values = 1;
   else
     alloc_values = (num_values + IPP_MAX_VALUES - 1) & (size_t)~(IPP_MAX_VALUES - 1);
 
-  attr = calloc(1, sizeof(ipp_attribute_t) + (size_t)(alloc_values - 1) * sizeof(_ipp_value_t));
+  // Heap messages store short names and a short single string value in the
+  // attribute block itself, avoiding the string pool and its lock...
+  if (!ipp->arena)
+  {
+    if (name && strlen(name) < _IPP_INLINE_NAME)
+      inline_size += strlen(name) + 1;
+
+    if (num_values == 1 && ((value_tag >= IPP_TAG_TEXTLANG && value_tag <= IPP_TAG_NAMELANG) || (value_tag >= IPP_TAG_TEXT && value_tag <= IPP_TAG_MIMETYPE)))
+      inline_size += _IPP_INLINE_VALUE;
+  }
+
+  alloc_size = sizeof(ipp_attribute_t) + (size_t)(alloc_values - 1) * sizeof(_ipp_value_t) + inline_size;
+  attr       = ipp_calloc(ipp, alloc_size);
 
   if (attr)
   {
     // Initialize attribute...
     DEBUG_printf("4debug_alloc: %p %s %s%s (%u values)", (void *)attr, name, num_values > 1 ? "1setOf " : "", ippTagString(value_tag), (unsigned)num_values);
 
+    attr->alloc_size  = alloc_size;
+    attr->inline_size = (unsigned short)inline_size;
+
     if (name)
-      attr->name = _cupsStrAlloc(name);
+      attr->name = ipp_attr_strdup(ipp, attr, name);
 
     attr->group_tag  = group_tag;
     attr->value_tag  = value_tag;
@@ -5378,6 +5908,9 @@ ipp_add_attr(ipp_t      *ipp,		// I - IPP message
 
     ipp->prev = ipp->last;
     ipp->last = ipp->current = attr;
+
+    ipp->num_attrs ++;
+    ipp_index_add(ipp, attr);
   }
 
   DEBUG_printf("5ipp_add_attr: Returning %p", (void *)attr);
@@ -5387,80 +5920,579 @@ ipp_add_attr(ipp_t      *ipp,		// I - IPP message
 
 
 //
-// 'ipp_free_values()' - Free attribute values.
+// 'ipp_arena_alloc()' - Allocate zeroed memory from an arena.
 //
 
-static void
-ipp_free_values(ipp_attribute_t *attr,	// I - Attribute to free values from
-                size_t          element,// I - First value to free
-                size_t          count)	// I - Number of values to free
+static void *				// O - Pointer to memory or `NULL` on error
+ipp_arena_alloc(_ipp_arena_t *arena,	// I - Arena allocator
+                size_t       size)	// I - Number of bytes
 {
-  size_t	i;			// Looping var
-  _ipp_value_t	*value;			// Current value
+  _ipp_arena_block_t	*block;		// Current block
+  size_t		bsize;		// Size of new block
+  bool			dedicated;	// Dedicated block for a large allocation?
+  void			*ptr;		// Pointer to memory
 
 
-  DEBUG_printf("4ipp_free_values(attr=%p, element=%u, count=%u)", (void *)attr, (unsigned)element, (unsigned)count);
+  // Round the allocation up to keep values aligned...
+  size = (size + _IPP_ARENA_ALIGN - 1) & (size_t)~(_IPP_ARENA_ALIGN - 1);
 
-  if (!(attr->value_tag & IPP_TAG_CUPS_CONST))
+  if ((block = arena->blocks) == NULL || (block->size - block->used) < size)
   {
-    // Free values as needed...
-    switch (attr->value_tag)
+    // Allocate a new block, using a dedicated block for large allocations so
+    // the rest of the current block doesn't go to waste...
+    dedicated = size > (_IPP_ARENA_SIZE / 4);
+    bsize     = dedicated ? size : _IPP_ARENA_SIZE;
+
+    if (!dedicated && arena->spare)
     {
-      case IPP_TAG_TEXTLANG :
-      case IPP_TAG_NAMELANG :
-	  if (element == 0 && count == attr->num_values && attr->values[0].string.language)
-	  {
-	    _cupsStrFree(attr->values[0].string.language);
-	    attr->values[0].string.language = NULL;
-	  }
-	  // Fall through to other string values
+      // Reuse a block kept by ippReset...
+      block        = arena->spare;
+      arena->spare = block->next;
+      block->next  = NULL;
+      block->used  = 0;
 
-      case IPP_TAG_TEXT :
-      case IPP_TAG_NAME :
-      case IPP_TAG_RESERVED_STRING :
-      case IPP_TAG_KEYWORD :
-      case IPP_TAG_URI :
-      case IPP_TAG_URISCHEME :
-      case IPP_TAG_CHARSET :
-      case IPP_TAG_LANGUAGE :
-      case IPP_TAG_MIMETYPE :
-	  for (i = count, value = attr->values + element; i > 0; i --, value ++)
-	  {
-	    _cupsStrFree(value->string.text);
-	    value->string.text = NULL;
-	  }
-	  break;
+      memset(block->data, 0, block->size);
+    }
+    else if ((block = _cupsMemCalloc(CUPS_MEMTYPE_IPP, 1, sizeof(_ipp_arena_block_t) + _IPP_ARENA_ALIGN + bsize)) == NULL)
+    {
+      DEBUG_printf("4ipp_arena_alloc: Unable to allocate %u byte block.", (unsigned)bsize);
+      return (NULL);
+    }
+    else
+    {
+      block->size = bsize;
+      block->data = (unsigned char *)block + ((sizeof(_ipp_arena_block_t) + _IPP_ARENA_ALIGN - 1) & (size_t)~(_IPP_ARENA_ALIGN - 1));
+    }
 
-      case IPP_TAG_UNSUPPORTED_VALUE :
-      case IPP_TAG_DEFAULT :
-      case IPP_TAG_UNKNOWN :
-      case IPP_TAG_NOVALUE :
-      case IPP_TAG_NOTSETTABLE :
-      case IPP_TAG_DELETEATTR :
-      case IPP_TAG_ADMINDEFINE :
-      case IPP_TAG_INTEGER :
-      case IPP_TAG_ENUM :
-      case IPP_TAG_BOOLEAN :
-      case IPP_TAG_DATE :
-      case IPP_TAG_RESOLUTION :
-      case IPP_TAG_RANGE :
-	  break;
+    if (dedicated && arena->blocks)
+    {
+      block->next         = arena->blocks->next;
+      arena->blocks->next = block;
+    }
+    else
+    {
+      block->next   = arena->blocks;
+      arena->blocks = block;
+    }
+  }
 
-      case IPP_TAG_BEGIN_COLLECTION :
-	  for (i = count, value = attr->values + element; i > 0; i --, value ++)
-	  {
-	    ippDelete(value->collection);
-	    value->collection = NULL;
-	  }
-	  break;
+  ptr         = block->data + block->used;
+  block->used += size;
 
-      case IPP_TAG_STRING :
-      default :
-	  for (i = count, value = attr->values + element; i > 0; i --, value ++)
-	  {
+  return (ptr);
+}
+
+
+//
+// 'ipp_arena_release()' - Release a reference to an arena, freeing it when
+//                         no messages are using it.
+//
+
+static void
+ipp_arena_release(_ipp_arena_t *arena)	// I - Arena allocator
+{
+  _ipp_arena_block_t	*block,		// Current block
+			*next;		// Next block
+
+
+  if (cupsAtomicDec(&arena->use) > 0)
+    return;
+
+  DEBUG_printf("4debug_free: %p IPP arena", (void *)arena);
+
+  for (block = arena->blocks; block; block = next)
+  {
+    next = block->next;
+    _cupsMemFree(block);
+  }
+
+  for (block = arena->spare; block; block = next)
+  {
+    next = block->next;
+    _cupsMemFree(block);
+  }
+
+  _cupsMemFree(arena);
+}
+
+
+//
+// 'ipp_arena_reset()' - Rewind an arena allocator after ippReset.
+//
+// The block holding the message itself stays in use, standard blocks are kept
+// as spares for new attributes, and dedicated blocks for large allocations are
+// freed.  Nothing is rewound if a collection from the message is still in use
+// elsewhere.
+//
+
+static void
+ipp_arena_reset(_ipp_arena_t *arena,	// I - Arena allocator
+                ipp_t        *ipp)	// I - IPP message in arena
+{
+  _ipp_arena_block_t	*block,		// Current block
+			*next,		// Next block
+			*mblock = NULL;	// Block holding message
+  size_t		used;		// Bytes used by message
+
+
+  if (cupsAtomicGet(&arena->use) > 1)
+    return;
+
+  for (block = arena->blocks; block; block = next)
+  {
+    next = block->next;
+
+    if ((unsigned char *)ipp >= block->data && (unsigned char *)ipp < (block->data + block->size))
+    {
+      mblock = block;
+    }
+    else if (block->size == _IPP_ARENA_SIZE)
+    {
+      block->next  = arena->spare;
+      arena->spare = block;
+    }
+    else
+    {
+      _cupsMemFree(block);
+    }
+  }
+
+  if ((arena->blocks = mblock) != NULL)
+  {
+    used = (size_t)((unsigned char *)ipp - mblock->data) + ((sizeof(ipp_t) + _IPP_ARENA_ALIGN - 1) & (size_t)~(_IPP_ARENA_ALIGN - 1));
+
+    memset(mblock->data + used, 0, mblock->used - used);
+
+    mblock->next = NULL;
+    mblock->used = used;
+  }
+}
+
+
+//
+// 'ipp_attr_relocate()' - Move inline strings after resizing an attribute.
+//
+// "olddata" points to the old contents of the attribute, which for `realloc`
+// is the start of the new memory, while "oldaddr" is the old address of the
+// attribute used to find pointers to inline strings.
+//
+
+static void
+ipp_attr_relocate(
+    ipp_attribute_t *attr,		// I - Resized attribute
+    const char      *olddata,		// I - Old attribute data
+    uintptr_t       oldaddr,		// I - Old attribute address
+    size_t          alloc_size)		// I - New size of attribute
+{
+  size_t	i;			// Looping var
+  _ipp_value_t	*value;			// Current value
+  uintptr_t	oldinline = oldaddr + attr->alloc_size - attr->inline_size;
+					// Old inline storage address
+  char		*newinline = (char *)attr + alloc_size - attr->inline_size;
+					// New inline storage
+  ipp_tag_t	value_tag = (ipp_tag_t)(attr->value_tag & IPP_TAG_CUPS_MASK);
+					// Value tag
+
+
+  memmove(newinline, olddata + attr->alloc_size - attr->inline_size, attr->inline_size);
+
+  if (attr->name && (uintptr_t)attr->name >= oldinline && (uintptr_t)attr->name < (oldinline + attr->inline_size))
+    attr->name = newinline + ((uintptr_t)attr->name - oldinline);
+
+  if ((value_tag < IPP_TAG_TEXTLANG || value_tag > IPP_TAG_NAMELANG) && (value_tag < IPP_TAG_TEXT || value_tag > IPP_TAG_MIMETYPE))
+    return;
+
+  for (i = attr->num_values, value = attr->values; i > 0; i --, value ++)
+  {
+    if (value->string.text && (uintptr_t)value->string.text >= oldinline && (uintptr_t)value->string.text < (oldinline + attr->inline_size))
+      value->string.text = newinline + ((uintptr_t)value->string.text - oldinline);
+
+    if (value->string.language && (uintptr_t)value->string.language >= oldinline && (uintptr_t)value->string.language < (oldinline + attr->inline_size))
+      value->string.language = newinline + ((uintptr_t)value->string.language - oldinline);
+  }
+}
+
+
+//
+// 'ipp_attr_strdup()' - Copy a string for an attribute.
+//
+// Strings that fit are copied into the attribute's inline storage, otherwise
+// the string is copied using `ipp_strdup`.
+//
+
+static char *				// O - Copy of string or `NULL` on error
+ipp_attr_strdup(ipp_t           *ipp,	// I - IPP message
+                ipp_attribute_t *attr,	// I - Attribute
+                const char      *s)	// I - String to copy
+{
+  size_t	len;			// Length of string
+  char		*temp;			// Copy of string
+
+
+  if (s && attr->inline_size > attr->inline_used && (len = strlen(s) + 1) <= (size_t)(attr->inline_size - attr->inline_used))
+  {
+    temp = (char *)attr + attr->alloc_size - attr->inline_size + attr->inline_used;
+    memcpy(temp, s, len);
+    attr->inline_used += (unsigned short)len;
+
+    return (temp);
+  }
+
+  return (ipp_strdup(ipp, s));
+}
+
+
+//
+// 'ipp_attr_strfree()' - Free a string copied with `ipp_attr_strdup`.
+//
+
+static void
+ipp_attr_strfree(ipp_t           *ipp,	// I - IPP message or `NULL`
+                 ipp_attribute_t *attr,	// I - Attribute
+                 char            *s)	// I - String
+{
+  char	*end = (char *)attr + attr->alloc_size;
+					// End of attribute
+
+
+  // Inline strings are freed with the attribute...
+  if (s >= (end - attr->inline_size) && s < end)
+    return;
+
+  ipp_strfree(ipp, s);
+}
+
+
+//
+// 'ipp_calloc()' - Allocate zeroed memory for a message.
+//
+
+static void *				// O - Pointer to memory or `NULL` on error
+ipp_calloc(ipp_t  *ipp,			// I - IPP message
+           size_t size)			// I - Number of bytes
+{
+  if (ipp && ipp->arena)
+    return (ipp_arena_alloc(ipp->arena, size));
+  else
+    return (_cupsMemCalloc(CUPS_MEMTYPE_IPP, 1, size));
+}
+
+
+//
+// 'ipp_check_keyword()' - Check the characters in a keyword or attribute name.
+//
+// Only ASCII letters, digits, "-", ".", and "_" are allowed, regardless of the
+// current locale.
+//
+
+static const char *			// O - First invalid character or nul
+ipp_check_keyword(const char *s)	// I - String
+{
+  int	ch;				// Current character
+
+
+  for (; *s; s ++)
+  {
+    ch = *s & 255;
+
+    if ((ch < 'a' || ch > 'z') && (ch < 'A' || ch > 'Z') && (ch < '0' || ch > '9') && ch != '-' && ch != '.' && ch != '_')
+      break;
+  }
+
+  return (s);
+}
+
+
+//
+// 'ipp_check_utf8()' - Check the characters in a UTF-8 text or name string.
+//
+// Runs of printable ASCII are checked eight bytes at a time; everything else
+// is checked one character at a time.  Control characters other than CR, LF,
+// and TAB (text) are not allowed.
+//
+
+static const char *			// O - First invalid character or nul
+ipp_check_utf8(const char *s,		// I - String
+               bool       text)		// I - `true` for text, `false` for name
+{
+  const char	*end = s + strlen(s);	// End of string
+  uint64_t	word;			// Eight bytes of string
+
+
+  while (s < end)
+  {
+    if ((end - s) >= 8)
+    {
+      // "word" is printable ASCII if no byte has the high bit set or is less
+      // than 0x20 or is 0x7f...
+      memcpy(&word, s, sizeof(word));
+
+      if (!((word | (word - 0x2020202020202020ULL) | ((word ^ 0x7f7f7f7f7f7f7f7fULL) - 0x0101010101010101ULL)) & 0x8080808080808080ULL))
+      {
+        s += 8;
+        continue;
+      }
+    }
+
+    if ((*s & 0xe0) == 0xc0)
+    {
+      if ((s[1] & 0xc0) != 0x80)
+	break;
+
+      s += 2;
+    }
+    else if ((*s & 0xf0) == 0xe0)
+    {
+      if ((s[1] & 0xc0) != 0x80 || (s[2] & 0xc0) != 0x80)
+	break;
+
+      s += 3;
+    }
+    else if ((*s & 0xf8) == 0xf0)
+    {
+      if ((s[1] & 0xc0) != 0x80 || (s[2] & 0xc0) != 0x80 || (s[3] & 0xc0) != 0x80)
+	break;
+
+      s += 4;
+    }
+    else if (*s & 0x80)
+    {
+      break;
+    }
+    else if ((*s < ' ' && (!text || (*s != '\n' && *s != '\r' && *s != '\t'))) || *s == 0x7f)
+    {
+      break;
+    }
+    else
+    {
+      s ++;
+    }
+  }
+
+  return (s);
+}
+
+
+//
+// 'ipp_compare_attrs()' - Compare the names of two attributes.
+//
+
+static int				// O - Result of comparison
+ipp_compare_attrs(ipp_attribute_t *a,	// I - First attribute
+                  ipp_attribute_t *b,	// I - Second attribute
+                  void            *data)// I - Callback data (unused)
+{
+  (void)data;
+
+  return (strcmp(a->name, b->name));
+}
+
+
+//
+// 'ipp_find_first()' - Find the starting point for a named attribute search.
+//
+// Large messages get a lazily-built index of the first attribute with each
+// name, so the returned attribute is either `NULL` (no match) or the first
+// attribute with the given name.  Otherwise the first attribute in the message
+// is returned and the caller does a linear search.
+//
+
+static ipp_attribute_t *		// O - First attribute to check
+ipp_find_first(ipp_t      *ipp,		// I - IPP message
+               const char *name)	// I - Attribute name
+{
+  ipp_attribute_t	*attr,		// Current attribute
+			key;		// Search key
+
+
+  if (!ipp->index)
+  {
+    if (ipp->num_attrs < _IPP_INDEX_MIN)
+      return (ipp->attrs);
+
+    DEBUG_printf("4ipp_find_first: Building name index for %u attributes.", (unsigned)ipp->num_attrs);
+
+    if ((ipp->index = cupsArrayNew((cups_array_cb_t)ipp_compare_attrs, NULL, (cups_ahash_cb_t)ipp_hash_attr, _IPP_INDEX_HASH, NULL, NULL)) == NULL)
+      return (ipp->attrs);
+
+    for (attr = ipp->attrs; attr; attr = attr->next)
+      ipp_index_add(ipp, attr);
+  }
+
+  key.name = (char *)name;
+
+  return ((ipp_attribute_t *)cupsArrayFind(ipp->index, &key));
+}
+
+
+//
+// 'ipp_find_path()' - Find an attribute matching part of a compiled path.
+//
+
+static ipp_attribute_t *		// O - Matching attribute or `NULL` if none
+ipp_find_path(ipp_t      *ipp,		// I - IPP message
+              ipp_path_t *path,		// I - Compiled path
+              size_t     level,		// I - Current level in path
+              ipp_tag_t  type)		// I - Type of attribute
+{
+  size_t		i;		// Looping var
+  ipp_attribute_t	*attr,		// Current attribute
+			*childattr;	// Child attribute
+  ipp_tag_t		value_tag;	// Value tag
+  const char		*name = path->names[level];
+					// Name at this level
+
+
+  for (attr = ipp_find_first(ipp, name); attr; attr = attr->next)
+  {
+    if (!attr->name || strcmp(attr->name, name))
+      continue;
+
+    value_tag = (ipp_tag_t)(attr->value_tag & IPP_TAG_CUPS_MASK);
+
+    if ((level + 1) < path->num_names)
+    {
+      // Search the member attributes of each collection value...
+      if (value_tag != IPP_TAG_BEGIN_COLLECTION)
+        continue;
+
+      for (i = 0; i < attr->num_values; i ++)
+      {
+        if (attr->values[i].collection && (childattr = ipp_find_path(attr->values[i].collection, path, level + 1, type)) != NULL)
+          return (childattr);
+      }
+    }
+    else if (value_tag == type || type == IPP_TAG_ZERO || (value_tag == IPP_TAG_TEXTLANG && type == IPP_TAG_TEXT) || (value_tag == IPP_TAG_NAMELANG && type == IPP_TAG_NAME))
+    {
+      return (attr);
+    }
+  }
+
+  return (NULL);
+}
+
+
+//
+// 'ipp_free()' - Free memory allocated with `ipp_calloc`.
+//
+// Arena memory is freed when the message is deleted.
+//
+
+static void
+ipp_free(ipp_t *ipp,			// I - IPP message or `NULL`
+         void  *ptr)			// I - Pointer to memory
+{
+  if (!ipp || !ipp->arena)
+    _cupsMemFree(ptr);
+}
+
+
+//
+// 'ipp_free_attrs()' - Free all attributes in a message.
+//
+
+static void
+ipp_free_attrs(ipp_t *ipp)		// I - IPP message
+{
+  ipp_attribute_t	*attr,		// Current attribute
+			*next;		// Next attribute
+
+
+  for (attr = ipp->attrs; attr != NULL; attr = next)
+  {
+    next = attr->next;
+
+    DEBUG_printf("4debug_free: %p %s %s%s (%u values)", (void *)attr, attr->name, attr->num_values > 1 ? "1setOf " : "", ippTagString(attr->value_tag), (unsigned)attr->num_values);
+
+    ipp_free_values(ipp, attr, 0, attr->num_values);
+
+    if (attr->name)
+      ipp_attr_strfree(ipp, attr, attr->name);
+
+    ipp_free(ipp, attr);
+  }
+
+  cupsArrayDelete(ipp->index);
+  ipp_free(ipp, ipp->frozen_data);
+}
+
+
+//
+// 'ipp_free_values()' - Free attribute values.
+//
+
+static void
+ipp_free_values(ipp_t           *ipp,	// I - IPP message or `NULL`
+                ipp_attribute_t *attr,	// I - Attribute to free values from
+                size_t          element,// I - First value to free
+                size_t          count)	// I - Number of values to free
+{
+  size_t	i;			// Looping var
+  _ipp_value_t	*value;			// Current value
+
+
+  DEBUG_printf("4ipp_free_values(attr=%p, element=%u, count=%u)", (void *)attr, (unsigned)element, (unsigned)count);
+
+  if (!(attr->value_tag & IPP_TAG_CUPS_CONST))
+  {
+    // Free values as needed...
+    switch (attr->value_tag)
+    {
+      case IPP_TAG_TEXTLANG :
+      case IPP_TAG_NAMELANG :
+	  if (element == 0 && count == attr->num_values && attr->values[0].string.language)
+	  {
+	    ipp_attr_strfree(ipp, attr, attr->values[0].string.language);
+	    attr->values[0].string.language = NULL;
+	  }
+	  // Fall through to other string values
+
+      case IPP_TAG_TEXT :
+      case IPP_TAG_NAME :
+      case IPP_TAG_RESERVED_STRING :
+      case IPP_TAG_KEYWORD :
+      case IPP_TAG_URI :
+      case IPP_TAG_URISCHEME :
+      case IPP_TAG_CHARSET :
+      case IPP_TAG_LANGUAGE :
+      case IPP_TAG_MIMETYPE :
+	  for (i = count, value = attr->values + element; i > 0; i --, value ++)
+	  {
+	    ipp_attr_strfree(ipp, attr, value->string.text);
+	    value->string.text = NULL;
+	  }
+	  break;
+
+      case IPP_TAG_UNSUPPORTED_VALUE :
+      case IPP_TAG_DEFAULT :
+      case IPP_TAG_UNKNOWN :
+      case IPP_TAG_NOVALUE :
+      case IPP_TAG_NOTSETTABLE :
+      case IPP_TAG_DELETEATTR :
+      case IPP_TAG_ADMINDEFINE :
+      case IPP_TAG_INTEGER :
+      case IPP_TAG_ENUM :
+      case IPP_TAG_BOOLEAN :
+      case IPP_TAG_DATE :
+      case IPP_TAG_RESOLUTION :
+      case IPP_TAG_RANGE :
+	  break;
+
+      case IPP_TAG_BEGIN_COLLECTION :
+	  for (i = count, value = attr->values + element; i > 0; i --, value ++)
+	  {
+	    ippDelete(value->collection);
+	    value->collection = NULL;
+	  }
+	  break;
+
+      case IPP_TAG_STRING :
+      default :
+	  for (i = count, value = attr->values + element; i > 0; i --, value ++)
+	  {
 	    if (value->unknown.data)
 	    {
-	      free(value->unknown.data);
+	      ipp_free(ipp, value->unknown.data);
 	      value->unknown.data = NULL;
 	    }
 	  }
@@ -5468,11 +6500,38 @@ ipp_free_values(ipp_attribute_t *attr,	// I - Attribute to free values from
     }
   }
 
-  // If we are not freeing values from the end, move the remaining values up...
-  if ((element + count) < attr->num_values)
-    memmove(attr->values + element, attr->values + element + count, (size_t)(attr->num_values - count - element) * sizeof(_ipp_value_t));
+  // If we are not freeing values from the end, move the remaining values up...
+  if ((element + count) < attr->num_values)
+    memmove(attr->values + element, attr->values + element + count, (size_t)(attr->num_values - count - element) * sizeof(_ipp_value_t));
+
+  attr->num_values -= count;
+}
+
+
+//
+// 'ipp_freeze()' - Mark a message and its collections as frozen.
+//
+
+static void
+ipp_freeze(ipp_t *ipp)			// I - IPP message or collection
+{
+  ipp_attribute_t	*attr;		// Current attribute
+  size_t		i;		// Looping var
 
-  attr->num_values -= count;
+
+  ipp->frozen = true;
+
+  for (attr = ipp->attrs; attr; attr = attr->next)
+  {
+    if ((attr->value_tag & IPP_TAG_CUPS_MASK) == IPP_TAG_BEGIN_COLLECTION)
+    {
+      for (i = 0; i < attr->num_values; i ++)
+      {
+        if (attr->values[i].collection && !attr->values[i].collection->frozen)
+          ipp_freeze(attr->values[i].collection);
+      }
+    }
+  }
 }
 
 
@@ -5507,6 +6566,97 @@ ipp_get_code(const char *value,		// I - Locale/charset string
 }
 
 
+//
+// 'ipp_hash_attr()' - Compute the name index hash for an attribute.
+//
+
+static size_t				// O - Hash value
+ipp_hash_attr(ipp_attribute_t *attr,	// I - Attribute
+              void            *data)	// I - Callback data (unused)
+{
+  size_t	hash;			// Hash value
+  const char	*nameptr;		// Pointer into name
+
+
+  (void)data;
+
+  for (hash = 0, nameptr = attr->name; *nameptr; nameptr ++)
+    hash = 31 * hash + (unsigned char)*nameptr;
+
+  return (hash % _IPP_INDEX_HASH);
+}
+
+
+//
+// 'ipp_index_add()' - Add an attribute to the name index, if any.
+//
+// Only the first attribute with a given name is indexed.
+//
+
+static void
+ipp_index_add(ipp_t           *ipp,	// I - IPP message
+              ipp_attribute_t *attr)	// I - Attribute
+{
+  if (ipp->index && attr->name && !cupsArrayFind(ipp->index, attr))
+    cupsArrayAdd(ipp->index, attr);
+}
+
+
+//
+// 'ipp_index_clear()' - Clear the name index so it is rebuilt when needed.
+//
+
+static void
+ipp_index_clear(ipp_t *ipp)		// I - IPP message
+{
+  if (ipp->index)
+  {
+    DEBUG_puts("4ipp_index_clear: Clearing name index.");
+
+    cupsArrayDelete(ipp->index);
+    ipp->index = NULL;
+  }
+}
+
+
+//
+// 'ipp_init_request()' - Initialize a new IPP request message.
+//
+
+static ipp_t *				// O - IPP request message
+ipp_init_request(ipp_t    *request,	// I - New IPP message
+                 ipp_op_t op)		// I - Operation code
+{
+  cups_lang_t	*language;		// Current language localization
+  static int	request_id = 0;		// Current request ID
+  static cups_mutex_t request_mutex = CUPS_MUTEX_INITIALIZER;
+					// Mutex for request ID
+
+
+  if (!request)
+    return (NULL);
+
+  // Set the operation and request ID...
+  cupsMutexLock(&request_mutex);
+
+  request->request.op.operation_id = op;
+  request->request.op.request_id   = ++request_id;
+
+  cupsMutexUnlock(&request_mutex);
+
+  // Use UTF-8 as the character set...
+  ippAddString(request, IPP_TAG_OPERATION, IPP_CONST_TAG(IPP_TAG_CHARSET), "attributes-charset", NULL, "utf-8");
+
+  // Get the language from the current locale...
+  language = cupsLangDefault();
+
+  ippAddString(request, IPP_TAG_OPERATION, IPP_CONST_TAG(IPP_TAG_LANGUAGE), "attributes-natural-language", NULL, cupsLangGetName(language));
+
+  // Return the new request...
+  return (request);
+}
+
+
 //
 // 'ipp_lang_code()' - Convert a C locale name into an IPP language code.
 //
@@ -5543,6 +6693,7 @@ ipp_length(ipp_t *ipp,			// I - IPP message or collection
   ipp_attribute_t	*attr;		// Current attribute
   ipp_tag_t		group;		// Current group
   _ipp_value_t		*value;		// Current value
+  bool			nested = false;	// Any collection values?
 
 
   DEBUG_printf("3ipp_length(ipp=%p, collection=%d)", (void *)ipp, collection);
@@ -5553,6 +6704,13 @@ ipp_length(ipp_t *ipp,			// I - IPP message or collection
     return (0);
   }
 
+  // Use the cached length if nothing has changed...
+  if (ipp_length_cached(ipp, collection != 0))
+  {
+    DEBUG_printf("4ipp_length: Returning " CUPS_LLFMT " bytes (cached)", CUPS_LLCAST ipp->length);
+    return (ipp->length);
+  }
+
   // Start with 8 bytes for the IPP message header...
   bytes = collection ? 0 : 8;
 
@@ -5654,6 +6812,8 @@ ipp_length(ipp_t *ipp,			// I - IPP message or collection
       case IPP_TAG_BEGIN_COLLECTION :
 	  for (i = 0, value = attr->values; i < attr->num_values; i ++, value ++)
             bytes += ipp_length(value->collection, 1);
+
+          nested = true;
 	  break;
 
       default :
@@ -5671,10 +6831,115 @@ ipp_length(ipp_t *ipp,			// I - IPP message or collection
 
   DEBUG_printf("4ipp_length: Returning " CUPS_LLFMT " bytes", CUPS_LLCAST bytes);
 
+  ipp->length        = bytes;
+  ipp->length_col    = collection != 0;
+  ipp->length_nested = nested;
+  ipp->length_valid  = true;
+
   return (bytes);
 }
 
 
+//
+// 'ipp_length_cached()' - Determine whether the cached length is valid.
+//
+// Changes to the message itself clear the cached length, so the check is
+// constant time for frozen messages and for messages without collection
+// values.  Collections can be changed independently of the (possibly several)
+// messages that contain them, so otherwise the attributes are scanned to check
+// that the cached lengths of the collection values are valid, too.  That scan
+// is still much cheaper than recomputing the length.
+//
+
+static bool				// O - `true` if valid, `false` otherwise
+ipp_length_cached(ipp_t *ipp,		// I - IPP message or collection
+                  bool  collection)	// I - `true` if a collection, `false` otherwise
+{
+  ipp_attribute_t	*attr;		// Current attribute
+  size_t		i;		// Looping var
+
+
+  if (!ipp->length_valid || ipp->length_col != collection)
+    return (false);
+  else if (ipp->frozen || !ipp->length_nested)
+    return (true);
+
+  for (attr = ipp->attrs; attr; attr = attr->next)
+  {
+    if ((attr->value_tag & IPP_TAG_CUPS_MASK) == IPP_TAG_BEGIN_COLLECTION)
+    {
+      for (i = 0; i < attr->num_values; i ++)
+      {
+        if (attr->values[i].collection && !ipp_length_cached(attr->values[i].collection, true))
+          return (false);
+      }
+    }
+  }
+
+  return (true);
+}
+
+
+//
+// 'ipp_new()' - Allocate a new IPP message, optionally using an arena.
+//
+
+static ipp_t *				// O - New IPP message
+ipp_new(_ipp_arena_t *arena)		// I - Arena allocator or `NULL` for heap
+{
+  ipp_t			*temp;		// New IPP message
+  _cups_globals_t	*cg = _cupsGlobals();
+					// Global data
+
+
+  if (arena)
+    temp = (ipp_t *)ipp_arena_alloc(arena, sizeof(ipp_t));
+  else
+    temp = (ipp_t *)_cupsMemCalloc(CUPS_MEMTYPE_IPP, 1, sizeof(ipp_t));
+
+  if (temp)
+  {
+    // Set default version - usually 2.0...
+    DEBUG_printf("4debug_alloc: %p IPP message", (void *)temp);
+
+    if (cg->server_version == 0)
+      _cupsSetDefaults();
+
+    temp->request.any.version[0] = (ipp_uchar_t)(cg->server_version / 10);
+    temp->request.any.version[1] = (ipp_uchar_t)(cg->server_version % 10);
+    temp->use                    = 1;
+    temp->find                   = temp->fstack;
+
+    if ((temp->arena = arena) != NULL)
+      cupsAtomicInc(&arena->use);
+  }
+
+  return (temp);
+}
+
+
+//
+// 'ipp_read_buffer()' - Read IPP data from a memory buffer.
+//
+
+static ssize_t				// O - Number of bytes read
+ipp_read_buffer(_ipp_buffer_t *buf,	// I - Memory buffer
+                ipp_uchar_t   *buffer,	// O - Read buffer
+                size_t        length)	// I - Number of bytes to read
+{
+  size_t	count;			// Number of bytes available
+
+
+  if ((count = (size_t)(buf->end - buf->ptr)) > length)
+    count = length;
+
+  memcpy(buffer, buf->ptr, count);
+  buf->ptr += count;
+
+  return ((ssize_t)count);
+}
+
+
 //
 // 'ipp_read_http()' - Semi-blocking read on a HTTP connection...
 //
@@ -5763,6 +7028,34 @@ ipp_read_file(int         *fd,		// I - File descriptor
 }
 
 
+//
+// 'ipp_regcomp()' - Compile a regular expression once.
+//
+// Compiled expressions are kept for the life of the process since regexec is
+// safe to use from multiple threads.
+//
+
+static int				// O - 0 on success, regcomp() error otherwise
+ipp_regcomp(regex_t    *re,		// I - Regular expression
+            int        *status,		// I - regcomp() status, -1 if not compiled
+            const char *pattern)	// I - Pattern
+{
+  int	r;				// Return value
+
+
+  cupsMutexLock(&ipp_regex_mutex);
+
+  if (*status < 0)
+    *status = regcomp(re, pattern, REG_NOSUB | REG_EXTENDED);
+
+  r = *status;
+
+  cupsMutexUnlock(&ipp_regex_mutex);
+
+  return (r);
+}
+
+
 //
 // 'ipp_set_error()' - Set a formatted, localized error string.
 //
@@ -5799,11 +7092,21 @@ ipp_set_value(ipp_t           *ipp,	// IO - IPP message
   ipp_attribute_t	*temp,		// New attribute pointer
 			*current,	// Current attribute in list
 			*prev;		// Previous attribute in list
-  size_t		alloc_values;	// Allocated values
+  size_t		alloc_values,	// Allocated values
+			alloc_size;	// Allocated size
+  uintptr_t		oldaddr;	// Old address of attribute
+  bool			indexed;	// Is the attribute in the name index?
+
 
+  // Frozen messages cannot be changed...
+  if (ipp->frozen)
+    return (NULL);
+
+  ipp->length_valid = false;
 
   // If we are setting an existing value element, return it...
-  temp = *attr;
+  temp          = *attr;
+  temp->encoded = NULL;
 
   if (temp->num_values <= 1)
     alloc_values = 1;
@@ -5825,17 +7128,55 @@ ipp_set_value(ipp_t           *ipp,	// IO - IPP message
   else
     alloc_values += IPP_MAX_VALUES;
 
+  alloc_size = sizeof(ipp_attribute_t) + (size_t)(alloc_values - 1) * sizeof(_ipp_value_t) + temp->inline_size;
+
+  if (alloc_size <= temp->alloc_size)
+  {
+    // Values were deleted previously, so there is still room for them...
+    memset(temp->values + temp->num_values, 0, (size_t)(element + 1 - temp->num_values) * sizeof(_ipp_value_t));
+    temp->num_values = element + 1;
+
+    return (temp->values + element);
+  }
+
   DEBUG_printf("4ipp_set_value: Reallocating for up to %u values.", (unsigned)alloc_values);
 
+  // Pull the attribute from the name index since its address may change...
+  indexed = ipp->index && temp->name && cupsArrayFind(ipp->index, temp) == temp;
+
+  if (indexed)
+    cupsArrayRemove(ipp->index, temp);
+
   // Reallocate memory...
-  if ((temp = realloc(temp, sizeof(ipp_attribute_t) + (size_t)(alloc_values - 1) * sizeof(_ipp_value_t))) == NULL)
+  oldaddr = (uintptr_t)temp;
+
+  if (ipp->arena)
+  {
+    // Arena memory cannot be resized, so copy the attribute to a new chunk...
+    if ((temp = ipp_arena_alloc(ipp->arena, alloc_size)) != NULL)
+      memcpy(temp, *attr, sizeof(ipp_attribute_t) + (size_t)((*attr)->num_values > 0 ? (*attr)->num_values - 1 : 0) * sizeof(_ipp_value_t));
+  }
+  else
+  {
+    temp = _cupsMemRealloc(CUPS_MEMTYPE_IPP, temp, alloc_size);
+  }
+
+  if (!temp)
   {
+    if (indexed)
+      cupsArrayAdd(ipp->index, *attr);
+
     _cupsSetHTTPError(HTTP_STATUS_ERROR);
     DEBUG_puts("4ipp_set_value: Unable to resize attribute.");
     return (NULL);
   }
 
-  // Zero the new memory...
+  // Move any inline strings to the end of the new memory and zero the rest...
+  if (temp->inline_size)
+    ipp_attr_relocate(temp, ipp->arena ? (char *)*attr : (char *)temp, oldaddr, alloc_size);
+
+  temp->alloc_size = alloc_size;
+
   memset(temp->values + temp->num_values, 0, (size_t)(alloc_values - temp->num_values) * sizeof(_ipp_value_t));
 
   if (temp != *attr)
@@ -5881,6 +7222,9 @@ ipp_set_value(ipp_t           *ipp,	// IO - IPP message
     *attr = temp;
   }
 
+  if (indexed)
+    cupsArrayAdd(ipp->index, temp);
+
   // Return the value element...
   if (element >= temp->num_values)
     temp->num_values = element + 1;
@@ -5889,6 +7233,102 @@ ipp_set_value(ipp_t           *ipp,	// IO - IPP message
 }
 
 
+//
+// 'ipp_strdup()' - Copy a string for a message.
+//
+// Strings in heap messages come from the shared string pool, while strings in
+// arena messages are copied into the arena.
+//
+
+static char *				// O - Copy of string or `NULL` on error
+ipp_strdup(ipp_t      *ipp,		// I - IPP message
+           const char *s)		// I - String to copy
+{
+  size_t	len;			// Length of string
+  char		*temp;			// Copy of string
+
+
+  if (!ipp || !ipp->arena)
+    return (_cupsStrAlloc(s));
+
+  if (!s)
+    return (NULL);
+
+  len = strlen(s) + 1;
+
+  if ((temp = ipp_arena_alloc(ipp->arena, len)) != NULL)
+    memcpy(temp, s, len);
+
+  return (temp);
+}
+
+
+//
+// 'ipp_stream_attr()' - Deliver a completed attribute to the streaming callback.
+//
+// The attribute is deleted from the message after the callback returns.
+//
+
+static bool				// O - `true` to continue, `false` to stop
+ipp_stream_attr(ipp_t           *ipp,	// I - IPP message
+                ipp_attribute_t *attr)	// I - Completed attribute
+{
+  bool	ret;				// Return value
+
+
+  DEBUG_printf("3ipp_stream_attr(ipp=%p, attr=%p(%s))", (void *)ipp, (void *)attr, attr->name);
+
+  ret = (ipp->stream_cb)(ipp->stream_data, attr->group_tag, attr);
+
+  ippDeleteAttribute(ipp, attr);
+
+  ipp->current = NULL;
+  ipp->prev    = ipp->last;
+
+  return (ret);
+}
+
+
+//
+// 'ipp_strfree()' - Free a string copied with `ipp_strdup`.
+//
+
+static void
+ipp_strfree(ipp_t *ipp,			// I - IPP message or `NULL`
+            char  *s)			// I - String
+{
+  if (!ipp || !ipp->arena)
+    _cupsStrFree(s);
+}
+
+
+//
+// 'ipp_write_batch()' - Add IPP data to a batched write buffer.
+//
+
+static ssize_t				// O - Number of bytes written
+ipp_write_batch(_ipp_wbuffer_t *wbuf,	// I - Write buffer
+                ipp_uchar_t    *buffer,	// I - Data to write
+                size_t         length)	// I - Number of bytes to write
+{
+  if (length > (size_t)(wbuf->end - wbuf->ptr))
+  {
+    // Not enough room, flush what we have...
+    if (!wbuf->cb || !ipp_write_flush(wbuf))
+      return (-1);
+
+    // Then write large blocks directly...
+    if (length >= (size_t)(wbuf->end - wbuf->start))
+      return ((wbuf->cb)(wbuf->dst, buffer, length));
+  }
+
+  memcpy(wbuf->ptr, buffer, length);
+  wbuf->ptr += length;
+
+  return ((ssize_t)length);
+}
+
+
 //
 // 'ipp_write_file()' - Write IPP data to a file.
 //
@@ -5904,3 +7344,22 @@ ipp_write_file(int         *fd,		// I - File descriptor
   return (write(*fd, buffer, length));
 #endif // _WIN32
 }
+
+
+//
+// 'ipp_write_flush()' - Flush a batched write buffer.
+//
+
+static bool				// O - `true` on success, `false` on error
+ipp_write_flush(_ipp_wbuffer_t *wbuf)	// I - Write buffer
+{
+  if (wbuf->cb && wbuf->ptr > wbuf->start)
+  {
+    if ((wbuf->cb)(wbuf->dst, wbuf->start, (size_t)(wbuf->ptr - wbuf->start)) < 0)
+      return (false);
+
+    wbuf->ptr = wbuf->start;
+  }
+
+  return (true);
+}
@@ -494,6 +494,7 @@ typedef unsigned char ipp_uchar_t;	// Unsigned 8-bit integer/character
 typedef struct _ipp_s ipp_t;		// IPP request/response data
 typedef struct _ipp_attribute_s ipp_attribute_t;
 					// IPP attribute
+typedef struct _ipp_path_s ipp_path_t;	// Compiled IPP attribute path
 
 typedef struct _ipp_file_s ipp_file_t;	// IPP data file
 typedef bool (*ipp_fattr_cb_t)(ipp_file_t *file, void *cb_data, const char *name);
@@ -508,6 +509,8 @@ typedef ssize_t	(*ipp_io_cb_t)(void *context, ipp_uchar_t *buffer, size_t bytes)
 
 typedef bool (*ipp_copy_cb_t)(void *context, ipp_t *dst, ipp_attribute_t *attr);
                                         // ippCopyAttributes callback function
+typedef bool (*ipp_stream_cb_t)(void *cb_data, ipp_tag_t group, ipp_attribute_t *attr);
+					// ippReadIOStream callback function
 
 
 //
@@ -535,6 +538,7 @@ extern ipp_attribute_t	*ippAddStringfv(ipp_t *ipp, ipp_tag_t group, ipp_tag_t va
 extern ipp_attribute_t	*ippAddStrings(ipp_t *ipp, ipp_tag_t group, ipp_tag_t value_tag, const char *name,  size_t num_values, const char *language, const char * const *values) _CUPS_PUBLIC;
 extern size_t		ippAttributeString(ipp_attribute_t *attr, char *buffer, size_t bufsize) _CUPS_PUBLIC;
 
+extern ipp_path_t	*ippCompilePath(const char *name) _CUPS_PUBLIC;
 extern bool		ippContainsInteger(ipp_attribute_t *attr, int value) _CUPS_PUBLIC;
 extern bool		ippContainsString(ipp_attribute_t *attr, const char *value) _CUPS_PUBLIC;
 extern ipp_attribute_t	*ippCopyAttribute(ipp_t *dst, ipp_attribute_t *attr, bool quickcopy) _CUPS_PUBLIC;
@@ -545,6 +549,7 @@ extern cups_array_t	*ippCreateRequestedArray(ipp_t *request) _CUPS_PUBLIC;
 extern time_t		ippDateToTime(const ipp_uchar_t *date) _CUPS_PUBLIC;
 extern void		ippDelete(ipp_t *ipp) _CUPS_PUBLIC;
 extern void		ippDeleteAttribute(ipp_t *ipp, ipp_attribute_t *attr) _CUPS_PUBLIC;
+extern void		ippDeletePath(ipp_path_t *path) _CUPS_PUBLIC;
 extern bool		ippDeleteValues(ipp_t *ipp, ipp_attribute_t **attr, size_t element, size_t count) _CUPS_PUBLIC;
 
 extern const char	*ippEnumString(const char *attrname, int enumvalue) _CUPS_PUBLIC;
@@ -577,6 +582,8 @@ extern bool		ippFileWriteToken(ipp_file_t *file, const char *token) _CUPS_PUBLIC
 extern bool		ippFileWriteTokenf(ipp_file_t *file, const char *token, ...) _CUPS_FORMAT(2,3) _CUPS_PUBLIC;
 extern ipp_attribute_t	*ippFindAttribute(ipp_t *ipp, const char *name, ipp_tag_t value_tag) _CUPS_PUBLIC;
 extern ipp_attribute_t	*ippFindNextAttribute(ipp_t *ipp, const char *name, ipp_tag_t value_tag) _CUPS_PUBLIC;
+extern ipp_attribute_t	*ippFindPath(ipp_t *ipp, ipp_path_t *path, ipp_tag_t type) _CUPS_PUBLIC;
+extern bool		ippFreeze(ipp_t *ipp) _CUPS_PUBLIC;
 
 extern bool		ippGetBoolean(ipp_attribute_t *attr, size_t element) _CUPS_PUBLIC;
 extern ipp_t		*ippGetCollection(ipp_attribute_t *attr, size_t element) _CUPS_PUBLIC;
@@ -601,15 +608,21 @@ extern ipp_tag_t	ippGetValueTag(ipp_attribute_t *attr) _CUPS_PUBLIC;
 extern int		ippGetVersion(ipp_t *ipp, int *minor) _CUPS_PUBLIC;
 
 extern ipp_t		*ippNew(void) _CUPS_PUBLIC;
+extern ipp_t		*ippNewArena(void) _CUPS_PUBLIC;
 extern ipp_t		*ippNewRequest(ipp_op_t op) _CUPS_PUBLIC;
+extern ipp_t		*ippNewRequestArena(ipp_op_t op) _CUPS_PUBLIC;
 extern ipp_t		*ippNewResponse(ipp_t *request) _CUPS_PUBLIC;
 
 extern const char	*ippOpString(ipp_op_t op) _CUPS_PUBLIC;
 extern ipp_op_t		ippOpValue(const char *name) _CUPS_PUBLIC;
 
 extern ipp_state_t	ippRead(http_t *http, ipp_t *ipp) _CUPS_PUBLIC;
+extern ipp_state_t	ippReadBuffer(const void *data, size_t datalen, ipp_t *ipp) _CUPS_PUBLIC;
 extern ipp_state_t	ippReadFile(int fd, ipp_t *ipp) _CUPS_PUBLIC;
 extern ipp_state_t	ippReadIO(void *src, ipp_io_cb_t cb, bool blocking, ipp_t *parent, ipp_t *ipp) _CUPS_PUBLIC;
+extern ipp_state_t	ippReadIOStream(void *src, ipp_io_cb_t cb, bool blocking, ipp_t *ipp, ipp_stream_cb_t stream_cb, void *stream_data) _CUPS_PUBLIC;
+extern ipp_state_t	ippReadStream(http_t *http, ipp_t *ipp, ipp_stream_cb_t stream_cb, void *stream_data) _CUPS_PUBLIC;
+extern void		ippReset(ipp_t *ipp) _CUPS_PUBLIC;
 extern void		ippRestore(ipp_t *ipp) _CUPS_PUBLIC;
 
 extern void		ippSave(ipp_t *ipp) _CUPS_PUBLIC;
@@ -642,6 +655,7 @@ extern bool		ippValidateAttribute(ipp_attribute_t *attr) _CUPS_PUBLIC;
 extern bool		ippValidateAttributes(ipp_t *ipp) _CUPS_PUBLIC;
 
 extern ipp_state_t	ippWrite(http_t *http, ipp_t *ipp) _CUPS_PUBLIC;
+extern bool		ippWriteBuffer(ipp_t *ipp, void **data, size_t *datalen) _CUPS_PUBLIC;
 extern ipp_state_t	ippWriteFile(int fd, ipp_t *ipp) _CUPS_PUBLIC;
 extern ipp_state_t	ippWriteIO(void *dst, ipp_io_cb_t cb, bool blocking, ipp_t *parent, ipp_t *ipp) _CUPS_PUBLIC;
 
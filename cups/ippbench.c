@@ -0,0 +1,1054 @@
+//
+// IPP benchmark program for CUPS.
+//
+// Copyright © 2026 by OpenPrinting.
+//
+// Licensed under Apache License v2.0.  See the file "LICENSE" for more
+// information.
+//
+// Usage:
+//
+//   ./ippbench [--csv] [-j JOBS] [-m MEDIA] [-t SECONDS]
+//   ./ippbench [--csv] [-n ITERATIONS] SEED-FILE-OR-DIRECTORY ...
+//
+
+#include <config.h>
+#include <cups/cups.h>
+#include <cups/dir.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+#  include <malloc.h>
+#  define HAVE_MALLINFO2 1
+#endif // __GLIBC__ >= 2.33
+
+
+//
+// Local types...
+//
+
+typedef struct _ippbench_buffer_s	// Memory buffer for I/O
+{
+  ipp_uchar_t	*data;			// Data
+  size_t	datalen,		// Length of data
+		datasize,		// Size of data buffer
+		pos;			// Current read position
+} _ippbench_buffer_t;
+
+typedef struct _ippbench_msg_s		// Benchmark message
+{
+  const char	*name;			// Name of message
+  ipp_t		*ipp;			// Message
+  _ippbench_buffer_t buffer;		// Encoded message
+  size_t	num_names;		// Number of attribute names
+  const char	**names;		// Attribute names for find test
+} _ippbench_msg_t;
+
+typedef struct _ippbench_seed_s		// Corpus seed results
+{
+  const char	*filename;		// Seed filename
+  size_t	bytes,			// Size of seed
+		heap;			// Heap bytes used by decoded message
+  bool		valid;			// Did the seed decode?
+  double	p50,			// Median time in seconds
+		p99,			// 99th percentile time in seconds
+		cost;			// Median time per byte
+} _ippbench_seed_t;
+
+typedef enum _ippbench_test_e		// Benchmark tests
+{
+  _IPPBENCH_ENCODE,			// ippWriteIO
+  _IPPBENCH_DECODE,			// ippReadIO
+  _IPPBENCH_COPY,			// ippCopyAttributes
+  _IPPBENCH_FIND,			// ippFindAttribute
+  _IPPBENCH_MAX
+} _ippbench_test_t;
+
+
+//
+// Local globals...
+//
+
+static const char * const bench_tests[] =
+{					// Test names
+  "encode",
+  "decode",
+  "copy",
+  "find"
+};
+
+
+//
+// Local functions...
+//
+
+static bool	add_seeds(cups_array_t *seeds, const char *path);
+static int	bench_corpus(cups_array_t *seeds, size_t iterations, bool csv);
+static ssize_t	bench_read_cb(_ippbench_buffer_t *buffer, ipp_uchar_t *data, size_t bytes);
+static bool	bench_run(_ippbench_msg_t *msg, _ippbench_test_t test, size_t *heap);
+static ssize_t	bench_write_cb(_ippbench_buffer_t *buffer, ipp_uchar_t *data, size_t bytes);
+static int	compare_doubles(const double *a, const double *b);
+static ipp_t	*create_get_jobs(int num_jobs);
+static ipp_t	*create_get_printer_attributes(void);
+static ipp_t	*create_media_col(const char *size_name, int width, int length, const char *source, const char *type, int margin, bool deep);
+static ipp_t	*create_media_col_database(int num_media);
+static ipp_t	*create_response(void);
+static size_t	get_heap(void);
+static double	get_time(void);
+static void	init_msg(_ippbench_msg_t *msg, const char *name, ipp_t *ipp);
+static int	usage(FILE *out);
+
+
+//
+// 'main()' - Benchmark the IPP encode/decode/copy/find functions.
+//
+
+int					// O - Exit status
+main(int  argc,				// I - Number of command-line args
+     char *argv[])			// I - Command-line arguments
+{
+  int			i;		// Looping var
+  bool			csv = false;	// Produce CSV output?
+  int			num_jobs = 100,	// Number of jobs in Get-Jobs response
+			num_media = 100,// Number of media-col-database values
+			iterations = 100;
+					// Number of iterations per seed
+  cups_array_t		*seeds = NULL;	// Seed files
+  double		duration = 1.0;	// Minimum duration of each test
+  _ippbench_msg_t	msgs[3];	// Benchmark messages
+  size_t		m;		// Current message
+  _ippbench_test_t	test;		// Current test
+  size_t		count,		// Number of messages processed
+			heap;		// Heap usage per message
+  double		start,		// Start time
+			secs;		// Elapsed time
+
+
+  // Parse command-line...
+  for (i = 1; i < argc; i ++)
+  {
+    if (!strcmp(argv[i], "--csv"))
+    {
+      csv = true;
+    }
+    else if (!strcmp(argv[i], "--help"))
+    {
+      return (usage(stdout));
+    }
+    else if (!strcmp(argv[i], "-j") && (i + 1) < argc)
+    {
+      i ++;
+      if ((num_jobs = atoi(argv[i])) < 1)
+        return (usage(stderr));
+    }
+    else if (!strcmp(argv[i], "-m") && (i + 1) < argc)
+    {
+      i ++;
+      if ((num_media = atoi(argv[i])) < 1)
+        return (usage(stderr));
+    }
+    else if (!strcmp(argv[i], "-n") && (i + 1) < argc)
+    {
+      i ++;
+      if ((iterations = atoi(argv[i])) < 1)
+        return (usage(stderr));
+    }
+    else if (!strcmp(argv[i], "-t") && (i + 1) < argc)
+    {
+      i ++;
+      if ((duration = atof(argv[i])) <= 0.0)
+        return (usage(stderr));
+    }
+    else if (argv[i][0] != '-')
+    {
+      if (!seeds)
+        seeds = cupsArrayNewStrings(NULL, '\0');
+
+      if (!add_seeds(seeds, argv[i]))
+        return (1);
+    }
+    else
+    {
+      return (usage(stderr));
+    }
+  }
+
+  // Benchmark the seed corpus, if any...
+  if (seeds)
+  {
+    i = bench_corpus(seeds, (size_t)iterations, csv);
+
+    cupsArrayDelete(seeds);
+
+    return (i);
+  }
+
+  // Create the test messages...
+  init_msg(msgs + 0, "get-printer-attributes", create_get_printer_attributes());
+  init_msg(msgs + 1, "get-jobs", create_get_jobs(num_jobs));
+  init_msg(msgs + 2, "media-col-database", create_media_col_database(num_media));
+
+  // Run the tests...
+  if (csv)
+    puts("message,test,bytes,attrs,count,seconds,msgs_per_sec,bytes_per_sec,heap_per_msg");
+  else
+    printf("%-24s %-6s %8s %10s %10s %12s %10s\n", "Message", "Test", "Bytes", "Count", "Msgs/sec", "MBytes/sec", "Heap/msg");
+
+  for (m = 0; m < (sizeof(msgs) / sizeof(msgs[0])); m ++)
+  {
+    for (test = _IPPBENCH_ENCODE; test < _IPPBENCH_MAX; test ++)
+    {
+      // Measure heap usage for a single message, then repeat the test until
+      // the minimum duration has passed...
+      if (!bench_run(msgs + m, test, &heap))
+      {
+        fprintf(stderr, "ippbench: %s %s failed: %s\n", msgs[m].name, bench_tests[test], cupsGetErrorString());
+        return (1);
+      }
+
+      count = 0;
+      start = get_time();
+
+      do
+      {
+        for (i = 0; i < 10; i ++)
+          bench_run(msgs + m, test, NULL);
+
+        count += 10;
+        secs  = get_time() - start;
+      }
+      while (secs < duration);
+
+      if (csv)
+        printf("%s,%s,%u,%u,%u,%.6f,%.1f,%.1f,%u\n", msgs[m].name, bench_tests[test], (unsigned)msgs[m].buffer.datalen, (unsigned)msgs[m].num_names, (unsigned)count, secs, count / secs, count * msgs[m].buffer.datalen / secs, (unsigned)heap);
+      else
+        printf("%-24s %-6s %8u %10u %10.1f %12.3f %10u\n", msgs[m].name, bench_tests[test], (unsigned)msgs[m].buffer.datalen, (unsigned)count, count / secs, count * msgs[m].buffer.datalen / secs / 1048576.0, (unsigned)heap);
+    }
+  }
+
+  // Free memory and return...
+  for (m = 0; m < (sizeof(msgs) / sizeof(msgs[0])); m ++)
+  {
+    ippDelete(msgs[m].ipp);
+    free(msgs[m].buffer.data);
+    free(msgs[m].names);
+  }
+
+  return (0);
+}
+
+
+//
+// 'add_seeds()' - Add a seed file or a directory of seed files.
+//
+
+static bool				// O - `true` on success, `false` on error
+add_seeds(cups_array_t *seeds,		// I - Seed files
+          const char   *path)		// I - File or directory
+{
+  cups_dir_t	*dir;			// Directory
+  cups_dentry_t	*dent;			// Directory entry
+  char		filename[1024];		// Seed filename
+
+
+  if ((dir = cupsDirOpen(path)) == NULL)
+  {
+    // Not a directory, add as a file...
+    return (cupsArrayAdd(seeds, (void *)path));
+  }
+
+  while ((dent = cupsDirReadName(dir)) != NULL)
+  {
+    if (dent->filename[0] == '.' || !S_ISREG(dent->fileinfo.st_mode))
+      continue;
+
+    snprintf(filename, sizeof(filename), "%s/%s", path, dent->filename);
+    cupsArrayAdd(seeds, filename);
+  }
+
+  cupsDirClose(dir);
+
+  return (true);
+}
+
+
+//
+// 'bench_corpus()' - Decode and re-encode each seed, reporting the latency.
+//
+// A seed is reported as "slow" when its median time per byte is more than ten
+// times the median for the whole corpus, which catches inputs that take
+// superlinear time to decode or encode.
+//
+
+static int				// O - Exit status
+bench_corpus(cups_array_t *seeds,	// I - Seed files
+             size_t       iterations,	// I - Number of iterations per seed
+             bool         csv)		// I - Produce CSV output?
+{
+  int			ret = 0;	// Exit status
+  size_t		i,		// Looping var
+			num_seeds = cupsArrayGetCount(seeds);
+					// Number of seeds
+  _ippbench_seed_t	*results,	// Seed results
+			*result;	// Current result
+  double		*times,		// Times for each iteration
+			*costs,		// Sorted costs for each seed
+			median,		// Median cost for corpus
+			start;		// Start time
+  const char		*filename;	// Current seed filename
+  cups_file_t		*fp;		// Seed file
+  _ippbench_buffer_t	seed,		// Seed data
+			buffer;		// Encoded message
+  ssize_t		bytes;		// Bytes read
+  size_t		heap;		// Starting heap usage
+  ipp_t			*ipp;		// Decoded message
+
+
+  results = calloc(num_seeds, sizeof(_ippbench_seed_t));
+  costs   = calloc(num_seeds, sizeof(double));
+  times   = calloc(iterations, sizeof(double));
+
+  if (!results || !costs || !times)
+  {
+    perror("ippbench: Unable to allocate memory");
+    return (1);
+  }
+
+  memset(&seed, 0, sizeof(seed));
+  memset(&buffer, 0, sizeof(buffer));
+
+  for (filename = (const char *)cupsArrayGetFirst(seeds), result = results; filename; filename = (const char *)cupsArrayGetNext(seeds), result ++)
+  {
+    // Load the seed into memory...
+    if ((fp = cupsFileOpen(filename, "r")) == NULL)
+    {
+      fprintf(stderr, "ippbench: %s: %s\n", filename, cupsGetErrorString());
+      ret = 1;
+      break;
+    }
+
+    seed.datalen = 0;
+
+    do
+    {
+      if (seed.datalen >= seed.datasize)
+      {
+        seed.datasize += 65536;
+
+        if ((seed.data = realloc(seed.data, seed.datasize)) == NULL)
+        {
+	  perror("ippbench: Unable to allocate memory");
+	  exit(1);
+        }
+      }
+
+      if ((bytes = cupsFileRead(fp, (char *)seed.data + seed.datalen, seed.datasize - seed.datalen)) > 0)
+        seed.datalen += (size_t)bytes;
+    }
+    while (bytes > 0);
+
+    cupsFileClose(fp);
+
+    result->filename = filename;
+    result->bytes    = seed.datalen;
+
+    // Decode and re-encode the seed, measuring the heap usage on the second
+    // iteration so that one-time allocations are not counted...
+    for (i = 0; i < iterations; i ++)
+    {
+      heap  = i == (iterations > 1) ? get_heap() : 0;
+      start = get_time();
+
+      seed.pos = 0;
+      ipp      = ippNew();
+
+      if (ippReadIO(&seed, (ipp_io_cb_t)bench_read_cb, true, NULL, ipp) == IPP_STATE_DATA)
+      {
+        if (heap)
+          result->heap = get_heap() - heap;
+
+        if (i == 0)
+        {
+          result->valid   = true;
+          buffer.datasize = ippGetLength(ipp);
+
+          if ((buffer.data = realloc(buffer.data, buffer.datasize + 1)) == NULL)
+	  {
+	    perror("ippbench: Unable to allocate memory");
+	    exit(1);
+	  }
+        }
+
+        buffer.datalen = 0;
+	ippWriteIO(&buffer, (ipp_io_cb_t)bench_write_cb, true, NULL, ipp);
+      }
+
+      ippDelete(ipp);
+
+      times[i] = get_time() - start;
+    }
+
+    qsort(times, iterations, sizeof(double), (int (*)(const void *, const void *))compare_doubles);
+
+    result->p50  = times[iterations / 2];
+    result->p99  = times[iterations * 99 / 100];
+    result->cost = result->p50 / (result->bytes > 256 ? result->bytes : 256);
+    costs[result - results] = result->cost;
+  }
+
+  if (!ret)
+  {
+    // Find the median cost and report the results...
+    qsort(costs, num_seeds, sizeof(double), (int (*)(const void *, const void *))compare_doubles);
+    median = costs[num_seeds / 2];
+
+    if (csv)
+      puts("seed,bytes,valid,iterations,p50_usec,p99_usec,heap,slow");
+    else
+      printf("%-40s %8s %5s %10s %10s %10s\n", "Seed", "Bytes", "Valid", "p50 usec", "p99 usec", "Heap");
+
+    for (i = 0, result = results; i < num_seeds; i ++, result ++)
+    {
+      bool slow = result->cost > (10.0 * median);
+					// Is this seed slow?
+
+      if (slow)
+        ret = 1;
+
+      if (csv)
+        printf("%s,%u,%s,%u,%.3f,%.3f,%u,%s\n", result->filename, (unsigned)result->bytes, result->valid ? "yes" : "no", (unsigned)iterations, 1000000.0 * result->p50, 1000000.0 * result->p99, (unsigned)result->heap, slow ? "yes" : "no");
+      else
+        printf("%-40s %8u %5s %10.3f %10.3f %10u%s\n", result->filename, (unsigned)result->bytes, result->valid ? "yes" : "no", 1000000.0 * result->p50, 1000000.0 * result->p99, (unsigned)result->heap, slow ? " SLOW" : "");
+    }
+  }
+
+  free(results);
+  free(costs);
+  free(times);
+  free(seed.data);
+  free(buffer.data);
+
+  return (ret);
+}
+
+
+//
+// 'bench_read_cb()' - Read data from a memory buffer.
+//
+
+static ssize_t				// O - Number of bytes read
+bench_read_cb(
+    _ippbench_buffer_t *buffer,		// I - Memory buffer
+    ipp_uchar_t        *data,		// I - Data buffer
+    size_t             bytes)		// I - Number of bytes to read
+{
+  if (bytes > (buffer->datalen - buffer->pos))
+    bytes = buffer->datalen - buffer->pos;
+
+  memcpy(data, buffer->data + buffer->pos, bytes);
+  buffer->pos += bytes;
+
+  return ((ssize_t)bytes);
+}
+
+
+//
+// 'bench_run()' - Run a single test on a single message.
+//
+
+static bool				// O - `true` on success, `false` on error
+bench_run(_ippbench_msg_t  *msg,	// I - Message
+          _ippbench_test_t test,	// I - Test to run
+          size_t           *heap)	// O - Heap bytes used by result or `NULL`
+{
+  bool			ret = true;	// Return value
+  size_t		i,		// Looping var
+			start = heap ? get_heap() : 0;
+					// Starting heap usage
+  ipp_t			*ipp;		// Temporary message
+  _ippbench_buffer_t	buffer;		// Temporary buffer
+
+
+  switch (test)
+  {
+    case _IPPBENCH_ENCODE :
+        buffer      = msg->buffer;
+        buffer.pos  = buffer.datalen = 0;
+
+        ippSetState(msg->ipp, IPP_STATE_IDLE);
+        ret = ippWriteIO(&buffer, (ipp_io_cb_t)bench_write_cb, true, NULL, msg->ipp) == IPP_STATE_DATA;
+        if (heap)
+          *heap = get_heap() - start;
+        break;
+
+    case _IPPBENCH_DECODE :
+        buffer     = msg->buffer;
+        buffer.pos = 0;
+
+        ipp = ippNew();
+        ret = ippReadIO(&buffer, (ipp_io_cb_t)bench_read_cb, true, NULL, ipp) == IPP_STATE_DATA;
+        if (heap)
+          *heap = get_heap() - start;
+        ippDelete(ipp);
+        break;
+
+    case _IPPBENCH_COPY :
+        ipp = ippNew();
+        ret = ippCopyAttributes(ipp, msg->ipp, false, NULL, NULL);
+        if (heap)
+          *heap = get_heap() - start;
+        ippDelete(ipp);
+        break;
+
+    case _IPPBENCH_FIND :
+        for (i = 0; i < msg->num_names; i ++)
+        {
+          if (!ippFindAttribute(msg->ipp, msg->names[i], IPP_TAG_ZERO))
+            ret = false;
+        }
+
+        // Also look for an attribute that doesn't exist...
+        if (ippFindAttribute(msg->ipp, "no-such-attribute", IPP_TAG_ZERO))
+          ret = false;
+
+        if (heap)
+          *heap = get_heap() - start;
+        break;
+
+    default :
+        ret = false;
+        break;
+  }
+
+  return (ret);
+}
+
+
+//
+// 'bench_write_cb()' - Write data to a memory buffer.
+//
+
+static ssize_t				// O - Number of bytes written
+bench_write_cb(
+    _ippbench_buffer_t *buffer,		// I - Memory buffer
+    ipp_uchar_t        *data,		// I - Data buffer
+    size_t             bytes)		// I - Number of bytes to write
+{
+  if (bytes > (buffer->datasize - buffer->datalen))
+    return (-1);
+
+  memcpy(buffer->data + buffer->datalen, data, bytes);
+  buffer->datalen += bytes;
+
+  return ((ssize_t)bytes);
+}
+
+
+//
+// 'compare_doubles()' - Compare two times for qsort.
+//
+
+static int				// O - Result of comparison
+compare_doubles(const double *a,	// I - First value
+                const double *b)	// I - Second value
+{
+  if (*a < *b)
+    return (-1);
+  else if (*a > *b)
+    return (1);
+  else
+    return (0);
+}
+
+
+//
+// 'create_get_jobs()' - Create a Get-Jobs response.
+//
+
+static ipp_t *				// O - IPP response
+create_get_jobs(int num_jobs)		// I - Number of jobs
+{
+  int		i;			// Looping var
+  ipp_t		*ipp;			// IPP response
+  char		job_name[256],		// job-name value
+		job_uri[256],		// job-uri value
+		job_user[256];		// job-originating-user-name value
+  static const char * const reasons[] =	// job-state-reasons values
+  {
+    "job-incoming",
+    "job-printing",
+    "job-queued"
+  };
+
+
+  ipp = create_response();
+
+  for (i = 0; i < num_jobs; i ++)
+  {
+    snprintf(job_name, sizeof(job_name), "Document %d.pdf", i + 1);
+    snprintf(job_uri, sizeof(job_uri), "ipp://printer.example.com/ipp/print/%d", i + 1);
+    snprintf(job_user, sizeof(job_user), "user%d", i % 17);
+
+    if (i > 0)
+      ippAddSeparator(ipp);
+
+    ippAddInteger(ipp, IPP_TAG_JOB, IPP_TAG_INTEGER, "job-id", i + 1);
+    ippAddString(ipp, IPP_TAG_JOB, IPP_TAG_URI, "job-uri", NULL, job_uri);
+    ippAddString(ipp, IPP_TAG_JOB, IPP_TAG_NAME, "job-name", NULL, job_name);
+    ippAddString(ipp, IPP_TAG_JOB, IPP_TAG_NAME, "job-originating-user-name", NULL, job_user);
+    ippAddInteger(ipp, IPP_TAG_JOB, IPP_TAG_ENUM, "job-state", IPP_JSTATE_PENDING + i % 3);
+    ippAddString(ipp, IPP_TAG_JOB, IPP_CONST_TAG(IPP_TAG_KEYWORD), "job-state-reasons", NULL, reasons[i % 3]);
+    ippAddInteger(ipp, IPP_TAG_JOB, IPP_TAG_INTEGER, "job-impressions", 1 + i % 50);
+    ippAddInteger(ipp, IPP_TAG_JOB, IPP_TAG_INTEGER, "job-k-octets", 10 + i % 1000);
+    ippAddInteger(ipp, IPP_TAG_JOB, IPP_TAG_INTEGER, "job-printer-up-time", 1000 + i);
+    ippAddInteger(ipp, IPP_TAG_JOB, IPP_TAG_INTEGER, "time-at-creation", 1000 + i);
+    ippAddInteger(ipp, IPP_TAG_JOB, IPP_TAG_INTEGER, "time-at-processing", 1001 + i);
+    ippAddOutOfBand(ipp, IPP_TAG_JOB, IPP_TAG_NOVALUE, "time-at-completed");
+  }
+
+  return (ipp);
+}
+
+
+//
+// 'create_get_printer_attributes()' - Create a Get-Printer-Attributes response.
+//
+
+static ipp_t *				// O - IPP response
+create_get_printer_attributes(void)
+{
+  int		i;			// Looping var
+  ipp_t		*ipp;			// IPP response
+  ipp_attribute_t *attr;		// Current attribute
+  ipp_t		*col;			// Collection value
+  static const char * const charsets[] =// charset-supported values
+  {
+    "us-ascii",
+    "utf-8"
+  };
+  static const char * const compressions[] =
+  {					// compression-supported values
+    "deflate",
+    "gzip",
+    "none"
+  };
+  static const char * const formats[] =	// document-format-supported values
+  {
+    "application/octet-stream",
+    "application/pdf",
+    "application/postscript",
+    "application/vnd.hp-pcl",
+    "image/jpeg",
+    "image/png",
+    "image/pwg-raster",
+    "image/urf",
+    "text/plain"
+  };
+  static const int finishings[] =	// finishings-supported values
+  {
+    IPP_FINISHINGS_NONE,
+    IPP_FINISHINGS_STAPLE,
+    IPP_FINISHINGS_PUNCH,
+    IPP_FINISHINGS_STAPLE_TOP_LEFT,
+    IPP_FINISHINGS_STAPLE_BOTTOM_LEFT,
+    IPP_FINISHINGS_STAPLE_TOP_RIGHT,
+    IPP_FINISHINGS_STAPLE_BOTTOM_RIGHT,
+    IPP_FINISHINGS_PUNCH_DUAL_LEFT,
+    IPP_FINISHINGS_PUNCH_DUAL_TOP
+  };
+  static const char * const job_creation[] =
+  {					// job-creation-attributes-supported values
+    "copies",
+    "finishings",
+    "finishings-col",
+    "ipp-attribute-fidelity",
+    "job-name",
+    "job-priority",
+    "media",
+    "media-col",
+    "multiple-document-handling",
+    "orientation-requested",
+    "output-bin",
+    "page-ranges",
+    "print-color-mode",
+    "print-quality",
+    "print-scaling",
+    "printer-resolution",
+    "sides"
+  };
+  static const char * const media[] =	// media-supported values
+  {
+    "iso_a3_297x420mm",
+    "iso_a4_210x297mm",
+    "iso_a5_148x210mm",
+    "iso_a6_105x148mm",
+    "iso_dl_110x220mm",
+    "jis_b5_182x257mm",
+    "na_executive_7.25x10.5in",
+    "na_index-4x6_4x6in",
+    "na_index-5x8_5x8in",
+    "na_ledger_11x17in",
+    "na_legal_8.5x14in",
+    "na_letter_8.5x11in",
+    "na_number-10_4.125x9.5in",
+    "na_monarch_3.875x7.5in"
+  };
+  static const int operations[] =	// operations-supported values
+  {
+    IPP_OP_PRINT_JOB,
+    IPP_OP_VALIDATE_JOB,
+    IPP_OP_CREATE_JOB,
+    IPP_OP_SEND_DOCUMENT,
+    IPP_OP_CANCEL_JOB,
+    IPP_OP_GET_JOB_ATTRIBUTES,
+    IPP_OP_GET_JOBS,
+    IPP_OP_GET_PRINTER_ATTRIBUTES,
+    IPP_OP_HOLD_JOB,
+    IPP_OP_RELEASE_JOB,
+    IPP_OP_PAUSE_PRINTER,
+    IPP_OP_RESUME_PRINTER,
+    IPP_OP_CANCEL_MY_JOBS,
+    IPP_OP_CLOSE_JOB,
+    IPP_OP_IDENTIFY_PRINTER
+  };
+  static const char * const sides[] =	// sides-supported values
+  {
+    "one-sided",
+    "two-sided-long-edge",
+    "two-sided-short-edge"
+  };
+  static const char * const versions[] =// ipp-versions-supported values
+  {
+    "1.1",
+    "2.0",
+    "2.1",
+    "2.2"
+  };
+  static const char * const urf[] =	// urf-supported values
+  {
+    "CP1",
+    "IS1-4-5-19",
+    "MT1-2-3-4-5-6",
+    "RS300-600",
+    "SRGB24",
+    "V1.4",
+    "W8",
+    "DM1"
+  };
+
+
+  ipp = create_response();
+
+  ippAddStrings(ipp, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_CHARSET), "charset-supported", sizeof(charsets) / sizeof(charsets[0]), NULL, charsets);
+  ippAddString(ipp, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_CHARSET), "charset-configured", NULL, "utf-8");
+  ippAddStrings(ipp, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "compression-supported", sizeof(compressions) / sizeof(compressions[0]), NULL, compressions);
+  ippAddInteger(ipp, IPP_TAG_PRINTER, IPP_TAG_INTEGER, "copies-default", 1);
+  ippAddRange(ipp, IPP_TAG_PRINTER, "copies-supported", 1, 999);
+  ippAddString(ipp, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_MIMETYPE), "document-format-default", NULL, "application/octet-stream");
+  ippAddStrings(ipp, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_MIMETYPE), "document-format-supported", sizeof(formats) / sizeof(formats[0]), NULL, formats);
+  ippAddInteger(ipp, IPP_TAG_PRINTER, IPP_TAG_ENUM, "finishings-default", IPP_FINISHINGS_NONE);
+  ippAddIntegers(ipp, IPP_TAG_PRINTER, IPP_TAG_ENUM, "finishings-supported", sizeof(finishings) / sizeof(finishings[0]), finishings);
+  ippAddStrings(ipp, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "ipp-versions-supported", sizeof(versions) / sizeof(versions[0]), NULL, versions);
+  ippAddStrings(ipp, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "job-creation-attributes-supported", sizeof(job_creation) / sizeof(job_creation[0]), NULL, job_creation);
+  ippAddRange(ipp, IPP_TAG_PRINTER, "job-impressions-supported", 1, 99999);
+  ippAddInteger(ipp, IPP_TAG_PRINTER, IPP_TAG_INTEGER, "job-priority-default", 50);
+  ippAddInteger(ipp, IPP_TAG_PRINTER, IPP_TAG_INTEGER, "job-priority-supported", 100);
+  ippAddString(ipp, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_LANGUAGE), "generated-natural-language-supported", NULL, "en");
+  ippAddString(ipp, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "media-default", NULL, "na_letter_8.5x11in");
+  ippAddStrings(ipp, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "media-supported", sizeof(media) / sizeof(media[0]), NULL, media);
+  ippAddStrings(ipp, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "media-ready", 2, NULL, media + 10);
+
+  col = create_media_col("na_letter_8.5x11in", 21590, 27940, "main", "stationery", 423, false);
+  ippAddCollection(ipp, IPP_TAG_PRINTER, "media-col-default", col);
+  ippDelete(col);
+
+  attr = NULL;
+  for (i = 0; i < 2; i ++)
+  {
+    col = create_media_col(i ? "iso_a4_210x297mm" : "na_letter_8.5x11in", i ? 21000 : 21590, i ? 29700 : 27940, i ? "alternate" : "main", "stationery", 423, false);
+    if (attr)
+      ippSetCollection(ipp, &attr, ippGetCount(attr), col);
+    else
+      attr = ippAddCollection(ipp, IPP_TAG_PRINTER, "media-col-ready", col);
+    ippDelete(col);
+  }
+
+  ippAddString(ipp, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "multiple-document-handling-default", NULL, "separate-documents-collated-copies");
+  ippAddString(ipp, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_LANGUAGE), "natural-language-configured", NULL, "en");
+  ippAddIntegers(ipp, IPP_TAG_PRINTER, IPP_TAG_ENUM, "operations-supported", sizeof(operations) / sizeof(operations[0]), operations);
+  ippAddInteger(ipp, IPP_TAG_PRINTER, IPP_TAG_ENUM, "orientation-requested-default", IPP_ORIENT_NONE);
+  ippAddString(ipp, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "output-bin-default", NULL, "face-down");
+  ippAddBoolean(ipp, IPP_TAG_PRINTER, "page-ranges-supported", true);
+  ippAddString(ipp, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "pdl-override-supported", NULL, "attempted");
+  ippAddString(ipp, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "print-color-mode-default", NULL, "auto");
+  ippAddInteger(ipp, IPP_TAG_PRINTER, IPP_TAG_ENUM, "print-quality-default", IPP_QUALITY_NORMAL);
+  ippAddBoolean(ipp, IPP_TAG_PRINTER, "printer-is-accepting-jobs", true);
+  ippAddString(ipp, IPP_TAG_PRINTER, IPP_TAG_TEXT, "printer-info", NULL, "Example Printer");
+  ippAddString(ipp, IPP_TAG_PRINTER, IPP_TAG_TEXT, "printer-location", NULL, "Second Floor, Room 42");
+  ippAddString(ipp, IPP_TAG_PRINTER, IPP_TAG_TEXT, "printer-make-and-model", NULL, "Example Laser Printer 4200");
+  ippAddString(ipp, IPP_TAG_PRINTER, IPP_TAG_NAME, "printer-name", NULL, "Example_Laser_Printer");
+  ippAddResolution(ipp, IPP_TAG_PRINTER, "printer-resolution-default", IPP_RES_PER_INCH, 600, 600);
+  ippAddInteger(ipp, IPP_TAG_PRINTER, IPP_TAG_ENUM, "printer-state", IPP_PSTATE_IDLE);
+  ippAddString(ipp, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "printer-state-reasons", NULL, "none");
+  ippAddInteger(ipp, IPP_TAG_PRINTER, IPP_TAG_INTEGER, "printer-up-time", 12345);
+  ippAddString(ipp, IPP_TAG_PRINTER, IPP_TAG_URI, "printer-uri-supported", NULL, "ipp://printer.example.com/ipp/print");
+  ippAddString(ipp, IPP_TAG_PRINTER, IPP_TAG_URI, "printer-uuid", NULL, "urn:uuid:a4c10f5a-7c4e-3b4f-6a3b-1d6a2a9b0e5c");
+  ippAddString(ipp, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "sides-default", NULL, "one-sided");
+  ippAddStrings(ipp, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "sides-supported", sizeof(sides) / sizeof(sides[0]), NULL, sides);
+  ippAddStrings(ipp, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "urf-supported", sizeof(urf) / sizeof(urf[0]), NULL, urf);
+  ippAddString(ipp, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "uri-authentication-supported", NULL, "none");
+  ippAddString(ipp, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "uri-security-supported", NULL, "none");
+
+  return (ipp);
+}
+
+
+//
+// 'create_media_col()' - Create a media-col value.
+//
+
+static ipp_t *				// O - Collection value
+create_media_col(const char *size_name,	// I - media-size-name value
+                 int        width,	// I - x-dimension value
+                 int        length,	// I - y-dimension value
+                 const char *source,	// I - media-source value
+                 const char *type,	// I - media-type value
+                 int        margin,	// I - Margin value
+                 bool       deep)	// I - Add media-source-properties?
+{
+  ipp_t	*col,				// Collection value
+	*size,				// media-size value
+	*props;				// media-source-properties value
+
+
+  col  = ippNew();
+  size = ippNew();
+
+  ippAddInteger(size, IPP_TAG_ZERO, IPP_TAG_INTEGER, "x-dimension", width);
+  ippAddInteger(size, IPP_TAG_ZERO, IPP_TAG_INTEGER, "y-dimension", length);
+
+  ippAddInteger(col, IPP_TAG_ZERO, IPP_TAG_INTEGER, "media-bottom-margin", margin);
+  ippAddInteger(col, IPP_TAG_ZERO, IPP_TAG_INTEGER, "media-left-margin", margin);
+  ippAddInteger(col, IPP_TAG_ZERO, IPP_TAG_INTEGER, "media-right-margin", margin);
+  ippAddCollection(col, IPP_TAG_ZERO, "media-size", size);
+  ippAddString(col, IPP_TAG_ZERO, IPP_TAG_KEYWORD, "media-size-name", NULL, size_name);
+  ippAddString(col, IPP_TAG_ZERO, IPP_TAG_KEYWORD, "media-source", NULL, source);
+  ippAddInteger(col, IPP_TAG_ZERO, IPP_TAG_INTEGER, "media-top-margin", margin);
+  ippAddString(col, IPP_TAG_ZERO, IPP_TAG_KEYWORD, "media-type", NULL, type);
+
+  if (deep)
+  {
+    props = ippNew();
+
+    ippAddString(props, IPP_TAG_ZERO, IPP_CONST_TAG(IPP_TAG_KEYWORD), "media-source-feed-direction", NULL, "short-edge-first");
+    ippAddInteger(props, IPP_TAG_ZERO, IPP_TAG_ENUM, "media-source-feed-orientation", IPP_ORIENT_PORTRAIT);
+    ippAddCollection(props, IPP_TAG_ZERO, "media-size", size);
+
+    ippAddCollection(col, IPP_TAG_ZERO, "media-source-properties", props);
+    ippDelete(props);
+  }
+
+  ippDelete(size);
+
+  return (col);
+}
+
+
+//
+// 'create_media_col_database()' - Create a deep media-col-database response.
+//
+
+static ipp_t *				// O - IPP response
+create_media_col_database(
+    int num_media)			// I - Number of media-col values
+{
+  int		i;			// Looping var
+  ipp_t		*ipp,			// IPP response
+		*col;			// Collection value
+  ipp_attribute_t *attr = NULL;		// media-col-database attribute
+  char		size_name[256];		// media-size-name value
+  static const char * const sources[] =	// media-source values
+  {
+    "auto",
+    "main",
+    "alternate",
+    "manual",
+    "by-pass-tray"
+  };
+  static const char * const types[] =	// media-type values
+  {
+    "stationery",
+    "stationery-letterhead",
+    "photographic-glossy",
+    "labels",
+    "envelope",
+    "transparency"
+  };
+
+
+  ipp = create_response();
+
+  for (i = 0; i < num_media; i ++)
+  {
+    snprintf(size_name, sizeof(size_name), "custom_%d_%dx%dmm", i + 1, 100 + i, 150 + i);
+
+    col = create_media_col(size_name, 10000 + 100 * i, 15000 + 100 * i, sources[i % 5], types[i % 6], (i & 1) ? 0 : 423, true);
+    if (attr)
+      ippSetCollection(ipp, &attr, ippGetCount(attr), col);
+    else
+      attr = ippAddCollection(ipp, IPP_TAG_PRINTER, "media-col-database", col);
+    ippDelete(col);
+  }
+
+  ippAddString(ipp, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "media-source-supported", NULL, "auto");
+  ippAddString(ipp, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "media-type-supported", NULL, "stationery");
+
+  return (ipp);
+}
+
+
+//
+// 'create_response()' - Create an empty successful IPP response.
+//
+
+static ipp_t *				// O - IPP response
+create_response(void)
+{
+  ipp_t	*ipp;				// IPP response
+
+
+  ipp = ippNew();
+  ippSetVersion(ipp, 2, 0);
+  ippSetStatusCode(ipp, IPP_STATUS_OK);
+  ippSetRequestId(ipp, 42);
+  ippAddString(ipp, IPP_TAG_OPERATION, IPP_CONST_TAG(IPP_TAG_CHARSET), "attributes-charset", NULL, "utf-8");
+  ippAddString(ipp, IPP_TAG_OPERATION, IPP_CONST_TAG(IPP_TAG_LANGUAGE), "attributes-natural-language", NULL, "en");
+
+  return (ipp);
+}
+
+
+//
+// 'get_heap()' - Get the number of bytes currently allocated from the heap.
+//
+
+static size_t				// O - Allocated bytes or 0 if unknown
+get_heap(void)
+{
+#ifdef HAVE_MALLINFO2
+  struct mallinfo2 info = mallinfo2();	// Memory allocation info
+
+  return (info.uordblks + info.hblkhd);
+
+#else
+  return (0);
+#endif // HAVE_MALLINFO2
+}
+
+
+//
+// 'get_time()' - Get the current time in seconds.
+//
+
+static double				// O - Time in seconds
+get_time(void)
+{
+#ifdef CLOCK_MONOTONIC
+  struct timespec	curtime;	// Current time
+
+
+  clock_gettime(CLOCK_MONOTONIC, &curtime);
+  return (curtime.tv_sec + 0.000000001 * curtime.tv_nsec);
+
+#else
+  struct timeval	curtime;	// Current time
+
+
+  gettimeofday(&curtime, NULL);
+  return (curtime.tv_sec + 0.000001 * curtime.tv_usec);
+#endif // CLOCK_MONOTONIC
+}
+
+
+//
+// 'init_msg()' - Initialize a benchmark message.
+//
+
+static void
+init_msg(_ippbench_msg_t *msg,		// I - Benchmark message
+         const char      *name,		// I - Message name
+         ipp_t           *ipp)		// I - IPP message
+{
+  size_t		i,		// Looping var
+			num_attrs = 0;	// Number of attributes
+  ipp_attribute_t	*attr;		// Current attribute
+
+
+  memset(msg, 0, sizeof(_ippbench_msg_t));
+
+  msg->name = name;
+  msg->ipp  = ipp;
+
+  // Collect the attribute names for the find test...
+  for (attr = ippGetFirstAttribute(ipp); attr; attr = ippGetNextAttribute(ipp))
+    num_attrs ++;
+
+  msg->names = calloc(num_attrs + 1, sizeof(char *));
+
+  for (attr = ippGetFirstAttribute(ipp); attr; attr = ippGetNextAttribute(ipp))
+  {
+    const char *attrname = ippGetName(attr);
+					// Attribute name
+
+    if (!attrname)
+      continue;
+
+    for (i = 0; i < msg->num_names; i ++)
+    {
+      if (!strcmp(msg->names[i], attrname))
+        break;
+    }
+
+    if (i >= msg->num_names)
+      msg->names[msg->num_names ++] = attrname;
+  }
+
+  // Allocate a buffer large enough for the encoded message and encode it...
+  msg->buffer.datasize = ippGetLength(ipp);
+  msg->buffer.data     = malloc(msg->buffer.datasize);
+
+  if (!msg->names || !msg->buffer.data)
+  {
+    perror("ippbench: Unable to allocate memory");
+    exit(1);
+  }
+
+  if (ippWriteIO(&msg->buffer, (ipp_io_cb_t)bench_write_cb, true, NULL, ipp) != IPP_STATE_DATA)
+  {
+    fprintf(stderr, "ippbench: Unable to encode %s message: %s\n", name, cupsGetErrorString());
+    exit(1);
+  }
+}
+
+
+//
+// 'usage()' - Show program usage.
+//
+
+static int				// O - Exit status
+usage(FILE *out)			// I - Output file
+{
+  fputs("Usage: ippbench [OPTIONS] [SEED-FILE-OR-DIRECTORY ...]\n", out);
+  fputs("Options:\n", out);
+  fputs("  --csv         Produce CSV output for regression tracking.\n", out);
+  fputs("  --help        Show program help.\n", out);
+  fputs("  -j JOBS       Set the number of jobs in the Get-Jobs response (default 100).\n", out);
+  fputs("  -m MEDIA      Set the number of media-col-database values (default 100).\n", out);
+  fputs("  -n ITERATIONS Set the number of iterations for each seed (default 100).\n", out);
+  fputs("  -t SECONDS    Set the minimum duration of each test (default 1.0).\n", out);
+
+  return (out == stdout ? 0 : 1);
+}
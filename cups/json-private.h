@@ -20,6 +20,7 @@ extern "C" {
 //
 
 extern void	_cupsJSONDelete(cups_json_t *json, const char *key) _CUPS_PRIVATE;
+extern char	*_cupsJSONExportString(cups_json_t *json) _CUPS_INTERNAL;
 
 
 #  ifdef __cplusplus
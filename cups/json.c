@@ -10,12 +10,48 @@
 #include "cups-private.h"
 #include "json-private.h"
 #include <sys/stat.h>
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#  include <arm_neon.h>
+#  define _CUPS_JSON_NEON 1
+#endif // __SSE2__
+
+
+//
+// Constants...
+//
+
+#define _CUPS_JSON_CACHE_MAX	16	// Maximum number of cached URLs
+#define _CUPS_JSON_INDEX_MIN	16	// Minimum number of keys to index
+#define _CUPS_JSON_MAX_DEPTH	128	// Maximum nesting depth for writers
+
+#define _CUPS_JWRITER_OBJECT	1	// Level is an object
+#define _CUPS_JWRITER_VALUES	2	// Level has keys/values
+#define _CUPS_JWRITER_KEY	4	// Key written, waiting for value
 
 
 //
 // Private types...
 //
 
+typedef struct _cups_jarena_s		// JSON node arena block
+{
+  struct _cups_jarena_s	*next;		// Next (overflow) block
+  cups_json_t		*nodes;		// Nodes in block
+  size_t		num_nodes,	// Number of nodes used
+			alloc_nodes;	// Number of nodes allocated
+} _cups_jarena_t;
+
+typedef struct _cups_jindex_s		// JSON object key index
+{
+  size_t		num_keys,	// Number of keys in table
+			mask;		// Hash table mask (size - 1)
+  bool			dups;		// Does the object have duplicate keys?
+  cups_json_t		*last,		// Last child node
+			**keys;		// Hash table of key nodes
+} _cups_jindex_t;
+
 struct _cups_json_s			// JSON node
 {
   cups_jtype_t	type;			// Node type
@@ -27,15 +63,70 @@ struct _cups_json_s			// JSON node
     double	number;			// Number value
     char	*string;		// String value
   }		value;			// Value, if any
+  _cups_jarena_t *arena;		// Arena containing node and string, if any
+  _cups_jindex_t *index;		// Key index for large objects, if any
+};
+
+typedef struct _cups_jcache_s		// JSON URL cache entry
+{
+  char			*url,		// URL
+			*etag,		// ETag value, if any
+			*data;		// JSON data
+  time_t		last_modified,	// Last-Modified date/time, if any
+			expires;	// Expiration date/time
+  size_t		used;		// Last use counter
+} _cups_jcache_t;
+
+struct _cups_json_writer_s		// JSON writer
+{
+  cups_file_t	*fp;			// Output file or `NULL` for a string
+  char		*buffer;		// String buffer
+  size_t	bufused,		// Bytes used in string buffer
+		bufsize;		// Size of string buffer
+  bool		error,			// Has an error occurred?
+		done;			// Has the root value been written?
+  size_t	depth;			// Current nesting depth
+  unsigned char	levels[_CUPS_JSON_MAX_DEPTH];
+					// State of each nesting level
 };
 
 
+//
+// Local globals...
+//
+
+static cups_mutex_t	json_cache_mutex = CUPS_MUTEX_INITIALIZER;
+					// Mutex for URL cache
+static _cups_jcache_t	json_cache[_CUPS_JSON_CACHE_MAX];
+					// URL cache
+static char		*json_cache_dir = NULL;
+					// URL cache directory, if any
+static size_t		json_cache_used = 0;
+					// URL cache use counter
+
+
 //
 // Local functions...
 //
 
+static cups_json_t *alloc_json(_cups_jarena_t *arena, cups_json_t *parent, cups_json_t *after, cups_jtype_t type);
+static _cups_jcache_t *cache_find(const char *url);
+static time_t	cache_expires(const char *cache_control, time_t now, bool *store);
+static char	*cache_path(char *buffer, size_t bufsize, const char *url);
+static cups_json_t *cache_result(_cups_jcache_t *entry, time_t *last_modified);
+static void	cache_store(const char *url, const char *etag, time_t last_modified, time_t expires, char *data);
+static size_t	count_literal(const char *s, size_t len);
 static void	delete_json(cups_json_t *json);
 static void	free_json(cups_json_t *json);
+static void	index_add(cups_json_t *json, cups_json_t *key);
+static void	index_build(cups_json_t *json);
+static void	index_free(cups_json_t *json);
+static size_t	index_hash(const char *key);
+static void	index_remove(cups_json_t *json, cups_json_t *key);
+static bool	writer_data(cups_json_writer_t *w, const char *s, size_t len);
+static bool	writer_error(cups_json_writer_t *w);
+static bool	writer_string(cups_json_writer_t *w, const char *s);
+static bool	writer_value(cups_json_writer_t *w);
 
 
 //
@@ -73,6 +164,9 @@ cupsJSONAdd(cups_json_t *parent,	// I - Parent JSON node
   else if ((current = parent->value.child) != NULL)
   {
     // Find the last child...
+    if (parent->index && parent->index->last)
+      current = parent->index->last;
+
     while (current && current->sibling)
       current = current->sibling;
 
@@ -83,6 +177,16 @@ cupsJSONAdd(cups_json_t *parent,	// I - Parent JSON node
     // This is the first child...
     parent->value.child = node;
   }
+
+  // Update the key index, if any...
+  if (parent->index)
+  {
+    if (!node->sibling)
+      parent->index->last = node;
+
+    if (node->type == CUPS_JTYPE_KEY)
+      index_add(parent, node);
+  }
 }
 
 
@@ -111,6 +215,15 @@ _cupsJSONDelete(cups_json_t *json,	// I - JSON node
       // Remove the current and next siblings from the parent...
       sibling = current->sibling;
 
+      if (json->index)
+      {
+        // Update the key index...
+        if (json->index->last == sibling)
+          json->index->last = prev;
+
+        index_remove(json, current);
+      }
+
       if (prev)
         prev->sibling = sibling->sibling;
       else
@@ -125,6 +238,48 @@ _cupsJSONDelete(cups_json_t *json,	// I - JSON node
 }
 
 
+//
+// '_cupsJSONExportString()' - Save a JSON node tree to a string.
+//
+// This function saves a JSON node tree to a string allocated using
+// `_cupsMemAlloc`.  The resulting string must be freed using `_cupsMemFree`.
+//
+
+char *					// O - JSON string or `NULL` on error
+_cupsJSONExportString(cups_json_t *json)// I - JSON root node
+{
+  cups_json_writer_t	*w;		// JSON writer
+  char			*s = NULL;	// JSON string
+
+
+  DEBUG_printf("_cupsJSONExportString(json=%p)", (void *)json);
+
+  // Range check input...
+  if (!json)
+  {
+    _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(EINVAL), 0);
+    DEBUG_puts("3_cupsJSONExportString: Returning NULL.");
+    return (NULL);
+  }
+
+  // Format the JSON into a string buffer and take ownership of the buffer...
+  if ((w = cupsJSONWriterNew(NULL)) == NULL)
+    return (NULL);
+
+  if (cupsJSONWriterAddNode(w, json) && w->buffer)
+  {
+    s         = w->buffer;
+    w->buffer = NULL;
+  }
+
+  cupsJSONWriterDelete(w);
+
+  DEBUG_printf("3_cupsJSONExportString: Returning \"%s\".", s);
+
+  return (s);
+}
+
+
 //
 // 'cupsJSONDelete()' - Delete a JSON node and all of its children.
 //
@@ -146,6 +301,7 @@ cupsJSONDelete(cups_json_t *json)	// I - JSON node
     {
       // This is the first child of the parent...
       json->parent->value.child = json->sibling;
+      child                     = NULL;
     }
     else
     {
@@ -161,6 +317,16 @@ cupsJSONDelete(cups_json_t *json)	// I - JSON node
         child = child->sibling;
       }
     }
+
+    if (json->parent->index)
+    {
+      // Update the key index...
+      if (json->parent->index->last == json)
+        json->parent->index->last = child;
+
+      if (json->type == CUPS_JTYPE_KEY)
+        index_remove(json->parent, json);
+    }
   }
 
   // Free the value(s)
@@ -178,37 +344,42 @@ cupsJSONExportFile(
     cups_json_t *json,			// I - JSON root node
     const char  *filename)		// I - JSON filename
 {
-  char	*s;				// JSON string
-  int	fd;				// JSON file
+  cups_file_t		*fp;		// JSON file
+  cups_json_writer_t	*w;		// JSON writer
+  bool			ret;		// Return value
 
 
   DEBUG_printf("cupsJSONExportFile(json=%p, filename=\"%s\")", (void *)json, filename);
 
-  // Get the JSON as a string...
-  if ((s = cupsJSONExportString(json)) == NULL)
-    return (false);
-
-  // Create the file...
-  if ((fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0666)) < 0)
+  // Range check input...
+  if (!json || !filename)
   {
-    _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(errno), 0);
-    free(s);
+    _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(EINVAL), 0);
     return (false);
   }
 
-  if (write(fd, s, strlen(s)) < 0)
+  // Create the file and stream the JSON to it...
+  if ((fp = cupsFileOpen(filename, "w")) == NULL)
+    return (false);
+
+  if ((w = cupsJSONWriterNew(fp)) == NULL)
   {
-    _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(errno), 0);
-    close(fd);
+    cupsFileClose(fp);
     unlink(filename);
-    free(s);
     return (false);
   }
 
-  close(fd);
-  free(s);
+  cupsJSONWriterAddNode(w, json);
 
-  return (true);
+  ret = cupsJSONWriterDelete(w);
+
+  if (!cupsFileClose(fp))
+    ret = false;
+
+  if (!ret)
+    unlink(filename);
+
+  return (ret);
 }
 
 
@@ -222,247 +393,18 @@ cupsJSONExportFile(
 char *					// O - JSON string or `NULL` on error
 cupsJSONExportString(cups_json_t *json)	// I - JSON root node
 {
-  cups_json_t	*current;		// Current node
-  size_t	length;			// Length of JSON data as a string
-  char		*s,			// JSON string
-		*ptr;			// Pointer into string
-  const char	*value;			// Pointer into string value
-  struct lconv	*loc;			// Locale data
-
-
-  DEBUG_printf("cupsJSONExportString(json=%p)", (void *)json);
-
-  // Range check input...
-  if (!json)
-  {
-    _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(EINVAL), 0);
-    DEBUG_puts("3cupsJSONExportString: Returning NULL.");
-    return (NULL);
-  }
-
-  // Figure out the necessary space needed in the string
-  current = json;
-  length  = 1;				// nul
-
-  while (current)
-  {
-    if (current->parent && current->parent->value.child != current)
-      length ++;			// Comma or colon separator
-
-    switch (current->type)
-    {
-      case CUPS_JTYPE_NULL :
-      case CUPS_JTYPE_TRUE :
-          length += 4;
-          break;
-
-      case CUPS_JTYPE_FALSE :
-          length += 5;
-          break;
-
-      case CUPS_JTYPE_ARRAY :
-      case CUPS_JTYPE_OBJECT :
-          length += 2;			// Brackets/braces
-          break;
-
-      case CUPS_JTYPE_NUMBER :
-          length += 32;
-          break;
-
-      case CUPS_JTYPE_KEY :
-      case CUPS_JTYPE_STRING :
-          length += 2;			// Quotes
-          for (value = current->value.string; *value; value ++)
-          {
-	    if (strchr("\\\"\b\f\n\r\t", *value))
-	      length += 2;		// Simple escaped char
-            else if ((*value & 255) < ' ')
-              length += 6;		// Worst case for control char
-	    else
-	      length ++;		// Literal char
-          }
-          break;
-    }
-
-    // Get next node...
-    if ((current->type == CUPS_JTYPE_ARRAY || current->type == CUPS_JTYPE_OBJECT) && current->value.child)
-    {
-      // Descend
-      current = current->value.child;
-    }
-    else if (current->sibling)
-    {
-      // Visit silbling
-      current = current->sibling;
-    }
-    else
-    {
-      // Ascend and continue...
-      current = current->parent;
-      while (current)
-      {
-        if (current->sibling)
-	{
-	  current = current->sibling;
-	  break;
-	}
-	else
-        {
-          current = current->parent;
-	}
-      }
-    }
-  }
-
-  DEBUG_printf("2cupsJSONExportString: length=%u", (unsigned)length);
-
-  // Allocate memory and fill it up...
-  if ((s = malloc(length)) == NULL)
-  {
-    _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(errno), 0);
-    DEBUG_puts("3cupsJSONExportString: Returning NULL.");
-    return (NULL);
-  }
+  char	*s,				// JSON string
+	*ret = NULL;			// Return value
 
-  current = json;
-  ptr     = s;
-  loc     = localeconv();
 
-  while (current)
+  // Copy the string so that it can be freed using the `free` function...
+  if ((s = _cupsJSONExportString(json)) != NULL)
   {
-    if (current->parent && current->parent->value.child != current)
-    {
-      // Add separator
-      if (current->type == CUPS_JTYPE_KEY || current->parent->type == CUPS_JTYPE_ARRAY)
-        *ptr++ = ',';
-      else
-        *ptr++ = ':';
-    }
-
-    switch (current->type)
-    {
-      case CUPS_JTYPE_NULL :
-          memcpy(ptr, "null", 4);
-          ptr += 4;
-          break;
-
-      case CUPS_JTYPE_TRUE :
-          memcpy(ptr, "true", 4);
-          ptr += 4;
-          break;
-
-      case CUPS_JTYPE_FALSE :
-          memcpy(ptr, "false", 5);
-          ptr += 5;
-          break;
-
-      case CUPS_JTYPE_ARRAY :
-          *ptr++ = '[';
-          break;
-
-      case CUPS_JTYPE_OBJECT :
-          *ptr++ = '{';
-          break;
-
-      case CUPS_JTYPE_NUMBER :
-          _cupsStrFormatd(ptr, s + length, current->value.number, loc);
-          ptr += strlen(ptr);
-          break;
-
-      case CUPS_JTYPE_KEY :
-      case CUPS_JTYPE_STRING :
-          *ptr++ = '\"';
-
-          for (value = current->value.string; *value; value ++)
-          {
-            // Quote/escape as needed...
-	    if (*value == '\\' || *value == '\"')
-	    {
-	      *ptr++ = '\\';
-	      *ptr++ = *value;
-	    }
-	    else if (*value == '\b')
-	    {
-	      *ptr++ = '\\';
-	      *ptr++ = 'b';
-	    }
-	    else if (*value == '\f')
-	    {
-	      *ptr++ = '\\';
-	      *ptr++ = 'f';
-	    }
-	    else if (*value == '\n')
-	    {
-	      *ptr++ = '\\';
-	      *ptr++ = 'n';
-	    }
-	    else if (*value == '\r')
-	    {
-	      *ptr++ = '\\';
-	      *ptr++ = 'r';
-	    }
-	    else if (*value == '\t')
-	    {
-	      *ptr++ = '\\';
-	      *ptr++ = 't';
-	    }
-            if ((*value & 255) < ' ')
-            {
-              snprintf(ptr, length - (size_t)(ptr - s), "\\u%04x", *value);
-              ptr += 6;
-	    }
-	    else
-	    {
-	      *ptr++ = *value;
-	    }
-          }
-
-          *ptr++ = '\"';
-          break;
-    }
-
-    // Get next node...
-    if ((current->type == CUPS_JTYPE_ARRAY || current->type == CUPS_JTYPE_OBJECT) && current->value.child)
-    {
-      // Descend
-      current = current->value.child;
-    }
-    else if (current->sibling)
-    {
-      // Visit silbling
-      current = current->sibling;
-    }
-    else if ((current = current->parent) != NULL)
-    {
-      // Ascend and continue...
-      if (current->type == CUPS_JTYPE_ARRAY)
-        *ptr++ = ']';
-      else
-        *ptr++ = '}';
-
-      while (current)
-      {
-        if (current->sibling)
-	{
-	  current = current->sibling;
-	  break;
-	}
-	else if ((current = current->parent) != NULL)
-	{
-	  if (current->type == CUPS_JTYPE_ARRAY)
-	    *ptr++ = ']';
-	  else
-	    *ptr++ = '}';
-	}
-      }
-    }
+    ret = strdup(s);
+    _cupsMemFree(s);
   }
 
-  *ptr = '\0';
-
-  DEBUG_printf("3cupsJSONExportString: Returning \"%s\".", s);
-
-  return (s);
+  return (ret);
 }
 
 
@@ -475,21 +417,46 @@ cupsJSONFind(cups_json_t *json,		// I - JSON object node
              const char  *key)		// I - Object key
 {
   cups_json_t	*current;		// Current child node
+  size_t	num_keys = 0;		// Number of keys searched
 
 
   // Range check input...
-  if (!json || json->type != CUPS_JTYPE_OBJECT)
+  if (!json || json->type != CUPS_JTYPE_OBJECT || !key)
+    return (NULL);
+
+  if (json->index)
+  {
+    // Look up the key in the index...
+    _cups_jindex_t	*index = json->index;
+					// Key index
+    size_t		slot;		// Current slot
+
+    for (slot = index_hash(key) & index->mask; index->keys[slot]; slot = (slot + 1) & index->mask)
+    {
+      if (!strcmp(key, index->keys[slot]->value.string))
+        return (index->keys[slot]->sibling);
+    }
+
     return (NULL);
+  }
 
   // Search for the named key...
   for (current = json->value.child; current; current = current->sibling)
   {
-    if (current->type == CUPS_JTYPE_KEY && !strcmp(key, current->value.string))
-      return (current->sibling);
+    if (current->type == CUPS_JTYPE_KEY)
+    {
+      if (!strcmp(key, current->value.string))
+        break;
+
+      num_keys ++;
+    }
   }
 
-  // If we get here there was no match...
-  return (NULL);
+  // Index large objects for the next lookup...
+  if (num_keys >= _CUPS_JSON_INDEX_MIN)
+    index_build(json);
+
+  return (current ? current->sibling : NULL);
 }
 
 
@@ -654,7 +621,7 @@ cupsJSONImportFile(const char *filename)// I - JSON filename
   }
 
   // Allocate memory for the JSON file...
-  if ((s = malloc((size_t)fileinfo.st_size + 1)) == NULL)
+  if ((s = _cupsMemAlloc(CUPS_MEMTYPE_JSON, (size_t)fileinfo.st_size + 1)) == NULL)
   {
     _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(errno), 0);
     close(fd);
@@ -666,7 +633,7 @@ cupsJSONImportFile(const char *filename)// I - JSON filename
   {
     _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(errno), 0);
     close(fd);
-    free(s);
+    _cupsMemFree(s);
     return (NULL);
   }
 
@@ -677,7 +644,7 @@ cupsJSONImportFile(const char *filename)// I - JSON filename
   json = cupsJSONImportString(s);
 
   // Free the string and return...
-  free(s);
+  _cupsMemFree(s);
 
   return (json);
 }
@@ -686,6 +653,9 @@ cupsJSONImportFile(const char *filename)// I - JSON filename
 //
 // 'cupsJSONImportString()' - Load a JSON object from a string.
 //
+// The nodes and strings of the returned tree are allocated together so that
+// @link cupsJSONDelete@ only needs to free a few blocks of memory.
+//
 
 cups_json_t *				// O - Root JSON object node
 cupsJSONImportString(const char *s)	// I - JSON string
@@ -694,8 +664,12 @@ cupsJSONImportString(const char *s)	// I - JSON string
 		*parent,		// Current parent node
 		*prev = NULL,		// Previous node
 		*current;		// Current node
-  size_t	count;			// Number of children
-  struct lconv	*loc;			// Locale data
+  size_t	count,			// Number of children
+		len,			// Length of JSON string
+		alloc_nodes;		// Initial number of nodes
+  const char	*end;			// End of JSON string
+  char		*strptr;		// Pointer into string storage
+  _cups_jarena_t *arena;		// Node arena
   static const char *sep = ",]} \n\r\t";// Separator chars
 
 
@@ -709,17 +683,30 @@ cupsJSONImportString(const char *s)	// I - JSON string
     return (NULL);
   }
 
-  // Create the root node...
-  if ((json = cupsJSONNew(NULL, NULL, CUPS_JTYPE_OBJECT)) == NULL)
+  // Allocate the arena - unescaped strings are never longer than the JSON
+  // source, so string storage is sized to the input and nodes that don't fit
+  // in the initial block go into overflow blocks...
+  len         = strlen(s);
+  end         = s + len;
+  alloc_nodes = len / 16 + 8;
+
+  if ((arena = _cupsMemCalloc(CUPS_MEMTYPE_JSON, 1, sizeof(_cups_jarena_t) + alloc_nodes * sizeof(cups_json_t) + len + 1)) == NULL)
   {
-    DEBUG_puts("2cupsJSONImportString: Unable to create root object.");
+    DEBUG_puts("2cupsJSONImportString: Unable to allocate arena.");
+    _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(errno), 0);
     return (NULL);
   }
 
+  arena->nodes       = (cups_json_t *)(arena + 1);
+  arena->alloc_nodes = alloc_nodes;
+  strptr             = (char *)(arena->nodes + alloc_nodes);
+
+  // Create the root node...
+  json = alloc_json(arena, NULL, NULL, CUPS_JTYPE_OBJECT);
+
   // Parse until we get to the end...
   parent = json;
   count  = 0;
-  loc    = localeconv();
   s ++;
 
   while (*s)
@@ -796,13 +783,35 @@ cupsJSONImportString(const char *s)	// I - JSON string
     if (*s == '\"')
     {
       // String
-      size_t		len;		// Length of value
-      const char	*start;		// Start of value
-      char		*ptr;		// Pointer into string
+      size_t		n;		// Number of literal characters
+
+      if (parent->type == CUPS_JTYPE_OBJECT && !(count & 1))
+        current = alloc_json(arena, parent, prev, CUPS_JTYPE_KEY);
+      else
+        current = alloc_json(arena, parent, prev, CUPS_JTYPE_STRING);
+
+      if (!current)
+      {
+	DEBUG_puts("2cupsJSONImportString: Unable to allocate key/string node.");
+        goto error;
+      }
 
-      // Find the end of the string...
-      for (s ++, start = s, len = 1; *s && *s != '\"'; s ++, len ++)
+      // Copy and unescape the string in a single pass...
+      current->value.string = strptr;
+
+      for (s ++; *s != '\"'; s ++)
       {
+        if ((n = count_literal(s, (size_t)(end - s))) > 0)
+        {
+          // Copy literal characters...
+          memcpy(strptr, s, n);
+          strptr += n;
+          s      += n;
+
+          if (*s == '\"')
+            break;
+        }
+
         if (*s == '\\')
         {
           // Ensure escaped character is valid...
@@ -817,77 +826,39 @@ cupsJSONImportString(const char *s)	// I - JSON string
 	    DEBUG_printf("2cupsJSONImportString: Bad escape '\\%s'.", s);
             goto invalid;
           }
-        }
-        else if ((*s & 255) < ' ')
-        {
-          // Control characters are not allowed in a string...
-	  DEBUG_printf("2cupsJSONImportString: Bad control character 0x%02x in string.", *s);
-          goto invalid;
-        }
-      }
-
-      if (!*s)
-      {
-        // Missing close quote...
-	DEBUG_puts("2cupsJSONImportString: Missing close quote.");
-        goto invalid;
-      }
 
-      // Allocate and copy the string over...
-      if (parent->type == CUPS_JTYPE_OBJECT && !(count & 1))
-        current = cupsJSONNew(parent, prev, CUPS_JTYPE_KEY);
-      else
-        current = cupsJSONNew(parent, prev, CUPS_JTYPE_STRING);
-
-      if (!current)
-      {
-	DEBUG_puts("2cupsJSONImportString: Unable to allocate key/string node.");
-        goto error;
-      }
-      else if ((current->value.string = malloc(len)) == NULL)
-      {
-        _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(errno), 0);
-        goto error;
-      }
-
-      for (s = start, ptr = current->value.string; *s && *s != '\"'; s ++)
-      {
-        if (*s == '\\')
-        {
           // Copy quoted character...
-          s ++;
-
           if (strchr("\\\"/", *s))
           {
             // Backslash, quote, or slash...
-            *ptr++ = *s;
+            *strptr++ = *s;
           }
           else if (*s == 'b')
           {
             // Backspace
-            *ptr++ = '\b';
+            *strptr++ = '\b';
           }
           else if (*s == 'f')
           {
             // Formfeed
-            *ptr++ = '\f';
+            *strptr++ = '\f';
           }
           else if (*s == 'n')
           {
             // Linefeed
-            *ptr++ = '\n';
+            *strptr++ = '\n';
           }
           else if (*s == 'r')
           {
             // Carriage return
-            *ptr++ = '\r';
+            *strptr++ = '\r';
           }
           else if (*s == 't')
           {
             // Tab
-            *ptr++ = '\t';
+            *strptr++ = '\t';
           }
-          else if (*s == 'u')
+          else
           {
             // Unicode character
             int ch,			// Unicode character
@@ -908,33 +879,39 @@ cupsJSONImportString(const char *s)	// I - JSON string
             if (ch < 0x80)
             {
               // ASCII
-              *ptr++ = (char)ch;
+              *strptr++ = (char)ch;
             }
             else if (ch < 0x800)
             {
               // 2-byte UTF-8
-              *ptr++ = (char)(0xc0 | (ch >> 6));
-              *ptr++ = (char)(0x80 | (ch & 0x3f));
+              *strptr++ = (char)(0xc0 | (ch >> 6));
+              *strptr++ = (char)(0x80 | (ch & 0x3f));
             }
             else
             {
               // 3-byte UTF-8
-              *ptr++ = (char)(0xe0 | (ch >> 12));
-              *ptr++ = (char)(0x80 | ((ch >> 6) & 0x3f));
-              *ptr++ = (char)(0x80 | (ch & 0x3f));
+              *strptr++ = (char)(0xe0 | (ch >> 12));
+              *strptr++ = (char)(0x80 | ((ch >> 6) & 0x3f));
+              *strptr++ = (char)(0x80 | (ch & 0x3f));
             }
           }
         }
+        else if (!*s)
+        {
+          // Missing close quote...
+	  DEBUG_puts("2cupsJSONImportString: Missing close quote.");
+          goto invalid;
+        }
         else
         {
-          // Copy literal character...
-          *ptr++ = *s;
+          // Control characters are not allowed in a string...
+	  DEBUG_printf("2cupsJSONImportString: Bad control character 0x%02x in string.", *s);
+          goto invalid;
         }
       }
 
-      *ptr = '\0';
-      if (*s == '\"')
-        s ++;
+      *strptr++ = '\0';
+      s ++;
 
       count ++;
       prev = current;
@@ -944,10 +921,10 @@ cupsJSONImportString(const char *s)	// I - JSON string
     else if (strchr("0123456789-", *s))
     {
       // Number
-      if ((current = cupsJSONNew(parent, prev, CUPS_JTYPE_NUMBER)) == NULL)
+      if ((current = alloc_json(arena, parent, prev, CUPS_JTYPE_NUMBER)) == NULL)
         goto error;
 
-      current->value.number = _cupsStrScand(s, (char **)&s, loc);
+      current->value.number = _cupsStrScand(s, (char **)&s, NULL);
       count ++;
       prev = current;
 
@@ -956,7 +933,7 @@ cupsJSONImportString(const char *s)	// I - JSON string
     else if (*s == '{')
     {
       // Start object
-      if ((parent = cupsJSONNew(parent, prev, CUPS_JTYPE_OBJECT)) == NULL)
+      if ((parent = alloc_json(arena, parent, prev, CUPS_JTYPE_OBJECT)) == NULL)
       {
         DEBUG_puts("2cupsJSONImportString: Unable to allocate object.");
         goto error;
@@ -990,7 +967,7 @@ cupsJSONImportString(const char *s)	// I - JSON string
     else if (*s == '[')
     {
       // Start array
-      if ((parent = cupsJSONNew(parent, prev, CUPS_JTYPE_ARRAY)) == NULL)
+      if ((parent = alloc_json(arena, parent, prev, CUPS_JTYPE_ARRAY)) == NULL)
       {
         DEBUG_puts("2cupsJSONImportString: Unable to allocate array.");
         goto error;
@@ -1022,7 +999,7 @@ cupsJSONImportString(const char *s)	// I - JSON string
     else if (!strncmp(s, "null", 4) && strchr(sep, s[4]))
     {
       // null value
-      if ((prev = cupsJSONNew(parent, prev, CUPS_JTYPE_NULL)) == NULL)
+      if ((prev = alloc_json(arena, parent, prev, CUPS_JTYPE_NULL)) == NULL)
       {
         DEBUG_puts("2cupsJSONImportString: Unable to allocate null value.");
         goto error;
@@ -1036,7 +1013,7 @@ cupsJSONImportString(const char *s)	// I - JSON string
     else if (!strncmp(s, "false", 5) && strchr(sep, s[5]))
     {
       // false value
-      if ((prev = cupsJSONNew(parent, prev, CUPS_JTYPE_FALSE)) == NULL)
+      if ((prev = alloc_json(arena, parent, prev, CUPS_JTYPE_FALSE)) == NULL)
       {
         DEBUG_puts("2cupsJSONImportString: Unable to allocate false value.");
         goto error;
@@ -1050,7 +1027,7 @@ cupsJSONImportString(const char *s)	// I - JSON string
     else if (!strncmp(s, "true", 4) && strchr(sep, s[4]))
     {
       // true value
-      if ((prev = cupsJSONNew(parent, prev, CUPS_JTYPE_TRUE)) == NULL)
+      if ((prev = alloc_json(arena, parent, prev, CUPS_JTYPE_TRUE)) == NULL)
       {
         DEBUG_puts("2cupsJSONImportString: Unable to allocate true value.");
         goto error;
@@ -1111,6 +1088,12 @@ cupsJSONImportString(const char *s)	// I - JSON string
 // the JSON data has not been updated since the "last_modified" date and time
 // or a suitable `IPP_STATUS_ERROR_` value if an error occurred.
 //
+// Responses are cached in memory and, if a directory has been set with
+// @link cupsJSONSetCacheDirectory@, on disk.  Cached data is returned without
+// contacting the server until the "max-age" from the Cache-Control header
+// expires, after which it is revalidated using the ETag and Last-Modified
+// values from the server.
+//
 
 cups_json_t *				// O  - Root JSON object node
 cupsJSONImportURL(
@@ -1127,15 +1110,23 @@ cupsJSONImportURL(
   http_t	*http;			// HTTP connection
   http_status_t	status;			// HTTP request status
   http_state_t	initial_state;		// Initial HTTP state
-  char		if_modified_since[HTTP_MAX_VALUE];
+  char		if_modified_since[HTTP_MAX_VALUE],
 					// If-Modified-Since header
+		etag[HTTP_MAX_VALUE] = "";
+					// If-None-Match header
   bool		new_auth = false,	// Using new auth information?
-		digest;			// Are we using Digest authentication?
+		digest,			// Are we using Digest authentication?
+		cached = false,		// Is the URL in the cache?
+		store = false;		// Cache the response?
   size_t	length;			// Length of JSON data
   ssize_t	bytes;			// Bytes read
   char		*data = NULL,		// Pointer to data
 		*dataptr,		// Pointer into data
 		*dataend;		// Pointer to end of data (less nul byte)
+  time_t	now = time(NULL),	// Current date/time
+		data_modified = 0,	// Last-Modified date/time of response
+		expires = 0;		// Expiration date/time of response
+  _cups_jcache_t *entry;		// Cache entry
   cups_json_t	*json = NULL;		// Root JSON node
 
 
@@ -1156,21 +1147,46 @@ cupsJSONImportURL(
     return (NULL);
   }
 
+  // Use cached data while it is fresh, otherwise revalidate using its ETag and
+  // Last-Modified values...
+  if (last_modified && *last_modified)
+    httpGetDateString(*last_modified, if_modified_since, sizeof(if_modified_since));
+  else
+    if_modified_since[0] = '\0';
+
+  cupsMutexLock(&json_cache_mutex);
+
+  if ((entry = cache_find(url)) != NULL)
+  {
+    if (entry->expires > now)
+    {
+      json = cache_result(entry, last_modified);
+      cupsMutexUnlock(&json_cache_mutex);
+      return (json);
+    }
+
+    cached = true;
+
+    cupsCopyString(etag, entry->etag ? entry->etag : "", sizeof(etag));
+
+    if (entry->last_modified)
+      httpGetDateString(entry->last_modified, if_modified_since, sizeof(if_modified_since));
+    else
+      if_modified_since[0] = '\0';
+  }
+
+  cupsMutexUnlock(&json_cache_mutex);
+
   // Connect to the server...
   if (!strcmp(scheme, "https") || port == 443)
     encryption = HTTP_ENCRYPTION_ALWAYS;
   else
     encryption = HTTP_ENCRYPTION_IF_REQUESTED;
 
-  if ((http = httpConnect(host, port, NULL, AF_UNSPEC, encryption, true, 30000, NULL)) == NULL)
+  if ((http = httpAcquireConnection(host, port, AF_UNSPEC, encryption, true, 30000, NULL)) == NULL)
     return (NULL);
 
   // Send a GET request for the resource path...
-  if (last_modified && *last_modified)
-    httpGetDateString(*last_modified, if_modified_since, sizeof(if_modified_since));
-  else
-    if_modified_since[0] = '\0';
-
   do
   {
     // Reconnect if the Connection header says "close"...
@@ -1187,6 +1203,7 @@ cupsJSONImportURL(
     // Prep for a request...
     httpClearFields(http);
     httpSetField(http, HTTP_FIELD_IF_MODIFIED_SINCE, if_modified_since);
+    httpSetField(http, HTTP_FIELD_IF_NONE_MATCH, etag);
 
     digest = http->authstring && !strncmp(http->authstring, "Digest ", 7);
 
@@ -1263,17 +1280,27 @@ cupsJSONImportURL(
 
   initial_state = httpGetState(http);
 
+  if (status == HTTP_STATUS_OK || status == HTTP_STATUS_NOT_MODIFIED)
+  {
+    // Get the caching information...
+    expires = cache_expires(httpGetField(http, HTTP_FIELD_CACHE_CONTROL), now, &store);
+
+    cupsCopyString(etag, httpGetField(http, HTTP_FIELD_ETAG), sizeof(etag));
+  }
+
   if (status == HTTP_STATUS_OK)
   {
     // Save the content date...
+    data_modified = httpGetDateTime(httpGetField(http, HTTP_FIELD_LAST_MODIFIED));
+
     if (last_modified)
-      *last_modified = httpGetDateTime(httpGetField(http, HTTP_FIELD_LAST_MODIFIED));
+      *last_modified = data_modified;
 
     // Allocate memory for string...
     if ((length = (size_t)httpGetLength(http)) == 0 || length > 65536)
       length = 65536;			// Accept up to 64k
 
-    if ((data = calloc(1, length + 1)) != NULL)
+    if ((data = _cupsMemCalloc(CUPS_MEMTYPE_JSON, 1, length + 1)) != NULL)
     {
       // Read the data into the string...
       for (dataptr = data, dataend = data + length; dataptr < dataend; dataptr += bytes)
@@ -1283,7 +1310,7 @@ cupsJSONImportURL(
       }
     }
   }
-  else
+  else if (status != HTTP_STATUS_NOT_MODIFIED || !cached)
   {
     // Save the last HTTP status as a CUPS error...
     _cupsSetHTTPError(status);
@@ -1293,14 +1320,43 @@ cupsJSONImportURL(
   if (httpGetState(http) == initial_state)
     httpFlush(http);
 
-  // Close the connection...
-  httpClose(http);
+  // Return the connection to the pool...
+  httpReleaseConnection(http);
+
+  if (status == HTTP_STATUS_NOT_MODIFIED && cached)
+  {
+    // Refresh the cached data...
+    cupsMutexLock(&json_cache_mutex);
+
+    if ((entry = cache_find(url)) != NULL)
+    {
+      if (store)
+        entry->expires = expires;
+
+      json = cache_result(entry, last_modified);
+    }
+    else
+    {
+      _cupsSetHTTPError(status);
+    }
 
-  // Load the JSON data, free the string, and return...
-  if (data)
+    cupsMutexUnlock(&json_cache_mutex);
+  }
+  else if (data)
   {
+    // Load the JSON data and cache or free the string...
     json = cupsJSONImportString(data);
-    free(data);
+
+    if (json && store && (expires > now || etag[0] || data_modified))
+    {
+      cupsMutexLock(&json_cache_mutex);
+      cache_store(url, etag, data_modified, expires, data);
+      cupsMutexUnlock(&json_cache_mutex);
+    }
+    else
+    {
+      _cupsMemFree(data);
+    }
   }
 
   return (json);
@@ -1324,7 +1380,7 @@ cupsJSONNew(cups_json_t  *parent,	// I - Parent JSON node or `NULL` for a root n
     return (NULL);
 
   // Allocate the node...
-  if ((node = calloc(1, sizeof(cups_json_t))) != NULL)
+  if ((node = _cupsMemCalloc(CUPS_MEMTYPE_JSON, 1, sizeof(cups_json_t))) != NULL)
   {
     node->type = type;
 
@@ -1346,16 +1402,28 @@ cupsJSONNewKey(cups_json_t *parent,	// I - Parent JSON node or `NULL` for a root
                const char  *value)	// I - Key string
 {
   cups_json_t	*node;			// JSON node
-  char		*s = strdup(value);	// Key string
+  char		*s;			// Key string
 
 
-  if (!s)
+  // Range check input...
+  if (!value || (parent && parent->type != CUPS_JTYPE_ARRAY && parent->type != CUPS_JTYPE_OBJECT))
     return (NULL);
 
-  if ((node = cupsJSONNew(parent, after, CUPS_JTYPE_KEY)) != NULL)
+  // Create the key and then add it so the parent's key index sees the string...
+  if ((s = _cupsMemStrdup(CUPS_MEMTYPE_JSON, value)) == NULL)
+    return (NULL);
+
+  if ((node = cupsJSONNew(NULL, NULL, CUPS_JTYPE_KEY)) != NULL)
+  {
     node->value.string = s;
+
+    if (parent)
+      cupsJSONAdd(parent, after, node);
+  }
   else
-    free(s);
+  {
+    _cupsMemFree(s);
+  }
 
   return (node);
 }
@@ -1390,7 +1458,7 @@ cupsJSONNewString(cups_json_t *parent,	// I - Parent JSON node or `NULL` for a r
 		  const char  *value)	// I - String value
 {
   cups_json_t	*node;			// JSON node
-  char		*s = strdup(value);	// String value
+  char		*s = _cupsMemStrdup(CUPS_MEMTYPE_JSON, value);	// String value
 
 
   if (!s)
@@ -1399,79 +1467,1210 @@ cupsJSONNewString(cups_json_t *parent,	// I - Parent JSON node or `NULL` for a r
   if ((node = cupsJSONNew(parent, after, CUPS_JTYPE_STRING)) != NULL)
     node->value.string = s;
   else
-    free(s);
+    _cupsMemFree(s);
 
   return (node);
 }
 
 
 //
-// 'delete_json()' - Free the JSON node and its children.
+// 'cupsJSONSetCacheDirectory()' - Set the directory for cached JSON URL data.
+//
+// This function sets a directory where @link cupsJSONImportURL@ keeps copies
+// of cached responses so that they can be reused by other processes and
+// after a restart.  The directory must exist.  Pass `NULL` to cache responses
+// in memory only, which is the default.
 //
 
-static void
-delete_json(cups_json_t *json)		// I - JSON node
+void
+cupsJSONSetCacheDirectory(
+    const char *dir)			// I - Directory or `NULL` for none
 {
-  cups_json_t	*child,			// Child node
-		*sibling;		// Sibling node
+  cupsMutexLock(&json_cache_mutex);
 
+  _cupsMemFree(json_cache_dir);
+  json_cache_dir = dir ? _cupsMemStrdup(CUPS_MEMTYPE_JSON, dir) : NULL;
 
-  if (json->type == CUPS_JTYPE_ARRAY || json->type == CUPS_JTYPE_OBJECT)
+  cupsMutexUnlock(&json_cache_mutex);
+}
+
+
+//
+// 'cupsJSONWriterAddBoolean()' - Write a boolean value.
+//
+
+bool					// O - `true` on success, `false` on error
+cupsJSONWriterAddBoolean(
+    cups_json_writer_t *w,		// I - JSON writer
+    bool               value)		// I - Boolean value
+{
+  if (!writer_value(w))
+    return (false);
+
+  return (value ? writer_data(w, "true", 4) : writer_data(w, "false", 5));
+}
+
+
+//
+// 'cupsJSONWriterAddKey()' - Write an object key.
+//
+// This function writes the key for the next value in the current object.
+//
+
+bool					// O - `true` on success, `false` on error
+cupsJSONWriterAddKey(
+    cups_json_writer_t *w,		// I - JSON writer
+    const char         *key)		// I - Key string
+{
+  unsigned char	*level;			// Current level
+
+
+  if (!w || w->error)
+    return (false);
+
+  if (!key || !w->depth || (w->levels[w->depth - 1] & (_CUPS_JWRITER_OBJECT | _CUPS_JWRITER_KEY)) != _CUPS_JWRITER_OBJECT)
+    return (writer_error(w));
+
+  level = w->levels + w->depth - 1;
+
+  if ((*level & _CUPS_JWRITER_VALUES) && !writer_data(w, ",", 1))
+    return (false);
+
+  *level |= _CUPS_JWRITER_VALUES | _CUPS_JWRITER_KEY;
+
+  return (writer_string(w, key) && writer_data(w, ":", 1));
+}
+
+
+//
+// 'cupsJSONWriterAddNode()' - Write a JSON node tree.
+//
+// This function writes the specified JSON node and all of its children.
+//
+
+bool					// O - `true` on success, `false` on error
+cupsJSONWriterAddNode(
+    cups_json_writer_t *w,		// I - JSON writer
+    cups_json_t        *json)		// I - JSON node
+{
+  cups_json_t	*current;		// Current node
+  bool		ret = true;		// Return value
+
+
+  if (!w || w->error)
+    return (false);
+
+  if (!json)
+    return (writer_error(w));
+
+  for (current = json; current && ret;)
   {
-    for (child = json->value.child; child && child != json; child = sibling)
+    switch (current->type)
     {
-      if ((child->type == CUPS_JTYPE_ARRAY || child->type == CUPS_JTYPE_OBJECT) && child->value.child)
-      {
-        // Descend into child nodes...
-        sibling = child->value.child;
-      }
-      else if ((sibling = child->sibling) == NULL)
-      {
-        // No more silbings, ascend unless the parent is the original node...
-	sibling = child->parent;
-        free_json(child);
+      case CUPS_JTYPE_NULL :
+          ret = cupsJSONWriterAddNull(w);
+          break;
 
-	while (sibling && sibling != json)
-        {
-	  cups_json_t *temp = sibling;	// Save the current pointer
+      case CUPS_JTYPE_TRUE :
+      case CUPS_JTYPE_FALSE :
+          ret = cupsJSONWriterAddBoolean(w, current->type == CUPS_JTYPE_TRUE);
+          break;
 
-          if (sibling->sibling)
-          {
-            // More siblings at this level, free the parent...
-            sibling = sibling->sibling;
-            free_json(temp);
-            break;
-          }
-          else
-          {
-            // No more siblings, continue upwards...
-            sibling = sibling->parent;
-            free_json(temp);
-          }
-        }
-      }
+      case CUPS_JTYPE_ARRAY :
+          ret = cupsJSONWriterStartArray(w);
+          break;
+
+      case CUPS_JTYPE_OBJECT :
+          ret = cupsJSONWriterStartObject(w);
+          break;
+
+      case CUPS_JTYPE_NUMBER :
+          ret = cupsJSONWriterAddNumber(w, current->value.number);
+          break;
+
+      case CUPS_JTYPE_KEY :
+          ret = cupsJSONWriterAddKey(w, current->value.string);
+          break;
+
+      case CUPS_JTYPE_STRING :
+          ret = cupsJSONWriterAddString(w, current->value.string);
+          break;
+    }
+
+    // Get next node...
+    if ((current->type == CUPS_JTYPE_ARRAY || current->type == CUPS_JTYPE_OBJECT) && current->value.child)
+    {
+      // Descend
+      current = current->value.child;
+      continue;
+    }
+
+    // Close an empty array/object...
+    if (current->type == CUPS_JTYPE_ARRAY)
+      ret = ret && cupsJSONWriterEndArray(w);
+    else if (current->type == CUPS_JTYPE_OBJECT)
+      ret = ret && cupsJSONWriterEndObject(w);
+
+    // Visit the next sibling or ascend, closing arrays/objects as we go...
+    while (current != json && !current->sibling && ret)
+    {
+      current = current->parent;
+
+      if (current->type == CUPS_JTYPE_ARRAY)
+        ret = cupsJSONWriterEndArray(w);
       else
-      {
-        // Free the memory for this node
-        free_json(child);
-      }
+        ret = cupsJSONWriterEndObject(w);
     }
+
+    if (current == json)
+      break;
+
+    current = current->sibling;
   }
 
-  free_json(json);
+  return (ret);
 }
 
 
 //
-// 'free_json()' - Free the JSON node.
+// 'cupsJSONWriterAddNull()' - Write a null value.
 //
 
-static void
-free_json(cups_json_t *json)		// I - JSON node
+bool					// O - `true` on success, `false` on error
+cupsJSONWriterAddNull(
+    cups_json_writer_t *w)		// I - JSON writer
 {
-  if (json->type == CUPS_JTYPE_KEY || json->type == CUPS_JTYPE_STRING)
-    free(json->value.string);
+  return (writer_value(w) && writer_data(w, "null", 4));
+}
+
+
+//
+// 'cupsJSONWriterAddNumber()' - Write a number value.
+//
+
+bool					// O - `true` on success, `false` on error
+cupsJSONWriterAddNumber(
+    cups_json_writer_t *w,		// I - JSON writer
+    double             value)		// I - Number value
+{
+  char	buffer[32],			// Number string
+	*bufptr;			// End of number string
+
+
+  if (!writer_value(w))
+    return (false);
+
+  bufptr = _cupsStrFormatd(buffer, buffer + sizeof(buffer), value, NULL);
+
+  return (writer_data(w, buffer, (size_t)(bufptr - buffer)));
+}
+
+
+//
+// 'cupsJSONWriterAddString()' - Write a string value.
+//
+
+bool					// O - `true` on success, `false` on error
+cupsJSONWriterAddString(
+    cups_json_writer_t *w,		// I - JSON writer
+    const char         *value)		// I - String value
+{
+  if (!value)
+    return (writer_error(w));
+
+  return (writer_value(w) && writer_string(w, value));
+}
+
+
+//
+// 'cupsJSONWriterDelete()' - Finish writing and free a JSON writer.
+//
+// This function frees the memory used by a JSON writer.  The output file, if
+// any, is not closed.
+//
+// `true` is returned if every write succeeded and a complete JSON value was
+// written.
+//
+
+bool					// O - `true` if output is complete, `false` otherwise
+cupsJSONWriterDelete(
+    cups_json_writer_t *w)		// I - JSON writer
+{
+  bool	ret;				// Return value
+
+
+  if (!w)
+    return (false);
+
+  if ((ret = !w->error && w->done && !w->depth) == false && !w->error)
+    _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(EINVAL), 0);
+
+  _cupsMemFree(w->buffer);
+  _cupsMemFree(w);
+
+  return (ret);
+}
+
+
+//
+// 'cupsJSONWriterEndArray()' - Finish an array.
+//
+
+bool					// O - `true` on success, `false` on error
+cupsJSONWriterEndArray(
+    cups_json_writer_t *w)		// I - JSON writer
+{
+  if (!w || w->error)
+    return (false);
+
+  if (!w->depth || (w->levels[w->depth - 1] & _CUPS_JWRITER_OBJECT))
+    return (writer_error(w));
+
+  w->depth --;
+
+  if (!w->depth)
+    w->done = true;
 
-  free(json);
+  return (writer_data(w, "]", 1));
 }
 
+
+//
+// 'cupsJSONWriterEndObject()' - Finish an object.
+//
+
+bool					// O - `true` on success, `false` on error
+cupsJSONWriterEndObject(
+    cups_json_writer_t *w)		// I - JSON writer
+{
+  if (!w || w->error)
+    return (false);
+
+  if (!w->depth || (w->levels[w->depth - 1] & (_CUPS_JWRITER_OBJECT | _CUPS_JWRITER_KEY)) != _CUPS_JWRITER_OBJECT)
+    return (writer_error(w));
+
+  w->depth --;
+
+  if (!w->depth)
+    w->done = true;
+
+  return (writer_data(w, "}", 1));
+}
+
+
+//
+// 'cupsJSONWriterGetString()' - Get the JSON written to a string.
+//
+// This function returns the JSON written so far by a writer created with a
+// `NULL` file.  The string is valid until the next write or until the writer
+// is deleted.
+//
+
+const char *				// O - JSON string or `NULL` if none
+cupsJSONWriterGetString(
+    cups_json_writer_t *w)		// I - JSON writer
+{
+  return (w && !w->fp ? (w->buffer ? w->buffer : "") : NULL);
+}
+
+
+//
+// 'cupsJSONWriterNew()' - Create a JSON writer.
+//
+// This function creates a writer that formats JSON data directly, without
+// building a tree of JSON nodes.  The "fp" argument specifies a file to write
+// to, or `NULL` to write to a string that is returned by
+// @link cupsJSONWriterGetString@.
+//
+// Values are written using the `cupsJSONWriterAdd` functions, while arrays and
+// objects are written using the `cupsJSONWriterStart` and `cupsJSONWriterEnd`
+// functions.  Object values must be preceded by a call to
+// @link cupsJSONWriterAddKey@.
+//
+
+cups_json_writer_t *			// O - JSON writer or `NULL` on error
+cupsJSONWriterNew(cups_file_t *fp)	// I - Output file or `NULL` for a string
+{
+  cups_json_writer_t	*w;		// JSON writer
+
+
+  if ((w = _cupsMemCalloc(CUPS_MEMTYPE_JSON, 1, sizeof(cups_json_writer_t))) == NULL)
+  {
+    _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(errno), 0);
+    return (NULL);
+  }
+
+  w->fp = fp;
+
+  return (w);
+}
+
+
+//
+// 'cupsJSONWriterStartArray()' - Start an array.
+//
+
+bool					// O - `true` on success, `false` on error
+cupsJSONWriterStartArray(
+    cups_json_writer_t *w)		// I - JSON writer
+{
+  if (!writer_value(w))
+    return (false);
+
+  if (w->depth >= _CUPS_JSON_MAX_DEPTH)
+    return (writer_error(w));
+
+  w->levels[w->depth ++] = 0;
+
+  return (writer_data(w, "[", 1));
+}
+
+
+//
+// 'cupsJSONWriterStartObject()' - Start an object.
+//
+
+bool					// O - `true` on success, `false` on error
+cupsJSONWriterStartObject(
+    cups_json_writer_t *w)		// I - JSON writer
+{
+  if (!writer_value(w))
+    return (false);
+
+  if (w->depth >= _CUPS_JSON_MAX_DEPTH)
+    return (writer_error(w));
+
+  w->levels[w->depth ++] = _CUPS_JWRITER_OBJECT;
+
+  return (writer_data(w, "{", 1));
+}
+
+
+//
+// 'alloc_json()' - Allocate a JSON node from an arena.
+//
+
+static cups_json_t *			// O - JSON node or `NULL` on error
+alloc_json(_cups_jarena_t *arena,	// I - Node arena
+           cups_json_t    *parent,	// I - Parent JSON node or `NULL` for the root node
+           cups_json_t    *after,	// I - Previous sibling node or `NULL` to append to the end
+           cups_jtype_t   type)		// I - JSON node type
+{
+  _cups_jarena_t	*block;		// Current block
+  cups_json_t		*node;		// JSON node
+
+
+  // Overflow blocks are inserted after the first block, so the newest block
+  // is always arena->next...
+  if ((block = arena->next) == NULL)
+    block = arena;
+
+  if (block->num_nodes >= block->alloc_nodes)
+  {
+    size_t alloc_nodes = 2 * block->alloc_nodes;
+					// Number of nodes in new block
+
+    if ((block = _cupsMemCalloc(CUPS_MEMTYPE_JSON, 1, sizeof(_cups_jarena_t) + alloc_nodes * sizeof(cups_json_t))) == NULL)
+    {
+      _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(errno), 0);
+      return (NULL);
+    }
+
+    block->nodes       = (cups_json_t *)(block + 1);
+    block->alloc_nodes = alloc_nodes;
+    block->next        = arena->next;
+    arena->next        = block;
+  }
+
+  node        = block->nodes + block->num_nodes ++;
+  node->type  = type;
+  node->arena = arena;
+
+  if (parent)
+    cupsJSONAdd(parent, after, node);
+
+  return (node);
+}
+
+
+//
+// 'cache_expires()' - Get the expiration date/time from a Cache-Control value.
+//
+// Responses without a "max-age" directive, or with "no-cache", expire
+// immediately and are revalidated on the next request.
+//
+
+static time_t				// O - Expiration date/time
+cache_expires(const char *cache_control,// I - Cache-Control value or `NULL`
+              time_t     now,		// I - Current date/time
+              bool       *store)	// O - `true` if the response can be cached
+{
+  const char	*ptr;			// Pointer into value
+  long		max_age = 0;		// max-age value
+
+
+  *store = true;
+
+  if (!cache_control)
+    return (now);
+
+  for (ptr = cache_control; *ptr;)
+  {
+    // Skip whitespace and commas...
+    while (*ptr == ',' || isspace(*ptr & 255))
+      ptr ++;
+
+    if (!_cups_strncasecmp(ptr, "no-store", 8))
+      *store = false;
+    else if (!_cups_strncasecmp(ptr, "no-cache", 8))
+      max_age = -1;
+    else if (!_cups_strncasecmp(ptr, "max-age=", 8) && max_age >= 0)
+      max_age = strtol(ptr + 8, NULL, 10);
+
+    // Skip to the next directive...
+    while (*ptr && *ptr != ',')
+      ptr ++;
+  }
+
+  return (max_age > 0 ? now + max_age : now);
+}
+
+
+//
+// 'cache_find()' - Find a URL in the cache.
+//
+// The caller must hold the cache mutex.  URLs that are not in memory are
+// loaded from the cache directory, if any.
+//
+
+static _cups_jcache_t *			// O - Cache entry or `NULL`
+cache_find(const char *url)		// I - URL
+{
+  size_t	i;			// Looping var
+  _cups_jcache_t *entry;		// Current entry
+  char		filename[1024],		// Cache filename
+		line[2048],		// Line from file
+		*value,			// Value from line
+		*etag = NULL,		// ETag value
+		*data = NULL;		// JSON data
+  time_t	last_modified = 0,	// Last-Modified value
+		expires = 0;		// Expiration date/time
+  bool		match = false;		// Does the URL match?
+  cups_file_t	*fp;			// Cache file
+  size_t	datalen = 0;		// Length of JSON data
+  ssize_t	bytes;			// Bytes read
+
+
+  for (i = 0, entry = json_cache; i < _CUPS_JSON_CACHE_MAX; i ++, entry ++)
+  {
+    if (entry->url && !strcmp(entry->url, url))
+    {
+      entry->used = ++ json_cache_used;
+      return (entry);
+    }
+  }
+
+  // Look for a cache file...
+  if (!json_cache_dir || !cache_path(filename, sizeof(filename), url) || (fp = cupsFileOpen(filename, "r")) == NULL)
+    return (NULL);
+
+  while (cupsFileGets(fp, line, sizeof(line)) && line[0])
+  {
+    if ((value = strchr(line, ' ')) == NULL)
+      continue;
+
+    *value++ = '\0';
+
+    if (!strcmp(line, "URL:"))
+      match = !strcmp(value, url);
+    else if (!strcmp(line, "ETag:") && !etag)
+      etag = _cupsMemStrdup(CUPS_MEMTYPE_JSON, value);
+    else if (!strcmp(line, "Last-Modified:"))
+      last_modified = (time_t)strtoll(value, NULL, 10);
+    else if (!strcmp(line, "Expires:"))
+      expires = (time_t)strtoll(value, NULL, 10);
+  }
+
+  if (match && (data = _cupsMemAlloc(CUPS_MEMTYPE_JSON, 65537)) != NULL)
+  {
+    while (datalen < 65536 && (bytes = cupsFileRead(fp, data + datalen, 65536 - datalen)) > 0)
+      datalen += (size_t)bytes;
+
+    data[datalen] = '\0';
+  }
+
+  cupsFileClose(fp);
+
+  if (!data || !datalen)
+  {
+    _cupsMemFree(etag);
+    _cupsMemFree(data);
+    return (NULL);
+  }
+
+  // Add it to the memory cache...
+  cache_store(url, etag, last_modified, expires, data);
+  _cupsMemFree(etag);
+
+  for (i = 0, entry = json_cache; i < _CUPS_JSON_CACHE_MAX; i ++, entry ++)
+  {
+    if (entry->url && !strcmp(entry->url, url))
+      return (entry);
+  }
+
+  return (NULL);
+}
+
+
+//
+// 'cache_path()' - Make the filename for a cached URL.
+//
+
+static char *				// O - Filename or `NULL` on error
+cache_path(char       *buffer,		// I - Filename buffer
+           size_t     bufsize,		// I - Size of filename buffer
+           const char *url)		// I - URL
+{
+  unsigned char	hash[32];		// SHA-256 hash of URL
+  char		hashstr[65];		// Hex string
+
+
+  if (cupsHashData("sha2-256", url, strlen(url), hash, sizeof(hash)) < 0)
+    return (NULL);
+
+  snprintf(buffer, bufsize, "%s/%s.json", json_cache_dir, cupsHashString(hash, sizeof(hash), hashstr, sizeof(hashstr)));
+
+  return (buffer);
+}
+
+
+//
+// 'cache_result()' - Return cached JSON data.
+//
+// The caller must hold the cache mutex.
+//
+
+static cups_json_t *			// O - Root JSON object node or `NULL`
+cache_result(_cups_jcache_t *entry,	// I  - Cache entry
+             time_t         *last_modified)
+					// IO - Last modified date/time or `NULL`
+{
+  if (last_modified && *last_modified && entry->last_modified && *last_modified >= entry->last_modified)
+  {
+    // The caller already has this data...
+    _cupsSetHTTPError(HTTP_STATUS_NOT_MODIFIED);
+    return (NULL);
+  }
+
+  if (last_modified)
+    *last_modified = entry->last_modified;
+
+  return (cupsJSONImportString(entry->data));
+}
+
+
+//
+// 'cache_store()' - Add or replace a URL in the cache.
+//
+// The caller must hold the cache mutex.  The "data" string is owned by the
+// cache afterwards.
+//
+
+static void
+cache_store(const char *url,		// I - URL
+            const char *etag,		// I - ETag value or `NULL`
+            time_t     last_modified,	// I - Last-Modified date/time
+            time_t     expires,		// I - Expiration date/time
+            char       *data)		// I - JSON data
+{
+  size_t	i;			// Looping var
+  _cups_jcache_t *entry,		// Current entry
+		*oldest = NULL;		// Entry to replace
+  char		filename[1024];		// Cache filename
+  cups_file_t	*fp;			// Cache file
+
+
+  // Find the existing or least-recently used entry...
+  for (i = 0, entry = json_cache; i < _CUPS_JSON_CACHE_MAX; i ++, entry ++)
+  {
+    if (!entry->url || !strcmp(entry->url, url))
+    {
+      oldest = entry;
+      break;
+    }
+    else if (!oldest || entry->used < oldest->used)
+    {
+      oldest = entry;
+    }
+  }
+
+  _cupsMemFree(oldest->url);
+  _cupsMemFree(oldest->etag);
+  _cupsMemFree(oldest->data);
+
+  oldest->url           = _cupsMemStrdup(CUPS_MEMTYPE_JSON, url);
+  oldest->etag          = etag && *etag ? _cupsMemStrdup(CUPS_MEMTYPE_JSON, etag) : NULL;
+  oldest->data          = data;
+  oldest->last_modified = last_modified;
+  oldest->expires       = expires;
+  oldest->used          = ++ json_cache_used;
+
+  if (!oldest->url)
+  {
+    _cupsMemFree(oldest->etag);
+    _cupsMemFree(oldest->data);
+    memset(oldest, 0, sizeof(_cups_jcache_t));
+    return;
+  }
+
+  // Save a copy in the cache directory, if any...
+  if (json_cache_dir && cache_path(filename, sizeof(filename), url) && (fp = cupsFileOpen(filename, "w")) != NULL)
+  {
+    cupsFilePrintf(fp, "URL: %s\n", url);
+    if (oldest->etag)
+      cupsFilePrintf(fp, "ETag: %s\n", oldest->etag);
+    cupsFilePrintf(fp, "Last-Modified: %ld\nExpires: %ld\n\n", (long)last_modified, (long)expires);
+    cupsFilePuts(fp, data);
+
+    if (!cupsFileClose(fp))
+      unlink(filename);
+  }
+}
+
+
+//
+// 'count_literal()' - Count the leading characters of a string value that can
+//                     be copied as-is.
+//
+// Copying stops at a quote, backslash, or control character (which includes
+// the nul terminator).
+//
+
+static size_t				// O - Number of literal characters
+count_literal(const char *s,		// I - String
+              size_t     len)		// I - Number of characters to check
+{
+  size_t	count = 0;		// Number of literal characters
+
+
+#ifdef __SSE2__
+  // Check 16 characters at a time...
+  const __m128i	quote = _mm_set1_epi8('\"'),
+		bslash = _mm_set1_epi8('\\'),
+		ctrl = _mm_set1_epi8(0x1f);
+
+  for (; (count + 16) <= len; count += 16)
+  {
+    __m128i v = _mm_loadu_si128((const __m128i *)(s + count));
+					// Current characters
+
+    if (_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, bslash)), _mm_cmpeq_epi8(_mm_max_epu8(v, ctrl), ctrl))))
+      break;
+  }
+
+#elif defined(_CUPS_JSON_NEON)
+  // Check 16 characters at a time...
+  const uint8x16_t	quote = vdupq_n_u8('\"'),
+			bslash = vdupq_n_u8('\\'),
+			space = vdupq_n_u8(' ');
+
+  for (; (count + 16) <= len; count += 16)
+  {
+    uint8x16_t v = vld1q_u8((const uint8_t *)s + count);
+					// Current characters
+
+    if (vmaxvq_u8(vorrq_u8(vorrq_u8(vceqq_u8(v, quote), vceqq_u8(v, bslash)), vcltq_u8(v, space))))
+      break;
+  }
+#endif // __SSE2__
+
+  // Check the remaining characters one at a time...
+  while (count < len && s[count] != '\"' && s[count] != '\\' && (s[count] & 255) >= ' ')
+    count ++;
+
+  return (count);
+}
+
+
+//
+// 'delete_json()' - Free the JSON node and its children.
+//
+
+static void
+delete_json(cups_json_t *json)		// I - JSON node
+{
+  cups_json_t	*child,			// Child node
+		*sibling;		// Sibling node
+
+
+  if (json->type == CUPS_JTYPE_ARRAY || json->type == CUPS_JTYPE_OBJECT)
+  {
+    for (child = json->value.child; child && child != json; child = sibling)
+    {
+      if ((child->type == CUPS_JTYPE_ARRAY || child->type == CUPS_JTYPE_OBJECT) && child->value.child)
+      {
+        // Descend into child nodes...
+        sibling = child->value.child;
+      }
+      else if ((sibling = child->sibling) == NULL)
+      {
+        // No more silbings, ascend unless the parent is the original node...
+	sibling = child->parent;
+        free_json(child);
+
+	while (sibling && sibling != json)
+        {
+	  cups_json_t *temp = sibling;	// Save the current pointer
+
+          if (sibling->sibling)
+          {
+            // More siblings at this level, free the parent...
+            sibling = sibling->sibling;
+            free_json(temp);
+            break;
+          }
+          else
+          {
+            // No more siblings, continue upwards...
+            sibling = sibling->parent;
+            free_json(temp);
+          }
+        }
+      }
+      else
+      {
+        // Free the memory for this node
+        free_json(child);
+      }
+    }
+  }
+
+  free_json(json);
+}
+
+
+//
+// 'free_json()' - Free the JSON node.
+//
+
+static void
+free_json(cups_json_t *json)		// I - JSON node
+{
+  _cups_jarena_t	*arena,		// Node arena
+			*next;		// Next block
+
+
+  if (json->index)
+    index_free(json);
+
+  if ((arena = json->arena) != NULL)
+  {
+    // Arena nodes are freed all at once with the root node, which is always
+    // freed after its children...
+    if (json == arena->nodes)
+    {
+      for (; arena; arena = next)
+      {
+        next = arena->next;
+        _cupsMemFree(arena);
+      }
+    }
+
+    return;
+  }
+
+  if (json->type == CUPS_JTYPE_KEY || json->type == CUPS_JTYPE_STRING)
+    _cupsMemFree(json->value.string);
+
+  _cupsMemFree(json);
+}
+
+
+//
+// 'index_add()' - Add a key to an object's index.
+//
+
+static void
+index_add(cups_json_t *json,		// I - JSON object node
+          cups_json_t *key)		// I - JSON key node
+{
+  _cups_jindex_t	*index = json->index;
+					// Key index
+  size_t		slot;		// Current slot
+
+
+  if (!key->value.string)
+  {
+    // No key string yet, rebuild the index on the next lookup...
+    index_free(json);
+    return;
+  }
+
+  if (2 * (index->num_keys + 1) > index->mask + 1)
+  {
+    // Grow the hash table...
+    cups_json_t	**keys,			// New hash table
+		**oldkey;		// Current old key
+    size_t	i,			// Looping var
+		mask = 2 * index->mask + 1;
+					// New hash table mask
+
+    if ((keys = _cupsMemCalloc(CUPS_MEMTYPE_JSON, mask + 1, sizeof(cups_json_t *))) == NULL)
+    {
+      index_free(json);
+      return;
+    }
+
+    for (i = index->mask + 1, oldkey = index->keys; i > 0; i --, oldkey ++)
+    {
+      if (*oldkey)
+      {
+        for (slot = index_hash((*oldkey)->value.string) & mask; keys[slot]; slot = (slot + 1) & mask);
+        keys[slot] = *oldkey;
+      }
+    }
+
+    _cupsMemFree(index->keys);
+    index->keys = keys;
+    index->mask = mask;
+  }
+
+  for (slot = index_hash(key->value.string) & index->mask; index->keys[slot]; slot = (slot + 1) & index->mask)
+  {
+    if (!strcmp(key->value.string, index->keys[slot]->value.string))
+    {
+      // Duplicate key, rebuild the index in object order on the next lookup...
+      index_free(json);
+      return;
+    }
+  }
+
+  index->keys[slot] = key;
+  index->num_keys ++;
+}
+
+
+//
+// 'index_build()' - Build the key index for an object.
+//
+// The first of any duplicate keys is indexed, matching a linear search.
+//
+
+static void
+index_build(cups_json_t *json)		// I - JSON object node
+{
+  _cups_jindex_t	*index;		// Key index
+  cups_json_t		*current;	// Current child node
+  size_t		num_keys = 0,	// Number of keys
+			table_size,	// Size of hash table
+			slot;		// Current slot
+
+
+  for (current = json->value.child; current; current = current->sibling)
+  {
+    if (current->type == CUPS_JTYPE_KEY)
+    {
+      if (!current->value.string)
+        return;
+
+      num_keys ++;
+    }
+  }
+
+  for (table_size = 64; table_size < 2 * num_keys; table_size *= 2);
+
+  if ((index = _cupsMemCalloc(CUPS_MEMTYPE_JSON, 1, sizeof(_cups_jindex_t))) == NULL)
+    return;
+
+  if ((index->keys = _cupsMemCalloc(CUPS_MEMTYPE_JSON, table_size, sizeof(cups_json_t *))) == NULL)
+  {
+    _cupsMemFree(index);
+    return;
+  }
+
+  index->mask = table_size - 1;
+
+  for (current = json->value.child; current; current = current->sibling)
+  {
+    index->last = current;
+
+    if (current->type != CUPS_JTYPE_KEY)
+      continue;
+
+    for (slot = index_hash(current->value.string) & index->mask; index->keys[slot]; slot = (slot + 1) & index->mask)
+    {
+      if (!strcmp(current->value.string, index->keys[slot]->value.string))
+        break;
+    }
+
+    if (index->keys[slot])
+    {
+      index->dups = true;
+    }
+    else
+    {
+      index->keys[slot] = current;
+      index->num_keys ++;
+    }
+  }
+
+  json->index = index;
+}
+
+
+//
+// 'index_free()' - Free the key index for an object.
+//
+
+static void
+index_free(cups_json_t *json)		// I - JSON object node
+{
+  _cupsMemFree(json->index->keys);
+  _cupsMemFree(json->index);
+
+  json->index = NULL;
+}
+
+
+//
+// 'index_hash()' - Compute the hash of a key string.
+//
+
+static size_t				// O - Hash value
+index_hash(const char *key)		// I - Key string
+{
+  size_t	hash = 2166136261U;	// Hash value
+
+
+  // FNV-1a hash...
+  while (*key)
+    hash = (hash ^ (*key++ & 255)) * 16777619U;
+
+  return (hash);
+}
+
+
+//
+// 'index_remove()' - Remove a key from an object's index.
+//
+
+static void
+index_remove(cups_json_t *json,		// I - JSON object node
+             cups_json_t *key)		// I - JSON key node
+{
+  _cups_jindex_t	*index = json->index;
+					// Key index
+  size_t		slot,		// Current slot
+			next,		// Next slot
+			home;		// Home slot of next key
+
+
+  if (index->dups || !key->value.string)
+  {
+    // A duplicate key may become visible, rebuild on the next lookup...
+    index_free(json);
+    return;
+  }
+
+  for (slot = index_hash(key->value.string) & index->mask; index->keys[slot] && index->keys[slot] != key; slot = (slot + 1) & index->mask);
+
+  if (!index->keys[slot])
+    return;
+
+  // Remove the key and shift back any keys that probed past it...
+  index->keys[slot] = NULL;
+  index->num_keys --;
+
+  for (next = (slot + 1) & index->mask; index->keys[next]; next = (next + 1) & index->mask)
+  {
+    home = index_hash(index->keys[next]->value.string) & index->mask;
+
+    if (((next - home) & index->mask) >= ((next - slot) & index->mask))
+    {
+      index->keys[slot] = index->keys[next];
+      index->keys[next] = NULL;
+      slot              = next;
+    }
+  }
+}
+
+
+//
+// 'writer_data()' - Write data to the JSON file or string.
+//
+
+static bool				// O - `true` on success, `false` on error
+writer_data(cups_json_writer_t *w,	// I - JSON writer
+            const char         *s,	// I - Data
+            size_t             len)	// I - Length of data
+{
+  if (w->fp)
+  {
+    if (!cupsFileWrite(w->fp, s, len))
+    {
+      w->error = true;
+      return (false);
+    }
+  }
+  else
+  {
+    if ((w->bufused + len) >= w->bufsize)
+    {
+      // Grow the string buffer...
+      char	*buffer;		// New buffer
+      size_t	bufsize;		// New size
+
+      for (bufsize = w->bufsize ? 2 * w->bufsize : 1024; (w->bufused + len) >= bufsize; bufsize *= 2);
+
+      if ((buffer = _cupsMemRealloc(CUPS_MEMTYPE_JSON, w->buffer, bufsize)) == NULL)
+      {
+        _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(errno), 0);
+        w->error = true;
+        return (false);
+      }
+
+      w->buffer  = buffer;
+      w->bufsize = bufsize;
+    }
+
+    memcpy(w->buffer + w->bufused, s, len);
+    w->bufused += len;
+    w->buffer[w->bufused] = '\0';
+  }
+
+  return (true);
+}
+
+
+//
+// 'writer_error()' - Record an invalid JSON writer call.
+//
+
+static bool				// O - `false`
+writer_error(cups_json_writer_t *w)	// I - JSON writer
+{
+  if (w)
+    w->error = true;
+
+  _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(EINVAL), 0);
+
+  return (false);
+}
+
+
+//
+// 'writer_string()' - Write a quoted and escaped string.
+//
+
+static bool				// O - `true` on success, `false` on error
+writer_string(cups_json_writer_t *w,	// I - JSON writer
+              const char         *s)	// I - String
+{
+  size_t	len = strlen(s),	// Length of string
+		n;			// Number of literal characters
+  char		temp[7];		// Escaped character
+
+
+  if (!writer_data(w, "\"", 1))
+    return (false);
+
+  while (len > 0)
+  {
+    // Copy literal characters...
+    if ((n = count_literal(s, len)) > 0)
+    {
+      if (!writer_data(w, s, n))
+        return (false);
+
+      s   += n;
+      len -= n;
+
+      if (!len)
+        break;
+    }
+
+    // Quote/escape as needed...
+    temp[0] = '\\';
+    temp[2] = '\0';
+
+    switch (*s)
+    {
+      case '\\' :
+      case '\"' :
+          temp[1] = *s;
+          break;
+      case '\b' :
+          temp[1] = 'b';
+          break;
+      case '\f' :
+          temp[1] = 'f';
+          break;
+      case '\n' :
+          temp[1] = 'n';
+          break;
+      case '\r' :
+          temp[1] = 'r';
+          break;
+      case '\t' :
+          temp[1] = 't';
+          break;
+      default :
+          snprintf(temp, sizeof(temp), "\\u%04x", *s & 255);
+          break;
+    }
+
+    if (!writer_data(w, temp, strlen(temp)))
+      return (false);
+
+    s ++;
+    len --;
+  }
+
+  return (writer_data(w, "\"", 1));
+}
+
+
+//
+// 'writer_value()' - Prepare to write a value.
+//
+
+static bool				// O - `true` on success, `false` on error
+writer_value(cups_json_writer_t *w)	// I - JSON writer
+{
+  unsigned char	*level;			// Current level
+
+
+  if (!w || w->error)
+    return (false);
+
+  if (!w->depth)
+  {
+    // Only one root value is allowed...
+    if (w->done)
+      return (writer_error(w));
+
+    w->done = true;
+    return (true);
+  }
+
+  level = w->levels + w->depth - 1;
+
+  if (*level & _CUPS_JWRITER_OBJECT)
+  {
+    // Object values must follow a key...
+    if (!(*level & _CUPS_JWRITER_KEY))
+      return (writer_error(w));
+
+    *level &= (unsigned char)~_CUPS_JWRITER_KEY;
+  }
+  else if (*level & _CUPS_JWRITER_VALUES)
+  {
+    // Separate array values with commas...
+    if (!writer_data(w, ",", 1))
+      return (false);
+  }
+
+  *level |= _CUPS_JWRITER_VALUES;
+
+  return (true);
+}
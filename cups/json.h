@@ -9,7 +9,7 @@
 
 #ifndef _CUPS_JSON_H_
 #  define _CUPS_JSON_H_
-#  include "base.h"
+#  include "file.h"
 #  ifdef __cplusplus
 extern "C" {
 #  endif /* __cplusplus */
@@ -33,6 +33,9 @@ typedef enum cups_jtype_e		// JSON node type
 
 typedef struct _cups_json_s cups_json_t;// JSON node
 
+typedef struct _cups_json_writer_s cups_json_writer_t;
+					// JSON writer
+
 
 //
 // Functions...
@@ -65,6 +68,22 @@ extern cups_json_t	*cupsJSONNewKey(cups_json_t *parent, cups_json_t *after, cons
 extern cups_json_t	*cupsJSONNewNumber(cups_json_t *parent, cups_json_t *after, double number) _CUPS_PUBLIC;
 extern cups_json_t	*cupsJSONNewString(cups_json_t *parent, cups_json_t *after, const char *value) _CUPS_PUBLIC;
 
+extern void		cupsJSONSetCacheDirectory(const char *dir) _CUPS_PUBLIC;
+
+extern bool		cupsJSONWriterAddBoolean(cups_json_writer_t *w, bool value) _CUPS_PUBLIC;
+extern bool		cupsJSONWriterAddKey(cups_json_writer_t *w, const char *key) _CUPS_PUBLIC;
+extern bool		cupsJSONWriterAddNode(cups_json_writer_t *w, cups_json_t *json) _CUPS_PUBLIC;
+extern bool		cupsJSONWriterAddNull(cups_json_writer_t *w) _CUPS_PUBLIC;
+extern bool		cupsJSONWriterAddNumber(cups_json_writer_t *w, double value) _CUPS_PUBLIC;
+extern bool		cupsJSONWriterAddString(cups_json_writer_t *w, const char *value) _CUPS_PUBLIC;
+extern bool		cupsJSONWriterDelete(cups_json_writer_t *w) _CUPS_PUBLIC;
+extern bool		cupsJSONWriterEndArray(cups_json_writer_t *w) _CUPS_PUBLIC;
+extern bool		cupsJSONWriterEndObject(cups_json_writer_t *w) _CUPS_PUBLIC;
+extern const char	*cupsJSONWriterGetString(cups_json_writer_t *w) _CUPS_PUBLIC;
+extern cups_json_writer_t *cupsJSONWriterNew(cups_file_t *fp) _CUPS_PUBLIC;
+extern bool		cupsJSONWriterStartArray(cups_json_writer_t *w) _CUPS_PUBLIC;
+extern bool		cupsJSONWriterStartObject(cups_json_writer_t *w) _CUPS_PUBLIC;
+
 
 #  ifdef __cplusplus
 }
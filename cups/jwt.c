@@ -25,7 +25,10 @@
 // Constants...
 //
 
+#define _CUPS_JWT_MAX_KEYS	16	// Maximum number of cached keys
 #define _CUPS_JWT_MAX_SIGNATURE	2048	// Enough for 512-bit signature
+#define _CUPS_JWT_MAX_TOKENS	256	// Maximum number of cached verified tokens
+#define _CUPS_JWT_TOKEN_TTL	3600	// Maximum time to cache a verified token
 
 
 //
@@ -44,6 +47,25 @@ struct _cups_jwt_s			// JWT object
   unsigned char	*signature;		// Signature
 };
 
+typedef struct _cups_jwt_key_s		// Cached public or private key
+{
+  unsigned char	thumbprint[32];		// SHA-256 JWK thumbprint
+  size_t	used;			// Last use counter
+#ifdef HAVE_OPENSSL
+  RSA		*rsa;			// RSA public or private key
+  EC_KEY	*ec;			// ECDSA public or private key
+#else // HAVE_GNUTLS
+  gnutls_pubkey_t key;			// Public key
+  gnutls_privkey_t privkey;		// Private key
+#endif // HAVE_OPENSSL
+} _cups_jwt_key_t;
+
+typedef struct _cups_jwt_token_s	// Cached verified token
+{
+  unsigned char	token[32];		// SHA-256 of signing input, signature, and key thumbprint
+  time_t	expires;		// Expiration date/time
+} _cups_jwt_token_t;
+
 
 //
 // Local globals...
@@ -75,18 +97,32 @@ static const char * const cups_jwa_algorithms[CUPS_JWA_MAX] =
   "sha2-384",
   "sha2-512"
 };
+static cups_mutex_t	jwt_cache_mutex = CUPS_MUTEX_INITIALIZER;
+					// Mutex for key and token caches
+static _cups_jwt_key_t	jwt_keys[_CUPS_JWT_MAX_KEYS];
+					// Cached public and private keys
+static size_t		jwt_keys_used = 0;
+					// Key use counter
+static _cups_jwt_token_t jwt_tokens[_CUPS_JWT_MAX_TOKENS];
+					// Cached verified tokens
 
 
 //
 // Local functions...
 //
 
+static _cups_jwt_key_t *find_key(const unsigned char *thumbprint, bool create);
+static bool	find_verified(const unsigned char *token);
 #ifdef HAVE_OPENSSL
+static EC_KEY	*get_ec_key(cups_json_t *jwk, const unsigned char *thumbprint, bool verify);
+static RSA	*get_rsa(cups_json_t *jwk, const unsigned char *thumbprint);
 static BIGNUM	*make_bignum(cups_json_t *jwk, const char *key);
 static void	make_bnstring(const BIGNUM *bn, char *buffer, size_t bufsize);
 static EC_KEY	*make_ec_key(cups_json_t *jwk, bool verify);
 static RSA	*make_rsa(cups_json_t *jwk);
 #else // HAVE_GNUTLS
+static gnutls_privkey_t get_private_key(cups_json_t *jwk, const unsigned char *thumbprint);
+static gnutls_pubkey_t get_public_key(cups_json_t *jwk, const unsigned char *thumbprint);
 static gnutls_datum_t *make_datum(cups_json_t *jwk, const char *key);
 static void	make_datstring(gnutls_datum_t *d, char *buffer, size_t bufsize);
 static gnutls_privkey_t make_private_key(cups_json_t *jwk);
@@ -94,6 +130,10 @@ static gnutls_pubkey_t make_public_key(cups_json_t *jwk);
 #endif // HAVE_OPENSSL
 static bool	make_signature(cups_jwt_t *jwt, cups_jwa_t alg, cups_json_t *jwk, unsigned char *signature, size_t *sigsize, const char **sigkid);
 static char	*make_string(cups_jwt_t *jwt, bool with_signature);
+static bool	make_private_thumbprint(cups_json_t *jwk, unsigned char *thumbprint);
+static bool	make_thumbprint(cups_json_t *jwk, unsigned char *thumbprint);
+static void	make_token_id(cups_jwt_t *jwt, const char *text, size_t text_len, const unsigned char *thumbprint, unsigned char *token);
+static void	save_verified(cups_jwt_t *jwt, const unsigned char *token);
 
 
 //
@@ -106,12 +146,12 @@ cupsJWTDelete(cups_jwt_t *jwt)		// I - JWT object
   if (jwt)
   {
     cupsJSONDelete(jwt->jose);
-    free(jwt->jose_string);
+    _cupsMemFree(jwt->jose_string);
     cupsJSONDelete(jwt->claims);
-    free(jwt->claims_string);
-    free(jwt->sigkid);
-    free(jwt->signature);
-    free(jwt);
+    _cupsMemFree(jwt->claims_string);
+    _cupsMemFree(jwt->sigkid);
+    _cupsMemFree(jwt->signature);
+    _cupsMemFree(jwt);
   }
 }
 
@@ -138,8 +178,14 @@ cupsJWTExportString(
   {
     if (format == CUPS_JWS_FORMAT_COMPACT)
     {
-      // Compact token string
-      ret = make_string(jwt, true);
+      // Compact token string, copied so it can be freed using `free`...
+      char	*s;			// Token string
+
+      if ((s = make_string(jwt, true)) != NULL)
+      {
+        ret = strdup(s);
+        _cupsMemFree(s);
+      }
     }
     else
     {
@@ -154,7 +200,7 @@ cupsJWTExportString(
 
       payload = make_string(jwt, false);
       cupsJSONNewString(json, cupsJSONNewKey(json, NULL, "payload"), payload);
-      free(payload);
+      _cupsMemFree(payload);
 
       if (jwt->sigsize)
       {
@@ -358,6 +404,10 @@ cupsJWTGetHeaders(cups_jwt_t *jwt)	// I - JWT object
 //
 // 'cupsJWTHasValidSignature()' - Determine whether the JWT has a valid signature.
 //
+// RSA and ECDSA public keys are cached by their JWK thumbprint, and verified
+// tokens are remembered until they expire (at most one hour), so repeated
+// checks of the same token skip the public key cryptography.
+//
 
 bool					// O - `true` if value, `false` otherwise
 cupsJWTHasValidSignature(
@@ -372,6 +422,9 @@ cupsJWTHasValidSignature(
 					// Size of signature
   char		*text;			// Signature text
   size_t	text_len;		// Length of signature text
+  unsigned char	thumbprint[32],		// JWK thumbprint
+		token[32];		// Token identifier
+  bool		cacheable;		// Can the result be cached?
 #ifdef HAVE_OPENSSL
   unsigned char	hash[128];		// Hash
   ssize_t	hash_len;		// Length of hash
@@ -413,14 +466,26 @@ cupsJWTHasValidSignature(
     case CUPS_JWA_RS256 :
     case CUPS_JWA_RS384 :
     case CUPS_JWA_RS512 :
-	// Get the message hash...
+	// Get the message text and see if we've already verified it...
         text     = make_string(jwt, false);
         text_len = strlen(text);
 
+        if ((cacheable = make_thumbprint(jwk, thumbprint)) == true)
+        {
+          make_token_id(jwt, text, text_len, thumbprint, token);
+
+          if (find_verified(token))
+          {
+            _cupsMemFree(text);
+            ret = true;
+            break;
+          }
+        }
+
 #ifdef HAVE_OPENSSL
         hash_len = cupsHashData(cups_jwa_algorithms[jwt->sigalg], text, text_len, hash, sizeof(hash));
 
-        if ((rsa = make_rsa(jwk)) != NULL)
+        if ((rsa = get_rsa(jwk, cacheable ? thumbprint : NULL)) != NULL)
         {
 	  ret = RSA_verify(nids[jwt->sigalg - CUPS_JWA_RS256], hash, hash_len, jwt->signature, jwt->sigsize, rsa) == 1;
 
@@ -428,7 +493,7 @@ cupsJWTHasValidSignature(
         }
 
 #else // HAVE_GNUTLS
-        if ((key = make_public_key(jwk)) != NULL)
+        if ((key = get_public_key(jwk, cacheable ? thumbprint : NULL)) != NULL)
         {
           text_datum.data = (unsigned char *)text;
           text_datum.size = (unsigned)text_len;
@@ -437,25 +502,45 @@ cupsJWTHasValidSignature(
           sig_datum.size  = (unsigned)jwt->sigsize;
 
           ret = !gnutls_pubkey_verify_data2(key, algs[jwt->sigalg - CUPS_JWA_RS256], 0, &text_datum, &sig_datum);
-          gnutls_pubkey_deinit(key);
+
+          // Cached keys are returned with the cache mutex held...
+          if (cacheable)
+            cupsMutexUnlock(&jwt_cache_mutex);
+          else
+            gnutls_pubkey_deinit(key);
         }
 #endif // HAVE_OPENSSL
 
+        if (ret && cacheable)
+          save_verified(jwt, token);
+
         // Free memory
-	free(text);
+	_cupsMemFree(text);
         break;
 
     case CUPS_JWA_ES256 :
     case CUPS_JWA_ES384 :
     case CUPS_JWA_ES512 :
-	// Get the message hash...
+	// Get the message text and see if we've already verified it...
         text     = make_string(jwt, false);
         text_len = strlen(text);
 
+        if ((cacheable = make_thumbprint(jwk, thumbprint)) == true)
+        {
+          make_token_id(jwt, text, text_len, thumbprint, token);
+
+          if (find_verified(token))
+          {
+            _cupsMemFree(text);
+            ret = true;
+            break;
+          }
+        }
+
 #ifdef HAVE_OPENSSL
         hash_len = cupsHashData(cups_jwa_algorithms[jwt->sigalg], text, text_len, hash, sizeof(hash));
 
-        if ((ec = make_ec_key(jwk, true)) != NULL)
+        if ((ec = get_ec_key(jwk, cacheable ? thumbprint : NULL, true)) != NULL)
         {
           // Convert binary signature into ECDSA signature for OpenSSL
           ECDSA_SIG	*ec_sig;	// EC signature
@@ -478,7 +563,7 @@ cupsJWTHasValidSignature(
         }
 
 #else // HAVE_GNUTLS
-        if ((key = make_public_key(jwk)) != NULL)
+        if ((key = get_public_key(jwk, cacheable ? thumbprint : NULL)) != NULL)
         {
 	  gnutls_datum_t r, s;		// Signature coordinates
 
@@ -494,12 +579,20 @@ cupsJWTHasValidSignature(
 
           ret = !gnutls_pubkey_verify_data2(key, algs[jwt->sigalg - CUPS_JWA_RS256], 0, &text_datum, &sig_datum);
 	  gnutls_free(sig_datum.data);
-          gnutls_pubkey_deinit(key);
+
+          // Cached keys are returned with the cache mutex held...
+          if (cacheable)
+            cupsMutexUnlock(&jwt_cache_mutex);
+          else
+            gnutls_pubkey_deinit(key);
         }
 #endif // HAVE_OPENSSL
 
+        if (ret && cacheable)
+          save_verified(jwt, token);
+
         // Free memory
-	free(text);
+	_cupsMemFree(text);
         break;
 
     default :
@@ -527,7 +620,7 @@ cupsJWTImportString(
 
 
   // Allocate a JWT...
-  if ((jwt = calloc(1, sizeof(cups_jwt_t))) == NULL)
+  if ((jwt = _cupsMemCalloc(CUPS_MEMTYPE_JSON, 1, sizeof(cups_jwt_t))) == NULL)
     return (NULL);
 
   // Import it...
@@ -543,7 +636,7 @@ cupsJWTImportString(
 
     tokptr ++;
     data[datalen] = '\0';
-    jwt->jose_string = strdup(data);
+    jwt->jose_string = _cupsMemStrdup(CUPS_MEMTYPE_JSON, data);
     if ((jwt->jose = cupsJSONImportString(data)) == NULL)
       goto import_error;
 
@@ -554,7 +647,7 @@ cupsJWTImportString(
 
     tokptr ++;
     data[datalen] = '\0';
-    jwt->claims_string = strdup(data);
+    jwt->claims_string = _cupsMemStrdup(CUPS_MEMTYPE_JSON, data);
     if ((jwt->claims = cupsJSONImportString(data)) == NULL)
       goto import_error;
 
@@ -565,7 +658,7 @@ cupsJWTImportString(
 
     if (datalen > 0)
     {
-      if ((jwt->signature = malloc(datalen)) == NULL)
+      if ((jwt->signature = _cupsMemAlloc(CUPS_MEMTYPE_JSON, datalen)) == NULL)
 	goto import_error;
 
       memcpy(jwt->signature, data, datalen);
@@ -602,7 +695,7 @@ cupsJWTImportString(
     }
 
     data[datalen] = '\0';
-    jwt->claims_string = strdup(data);
+    jwt->claims_string = _cupsMemStrdup(CUPS_MEMTYPE_JSON, data);
     if ((jwt->claims = cupsJSONImportString(data)) == NULL)
     {
       cupsJSONDelete(json);
@@ -636,7 +729,7 @@ cupsJWTImportString(
     }
 
     data[datalen] = '\0';
-    jwt->jose_string = strdup(data);
+    jwt->jose_string = _cupsMemStrdup(CUPS_MEMTYPE_JSON, data);
     if ((jwt->jose = cupsJSONImportString(data)) == NULL)
     {
       cupsJSONDelete(json);
@@ -658,7 +751,7 @@ cupsJWTImportString(
 
     if (datalen > 0)
     {
-      if ((jwt->signature = malloc(datalen)) == NULL)
+      if ((jwt->signature = _cupsMemAlloc(CUPS_MEMTYPE_JSON, datalen)) == NULL)
 	goto import_error;
 
       memcpy(jwt->signature, data, datalen);
@@ -666,7 +759,7 @@ cupsJWTImportString(
     }
 
     if ((header = cupsJSONFind(signature, "header")) != NULL && (kid = cupsJSONFind(header, "kid")) != NULL && (value = cupsJSONGetString(kid)) != NULL)
-      jwt->sigkid = strdup(value);
+      jwt->sigkid = _cupsMemStrdup(CUPS_MEMTYPE_JSON, value);
   }
 
   // Check the algorithm used in the protected header...
@@ -961,7 +1054,7 @@ cupsJWTNew(const char *type)		// I - JWT type or `NULL` for default ("JWT")
   cups_jwt_t	*jwt;			// JWT object
 
 
-  if ((jwt = calloc(1, sizeof(cups_jwt_t))) != NULL)
+  if ((jwt = _cupsMemCalloc(CUPS_MEMTYPE_JSON, 1, sizeof(cups_jwt_t))) != NULL)
   {
     if ((jwt->jose = cupsJSONNew(NULL, NULL, CUPS_JTYPE_OBJECT)) != NULL)
     {
@@ -991,7 +1084,7 @@ cupsJWTSetClaimNumber(cups_jwt_t *jwt,	// I - JWT object
     return;
 
   // Remove existing claim string, if any...
-  free(jwt->claims_string);
+  _cupsMemFree(jwt->claims_string);
   jwt->claims_string = NULL;
 
   // Remove existing claim, if any...
@@ -1016,7 +1109,7 @@ cupsJWTSetClaimString(cups_jwt_t *jwt,	// I - JWT object
     return;
 
   // Remove existing claim string, if any...
-  free(jwt->claims_string);
+  _cupsMemFree(jwt->claims_string);
   jwt->claims_string = NULL;
 
   // Remove existing claim, if any...
@@ -1042,7 +1135,7 @@ cupsJWTSetClaimValue(
     return;
 
   // Remove existing claim string, if any...
-  free(jwt->claims_string);
+  _cupsMemFree(jwt->claims_string);
   jwt->claims_string = NULL;
 
   // Remove existing claim, if any...
@@ -1068,7 +1161,7 @@ cupsJWTSetHeaderNumber(
     return;
 
   // Remove existing claim string, if any...
-  free(jwt->claims_string);
+  _cupsMemFree(jwt->claims_string);
   jwt->claims_string = NULL;
 
   // Remove existing claim, if any...
@@ -1094,7 +1187,7 @@ cupsJWTSetHeaderString(
     return;
 
   // Remove existing claim string, if any...
-  free(jwt->claims_string);
+  _cupsMemFree(jwt->claims_string);
   jwt->claims_string = NULL;
 
   // Remove existing claim, if any...
@@ -1120,7 +1213,7 @@ cupsJWTSetHeaderValue(
     return;
 
   // Remove existing claim string, if any...
-  free(jwt->claims_string);
+  _cupsMemFree(jwt->claims_string);
   jwt->claims_string = NULL;
 
   // Remove existing claim, if any...
@@ -1155,15 +1248,15 @@ cupsJWTSign(cups_jwt_t  *jwt,		// I - JWT object
   }
 
   // Remove existing JOSE string, if any...
-  free(jwt->jose_string);
+  _cupsMemFree(jwt->jose_string);
   _cupsJSONDelete(jwt->jose, "alg");
   cupsJSONNewString(jwt->jose, cupsJSONNewKey(jwt->jose, NULL, "alg"), cups_jwa_strings[alg]);
 
-  jwt->jose_string = cupsJSONExportString(jwt->jose);
+  jwt->jose_string = _cupsJSONExportString(jwt->jose);
 
   // Clear existing signature...
-  free(jwt->signature);
-  free(jwt->sigkid);
+  _cupsMemFree(jwt->signature);
+  _cupsMemFree(jwt->sigkid);
   jwt->signature = NULL;
   jwt->sigkid    = NULL;
   jwt->sigsize   = 0;
@@ -1177,9 +1270,9 @@ cupsJWTSign(cups_jwt_t  *jwt,		// I - JWT object
   }
 
   if (sigkid)
-    jwt->sigkid = strdup(sigkid);
+    jwt->sigkid = _cupsMemStrdup(CUPS_MEMTYPE_JSON, sigkid);
 
-  if ((jwt->signature = malloc(sigsize)) == NULL)
+  if ((jwt->signature = _cupsMemAlloc(CUPS_MEMTYPE_JSON, sigsize)) == NULL)
   {
     DEBUG_printf("2cupsJWTSign: Unable to allocate %d bytes for signature.", (int)sigsize);
     return (false);
@@ -1193,7 +1286,181 @@ cupsJWTSign(cups_jwt_t  *jwt,		// I - JWT object
 }
 
 
+//
+// 'find_key()' - Find or create a cached key.
+//
+// The caller must hold the cache mutex.  When "create" is `true`, the least
+// recently used key is replaced if the thumbprint is not found.
+//
+
+static _cups_jwt_key_t *		// O - Cached key or `NULL`
+find_key(
+    const unsigned char *thumbprint,	// I - JWK thumbprint
+    bool                create)		// I - Create a new entry as needed?
+{
+  size_t		i;		// Looping var
+  _cups_jwt_key_t	*key,		// Current key
+			*oldest = NULL;	// Least recently used key
+
+
+  for (i = 0, key = jwt_keys; i < _CUPS_JWT_MAX_KEYS; i ++, key ++)
+  {
+    if (key->used && !memcmp(key->thumbprint, thumbprint, sizeof(key->thumbprint)))
+    {
+      key->used = ++ jwt_keys_used;
+      return (key);
+    }
+    else if (!oldest || key->used < oldest->used)
+    {
+      oldest = key;
+    }
+  }
+
+  if (!create)
+    return (NULL);
+
+  // Replace the least recently used key...
+#ifdef HAVE_OPENSSL
+  RSA_free(oldest->rsa);
+  EC_KEY_free(oldest->ec);
+#else // HAVE_GNUTLS
+  if (oldest->key)
+    gnutls_pubkey_deinit(oldest->key);
+  if (oldest->privkey)
+    gnutls_privkey_deinit(oldest->privkey);
+#endif // HAVE_OPENSSL
+
+  memset(oldest, 0, sizeof(_cups_jwt_key_t));
+  memcpy(oldest->thumbprint, thumbprint, sizeof(oldest->thumbprint));
+  oldest->used = ++ jwt_keys_used;
+
+  return (oldest);
+}
+
+
+//
+// 'find_verified()' - See if a token has already been verified.
+//
+
+static bool				// O - `true` if verified, `false` otherwise
+find_verified(
+    const unsigned char *token)		// I - Token identifier
+{
+  _cups_jwt_token_t	*entry;		// Cache entry
+  bool			ret;		// Return value
+
+
+  cupsMutexLock(&jwt_cache_mutex);
+
+  entry = jwt_tokens + ((token[0] | (token[1] << 8)) % _CUPS_JWT_MAX_TOKENS);
+  ret   = entry->expires > time(NULL) && !memcmp(entry->token, token, sizeof(entry->token));
+
+  cupsMutexUnlock(&jwt_cache_mutex);
+
+  return (ret);
+}
+
+
 #ifdef HAVE_OPENSSL
+//
+// 'get_ec_key()' - Get a cached or new ECDSA object.
+//
+// Signing keys must be looked up using the private thumbprint.  The returned
+// object must be freed using `EC_KEY_free`.
+//
+
+static EC_KEY *				// O - EC object or `NULL` on error
+get_ec_key(
+    cups_json_t         *jwk,		// I - JSON web key
+    const unsigned char *thumbprint,	// I - JWK thumbprint or `NULL` for none
+    bool                verify)		// I - `true` for verification, `false` for signing
+{
+  _cups_jwt_key_t	*key;		// Cached key
+  EC_KEY		*ec;		// EC object
+
+
+  if (!thumbprint)
+    return (make_ec_key(jwk, verify));
+
+  cupsMutexLock(&jwt_cache_mutex);
+
+  if ((key = find_key(thumbprint, false)) != NULL && key->ec)
+  {
+    ec = key->ec;
+    EC_KEY_up_ref(ec);
+    cupsMutexUnlock(&jwt_cache_mutex);
+    return (ec);
+  }
+
+  cupsMutexUnlock(&jwt_cache_mutex);
+
+  if ((ec = make_ec_key(jwk, verify)) != NULL)
+  {
+    // Cache the new key...
+    cupsMutexLock(&jwt_cache_mutex);
+
+    key = find_key(thumbprint, true);
+
+    EC_KEY_free(key->ec);
+    key->ec = ec;
+    EC_KEY_up_ref(ec);
+
+    cupsMutexUnlock(&jwt_cache_mutex);
+  }
+
+  return (ec);
+}
+
+
+//
+// 'get_rsa()' - Get a cached or new RSA object.
+//
+// Signing keys must be looked up using the private thumbprint.  The returned
+// object must be freed using `RSA_free`.
+//
+
+static RSA *				// O - RSA object or `NULL` on error
+get_rsa(
+    cups_json_t         *jwk,		// I - JSON web key
+    const unsigned char *thumbprint)	// I - JWK thumbprint or `NULL` for none
+{
+  _cups_jwt_key_t	*key;		// Cached key
+  RSA			*rsa;		// RSA object
+
+
+  if (!thumbprint)
+    return (make_rsa(jwk));
+
+  cupsMutexLock(&jwt_cache_mutex);
+
+  if ((key = find_key(thumbprint, false)) != NULL && key->rsa)
+  {
+    rsa = key->rsa;
+    RSA_up_ref(rsa);
+    cupsMutexUnlock(&jwt_cache_mutex);
+    return (rsa);
+  }
+
+  cupsMutexUnlock(&jwt_cache_mutex);
+
+  if ((rsa = make_rsa(jwk)) != NULL)
+  {
+    // Cache the new key...
+    cupsMutexLock(&jwt_cache_mutex);
+
+    key = find_key(thumbprint, true);
+
+    RSA_free(key->rsa);
+    key->rsa = rsa;
+    RSA_up_ref(rsa);
+
+    cupsMutexUnlock(&jwt_cache_mutex);
+  }
+
+  return (rsa);
+}
+
+
 //
 // 'make_bignum()' - Make a BIGNUM for the specified key.
 //
@@ -1369,6 +1636,82 @@ make_rsa(cups_json_t *jwk)		// I - JSON web key
 
 
 #else // HAVE_GNUTLS
+//
+// 'get_private_key()' - Get a cached or new private key for signing.
+//
+// GnuTLS private keys are not reference counted, so cached keys are returned
+// with the cache mutex held and the caller must unlock it when done.
+// Otherwise the returned key must be freed using `gnutls_privkey_deinit`.
+//
+
+static gnutls_privkey_t			// O - Private key or `NULL`
+get_private_key(
+    cups_json_t         *jwk,		// I - JSON web key
+    const unsigned char *thumbprint)	// I - Private JWK thumbprint or `NULL` for none
+{
+  _cups_jwt_key_t	*key;		// Cached key
+  gnutls_privkey_t	privkey;	// Private key
+
+
+  if (!thumbprint)
+    return (make_private_key(jwk));
+
+  cupsMutexLock(&jwt_cache_mutex);
+
+  if ((key = find_key(thumbprint, false)) != NULL && key->privkey)
+    return (key->privkey);
+
+  if ((privkey = make_private_key(jwk)) == NULL)
+  {
+    cupsMutexUnlock(&jwt_cache_mutex);
+    return (NULL);
+  }
+
+  key          = find_key(thumbprint, true);
+  key->privkey = privkey;
+
+  return (privkey);
+}
+
+
+//
+// 'get_public_key()' - Get a cached or new public key for verification.
+//
+// GnuTLS public keys are not reference counted, so cached keys are returned
+// with the cache mutex held and the caller must unlock it when done.
+// Otherwise the returned key must be freed using `gnutls_pubkey_deinit`.
+//
+
+static gnutls_pubkey_t			// O - Public key or `NULL`
+get_public_key(
+    cups_json_t         *jwk,		// I - JSON web key
+    const unsigned char *thumbprint)	// I - JWK thumbprint or `NULL` for none
+{
+  _cups_jwt_key_t	*key;		// Cached key
+  gnutls_pubkey_t	pubkey;		// Public key
+
+
+  if (!thumbprint)
+    return (make_public_key(jwk));
+
+  cupsMutexLock(&jwt_cache_mutex);
+
+  if ((key = find_key(thumbprint, false)) != NULL && key->key)
+    return (key->key);
+
+  if ((pubkey = make_public_key(jwk)) == NULL)
+  {
+    cupsMutexUnlock(&jwt_cache_mutex);
+    return (NULL);
+  }
+
+  key      = find_key(thumbprint, true);
+  key->key = pubkey;
+
+  return (pubkey);
+}
+
+
 //
 // 'make_datum()' - Make a datum value for a parameter.
 //
@@ -1395,7 +1738,7 @@ make_datum(cups_json_t *jwk,		// I - JSON web key
     return (NULL);
 
   // Convert to a datum...
-  if ((datum = (gnutls_datum_t *)calloc(1, sizeof(gnutls_datum_t) + value_len)) != NULL)
+  if ((datum = (gnutls_datum_t *)_cupsMemCalloc(CUPS_MEMTYPE_JSON, 1, sizeof(gnutls_datum_t) + value_len)) != NULL)
   {
     // Set pointer and length, and copy value bytes...
     datum->data = (unsigned char *)(datum + 1);
@@ -1470,14 +1813,14 @@ make_private_key(cups_json_t *jwk)	// I - JSON web key
     }
 
     // Free memory...
-    free(n);
-    free(e);
-    free(d);
-    free(p);
-    free(q);
-    free(dp);
-    free(dq);
-    free(qi);
+    _cupsMemFree(n);
+    _cupsMemFree(e);
+    _cupsMemFree(d);
+    _cupsMemFree(p);
+    _cupsMemFree(q);
+    _cupsMemFree(dp);
+    _cupsMemFree(dq);
+    _cupsMemFree(qi);
   }
   else if (!strcmp(kty, "EC"))
   {
@@ -1516,9 +1859,9 @@ make_private_key(cups_json_t *jwk)	// I - JSON web key
     }
 
     // Free memory...
-    free(x);
-    free(y);
-    free(d);
+    _cupsMemFree(x);
+    _cupsMemFree(y);
+    _cupsMemFree(d);
   }
 
   // Return whatever key we got...
@@ -1563,8 +1906,8 @@ make_public_key(cups_json_t *jwk)	// I - JSON web key
     }
 
     // Free memory and return...
-    free(n);
-    free(e);
+    _cupsMemFree(n);
+    _cupsMemFree(e);
   }
   else if (!strcmp(kty, "EC"))
   {
@@ -1601,8 +1944,8 @@ make_public_key(cups_json_t *jwk)	// I - JSON web key
     }
 
     // Free memory...
-    free(x);
-    free(y);
+    _cupsMemFree(x);
+    _cupsMemFree(y);
   }
 
   return (key);
@@ -1626,6 +1969,8 @@ make_signature(cups_jwt_t    *jwt,	// I  - JWT
   cups_json_t		*keys;		// Array of keys
   char			*text;		// JWS Signing Input
   size_t		text_len;	// Length of signing input
+  unsigned char		thumbprint[32];	// Private JWK thumbprint
+  bool			cacheable;	// Can the key be cached?
 #ifdef HAVE_OPENSSL
   static int		nids[] = { NID_sha256, NID_sha384, NID_sha512 };
 					// Hash NIDs
@@ -1716,7 +2061,9 @@ make_signature(cups_jwt_t    *jwt,	// I  - JWT
 					// Length of signature
     RSA		*rsa;			// RSA public/private key
 
-    if ((rsa = make_rsa(jwk)) != NULL)
+    cacheable = make_private_thumbprint(jwk, thumbprint);
+
+    if ((rsa = get_rsa(jwk, cacheable ? thumbprint : NULL)) != NULL)
     {
       hash_len = cupsHashData(cups_jwa_algorithms[alg], text, text_len, hash, sizeof(hash));
       if (RSA_sign(nids[alg - CUPS_JWA_RS256], hash, hash_len, signature, &siglen, rsa) == 1)
@@ -1728,7 +2075,9 @@ make_signature(cups_jwt_t    *jwt,	// I  - JWT
       RSA_free(rsa);
     }
 #else // HAVE_GNUTLS
-    if ((key = make_private_key(jwk)) != NULL)
+    cacheable = make_private_thumbprint(jwk, thumbprint);
+
+    if ((key = get_private_key(jwk, cacheable ? thumbprint : NULL)) != NULL)
     {
       text_datum.data = (unsigned char *)text;
       text_datum.size = (unsigned)text_len;
@@ -1743,7 +2092,11 @@ make_signature(cups_jwt_t    *jwt,	// I  - JWT
       }
 
       gnutls_free(sig_datum.data);
-      gnutls_privkey_deinit(key);
+
+      if (cacheable)
+        cupsMutexUnlock(&jwt_cache_mutex);
+      else
+        gnutls_privkey_deinit(key);
     }
 #endif // HAVE_OPENSSL
   }
@@ -1761,7 +2114,9 @@ make_signature(cups_jwt_t    *jwt,	// I  - JWT
     const BIGNUM *r, *s;		// Signature coordinates
     unsigned	r_len, s_len;		// Length of coordinates
 
-    if ((ec = make_ec_key(jwk, false)) != NULL)
+    cacheable = make_private_thumbprint(jwk, thumbprint);
+
+    if ((ec = get_ec_key(jwk, cacheable ? thumbprint : NULL, false)) != NULL)
     {
       hash_len = cupsHashData(cups_jwa_algorithms[alg], text, text_len, hash, sizeof(hash));
       if ((ec_sig = ECDSA_do_sign(hash, hash_len, ec)) != NULL)
@@ -1786,7 +2141,9 @@ make_signature(cups_jwt_t    *jwt,	// I  - JWT
       EC_KEY_free(ec);
     }
 #else // HAVE_GNUTLS
-    if ((key = make_private_key(jwk)) != NULL)
+    cacheable = make_private_thumbprint(jwk, thumbprint);
+
+    if ((key = get_private_key(jwk, cacheable ? thumbprint : NULL)) != NULL)
     {
       text_datum.data = (unsigned char *)text;
       text_datum.size = (unsigned)text_len;
@@ -1820,14 +2177,18 @@ make_signature(cups_jwt_t    *jwt,	// I  - JWT
 	DEBUG_printf("4make_signature: EC signing failed, sig_datum=%d bytes.", (int)sig_datum.size);
       }
       gnutls_free(sig_datum.data);
-      gnutls_privkey_deinit(key);
+
+      if (cacheable)
+        cupsMutexUnlock(&jwt_cache_mutex);
+      else
+        gnutls_privkey_deinit(key);
     }
 #endif // HAVE_OPENSSL
   }
 
   done:
 
-  free(text);
+  _cupsMemFree(text);
 
   if (ret)
     *sigkid = cupsJSONGetString(cupsJSONFind(jwk, "kid"));
@@ -1856,7 +2217,7 @@ make_string(cups_jwt_t *jwt,		// I - JWT object
 
   // Get the JOSE header and claims object strings...
   if (!jwt->claims_string)
-    jwt->claims_string = cupsJSONExportString(jwt->claims);
+    jwt->claims_string = _cupsJSONExportString(jwt->claims);
 
   if (!jwt->jose_string || !jwt->claims_string)
     return (NULL);
@@ -1867,7 +2228,7 @@ make_string(cups_jwt_t *jwt,		// I - JWT object
   // Calculate the maximum Base64URL-encoded string length...
   len = ((jose_len + 2) * 4 / 3) + 1 + ((claims_len + 2) * 4 / 3) + 1 + ((_CUPS_JWT_MAX_SIGNATURE + 2) * 4 / 3) + 1;
 
-  if ((s = malloc(len)) == NULL)
+  if ((s = _cupsMemAlloc(CUPS_MEMTYPE_JSON, len)) == NULL)
     return (NULL);
 
   ptr = s;
@@ -1890,3 +2251,152 @@ make_string(cups_jwt_t *jwt,		// I - JWT object
 
   return (s);
 }
+
+
+//
+// 'make_private_thumbprint()' - Make the SHA-256 thumbprint of a private JWK.
+//
+// The private thumbprint adds the private "d" member to the RFC 7638
+// thumbprint so that cached signing keys are never found using only the
+// public key members.
+//
+
+static bool				// O - `true` on success, `false` on error
+make_private_thumbprint(
+    cups_json_t   *jwk,			// I - JSON web key
+    unsigned char *thumbprint)		// O - Thumbprint (32 bytes)
+{
+  const char	*d;			// Private key
+  unsigned char	hash[32];		// Public thumbprint
+  cups_hash_t	*ctx;			// Hashing context
+
+
+  if ((d = cupsJSONGetString(cupsJSONFind(jwk, "d"))) == NULL || !make_thumbprint(jwk, hash))
+    return (false);
+
+  if ((ctx = cupsHashInit("sha2-256")) == NULL)
+    return (false);
+
+  cupsHashUpdate(ctx, hash, sizeof(hash));
+  cupsHashUpdate(ctx, d, strlen(d));
+
+  return (cupsHashFinish(ctx, thumbprint, 32) == 32);
+}
+
+
+//
+// 'make_thumbprint()' - Make the SHA-256 thumbprint of a public JWK.
+//
+// The thumbprint is computed from the required public key members as
+// described in RFC 7638.
+//
+
+static bool				// O - `true` on success, `false` on error
+make_thumbprint(
+    cups_json_t   *jwk,			// I - JSON web key
+    unsigned char *thumbprint)		// O - Thumbprint (32 bytes)
+{
+  const char	*kty,			// Key type
+		*crv,			// EC curve
+		*e, *n,			// RSA public key
+		*x, *y;			// EC public key
+  char		buffer[4096];		// Canonical JSON
+  int		len;			// Length of canonical JSON
+
+
+  if ((kty = cupsJSONGetString(cupsJSONFind(jwk, "kty"))) == NULL)
+  {
+    return (false);
+  }
+  else if (!strcmp(kty, "RSA"))
+  {
+    e = cupsJSONGetString(cupsJSONFind(jwk, "e"));
+    n = cupsJSONGetString(cupsJSONFind(jwk, "n"));
+
+    if (!e || !n)
+      return (false);
+
+    len = snprintf(buffer, sizeof(buffer), "{\"e\":\"%s\",\"kty\":\"RSA\",\"n\":\"%s\"}", e, n);
+  }
+  else if (!strcmp(kty, "EC"))
+  {
+    crv = cupsJSONGetString(cupsJSONFind(jwk, "crv"));
+    x   = cupsJSONGetString(cupsJSONFind(jwk, "x"));
+    y   = cupsJSONGetString(cupsJSONFind(jwk, "y"));
+
+    if (!crv || !x || !y)
+      return (false);
+
+    len = snprintf(buffer, sizeof(buffer), "{\"crv\":\"%s\",\"kty\":\"EC\",\"x\":\"%s\",\"y\":\"%s\"}", crv, x, y);
+  }
+  else
+  {
+    return (false);
+  }
+
+  if (len < 0 || (size_t)len >= sizeof(buffer))
+    return (false);
+
+  return (cupsHashData("sha2-256", buffer, (size_t)len, thumbprint, 32) == 32);
+}
+
+
+//
+// 'make_token_id()' - Make an identifier for a signed token and key.
+//
+
+static void
+make_token_id(
+    cups_jwt_t          *jwt,		// I - JWT object
+    const char          *text,		// I - JWS signing input
+    size_t              text_len,	// I - Length of signing input
+    const unsigned char *thumbprint,	// I - JWK thumbprint
+    unsigned char       *token)		// O - Token identifier (32 bytes)
+{
+  unsigned char	hashes[96];		// Hashes of input, signature, and key
+
+
+  // Hash the hashes of the signing input and signature along with the key
+  // thumbprint...
+  cupsHashData("sha2-256", text, text_len, hashes, 32);
+  cupsHashData("sha2-256", jwt->signature, jwt->sigsize, hashes + 32, 32);
+  memcpy(hashes + 64, thumbprint, 32);
+
+  cupsHashData("sha2-256", hashes, sizeof(hashes), token, 32);
+}
+
+
+//
+// 'save_verified()' - Remember that a token has been verified.
+//
+
+static void
+save_verified(
+    cups_jwt_t          *jwt,		// I - JWT object
+    const unsigned char *token)		// I - Token identifier
+{
+  _cups_jwt_token_t	*entry;		// Cache entry
+  time_t		now = time(NULL),
+					// Current time
+			expires,	// Expiration time
+			exp;		// "exp" claim value
+
+
+  // Cache until the token expires, up to the maximum TTL...
+  expires = now + _CUPS_JWT_TOKEN_TTL;
+
+  if ((exp = (time_t)cupsJWTGetClaimNumber(jwt, CUPS_JWT_EXP)) > 0 && exp < expires)
+    expires = exp;
+
+  if (expires <= now)
+    return;
+
+  cupsMutexLock(&jwt_cache_mutex);
+
+  entry = jwt_tokens + ((token[0] | (token[1] << 8)) % _CUPS_JWT_MAX_TOKENS);
+
+  memcpy(entry->token, token, sizeof(entry->token));
+  entry->expires = expires;
+
+  cupsMutexUnlock(&jwt_cache_mutex);
+}
@@ -191,7 +191,7 @@ cupsLangSetLocale(char *argv[])		// IO - Command-line arguments
 
       // Save the new string if it differs from the original...
       if (strcmp(buffer, argv[i]))
-        argv[i] = strdup(buffer);
+        argv[i] = _cupsMemStrdup(CUPS_MEMTYPE_OTHER, buffer);
     }
   }
 }
@@ -15,7 +15,12 @@
 #  include <io.h>
 #else
 #  include <unistd.h>
+#  include <sys/mman.h>
 #endif // _WIN32
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && !defined(__STDC_NO_ATOMICS__)
+#  include <stdatomic.h>
+#  define _CUPS_LANG_ATOMIC 1		// Use atomics to publish message indices
+#endif // __STDC_VERSION__ >= 201112L && !__STDC_NO_ATOMICS__
 
 #include "strings/ca_strings.h"
 #include "strings/cs_strings.h"
@@ -31,16 +36,50 @@
 #include "strings/zh_CN_strings.h"
 
 
+//
+// Constants...
+//
+
+#define _CUPS_CATALOG_MAGIC	"CUPSCAT1"
+					// Compiled message catalog magic string
+#define _CUPS_CATALOG_ORDER	0x01020304
+					// Compiled message catalog byte order mark
+
+
 //
 // Types...
 //
 
+typedef struct _cups_catalog_s		// Compiled message catalog header
+{
+  char			magic[8];	// Magic string "CUPSCAT1"
+  uint32_t		byte_order,	// Byte order mark 0x01020304
+			num_messages,	// Number of messages
+			table_size,	// Number of hash table slots (power of 2)
+			reserved;	// Reserved (0)
+} _cups_catalog_t;
+
 typedef struct _cups_message_s		// Message catalog entry
 {
   char			*key,		// Key string
 			*text;		// Localized text string
 } _cups_message_t;
 
+typedef struct _cups_lslot_s		// Message index slot
+{
+  uint32_t		hash;		// Hash of key string
+  const char		*key,		// Key string or `NULL` if empty
+			*text;		// Localized text string
+} _cups_lslot_t;
+
+typedef struct _cups_lindex_s		// Message index (immutable once published)
+{
+  struct _cups_lindex_s	*prev;		// Previous (retired) index
+  const char		*catalog;	// Compiled message catalog, if any
+  size_t		mask;		// Hash table mask (table size - 1)
+  _cups_lslot_t		*slots;		// Hash table slots
+} _cups_lindex_t;
+
 struct _cups_lang_s			// Language Cache
 {
   cups_lang_t		*next;		// Next language in cache
@@ -49,6 +88,13 @@ struct _cups_lang_s			// Language Cache
   size_t		num_messages,	// Number of messages
 			alloc_messages;	// Allocated messages
   _cups_message_t	*messages;	// Messages
+  const char		*catalog;	// Compiled message catalog, if any
+  size_t		catalog_size;	// Size of compiled message catalog
+#ifdef _CUPS_LANG_ATOMIC
+  _Atomic(_cups_lindex_t *) index;	// Current message index
+#else
+  _cups_lindex_t	*index;		// Current message index
+#endif // _CUPS_LANG_ATOMIC
 };
 
 
@@ -68,7 +114,12 @@ static char		*lang_directory = NULL;
 // Local functions...
 //
 
+static const char	*cups_catalog_find(const char *catalog, const char *message);
+static uint32_t		cups_catalog_hash(const char *s);
+static bool		cups_catalog_load(cups_lang_t *lang, int fd, size_t size);
+static void		cups_catalog_unload(cups_lang_t *lang);
 static cups_lang_t	*cups_lang_new(const char *language);
+static bool		cups_lang_publish(cups_lang_t *lang);
 static int		cups_message_compare(_cups_message_t *m1, _cups_message_t *m2);
 
 
@@ -100,6 +151,7 @@ cupsLangFind(const char *language)	// I - Language or locale name
 {
   char		langname[16];		// Requested language name
   cups_lang_t	*lang;			// Current language...
+  _cups_globals_t *cg = _cupsGlobals();	// Global data
 
 
   DEBUG_printf("2cupsLangFind(language=\"%s\")", language);
@@ -107,12 +159,17 @@ cupsLangFind(const char *language)	// I - Language or locale name
   if (!language)
     return (cupsLangDefault());
 
-  cupsMutexLock(&lang_mutex);
-
   cupsCopyString(langname, language, sizeof(langname));
   if (langname[2] == '-')
     langname[2] = '_';
 
+  // Languages are never freed, so the last language found by this thread can
+  // be returned without locking...
+  if ((lang = cg->lang_last) != NULL && !_cups_strcasecmp(lang->language, langname))
+    return (lang);
+
+  cupsMutexLock(&lang_mutex);
+
   for (lang = lang_cache; lang; lang = lang->next)
   {
     if (!_cups_strcasecmp(lang->language, langname))
@@ -127,6 +184,9 @@ cupsLangFind(const char *language)	// I - Language or locale name
 
   cupsMutexUnlock(&lang_mutex);
 
+  if (lang)
+    cg->lang_last = lang;
+
   return (lang);
 }
 
@@ -177,24 +237,43 @@ const char *				// O - Localized message
 cupsLangGetString(cups_lang_t *lang,	// I - Language
                   const char  *message)	// I - Message
 {
-  _cups_message_t	key,		// Search key
-			*match;		// Matching message
+  _cups_lindex_t	*index;		// Message index
+  const _cups_lslot_t	*slot;		// Current slot
+  uint32_t		hash;		// Hash of message
+  size_t		i;		// Current slot number
   const char		*text;		// Localized message text
 
 
   DEBUG_printf("cupsLangGetString(lang=%p(%s), message=\"%s\")", (void *)lang, lang ? lang->language : "null", message);
 
   // Range check input...
-  if (!lang || !lang->num_messages || !message || !*message)
+  if (!lang || !message || !*message)
     return (message);
 
+  // Get the current message index - indices are never modified or freed once
+  // they are published, so the lookup itself does not need a lock...
+#ifdef _CUPS_LANG_ATOMIC
+  index = atomic_load_explicit(&lang->index, memory_order_acquire);
+#else
   cupsRWLockRead(&lang->rwlock);
+  index = lang->index;
+  cupsRWUnlock(&lang->rwlock);
+#endif // _CUPS_LANG_ATOMIC
 
-  key.key = (char *)message;
-  match   = bsearch(&key, lang->messages, lang->num_messages, sizeof(_cups_message_t), (int (*)(const void *, const void *))cups_message_compare);
-  text    = match ? match->text : message;
+  if (!index)
+    return (message);
 
-  cupsRWUnlock(&lang->rwlock);
+  // Look up the message...
+  hash = cups_catalog_hash(message);
+
+  for (i = hash & index->mask, slot = index->slots + i; slot->key; i = (i + 1) & index->mask, slot = index->slots + i)
+  {
+    if (slot->hash == hash && !strcmp(slot->key, message))
+      return (slot->text);
+  }
+
+  if (!index->catalog || (text = cups_catalog_find(index->catalog, message)) == NULL)
+    text = message;
 
   return (text);
 }
@@ -203,6 +282,15 @@ cupsLangGetString(cups_lang_t *lang,	// I - Language
 //
 // 'cupsLangLoadStrings()' - Load a message catalog for a language.
 //
+// This function loads a ".strings" file or in-memory strings data for the
+// specified language.  Messages that have already been loaded are not
+// replaced.
+//
+// The file may also be a compiled message catalog written by
+// @link cupsLangSaveCatalog@, which is mapped into memory read-only instead of
+// being parsed.  Only one compiled message catalog can be loaded for each
+// language.
+//
 
 bool				// O - `true` on success, `false` on failure
 cupsLangLoadStrings(
@@ -228,6 +316,7 @@ cupsLangLoadStrings(
     int		fd;			// File descriptor
     struct stat	fileinfo;		// File information
     ssize_t	bytes;			// Bytes read
+    char	magic[8];		// Magic string for compiled catalog
 
     if ((fd = open(filename, O_RDONLY)) < 0)
     {
@@ -242,7 +331,23 @@ cupsLangLoadStrings(
       return (false);
     }
 
-    if ((ptr = malloc((size_t)(fileinfo.st_size + 1))) == NULL)
+    if (fileinfo.st_size >= (off_t)sizeof(_cups_catalog_t) && read(fd, magic, sizeof(magic)) == (ssize_t)sizeof(magic) && !memcmp(magic, _CUPS_CATALOG_MAGIC, sizeof(magic)))
+    {
+      // Map the compiled message catalog...
+      ret = (uintmax_t)fileinfo.st_size <= SIZE_MAX && cups_catalog_load(lang, fd, (size_t)fileinfo.st_size);
+      close(fd);
+
+      return (ret);
+    }
+
+    if (lseek(fd, 0, SEEK_SET))
+    {
+      _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(errno), 0);
+      close(fd);
+      return (false);
+    }
+
+    if ((ptr = _cupsMemAlloc(CUPS_MEMTYPE_OTHER, (size_t)(fileinfo.st_size + 1))) == NULL)
     {
       _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(errno), 0);
       close(fd);
@@ -253,7 +358,7 @@ cupsLangLoadStrings(
     {
       _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(errno), 0);
       close(fd);
-      free(ptr);
+      _cupsMemFree(ptr);
       return (false);
     }
 
@@ -307,7 +412,7 @@ cupsLangLoadStrings(
       {
         if (*dataptr == '*' && dataptr[1] == '/')
 	{
-	  dataptr += 2;
+	  dataptr ++;
 	  break;
 	}
 	else if (*dataptr == '\n')
@@ -316,6 +421,9 @@ cupsLangLoadStrings(
 
       if (!*dataptr)
         break;
+
+      // Continue after the closing "*/"...
+      continue;
     }
     else if (*dataptr != '\"')
     {
@@ -492,12 +600,12 @@ cupsLangLoadStrings(
     dataptr ++;
 
     // Add the message if it doesn't already exist...
-    if (lang->num_messages > 0 && bsearch(&mkey, lang->messages, lang->num_messages, sizeof(_cups_message_t), (int (*)(const void *, const void *))cups_message_compare))
+    if ((lang->num_messages > 0 && bsearch(&mkey, lang->messages, lang->num_messages, sizeof(_cups_message_t), (int (*)(const void *, const void *))cups_message_compare)) || (lang->catalog && cups_catalog_find(lang->catalog, key)))
       continue;
 
     if (num_messages >= lang->alloc_messages)
     {
-      if ((m = realloc(lang->messages, (lang->alloc_messages + 1024) * sizeof(_cups_message_t))) == NULL)
+      if ((m = _cupsMemRealloc(CUPS_MEMTYPE_OTHER, lang->messages, (lang->alloc_messages + 1024) * sizeof(_cups_message_t))) == NULL)
       {
         _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(errno), 0);
         ret = false;
@@ -527,13 +635,171 @@ cupsLangLoadStrings(
   {
     lang->num_messages = num_messages;
     qsort(lang->messages, lang->num_messages, sizeof(_cups_message_t), (int (*)(const void *, const void *))cups_message_compare);
+
+    if (!cups_lang_publish(lang))
+      ret = false;
   }
 
   cupsRWUnlock(&lang->rwlock);
 
   // Free temporary storage and return...
   if (data != strings)
-    free((void *)data);
+    _cupsMemFree((void *)data);
+
+  return (ret);
+}
+
+
+//
+// 'cupsLangSaveCatalog()' - Save a compiled message catalog for a language.
+//
+// This function saves all of the messages for the specified language as a
+// compiled message catalog.  Compiled catalogs are mapped into memory
+// read-only by @link cupsLangLoadStrings@ and use a precomputed hash table
+// for lookups, so they load without parsing and their memory is shared
+// between processes.
+//
+// Compiled catalogs use the byte order of the system that saved them.  When
+// a file named "LANGUAGE.catalog" exists in the directory set using
+// @link cupsLangSetDirectory@, it is used instead of the built-in strings and
+// any "LANGUAGE.strings" file.
+//
+
+bool					// O - `true` on success, `false` on failure
+cupsLangSaveCatalog(
+    cups_lang_t *lang,			// I - Language data
+    const char  *filename)		// I - Filename
+{
+  bool			ret = false;	// Return value
+  _cups_message_t	*pairs = NULL,	// Messages to save
+			key,		// Search key
+			*pair;		// Current message
+  size_t		i,		// Looping var
+			num_pairs = 0,	// Number of messages to save
+			max_pairs,	// Maximum number of messages
+			table_size = 16,// Number of hash table slots
+			size;		// Size of compiled catalog
+  const _cups_catalog_t	*oldcatalog;	// Existing compiled catalog
+  const uint32_t	*oldslot;	// Existing hash table slot
+  _cups_catalog_t	*catalog = NULL;// Compiled catalog
+  uint32_t		*slots,		// Hash table slots
+			slot,		// Current slot
+			offset;		// Offset of next string
+  cups_file_t		*fp;		// Output file
+
+
+  // Range check input...
+  if (!lang || !filename)
+  {
+    _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(EINVAL), 0);
+    return (false);
+  }
+
+  cupsRWLockRead(&lang->rwlock);
+
+  // Collect the loaded messages, followed by any messages from an existing
+  // compiled catalog that are not shadowed by them...
+  oldcatalog = (const _cups_catalog_t *)lang->catalog;
+  max_pairs  = lang->num_messages + (oldcatalog ? oldcatalog->num_messages : 0);
+
+  if (max_pairs > 0 && (pairs = _cupsMemCalloc(CUPS_MEMTYPE_OTHER, max_pairs, sizeof(_cups_message_t))) == NULL)
+  {
+    _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(errno), 0);
+    goto done;
+  }
+
+  for (i = 0; i < lang->num_messages; i ++)
+    pairs[num_pairs ++] = lang->messages[i];
+
+  if (oldcatalog)
+  {
+    for (i = oldcatalog->table_size, oldslot = (const uint32_t *)(oldcatalog + 1); i > 0; i --, oldslot += 2)
+    {
+      if (!oldslot[0])
+        continue;
+
+      key.key = (char *)lang->catalog + oldslot[0];
+
+      if (lang->num_messages > 0 && bsearch(&key, lang->messages, lang->num_messages, sizeof(_cups_message_t), (int (*)(const void *, const void *))cups_message_compare))
+        continue;
+
+      pair       = pairs + num_pairs ++;
+      pair->key  = key.key;
+      pair->text = (char *)lang->catalog + oldslot[1];
+    }
+  }
+
+  // Size the hash table for a load factor of at most 50% and add up the
+  // string lengths...
+  while (table_size < 2 * num_pairs)
+    table_size *= 2;
+
+  size = sizeof(_cups_catalog_t) + 2 * table_size * sizeof(uint32_t);
+
+  for (i = num_pairs, pair = pairs; i > 0; i --, pair ++)
+  {
+    size += strlen(pair->key) + 1;
+
+    if (strcmp(pair->key, pair->text))
+      size += strlen(pair->text) + 1;
+  }
+
+  if (size > UINT32_MAX)
+  {
+    _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(E2BIG), 0);
+    goto done;
+  }
+
+  // Build the compiled catalog...
+  if ((catalog = _cupsMemCalloc(CUPS_MEMTYPE_OTHER, 1, size)) == NULL)
+  {
+    _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(errno), 0);
+    goto done;
+  }
+
+  memcpy(catalog->magic, _CUPS_CATALOG_MAGIC, sizeof(catalog->magic));
+  catalog->byte_order   = _CUPS_CATALOG_ORDER;
+  catalog->num_messages = (uint32_t)num_pairs;
+  catalog->table_size   = (uint32_t)table_size;
+
+  slots  = (uint32_t *)(catalog + 1);
+  offset = (uint32_t)(sizeof(_cups_catalog_t) + 2 * table_size * sizeof(uint32_t));
+
+  for (i = num_pairs, pair = pairs; i > 0; i --, pair ++)
+  {
+    for (slot = cups_catalog_hash(pair->key) & (uint32_t)(table_size - 1); slots[2 * slot]; slot = (slot + 1) & (uint32_t)(table_size - 1));
+
+    slots[2 * slot] = offset;
+    cupsCopyString((char *)catalog + offset, pair->key, size - offset);
+    offset += (uint32_t)strlen(pair->key) + 1;
+
+    if (strcmp(pair->key, pair->text))
+    {
+      slots[2 * slot + 1] = offset;
+      cupsCopyString((char *)catalog + offset, pair->text, size - offset);
+      offset += (uint32_t)strlen(pair->text) + 1;
+    }
+    else
+    {
+      slots[2 * slot + 1] = slots[2 * slot];
+    }
+  }
+
+  // Write it...
+  if ((fp = cupsFileOpen(filename, "w")) == NULL)
+    goto done;
+
+  ret = cupsFileWrite(fp, (char *)catalog, size);
+
+  if (!cupsFileClose(fp))
+    ret = false;
+
+  done:
+
+  cupsRWUnlock(&lang->rwlock);
+
+  _cupsMemFree(pairs);
+  _cupsMemFree(catalog);
 
   return (ret);
 }
@@ -550,14 +816,186 @@ cupsLangSetDirectory(const char *d)	// I - Directory name
   {
     cupsMutexLock(&lang_mutex);
 
-    free(lang_directory);
-    lang_directory = strdup(d);
+    _cupsMemFree(lang_directory);
+    lang_directory = _cupsMemStrdup(CUPS_MEMTYPE_OTHER, d);
 
     cupsMutexUnlock(&lang_mutex);
   }
 }
 
 
+//
+// 'cups_catalog_find()' - Find a message in a compiled message catalog.
+//
+
+static const char *			// O - Localized text or `NULL` if not found
+cups_catalog_find(const char *catalog,	// I - Compiled message catalog
+                  const char *message)	// I - Message
+{
+  const _cups_catalog_t	*header = (const _cups_catalog_t *)catalog;
+					// Catalog header
+  const uint32_t	*slots = (const uint32_t *)(header + 1);
+					// Hash table slots
+  uint32_t		count,		// Number of slots checked
+			mask = header->table_size - 1,
+					// Mask for slot numbers
+			slot;		// Current slot
+
+
+  for (count = header->table_size, slot = cups_catalog_hash(message) & mask; count > 0 && slots[2 * slot]; count --, slot = (slot + 1) & mask)
+  {
+    if (!strcmp(catalog + slots[2 * slot], message))
+      return (catalog + slots[2 * slot + 1]);
+  }
+
+  return (NULL);
+}
+
+
+//
+// 'cups_catalog_hash()' - Compute the hash of a message.
+//
+// This uses the 32-bit FNV-1a hash function.  Since the hash is stored in
+// compiled catalogs, it must not change.
+//
+
+static uint32_t				// O - Hash value
+cups_catalog_hash(const char *s)	// I - Message
+{
+  uint32_t	hash = 2166136261U;	// Hash value
+
+
+  for (; *s; s ++)
+    hash = (hash ^ (unsigned char)*s) * 16777619U;
+
+  return (hash);
+}
+
+
+//
+// 'cups_catalog_load()' - Map and validate a compiled message catalog.
+//
+
+static bool				// O - `true` on success, `false` on failure
+cups_catalog_load(cups_lang_t *lang,	// I - Language data
+                  int         fd,	// I - File descriptor
+                  size_t      size)	// I - Size of file
+{
+  char			*data;		// Catalog data
+  const _cups_catalog_t	*header;	// Catalog header
+  const uint32_t	*slot;		// Current hash table slot
+  size_t		start;		// Offset of first string
+  uint32_t		i,		// Looping var
+			count = 0;	// Number of messages
+  bool			valid;		// Is the catalog valid?
+
+
+  // Map or read the file...
+#if _WIN32
+  ssize_t	bytes;			// Bytes read
+
+  if ((data = _cupsMemAlloc(CUPS_MEMTYPE_OTHER, size)) == NULL)
+  {
+    _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(errno), 0);
+    return (false);
+  }
+
+  if (lseek(fd, 0, SEEK_SET) || (bytes = read(fd, data, (unsigned)size)) < 0 || (size_t)bytes != size)
+  {
+    _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(errno), 0);
+    _cupsMemFree(data);
+    return (false);
+  }
+
+#else
+  if ((data = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0)) == MAP_FAILED)
+  {
+    _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(errno), 0);
+    return (false);
+  }
+#endif // _WIN32
+
+  // Validate the header, hash table, and string offsets...
+  header = (const _cups_catalog_t *)data;
+  valid  = header->byte_order == _CUPS_CATALOG_ORDER && header->table_size > 0 && !(header->table_size & (header->table_size - 1)) && header->num_messages < header->table_size && header->table_size <= (size - sizeof(_cups_catalog_t)) / (2 * sizeof(uint32_t)) && !data[size - 1];
+  start  = sizeof(_cups_catalog_t) + 2 * (size_t)header->table_size * sizeof(uint32_t);
+
+  for (i = valid ? header->table_size : 0, slot = (const uint32_t *)(header + 1); i > 0 && valid; i --, slot += 2)
+  {
+    if (!slot[0])
+      valid = !slot[1];
+    else if (slot[0] < start || slot[0] >= size || slot[1] < start || slot[1] >= size)
+      valid = false;
+    else
+      count ++;
+  }
+
+  if (valid && count == header->num_messages)
+  {
+    // Save the catalog...
+    cupsRWLockWrite(&lang->rwlock);
+
+    if (lang->catalog)
+    {
+      _cupsSetError(IPP_STATUS_ERROR_INTERNAL, _("Message catalog already loaded."), 1);
+    }
+    else
+    {
+      lang->catalog      = data;
+      lang->catalog_size = size;
+
+      if (cups_lang_publish(lang))
+      {
+        data = NULL;
+      }
+      else
+      {
+        lang->catalog      = NULL;
+        lang->catalog_size = 0;
+      }
+    }
+
+    cupsRWUnlock(&lang->rwlock);
+
+    if (!data)
+      return (true);
+  }
+  else
+  {
+    _cupsSetError(IPP_STATUS_ERROR_INTERNAL, _("Invalid message catalog."), 1);
+  }
+
+#if _WIN32
+  _cupsMemFree(data);
+#else
+  munmap(data, size);
+#endif // _WIN32
+
+  return (false);
+}
+
+
+//
+// 'cups_catalog_unload()' - Unmap a compiled message catalog.
+//
+
+static void
+cups_catalog_unload(cups_lang_t *lang)	// I - Language data
+{
+  if (!lang->catalog)
+    return;
+
+#if _WIN32
+  _cupsMemFree((void *)lang->catalog);
+#else
+  munmap((void *)lang->catalog, lang->catalog_size);
+#endif // _WIN32
+
+  lang->catalog      = NULL;
+  lang->catalog_size = 0;
+}
+
+
 //
 // 'cups_lang_new()' - Create a new language.
 //
@@ -571,12 +1009,28 @@ cups_lang_new(const char *language)	// I - Language name
 
 
   // Create an empty language data structure...
-  if ((lang = calloc(1, sizeof(cups_lang_t))) == NULL)
+  if ((lang = _cupsMemCalloc(CUPS_MEMTYPE_OTHER, 1, sizeof(cups_lang_t))) == NULL)
     return (NULL);
 
   cupsRWInit(&lang->rwlock);
   cupsCopyString(lang->language, language, sizeof(lang->language));
 
+  // Use a compiled message catalog, if present...
+  if (lang_directory)
+  {
+    snprintf(filename, sizeof(filename), "%s/%s.catalog", lang_directory, language);
+    if (access(filename, 0) && language[2])
+    {
+      char	baselang[3];		// Base language name
+
+      cupsCopyString(baselang, language, sizeof(baselang));
+      snprintf(filename, sizeof(filename), "%s/%s.catalog", lang_directory, baselang);
+    }
+
+    if (!access(filename, 0) && cupsLangLoadStrings(lang, filename, NULL))
+      goto done;
+  }
+
   // Add strings...
   if (!_cups_strncasecmp(language, "ca", 2))
     status = cupsLangLoadStrings(lang, NULL, ca_strings);
@@ -621,7 +1075,9 @@ cups_lang_new(const char *language)	// I - Language name
   if (!status)
   {
     // Free memory if the load failed...
-    size_t	i;			// Looping var
+    size_t		i;		// Looping var
+    _cups_lindex_t	*index,		// Current message index
+			*prev;		// Previous message index
 
     for (i = 0; i < lang->num_messages; i ++)
     {
@@ -629,13 +1085,29 @@ cups_lang_new(const char *language)	// I - Language name
       _cupsStrFree(lang->messages[i].text);
     }
 
-    free(lang->messages);
-    free(lang);
+    _cupsMemFree(lang->messages);
+    cups_catalog_unload(lang);
+
+#ifdef _CUPS_LANG_ATOMIC
+    index = atomic_load_explicit(&lang->index, memory_order_relaxed);
+#else
+    index = lang->index;
+#endif // _CUPS_LANG_ATOMIC
+
+    for (; index; index = prev)
+    {
+      prev = index->prev;
+      _cupsMemFree(index);
+    }
+
+    _cupsMemFree(lang);
 
     return (NULL);
   }
 
   // Add this language to the front of the list...
+  done:
+
   lang->next = lang_cache;
   lang_cache = lang;
 
@@ -643,6 +1115,65 @@ cups_lang_new(const char *language)	// I - Language name
 }
 
 
+//
+// 'cups_lang_publish()' - Build and publish a new message index.
+//
+// The caller must hold the write lock.  Readers may still be using the old
+// index, so it is retired to the new index's "prev" list rather than freed.
+//
+
+static bool				// O - `true` on success, `false` on error
+cups_lang_publish(cups_lang_t *lang)	// I - Language data
+{
+  _cups_lindex_t	*index,		// New message index
+			*current;	// Current message index
+  size_t		i,		// Looping var
+			slot,		// Current slot number
+			table_size;	// Number of hash table slots
+  const _cups_message_t	*m;		// Current message
+
+
+  // Size the hash table for a load factor of at most 50%...
+  for (table_size = 16; table_size < 2 * lang->num_messages; table_size *= 2);
+
+  if ((index = _cupsMemCalloc(CUPS_MEMTYPE_OTHER, 1, sizeof(_cups_lindex_t) + table_size * sizeof(_cups_lslot_t))) == NULL)
+  {
+    _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(errno), 0);
+    return (false);
+  }
+
+  index->catalog = lang->catalog;
+  index->mask    = table_size - 1;
+  index->slots   = (_cups_lslot_t *)(index + 1);
+
+  for (i = lang->num_messages, m = lang->messages; i > 0; i --, m ++)
+  {
+    uint32_t hash = cups_catalog_hash(m->key);
+					// Hash of key string
+
+    for (slot = hash & index->mask; index->slots[slot].key; slot = (slot + 1) & index->mask);
+
+    index->slots[slot].hash = hash;
+    index->slots[slot].key  = m->key;
+    index->slots[slot].text = m->text;
+  }
+
+  // Publish the new index...
+#ifdef _CUPS_LANG_ATOMIC
+  current     = atomic_load_explicit(&lang->index, memory_order_relaxed);
+  index->prev = current;
+
+  atomic_store_explicit(&lang->index, index, memory_order_release);
+#else
+  current     = lang->index;
+  index->prev = current;
+  lang->index = index;
+#endif // _CUPS_LANG_ATOMIC
+
+  return (true);
+}
+
+
 //
 // 'cups_message_compare()' - Compare two messages.
 //
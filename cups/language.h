@@ -41,6 +41,7 @@ extern const char	*cupsLangGetString(cups_lang_t *lang, const char *s) _CUPS_PUB
 extern bool		cupsLangLoadStrings(cups_lang_t *lang, const char *filename, const char *strings);
 extern ssize_t		cupsLangPrintf(FILE *fp, const char *format, ...) _CUPS_FORMAT(2, 3) _CUPS_PUBLIC;
 extern ssize_t		cupsLangPuts(FILE *fp, const char *message) _CUPS_PUBLIC;
+extern bool		cupsLangSaveCatalog(cups_lang_t *lang, const char *filename) _CUPS_PUBLIC;
 extern void		cupsLangSetDirectory(const char *d) _CUPS_PUBLIC;
 extern void		cupsLangSetLocale(char *argv[]) _CUPS_PUBLIC;
 
@@ -12,12 +12,29 @@
 #include "cups-private.h"
 
 
+//
+// Private types...
+//
+
+struct _cups_options_s			// Option set
+{
+  size_t	num_options,		// Number of options
+		alloc_options;		// Allocated options
+  cups_option_t	*options;		// Options in insertion order
+  size_t	mask;			// Hash table mask (size - 1)
+  size_t	*hash;			// Hash table of option indices plus 1
+};
+
+
 //
 // Local functions...
 //
 
 static int	cups_compare_options(cups_option_t *a, cups_option_t *b);
 static size_t	cups_find_option(const char *name, size_t num_options, cups_option_t *option, int *rdiff);
+static size_t	cups_hash_name(const char *name);
+static size_t	*cups_options_find(cups_options_t *opts, const char *name);
+static bool	cups_options_resize(cups_options_t *opts);
 
 
 //
@@ -75,6 +92,11 @@ cupsAddOption(const char    *name,	// I  - Name of option
     insert = 0;
     diff   = 1;
   }
+  else if ((diff = _cups_strcasecmp(name, (*options)[num_options - 1].name)) > 0)
+  {
+    // Appending to the end of the array...
+    insert = num_options;
+  }
   else
   {
     insert = cups_find_option(name, num_options, *options, &diff);
@@ -86,7 +108,7 @@ cupsAddOption(const char    *name,	// I  - Name of option
   if (diff)
   {
     // No matching option name...
-    if ((temp = (cups_option_t *)realloc(num_options ? *options : NULL, sizeof(cups_option_t) * (num_options + 1))) == NULL)
+    if ((temp = (cups_option_t *)_cupsMemRealloc(CUPS_MEMTYPE_OTHER, num_options ? *options : NULL, sizeof(cups_option_t) * (num_options + 1))) == NULL)
       return (0);
 
     *options = temp;
@@ -100,8 +122,12 @@ cupsAddOption(const char    *name,	// I  - Name of option
   }
   else
   {
-    // Match found; free the old value...
+    // Match found; keep the same pooled string or free the old value...
     temp = *options + insert;
+
+    if (temp->value == value)
+      return (num_options);
+
     _cupsStrFree(temp->value);
   }
 
@@ -132,7 +158,7 @@ cupsFreeOptions(
     _cupsStrFree(options[i].value);
   }
 
-  free(options);
+  _cupsMemFree(options);
 }
 
 
@@ -192,6 +218,293 @@ cupsGetOption(const char    *name,	// I - Name of option
 }
 
 
+//
+// 'cupsOptionsAdd()' - Add an option to an option set.
+//
+// This function adds or replaces the named option in the option set.  Option
+// names are case-insensitive.
+//
+
+bool					// O - `true` on success, `false` on error
+cupsOptionsAdd(cups_options_t *opts,	// I - Option set
+               const char     *name,	// I - Name of option
+               const char     *value)	// I - Value of option
+{
+  size_t	*slot;			// Hash table slot
+  cups_option_t	*option;		// New option
+
+
+  // Range check input...
+  if (!opts || !name || !name[0] || !value)
+    return (false);
+
+  if (!_cups_strcasecmp(name, "cupsPrintQuality"))
+    cupsOptionsRemove(opts, "print-quality");
+  else if (!_cups_strcasecmp(name, "print-quality"))
+    cupsOptionsRemove(opts, "cupsPrintQuality");
+
+  // Make room as needed...
+  if (opts->num_options >= opts->alloc_options || 2 * (opts->num_options + 1) > opts->mask + 1)
+  {
+    if (!cups_options_resize(opts))
+      return (false);
+  }
+
+  if (*(slot = cups_options_find(opts, name)))
+  {
+    // Match found; keep the same pooled string or replace the old value...
+    option = opts->options + *slot - 1;
+
+    if (option->value != value)
+    {
+      _cupsStrFree(option->value);
+      option->value = _cupsStrAlloc(value);
+    }
+  }
+  else
+  {
+    // Add a new option...
+    option        = opts->options + opts->num_options;
+    option->name  = _cupsStrAlloc(name);
+    option->value = _cupsStrAlloc(value);
+
+    *slot = ++ opts->num_options;
+  }
+
+  return (true);
+}
+
+
+//
+// 'cupsOptionsAddArray()' - Add options from an option array to an option set.
+//
+
+bool					// O - `true` on success, `false` on error
+cupsOptionsAddArray(
+    cups_options_t *opts,		// I - Option set
+    size_t         num_options,		// I - Number of options
+    cups_option_t  *options)		// I - Options
+{
+  // Range check input...
+  if (!opts || (num_options > 0 && !options))
+    return (false);
+
+  // Add the options...
+  for (; num_options > 0; num_options --, options ++)
+  {
+    if (!cupsOptionsAdd(opts, options->name, options->value))
+      return (false);
+  }
+
+  return (true);
+}
+
+
+//
+// 'cupsOptionsDelete()' - Free the memory used by an option set.
+//
+
+void
+cupsOptionsDelete(cups_options_t *opts)	// I - Option set
+{
+  if (!opts)
+    return;
+
+  cupsFreeOptions(opts->num_options, opts->options);
+  if (!opts->num_options)
+    _cupsMemFree(opts->options);
+
+  _cupsMemFree(opts->hash);
+  _cupsMemFree(opts);
+}
+
+
+//
+// 'cupsOptionsGet()' - Get an option value from an option set.
+//
+
+const char *				// O - Option value or `NULL`
+cupsOptionsGet(cups_options_t *opts,	// I - Option set
+               const char     *name)	// I - Name of option
+{
+  size_t	*slot;			// Hash table slot
+
+
+  if (!opts || !name || !opts->num_options)
+    return (NULL);
+
+  if (*(slot = cups_options_find(opts, name)))
+    return (opts->options[*slot - 1].value);
+  else
+    return (NULL);
+}
+
+
+//
+// 'cupsOptionsGetArray()' - Copy an option set to an option array.
+//
+// This function creates a sorted option array for use with the other option
+// array functions.  The returned array must be freed using
+// @link cupsFreeOptions@.
+//
+
+size_t					// O - Number of options
+cupsOptionsGetArray(
+    cups_options_t *opts,		// I - Option set
+    cups_option_t  **options)		// O - Options
+{
+  size_t	i;			// Looping var
+  cups_option_t	*option;		// Current option
+
+
+  // Range check input...
+  if (options)
+    *options = NULL;
+
+  if (!opts || !options || !opts->num_options)
+    return (0);
+
+  // Copy and sort the options...
+  if ((*options = (cups_option_t *)_cupsMemAlloc(CUPS_MEMTYPE_OTHER, opts->num_options * sizeof(cups_option_t))) == NULL)
+    return (0);
+
+  for (i = opts->num_options, option = *options; i > 0; i --, option ++)
+  {
+    option->name  = _cupsStrRetain(opts->options[opts->num_options - i].name);
+    option->value = _cupsStrRetain(opts->options[opts->num_options - i].value);
+  }
+
+  qsort(*options, opts->num_options, sizeof(cups_option_t), (int (*)(const void *, const void *))cups_compare_options);
+
+  return (opts->num_options);
+}
+
+
+//
+// 'cupsOptionsGetCount()' - Get the number of options in an option set.
+//
+
+size_t					// O - Number of options
+cupsOptionsGetCount(
+    cups_options_t *opts)		// I - Option set
+{
+  return (opts ? opts->num_options : 0);
+}
+
+
+//
+// 'cupsOptionsGetName()' - Get the name of an option in an option set.
+//
+// Options are numbered from `0` to the value returned by
+// @link cupsOptionsGetCount@ minus one.  Removing an option can change the
+// order of the remaining options.
+//
+
+const char *				// O - Option name or `NULL`
+cupsOptionsGetName(cups_options_t *opts,// I - Option set
+                   size_t         n)	// I - Option number (0-based)
+{
+  return (opts && n < opts->num_options ? opts->options[n].name : NULL);
+}
+
+
+//
+// 'cupsOptionsGetValue()' - Get the value of an option in an option set.
+//
+// Options are numbered from `0` to the value returned by
+// @link cupsOptionsGetCount@ minus one.  Removing an option can change the
+// order of the remaining options.
+//
+
+const char *				// O - Option value or `NULL`
+cupsOptionsGetValue(
+    cups_options_t *opts,		// I - Option set
+    size_t         n)			// I - Option number (0-based)
+{
+  return (opts && n < opts->num_options ? opts->options[n].value : NULL);
+}
+
+
+//
+// 'cupsOptionsNew()' - Create a new option set.
+//
+// Option sets provide hashed lookups and constant-time additions and removals
+// for large numbers of options.  Use @link cupsOptionsAddArray@ and
+// @link cupsOptionsGetArray@ to convert to and from option arrays.
+//
+
+cups_options_t *			// O - Option set or `NULL` on error
+cupsOptionsNew(void)
+{
+  return ((cups_options_t *)_cupsMemCalloc(CUPS_MEMTYPE_OTHER, 1, sizeof(cups_options_t)));
+}
+
+
+//
+// 'cupsOptionsRemove()' - Remove an option from an option set.
+//
+
+bool					// O - `true` if removed, `false` if not found
+cupsOptionsRemove(cups_options_t *opts,	// I - Option set
+                  const char     *name)	// I - Name of option
+{
+  size_t	*slot,			// Hash table slot
+		i,			// Index of option
+		hole,			// Empty hash table slot
+		j,			// Current hash table slot
+		k,			// Home slot of current entry
+		last;			// Index of last option plus 1
+
+
+  // Range check input...
+  if (!opts || !name || !opts->num_options)
+    return (false);
+
+  if (!*(slot = cups_options_find(opts, name)))
+    return (false);
+
+  // Free the option...
+  i = *slot - 1;
+
+  _cupsStrFree(opts->options[i].name);
+  _cupsStrFree(opts->options[i].value);
+
+  // Remove it from the hash table, shifting back any following entries in
+  // the probe sequence that would otherwise become unreachable...
+  for (hole = j = (size_t)(slot - opts->hash);;)
+  {
+    j = (j + 1) & opts->mask;
+
+    if (!opts->hash[j])
+      break;
+
+    k = cups_hash_name(opts->options[opts->hash[j] - 1].name) & opts->mask;
+
+    if (j > hole ? (k <= hole || k > j) : (k <= hole && k > j))
+    {
+      opts->hash[hole] = opts->hash[j];
+      hole             = j;
+    }
+  }
+
+  opts->hash[hole] = 0;
+
+  // Move the last option into the hole in the options array...
+  last = opts->num_options --;
+
+  if (i < opts->num_options)
+  {
+    opts->options[i] = opts->options[opts->num_options];
+
+    for (j = cups_hash_name(opts->options[i].name) & opts->mask; opts->hash[j] != last; j = (j + 1) & opts->mask);
+
+    opts->hash[j] = i + 1;
+  }
+
+  return (true);
+}
+
+
 //
 // 'cupsParseOptions()' - Parse options from a command-line argument.
 //
@@ -224,7 +537,7 @@ cupsParseOptions(
     return (0);
 
   // Make a copy of the argument string and then divide it up...
-  if ((copyarg = strdup(arg)) == NULL)
+  if ((copyarg = _cupsMemStrdup(CUPS_MEMTYPE_OTHER, arg)) == NULL)
   {
     DEBUG_puts("1cupsParseOptions: Unable to copy arg string");
     return (num_options);
@@ -357,7 +670,7 @@ cupsParseOptions(
   }
 
   // Free the copy of the argument we made and return the number of options found.
-  free(copyarg);
+  _cupsMemFree(copyarg);
 
   return (num_options);
 }
@@ -414,7 +727,12 @@ static int				// O - Result of comparison
 cups_compare_options(cups_option_t *a,	// I - First option
 		     cups_option_t *b)	// I - Second option
 {
-  return (_cups_strcasecmp(a->name, b->name));
+  // Option names are pooled, so a name passed from another option array is
+  // often the same pointer...
+  if (a->name == b->name)
+    return (0);
+  else
+    return (_cups_strcasecmp(a->name, b->name));
 }
 
 
@@ -475,3 +793,98 @@ cups_find_option(
 
   return (current);
 }
+
+
+//
+// 'cups_hash_name()' - Compute a case-insensitive hash of an option name.
+//
+
+static size_t				// O - Hash value
+cups_hash_name(const char *name)	// I - Option name
+{
+  size_t	hash = 2166136261U;	// FNV-1a hash
+
+
+  while (*name)
+  {
+    hash ^= (size_t)_cups_tolower(*name++ & 255);
+    hash *= 16777619U;
+  }
+
+  return (hash);
+}
+
+
+//
+// 'cups_options_find()' - Find the hash table slot for an option.
+//
+// The returned slot contains `0` if the option is not in the set.
+//
+
+static size_t *				// O - Hash table slot
+cups_options_find(cups_options_t *opts,	// I - Option set
+                  const char     *name)	// I - Option name
+{
+  size_t	j;			// Current slot
+
+
+  for (j = cups_hash_name(name) & opts->mask; opts->hash[j]; j = (j + 1) & opts->mask)
+  {
+    if (!_cups_strcasecmp(name, opts->options[opts->hash[j] - 1].name))
+      break;
+  }
+
+  return (opts->hash + j);
+}
+
+
+//
+// 'cups_options_resize()' - Grow the options and hash table of an option set.
+//
+
+static bool				// O - `true` on success, `false` on error
+cups_options_resize(
+    cups_options_t *opts)		// I - Option set
+{
+  size_t	alloc_options,		// New allocated options
+		hsize,			// New hash table size
+		*hash,			// New hash table
+		i,			// Looping var
+		j;			// Slot
+  cups_option_t	*options;		// New options
+
+
+  if (opts->num_options >= opts->alloc_options)
+  {
+    alloc_options = opts->alloc_options ? 2 * opts->alloc_options : 16;
+
+    if ((options = (cups_option_t *)_cupsMemRealloc(CUPS_MEMTYPE_OTHER, opts->options, alloc_options * sizeof(cups_option_t))) == NULL)
+      return (false);
+
+    opts->options       = options;
+    opts->alloc_options = alloc_options;
+  }
+
+  if (2 * (opts->num_options + 1) > opts->mask + 1)
+  {
+    // Keep the hash table at most half full...
+    for (hsize = opts->mask ? 2 * (opts->mask + 1) : 32; hsize < 2 * (opts->num_options + 1); hsize *= 2);
+
+    if ((hash = (size_t *)_cupsMemCalloc(CUPS_MEMTYPE_OTHER, hsize, sizeof(size_t))) == NULL)
+      return (false);
+
+    for (i = 0; i < opts->num_options; i ++)
+    {
+      for (j = cups_hash_name(opts->options[i].name) & (hsize - 1); hash[j]; j = (j + 1) & (hsize - 1));
+
+      hash[j] = i + 1;
+    }
+
+    _cupsMemFree(opts->hash);
+
+    opts->hash = hash;
+    opts->mask = hsize - 1;
+  }
+
+  return (true);
+}
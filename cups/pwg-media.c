@@ -10,6 +10,7 @@
 
 #include "cups-private.h"
 #include <math.h>
+#include <stddef.h>
 
 
 //
@@ -25,11 +26,17 @@
 // Local functions...
 //
 
-static int	pwg_compare_legacy(pwg_media_t *a, pwg_media_t *b);
-static int	pwg_compare_pwg(pwg_media_t *a, pwg_media_t *b);
-static int	pwg_compare_ppd(pwg_media_t *a, pwg_media_t *b);
+static int	pwg_compare_legacy(const pwg_media_t **a, const pwg_media_t **b);
+static int	pwg_compare_pwg(const pwg_media_t **a, const pwg_media_t **b);
+static int	pwg_compare_ppd(const pwg_media_t **a, const pwg_media_t **b);
+static int	pwg_compare_table(const pwg_media_t **a, const pwg_media_t **b);
+static int	pwg_compare_width(const pwg_media_t **a, const pwg_media_t **b);
+static pwg_media_t *pwg_find_lut(const pwg_media_t **lut, size_t num_lut, size_t offset, const char *name);
 static char	*pwg_format_inches(char *buf, size_t bufsize, int val);
 static char	*pwg_format_millimeters(char *buf, size_t bufsize, int val);
+static _cups_pwg_custom_t *pwg_get_custom(_cups_globals_t *cg);
+static void	pwg_init_luts(void);
+static void	pwg_init_luts_once(void);
 static int	pwg_scan_measurement(const char *buf, char **bufptr, int numer, int denom);
 
 
@@ -273,6 +280,28 @@ static pwg_media_t const cups_pwg_media[] =
   _PWG_MEDIA_IN("roc_8k_10.75x15.5in", NULL, "roc8k", 10.75, 15.5)
 };
 
+#define _PWG_NUM_MEDIA	(sizeof(cups_pwg_media) / sizeof(cups_pwg_media[0]))
+
+static const pwg_media_t *pwg_leg_lut[_PWG_NUM_MEDIA],
+			*pwg_ppd_lut[_PWG_NUM_MEDIA],
+			*pwg_pwg_lut[_PWG_NUM_MEDIA],
+			*pwg_width_lut[_PWG_NUM_MEDIA];
+					// Lookup tables for legacy, PPD, and PWG names and widths
+static size_t		pwg_num_leg_lut = 0,
+			pwg_num_ppd_lut = 0,
+			pwg_num_pwg_lut = 0,
+			pwg_num_width_lut = 0;
+					// Number of entries in lookup tables
+#ifdef _WIN32
+static cups_mutex_t	pwg_lut_mutex = CUPS_MUTEX_INITIALIZER;
+					// Mutex for lookup tables
+static bool		pwg_lut_init = false;
+					// Lookup tables initialized?
+#else
+static pthread_once_t	pwg_lut_once = PTHREAD_ONCE_INIT;
+					// One-time initialization of lookup tables
+#endif // _WIN32
+
 
 //
 // 'pwgFormatSizeName()' - Generate a PWG self-describing media size name.
@@ -542,32 +571,14 @@ pwgInitSize(pwg_size_t *size,		// I - Size to initialize
 pwg_media_t *				// O - Matching size or NULL
 pwgMediaForLegacy(const char *legacy)	// I - Legacy size name
 {
-  pwg_media_t	key;			// Search key
-  _cups_globals_t *cg = _cupsGlobals();	// Global data
-
-
   // Range check input...
   if (!legacy)
     return (NULL);
 
-  // Build the lookup table for PWG names as needed...
-  if (!cg->leg_size_lut)
-  {
-    size_t	i;			// Looping var
-    pwg_media_t	*size;			// Current size
-
-    cg->leg_size_lut = cupsArrayNew((cups_array_cb_t)pwg_compare_legacy, NULL, NULL, 0, NULL, NULL);
-
-    for (i = sizeof(cups_pwg_media) / sizeof(cups_pwg_media[0]), size = (pwg_media_t *)cups_pwg_media; i > 0; i --, size ++)
-    {
-      if (size->legacy)
-	cupsArrayAdd(cg->leg_size_lut, size);
-    }
-  }
-
   // Lookup the name...
-  key.legacy = legacy;
-  return ((pwg_media_t *)cupsArrayFind(cg->leg_size_lut, &key));
+  pwg_init_luts();
+
+  return (pwg_find_lut(pwg_leg_lut, pwg_num_leg_lut, offsetof(pwg_media_t, legacy), legacy));
 }
 
 
@@ -587,8 +598,7 @@ pwgMediaForLegacy(const char *legacy)	// I - Legacy size name
 pwg_media_t *				// O - Matching size or NULL
 pwgMediaForPPD(const char *ppd)		// I - PPD size name
 {
-  pwg_media_t	key,			// Search key
-		*size;			// Matching size
+  pwg_media_t	*size;			// Matching size
   _cups_globals_t *cg = _cupsGlobals();	// Global data
 
 
@@ -596,23 +606,10 @@ pwgMediaForPPD(const char *ppd)		// I - PPD size name
   if (!ppd)
     return (NULL);
 
-  // Build the lookup table for PWG names as needed...
-  if (!cg->ppd_size_lut)
-  {
-    size_t	i;			// Looping var
-
-    cg->ppd_size_lut = cupsArrayNew((cups_array_cb_t)pwg_compare_ppd, NULL, NULL, 0, NULL, NULL);
-
-    for (i = sizeof(cups_pwg_media) / sizeof(cups_pwg_media[0]), size = (pwg_media_t *)cups_pwg_media; i > 0; i --, size ++)
-    {
-      if (size->ppd)
-        cupsArrayAdd(cg->ppd_size_lut, size);
-    }
-  }
-
   // Lookup the name...
-  key.ppd = ppd;
-  if ((size = (pwg_media_t *)cupsArrayFind(cg->ppd_size_lut, &key)) == NULL)
+  pwg_init_luts();
+
+  if ((size = pwg_find_lut(pwg_ppd_lut, pwg_num_ppd_lut, offsetof(pwg_media_t, ppd), ppd)) == NULL)
   {
     // See if the name is of the form:
     //
@@ -704,19 +701,23 @@ pwgMediaForPPD(const char *ppd)		// I - PPD size name
 	//
 	//   [oe|om]_WIDTHxHEIGHTuu_WIDTHxHEIGHTuu
         char	wstr[32], lstr[32];	// Width and length as strings
+	_cups_pwg_custom_t *pc;		// Custom size data
 
-	size         = &(cg->pwg_media);
+	if ((pc = pwg_get_custom(cg)) == NULL)
+	  return (NULL);
+
+	size         = &(pc->media);
 	size->width  = w;
 	size->length = l;
-	size->pwg    = cg->pwg_name;
+	size->pwg    = pc->pwg_name;
 
-	pwgFormatSizeName(cg->pwg_name, sizeof(cg->pwg_name), custom ? "custom" : NULL, custom ? ppd + 7 : NULL, size->width, size->length, NULL);
+	pwgFormatSizeName(pc->pwg_name, sizeof(pc->pwg_name), custom ? "custom" : NULL, custom ? ppd + 7 : NULL, size->width, size->length, NULL);
 
         if ((w % 635) == 0 && (l % 635) == 0)
-          snprintf(cg->ppd_name, sizeof(cg->ppd_name), "%sx%s", pwg_format_inches(wstr, sizeof(wstr), w), pwg_format_inches(lstr, sizeof(lstr), l));
+          snprintf(pc->ppd_name, sizeof(pc->ppd_name), "%sx%s", pwg_format_inches(wstr, sizeof(wstr), w), pwg_format_inches(lstr, sizeof(lstr), l));
         else
-          snprintf(cg->ppd_name, sizeof(cg->ppd_name), "%sx%smm", pwg_format_millimeters(wstr, sizeof(wstr), w), pwg_format_millimeters(lstr, sizeof(lstr), l));
-        size->ppd = cg->ppd_name;
+          snprintf(pc->ppd_name, sizeof(pc->ppd_name), "%sx%smm", pwg_format_millimeters(wstr, sizeof(wstr), w), pwg_format_millimeters(lstr, sizeof(lstr), l));
+        size->ppd = pc->ppd_name;
       }
     }
   }
@@ -740,8 +741,7 @@ pwg_media_t *				// O - Matching size or NULL
 pwgMediaForPWG(const char *pwg)		// I - PWG size name
 {
   char		*ptr;			// Pointer into name
-  pwg_media_t	key,			// Search key
-		*size;			// Matching size
+  pwg_media_t	*size;			// Matching size
   _cups_globals_t *cg = _cupsGlobals();	// Global data
 
 
@@ -749,20 +749,10 @@ pwgMediaForPWG(const char *pwg)		// I - PWG size name
   if (!pwg)
     return (NULL);
 
-  // Build the lookup table for PWG names as needed...
-  if (!cg->pwg_size_lut)
-  {
-    size_t	i;			// Looping var
-
-    cg->pwg_size_lut = cupsArrayNew((cups_array_cb_t)pwg_compare_pwg, NULL, NULL, 0, NULL, NULL);
-
-    for (i = sizeof(cups_pwg_media) / sizeof(cups_pwg_media[0]), size = (pwg_media_t *)cups_pwg_media; i > 0; i --, size ++)
-      cupsArrayAdd(cg->pwg_size_lut, size);
-  }
-
   // Lookup the name...
-  key.pwg = pwg;
-  if ((size = (pwg_media_t *)cupsArrayFind(cg->pwg_size_lut, &key)) == NULL &&
+  pwg_init_luts();
+
+  if ((size = pwg_find_lut(pwg_pwg_lut, pwg_num_pwg_lut, offsetof(pwg_media_t, pwg), pwg)) == NULL &&
       (ptr = (char *)strchr(pwg, '_')) != NULL &&
       (ptr = (char *)strchr(ptr + 1, '_')) != NULL)
   {
@@ -795,22 +785,26 @@ pwgMediaForPWG(const char *pwg)		// I - PWG size name
       if (ptr)
       {
         char	wstr[32], lstr[32];	// Width and length strings
+	_cups_pwg_custom_t *pc;		// Custom size data
 
         if (!strncmp(pwg, "disc_", 5))
           w = l;			// Make the media size OUTERxOUTER
 
-        size         = &(cg->pwg_media);
+	if ((pc = pwg_get_custom(cg)) == NULL)
+	  return (NULL);
+
+        size         = &(pc->media);
         size->width  = w;
         size->length = l;
 
-        cupsCopyString(cg->pwg_name, pwg, sizeof(cg->pwg_name));
-	size->pwg = cg->pwg_name;
+        cupsCopyString(pc->pwg_name, pwg, sizeof(pc->pwg_name));
+	size->pwg = pc->pwg_name;
 
         if (numer == 100)
-          snprintf(cg->ppd_name, sizeof(cg->ppd_name), "%sx%smm", pwg_format_millimeters(wstr, sizeof(wstr), w), pwg_format_millimeters(lstr, sizeof(lstr), l));
+          snprintf(pc->ppd_name, sizeof(pc->ppd_name), "%sx%smm", pwg_format_millimeters(wstr, sizeof(wstr), w), pwg_format_millimeters(lstr, sizeof(lstr), l));
         else
-          snprintf(cg->ppd_name, sizeof(cg->ppd_name), "%sx%s", pwg_format_inches(wstr, sizeof(wstr), w), pwg_format_inches(lstr, sizeof(lstr), l));
-        size->ppd = cg->ppd_name;
+          snprintf(pc->ppd_name, sizeof(pc->ppd_name), "%sx%s", pwg_format_inches(wstr, sizeof(wstr), w), pwg_format_inches(lstr, sizeof(lstr), l));
+        size->ppd = pc->ppd_name;
       }
     }
   }
@@ -850,13 +844,20 @@ _pwgMediaNearSize(int width,	        // I - Width in hundredths of millimeters
 		  int length,		// I - Length in hundredths of millimeters
 		  int epsilon)		// I - Match within this tolernace. PWG units
 {
-  size_t	i;			// Looping var
-  pwg_media_t	*media,			// Current media
+  size_t	i,			// Looping var
+		left,			// Left side of search
+		right,			// Right side of search
+		current,		// Current entry
+		num_matches;		// Number of candidate sizes
+  const pwg_media_t *media,		// Current media
+		*matches[64],		// Candidate sizes
 		*best_media = NULL;	// Best match
+  bool		all_media;		// Check all media sizes?
   int		dw, dl,			// Difference in width and length
 		best_dw = 999,		// Best difference in width and length
 		best_dl = 999;
   char		wstr[32], lstr[32];	// Width and length as strings
+  _cups_pwg_custom_t *pc;		// Custom size data
   _cups_globals_t *cg = _cupsGlobals();	// Global data
 
 
@@ -864,46 +865,91 @@ _pwgMediaNearSize(int width,	        // I - Width in hundredths of millimeters
   if (width <= 0 || length <= 0)
     return (NULL);
 
-  // Look for a standard size...
-  for (i = sizeof(cups_pwg_media) / sizeof(cups_pwg_media[0]), media = (pwg_media_t *)cups_pwg_media; i > 0; i --, media ++)
+  // See if this is the same size as the last lookup...
+  if (cg->pwg_near_media && cg->pwg_near_width == width && cg->pwg_near_length == length && cg->pwg_near_epsilon == epsilon)
+    return (cg->pwg_near_media);
+
+  // Find the first size that is within the tolerance for the width...
+  pwg_init_luts();
+
+  for (left = 0, right = pwg_num_width_lut; left < right;)
+  {
+    current = (left + right) / 2;
+
+    if (pwg_width_lut[current]->width < (width - epsilon))
+      left = current + 1;
+    else
+      right = current;
+  }
+
+  // Collect the sizes that are within the tolerance for both dimensions...
+  for (num_matches = 0; left < pwg_num_width_lut && pwg_width_lut[left]->width <= (width + epsilon); left ++)
+  {
+    if (abs(pwg_width_lut[left]->length - length) > epsilon)
+      continue;
+
+    if (num_matches >= (sizeof(matches) / sizeof(matches[0])))
+      break;
+
+    matches[num_matches ++] = pwg_width_lut[left];
+  }
+
+  all_media = left < pwg_num_width_lut && pwg_width_lut[left]->width <= (width + epsilon);
+
+  if (all_media)
+    num_matches = _PWG_NUM_MEDIA;	// Too many candidates, check every size
+  else if (num_matches > 1)
+    qsort(matches, num_matches, sizeof(pwg_media_t *), (int (*)(const void *, const void *))pwg_compare_table);
+
+  // Look for a standard size, checking candidates in table order...
+  for (i = 0; i < num_matches; i ++)
   {
+    media = all_media ? cups_pwg_media + i : matches[i];
     dw = abs(media->width - width);
     dl = abs(media->length - length);
 
     if (!dw && !dl)
     {
-      return (media);
+      best_media = media;
+      break;
     }
-    else if (dw <= epsilon && dl <= epsilon)
+    else if (dw <= epsilon && dl <= epsilon && dw <= best_dw && dl <= best_dl)
     {
-      if (dw <= best_dw && dl <= best_dl)
-      {
-        best_media = media;
-        best_dw    = dw;
-        best_dl    = dl;
-      }
+      best_media = media;
+      best_dw    = dw;
+      best_dl    = dl;
     }
   }
 
   if (best_media)
-    return (best_media);
+  {
+    cg->pwg_near_media   = (pwg_media_t *)best_media;
+    cg->pwg_near_width   = width;
+    cg->pwg_near_length  = length;
+    cg->pwg_near_epsilon = epsilon;
+
+    return ((pwg_media_t *)best_media);
+  }
 
   // Not a standard size; convert it to a PWG custom name of the form:
   //
   //   custom_WIDTHxHEIGHTuu_WIDTHxHEIGHTuu
-  pwgFormatSizeName(cg->pwg_name, sizeof(cg->pwg_name), "custom", NULL, width, length, NULL);
+  if ((pc = pwg_get_custom(cg)) == NULL)
+    return (NULL);
+
+  pwgFormatSizeName(pc->pwg_name, sizeof(pc->pwg_name), "custom", NULL, width, length, NULL);
 
-  cg->pwg_media.pwg    = cg->pwg_name;
-  cg->pwg_media.width  = width;
-  cg->pwg_media.length = length;
+  pc->media.pwg    = pc->pwg_name;
+  pc->media.width  = width;
+  pc->media.length = length;
 
   if ((width % 635) == 0 && (length % 635) == 0)
-    snprintf(cg->ppd_name, sizeof(cg->ppd_name), "%sx%s", pwg_format_inches(wstr, sizeof(wstr), width), pwg_format_inches(lstr, sizeof(lstr), length));
+    snprintf(pc->ppd_name, sizeof(pc->ppd_name), "%sx%s", pwg_format_inches(wstr, sizeof(wstr), width), pwg_format_inches(lstr, sizeof(lstr), length));
   else
-    snprintf(cg->ppd_name, sizeof(cg->ppd_name), "%sx%smm", pwg_format_millimeters(wstr, sizeof(wstr), width), pwg_format_millimeters(lstr, sizeof(lstr), length));
-  cg->pwg_media.ppd = cg->ppd_name;
+    snprintf(pc->ppd_name, sizeof(pc->ppd_name), "%sx%smm", pwg_format_millimeters(wstr, sizeof(wstr), width), pwg_format_millimeters(lstr, sizeof(lstr), length));
+  pc->media.ppd = pc->ppd_name;
 
-  return (&(cg->pwg_media));
+  return (&(pc->media));
 }
 
 
@@ -925,10 +971,17 @@ _pwgMediaTable(size_t *num_media)	// O - Number of entries
 //
 
 static int				// O - Result of comparison
-pwg_compare_legacy(pwg_media_t *a,	// I - First size
-                   pwg_media_t *b)	// I - Second size
+pwg_compare_legacy(const pwg_media_t **a,	// I - First size
+                   const pwg_media_t **b)	// I - Second size
 {
-  return (strcmp(a->legacy, b->legacy));
+  int	result;				// Result of comparison
+
+
+  // Sort matching names in table order...
+  if ((result = strcmp((*a)->legacy, (*b)->legacy)) == 0)
+    result = (*a < *b) ? -1 : (*a > *b);
+
+  return (result);
 }
 
 
@@ -937,10 +990,17 @@ pwg_compare_legacy(pwg_media_t *a,	// I - First size
 //
 
 static int				// O - Result of comparison
-pwg_compare_ppd(pwg_media_t *a,	// I - First size
-                pwg_media_t *b)	// I - Second size
+pwg_compare_ppd(const pwg_media_t **a,	// I - First size
+                const pwg_media_t **b)	// I - Second size
 {
-  return (strcmp(a->ppd, b->ppd));
+  int	result;				// Result of comparison
+
+
+  // Sort matching names in table order...
+  if ((result = strcmp((*a)->ppd, (*b)->ppd)) == 0)
+    result = (*a < *b) ? -1 : (*a > *b);
+
+  return (result);
 }
 
 
@@ -949,10 +1009,76 @@ pwg_compare_ppd(pwg_media_t *a,	// I - First size
 //
 
 static int				// O - Result of comparison
-pwg_compare_pwg(pwg_media_t *a,	// I - First size
-                pwg_media_t *b)	// I - Second size
+pwg_compare_pwg(const pwg_media_t **a,	// I - First size
+                const pwg_media_t **b)	// I - Second size
+{
+  int	result;				// Result of comparison
+
+
+  // Sort matching names in table order...
+  if ((result = strcmp((*a)->pwg, (*b)->pwg)) == 0)
+    result = (*a < *b) ? -1 : (*a > *b);
+
+  return (result);
+}
+
+
+//
+// 'pwg_compare_table()' - Compare two sizes using their order in the table.
+//
+
+static int				// O - Result of comparison
+pwg_compare_table(const pwg_media_t **a,// I - First size
+                  const pwg_media_t **b)// I - Second size
+{
+  return ((*a < *b) ? -1 : (*a > *b));
+}
+
+
+//
+// 'pwg_compare_width()' - Compare two sizes using their widths.
+//
+
+static int				// O - Result of comparison
+pwg_compare_width(const pwg_media_t **a,// I - First size
+                  const pwg_media_t **b)// I - Second size
 {
-  return (strcmp(a->pwg, b->pwg));
+  if ((*a)->width != (*b)->width)
+    return ((*a)->width < (*b)->width ? -1 : 1);
+  else
+    return (pwg_compare_table(a, b));
+}
+
+
+//
+// 'pwg_find_lut()' - Find the first size with the given name in a lookup table.
+//
+
+static pwg_media_t *			// O - Matching size or `NULL`
+pwg_find_lut(const pwg_media_t **lut,	// I - Lookup table
+             size_t            num_lut,	// I - Number of entries in table
+             size_t            offset,	// I - Offset of name in size
+             const char        *name)	// I - Name to find
+{
+  size_t	left,			// Left side of search
+		right,			// Right side of search
+		current;		// Current entry
+
+
+  for (left = 0, right = num_lut; left < right;)
+  {
+    current = (left + right) / 2;
+
+    if (strcmp(*(const char * const *)((const char *)lut[current] + offset), name) < 0)
+      left = current + 1;
+    else
+      right = current;
+  }
+
+  if (left < num_lut && !strcmp(*(const char * const *)((const char *)lut[left] + offset), name))
+    return ((pwg_media_t *)lut[left]);
+  else
+    return (NULL);
 }
 
 
@@ -1021,6 +1147,76 @@ pwg_format_millimeters(char   *buf,	// I - Buffer
 }
 
 
+//
+// 'pwg_get_custom()' - Get the custom size data for the current thread.
+//
+// The custom size data is only allocated when a thread first needs it.
+//
+
+static _cups_pwg_custom_t *		// O - Custom size data or `NULL` on error
+pwg_get_custom(_cups_globals_t *cg)	// I - Global data
+{
+  if (!cg->pwg_custom)
+    cg->pwg_custom = _cupsMemCalloc(CUPS_MEMTYPE_OTHER, 1, sizeof(_cups_pwg_custom_t));
+
+  return (cg->pwg_custom);
+}
+
+
+//
+// 'pwg_init_luts()' - Initialize the lookup tables.
+//
+// The lookup tables are sorted pointers to the static media size table and are
+// shared by all threads.
+//
+
+static void
+pwg_init_luts(void)
+{
+#ifdef _WIN32
+  cupsMutexLock(&pwg_lut_mutex);
+  if (!pwg_lut_init)
+  {
+    pwg_init_luts_once();
+    pwg_lut_init = true;
+  }
+  cupsMutexUnlock(&pwg_lut_mutex);
+
+#else
+  pthread_once(&pwg_lut_once, pwg_init_luts_once);
+#endif // _WIN32
+}
+
+
+//
+// 'pwg_init_luts_once()' - Build the lookup tables.
+//
+
+static void
+pwg_init_luts_once(void)
+{
+  size_t		i;		// Looping var
+  const pwg_media_t	*size;		// Current size
+
+
+  for (i = _PWG_NUM_MEDIA, size = cups_pwg_media; i > 0; i --, size ++)
+  {
+    if (size->legacy)
+      pwg_leg_lut[pwg_num_leg_lut ++] = size;
+    if (size->ppd)
+      pwg_ppd_lut[pwg_num_ppd_lut ++] = size;
+
+    pwg_pwg_lut[pwg_num_pwg_lut ++]     = size;
+    pwg_width_lut[pwg_num_width_lut ++] = size;
+  }
+
+  qsort(pwg_leg_lut, pwg_num_leg_lut, sizeof(pwg_media_t *), (int (*)(const void *, const void *))pwg_compare_legacy);
+  qsort(pwg_ppd_lut, pwg_num_ppd_lut, sizeof(pwg_media_t *), (int (*)(const void *, const void *))pwg_compare_ppd);
+  qsort(pwg_pwg_lut, pwg_num_pwg_lut, sizeof(pwg_media_t *), (int (*)(const void *, const void *))pwg_compare_pwg);
+  qsort(pwg_width_lut, pwg_num_width_lut, sizeof(pwg_media_t *), (int (*)(const void *, const void *))pwg_compare_width);
+}
+
+
 //
 // 'pwg_scan_measurement()' - Scan a measurement in inches or millimeters.
 //
@@ -1,17 +1,39 @@
 //
-// Random number function for CUPS.
+// Random number functions for CUPS.
 //
-// Copyright © 2019-2022 by Michael R Sweet.
+// Copyright © 2019-2022 by Michael R Sweet.
 //
 // Licensed under Apache License v2.0.  See the file "LICENSE" for more
 // information.
 //
 
-#include "cups.h"
+#include "cups-private.h"
 #if !defined(_WIN32) && !defined(__APPLE__)
 #  include <unistd.h>
 #  include <fcntl.h>
 #  include <pthread.h>
+#  ifdef HAVE_GETRANDOM
+#    include <sys/random.h>
+#  endif // HAVE_GETRANDOM
+
+
+//
+// Local globals...
+//
+
+static unsigned		rand_forks = 0;	// Number of forks
+static pthread_once_t	rand_once = PTHREAD_ONCE_INIT;
+					// One-time initialization object
+
+
+//
+// Local functions...
+//
+
+static void		rand_child(void);
+static void		rand_fill(_cups_globals_t *cg);
+static void		rand_init_once(void);
+static void		rand_seed(_cups_globals_t *cg);
 #endif // !_WIN32 && !__APPLE__
 
 
@@ -40,86 +62,253 @@ cupsGetRand(void)
   return (arc4random());
 
 #else
-  // Use a Mersenne twister random number generator seeded from /dev/urandom...
-  unsigned	i,			// Looping var
-		temp;			// Temporary value
-  static bool	first_time = true;	// First time we ran?
-  static unsigned mt_state[624],	// Mersenne twister state
-		mt_index;		// Mersenne twister index
-  static pthread_mutex_t mt_mutex = PTHREAD_MUTEX_INITIALIZER;
-					// Mutex to control access to state
+  // Pull 32-bits from the per-thread random buffer...
+  unsigned	v;			// Random number
 
 
-  pthread_mutex_lock(&mt_mutex);
+  cupsGetRandBytes(&v, sizeof(v));
 
-  if (first_time)
-  {
-    int		fd;			// "/dev/urandom" file
-    struct timeval curtime;		// Current time
+  return (v);
+#endif // _WIN32
+}
 
-    // Seed the random number state...
-    if ((fd = open("/dev/urandom", O_RDONLY)) >= 0)
-    {
-      // Read random entropy from the system...
-      if (read(fd, mt_state, sizeof(mt_state[0])) < sizeof(mt_state[0]))
-        mt_state[0] = 0;		// Force fallback...
 
-      close(fd);
-    }
-    else
-      mt_state[0] = 0;
+//
+// 'cupsGetRandBytes()' - Fill a buffer with pseudo-random bytes.
+//
+// This function fills a buffer with cryptographically strong pseudo-random
+// bytes suitable for use as keys, one-time identifiers, or nonces.  The random
+// bytes are generated/seeded using system entropy.
+//
+
+void
+cupsGetRandBytes(void   *buffer,	// I - Buffer
+                 size_t bytes)		// I - Number of bytes
+{
+#if _WIN32
+  // rand_s uses real entropy...
+  unsigned char	*bufptr = (unsigned char *)buffer;
+					// Pointer into buffer
+  unsigned	v;			// Random number
 
-    if (!mt_state[0])
+
+  while (bytes > 0)
+  {
+    rand_s(&v);
+
+    if (bytes < sizeof(v))
     {
-      // Fallback to using the current time in microseconds...
-      gettimeofday(&curtime, NULL);
-      mt_state[0] = (unsigned)(curtime.tv_sec + curtime.tv_usec);
+      memcpy(bufptr, &v, bytes);
+      break;
     }
 
-    mt_index = 0;
+    memcpy(bufptr, &v, sizeof(v));
+    bufptr += sizeof(v);
+    bytes  -= sizeof(v);
+  }
+
+#elif defined(__APPLE__)
+  // macOS/iOS arc4random_buf() uses real entropy automatically...
+  arc4random_buf(buffer, bytes);
+
+#else
+  // Use a per-thread ChaCha20 generator seeded from system entropy...
+  _cups_globals_t *cg = _cupsGlobals();	// Global data
+  unsigned char	*bufptr = (unsigned char *)buffer,
+					// Pointer into buffer
+		*randptr;		// Pointer into random bytes
+  size_t	count;			// Number of bytes to copy
+
+
+  if (!cg->rand_seeded || cg->rand_forks != rand_forks)
+    rand_seed(cg);
+
+  while (bytes > 0)
+  {
+    if (cg->rand_avail == 0)
+      rand_fill(cg);
+
+    if ((count = cg->rand_avail) > bytes)
+      count = bytes;
+
+    // Copy bytes from the end of the buffer and erase them so they cannot be
+    // recovered later...
+    randptr = cg->rand_buffer + sizeof(cg->rand_buffer) - cg->rand_avail;
 
-    for (i = 1; i < 624; i ++)
-      mt_state[i] = (unsigned)((1812433253 * (mt_state[i - 1] ^ (mt_state[i - 1] >> 30))) + i);
+    memcpy(bufptr, randptr, count);
+    memset(randptr, 0, count);
 
-    first_time = false;
+    cg->rand_avail -= count;
+    bufptr         += count;
+    bytes          -= count;
   }
+#endif // _WIN32
+}
+
+
+#if !defined(_WIN32) && !defined(__APPLE__)
+//
+// 'rand_child()' - Force a reseed in a child process.
+//
+
+static void
+rand_child(void)
+{
+  rand_forks ++;
+}
 
-  if (mt_index == 0)
+
+//
+// 'rand_fill()' - Fill the random buffer using ChaCha20.
+//
+// Four ChaCha20 blocks (RFC 8439) are generated using the current key.  The
+// first 32 bytes of output replace the key ("fast key erasure") so that
+// previously returned bytes cannot be reconstructed from the current state,
+// and the remaining bytes are made available to cupsGetRandBytes.
+//
+
+static void
+rand_fill(_cups_globals_t *cg)		// I - Global data
+{
+  uint32_t	block,			// Current block
+		i,			// Looping var
+		input[16],		// Input state
+		x[16];			// Working state
+  unsigned char	*bufptr;		// Pointer into buffer
+
+
+#  define RAND_ROTL(v,n) (((v) << (n)) | ((v) >> (32 - (n))))
+#  define RAND_QR(a,b,c,d) \
+  x[a] += x[b]; x[d] ^= x[a]; x[d] = RAND_ROTL(x[d], 16); \
+  x[c] += x[d]; x[b] ^= x[c]; x[b] = RAND_ROTL(x[b], 12); \
+  x[a] += x[b]; x[d] ^= x[a]; x[d] = RAND_ROTL(x[d], 8); \
+  x[c] += x[d]; x[b] ^= x[c]; x[b] = RAND_ROTL(x[b], 7)
+
+  // Initialize the state with the "expand 32-byte k" constants, key, block
+  // counter, and a zero nonce...
+  input[0] = 0x61707865;
+  input[1] = 0x3320646e;
+  input[2] = 0x79622d32;
+  input[3] = 0x6b206574;
+
+  memcpy(input + 4, cg->rand_key, sizeof(cg->rand_key));
+
+  input[13] = input[14] = input[15] = 0;
+
+  for (block = 0, bufptr = cg->rand_buffer; block < (sizeof(cg->rand_buffer) / 64); block ++)
   {
-    // Generate a sequence of random numbers...
-    unsigned i1 = 1, i397 = 397;	// Looping vars
+    input[12] = block;
 
-    for (i = 0; i < 624; i ++)
+    memcpy(x, input, sizeof(x));
+
+    for (i = 0; i < 10; i ++)
+    {
+      // Column rounds...
+      RAND_QR(0, 4, 8, 12);
+      RAND_QR(1, 5, 9, 13);
+      RAND_QR(2, 6, 10, 14);
+      RAND_QR(3, 7, 11, 15);
+
+      // Diagonal rounds...
+      RAND_QR(0, 5, 10, 15);
+      RAND_QR(1, 6, 11, 12);
+      RAND_QR(2, 7, 8, 13);
+      RAND_QR(3, 4, 9, 14);
+    }
+
+    // Add the input state and store in little-endian order...
+    for (i = 0; i < 16; i ++)
     {
-      temp        = (mt_state[i] & 0x80000000) + (mt_state[i1] & 0x7fffffff);
-      mt_state[i] = mt_state[i397] ^ (temp >> 1);
+      x[i] += input[i];
+
+      *bufptr++ = (unsigned char)x[i];
+      *bufptr++ = (unsigned char)(x[i] >> 8);
+      *bufptr++ = (unsigned char)(x[i] >> 16);
+      *bufptr++ = (unsigned char)(x[i] >> 24);
+    }
+  }
+
+#  undef RAND_QR
+#  undef RAND_ROTL
+
+  // Rekey using the first 32 bytes...
+  memcpy(cg->rand_key, cg->rand_buffer, sizeof(cg->rand_key));
+  memset(cg->rand_buffer, 0, sizeof(cg->rand_key));
+  memset(input, 0, sizeof(input));
+  memset(x, 0, sizeof(x));
+
+  cg->rand_avail = sizeof(cg->rand_buffer) - sizeof(cg->rand_key);
+}
 
-      if (temp & 1)
-	mt_state[i] ^= 2567483615u;
 
-      i1 ++;
-      i397 ++;
+//
+// 'rand_init_once()' - Register the fork handler.
+//
+
+static void
+rand_init_once(void)
+{
+  pthread_atfork(NULL, NULL, rand_child);
+}
+
+
+//
+// 'rand_seed()' - Seed the per-thread generator from system entropy.
+//
+
+static void
+rand_seed(_cups_globals_t *cg)		// I - Global data
+{
+  size_t	bytes = 0;		// Bytes of entropy read
+  ssize_t	rbytes;			// Bytes read
+  int		fd;			// "/dev/urandom" file
+
 
-      if (i1 == 624)
-	i1 = 0;
+  pthread_once(&rand_once, rand_init_once);
 
-      if (i397 == 624)
-	i397 = 0;
+#  ifdef HAVE_GETRANDOM
+  // Read random entropy from the system...
+  while (bytes < sizeof(cg->rand_key))
+  {
+    if ((rbytes = getrandom((char *)cg->rand_key + bytes, sizeof(cg->rand_key) - bytes, 0)) > 0)
+      bytes += (size_t)rbytes;
+    else if (rbytes < 0 && errno != EINTR)
+      break;
+  }
+#  endif // HAVE_GETRANDOM
+
+  if (bytes < sizeof(cg->rand_key) && (fd = open("/dev/urandom", O_RDONLY)) >= 0)
+  {
+    // Read random entropy from the system...
+    while (bytes < sizeof(cg->rand_key))
+    {
+      if ((rbytes = read(fd, (char *)cg->rand_key + bytes, sizeof(cg->rand_key) - bytes)) > 0)
+        bytes += (size_t)rbytes;
+      else if (rbytes == 0 || errno != EINTR)
+        break;
     }
+
+    close(fd);
   }
 
-  // Pull 32-bits of random data...
-  temp = mt_state[mt_index ++];
-  temp ^= temp >> 11;
-  temp ^= (temp << 7) & 2636928640u;
-  temp ^= (temp << 15) & 4022730752u;
-  temp ^= temp >> 18;
+  if (bytes < sizeof(cg->rand_key))
+  {
+    // Fallback to using the current time in microseconds, process ID, and
+    // thread data address...
+    struct timeval curtime;		// Current time
+
+    gettimeofday(&curtime, NULL);
 
-  if (mt_index == 624)
-    mt_index = 0;
+    cg->rand_key[0] ^= (uint32_t)curtime.tv_sec;
+    cg->rand_key[1] ^= (uint32_t)curtime.tv_usec;
+    cg->rand_key[2] ^= (uint32_t)getpid();
+    cg->rand_key[3] ^= (uint32_t)(uintptr_t)cg;
+  }
 
-  pthread_mutex_unlock(&mt_mutex);
+  memset(cg->rand_buffer, 0, sizeof(cg->rand_buffer));
 
-  return (temp);
-#endif // _WIN32
+  cg->rand_avail  = 0;
+  cg->rand_forks  = rand_forks;
+  cg->rand_seeded = true;
 }
+#endif // !_WIN32 && !__APPLE__
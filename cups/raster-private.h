@@ -38,6 +38,8 @@ struct _cups_raster_s			// Raster stream data
   cups_raster_cb_t	iocb;		// IO callback
   cups_raster_mode_t	mode;		// Read/write mode
   cups_page_header_t	header;		// Raster header for current page
+  cups_page_header_t	cheader;	// Last page header as read or written
+  bool			cvalid;		// Is the last page header valid?
   unsigned		rowheight,	// Row height in lines
 			count,		// Current row run-length count
 			remaining,	// Remaining rows in page image
@@ -51,11 +53,20 @@ struct _cups_raster_s			// Raster stream data
 			*bufptr,	// Current (read) position in buffer
 			*bufend;	// End of current (read) buffer
   size_t		bufsize;	// Buffer size
+  size_t		iosize;		// I/O buffer size from cupsRasterSetBufferSize
+  unsigned char		*map;		// Memory-mapped file data
+  size_t		maplen;		// Length of mapped data
+  size_t		num_threads;	// Number of compression threads
 #  ifdef DEBUG
   size_t		iostart,	// Start of read/write buffer
 			iocount;	// Number of bytes read/written
 #  endif // DEBUG
   unsigned		apple_page_count;// Apple raster page count
+  bool			seekable;	// Is the stream a seekable file?
+  unsigned		page;		// Index of the next page to be read
+  off_t			*pages;		// Offsets of page headers
+  size_t		num_pages,	// Number of page offsets
+			alloc_pages;	// Allocated page offsets
 };
 
 
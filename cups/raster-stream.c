@@ -11,6 +11,26 @@
 
 #include "raster-private.h"
 #include "debug-internal.h"
+#include "thread.h"
+#include <sys/stat.h>
+#ifndef _WIN32
+#  include <sys/mman.h>
+#endif // !_WIN32
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#  include <arm_neon.h>
+#  define _CUPS_RASTER_NEON 1
+#endif // __SSE2__
+
+
+//
+// Local constants...
+//
+
+#define _CUPS_RASTER_MAX_BUFSIZE 67108864
+					// Maximum I/O buffer size
+#define _CUPS_RASTER_MAX_THREADS 64	// Maximum compression threads
 
 
 //
@@ -19,6 +39,22 @@
 
 typedef void (*_cups_copyfunc_t)(void *dst, const void *src, size_t bytes);
 
+typedef struct _cups_rrow_s		// Row to compress
+{
+  const unsigned char	*pixels;	// Pixels for row
+  unsigned		count;		// Repeat count for row
+} _cups_rrow_t;
+
+typedef struct _cups_rjob_s		// Row compression job
+{
+  cups_raster_t		*r;		// Raster stream
+  _cups_rrow_t		*rows;		// Rows to compress
+  size_t		num_rows;	// Number of rows
+  unsigned char		*buffer;	// Compressed data
+  size_t		bufused;	// Bytes of compressed data
+  cups_thread_t		thread;		// Compression thread
+} _cups_rjob_t;
+
 
 //
 // Local globals...
@@ -42,6 +78,40 @@ static const char * const apple_media_types[] =
   "other"
 };
 
+static const size_t pwg_fields[] =
+{					// 32-bit header fields copied to PWG Raster
+  offsetof(cups_page_header_t, CutMedia),
+  offsetof(cups_page_header_t, Duplex),
+  offsetof(cups_page_header_t, HWResolution[0]),
+  offsetof(cups_page_header_t, HWResolution[1]),
+  offsetof(cups_page_header_t, ImagingBoundingBox[0]),
+  offsetof(cups_page_header_t, ImagingBoundingBox[1]),
+  offsetof(cups_page_header_t, ImagingBoundingBox[2]),
+  offsetof(cups_page_header_t, ImagingBoundingBox[3]),
+  offsetof(cups_page_header_t, InsertSheet),
+  offsetof(cups_page_header_t, Jog),
+  offsetof(cups_page_header_t, LeadingEdge),
+  offsetof(cups_page_header_t, ManualFeed),
+  offsetof(cups_page_header_t, MediaPosition),
+  offsetof(cups_page_header_t, MediaWeight),
+  offsetof(cups_page_header_t, NumCopies),
+  offsetof(cups_page_header_t, Orientation),
+  offsetof(cups_page_header_t, PageSize[0]),
+  offsetof(cups_page_header_t, PageSize[1]),
+  offsetof(cups_page_header_t, Tumble),
+  offsetof(cups_page_header_t, cupsWidth),
+  offsetof(cups_page_header_t, cupsHeight),
+  offsetof(cups_page_header_t, cupsBitsPerColor),
+  offsetof(cups_page_header_t, cupsBitsPerPixel),
+  offsetof(cups_page_header_t, cupsBytesPerLine),
+  offsetof(cups_page_header_t, cupsColorOrder),
+  offsetof(cups_page_header_t, cupsColorSpace),
+  offsetof(cups_page_header_t, cupsNumColors),
+  offsetof(cups_page_header_t, cupsInteger[0]),
+  offsetof(cups_page_header_t, cupsInteger[1]),
+  offsetof(cups_page_header_t, cupsInteger[2])
+};
+
 #ifdef DEBUG
 static const char * const cups_modes[] =
 {					// Open modes
@@ -58,13 +128,30 @@ static const char * const cups_modes[] =
 // Local functions...
 //
 
+static bool	cups_raster_alloc(cups_raster_t *r, size_t bufsize);
+static size_t	cups_raster_encode(cups_raster_t *r, const unsigned char *pixels, unsigned rcount, unsigned char *buffer);
+static void	cups_raster_fill(unsigned char *ptr, unsigned bpp, size_t bytes);
+static bool	cups_raster_flush(cups_raster_t *r);
 static ssize_t	cups_raster_io(cups_raster_t *r, unsigned char *buf, size_t bytes);
+static unsigned	cups_raster_literal(const unsigned char *ptr, unsigned bpp, unsigned n);
+#ifndef _WIN32
+static void	cups_raster_map(cups_raster_t *r, int fd);
+#endif // !_WIN32
 static ssize_t	cups_raster_read(cups_raster_t *r, unsigned char *buf, size_t bytes);
+static unsigned	cups_raster_repeat(const unsigned char *ptr, unsigned bpp, unsigned n);
+static void	cups_raster_reset(cups_raster_t *r);
+static bool	cups_raster_seek(cups_raster_t *r, off_t offset);
+static bool	cups_raster_skip(cups_raster_t *r);
+static bool	cups_raster_skip_bytes(cups_raster_t *r, size_t bytes);
+static off_t	cups_raster_tell(cups_raster_t *r);
+static void	*cups_raster_thread(_cups_rjob_t *job);
 static int	cups_raster_update(cups_raster_t *r);
 static ssize_t	cups_raster_write(cups_raster_t *r, const unsigned char *pixels);
+static bool	cups_raster_write_lines(cups_raster_t *r, const unsigned char *p, unsigned lines);
 static ssize_t	cups_read_fd(void *ctx, unsigned char *buf, size_t bytes);
 static void	cups_swap(unsigned char *buf, size_t bytes);
 static void	cups_swap_copy(unsigned char *dst, const unsigned char *src, size_t bytes);
+static void	cups_swap_words(unsigned *words, size_t count);
 static ssize_t	cups_write_fd(void *ctx, unsigned char *buf, size_t bytes);
 
 
@@ -154,8 +241,9 @@ _cupsRasterColorSpaceString(
 //
 // 'cupsRasterClose()' - Close a raster stream.
 //
-// The file descriptor associated with the raster stream must be closed
-// separately as needed.
+// Any buffered output is written before the stream is closed.  The file
+// descriptor associated with the raster stream must be closed separately as
+// needed.
 //
 
 void
@@ -163,10 +251,77 @@ cupsRasterClose(cups_raster_t *r)	// I - Stream to free
 {
   if (r != NULL)
   {
-    free(r->buffer);
-    free(r->pixels);
-    free(r);
+    if (r->mode != CUPS_RASTER_READ)
+      cups_raster_flush(r);
+
+#ifndef _WIN32
+    if (r->map)
+      munmap(r->map, r->maplen);
+#endif // !_WIN32
+
+    _cupsMemFree(r->buffer);
+    _cupsMemFree(r->pixels);
+    _cupsMemFree(r->pages);
+    _cupsMemFree(r);
+  }
+}
+
+
+//
+// 'cupsRasterGetLine()' - Read a line of raster pixels without copying.
+//
+// This function returns a pointer to the next line of pixels, which contains
+// "cupsBytesPerLine" bytes.  The pointer is valid until the next call using
+// the raster stream.
+//
+// When reading uncompressed raster data from a regular file opened with
+// @link cupsRasterOpen@, the pointer refers to the memory-mapped file data.
+// Otherwise the line is decoded into an internal buffer.  Partial lines that
+// have been read with @link cupsRasterReadPixels@ must be finished before
+// calling this function.
+//
+
+const unsigned char *			// O - Pointer to line or `NULL` on end of page or error
+cupsRasterGetLine(cups_raster_t *r)	// I - Raster stream
+{
+  unsigned char	*line;			// Pointer to line
+  unsigned	bpl;			// Bytes per line
+
+
+  if (!r || r->mode != CUPS_RASTER_READ || r->remaining == 0 || (bpl = r->header.cupsBytesPerLine) == 0 || !r->pixels)
+    return (NULL);
+
+  if (!r->compressed)
+  {
+    if (r->bufptr && (size_t)(r->bufend - r->bufptr) >= bpl && !(r->swapped && (r->header.cupsBitsPerColor == 16 || r->header.cupsBitsPerPixel == 12 || r->header.cupsBitsPerPixel == 16)))
+    {
+      // Return the memory-mapped line...
+      line = r->bufptr;
+      r->bufptr += bpl;
+      r->remaining --;
+
+      return (line);
+    }
+  }
+  else if (r->pcurrent != r->pixels)
+  {
+    // Can't return part of a line...
+    return (NULL);
+  }
+  else if (r->count > 0)
+  {
+    // Repeat the current line...
+    r->count --;
+    r->remaining --;
+
+    return (r->pixels);
   }
+
+  // Read the line into the line buffer...
+  if (cupsRasterReadPixels(r, r->pixels, bpl) < bpl)
+    return (NULL);
+
+  return (r->pixels);
 }
 
 
@@ -533,7 +688,7 @@ _cupsRasterNew(
 
   _cupsRasterClearError();
 
-  if ((r = calloc(sizeof(cups_raster_t), 1)) == NULL)
+  if ((r = _cupsMemCalloc(CUPS_MEMTYPE_RASTER, sizeof(cups_raster_t), 1)) == NULL)
   {
     _cupsRasterAddError("Unable to allocate memory for raster stream: %s", strerror(errno));
     DEBUG_puts("1_cupsRasterNwq: Returning NULL.");
@@ -550,7 +705,7 @@ _cupsRasterNew(
     if (cups_raster_io(r, (unsigned char *)&(r->sync), sizeof(r->sync)) != sizeof(r->sync))
     {
       _cupsRasterAddError("Unable to read header from raster stream: %s", strerror(errno));
-      free(r);
+      _cupsMemFree(r);
       DEBUG_puts("1_cupsRasterNew: Unable to read header, returning NULL.");
       return (NULL);
     }
@@ -558,7 +713,7 @@ _cupsRasterNew(
     if (r->sync != CUPS_RASTER_SYNC && r->sync != CUPS_RASTER_REVSYNC && r->sync != CUPS_RASTER_SYNCv1 && r->sync != CUPS_RASTER_REVSYNCv1 && r->sync != CUPS_RASTER_SYNCv2 && r->sync != CUPS_RASTER_REVSYNCv2 && r->sync != CUPS_RASTER_SYNCapple && r->sync != CUPS_RASTER_REVSYNCapple)
     {
       _cupsRasterAddError("Unknown raster format %08x.", r->sync);
-      free(r);
+      _cupsMemFree(r);
       DEBUG_puts("1_cupsRasterNew: Unknown format, returning NULL.");
       return (NULL);
     }
@@ -579,7 +734,7 @@ _cupsRasterNew(
 	      sizeof(header))
       {
 	_cupsRasterAddError("Unable to read header from raster stream: %s", strerror(errno));
-	free(r);
+	_cupsMemFree(r);
 	DEBUG_puts("1_cupsRasterNew: Unable to read header, returning NULL.");
 	return (NULL);
       }
@@ -621,7 +776,7 @@ _cupsRasterNew(
     if (cups_raster_io(r, (unsigned char *)&(r->sync), sizeof(r->sync)) < (ssize_t)sizeof(r->sync))
     {
       _cupsRasterAddError("Unable to write raster stream header: %s", strerror(errno));
-      free(r);
+      _cupsMemFree(r);
       DEBUG_puts("1_cupsRasterNew: Unable to write header, returning NULL.");
       return (NULL);
     }
@@ -641,6 +796,11 @@ _cupsRasterNew(
 // image processor (RIP) filters that generate raster data, "fd" will be 1
 // (stdout).
 //
+// When reading from a regular file, the file is mapped into memory and raster
+// data is decoded directly from the mapping.  Data appended to the file after
+// it is opened is read normally.  Pages in a regular file can be read in any
+// order using the @link cupsRasterSeekPage@ function.
+//
 // When writing raster data, the @code CUPS_RASTER_WRITE@,
 // @code CUPS_RASTER_WRITE_COMPRESS@, or @code CUPS_RASTER_WRITE_PWG@ mode can
 // be used - compressed and PWG output is generally 25-50% smaller but adds a
@@ -652,7 +812,20 @@ cupsRasterOpen(int                fd,	// I - File descriptor
                cups_raster_mode_t mode)	// I - Mode - `CUPS_RASTER_READ`, `CUPS_RASTER_WRITE`, `CUPS_RASTER_WRITE_COMPRESSED`, `CUPS_RASTER_WRITE_PWG`
 {
   if (mode == CUPS_RASTER_READ)
-    return (_cupsRasterNew(cups_read_fd, (void *)((intptr_t)fd), mode));
+  {
+    cups_raster_t *r = _cupsRasterNew(cups_read_fd, (void *)((intptr_t)fd), mode);
+					// New stream
+
+    if (r)
+      r->seekable = lseek(fd, 0, SEEK_CUR) >= 0;
+
+#ifndef _WIN32
+    if (r)
+      cups_raster_map(r, fd);
+#endif // !_WIN32
+
+    return (r);
+  }
   else
     return (_cupsRasterNew(cups_write_fd, (void *)((intptr_t)fd), mode));
 }
@@ -689,7 +862,10 @@ cupsRasterReadHeader(
     cups_raster_t      *r,		// I - Raster stream
     cups_page_header_t *h)		// I - Pointer to header data
 {
-  size_t	len;			// Length for read/swap
+  size_t		len;		// Length for read/swap
+  cups_page_header_t	raw;		// Raw page header
+  bool			cached = false;	// Same header as the previous page?
+  off_t			offset;		// Offset of page header
 
 
   DEBUG_printf("cupsRasterReadHeader(r=%p, h=%p), r->mode=%s", (void *)r, (void *)h, r ? cups_modes[r->mode] : "");
@@ -697,9 +873,9 @@ cupsRasterReadHeader(
   if (r == NULL || r->mode != CUPS_RASTER_READ || !h)
     return (false);
 
-  DEBUG_printf("1cupsRasterReadHeader: r->iocount=" CUPS_LLFMT, CUPS_LLCAST r->iocount);
+  offset = r->seekable ? cups_raster_tell(r) : -1;
 
-  memset(&(r->header), 0, sizeof(r->header));
+  DEBUG_printf("1cupsRasterReadHeader: r->iocount=" CUPS_LLFMT, CUPS_LLCAST r->iocount);
 
   // Read the header...
   switch (r->sync)
@@ -714,27 +890,32 @@ cupsRasterReadHeader(
 	DEBUG_printf("2cupsRasterReadHeader: len=%d", (int)len);
 
         // Read it...
-	if (cups_raster_read(r, (unsigned char *)&(r->header), len) < (ssize_t)len)
+	if (cups_raster_read(r, (unsigned char *)&raw, len) < (ssize_t)len)
 	{
 	  DEBUG_printf("2cupsRasterReadHeader: EOF, r->iocount=" CUPS_LLFMT, CUPS_LLCAST r->iocount);
 	  return (false);
 	}
 
+        // Reuse the decoded header if it is the same as the previous page...
+        if (r->cvalid && !memcmp(&raw, &r->cheader, len))
+        {
+          DEBUG_puts("2cupsRasterReadHeader: Same header as previous page.");
+          cached = true;
+          break;
+        }
+
+        r->cvalid = false;
+
+        memcpy(&r->cheader, &raw, len);
+	memset(&(r->header), 0, sizeof(r->header));
+	memcpy(&(r->header), &raw, len);
+
         // Swap bytes as needed...
 	if (r->swapped)
 	{
-	  unsigned	*s,		// Current word
-			temp;		// Temporary copy
-
 	  DEBUG_puts("2cupsRasterReadHeader: Swapping header bytes.");
 
-	  for (len = 81, s = &(r->header.AdvanceDistance); len > 0; len --, s ++)
-	  {
-	    temp = *s;
-	    *s   = ((temp & 0xff) << 24) | ((temp & 0xff00) << 8) | ((temp & 0xff0000) >> 8) | ((temp & 0xff000000) >> 24);
-
-	    DEBUG_printf("2cupsRasterReadHeader: %08x => %08x", temp, *s);
-	  }
+	  cups_swap_words(&(r->header.AdvanceDistance), 81);
 	}
         break;
 
@@ -769,6 +950,8 @@ cupsRasterReadHeader(
 	    return (false);
 	  }
 
+	  memset(&(r->header), 0, sizeof(r->header));
+
 	  cupsCopyString(r->header.MediaClass, "PwgRaster", sizeof(r->header.MediaClass));
 					      // PwgRaster
           r->header.cupsBitsPerPixel = appleheader[0];
@@ -809,8 +992,18 @@ cupsRasterReadHeader(
   }
 
   // Update the header and row count...
-  if (!cups_raster_update(r))
+  if (cached)
+  {
+    cups_raster_reset(r);
+  }
+  else if (!cups_raster_update(r))
+  {
     return (false);
+  }
+  else if (r->sync != CUPS_RASTER_SYNCapple && r->sync != CUPS_RASTER_REVSYNCapple)
+  {
+    r->cvalid = true;
+  }
 
   DEBUG_printf("2cupsRasterReadHeader: cupsColorSpace=%s", _cupsRasterColorSpaceString(r->header.cupsColorSpace));
   DEBUG_printf("2cupsRasterReadHeader: cupsBitsPerColor=%u", r->header.cupsBitsPerColor);
@@ -822,7 +1015,32 @@ cupsRasterReadHeader(
 
   memcpy(h, &r->header, sizeof(cups_page_header_t));
 
-  return (r->header.cupsBitsPerPixel > 0 && r->header.cupsBitsPerPixel <= 240 && r->header.cupsBitsPerColor > 0 && r->header.cupsBitsPerColor <= 16 && r->header.cupsBytesPerLine > 0 && r->header.cupsBytesPerLine <= 0x7fffffff && r->header.cupsHeight != 0 && (r->header.cupsBytesPerLine % r->bpp) == 0);
+  if (r->header.cupsBitsPerPixel == 0 || r->header.cupsBitsPerPixel > 240 || r->header.cupsBitsPerColor == 0 || r->header.cupsBitsPerColor > 16 || r->header.cupsBytesPerLine == 0 || r->header.cupsBytesPerLine > 0x7fffffff || r->header.cupsHeight == 0 || (r->header.cupsBytesPerLine % r->bpp) != 0)
+    return (false);
+
+  // Add the page to the index as needed...
+  if (offset >= 0 && r->page == r->num_pages)
+  {
+    if (r->num_pages >= r->alloc_pages)
+    {
+      off_t	*pages;			// New page offsets
+      size_t	alloc_pages = r->alloc_pages ? 2 * r->alloc_pages : 16;
+					// New allocation
+
+      if ((pages = _cupsMemRealloc(CUPS_MEMTYPE_RASTER, r->pages, alloc_pages * sizeof(off_t))) != NULL)
+      {
+        r->pages       = pages;
+        r->alloc_pages = alloc_pages;
+      }
+    }
+
+    if (r->num_pages < r->alloc_pages)
+      r->pages[r->num_pages ++] = offset;
+  }
+
+  r->page ++;
+
+  return (true);
 }
 
 
@@ -913,7 +1131,11 @@ cupsRasterReadPixels(
       while (bytes > 0)
       {
         // Get a new repeat count...
-        if (!cups_raster_read(r, &byte, 1))
+        if (r->bufptr < r->bufend)
+        {
+          byte = *(r->bufptr)++;
+        }
+        else if (!cups_raster_read(r, &byte, 1))
 	{
 	  DEBUG_puts("1cupsRasterReadPixels: Read error, returning 0.");
 	  return (0);
@@ -975,15 +1197,8 @@ cupsRasterReadPixels(
 	    return (0);
 	  }
 
-	  temp  += r->bpp;
-	  count -= r->bpp;
-
-	  while (count > 0)
-	  {
-	    memcpy(temp, temp - r->bpp, r->bpp);
-	    temp  += r->bpp;
-	    count -= r->bpp;
-          }
+	  cups_raster_fill(temp, r->bpp, count);
+	  temp += count;
 	}
       }
 
@@ -1039,6 +1254,134 @@ cupsRasterReadPixels(
 }
 
 
+//
+// 'cupsRasterSeekPage()' - Position a raster stream at the start of a page.
+//
+// This function positions a raster stream opened for reading with
+// @link cupsRasterOpen@ so that the next call to @link cupsRasterReadHeader@
+// reads the header of the specified page.  The first page is number 1.
+//
+// The offset of each page is remembered as its header is read.  When seeking
+// past the last page that has been read, the intervening pages are scanned by
+// skipping over their (compressed) line data without decoding it.
+//
+// Seeking is only supported for regular files, so `false` is returned for
+// pipes and for streams opened with @link cupsRasterOpenIO@.
+//
+
+bool					// O - `true` on success, `false` on failure
+cupsRasterSeekPage(cups_raster_t *r,	// I - Raster stream
+                   unsigned      page)	// I - Page number (`1` for the first page)
+{
+  cups_page_header_t	header;		// Page header
+
+
+  DEBUG_printf("cupsRasterSeekPage(r=%p, page=%u)", (void *)r, page);
+
+  if (!r || r->mode != CUPS_RASTER_READ || page < 1)
+    return (false);
+
+  if (!r->seekable)
+  {
+    _cupsRasterAddError("Raster stream is not seekable.");
+    return (false);
+  }
+
+  if (page > r->num_pages)
+  {
+    // Scan forward from the last page in the index...
+    if (r->num_pages > 0)
+    {
+      if (!cups_raster_seek(r, r->pages[r->num_pages - 1]))
+        return (false);
+
+      r->page = (unsigned)r->num_pages - 1;
+    }
+
+    while (r->num_pages < page)
+    {
+      if (!cupsRasterReadHeader(r, &header))
+      {
+        _cupsRasterAddError("Unable to find page %u in raster stream.", page);
+        return (false);
+      }
+
+      if (r->num_pages < page && !cups_raster_skip(r))
+      {
+        _cupsRasterAddError("Unable to find page %u in raster stream.", page);
+        return (false);
+      }
+    }
+  }
+
+  // Go to the start of the page...
+  if (!cups_raster_seek(r, r->pages[page - 1]))
+    return (false);
+
+  r->page      = page - 1;
+  r->remaining = 0;
+  r->count     = 0;
+  r->pcurrent  = r->pixels;
+
+  return (true);
+}
+
+
+//
+// 'cupsRasterSetBufferSize()' - Set the size of the I/O buffer for a raster stream.
+//
+// This function sets the number of bytes that are read from or written to the
+// raster stream's file descriptor or callback at a time.  When writing, output
+// is collected until the buffer is full or the stream is closed, which reduces
+// the number of system calls for pipes and sockets.  When reading, data is
+// read ahead into the buffer.  A size of `0` restores the default behavior of
+// writing each line as it is compressed.  The maximum size is 64MiB.
+//
+// Any buffered output is written before the buffer size is changed.
+//
+
+bool					// O - `true` on success, `false` on error
+cupsRasterSetBufferSize(
+    cups_raster_t *r,			// I - Raster stream
+    size_t        bufsize)		// I - Buffer size in bytes or `0` for the default
+{
+  if (!r || bufsize > _CUPS_RASTER_MAX_BUFSIZE)
+    return (false);
+
+  if (r->mode != CUPS_RASTER_READ && !cups_raster_flush(r))
+    return (false);
+
+  r->iosize = bufsize;
+
+  return (true);
+}
+
+
+//
+// 'cupsRasterSetCompressionThreads()' - Set the number of threads used to compress raster data.
+//
+// This function enables parallel compression for a raster stream opened for
+// writing with compression (any mode except `CUPS_RASTER_WRITE`).  When
+// @link cupsRasterWritePixels@ is called with a band of two or more whole
+// lines, the lines are compressed by up to "num_threads" threads and written
+// in order, producing the same raster data as a single thread.  A value of
+// `0` or `1` uses a single thread.
+//
+
+bool					// O - `true` on success, `false` on error
+cupsRasterSetCompressionThreads(
+    cups_raster_t *r,			// I - Raster stream
+    size_t        num_threads)		// I - Number of threads
+{
+  if (!r || r->mode == CUPS_RASTER_READ || !r->compressed || num_threads > _CUPS_RASTER_MAX_THREADS)
+    return (false);
+
+  r->num_threads = num_threads;
+
+  return (true);
+}
+
+
 //
 // '_cupsRasterWriteHeader()' - Write a raster page header.
 //
@@ -1060,13 +1403,26 @@ cupsRasterWriteHeader(
   DEBUG_printf("1cupsRasterWriteHeader: cupsWidth=%u", r->header.cupsWidth);
   DEBUG_printf("1cupsRasterWriteHeader: cupsHeight=%u", r->header.cupsHeight);
 
-  r->header = *h;
-
-  // Compute the number of raster lines in the page image...
-  if (!cups_raster_update(r))
+  if (r->cvalid && !memcmp(h, &r->cheader, sizeof(r->cheader)))
   {
-    DEBUG_puts("1cupsRasterWriteHeader: Unable to update parameters, returning 0.");
-    return (false);
+    // Same header as the previous page, just reset the row count...
+    DEBUG_puts("1cupsRasterWriteHeader: Same header as previous page.");
+    cups_raster_reset(r);
+  }
+  else
+  {
+    r->header  = *h;
+    r->cheader = *h;
+    r->cvalid  = false;
+
+    // Compute the number of raster lines in the page image...
+    if (!cups_raster_update(r))
+    {
+      DEBUG_puts("1cupsRasterWriteHeader: Unable to update parameters, returning 0.");
+      return (false);
+    }
+
+    r->cvalid = true;
   }
 
   if (r->mode == CUPS_RASTER_WRITE_APPLE)
@@ -1084,6 +1440,8 @@ cupsRasterWriteHeader(
   {
     // PWG raster data is always network byte order with much of the page header
     // zeroed.
+    size_t		i;		// Looping var
+    unsigned		v;		// Header value
     cups_page_header_t	fh;		// File page header
 
     memset(&fh, 0, sizeof(fh));
@@ -1096,36 +1454,13 @@ cupsRasterWriteHeader(
     cupsCopyString(fh.cupsPageSizeName, r->header.cupsPageSizeName,
             sizeof(fh.cupsPageSizeName));
 
-    fh.CutMedia              = htonl(r->header.CutMedia);
-    fh.Duplex                = htonl(r->header.Duplex);
-    fh.HWResolution[0]       = htonl(r->header.HWResolution[0]);
-    fh.HWResolution[1]       = htonl(r->header.HWResolution[1]);
-    fh.ImagingBoundingBox[0] = htonl(r->header.ImagingBoundingBox[0]);
-    fh.ImagingBoundingBox[1] = htonl(r->header.ImagingBoundingBox[1]);
-    fh.ImagingBoundingBox[2] = htonl(r->header.ImagingBoundingBox[2]);
-    fh.ImagingBoundingBox[3] = htonl(r->header.ImagingBoundingBox[3]);
-    fh.InsertSheet           = htonl(r->header.InsertSheet);
-    fh.Jog                   = htonl(r->header.Jog);
-    fh.LeadingEdge           = htonl(r->header.LeadingEdge);
-    fh.ManualFeed            = htonl(r->header.ManualFeed);
-    fh.MediaPosition         = htonl(r->header.MediaPosition);
-    fh.MediaWeight           = htonl(r->header.MediaWeight);
-    fh.NumCopies             = htonl(r->header.NumCopies);
-    fh.Orientation           = htonl(r->header.Orientation);
-    fh.PageSize[0]           = htonl(r->header.PageSize[0]);
-    fh.PageSize[1]           = htonl(r->header.PageSize[1]);
-    fh.Tumble                = htonl(r->header.Tumble);
-    fh.cupsWidth             = htonl(r->header.cupsWidth);
-    fh.cupsHeight            = htonl(r->header.cupsHeight);
-    fh.cupsBitsPerColor      = htonl(r->header.cupsBitsPerColor);
-    fh.cupsBitsPerPixel      = htonl(r->header.cupsBitsPerPixel);
-    fh.cupsBytesPerLine      = htonl(r->header.cupsBytesPerLine);
-    fh.cupsColorOrder        = htonl(r->header.cupsColorOrder);
-    fh.cupsColorSpace        = htonl(r->header.cupsColorSpace);
-    fh.cupsNumColors         = htonl(r->header.cupsNumColors);
-    fh.cupsInteger[0]        = htonl(r->header.cupsInteger[0]);
-    fh.cupsInteger[1]        = htonl(r->header.cupsInteger[1]);
-    fh.cupsInteger[2]        = htonl(r->header.cupsInteger[2]);
+    for (i = 0; i < (sizeof(pwg_fields) / sizeof(pwg_fields[0])); i ++)
+    {
+      memcpy(&v, (char *)&(r->header) + pwg_fields[i], sizeof(v));
+      v = htonl(v);
+      memcpy((char *)&fh + pwg_fields[i], &v, sizeof(v));
+    }
+
     fh.cupsInteger[3]        = htonl((unsigned)(r->header.cupsImagingBBox[0] * r->header.HWResolution[0] / 72.0));
     fh.cupsInteger[4]        = htonl((unsigned)(r->header.cupsImagingBBox[1] * r->header.HWResolution[1] / 72.0));
     fh.cupsInteger[5]        = htonl((unsigned)(r->header.cupsImagingBBox[2] * r->header.HWResolution[0] / 72.0));
@@ -1218,7 +1553,8 @@ cupsRasterWritePixels(
     unsigned      len)			// I - Number of bytes to write
 {
   ssize_t	bytes;			// Bytes read
-  unsigned	remaining;		// Bytes remaining
+  unsigned	remaining,		// Bytes remaining
+		lines;			// Number of whole lines
 
 
   DEBUG_printf("cupsRasterWritePixels(r=%p, p=%p, len=%u), remaining=%u", (void *)r, (void *)p, len, r ? r->remaining : 0);
@@ -1237,22 +1573,9 @@ cupsRasterWritePixels(
          r->header.cupsBitsPerPixel == 12 ||
          r->header.cupsBitsPerPixel == 16))
     {
-      unsigned char	*bufptr;	// Pointer into write buffer
-
-      // Allocate a write buffer as needed...
-      if ((size_t)len > r->bufsize)
-      {
-	if (r->buffer)
-	  bufptr = realloc(r->buffer, len);
-	else
-	  bufptr = malloc(len);
-
-	if (!bufptr)
-	  return (0);
-
-	r->buffer  = bufptr;
-	r->bufsize = len;
-      }
+      // Write any buffered output and allocate a write buffer as needed...
+      if (!cups_raster_flush(r) || !cups_raster_alloc(r, len))
+        return (0);
 
       // Byte swap the pixels and write them...
       cups_swap_copy(r->buffer, p, len);
@@ -1268,8 +1591,25 @@ cupsRasterWritePixels(
       return (len);
   }
 
+  remaining = len;
+
+  if (r->num_threads > 1 && r->pcurrent == r->pixels && (lines = len / r->header.cupsBytesPerLine) > 1)
+  {
+    // Compress whole lines using multiple threads...
+    if (lines > r->remaining)
+      lines = r->remaining;
+
+    if (!cups_raster_write_lines(r, p, lines))
+      return (0);
+    else if (r->remaining == 0)
+      return (len);
+
+    remaining -= lines * r->header.cupsBytesPerLine;
+    p         += lines * r->header.cupsBytesPerLine;
+  }
+
   // Otherwise, compress each line...
-  for (remaining = len; remaining > 0; remaining -= (unsigned)bytes, p += bytes)
+  for (; remaining > 0; remaining -= (unsigned)bytes, p += bytes)
   {
     // Figure out the number of remaining bytes on the current line...
     if ((bytes = (ssize_t)remaining) > (ssize_t)(r->pend - r->pcurrent))
@@ -1349,170 +1689,921 @@ cupsRasterWritePixels(
 
 
 //
-// 'cups_raster_io()' - Read/write bytes from a context, handling interruptions.
+// 'cups_raster_alloc()' - Make sure the I/O buffer holds at least "bufsize" bytes.
+//
+// Buffered data is preserved, except when the buffer currently refers to the
+// memory-mapped file.
 //
 
-static ssize_t				// O - Bytes read/write or -1
-cups_raster_io(cups_raster_t *r,	// I - Raster stream
-               unsigned char *buf,	// I - Buffer for read/write
-               size_t        bytes)	// I - Number of bytes to read/write
+static bool				// O - `true` on success, `false` on error
+cups_raster_alloc(cups_raster_t *r,	// I - Raster stream
+                  size_t        bufsize)// I - Minimum buffer size
 {
-  ssize_t	count,			// Number of bytes read/written
-		total;			// Total bytes read/written
+  bool		mapped = r->map && r->bufend == r->map + r->maplen;
+					// Reading from the mapped file?
+  size_t	offset = mapped || !r->bufptr ? 0 : (size_t)(r->bufptr - r->buffer),
+					// Offset to current start of buffer
+		end = mapped || !r->bufend ? 0 : (size_t)(r->bufend - r->buffer);
+					// Offset to current end of buffer
+  unsigned char	*buffer;		// New buffer
 
 
-  DEBUG_printf("5cups_raster_io(r=%p, buf=%p, bytes=" CUPS_LLFMT ")", (void *)r, (void *)buf, CUPS_LLCAST bytes);
+  if (bufsize <= r->bufsize)
+    return (true);
 
-  for (total = 0; total < (ssize_t)bytes; total += count, buf += count)
+  if ((buffer = _cupsMemRealloc(CUPS_MEMTYPE_RASTER, r->buffer, bufsize)) == NULL)
   {
-    count = (*r->iocb)(r->ctx, buf, bytes - (size_t)total);
+    DEBUG_printf("4cups_raster_alloc: Unable to allocate " CUPS_LLFMT " bytes for raster buffer: %s", CUPS_LLCAST bufsize, strerror(errno));
+    return (false);
+  }
 
-    DEBUG_printf("6cups_raster_io: count=%d, total=%d", (int)count, (int)total);
-    if (count == 0)
-      break;
-    else if (count < 0)
-    {
-      DEBUG_puts("6cups_raster_io: Returning -1 on error.");
-      return (-1);
-    }
+  r->buffer  = buffer;
+  r->bufsize = bufsize;
 
-#ifdef DEBUG
-    r->iocount += (size_t)count;
-#endif // DEBUG
+  if (!mapped)
+  {
+    r->bufptr = buffer + offset;
+    r->bufend = buffer + end;
   }
 
-  DEBUG_printf("6cups_raster_io: iocount=" CUPS_LLFMT, CUPS_LLCAST r->iocount);
-  DEBUG_printf("6cups_raster_io: Returning " CUPS_LLFMT ".", CUPS_LLCAST total);
-
-  return (total);
+  return (true);
 }
 
 
 //
-// 'cups_raster_read()' - Read through the raster buffer.
+// 'cups_raster_encode()' - Compress a row of raster data.
+//
+// The buffer must hold at least "cupsBytesPerLine + cupsBytesPerLine / 64 + 16"
+// bytes.
 //
 
-static ssize_t				// O - Number of bytes read
-cups_raster_read(cups_raster_t *r,	// I - Raster stream
-                 unsigned char *buf,	// I - Buffer
-                 size_t        bytes)	// I - Number of bytes to read
+static size_t				// O - Number of bytes in buffer
+cups_raster_encode(
+    cups_raster_t       *r,		// I - Raster stream
+    const unsigned char *pixels,	// I - Pixel data to compress
+    unsigned            rcount,		// I - Repeat count for row
+    unsigned char       *buffer)	// I - Compression buffer
 {
-  ssize_t	count,			// Number of bytes read
-		remaining,		// Remaining bytes in buffer
-		total;			// Total bytes read
-
+  const unsigned char	*start,		// Start of sequence
+			*ptr,		// Current pointer in sequence
+			*pend,		// End of raster buffer
+			*plast;		// Pointer to last pixel
+  unsigned char		*wptr;		// Pointer into write buffer
+  unsigned		bpp,		// Bytes per pixel
+			count,		// Count
+			n;		// Number of pixels to compare
+  _cups_copyfunc_t	cf;		// Copy function
 
-  DEBUG_printf("4cups_raster_read(r=%p, buf=%p, bytes=" CUPS_LLFMT "), offset=" CUPS_LLFMT, (void *)r, (void *)buf, CUPS_LLCAST bytes, CUPS_LLCAST (r->iostart + r->bufptr - r->buffer));
 
-  if (!r->compressed)
-    return (cups_raster_io(r, buf, bytes));
+  // Determine whether we need to swap bytes...
+  if (r->swapped && (r->header.cupsBitsPerColor == 16 || r->header.cupsBitsPerPixel == 12 || r->header.cupsBitsPerPixel == 16))
+    cf = (_cups_copyfunc_t)cups_swap_copy;
+  else
+    cf = (_cups_copyfunc_t)memcpy;
 
-  // Allocate a read buffer as needed...
-  count = (ssize_t)(2 * r->header.cupsBytesPerLine);
-  if (count < 65536)
-    count = 65536;
+  // Write the row repeat count...
+  bpp     = r->bpp;
+  pend    = pixels + r->header.cupsBytesPerLine;
+  plast   = pend - bpp;
+  wptr    = buffer;
+  *wptr++ = (unsigned char)(rcount - 1);
 
-  if ((size_t)count > r->bufsize)
+  // Write using a modified PackBits compression...
+  for (ptr = pixels; ptr < pend;)
   {
-    ssize_t offset = r->bufptr - r->buffer;
-					// Offset to current start of buffer
-    ssize_t end = r->bufend - r->buffer;// Offset to current end of buffer
-    unsigned char *rptr;		// Pointer in read buffer
-
-    if (r->buffer)
-      rptr = realloc(r->buffer, (size_t)count);
-    else
-      rptr = malloc((size_t)count);
-
-    if (!rptr)
-      return (0);
-
-    r->buffer  = rptr;
-    r->bufptr  = rptr + offset;
-    r->bufend  = rptr + end;
-    r->bufsize = (size_t)count;
-  }
+    start = ptr;
+    ptr += bpp;
 
-  // Loop until we have read everything...
+    if (ptr == pend)
+    {
+      // Encode a single pixel at the end...
+      *wptr++ = 0;
+      (*cf)(wptr, start, bpp);
+      wptr += bpp;
+    }
+    else if (!memcmp(start, ptr, bpp))
+    {
+      // Encode a sequence of repeating pixels...
+      if ((n = (unsigned)((plast - ptr + bpp - 1) / bpp)) > 126)
+        n = 126;
+
+      count = cups_raster_repeat(ptr, bpp, n);
+      ptr   += count * bpp;
+      count += 2;
+
+      *wptr++ = (unsigned char)(count - 1);
+      (*cf)(wptr, ptr, bpp);
+      wptr += bpp;
+      ptr  += bpp;
+    }
+    else
+    {
+      // Encode a sequence of non-repeating pixels...
+      if (ptr < plast)
+      {
+        if ((n = (unsigned)((plast - ptr + bpp - 1) / bpp)) > 127)
+          n = 127;
+
+        count = cups_raster_literal(ptr, bpp, n);
+        ptr   += count * bpp;
+        count ++;
+      }
+      else
+        count = 1;
+
+      if (ptr >= plast && count < 128)
+      {
+        count ++;
+	ptr += bpp;
+      }
+
+      *wptr++ = (unsigned char)(257 - count);
+
+      count *= bpp;
+      (*cf)(wptr, start, count);
+      wptr += count;
+    }
+  }
+
+  return ((size_t)(wptr - buffer));
+}
+
+
+//
+// 'cups_raster_fill()' - Fill a repeat run with copies of its first pixel.
+//
+// The first pixel is copied into the rest of the run with 16-byte stores for
+// 2- and 4-byte pixels, and otherwise by repeatedly copying the filled part of
+// the run.
+//
+
+static void
+cups_raster_fill(unsigned char *ptr,	// I - First pixel of run
+                 unsigned      bpp,	// I - Bytes per pixel
+                 size_t        bytes)	// I - Number of bytes in run
+{
+  size_t	count = bpp,		// Number of bytes filled
+		length;			// Number of bytes to copy
+
+
+  if (bpp == 1)
+  {
+    memset(ptr + 1, *ptr, bytes - 1);
+    return;
+  }
+
+#if defined(__SSE2__) || defined(_CUPS_RASTER_NEON)
+  if ((bpp == 2 || bpp == 4) && bytes >= 32)
+  {
+    uint16_t	value16;		// 2-byte pixel
+    uint32_t	value32;		// 4-byte pixel
+#  ifdef __SSE2__
+    __m128i	pixels;			// 16 bytes of pixels
+
+    if (bpp == 2)
+    {
+      memcpy(&value16, ptr, sizeof(value16));
+      pixels = _mm_set1_epi16((short)value16);
+    }
+    else
+    {
+      memcpy(&value32, ptr, sizeof(value32));
+      pixels = _mm_set1_epi32((int)value32);
+    }
+
+    for (; (count + 16) <= bytes; count += 16)
+      _mm_storeu_si128((__m128i *)(ptr + count), pixels);
+
+#  else
+    uint8x16_t	pixels;			// 16 bytes of pixels
+
+    if (bpp == 2)
+    {
+      memcpy(&value16, ptr, sizeof(value16));
+      pixels = vreinterpretq_u8_u16(vdupq_n_u16(value16));
+    }
+    else
+    {
+      memcpy(&value32, ptr, sizeof(value32));
+      pixels = vreinterpretq_u8_u32(vdupq_n_u32(value32));
+    }
+
+    for (; (count + 16) <= bytes; count += 16)
+      vst1q_u8(ptr + count, pixels);
+#  endif // __SSE2__
+  }
+#endif // __SSE2__ || _CUPS_RASTER_NEON
+
+  // Copy the filled pixels, doubling the number each time...
+  for (; count < bytes; count += length)
+  {
+    if ((length = bytes - count) > count)
+      length = count;
+
+    memcpy(ptr + count, ptr, length);
+  }
+}
+
+
+//
+// 'cups_raster_flush()' - Write any buffered output.
+//
+
+static bool				// O - `true` on success, `false` on error
+cups_raster_flush(cups_raster_t *r)	// I - Raster stream
+{
+  size_t	bytes;			// Bytes to write
+
+
+  if (!r->bufptr || (bytes = (size_t)(r->bufptr - r->buffer)) == 0)
+    return (true);
+
+  DEBUG_printf("4cups_raster_flush: Writing " CUPS_LLFMT " bytes.", CUPS_LLCAST bytes);
+
+  r->bufptr = r->buffer;
+
+  return (cups_raster_io(r, r->buffer, bytes) == (ssize_t)bytes);
+}
+
+
+//
+// 'cups_raster_io()' - Read/write bytes from a context, handling interruptions.
+//
+// When a buffer size has been set, output is collected in the I/O buffer and
+// input is read ahead into it.  Writes of the I/O buffer itself go directly
+// to the callback.
+//
+
+static ssize_t				// O - Bytes read/write or -1
+cups_raster_io(cups_raster_t *r,	// I - Raster stream
+               unsigned char *buf,	// I - Buffer for read/write
+               size_t        bytes)	// I - Number of bytes to read/write
+{
+  ssize_t	count,			// Number of bytes read/written
+		total;			// Total bytes read/written
+
+
+  DEBUG_printf("5cups_raster_io(r=%p, buf=%p, bytes=" CUPS_LLFMT ")", (void *)r, (void *)buf, CUPS_LLCAST bytes);
+
+  total = 0;
+
+  if (r->mode != CUPS_RASTER_READ)
+  {
+    if (r->iosize > 0 && buf != r->buffer)
+    {
+      // Buffer output...
+      if (!cups_raster_alloc(r, r->iosize))
+        return (-1);
+
+      if ((size_t)(r->bufptr - r->buffer) + bytes > r->bufsize && !cups_raster_flush(r))
+        return (-1);
+
+      if (bytes < r->bufsize)
+      {
+        memcpy(r->bufptr, buf, bytes);
+        r->bufptr += bytes;
+
+        return ((ssize_t)bytes);
+      }
+    }
+  }
+  else
+  {
+    if (r->bufptr < r->bufend)
+    {
+      // Use buffered (memory-mapped) data first...
+      if ((size_t)(total = r->bufend - r->bufptr) > bytes)
+	total = (ssize_t)bytes;
+
+      memcpy(buf, r->bufptr, (size_t)total);
+      r->bufptr += total;
+      buf       += total;
+    }
+
+    if (r->iosize > 0 && (bytes - (size_t)total) < r->iosize)
+    {
+      // Read ahead into the I/O buffer...
+      if (!cups_raster_alloc(r, r->iosize))
+        return (-1);
+
+      while (total < (ssize_t)bytes)
+      {
+        if ((count = (*r->iocb)(r->ctx, r->buffer, r->bufsize)) <= 0)
+          return (count < 0 ? -1 : total);
+
+#ifdef DEBUG
+	r->iocount += (size_t)count;
+#endif // DEBUG
+
+        r->bufptr = r->buffer;
+        r->bufend = r->buffer + count;
+
+        if (count > (ssize_t)bytes - total)
+          count = (ssize_t)bytes - total;
+
+        memcpy(buf, r->bufptr, (size_t)count);
+        r->bufptr += count;
+        buf       += count;
+        total     += count;
+      }
+
+      return (total);
+    }
+  }
+
+  for (; total < (ssize_t)bytes; total += count, buf += count)
+  {
+    count = (*r->iocb)(r->ctx, buf, bytes - (size_t)total);
+
+    DEBUG_printf("6cups_raster_io: count=%d, total=%d", (int)count, (int)total);
+    if (count == 0)
+      break;
+    else if (count < 0)
+    {
+      DEBUG_puts("6cups_raster_io: Returning -1 on error.");
+      return (-1);
+    }
+
+#ifdef DEBUG
+    r->iocount += (size_t)count;
+#endif // DEBUG
+  }
+
+  DEBUG_printf("6cups_raster_io: iocount=" CUPS_LLFMT, CUPS_LLCAST r->iocount);
+  DEBUG_printf("6cups_raster_io: Returning " CUPS_LLFMT ".", CUPS_LLCAST total);
+
+  return (total);
+}
+
+
+//
+// 'cups_raster_literal()' - Count the pixels that differ from the next pixel.
+//
+// This function returns the index of the first of the "n" pixels starting at
+// "ptr" that is the same as the pixel after it, or "n" if there is none.  The
+// caller ensures that "n + 1" pixels are available.
+//
+
+static unsigned				// O - Number of non-repeating pixels
+cups_raster_literal(
+    const unsigned char *ptr,		// I - First pixel
+    unsigned            bpp,		// I - Bytes per pixel
+    unsigned            n)		// I - Number of pixels to compare
+{
+  unsigned		i = 0;		// Current pixel
+  const unsigned char	*p;		// Pointer to current pixel
+
+
+#ifdef __SSE2__
+  // Compare 16 bytes at a time against the same bytes one pixel later...
+  switch (bpp)
+  {
+    case 1 :
+        for (; (i + 16) <= n; i += 16)
+        {
+          if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(ptr + i)), _mm_loadu_si128((const __m128i *)(ptr + i + 1)))))
+            break;
+        }
+        break;
+
+    case 2 :
+        for (p = ptr + 2 * i; (i + 8) <= n; i += 8, p += 16)
+        {
+          if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_loadu_si128((const __m128i *)p), _mm_loadu_si128((const __m128i *)(p + 2)))))
+            break;
+        }
+        break;
+
+    case 3 :
+        // Five 3-byte pixels fit in each 16-byte compare, and a pixel repeats
+        // when all three of its byte comparisons are true...
+        for (p = ptr; (i + 6) <= n; i += 5, p += 15)
+        {
+          int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)p), _mm_loadu_si128((const __m128i *)(p + 3))));
+
+          if (mask & (mask >> 1) & (mask >> 2) & 0x1249)
+            break;
+        }
+        break;
+
+    case 4 :
+        for (p = ptr; (i + 4) <= n; i += 4, p += 16)
+        {
+          if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)p), _mm_loadu_si128((const __m128i *)(p + 4)))))
+            break;
+        }
+        break;
+  }
+
+#elif defined(_CUPS_RASTER_NEON)
+  // Compare 16 bytes at a time against the same bytes one pixel later...
+  switch (bpp)
+  {
+    case 1 :
+        for (; (i + 16) <= n; i += 16)
+        {
+          if (vmaxvq_u8(vceqq_u8(vld1q_u8(ptr + i), vld1q_u8(ptr + i + 1))))
+            break;
+        }
+        break;
+
+    case 2 :
+        for (p = ptr + 2 * i; (i + 8) <= n; i += 8, p += 16)
+        {
+          if (vmaxvq_u16(vceqq_u16(vreinterpretq_u16_u8(vld1q_u8(p)), vreinterpretq_u16_u8(vld1q_u8(p + 2)))))
+            break;
+        }
+        break;
+
+    case 4 :
+        for (p = ptr; (i + 4) <= n; i += 4, p += 16)
+        {
+          if (vmaxvq_u32(vceqq_u32(vreinterpretq_u32_u8(vld1q_u8(p)), vreinterpretq_u32_u8(vld1q_u8(p + 4)))))
+            break;
+        }
+        break;
+  }
+#endif // __SSE2__
+
+  // Find the repeating pixel in the remaining pixels...
+  switch (bpp)
+  {
+    case 1 :
+        for (; i < n; i ++)
+        {
+          if (ptr[i] == ptr[i + 1])
+            break;
+        }
+        break;
+
+    case 3 :
+        for (p = ptr + 3 * i; i < n; i ++, p += 3)
+        {
+          if (p[0] == p[3] && p[1] == p[4] && p[2] == p[5])
+            break;
+        }
+        break;
+
+    default :
+        for (p = ptr + bpp * i; i < n; i ++, p += bpp)
+        {
+          if (!memcmp(p, p + bpp, bpp))
+            break;
+        }
+        break;
+  }
+
+  return (i);
+}
+
+
+#ifndef _WIN32
+//
+// 'cups_raster_map()' - Map a regular file into memory for reading.
+//
+// The mapped file data is used as the read buffer, and the file descriptor
+// is positioned at the end of the mapping so that any data appended to the
+// file is read normally.  The stream is left unchanged if the file cannot be
+// mapped.
+//
+
+static void
+cups_raster_map(cups_raster_t *r,	// I - Raster stream
+                int           fd)	// I - File descriptor
+{
+  struct stat	fileinfo;		// File information
+  off_t		offset;			// Current offset in file
+  unsigned char	*map;			// Mapped data
+
+
+  if (fstat(fd, &fileinfo) || !S_ISREG(fileinfo.st_mode) || (uintmax_t)fileinfo.st_size > SIZE_MAX || (offset = lseek(fd, 0, SEEK_CUR)) < 0 || offset >= fileinfo.st_size)
+    return;
+
+  if ((map = mmap(NULL, (size_t)fileinfo.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED)
+  {
+    DEBUG_printf("4cups_raster_map: mmap failed - %s", strerror(errno));
+    return;
+  }
+
+  if (lseek(fd, fileinfo.st_size, SEEK_SET) != fileinfo.st_size)
+  {
+    munmap(map, (size_t)fileinfo.st_size);
+    lseek(fd, offset, SEEK_SET);
+    return;
+  }
+
+#  ifdef MADV_SEQUENTIAL
+  madvise(map, (size_t)fileinfo.st_size, MADV_SEQUENTIAL);
+#  endif // MADV_SEQUENTIAL
+
+  r->map    = map;
+  r->maplen = (size_t)fileinfo.st_size;
+  r->bufptr = map + offset;
+  r->bufend = map + r->maplen;
+}
+#endif // !_WIN32
+
+
+//
+// 'cups_raster_read()' - Read through the raster buffer.
+//
+
+static ssize_t				// O - Number of bytes read
+cups_raster_read(cups_raster_t *r,	// I - Raster stream
+                 unsigned char *buf,	// I - Buffer
+                 size_t        bytes)	// I - Number of bytes to read
+{
+  ssize_t	count,			// Number of bytes read
+		remaining,		// Remaining bytes in buffer
+		total;			// Total bytes read
+
+
+  DEBUG_printf("4cups_raster_read(r=%p, buf=%p, bytes=" CUPS_LLFMT "), offset=" CUPS_LLFMT, (void *)r, (void *)buf, CUPS_LLCAST bytes, CUPS_LLCAST (r->iostart + r->bufptr - r->buffer));
+
+  if (!r->compressed)
+    return (cups_raster_io(r, buf, bytes));
+
+  if (r->bufptr && (size_t)(r->bufend - r->bufptr) >= bytes)
+  {
+    // Copy directly from the raster buffer...
+    memcpy(buf, r->bufptr, bytes);
+    r->bufptr += bytes;
+
+    return ((ssize_t)bytes);
+  }
+
+  // Allocate a read buffer as needed...
+  count = (ssize_t)(2 * r->header.cupsBytesPerLine);
+  if (count < 65536)
+    count = 65536;
+  if ((size_t)count < r->iosize)
+    count = (ssize_t)r->iosize;
+
+  if (!cups_raster_alloc(r, (size_t)count))
+    return (0);
+
+  // Loop until we have read everything...
   for (total = 0, remaining = (int)(r->bufend - r->bufptr); total < (ssize_t)bytes; total += count, buf += count)
   {
-    count = (ssize_t)bytes - total;
+    count = (ssize_t)bytes - total;
+
+    DEBUG_printf("5cups_raster_read: count=" CUPS_LLFMT ", remaining=" CUPS_LLFMT ", buf=%p, bufptr=%p, bufend=%p", CUPS_LLCAST count, CUPS_LLCAST remaining, (void *)buf, (void *)r->bufptr, (void *)r->bufend);
+
+    if (remaining == 0)
+    {
+      if (count < 16)
+      {
+        // Read into the raster buffer and then copy...
+#ifdef DEBUG
+        r->iostart += (size_t)(r->bufend - r->buffer);
+#endif // DEBUG
+
+        remaining = (*r->iocb)(r->ctx, r->buffer, r->bufsize);
+	if (remaining <= 0)
+	  return (0);
+
+	r->bufptr = r->buffer;
+	r->bufend = r->buffer + remaining;
+
+#ifdef DEBUG
+        r->iocount += (size_t)remaining;
+#endif // DEBUG
+      }
+      else
+      {
+        // Read directly into "buf"...
+	count = (*r->iocb)(r->ctx, buf, (size_t)count);
+
+	if (count <= 0)
+	  return (0);
+
+#ifdef DEBUG
+	r->iostart += (size_t)count;
+        r->iocount += (size_t)count;
+#endif // DEBUG
+
+	continue;
+      }
+    }
+
+    // Copy bytes from raster buffer to "buf"...
+    if (count > remaining)
+      count = remaining;
+
+    if (count == 1)
+    {
+      // Copy 1 byte...
+      *buf = *(r->bufptr)++;
+      remaining --;
+    }
+    else if (count < 128)
+    {
+      // Copy up to 127 bytes without using memcpy(); this is faster because it
+      // avoids an extra function call and is often further optimized by the
+      // compiler...
+      unsigned char	*bufptr;	// Temporary buffer pointer
+
+      remaining -= count;
+
+      for (bufptr = r->bufptr; count > 0; count --, total ++)
+	*buf++ = *bufptr++;
+
+      r->bufptr = bufptr;
+    }
+    else
+    {
+      // Use memcpy() for a large read...
+      memcpy(buf, r->bufptr, (size_t)count);
+      r->bufptr += count;
+      remaining -= count;
+    }
+  }
+
+  DEBUG_printf("5cups_raster_read: Returning %ld", (long)total);
+
+  return (total);
+}
+
+
+//
+// 'cups_raster_repeat()' - Count the pixels that are the same as the next pixel.
+//
+// This function returns the number of the "n" pixels starting at "ptr" that
+// are the same as the pixel after them.  Since consecutive pixels are the same
+// when every byte matches the byte "bpp" bytes later, this is the offset of the
+// first different byte divided by "bpp".  The caller ensures that "n + 1"
+// pixels are available.
+//
+
+static unsigned				// O - Number of repeating pixels
+cups_raster_repeat(
+    const unsigned char *ptr,		// I - First pixel
+    unsigned            bpp,		// I - Bytes per pixel
+    unsigned            n)		// I - Number of pixels to compare
+{
+  const unsigned char	*next = ptr + bpp;
+					// Next pixel
+  size_t		i = 0,		// Current byte
+			bytes = (size_t)n * bpp;
+					// Number of bytes to compare
+
+
+  // Skip 16 (or 8) bytes at a time until there is a difference...
+#ifdef __SSE2__
+  for (; (i + 16) <= bytes; i += 16)
+  {
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(ptr + i)), _mm_loadu_si128((const __m128i *)(next + i)))) != 0xffff)
+      break;
+  }
+
+#elif defined(_CUPS_RASTER_NEON)
+  for (; (i + 16) <= bytes; i += 16)
+  {
+    if (vminvq_u8(vceqq_u8(vld1q_u8(ptr + i), vld1q_u8(next + i))) != 0xff)
+      break;
+  }
+
+#else
+  for (; (i + 8) <= bytes; i += 8)
+  {
+    uint64_t	a, b;			// Bytes to compare
+
+    memcpy(&a, ptr + i, sizeof(a));
+    memcpy(&b, next + i, sizeof(b));
+
+    if (a != b)
+      break;
+  }
+#endif // __SSE2__
+
+  // Then find the first different byte...
+  for (; i < bytes; i ++)
+  {
+    if (ptr[i] != next[i])
+      break;
+  }
+
+  return ((unsigned)(i / bpp));
+}
+
+
+//
+// 'cups_raster_reset()' - Reset the row count and line buffer for a new page.
+//
+
+static void
+cups_raster_reset(cups_raster_t *r)	// I - Raster stream
+{
+  if (r->header.cupsColorOrder == CUPS_ORDER_PLANAR)
+    r->remaining = r->header.cupsHeight * r->header.cupsNumColors;
+  else
+    r->remaining = r->header.cupsHeight;
+
+  r->pcurrent = r->pixels;
+  r->count    = 0;
+}
+
+
+//
+// 'cups_raster_seek()' - Set the read position in a raster file.
+//
+// Offsets within the memory-mapped part of the file are read from the mapping
+// with the file positioned at the end of the mapping, just like
+// @code cups_raster_map@ leaves it.
+//
+
+static bool				// O - `true` on success, `false` on error
+cups_raster_seek(cups_raster_t *r,	// I - Raster stream
+                 off_t         offset)	// I - Offset in file
+{
+  int	fd = (int)((intptr_t)r->ctx);	// File descriptor
+
+
+  DEBUG_printf("4cups_raster_seek(r=%p, offset=" CUPS_LLFMT ")", (void *)r, CUPS_LLCAST offset);
+
+  if (r->map && offset <= (off_t)r->maplen)
+  {
+    if (lseek(fd, (off_t)r->maplen, SEEK_SET) != (off_t)r->maplen)
+    {
+      _cupsRasterAddError("Unable to seek in raster stream: %s", strerror(errno));
+      return (false);
+    }
+
+    r->bufptr = r->map + offset;
+    r->bufend = r->map + r->maplen;
+  }
+  else
+  {
+    if (lseek(fd, offset, SEEK_SET) != offset)
+    {
+      _cupsRasterAddError("Unable to seek in raster stream: %s", strerror(errno));
+      return (false);
+    }
+
+    r->bufptr = r->bufend = r->buffer;
+  }
+
+  return (true);
+}
+
+
+//
+// 'cups_raster_skip()' - Skip the line data for the current page.
+//
+// Compressed lines are parsed just enough to find where they end, so the
+// pixels are never decoded.
+//
+
+static bool				// O - `true` on success, `false` on error
+cups_raster_skip(cups_raster_t *r)	// I - Raster stream
+{
+  unsigned	lines,			// Lines remaining
+		bytes,			// Bytes remaining in line
+		count;			// Bytes for current run
+  unsigned char	byte;			// Byte from file
+  off_t		offset;			// Current offset
+
+
+  if (!r->compressed)
+  {
+    // Seek past the uncompressed lines...
+    if ((offset = cups_raster_tell(r)) < 0 || !cups_raster_seek(r, offset + (off_t)r->header.cupsBytesPerLine * r->remaining))
+      return (false);
 
-    DEBUG_printf("5cups_raster_read: count=" CUPS_LLFMT ", remaining=" CUPS_LLFMT ", buf=%p, bufptr=%p, bufend=%p", CUPS_LLCAST count, CUPS_LLCAST remaining, (void *)buf, (void *)r->bufptr, (void *)r->bufend);
+    r->remaining = 0;
 
-    if (remaining == 0)
-    {
-      if (count < 16)
-      {
-        // Read into the raster buffer and then copy...
-#ifdef DEBUG
-        r->iostart += (size_t)(r->bufend - r->buffer);
-#endif // DEBUG
+    return (true);
+  }
 
-        remaining = (*r->iocb)(r->ctx, r->buffer, r->bufsize);
-	if (remaining <= 0)
-	  return (0);
+  for (lines = r->remaining; lines > 0;)
+  {
+    // Get the line repeat count...
+    if (cups_raster_read(r, &byte, 1) != 1)
+      return (false);
 
-	r->bufptr = r->buffer;
-	r->bufend = r->buffer + remaining;
+    if ((unsigned)byte + 1 > lines)
+      lines = 0;
+    else
+      lines -= (unsigned)byte + 1;
 
-#ifdef DEBUG
-        r->iocount += (size_t)remaining;
-#endif // DEBUG
+    // Then skip the runs of pixels for the line...
+    for (bytes = r->header.cupsBytesPerLine; bytes > 0; bytes -= count)
+    {
+      if (cups_raster_read(r, &byte, 1) != 1)
+        return (false);
+
+      if (byte == 128)
+      {
+        // Clear to end of line...
+        break;
       }
-      else
+      else if (byte & 128)
       {
-        // Read directly into "buf"...
-	count = (*r->iocb)(r->ctx, buf, (size_t)count);
+        // N literal pixels...
+        if ((count = (unsigned)(257 - byte) * r->bpp) > bytes)
+          count = bytes;
 
-	if (count <= 0)
-	  return (0);
+        if (!cups_raster_skip_bytes(r, count))
+          return (false);
+      }
+      else
+      {
+        // Repeat the next pixel N times...
+        if ((count = ((unsigned)byte + 1) * r->bpp) > bytes)
+          count = bytes;
 
-#ifdef DEBUG
-	r->iostart += (size_t)count;
-        r->iocount += (size_t)count;
-#endif // DEBUG
+        if (count < r->bpp)
+          break;
 
-	continue;
+        if (!cups_raster_skip_bytes(r, r->bpp))
+          return (false);
       }
     }
+  }
 
-    // Copy bytes from raster buffer to "buf"...
-    if (count > remaining)
-      count = remaining;
+  r->remaining = 0;
 
-    if (count == 1)
-    {
-      // Copy 1 byte...
-      *buf = *(r->bufptr)++;
-      remaining --;
-    }
-    else if (count < 128)
-    {
-      // Copy up to 127 bytes without using memcpy(); this is faster because it
-      // avoids an extra function call and is often further optimized by the
-      // compiler...
-      unsigned char	*bufptr;	// Temporary buffer pointer
+  return (true);
+}
 
-      remaining -= count;
 
-      for (bufptr = r->bufptr; count > 0; count --, total ++)
-	*buf++ = *bufptr++;
+//
+// 'cups_raster_skip_bytes()' - Skip bytes in a compressed raster stream.
+//
 
-      r->bufptr = bufptr;
+static bool				// O - `true` on success, `false` on error
+cups_raster_skip_bytes(
+    cups_raster_t *r,			// I - Raster stream
+    size_t        bytes)		// I - Number of bytes to skip
+{
+  size_t	count;			// Bytes skipped
+  unsigned char	temp[1024];		// Temporary buffer
+
+
+  while (bytes > 0)
+  {
+    if (r->bufptr < r->bufend)
+    {
+      // Skip buffered (memory-mapped) data...
+      if ((count = (size_t)(r->bufend - r->bufptr)) > bytes)
+        count = bytes;
+
+      r->bufptr += count;
     }
     else
     {
-      // Use memcpy() for a large read...
-      memcpy(buf, r->bufptr, (size_t)count);
-      r->bufptr += count;
-      remaining -= count;
+      // Read more data...
+      if ((count = bytes) > sizeof(temp))
+        count = sizeof(temp);
+
+      if (cups_raster_read(r, temp, count) != (ssize_t)count)
+        return (false);
     }
+
+    bytes -= count;
   }
 
-  DEBUG_printf("5cups_raster_read: Returning %ld", (long)total);
+  return (true);
+}
 
-  return (total);
+
+//
+// 'cups_raster_tell()' - Get the read position in a raster file.
+//
+
+static off_t				// O - Offset in file or `-1` on error
+cups_raster_tell(cups_raster_t *r)	// I - Raster stream
+{
+  off_t	offset;				// Offset in file
+
+
+  if (r->map && r->bufend == r->map + r->maplen)
+    return ((off_t)(r->bufptr - r->map));
+
+  if ((offset = lseek((int)((intptr_t)r->ctx), 0, SEEK_CUR)) < 0)
+    return (-1);
+
+  if (r->bufptr)
+    offset -= (off_t)(r->bufend - r->bufptr);
+
+  return (offset);
+}
+
+
+//
+// 'cups_raster_thread()' - Compress the rows for a compression job.
+//
+
+static void *				// O - Thread exit status
+cups_raster_thread(_cups_rjob_t *job)	// I - Compression job
+{
+  size_t	i;			// Looping var
+
+
+  for (i = 0, job->bufused = 0; i < job->num_rows; i ++)
+    job->bufused += cups_raster_encode(job->r, job->rows[i].pixels, job->rows[i].count, job->buffer + job->bufused);
+
+  return (NULL);
 }
 
 
@@ -1615,19 +2706,14 @@ cups_raster_update(cups_raster_t *r)	// I - Raster stream
   if (r->bpp == 0)
     r->bpp = 1;
 
-  // Set the number of remaining rows...
-  if (r->header.cupsColorOrder == CUPS_ORDER_PLANAR)
-    r->remaining = r->header.cupsHeight * r->header.cupsNumColors;
-  else
-    r->remaining = r->header.cupsHeight;
-
-  // Allocate the compression buffer...
-  if (r->compressed)
+  // Allocate the compression/line buffer, reusing the current buffer when the
+  // line length has not changed...
+  if ((r->compressed || r->mode == CUPS_RASTER_READ) && (!r->pixels || r->pend != r->pixels + r->header.cupsBytesPerLine))
   {
     if (r->pixels != NULL)
-      free(r->pixels);
+      _cupsMemFree(r->pixels);
 
-    if ((r->pixels = calloc(r->header.cupsBytesPerLine, 1)) == NULL)
+    if ((r->pixels = _cupsMemCalloc(CUPS_MEMTYPE_RASTER, r->header.cupsBytesPerLine, 1)) == NULL)
     {
       r->pcurrent = NULL;
       r->pend     = NULL;
@@ -1636,11 +2722,16 @@ cups_raster_update(cups_raster_t *r)	// I - Raster stream
       return (0);
     }
 
-    r->pcurrent = r->pixels;
-    r->pend     = r->pixels + r->header.cupsBytesPerLine;
-    r->count    = 0;
+    r->pend = r->pixels + r->header.cupsBytesPerLine;
+  }
+  else if (r->pixels)
+  {
+    memset(r->pixels, 0, r->header.cupsBytesPerLine);
   }
 
+  // Set the number of remaining rows...
+  cups_raster_reset(r);
+
   return (1);
 }
 
@@ -1654,109 +2745,172 @@ cups_raster_write(
     cups_raster_t       *r,		// I - Raster stream
     const unsigned char *pixels)	// I - Pixel data to write
 {
-  const unsigned char	*start,		// Start of sequence
-			*ptr,		// Current pointer in sequence
-			*pend,		// End of raster buffer
-			*plast;		// Pointer to last pixel
-  unsigned char		*wptr;		// Pointer into write buffer
-  unsigned		bpp,		// Bytes per pixel
-			count;		// Count
-  _cups_copyfunc_t	cf;		// Copy function
+  size_t		count,		// Count
+			linesize;	// Maximum compressed line size
 
 
   DEBUG_printf("3cups_raster_write(r=%p, pixels=%p)", (void *)r, (void *)pixels);
 
-  // Determine whether we need to swap bytes...
-  if (r->swapped && (r->header.cupsBitsPerColor == 16 || r->header.cupsBitsPerPixel == 12 || r->header.cupsBitsPerPixel == 16))
-  {
-    DEBUG_puts("4cups_raster_write: Swapping bytes when writing.");
-    cf = (_cups_copyfunc_t)cups_swap_copy;
-  }
-  else
-    cf = (_cups_copyfunc_t)memcpy;
-
   // Allocate a write buffer as needed...
   count = r->header.cupsBytesPerLine * 2;
   if (count < 65536)
     count = 65536;
+  if (count < r->iosize)
+    count = r->iosize;
 
-  if ((size_t)count > r->bufsize)
-  {
-    if (r->buffer)
-      wptr = realloc(r->buffer, count);
-    else
-      wptr = malloc(count);
+  if (!cups_raster_alloc(r, count))
+    return (-1);
 
-    if (!wptr)
-    {
-      DEBUG_printf("4cups_raster_write: Unable to allocate " CUPS_LLFMT " bytes for raster buffer: %s", CUPS_LLCAST count, strerror(errno));
-      return (-1);
-    }
+  // Make room for the compressed row...
+  linesize = r->header.cupsBytesPerLine + r->header.cupsBytesPerLine / 64 + 16;
 
-    r->buffer  = wptr;
-    r->bufsize = count;
-  }
+  if ((size_t)(r->bufptr - r->buffer) + linesize > r->bufsize && !cups_raster_flush(r))
+    return (-1);
 
-  // Write the row repeat count...
-  bpp     = r->bpp;
-  pend    = pixels + r->header.cupsBytesPerLine;
-  plast   = pend - bpp;
-  wptr    = r->buffer;
-  *wptr++ = (unsigned char)(r->count - 1);
+  // Compress the row, writing it immediately unless we are buffering output...
+  count     = cups_raster_encode(r, pixels, r->count, r->bufptr);
+  r->bufptr += count;
 
-  // Write using a modified PackBits compression...
-  for (ptr = pixels; ptr < pend;)
+  if (r->iosize == 0 && !cups_raster_flush(r))
+    return (-1);
+
+  return ((ssize_t)count);
+}
+
+
+//
+// 'cups_raster_write_lines()' - Compress and write whole lines using multiple threads.
+//
+// Consecutive identical lines are combined in the same way as
+// @link cupsRasterWritePixels@, and the resulting rows are then divided among
+// the compression threads and written in order.
+//
+
+static bool				// O - `true` on success, `false` on error
+cups_raster_write_lines(
+    cups_raster_t       *r,		// I - Raster stream
+    const unsigned char *p,		// I - Pixel data to write
+    unsigned            lines)		// I - Number of lines
+{
+  bool			ret = true;	// Return value
+  size_t		bpl = r->header.cupsBytesPerLine,
+					// Bytes per line
+			linesize = bpl + bpl / 64 + 16,
+					// Maximum compressed line size
+			num_rows = 0,	// Number of rows
+			num_jobs,	// Number of compression jobs
+			per_job,	// Rows per job
+			i;		// Looping var
+  unsigned		y,		// Current line
+			count = r->count;
+					// Repeat count for row
+  const unsigned char	*prev = r->pixels;
+					// Previous line
+  _cups_rrow_t		*rows;		// Rows to compress
+  _cups_rjob_t		jobs[_CUPS_RASTER_MAX_THREADS],
+					// Compression jobs
+			*job;		// Current job
+
+
+  DEBUG_printf("3cups_raster_write_lines(r=%p, p=%p, lines=%u)", (void *)r, (void *)p, lines);
+
+  if ((rows = _cupsMemCalloc(CUPS_MEMTYPE_RASTER, lines + 1, sizeof(_cups_rrow_t))) == NULL)
+    return (false);
+
+  // Find the rows to write...
+  for (y = 0; y < lines; y ++, p += bpl)
   {
-    start = ptr;
-    ptr += bpp;
+    r->remaining --;
 
-    if (ptr == pend)
-    {
-      // Encode a single pixel at the end...
-      *wptr++ = 0;
-      (*cf)(wptr, start, bpp);
-      wptr += bpp;
-    }
-    else if (!memcmp(start, ptr, bpp))
+    if (count > 0 && !memcmp(p, prev, bpl))
     {
-      // Encode a sequence of repeating pixels...
-      for (count = 2; count < 128 && ptr < plast; count ++, ptr += bpp)
+      // Same as the previous line...
+      count += r->rowheight;
+
+      if (r->remaining == 0 || count > (256 - r->rowheight))
       {
-        if (memcmp(ptr, ptr + bpp, bpp))
-	  break;
-      }
+        rows[num_rows].pixels  = prev;
+        rows[num_rows ++].count = count;
 
-      *wptr++ = (unsigned char)(count - 1);
-      (*cf)(wptr, ptr, bpp);
-      wptr += bpp;
-      ptr  += bpp;
+        if (r->remaining > 0)
+          count = 0;
+      }
     }
     else
     {
-      // Encode a sequence of non-repeating pixels...
-      for (count = 1; count < 128 && ptr < plast; count ++, ptr += bpp)
+      // Start a new row...
+      if (count > 0)
       {
-        if (!memcmp(ptr, ptr + bpp, bpp))
-	  break;
+        rows[num_rows].pixels  = prev;
+        rows[num_rows ++].count = count;
       }
 
-      if (ptr >= plast && count < 128)
+      prev  = p;
+      count = r->rowheight;
+
+      if (r->remaining == 0)
       {
-        count ++;
-	ptr += bpp;
+        rows[num_rows].pixels  = prev;
+        rows[num_rows ++].count = count;
       }
+    }
+  }
 
-      *wptr++ = (unsigned char)(257 - count);
+  // Compress the rows, using the current thread for the first job...
+  if ((num_jobs = r->num_threads) > num_rows)
+    num_jobs = num_rows;
 
-      count *= bpp;
-      (*cf)(wptr, start, count);
-      wptr += count;
+  if (num_jobs > 0)
+  {
+    memset(jobs, 0, sizeof(jobs));
+
+    per_job  = (num_rows + num_jobs - 1) / num_jobs;
+    num_jobs = (num_rows + per_job - 1) / per_job;
+
+    for (i = 0, job = jobs; i < num_jobs; i ++, job ++)
+    {
+      job->r        = r;
+      job->rows     = rows + i * per_job;
+      job->num_rows = i < (num_jobs - 1) ? per_job : num_rows - i * per_job;
+      job->thread   = CUPS_THREAD_INVALID;
+
+      if ((job->buffer = _cupsMemAlloc(CUPS_MEMTYPE_RASTER, job->num_rows * linesize)) == NULL)
+      {
+        ret = false;
+        break;
+      }
+
+      if (i > 0)
+        job->thread = cupsThreadCreate((cups_thread_func_t)cups_raster_thread, job);
+    }
+
+    if (ret)
+      cups_raster_thread(jobs);
+
+    // Write the compressed rows in order...
+    for (i = 0, job = jobs; i < num_jobs; i ++, job ++)
+    {
+      if (job->thread != CUPS_THREAD_INVALID)
+	cupsThreadWait(job->thread);
+      else if (ret && i > 0)
+	cups_raster_thread(job);
+
+      if (ret && cups_raster_io(r, job->buffer, job->bufused) < (ssize_t)job->bufused)
+	ret = false;
+
+      _cupsMemFree(job->buffer);
     }
   }
 
-  DEBUG_printf("4cups_raster_write: Writing " CUPS_LLFMT " bytes.", CUPS_LLCAST (wptr - r->buffer));
+  // Save the last line for the next call...
+  if (count > 0 && prev != r->pixels)
+    memcpy(r->pixels, prev, bpl);
+
+  r->count = count;
+
+  _cupsMemFree(rows);
 
-  return (cups_raster_io(r, r->buffer, (size_t)(wptr - r->buffer)));
+  return (ret);
 }
 
 
@@ -1794,44 +2948,100 @@ static void
 cups_swap(unsigned char *buf,		// I - Buffer to swap
           size_t        bytes)		// I - Number of bytes to swap
 {
+  cups_swap_copy(buf, buf, bytes);
+}
+
+
+//
+// 'cups_swap_copy()' - Copy and swap bytes in raster data...
+//
+// The source and destination may be the same buffer.
+//
+
+static void
+cups_swap_copy(
+    unsigned char       *dst,		// I - Destination
+    const unsigned char *src,		// I - Source
+    size_t              bytes)		// I - Number of bytes to swap
+{
+  size_t	i = 0;			// Current byte
   unsigned char	even, odd;		// Temporary variables
 
 
-  bytes /= 2;
+  bytes &= ~(size_t)1;
 
-  while (bytes > 0)
+  // Swap 16 (or 8) bytes at a time...
+#ifdef __SSE2__
+  for (; (i + 16) <= bytes; i += 16)
+  {
+    __m128i	v = _mm_loadu_si128((const __m128i *)(src + i));
+					// 8 16-bit values
+
+    _mm_storeu_si128((__m128i *)(dst + i), _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8)));
+  }
+
+#elif defined(_CUPS_RASTER_NEON)
+  for (; (i + 16) <= bytes; i += 16)
+    vst1q_u8(dst + i, vrev16q_u8(vld1q_u8(src + i)));
+
+#else
+  for (; (i + 8) <= bytes; i += 8)
   {
-    even   = buf[0];
-    odd    = buf[1];
-    buf[0] = odd;
-    buf[1] = even;
+    uint64_t	v;			// 4 16-bit values
+
+    memcpy(&v, src + i, sizeof(v));
+    v = ((v & 0x00ff00ff00ff00ffULL) << 8) | ((v >> 8) & 0x00ff00ff00ff00ffULL);
+    memcpy(dst + i, &v, sizeof(v));
+  }
+#endif // __SSE2__
 
-    buf += 2;
-    bytes --;
+  // Then swap any remaining bytes...
+  for (; i < bytes; i += 2)
+  {
+    even       = src[i];
+    odd        = src[i + 1];
+    dst[i]     = odd;
+    dst[i + 1] = even;
   }
 }
 
 
 //
-// 'cups_swap_copy()' - Copy and swap bytes in raster data...
+// 'cups_swap_words()' - Swap bytes in 32-bit header values...
 //
 
 static void
-cups_swap_copy(
-    unsigned char       *dst,		// I - Destination
-    const unsigned char *src,		// I - Source
-    size_t              bytes)		// I - Number of bytes to swap
+cups_swap_words(unsigned *words,	// I - Values to swap
+                size_t   count)		// I - Number of values
 {
-  bytes /= 2;
+  size_t	i = 0;			// Current value
+  unsigned	temp;			// Temporary copy
 
-  while (bytes > 0)
+
+  // Swap 4 values at a time...
+#ifdef __SSE2__
+  for (; (i + 4) <= count; i += 4)
   {
-    dst[0] = src[1];
-    dst[1] = src[0];
+    __m128i	v = _mm_loadu_si128((const __m128i *)(words + i));
+					// 4 32-bit values
+
+    // Swap the bytes in each 16-bit half and then the halves...
+    v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+    v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
 
-    dst += 2;
-    src += 2;
-    bytes --;
+    _mm_storeu_si128((__m128i *)(words + i), v);
+  }
+
+#elif defined(_CUPS_RASTER_NEON)
+  for (; (i + 4) <= count; i += 4)
+    vst1q_u8((uint8_t *)(words + i), vrev32q_u8(vld1q_u8((const uint8_t *)(words + i))));
+#endif // __SSE2__
+
+  // Then swap any remaining values...
+  for (; i < count; i ++)
+  {
+    temp     = words[i];
+    words[i] = ((temp & 0xff) << 24) | ((temp & 0xff00) << 8) | ((temp & 0xff0000) >> 8) | ((temp & 0xff000000) >> 24);
   }
 }
 
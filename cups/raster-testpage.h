@@ -42,8 +42,10 @@ cupsRasterWriteTest(
 			page;		// Current page number
   char			pagestr[5],	// Page number string
 			output[8][101];	// Output image
-  unsigned char		*line,		// Line of raster data
+  unsigned char		*kline,		// Solid black line in raster data
 			*bline,		// Border line in raster data
+			*lines[2],	// Cached interior lines (even/odd)
+			*line,		// Current interior line
 			*lineptr,	// Pointer into line
 			*lineend,	// Pointer to end of line
 			black,		// Black pixel
@@ -57,7 +59,8 @@ cupsRasterWriteTest(
 			xoff, yoff,	// X and Y offsets
 			xend, yend,	// End X and Y values
 			yend2,		// End Y value for solid border
-			rows;		// Number of rows
+			rows,		// Number of rows
+			ncache;		// Number of cached lines per repeat
   int			col, row,	// Column and row in output
 			color;		// Template color
   ipp_orient_t		porientation;	// Current page orientation
@@ -151,19 +154,19 @@ cupsRasterWriteTest(
   yend  = header->cupsHeight - yoff;
   yend2 = header->cupsHeight - yborder;
 
-  // Allocate memory for the raster output...
-  if ((line = malloc(header->cupsBytesPerLine)) == NULL)
+  // Allocate memory for the raster output - the solid and border lines are
+  // the same for every page, and each interior line is formatted once and
+  // then written "yrep" times (twice for the alternating 1-bit shading
+  // patterns)...
+  if ((kline = malloc(4 * header->cupsBytesPerLine)) == NULL)
   {
-    _cupsRasterAddError("Unable to allocate %u bytes for line: %s", header->cupsBytesPerLine, strerror(errno));
+    _cupsRasterAddError("Unable to allocate %u bytes for lines: %s", 4 * header->cupsBytesPerLine, strerror(errno));
     return (false);
   }
 
-  if ((bline = malloc(header->cupsBytesPerLine)) == NULL)
-  {
-    _cupsRasterAddError("Unable to allocate %u bytes for line: %s", header->cupsBytesPerLine, strerror(errno));
-    free(line);
-    return (false);
-  }
+  bline    = kline + header->cupsBytesPerLine;
+  lines[0] = bline + header->cupsBytesPerLine;
+  lines[1] = lines[0] + header->cupsBytesPerLine;
 
   switch (header->cupsColorSpace)
   {
@@ -180,7 +183,109 @@ cupsRasterWriteTest(
   }
 
   bpp     = header->cupsBitsPerPixel / 8;
-  lineend = line + header->cupsBytesPerLine;
+  lineend = kline + header->cupsBytesPerLine;
+  ncache  = bpp ? 1 : 2;
+
+  if (bpp == 4)
+  {
+    // 32-bit CMYK output
+    for (lineptr = kline; lineptr < lineend;)
+    {
+      *lineptr++ = 0x00;
+      *lineptr++ = 0x00;
+      *lineptr++ = 0x00;
+      *lineptr++ = 0xff;
+    }
+  }
+  else if (bpp == 8)
+  {
+    // 64-bit CMYK output
+    for (lineptr = kline; lineptr < lineend;)
+    {
+      *lineptr++ = 0x00;
+      *lineptr++ = 0x00;
+      *lineptr++ = 0x00;
+      *lineptr++ = 0x00;
+      *lineptr++ = 0x00;
+      *lineptr++ = 0x00;
+      *lineptr++ = 0xff;
+      *lineptr++ = 0xff;
+    }
+  }
+  else
+  {
+    // 1/8/16/24/32-bit bitmap/grayscale/color output...
+    memset(kline, black, header->cupsBytesPerLine);
+  }
+
+  memset(bline, white, header->cupsBytesPerLine);
+  if (bpp == 4)
+  {
+    // 32-bit CMYK output
+    for (lineptr = bline, xcount = xborder; xcount > 0; xcount --)
+    {
+      *lineptr++ = 0x00;
+      *lineptr++ = 0x00;
+      *lineptr++ = 0x00;
+      *lineptr++ = 0xff;
+    }
+
+    for (lineptr = bline + header->cupsBytesPerLine - xborder * 4, xcount = xborder; xcount > 0; xcount --)
+    {
+      *lineptr++ = 0x00;
+      *lineptr++ = 0x00;
+      *lineptr++ = 0x00;
+      *lineptr++ = 0xff;
+    }
+  }
+  else if (bpp == 8)
+  {
+    // 64-bit CMYK output
+    for (lineptr = bline, xcount = xborder; xcount > 0; xcount --)
+    {
+      *lineptr++ = 0x00;
+      *lineptr++ = 0x00;
+      *lineptr++ = 0x00;
+      *lineptr++ = 0x00;
+      *lineptr++ = 0x00;
+      *lineptr++ = 0x00;
+      *lineptr++ = 0xff;
+      *lineptr++ = 0xff;
+    }
+
+    for (lineptr = bline + header->cupsBytesPerLine - xborder * 8, xcount = xborder; xcount > 0; xcount --)
+    {
+      *lineptr++ = 0x00;
+      *lineptr++ = 0x00;
+      *lineptr++ = 0x00;
+      *lineptr++ = 0x00;
+      *lineptr++ = 0x00;
+      *lineptr++ = 0x00;
+      *lineptr++ = 0xff;
+      *lineptr++ = 0xff;
+    }
+  }
+  else if (bpp)
+  {
+    // 8/16/24/32-bit grayscale/color output...
+    memset(bline, black, xborder * bpp);
+    memset(bline + header->cupsBytesPerLine - xborder * bpp, black, xborder * bpp);
+  }
+  else
+  {
+    // Bitmap output...
+    if (xborder >= 8)
+    {
+      memset(bline, black, xborder / 8);
+      memset(bline + header->cupsBytesPerLine - xborder / 8, black, xborder / 8);
+    }
+    if (xborder & 7)
+    {
+      // Capture partial pixels
+      bline[xborder / 8] ^= (0xff << (xborder & 7)) & 0xff;
+      bline[header->cupsBytesPerLine - xborder / 8 - 1] ^= 0xff >> (xborder & 7);
+    }
+  }
 
   // Loop to create all copies and pages...
   for (copy = 0; copy < num_copies; copy ++)
@@ -205,109 +310,8 @@ cupsRasterWriteTest(
       else
 	cupsRasterWriteHeader(ras, header);
 
-      if (bpp == 4)
-      {
-        // 32-bit CMYK output
-        for (lineptr = line; lineptr < lineend;)
-        {
-          *lineptr++ = 0x00;
-          *lineptr++ = 0x00;
-          *lineptr++ = 0x00;
-          *lineptr++ = 0xff;
-        }
-      }
-      else if (bpp == 8)
-      {
-        // 64-bit CMYK output
-        for (lineptr = line; lineptr < lineend;)
-        {
-          *lineptr++ = 0x00;
-          *lineptr++ = 0x00;
-          *lineptr++ = 0x00;
-          *lineptr++ = 0x00;
-          *lineptr++ = 0x00;
-          *lineptr++ = 0x00;
-          *lineptr++ = 0xff;
-          *lineptr++ = 0xff;
-        }
-      }
-      else
-      {
-        // 1/8/16/24/32-bit bitmap/grayscale/color output...
-        memset(line, black, header->cupsBytesPerLine);
-      }
-
       for (y = 0; y < yborder; y ++)
-	cupsRasterWritePixels(ras, line, header->cupsBytesPerLine);
-
-      memset(bline, white, header->cupsBytesPerLine);
-      if (bpp == 4)
-      {
-        // 32-bit CMYK output
-        for (lineptr = bline, xcount = xborder; xcount > 0; xcount --)
-        {
-          *lineptr++ = 0x00;
-          *lineptr++ = 0x00;
-          *lineptr++ = 0x00;
-          *lineptr++ = 0xff;
-        }
-
-        for (lineptr = bline + header->cupsBytesPerLine - xborder * 4, xcount = xborder; xcount > 0; xcount --)
-        {
-          *lineptr++ = 0x00;
-          *lineptr++ = 0x00;
-          *lineptr++ = 0x00;
-          *lineptr++ = 0xff;
-        }
-      }
-      else if (bpp == 8)
-      {
-        // 64-bit CMYK output
-        for (lineptr = bline, xcount = xborder; xcount > 0; xcount --)
-        {
-          *lineptr++ = 0x00;
-          *lineptr++ = 0x00;
-          *lineptr++ = 0x00;
-          *lineptr++ = 0x00;
-          *lineptr++ = 0x00;
-          *lineptr++ = 0x00;
-          *lineptr++ = 0xff;
-          *lineptr++ = 0xff;
-        }
-
-        for (lineptr = bline + header->cupsBytesPerLine - xborder * 8, xcount = xborder; xcount > 0; xcount --)
-        {
-          *lineptr++ = 0x00;
-          *lineptr++ = 0x00;
-          *lineptr++ = 0x00;
-          *lineptr++ = 0x00;
-          *lineptr++ = 0x00;
-          *lineptr++ = 0x00;
-          *lineptr++ = 0xff;
-          *lineptr++ = 0xff;
-        }
-      }
-      else if (bpp)
-      {
-        // 8/16/24/32-bit grayscale/color output...
-        memset(bline, black, xborder * bpp);
-        memset(bline + header->cupsBytesPerLine - xborder * bpp, black, xborder * bpp);
-      }
-      else
-      {
-        // Bitmap output...
-        if (xborder >= 8)
-        {
-          memset(bline, black, xborder / 8);
-          memset(bline + header->cupsBytesPerLine - xborder / 8, black, xborder / 8);
-        }
-        if (xborder & 7)
-        {
-          // Capture partial pixels
-          bline[xborder / 8] ^= (0xff << (xborder & 7)) & 0xff;
-          bline[header->cupsBytesPerLine - xborder / 8 - 1] ^= 0xff >> (xborder & 7);
-        }
-      }
+	cupsRasterWritePixels(ras, kline, header->cupsBytesPerLine);
 
       for (; y < yoff; y ++)
 	cupsRasterWritePixels(ras, bline, header->cupsBytesPerLine);
@@ -370,6 +374,15 @@ cupsRasterWriteTest(
                 // Write N scan lines...
 	        for (ycount = yrep; ycount > 0 && y < yend; ycount --, y ++)
 	        {
+		  // Replay the cached line for repeated scan lines...
+		  line = lines[bpp ? 0 : y & 1];
+
+		  if ((yrep - ycount) >= ncache)
+		  {
+		    cupsRasterWritePixels(ras, line, header->cupsBytesPerLine);
+		    continue;
+		  }
+
 		  // Format the current line in the output row...
 		  memcpy(line, bline, header->cupsBytesPerLine);
 		  colorptr = colors[color];
@@ -530,6 +543,15 @@ cupsRasterWriteTest(
 		// Write N scan lines...
 		for (ycount = yrep; ycount > 0 && y < yend; ycount --, y ++)
 		{
+		  // Replay the cached line for repeated scan lines...
+		  line = lines[bpp ? 0 : y & 1];
+
+		  if ((yrep - ycount) >= ncache)
+		  {
+		    cupsRasterWritePixels(ras, line, header->cupsBytesPerLine);
+		    continue;
+		  }
+
 		  memcpy(line, bline, header->cupsBytesPerLine);
 
 		  color = (int)rows - 1;
@@ -697,6 +719,15 @@ cupsRasterWriteTest(
                 // Write N scan lines...
 	        for (ycount = yrep; ycount > 0 && y < yend; ycount --, y ++)
 	        {
+		  // Replay the cached line for repeated scan lines...
+		  line = lines[bpp ? 0 : y & 1];
+
+		  if ((yrep - ycount) >= ncache)
+		  {
+		    cupsRasterWritePixels(ras, line, header->cupsBytesPerLine);
+		    continue;
+		  }
+
 		  // Format the current line in the output row...
 		  memcpy(line, bline, header->cupsBytesPerLine);
 		  colorptr = colors[color];
@@ -851,6 +882,15 @@ cupsRasterWriteTest(
 		// Write N scan lines...
 		for (ycount = yrep; ycount > 0 && y < yend; ycount --, y ++)
 		{
+		  // Replay the cached line for repeated scan lines...
+		  line = lines[bpp ? 0 : y & 1];
+
+		  if ((yrep - ycount) >= ncache)
+		  {
+		    cupsRasterWritePixels(ras, line, header->cupsBytesPerLine);
+		    continue;
+		  }
+
 		  memcpy(line, bline, header->cupsBytesPerLine);
 
 		  color = 0;
@@ -1016,6 +1056,15 @@ cupsRasterWriteTest(
                 // Write N scan lines...
 	        for (ycount = yrep; ycount > 0 && y < yend; ycount --, y ++)
 	        {
+		  // Replay the cached line for repeated scan lines...
+		  line = lines[bpp ? 0 : y & 1];
+
+		  if ((yrep - ycount) >= ncache)
+		  {
+		    cupsRasterWritePixels(ras, line, header->cupsBytesPerLine);
+		    continue;
+		  }
+
 		  // Format the current line in the output row...
 		  memcpy(line, bline, header->cupsBytesPerLine);
 		  colorptr = colors[color];
@@ -1171,6 +1220,15 @@ cupsRasterWriteTest(
 		// Write N scan lines...
 		for (ycount = yrep; ycount > 0 && y < yend; ycount --, y ++)
 		{
+		  // Replay the cached line for repeated scan lines...
+		  line = lines[bpp ? 0 : y & 1];
+
+		  if ((yrep - ycount) >= ncache)
+		  {
+		    cupsRasterWritePixels(ras, line, header->cupsBytesPerLine);
+		    continue;
+		  }
+
 		  memcpy(line, bline, header->cupsBytesPerLine);
 
 		  color = (int)rows - 1;
@@ -1344,6 +1402,15 @@ cupsRasterWriteTest(
                 // Write N scan lines...
 	        for (ycount = yrep; ycount > 0 && y < yend; ycount --, y ++)
 	        {
+		  // Replay the cached line for repeated scan lines...
+		  line = lines[bpp ? 0 : y & 1];
+
+		  if ((yrep - ycount) >= ncache)
+		  {
+		    cupsRasterWritePixels(ras, line, header->cupsBytesPerLine);
+		    continue;
+		  }
+
 		  // Format the current line in the output row...
 		  memcpy(line, bline, header->cupsBytesPerLine);
 		  colorptr = colors[color];
@@ -1503,6 +1570,15 @@ cupsRasterWriteTest(
 		// Write N scan lines...
 		for (ycount = yrep; ycount > 0 && y < yend; ycount --, y ++)
 		{
+		  // Replay the cached line for repeated scan lines...
+		  line = lines[bpp ? 0 : y & 1];
+
+		  if ((yrep - ycount) >= ncache)
+		  {
+		    cupsRasterWritePixels(ras, line, header->cupsBytesPerLine);
+		    continue;
+		  }
+
 		  memcpy(line, bline, header->cupsBytesPerLine);
 
 		  color = 0;
@@ -1661,46 +1737,13 @@ cupsRasterWriteTest(
       for (; y < yend2; y ++)
 	cupsRasterWritePixels(ras, bline, header->cupsBytesPerLine);
 
-      if (bpp == 4)
-      {
-        // 32-bit CMYK output
-        for (lineptr = line; lineptr < lineend;)
-        {
-          *lineptr++ = 0x00;
-          *lineptr++ = 0x00;
-          *lineptr++ = 0x00;
-          *lineptr++ = 0xff;
-        }
-      }
-      else if (bpp == 8)
-      {
-        // 64-bit CMYK output
-        for (lineptr = line; lineptr < lineend;)
-        {
-          *lineptr++ = 0x00;
-          *lineptr++ = 0x00;
-          *lineptr++ = 0x00;
-          *lineptr++ = 0x00;
-          *lineptr++ = 0x00;
-          *lineptr++ = 0x00;
-          *lineptr++ = 0xff;
-          *lineptr++ = 0xff;
-        }
-      }
-      else
-      {
-        // 1/8/16/24/32-bit bitmap/grayscale/color output...
-        memset(line, black, header->cupsBytesPerLine);
-      }
-
       for (; y < header->cupsHeight; y ++)
-	cupsRasterWritePixels(ras, line, header->cupsBytesPerLine);
+	cupsRasterWritePixels(ras, kline, header->cupsBytesPerLine);
     }
   }
 
   // Free memory and return...
-  free(line);
-  free(bline);
+  free(kline);
 
   return (true);
 }
@@ -356,11 +356,15 @@ typedef ssize_t (*cups_raster_cb_t)(void *ctx, unsigned char *buffer, size_t len
 
 extern void		cupsRasterClose(cups_raster_t *r) _CUPS_PUBLIC;
 extern const char	*cupsRasterGetErrorString(void) _CUPS_PUBLIC;
+extern const unsigned char *cupsRasterGetLine(cups_raster_t *r) _CUPS_PUBLIC;
 extern bool		cupsRasterInitHeader(cups_page_header_t *h, cups_media_t *media, const char *optimize, ipp_quality_t quality, const char *intent, ipp_orient_t orientation, const char *sides, const char *type, int xdpi, int ydpi, const char *sheet_back) _CUPS_PUBLIC;
 extern cups_raster_t	*cupsRasterOpen(int fd, cups_raster_mode_t mode) _CUPS_PUBLIC;
 extern cups_raster_t	*cupsRasterOpenIO(cups_raster_cb_t iocb, void *ctx, cups_raster_mode_t mode) _CUPS_PUBLIC;
 extern bool		cupsRasterReadHeader(cups_raster_t *r, cups_page_header_t *h) _CUPS_PUBLIC;
 extern unsigned		cupsRasterReadPixels(cups_raster_t *r, unsigned char *p, unsigned len) _CUPS_PUBLIC;
+extern bool		cupsRasterSeekPage(cups_raster_t *r, unsigned page) _CUPS_PUBLIC;
+extern bool		cupsRasterSetBufferSize(cups_raster_t *r, size_t bufsize) _CUPS_PUBLIC;
+extern bool		cupsRasterSetCompressionThreads(cups_raster_t *r, size_t num_threads) _CUPS_PUBLIC;
 extern bool		cupsRasterWriteHeader(cups_raster_t *r, cups_page_header_t *h) _CUPS_PUBLIC;
 extern unsigned		cupsRasterWritePixels(cups_raster_t *r, unsigned char *p, unsigned len) _CUPS_PUBLIC;
 
@@ -1,43 +1,105 @@
 //
 // Raster benchmark program for CUPS.
 //
-// Copyright © 2021-2022 by OpenPrinting.
-// Copyright © 2007-2016 by Apple Inc.
-// Copyright © 1997-2006 by Easy Software Products.
+// Copyright © 2021-2026 by OpenPrinting.
+// Copyright © 2007-2016 by Apple Inc.
+// Copyright © 1997-2006 by Easy Software Products.
 //
 // Licensed under Apache License v2.0.  See the file "LICENSE" for more
 // information.
 //
+// Usage:
+//
+//   ./rasterbench [--json] [-b BITS] [-c COLORSPACE] [-i PASSES] [-m MODE]
+//                 [-n PAGES] [-p PATTERN] [-r DPI] [-t THREADS] [-z]
+//
 
 #include <config.h>
 #include <cups/raster.h>
+#include <cups/json.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/time.h>
-#include <signal.h>
-#include <unistd.h>
-#include <sys/wait.h>
 
 
 //
 // Constants...
 //
 
-#define TEST_WIDTH	1024
-#define TEST_HEIGHT	1024
-#define TEST_PAGES	16
-#define TEST_PASSES	20
+#define TEST_LINES	64		// Number of different lines per page
+#define TEST_MAX_PASSES	1000		// Maximum number of passes
+
+
+//
+// Local types...
+//
+
+typedef struct bench_buffer_s		// Memory buffer for raster data
+{
+  unsigned char	*data;			// Data
+  size_t	used,			// Bytes used
+		alloc,			// Bytes allocated
+		pos;			// Read position
+} bench_buffer_t;
+
+typedef struct bench_cspace_s		// Color space
+{
+  const char	*name;			// Name
+  cups_cspace_t	cspace;			// Color space
+  unsigned	num_colors;		// Number of colors
+} bench_cspace_t;
+
+typedef struct bench_mode_s		// Write mode
+{
+  const char	*name;			// Name
+  cups_raster_mode_t mode;		// Write mode
+} bench_mode_t;
+
+
+//
+// Local globals...
+//
+
+static const bench_cspace_t cspaces[] =
+{					// Color spaces
+  { "adobe-rgb", CUPS_CSPACE_ADOBERGB, 3 },
+  { "black",     CUPS_CSPACE_K,        1 },
+  { "cmyk",      CUPS_CSPACE_CMYK,     4 },
+  { "rgb",       CUPS_CSPACE_RGB,      3 },
+  { "sgray",     CUPS_CSPACE_SW,       1 },
+  { "srgb",      CUPS_CSPACE_SRGB,     3 }
+};
+
+static const bench_mode_t modes[] =
+{					// Write modes
+  { "apple", CUPS_RASTER_WRITE_APPLE },
+  { "pwg",   CUPS_RASTER_WRITE_PWG },
+  { "v2",    CUPS_RASTER_WRITE_COMPRESSED },
+  { "v3",    CUPS_RASTER_WRITE }
+};
+
+static const char * const patterns[] =
+{					// Content patterns
+  "photo",
+  "random",
+  "solid",
+  "text"
+};
 
 
 //
 // Local functions...
 //
 
-static double	compute_median(double *secs);
+static double	compute_median(double *secs, int num_secs);
 static double	get_time(void);
-static void	read_test(int fd);
-static int	run_read_test(void);
-static void	write_test(int fd, cups_raster_mode_t mode);
+static void	make_data(unsigned char *data, unsigned bpl, const char *pattern);
+static ssize_t	read_buffer(bench_buffer_t *bufptr, unsigned char *buffer, size_t length);
+static bool	read_test(bench_buffer_t *bufptr, unsigned char *line);
+static int	usage(FILE *out);
+static ssize_t	write_buffer(bench_buffer_t *bufptr, unsigned char *buffer, size_t length);
+static bool	write_test(bench_buffer_t *bufptr, cups_raster_mode_t mode, cups_page_header_t *header, unsigned pages, size_t threads, unsigned char *data);
 
 
 //
@@ -48,54 +110,249 @@ int					// O - Exit status
 main(int  argc,				// I - Number of command-line args
      char *argv[])			// I - Command-line arguments
 {
-  int		i;			// Looping var
-  int		ras_fd,			// File descriptor for read process
-		status;			// Exit status of read process
-  double	start_secs,		// Start time
-		write_secs,		// Write time
-		read_secs,		// Read time
-		pass_secs[TEST_PASSES];	// Total test times
-  cups_raster_mode_t mode;		// Write mode
+  int			i,		// Looping var
+			passes = 20;	// Number of passes
+  size_t		j;		// Looping var
+  bool			json = false;	// Produce JSON output?
+  unsigned		bits = 8,	// Bits per color
+			dpi = 0,	// Resolution
+			pages = 16;	// Number of pages
+  size_t		threads = 1;	// Number of compression threads
+  const bench_cspace_t	*cspace = cspaces + 1;
+					// Color space
+  const bench_mode_t	*mode = modes + 3;
+					// Write mode
+  const char		*pattern = "text";
+					// Content pattern
+  cups_page_header_t	header;		// Page header
+  bench_buffer_t	buffer;		// Raster data
+  unsigned char		*data,		// Lines to write
+			*line;		// Line buffer for reading
+  double		start,		// Start time
+			write_secs[TEST_MAX_PASSES],
+					// Write times
+			read_secs[TEST_MAX_PASSES],
+					// Read times
+			raw_bytes,	// Bytes of raster data per document
+			num_lines,	// Lines per document
+			write_median,	// Median write time
+			read_median;	// Median read time
+
+
+  // Parse command-line...
+  for (i = 1; i < argc; i ++)
+  {
+    if (!strcmp(argv[i], "--help"))
+    {
+      return (usage(stdout));
+    }
+    else if (!strcmp(argv[i], "--json"))
+    {
+      json = true;
+    }
+    else if (!strcmp(argv[i], "-b") && (i + 1) < argc)
+    {
+      i ++;
+      bits = (unsigned)atoi(argv[i]);
 
+      if (bits != 1 && bits != 2 && bits != 4 && bits != 8 && bits != 16)
+        return (usage(stderr));
+    }
+    else if (!strcmp(argv[i], "-c") && (i + 1) < argc)
+    {
+      i ++;
+      for (j = 0, cspace = NULL; j < (sizeof(cspaces) / sizeof(cspaces[0])); j ++)
+      {
+        if (!strcmp(argv[i], cspaces[j].name))
+          cspace = cspaces + j;
+      }
 
-  // See if we have anything on the command-line...
-  if (argc > 2 || (argc == 2 && strcmp(argv[1], "-z")))
+      if (!cspace)
+        return (usage(stderr));
+    }
+    else if (!strcmp(argv[i], "-i") && (i + 1) < argc)
+    {
+      i ++;
+      if ((passes = atoi(argv[i])) < 1 || passes > TEST_MAX_PASSES)
+        return (usage(stderr));
+    }
+    else if (!strcmp(argv[i], "-m") && (i + 1) < argc)
+    {
+      i ++;
+      for (j = 0, mode = NULL; j < (sizeof(modes) / sizeof(modes[0])); j ++)
+      {
+        if (!strcmp(argv[i], modes[j].name))
+          mode = modes + j;
+      }
+
+      if (!mode)
+        return (usage(stderr));
+    }
+    else if (!strcmp(argv[i], "-n") && (i + 1) < argc)
+    {
+      i ++;
+      if ((pages = (unsigned)atoi(argv[i])) < 1)
+        return (usage(stderr));
+    }
+    else if (!strcmp(argv[i], "-p") && (i + 1) < argc)
+    {
+      i ++;
+      for (j = 0, pattern = NULL; j < (sizeof(patterns) / sizeof(patterns[0])); j ++)
+      {
+        if (!strcmp(argv[i], patterns[j]))
+          pattern = patterns[j];
+      }
+
+      if (!pattern)
+        return (usage(stderr));
+    }
+    else if (!strcmp(argv[i], "-r") && (i + 1) < argc)
+    {
+      i ++;
+      if ((dpi = (unsigned)atoi(argv[i])) < 72 || dpi > 2400)
+        return (usage(stderr));
+    }
+    else if (!strcmp(argv[i], "-t") && (i + 1) < argc)
+    {
+      i ++;
+      if ((threads = (size_t)atoi(argv[i])) < 1)
+        return (usage(stderr));
+    }
+    else if (!strcmp(argv[i], "-z"))
+    {
+      mode = modes + 2;
+    }
+    else
+    {
+      return (usage(stderr));
+    }
+  }
+
+  if (bits < 8 && cspace->num_colors > 1)
+  {
+    fprintf(stderr, "rasterbench: %u-bit color is only supported for \"black\" and \"sgray\".\n", bits);
+    return (1);
+  }
+
+  // Set up the page header - 1024x1024 pixels or US Letter at the specified
+  // resolution...
+  memset(&header, 0, sizeof(header));
+
+  header.HWResolution[0]  = header.HWResolution[1] = dpi ? dpi : 300;
+  header.cupsWidth        = dpi ? 17 * dpi / 2 : 1024;
+  header.cupsHeight       = dpi ? 11 * dpi : 1024;
+  header.PageSize[0]      = 72 * header.cupsWidth / header.HWResolution[0];
+  header.PageSize[1]      = 72 * header.cupsHeight / header.HWResolution[1];
+  header.cupsPageSize[0]  = header.PageSize[0];
+  header.cupsPageSize[1]  = header.PageSize[1];
+  header.cupsBitsPerColor = bits;
+  header.cupsBitsPerPixel = bits * cspace->num_colors;
+  header.cupsBytesPerLine = (header.cupsWidth * header.cupsBitsPerPixel + 7) / 8;
+  header.cupsColorOrder   = CUPS_ORDER_CHUNKED;
+  header.cupsColorSpace   = cspace->cspace;
+  header.cupsNumColors    = cspace->num_colors;
+
+  cupsCopyString(header.MediaType, "stationery", sizeof(header.MediaType));
+
+  raw_bytes = (double)header.cupsBytesPerLine * header.cupsHeight * pages;
+  num_lines = (double)header.cupsHeight * pages;
+
+  // Create the raster data...
+  if ((data = malloc(TEST_LINES * header.cupsBytesPerLine)) == NULL || (line = malloc(header.cupsBytesPerLine)) == NULL)
   {
-    puts("Usage: rasterbench [-z]");
+    perror("rasterbench: Unable to allocate memory");
     return (1);
   }
 
-  mode = argc > 1 ? CUPS_RASTER_WRITE_COMPRESSED : CUPS_RASTER_WRITE;
+  make_data(data, header.cupsBytesPerLine, pattern);
 
-  // Ignore SIGPIPE...
-  signal(SIGPIPE, SIG_IGN);
+  memset(&buffer, 0, sizeof(buffer));
 
   // Run the tests several times to get a good average...
-  printf("Test read/write speed of %d pages, %dx%d pixels...\n\n", TEST_PAGES, TEST_WIDTH, TEST_HEIGHT);
-  for (i = 0; i < TEST_PASSES; i ++)
+  if (!json)
+    printf("Test %s %s_%u (%s) raster with %u pages, %ux%u pixels, %u thread(s)...\n\n", mode->name, cspace->name, bits, pattern, pages, header.cupsWidth, header.cupsHeight, (unsigned)threads);
+
+  for (i = 0; i < passes; i ++)
   {
-    printf("PASS %2d: ", i + 1);
-    fflush(stdout);
+    if (!json)
+    {
+      printf("PASS %2d: ", i + 1);
+      fflush(stdout);
+    }
 
-    ras_fd     = run_read_test();
-    start_secs = get_time();
+    start = get_time();
 
-    write_test(ras_fd, mode);
+    if (!write_test(&buffer, mode->mode, &header, pages, threads, data))
+      return (1);
 
-    write_secs = get_time();
-    printf(" %.3f write,", write_secs - start_secs);
-    fflush(stdout);
+    write_secs[i] = get_time() - start;
 
-    close(ras_fd);
-    wait(&status);
+    start = get_time();
 
-    read_secs    = get_time();
-    pass_secs[i] = read_secs - start_secs;
-    printf(" %.3f read, %.3f total\n", read_secs - write_secs, pass_secs[i]);
+    if (!read_test(&buffer, line))
+      return (1);
+
+    read_secs[i] = get_time() - start;
+
+    if (!json)
+      printf(" %.3f write, %.3f read\n", write_secs[i], read_secs[i]);
   }
 
-  printf("\nMedian Total Time: %.3f seconds per document\n",
-         compute_median(pass_secs));
+  write_median = compute_median(write_secs, passes);
+  read_median  = compute_median(read_secs, passes);
+
+  if (json)
+  {
+    cups_json_t	*results,		// Results object
+		*current = NULL;	// Current value
+    char	*s;			// JSON string
+
+    results = cupsJSONNew(NULL, NULL, CUPS_JTYPE_OBJECT);
+
+#define ADD_NUMBER(k,v) current = cupsJSONNewNumber(results, cupsJSONNewKey(results, current, k), v)
+#define ADD_STRING(k,v) current = cupsJSONNewString(results, cupsJSONNewKey(results, current, k), v)
+
+    ADD_STRING("mode", mode->name);
+    ADD_STRING("color-space", cspace->name);
+    ADD_NUMBER("bits-per-color", bits);
+    ADD_STRING("pattern", pattern);
+    ADD_NUMBER("threads", threads);
+    ADD_NUMBER("resolution", header.HWResolution[0]);
+    ADD_NUMBER("width", header.cupsWidth);
+    ADD_NUMBER("height", header.cupsHeight);
+    ADD_NUMBER("pages", pages);
+    ADD_NUMBER("passes", passes);
+    ADD_NUMBER("bytes", raw_bytes);
+    ADD_NUMBER("compressed-bytes", buffer.used);
+    ADD_NUMBER("compression-ratio", raw_bytes / buffer.used);
+    ADD_NUMBER("write-seconds", write_median);
+    ADD_NUMBER("write-mbytes-per-second", raw_bytes / write_median / 1048576.0);
+    ADD_NUMBER("write-lines-per-second", num_lines / write_median);
+    ADD_NUMBER("read-seconds", read_median);
+    ADD_NUMBER("read-mbytes-per-second", raw_bytes / read_median / 1048576.0);
+    ADD_NUMBER("read-lines-per-second", num_lines / read_median);
+
+#undef ADD_NUMBER
+#undef ADD_STRING
+
+    if ((s = cupsJSONExportString(results)) != NULL)
+    {
+      puts(s);
+      free(s);
+    }
+
+    cupsJSONDelete(results);
+  }
+  else
+  {
+    printf("\nMedian Write Time: %.3f seconds per document, %.1f MB/s, %.0f lines/s\n", write_median, raw_bytes / write_median / 1048576.0, num_lines / write_median);
+    printf("Median Read Time: %.3f seconds per document, %.1f MB/s, %.0f lines/s\n", read_median, raw_bytes / read_median / 1048576.0, num_lines / read_median);
+    printf("Compression Ratio: %.2f (%.0f bytes per document)\n", raw_bytes / buffer.used, (double)buffer.used);
+  }
+
+  free(buffer.data);
+  free(data);
+  free(line);
 
   return (0);
 }
@@ -106,16 +363,17 @@ main(int  argc,				// I - Number of command-line args
 //
 
 static double				// O - Median time in seconds
-compute_median(double *secs)		// I - Array of time samples
+compute_median(double *secs,		// I - Array of time samples
+               int    num_secs)		// I - Number of samples
 {
   int		i, j;			// Looping vars
   double	temp;			// Swap variable
 
 
   // Sort the array into ascending order using a quicky bubble sort...
-  for (i = 0; i < (TEST_PASSES - 1); i ++)
+  for (i = 0; i < (num_secs - 1); i ++)
   {
-    for (j = i + 1; j < TEST_PASSES; j ++)
+    for (j = i + 1; j < num_secs; j ++)
     {
       if (secs[i] > secs[j])
       {
@@ -126,8 +384,11 @@ compute_median(double *secs)		// I - Array of time samples
     }
   }
 
-  // Return the average of the middle two samples...
-  return (0.5 * (secs[TEST_PASSES / 2 - 1] + secs[TEST_PASSES / 2]));
+  // Return the middle sample or the average of the middle two samples...
+  if (num_secs & 1)
+    return (secs[num_secs / 2]);
+  else
+    return (0.5 * (secs[num_secs / 2 - 1] + secs[num_secs / 2]));
 }
 
 
@@ -147,156 +408,239 @@ get_time(void)
 
 
 //
-// 'read_test()' - Benchmark the raster read functions.
+// 'make_data()' - Create raster data for the benchmarks.
+//
+// The "solid" pattern uses the same value for every byte, "photo" uses smooth
+// gradients with some noise, "random" uses random bytes, and "text" uses a
+// combination of random data and repeated data to simulate text with some
+// whitespace.
 //
 
 static void
-read_test(int fd)			// I - File descriptor to read from
+make_data(unsigned char *data,		// I - Lines of raster data
+          unsigned      bpl,		// I - Bytes per line
+          const char    *pattern)	// I - Content pattern
+{
+  unsigned	x, y;			// Looping vars
+  unsigned	count;			// Number of bytes to set
+  unsigned char	*line;			// Current line
+
+
+  if (!strcmp(pattern, "solid"))
+  {
+    memset(data, 0x80, TEST_LINES * bpl);
+    return;
+  }
+
+  memset(data, 0, TEST_LINES * bpl);
+
+  for (y = 0, line = data; y < TEST_LINES; y ++, line += bpl)
+  {
+    if (!strcmp(pattern, "photo"))
+    {
+      for (x = 0; x < bpl; x ++)
+        line[x] = (unsigned char)(x / 16 + 2 * y + ((cupsGetRand() & 7) == 0 ? cupsGetRand() & 3 : 0));
+    }
+    else if (!strcmp(pattern, "random"))
+    {
+      for (x = 0; x < bpl; x ++)
+        line[x] = (unsigned char)cupsGetRand();
+    }
+    else if ((y & 31) < 28)
+    {
+      for (x = cupsGetRand() & 127, count = (cupsGetRand() & 15) + 1; x < bpl; x ++, count --)
+      {
+	if (count == 0)
+	{
+	  x     += (cupsGetRand() & 15) + 1;
+	  count = (cupsGetRand() & 15) + 1;
+
+	  if (x >= bpl)
+	    break;
+	}
+
+	line[x] = (unsigned char)cupsGetRand();
+      }
+    }
+  }
+}
+
+
+//
+// 'read_buffer()' - Read raster data from a memory buffer.
+//
+
+static ssize_t				// O - Bytes read
+read_buffer(bench_buffer_t *bufptr,	// I - Memory buffer
+            unsigned char  *buffer,	// I - Read buffer
+            size_t         length)	// I - Maximum number of bytes to read
+{
+  if (length > (bufptr->used - bufptr->pos))
+    length = bufptr->used - bufptr->pos;
+
+  memcpy(buffer, bufptr->data + bufptr->pos, length);
+  bufptr->pos += length;
+
+  return ((ssize_t)length);
+}
+
+
+//
+// 'read_test()' - Benchmark the raster read functions.
+//
+
+static bool				// O - `true` on success, `false` on error
+read_test(bench_buffer_t *bufptr,	// I - Raster data
+          unsigned char  *line)		// I - Line buffer
 {
   unsigned		y;		// Looping var
   cups_raster_t		*r;		// Raster stream
   cups_page_header_t	header;		// Page header
-  unsigned char		buffer[8 * TEST_WIDTH];
-					// Read buffer
 
 
-  // Test read speed...
-  if ((r = cupsRasterOpen(fd, CUPS_RASTER_READ)) == NULL)
+  bufptr->pos = 0;
+
+  if ((r = cupsRasterOpenIO((cups_raster_cb_t)read_buffer, bufptr, CUPS_RASTER_READ)) == NULL)
   {
-    perror("Unable to create raster input stream");
-    return;
+    fprintf(stderr, "rasterbench: Unable to create raster input stream: %s\n", cupsRasterGetErrorString());
+    return (false);
   }
 
   while (cupsRasterReadHeader(r, &header))
   {
     for (y = 0; y < header.cupsHeight; y ++)
-      cupsRasterReadPixels(r, buffer, header.cupsBytesPerLine);
+      cupsRasterReadPixels(r, line, header.cupsBytesPerLine);
   }
 
   cupsRasterClose(r);
+
+  return (true);
 }
 
 
 //
-// 'run_read_test()' - Run the read test as a child process via pipes.
+// 'usage()' - Show program usage.
 //
 
-static int				// O - Standard input of child
-run_read_test(void)
+static int				// O - Exit status
+usage(FILE *out)			// I - Output file
 {
-  int	ras_pipes[2];			// Raster data pipes
-  int	pid;				// Child process ID
+  fputs("Usage: rasterbench [OPTIONS]\n", out);
+  fputs("Options:\n", out);
+  fputs("  --help        Show program help.\n", out);
+  fputs("  --json        Produce JSON output for regression tracking.\n", out);
+  fputs("  -b BITS       Set the bits per color - 1, 2, 4, 8 (default), or 16.\n", out);
+  fputs("  -c COLORSPACE Set the color space - adobe-rgb, black (default), cmyk, rgb,\n"
+        "                sgray, or srgb.\n", out);
+  fputs("  -i PASSES     Set the number of passes (default 20).\n", out);
+  fputs("  -m MODE       Set the write mode - apple, pwg, v2 (compressed CUPS), or\n"
+        "                v3 (uncompressed CUPS, default).\n", out);
+  fputs("  -n PAGES      Set the number of pages (default 16).\n", out);
+  fputs("  -p PATTERN    Set the content pattern - photo, random, solid, or text\n"
+        "                (default).\n", out);
+  fputs("  -r DPI        Use US Letter pages at the specified resolution instead of\n"
+        "                1024x1024 pixels.\n", out);
+  fputs("  -t THREADS    Set the number of compression threads (default 1).\n", out);
+  fputs("  -z            Same as \"-m v2\".\n", out);
+
+  return (out == stdout ? 0 : 1);
+}
 
 
-  if (pipe(ras_pipes))
-    return (-1);
+//
+// 'write_buffer()' - Write raster data to a memory buffer.
+//
 
-  if ((pid = fork()) < 0)
+static ssize_t				// O - Bytes written or -1 on error
+write_buffer(bench_buffer_t *bufptr,	// I - Memory buffer
+             unsigned char  *buffer,	// I - Bytes to write
+             size_t         length)	// I - Number of bytes to write
+{
+  if ((bufptr->used + length) > bufptr->alloc)
   {
-    // Fork error - return -1 on error...
-    close(ras_pipes[0]);
-    close(ras_pipes[1]);
+    size_t	alloc = 2 * (bufptr->used + length);
+					// New size
+    unsigned char *data = realloc(bufptr->data, alloc);
+					// New buffer
 
-    return (-1);
-  }
-  else if (pid == 0)
-  {
-    // Child comes here - read data from the input pipe...
-    close(ras_pipes[1]);
-    read_test(ras_pipes[0]);
-    exit(0);
-  }
-  else
-  {
-    // Parent comes here - return the output pipe...
-    close(ras_pipes[0]);
-    return (ras_pipes[1]);
+    if (!data)
+      return (-1);
+
+    bufptr->data  = data;
+    bufptr->alloc = alloc;
   }
+
+  memcpy(bufptr->data + bufptr->used, buffer, length);
+  bufptr->used += length;
+
+  return ((ssize_t)length);
 }
 
 
 //
 // 'write_test()' - Benchmark the raster write functions.
 //
+// Lines are written one at a time, or in bands of up to 64 lines when using
+// multiple compression threads.
+//
 
-static void
-write_test(int                fd,	// I - File descriptor to write to
-           cups_raster_mode_t mode)	// I - Write mode
+static bool				// O - `true` on success, `false` on error
+write_test(
+    bench_buffer_t     *bufptr,		// I - Memory buffer
+    cups_raster_mode_t mode,		// I - Write mode
+    cups_page_header_t *header,		// I - Page header
+    unsigned           pages,		// I - Number of pages
+    size_t             threads,		// I - Number of compression threads
+    unsigned char      *data)		// I - Lines of raster data
 {
-  unsigned		page, x, y;	// Looping vars
-  unsigned		count;		// Number of bytes to set
+  unsigned		page, y,	// Looping vars
+			count;		// Number of lines to write
   cups_raster_t		*r;		// Raster stream
-  cups_page_header_t	header;		// Page header
-  unsigned char		data[32][8 * TEST_WIDTH];
-					// Raster data to write
 
 
-  // Create a combination of random data and repeated data to simulate
-  // text with some whitespace.
-  memset(data, 0, sizeof(data));
+  bufptr->used = 0;
 
-  for (y = 0; y < 28; y ++)
+  if ((r = cupsRasterOpenIO((cups_raster_cb_t)write_buffer, bufptr, mode)) == NULL)
   {
-    for (x = cupsGetRand() & 127, count = (cupsGetRand() & 15) + 1;
-         x < sizeof(data[0]);
-         x ++, count --)
-    {
-      if (count <= 0)
-      {
-	x     += (cupsGetRand() & 15) + 1;
-	count = (cupsGetRand() & 15) + 1;
-
-        if (x >= sizeof(data[0]))
-	  break;
-      }
-
-      data[y][x] = (unsigned char)cupsGetRand();
-    }
+    fprintf(stderr, "rasterbench: Unable to create raster output stream: %s\n", cupsRasterGetErrorString());
+    return (false);
   }
 
-  // Test write speed...
-  if ((r = cupsRasterOpen(fd, mode)) == NULL)
+  if (threads > 1 && !cupsRasterSetCompressionThreads(r, threads))
   {
-    perror("Unable to create raster output stream");
-    return;
+    fputs("rasterbench: Unable to set the number of compression threads.\n", stderr);
+    cupsRasterClose(r);
+    return (false);
   }
 
-  for (page = 0; page < TEST_PAGES; page ++)
+  for (page = 0; page < pages; page ++)
   {
-    memset(&header, 0, sizeof(header));
-    header.cupsWidth        = TEST_WIDTH;
-    header.cupsHeight       = TEST_HEIGHT;
-    header.cupsBytesPerLine = TEST_WIDTH;
-
-    if (page & 1)
+    if (!cupsRasterWriteHeader(r, header))
     {
-      header.cupsBytesPerLine *= 4;
-      header.cupsColorSpace = CUPS_CSPACE_CMYK;
-      header.cupsColorOrder = CUPS_ORDER_CHUNKED;
-    }
-    else
-    {
-      header.cupsColorSpace = CUPS_CSPACE_K;
-      header.cupsColorOrder = CUPS_ORDER_BANDED;
+      fprintf(stderr, "rasterbench: Unable to write page header: %s\n", cupsRasterGetErrorString());
+      cupsRasterClose(r);
+      return (false);
     }
 
-    if (page & 2)
+    for (y = 0; y < header->cupsHeight; y += count)
     {
-      header.cupsBytesPerLine *= 2;
-      header.cupsBitsPerColor = 16;
-      header.cupsBitsPerPixel = (page & 1) ? 64 : 16;
-    }
-    else
-    {
-      header.cupsBitsPerColor = 8;
-      header.cupsBitsPerPixel = (page & 1) ? 32 : 8;
-    }
+      if (threads > 1)
+      {
+        if ((count = header->cupsHeight - y) > TEST_LINES)
+          count = TEST_LINES;
 
-    cupsRasterWriteHeader(r, &header);
+        cupsRasterWritePixels(r, data, count * header->cupsBytesPerLine);
+      }
+      else
+      {
+        count = 1;
 
-    for (y = 0; y < TEST_HEIGHT; y ++)
-      cupsRasterWritePixels(r, data[y & 31], header.cupsBytesPerLine);
+        cupsRasterWritePixels(r, data + (y % TEST_LINES) * header->cupsBytesPerLine, header->cupsBytesPerLine);
+      }
+    }
   }
 
   cupsRasterClose(r);
+
+  return (true);
 }
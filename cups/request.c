@@ -20,9 +20,48 @@
 #ifndef O_BINARY
 #  define O_BINARY 0
 #endif // O_BINARY
-#ifndef MSG_DONTWAIT
-#  define MSG_DONTWAIT 0
-#endif // !MSG_DONTWAIT
+
+
+//
+// Local constants...
+//
+
+#define _CUPS_MAX_PIPELINE	16	// Maximum number of pipelined requests
+
+
+//
+// Local types...
+//
+
+typedef struct _cups_async_s		// Asynchronous request
+{
+  ipp_t			*request;	// IPP request
+  char			resource[HTTP_MAX_URI];
+					// HTTP resource for POST
+  cups_response_cb_t	cb;		// Response callback
+  void			*cb_data;	// Callback data
+} _cups_async_t;
+
+typedef struct _cups_stream_s		// Streaming response
+{
+  ipp_stream_cb_t	cb;		// Attribute callback
+  void			*cb_data;	// Callback data
+  bool			stopped;	// Did the callback stop reading?
+  char			message[256];	// Streamed "status-message" value
+} _cups_stream_t;
+
+
+//
+// Local functions...
+//
+
+static bool		cups_async_cb(http_loop_t *loop, http_t *http, http_loop_events_t events, _cups_async_t *async);
+static bool		cups_async_send(http_t *http, _cups_async_t *async);
+static http_status_t	cups_check_response(http_t *http);
+static ipp_t		*cups_do_request(http_t *http, ipp_t *request, const char *resource, int infile, int outfile, ipp_stream_cb_t stream_cb, void *stream_data);
+static ipp_t		*cups_get_response(http_t *http, const char *resource, ipp_stream_cb_t stream_cb, void *stream_data);
+static bool		cups_send_pipelined(http_t *http, ipp_t *request, const char *resource);
+static bool		cups_stream_cb(_cups_stream_t *stream, ipp_tag_t group, ipp_attribute_t *attr);
 
 
 //
@@ -92,159 +131,148 @@ cupsDoIORequest(http_t     *http,	// I - Connection to server or `CUPS_HTTP_DEFA
 		int        infile,	// I - File to read from or `-1` for none
 		int        outfile)	// I - File to write to or `-1` for none
 {
-  ipp_t		*response = NULL;	// IPP response data
-  size_t	length = 0;		// Content-Length value
-  http_status_t	status;			// Status of HTTP request
-  struct stat	fileinfo;		// File information
-  ssize_t	bytes;			// Number of bytes read/written
-  char		buffer[32768];		// Output buffer
-
-
   DEBUG_printf("cupsDoIORequest(http=%p, request=%p(%s), resource=\"%s\", infile=%d, outfile=%d)", (void *)http, (void *)request, request ? ippOpString(request->request.op.operation_id) : "?", resource, infile, outfile);
 
-  // Range check input...
-  if (!request || !resource)
-  {
-    ippDelete(request);
+  return (cups_do_request(http, request, resource, infile, outfile, NULL, NULL));
+}
 
-    _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(EINVAL), false);
 
-    return (NULL);
-  }
+//
+// 'cupsDoRequest()' - Do an IPP request.
+//
+// This function sends the IPP request to the specified server, retrying
+// and authenticating as necessary.  The request is freed with @link ippDelete@.
+//
 
-  // Get the default connection as needed...
-  if (!http && (http = _cupsConnect()) == NULL)
-  {
-    ippDelete(request);
+ipp_t *					// O - Response data
+cupsDoRequest(http_t     *http,		// I - Connection to server or `CUPS_HTTP_DEFAULT`
+              ipp_t      *request,	// I - IPP request
+              const char *resource)	// I - HTTP resource for POST
+{
+  DEBUG_printf("cupsDoRequest(http=%p, request=%p(%s), resource=\"%s\")", (void *)http, (void *)request, request ? ippOpString(request->request.op.operation_id) : "?", resource);
 
-    return (NULL);
-  }
+  return (cupsDoIORequest(http, request, resource, -1, -1));
+}
 
-  // See if we have a file to send...
-  if (infile >= 0)
-  {
-    if (fstat(infile, &fileinfo))
-    {
-      // Can't get file information!
-      _cupsSetError(errno == EBADF ? IPP_STATUS_ERROR_NOT_FOUND : IPP_STATUS_ERROR_NOT_AUTHORIZED, NULL, false);
-      ippDelete(request);
 
-      return (NULL);
-    }
+//
+// 'cupsDoRequests()' - Do several IPP requests over one connection.
+//
+// This function sends the IPP requests in the "requests" array to the
+// specified server and stores the corresponding responses (or `NULL` on error)
+// in the "responses" array.  After the first request succeeds, the remaining
+// requests are pipelined - up to 16 requests are sent before their responses
+// are read - which avoids waiting a full round trip for each request.  If the
+// server does not support persistent connections or closes the connection,
+// any unanswered requests are sent again one at a time using
+// @link cupsDoRequest@.
+//
+// Since a request may be sent a second time, only pipeline requests that can
+// safely be repeated, such as Get-Job-Attributes or Get-Printer-Attributes.
+// The requests are freed with @link ippDelete@.
+//
 
-#ifdef _WIN32
-    if (fileinfo.st_mode & _S_IFDIR)
-#else
-    if (S_ISDIR(fileinfo.st_mode))
-#endif // _WIN32
-    {
-      // Can't send a directory...
-      _cupsSetError(IPP_STATUS_ERROR_NOT_POSSIBLE, strerror(EISDIR), false);
-      ippDelete(request);
+size_t					// O - Number of responses
+cupsDoRequests(
+    http_t     *http,			// I - Connection to server or `CUPS_HTTP_DEFAULT`
+    size_t     num_requests,		// I - Number of requests
+    ipp_t      **requests,		// I - IPP requests
+    const char *resource,		// I - HTTP resource for POST
+    ipp_t      **responses)		// O - IPP responses
+{
+  size_t	i,			// Looping var
+		sent,			// Number of requests sent
+		received,		// Number of responses received
+		count = 0;		// Number of responses
+  bool		send_error = false;	// Did a pipelined send fail?
 
-      return (NULL);
-    }
 
-#ifndef _WIN32
-    if (!S_ISREG(fileinfo.st_mode))
-      length = 0;			// Chunk when piping
-    else
-#endif // !_WIN32
-    length = ippGetLength(request) + (size_t)fileinfo.st_size;
-  }
-  else
+  DEBUG_printf("cupsDoRequests(http=%p, num_requests=%u, requests=%p, resource=\"%s\", responses=%p)", (void *)http, (unsigned)num_requests, (void *)requests, resource, (void *)responses);
+
+  // Range check input...
+  if (!requests || !resource || !responses)
   {
-    length = ippGetLength(request);
-  }
+    for (i = 0; requests && i < num_requests; i ++)
+      ippDelete(requests[i]);
 
-  DEBUG_printf("2cupsDoIORequest: Request length=%ld, total length=%ld", (long)ippGetLength(request), (long)length);
+    _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(EINVAL), false);
 
-  // Clear any "Local" authentication data since it is probably stale...
-  if (http->authstring && !strncmp(http->authstring, "Local ", 6))
-    httpSetAuthString(http, NULL, NULL);
+    return (0);
+  }
 
-  // Loop until we can send the request without authorization problems.
-  while (response == NULL)
-  {
-    DEBUG_puts("2cupsDoIORequest: setup...");
+  memset(responses, 0, num_requests * sizeof(ipp_t *));
 
-    // Send the request...
-    status = cupsSendRequest(http, request, resource, length);
+  // Get the default connection as needed...
+  if (!http && (http = _cupsConnect()) == NULL)
+  {
+    for (i = 0; i < num_requests; i ++)
+      ippDelete(requests[i]);
 
-    DEBUG_printf("2cupsDoIORequest: status=%d", status);
+    return (0);
+  }
 
-    if (status == HTTP_STATUS_CONTINUE && request->state == IPP_STATE_DATA && infile >= 0)
-    {
-      DEBUG_puts("2cupsDoIORequest: file write...");
+  // Send the first request normally to handle authentication and encryption,
+  // then pipeline the rest if the server keeps the connection open...
+  sent = received = 0;
 
-      // Send the file with the request...
-#ifndef _WIN32
-      if (S_ISREG(fileinfo.st_mode))
-#endif // _WIN32
-      lseek(infile, 0, SEEK_SET);
+  if (num_requests > 0)
+  {
+    responses[0] = cupsDoRequest(http, requests[0], resource);
+    sent         = received = 1;
 
-      while ((bytes = read(infile, buffer, sizeof(buffer))) > 0)
+    if (responses[0] && http->state == HTTP_STATE_WAITING && http->version >= HTTP_VERSION_1_1 && _cups_strcasecmp(httpGetField(http, HTTP_FIELD_CONNECTION), "close") && (!http->authstring || strncmp(http->authstring, "Digest ", 7)))
+    {
+      for (; received < num_requests; received ++)
       {
-        if ((status = cupsWriteRequestData(http, buffer, (size_t)bytes))
-                != HTTP_STATUS_CONTINUE)
-	  break;
+        // Keep up to _CUPS_MAX_PIPELINE requests in flight...
+        while (!send_error && sent < num_requests && (sent - received) < _CUPS_MAX_PIPELINE)
+        {
+          if (!cups_send_pipelined(http, requests[sent], resource))
+            send_error = true;
+          else
+            sent ++;
+        }
+
+        if (received >= sent)
+          break;
+
+        // Read the next response...
+        http->state = HTTP_STATE_POST_SEND;
+
+        if ((responses[received] = cupsGetResponse(http, resource)) == NULL)
+          break;
+
+        ippDelete(requests[received]);
+
+        if (http->version < HTTP_VERSION_1_1 || !_cups_strcasecmp(httpGetField(http, HTTP_FIELD_CONNECTION), "close"))
+        {
+          // Server won't answer any more requests on this connection...
+          received ++;
+          break;
+	}
       }
-    }
-
-    // Get the server's response...
-    if (status <= HTTP_STATUS_CONTINUE || status == HTTP_STATUS_OK)
-    {
-      response = cupsGetResponse(http, resource);
-      status   = httpGetStatus(http);
-    }
 
-    DEBUG_printf("2cupsDoIORequest: status=%d", status);
-
-    if (status == HTTP_STATUS_ERROR || (status >= HTTP_STATUS_BAD_REQUEST && status != HTTP_STATUS_UNAUTHORIZED && status != HTTP_STATUS_UPGRADE_REQUIRED))
-    {
-      _cupsSetHTTPError(status);
-      break;
-    }
+      DEBUG_printf("2cupsDoRequests: Pipelined %u requests, %u responses.", (unsigned)(sent - 1), (unsigned)(received - 1));
 
-    if (response && outfile >= 0)
-    {
-      // Write trailing data to file...
-      while ((bytes = httpRead(http, buffer, sizeof(buffer))) > 0)
+      if (received < sent || send_error)
       {
-	if (write(outfile, buffer, (size_t)bytes) < bytes)
-	  break;
+        // Discard any unanswered requests on this connection and start over...
+        httpReconnect(http, 30000, NULL);
       }
     }
-
-    if (http->state != HTTP_STATE_WAITING)
-    {
-      // Flush any remaining data...
-      httpFlush(http);
-    }
   }
 
-  // Delete the original request and return the response...
-  ippDelete(request);
-
-  return (response);
-}
-
-
-//
-// 'cupsDoRequest()' - Do an IPP request.
-//
-// This function sends the IPP request to the specified server, retrying
-// and authenticating as necessary.  The request is freed with @link ippDelete@.
-//
+  // Send any remaining requests one at a time...
+  for (i = received; i < num_requests; i ++)
+    responses[i] = cupsDoRequest(http, requests[i], resource);
 
-ipp_t *					// O - Response data
-cupsDoRequest(http_t     *http,		// I - Connection to server or `CUPS_HTTP_DEFAULT`
-              ipp_t      *request,	// I - IPP request
-              const char *resource)	// I - HTTP resource for POST
-{
-  DEBUG_printf("cupsDoRequest(http=%p, request=%p(%s), resource=\"%s\")", (void *)http, (void *)request, request ? ippOpString(request->request.op.operation_id) : "?", resource);
+  for (i = 0; i < num_requests; i ++)
+  {
+    if (responses[i])
+      count ++;
+  }
 
-  return (cupsDoIORequest(http, request, resource, -1, -1));
+  return (count);
 }
 
 
@@ -261,188 +289,67 @@ ipp_t *					// O - Response or `NULL` on HTTP error
 cupsGetResponse(http_t     *http,	// I - Connection to server or `CUPS_HTTP_DEFAULT`
                 const char *resource)	// I - HTTP resource for POST
 {
-  http_status_t	status;			// HTTP status
-  ipp_state_t	state;			// IPP read state
-  ipp_t		*response = NULL;	// IPP response
+  DEBUG_printf("cupsGetResponse(http=%p, resource=\"%s\")", (void *)http, resource);
 
+  return (cups_get_response(http, resource, NULL, NULL));
+}
 
-  DEBUG_printf("cupsGetResponse(http=%p, resource=\"%s\")", (void *)http, resource);
-  DEBUG_printf("1cupsGetResponse: http->state=%d", http ? http->state : HTTP_STATE_ERROR);
 
-  // Connect to the default server as needed...
-  if (!http)
-  {
-    _cups_globals_t *cg = _cupsGlobals();
-					// Pointer to library globals
+//
+// 'cupsGetError()' - Return the last IPP status code received on the current
+//                     thread.
+//
 
-    if ((http = cg->http) == NULL)
-    {
-      _cupsSetError(IPP_STATUS_ERROR_INTERNAL, _("No active connection."), true);
-      DEBUG_puts("1cupsGetResponse: No active connection - returning NULL.");
-      return (NULL);
-    }
-  }
+ipp_status_t				// O - IPP status code from last request
+cupsGetError(void)
+{
+  return (_cupsGlobals()->last_error);
+}
 
-  if (http->state != HTTP_STATE_POST_RECV && http->state != HTTP_STATE_POST_SEND)
-  {
-    _cupsSetError(IPP_STATUS_ERROR_INTERNAL, _("No request sent."), true);
-    DEBUG_puts("1cupsGetResponse: Not in POST state - returning NULL.");
-    return (NULL);
-  }
 
-  // Check for an unfinished chunked request...
-  if (http->data_encoding == HTTP_ENCODING_CHUNKED)
-  {
-    // Send a 0-length chunk to finish off the request...
-    DEBUG_puts("2cupsGetResponse: Finishing chunked POST...");
+//
+// 'cupsGetErrorString()' - Return the last IPP status-message received on the
+//                           current thread.
+//
 
-    if (httpWrite(http, "", 0) < 0)
-    {
-      _cupsSetError(IPP_STATUS_ERROR_INTERNAL, _("Unable to finish request."), true);
-      return (NULL);
-    }
-  }
+const char *				// O - "status-message" text from last request
+cupsGetErrorString(void)
+{
+  return (_cupsGlobals()->last_status_message);
+}
 
-  // Wait for a response from the server...
-  DEBUG_printf("2cupsGetResponse: Update loop, http->status=%d...", http->status);
 
-  do
-  {
-    status = httpUpdate(http);
-  }
-  while (status == HTTP_STATUS_CONTINUE);
+//
+// 'cupsReadResponseData()' - Read additional data after the IPP response.
+//
+// This function is used after @link cupsGetResponse@ to read any trailing
+// document data after an IPP response.
+//
 
-  DEBUG_printf("2cupsGetResponse: status=%d", status);
+ssize_t					// O - Bytes read, 0 on EOF, -1 on error
+cupsReadResponseData(
+    http_t *http,			// I - Connection to server or `CUPS_HTTP_DEFAULT`
+    char   *buffer,			// I - Buffer to use
+    size_t length)			// I - Number of bytes to read
+{
+  // Get the default connection as needed...
+  DEBUG_printf("cupsReadResponseData(http=%p, buffer=%p, length=" CUPS_LLFMT ")", (void *)http, (void *)buffer, CUPS_LLCAST length);
 
-  if (status == HTTP_STATUS_OK)
+  if (!http)
   {
-    // Get the IPP response...
-    response = ippNew();
+    _cups_globals_t *cg = _cupsGlobals();
+					// Pointer to library globals
 
-    while ((state = ippRead(http, response)) != IPP_STATE_DATA)
+    if ((http = cg->http) == NULL)
     {
-      if (state == IPP_STATE_ERROR)
-	break;
+      _cupsSetError(IPP_STATUS_ERROR_INTERNAL, _("No active connection"), true);
+      return (-1);
     }
+  }
 
-    if (state == IPP_STATE_ERROR)
-    {
-      // Flush remaining data and delete the response...
-      _cupsSetError(IPP_STATUS_ERROR_INTERNAL, _("Unable to read response."), true);
-      DEBUG_puts("1cupsGetResponse: IPP read error!");
-
-      httpFlush(http);
-
-      ippDelete(response);
-      response = NULL;
-
-      http->status = HTTP_STATUS_ERROR;
-      http->error  = EINVAL;
-    }
-  }
-  else if (status != HTTP_STATUS_ERROR)
-  {
-    // Flush any error message...
-    httpFlush(http);
-
-    _cupsSetHTTPError(status);
-
-    // Then handle encryption and authentication...
-    if (status == HTTP_STATUS_UNAUTHORIZED)
-    {
-      // See if we can do authentication...
-      DEBUG_puts("2cupsGetResponse: Need authorization...");
-
-      if (cupsDoAuthentication(http, "POST", resource))
-      {
-        if (!httpReconnect(http, 30000, NULL))
-          http->status = HTTP_STATUS_ERROR;
-      }
-      else
-      {
-        http->status = HTTP_STATUS_CUPS_AUTHORIZATION_CANCELED;
-      }
-    }
-    else if (status == HTTP_STATUS_UPGRADE_REQUIRED)
-    {
-      // Force a reconnect with encryption...
-      DEBUG_puts("2cupsGetResponse: Need encryption...");
-
-      if (httpReconnect(http, 30000, NULL))
-        httpSetEncryption(http, HTTP_ENCRYPTION_REQUIRED);
-    }
-  }
-
-  if (response)
-  {
-    ipp_attribute_t	*attr;		// status-message attribute
-
-    attr = ippFindAttribute(response, "status-message", IPP_TAG_TEXT);
-
-    DEBUG_printf("1cupsGetResponse: status-code=%s, status-message=\"%s\"", ippErrorString(response->request.status.status_code), attr ? attr->values[0].string.text : "");
-
-    _cupsSetError(response->request.status.status_code, attr ? attr->values[0].string.text : ippErrorString(response->request.status.status_code), false);
-  }
-
-  return (response);
-}
-
-
-//
-// 'cupsGetError()' - Return the last IPP status code received on the current
-//                     thread.
-//
-
-ipp_status_t				// O - IPP status code from last request
-cupsGetError(void)
-{
-  return (_cupsGlobals()->last_error);
-}
-
-
-//
-// 'cupsGetErrorString()' - Return the last IPP status-message received on the
-//                           current thread.
-//
-
-const char *				// O - "status-message" text from last request
-cupsGetErrorString(void)
-{
-  return (_cupsGlobals()->last_status_message);
-}
-
-
-//
-// 'cupsReadResponseData()' - Read additional data after the IPP response.
-//
-// This function is used after @link cupsGetResponse@ to read any trailing
-// document data after an IPP response.
-//
-
-ssize_t					// O - Bytes read, 0 on EOF, -1 on error
-cupsReadResponseData(
-    http_t *http,			// I - Connection to server or `CUPS_HTTP_DEFAULT`
-    char   *buffer,			// I - Buffer to use
-    size_t length)			// I - Number of bytes to read
-{
-  // Get the default connection as needed...
-  DEBUG_printf("cupsReadResponseData(http=%p, buffer=%p, length=" CUPS_LLFMT ")", (void *)http, (void *)buffer, CUPS_LLCAST length);
-
-  if (!http)
-  {
-    _cups_globals_t *cg = _cupsGlobals();
-					// Pointer to library globals
-
-    if ((http = cg->http) == NULL)
-    {
-      _cupsSetError(IPP_STATUS_ERROR_INTERNAL, _("No active connection"), true);
-      return (-1);
-    }
-  }
-
-  // Then read from the HTTP connection...
-  return (httpRead(http, buffer, length));
-}
+  // Then read from the HTTP connection...
+  return (httpRead(http, buffer, length));
+}
 
 
 //
@@ -523,6 +430,9 @@ cupsSendRequest(http_t     *http,	// I - Connection to server or `CUPS_HTTP_DEFA
     }
   }
 
+  // Use any cached authentication for the server...
+  _cupsSetCachedAuth(http, "POST", resource);
+
   // Loop until we can send the request without authorization problems.
   expect = HTTP_STATUS_CONTINUE;
 
@@ -703,6 +613,92 @@ cupsSendRequest(http_t     *http,	// I - Connection to server or `CUPS_HTTP_DEFA
 }
 
 
+//
+// 'cupsSendRequestAsync()' - Send an IPP request and get the response from an
+//                            event loop.
+//
+// This function sends the IPP request to the specified server and adds the
+// connection to the event loop, which calls the "cb" function with the
+// response once it has been received.  The callback receives `NULL` for the
+// response on error, with the error available from @link cupsGetError@ and
+// @link cupsGetErrorString@, and must free a non-`NULL` response with
+// @link ippDelete@.  The request is freed with @link ippDelete@.
+//
+// Authentication (HTTP status 401) and encryption upgrades (HTTP status 426)
+// are handled as for @link cupsDoRequest@ by sending the request again from
+// the event loop.  Waiting for the response does not block, however
+// connecting, authenticating, and reading the response once it starts to
+// arrive use the connection's normal blocking behavior and timeouts.
+//
+// Only one asynchronous request can be outstanding on a connection at a time -
+// use one connection per outstanding request.  The callback can send another
+// request on the same connection.
+//
+
+bool					// O - `true` if the request was sent, `false` on error
+cupsSendRequestAsync(
+    http_loop_t        *loop,		// I - Event loop
+    http_t             *http,		// I - Connection to server or `CUPS_HTTP_DEFAULT`
+    ipp_t              *request,	// I - IPP request
+    const char         *resource,	// I - HTTP resource for POST
+    cups_response_cb_t cb,		// I - Response callback
+    void               *cb_data)	// I - Callback data
+{
+  _cups_async_t	*async;			// Asynchronous request
+
+
+  DEBUG_printf("cupsSendRequestAsync(loop=%p, http=%p, request=%p(%s), resource=\"%s\", cb=%p, cb_data=%p)", (void *)loop, (void *)http, (void *)request, request ? ippOpString(request->request.op.operation_id) : "?", resource, (void *)cb, cb_data);
+
+  // Range check input...
+  if (!loop || !request || !resource || !cb)
+  {
+    ippDelete(request);
+
+    _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(EINVAL), false);
+
+    return (false);
+  }
+
+  // Get the default connection as needed...
+  if (!http && (http = _cupsConnect()) == NULL)
+  {
+    ippDelete(request);
+
+    return (false);
+  }
+
+  // Clear any "Local" authentication data since it is probably stale...
+  if (http->authstring && !strncmp(http->authstring, "Local ", 6))
+    httpSetAuthString(http, NULL, NULL);
+
+  // Send the request and wait for the response in the event loop...
+  if ((async = _cupsMemCalloc(CUPS_MEMTYPE_HTTP, 1, sizeof(_cups_async_t))) == NULL)
+  {
+    ippDelete(request);
+
+    _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(errno), false);
+
+    return (false);
+  }
+
+  async->request = request;
+  async->cb      = cb;
+  async->cb_data = cb_data;
+
+  cupsCopyString(async->resource, resource, sizeof(async->resource));
+
+  if (!cups_async_send(http, async) || !httpLoopAdd(loop, http, HTTP_LOOP_READ, http->timeout_value > 0.0 ? (int)(1000.0 * http->timeout_value) : 0, (http_loop_cb_t)cups_async_cb, async))
+  {
+    ippDelete(request);
+    _cupsMemFree(async);
+
+    return (false);
+  }
+
+  return (true);
+}
+
+
 //
 // 'cupsWriteRequestData()' - Write additional data after an IPP request.
 //
@@ -746,30 +742,10 @@ cupsWriteRequestData(
   }
 
   // Finally, check if we have any pending data from the server...
-  if (length >= HTTP_MAX_BUFFER || http->wused < wused || (wused > 0 && (size_t)http->wused == length))
+  if (length >= http->wsize || http->wused < wused || (wused > 0 && (size_t)http->wused == length))
   {
     // We've written something to the server, so check for response data...
-    if (_httpWait(http, 0, 1))
-    {
-      http_status_t	status;		// Status from _httpUpdate
-
-      _httpUpdate(http, &status);
-      if (status >= HTTP_STATUS_MULTIPLE_CHOICES)
-      {
-        _cupsSetHTTPError(status);
-
-	do
-	{
-	  status = httpUpdate(http);
-	}
-	while (status != HTTP_STATUS_ERROR && http->state == HTTP_STATE_POST_RECV);
-
-        httpFlush(http);
-      }
-
-      DEBUG_printf("1cupsWriteRequestData: Returning %d.\n", status);
-      return (status);
-    }
+    return (cups_check_response(http));
   }
 
   DEBUG_puts("1cupsWriteRequestData: Returning HTTP_STATUS_CONTINUE.");
@@ -802,35 +778,22 @@ _cupsConnect(void)
         (cg->http->encryption != cg->encryption &&
 	 cg->http->encryption == HTTP_ENCRYPTION_NEVER))
     {
-      // Need to close the current connection because something has changed...
-      httpClose(cg->http);
+      // Something has changed, return the current connection to the pool...
+      httpReleaseConnection(cg->http);
       cg->http = NULL;
     }
-    else
+    else if (!_httpCheckConnection(cg->http))
     {
-      // Same server, see if the connection is still established...
-      char	ch;			// Connection check byte
-      ssize_t	n;			// Number of bytes
-
-#ifdef _WIN32
-      if ((n = recv(cg->http->fd, &ch, 1, MSG_PEEK)) == 0 ||
-          (n < 0 && WSAGetLastError() != WSAEWOULDBLOCK))
-#else
-      if ((n = recv(cg->http->fd, &ch, 1, MSG_PEEK | MSG_DONTWAIT)) == 0 ||
-          (n < 0 && errno != EWOULDBLOCK))
-#endif // _WIN32
-      {
-        // Nope, close the connection...
-	httpClose(cg->http);
-	cg->http = NULL;
-      }
+      // Same server but the connection has been closed...
+      httpClose(cg->http);
+      cg->http = NULL;
     }
   }
 
   // (Re)connect as needed...
   if (!cg->http)
   {
-    if ((cg->http = httpConnect(cupsGetServer(), ippGetPort(), NULL, AF_UNSPEC, cupsGetEncryption(), 1, 30000, NULL)) == NULL)
+    if ((cg->http = httpAcquireConnection(cupsGetServer(), ippGetPort(), AF_UNSPEC, cupsGetEncryption(), true, 30000, NULL)) == NULL)
     {
       if (errno)
         _cupsSetError(IPP_STATUS_ERROR_SERVICE_UNAVAILABLE, NULL, false);
@@ -844,6 +807,40 @@ _cupsConnect(void)
 }
 
 
+//
+// '_cupsDoStreamRequest()' - Do an IPP request, streaming the response.
+//
+// This function sends the IPP request like @link cupsDoRequest@, but the
+// response attributes are passed to the "stream_cb" function as they are read
+// rather than being accumulated in the response.  The returned response only
+// holds the message header, so the status code is available using
+// @link ippGetStatusCode@.  If the callback returns `false`, the remainder of
+// the response is discarded and the (partial) response is returned.
+//
+
+ipp_t *					// O - Response header or `NULL` on error
+_cupsDoStreamRequest(
+    http_t          *http,		// I - Connection to server or `CUPS_HTTP_DEFAULT`
+    ipp_t           *request,		// I - IPP request
+    const char      *resource,		// I - HTTP resource for POST
+    ipp_stream_cb_t stream_cb,		// I - Attribute callback function
+    void            *stream_data)	// I - Attribute callback data
+{
+  DEBUG_printf("_cupsDoStreamRequest(http=%p, request=%p(%s), resource=\"%s\", stream_cb=%p, stream_data=%p)", (void *)http, (void *)request, request ? ippOpString(request->request.op.operation_id) : "?", resource, (void *)stream_cb, stream_data);
+
+  if (!stream_cb)
+  {
+    ippDelete(request);
+
+    _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(EINVAL), false);
+
+    return (NULL);
+  }
+
+  return (cups_do_request(http, request, resource, -1, -1, stream_cb, stream_data));
+}
+
+
 //
 // '_cupsSetError()' - Set the last IPP status code and status-message.
 //
@@ -955,3 +952,541 @@ _cupsSetHTTPError(http_status_t status)	// I - HTTP status code
 	break;
   }
 }
+
+
+//
+// 'cups_async_cb()' - Read the response to an asynchronous request.
+//
+
+static bool				// O - `true` to keep waiting, `false` when done
+cups_async_cb(
+    http_loop_t        *loop,		// I - Event loop
+    http_t             *http,		// I - Connection to server
+    http_loop_events_t events,		// I - Ready events
+    _cups_async_t      *async)		// I - Asynchronous request
+{
+  ipp_t		*response = NULL;	// IPP response
+  http_status_t	status;			// Status of HTTP request
+
+
+  DEBUG_printf("4cups_async_cb(loop=%p, http=%p, events=%u, async=%p)", (void *)loop, (void *)http, events, (void *)async);
+
+  if (events & HTTP_LOOP_TIMEOUT)
+  {
+    // No response yet, see if we should keep waiting...
+    if (http->timeout_cb && (http->timeout_cb)(http, http->timeout_data))
+      return (true);
+
+    http->error = ETIMEDOUT;
+    _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(ETIMEDOUT), false);
+    httpReconnect(http, 30000, NULL);
+  }
+  else
+  {
+    // Get the server's response...
+    response = cupsGetResponse(http, async->resource);
+    status   = httpGetStatus(http);
+
+    DEBUG_printf("5cups_async_cb: status=%d", status);
+
+    if (!response && (status == HTTP_STATUS_UNAUTHORIZED || status == HTTP_STATUS_UPGRADE_REQUIRED))
+    {
+      // Send the request again with authentication or encryption...
+      if (cups_async_send(http, async))
+        return (true);
+    }
+    else if (status == HTTP_STATUS_ERROR || (status >= HTTP_STATUS_BAD_REQUEST && status != HTTP_STATUS_UNAUTHORIZED && status != HTTP_STATUS_UPGRADE_REQUIRED))
+    {
+      _cupsSetHTTPError(status);
+    }
+
+    if (http->state != HTTP_STATE_WAITING)
+    {
+      // Flush any remaining data...
+      httpFlush(http);
+    }
+  }
+
+  // Remove the connection from the loop before calling the callback so that it
+  // can send another request on the connection...
+  httpLoopRemove(loop, http);
+
+  (async->cb)(http, response, async->cb_data);
+
+  ippDelete(async->request);
+  _cupsMemFree(async);
+
+  return (false);
+}
+
+
+//
+// 'cups_async_send()' - Send an asynchronous request.
+//
+
+static bool				// O - `true` on success, `false` on error
+cups_async_send(http_t        *http,	// I - Connection to server
+                _cups_async_t *async)	// I - Asynchronous request
+{
+  DEBUG_printf("4cups_async_send(http=%p, async=%p)", (void *)http, (void *)async);
+
+  // If the prior request was not flushed out, do so now...
+  if (http->state == HTTP_STATE_GET_SEND || http->state == HTTP_STATE_POST_SEND)
+  {
+    httpFlush(http);
+  }
+  else if (http->state != HTTP_STATE_WAITING)
+  {
+    DEBUG_printf("5cups_async_send: Unknown HTTP state (%d), reconnecting.", http->state);
+    if (!httpReconnect(http, 30000, NULL))
+      return (false);
+  }
+
+  // Encrypt the link when sending authentication information to a remote
+  // server...
+  if (ippFindAttribute(async->request, "auth-info", IPP_TAG_TEXT) && !httpAddrIsLocalhost(http->hostaddr) && !http->tls && !httpSetEncryption(http, HTTP_ENCRYPTION_REQUIRED))
+  {
+    DEBUG_puts("5cups_async_send: Unable to encrypt connection.");
+    return (false);
+  }
+
+  // Reconnect if the last response had a "Connection: close"...
+  if (!_cups_strcasecmp(httpGetField(http, HTTP_FIELD_CONNECTION), "close"))
+  {
+    httpClearFields(http);
+    if (!httpReconnect(http, 30000, NULL))
+      return (false);
+  }
+
+  // Use any cached authentication for the server, or update the Digest
+  // authentication string as needed...
+  if (!_cupsSetCachedAuth(http, "POST", async->resource) && http->authstring && !strncmp(http->authstring, "Digest ", 7))
+    _httpSetDigestAuthString(http, http->nextnonce, "POST", async->resource);
+
+  // Send the request, reconnecting once if the server closed the connection...
+  if (cups_send_pipelined(http, async->request, async->resource))
+    return (true);
+
+  DEBUG_puts("5cups_async_send: POST failed, reconnecting.");
+
+  return (httpReconnect(http, 30000, NULL) && cups_send_pipelined(http, async->request, async->resource));
+}
+
+
+//
+// 'cups_check_response()' - Check for an early response from the server.
+//
+
+static http_status_t			// O - `HTTP_STATUS_CONTINUE` if OK or HTTP status on error
+cups_check_response(http_t *http)	// I - Connection to server
+{
+  http_status_t	status;			// Status from _httpUpdate
+
+
+  if (!_httpWait(http, 0, 1))
+    return (HTTP_STATUS_CONTINUE);
+
+  _httpUpdate(http, &status);
+  if (status >= HTTP_STATUS_MULTIPLE_CHOICES)
+  {
+    _cupsSetHTTPError(status);
+
+    do
+    {
+      status = httpUpdate(http);
+    }
+    while (status != HTTP_STATUS_ERROR && http->state == HTTP_STATE_POST_RECV);
+
+    httpFlush(http);
+  }
+
+  DEBUG_printf("2cups_check_response: Returning %d.", status);
+  return (status);
+}
+
+
+//
+// 'cups_do_request()' - Do an IPP request, optionally streaming the response.
+//
+
+static ipp_t *				// O - Response data
+cups_do_request(
+    http_t          *http,		// I - Connection to server or `CUPS_HTTP_DEFAULT`
+    ipp_t           *request,		// I - IPP request
+    const char      *resource,		// I - HTTP resource for POST
+    int             infile,		// I - File to read from or `-1` for none
+    int             outfile,		// I - File to write to or `-1` for none
+    ipp_stream_cb_t stream_cb,		// I - Attribute callback or `NULL` for none
+    void            *stream_data)	// I - Attribute callback data
+{
+  ipp_t		*response = NULL;	// IPP response data
+  size_t	length = 0;		// Content-Length value
+  http_status_t	status;			// Status of HTTP request
+  struct stat	fileinfo;		// File information
+  ssize_t	bytes;			// Number of bytes read/written
+  char		buffer[32768];		// Output buffer
+
+
+  // Range check input...
+  if (!request || !resource)
+  {
+    ippDelete(request);
+
+    _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(EINVAL), false);
+
+    return (NULL);
+  }
+
+  // Get the default connection as needed...
+  if (!http && (http = _cupsConnect()) == NULL)
+  {
+    ippDelete(request);
+
+    return (NULL);
+  }
+
+  // See if we have a file to send...
+  if (infile >= 0)
+  {
+    if (fstat(infile, &fileinfo))
+    {
+      // Can't get file information!
+      _cupsSetError(errno == EBADF ? IPP_STATUS_ERROR_NOT_FOUND : IPP_STATUS_ERROR_NOT_AUTHORIZED, NULL, false);
+      ippDelete(request);
+
+      return (NULL);
+    }
+
+#ifdef _WIN32
+    if (fileinfo.st_mode & _S_IFDIR)
+#else
+    if (S_ISDIR(fileinfo.st_mode))
+#endif // _WIN32
+    {
+      // Can't send a directory...
+      _cupsSetError(IPP_STATUS_ERROR_NOT_POSSIBLE, strerror(EISDIR), false);
+      ippDelete(request);
+
+      return (NULL);
+    }
+
+#ifndef _WIN32
+    if (!S_ISREG(fileinfo.st_mode))
+      length = 0;			// Chunk when piping
+    else
+#endif // !_WIN32
+    length = ippGetLength(request) + (size_t)fileinfo.st_size;
+  }
+  else
+  {
+    length = ippGetLength(request);
+  }
+
+  DEBUG_printf("2cups_do_request: Request length=%ld, total length=%ld", (long)ippGetLength(request), (long)length);
+
+  // Clear any "Local" authentication data since it is probably stale...
+  if (http->authstring && !strncmp(http->authstring, "Local ", 6))
+    httpSetAuthString(http, NULL, NULL);
+
+  // Loop until we can send the request without authorization problems.
+  while (response == NULL)
+  {
+    DEBUG_puts("2cups_do_request: setup...");
+
+    // Send the request...
+    status = cupsSendRequest(http, request, resource, length);
+
+    DEBUG_printf("2cups_do_request: status=%d", status);
+
+    if (status == HTTP_STATUS_CONTINUE && request->state == IPP_STATE_DATA && infile >= 0)
+    {
+      DEBUG_puts("2cups_do_request: file write...");
+
+      // Send the file with the request...
+#ifndef _WIN32
+      if (S_ISREG(fileinfo.st_mode))
+#endif // _WIN32
+      lseek(infile, 0, SEEK_SET);
+
+      while ((bytes = _httpWriteFile(http, infile)) > 0)
+      {
+        if ((status = cups_check_response(http)) != HTTP_STATUS_CONTINUE)
+	  break;
+      }
+
+      if (bytes < 0)
+      {
+        _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(http->error), false);
+        status = HTTP_STATUS_ERROR;
+      }
+    }
+
+    // Get the server's response...
+    if (status <= HTTP_STATUS_CONTINUE || status == HTTP_STATUS_OK)
+    {
+      response = cups_get_response(http, resource, stream_cb, stream_data);
+      status   = httpGetStatus(http);
+    }
+
+    DEBUG_printf("2cups_do_request: status=%d", status);
+
+    if (status == HTTP_STATUS_ERROR || (status >= HTTP_STATUS_BAD_REQUEST && status != HTTP_STATUS_UNAUTHORIZED && status != HTTP_STATUS_UPGRADE_REQUIRED))
+    {
+      _cupsSetHTTPError(status);
+      break;
+    }
+
+    if (response && outfile >= 0)
+    {
+      // Write trailing data to file...
+      while ((bytes = httpRead(http, buffer, sizeof(buffer))) > 0)
+      {
+	if (write(outfile, buffer, (size_t)bytes) < bytes)
+	  break;
+      }
+    }
+
+    if (http->state != HTTP_STATE_WAITING)
+    {
+      // Flush any remaining data...
+      httpFlush(http);
+    }
+  }
+
+  // Delete the original request and return the response...
+  ippDelete(request);
+
+  return (response);
+}
+
+
+//
+// 'cups_get_response()' - Get a response to an IPP request, optionally
+//                         streaming the attributes to a callback.
+//
+
+static ipp_t *				// O - Response or `NULL` on HTTP error
+cups_get_response(
+    http_t          *http,		// I - Connection to server or `CUPS_HTTP_DEFAULT`
+    const char      *resource,		// I - HTTP resource for POST
+    ipp_stream_cb_t stream_cb,		// I - Attribute callback or `NULL` for none
+    void            *stream_data)	// I - Attribute callback data
+{
+  http_status_t	status;			// HTTP status
+  ipp_state_t	state;			// IPP read state
+  ipp_t		*response = NULL;	// IPP response
+  _cups_stream_t stream;		// Streaming callback data
+
+
+  DEBUG_printf("1cups_get_response: http->state=%d", http ? http->state : HTTP_STATE_ERROR);
+
+  // Connect to the default server as needed...
+  if (!http)
+  {
+    _cups_globals_t *cg = _cupsGlobals();
+					// Pointer to library globals
+
+    if ((http = cg->http) == NULL)
+    {
+      _cupsSetError(IPP_STATUS_ERROR_INTERNAL, _("No active connection."), true);
+      DEBUG_puts("1cups_get_response: No active connection - returning NULL.");
+      return (NULL);
+    }
+  }
+
+  if (http->state != HTTP_STATE_POST_RECV && http->state != HTTP_STATE_POST_SEND)
+  {
+    _cupsSetError(IPP_STATUS_ERROR_INTERNAL, _("No request sent."), true);
+    DEBUG_puts("1cups_get_response: Not in POST state - returning NULL.");
+    return (NULL);
+  }
+
+  // Check for an unfinished chunked request...
+  if (http->data_encoding == HTTP_ENCODING_CHUNKED)
+  {
+    // Send a 0-length chunk to finish off the request...
+    DEBUG_puts("2cups_get_response: Finishing chunked POST...");
+
+    if (httpWrite(http, "", 0) < 0)
+    {
+      _cupsSetError(IPP_STATUS_ERROR_INTERNAL, _("Unable to finish request."), true);
+      return (NULL);
+    }
+  }
+
+  // Wait for a response from the server...
+  DEBUG_printf("2cups_get_response: Update loop, http->status=%d...", http->status);
+
+  do
+  {
+    status = httpUpdate(http);
+  }
+  while (status == HTTP_STATUS_CONTINUE);
+
+  DEBUG_printf("2cups_get_response: status=%d", status);
+
+  if (status == HTTP_STATUS_OK)
+  {
+    // Get the IPP response...
+    response          = ippNew();
+    stream.stopped    = false;
+    stream.message[0] = '\0';
+
+    if (stream_cb)
+    {
+      // Deliver attributes to the callback as they are read...
+      stream.cb      = stream_cb;
+      stream.cb_data = stream_data;
+
+      while ((state = ippReadStream(http, response, (ipp_stream_cb_t)cups_stream_cb, &stream)) != IPP_STATE_DATA)
+      {
+	if (state == IPP_STATE_ERROR)
+	  break;
+      }
+    }
+    else
+    {
+      while ((state = ippRead(http, response)) != IPP_STATE_DATA)
+      {
+	if (state == IPP_STATE_ERROR)
+	  break;
+      }
+    }
+
+    if (state == IPP_STATE_ERROR && stream.stopped)
+    {
+      // The callback stopped reading, discard the rest of the response...
+      DEBUG_puts("2cups_get_response: Stopped by stream callback.");
+
+      httpFlush(http);
+    }
+    else if (state == IPP_STATE_ERROR)
+    {
+      // Flush remaining data and delete the response...
+      _cupsSetError(IPP_STATUS_ERROR_INTERNAL, _("Unable to read response."), true);
+      DEBUG_puts("1cups_get_response: IPP read error!");
+
+      httpFlush(http);
+
+      ippDelete(response);
+      response = NULL;
+
+      http->status = HTTP_STATUS_ERROR;
+      http->error  = EINVAL;
+    }
+  }
+  else if (status != HTTP_STATUS_ERROR)
+  {
+    // Flush any error message...
+    httpFlush(http);
+
+    _cupsSetHTTPError(status);
+
+    // Then handle encryption and authentication...
+    if (status == HTTP_STATUS_UNAUTHORIZED)
+    {
+      // See if we can do authentication...
+      DEBUG_puts("2cups_get_response: Need authorization...");
+
+      if (cupsDoAuthentication(http, "POST", resource))
+      {
+        if (!httpReconnect(http, 30000, NULL))
+          http->status = HTTP_STATUS_ERROR;
+      }
+      else
+      {
+        http->status = HTTP_STATUS_CUPS_AUTHORIZATION_CANCELED;
+      }
+    }
+    else if (status == HTTP_STATUS_UPGRADE_REQUIRED)
+    {
+      // Force a reconnect with encryption...
+      DEBUG_puts("2cups_get_response: Need encryption...");
+
+      if (httpReconnect(http, 30000, NULL))
+        httpSetEncryption(http, HTTP_ENCRYPTION_REQUIRED);
+    }
+  }
+
+  if (response)
+  {
+    ipp_attribute_t	*attr;		// status-message attribute
+
+    const char		*message;	// status-message value
+
+    // Streamed attributes are not kept in the response, so use the copy
+    // saved by cups_stream_cb()...
+    if ((attr = ippFindAttribute(response, "status-message", IPP_TAG_TEXT)) != NULL)
+      message = attr->values[0].string.text;
+    else if (stream_cb && stream.message[0])
+      message = stream.message;
+    else
+      message = ippErrorString(response->request.status.status_code);
+
+    DEBUG_printf("1cups_get_response: status-code=%s, status-message=\"%s\"", ippErrorString(response->request.status.status_code), message);
+
+    _cupsSetError(response->request.status.status_code, message, false);
+  }
+
+  return (response);
+}
+
+
+//
+// 'cups_send_pipelined()' - Send an IPP request without waiting for a response.
+//
+
+static bool				// O - `true` on success, `false` on error
+cups_send_pipelined(
+    http_t     *http,			// I - Connection to server
+    ipp_t      *request,		// I - IPP request
+    const char *resource)		// I - HTTP resource for POST
+{
+  ipp_state_t	state;			// State of IPP processing
+  char		date[256];		// Date: header value
+
+
+  DEBUG_printf("4cups_send_pipelined(http=%p, request=%p(%s), resource=\"%s\")", (void *)http, (void *)request, request ? ippOpString(request->request.op.operation_id) : "?", resource);
+
+  if (!request)
+    return (false);
+
+  httpClearFields(http);
+  httpSetField(http, HTTP_FIELD_CONTENT_TYPE, "application/ipp");
+  httpSetField(http, HTTP_FIELD_DATE, httpGetDateString(time(NULL), date, sizeof(date)));
+  httpSetLength(http, ippGetLength(request));
+  httpSetField(http, HTTP_FIELD_AUTHORIZATION, http->authstring);
+
+  if (!httpWriteRequest(http, "POST", resource))
+    return (false);
+
+  request->state = IPP_STATE_IDLE;
+
+  while ((state = ippWrite(http, request)) != IPP_STATE_DATA)
+  {
+    if (state == IPP_STATE_ERROR)
+      return (false);
+  }
+
+  return (true);
+}
+
+
+//
+// 'cups_stream_cb()' - Pass a streamed attribute to the caller's callback.
+//
+
+static bool				// O - `true` to continue, `false` to stop
+cups_stream_cb(_cups_stream_t  *stream,	// I - Streaming callback data
+               ipp_tag_t       group,	// I - Group tag
+               ipp_attribute_t *attr)	// I - Attribute or `NULL` for a group tag
+{
+  // Save the status-message, since the attribute is freed after the callback...
+  if (attr && group == IPP_TAG_OPERATION && attr->name && !strcmp(attr->name, "status-message") && ((attr->value_tag & IPP_TAG_CUPS_MASK) == IPP_TAG_TEXT || (attr->value_tag & IPP_TAG_CUPS_MASK) == IPP_TAG_TEXTLANG))
+    cupsCopyString(stream->message, attr->values[0].string.text, sizeof(stream->message));
+
+  if (!(stream->cb)(stream->cb_data, group, attr))
+    stream->stopped = true;
+
+  return (!stream->stopped);
+}
@@ -13,6 +13,7 @@
 #  define _CUPS_STRING_PRIVATE_H_
 #  include "config.h"
 #  include "base.h"
+#  include "thread.h"
 #  include <stdio.h>
 #  include <stdlib.h>
 #  include <stdarg.h>
@@ -37,7 +38,9 @@ typedef struct _cups_sp_item_s		// String Pool Item
 #  ifdef DEBUG_GUARDS
   unsigned int	guard;			// Guard word
 #  endif // DEBUG_GUARDS
-  unsigned int	ref_count;		// Reference count
+  cups_atomic_t	ref_count;		// Reference count
+  unsigned int	hash;			// Hash of string
+  size_t	len;			// Length of string
   char		str[1];			// String
 } _cups_sp_item_t;
 
@@ -115,14 +118,23 @@ extern int _cups_toupper(int ch);
 // Prototypes...
 //
 
+extern void	*_cupsMemAlloc(cups_memtype_t type, size_t size) _CUPS_INTERNAL;
+extern void	*_cupsMemCalloc(cups_memtype_t type, size_t count, size_t size) _CUPS_INTERNAL;
+extern void	_cupsMemFree(void *ptr) _CUPS_INTERNAL;
+extern void	*_cupsMemRealloc(cups_memtype_t type, void *ptr, size_t size) _CUPS_INTERNAL;
+extern char	*_cupsMemStrdup(cups_memtype_t type, const char *s) _CUPS_INTERNAL;
+
 extern ssize_t	_cups_safe_vsnprintf(char *buffer, size_t bufsize, const char *format, va_list args) _CUPS_PRIVATE;
 extern void	_cups_strcpy(char *dst, const char *src) _CUPS_PRIVATE;
 extern int	_cups_strcasecmp(const char *, const char *) _CUPS_PRIVATE;
 extern int	_cups_strncasecmp(const char *, const char *, size_t n) _CUPS_PRIVATE;
 
 extern char	*_cupsStrAlloc(const char *s) _CUPS_PRIVATE;
+extern bool	_cupsStrEqual(const char *a, const char *b) _CUPS_PRIVATE;
 extern void	_cupsStrFlush(void) _CUPS_PRIVATE;
 extern void	_cupsStrFree(const char *s) _CUPS_PRIVATE;
+extern size_t	_cupsStrHash(const char *s) _CUPS_PRIVATE;
+extern size_t	_cupsStrLength(const char *s) _CUPS_PRIVATE;
 extern char	*_cupsStrRetain(const char *s) _CUPS_PRIVATE;
 extern size_t	_cupsStrStatistics(size_t *alloc_bytes, size_t *total_bytes) _CUPS_PRIVATE;
 extern char	*_cupsStrFormatd(char *buf, char *bufend, double number, struct lconv *loc) _CUPS_PRIVATE;
@@ -13,16 +13,90 @@
 #include "cups-private.h"
 #include <stddef.h>
 #include <limits.h>
+#include <math.h>
+
+
+//
+// Local types...
+//
+
+#define _CUPS_SP_SHARDS	32		// Number of string pool shards
+#define _CUPS_SP_SHARD(hash) (((hash) >> 27) & (_CUPS_SP_SHARDS - 1))
+					// Shard for a 32-bit hash value
+#define _CUPS_SP_INIT	{ CUPS_MUTEX_INITIALIZER, NULL }
+					// Initializer for a shard
+
+typedef struct _cups_diyfp_s		// Floating point value with 64-bit significand
+{
+  uint64_t		f;		// Significand
+  int			e;		// Binary exponent
+} _cups_diyfp_t;
+
+typedef struct _cups_sp_shard_s		// String pool shard
+{
+  cups_mutex_t		mutex;		// Mutex to control access to shard
+  cups_array_t		*pool;		// Strings in shard
+} _cups_sp_shard_t;
 
 
 //
 // Local globals...
 //
 
-static cups_mutex_t	sp_mutex = CUPS_MUTEX_INITIALIZER;
-					// Mutex to control access to pool
-static cups_array_t	*stringpool = NULL;
-					// Global string pool
+static const _cups_diyfp_t powers10[] =
+{					// Normalized powers of 10 from 1e-348 to 1e340, step 8
+  { UINT64_C(0xfa8fd5a0081c0288), -1220 }, { UINT64_C(0xbaaee17fa23ebf76), -1193 }, { UINT64_C(0x8b16fb203055ac76), -1166 },
+  { UINT64_C(0xcf42894a5dce35ea), -1140 }, { UINT64_C(0x9a6bb0aa55653b2d), -1113 }, { UINT64_C(0xe61acf033d1a45df), -1087 },
+  { UINT64_C(0xab70fe17c79ac6ca), -1060 }, { UINT64_C(0xff77b1fcbebcdc4f), -1034 }, { UINT64_C(0xbe5691ef416bd60c), -1007 },
+  { UINT64_C(0x8dd01fad907ffc3c), -980 }, { UINT64_C(0xd3515c2831559a83), -954 }, { UINT64_C(0x9d71ac8fada6c9b5), -927 },
+  { UINT64_C(0xea9c227723ee8bcb), -901 }, { UINT64_C(0xaecc49914078536d), -874 }, { UINT64_C(0x823c12795db6ce57), -847 },
+  { UINT64_C(0xc21094364dfb5637), -821 }, { UINT64_C(0x9096ea6f3848984f), -794 }, { UINT64_C(0xd77485cb25823ac7), -768 },
+  { UINT64_C(0xa086cfcd97bf97f4), -741 }, { UINT64_C(0xef340a98172aace5), -715 }, { UINT64_C(0xb23867fb2a35b28e), -688 },
+  { UINT64_C(0x84c8d4dfd2c63f3b), -661 }, { UINT64_C(0xc5dd44271ad3cdba), -635 }, { UINT64_C(0x936b9fcebb25c996), -608 },
+  { UINT64_C(0xdbac6c247d62a584), -582 }, { UINT64_C(0xa3ab66580d5fdaf6), -555 }, { UINT64_C(0xf3e2f893dec3f126), -529 },
+  { UINT64_C(0xb5b5ada8aaff80b8), -502 }, { UINT64_C(0x87625f056c7c4a8b), -475 }, { UINT64_C(0xc9bcff6034c13053), -449 },
+  { UINT64_C(0x964e858c91ba2655), -422 }, { UINT64_C(0xdff9772470297ebd), -396 }, { UINT64_C(0xa6dfbd9fb8e5b88f), -369 },
+  { UINT64_C(0xf8a95fcf88747d94), -343 }, { UINT64_C(0xb94470938fa89bcf), -316 }, { UINT64_C(0x8a08f0f8bf0f156b), -289 },
+  { UINT64_C(0xcdb02555653131b6), -263 }, { UINT64_C(0x993fe2c6d07b7fac), -236 }, { UINT64_C(0xe45c10c42a2b3b06), -210 },
+  { UINT64_C(0xaa242499697392d3), -183 }, { UINT64_C(0xfd87b5f28300ca0e), -157 }, { UINT64_C(0xbce5086492111aeb), -130 },
+  { UINT64_C(0x8cbccc096f5088cc), -103 }, { UINT64_C(0xd1b71758e219652c), -77 }, { UINT64_C(0x9c40000000000000), -50 },
+  { UINT64_C(0xe8d4a51000000000), -24 }, { UINT64_C(0xad78ebc5ac620000), 3 }, { UINT64_C(0x813f3978f8940984), 30 },
+  { UINT64_C(0xc097ce7bc90715b3), 56 }, { UINT64_C(0x8f7e32ce7bea5c70), 83 }, { UINT64_C(0xd5d238a4abe98068), 109 },
+  { UINT64_C(0x9f4f2726179a2245), 136 }, { UINT64_C(0xed63a231d4c4fb27), 162 }, { UINT64_C(0xb0de65388cc8ada8), 189 },
+  { UINT64_C(0x83c7088e1aab65db), 216 }, { UINT64_C(0xc45d1df942711d9a), 242 }, { UINT64_C(0x924d692ca61be758), 269 },
+  { UINT64_C(0xda01ee641a708dea), 295 }, { UINT64_C(0xa26da3999aef774a), 322 }, { UINT64_C(0xf209787bb47d6b85), 348 },
+  { UINT64_C(0xb454e4a179dd1877), 375 }, { UINT64_C(0x865b86925b9bc5c2), 402 }, { UINT64_C(0xc83553c5c8965d3d), 428 },
+  { UINT64_C(0x952ab45cfa97a0b3), 455 }, { UINT64_C(0xde469fbd99a05fe3), 481 }, { UINT64_C(0xa59bc234db398c25), 508 },
+  { UINT64_C(0xf6c69a72a3989f5c), 534 }, { UINT64_C(0xb7dcbf5354e9bece), 561 }, { UINT64_C(0x88fcf317f22241e2), 588 },
+  { UINT64_C(0xcc20ce9bd35c78a5), 614 }, { UINT64_C(0x98165af37b2153df), 641 }, { UINT64_C(0xe2a0b5dc971f303a), 667 },
+  { UINT64_C(0xa8d9d1535ce3b396), 694 }, { UINT64_C(0xfb9b7cd9a4a7443c), 720 }, { UINT64_C(0xbb764c4ca7a44410), 747 },
+  { UINT64_C(0x8bab8eefb6409c1a), 774 }, { UINT64_C(0xd01fef10a657842c), 800 }, { UINT64_C(0x9b10a4e5e9913129), 827 },
+  { UINT64_C(0xe7109bfba19c0c9d), 853 }, { UINT64_C(0xac2820d9623bf429), 880 }, { UINT64_C(0x80444b5e7aa7cf85), 907 },
+  { UINT64_C(0xbf21e44003acdd2d), 933 }, { UINT64_C(0x8e679c2f5e44ff8f), 960 }, { UINT64_C(0xd433179d9c8cb841), 986 },
+  { UINT64_C(0x9e19db92b4e31ba9), 1013 }, { UINT64_C(0xeb96bf6ebadf77d9), 1039 }, { UINT64_C(0xaf87023b9bf0ee6b), 1066 }
+};
+static const uint64_t	ipowers10[] =
+{					// Integer powers of 10 from 1e0 to 1e19
+  UINT64_C(1), UINT64_C(10), UINT64_C(100), UINT64_C(1000), UINT64_C(10000),
+  UINT64_C(100000), UINT64_C(1000000), UINT64_C(10000000),
+  UINT64_C(100000000), UINT64_C(1000000000), UINT64_C(10000000000),
+  UINT64_C(100000000000), UINT64_C(1000000000000),
+  UINT64_C(10000000000000), UINT64_C(100000000000000),
+  UINT64_C(1000000000000000), UINT64_C(10000000000000000),
+  UINT64_C(100000000000000000), UINT64_C(1000000000000000000),
+  UINT64_C(10000000000000000000)
+};
+static _cups_sp_shard_t	stringpool[_CUPS_SP_SHARDS] =
+{					// Global string pool, sharded by hash
+  _CUPS_SP_INIT, _CUPS_SP_INIT, _CUPS_SP_INIT, _CUPS_SP_INIT,
+  _CUPS_SP_INIT, _CUPS_SP_INIT, _CUPS_SP_INIT, _CUPS_SP_INIT,
+  _CUPS_SP_INIT, _CUPS_SP_INIT, _CUPS_SP_INIT, _CUPS_SP_INIT,
+  _CUPS_SP_INIT, _CUPS_SP_INIT, _CUPS_SP_INIT, _CUPS_SP_INIT,
+  _CUPS_SP_INIT, _CUPS_SP_INIT, _CUPS_SP_INIT, _CUPS_SP_INIT,
+  _CUPS_SP_INIT, _CUPS_SP_INIT, _CUPS_SP_INIT, _CUPS_SP_INIT,
+  _CUPS_SP_INIT, _CUPS_SP_INIT, _CUPS_SP_INIT, _CUPS_SP_INIT,
+  _CUPS_SP_INIT, _CUPS_SP_INIT, _CUPS_SP_INIT, _CUPS_SP_INIT
+};
 
 
 //
@@ -30,6 +104,12 @@ static cups_array_t	*stringpool = NULL;
 //
 
 static int	compare_sp_items(_cups_sp_item_t *a, _cups_sp_item_t *b);
+static int	format_digits(double number, char *digits, int *exp10);
+static size_t	format_integer(char *buffer, unsigned long long value, bool negative, char type, char flag, bool zero, int width, int prec);
+static _cups_diyfp_t format_multiply(_cups_diyfp_t a, _cups_diyfp_t b);
+static void	format_round(char *digits, int num_digits, uint64_t delta, uint64_t rest, uint64_t ten_kappa, uint64_t wp_w);
+static size_t	hash_sp_item(_cups_sp_item_t *item);
+static size_t	hash_sp_string(const char *s);
 static void	validate_end(char *s, char *end);
 
 
@@ -176,15 +256,21 @@ cupsFormatStringv(
 {
   char		*bufptr,		// Pointer to position in buffer
 		*bufend,		// Pointer to end of buffer
+		flag,			// Flag character (space, -, +, #, ')
 		size,			// Size character (h, l, L)
 		type;			// Format type character
+  bool		zero;			// Pad with zeros?
   int		width,			// Width of field
 		prec;			// Number of characters of precision
   char		tformat[100],		// Temporary format string for snprintf()
 		*tptr,			// Pointer into temporary format
 		temp[1024];		// Buffer for formatted numbers
-  char		*s;			// Pointer to string
+  const char	*s,			// Pointer to string
+		*start;			// Start of literal or unescaped text
+  size_t	len;			// Length of formatted number or text
   ssize_t	bytes;			// Total number of bytes needed
+  unsigned long long value;		// Integer value
+  bool		negative;		// Negative integer value?
 
 
   // Range check input...
@@ -203,6 +289,9 @@ cupsFormatStringv(
       // Format character...
       tptr = tformat;
       *tptr++ = *format++;
+      flag    = '\0';
+      zero    = false;
+      prec    = -1;
 
       if (*format == '%')
       {
@@ -212,8 +301,9 @@ cupsFormatStringv(
         format ++;
 	continue;
       }
-      else if (strchr(" -+#\'", *format))
+      else if (*format && strchr(" -+#\'", *format))
       {
+        flag    = *format;
         *tptr++ = *format++;
       }
 
@@ -229,6 +319,7 @@ cupsFormatStringv(
       else
       {
 	width = 0;
+	zero  = *format == '0';
 
 	while (isdigit(*format & 255))
 	{
@@ -323,14 +414,67 @@ cupsFormatStringv(
 	    }
 	    break;
 
-        case 'B' : // Integer formats
-	case 'X' :
-	case 'b' :
+        case 'X' : // Integer formats
         case 'd' :
 	case 'i' :
 	case 'o' :
 	case 'u' :
 	case 'x' :
+	    if (flag != '\'' && width >= 0 && (size_t)(width + 2) <= sizeof(temp) && (size_t)(prec + 4) <= sizeof(temp))
+	    {
+	      // Format the integer directly...
+	      if (type == 'd' || type == 'i')
+	      {
+	        long long svalue;	// Signed value
+
+#  ifdef HAVE_LONG_LONG
+		if (size == 'L')
+		  svalue = va_arg(ap, long long);
+		else
+#  endif // HAVE_LONG_LONG
+		if (size == 'l')
+		  svalue = va_arg(ap, long);
+		else if (size == 'h')
+		  svalue = (short)va_arg(ap, int);
+		else
+		  svalue = va_arg(ap, int);
+
+                negative = svalue < 0;
+                value    = negative ? 0 - (unsigned long long)svalue : (unsigned long long)svalue;
+	      }
+	      else
+	      {
+#  ifdef HAVE_LONG_LONG
+		if (size == 'L')
+		  value = va_arg(ap, unsigned long long);
+		else
+#  endif // HAVE_LONG_LONG
+		if (size == 'l')
+		  value = va_arg(ap, unsigned long);
+		else if (size == 'h')
+		  value = (unsigned short)va_arg(ap, unsigned);
+		else
+		  value = va_arg(ap, unsigned);
+
+                negative = false;
+	      }
+
+	      len    = format_integer(temp, value, negative, type, flag, zero, width, prec);
+	      bytes += (ssize_t)len;
+
+	      if (bufptr < bufend)
+	      {
+	        if (len > (size_t)(bufend - bufptr))
+	          len = (size_t)(bufend - bufptr);
+
+		memcpy(bufptr, temp, len);
+		bufptr += len;
+	      }
+	      break;
+	    }
+
+        case 'B' : // Binary integer formats
+	case 'b' :
 	    if ((size_t)(width + 2) > sizeof(temp))
 	      break;
 
@@ -395,7 +539,20 @@ cupsFormatStringv(
             // Copy the C string, replacing control chars and \ with C character escapes...
             for (; *s && bufptr < bufend; s ++)
 	    {
-	      if (*s == '\n')
+	      if ((*s & 255) >= ' ' && *s != '\\' && *s != '\'' && *s != '\"')
+	      {
+	        // Copy a run of characters that need no escaping...
+	        for (start = s; (*s & 255) >= ' ' && *s != '\\' && *s != '\'' && *s != '\"'; s ++);
+
+                if ((len = (size_t)(s - start)) > (size_t)(bufend - bufptr))
+                  len = (size_t)(bufend - bufptr);
+
+		memcpy(bufptr, start, len);
+		bufptr += len;
+		bytes  += (ssize_t)len;
+		s       = start + len - 1;
+	      }
+	      else if (*s == '\n')
 	      {
 	        *bufptr++ = '\\';
 	        if (bufptr < bufend)
@@ -466,13 +623,20 @@ cupsFormatStringv(
     }
     else
     {
-      // Literal character...
-      bytes ++;
+      // Literal text up to the next format character...
+      for (start = format; *format && *format != '%'; format ++);
+
+      len    = (size_t)(format - start);
+      bytes += (ssize_t)len;
 
       if (bufptr < bufend)
-        *bufptr++ = *format++;
-      else
-        format ++;
+      {
+        if (len > (size_t)(bufend - bufptr))
+          len = (size_t)(bufend - bufptr);
+
+        memcpy(bufptr, start, len);
+        bufptr += len;
+      }
     }
   }
 
@@ -501,24 +665,33 @@ cupsFormatStringv(
 char *					// O - String pointer
 _cupsStrAlloc(const char *s)		// I - String
 {
-  size_t		slen;		// Length of string
+  size_t		slen,		// Length of string
+			hash;		// Hash of string
   _cups_sp_item_t	*item,		// String pool item
 			*key;		// Search key
+  _cups_sp_shard_t	*shard;		// String pool shard
 
 
   // Range check input...
   if (!s)
     return (NULL);
 
-  // Get the string pool...
-  cupsMutexLock(&sp_mutex);
+  // Get the string pool shard...
+  hash  = hash_sp_string(s);
+  shard = stringpool + _CUPS_SP_SHARD(hash);
+
+  cupsMutexLock(&shard->mutex);
 
-  if (!stringpool)
-    stringpool = cupsArrayNew((cups_array_cb_t)compare_sp_items, NULL, NULL, 0, NULL, NULL);
+  if (!shard->pool)
+  {
+    cupsMutexSetName(&shard->mutex, "stringpool");
+
+    shard->pool = cupsArrayNewHashed((cups_ahash_cb_t)hash_sp_item, (cups_array_cb_t)compare_sp_items, NULL, NULL, NULL);
+  }
 
-  if (!stringpool)
+  if (!shard->pool)
   {
-    cupsMutexUnlock(&sp_mutex);
+    cupsMutexUnlock(&shard->mutex);
 
     return (NULL);
   }
@@ -526,10 +699,10 @@ _cupsStrAlloc(const char *s)		// I - String
   // See if the string is already in the pool...
   key = (_cups_sp_item_t *)(s - offsetof(_cups_sp_item_t, str));
 
-  if ((item = (_cups_sp_item_t *)cupsArrayFind(stringpool, key)) != NULL)
+  if ((item = (_cups_sp_item_t *)cupsArrayFind(shard->pool, key)) != NULL)
   {
     // Found it, return the cached string...
-    item->ref_count ++;
+    cupsAtomicInc(&item->ref_count);
 
 #ifdef DEBUG_GUARDS
     DEBUG_printf("5_cupsStrAlloc: Using string %p(%s) for \"%s\", guard=%08x, ref_count=%d", item, item->str, s, item->guard, item->ref_count);
@@ -538,22 +711,24 @@ _cupsStrAlloc(const char *s)		// I - String
       abort();
 #endif // DEBUG_GUARDS
 
-    cupsMutexUnlock(&sp_mutex);
+    cupsMutexUnlock(&shard->mutex);
 
     return (item->str);
   }
 
   // Not found, so allocate a new one...
   slen = strlen(s);
-  item = (_cups_sp_item_t *)calloc(1, sizeof(_cups_sp_item_t) + slen);
+  item = (_cups_sp_item_t *)_cupsMemCalloc(CUPS_MEMTYPE_STRING, 1, sizeof(_cups_sp_item_t) + slen);
   if (!item)
   {
-    cupsMutexUnlock(&sp_mutex);
+    cupsMutexUnlock(&shard->mutex);
 
     return (NULL);
   }
 
   item->ref_count = 1;
+  item->hash      = (unsigned)hash;
+  item->len       = slen;
   memcpy(item->str, s, slen + 1);
 
 #ifdef DEBUG_GUARDS
@@ -563,14 +738,30 @@ _cupsStrAlloc(const char *s)		// I - String
 #endif // DEBUG_GUARDS
 
   // Add the string to the pool and return it...
-  cupsArrayAdd(stringpool, item);
+  cupsArrayAdd(shard->pool, item);
 
-  cupsMutexUnlock(&sp_mutex);
+  cupsMutexUnlock(&shard->mutex);
 
   return (item->str);
 }
 
 
+//
+// '_cupsStrEqual()' - Compare two pooled strings for equality.
+//
+// Note: Both strings MUST come from the string pool.  Since the pool stores
+//       a single copy of each string, pooled strings are equal only if they
+//       have the same address and no characters need to be compared.
+//
+
+bool					// O - `true` if equal, `false` otherwise
+_cupsStrEqual(const char *a,		// I - First pooled string
+              const char *b)		// I - Second pooled string
+{
+  return (a == b);
+}
+
+
 //
 // '_cupsStrFlush()' - Flush the string pool.
 //
@@ -578,93 +769,157 @@ _cupsStrAlloc(const char *s)		// I - String
 void
 _cupsStrFlush(void)
 {
+  size_t		i;		// Looping var
+  _cups_sp_shard_t	*shard;		// Current shard
   _cups_sp_item_t	*item;		// Current item
 
 
-  DEBUG_printf("4_cupsStrFlush: %u strings in array", (unsigned)cupsArrayGetCount(stringpool));
+  for (i = _CUPS_SP_SHARDS, shard = stringpool; i > 0; i --, shard ++)
+  {
+    cupsMutexLock(&shard->mutex);
 
-  cupsMutexLock(&sp_mutex);
+    DEBUG_printf("4_cupsStrFlush: %u strings in shard %u", (unsigned)cupsArrayGetCount(shard->pool), (unsigned)(shard - stringpool));
 
-  for (item = (_cups_sp_item_t *)cupsArrayGetFirst(stringpool); item; item = (_cups_sp_item_t *)cupsArrayGetNext(stringpool))
-    free(item);
+    for (item = (_cups_sp_item_t *)cupsArrayGetFirst(shard->pool); item; item = (_cups_sp_item_t *)cupsArrayGetNext(shard->pool))
+      _cupsMemFree(item);
 
-  cupsArrayDelete(stringpool);
-  stringpool = NULL;
+    cupsArrayDelete(shard->pool);
+    shard->pool = NULL;
 
-  cupsMutexUnlock(&sp_mutex);
+    cupsMutexUnlock(&shard->mutex);
+  }
 }
 
 
 //
 // '_cupsStrFormatd()' - Format a floating-point number.
 //
+// The number is formatted using the shortest string that reads back as the
+// same value, with a period (".") as the decimal point regardless of the
+// current locale.  Exponential notation is only used for very large and very
+// small numbers.  The result is at most 25 characters long, for example
+// "-0.0000012345678901234567".  The locale data is not used.
+//
 
 char *					// O - Pointer to end of string
 _cupsStrFormatd(char         *buf,	// I - String
                 char         *bufend,	// I - End of string buffer
 		double       number,	// I - Number to format
-                struct lconv *loc)	// I - Locale data
+                struct lconv *loc)	// I - Locale data (unused)
 {
-  char		*bufptr,		// Pointer into buffer
-		temp[1024],		// Temporary string
-		*tempdec,		// Pointer to decimal point
+  char		digits[32],		// Significant digits
+		temp[64],		// Temporary string
 		*tempptr;		// Pointer into temporary string
-  const char	*dec;			// Decimal point
-  int		declen;			// Length of decimal point
+  int		num_digits,		// Number of significant digits
+		exp10,			// Decimal exponent of last digit
+		point,			// Position of decimal point
+		i;			// Looping var
+  size_t	templen;		// Length of temporary string
 
 
-  // Format the number using the "%.12f" format and then eliminate unnecessary trailing 0's.
-  snprintf(temp, sizeof(temp), "%.12f", number);
-  tempptr = temp + strlen(temp) - 1;
-  while (tempptr > temp && *tempptr == '0')
-    *tempptr-- = '\0';
+  (void)loc;
 
-  // Next, find the decimal point...
-  if (loc && loc->decimal_point)
+  tempptr = temp;
+
+  if (isnan(number))
   {
-    dec    = loc->decimal_point;
-    declen = (int)strlen(dec);
+    memcpy(tempptr, "nan", 3);
+    tempptr += 3;
   }
   else
   {
-    dec    = ".";
-    declen = 1;
-  }
-
-  if (declen == 1)
-    tempdec = strchr(temp, *dec);
-  else
-    tempdec = strstr(temp, dec);
+    if (signbit(number))
+    {
+      *tempptr++ = '-';
+      number     = -number;
+    }
 
-  // Copy everything up to the decimal point...
-  if (tempdec)
-  {
-    tempptr = temp;
-    bufptr  = buf;
-    while (tempptr < tempdec && bufptr < bufend)
+    if (isinf(number))
     {
-      *bufptr++ = *tempptr++;
+      memcpy(tempptr, "inf", 3);
+      tempptr += 3;
     }
+    else if (number == 0.0)
+    {
+      *tempptr++ = '0';
+    }
+    else
+    {
+      // Get the shortest digit string, then place the decimal point...
+      num_digits = format_digits(number, digits, &exp10);
+      point      = num_digits + exp10;
 
-    tempptr += declen;
+      if (exp10 >= 0 && point <= 21)
+      {
+        // Integer: "ddd000"
+        memcpy(tempptr, digits, (size_t)num_digits);
+        tempptr += num_digits;
 
-    if (*tempptr && bufptr < bufend)
-    {
-      *bufptr++ = '.';
+        for (i = 0; i < exp10; i ++)
+          *tempptr++ = '0';
+      }
+      else if (point > 0 && point <= 21)
+      {
+        // Fixed point: "ddd.ddd"
+        memcpy(tempptr, digits, (size_t)point);
+        tempptr += point;
+        *tempptr++ = '.';
+        memcpy(tempptr, digits + point, (size_t)(num_digits - point));
+        tempptr += num_digits - point;
+      }
+      else if (point > -6 && point <= 0)
+      {
+        // Small fraction: "0.000ddd"
+        *tempptr++ = '0';
+        *tempptr++ = '.';
 
-      while (*tempptr && bufptr < bufend)
-        *bufptr++ = *tempptr++;
-    }
+        for (i = point; i < 0; i ++)
+          *tempptr++ = '0';
 
-    *bufptr = '\0';
-  }
-  else
-  {
-    cupsCopyString(buf, temp, (size_t)(bufend - buf + 1));
-    bufptr = buf + strlen(buf);
+        memcpy(tempptr, digits, (size_t)num_digits);
+        tempptr += num_digits;
+      }
+      else
+      {
+        // Exponential: "d.ddde+nnn"
+        *tempptr++ = digits[0];
+
+        if (num_digits > 1)
+        {
+          *tempptr++ = '.';
+          memcpy(tempptr, digits + 1, (size_t)(num_digits - 1));
+          tempptr += num_digits - 1;
+        }
+
+        if ((point --) > 0)
+        {
+          *tempptr++ = 'e';
+          *tempptr++ = '+';
+        }
+        else
+        {
+          *tempptr++ = 'e';
+          *tempptr++ = '-';
+          point      = -point;
+        }
+
+        if (point >= 100)
+          *tempptr++ = (char)('0' + point / 100);
+        if (point >= 10)
+          *tempptr++ = (char)('0' + (point / 10) % 10);
+        *tempptr++ = (char)('0' + point % 10);
+      }
+    }
   }
 
-  return (bufptr);
+  // Copy the formatted number to the output buffer...
+  if ((templen = (size_t)(tempptr - temp)) > (size_t)(bufend - buf))
+    templen = (size_t)(bufend - buf);
+
+  memcpy(buf, temp, templen);
+  buf[templen] = '\0';
+
+  return (buf + templen);
 }
 
 
@@ -677,6 +932,7 @@ _cupsStrFree(const char *s)		// I - String to free
 {
   _cups_sp_item_t	*item,		// String pool item
 			*key;		// Search key
+  _cups_sp_shard_t	*shard;		// String pool shard
 
 
   // Range check input...
@@ -684,11 +940,13 @@ _cupsStrFree(const char *s)		// I - String to free
     return;
 
   // See if the string is already in the pool...
-  cupsMutexLock(&sp_mutex);
+  shard = stringpool + _CUPS_SP_SHARD(hash_sp_string(s));
+
+  cupsMutexLock(&shard->mutex);
 
   key = (_cups_sp_item_t *)(s - offsetof(_cups_sp_item_t, str));
 
-  if ((item = (_cups_sp_item_t *)cupsArrayFind(stringpool, key)) != NULL && item == key)
+  if ((item = (_cups_sp_item_t *)cupsArrayFind(shard->pool, key)) != NULL && item == key)
   {
     // Found it, dereference...
 #ifdef DEBUG_GUARDS
@@ -699,18 +957,54 @@ _cupsStrFree(const char *s)		// I - String to free
     }
 #endif // DEBUG_GUARDS
 
-    item->ref_count --;
-
-    if (!item->ref_count)
+    if (cupsAtomicDec(&item->ref_count) == 0)
     {
       // Remove and free...
-      cupsArrayRemove(stringpool, item);
+      cupsArrayRemove(shard->pool, item);
 
-      free(item);
+      _cupsMemFree(item);
     }
   }
 
-  cupsMutexUnlock(&sp_mutex);
+  cupsMutexUnlock(&shard->mutex);
+}
+
+
+//
+// '_cupsStrHash()' - Get the hash of a pooled string.
+//
+// The hash is computed once when the string is added to the pool.
+//
+// Note: This function does not verify that the passed pointer is in the
+//       string pool, so any calls to it MUST know they are passing in a
+//       good pointer.
+//
+
+size_t					// O - Hash value or `0` for `NULL`
+_cupsStrHash(const char *s)		// I - Pooled string
+{
+  if (!s)
+    return (0);
+
+  return (((_cups_sp_item_t *)(s - offsetof(_cups_sp_item_t, str)))->hash);
+}
+
+
+//
+// '_cupsStrLength()' - Get the length of a pooled string.
+//
+// Note: This function does not verify that the passed pointer is in the
+//       string pool, so any calls to it MUST know they are passing in a
+//       good pointer.
+//
+
+size_t					// O - Length of string in bytes
+_cupsStrLength(const char *s)		// I - Pooled string
+{
+  if (!s)
+    return (0);
+
+  return (((_cups_sp_item_t *)(s - offsetof(_cups_sp_item_t, str)))->len);
 }
 
 
@@ -730,10 +1024,10 @@ _cupsStrRetain(const char *s)		// I - String to retain
 
   if (s)
   {
+    // The caller already holds a reference, so the string cannot be freed
+    // while we increment the reference count and no lock is needed...
     item = (_cups_sp_item_t *)(s - offsetof(_cups_sp_item_t, str));
 
-    cupsMutexLock(&sp_mutex);
-
 #ifdef DEBUG_GUARDS
     if (item->guard != _CUPS_STR_GUARD)
     {
@@ -742,9 +1036,7 @@ _cupsStrRetain(const char *s)		// I - String to retain
     }
 #endif // DEBUG_GUARDS
 
-    item->ref_count ++;
-
-    cupsMutexUnlock(&sp_mutex);
+    cupsAtomicInc(&item->ref_count);
   }
 
   return ((char *)s);
@@ -754,17 +1046,37 @@ _cupsStrRetain(const char *s)		// I - String to retain
 //
 // '_cupsStrScand()' - Scan a string for a floating-point number.
 //
-// This function handles the locale-specific BS so that a decimal
-// point is always the period (".")...
+// The number always uses a period (".") as the decimal point regardless of
+// the current locale.  Numbers whose significant digits fit in 53 bits and
+// have small exponents are converted directly.  Other numbers are converted
+// using `strtod` with the decimal point of the locale data, or of the current
+// locale when `loc` is `NULL`.
 //
 
 double					// O - Number
 _cupsStrScand(const char   *buf,	// I - Pointer to number
               char         **bufptr,	// O - New pointer or NULL on error
-              struct lconv *loc)	// I - Locale data
+              struct lconv *loc)	// I - Locale data or `NULL`
 {
-  char	temp[1024],			// Temporary buffer
-	*tempptr;			// Pointer into temporary buffer
+  const char	*start;			// Start of number
+  uint64_t	mantissa = 0;		// Significant digits
+  int		num_digits = 0,		// Number of significant digits
+		exp10 = 0,		// Decimal exponent
+		expval = 0;		// Exponent value
+  bool		negative = false,	// Negative number?
+		expneg = false,		// Negative exponent?
+		exact = true;		// Can convert directly?
+  double	number;			// Number
+  char		temp[1024],		// Temporary buffer
+		*tempptr;		// Pointer into temporary buffer
+  const char	*dec;			// Decimal point
+  size_t	declen;			// Length of decimal point
+  static const double powers[] =	// Exact powers of 10
+  {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+    1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+    1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
 
 
   // Range check input...
@@ -775,110 +1087,125 @@ _cupsStrScand(const char   *buf,	// I - Pointer to number
   while (_cups_isspace(*buf))
     buf ++;
 
-  // Copy leading sign, numbers, period, and then numbers...
-  tempptr = temp;
+  // Scan leading sign, numbers, period, numbers, and exponent...
+  start = buf;
+
   if (*buf == '-' || *buf == '+')
-    *tempptr++ = *buf++;
+    negative = *buf++ == '-';
 
-  while (isdigit(*buf & 255))
+  for (; isdigit(*buf & 255); buf ++)
   {
-    if (tempptr < (temp + sizeof(temp) - 1))
+    if (num_digits < 19)
     {
-      *tempptr++ = *buf++;
+      if (mantissa || *buf != '0')
+      {
+        mantissa = mantissa * 10 + (uint64_t)(*buf - '0');
+        num_digits ++;
+      }
     }
     else
     {
-      if (bufptr)
-	*bufptr = NULL;
-
-      return (0.0);
+      exact = false;
     }
   }
 
   if (*buf == '.')
   {
-    // Read fractional portion of number...
-    buf ++;
-
-    if (loc && loc->decimal_point)
+    // Scan fractional portion of number...
+    for (buf ++; isdigit(*buf & 255); buf ++)
     {
-      cupsCopyString(tempptr, loc->decimal_point, sizeof(temp) - (size_t)(tempptr - temp));
-      tempptr += strlen(tempptr);
-    }
-    else if (tempptr < (temp + sizeof(temp) - 1))
-    {
-      *tempptr++ = '.';
-    }
-    else
-    {
-      if (bufptr)
-        *bufptr = NULL;
-
-      return (0.0);
-    }
-
-    while (isdigit(*buf & 255))
-    {
-      if (tempptr < (temp + sizeof(temp) - 1))
+      if (num_digits < 19)
       {
-	*tempptr++ = *buf++;
+        mantissa = mantissa * 10 + (uint64_t)(*buf - '0');
+        exp10 --;
+
+        if (mantissa)
+          num_digits ++;
       }
       else
       {
-	if (bufptr)
-	  *bufptr = NULL;
-
-	return (0.0);
+        exact = false;
       }
     }
   }
 
   if (*buf == 'e' || *buf == 'E')
   {
-    // Read exponent...
-    if (tempptr < (temp + sizeof(temp) - 1))
+    // Scan exponent...
+    buf ++;
+
+    if (*buf == '+' || *buf == '-')
+      expneg = *buf++ == '-';
+
+    for (; isdigit(*buf & 255); buf ++)
     {
-      *tempptr++ = *buf++;
+      if (expval < 10000)
+        expval = expval * 10 + *buf - '0';
     }
-    else
-    {
-      if (bufptr)
-	*bufptr = NULL;
 
-      return (0.0);
-    }
+    exp10 += expneg ? -expval : expval;
+  }
 
-    if (*buf == '+' || *buf == '-')
-    {
-      if (tempptr < (temp + sizeof(temp) - 1))
-      {
-	*tempptr++ = *buf++;
-      }
-      else
-      {
-	if (bufptr)
-	  *bufptr = NULL;
+  if (exact && mantissa <= (UINT64_C(1) << 53) && exp10 >= -22 && exp10 <= 22)
+  {
+    // Both the mantissa and power of 10 are exact, so a single multiply or
+    // divide gives a correctly rounded result...
+    if (bufptr)
+      *bufptr = (char *)buf;
 
-	return (0.0);
-      }
-    }
+    number = (double)mantissa;
+
+    if (exp10 > 0)
+      number *= powers[exp10];
+    else if (exp10 < 0)
+      number /= powers[-exp10];
+
+    return (negative ? -number : number);
+  }
+
+  // Copy the number to a temporary buffer using the locale's decimal point...
+  if (!loc)
+    loc = localeconv();
+
+  if (loc && loc->decimal_point)
+  {
+    dec    = loc->decimal_point;
+    declen = strlen(dec);
+  }
+  else
+  {
+    dec    = ".";
+    declen = 1;
+  }
 
-    while (isdigit(*buf & 255))
+  for (tempptr = temp; start < buf; start ++)
+  {
+    if (*start == '.')
     {
-      if (tempptr < (temp + sizeof(temp) - 1))
-      {
-	*tempptr++ = *buf++;
-      }
-      else
-      {
-	if (bufptr)
-	  *bufptr = NULL;
+      if (declen > (size_t)(temp + sizeof(temp) - 1 - tempptr))
+        break;
 
-	return (0.0);
-      }
+      memcpy(tempptr, dec, declen);
+      tempptr += declen;
+    }
+    else if (tempptr < (temp + sizeof(temp) - 1))
+    {
+      *tempptr++ = *start;
+    }
+    else
+    {
+      break;
     }
   }
 
+  if (start < buf)
+  {
+    if (bufptr)
+      *bufptr = NULL;
+
+    return (0.0);
+  }
+
   // Nul-terminate the temporary string and return the value...
   if (bufptr)
     *bufptr = (char *)buf;
@@ -900,23 +1227,30 @@ _cupsStrStatistics(size_t *alloc_bytes,	// O - Allocated bytes
   size_t		count,		// Number of strings
 			abytes,		// Allocated string bytes
 			tbytes,		// Total string bytes
-			len;		// Length of string
+			len,		// Length of string
+			refs,		// Reference count of string
+			i;		// Looping var
+  _cups_sp_shard_t	*shard;		// Current shard
   _cups_sp_item_t	*item;		// Current item
 
 
   // Loop through strings in pool, counting everything up...
-  cupsMutexLock(&sp_mutex);
-
-  for (count = 0, abytes = 0, tbytes = 0, item = (_cups_sp_item_t *)cupsArrayGetFirst(stringpool); item; item = (_cups_sp_item_t *)cupsArrayGetNext(stringpool))
+  for (i = _CUPS_SP_SHARDS, shard = stringpool, count = 0, abytes = 0, tbytes = 0; i > 0; i --, shard ++)
   {
-    // Count allocated memory, using a 64-bit aligned buffer as a basis.
-    count  += item->ref_count;
-    len    = (strlen(item->str) + 8) & (size_t)~7;
-    abytes += sizeof(_cups_sp_item_t) + len;
-    tbytes += item->ref_count * len;
-  }
+    cupsMutexLock(&shard->mutex);
 
-  cupsMutexUnlock(&sp_mutex);
+    for (item = (_cups_sp_item_t *)cupsArrayGetFirst(shard->pool); item; item = (_cups_sp_item_t *)cupsArrayGetNext(shard->pool))
+    {
+      // Count allocated memory, using a 64-bit aligned buffer as a basis.
+      refs   = (size_t)cupsAtomicGet(&item->ref_count);
+      count  += refs;
+      len    = (strlen(item->str) + 8) & (size_t)~7;
+      abytes += sizeof(_cups_sp_item_t) + len;
+      tbytes += refs * len;
+    }
+
+    cupsMutexUnlock(&shard->mutex);
+  }
 
   // Return values...
   if (alloc_bytes)
@@ -1011,7 +1345,331 @@ static int				// O - Result of comparison
 compare_sp_items(_cups_sp_item_t *a,	// I - First item
                  _cups_sp_item_t *b)	// I - Second item
 {
-  return (strcmp(a->str, b->str));
+  if (a == b)
+    return (0);
+  else
+    return (strcmp(a->str, b->str));
+}
+
+
+//
+// 'format_digits()' - Get the shortest significant digits of a number.
+//
+// This uses the Grisu2 algorithm, which finds the shortest digit string in the
+// rounding interval of the number using 64-bit integer arithmetic.  Grisu2
+// always produces digits that read back as the same number, and most of the
+// time those digits are also the shortest possible.
+//
+// The number must be finite and greater than 0.
+//
+
+static int				// O - Number of digits
+format_digits(double number,		// I - Number
+              char   *digits,		// O - Digits (not nul-terminated)
+              int    *exp10)		// O - Decimal exponent of last digit
+{
+  union
+  {
+    double	d;			// Number
+    uint64_t	u;			// Bits
+  }		bits;			// Bits of number
+  _cups_diyfp_t	v,			// Number
+		mp,			// Upper boundary
+		mm,			// Lower boundary
+		cp,			// Cached power of 10
+		one;			// 1.0 with exponent of upper boundary
+  uint64_t	delta,			// Width of rounding interval
+		wp_w,			// Distance from number to upper boundary
+		p2,			// Fraction part of upper boundary
+		tmp;			// Remainder
+  uint32_t	p1;			// Integer part of upper boundary
+  int		kappa,			// Current digit position
+		num_digits = 0,		// Number of digits
+		index;			// Index into powers of 10
+  double	dk;			// Estimated power of 10
+  static const uint64_t hidden = UINT64_C(0x0010000000000000);
+					// Hidden bit of a double
+
+
+  // Get the significand and exponent...
+  bits.d = number;
+  v.f    = bits.u & (hidden - 1);
+
+  if ((v.e = (int)((bits.u >> 52) & 0x7ff)) != 0)
+  {
+    v.f |= hidden;
+    v.e -= 1075;
+  }
+  else
+  {
+    v.e = -1074;
+  }
+
+  // Compute the normalized boundaries m+ and m- of the rounding interval...
+  mp.f = (v.f << 1) + 1;
+  mp.e = v.e - 1;
+
+  while (!(mp.f & (hidden << 1)))
+  {
+    mp.f <<= 1;
+    mp.e --;
+  }
+
+  mp.f <<= 10;
+  mp.e -= 10;
+
+  if (v.f == hidden)
+  {
+    mm.f = (v.f << 2) - 1;
+    mm.e = v.e - 2;
+  }
+  else
+  {
+    mm.f = (v.f << 1) - 1;
+    mm.e = v.e - 1;
+  }
+
+  mm.f <<= mm.e - mp.e;
+  mm.e = mp.e;
+
+  while (!(v.f & (UINT64_C(1) << 63)))
+  {
+    v.f <<= 1;
+    v.e --;
+  }
+
+  // Scale by a cached power of 10 so the upper boundary's exponent is between
+  // -60 and -32...
+  dk = (-61 - mp.e) * 0.30102999566398114 + 347;
+  if ((index = (int)dk) < dk)
+    index ++;
+
+  index  = (index >> 3) + 1;
+  *exp10 = 348 - index * 8;
+  cp     = powers10[index];
+
+  v    = format_multiply(v, cp);
+  mp   = format_multiply(mp, cp);
+  mm   = format_multiply(mm, cp);
+  mp.f --;
+  mm.f ++;
+
+  // Generate digits of the upper boundary until they are inside the rounding
+  // interval...
+  delta = mp.f - mm.f;
+  wp_w  = mp.f - v.f;
+  one.e = mp.e;
+  one.f = UINT64_C(1) << -one.e;
+  p1    = (uint32_t)(mp.f >> -one.e);
+  p2    = mp.f & (one.f - 1);
+
+  for (kappa = 1; kappa < 10 && p1 >= ipowers10[kappa]; kappa ++);
+
+  while (kappa > 0)
+  {
+    uint32_t d = (uint32_t)(p1 / ipowers10[kappa - 1]);
+					// Current digit
+
+    p1 %= (uint32_t)ipowers10[kappa - 1];
+
+    if (d || num_digits)
+      digits[num_digits ++] = (char)('0' + d);
+
+    kappa --;
+    tmp = ((uint64_t)p1 << -one.e) + p2;
+
+    if (tmp <= delta)
+    {
+      *exp10 += kappa;
+      format_round(digits, num_digits, delta, tmp, ipowers10[kappa] << -one.e, wp_w);
+      return (num_digits);
+    }
+  }
+
+  for (;;)
+  {
+    p2    *= 10;
+    delta *= 10;
+
+    if ((p2 >> -one.e) || num_digits)
+      digits[num_digits ++] = (char)('0' + (p2 >> -one.e));
+
+    p2 &= one.f - 1;
+    kappa --;
+
+    if (p2 < delta)
+    {
+      *exp10 += kappa;
+      format_round(digits, num_digits, delta, p2, one.f, -kappa < 20 ? wp_w * ipowers10[-kappa] : 0);
+      return (num_digits);
+    }
+  }
+}
+
+
+//
+// 'format_integer()' - Format an integer for `cupsFormatStringv`.
+//
+// This handles the "d", "i", "o", "u", "x", and "X" conversions with the
+// space, "-", "+", and "#" flags, zero padding, width, and precision just like
+// `snprintf` does.  The buffer must have room for the width or precision plus
+// 3 characters.
+//
+
+static size_t				// O - Length of formatted integer
+format_integer(char               *buffer,// I - Output buffer (not nul-terminated)
+               unsigned long long value,// I - Absolute value
+               bool               negative,// I - Negative value?
+               char               type,	// I - Format type character
+               char               flag,	// I - Flag character or `'\0'`
+               bool               zero,	// I - Pad with zeros?
+               int                width,// I - Width of field
+               int                prec)	// I - Precision or `-1` for none
+{
+  char		digits[32],		// Digits in reverse order
+		*bufptr = buffer;	// Pointer into buffer
+  const char	*prefix = "";		// Sign or base prefix
+  const char	*chars = type == 'X' ? "0123456789ABCDEF" : "0123456789abcdef";
+					// Digit characters
+  unsigned	base = type == 'o' ? 8 : (type == 'x' || type == 'X') ? 16 : 10;
+					// Number base
+  int		num_digits = 0,		// Number of digits
+		num_zeros,		// Number of leading zeros
+		num_pad,		// Number of padding spaces
+		len;			// Length without padding
+
+
+  // Convert the digits; a precision of 0 with value 0 yields no digits...
+  if (value || prec != 0)
+  {
+    do
+    {
+      digits[num_digits ++] = chars[value % base];
+      value /= base;
+    }
+    while (value);
+  }
+
+  // Get the sign or base prefix...
+  if (negative)
+    prefix = "-";
+  else if (type == 'd' || type == 'i')
+    prefix = flag == '+' ? "+" : flag == ' ' ? " " : "";
+  else if (flag == '#' && type == 'o' && (num_digits == 0 || digits[num_digits - 1] != '0') && prec <= num_digits)
+    prec = num_digits + 1;
+  else if (flag == '#' && base == 16 && num_digits > 0 && (num_digits > 1 || digits[0] != '0'))
+    prefix = type == 'X' ? "0X" : "0x";
+
+  // Figure out the zeros and padding...
+  num_zeros = prec > num_digits ? prec - num_digits : 0;
+  len       = (int)strlen(prefix) + num_zeros + num_digits;
+
+  if (zero && flag != '-' && prec < 0 && width > len)
+  {
+    num_zeros += width - len;
+    len       = width;
+  }
+
+  num_pad = width > len ? width - len : 0;
+
+  // Copy the pieces...
+  if (flag != '-')
+  {
+    memset(bufptr, ' ', (size_t)num_pad);
+    bufptr += num_pad;
+  }
+
+  while (*prefix)
+    *bufptr++ = *prefix++;
+
+  memset(bufptr, '0', (size_t)num_zeros);
+  bufptr += num_zeros;
+
+  while (num_digits > 0)
+    *bufptr++ = digits[-- num_digits];
+
+  if (flag == '-')
+  {
+    memset(bufptr, ' ', (size_t)num_pad);
+    bufptr += num_pad;
+  }
+
+  return ((size_t)(bufptr - buffer));
+}
+
+
+//
+// 'format_multiply()' - Multiply two 64-bit significands, rounding the result.
+//
+
+static _cups_diyfp_t			// O - Product
+format_multiply(_cups_diyfp_t a,	// I - First value
+                _cups_diyfp_t b)	// I - Second value
+{
+  _cups_diyfp_t	p;			// Product
+  uint64_t	ah = a.f >> 32,		// High 32 bits of a
+		al = a.f & 0xffffffff,	// Low 32 bits of a
+		bh = b.f >> 32,		// High 32 bits of b
+		bl = b.f & 0xffffffff,	// Low 32 bits of b
+		mid;			// Middle 64 bits of product
+
+
+  mid = ((al * bl) >> 32) + ((ah * bl) & 0xffffffff) + ((al * bh) & 0xffffffff) + (UINT64_C(1) << 31);
+  p.f = ah * bh + ((ah * bl) >> 32) + ((al * bh) >> 32) + (mid >> 32);
+  p.e = a.e + b.e + 64;
+
+  return (p);
+}
+
+
+//
+// 'format_round()' - Move the last digit closer to the number.
+//
+
+static void
+format_round(char     *digits,		// I - Digits
+             int      num_digits,	// I - Number of digits
+             uint64_t delta,		// I - Width of rounding interval
+             uint64_t rest,		// I - Distance from digits to upper boundary
+             uint64_t ten_kappa,	// I - Value of last digit
+             uint64_t wp_w)		// I - Distance from number to upper boundary
+{
+  while (rest < wp_w && (delta - rest) >= ten_kappa && ((rest + ten_kappa) < wp_w || (wp_w - rest) > (rest + ten_kappa - wp_w)))
+  {
+    digits[num_digits - 1] --;
+    rest += ten_kappa;
+  }
+}
+
+
+//
+// 'hash_sp_item()' - Compute the hash of a string pool item.
+//
+
+static size_t				// O - Hash value
+hash_sp_item(_cups_sp_item_t *item)	// I - Item
+{
+  return (hash_sp_string(item->str));
+}
+
+
+//
+// 'hash_sp_string()' - Compute the hash of a string.
+//
+// This uses the 32-bit FNV-1a hash function.  The low bits select the slot in a
+// shard's hash table and the high bits select the shard.
+//
+
+static size_t				// O - Hash value
+hash_sp_string(const char *s)		// I - String
+{
+  size_t	hash = 2166136261U;	// Hash value
+
+
+  for (; *s; s ++)
+    hash = ((hash ^ (unsigned char)*s) * 16777619U) & 0xffffffffU;
+
+  return (hash);
 }
 
 
@@ -18,6 +18,72 @@
 #else
 #  include <unistd.h>
 #endif // _WIN32 || __EMX__
+#ifdef HAVE_MEMFD_CREATE
+#  include <sys/mman.h>
+#endif // HAVE_MEMFD_CREATE
+
+
+//
+// 'cupsCreateAnonymousFd()' - Creates an anonymous temporary file.
+//
+// This function creates a temporary file without a name and returns a file
+// descriptor for the file.  The file is removed automatically when the last
+// file descriptor for it is closed, so there is nothing to clean up and the
+// file descriptor can be passed to child processes.  The file is opened for
+// reading and writing.
+//
+// When "in_memory" is `true`, the file is stored in memory (`memfd_create`)
+// on systems that support it.  Otherwise, the file is created in the temporary
+// directory without a name (`O_TMPFILE`) when supported, or is created with
+// @link cupsCreateTempFd@ and immediately removed.
+//
+
+int					// O - New file descriptor or `-1` on error
+cupsCreateAnonymousFd(bool in_memory)	// I - `true` to store the file in memory, `false` to use the temporary directory
+{
+  int		fd;			// File descriptor for temp file
+  char		filename[1024];		// Temporary filename
+
+
+#ifdef HAVE_MEMFD_CREATE
+  // Use a memory file as requested...
+  if (in_memory && (fd = memfd_create("cups", 0)) >= 0)
+    return (fd);
+#else
+  (void)in_memory;
+#endif // HAVE_MEMFD_CREATE
+
+#ifdef O_TMPFILE
+  // Try creating an unnamed file in the temporary directory...
+  const char	*tmpdir;		// TMPDIR environment var
+
+  if ((tmpdir = getenv("TMPDIR")) == NULL)
+    tmpdir = "/tmp";
+
+  if ((fd = open(tmpdir, O_TMPFILE | O_RDWR, 0600)) >= 0)
+    return (fd);
+#endif // O_TMPFILE
+
+  // Fall back on a named temporary file that is removed right away...
+  if ((fd = cupsCreateTempFd(NULL, NULL, filename, sizeof(filename))) >= 0)
+  {
+#ifdef _WIN32
+    // Windows cannot remove an open file, so open it again as a temporary
+    // file that is removed when closed...
+    int	tempfd = open(filename, _O_RDWR | _O_BINARY | _O_TEMPORARY);
+					// Temporary file descriptor
+
+    close(fd);
+
+    if ((fd = tempfd) < 0)
+      unlink(filename);
+#else
+    unlink(filename);
+#endif // _WIN32
+  }
+
+  return (fd);
+}
 
 
 //
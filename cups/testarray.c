@@ -21,6 +21,7 @@
 //
 
 static double	get_seconds(void);
+static size_t	hash_string(const char *s, void *data);
 static int	load_words(const char *filename, cups_array_t *array);
 
 
@@ -43,11 +44,35 @@ main(void)
   cups_dentry_t	*dent;			// Directory entry
   char		*saved[32];		// Saved entries
   void		*data;			// User data for arrays
+  cups_array_iter_t iter;		// Array iterator
+  cups_memstats_t before,		// Memory statistics before test
+		during,			// Memory statistics during test
+		after;			// Memory statistics after test
+  static const char * const batch[] =
+  {					// Batch of strings
+    "foo", "bar", "zoo", "bar"
+  };
+  static const char * const batch_sorted[] =
+  {					// Sorted strings
+    "bar", "bar", "foo", "foo", "moo", "zoo"
+  };
 
 
   // No errors so far...
   status = 0;
 
+  // cupsSetMemoryStats() must be called before anything else...
+  testBegin("cupsSetMemoryStats(true)");
+  if (cupsSetMemoryStats(true))
+  {
+    testEnd(true);
+  }
+  else
+  {
+    testEnd(false);
+    status = 1;
+  }
+
   // cupsArrayNew()
   testBegin("cupsArrayNew");
 
@@ -345,6 +370,214 @@ main(void)
   cupsArrayDelete(array);
   cupsArrayDelete(dup_array);
 
+  // Test a large array that uses chunks...
+  testBegin("cupsArrayAdd(10000 strings)");
+  array = cupsArrayNewStrings(NULL, ',');
+
+  for (i = 0; i < 10000; i ++)
+  {
+    snprintf(word, sizeof(word), "%05d", (i * 7919) % 10000);
+    if (!cupsArrayAdd(array, word))
+      break;
+  }
+
+  if (i < 10000)
+  {
+    testEndMessage(false, "add failed at %d", i);
+    status ++;
+  }
+  else
+  {
+    for (i = 0, text = (char *)cupsArrayGetFirst(array); text; i ++, text = (char *)cupsArrayGetNext(array))
+    {
+      snprintf(word, sizeof(word), "%05d", i);
+      if (strcmp(text, word) || cupsArrayGetIndex(array) != (size_t)i)
+        break;
+    }
+
+    if (i != 10000)
+    {
+      testEndMessage(false, "element %d is \"%s\"", i, text ? text : "(null)");
+      status ++;
+    }
+    else
+    {
+      testEnd(true);
+    }
+  }
+
+  testBegin("cupsArrayIterNext/Prev(10000 strings)");
+  cupsArrayGetElement(array, 1234);
+  cupsArrayIterInit(array, &iter);
+
+  for (i = 0; (text = (char *)cupsArrayIterNext(&iter)) != NULL; i ++)
+  {
+    if (text != cupsArrayGetElement(array, (size_t)i))
+      break;
+  }
+
+  if (i != 10000)
+  {
+    testEndMessage(false, "forward element %d is \"%s\"", i, text ? text : "(null)");
+    status ++;
+  }
+  else
+  {
+    for (i = 9999; (text = (char *)cupsArrayIterPrev(&iter)) != NULL; i --)
+    {
+      if (text != cupsArrayGetElement(array, (size_t)i))
+        break;
+    }
+
+    if (i != -1)
+    {
+      testEndMessage(false, "reverse element %d is \"%s\"", i, text ? text : "(null)");
+      status ++;
+    }
+    else
+    {
+      testEnd(true);
+    }
+  }
+
+  testBegin("cupsArrayRemove(9900 strings)");
+  for (i = 0; i < 10000; i ++)
+  {
+    if (i % 100)
+    {
+      snprintf(word, sizeof(word), "%05d", i);
+      if (!cupsArrayRemove(array, word))
+        break;
+    }
+  }
+
+  if (i < 10000)
+  {
+    testEndMessage(false, "remove failed at %d", i);
+    status ++;
+  }
+  else if (cupsArrayGetCount(array) != 100)
+  {
+    testEndMessage(false, "%u elements, expected 100", (unsigned)cupsArrayGetCount(array));
+    status ++;
+  }
+  else
+  {
+    for (i = 0, text = (char *)cupsArrayGetFirst(array); text; i ++, text = (char *)cupsArrayGetNext(array))
+    {
+      snprintf(word, sizeof(word), "%05d", i * 100);
+      if (strcmp(text, word))
+        break;
+    }
+
+    if (i != 100)
+    {
+      testEndMessage(false, "element %d is \"%s\"", i, text ? text : "(null)");
+      status ++;
+    }
+    else
+    {
+      testEnd(true);
+    }
+  }
+
+  cupsArrayDelete(array);
+
+  // Test adding a batch of strings...
+  testBegin("cupsArrayAddBatch");
+  array = cupsArrayNewStrings("foo,moo", ',');
+
+  if (!cupsArrayAddBatch(array, (void **)batch, sizeof(batch) / sizeof(batch[0])))
+  {
+    testEndMessage(false, "returned false");
+    status ++;
+  }
+  else if (cupsArrayGetCount(array) != 6)
+  {
+    testEndMessage(false, "%u elements, expected 6", (unsigned)cupsArrayGetCount(array));
+    status ++;
+  }
+  else
+  {
+    for (i = 0, text = (char *)cupsArrayGetFirst(array); text; i ++, text = (char *)cupsArrayGetNext(array))
+    {
+      if (strcmp(text, batch_sorted[i]))
+        break;
+    }
+
+    if (i != 6)
+    {
+      testEndMessage(false, "element %d is \"%s\", expected \"%s\"", i, text ? text : "(null)", i < 6 ? batch_sorted[i] : "(null)");
+      status ++;
+    }
+    else if (cupsArrayGetInsert(array) != 1)
+    {
+      testEndMessage(false, "insert index %u, expected 1", (unsigned)cupsArrayGetInsert(array));
+      status ++;
+    }
+    else
+    {
+      testEnd(true);
+    }
+  }
+
+  cupsArrayDelete(array);
+
+  // Test a hashed array...
+  testBegin("cupsArrayNewHashed");
+  array = cupsArrayNewHashed((cups_ahash_cb_t)hash_string, (cups_array_cb_t)strcmp, NULL, (cups_acopy_cb_t)strdup, (cups_afree_cb_t)free);
+
+  if (!array)
+  {
+    testEndMessage(false, "returned NULL");
+    status ++;
+  }
+  else
+  {
+    for (i = 0; i < 1000; i ++)
+    {
+      snprintf(word, sizeof(word), "word%d", i);
+      if (!cupsArrayAdd(array, word))
+        break;
+    }
+
+    for (i = 0; i < 1000; i += 2)
+    {
+      snprintf(word, sizeof(word), "word%d", i);
+      if (!cupsArrayRemove(array, word))
+        break;
+    }
+
+    if (cupsArrayGetCount(array) != 500)
+    {
+      testEndMessage(false, "%u elements, expected 500", (unsigned)cupsArrayGetCount(array));
+      status ++;
+    }
+    else
+    {
+      for (i = 0; i < 1000; i ++)
+      {
+        snprintf(word, sizeof(word), "word%d", i);
+        text = (char *)cupsArrayFind(array, word);
+
+        if ((i & 1) != (text != NULL) || (text && strcmp(text, word)))
+          break;
+      }
+
+      if (i < 1000)
+      {
+        testEndMessage(false, "cupsArrayFind(\"%s\") returned %s", word, text ? text : "NULL");
+        status ++;
+      }
+      else
+      {
+        testEnd(true);
+      }
+    }
+
+    cupsArrayDelete(array);
+  }
+
   // Test the array with string functions...
   testBegin("cupsArrayNewStrings(\" \\t\\nfoo bar\\tboo\\nfar\", ' ')");
   array = cupsArrayNewStrings(" \t\nfoo bar\tboo\nfar", ' ');
@@ -453,6 +686,52 @@ main(void)
 
   cupsArrayDelete(array);
 
+  // Test the memory statistics...
+  testBegin("cupsSetAllocator(after allocation)");
+  if (cupsSetAllocator(NULL, NULL, NULL, NULL))
+  {
+    testEndMessage(false, "unexpected success");
+    status = 1;
+  }
+  else
+  {
+    testEnd(true);
+  }
+
+  testBegin("cupsGetMemoryStats(CUPS_MEMTYPE_ARRAY)");
+  if (!cupsGetMemoryStats(CUPS_MEMTYPE_ARRAY, &before))
+  {
+    testEndMessage(false, "statistics not enabled");
+    status = 1;
+  }
+  else
+  {
+    array = cupsArrayNewStrings("foo,bar,boo,far", ',');
+    cupsGetMemoryStats(CUPS_MEMTYPE_ARRAY, &during);
+    cupsArrayDelete(array);
+    cupsGetMemoryStats(CUPS_MEMTYPE_ARRAY, &after);
+
+    if (during.bytes <= before.bytes || during.allocs <= before.allocs)
+    {
+      testEndMessage(false, "bytes=%u, allocs=%u after cupsArrayNewStrings, expected more than %u and %u", (unsigned)during.bytes, (unsigned)during.allocs, (unsigned)before.bytes, (unsigned)before.allocs);
+      status = 1;
+    }
+    else if (after.bytes != before.bytes || after.allocs != before.allocs)
+    {
+      testEndMessage(false, "bytes=%u, allocs=%u after cupsArrayDelete, expected %u and %u", (unsigned)after.bytes, (unsigned)after.allocs, (unsigned)before.bytes, (unsigned)before.allocs);
+      status = 1;
+    }
+    else if (after.peak_bytes < during.bytes || after.total_allocs <= before.total_allocs)
+    {
+      testEndMessage(false, "peak_bytes=%u, total_allocs=%u, expected at least %u and more than %u", (unsigned)after.peak_bytes, (unsigned)after.total_allocs, (unsigned)during.bytes, (unsigned)before.total_allocs);
+      status = 1;
+    }
+    else
+    {
+      testEndMessage(true, "%u bytes peak", (unsigned)after.peak_bytes);
+    }
+  }
+
   return (status);
 }
 
@@ -485,6 +764,26 @@ get_seconds(void)
 #endif // _WIN32
 
 
+//
+// 'hash_string()' - Compute a simple hash of a string.
+//
+
+static size_t				// O - Hash value
+hash_string(const char *s,		// I - String
+            void       *data)		// I - User data (unused)
+{
+  size_t	hash = 0;		// Hash value
+
+
+  (void)data;
+
+  while (*s)
+    hash = 31 * hash + (unsigned char)*s++;
+
+  return (hash);
+}
+
+
 //
 // 'load_words()' - Load words from a file.
 //
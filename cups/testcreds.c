@@ -46,6 +46,7 @@
 #include "cups-private.h"
 #include "test-internal.h"
 #include <sys/stat.h>
+#include <sys/wait.h>
 #include <poll.h>
 
 
@@ -56,10 +57,24 @@
 #define TEST_CERT_PATH	".testssl"
 
 
+//
+// Local types...
+//
+
+typedef struct _testcreds_async_s	// Asynchronous creation data
+{
+  cups_mutex_t	mutex;			// Mutex for data
+  cups_cond_t	cond;			// Condition for completion
+  bool		done,			// Is creation done?
+		success;		// Were the credentials created?
+} _testcreds_async_t;
+
+
 //
 // Local functions...
 //
 
+static void	async_cb(_testcreds_async_t *async, const char *common_name, bool success);
 static int	do_unit_tests(void);
 static int	test_ca(const char *common_name, const char *csrfile, const char *root_name, int days);
 static int	test_cert(bool ca_cert, cups_credpurpose_t purpose, cups_credtype_t type, cups_credusage_t keyusage, const char *organization, const char *org_unit, const char *locality, const char *state, const char *country, const char *root_name, const char *common_name, size_t num_alt_names, const char **alt_names, int days);
@@ -396,6 +411,26 @@ main(int  argc,				// I - Number of command-line arguments
 }
 
 
+//
+// 'async_cb()' - Record the result of asynchronous credential creation.
+//
+
+static void
+async_cb(_testcreds_async_t *async,	// I - Asynchronous creation data
+         const char         *common_name,
+					// I - Common name
+         bool               success)	// I - `true` if created, `false` otherwise
+{
+  (void)common_name;
+
+  cupsMutexLock(&async->mutex);
+  async->done    = true;
+  async->success = success;
+  cupsCondBroadcast(&async->cond);
+  cupsMutexUnlock(&async->mutex);
+}
+
+
 //
 // 'do_unit_tests()' - Do unit tests.
 //
@@ -405,6 +440,13 @@ do_unit_tests(void)
 {
   cups_credtype_t	type;		// Current credential type
   char			*data;		// Cert data
+  http_trust_t		trust;		// Trust evaluation
+  _testcreds_async_t	async;		// Asynchronous creation data
+  int			i;		// Looping var
+  pid_t			pid;		// Child process ID
+  int			status;		// Child exit status
+  char			*childkey,	// Private key from child
+			*parentkey;	// Private key from parent
   static const char * const alt_names[] =
   {					// subjectAltName values
     "printer.example.com",
@@ -446,9 +488,56 @@ do_unit_tests(void)
 
     testBegin("cupsCreateCredentials(printer w/alt names, %s, signed by CA cert)", types[type]);
     if (cupsCreateCredentials(TEST_CERT_PATH, false, CUPS_CREDPURPOSE_SERVER_AUTH, type, CUPS_CREDUSAGE_DEFAULT_TLS, "Organization", "Unit", "Locality", "Ontario", "CA", "printer", "admin@example.com", sizeof(alt_names) / sizeof(alt_names[0]), alt_names, "_site_", time(NULL) + 30 * 86400))
+    {
       testEnd(true);
+
+      if ((data = cupsCopyCredentials(TEST_CERT_PATH, "printer")) != NULL)
+      {
+        // Check trust twice, the second time should use the cached decision...
+        testBegin("cupsGetCredentialsTrust(printer)");
+        if ((trust = cupsGetCredentialsTrust(TEST_CERT_PATH, "printer", data)) == HTTP_TRUST_OK)
+          testEnd(true);
+        else
+          testEndMessage(false, "%d (%s)", trust, cupsGetErrorString());
+
+        testBegin("cupsGetCredentialsTrust(printer, cached)");
+        if ((trust = cupsGetCredentialsTrust(TEST_CERT_PATH, "printer", data)) == HTTP_TRUST_OK)
+          testEnd(true);
+        else
+          testEndMessage(false, "%d (%s)", trust, cupsGetErrorString());
+
+        // Replacing the stored credentials must not use the cached decision...
+        testBegin("cupsGetCredentialsTrust(altprinter)");
+        if (!cupsSaveCredentials(TEST_CERT_PATH, "altprinter", data, NULL))
+        {
+          testEndMessage(false, "%s", cupsGetErrorString());
+        }
+        else if ((trust = cupsGetCredentialsTrust(TEST_CERT_PATH, "altprinter", data)) != HTTP_TRUST_OK)
+        {
+          testEndMessage(false, "%d (%s)", trust, cupsGetErrorString());
+        }
+        else
+        {
+          char *tdata = cupsCopyCredentials(TEST_CERT_PATH, "_site_");
+					// Different credentials
+
+          if (!tdata || !cupsSaveCredentials(TEST_CERT_PATH, "altprinter", tdata, NULL))
+            testEndMessage(false, "%s", cupsGetErrorString());
+          else if ((trust = cupsGetCredentialsTrust(TEST_CERT_PATH, "altprinter", data)) == HTTP_TRUST_OK)
+            testEndMessage(false, "Used cached trust after credentials changed");
+          else
+            testEnd(true);
+
+          free(tdata);
+        }
+
+        free(data);
+      }
+    }
     else
+    {
       testEndMessage(false, "%s", cupsGetErrorString());
+    }
 
     testBegin("cupsCreateCredentialsRequest(altprinter w/alt names, %s)", types[type]);
     if (cupsCreateCredentialsRequest(TEST_CERT_PATH, CUPS_CREDPURPOSE_SERVER_AUTH, type, CUPS_CREDUSAGE_DEFAULT_TLS, "Organization", "Unit", "Locality", "Ontario", "CA", "altprinter", "admin@example.com", sizeof(alt_names) / sizeof(alt_names[0]), alt_names))
@@ -524,6 +613,84 @@ do_unit_tests(void)
     }
   }
 
+  // Create credentials in the background using pre-generated keys...
+  testBegin("cupsSetCredentialsKeyPool(ecdsa-p256, 2)");
+  testEnd(cupsSetCredentialsKeyPool(CUPS_CREDTYPE_ECDSA_P256_SHA256, 2));
+
+  memset(&async, 0, sizeof(async));
+  cupsMutexInit(&async.mutex);
+  cupsCondInit(&async.cond);
+
+  testBegin("cupsCreateCredentialsAsync(asyncprinter, ecdsa-p256)");
+  if (cupsCreateCredentialsAsync(TEST_CERT_PATH, false, CUPS_CREDPURPOSE_SERVER_AUTH, CUPS_CREDTYPE_ECDSA_P256_SHA256, CUPS_CREDUSAGE_DEFAULT_TLS, "Organization", "Unit", "Locality", "Ontario", "CA", "asyncprinter", /*email*/NULL, sizeof(alt_names) / sizeof(alt_names[0]), alt_names, /*root_name*/NULL, time(NULL) + 30 * 86400, (cups_cred_cb_t)async_cb, &async))
+  {
+    cupsMutexLock(&async.mutex);
+    for (i = 0; i < 30 && !async.done; i ++)
+      cupsCondWait(&async.cond, &async.mutex, 1.0);
+    cupsMutexUnlock(&async.mutex);
+
+    if (!async.done)
+    {
+      testEndMessage(false, "timeout");
+    }
+    else if (!async.success)
+    {
+      testEndMessage(false, "callback reported failure");
+    }
+    else
+    {
+      testEnd(true);
+
+      testBegin("cupsCopyCredentials(asyncprinter)");
+      data = cupsCopyCredentials(TEST_CERT_PATH, "asyncprinter");
+      testEnd(data != NULL);
+      free(data);
+    }
+  }
+  else
+  {
+    testEndMessage(false, "%s", cupsGetErrorString());
+  }
+
+  // Make sure a child process doesn't reuse the parent's pre-generated keys...
+  testBegin("cupsCreateCredentials(forkchild+forkparent, ecdsa-p256)");
+  sleep(1);				// Let the key pool refill
+
+  if ((pid = fork()) == 0)
+  {
+    _exit(cupsCreateCredentials(TEST_CERT_PATH, false, CUPS_CREDPURPOSE_SERVER_AUTH, CUPS_CREDTYPE_ECDSA_P256_SHA256, CUPS_CREDUSAGE_DEFAULT_TLS, "Organization", "Unit", "Locality", "Ontario", "CA", "forkchild", /*email*/NULL, sizeof(alt_names) / sizeof(alt_names[0]), alt_names, /*root_name*/NULL, time(NULL) + 30 * 86400) ? 0 : 1);
+  }
+  else if (pid < 0)
+  {
+    testEndMessage(false, "fork: %s", strerror(errno));
+  }
+  else if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status))
+  {
+    testEndMessage(false, "child process failed");
+  }
+  else if (!cupsCreateCredentials(TEST_CERT_PATH, false, CUPS_CREDPURPOSE_SERVER_AUTH, CUPS_CREDTYPE_ECDSA_P256_SHA256, CUPS_CREDUSAGE_DEFAULT_TLS, "Organization", "Unit", "Locality", "Ontario", "CA", "forkparent", /*email*/NULL, sizeof(alt_names) / sizeof(alt_names[0]), alt_names, /*root_name*/NULL, time(NULL) + 30 * 86400))
+  {
+    testEndMessage(false, "%s", cupsGetErrorString());
+  }
+  else
+  {
+    childkey  = cupsCopyCredentialsKey(TEST_CERT_PATH, "forkchild");
+    parentkey = cupsCopyCredentialsKey(TEST_CERT_PATH, "forkparent");
+
+    if (!childkey || !parentkey)
+      testEndMessage(false, "unable to copy keys");
+    else if (!strcmp(childkey, parentkey))
+      testEndMessage(false, "child and parent used the same key");
+    else
+      testEnd(true);
+
+    free(childkey);
+    free(parentkey);
+  }
+
+  testBegin("cupsSetCredentialsKeyPool(ecdsa-p256, 0)");
+  testEnd(cupsSetCredentialsKeyPool(CUPS_CREDTYPE_ECDSA_P256_SHA256, 0));
+
   return (testsPassed ? 0 : 1);
 }
 
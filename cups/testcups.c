@@ -33,6 +33,10 @@ main(int  argc,				// I - Number of command-line arguments
      char *argv[])			// I - Command-line arguments
 {
   unsigned	numbers[100];		// Random numbers
+  unsigned char	bytes[8192],		// Random bytes
+		bytes2[8192];		// More random bytes
+  size_t	count,			// Number of random bytes
+		counts[256];		// Count of each byte value
   http_t	*http,			// First HTTP connection
 		*http2;			// Second HTTP connection
   int		status = 0,		// Exit status
@@ -278,6 +282,40 @@ main(int  argc,				// I - Number of command-line arguments
       testMessage("    numbers[%d]=%u", i, numbers[i]);
   }
 
+  //
+  // cupsGetRandBytes()
+  //
+
+  testBegin("cupsGetRandBytes");
+  for (count = 0, i = 1; count < sizeof(bytes); count += (size_t)i, i = i * 3 % 509)
+  {
+    if ((count + (size_t)i) > sizeof(bytes))
+      i = (int)(sizeof(bytes) - count);
+
+    cupsGetRandBytes(bytes + count, (size_t)i);
+  }
+  cupsGetRandBytes(bytes2, sizeof(bytes2));
+
+  memset(counts, 0, sizeof(counts));
+  for (count = 0; count < sizeof(bytes); count ++)
+    counts[bytes[count]] ++;
+  for (i = 0; i < 256; i ++)
+  {
+    if (!counts[i])
+      break;
+  }
+
+  if (i < 256)
+  {
+    testEndMessage(false, "byte value %d never returned", i);
+  }
+  else if (!memcmp(bytes, bytes2, sizeof(bytes)))
+  {
+    testEndMessage(false, "same bytes returned twice");
+  }
+  else
+    testEnd(true);
+
 
   //
   // _cupsConnect() connection reuse...
@@ -22,6 +22,7 @@ static void	localize(http_t *http, cups_dest_t *dest, cups_dinfo_t *dinfo, const
 static void	print_file(http_t *http, cups_dest_t *dest, cups_dinfo_t *dinfo, const char *filename, size_t num_options, cups_option_t *options);
 static void	show_conflicts(http_t *http, cups_dest_t *dest, cups_dinfo_t *dinfo, size_t num_options, cups_option_t *options);
 static void	show_default(http_t *http, cups_dest_t *dest, cups_dinfo_t *dinfo, const char *option);
+static void	show_jobs(http_t *http, cups_dest_t *dest, cups_dinfo_t *dinfo, size_t num_jobs, char *job_ids[]);
 static void	show_media(http_t *http, cups_dest_t *dest, cups_dinfo_t *dinfo, unsigned flags, const char *name);
 static void	show_supported(http_t *http, cups_dest_t *dest, cups_dinfo_t *dinfo, const char *option, const char *value);
 static void	usage(const char *arg) _CUPS_NORETURN;
@@ -178,6 +179,10 @@ main(int  argc,				// I - Number of command-line arguments
   {
     show_default(http, dest, dinfo, argv[i + 1]);
   }
+  else if (!strcmp(argv[i], "jobs") && (i + 1) < argc)
+  {
+    show_jobs(http, dest, dinfo, (size_t)(argc - i - 1), argv + i + 1);
+  }
   else if (!strcmp(argv[i], "localize"))
   {
     i ++;
@@ -522,6 +527,49 @@ show_default(http_t       *http,	// I - Connection to destination
 }
 
 
+//
+// 'show_jobs()' - Show the states of jobs.
+//
+
+static void
+show_jobs(http_t       *http,		// I - Connection to destination
+          cups_dest_t  *dest,		// I - Destination
+          cups_dinfo_t *dinfo,		// I - Destination information
+          size_t       num_jobs,	// I - Number of jobs
+          char         *job_ids[])	// I - Job IDs
+{
+  size_t	i;			// Looping var
+  int		*ids;			// Job IDs
+  ipp_jstate_t	*states;		// Job states
+  ipp_status_t	status;			// Status of request
+
+
+  if ((ids = calloc(num_jobs, sizeof(int))) == NULL || (states = calloc(num_jobs, sizeof(ipp_jstate_t))) == NULL)
+  {
+    printf("Unable to allocate memory: %s\n", strerror(errno));
+    free(ids);
+    return;
+  }
+
+  for (i = 0; i < num_jobs; i ++)
+    ids[i] = atoi(job_ids[i]);
+
+  if ((status = cupsGetDestJobsStatus(http, dest, dinfo, num_jobs, ids, states)) != IPP_STATUS_OK)
+    printf("cupsGetDestJobsStatus: %s\n", ippErrorString(status));
+
+  for (i = 0; i < num_jobs; i ++)
+  {
+    if (states[i])
+      printf("%d: %s\n", ids[i], ippEnumString("job-state", (int)states[i]));
+    else
+      printf("%d: unknown\n", ids[i]);
+  }
+
+  free(ids);
+  free(states);
+}
+
+
 //
 // 'show_media()' - Show available media.
 //
@@ -767,6 +815,7 @@ usage(const char *arg)			// I - Argument for usage message
   puts("Operations:");
   puts("  conflicts options");
   puts("  default option");
+  puts("  jobs job-id [... job-id]");
   puts("  localize option [value]");
   puts("  media [borderless] [duplex] [exact] [ready] [name or size]");
   puts("  print filename [options]");
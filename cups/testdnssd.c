@@ -53,7 +53,8 @@ main(int  argc,				// I - Number of command-line arguments
 {
   int			i,		// Looping var
 			ret = 0;	// Return value
-  cups_dnssd_t		*dnssd;		// DNS-SD context
+  cups_dnssd_t		*dnssd,		// DNS-SD context
+			*idnssd;	// Inline DNS-SD context
   char			name[256];	// Name buffer
   cups_dnssd_browse_t	*browse;	// DNS-SD browse request
 //  cups_dnssd_query_t	*query;		// DNS-SD query request
@@ -76,6 +77,23 @@ main(int  argc,				// I - Number of command-line arguments
   if (argc == 1)
   {
     // Do unit tests...
+    static const unsigned char txtrec[] = "\011rp=ipp/pr\004note\015TY=Test Model";
+					// TXT record
+    const char	*value;			// TXT value
+    size_t	valuelen;		// Length of TXT value
+
+    testBegin("cupsDNSSDGetTXTView");
+    if ((value = cupsDNSSDGetTXTView(txtrec, sizeof(txtrec) - 1, "rp", &valuelen)) == NULL || valuelen != 6 || memcmp(value, "ipp/pr", 6))
+      testEndMessage(false, "rp");
+    else if ((value = cupsDNSSDGetTXTView(txtrec, sizeof(txtrec) - 1, "ty", &valuelen)) == NULL || valuelen != 10 || memcmp(value, "Test Model", 10))
+      testEndMessage(false, "ty");
+    else if ((value = cupsDNSSDGetTXTView(txtrec, sizeof(txtrec) - 1, "note", &valuelen)) == NULL || valuelen != 0)
+      testEndMessage(false, "note");
+    else if (cupsDNSSDGetTXTView(txtrec, sizeof(txtrec) - 1, "r", &valuelen) || cupsDNSSDGetTXTView(txtrec, sizeof(txtrec) - 1, "missing", &valuelen))
+      testEndMessage(false, "missing");
+    else
+      testEnd(true);
+
     testBegin("cupsDNSSDNew");
     if ((dnssd = cupsDNSSDNew(error_cb, &testdata)) != NULL)
       testEnd(true);
@@ -205,6 +223,60 @@ main(int  argc,				// I - Number of command-line arguments
     if (i >= 30)
       ret = 1;
 
+    testBegin("cupsDNSSDNewInline");
+    if ((idnssd = cupsDNSSDNewInline(error_cb, &testdata)) != NULL)
+    {
+      testEnd(true);
+    }
+    else
+    {
+      ret = 1;
+      goto done;
+    }
+
+    testBegin("cupsDNSSDBrowseNew(inline, _testdnssd._tcp)");
+    if (cupsDNSSDBrowseNew(idnssd, CUPS_DNSSD_IF_INDEX_ANY, "_testdnssd._tcp", NULL, browse_cb, &testdata) != NULL)
+    {
+      testEnd(true);
+    }
+    else
+    {
+      cupsDNSSDDelete(idnssd);
+      ret = 1;
+      goto done;
+    }
+
+    testBegin("cupsDNSSDGetFds/cupsDNSSDProcess");
+    {
+      int	fds[8],			// File descriptors
+		timeout = -1;		// Timeout
+      size_t	num_fds = 0,		// Number of file descriptors
+		count;			// Number of browse callbacks
+      bool	found = false;		// Found the test service?
+
+      cupsMutexLock(&testdata.mutex);
+      count = testdata.browse_dnssd_count;
+      cupsMutexUnlock(&testdata.mutex);
+
+      for (i = 0; i < 30 && !found; i ++)
+      {
+        if ((num_fds = cupsDNSSDGetFds(idnssd, fds, sizeof(fds) / sizeof(fds[0]), &timeout)) == 0 || !cupsDNSSDProcess(idnssd, 1000))
+          break;
+
+        cupsMutexLock(&testdata.mutex);
+        found = testdata.browse_dnssd_count != count;
+        cupsMutexUnlock(&testdata.mutex);
+
+        testProgress();
+      }
+
+      testEndMessage(found, "%u fds, timeout=%d", (unsigned)num_fds, timeout);
+      if (!found)
+        ret = 1;
+    }
+
+    cupsDNSSDDelete(idnssd);
+
     done:
 
     cupsDNSSDDelete(dnssd);
@@ -29,9 +29,12 @@
 // Local functions...
 //
 
+static int	buffer_tests(void);
+static int	conf_tests(void);
 static int	count_lines(cups_file_t *fp);
+static int	index_tests(void);
 static int	random_tests(void);
-static int	read_write_tests(bool compression);
+static int	read_write_tests(cups_file_compression_t compression, size_t bufsize, size_t num_threads, size_t qdepth);
 
 
 //
@@ -56,14 +59,68 @@ main(int  argc,				// I - Number of command-line arguments
   if (argc == 1)
   {
     // Do uncompressed file tests...
-    status = read_write_tests(false);
+    status = read_write_tests(CUPS_FILE_COMPRESSION_NONE, 0, 0, 0);
 
     // Do compressed file tests...
-    status += read_write_tests(true);
+    status += read_write_tests(CUPS_FILE_COMPRESSION_GZIP, 0, 0, 0);
+#ifdef HAVE_ZSTD
+    status += read_write_tests(CUPS_FILE_COMPRESSION_ZSTD, 0, 0, 0);
+#endif // HAVE_ZSTD
+
+    // Do uncompressed and compressed file tests with larger buffers...
+    status += read_write_tests(CUPS_FILE_COMPRESSION_NONE, 65536, 0, 0);
+    status += read_write_tests(CUPS_FILE_COMPRESSION_GZIP, 65536, 0, 0);
+#ifdef HAVE_ZSTD
+    status += read_write_tests(CUPS_FILE_COMPRESSION_ZSTD, 65536, 0, 0);
+#endif // HAVE_ZSTD
+
+    // Do compressed file tests with multiple compression threads...
+    status += read_write_tests(CUPS_FILE_COMPRESSION_GZIP, 0, 4, 0);
+
+    // Do uncompressed and compressed file tests with read-ahead/write-behind...
+    status += read_write_tests(CUPS_FILE_COMPRESSION_NONE, 0, 0, 8);
+    status += read_write_tests(CUPS_FILE_COMPRESSION_GZIP, 65536, 0, 8);
+
+    // Do buffer boundary tests...
+    status += buffer_tests();
 
     // Do uncompressed random I/O tests...
     status += random_tests();
 
+    // Do compressed random I/O tests with a seek index...
+    status += index_tests();
+
+    // Do parsed configuration file tests...
+    status += conf_tests();
+
+    // Test anonymous temporary files...
+    for (i = 0; i < 2; i ++)
+    {
+      int	tempfd;				// Temporary file descriptor
+      char	tempdata[5];			// Data from file
+
+      testBegin("cupsCreateAnonymousFd(%s)", i ? "true" : "false");
+
+      if ((tempfd = cupsCreateAnonymousFd(i != 0)) < 0)
+      {
+        testEndMessage(false, "%s", strerror(errno));
+        status ++;
+        continue;
+      }
+
+      if (write(tempfd, "test", 4) != 4 || lseek(tempfd, 0, SEEK_SET) != 0 || read(tempfd, tempdata, sizeof(tempdata)) != 4 || memcmp(tempdata, "test", 4))
+      {
+        testEndMessage(false, "%s", strerror(errno));
+        status ++;
+      }
+      else
+      {
+        testEnd(true);
+      }
+
+      close(tempfd);
+    }
+
 #ifndef _WIN32
     // Test fdopen and close without reading...
     pipe(fds);
@@ -140,6 +197,69 @@ main(int  argc,				// I - Number of command-line arguments
       cupsFileClose(fp);
     }
 
+    // Count lines and compare data using a memory-mapped file...
+    testBegin("cupsFileOpen(\"testfile.txt\", \"rm\")");
+
+    if ((fp = cupsFileOpen("testfile.txt", "rm")) == NULL)
+    {
+      testEnd(false);
+      status ++;
+    }
+    else
+    {
+      cups_file_t	*rfp;		// Buffered file
+      const char	*data;		// Data from file
+      size_t		length;		// Length of data
+      char		buffer[8192];	// Data from buffered file
+      off_t		total = 0;	// Total bytes
+
+
+      testEnd(true);
+      testBegin("cupsFileGets");
+
+      if ((count = count_lines(fp)) != 477)
+      {
+        testEndMessage(false, "got %d lines, expected 477", count);
+	status ++;
+      }
+      else
+      {
+        testEnd(true);
+      }
+
+      testBegin("cupsFileGetView");
+
+      if (cupsFileRewind(fp) != 0 || (rfp = cupsFileOpen("testfile.txt", "r")) == NULL)
+      {
+        testEndMessage(false, "%s", strerror(errno));
+	status ++;
+      }
+      else
+      {
+	while ((data = cupsFileGetView(fp, sizeof(buffer), &length)) != NULL)
+	{
+	  if (cupsFileRead(rfp, buffer, length) != (ssize_t)length || memcmp(data, buffer, length))
+	    break;
+
+	  total += (off_t)length;
+	}
+
+	if (data || !cupsFileEOF(fp) || cupsFileTell(fp) != total || cupsFileRead(rfp, buffer, 1) > 0)
+	{
+	  testEndMessage(false, "data differs at offset " CUPS_LLFMT, CUPS_LLCAST total);
+	  status ++;
+	}
+	else
+	{
+	  testEndMessage(true, CUPS_LLFMT " bytes", CUPS_LLCAST total);
+	}
+
+	cupsFileClose(rfp);
+      }
+
+      cupsFileClose(fp);
+    }
+
     // Test path functions...
     testBegin("cupsFileFind");
 #ifdef _WIN32
@@ -238,6 +358,26 @@ main(int  argc,				// I - Number of command-line arguments
 	    testEnd(true);
 	  }
 
+	  testBegin("cupsDirReadName/cupsDirGetInfo");
+	  cupsDirRewind(dir);
+	  for (num_files = 0; (dent = cupsDirReadName(dir)) != NULL; num_files ++)
+	  {
+	    const struct stat *fileinfo;	// File information
+
+	    if (!S_ISREG(dent->fileinfo.st_mode) || (fileinfo = cupsDirGetInfo(dir)) == NULL || fileinfo->st_size != 16)
+	      break;
+	  }
+
+	  if (num_files != 10)
+	  {
+	    testEndMessage(false, "Got %d files, expected 10", num_files);
+	    status ++;
+	  }
+	  else
+	  {
+	    testEnd(true);
+	  }
+
 	  cupsDirClose(dir);
 	}
       }
@@ -295,6 +435,306 @@ main(int  argc,				// I - Number of command-line arguments
 }
 
 
+//
+// 'buffer_tests()' - Do buffer boundary tests.
+//
+// Writes lines of varying length so that cupsFilePrintf and cupsFilePutChar
+// cross the end of the file buffer at many different offsets, then reads
+// everything back with cupsFileGetChar.
+//
+
+static int				// O - Status
+buffer_tests(void)
+{
+  int		status = 0,		// Status of tests
+		i,			// Looping var
+		ch = 0;			// Character from file
+  cups_file_t	*fp;			// File
+  char		*expected,		// Expected file contents
+		*eptr,			// Pointer into expected contents
+		filler[10001];		// Filler characters
+  size_t	elen,			// Length of expected contents
+		len;			// Length of filler
+  off_t		offset;			// Seek offset
+
+
+  memset(filler, 'x', sizeof(filler) - 1);
+  filler[sizeof(filler) - 1] = '\0';
+
+  if ((expected = malloc(1024 * 1024)) == NULL)
+  {
+    testBegin("malloc(1MiB)");
+    testEndMessage(false, "%s", strerror(errno));
+    return (1);
+  }
+
+  eptr = expected;
+
+  // cupsFilePrintf()/cupsFilePutChar()
+  testBegin("cupsFilePrintf/cupsFilePutChar(buffer boundaries)");
+
+  if ((fp = cupsFileOpen("testfile-buffer.txt", "w")) == NULL)
+  {
+    testEndMessage(false, "%s", strerror(errno));
+    free(expected);
+    return (1);
+  }
+
+  for (i = 0; i < 1000; i ++)
+  {
+    // Use strings around and larger than the 4k file buffer every 100 lines...
+    switch (i % 100)
+    {
+      case 96 :
+      case 97 :
+      case 98 :
+          len = (size_t)(4089 - 97 + i % 100);
+          break;
+      case 99 :
+          len = sizeof(filler) - 1;
+          break;
+      default :
+          len = (size_t)((i * 37) % 600);
+          break;
+    }
+
+    if (!cupsFilePrintf(fp, "%05d:%.*s\n", i, (int)len, filler))
+      break;
+
+    eptr += snprintf(eptr, (size_t)(expected + 1024 * 1024 - eptr), "%05d:%.*s\n", i, (int)len, filler);
+
+    if (!cupsFilePutChar(fp, 'A' + i % 26))
+      break;
+
+    *eptr++ = (char)('A' + i % 26);
+  }
+
+  elen = (size_t)(eptr - expected);
+
+  if (i < 1000)
+  {
+    testEndMessage(false, "line %d: %s", i, strerror(errno));
+    status ++;
+  }
+  else if (cupsFileTell(fp) != (off_t)elen)
+  {
+    testEndMessage(false, "got position %ld, expected %ld", (long)cupsFileTell(fp), (long)elen);
+    status ++;
+  }
+  else
+  {
+    testEnd(true);
+  }
+
+  if (!cupsFileClose(fp))
+  {
+    testBegin("cupsFileClose()");
+    testEndMessage(false, "%s", strerror(errno));
+    status ++;
+  }
+
+  // cupsFileGetChar()
+  testBegin("cupsFileGetChar(buffer boundaries)");
+
+  if ((fp = cupsFileOpen("testfile-buffer.txt", "r")) == NULL)
+  {
+    testEndMessage(false, "%s", strerror(errno));
+    free(expected);
+    return (status + 1);
+  }
+
+  for (eptr = expected; eptr < (expected + elen); eptr ++)
+  {
+    if ((ch = cupsFileGetChar(fp)) != (*eptr & 255))
+      break;
+  }
+
+  if (eptr < (expected + elen))
+  {
+    testEndMessage(false, "got %d at offset %ld, expected %d", ch, (long)(eptr - expected), *eptr & 255);
+    status ++;
+  }
+  else if (cupsFileTell(fp) != (off_t)elen)
+  {
+    testEndMessage(false, "got position %ld, expected %ld", (long)cupsFileTell(fp), (long)elen);
+    status ++;
+  }
+  else if ((ch = cupsFileGetChar(fp)) != -1)
+  {
+    testEndMessage(false, "got %d at end of file, expected -1", ch);
+    status ++;
+  }
+  else
+  {
+    testEnd(true);
+  }
+
+  // cupsFileSeek() + cupsFileGetChar()
+  testBegin("cupsFileSeek/cupsFileGetChar(buffer boundaries)");
+
+  for (offset = (off_t)elen - 1; offset > 0; offset -= 4093)
+  {
+    if (cupsFileSeek(fp, offset) != offset || (ch = cupsFileGetChar(fp)) != (expected[offset] & 255) || cupsFileTell(fp) != (offset + 1))
+      break;
+  }
+
+  if (offset > 0)
+  {
+    testEndMessage(false, "got %d at offset %ld, expected %d", ch, (long)offset, expected[offset] & 255);
+    status ++;
+  }
+  else
+  {
+    testEnd(true);
+  }
+
+  cupsFileClose(fp);
+  free(expected);
+
+  unlink("testfile-buffer.txt");
+
+  return (status);
+}
+
+
+//
+// 'conf_tests()' - Do parsed configuration file tests.
+//
+
+static int				// O - Status
+conf_tests(void)
+{
+  int		status = 0;		// Status of tests
+  cups_file_t	*fp;			// File
+  cups_conf_t	*conf,			// Configuration file
+		*conf2;			// Configuration file (again)
+  const char	*directive,		// Directive
+		*value;			// Value
+  int		linenum;		// Line number
+
+
+  // cupsConfOpen()
+  testBegin("cupsConfOpen(testfile.conf)");
+
+  if ((fp = cupsFileOpen("testfile.conf", "w")) == NULL)
+  {
+    testEndMessage(false, "testfile.conf: %s", strerror(errno));
+    return (1);
+  }
+
+  cupsFilePuts(fp, "# Test configuration file\nEncryption Never\nServerName localhost\nNoValue\nencryption Required # Comment\n");
+  cupsFileClose(fp);
+
+  if ((conf = cupsConfOpen("testfile.conf")) == NULL)
+  {
+    testEndMessage(false, "%s", strerror(errno));
+    return (1);
+  }
+
+  testEnd(true);
+
+  // cupsConfGetCount()
+  testBegin("cupsConfGetCount");
+
+  if (cupsConfGetCount(conf) == 4)
+  {
+    testEnd(true);
+  }
+  else
+  {
+    testEndMessage(false, "got %u, expected 4", (unsigned)cupsConfGetCount(conf));
+    status ++;
+  }
+
+  // cupsConfGetDirective()
+  testBegin("cupsConfGetDirective");
+
+  if ((directive = cupsConfGetDirective(conf, 2, &value, &linenum)) != NULL && !strcmp(directive, "NoValue") && !value && linenum == 4 && !cupsConfGetDirective(conf, 4, &value, &linenum))
+  {
+    testEnd(true);
+  }
+  else
+  {
+    testEndMessage(false, "got \"%s\" value \"%s\" on line %d", directive ? directive : "(null)", value ? value : "(null)", linenum);
+    status ++;
+  }
+
+  // cupsConfGetValue()
+  testBegin("cupsConfGetValue");
+
+  if ((value = cupsConfGetValue(conf, "ENCRYPTION")) == NULL || strcmp(value, "Required"))
+  {
+    testEndMessage(false, "got \"%s\" for Encryption, expected \"Required\"", value ? value : "(null)");
+    status ++;
+  }
+  else if ((value = cupsConfGetValue(conf, "ServerName")) == NULL || strcmp(value, "localhost"))
+  {
+    testEndMessage(false, "got \"%s\" for ServerName, expected \"localhost\"", value ? value : "(null)");
+    status ++;
+  }
+  else if (cupsConfGetValue(conf, "NoValue") || cupsConfGetValue(conf, "Missing"))
+  {
+    testEndMessage(false, "got unexpected value for NoValue or Missing");
+    status ++;
+  }
+  else
+  {
+    testEnd(true);
+  }
+
+  // cupsConfOpen() again should use the cached copy...
+  testBegin("cupsConfOpen(cached)");
+
+  if ((conf2 = cupsConfOpen("testfile.conf")) == conf)
+  {
+    testEnd(true);
+  }
+  else
+  {
+    testEndMessage(false, "got a different copy");
+    status ++;
+  }
+
+  cupsConfClose(conf2);
+
+  // Changing the file should cause it to be read again...
+  testBegin("cupsConfOpen(changed)");
+
+  if ((fp = cupsFileOpen("testfile.conf", "w")) != NULL)
+  {
+    cupsFilePuts(fp, "Encryption IfRequested\n");
+    cupsFileClose(fp);
+  }
+
+  if ((conf2 = cupsConfOpen("testfile.conf")) == NULL || conf2 == conf)
+  {
+    testEndMessage(false, "did not read the changed file");
+    status ++;
+  }
+  else if (cupsConfGetCount(conf2) != 1 || (value = cupsConfGetValue(conf2, "Encryption")) == NULL || strcmp(value, "IfRequested"))
+  {
+    testEndMessage(false, "got \"%s\" for Encryption, expected \"IfRequested\"", value ? value : "(null)");
+    status ++;
+  }
+  else if ((value = cupsConfGetValue(conf, "Encryption")) == NULL || strcmp(value, "Required"))
+  {
+    testEndMessage(false, "old copy was changed");
+    status ++;
+  }
+  else
+  {
+    testEnd(true);
+  }
+
+  cupsConfClose(conf2);
+  cupsConfClose(conf);
+
+  unlink("testfile.conf");
+
+  return (status);
+}
+
+
 //
 // 'count_lines()' - Count the number of lines in a file.
 //
@@ -313,6 +753,109 @@ count_lines(cups_file_t *fp)		// I - File to read from
 }
 
 
+//
+// 'index_tests()' - Do compressed random access tests with a seek index.
+//
+
+static int				// O - Status
+index_tests(void)
+{
+  int		status = 0,		// Status of tests
+		i,			// Looping var
+		count;			// Number of lines
+  cups_file_t	*fp;			// File
+  char		line[256],		// Line from file
+		expected[256];		// Expected line
+  static const int records[] =		// Records to seek to
+  {
+    150000, 10, 199999, 100000, 50000, 123456, 0, 175000
+  };
+
+
+  // cupsFileOpen(write)
+  testBegin("cupsFileOpen(\"testfile-index.gz\", \"w1\")");
+
+  if ((fp = cupsFileOpen("testfile-index.gz", "w1")) == NULL)
+  {
+    testEndMessage(false, "%s", strerror(errno));
+    return (1);
+  }
+
+  for (i = 0; i < 200000; i ++)
+    cupsFilePrintf(fp, "Line %06d\n", i);
+
+  if (cupsFileClose(fp))
+  {
+    testEnd(true);
+  }
+  else
+  {
+    testEndMessage(false, "%s", strerror(errno));
+    return (1);
+  }
+
+  // cupsFileSetSeekIndex()
+  testBegin("cupsFileSetSeekIndex(65536)");
+
+  if ((fp = cupsFileOpen("testfile-index.gz", "r")) == NULL || !cupsFileSetSeekIndex(fp, 65536))
+  {
+    testEndMessage(false, "%s", strerror(errno));
+    cupsFileClose(fp);
+    return (1);
+  }
+
+  for (count = 0; cupsFileGets(fp, line, sizeof(line)); count ++);
+
+  if (count == 200000)
+  {
+    testEnd(true);
+  }
+  else
+  {
+    testEndMessage(false, "got %d lines, expected 200000", count);
+    status ++;
+  }
+
+  // cupsFileSeek()
+  testBegin("cupsFileSeek(indexed)");
+
+  for (i = 0; i < (int)(sizeof(records) / sizeof(records[0])); i ++)
+  {
+    snprintf(expected, sizeof(expected), "Line %06d", records[i]);
+
+    if (cupsFileSeek(fp, (off_t)records[i] * 12) != (off_t)records[i] * 12 || !cupsFileGets(fp, line, sizeof(line)) || strcmp(line, expected))
+      break;
+  }
+
+  if (i < (int)(sizeof(records) / sizeof(records[0])))
+  {
+    testEndMessage(false, "got \"%s\", expected \"%s\"", line, expected);
+    status ++;
+  }
+  else
+  {
+    // Read to the end of the file to check the trailer handling...
+    for (count = records[i - 1] + 1; cupsFileGets(fp, line, sizeof(line)); count ++);
+
+    if (count == 200000)
+    {
+      testEnd(true);
+    }
+    else
+    {
+      testEndMessage(false, "got %d lines, expected 200000", count);
+      status ++;
+    }
+  }
+
+  cupsFileClose(fp);
+
+  unlink("testfile-index.gz");
+
+  return (status);
+}
+
+
 //
 // 'random_tests()' - Do random access tests.
 //
@@ -403,10 +946,10 @@ random_tests(void)
 
     cupsFileClose(fp);
 
-    // cupsFileOpen(read)
-    testBegin("cupsFileOpen(read %d)", pass);
+    // cupsFileOpen(read), using a memory-mapped file on odd passes
+    testBegin("cupsFileOpen(read%s %d)", (pass & 1) ? " mapped" : "", pass);
 
-    if ((fp = cupsFileOpen("testfile.dat", "r")) == NULL)
+    if ((fp = cupsFileOpen("testfile.dat", (pass & 1) ? "rm" : "r")) == NULL)
     {
       testEndMessage(false, "%s", strerror(errno));
       status ++;
@@ -476,7 +1019,11 @@ random_tests(void)
 //
 
 static int				// O - Status
-read_write_tests(bool compression)	// I - Use compression?
+read_write_tests(
+    cups_file_compression_t compression,// I - Compression to use
+    size_t                  bufsize,	// I - Buffer size or `0` for default
+    size_t                  num_threads,// I - Number of compression threads or `0` for default
+    size_t                  qdepth)	// I - Read-ahead/write-behind depth or `0` for none
 {
   int		i, j;			// Looping vars
   cups_file_t	*fp;			// File
@@ -491,6 +1038,24 @@ read_write_tests(bool compression)	// I - Use compression?
   off_t		length;			// Length of file
   static const char *partial_line = "partial line";
 					// Partial line
+  static const char * const filenames[] =
+  {					// Test filenames
+    "testfile.dat",
+    "testfile.dat.gz",
+    "testfile.dat.zst"
+  };
+  static const char * const modes[] =
+  {					// Open modes for writing
+    "w",
+    "w9",
+    "wz"
+  };
+  static const char * const names[] =
+  {					// Compression names
+    "",
+    " gzip",
+    " zstd"
+  };
 
 
   // No errors so far...
@@ -501,23 +1066,71 @@ read_write_tests(bool compression)	// I - Use compression?
     writebuf[i] = (unsigned char)cupsGetRand();
 
   // cupsFileOpen(write)
-  testBegin("cupsFileOpen(write%s)", compression ? " compressed" : "");
+  testBegin("cupsFileOpen(write%s)", names[compression]);
 
-  fp = cupsFileOpen(compression ? "testfile.dat.gz" : "testfile.dat", compression ? "w9" : "w");
+  fp = cupsFileOpen(filenames[compression], modes[compression]);
   if (fp)
   {
     testEnd(true);
 
+    if (bufsize)
+    {
+      // cupsFileSetBufferSize()
+      testBegin("cupsFileSetBufferSize(%u)", (unsigned)bufsize);
+
+      if (cupsFileSetBufferSize(fp, bufsize))
+      {
+        testEnd(true);
+      }
+      else
+      {
+        testEndMessage(false, "%s", strerror(errno));
+        status ++;
+      }
+    }
+
+    if (num_threads)
+    {
+      // cupsFileSetCompressionThreads()
+      testBegin("cupsFileSetCompressionThreads(%u)", (unsigned)num_threads);
+
+      if (cupsFileSetCompressionThreads(fp, num_threads))
+      {
+        testEnd(true);
+      }
+      else
+      {
+        testEndMessage(false, "%s", strerror(errno));
+        status ++;
+      }
+    }
+
+    if (qdepth)
+    {
+      // cupsFileSetQueueDepth()
+      testBegin("cupsFileSetQueueDepth(%u)", (unsigned)qdepth);
+
+      if (cupsFileSetQueueDepth(fp, qdepth))
+      {
+        testEnd(true);
+      }
+      else
+      {
+        testEndMessage(false, "%s", strerror(errno));
+        status ++;
+      }
+    }
+
     // cupsFileIsCompressed()
     testBegin("cupsFileIsCompressed()");
 
-    if (cupsFileIsCompressed(fp) == compression)
+    if (cupsFileIsCompressed(fp) == (compression != CUPS_FILE_COMPRESSION_NONE) && cupsFileGetCompression(fp) == compression)
     {
       testEnd(true);
     }
     else
     {
-      testEndMessage(false, "Got %s, expected %s", cupsFileIsCompressed(fp) ? "true" : "false", compression ? "true" : "false");
+      testEndMessage(false, "Got %s/%d, expected %s/%d", cupsFileIsCompressed(fp) ? "true" : "false", cupsFileGetCompression(fp), compression ? "true" : "false", compression);
       status ++;
     }
 
@@ -639,11 +1252,43 @@ read_write_tests(bool compression)	// I - Use compression?
   // cupsFileOpen(read)
   testBegin("cupsFileOpen(read)");
 
-  fp = cupsFileOpen(compression ? "testfile.dat.gz" : "testfile.dat", "r");
+  fp = cupsFileOpen(filenames[compression], "r");
   if (fp)
   {
     testEnd(true);
 
+    if (bufsize)
+    {
+      // cupsFileSetBufferSize()
+      testBegin("cupsFileSetBufferSize(%u)", (unsigned)bufsize);
+
+      if (cupsFileSetBufferSize(fp, bufsize))
+      {
+        testEnd(true);
+      }
+      else
+      {
+        testEndMessage(false, "%s", strerror(errno));
+        status ++;
+      }
+    }
+
+    if (qdepth)
+    {
+      // cupsFileSetQueueDepth()
+      testBegin("cupsFileSetQueueDepth(%u)", (unsigned)qdepth);
+
+      if (cupsFileSetQueueDepth(fp, qdepth))
+      {
+        testEnd(true);
+      }
+      else
+      {
+        testEndMessage(false, "%s", strerror(errno));
+        status ++;
+      }
+    }
+
     // cupsFileGets()
     testBegin("cupsFileGets()");
 
@@ -668,14 +1313,13 @@ read_write_tests(bool compression)	// I - Use compression?
     // cupsFileIsCompressed()
     testBegin("cupsFileIsCompressed()");
 
-    if (cupsFileIsCompressed(fp) == compression)
+    if (cupsFileIsCompressed(fp) == (compression != CUPS_FILE_COMPRESSION_NONE) && cupsFileGetCompression(fp) == compression)
     {
       testEnd(true);
     }
     else
     {
-      testEndMessage(false, "Got %s, expected %s", cupsFileIsCompressed(fp) ? "true" : "false",
-             compression ? "true" : "false");
+      testEndMessage(false, "Got %s/%d, expected %s/%d", cupsFileIsCompressed(fp) ? "true" : "false", cupsFileGetCompression(fp), compression ? "true" : "false", compression);
       status ++;
     }
 
@@ -817,9 +1461,42 @@ read_write_tests(bool compression)	// I - Use compression?
     status ++;
   }
 
+  if (compression != CUPS_FILE_COMPRESSION_NONE)
+  {
+    // cupsFileOpen(read mapped), compressed files must not be mapped raw...
+    testBegin("cupsFileOpen(read mapped%s)", names[compression]);
+
+    if ((fp = cupsFileOpen(filenames[compression], "rm")) == NULL)
+    {
+      testEndMessage(false, "%s", strerror(errno));
+      status ++;
+    }
+    else
+    {
+      linenum = 1;
+
+      if (!cupsFileGetConf(fp, line, sizeof(line), &value, &linenum) || _cups_strcasecmp(line, "TestLine") || !value || atoi(value) != 0)
+      {
+        testEndMessage(false, "Got directive \"%s\", value \"%s\"", line, value ? value : "(null)");
+        status ++;
+      }
+      else if (cupsFileGetCompression(fp) != compression)
+      {
+        testEndMessage(false, "Got compression %d, expected %d", cupsFileGetCompression(fp), compression);
+        status ++;
+      }
+      else
+      {
+        testEnd(true);
+      }
+
+      cupsFileClose(fp);
+    }
+  }
+
   // Remove the test file...
   if (!status)
-    unlink(compression ? "testfile.dat.gz" : "testfile.dat");
+    unlink(filenames[compression]);
 
   // Return the test status...
   return (status);
@@ -267,6 +267,8 @@ do_test(_form_data_t *test)		// I - Test data
 		num_vars;		// Number of variables
   cups_option_t	*vars;			// Variables
   char		*data;			// Form data
+  cups_option_t	bufvars[10];		// Variables for in-place decoding
+  char		buffer[1024];		// Buffer for in-place decoding/encoding
 
 
   testBegin("cupsFormDecode(\"%s\")", test->encoded);
@@ -300,6 +302,35 @@ do_test(_form_data_t *test)		// I - Test data
 
   cupsFreeOptions(num_vars, vars);
 
+  testBegin("cupsFormDecodeBuffer(\"%s\")", test->encoded);
+  cupsCopyString(buffer, test->encoded, sizeof(buffer));
+  num_vars = cupsFormDecodeBuffer(buffer, sizeof(bufvars) / sizeof(bufvars[0]), bufvars);
+  if (num_vars != test->num_pairs)
+  {
+    testEndMessage(false, "got %u pairs, expected %u", (unsigned)num_vars, (unsigned)test->num_pairs);
+  }
+  else
+  {
+    for (i = 0; i < num_vars; i ++)
+    {
+      if (strcmp(bufvars[i].name, test->pairs[i * 2]) || strcmp(bufvars[i].value, test->pairs[i * 2 + 1]))
+      {
+        testEndMessage(false, "Got %s=\"%s\", expected %s=\"%s\"", bufvars[i].name, bufvars[i].value, test->pairs[i * 2], test->pairs[i * 2 + 1]);
+        break;
+      }
+    }
+
+    if (i >= num_vars)
+      testEnd(true);
+  }
+
+  if (test->num_pairs > 1)
+  {
+    testBegin("cupsFormDecodeBuffer(\"%s\", max_vars=1)", test->encoded);
+    cupsCopyString(buffer, test->encoded, sizeof(buffer));
+    testEnd(cupsFormDecodeBuffer(buffer, 1, bufvars) == 0);
+  }
+
   if (test->num_pairs == 0 && test->encoded[0])
     return;
 
@@ -317,6 +348,23 @@ do_test(_form_data_t *test)		// I - Test data
     testEnd(true);
 
   free(data);
+
+  testBegin("cupsFormEncodeBuffer(%u pairs)", (unsigned)test->num_pairs);
+  data = cupsFormEncodeBuffer(test->url, num_vars, vars, buffer, sizeof(buffer));
+
+  if (!data && test->encoded[0])
+    testEndMessage(false, cupsGetErrorString());
+  else if (data && strcmp(data, test->encoded))
+    testEndMessage(false, "Got \"%s\", expected \"%s\"", data, test->encoded);
+  else
+    testEnd(true);
+
+  if (test->encoded[0])
+  {
+    testBegin("cupsFormEncodeBuffer(%u pairs, bufsize=%u)", (unsigned)test->num_pairs, (unsigned)strlen(test->encoded));
+    testEnd(cupsFormEncodeBuffer(test->url, num_vars, vars, buffer, strlen(test->encoded)) == NULL);
+  }
+
   cupsFreeOptions(num_vars, vars);
 }
 
@@ -27,6 +27,9 @@ main(int  argc,				// I - Number of command-line arguments
      char *argv[])			// I - Command-line arguments
 {
   int		i;			// Looping var
+  cups_hash_t	*ctx;			// Incremental hash context
+  cups_file_t	*fp;			// Temporary file
+  char		filename[1024];		// Temporary filename
   unsigned char	hash[64];		// Hash value
   ssize_t	hashsize;		// Size of hash
   char		hex[256];		// Hex string for hash
@@ -57,6 +60,18 @@ main(int  argc,				// I - Number of command-line arguments
       else
         testEnd(true);
 
+      testBegin("cupsHashInit/Update/Finish('%s')", tests[i][0]);
+      if ((ctx = cupsHashInit(tests[i][0])) == NULL)
+        testEndMessage(false, "%s", cupsGetErrorString());
+      else if (!cupsHashUpdate(ctx, text, 1) || !cupsHashUpdate(ctx, text + 1, 10) || !cupsHashUpdate(ctx, text + 11, strlen(text + 11)))
+        testEndMessage(false, "cupsHashUpdate failed");
+      else if ((hashsize = cupsHashFinish(ctx, hash, sizeof(hash))) < 0)
+        testEndMessage(false, "%s", cupsGetErrorString());
+      else if (strcasecmp(cupsHashString(hash, (size_t)hashsize, hex, sizeof(hex)), tests[i][1]))
+        testEndMessage(false, "expected '%s', got '%s'", tests[i][1], hex);
+      else
+        testEnd(true);
+
       if (!tests[i][2][0])
         continue;
 
@@ -67,6 +82,53 @@ main(int  argc,				// I - Number of command-line arguments
         testEndMessage(false, "expected '%s', got '%s'", tests[i][1], hex);
       else
         testEnd(true);
+
+      testBegin("cupsHMACInit/cupsHashUpdate/Finish('%s')", tests[i][0]);
+      if ((ctx = cupsHMACInit(tests[i][0], (unsigned char *)key, strlen(key))) == NULL)
+        testEndMessage(false, "%s", cupsGetErrorString());
+      else if (!cupsHashUpdate(ctx, text, 20) || !cupsHashUpdate(ctx, text + 20, strlen(text + 20)))
+        testEndMessage(false, "cupsHashUpdate failed");
+      else if ((hashsize = cupsHashFinish(ctx, hash, sizeof(hash))) < 0)
+        testEndMessage(false, "%s", cupsGetErrorString());
+      else if (strcasecmp(cupsHashString(hash, (size_t)hashsize, hex, sizeof(hex)), tests[i][2]))
+        testEndMessage(false, "expected '%s', got '%s'", tests[i][2], hex);
+      else
+        testEnd(true);
+    }
+
+    // Hash data as it is written to a compressed file...
+    testBegin("cupsFileSetHash");
+    if ((fp = cupsCreateTempFile(NULL, NULL, filename, sizeof(filename))) == NULL)
+    {
+      testEndMessage(false, "%s", cupsGetErrorString());
+    }
+    else
+    {
+      cupsFileClose(fp);
+
+      if ((fp = cupsFileOpen(filename, "w9")) == NULL)
+      {
+        testEndMessage(false, "%s", cupsGetErrorString());
+      }
+      else
+      {
+        ctx = cupsHashInit("sha2-256");
+
+        cupsFileSetHash(fp, ctx);
+        cupsFilePuts(fp, "The quick brown fox ");
+        cupsFileWrite(fp, "jumps over ", 11);
+        cupsFilePrintf(fp, "the %s dog", "lazy");
+        cupsFileClose(fp);
+
+        if ((hashsize = cupsHashFinish(ctx, hash, sizeof(hash))) < 0)
+          testEndMessage(false, "%s", cupsGetErrorString());
+        else if (strcasecmp(cupsHashString(hash, (size_t)hashsize, hex, sizeof(hex)), tests[3][1]))
+          testEndMessage(false, "expected '%s', got '%s'", tests[3][1], hex);
+        else
+          testEnd(true);
+      }
+
+      unlink(filename);
     }
 
     if (!testsPassed)
@@ -11,12 +11,45 @@
 
 #include "cups-private.h"
 #include "test-internal.h"
+#ifndef _WIN32
+#  include <poll.h>
+#endif // !_WIN32
 
 
 //
 // Types and structures...
 //
 
+typedef struct test_jobs_s		// Jobs from cupsGetJobsIter
+{
+  int			ids[10];	// Job IDs
+  size_t		num_ids,	// Number of jobs
+			max_ids;	// Number of jobs before stopping
+} test_jobs_t;
+
+typedef struct test_server_s		// Test HTTP/IPP server
+{
+  int			fd;		// Listen socket
+  int			port;		// Port number
+  bool			stop;		// Stop the server?
+  int			max_requests;	// Requests per connection or `0` for no limit
+  int			num_jobs;	// Number of jobs for Get-Jobs
+  cups_atomic_t		num_requests;	// Number of IPP requests answered
+  bool			ranges;		// Support ranged GET requests?
+  const char		*data;		// Data for GET requests
+  size_t		datalen;	// Length of data
+  cups_atomic_t		num_gets;	// Number of GET requests answered
+  off_t			last_start;	// First byte of last GET request
+  cups_thread_t		thread;		// Accept thread
+  cups_thread_pool_t	*pool;		// Connection threads
+} test_server_t;
+
+typedef struct test_client_s		// Test server connection
+{
+  test_server_t		*server;	// Test server
+  http_t		*http;		// HTTP connection
+} test_client_t;
+
 typedef struct uri_test_s		// URI test cases
 {
   http_uri_status_t	result;		// Expected return value
@@ -31,6 +64,22 @@ typedef struct uri_test_s		// URI test cases
 } uri_test_t;
 
 
+//
+// Local functions...
+//
+
+static const char *auth_password_cb(const char *prompt, http_t *http, const char *method, const char *resource, void *user_data);
+static bool	compare_file(const char *filename, const char *data, size_t datalen);
+static bool	jobs_cb(test_jobs_t *data, const cups_job_t *job);
+static bool	loop_cb(http_loop_t *loop, http_t *http, http_loop_events_t events, http_loop_events_t *data);
+static void	*server_client_cb(test_client_t *client);
+static bool	server_get(test_server_t *server, http_t *http);
+static ipp_t	*server_ipp(test_server_t *server, ipp_t *request);
+static void	*server_run_cb(test_server_t *server);
+static bool	server_start(test_server_t *server, http_addr_t *addr);
+static void	server_stop(test_server_t *server);
+
+
 //
 // Local globals...
 //
@@ -237,6 +286,19 @@ main(int  argc,				// I - Number of command-line arguments
   off_t		length, total;		// Length and total bytes
   time_t	start, current;		// Start and end time
   const char	*encoding;		// Negotiated Content-Encoding
+  test_server_t	server;			// Test HTTP/IPP server
+  char		*data;			// Test server data
+  static const char * const codings[] =
+  {					// Content codings to test
+#ifdef HAVE_BROTLI
+    "br",
+#endif // HAVE_BROTLI
+    "deflate",
+    "gzip",
+#ifdef HAVE_ZSTD
+    "zstd",
+#endif // HAVE_ZSTD
+  };
   static const char * const uri_status_strings[] =
   {					// URI encode/decode status strings
     "HTTP_URI_STATUS_OVERFLOW",
@@ -282,6 +344,29 @@ main(int  argc,				// I - Number of command-line arguments
       testError("httpGetDateString(%d) returned \"%s\"", (int)current, httpGetDateString(current, buffer, sizeof(buffer)));
     }
 
+    // Repeated and changed times use the cached string correctly...
+    testBegin("httpGetDateString() cached");
+
+    if (httpGetDateTime(httpGetDateString(start, buffer, sizeof(buffer))) != start)
+    {
+      failures ++;
+      testEndMessage(false, "wrong time for repeated value");
+    }
+    else if (httpGetDateTime(httpGetDateString(start + 86401, buffer, sizeof(buffer))) != start + 86401)
+    {
+      failures ++;
+      testEndMessage(false, "wrong time for new value");
+    }
+    else if (strlen(httpGetDateString(start, buffer, 6)) != 5)
+    {
+      failures ++;
+      testEndMessage(false, "did not truncate to buffer size");
+    }
+    else
+    {
+      testEnd(true);
+    }
+
     // httpDecode64()/httpEncode64()
     testBegin("httpDecode64()/httpEncode64()");
 
@@ -344,6 +429,34 @@ main(int  argc,				// I - Number of command-line arguments
       testEnd(false);
     }
 
+    // Repeated and invalidated lookups return the same (cached) hostname...
+    testBegin("httpGetHostname() cached");
+
+    if (!httpGetHostname(NULL, buffer, sizeof(buffer)) || strcmp(buffer, hostname))
+    {
+      failures ++;
+      testEndMessage(false, "got \"%s\", expected \"%s\"", buffer, hostname);
+    }
+    else if (!httpGetHostname(NULL, buffer, 4) || strlen(buffer) > 3 || strncmp(buffer, hostname, strlen(buffer)))
+    {
+      failures ++;
+      testEndMessage(false, "got \"%s\" with short buffer", buffer);
+    }
+    else
+    {
+      _httpHostnameChanged();
+
+      if (!httpGetHostname(NULL, buffer, sizeof(buffer)) || strcmp(buffer, hostname))
+      {
+	failures ++;
+	testEndMessage(false, "got \"%s\" after change, expected \"%s\"", buffer, hostname);
+      }
+      else
+      {
+        testEnd(true);
+      }
+    }
+
     // httpAddrGetList()
     testBegin("httpAddrGetList(%s)", hostname);
 
@@ -365,6 +478,41 @@ main(int  argc,				// I - Number of command-line arguments
       else
         testEndMessage(true, "%d address(es) for %s", i, hostname);
 
+      // Repeat the lookup from the cache and after flushing the cache...
+      testBegin("httpAddrGetList(%s) cached", hostname);
+      for (j = 0; j < 2; j ++)
+      {
+        http_addrlist_t	*addrlist2,	// Second lookup
+			*addr2;		// Current address
+
+        if (j)
+          httpAddrFlushCache();
+
+        if ((addrlist2 = httpAddrGetList(hostname, AF_UNSPEC, NULL)) == NULL)
+          break;
+
+	for (addr = addrlist, addr2 = addrlist2; addr && addr2; addr = addr->next, addr2 = addr2->next)
+	{
+	  if (!httpAddrIsEqual(&addr->addr, &addr2->addr))
+	    break;
+	}
+
+        httpAddrFreeList(addrlist2);
+
+        if (addr || addr2)
+          break;
+      }
+
+      if (j < 2)
+      {
+        failures ++;
+        testEndMessage(false, "%s", j ? "after httpAddrFlushCache" : "from cache");
+      }
+      else
+      {
+        testEnd(true);
+      }
+
       httpAddrFreeList(addrlist);
     }
     else if (!strncmp(hostname, "mac-", 4) && isdigit(hostname[4] & 255))
@@ -414,6 +562,40 @@ main(int  argc,				// I - Number of command-line arguments
       }
     }
 
+    if (!j)
+      testEndMessage(true, "%d URIs tested", (int)(sizeof(uri_tests) / sizeof(uri_tests[0])));
+
+    // Test httpSeparateURIView()...
+    testBegin("httpSeparateURIView()");
+    for (i = 0, j = 0; i < (int)(sizeof(uri_tests) / sizeof(uri_tests[0])); i ++)
+    {
+      http_uri_view_t	view;		// URI components
+      const char	*uri = uri_tests[i].uri;
+					// URI
+
+      uri_status = httpSeparateURIView(uri, &view);
+
+      // Copy the components, adding the implied "/" to the resource...
+      snprintf(scheme, sizeof(scheme), "%.*s", (int)view.scheme.length, uri + view.scheme.offset);
+      snprintf(username, sizeof(username), "%.*s", (int)view.username.length, uri + view.username.offset);
+      snprintf(hostname, sizeof(hostname), "%.*s", (int)view.host.length, uri + view.host.offset);
+      snprintf(resource, sizeof(resource), "%s%.*s", (uri_status >= HTTP_URI_STATUS_OK && (!view.resource.length || uri[view.resource.offset] == '?')) ? "/" : "", (int)view.resource.length, uri + view.resource.offset);
+
+      // Only compare components without encoded characters...
+      if (uri_status != uri_tests[i].result || (uri_status >= HTTP_URI_STATUS_OK && ((view.scheme.length && strcmp(scheme, uri_tests[i].scheme)) || (!strpbrk(username, "%+") && strcmp(username, uri_tests[i].username)) || (!strpbrk(hostname, "%+") && strcmp(hostname, uri_tests[i].hostname)) || view.port != uri_tests[i].port || (!strchr(resource, '%') && strcmp(resource, uri_tests[i].resource)))))
+      {
+        failures ++;
+
+	if (!j)
+	{
+	  testEnd(false);
+	  j = 1;
+	}
+
+        testError("\"%s\": Returned %s (\"%s\", \"%s\", \"%s\", %d, \"%s\")", uri, uri_status_strings[uri_status + 8], scheme, username, hostname, view.port, resource);
+      }
+    }
+
     if (!j)
       testEndMessage(true, "%d URIs tested", (int)(sizeof(uri_tests) / sizeof(uri_tests[0])));
 
@@ -467,162 +649,1070 @@ main(int  argc,				// I - Number of command-line arguments
     else
       testEndMessage(true, "%s", buffer);
 
-    return (failures);
-  }
-  else if (strstr(argv[1], "._tcp"))
-  {
-    // Test resolving an mDNS name.
-    char	resolved[1024];		// Resolved URI
-
-    testBegin("httpResolveURI(%s, HTTP_RESOLVE_DEFAULT)", argv[1]);
-
-    if (!httpResolveURI(argv[1], resolved, sizeof(resolved), HTTP_RESOLVE_DEFAULT, NULL, NULL))
+    // httpFieldValue
+    testBegin("httpFieldValue");
+    if (httpFieldValue("Accept") != HTTP_FIELD_ACCEPT || httpFieldValue("content-type") != HTTP_FIELD_CONTENT_TYPE || httpFieldValue("DASL") != HTTP_FIELD_DASL || httpFieldValue("date") != HTTP_FIELD_DATE || httpFieldValue("DAV") != HTTP_FIELD_DAV || httpFieldValue("WWW-Authenticate") != HTTP_FIELD_WWW_AUTHENTICATE || httpFieldValue("x-frame-options") != HTTP_FIELD_X_FRAME_OPTIONS)
     {
       testEnd(false);
-      return (1);
+      failures ++;
     }
-    else
-      testEndMessage(true, "%s", resolved);
-
-    testBegin("httpResolveURI(%s, HTTP_RESOLVE_FQDN)", argv[1]);
-
-    if (!httpResolveURI(argv[1], resolved, sizeof(resolved), HTTP_RESOLVE_FQDN, NULL, NULL))
+    else if (httpFieldValue("Accept-Bogus") != HTTP_FIELD_UNKNOWN || httpFieldValue("") != HTTP_FIELD_UNKNOWN || httpFieldValue("Zzz") != HTTP_FIELD_UNKNOWN)
     {
-      testEnd(false);
-      return (1);
+      testEndMessage(false, "found unknown field");
+      failures ++;
     }
-    else if (strstr(resolved, ".local:"))
+    else
+      testEnd(true);
+
+    // httpSetBufferSizes
+    testBegin("httpSetBufferSizes");
+    if ((http = httpConnect("localhost", 631, NULL, AF_UNSPEC, HTTP_ENCRYPTION_IF_REQUESTED, true, 0, NULL)) == NULL)
     {
-      testEndMessage(false, "%s", resolved);
-      return (1);
+      testEndMessage(false, "httpConnect: %s", cupsGetErrorString());
+      failures ++;
     }
     else
     {
-      testEndMessage(true, "%s", resolved);
-      return (0);
-    }
-  }
-  else if (!strcmp(argv[1], "-d") && argc == 3)
-  {
-    // Test httpDecode64
-    size_t	bufsize = sizeof(buffer);
-					// Output size
+      if (!httpSetBufferSizes(http, 262144, 65536))
+      {
+        testEndMessage(false, "262144/65536: %s", cupsGetErrorString());
+        failures ++;
+      }
+      else if (httpSetBufferSizes(http, 0, 32 * 1024 * 1024))
+      {
+        testEndMessage(false, "0/33554432 unexpectedly succeeded");
+        failures ++;
+      }
+      else if (!httpSetBufferSizes(http, 0, 0))
+      {
+        testEndMessage(false, "0/0: %s", cupsGetErrorString());
+        failures ++;
+      }
+      else
+        testEnd(true);
 
-    if (httpDecode64(buffer, &bufsize, argv[2], NULL))
-    {
-      fwrite(buffer, 1, bufsize, stdout);
-      return (0);
+      httpClose(http);
     }
 
-    return (1);
-  }
-  else if (!strcmp(argv[1], "-e") && argc == 3)
-  {
-    // Test httpEncode64 for Base64
-    if (httpEncode64(buffer, sizeof(buffer), argv[2], strlen(argv[2]), false))
+    // httpAcquireConnection/httpReleaseConnection
+    testBegin("httpAcquireConnection/httpReleaseConnection");
+    if ((addrlist = httpAddrGetList("127.0.0.1", AF_INET, "0")) == NULL)
     {
-      puts(buffer);
-      return (0);
+      testEndMessage(false, "httpAddrGetList: %s", cupsGetErrorString());
+      failures ++;
     }
-
-    return (1);
-  }
-  else if (!strcmp(argv[1], "-E") && argc == 3)
-  {
-    // Test httpEncode64 for Base64url
-    if (httpEncode64(buffer, sizeof(buffer), argv[2], strlen(argv[2]), true))
+    else
     {
-      puts(buffer);
-      return (0);
-    }
-
-    return (1);
-  }
-  else if (!strcmp(argv[1], "-u") && argc == 3)
-  {
-    // Test URI separation...
-    uri_status = httpSeparateURI(HTTP_URI_CODING_ALL, argv[2], scheme, sizeof(scheme), username, sizeof(username), hostname, sizeof(hostname), &port, resource, sizeof(resource));
-    printf("uri_status = %s\n", uri_status_strings[uri_status + 8]);
-    printf("scheme     = \"%s\"\n", scheme);
-    printf("username   = \"%s\"\n", username);
-    printf("hostname   = \"%s\"\n", hostname);
-    printf("port       = %d\n", port);
-    printf("resource   = \"%s\"\n", resource);
-
-    return (0);
-  }
+      int		lfd;		// Listen socket
+      http_addr_t	laddr;		// Listen address
+      socklen_t		laddrlen = sizeof(laddr);
+					// Length of listen address
+      http_t		*http2;		// Second connection
 
-  // Test HTTP GET requests...
-  http = NULL;
-  out = stdout;
+      if ((lfd = httpAddrListen(&addrlist->addr, 0)) < 0 || getsockname(lfd, (struct sockaddr *)&laddr, &laddrlen))
+      {
+        testEndMessage(false, "httpAddrListen: %s", cupsGetErrorString());
+        failures ++;
+      }
+      else if ((http = httpAcquireConnection("127.0.0.1", httpAddrGetPort(&laddr), AF_INET, HTTP_ENCRYPTION_IF_REQUESTED, true, 30000, NULL)) == NULL)
+      {
+        testEndMessage(false, "httpAcquireConnection: %s", cupsGetErrorString());
+        failures ++;
+      }
+      else
+      {
+        // Released connections should be reused...
+        httpReleaseConnection(http);
 
-  for (i = 1; i < argc; i ++)
-  {
-    int new_auth;
+        if ((http2 = httpAcquireConnection("127.0.0.1", httpAddrGetPort(&laddr), AF_INET, HTTP_ENCRYPTION_IF_REQUESTED, true, 0, NULL)) != http)
+        {
+          testEndMessage(false, "did not reuse idle connection");
+          failures ++;
+        }
+        else
+        {
+          // ...unless the pool is disabled
+          httpSetConnectionPool(0, 0);
+          httpReleaseConnection(http2);
 
-    if (!strcmp(argv[i], "-o"))
-    {
-      i ++;
-      if (i >= argc)
-        break;
+          http2 = httpAcquireConnection("127.0.0.1", httpAddrGetPort(&laddr), AF_INET, HTTP_ENCRYPTION_IF_REQUESTED, true, 0, NULL);
 
-      out = fopen(argv[i], "wb");
-      continue;
-    }
+          if (!http2 || httpGetFd(http2) >= 0)
+          {
+            testEndMessage(false, "reused connection with pool disabled");
+            failures ++;
+          }
+          else
+            testEnd(true);
 
-    httpSeparateURI(HTTP_URI_CODING_MOST, argv[i], scheme, sizeof(scheme),
-                    username, sizeof(username),
-                    hostname, sizeof(hostname), &port,
-		    resource, sizeof(resource));
+          httpSetConnectionPool(32, 30);
+        }
 
-    if (!_cups_strcasecmp(scheme, "https") || !_cups_strcasecmp(scheme, "ipps") ||
-        port == 443)
-      encryption = HTTP_ENCRYPTION_ALWAYS;
-    else
-      encryption = HTTP_ENCRYPTION_IF_REQUESTED;
+        httpClose(http2);
+      }
 
-    http = httpConnect(hostname, port, NULL, AF_UNSPEC, encryption, 1, 30000, NULL);
-    if (http == NULL)
-    {
-      perror(hostname);
-      continue;
-    }
+      if (lfd >= 0)
+        httpAddrClose(NULL, lfd);
 
-    if (httpIsEncrypted(http))
-    {
-      char *creds;
-      char info[1024], expstr[256];
-      static const char *trusts[] = { "OK", "Invalid", "Changed", "Expired", "Renewed", "Unknown" };
-      if ((creds = httpCopyPeerCredentials(http)) != NULL)
+      // httpLoop*
+      testBegin("httpLoopNew/httpLoopAdd/httpLoopRun/httpLoopWake");
+      laddrlen = sizeof(laddr);
+      if ((lfd = httpAddrListen(&addrlist->addr, 0)) < 0 || getsockname(lfd, (struct sockaddr *)&laddr, &laddrlen))
       {
-	char *lcreds;
-        http_trust_t trust = cupsGetCredentialsTrust(NULL, hostname, creds);
-
-        cupsGetCredentialsInfo(creds, info, sizeof(info));
-
-//	printf("Count: %u\n", (unsigned)cupsArrayGetCount(creds));
-        printf("Trust: %s\n", trusts[trust]);
-        printf("Expiration: %s\n", httpGetDateString(cupsGetCredentialsExpiration(creds), expstr, sizeof(expstr)));
-        printf("IsValidName: %s\n", cupsAreCredentialsValidForName(hostname, creds) ? "true" : "false");
-        printf("String: \"%s\"\n", info);
+        testEndMessage(false, "httpAddrListen: %s", cupsGetErrorString());
+        failures ++;
+      }
+      else if ((http = httpConnect("127.0.0.1", httpAddrGetPort(&laddr), NULL, AF_INET, HTTP_ENCRYPTION_IF_REQUESTED, false, 30000, NULL)) == NULL || (http2 = httpAcceptConnection(lfd, false)) == NULL)
+      {
+        testEndMessage(false, "httpConnect/httpAcceptConnection: %s", cupsGetErrorString());
+        failures ++;
+        httpClose(http);
+      }
+      else
+      {
+        http_loop_t		*loop = httpLoopNew();
+					// Event loop
+        http_loop_events_t	events = HTTP_LOOP_NONE;
+					// Events from callback
+        http_stats_t		stats;	// Connection statistics
 
-	printf("LoadCredentials: %s\n", (lcreds = cupsCopyCredentials(NULL, hostname)) != NULL ? "true" : "false");
-	cupsGetCredentialsInfo(lcreds, info, sizeof(info));
-//	printf("    Count: %u\n", (unsigned)cupsArrayGetCount(lcreds));
-	printf("    String: \"%s\"\n", info);
+        // An idle connection should time out...
+        httpLoopAdd(loop, http, HTTP_LOOP_READ, 100, (http_loop_cb_t)loop_cb, &events);
 
-#if 0
-        if (lcreds && cupsArrayGetCount(creds) == cupsArrayGetCount(lcreds))
+        if (httpLoopRun(loop, 1000) != 1 || events != HTTP_LOOP_TIMEOUT)
         {
-          http_credential_t	*cred, *lcred;
+          testEndMessage(false, "got events=%u, expected HTTP_LOOP_TIMEOUT", events);
+          failures ++;
+        }
+        else
+        {
+          // ...and report data from the other end...
+          events = HTTP_LOOP_NONE;
+          httpPrintf(http2, "Hello");
 
-          for (i = 1, cred = (http_credential_t *)cupsArrayGetFirst(creds), lcred = (http_credential_t *)cupsArrayGetFirst(lcreds);
-               cred && lcred;
-               i ++, cred = (http_credential_t *)cupsArrayGetNext(creds), lcred = (http_credential_t *)cupsArrayGetNext(lcreds))
+          if (httpLoopRun(loop, 1000) != 1 || events != HTTP_LOOP_READ)
           {
-            if (cred->datalen != lcred->datalen)
-              printf("    Credential #%d: Different lengths (saved=%d, current=%d)\n", i, (int)cred->datalen, (int)lcred->datalen);
-            else if (memcmp(cred->data, lcred->data, cred->datalen))
+            testEndMessage(false, "got events=%u, expected HTTP_LOOP_READ", events);
+            failures ++;
+          }
+          else if (httpLoopRun(loop, 0) != 0 || httpLoopRun(loop, -1) != 0)
+          {
+            // ...and the callback returning false removes it.
+            testEndMessage(false, "connection not removed from loop");
+            failures ++;
+          }
+          else
+          {
+            // A wakeup should end the wait early...
+            time_t	start = time(NULL);
+					// Start time
+
+            events = HTTP_LOOP_NONE;
+            httpLoopAdd(loop, http2, HTTP_LOOP_READ, 0, (http_loop_cb_t)loop_cb, &events);
+            httpLoopWake(loop);
+
+            if (httpLoopRun(loop, 10000) != 0 || events != HTTP_LOOP_NONE || (time(NULL) - start) > 5)
+            {
+              testEndMessage(false, "loop not woken up, got events=%u", events);
+              failures ++;
+            }
+            else
+              testEnd(true);
+          }
+
+          // httpGetStats
+          testBegin("httpGetStats");
+          if (!httpGetStats(http2, &stats) || stats.bytes_written != 5 || stats.write_calls != 1 || stats.reconnects != 0)
+          {
+            testEndMessage(false, "bytes_written=%u, write_calls=%u, reconnects=%u", (unsigned)stats.bytes_written, (unsigned)stats.write_calls, (unsigned)stats.reconnects);
+            failures ++;
+          }
+          else
+          {
+            testEnd(true);
+          }
+        }
+
+        httpLoopDelete(loop);
+        httpClose(http);
+        httpClose(http2);
+      }
+
+      if (lfd >= 0)
+        httpAddrClose(NULL, lfd);
+
+      // _cupsSetCachedAuth
+      testBegin("_cupsSetCachedAuth");
+      laddrlen = sizeof(laddr);
+      if ((lfd = httpAddrListen(&addrlist->addr, 0)) < 0 || getsockname(lfd, (struct sockaddr *)&laddr, &laddrlen))
+      {
+        testEndMessage(false, "httpAddrListen: %s", cupsGetErrorString());
+        failures ++;
+      }
+      else
+      {
+        http_t	*http3;			// Encrypted connection
+
+        http  = httpConnect("127.0.0.1", httpAddrGetPort(&laddr), NULL, AF_INET, HTTP_ENCRYPTION_IF_REQUESTED, true, 30000, NULL);
+        http2 = httpConnect("127.0.0.1", httpAddrGetPort(&laddr), NULL, AF_INET, HTTP_ENCRYPTION_IF_REQUESTED, true, 30000, NULL);
+        http3 = httpConnect("127.0.0.1", httpAddrGetPort(&laddr), NULL, AF_INET, HTTP_ENCRYPTION_IF_REQUESTED, true, 30000, NULL);
+
+        cupsSetPasswordCB(auth_password_cb, NULL);
+
+        if (!http || !http2 || !http3)
+        {
+          testEndMessage(false, "httpConnect: %s", cupsGetErrorString());
+          failures ++;
+        }
+        else
+        {
+          // Authenticate the first connection using Basic...
+          httpSetField(http, HTTP_FIELD_WWW_AUTHENTICATE, "Basic realm=\"testhttp\"");
+
+          if (!cupsDoAuthentication(http, "POST", "/") || !http->authstring || strncmp(http->authstring, "Basic ", 6))
+          {
+            testEndMessage(false, "cupsDoAuthentication failed");
+            failures ++;
+          }
+          else if (!_cupsSetCachedAuth(http2, "POST", "/") || !http2->authstring || strcmp(http->authstring, http2->authstring))
+          {
+            // A new connection to the same server should use the cached value...
+            testEndMessage(false, "cached authentication not used");
+            failures ++;
+          }
+          else
+          {
+            // ...but not an encrypted connection (or the other way around).
+            // Pretend the third connection is using TLS...
+            http3->tls = (_http_tls_t)http3;
+
+            if (_cupsSetCachedAuth(http3, "POST", "/") || http3->authstring)
+            {
+              testEndMessage(false, "cached authentication used with different encryption");
+              failures ++;
+            }
+            else
+              testEnd(true);
+
+            http3->tls = NULL;
+          }
+        }
+
+        cupsSetPasswordCB(NULL, NULL);
+
+        httpClose(http);
+        httpClose(http2);
+        httpClose(http3);
+        httpAddrClose(NULL, lfd);
+      }
+
+      // Content codings
+      for (i = 0; i < (int)(sizeof(codings) / sizeof(codings[0])); i ++)
+      {
+        char	cdata[65536],		// Content data
+		*cptr;			// Pointer into content data
+        size_t	cused;			// Bytes of content data received
+        cups_hash_t *ctx;		// Hash of content data received
+        unsigned char chash[32],	// Expected hash
+		rhash[32];		// Received hash
+
+        testBegin("httpWrite/httpPeek/httpRead(Content-Encoding: %s)", codings[i]);
+
+        for (j = 0, cptr = cdata; j < (int)sizeof(cdata); j ++)
+          *cptr++ = (char)('A' + (j * 7 + j / 57) % 26);
+
+        laddrlen = sizeof(laddr);
+        if ((lfd = httpAddrListen(&addrlist->addr, 0)) < 0 || getsockname(lfd, (struct sockaddr *)&laddr, &laddrlen))
+        {
+          testEndMessage(false, "httpAddrListen: %s", cupsGetErrorString());
+          failures ++;
+          break;
+        }
+        else if ((http = httpConnect("127.0.0.1", httpAddrGetPort(&laddr), NULL, AF_INET, HTTP_ENCRYPTION_IF_REQUESTED, true, 30000, NULL)) == NULL || (http2 = httpAcceptConnection(lfd, true)) == NULL)
+        {
+          testEndMessage(false, "httpConnect/httpAcceptConnection: %s", cupsGetErrorString());
+          failures ++;
+          httpClose(http);
+        }
+        else
+        {
+          // Send compressed content from the client...
+          httpClearFields(http);
+          httpSetField(http, HTTP_FIELD_TRANSFER_ENCODING, "chunked");
+
+          if (!httpWriteRequest(http, "POST", "/"))
+          {
+            testEndMessage(false, "httpWriteRequest: %s", cupsGetErrorString());
+            failures ++;
+          }
+          else
+          {
+            httpSetField(http, HTTP_FIELD_CONTENT_ENCODING, codings[i]);
+            httpWrite(http, cdata, sizeof(cdata));
+            httpWrite(http, "", 0);
+            httpFlushWrite(http);
+
+            // ...and receive it on the server.
+            if (httpReadRequest(http2, resource, sizeof(resource)) != HTTP_STATE_POST)
+            {
+              testEndMessage(false, "httpReadRequest: %s", cupsGetErrorString());
+              failures ++;
+            }
+            else
+            {
+              while ((status = httpUpdate(http2)) == HTTP_STATUS_CONTINUE);
+
+              httpSetField(http2, HTTP_FIELD_CONTENT_ENCODING, codings[i]);
+
+              ctx = cupsHashInit("sha2-256");
+              httpSetHash(http2, ctx);
+
+              if (httpPeek(http2, buffer, 1) != 1 || buffer[0] != cdata[0])
+              {
+                testEndMessage(false, "httpPeek: %s", strerror(httpGetError(http2)));
+                failures ++;
+                httpSetHash(http2, NULL);
+                cupsHashFinish(ctx, NULL, 0);
+              }
+              else
+              {
+                for (cused = 0; (bytes = (long)httpRead(http2, buffer, sizeof(buffer))) > 0; cused += (size_t)bytes)
+                {
+                  if (cused + (size_t)bytes > sizeof(cdata) || memcmp(buffer, cdata + cused, (size_t)bytes))
+                    break;
+                }
+
+                httpSetHash(http2, NULL);
+                cupsHashData("sha2-256", cdata, sizeof(cdata), chash, sizeof(chash));
+
+                if (bytes != 0 || cused != sizeof(cdata))
+                {
+                  testEndMessage(false, "got %u bytes, expected %u", (unsigned)cused, (unsigned)sizeof(cdata));
+                  failures ++;
+                  cupsHashFinish(ctx, NULL, 0);
+                }
+                else if (cupsHashFinish(ctx, rhash, sizeof(rhash)) != 32 || memcmp(chash, rhash, sizeof(chash)))
+                {
+                  testEndMessage(false, "httpSetHash: wrong hash for received data");
+                  failures ++;
+                }
+                else
+                  testEnd(true);
+              }
+            }
+          }
+
+          httpClose(http);
+          httpClose(http2);
+        }
+
+        httpAddrClose(NULL, lfd);
+      }
+
+      // _httpReadFile
+      for (i = 0; i < 2; i ++)
+      {
+        char	cdata[65536],		// Content data
+		*cptr,			// Pointer into content data
+		fdata[65536],		// File data
+		filename[1024];		// Temporary file
+        size_t	cused;			// Bytes of content data written
+        int	fd;			// Temporary file descriptor
+
+        testBegin("_httpReadFile(%s)", i ? "Content-Length" : "chunked");
+
+        for (j = 0, cptr = cdata; j < (int)sizeof(cdata); j ++)
+          *cptr++ = (char)('a' + (j * 5 + j / 131) % 26);
+
+        laddrlen = sizeof(laddr);
+        if ((lfd = httpAddrListen(&addrlist->addr, 0)) < 0 || getsockname(lfd, (struct sockaddr *)&laddr, &laddrlen))
+        {
+          testEndMessage(false, "httpAddrListen: %s", cupsGetErrorString());
+          failures ++;
+          break;
+        }
+        else if ((http = httpConnect("127.0.0.1", httpAddrGetPort(&laddr), NULL, AF_INET, HTTP_ENCRYPTION_IF_REQUESTED, true, 30000, NULL)) == NULL || (http2 = httpAcceptConnection(lfd, true)) == NULL)
+        {
+          testEndMessage(false, "httpConnect/httpAcceptConnection: %s", cupsGetErrorString());
+          failures ++;
+          httpClose(http);
+        }
+        else if ((fd = cupsCreateTempFd(NULL, NULL, filename, sizeof(filename))) < 0)
+        {
+          testEndMessage(false, "cupsCreateTempFd: %s", cupsGetErrorString());
+          failures ++;
+          httpClose(http);
+          httpClose(http2);
+        }
+        else
+        {
+          // Send the content from the client in several chunks...
+          httpClearFields(http);
+          if (i)
+            httpSetLength(http, sizeof(cdata));
+          else
+            httpSetField(http, HTTP_FIELD_TRANSFER_ENCODING, "chunked");
+
+          if (!httpWriteRequest(http, "POST", "/"))
+          {
+            testEndMessage(false, "httpWriteRequest: %s", cupsGetErrorString());
+            failures ++;
+          }
+          else
+          {
+            for (cused = 0; cused < sizeof(cdata); cused += 16384)
+              httpWrite(http, cdata + cused, 16384);
+            if (!i)
+              httpWrite(http, "", 0);
+            httpFlushWrite(http);
+
+            // ...and receive it on the server, reading the start with httpRead
+            // like an IPP request...
+            if (httpReadRequest(http2, resource, sizeof(resource)) != HTTP_STATE_POST)
+            {
+              testEndMessage(false, "httpReadRequest: %s", cupsGetErrorString());
+              failures ++;
+            }
+            else
+            {
+              while ((status = httpUpdate(http2)) == HTTP_STATUS_CONTINUE);
+
+              for (cused = 0; cused < 100 && (bytes = (long)httpRead(http2, fdata + cused, 100 - cused)) > 0; cused += (size_t)bytes);
+
+              if (write(fd, fdata, cused) != (ssize_t)cused)
+                bytes = -1;
+              else
+              {
+                while ((bytes = (long)_httpReadFile(http2, fd)) > 0)
+                  cused += (size_t)bytes;
+              }
+
+              lseek(fd, 0, SEEK_SET);
+
+              if (bytes != 0 || cused != sizeof(cdata) || read(fd, fdata, sizeof(fdata)) != (ssize_t)sizeof(fdata) || memcmp(cdata, fdata, sizeof(cdata)))
+              {
+                testEndMessage(false, "got %u bytes, expected %u", (unsigned)cused, (unsigned)sizeof(cdata));
+                failures ++;
+              }
+              else if (httpGetState(http2) != HTTP_STATE_POST_SEND)
+              {
+                testEndMessage(false, "got state %s, expected %s", httpStateString(httpGetState(http2)), httpStateString(HTTP_STATE_POST_SEND));
+                failures ++;
+              }
+              else
+                testEnd(true);
+            }
+          }
+
+          close(fd);
+          unlink(filename);
+
+          httpClose(http);
+          httpClose(http2);
+        }
+
+        httpAddrClose(NULL, lfd);
+      }
+
+      // httpSetWriteCoalescing
+      testBegin("httpSetWriteCoalescing");
+      laddrlen = sizeof(laddr);
+      if ((lfd = httpAddrListen(&addrlist->addr, 0)) < 0 || getsockname(lfd, (struct sockaddr *)&laddr, &laddrlen))
+      {
+        testEndMessage(false, "httpAddrListen: %s", cupsGetErrorString());
+        failures ++;
+      }
+      else if ((http = httpConnect("127.0.0.1", httpAddrGetPort(&laddr), NULL, AF_INET, HTTP_ENCRYPTION_IF_REQUESTED, true, 30000, NULL)) == NULL || (http2 = httpAcceptConnection(lfd, true)) == NULL)
+      {
+        testEndMessage(false, "httpConnect/httpAcceptConnection: %s", cupsGetErrorString());
+        failures ++;
+        httpClose(http);
+        httpAddrClose(NULL, lfd);
+      }
+      else
+      {
+        http_stats_t	before,		// Server statistics before responses
+			after;		// Server statistics after responses
+        char		line[256];	// Line from connection
+        int		responses = 0;	// Number of responses received
+
+        // Send three pipelined requests and answer them on the server...
+        httpPrintf(http, "GET /1 HTTP/1.1\r\nHost: localhost\r\n\r\nGET /2 HTTP/1.1\r\nHost: localhost\r\n\r\nGET /3 HTTP/1.1\r\nHost: localhost\r\n\r\n");
+        httpFlushWrite(http);
+
+        httpSetWriteCoalescing(http2, true);
+        httpGetStats(http2, &before);
+
+        for (j = 0; j < 3; j ++)
+        {
+          if (httpReadRequest(http2, resource, sizeof(resource)) != HTTP_STATE_GET)
+            break;
+
+          while ((status = httpUpdate(http2)) == HTTP_STATUS_CONTINUE);
+
+          httpClearFields(http2);
+          httpSetField(http2, HTTP_FIELD_CONTENT_TYPE, "text/plain");
+          httpSetLength(http2, 6);
+
+          if (!httpWriteResponse(http2, HTTP_STATUS_OK) || httpWrite(http2, "hello\n", 6) != 6)
+            break;
+
+          if (j < 2 && !httpWait(http2, 0))
+            break;
+        }
+
+        httpGetStats(http2, &after);
+
+        if (j < 3)
+        {
+          testEndMessage(false, "request %d failed: %s", j + 1, cupsGetErrorString());
+          failures ++;
+        }
+        else if (after.write_calls != before.write_calls)
+        {
+          testEndMessage(false, "%u writes before flushing, expected 0", (unsigned)(after.write_calls - before.write_calls));
+          failures ++;
+        }
+        else
+        {
+          // No more requests, so waiting sends all three responses at once...
+          httpWait(http2, 0);
+          httpGetStats(http2, &after);
+
+          while (responses < 3 && httpGets(http, line, sizeof(line)))
+          {
+            if (!strcmp(line, "hello"))
+              responses ++;
+          }
+
+          if (after.write_calls != before.write_calls + 1)
+          {
+            testEndMessage(false, "%u writes, expected 1", (unsigned)(after.write_calls - before.write_calls));
+            failures ++;
+          }
+          else if (responses != 3)
+          {
+            testEndMessage(false, "got %d responses, expected 3", responses);
+            failures ++;
+          }
+          else
+          {
+            testEnd(true);
+          }
+        }
+
+        httpClose(http);
+        httpClose(http2);
+        httpAddrClose(NULL, lfd);
+      }
+
+      // httpGets/httpGetsView
+      testBegin("httpGets/httpGetsView");
+      laddrlen = sizeof(laddr);
+      if ((lfd = httpAddrListen(&addrlist->addr, 0)) < 0 || getsockname(lfd, (struct sockaddr *)&laddr, &laddrlen))
+      {
+        testEndMessage(false, "httpAddrListen: %s", cupsGetErrorString());
+        failures ++;
+      }
+      else if ((http = httpConnect("127.0.0.1", httpAddrGetPort(&laddr), NULL, AF_INET, HTTP_ENCRYPTION_IF_REQUESTED, true, 30000, NULL)) == NULL || (http2 = httpAcceptConnection(lfd, true)) == NULL)
+      {
+        testEndMessage(false, "httpConnect/httpAcceptConnection: %s", cupsGetErrorString());
+        failures ++;
+        httpClose(http);
+        httpAddrClose(NULL, lfd);
+      }
+      else
+      {
+        char		longline[2001],	// Long line
+			line[4096];	// Line from connection
+        const char	*view;		// Line view
+        size_t		viewlen;	// Length of line view
+
+        memset(longline, 'L', sizeof(longline) - 1);
+        longline[sizeof(longline) - 1] = '\0';
+
+        httpPrintf(http, "first\r\nsecond line\n\r\n%s\r\nla\rst\r\n", longline);
+        httpFlushWrite(http);
+
+        if (!httpGets(http2, line, sizeof(line)) || strcmp(line, "first"))
+        {
+          failures ++;
+          testEndMessage(false, "httpGets: got \"%s\", expected \"first\"", line);
+        }
+        else if ((view = httpGetsView(http2, &viewlen)) == NULL || viewlen != 11 || memcmp(view, "second line", 11))
+        {
+          failures ++;
+          testEndMessage(false, "httpGetsView: got \"%.*s\", expected \"second line\"", (int)viewlen, view ? view : "");
+        }
+        else if ((view = httpGetsView(http2, &viewlen)) == NULL || viewlen != 0)
+        {
+          failures ++;
+          testEndMessage(false, "httpGetsView: got \"%.*s\", expected \"\"", (int)viewlen, view ? view : "");
+        }
+        else if ((view = httpGetsView(http2, &viewlen)) == NULL || viewlen != strlen(longline) || memcmp(view, longline, viewlen))
+        {
+          failures ++;
+          testEndMessage(false, "httpGetsView: got %u bytes, expected %u", (unsigned)viewlen, (unsigned)strlen(longline));
+        }
+        else if (!httpGets(http2, line, sizeof(line)) || strcmp(line, "last"))
+        {
+          failures ++;
+          testEndMessage(false, "httpGets: got \"%s\", expected \"last\"", line);
+        }
+        else
+        {
+          testEnd(true);
+        }
+
+
+        httpClose(http);
+        httpClose(http2);
+        httpAddrClose(NULL, lfd);
+      }
+
+      // httpAddrListenMultiple/httpAcceptConnections
+      testBegin("httpAddrListenMultiple/httpAcceptConnections");
+      {
+        int		lfds[2];	// Listen sockets
+        http_t		*clients[4],	// Client connections
+			*servers[4];	// Server connections
+	size_t		num_clients,	// Number of client connections
+			num_servers = 0;// Number of server connections
+	struct pollfd	pfds[2];	// Poll data
+
+        laddrlen = sizeof(laddr);
+
+        if (httpAddrListenMultiple(&addrlist->addr, 0, 2, lfds) != 2 || getsockname(lfds[0], (struct sockaddr *)&laddr, &laddrlen))
+        {
+          testEndMessage(false, "httpAddrListenMultiple: %s", cupsGetErrorString());
+          failures ++;
+        }
+        else
+        {
+          for (num_clients = 0; num_clients < 4; num_clients ++)
+          {
+            if ((clients[num_clients] = httpConnect("127.0.0.1", httpAddrGetPort(&laddr), NULL, AF_INET, HTTP_ENCRYPTION_IF_REQUESTED, true, 30000, NULL)) == NULL)
+              break;
+          }
+
+          pfds[0].fd     = lfds[0];
+          pfds[0].events = POLLIN;
+          pfds[1].fd     = lfds[1];
+          pfds[1].events = POLLIN;
+
+          while (num_servers < num_clients && poll(pfds, 2, 1000) > 0)
+          {
+            for (i = 0; i < 2; i ++)
+            {
+              if (pfds[i].revents & POLLIN)
+                num_servers += httpAcceptConnections(lfds[i], true, 4 - num_servers, servers + num_servers);
+            }
+          }
+
+          if (num_clients != 4)
+          {
+            testEndMessage(false, "httpConnect: %s", cupsGetErrorString());
+            failures ++;
+          }
+          else if (num_servers != num_clients)
+          {
+            testEndMessage(false, "accepted %u of %u connections", (unsigned)num_servers, (unsigned)num_clients);
+            failures ++;
+          }
+          else
+            testEnd(true);
+
+          while (num_clients > 0)
+            httpClose(clients[-- num_clients]);
+          while (num_servers > 0)
+            httpClose(servers[-- num_servers]);
+
+          httpAddrClose(NULL, lfds[0]);
+          httpAddrClose(NULL, lfds[1]);
+        }
+      }
+
+      // Tests using an HTTP/IPP server...
+      memset(&server, 0, sizeof(server));
+      server.num_jobs = 5;
+      server.datalen  = 3500000;
+
+      if ((data = malloc(server.datalen)) != NULL)
+      {
+        for (i = 0; i < (int)server.datalen; i ++)
+          data[i] = (char)(i + i / 251);
+      }
+
+      server.data = data;
+
+      if (!data || !server_start(&server, &addrlist->addr))
+      {
+        testBegin("server_start");
+        testEndMessage(false, "%s", cupsGetErrorString());
+        failures ++;
+      }
+      else if ((http = httpConnect("127.0.0.1", server.port, NULL, AF_INET, HTTP_ENCRYPTION_IF_REQUESTED, true, 30000, NULL)) == NULL)
+      {
+        testBegin("httpConnect");
+        testEndMessage(false, "%s", cupsGetErrorString());
+        failures ++;
+        server_stop(&server);
+      }
+      else
+      {
+        test_jobs_t	jobs;		// Jobs from cupsGetJobsIter
+        ipp_t		*requests[20],	// IPP requests
+			*responses[20];	// IPP responses
+        size_t		num_responses;	// Number of responses
+
+        // cupsGetJobsIter
+        testBegin("cupsGetJobsIter(limit=2)");
+        memset(&jobs, 0, sizeof(jobs));
+        jobs.max_ids        = 10;
+        server.num_requests = 0;
+
+        if (!cupsGetJobsIter(http, NULL, false, CUPS_WHICHJOBS_ALL, 0, 2, (cups_job_cb_t)jobs_cb, &jobs))
+        {
+          testEndMessage(false, "%s", cupsGetErrorString());
+          failures ++;
+        }
+        else if (jobs.num_ids != 5 || jobs.ids[0] != 1 || jobs.ids[1] != 2 || jobs.ids[2] != 3 || jobs.ids[3] != 4 || jobs.ids[4] != 5)
+        {
+          testEndMessage(false, "got %u jobs, expected 1 to 5", (unsigned)jobs.num_ids);
+          failures ++;
+        }
+        else if (server.num_requests != 3)
+        {
+          testEndMessage(false, "got %d requests, expected 3", (int)server.num_requests);
+          failures ++;
+        }
+        else
+          testEnd(true);
+
+        testBegin("cupsGetJobsIter(stop after 3)");
+        memset(&jobs, 0, sizeof(jobs));
+        jobs.max_ids = 3;
+
+        if (!cupsGetJobsIter(http, NULL, false, CUPS_WHICHJOBS_ALL, 0, 0, (cups_job_cb_t)jobs_cb, &jobs))
+        {
+          testEndMessage(false, "%s", cupsGetErrorString());
+          failures ++;
+        }
+        else if (jobs.num_ids != 3 || jobs.ids[0] != 1 || jobs.ids[1] != 2 || jobs.ids[2] != 3)
+        {
+          testEndMessage(false, "got %u jobs, expected 1 to 3", (unsigned)jobs.num_ids);
+          failures ++;
+        }
+        else
+          testEnd(true);
+
+        testBegin("cupsGetJobsIter(error)");
+        memset(&jobs, 0, sizeof(jobs));
+        jobs.max_ids = 10;
+
+        if (cupsGetJobsIter(http, "bad", false, CUPS_WHICHJOBS_ALL, 0, 2, (cups_job_cb_t)jobs_cb, &jobs))
+        {
+          testEndMessage(false, "unexpected success");
+          failures ++;
+        }
+        else if (cupsGetError() != IPP_STATUS_ERROR_NOT_FOUND || strcmp(cupsGetErrorString(), "No such printer."))
+        {
+          testEndMessage(false, "got %s (%s), expected client-error-not-found (No such printer.)", ippErrorString(cupsGetError()), cupsGetErrorString());
+          failures ++;
+        }
+        else if (jobs.num_ids != 0)
+        {
+          testEndMessage(false, "got %u jobs, expected 0", (unsigned)jobs.num_ids);
+          failures ++;
+        }
+        else
+          testEnd(true);
+
+        // cupsDoRequests
+        for (j = 0; j < 2; j ++)
+        {
+          testBegin("cupsDoRequests(%s)", j ? "close after 3" : "pipelined");
+          server.max_requests = j ? 3 : 0;
+          server.num_requests = 0;
+
+          for (k = 0; k < 20; k ++)
+          {
+            requests[k] = ippNewRequest(IPP_OP_GET_JOB_ATTRIBUTES);
+            ippAddString(requests[k], IPP_TAG_OPERATION, IPP_TAG_URI, "printer-uri", NULL, "ipp://localhost/printers/test");
+            ippAddInteger(requests[k], IPP_TAG_OPERATION, IPP_TAG_INTEGER, "job-id", k + 1);
+          }
+
+          num_responses = cupsDoRequests(http, 20, requests, "/", responses);
+
+          for (k = 0; k < 20; k ++)
+          {
+            if (!responses[k] || ippGetStatusCode(responses[k]) != IPP_STATUS_OK || ippGetInteger(ippFindAttribute(responses[k], "job-id", IPP_TAG_INTEGER), 0) != k + 1)
+              break;
+          }
+
+          if (num_responses != 20)
+          {
+            testEndMessage(false, "got %u responses, expected 20", (unsigned)num_responses);
+            failures ++;
+          }
+          else if (k < 20)
+          {
+            testEndMessage(false, "bad response %d", k + 1);
+            failures ++;
+          }
+          else if (server.num_requests < 20)
+          {
+            testEndMessage(false, "got %d requests, expected at least 20", (int)server.num_requests);
+            failures ++;
+          }
+          else
+            testEnd(true);
+
+          for (k = 0; k < 20; k ++)
+            ippDelete(responses[k]);
+        }
+
+        server.max_requests = 0;
+
+        // cupsGetFileParallel
+        testBegin("cupsGetFileParallel(ranged)");
+        server.ranges   = true;
+        server.num_gets = 0;
+
+        if ((status = cupsGetFileParallel(http, "/testhttp.dat", "testhttp.dat", false, 4)) != HTTP_STATUS_OK)
+        {
+          testEndMessage(false, "%s", httpStatusString(status));
+          failures ++;
+        }
+        else if (!compare_file("testhttp.dat", server.data, server.datalen))
+        {
+          testEndMessage(false, "file contents do not match");
+          failures ++;
+        }
+        else if (server.num_gets < 2)
+        {
+          testEndMessage(false, "got %d GET requests, expected more than 1", (int)server.num_gets);
+          failures ++;
+        }
+        else
+          testEnd(true);
+
+        testBegin("cupsGetFileParallel(resume)");
+        if ((out = fopen("testhttp.dat", "wb")) != NULL)
+        {
+          fwrite(server.data, 1, 1000, out);
+          fclose(out);
+        }
+
+        if ((status = cupsGetFileParallel(http, "/testhttp.dat", "testhttp.dat", true, 1)) != HTTP_STATUS_OK)
+        {
+          testEndMessage(false, "%s", httpStatusString(status));
+          failures ++;
+        }
+        else if (!compare_file("testhttp.dat", server.data, server.datalen))
+        {
+          testEndMessage(false, "file contents do not match");
+          failures ++;
+        }
+        else if (server.last_start != 1000)
+        {
+          testEndMessage(false, "got range starting at %ld, expected 1000", (long)server.last_start);
+          failures ++;
+        }
+        else
+          testEnd(true);
+
+        testBegin("cupsGetFileParallel(resume, no ranges)");
+        server.ranges = false;
+
+        if ((out = fopen("testhttp.dat", "wb")) != NULL)
+        {
+          // Stale partial file that is longer than the resource...
+          for (length = 0; length < (off_t)server.datalen + 1000; length ++)
+            putc('x', out);
+          fclose(out);
+        }
+
+        if ((status = cupsGetFileParallel(http, "/testhttp.dat", "testhttp.dat", true, 4)) != HTTP_STATUS_OK)
+        {
+          testEndMessage(false, "%s", httpStatusString(status));
+          failures ++;
+        }
+        else if (!compare_file("testhttp.dat", server.data, server.datalen))
+        {
+          testEndMessage(false, "file contents do not match");
+          failures ++;
+        }
+        else
+          testEnd(true);
+
+        unlink("testhttp.dat");
+
+        httpClose(http);
+        server_stop(&server);
+      }
+
+      free(data);
+
+      httpAddrFreeList(addrlist);
+    }
+
+    return (failures);
+  }
+  else if (strstr(argv[1], "._tcp"))
+  {
+    // Test resolving an mDNS name.
+    char	resolved[1024];		// Resolved URI
+
+    testBegin("httpResolveURI(%s, HTTP_RESOLVE_DEFAULT)", argv[1]);
+
+    if (!httpResolveURI(argv[1], resolved, sizeof(resolved), HTTP_RESOLVE_DEFAULT, NULL, NULL))
+    {
+      testEnd(false);
+      return (1);
+    }
+    else
+      testEndMessage(true, "%s", resolved);
+
+    testBegin("httpResolveURI(%s, HTTP_RESOLVE_FQDN)", argv[1]);
+
+    if (!httpResolveURI(argv[1], resolved, sizeof(resolved), HTTP_RESOLVE_FQDN, NULL, NULL))
+    {
+      testEnd(false);
+      return (1);
+    }
+    else if (strstr(resolved, ".local:"))
+    {
+      testEndMessage(false, "%s", resolved);
+      return (1);
+    }
+    else
+    {
+      testEndMessage(true, "%s", resolved);
+      return (0);
+    }
+  }
+  else if (!strcmp(argv[1], "-d") && argc == 3)
+  {
+    // Test httpDecode64
+    size_t	bufsize = sizeof(buffer);
+					// Output size
+
+    if (httpDecode64(buffer, &bufsize, argv[2], NULL))
+    {
+      fwrite(buffer, 1, bufsize, stdout);
+      return (0);
+    }
+
+    return (1);
+  }
+  else if (!strcmp(argv[1], "-e") && argc == 3)
+  {
+    // Test httpEncode64 for Base64
+    if (httpEncode64(buffer, sizeof(buffer), argv[2], strlen(argv[2]), false))
+    {
+      puts(buffer);
+      return (0);
+    }
+
+    return (1);
+  }
+  else if (!strcmp(argv[1], "-E") && argc == 3)
+  {
+    // Test httpEncode64 for Base64url
+    if (httpEncode64(buffer, sizeof(buffer), argv[2], strlen(argv[2]), true))
+    {
+      puts(buffer);
+      return (0);
+    }
+
+    return (1);
+  }
+  else if (!strcmp(argv[1], "-u") && argc == 3)
+  {
+    // Test URI separation...
+    uri_status = httpSeparateURI(HTTP_URI_CODING_ALL, argv[2], scheme, sizeof(scheme), username, sizeof(username), hostname, sizeof(hostname), &port, resource, sizeof(resource));
+    printf("uri_status = %s\n", uri_status_strings[uri_status + 8]);
+    printf("scheme     = \"%s\"\n", scheme);
+    printf("username   = \"%s\"\n", username);
+    printf("hostname   = \"%s\"\n", hostname);
+    printf("port       = %d\n", port);
+    printf("resource   = \"%s\"\n", resource);
+
+    return (0);
+  }
+
+  // Test HTTP GET requests...
+  http = NULL;
+  out = stdout;
+
+  for (i = 1; i < argc; i ++)
+  {
+    int new_auth;
+
+    if (!strcmp(argv[i], "-o"))
+    {
+      i ++;
+      if (i >= argc)
+        break;
+
+      out = fopen(argv[i], "wb");
+      continue;
+    }
+
+    httpSeparateURI(HTTP_URI_CODING_MOST, argv[i], scheme, sizeof(scheme),
+                    username, sizeof(username),
+                    hostname, sizeof(hostname), &port,
+		    resource, sizeof(resource));
+
+    if (!_cups_strcasecmp(scheme, "https") || !_cups_strcasecmp(scheme, "ipps") ||
+        port == 443)
+      encryption = HTTP_ENCRYPTION_ALWAYS;
+    else
+      encryption = HTTP_ENCRYPTION_IF_REQUESTED;
+
+    http = httpConnect(hostname, port, NULL, AF_UNSPEC, encryption, 1, 30000, NULL);
+    if (http == NULL)
+    {
+      perror(hostname);
+      continue;
+    }
+
+    if (httpIsEncrypted(http))
+    {
+      char *creds;
+      char info[1024], expstr[256];
+      static const char *trusts[] = { "OK", "Invalid", "Changed", "Expired", "Renewed", "Unknown" };
+      if ((creds = httpCopyPeerCredentials(http)) != NULL)
+      {
+	char *lcreds;
+        http_trust_t trust = cupsGetCredentialsTrust(NULL, hostname, creds);
+
+        cupsGetCredentialsInfo(creds, info, sizeof(info));
+
+//	printf("Count: %u\n", (unsigned)cupsArrayGetCount(creds));
+        printf("Trust: %s\n", trusts[trust]);
+        printf("Expiration: %s\n", httpGetDateString(cupsGetCredentialsExpiration(creds), expstr, sizeof(expstr)));
+        printf("IsValidName: %s\n", cupsAreCredentialsValidForName(hostname, creds) ? "true" : "false");
+        printf("String: \"%s\"\n", info);
+
+	printf("LoadCredentials: %s\n", (lcreds = cupsCopyCredentials(NULL, hostname)) != NULL ? "true" : "false");
+	cupsGetCredentialsInfo(lcreds, info, sizeof(info));
+//	printf("    Count: %u\n", (unsigned)cupsArrayGetCount(lcreds));
+	printf("    String: \"%s\"\n", info);
+
+#if 0
+        if (lcreds && cupsArrayGetCount(creds) == cupsArrayGetCount(lcreds))
+        {
+          http_credential_t	*cred, *lcred;
+
+          for (i = 1, cred = (http_credential_t *)cupsArrayGetFirst(creds), lcred = (http_credential_t *)cupsArrayGetFirst(lcreds);
+               cred && lcred;
+               i ++, cred = (http_credential_t *)cupsArrayGetNext(creds), lcred = (http_credential_t *)cupsArrayGetNext(lcreds))
+          {
+            if (cred->datalen != lcred->datalen)
+              printf("    Credential #%d: Different lengths (saved=%d, current=%d)\n", i, (int)cred->datalen, (int)lcred->datalen);
+            else if (memcmp(cred->data, lcred->data, cred->datalen))
               printf("    Credential #%d: Different data\n", i);
             else
               printf("    Credential #%d: Matches\n", i);
@@ -862,3 +1952,423 @@ main(int  argc,				// I - Number of command-line arguments
 
   return (0);
 }
+
+
+//
+// 'auth_password_cb()' - Return a password for authentication tests.
+//
+
+static const char *			// O - Password
+auth_password_cb(const char *prompt,	// I - Prompt (unused)
+                 http_t     *http,	// I - Connection (unused)
+                 const char *method,	// I - Request method (unused)
+                 const char *resource,	// I - Resource path (unused)
+                 void       *user_data)	// I - User data (unused)
+{
+  (void)prompt;
+  (void)http;
+  (void)method;
+  (void)resource;
+  (void)user_data;
+
+  return ("testhttp");
+}
+
+
+//
+// 'compare_file()' - Compare the contents of a file to a buffer.
+//
+
+static bool				// O - `true` if the same, `false` otherwise
+compare_file(const char *filename,	// I - Filename
+             const char *data,		// I - Expected data
+             size_t     datalen)	// I - Length of expected data
+{
+  cups_file_t	*fp;			// File
+  char		buffer[8192];		// Read buffer
+  ssize_t	bytes;			// Bytes read
+  size_t	total = 0;		// Total bytes read
+  bool		ret = true;		// Return value
+
+
+  if ((fp = cupsFileOpen(filename, "r")) == NULL)
+    return (false);
+
+  while (ret && (bytes = cupsFileRead(fp, buffer, sizeof(buffer))) > 0)
+  {
+    if ((total + (size_t)bytes) > datalen || memcmp(buffer, data + total, (size_t)bytes))
+      ret = false;
+
+    total += (size_t)bytes;
+  }
+
+  cupsFileClose(fp);
+
+  return (ret && total == datalen);
+}
+
+//
+// 'jobs_cb()' - Record the jobs from an iterator.
+//
+
+static bool				// O - `true` to continue, `false` to stop
+jobs_cb(test_jobs_t      *data,		// I - Job data
+        const cups_job_t *job)		// I - Job
+{
+  if (data->num_ids < (sizeof(data->ids) / sizeof(data->ids[0])))
+    data->ids[data->num_ids] = job->id;
+
+  data->num_ids ++;
+
+  return (data->num_ids < data->max_ids);
+}
+
+
+
+//
+// 'loop_cb()' - Record events from an event loop.
+//
+
+static bool				// O - `true` to keep watching, `false` to remove
+loop_cb(http_loop_t        *loop,	// I - Event loop
+        http_t             *http,	// I - HTTP connection
+        http_loop_events_t events,	// I - Events
+        http_loop_events_t *data)	// I - Events from callback
+{
+  (void)loop;
+  (void)http;
+
+  *data = events;
+
+  return (events != HTTP_LOOP_READ);
+}
+
+
+//
+// 'server_client_cb()' - Answer requests on a test server connection.
+//
+
+static void *				// O - Thread exit status
+server_client_cb(test_client_t *client)	// I - Client connection
+{
+  test_server_t	*server = client->server;
+					// Test server
+  http_t	*http = client->http;	// HTTP connection
+  http_state_t	state;			// Request state
+  http_status_t	status;			// Request status
+  char		resource[256];		// Resource path
+  ipp_t		*request,		// IPP request
+		*response;		// IPP response
+  ipp_state_t	ipp_state;		// IPP read state
+  int		count = 0;		// Number of requests on this connection
+
+
+  free(client);
+
+  while (!server->stop)
+  {
+    // Wait for the next request...
+    if (!httpWait(http, 100))
+      continue;
+
+    while ((state = httpReadRequest(http, resource, sizeof(resource))) == HTTP_STATE_WAITING)
+      usleep(1000);
+
+    if (state != HTTP_STATE_GET && state != HTTP_STATE_POST)
+      break;
+
+    while ((status = httpUpdate(http)) == HTTP_STATUS_CONTINUE);
+
+    if (status != HTTP_STATUS_OK)
+      break;
+
+    if (state == HTTP_STATE_GET)
+    {
+      if (!server_get(server, http))
+        break;
+
+      continue;
+    }
+
+    if (httpGetExpect(http) == HTTP_STATUS_CONTINUE)
+      httpWriteResponse(http, HTTP_STATUS_CONTINUE);
+
+    // Read the IPP request and send the response...
+    request = ippNew();
+
+    while ((ipp_state = ippRead(http, request)) != IPP_STATE_DATA)
+    {
+      if (ipp_state == IPP_STATE_ERROR)
+        break;
+    }
+
+    if (ipp_state == IPP_STATE_ERROR)
+    {
+      ippDelete(request);
+      break;
+    }
+
+    cupsAtomicInc(&server->num_requests);
+
+    response = server_ipp(server, request);
+    count ++;
+
+    httpClearFields(http);
+    httpSetField(http, HTTP_FIELD_CONTENT_TYPE, "application/ipp");
+    if (server->max_requests > 0 && count >= server->max_requests)
+      httpSetField(http, HTTP_FIELD_CONNECTION, "close");
+    httpSetLength(http, ippGetLength(response));
+    httpWriteResponse(http, HTTP_STATUS_OK);
+
+    while ((ipp_state = ippWrite(http, response)) != IPP_STATE_DATA)
+    {
+      if (ipp_state == IPP_STATE_ERROR)
+        break;
+    }
+
+    httpFlushWrite(http);
+
+    ippDelete(request);
+    ippDelete(response);
+
+    if (server->max_requests > 0 && count >= server->max_requests)
+      break;
+  }
+
+  httpClose(http);
+
+  return (NULL);
+}
+
+
+//
+// 'server_get()' - Answer a GET request for the test server.
+//
+// Range requests are only honored when "ranges" is `true`, otherwise the whole
+// data is returned like a server without range support.
+//
+
+static bool				// O - `true` to keep the connection, `false` to close it
+server_get(test_server_t *server,	// I - Test server
+           http_t        *http)		// I - HTTP connection
+{
+  const char	*range;			// Range field
+  char		*ptr,			// Pointer into Range value
+		value[256];		// Content-Range value
+  off_t		first = 0,		// First byte
+		last;			// Last byte
+  http_status_t	status = HTTP_STATUS_OK;// HTTP status
+
+
+  cupsAtomicInc(&server->num_gets);
+
+  last = (off_t)server->datalen - 1;
+
+  if (server->ranges && (range = httpGetField(http, HTTP_FIELD_RANGE)) != NULL && !strncmp(range, "bytes=", 6))
+  {
+    first = (off_t)strtoll(range + 6, &ptr, 10);
+
+    if (*ptr == '-' && isdigit(ptr[1] & 255) && (off_t)strtoll(ptr + 1, NULL, 10) < last)
+      last = (off_t)strtoll(ptr + 1, NULL, 10);
+
+    status = HTTP_STATUS_PARTIAL_CONTENT;
+  }
+
+  server->last_start = first;
+
+  httpClearFields(http);
+  httpSetField(http, HTTP_FIELD_CONTENT_TYPE, "application/octet-stream");
+  httpSetField(http, HTTP_FIELD_ETAG, "\"testhttp\"");
+
+  if (first >= (off_t)server->datalen)
+  {
+    snprintf(value, sizeof(value), "bytes */%u", (unsigned)server->datalen);
+    httpSetField(http, HTTP_FIELD_CONTENT_RANGE, value);
+    httpSetLength(http, 0);
+    httpWriteResponse(http, HTTP_STATUS_RANGE_NOT_SATISFIABLE);
+
+    return (false);
+  }
+
+  if (status == HTTP_STATUS_PARTIAL_CONTENT)
+  {
+    snprintf(value, sizeof(value), "bytes %ld-%ld/%u", (long)first, (long)last, (unsigned)server->datalen);
+    httpSetField(http, HTTP_FIELD_CONTENT_RANGE, value);
+  }
+
+  httpSetLength(http, (size_t)(last - first + 1));
+
+  if (!httpWriteResponse(http, status) || httpWrite(http, server->data + first, (size_t)(last - first + 1)) < 0)
+    return (false);
+
+  httpFlushWrite(http);
+
+  return (true);
+}
+
+
+//
+// 'server_ipp()' - Answer an IPP request for the test server.
+//
+// Get-Jobs requests return "num_jobs" jobs, honoring "first-index" and "limit",
+// and fail with a "status-message" for printers named "bad".  Other requests
+// return their "job-id" or request ID in a job group.
+//
+
+static ipp_t *				// O - IPP response
+server_ipp(test_server_t *server,	// I - Test server
+           ipp_t         *request)	// I - IPP request
+{
+  ipp_t		*response;		// IPP response
+  ipp_attribute_t *attr;		// Request attribute
+  const char	*uri;			// printer-uri value
+  int		i,			// Looping var
+		first,			// First job
+		last;			// Last job
+
+
+  response = ippNewResponse(request);
+
+  if (ippGetOperation(request) == IPP_OP_GET_JOBS)
+  {
+    if ((uri = ippGetString(ippFindAttribute(request, "printer-uri", IPP_TAG_URI), 0, NULL)) != NULL && strstr(uri, "/printers/bad"))
+    {
+      ippSetStatusCode(response, IPP_STATUS_ERROR_NOT_FOUND);
+      ippAddString(response, IPP_TAG_OPERATION, IPP_TAG_TEXT, "status-message", NULL, "No such printer.");
+      return (response);
+    }
+
+    if ((attr = ippFindAttribute(request, "first-index", IPP_TAG_INTEGER)) != NULL)
+      first = ippGetInteger(attr, 0);
+    else
+      first = 1;
+
+    if ((attr = ippFindAttribute(request, "limit", IPP_TAG_INTEGER)) != NULL)
+      last = first + ippGetInteger(attr, 0) - 1;
+    else
+      last = server->num_jobs;
+
+    if (last > server->num_jobs)
+      last = server->num_jobs;
+
+    for (i = first; i <= last; i ++)
+    {
+      if (i > first)
+        ippAddSeparator(response);
+
+      ippAddInteger(response, IPP_TAG_JOB, IPP_TAG_INTEGER, "job-id", i);
+      ippAddString(response, IPP_TAG_JOB, IPP_TAG_NAME, "job-name", NULL, "testhttp");
+      ippAddString(response, IPP_TAG_JOB, IPP_TAG_URI, "job-printer-uri", NULL, "ipp://localhost/printers/test");
+      ippAddInteger(response, IPP_TAG_JOB, IPP_TAG_ENUM, "job-state", IPP_JSTATE_PENDING);
+    }
+  }
+  else if ((attr = ippFindAttribute(request, "job-id", IPP_TAG_INTEGER)) != NULL)
+  {
+    ippAddInteger(response, IPP_TAG_JOB, IPP_TAG_INTEGER, "job-id", ippGetInteger(attr, 0));
+  }
+  else
+  {
+    ippAddInteger(response, IPP_TAG_JOB, IPP_TAG_INTEGER, "job-id", ippGetRequestId(request));
+  }
+
+  return (response);
+}
+
+
+//
+// 'server_run_cb()' - Accept connections for the test server.
+//
+
+static void *				// O - Thread exit status
+server_run_cb(test_server_t *server)	// I - Test server
+{
+  struct pollfd	pfd;			// Poll data
+  test_client_t	*client;		// Client connection
+  http_t	*http;			// HTTP connection
+
+
+  pfd.fd     = server->fd;
+  pfd.events = POLLIN;
+
+  while (!server->stop)
+  {
+    if (poll(&pfd, 1, 100) <= 0 || !(pfd.revents & POLLIN))
+      continue;
+
+    if ((http = httpAcceptConnection(server->fd, true)) == NULL)
+      continue;
+
+    if ((client = (test_client_t *)calloc(1, sizeof(test_client_t))) == NULL)
+    {
+      httpClose(http);
+      continue;
+    }
+
+    client->server = server;
+    client->http   = http;
+
+    cupsThreadPoolAdd(server->pool, (cups_thread_func_t)server_client_cb, client);
+  }
+
+  return (NULL);
+}
+
+
+//
+// 'server_start()' - Start a test server.
+//
+
+static bool				// O - `true` on success, `false` on error
+server_start(test_server_t *server,	// I - Test server
+             http_addr_t   *addr)	// I - Listen address
+{
+  http_addr_t	laddr;			// Listen address
+  socklen_t	laddrlen = sizeof(laddr);
+					// Length of listen address
+
+
+  server->stop         = false;
+  server->num_requests = 0;
+
+  if ((server->fd = httpAddrListen(addr, 0)) < 0)
+    return (false);
+
+  if (getsockname(server->fd, (struct sockaddr *)&laddr, &laddrlen))
+  {
+    httpAddrClose(NULL, server->fd);
+    return (false);
+  }
+
+  server->port = httpAddrGetPort(&laddr);
+
+  if ((server->pool = cupsThreadPoolNew(32, 0)) == NULL)
+  {
+    httpAddrClose(NULL, server->fd);
+    return (false);
+  }
+
+  if ((server->thread = cupsThreadCreate((cups_thread_func_t)server_run_cb, server)) == CUPS_THREAD_INVALID)
+  {
+    cupsThreadPoolDelete(server->pool);
+    httpAddrClose(NULL, server->fd);
+    return (false);
+  }
+
+  return (true);
+}
+
+
+//
+// 'server_stop()' - Stop a test server.
+//
+
+static void
+server_stop(test_server_t *server)	// I - Test server
+{
+  server->stop = true;
+
+  cupsThreadWait(server->thread);
+  cupsThreadPoolDelete(server->pool);
+
+  httpAddrClose(NULL, server->fd);
+}
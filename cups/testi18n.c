@@ -16,6 +16,8 @@
 #include <stdlib.h>
 #include <time.h>
 #include <unistd.h>
+#include <errno.h>
+#include <sys/stat.h>
 
 
 //
@@ -135,6 +137,8 @@ main(int  argc,				// I - Argument Count
     // "A != <CJK U+4E42>." - use Windows 950 (Big5) or EUC-TW
   char		utf8dest[1024];		// UTF-8 destination string
   cups_utf32_t	utf32dest[1024];	// UTF-32 destination string
+  cups_lang_t	*lang,			// Language data
+		*catlang;		// Language data from compiled catalog
 
 
   if (argc > 1)
@@ -497,6 +501,72 @@ main(int  argc,				// I - Argument Count
   else
     testEnd(true);
 
+  // cupsLangLoadStrings with comments
+  testBegin("cupsLangLoadStrings(comments)");
+
+  lang = cupsLangFind("de");
+
+  if (!lang || !cupsLangLoadStrings(lang, NULL, "/* First comment */\n\"testi18n-a\" = \"A\";\n/* Second\ncomment */\"testi18n-b\" = \"B\";\n"))
+  {
+    testEndMessage(false, "%s", cupsGetErrorString());
+    errors ++;
+  }
+  else if (strcmp(cupsLangGetString(lang, "testi18n-a"), "A") || strcmp(cupsLangGetString(lang, "testi18n-b"), "B"))
+  {
+    testEndMessage(false, "got \"%s\" and \"%s\", expected \"A\" and \"B\"", cupsLangGetString(lang, "testi18n-a"), cupsLangGetString(lang, "testi18n-b"));
+    errors ++;
+  }
+  else
+    testEnd(true);
+
+  // cupsLangSaveCatalog/cupsLangLoadStrings
+  testBegin("cupsLangSaveCatalog(de)");
+
+  if (mkdir("testi18n.d", 0777) && errno != EEXIST)
+  {
+    testEndMessage(false, "testi18n.d: %s", strerror(errno));
+    errors ++;
+  }
+  else if (!lang || !cupsLangSaveCatalog(lang, "testi18n.d/qq.catalog"))
+  {
+    testEndMessage(false, "%s", cupsGetErrorString());
+    errors ++;
+  }
+  else
+  {
+    testEnd(true);
+
+    testBegin("cupsLangFind(qq) with compiled catalog");
+    cupsLangSetDirectory("testi18n.d");
+
+    if ((catlang = cupsLangFind("qq")) == NULL)
+    {
+      testEndMessage(false, "%s", cupsGetErrorString());
+      errors ++;
+    }
+    else if (strcmp(cupsLangGetString(catlang, "Unknown"), "Unbekannt"))
+    {
+      testEndMessage(false, "got \"%s\" for \"Unknown\", expected \"Unbekannt\"", cupsLangGetString(catlang, "Unknown"));
+      errors ++;
+    }
+    else if (strcmp(cupsLangGetString(catlang, "Not a message"), "Not a message"))
+    {
+      testEndMessage(false, "got \"%s\" for \"Not a message\"", cupsLangGetString(catlang, "Not a message"));
+      errors ++;
+    }
+    else if (cupsLangLoadStrings(catlang, "testi18n.d/qq.catalog", NULL))
+    {
+      testEndMessage(false, "loaded a second compiled catalog");
+      errors ++;
+    }
+    else
+      testEnd(true);
+
+    unlink("testi18n.d/qq.catalog");
+  }
+
+  rmdir("testi18n.d");
+
   return (errors > 0);
 }
 
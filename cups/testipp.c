@@ -29,10 +29,19 @@ typedef struct _ippdata_t
 {
   size_t	rpos,			// Read position
 		wused,			// Bytes used
-		wsize;			// Max size of buffer
+		wsize,			// Max size of buffer
+		wcalls;			// Number of write callbacks
   ipp_uchar_t	*wbuffer;		// Buffer
 } _ippdata_t;
 
+typedef struct _ippstream_s		// ippReadIOStream counts
+{
+  size_t	groups,			// Number of group tags
+		attrs,			// Number of attributes
+		collections,		// Number of collection attributes
+		max_attrs;		// Stop after this many attributes
+} _ippstream_t;
+
 
 //
 // Local globals...
@@ -287,6 +296,7 @@ static ipp_uchar_t mixed[] =		// Mixed value buffer
 void	print_attributes(ipp_t *ipp, int indent);
 ssize_t	read_cb(_ippdata_t *data, ipp_uchar_t *buffer, size_t bytes);
 ssize_t	read_hex(cups_file_t *fp, ipp_uchar_t *buffer, size_t bytes);
+bool	stream_cb(_ippstream_t *counts, ipp_tag_t group, ipp_attribute_t *attr);
 bool	token_cb(ipp_file_t *f, void *user_data, const char *token);
 ssize_t	write_cb(_ippdata_t *data, ipp_uchar_t *buffer, size_t bytes);
 
@@ -300,6 +310,8 @@ main(int  argc,			// I - Number of command-line arguments
      char *argv[])		// I - Command-line arguments
 {
   _ippdata_t	data;		// IPP buffer
+  _ippstream_t	counts;		// IPP stream counts
+  void		*wdata;		// ippWriteBuffer data
   ipp_uchar_t	buffer[8192];	// Write buffer data
   ipp_t		*cols[2],	// Collections
 		*size;		// media-size collection
@@ -308,6 +320,8 @@ main(int  argc,			// I - Number of command-line arguments
 		*media_size,	// media-size attribute
 		*attr;		// Other attribute
   ipp_state_t	state;		// State
+  ipp_path_t	*path;		// Compiled attribute path
+  cups_array_t	*ras[2];	// Requested attributes arrays
   size_t	length;		// Length of data
   cups_file_t	*fp;		// File pointer
   size_t	i;		// Looping var
@@ -379,6 +393,7 @@ main(int  argc,			// I - Number of command-line arguments
 
     data.wused   = 0;
     data.wsize   = sizeof(buffer);
+    data.wcalls  = 0;
     data.wbuffer = buffer;
 
     while ((state = ippWriteIO(&data, (ipp_io_cb_t)write_cb, 1, NULL,
@@ -417,6 +432,15 @@ main(int  argc,			// I - Number of command-line arguments
     else
       testEnd(true);
 
+    testBegin("ippWriteIO(batched)");
+    if (data.wcalls != 1)
+    {
+      testEndMessage(false, "%u write callbacks", (unsigned)data.wcalls);
+      status = 1;
+    }
+    else
+      testEnd(true);
+
     ippDelete(request);
 
     // Read the data back in and confirm...
@@ -640,232 +664,1254 @@ main(int  argc,			// I - Number of command-line arguments
     else
       testEnd(true);
 
-    ippDelete(request);
-
-    // Read the bad collection data and confirm we get an error...
-    testBegin("Read Bad Collection from Memory");
-
-    request = ippNew();
-    data.rpos    = 0;
-    data.wused   = sizeof(bad_collection);
-    data.wsize   = sizeof(bad_collection);
-    data.wbuffer = bad_collection;
-
-    while ((state = ippReadIO(&data, (ipp_io_cb_t)read_cb, 1, NULL, request)) != IPP_STATE_DATA)
-      if (state == IPP_STATE_ERROR)
-	break;
+    testBegin("ippFindPath(media-col/media-size/x-dimension)");
+    if ((path = ippCompilePath("media-col/media-size/x-dimension")) == NULL)
+    {
+      testEndMessage(false, "unable to compile path");
+      status = 1;
+    }
+    else
+    {
+      if ((attr = ippFindPath(request, path, IPP_TAG_INTEGER)) == NULL)
+      {
+        testEndMessage(false, "not found");
+        status = 1;
+      }
+      else if (ippGetInteger(attr, 0) != 21590)
+      {
+        testEndMessage(false, "wrong value for x-dimension - %d", ippGetInteger(attr, 0));
+        status = 1;
+      }
+      else if (ippFindPath(request, path, IPP_TAG_KEYWORD))
+      {
+        testEndMessage(false, "found keyword x-dimension");
+        status = 1;
+      }
+      else
+        testEnd(true);
 
-    ippDelete(request);
+      ippDeletePath(path);
+    }
 
-    if (state != IPP_STATE_ERROR)
-      testEndMessage(false, "read successful");
+    testBegin("ippCompilePath(bad paths)");
+    if ((path = ippCompilePath("media-col//x-dimension")) != NULL || (path = ippCompilePath("media-col/")) != NULL || (path = ippCompilePath("")) != NULL)
+    {
+      testEndMessage(false, "compiled bad path");
+      ippDeletePath(path);
+      status = 1;
+    }
+    else if ((path = ippCompilePath("media-col/media-size/x-dimension/bogus")) == NULL || ippFindPath(request, path, IPP_TAG_ZERO))
+    {
+      testEndMessage(false, "bad lookup of deep path");
+      status = 1;
+    }
     else
       testEnd(true);
 
-    // Read the mixed data and confirm we converted everything to rangeOfInteger
-    // values...
-    testBegin("Read Mixed integer/rangeOfInteger from Memory");
+    ippDeletePath(path);
+    ippDelete(request);
 
-    request = ippNew();
-    data.rpos    = 0;
-    data.wused   = sizeof(mixed);
-    data.wsize   = sizeof(mixed);
-    data.wbuffer = mixed;
+    // Read the data back into an arena message and confirm...
+    testBegin("Read Sample into Arena from Memory");
 
-    while ((state = ippReadIO(&data, (ipp_io_cb_t)read_cb, 1, NULL,
-                              request)) != IPP_STATE_DATA)
+    request   = ippNewArena();
+    data.rpos = 0;
+
+    while ((state = ippReadIO(&data, (ipp_io_cb_t)read_cb, 1, NULL, request)) != IPP_STATE_DATA)
+    {
       if (state == IPP_STATE_ERROR)
 	break;
-
-    length = ippGetLength(request);
+    }
 
     if (state != IPP_STATE_DATA)
     {
       testEndMessage(false, "%d bytes read", (int)data.rpos);
       status = 1;
     }
-    else if (data.rpos != sizeof(mixed))
+    else if ((length = ippGetLength(request)) != sizeof(collection))
     {
-      testEndMessage(false, "read %d bytes, expected %d bytes", (int)data.rpos,
-             (int)sizeof(mixed));
+      testEndMessage(false, "wrong ippLength(), %d instead of %d bytes", (int)length, (int)sizeof(collection));
       print_attributes(request, 8);
       status = 1;
     }
-    else if (length != (sizeof(mixed) + 4))
+    else if ((attr = ippFindAttribute(request, "media-col/media-size/x-dimension", IPP_TAG_INTEGER)) == NULL || ippGetInteger(attr, 0) != 21590)
     {
-      testEndMessage(false, "wrong ippLength(), %d instead of %d bytes",
-             (int)length, (int)sizeof(mixed) + 4);
-      print_attributes(request, 8);
+      testEndMessage(false, "media-col/media-size/x-dimension not found or wrong value");
       status = 1;
     }
     else
       testEnd(true);
 
-    testBegin("ippFindAttribute(notify-lease-duration-supported)");
-    if ((attr = ippFindAttribute(request, "notify-lease-duration-supported",
-                                 IPP_TAG_ZERO)) == NULL)
-    {
-      testEndMessage(false, "not found");
-      status = 1;
-    }
-    else if (attr->value_tag != IPP_TAG_RANGE)
+    testBegin("ippSetString(arena)");
+    attr = ippAddString(request, IPP_TAG_JOB, IPP_TAG_KEYWORD, "job-sheets", NULL, "none");
+    for (i = 1; i < 2 * IPP_MAX_VALUES; i ++)
+      ippSetStringf(request, &attr, i, "value-%u", (unsigned)i);
+
+    if (ippGetCount(attr) != 2 * IPP_MAX_VALUES || strcmp(ippGetString(attr, 0, NULL), "none") || strcmp(ippGetString(attr, 2 * IPP_MAX_VALUES - 1, NULL), "value-15") || ippFindAttribute(request, "job-sheets", IPP_TAG_KEYWORD) != attr)
     {
-      testEndMessage(false, "wrong type - %s", ippTagString(attr->value_tag));
+      testEndMessage(false, "got %u values", (unsigned)ippGetCount(attr));
       status = 1;
     }
-    else if (attr->num_values != 2)
+    else
+      testEnd(true);
+
+    testBegin("ippCopyAttributes(arena)");
+    cols[0] = ippNew();
+    ippCopyAttributes(cols[0], request, false, NULL, NULL);
+    ippDelete(request);
+
+    if ((attr = ippFindAttribute(cols[0], "media-col/media-size/y-dimension", IPP_TAG_INTEGER)) == NULL || ippGetInteger(attr, 0) != 27940)
     {
-      testEndMessage(false, "wrong count - %d", attr->num_values);
+      testEndMessage(false, "media-col/media-size/y-dimension not found or wrong value");
       status = 1;
     }
-    else if (attr->values[0].range.lower != 1 ||
-             attr->values[0].range.upper != 1 ||
-             attr->values[1].range.lower != 16 ||
-             attr->values[1].range.upper != 32)
+    else if ((attr = ippFindAttribute(cols[0], "job-sheets", IPP_TAG_KEYWORD)) == NULL || strcmp(ippGetString(attr, 1, NULL), "value-1"))
     {
-      testEndMessage(false, "wrong values - %d,%d and %d,%d",
-             attr->values[0].range.lower,
-             attr->values[0].range.upper,
-             attr->values[1].range.lower,
-             attr->values[1].range.upper);
+      testEndMessage(false, "job-sheets not found or wrong value");
       status = 1;
     }
     else
       testEnd(true);
 
-    ippDelete(request);
+    ippDelete(cols[0]);
 
-#ifdef DEBUG
-    // Test that private option array is sorted...
-    testBegin("_ippCheckOptions");
-    if ((name = _ippCheckOptions()) == NULL)
+    // Read the sample using ippReadBuffer...
+    testBegin("ippReadBuffer");
+    request = ippNew();
+
+    if ((state = ippReadBuffer(collection, sizeof(collection), request)) != IPP_STATE_DATA)
     {
-      testEnd(true);
+      testEndMessage(false, "state %d", (int)state);
+      status = 1;
     }
-    else
+    else if ((length = ippGetLength(request)) != sizeof(collection))
     {
-      testEndMessage(false, "\"%s\" out of order", name);
+      testEndMessage(false, "wrong ippLength(), %d instead of %d bytes", (int)length, (int)sizeof(collection));
       status = 1;
     }
-#endif // DEBUG
-
-    // Test _ippFindOption() private API...
-    testBegin("_ippFindOption(\"printer-type\")");
-    if (_ippFindOption("printer-type"))
-      testEnd(true);
     else
+      testEnd(true);
+
+    testBegin("ippWriteBuffer");
+    if (!ippWriteBuffer(request, &wdata, &length))
     {
-      testEnd(false);
+      testEndMessage(false, "%s", cupsGetErrorString());
       status = 1;
     }
-  }
-  else
-  {
-    // Read IPP files...
-    for (i = 1; i < (size_t)argc; i ++)
+    else if (length != sizeof(collection) || memcmp(wdata, collection, length))
     {
-      if (strlen(argv[i]) > 5 && !strcmp(argv[i] + strlen(argv[i]) - 5, ".test"))
-      {
-        // Read an ASCII IPP message...
-        ipp_file_t *file;		// IPP data file
-
-        file    = ippFileNew(NULL, NULL, NULL, NULL);
-        request = ippNew();
-
-        ippFileOpen(file, argv[i], "r");
-        ippFileRead(file, token_cb, true);
-        ippFileDelete(file);
-      }
-      else if (strlen(argv[i]) > 4 && !strcmp(argv[i] + strlen(argv[i]) - 4, ".hex"))
-      {
-        // Read a hex-encoded IPP message...
-	if ((fp = cupsFileOpen(argv[i], "r")) == NULL)
-	{
-	  printf("Unable to open \"%s\" - %s\n", argv[i], strerror(errno));
-	  status = 1;
-	  continue;
-	}
+      testEndMessage(false, "output does not match baseline");
+      testHexDump(wdata, length);
+      status = 1;
+    }
+    else
+      testEnd(true);
 
-	request = ippNew();
-	while ((state = ippReadIO(fp, (ipp_io_cb_t)read_hex, 1, NULL, request)) == IPP_STATE_ATTRIBUTE);
+    free(wdata);
 
-	if (state != IPP_STATE_DATA)
-	{
-	  printf("Error reading IPP message from \"%s\": %s\n", argv[i], cupsGetErrorString());
-	  status = 1;
+    // Freeze the message and confirm it can't be changed...
+    testBegin("ippFreeze");
+    attr = ippFindAttribute(request, "printer-uri", IPP_TAG_URI);
 
-	  ippDelete(request);
-	  request = NULL;
-	}
+    if (!ippFreeze(request))
+    {
+      testEndMessage(false, "unable to freeze message");
+      status = 1;
+    }
+    else if (ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_NAME, "requesting-user-name", NULL, "john-doe"))
+    {
+      testEndMessage(false, "ippAddString succeeded");
+      status = 1;
+    }
+    else if (ippSetString(request, &attr, 0, "ipp://localhost/printers/bar") || strcmp(ippGetString(attr, 0, NULL), "ipp://localhost/printers/foo"))
+    {
+      testEndMessage(false, "ippSetString succeeded");
+      status = 1;
+    }
+    else if ((attr = ippFindAttribute(request, "media-col/media-size", IPP_TAG_BEGIN_COLLECTION)) == NULL || ippSetInteger(ippGetCollection(attr, 0), &attr, 0, 1))
+    {
+      testEndMessage(false, "ippSetInteger succeeded in collection");
+      status = 1;
+    }
+    else
+    {
+      attr = ippFindAttribute(request, "printer-uri", IPP_TAG_URI);
+      ippDeleteAttribute(request, attr);
 
-        cupsFileClose(fp);
+      if (ippFindAttribute(request, "printer-uri", IPP_TAG_URI) != attr)
+      {
+        testEndMessage(false, "ippDeleteAttribute succeeded");
+        status = 1;
       }
       else
-      {
-        // Read a raw (binary) IPP message...
-	if ((fp = cupsFileOpen(argv[i], "r")) == NULL)
-	{
-	  printf("Unable to open \"%s\" - %s\n", argv[i], strerror(errno));
-	  status = 1;
-	  continue;
-	}
+        testEnd(true);
+    }
 
-	request = ippNew();
-	while ((state = ippReadIO(fp, (ipp_io_cb_t)cupsFileRead, 1, NULL,
-				  request)) == IPP_STATE_ATTRIBUTE);
+    testBegin("ippWriteBuffer(frozen)");
+    if (!ippWriteBuffer(request, &wdata, &length))
+    {
+      testEndMessage(false, "%s", cupsGetErrorString());
+      status = 1;
+    }
+    else if (length != sizeof(collection) || memcmp(wdata, collection, length))
+    {
+      testEndMessage(false, "output does not match baseline");
+      testHexDump(wdata, length);
+      status = 1;
+    }
+    else
+      testEnd(true);
 
-	if (state != IPP_STATE_DATA)
-	{
-	  printf("Error reading IPP message from \"%s\": %s\n", argv[i], cupsGetErrorString());
-	  status = 1;
+    free(wdata);
 
-	  ippDelete(request);
-	  request = NULL;
-	}
+    // Quick copies share the encoding until they are changed...
+    testBegin("ippCopyAttributes(frozen)");
+    cols[0] = ippNew();
+    ippSetRequestId(cols[0], 1);
+    ippSetOperation(cols[0], IPP_OP_PRINT_JOB);
+    ippSetVersion(cols[0], 1, 1);
+    ippCopyAttributes(cols[0], request, true, NULL, NULL);
 
-        cupsFileClose(fp);
-      }
+    if (!ippWriteBuffer(cols[0], &wdata, &length) || length != sizeof(collection) || memcmp(wdata, collection, length))
+    {
+      testEndMessage(false, "output does not match baseline");
+      status = 1;
+    }
+    else
+    {
+      free(wdata);
 
-      if (request)
+      attr = ippFindAttribute(cols[0], "printer-uri", IPP_TAG_URI);
+      ippSetString(cols[0], &attr, 0, "ipp://localhost/printers/bar");
+
+      if (!ippWriteBuffer(cols[0], &wdata, &length) || length != sizeof(collection) || !memcmp(wdata, collection, length))
       {
-	printf("\n%s:\n", argv[i]);
-	print_attributes(request, 4);
-	ippDelete(request);
+        testEndMessage(false, "changed value not written");
+        status = 1;
       }
+      else
+        testEnd(true);
     }
-  }
 
-  return (status);
-}
-
-
-//
-// 'print_attributes()' - Print the attributes in a request...
-//
-
-void
-print_attributes(ipp_t *ipp,		// I - IPP request
-                 int   indent)		// I - Indentation
-{
-  ipp_tag_t		group;		// Current group
-  ipp_attribute_t	*attr;		// Current attribute
-  char                  buffer[2048];   // Value string
+    free(wdata);
+    ippDelete(cols[0]);
 
+    // Full copies share frozen collections...
+    testBegin("ippCopyAttribute(frozen collection)");
+    cols[0] = ippNew();
+    attr    = ippFindAttribute(request, "media-col", IPP_TAG_BEGIN_COLLECTION);
 
-  for (group = IPP_TAG_ZERO, attr = ipp->attrs; attr; attr = attr->next)
-  {
-    if (!attr->name && indent == 4)
+    if ((attr = ippCopyAttribute(cols[0], attr, false)) == NULL)
     {
-      group = IPP_TAG_ZERO;
-      putchar('\n');
-      continue;
+      testEndMessage(false, "unable to copy media-col");
+      status = 1;
     }
-
-    if (group != attr->group_tag)
+    else if (ippGetCollection(attr, 0) != ippGetCollection(ippFindAttribute(request, "media-col", IPP_TAG_BEGIN_COLLECTION), 0))
     {
-      group = attr->group_tag;
-
-      testError("\n%*s%s:\n", indent - 4, "", ippTagString(group));
+      testEndMessage(false, "media-col collection was copied");
+      status = 1;
+    }
+    else
+    {
+      ippDelete(request);
+      request = NULL;
+
+      if ((attr = ippFindAttribute(cols[0], "media-col/media-size/x-dimension", IPP_TAG_INTEGER)) == NULL || ippGetInteger(attr, 0) != 21590)
+      {
+        testEndMessage(false, "media-col/media-size/x-dimension not found or wrong value");
+        status = 1;
+      }
+      else
+        testEnd(true);
+    }
+
+    ippDelete(cols[0]);
+    ippDelete(request);
+
+    testBegin("ippReadBuffer(truncated)");
+    request = ippNew();
+
+    if ((state = ippReadBuffer(collection, sizeof(collection) / 2, request)) != IPP_STATE_ERROR)
+    {
+      testEndMessage(false, "state %d", (int)state);
+      status = 1;
+    }
+    else
+      testEnd(true);
+
+    ippDelete(request);
+
+    // Confirm that octetString values in arena messages reference the buffer...
+    testBegin("ippReadBuffer(arena)");
+    request = ippNew();
+    ippAddOctetString(request, IPP_TAG_OPERATION, "job-password", "password", 8);
+
+    data.wused   = 0;
+    data.wsize   = sizeof(buffer);
+    data.wbuffer = buffer;
+
+    while ((state = ippWriteIO(&data, (ipp_io_cb_t)write_cb, 1, NULL, request)) != IPP_STATE_DATA)
+    {
+      if (state == IPP_STATE_ERROR)
+	break;
+    }
+
+    ippDelete(request);
+    request = ippNewArena();
+
+    if (state != IPP_STATE_DATA || (state = ippReadBuffer(buffer, data.wused, request)) != IPP_STATE_DATA)
+    {
+      testEndMessage(false, "state %d", (int)state);
+      status = 1;
+    }
+    else if ((attr = ippFindAttribute(request, "job-password", IPP_TAG_STRING)) == NULL)
+    {
+      testEndMessage(false, "job-password not found");
+      status = 1;
+    }
+    else
+    {
+      ipp_uchar_t *octets = (ipp_uchar_t *)ippGetOctetString(attr, 0, &length);
+					// octetString value
+
+      if (length != 8 || !octets || memcmp(octets, "password", 8))
+      {
+        testEndMessage(false, "wrong job-password value");
+        status = 1;
+      }
+      else if (octets < buffer || octets >= (buffer + data.wused))
+      {
+        testEndMessage(false, "job-password value was copied");
+        status = 1;
+      }
+      else
+        testEnd(true);
+    }
+
+    ippDelete(request);
+
+    // Stream the sample to a callback...
+    testBegin("ippReadIOStream");
+    request = ippNew();
+    memset(&counts, 0, sizeof(counts));
+    data.rpos    = 0;
+    data.wused   = sizeof(collection);
+    data.wsize   = sizeof(collection);
+    data.wbuffer = collection;
+
+    if ((state = ippReadIOStream(&data, (ipp_io_cb_t)read_cb, true, request, (ipp_stream_cb_t)stream_cb, &counts)) != IPP_STATE_DATA)
+    {
+      testEndMessage(false, "state %d", (int)state);
+      status = 1;
+    }
+    else if (counts.groups != 2 || counts.attrs != 4 || counts.collections != 1)
+    {
+      testEndMessage(false, "got %u groups, %u attributes, %u collections", (unsigned)counts.groups, (unsigned)counts.attrs, (unsigned)counts.collections);
+      status = 1;
+    }
+    else if (ippGetFirstAttribute(request) || ippGetRequestId(request) != 1)
+    {
+      testEndMessage(false, "attributes left in message or wrong request-id");
+      status = 1;
+    }
+    else
+      testEnd(true);
+
+    ippDelete(request);
+
+    testBegin("ippReadIOStream(stop)");
+    request = ippNew();
+    memset(&counts, 0, sizeof(counts));
+    counts.max_attrs = 2;
+    data.rpos        = 0;
+
+    if ((state = ippReadIOStream(&data, (ipp_io_cb_t)read_cb, true, request, (ipp_stream_cb_t)stream_cb, &counts)) != IPP_STATE_ERROR)
+    {
+      testEndMessage(false, "state %d", (int)state);
+      status = 1;
+    }
+    else if (counts.attrs != 2 || ippGetFirstAttribute(request))
+    {
+      testEndMessage(false, "got %u attributes", (unsigned)counts.attrs);
+      status = 1;
+    }
+    else
+      testEnd(true);
+
+    ippDelete(request);
+
+    // Confirm that names and values round-trip...
+    testBegin("ippOpString/ippOpValue");
+    for (i = 0; i < 0x4030; i ++)
+    {
+      const char *name = ippOpString((ipp_op_t)i);
+					// Operation name
+
+      if (strncmp(name, "0x", 2) && ippOpValue(name) != (ipp_op_t)i)
+        break;
+
+      if (i == 0x80)
+        i = 0x4000;
+    }
+
+    if (i < 0x4030)
+      testEndMessage(false, "'%s' is not 0x%04x", ippOpString((ipp_op_t)i), (unsigned)i);
+    else if (ippOpValue("get-printer-attributes") != IPP_OP_GET_PRINTER_ATTRIBUTES || ippOpValue("CUPS-Add-Class") != IPP_OP_CUPS_ADD_MODIFY_CLASS || ippOpValue("Windows-Ext") != IPP_OP_PRIVATE || ippOpValue("bogus") != IPP_OP_CUPS_INVALID)
+      testEndMessage(false, "bad lookup of alias or unknown name");
+    else
+      testEnd(true);
+
+    if (i < 0x4030)
+      status = 1;
+
+    testBegin("ippTagString/ippTagValue");
+    for (i = 0; i < IPP_TAG_EXTENSION; i ++)
+    {
+      const char *name = ippTagString((ipp_tag_t)i);
+					// Tag name
+
+      if (strcmp(name, "UNKNOWN") && strncmp(name, "0x", 2) && ippTagValue(name) != (ipp_tag_t)i)
+        break;
+    }
+
+    if (i < IPP_TAG_EXTENSION)
+    {
+      testEndMessage(false, "'%s' is not 0x%02x", ippTagString((ipp_tag_t)i), (unsigned)i);
+      status = 1;
+    }
+    else if (ippTagValue("Keyword") != IPP_TAG_KEYWORD || ippTagValue("printer") != IPP_TAG_PRINTER || ippTagValue("bogus") != IPP_TAG_ZERO)
+    {
+      testEndMessage(false, "bad lookup of alias or unknown name");
+      status = 1;
+    }
+    else
+      testEnd(true);
+
+    testBegin("ippErrorString/ippErrorValue");
+    for (i = 0; i < 0x1010; i ++)
+    {
+      const char *name = ippErrorString((ipp_status_t)i);
+					// Status name
+
+      if (strncmp(name, "0x", 2) && ippErrorValue(name) != (ipp_status_t)i)
+        break;
+    }
+
+    if (i < 0x1010)
+    {
+      testEndMessage(false, "'%s' is not 0x%04x", ippErrorString((ipp_status_t)i), (unsigned)i);
+      status = 1;
+    }
+    else if (ippErrorValue("CLIENT-ERROR-NOT-FOUND") != IPP_STATUS_ERROR_NOT_FOUND || ippErrorValue("cups-see-other") != IPP_STATUS_CUPS_SEE_OTHER || ippErrorValue("bogus") != (ipp_status_t)-1)
+    {
+      testEndMessage(false, "bad lookup of alias or unknown name");
+      status = 1;
+    }
+    else
+      testEnd(true);
+
+    testBegin("ippEnumString/ippEnumValue");
+    for (i = 3; i < 0x40000100; i ++)
+    {
+      const char *name = ippEnumString("finishings", (int)i);
+					// Enum name
+
+      if (ippEnumValue("finishings", name) != (int)i || ippEnumValue("job-finishings", name) != (int)i)
+        break;
+
+      if (i == 0x100)
+        i = 0x3fffffff;
+    }
+
+    if (i < 0x40000100)
+    {
+      testEndMessage(false, "'%s' is not %d", ippEnumString("finishings", (int)i), (int)i);
+      status = 1;
+    }
+    else if (ippEnumValue("printer-state", "stopped") != IPP_PSTATE_STOPPED || strcmp(ippEnumString("job-state", IPP_JSTATE_ABORTED), "aborted") || ippEnumValue("operations-supported", "Get-Jobs") != IPP_OP_GET_JOBS || ippEnumValue("finishings", "bogus") != -1 || ippEnumValue("bogus", "none") != -1)
+    {
+      testEndMessage(false, "bad lookup of enum value");
+      status = 1;
+    }
+    else
+      testEnd(true);
+
+    // Confirm that values are formatted and escaped correctly...
+    testBegin("ippAttributeString");
+    request = ippNew();
+    ippAddRange(request, IPP_TAG_JOB, "page-ranges", -5, 2147483647);
+    ippAddResolution(request, IPP_TAG_JOB, "printer-resolution", IPP_RES_PER_CM, 300, 600);
+    ippAddString(request, IPP_TAG_JOB, IPP_TAG_TEXTLANG, "job-name", "fr-CA", "a \"b\" [c]");
+    ippAddOctetString(request, IPP_TAG_JOB, "job-password", "a b\\\001", 5);
+    cols[0] = ippNew();
+    ippAddInteger(cols[0], IPP_TAG_ZERO, IPP_TAG_INTEGER, "x-dimension", 21590);
+    ippAddBoolean(cols[0], IPP_TAG_ZERO, "y-bogus", false);
+    ippAddCollection(request, IPP_TAG_JOB, "media-size", cols[0]);
+    ippDelete(cols[0]);
+
+    for (attr = ippGetFirstAttribute(request), i = 0; attr; attr = ippGetNextAttribute(request), i ++)
+    {
+      static const char * const expected[] =
+      {					// Expected strings
+        "-5-2147483647",
+        "300x600dpcm",
+        "a \\\"b\\\" \\[c][fr-ca]",
+        "a\\ b\\\\\\001",
+        "{x-dimension=21590 y-bogus=false}"
+      };
+
+      length = ippAttributeString(attr, (char *)buffer, sizeof(buffer));
+
+      if (strcmp((char *)buffer, expected[i]) || length != strlen(expected[i]) || ippAttributeString(attr, NULL, 0) != length)
+        break;
+
+      if (ippAttributeString(attr, (char *)buffer, 5) != length || strncmp((char *)buffer, expected[i], 4) || buffer[4])
+        break;
+
+      // Exact fit and one byte short, including the "[language]" suffix...
+      buffer[length + 1] = 'X';
+
+      if (ippAttributeString(attr, (char *)buffer, length + 1) != length || strcmp((char *)buffer, expected[i]) || buffer[length + 1] != 'X')
+        break;
+
+      if (ippAttributeString(attr, (char *)buffer, length) != length || strncmp((char *)buffer, expected[i], length - 1) || buffer[length - 1] || buffer[length + 1] != 'X')
+        break;
+    }
+
+    if (attr)
+    {
+      testEndMessage(false, "%s: got '%s'", ippGetName(attr), buffer);
+      status = 1;
+    }
+    else
+      testEnd(true);
+
+    ippDelete(request);
+
+    // Confirm that cached requested-attributes arrays outlive the request...
+    testBegin("ippCreateRequestedArray");
+    for (i = 0; i < 2; i ++)
+    {
+      static const char * const requested[] =
+      {					// requested-attributes values
+        "printer-description",
+        "x-vendor-attribute"
+      };
+
+      request = ippNewRequest(IPP_OP_GET_PRINTER_ATTRIBUTES);
+      ippAddStrings(request, IPP_TAG_OPERATION, IPP_TAG_KEYWORD, "requested-attributes", 2, NULL, requested);
+      ras[i] = ippCreateRequestedArray(request);
+      ippDelete(request);
+    }
+
+    if (!ras[0] || !ras[1] || ras[0] == ras[1] || cupsArrayGetCount(ras[0]) != cupsArrayGetCount(ras[1]))
+    {
+      testEndMessage(false, "got %u and %u names", (unsigned)cupsArrayGetCount(ras[0]), (unsigned)cupsArrayGetCount(ras[1]));
+      status = 1;
+    }
+    else if (!cupsArrayFind(ras[1], "printer-name") || !cupsArrayFind(ras[1], "x-vendor-attribute") || strcmp((char *)cupsArrayFind(ras[0], "x-vendor-attribute"), "x-vendor-attribute"))
+    {
+      testEndMessage(false, "missing names");
+      status = 1;
+    }
+    else
+      testEnd(true);
+
+    cupsArrayDelete(ras[0]);
+    cupsArrayDelete(ras[1]);
+
+    // Confirm that cached arrays are replaced without invalidating copies...
+    testBegin("ippCreateRequestedArray(replaced cache entries)");
+    {
+      static const char * const names[] =
+      {					// Registered attribute names
+        "copies-default",
+        "media-default",
+        "printer-info",
+        "printer-location",
+        "printer-make-and-model",
+        "printer-name",
+        "printer-state",
+        "printer-state-reasons"
+      };
+      const char	*requested[8];	// requested-attributes values
+      size_t		num_requested;	// Number of values
+      unsigned		mask;		// Names to request
+
+      request = ippNewRequest(IPP_OP_GET_PRINTER_ATTRIBUTES);
+      ippAddStrings(request, IPP_TAG_OPERATION, IPP_TAG_KEYWORD, "requested-attributes", 2, NULL, names + 4);
+      ras[0] = ippCreateRequestedArray(request);
+      ippDelete(request);
+
+      for (mask = 1; mask < 256; mask ++)
+      {
+        for (i = 0, num_requested = 0; i < 8; i ++)
+        {
+          if (mask & (1U << i))
+            requested[num_requested ++] = names[i];
+        }
+
+        request = ippNewRequest(IPP_OP_GET_PRINTER_ATTRIBUTES);
+        ippAddStrings(request, IPP_TAG_OPERATION, IPP_TAG_KEYWORD, "requested-attributes", num_requested, NULL, requested);
+        ras[1] = ippCreateRequestedArray(request);
+        ippDelete(request);
+
+        if (!ras[1] || cupsArrayGetCount(ras[1]) != num_requested)
+          break;
+
+        cupsArrayDelete(ras[1]);
+      }
+
+      if (mask < 256)
+      {
+        testEndMessage(false, "got %u names for list %u", (unsigned)cupsArrayGetCount(ras[1]), mask);
+        cupsArrayDelete(ras[1]);
+        status = 1;
+      }
+      else if (!ras[0] || cupsArrayGetCount(ras[0]) != 2 || strcmp((char *)cupsArrayFind(ras[0], "printer-make-and-model"), "printer-make-and-model") || strcmp((char *)cupsArrayFind(ras[0], "printer-name"), "printer-name"))
+      {
+        testEndMessage(false, "first array changed");
+        status = 1;
+      }
+      else
+        testEnd(true);
+
+      cupsArrayDelete(ras[0]);
+    }
+
+    // Expand literal text and variables, including an unterminated ${name}...
+    testBegin("ippFileExpandVars");
+    {
+      ipp_file_t	*file;		// IPP data file
+      char		expanded[256];	// Expanded string
+
+      file = ippFileNew(NULL, NULL, NULL, NULL);
+      ippFileSetVar(file, "name", "value");
+      ippFileSetVar(file, "x-y", "XY");
+
+      if ((length = ippFileExpandVars(file, expanded, "a $name ${x-y}s $$ ${undefined", sizeof(expanded))) != 14 || strcmp(expanded, "a value XYs $ "))
+      {
+        testEndMessage(false, "got %u \"%s\"", (unsigned)length, expanded);
+        status = 1;
+      }
+      else if ((length = ippFileExpandVars(file, expanded, "0123456789012345678901234567890123456789 $name", 32)) != 46 || strcmp(expanded, "0123456789012345678901234567890"))
+      {
+        testEndMessage(false, "got %u \"%s\" for truncated string", (unsigned)length, expanded);
+        status = 1;
+      }
+      else
+        testEnd(true);
+
+      ippFileDelete(file);
+    }
+
+    // Look up variables from the grandparent, parent, and child files...
+    testBegin("ippFileGetVar");
+    {
+      ipp_file_t	*files[3];	// IPP data files
+
+      files[0] = ippFileNew(NULL, NULL, NULL, NULL);
+      files[1] = ippFileNew(files[0], NULL, NULL, NULL);
+      files[2] = ippFileNew(files[1], NULL, NULL, NULL);
+
+      ippFileSetVar(files[0], "a", "grandparent");
+      ippFileSetVar(files[0], "b", "grandparent");
+      ippFileSetVar(files[1], "b", "parent");
+      ippFileSetVar(files[2], "c", "child");
+
+      if (strcmp(ippFileGetVar(files[2], "a"), "grandparent") || strcmp(ippFileGetVar(files[2], "b"), "parent") || strcmp(ippFileGetVar(files[2], "c"), "child") || ippFileGetVar(files[1], "c") || ippFileGetVar(files[2], "d"))
+      {
+        testEndMessage(false, "a=\"%s\", b=\"%s\", c=\"%s\"", ippFileGetVar(files[2], "a"), ippFileGetVar(files[2], "b"), ippFileGetVar(files[2], "c"));
+        status = 1;
+      }
+      else
+        testEnd(true);
+
+      ippFileDelete(files[2]);
+      ippFileDelete(files[1]);
+      ippFileDelete(files[0]);
+    }
+
+    // Write attributes and read them back...
+    testBegin("ippFileWriteAttributes");
+    {
+      ipp_file_t	*file;		// IPP data file
+      ipp_t		*attrs;		// Attributes read from file
+      ipp_attribute_t	*rattr;		// Attribute read from file
+      char		value[1024],	// Written value
+			rvalue[1024];	// Read value
+      bool		values[3] = { true, false, true };
+					// Boolean values
+
+      request = ippNew();
+      cols[0] = ippNew();
+      ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_CHARSET, "attributes-charset", NULL, "utf-8");
+      ippAddString(request, IPP_TAG_PRINTER, IPP_TAG_TEXT, "printer-info", NULL, "A \"quoted\" back\\slash string");
+      ippAddInteger(request, IPP_TAG_PRINTER, IPP_TAG_INTEGER, "x-integer", -2147483647 - 1);
+      ippAddBooleans(request, IPP_TAG_PRINTER, "x-boolean", 3, values);
+      ippAddRange(request, IPP_TAG_PRINTER, "x-range", -5, 100);
+      ippAddResolution(request, IPP_TAG_PRINTER, "x-resolution", IPP_RES_PER_INCH, 300, 600);
+      ippAddInteger(cols[0], IPP_TAG_ZERO, IPP_TAG_INTEGER, "x-dimension", 21000);
+      ippAddString(cols[0], IPP_TAG_ZERO, IPP_TAG_KEYWORD, "media-type", NULL, "stationery");
+      ippAddCollection(request, IPP_TAG_JOB, "media-col", cols[0]);
+      ippDelete(cols[0]);
+
+      attrs = ippNew();
+      file  = ippFileNew(NULL, NULL, NULL, NULL);
+
+      if (!ippFileOpen(file, "testipp.attrs", "w") || !ippFileWriteAttributes(file, request, true) || !ippFileClose(file))
+      {
+        testEndMessage(false, "write: %s", cupsGetErrorString());
+        status = 1;
+      }
+      else if (!ippFileOpen(file, "testipp.attrs", "r") || !ippFileSetAttributes(file, attrs) || !ippFileRead(file, NULL, true))
+      {
+        testEndMessage(false, "read: %s", cupsGetErrorString());
+        status = 1;
+      }
+      else
+      {
+        for (attr = ippGetFirstAttribute(request); attr; attr = ippGetNextAttribute(request))
+        {
+          if ((rattr = ippFindAttribute(attrs, ippGetName(attr), ippGetValueTag(attr))) == NULL || ippGetGroupTag(rattr) != ippGetGroupTag(attr))
+          {
+            testEndMessage(false, "missing %s", ippGetName(attr));
+            status = 1;
+            break;
+          }
+
+          ippAttributeString(attr, value, sizeof(value));
+          ippAttributeString(rattr, rvalue, sizeof(rvalue));
+
+          if (strcmp(rvalue, value))
+          {
+            testEndMessage(false, "got %s=%s, expected %s", ippGetName(attr), rvalue, value);
+            status = 1;
+            break;
+          }
+        }
+
+        if (!attr)
+          testEnd(true);
+      }
+
+      ippFileDelete(file);
+      ippDelete(attrs);
+      ippDelete(request);
+      unlink("testipp.attrs");
+    }
+
+    // Validate good and bad strings, including bad characters after the first
+    // eight bytes...
+    testBegin("ippValidateAttribute");
+    {
+      static const struct
+      {
+	ipp_tag_t	value_tag;	// Value tag
+	const char	*value;		// Value
+	bool		valid;		// Valid value?
+      } values[] =
+      {
+	{ IPP_TAG_TEXT, "Plain ASCII text that is longer than eight bytes", true },
+	{ IPP_TAG_TEXT, "Text with\ta tab and a line feed\n", true },
+	{ IPP_TAG_TEXT, "Caf\303\251 au lait \342\202\254 \360\237\226\250", true },
+	{ IPP_TAG_TEXT, "Control character \001 after eight bytes", false },
+	{ IPP_TAG_TEXT, "Delete character \177 after eight bytes", false },
+	{ IPP_TAG_TEXT, "Bad UTF-8 sequence \303 after eight bytes", false },
+	{ IPP_TAG_TEXT, "Truncated UTF-8 \342\202", false },
+	{ IPP_TAG_NAME, "Printer Name", true },
+	{ IPP_TAG_NAME, "Printer\tName", false },
+	{ IPP_TAG_KEYWORD, "iso_a4_210x297mm", true },
+	{ IPP_TAG_KEYWORD, "iso a4", false },
+	{ IPP_TAG_KEYWORD, "na_letter_8.5x11in\351", false },
+	{ IPP_TAG_LANGUAGE, "en-us", true },
+	{ IPP_TAG_LANGUAGE, "x", false },
+	{ IPP_TAG_LANGUAGE, "fr-ca", true },
+	{ IPP_TAG_MIMETYPE, "application/pdf", true },
+	{ IPP_TAG_MIMETYPE, "application pdf", false },
+	{ IPP_TAG_MIMETYPE, "text/plain;charset=utf-8", true }
+      };
+
+      for (i = 0, attr = NULL; i < (sizeof(values) / sizeof(values[0])); i ++)
+      {
+	request = ippNew();
+	attr    = ippAddString(request, IPP_TAG_JOB, values[i].value_tag, "x-value", NULL, values[i].value);
+
+	if (ippValidateAttribute(attr) != values[i].valid)
+	{
+	  testEndMessage(false, "got %s for \"%s\"", values[i].valid ? "invalid" : "valid", values[i].value);
+	  status = 1;
+	  ippDelete(request);
+	  break;
+	}
+
+	ippDelete(request);
+      }
+
+      if (i >= (sizeof(values) / sizeof(values[0])))
+	testEnd(true);
+    }
+
+    // Reset heap and arena messages and confirm that the arena keeps its
+    // memory blocks...
+    testBegin("ippReset");
+    for (i = 0; i < 2; i ++)
+    {
+      size_t		j,		// Looping var
+			count;		// Number of arena blocks
+      _ipp_arena_block_t *block;	// Arena block
+
+      request = i ? ippNewRequestArena(IPP_OP_PRINT_JOB) : ippNewRequest(IPP_OP_PRINT_JOB);
+      cols[0] = i ? ippNewArena() : ippNew();
+      ippAddInteger(cols[0], IPP_TAG_ZERO, IPP_TAG_INTEGER, "x-dimension", 21000);
+      ippAddCollection(request, IPP_TAG_JOB, "media-size", cols[0]);
+      ippDelete(cols[0]);
+
+      for (j = 0; j < 500; j ++)
+        ippAddStringf(request, IPP_TAG_JOB, IPP_TAG_NAME, "x-vendor-name", NULL, "Value %u", (unsigned)j);
+
+      ippReset(request);
+
+      for (block = request->arena ? request->arena->blocks : NULL, count = 0; block; block = block->next)
+        count ++;
+
+      if (ippGetFirstAttribute(request) || ippGetOperation(request) != 0 || ippGetRequestId(request) != 0 || ippGetState(request) != IPP_STATE_IDLE || count > 1 || (i && !request->arena->spare))
+      {
+        testEndMessage(false, "%s message not reset", i ? "arena" : "heap");
+        status = 1;
+        ippDelete(request);
+        break;
+      }
+
+      ippSetOperation(request, IPP_OP_GET_JOBS);
+      ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_CHARSET, "attributes-charset", NULL, "utf-8");
+      for (j = 0; j < 500; j ++)
+        ippAddStringf(request, IPP_TAG_JOB, IPP_TAG_NAME, "x-vendor-name", NULL, "Value %u", (unsigned)j);
+
+      if (ippGetOperation(request) != IPP_OP_GET_JOBS || (attr = ippGetFirstAttribute(request)) == NULL || strcmp(ippGetName(attr), "attributes-charset") || strcmp(ippGetString(attr, 0, NULL), "utf-8") || (attr = ippFindAttribute(request, "x-vendor-name", IPP_TAG_NAME)) == NULL || strcmp(ippGetString(attr, 0, NULL), "Value 0"))
+      {
+        testEndMessage(false, "%s message not reusable", i ? "arena" : "heap");
+        status = 1;
+        ippDelete(request);
+        break;
+      }
+
+      ippDelete(request);
+    }
+
+    if (i >= 2)
+      testEnd(true);
+
+    // Confirm that inline names and values survive resizing the attribute...
+    testBegin("ippSetString(inline)");
+    request = ippNew();
+    attr    = ippAddString(request, IPP_TAG_JOB, IPP_TAG_KEYWORD, "media-type", NULL, "stationery");
+
+    for (i = 1; i < 20; i ++)
+      ippSetString(request, &attr, i, (i & 1) ? "labels" : "envelope");
+
+    ippDeleteValues(request, &attr, 1, 18);
+    ippSetString(request, &attr, 1, "photographic");
+    ippSetString(request, &attr, 2, "transparency");
+    ippSetString(request, &attr, 0, "stationery-letterhead");
+
+    if (strcmp(ippGetName(attr), "media-type") || ippGetCount(attr) != 3 || strcmp(ippGetString(attr, 0, NULL), "stationery-letterhead") || strcmp(ippGetString(attr, 1, NULL), "photographic") || strcmp(ippGetString(attr, 2, NULL), "transparency"))
+    {
+      testEndMessage(false, "got %s=%s,%s,%s (%u values)", ippGetName(attr), ippGetString(attr, 0, NULL), ippGetString(attr, 1, NULL), ippGetString(attr, 2, NULL), (unsigned)ippGetCount(attr));
+      status = 1;
+    }
+    else
+    {
+      ippSetName(request, &attr, "media-type-supported");
+
+      if (strcmp(ippGetName(attr), "media-type-supported") || ippFindAttribute(request, "media-type", IPP_TAG_ZERO) || ippFindAttribute(request, "media-type-supported", IPP_TAG_KEYWORD) != attr)
+      {
+        testEndMessage(false, "got name %s", ippGetName(attr));
+        status = 1;
+      }
+      else
+        testEnd(true);
+    }
+
+    ippDelete(request);
+
+    // Confirm that cached lengths track changes to nested collections...
+    testBegin("ippGetLength(cached)");
+    request = ippNew();
+    cols[0] = ippNew();
+    ippAddInteger(cols[0], IPP_TAG_ZERO, IPP_TAG_INTEGER, "x-dimension", 21590);
+    attr = ippAddCollection(request, IPP_TAG_JOB, "media-size", cols[0]);
+    ippDelete(cols[0]);
+
+    length = ippGetLength(request);
+
+    cols[0] = ippGetCollection(attr, 0);
+    ippAddInteger(cols[0], IPP_TAG_ZERO, IPP_TAG_INTEGER, "y-dimension", 27940);
+
+    data.wused   = 0;
+    data.wsize   = sizeof(buffer);
+    data.wbuffer = buffer;
+
+    while ((state = ippWriteIO(&data, (ipp_io_cb_t)write_cb, 1, NULL, request)) != IPP_STATE_DATA)
+    {
+      if (state == IPP_STATE_ERROR)
+	break;
+    }
+
+    if (length == ippGetLength(request) || data.wused != ippGetLength(request))
+    {
+      testEndMessage(false, "got %u bytes, expected %u bytes", (unsigned)ippGetLength(request), (unsigned)data.wused);
+      status = 1;
+    }
+    else
+    {
+      length = ippGetLength(request);
+
+      ippDeleteAttribute(cols[0], ippFindAttribute(cols[0], "x-dimension", IPP_TAG_INTEGER));
+
+      if (ippGetLength(request) != (length - 25))
+      {
+        testEndMessage(false, "got %u bytes, expected %u bytes", (unsigned)ippGetLength(request), (unsigned)(length - 25));
+        status = 1;
+      }
+      else
+        testEnd(true);
+    }
+
+    ippDelete(request);
+
+    // Confirm that the cached length of a message without collections tracks
+    // the addition of a collection...
+    testBegin("ippGetLength(cached, no collections)");
+    request = ippNew();
+    ippAddInteger(request, IPP_TAG_JOB, IPP_TAG_INTEGER, "copies", 1);
+
+    length = ippGetLength(request);
+
+    cols[0] = ippNew();
+    ippAddInteger(cols[0], IPP_TAG_ZERO, IPP_TAG_INTEGER, "x-dimension", 21590);
+    attr = ippAddCollection(request, IPP_TAG_JOB, "media-size", cols[0]);
+    ippDelete(cols[0]);
+
+    if (ippGetLength(request) == length)
+    {
+      testEndMessage(false, "length did not change");
+      status = 1;
+    }
+    else
+    {
+      length  = ippGetLength(request);
+      cols[0] = ippGetCollection(attr, 0);
+      ippAddInteger(cols[0], IPP_TAG_ZERO, IPP_TAG_INTEGER, "y-dimension", 27940);
+
+      if (ippGetLength(request) != (length + 25))
+      {
+        testEndMessage(false, "got %u bytes, expected %u bytes", (unsigned)ippGetLength(request), (unsigned)(length + 25));
+        status = 1;
+      }
+      else
+        testEnd(true);
+    }
+
+    ippDelete(request);
+
+    // Build a large message and confirm that searches work with the name
+    // index...
+    testBegin("ippFindAttribute/ippFindNextAttribute(large message)");
+
+    request = ippNewRequest(IPP_OP_GET_JOBS);
+    for (i = 0; i < 100; i ++)
+    {
+      ippAddInteger(request, IPP_TAG_JOB, IPP_TAG_INTEGER, "job-id", (int)i + 1);
+      ippAddStringf(request, IPP_TAG_JOB, IPP_TAG_NAME, "job-name", NULL, "job-%u", (unsigned)i);
+      ippAddSeparator(request);
+    }
+
+    for (i = 0, attr = ippFindAttribute(request, "job-id", IPP_TAG_INTEGER); attr; attr = ippFindNextAttribute(request, "job-id", IPP_TAG_INTEGER))
+    {
+      if (ippGetInteger(attr, 0) != (int)i + 1)
+        break;
+      i ++;
+    }
+
+    if (i != 100)
+    {
+      testEndMessage(false, "found %u job-id attributes", (unsigned)i);
+      status = 1;
+    }
+    else if (ippFindAttribute(request, "job-name", IPP_TAG_INTEGER) || ippFindAttribute(request, "job-state", IPP_TAG_ZERO))
+    {
+      testEndMessage(false, "found wrong attribute");
+      status = 1;
+    }
+    else
+      testEnd(true);
+
+    testBegin("ippDeleteAttribute(large message)");
+    ippDeleteAttribute(request, ippFindAttribute(request, "job-id", IPP_TAG_INTEGER));
+    if ((attr = ippFindAttribute(request, "job-id", IPP_TAG_INTEGER)) == NULL || ippGetInteger(attr, 0) != 2)
+    {
+      testEndMessage(false, "got %d, expected 2", ippGetInteger(attr, 0));
+      status = 1;
+    }
+    else
+      testEnd(true);
+
+    testBegin("ippSetName(large message)");
+    attr = ippFindAttribute(request, "job-name", IPP_TAG_NAME);
+    ippSetName(request, &attr, "job-title");
+    if (ippFindAttribute(request, "job-title", IPP_TAG_NAME) != attr)
+    {
+      testEndMessage(false, "job-title not found");
+      status = 1;
+    }
+    else if ((attr = ippFindAttribute(request, "job-name", IPP_TAG_NAME)) == NULL || strcmp(ippGetString(attr, 0, NULL), "job-1"))
+    {
+      testEndMessage(false, "got \"%s\", expected \"job-1\"", ippGetString(attr, 0, NULL));
+      status = 1;
+    }
+    else
+      testEnd(true);
+
+    testBegin("ippSetInteger(large message)");
+    attr = ippFindAttribute(request, "job-id", IPP_TAG_INTEGER);
+    for (i = 1; i < 4 * IPP_MAX_VALUES; i ++)
+      ippSetInteger(request, &attr, i, (int)i);
+
+    if (ippFindAttribute(request, "job-id", IPP_TAG_INTEGER) != attr)
+    {
+      testEndMessage(false, "job-id not found after resize");
+      status = 1;
+    }
+    else
+      testEnd(true);
+
+    ippDelete(request);
+
+    // Read the bad collection data and confirm we get an error...
+    testBegin("Read Bad Collection from Memory");
+
+    request = ippNew();
+    data.rpos    = 0;
+    data.wused   = sizeof(bad_collection);
+    data.wsize   = sizeof(bad_collection);
+    data.wbuffer = bad_collection;
+
+    while ((state = ippReadIO(&data, (ipp_io_cb_t)read_cb, 1, NULL, request)) != IPP_STATE_DATA)
+      if (state == IPP_STATE_ERROR)
+	break;
+
+    ippDelete(request);
+
+    if (state != IPP_STATE_ERROR)
+      testEndMessage(false, "read successful");
+    else
+      testEnd(true);
+
+    // Read the mixed data and confirm we converted everything to rangeOfInteger
+    // values...
+    testBegin("Read Mixed integer/rangeOfInteger from Memory");
+
+    request = ippNew();
+    data.rpos    = 0;
+    data.wused   = sizeof(mixed);
+    data.wsize   = sizeof(mixed);
+    data.wbuffer = mixed;
+
+    while ((state = ippReadIO(&data, (ipp_io_cb_t)read_cb, 1, NULL,
+                              request)) != IPP_STATE_DATA)
+      if (state == IPP_STATE_ERROR)
+	break;
+
+    length = ippGetLength(request);
+
+    if (state != IPP_STATE_DATA)
+    {
+      testEndMessage(false, "%d bytes read", (int)data.rpos);
+      status = 1;
+    }
+    else if (data.rpos != sizeof(mixed))
+    {
+      testEndMessage(false, "read %d bytes, expected %d bytes", (int)data.rpos,
+             (int)sizeof(mixed));
+      print_attributes(request, 8);
+      status = 1;
+    }
+    else if (length != (sizeof(mixed) + 4))
+    {
+      testEndMessage(false, "wrong ippLength(), %d instead of %d bytes",
+             (int)length, (int)sizeof(mixed) + 4);
+      print_attributes(request, 8);
+      status = 1;
+    }
+    else
+      testEnd(true);
+
+    testBegin("ippFindAttribute(notify-lease-duration-supported)");
+    if ((attr = ippFindAttribute(request, "notify-lease-duration-supported",
+                                 IPP_TAG_ZERO)) == NULL)
+    {
+      testEndMessage(false, "not found");
+      status = 1;
+    }
+    else if (attr->value_tag != IPP_TAG_RANGE)
+    {
+      testEndMessage(false, "wrong type - %s", ippTagString(attr->value_tag));
+      status = 1;
+    }
+    else if (attr->num_values != 2)
+    {
+      testEndMessage(false, "wrong count - %d", attr->num_values);
+      status = 1;
+    }
+    else if (attr->values[0].range.lower != 1 ||
+             attr->values[0].range.upper != 1 ||
+             attr->values[1].range.lower != 16 ||
+             attr->values[1].range.upper != 32)
+    {
+      testEndMessage(false, "wrong values - %d,%d and %d,%d",
+             attr->values[0].range.lower,
+             attr->values[0].range.upper,
+             attr->values[1].range.lower,
+             attr->values[1].range.upper);
+      status = 1;
+    }
+    else
+      testEnd(true);
+
+    ippDelete(request);
+
+#ifdef DEBUG
+    // Test that private option array is sorted...
+    testBegin("_ippCheckOptions");
+    if ((name = _ippCheckOptions()) == NULL)
+    {
+      testEnd(true);
+    }
+    else
+    {
+      testEndMessage(false, "\"%s\" out of order", name);
+      status = 1;
+    }
+#endif // DEBUG
+
+    // Test _ippFindOption() private API...
+    testBegin("_ippFindOption(\"printer-type\")");
+    if (_ippFindOption("printer-type"))
+      testEnd(true);
+    else
+    {
+      testEnd(false);
+      status = 1;
+    }
+  }
+  else
+  {
+    // Read IPP files...
+    for (i = 1; i < (size_t)argc; i ++)
+    {
+      if (strlen(argv[i]) > 5 && !strcmp(argv[i] + strlen(argv[i]) - 5, ".test"))
+      {
+        // Read an ASCII IPP message...
+        ipp_file_t *file;		// IPP data file
+
+        file    = ippFileNew(NULL, NULL, NULL, NULL);
+        request = ippNew();
+
+        ippFileOpen(file, argv[i], "r");
+        ippFileRead(file, token_cb, true);
+        ippFileDelete(file);
+      }
+      else if (strlen(argv[i]) > 4 && !strcmp(argv[i] + strlen(argv[i]) - 4, ".hex"))
+      {
+        // Read a hex-encoded IPP message...
+	if ((fp = cupsFileOpen(argv[i], "r")) == NULL)
+	{
+	  printf("Unable to open \"%s\" - %s\n", argv[i], strerror(errno));
+	  status = 1;
+	  continue;
+	}
+
+	request = ippNew();
+	while ((state = ippReadIO(fp, (ipp_io_cb_t)read_hex, 1, NULL, request)) == IPP_STATE_ATTRIBUTE);
+
+	if (state != IPP_STATE_DATA)
+	{
+	  printf("Error reading IPP message from \"%s\": %s\n", argv[i], cupsGetErrorString());
+	  status = 1;
+
+	  ippDelete(request);
+	  request = NULL;
+	}
+
+        cupsFileClose(fp);
+      }
+      else
+      {
+        // Read a raw (binary) IPP message...
+	if ((fp = cupsFileOpen(argv[i], "r")) == NULL)
+	{
+	  printf("Unable to open \"%s\" - %s\n", argv[i], strerror(errno));
+	  status = 1;
+	  continue;
+	}
+
+	request = ippNew();
+	while ((state = ippReadIO(fp, (ipp_io_cb_t)cupsFileRead, 1, NULL,
+				  request)) == IPP_STATE_ATTRIBUTE);
+
+	if (state != IPP_STATE_DATA)
+	{
+	  printf("Error reading IPP message from \"%s\": %s\n", argv[i], cupsGetErrorString());
+	  status = 1;
+
+	  ippDelete(request);
+	  request = NULL;
+	}
+
+        cupsFileClose(fp);
+      }
+
+      if (request)
+      {
+	printf("\n%s:\n", argv[i]);
+	print_attributes(request, 4);
+	ippDelete(request);
+      }
+    }
+  }
+
+  return (status);
+}
+
+
+//
+// 'print_attributes()' - Print the attributes in a request...
+//
+
+void
+print_attributes(ipp_t *ipp,		// I - IPP request
+                 int   indent)		// I - Indentation
+{
+  ipp_tag_t		group;		// Current group
+  ipp_attribute_t	*attr;		// Current attribute
+  char                  buffer[2048];   // Value string
+
+
+  for (group = IPP_TAG_ZERO, attr = ipp->attrs; attr; attr = attr->next)
+  {
+    if (!attr->name && indent == 4)
+    {
+      group = IPP_TAG_ZERO;
+      putchar('\n');
+      continue;
+    }
+
+    if (group != attr->group_tag)
+    {
+      group = attr->group_tag;
+
+      testError("\n%*s%s:\n", indent - 4, "", ippTagString(group));
     }
 
     ippAttributeString(attr, buffer, sizeof(buffer));
@@ -941,6 +1987,33 @@ read_hex(cups_file_t *fp,		// I - File to read from
 }
 
 
+//
+// 'stream_cb()' - Count attributes for ippReadIOStream.
+//
+
+bool					// O - `true` to continue, `false` to stop
+stream_cb(_ippstream_t    *counts,	// I - Counts
+          ipp_tag_t       group,	// I - Group tag
+          ipp_attribute_t *attr)	// I - Attribute or `NULL` for group tag
+{
+  if (!attr)
+  {
+    counts->groups ++;
+    return (true);
+  }
+
+  if (ippGetGroupTag(attr) != group || !ippGetName(attr))
+    return (false);
+
+  counts->attrs ++;
+
+  if (ippGetValueTag(attr) == IPP_TAG_BEGIN_COLLECTION && ippFindAttribute(ippGetCollection(attr, 0), "media-size/x-dimension", IPP_TAG_INTEGER))
+    counts->collections ++;
+
+  return (!counts->max_attrs || counts->attrs < counts->max_attrs);
+}
+
+
 //
 // 'token_cb()' - Token callback for ASCII IPP data file parser.
 //
@@ -981,6 +2054,7 @@ write_cb(_ippdata_t   *data,		// I - Data
 
   memcpy(data->wbuffer + data->wused, buffer, count);
   data->wused += count;
+  data->wcalls ++;
 
   // Return the number of bytes written...
   return ((ssize_t)count);
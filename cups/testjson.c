@@ -29,6 +29,8 @@ main(int  argc,				// I - Number of command-line arguments
     // Do unit tests...
     cups_json_t	*current,		// Current node
 		*parent;		// Current parent node
+    cups_json_writer_t *w;		// JSON writer
+    cups_file_t	*fp;			// JSON file
     cups_jtype_t type;			// Node type
     size_t	count;			// Number of children
     char	*s;			// JSON string
@@ -214,10 +216,264 @@ main(int  argc,				// I - Number of command-line arguments
       testEndMessage(false, "%s", cupsGetErrorString());
     }
 
+    testBegin("cupsJSONImportString(escapes and arrays)");
+    if ((parent = cupsJSONImportString("{\"key\":\"A long string with \\\"quotes\\\", \\\\backslashes\\\\, \\u00e9, and \\n.\",\"array\":[1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,17,18,19,20,21,22,23,24,25,26,27,28,29,30]}")) != NULL)
+    {
+      const char *value = cupsJSONGetString(cupsJSONFind(parent, "key"));
+					// String value
+
+      if (!value || strcmp(value, "A long string with \"quotes\", \\backslashes\\, \303\251, and \n."))
+      {
+        testEndMessage(false, "got '%s'", value ? value : "(null)");
+      }
+      else if ((current = cupsJSONFind(parent, "array")) == NULL || (count = cupsJSONGetCount(current)) != 30)
+      {
+        testEndMessage(false, "bad array");
+      }
+      else
+      {
+        // Mix heap and arena nodes before deleting...
+        cupsJSONNewString(current, NULL, "added");
+        cupsJSONDelete(cupsJSONGetChild(current, 0));
+
+        count = cupsJSONGetCount(current);
+        testEndMessage(count == 30, "%u", (unsigned)count);
+      }
+
+      cupsJSONDelete(parent);
+    }
+    else
+    {
+      testEndMessage(false, "%s", cupsGetErrorString());
+    }
+
+    testBegin("cupsJSONImportString(unterminated string)");
+    parent = cupsJSONImportString("{\"key\":\"value]}");
+    testEnd(parent == NULL);
+    cupsJSONDelete(parent);
+
+    // The longest numbers are 25 characters...
+    testBegin("cupsJSONExportString(longest numbers)");
+    if ((parent = cupsJSONNew(NULL, NULL, CUPS_JTYPE_OBJECT)) != NULL)
+    {
+      cups_json_t	*array;		// Array of numbers
+      static const double numbers[] =	// Longest numbers in each notation
+      {
+        -1.2345678901234567e-6,
+        -1.2345678901234567e300,
+        -123456789012345680000.0
+      };
+
+      current = cupsJSONNewKey(parent, NULL, "numbers");
+      array   = cupsJSONNew(parent, current, CUPS_JTYPE_ARRAY);
+
+      for (i = 0, current = NULL; i < (int)(sizeof(numbers) / sizeof(numbers[0])); i ++)
+        current = cupsJSONNewNumber(array, current, numbers[i]);
+
+      if ((s = cupsJSONExportString(parent)) == NULL || strcmp(s, "{\"numbers\":[-0.0000012345678901234567,-1.2345678901234567e+300,-123456789012345680000]}"))
+      {
+        testEndMessage(false, "got '%s'", s ? s : "(null)");
+      }
+      else
+      {
+        cupsJSONDelete(parent);
+
+        if ((parent = cupsJSONImportString(s)) == NULL)
+        {
+          testEndMessage(false, "%s", cupsGetErrorString());
+        }
+        else
+        {
+          for (i = 0, current = cupsJSONGetChild(cupsJSONFind(parent, "numbers"), 0); current && i < (int)(sizeof(numbers) / sizeof(numbers[0])); i ++, current = cupsJSONGetSibling(current))
+          {
+            if (cupsJSONGetNumber(current) != numbers[i])
+              break;
+          }
+
+          testEndMessage(i == (int)(sizeof(numbers) / sizeof(numbers[0])), "%u of %u numbers read back", (unsigned)i, (unsigned)(sizeof(numbers) / sizeof(numbers[0])));
+        }
+      }
+
+      free(s);
+      cupsJSONDelete(parent);
+    }
+    else
+    {
+      testEndMessage(false, "%s", cupsGetErrorString());
+    }
+
     testBegin("cupsJSONDelete(root)");
     cupsJSONDelete(json);
     testEnd(true);
 
+    testBegin("cupsJSONFind(large object)");
+    if ((json = cupsJSONNew(NULL, NULL, CUPS_JTYPE_OBJECT)) != NULL)
+    {
+      char	key[32];		// Key string
+      bool	found = true;		// Found all keys?
+
+      for (i = 0; i < 200 && found; i ++)
+      {
+        snprintf(key, sizeof(key), "key%d", i);
+        current = cupsJSONNewKey(json, NULL, key);
+        cupsJSONNewNumber(json, current, i);
+
+        // Look up the first key after each add to build and use the index...
+        found = cupsJSONGetNumber(cupsJSONFind(json, "key0")) == 0.0;
+      }
+
+      for (i = 0; i < 200 && found; i ++)
+      {
+        snprintf(key, sizeof(key), "key%d", i);
+        found = cupsJSONGetNumber(cupsJSONFind(json, key)) == i;
+      }
+
+      if (!found)
+      {
+        testEndMessage(false, "%s not found", key);
+      }
+      else
+      {
+        // Delete a key and its value...
+        current = cupsJSONFind(json, "key100");
+        cupsJSONDelete(cupsJSONGetChild(json, 200));
+        cupsJSONDelete(current);
+
+        // Append a new key and value...
+        current = cupsJSONNewKey(json, NULL, "new");
+        cupsJSONNewString(json, current, "value");
+
+        if (cupsJSONFind(json, "key100"))
+          testEndMessage(false, "key100 not deleted");
+        else if (cupsJSONGetNumber(cupsJSONFind(json, "key199")) != 199.0)
+          testEndMessage(false, "key199 not found");
+        else if (!cupsJSONFind(json, "new") || cupsJSONGetSibling(cupsJSONGetChild(json, 398)) != cupsJSONFind(json, "new"))
+          testEndMessage(false, "new not found");
+        else
+          testEnd(true);
+      }
+
+      cupsJSONDelete(json);
+    }
+    else
+    {
+      testEndMessage(false, "%s", cupsGetErrorString());
+    }
+
+    testBegin("cupsJSONWriterNew(NULL)");
+    if ((w = cupsJSONWriterNew(NULL)) != NULL)
+    {
+      static const char *expected = "{\"name\":\"a \\\"b\\\"\\n\\u0001\",\"values\":[1,2.5,true,false,null],\"empty\":{}}";
+					// Expected JSON output
+
+      testEnd(true);
+
+      testBegin("cupsJSONWriterAdd*");
+      cupsJSONWriterStartObject(w);
+      cupsJSONWriterAddKey(w, "name");
+      cupsJSONWriterAddString(w, "a \"b\"\n\001");
+      cupsJSONWriterAddKey(w, "values");
+      cupsJSONWriterStartArray(w);
+      cupsJSONWriterAddNumber(w, 1);
+      cupsJSONWriterAddNumber(w, 2.5);
+      cupsJSONWriterAddBoolean(w, true);
+      cupsJSONWriterAddBoolean(w, false);
+      cupsJSONWriterAddNull(w);
+      cupsJSONWriterEndArray(w);
+      cupsJSONWriterAddKey(w, "empty");
+      cupsJSONWriterStartObject(w);
+      cupsJSONWriterEndObject(w);
+      if (!cupsJSONWriterEndObject(w))
+        testEndMessage(false, "%s", cupsGetErrorString());
+      else if (strcmp(cupsJSONWriterGetString(w), expected))
+        testEndMessage(false, "got '%s'", cupsJSONWriterGetString(w));
+      else
+        testEnd(true);
+
+      testBegin("cupsJSONWriterDelete");
+      testEnd(cupsJSONWriterDelete(w));
+    }
+    else
+    {
+      testEndMessage(false, "%s", cupsGetErrorString());
+    }
+
+    testBegin("cupsJSONWriterAddString(no key)");
+    w = cupsJSONWriterNew(NULL);
+    cupsJSONWriterStartObject(w);
+    testEnd(!cupsJSONWriterAddString(w, "value") && !cupsJSONWriterDelete(w));
+
+    testBegin("cupsJSONWriterNew(file)");
+    if ((fp = cupsFileOpen("test.json", "w")) != NULL)
+    {
+      w = cupsJSONWriterNew(fp);
+      cupsJSONWriterStartObject(w);
+      cupsJSONWriterAddKey(w, "numbers");
+      cupsJSONWriterStartArray(w);
+      for (i = 0; i < 1000; i ++)
+        cupsJSONWriterAddNumber(w, i);
+      cupsJSONWriterEndArray(w);
+      cupsJSONWriterEndObject(w);
+
+      if (!cupsJSONWriterDelete(w) || !cupsFileClose(fp))
+      {
+        testEndMessage(false, "%s", cupsGetErrorString());
+      }
+      else if ((parent = cupsJSONImportFile("test.json")) == NULL)
+      {
+        testEndMessage(false, "%s", cupsGetErrorString());
+      }
+      else
+      {
+        count = cupsJSONGetCount(cupsJSONFind(parent, "numbers"));
+        testEndMessage(count == 1000, "%u", (unsigned)count);
+        cupsJSONDelete(parent);
+      }
+    }
+    else
+    {
+      testEndMessage(false, "%s", cupsGetErrorString());
+    }
+
+    testBegin("cupsJSONImportURL(cached)");
+    {
+      static const char *url = "https://www.example.invalid/cached.json";
+					// Cached URL
+      unsigned char	hash[32];	// SHA-256 hash of URL
+      char		hashstr[65],	// Hex string
+			filename[256];	// Cache filename
+      time_t		cached_modified = 0;
+					// Last-Modified value
+
+      // Seed the cache directory with a response that is fresh for an hour...
+      cupsHashData("sha2-256", url, strlen(url), hash, sizeof(hash));
+      snprintf(filename, sizeof(filename), "%s.json", cupsHashString(hash, sizeof(hash), hashstr, sizeof(hashstr)));
+
+      if ((fp = cupsFileOpen(filename, "w")) != NULL)
+      {
+        cupsFilePrintf(fp, "URL: %s\nETag: \"1\"\nLast-Modified: 1700000000\nExpires: %ld\n\n{\"cached\":true}", url, (long)time(NULL) + 3600);
+        cupsFileClose(fp);
+      }
+
+      cupsJSONSetCacheDirectory(".");
+
+      if ((json = cupsJSONImportURL(url, &cached_modified)) == NULL)
+        testEndMessage(false, "%s", cupsGetErrorString());
+      else if (cupsJSONGetType(cupsJSONFind(json, "cached")) != CUPS_JTYPE_TRUE || cached_modified != 1700000000)
+        testEndMessage(false, "bad cached data");
+      else
+        testEnd(true);
+
+      cupsJSONDelete(json);
+
+      testBegin("cupsJSONImportURL(cached, since %ld)", (long)cached_modified);
+      json = cupsJSONImportURL(url, &cached_modified);
+      testEnd(!json && cupsGetError() == IPP_STATUS_OK_EVENTS_COMPLETE);
+
+      cupsJSONSetCacheDirectory(NULL);
+      unlink(filename);
+    }
+
     testBegin("cupsJSONImportURL('https://accounts.google.com/.well-known/openid-configuration', no last modified)");
     json = cupsJSONImportURL("https://accounts.google.com/.well-known/openid-configuration", &last_modified);
 
@@ -165,6 +165,23 @@ main(int  argc,				// I - Number of command-line arguments
     testBegin("cupsJWTHasValidSignature(RS512)");
     testEnd(cupsJWTHasValidSignature(jwt, pubjwk));
 
+    testBegin("cupsJWTHasValidSignature(RS512 cached)");
+    testEnd(cupsJWTHasValidSignature(jwt, pubjwk));
+
+    testBegin("cupsJWTHasValidSignature(RS512 modified)");
+    cupsJWTSetClaimString(jwt, CUPS_JWT_SUB, "modified");
+    testEnd(!cupsJWTHasValidSignature(jwt, pubjwk));
+    cupsJWTSetClaimString(jwt, CUPS_JWT_SUB, "joe.user");
+
+    testBegin("cupsJWTSign(RS256 cached)");
+    testEnd(cupsJWTSign(jwt, CUPS_JWA_RS256, jwk));
+
+    testBegin("cupsJWTHasValidSignature(RS256 cached)");
+    testEnd(cupsJWTHasValidSignature(jwt, pubjwk));
+
+    testBegin("cupsJWTSign(RS256 public key)");
+    testEnd(!cupsJWTSign(jwt, CUPS_JWA_RS256, pubjwk));
+
     cupsJSONDelete(jwk);
     cupsJSONDelete(pubjwk);
 
@@ -194,6 +211,15 @@ main(int  argc,				// I - Number of command-line arguments
     testBegin("cupsJWTHasValidSignature(ES256)");
     testEnd(cupsJWTHasValidSignature(jwt, pubjwk));
 
+    testBegin("cupsJWTSign(ES256 cached)");
+    testEnd(cupsJWTSign(jwt, CUPS_JWA_ES256, jwk));
+
+    testBegin("cupsJWTHasValidSignature(ES256 cached)");
+    testEnd(cupsJWTHasValidSignature(jwt, pubjwk));
+
+    testBegin("cupsJWTSign(ES256 public key)");
+    testEnd(!cupsJWTSign(jwt, CUPS_JWA_ES256, pubjwk));
+
     cupsJSONDelete(jwk);
     cupsJSONDelete(pubjwk);
 
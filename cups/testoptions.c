@@ -27,6 +27,12 @@ main(int  argc,				// I - Number of command-line arguments
   ipp_t		*request;		// IPP request
   ipp_attribute_t *attr;		// IPP attribute
   size_t	count;			// Number of attributes
+  char		buffer[256];		// String buffer
+  char		*pooled[3];		// Pooled strings
+  cups_options_t *opts;			// Option set
+  size_t	i,			// Looping var
+		num_copy;		// Number of copied options
+  cups_option_t	*copy;			// Copied options
 
 
   if (argc == 1)
@@ -139,10 +145,137 @@ main(int  argc,				// I - Number of command-line arguments
     }
     else
       testEnd(true);
+
+    testBegin("cupsEncodeOption(quoted values)");
+    if ((attr = cupsEncodeOption(request, IPP_TAG_JOB, "auth-info", "'a,b',c\\,d,e")) == NULL)
+    {
+      testEndMessage(false, "%s", cupsGetErrorString());
+      status ++;
+    }
+    else if (ippGetCount(attr) != 3)
+    {
+      testEndMessage(false, "\"auth-info\" has %d values, expected 3", (int)ippGetCount(attr));
+      status ++;
+    }
+    else if (strcmp(ippGetString(attr, 0, NULL), "'a,b'") || strcmp(ippGetString(attr, 1, NULL), "c,d") || strcmp(ippGetString(attr, 2, NULL), "e"))
+    {
+      testEndMessage(false, "\"auth-info\" has values \"%s\", \"%s\", \"%s\", expected \"'a,b'\", \"c,d\", \"e\"", ippGetString(attr, 0, NULL), ippGetString(attr, 1, NULL), ippGetString(attr, 2, NULL));
+      status ++;
+    }
+    else
+      testEnd(true);
+
+    ippDelete(request);
+
+    // _cupsStrAlloc/Equal/Hash/Length()
+    testBegin("_cupsStrAlloc/Equal/Hash/Length");
+    cupsCopyString(buffer, "media-col", sizeof(buffer));
+    pooled[0] = _cupsStrAlloc("media-col");
+    pooled[1] = _cupsStrAlloc(buffer);
+    pooled[2] = _cupsStrAlloc("media-type");
+
+    if (!_cupsStrEqual(pooled[0], pooled[1]))
+    {
+      testEndMessage(false, "%p != %p", pooled[0], pooled[1]);
+      status ++;
+    }
+    else if (_cupsStrLength(pooled[0]) != 9)
+    {
+      testEndMessage(false, "length=%u, expected 9", (unsigned)_cupsStrLength(pooled[0]));
+      status ++;
+    }
+    else if (_cupsStrHash(pooled[0]) == _cupsStrHash(pooled[2]))
+    {
+      testEndMessage(false, "\"media-col\" and \"media-type\" have the same hash %u", (unsigned)_cupsStrHash(pooled[0]));
+      status ++;
+    }
+    else
+      testEnd(true);
+
+    _cupsStrFree(pooled[0]);
+    _cupsStrFree(pooled[1]);
+    _cupsStrFree(pooled[2]);
+
+    // cupsAddOption() with the current value
+    testBegin("cupsAddOption(same value)");
+    num_options = cupsAddOption("foo", cupsGetOption("foo", num_options, options), num_options, &options);
+
+    if ((value = cupsGetOption("foo", num_options, options)) == NULL || strcmp(value, "1234"))
+    {
+      testEndMessage(false, "foo=\"%s\", expected \"1234\"", value);
+      status ++;
+    }
+    else
+      testEnd(true);
+
+    // cupsOptionsNew/Add/Get/Remove()
+    testBegin("cupsOptionsAdd/Get/Remove");
+    opts = cupsOptionsNew();
+
+    for (i = 0; i < 1000; i ++)
+    {
+      snprintf(buffer, sizeof(buffer), "option-%u", (unsigned)i);
+      cupsOptionsAdd(opts, buffer, buffer + 7);
+    }
+
+    for (i = 0; i < 1000; i += 2)
+    {
+      snprintf(buffer, sizeof(buffer), "OPTION-%u", (unsigned)i);
+      cupsOptionsRemove(opts, buffer);
+    }
+
+    for (i = 0; i < 1000; i ++)
+    {
+      snprintf(buffer, sizeof(buffer), "option-%u", (unsigned)i);
+      value = cupsOptionsGet(opts, buffer);
+
+      if ((i & 1) ? (!value || strcmp(value, buffer + 7)) : value != NULL)
+        break;
+    }
+
+    if (cupsOptionsGetCount(opts) != 500)
+    {
+      testEndMessage(false, "%u options, expected 500", (unsigned)cupsOptionsGetCount(opts));
+      status ++;
+    }
+    else if (i < 1000)
+    {
+      testEndMessage(false, "option-%u=\"%s\"", (unsigned)i, value);
+      status ++;
+    }
+    else
+      testEnd(true);
+
+    // cupsOptionsAddArray/GetArray()
+    testBegin("cupsOptionsAddArray/GetArray");
+    cupsOptionsAddArray(opts, num_options, options);
+    num_copy = cupsOptionsGetArray(opts, &copy);
+
+    if (num_copy != 500 + num_options)
+    {
+      testEndMessage(false, "%u options, expected %u", (unsigned)num_copy, (unsigned)(500 + num_options));
+      status ++;
+    }
+    else if ((value = cupsGetOption("option-999", num_copy, copy)) == NULL || strcmp(value, "999"))
+    {
+      testEndMessage(false, "option-999=\"%s\", expected \"999\"", value);
+      status ++;
+    }
+    else if ((value = cupsGetOption("foobar", num_copy, copy)) == NULL || strcmp(value, "FOO BAR"))
+    {
+      testEndMessage(false, "foobar=\"%s\", expected \"FOO BAR\"", value);
+      status ++;
+    }
+    else
+      testEnd(true);
+
+    cupsFreeOptions(num_copy, copy);
+    cupsOptionsDelete(opts);
+
+    cupsFreeOptions(num_options, options);
   }
   else
   {
-    size_t		i;		// Looping var
     cups_option_t	*option;	// Current option
 
 
@@ -14,13 +14,31 @@
 #include <math.h>
 
 
+//
+// Local types...
+//
+
+typedef struct test_buffer_s		// Memory buffer for output
+{
+  unsigned char	*data;			// Data
+  size_t	used,			// Bytes used
+		alloc,			// Bytes allocated
+		pos,			// Read position
+		calls;			// Number of read/write calls
+} test_buffer_t;
+
+
 //
 // Local functions...
 //
 
+static int	do_buffer_tests(cups_raster_mode_t mode);
 static int	do_ras_file(const char *filename);
 static int	do_raster_tests(cups_raster_mode_t mode);
+static int	do_thread_tests(cups_raster_mode_t mode);
 static void	print_changes(cups_page_header_t *header, cups_page_header_t *expected);
+static ssize_t	read_buffer(test_buffer_t *bufptr, unsigned char *buffer, size_t length);
+static ssize_t	write_buffer(test_buffer_t *bufptr, unsigned char *buffer, size_t length);
 
 
 //
@@ -40,6 +58,10 @@ main(int  argc,				// I - Number of command-line args
     errors += do_raster_tests(CUPS_RASTER_WRITE_COMPRESSED);
     errors += do_raster_tests(CUPS_RASTER_WRITE_PWG);
     errors += do_raster_tests(CUPS_RASTER_WRITE_APPLE);
+    errors += do_thread_tests(CUPS_RASTER_WRITE_COMPRESSED);
+    errors += do_thread_tests(CUPS_RASTER_WRITE_PWG);
+    errors += do_buffer_tests(CUPS_RASTER_WRITE);
+    errors += do_buffer_tests(CUPS_RASTER_WRITE_COMPRESSED);
   }
   else
   {
@@ -53,6 +75,154 @@ main(int  argc,				// I - Number of command-line args
 }
 
 
+//
+// 'do_buffer_tests()' - Test reading and writing with a large I/O buffer.
+//
+
+static int				// O - Number of errors
+do_buffer_tests(cups_raster_mode_t mode)// I - Write mode
+{
+  int			i;		// Looping var
+  unsigned		page, x, y;	// Looping vars
+  cups_raster_t		*r;		// Raster stream
+  cups_page_header_t	header;		// Page header
+  test_buffer_t		output[2];	// Output for default and large buffers
+  unsigned char		line[1024];	// Line buffer
+  int			errors = 0;	// Number of errors
+
+
+  testBegin("cupsRasterSetBufferSize(%s)", mode == CUPS_RASTER_WRITE ? "CUPS_RASTER_WRITE" : "CUPS_RASTER_WRITE_COMPRESSED");
+
+  memset(&header, 0, sizeof(header));
+  header.cupsWidth        = 256;
+  header.cupsHeight       = 256;
+  header.cupsBytesPerLine = 1024;
+  header.cupsBitsPerColor = 8;
+  header.cupsBitsPerPixel = 32;
+  header.cupsColorOrder   = CUPS_ORDER_CHUNKED;
+  header.cupsColorSpace   = CUPS_CSPACE_CMYK;
+  header.cupsNumColors    = 4;
+
+  memset(output, 0, sizeof(output));
+
+  // Write the same pages with the default and a 1MiB buffer...
+  for (i = 0; i < 2 && !errors; i ++)
+  {
+    if ((r = cupsRasterOpenIO((cups_raster_cb_t)write_buffer, output + i, mode)) == NULL)
+    {
+      testEndMessage(false, "%s", cupsRasterGetErrorString());
+      errors ++;
+      break;
+    }
+
+    if (i && !cupsRasterSetBufferSize(r, 1048576))
+    {
+      testEndMessage(false, "unable to set buffer size");
+      errors ++;
+    }
+
+    for (page = 0; page < 2 && !errors; page ++)
+    {
+      if (!cupsRasterWriteHeader(r, &header))
+      {
+        testEndMessage(false, "cupsRasterWriteHeader failed");
+        errors ++;
+        break;
+      }
+
+      for (y = 0; y < header.cupsHeight; y ++)
+      {
+        for (x = 0; x < header.cupsBytesPerLine; x ++)
+          line[x] = (unsigned char)((x & 64) ? y + page : x);
+
+        if (!cupsRasterWritePixels(r, line, header.cupsBytesPerLine))
+        {
+          testEndMessage(false, "cupsRasterWritePixels failed");
+          errors ++;
+          break;
+        }
+      }
+    }
+
+    cupsRasterClose(r);
+  }
+
+  if (!errors && (output[0].used != output[1].used || memcmp(output[0].data, output[1].data, output[0].used)))
+  {
+    testEndMessage(false, "%u bytes written with buffer, expected %u", (unsigned)output[1].used, (unsigned)output[0].used);
+    errors ++;
+  }
+  else if (!errors && output[1].calls > 2)
+  {
+    testEndMessage(false, "%u writes with buffer, expected 2", (unsigned)output[1].calls);
+    errors ++;
+  }
+
+  // Read the pages back with a 1MiB buffer...
+  if (!errors)
+  {
+    if ((r = cupsRasterOpenIO((cups_raster_cb_t)read_buffer, output + 1, CUPS_RASTER_READ)) == NULL || !cupsRasterSetBufferSize(r, 1048576))
+    {
+      testEndMessage(false, "%s", cupsRasterGetErrorString());
+      errors ++;
+    }
+    else
+    {
+      output[1].calls = 0;
+
+      for (page = 0; page < 2 && !errors; page ++)
+      {
+	if (!cupsRasterReadHeader(r, &header))
+	{
+	  testEndMessage(false, "cupsRasterReadHeader failed");
+	  errors ++;
+	  break;
+	}
+
+	for (y = 0; y < header.cupsHeight; y ++)
+	{
+	  if (!cupsRasterReadPixels(r, line, header.cupsBytesPerLine))
+	  {
+	    testEndMessage(false, "cupsRasterReadPixels failed");
+	    errors ++;
+	    break;
+	  }
+
+	  for (x = 0; x < header.cupsBytesPerLine; x ++)
+	  {
+	    if (line[x] != (unsigned char)((x & 64) ? y + page : x))
+	      break;
+	  }
+
+	  if (x < header.cupsBytesPerLine)
+	  {
+	    testEndMessage(false, "page %u, line %u corrupt", page + 1, y);
+	    errors ++;
+	    break;
+	  }
+	}
+      }
+
+      if (!errors && output[1].calls > 2)
+      {
+	testEndMessage(false, "%u reads with buffer, expected 2", (unsigned)output[1].calls);
+	errors ++;
+      }
+    }
+
+    cupsRasterClose(r);
+  }
+
+  if (!errors)
+    testEndMessage(true, "%u bytes", (unsigned)output[1].used);
+
+  free(output[0].data);
+  free(output[1].data);
+
+  return (errors);
+}
+
+
 //
 // 'do_ras_file()' - Test reading of a raster file.
 //
@@ -129,6 +299,7 @@ do_raster_tests(cups_raster_mode_t mode)// O - Write mode
   cups_page_header_t	header,		// Page header
 			expected;	// Expected page header
   unsigned char		data[2048];	// Raster data
+  const unsigned char	*line;		// Line from cupsRasterGetLine
   int			errors = 0;	// Number of errors
 
 
@@ -429,13 +600,15 @@ do_raster_tests(cups_raster_mode_t mode)// O - Write mode
       {
 	for (y = 0; y < 64; y ++)
 	{
-	  if (!cupsRasterReadPixels(r, data, header.cupsBytesPerLine))
+	  if ((line = cupsRasterGetLine(r)) == NULL)
 	  {
-	    testEndMessage(false, "read error");
+	    testEndMessage(false, "cupsRasterGetLine failed");
 	    errors ++;
 	    break;
 	  }
 
+	  memcpy(data, line, header.cupsBytesPerLine);
+
 	  if (data[0] != 255 || memcmp(data, data + 1, header.cupsBytesPerLine - 1))
           {
 	    testEndMessage(false, "raster line %d corrupt", y + 128);
@@ -505,6 +678,220 @@ do_raster_tests(cups_raster_mode_t mode)// O - Write mode
   cupsRasterClose(r);
   fclose(fp);
 
+  // Test random access, starting with a page that has to be scanned for...
+  testBegin("cupsRasterSeekPage");
+
+  if ((fp = fopen("test.raster", "rb")) == NULL || (r = cupsRasterOpen(fileno(fp), CUPS_RASTER_READ)) == NULL)
+  {
+    testEndMessage(false, "%s", strerror(errno));
+    errors ++;
+  }
+  else
+  {
+    static const unsigned seek_pages[] = { 4, 2, 3, 1, 4 };
+					// Pages to seek to
+    static const unsigned seek_bpp[] = { 8, 32, 16, 64 };
+					// Bits per pixel for each page
+
+    for (count = 0; count < (unsigned)(sizeof(seek_pages) / sizeof(seek_pages[0])); count ++)
+    {
+      page = seek_pages[count];
+
+      if (!cupsRasterSeekPage(r, page))
+      {
+        testEndMessage(false, "page %u: %s", page, cupsRasterGetErrorString());
+        errors ++;
+        break;
+      }
+      else if (!cupsRasterReadHeader(r, &header) || header.cupsBitsPerPixel != seek_bpp[page - 1])
+      {
+        testEndMessage(false, "page %u: bad page header", page);
+        errors ++;
+        break;
+      }
+      else if (!cupsRasterReadPixels(r, data, header.cupsBytesPerLine) || data[0] != 0 || memcmp(data, data + 1, header.cupsBytesPerLine - 1))
+      {
+        testEndMessage(false, "page %u: raster line 0 corrupt", page);
+        errors ++;
+        break;
+      }
+    }
+
+    if (count >= (unsigned)(sizeof(seek_pages) / sizeof(seek_pages[0])))
+    {
+      if (cupsRasterSeekPage(r, 5))
+      {
+        testEndMessage(false, "seek to page 5 succeeded");
+        errors ++;
+      }
+      else
+      {
+        testEnd(true);
+      }
+    }
+
+    cupsRasterClose(r);
+  }
+
+  if (fp)
+    fclose(fp);
+
+  return (errors);
+}
+
+
+//
+// 'do_thread_tests()' - Test writing with multiple compression threads.
+//
+
+static int				// O - Number of errors
+do_thread_tests(cups_raster_mode_t mode)// I - Write mode
+{
+  int			i;		// Looping var
+  unsigned		page, x, y,	// Looping vars
+			count,		// Number of lines in band
+			bytes;		// Number of bytes to write
+  cups_raster_t		*r;		// Raster stream
+  cups_page_header_t	header;		// Page header
+  test_buffer_t		output[2];	// Output for 1 and 4 threads
+  unsigned char		*data,		// Page data
+			*line,		// Current line
+			small[5 * 1024];// Page data for 5-line page
+  int			errors = 0;	// Number of errors
+
+
+  testBegin("cupsRasterSetCompressionThreads(%s)", mode == CUPS_RASTER_WRITE_COMPRESSED ? "CUPS_RASTER_WRITE_COMPRESSED" : "CUPS_RASTER_WRITE_PWG");
+
+  memset(&header, 0, sizeof(header));
+  header.cupsWidth        = 256;
+  header.cupsHeight       = 640;
+  header.cupsBytesPerLine = 1024;
+  header.cupsBitsPerColor = 8;
+  header.cupsBitsPerPixel = 32;
+  header.cupsColorOrder   = CUPS_ORDER_CHUNKED;
+  header.cupsColorSpace   = CUPS_CSPACE_CMYK;
+  header.cupsNumColors    = 4;
+  header.HWResolution[0]  = 64;
+  header.HWResolution[1]  = 64;
+  header.PageSize[0]      = 288;
+  header.PageSize[1]      = 720;
+
+  if ((data = malloc(header.cupsHeight * header.cupsBytesPerLine)) == NULL)
+  {
+    testEndMessage(false, "%s", strerror(errno));
+    return (1);
+  }
+
+  // Lines 0-299 are blank, followed by groups of 1 to 7 identical lines...
+  memset(data, 0, 300 * header.cupsBytesPerLine);
+
+  for (y = 300, line = data + y * header.cupsBytesPerLine; y < header.cupsHeight; y ++, line += header.cupsBytesPerLine)
+  {
+    if (y % 7 < y % 5)
+    {
+      memcpy(line, line - header.cupsBytesPerLine, header.cupsBytesPerLine);
+      continue;
+    }
+
+    for (x = 0; x < header.cupsBytesPerLine; x ++)
+      line[x] = (unsigned char)((x & 32) ? y : (x * y) >> 3);
+  }
+
+  // The 5-line page has a row count that is not a multiple of the number of
+  // threads...
+  for (y = 0, line = small; y < 5; y ++, line += header.cupsBytesPerLine)
+  {
+    for (x = 0; x < header.cupsBytesPerLine; x ++)
+      line[x] = (unsigned char)(x + 37 * y);
+  }
+
+  memset(output, 0, sizeof(output));
+
+  for (i = 0; i < 2; i ++)
+  {
+    if ((r = cupsRasterOpenIO((cups_raster_cb_t)write_buffer, output + i, mode)) == NULL)
+    {
+      errors ++;
+      break;
+    }
+
+    if (i && !cupsRasterSetCompressionThreads(r, 4))
+    {
+      testEndMessage(false, "unable to set threads");
+      errors ++;
+    }
+
+    for (page = 0; page < 2; page ++)
+    {
+      if (!cupsRasterWriteHeader(r, &header))
+      {
+        errors ++;
+        break;
+      }
+
+      // Write bands of 37 lines, splitting the last line of each band on the
+      // second page...
+      for (y = 0; y < header.cupsHeight; y += count)
+      {
+        if ((count = header.cupsHeight - y) > 37)
+          count = 37;
+
+        line  = data + y * header.cupsBytesPerLine;
+        bytes = count * header.cupsBytesPerLine;
+
+        if (page)
+        {
+          if (!cupsRasterWritePixels(r, line, bytes - 512))
+            break;
+
+          line  += bytes - 512;
+          bytes = 512;
+        }
+
+        if (!cupsRasterWritePixels(r, line, bytes))
+          break;
+      }
+
+      if (y < header.cupsHeight)
+      {
+        testEndMessage(false, "cupsRasterWritePixels failed");
+        errors ++;
+        break;
+      }
+    }
+
+    if (!errors)
+    {
+      // Write a 5-line page in a single call...
+      header.cupsHeight = 5;
+
+      if (!cupsRasterWriteHeader(r, &header) || !cupsRasterWritePixels(r, small, sizeof(small)))
+      {
+        testEndMessage(false, "cupsRasterWritePixels(5 lines) failed");
+        errors ++;
+      }
+
+      header.cupsHeight = 640;
+    }
+
+    cupsRasterClose(r);
+  }
+
+  if (!errors)
+  {
+    if (output[0].used != output[1].used || memcmp(output[0].data, output[1].data, output[0].used))
+    {
+      testEndMessage(false, "%u bytes with threads, expected %u", (unsigned)output[1].used, (unsigned)output[0].used);
+      errors ++;
+    }
+    else
+      testEndMessage(true, "%u bytes", (unsigned)output[0].used);
+  }
+
+  free(output[0].data);
+  free(output[1].data);
+  free(data);
+
   return (errors);
 }
 
@@ -678,3 +1065,56 @@ print_changes(
   if (strcmp(header->cupsPageSizeName, expected->cupsPageSizeName))
     testError("    cupsPageSizeName (%s), expected (%s)", header->cupsPageSizeName, expected->cupsPageSizeName);
 }
+
+
+//
+// 'read_buffer()' - Read raster data from a memory buffer.
+//
+
+static ssize_t				// O - Bytes read
+read_buffer(test_buffer_t *bufptr,	// I - Memory buffer
+            unsigned char *buffer,	// I - Read buffer
+            size_t        length)	// I - Maximum number of bytes to read
+{
+  bufptr->calls ++;
+
+  if (length > (bufptr->used - bufptr->pos))
+    length = bufptr->used - bufptr->pos;
+
+  memcpy(buffer, bufptr->data + bufptr->pos, length);
+  bufptr->pos += length;
+
+  return ((ssize_t)length);
+}
+
+
+//
+// 'write_buffer()' - Write raster data to a memory buffer.
+//
+
+static ssize_t				// O - Bytes written or -1 on error
+write_buffer(test_buffer_t *bufptr,	// I - Memory buffer
+             unsigned char *buffer,	// I - Bytes to write
+             size_t        length)	// I - Number of bytes to write
+{
+  bufptr->calls ++;
+
+  if ((bufptr->used + length) > bufptr->alloc)
+  {
+    size_t	alloc = bufptr->alloc + length + 65536;
+					// New size
+    unsigned char *data = realloc(bufptr->data, alloc);
+					// New buffer
+
+    if (!data)
+      return (-1);
+
+    bufptr->data  = data;
+    bufptr->alloc = alloc;
+  }
+
+  memcpy(bufptr->data + bufptr->used, buffer, length);
+  bufptr->used += length;
+
+  return ((ssize_t)length);
+}
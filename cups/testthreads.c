@@ -10,16 +10,115 @@
 
 #include <stdio.h>
 #include <errno.h>
+#include <time.h>
+#include <unistd.h>
 #include <cups/cups.h>
 #include <cups/thread.h>
+#include "string-private.h"
+#include "test-internal.h"
+
+
+//
+// Local types...
+//
+
+typedef enum _scale_test_e		// Scaling benchmark workloads
+{
+  _SCALE_STRALLOC,			// _cupsStrAlloc/_cupsStrFree
+  _SCALE_IPP,				// ippNew/ippDelete churn
+  _SCALE_PWG,				// pwgMediaForPWG
+  _SCALE_LANG,				// cupsLangGetString
+  _SCALE_RAND,				// cupsGetRand
+  _SCALE_MAX
+} _scale_test_t;
+
+typedef struct _scale_data_s		// Scaling benchmark thread data
+{
+  _scale_test_t	test;			// Workload
+  double	end;			// End time
+  cups_lang_t	*lang;			// Language for cupsLangGetString
+  size_t	ops;			// Number of operations completed
+} _scale_data_t;
+
+
+//
+// Local globals...
+//
+
+static cups_atomic_t	atomic_count = 0;
+					// Atomic counter
+static cups_spinlock_t	spin_lock = CUPS_SPINLOCK_INITIALIZER;
+					// Lock for spin counter
+static size_t		spin_count = 0;	// Spin counter
+static cups_mutex_t	pool_mutex = CUPS_MUTEX_INITIALIZER;
+					// Mutex for pool counter
+static size_t		pool_count = 0;	// Number of pool functions run
+static cups_cond_t	pool_cond = CUPS_COND_INITIALIZER;
+					// Condition for blocking pool function
+static int		pool_state = 0;	// Blocking pool function state
+static cups_thread_pool_t *pool_tree = NULL;
+					// Pool for tree functions
+static const char * const scale_keywords[] =
+{					// Strings for workloads
+  "media",
+  "media-col",
+  "media-size",
+  "copies",
+  "sides",
+  "print-quality",
+  "printer-resolution",
+  "finishings"
+};
+static const char * const scale_media[] =
+{					// Media names for pwgMediaForPWG
+  "na_letter_8.5x11in",
+  "iso_a4_210x297mm",
+  "na_legal_8.5x14in",
+  "iso_a5_148x210mm",
+  "na_index-4x6_4x6in",
+  "jpn_hagaki_100x148mm",
+  "custom_oddball_100x200mm",
+  "iso_a3_297x420mm"
+};
+static const char * const scale_messages[] =
+{					// Messages for cupsLangGetString
+  "Idle",
+  "Printing",
+  "Stopped",
+  "Unknown",
+  "No request URI.",
+  "Bad request version.",
+  "Unable to open file.",
+  "Internal server error"
+};
+static const char * const scale_tests[] =
+{					// Workload names
+  "_cupsStrAlloc",
+  "ippNew/ippDelete",
+  "pwgMediaForPWG",
+  "cupsLangGetString",
+  "cupsGetRand"
+};
 
 
 //
 // Local functions...
 //
 
+static void	*atomic_func(void *data);
+static bool	atomic_test(void);
 static bool	enum_dests_cb(void *_name, unsigned flags, cups_dest_t *dest);
+static double	get_time(void);
+static bool	lock_stats_test(void);
+static void	*pool_block_func(void *data);
+static void	*pool_func(void *data);
+static bool	pool_test(size_t max_threads, size_t max_queue, size_t count);
+static void	*pool_tree_func(void *data);
+static bool	pool_tree_test(size_t max_threads, size_t max_queue, bool stealing, int depth);
+static bool	pool_try_test(void);
 static void	*run_query(cups_dest_t *dest);
+static void	*scale_func(_scale_data_t *data);
+static bool	scale_test(size_t max_threads, double duration);
 static void	show_supported(http_t *http, cups_dest_t *dest, cups_dinfo_t *dinfo, const char *option, const char *value);
 
 
@@ -31,15 +130,145 @@ int					// O - Exit status
 main(int  argc,				// I - Number of command-line arguments
      char *argv[])			// I - Command-line arguments
 {
-  // Go through all the available destinations to find the requested one...
-  (void)argc;
+  // Collect lock statistics for all of the tests...
+  setenv("CUPS_LOCK_STATS", "1", 1);
+  cupsMutexSetName(&pool_mutex, "pool_mutex");
 
+  if (argc > 1 && !strcmp(argv[1], "--scale"))
+  {
+    // Run the multi-core scaling benchmark...
+    int		i;			// Looping var
+    long	max_threads = 8;	// Maximum number of threads
+    double	duration = 1.0;		// Duration of each run
+
+#ifdef _SC_NPROCESSORS_ONLN
+    if ((max_threads = sysconf(_SC_NPROCESSORS_ONLN)) < 1)
+      max_threads = 8;
+#endif // _SC_NPROCESSORS_ONLN
+
+    for (i = 2; i < argc; i ++)
+    {
+      if (!strcmp(argv[i], "-n") && (i + 1) < argc && (max_threads = atol(argv[i + 1])) > 0)
+      {
+        i ++;
+      }
+      else if (!strcmp(argv[i], "-t") && (i + 1) < argc && (duration = atof(argv[i + 1])) > 0.0)
+      {
+        i ++;
+      }
+      else
+      {
+        puts("Usage: ./testthreads --scale [-n MAX-THREADS] [-t SECONDS]");
+        return (1);
+      }
+    }
+
+    return (scale_test((size_t)max_threads, duration) ? 0 : 1);
+  }
+
+  // Test atomics and spin locks...
+
+  if (!atomic_test())
+    return (1);
+
+  // Test thread pools...
+  if (!pool_test(1, 0, 10) || !pool_test(4, 0, 100) || !pool_test(4, 2, 100))
+    return (1);
+
+  if (!pool_tree_test(4, 0, false, 8) || !pool_tree_test(4, 0, true, 8) || !pool_tree_test(2, 2, true, 8) || !pool_tree_test(1, 1, false, 6))
+    return (1);
+
+  if (!pool_try_test())
+    return (1);
+
+  if (!lock_stats_test())
+    return (1);
+
+  // Go through all the available destinations to find the requested one...
   cupsEnumDests(CUPS_DEST_FLAGS_NONE, -1, NULL, 0, 0, enum_dests_cb, argv[1]);
 
   return (0);
 }
 
 
+//
+// 'atomic_func()' - Increment the atomic and spin counters.
+//
+
+static void *				// O - Return value (not used)
+atomic_func(void *data)			// I - Data (not used)
+{
+  int	i;				// Looping var
+
+
+  (void)data;
+
+  for (i = 0; i < 100000; i ++)
+  {
+    cupsAtomicInc(&atomic_count);
+
+    cupsSpinLock(&spin_lock);
+    spin_count ++;
+    cupsSpinUnlock(&spin_lock);
+  }
+
+  return (NULL);
+}
+
+
+//
+// 'atomic_test()' - Test atomic operations and spin locks.
+//
+
+static bool				// O - `true` on success, `false` on failure
+atomic_test(void)
+{
+  size_t	i;			// Looping var
+  cups_thread_t	threads[4];		// Threads
+  cups_atomic_t	value = 1;		// Atomic value
+
+
+  testBegin("cupsAtomicCAS/Dec/Get/Inc");
+  if (cupsAtomicInc(&value) != 2 || cupsAtomicDec(&value) != 1 || cupsAtomicDec(&value) != 0)
+  {
+    testEndMessage(false, "bad increment/decrement result");
+    return (false);
+  }
+  else if (cupsAtomicCAS(&value, 1, 2) || cupsAtomicGet(&value) != 0)
+  {
+    testEndMessage(false, "replaced unexpected value");
+    return (false);
+  }
+  else if (!cupsAtomicCAS(&value, 0, 42) || cupsAtomicGet(&value) != 42)
+  {
+    testEndMessage(false, "did not replace expected value");
+    return (false);
+  }
+  testEnd(true);
+
+  testBegin("cupsSpinLock/Unlock(4 threads)");
+  for (i = 0; i < (sizeof(threads) / sizeof(threads[0])); i ++)
+    threads[i] = cupsThreadCreate(atomic_func, NULL);
+
+  for (i = 0; i < (sizeof(threads) / sizeof(threads[0])); i ++)
+    cupsThreadWait(threads[i]);
+
+  if (cupsAtomicGet(&atomic_count) != 400000)
+  {
+    testEndMessage(false, "got atomic count %d, expected 400000", (int)cupsAtomicGet(&atomic_count));
+    return (false);
+  }
+  else if (spin_count != 400000)
+  {
+    testEndMessage(false, "got spin count %u, expected 400000", (unsigned)spin_count);
+    return (false);
+  }
+  testEnd(true);
+
+  return (true);
+}
+
+
 //
 // 'enum_dests_cb()' - Destination enumeration function...
 //
@@ -71,6 +300,319 @@ enum_dests_cb(void        *_name,	// I - Printer name, if any
 }
 
 
+//
+// 'get_time()' - Get the current time in seconds.
+//
+
+static double				// O - Time in seconds
+get_time(void)
+{
+  struct timespec	curtime;	// Current time
+
+
+  clock_gettime(CLOCK_MONOTONIC, &curtime);
+  return (curtime.tv_sec + 0.000000001 * curtime.tv_nsec);
+}
+
+
+//
+// 'lock_stats_test()' - Test lock statistics.
+//
+
+static bool				// O - `true` on success, `false` on failure
+lock_stats_test(void)
+{
+  cups_lock_stats_t	*stats,		// Lock statistics
+			*stat;		// Current statistics
+  size_t		i,		// Looping var
+			count,		// Number of locks
+			waits;		// Number of waits in histogram
+
+
+  testBegin("cupsThreadGetLockStats");
+  if ((count = cupsThreadGetLockStats(NULL, 0)) == 0)
+  {
+    testEndMessage(false, "no statistics");
+    return (false);
+  }
+
+  if ((stats = (cups_lock_stats_t *)calloc(count, sizeof(cups_lock_stats_t))) == NULL)
+  {
+    testEndMessage(false, "%s", strerror(errno));
+    return (false);
+  }
+
+  if (cupsThreadGetLockStats(stats, count) < count)
+  {
+    testEndMessage(false, "number of locks went down");
+    free(stats);
+    return (false);
+  }
+
+  for (i = count, stat = stats; i > 0; i --, stat ++)
+  {
+    if (stat->name && !strcmp(stat->name, "pool_mutex"))
+      break;
+  }
+
+  if (i == 0)
+  {
+    testEndMessage(false, "no statistics for pool_mutex");
+    free(stats);
+    return (false);
+  }
+
+  for (i = 0, waits = 0; i < CUPS_LOCK_STATS_BUCKETS; i ++)
+    waits += stat->waits[i];
+
+  if (stat->lock != &pool_mutex || stat->acquired < pool_count || stat->contended > stat->acquired || waits != stat->contended)
+  {
+    testEndMessage(false, "bad statistics for pool_mutex: lock=%p, acquired=%u, contended=%u, waits=%u", stat->lock, (unsigned)stat->acquired, (unsigned)stat->contended, (unsigned)waits);
+    free(stats);
+    return (false);
+  }
+
+  testEndMessage(true, "%u locks, pool_mutex acquired=%u, contended=%u, wait_time=%.6f", (unsigned)count, (unsigned)stat->acquired, (unsigned)stat->contended, stat->wait_time);
+  free(stats);
+
+  return (true);
+}
+
+
+//
+// 'pool_block_func()' - Block a thread pool worker until released.
+//
+
+static void *				// O - Return value (not used)
+pool_block_func(void *data)		// I - Data (not used)
+{
+  (void)data;
+
+  cupsMutexLock(&pool_mutex);
+  pool_state = 1;
+  cupsCondBroadcast(&pool_cond);
+  while (pool_state == 1)
+    cupsCondWait(&pool_cond, &pool_mutex, 0.0);
+  cupsMutexUnlock(&pool_mutex);
+
+  return (NULL);
+}
+
+
+//
+// 'pool_func()' - Count a thread pool function call.
+//
+
+static void *				// O - Return value (not used)
+pool_func(void *data)			// I - Data (not used)
+{
+  (void)data;
+
+  cupsMutexLock(&pool_mutex);
+  pool_count ++;
+  cupsMutexUnlock(&pool_mutex);
+
+  return (NULL);
+}
+
+
+//
+// 'pool_test()' - Run functions using a thread pool.
+//
+
+static bool				// O - `true` on success, `false` on failure
+pool_test(size_t max_threads,		// I - Maximum number of threads
+          size_t max_queue,		// I - Maximum number of queued functions
+          size_t count)			// I - Number of functions to run
+{
+  cups_thread_pool_t	*pool;		// Thread pool
+  size_t		i;		// Looping var
+
+
+  testBegin("cupsThreadPoolNew(%u, %u)", (unsigned)max_threads, (unsigned)max_queue);
+  if ((pool = cupsThreadPoolNew(max_threads, max_queue)) == NULL)
+  {
+    testEndMessage(false, "%s", strerror(errno));
+    return (false);
+  }
+  testEnd(true);
+
+  pool_count = 0;
+
+  testBegin("cupsThreadPoolAdd(%u functions)", (unsigned)count);
+  for (i = 0; i < count; i ++)
+  {
+    if (!cupsThreadPoolAdd(pool, pool_func, NULL))
+    {
+      testEndMessage(false, "%s", strerror(errno));
+      cupsThreadPoolDelete(pool);
+      return (false);
+    }
+  }
+  testEnd(true);
+
+  testBegin("cupsThreadPoolWait");
+  cupsThreadPoolWait(pool);
+  cupsMutexLock(&pool_mutex);
+  i = pool_count;
+  cupsMutexUnlock(&pool_mutex);
+  if (i != count)
+  {
+    testEndMessage(false, "got %u calls, expected %u", (unsigned)i, (unsigned)count);
+    cupsThreadPoolDelete(pool);
+    return (false);
+  }
+  testEnd(true);
+
+  cupsThreadPoolDelete(pool);
+
+  return (true);
+}
+
+
+//
+// 'pool_tree_func()' - Count a call and queue two more until the depth is 0.
+//
+
+static void *				// O - Return value (not used)
+pool_tree_func(void *data)		// I - Depth
+{
+  intptr_t	depth = (intptr_t)data;	// Depth
+
+
+  pool_func(NULL);
+
+  if (depth > 0)
+  {
+    cupsThreadPoolAdd(pool_tree, pool_tree_func, (void *)(depth - 1));
+    cupsThreadPoolAdd(pool_tree, pool_tree_func, (void *)(depth - 1));
+  }
+
+  return (NULL);
+}
+
+
+//
+// 'pool_tree_test()' - Run nested functions using a thread pool.
+//
+
+static bool				// O - `true` on success, `false` on failure
+pool_tree_test(size_t max_threads,	// I - Maximum number of threads
+               size_t max_queue,	// I - Maximum number of queued functions
+               bool   stealing,		// I - Enable work stealing?
+               int    depth)		// I - Depth of tree
+{
+  size_t	count,			// Number of calls
+		expected = ((size_t)2 << depth) - 1;
+					// Expected number of calls
+
+
+  testBegin("cupsThreadPoolAdd(%u, %u, stealing=%s, depth=%d)", (unsigned)max_threads, (unsigned)max_queue, stealing ? "true" : "false", depth);
+  if ((pool_tree = cupsThreadPoolNew(max_threads, max_queue)) == NULL)
+  {
+    testEndMessage(false, "%s", strerror(errno));
+    return (false);
+  }
+
+  cupsThreadPoolSetStealing(pool_tree, stealing);
+
+  pool_count = 0;
+
+  if (!cupsThreadPoolAdd(pool_tree, pool_tree_func, (void *)(intptr_t)depth))
+  {
+    testEndMessage(false, "%s", strerror(errno));
+    cupsThreadPoolDelete(pool_tree);
+    return (false);
+  }
+
+  cupsThreadPoolWait(pool_tree);
+  cupsMutexLock(&pool_mutex);
+  count = pool_count;
+  cupsMutexUnlock(&pool_mutex);
+
+  cupsThreadPoolDelete(pool_tree);
+  pool_tree = NULL;
+
+  if (count != expected)
+  {
+    testEndMessage(false, "got %u calls, expected %u", (unsigned)count, (unsigned)expected);
+    return (false);
+  }
+
+  testEnd(true);
+
+  return (true);
+}
+
+
+//
+// 'pool_try_test()' - Test non-blocking queuing with a full thread pool.
+//
+
+static bool				// O - `true` on success, `false` on failure
+pool_try_test(void)
+{
+  cups_thread_pool_t	*pool;		// Thread pool
+  bool			ret = true;	// Return value
+
+
+  testBegin("cupsThreadPoolTryAdd");
+  if ((pool = cupsThreadPoolNew(1, 1)) == NULL)
+  {
+    testEndMessage(false, "%s", strerror(errno));
+    return (false);
+  }
+
+  pool_count = 0;
+  pool_state = 0;
+
+  // Block the only worker...
+  cupsThreadPoolAdd(pool, pool_block_func, NULL);
+
+  cupsMutexLock(&pool_mutex);
+  while (pool_state == 0)
+    cupsCondWait(&pool_cond, &pool_mutex, 0.0);
+  cupsMutexUnlock(&pool_mutex);
+
+  // Then fill the queue...
+  if (!cupsThreadPoolTryAdd(pool, pool_func, NULL))
+  {
+    testEndMessage(false, "unable to queue function: %s", strerror(errno));
+    ret = false;
+  }
+  else if (cupsThreadPoolTryAdd(pool, pool_func, NULL))
+  {
+    testEndMessage(false, "queued function with a full queue");
+    ret = false;
+  }
+  else if (errno != EAGAIN)
+  {
+    testEndMessage(false, "got '%s', expected EAGAIN", strerror(errno));
+    ret = false;
+  }
+
+  cupsMutexLock(&pool_mutex);
+  pool_state = 2;
+  cupsCondBroadcast(&pool_cond);
+  cupsMutexUnlock(&pool_mutex);
+
+  cupsThreadPoolWait(pool);
+  cupsThreadPoolDelete(pool);
+
+  if (ret && pool_count != 1)
+  {
+    testEndMessage(false, "got %u calls, expected 1", (unsigned)pool_count);
+    ret = false;
+  }
+  else if (ret)
+  {
+    testEnd(true);
+  }
+
+  return (ret);
+}
+
+
 //
 // 'run_query()' - Query printer capabilities on a separate thread.
 //
@@ -104,6 +646,197 @@ run_query(cups_dest_t *dest)		// I - Destination to query
 }
 
 
+//
+// 'scale_func()' - Run a scaling benchmark workload until the end time.
+//
+
+static void *				// O - Return value (not used)
+scale_func(_scale_data_t *data)		// I - Thread data
+{
+  size_t	i;			// Looping var
+  ipp_t		*ipp;			// IPP message
+  static const char * const requested[] =
+  {					// requested-attributes values
+    "media-col-database",
+    "media-supported",
+    "printer-state"
+  };
+
+
+  do
+  {
+    // Check the time every 64 operations...
+    for (i = 0; i < 64; i ++)
+    {
+      switch (data->test)
+      {
+        case _SCALE_STRALLOC :
+            _cupsStrFree(_cupsStrAlloc(scale_keywords[i & 7]));
+            break;
+
+        case _SCALE_IPP :
+            ipp = ippNewRequest(IPP_OP_GET_PRINTER_ATTRIBUTES);
+            ippAddString(ipp, IPP_TAG_OPERATION, IPP_TAG_URI, "printer-uri", NULL, "ipp://localhost/ipp/print");
+            ippAddString(ipp, IPP_TAG_OPERATION, IPP_TAG_NAME, "requesting-user-name", NULL, "user");
+            ippAddStrings(ipp, IPP_TAG_OPERATION, IPP_TAG_KEYWORD, "requested-attributes", sizeof(requested) / sizeof(requested[0]), NULL, requested);
+            ippDelete(ipp);
+            break;
+
+        case _SCALE_PWG :
+            pwgMediaForPWG(scale_media[i & 7]);
+            break;
+
+        case _SCALE_LANG :
+            cupsLangGetString(data->lang, scale_messages[i & 7]);
+            break;
+
+        default :
+            cupsGetRand();
+            break;
+      }
+    }
+
+    data->ops += i;
+  }
+  while (get_time() < data->end);
+
+  return (NULL);
+}
+
+
+//
+// 'scale_test()' - Run the multi-core scaling benchmark.
+//
+// Each workload is run with 1, 2, 4, ... up to the maximum number of threads,
+// and the operations per second are reported along with the lock that was
+// contended the most during the run.
+//
+
+static bool				// O - `true` on success, `false` on failure
+scale_test(size_t max_threads,		// I - Maximum number of threads
+           double duration)		// I - Duration of each run
+{
+  size_t		i,		// Looping var
+			num_threads,	// Number of threads
+			ops,		// Total operations
+			num_before,	// Number of locks before run
+			num_after,	// Number of locks after run
+			contended,	// Contended acquisitions during run
+			top_contended;	// Contended acquisitions for top lock
+  const char		*top_name;	// Name of top lock
+  _scale_test_t		test;		// Current workload
+  _scale_data_t		*data;		// Thread data
+  cups_thread_t		*threads;	// Threads
+  cups_lock_stats_t	*before,	// Lock statistics before run
+			*after,		// Lock statistics after run
+			*stat,		// Current lock after run
+			*bstat;		// Current lock before run
+  cups_lang_t		*lang;		// Language for cupsLangGetString
+  char			*strs[8];	// Strings held for _cupsStrAlloc
+  double		rate,		// Operations per second
+			rate1 = 0.0;	// Operations per second with one thread
+
+
+  data    = (_scale_data_t *)calloc(max_threads, sizeof(_scale_data_t));
+  threads = (cups_thread_t *)calloc(max_threads, sizeof(cups_thread_t));
+  before  = (cups_lock_stats_t *)calloc(512, sizeof(cups_lock_stats_t));
+  after   = (cups_lock_stats_t *)calloc(512, sizeof(cups_lock_stats_t));
+
+  if (!data || !threads || !before || !after)
+  {
+    perror("testthreads: Unable to allocate memory");
+    return (false);
+  }
+
+  // Hold a reference to the strings so that the workload measures lookups
+  // rather than allocations...
+  for (i = 0; i < (sizeof(strs) / sizeof(strs[0])); i ++)
+    strs[i] = _cupsStrAlloc(scale_keywords[i]);
+
+  lang = cupsLangDefault();
+
+  printf("%-20s %7s %12s %12s %7s %10s  %s\n", "Test", "Threads", "Ops/sec", "Ops/sec/thr", "Scaling", "Contended", "Top Lock");
+
+  for (test = _SCALE_STRALLOC; test < _SCALE_MAX; test ++)
+  {
+    for (num_threads = 1;; num_threads *= 2)
+    {
+      if (num_threads > max_threads)
+        num_threads = max_threads;
+
+      num_before = cupsThreadGetLockStats(before, 512);
+
+      for (i = 0; i < num_threads; i ++)
+      {
+        data[i].test = test;
+        data[i].end  = get_time() + duration;
+        data[i].lang = lang;
+        data[i].ops  = 0;
+
+        if ((threads[i] = cupsThreadCreate((cups_thread_func_t)scale_func, data + i)) == CUPS_THREAD_INVALID)
+        {
+          perror("testthreads: Unable to create thread");
+          return (false);
+        }
+      }
+
+      for (i = 0, ops = 0; i < num_threads; i ++)
+      {
+        cupsThreadWait(threads[i]);
+        ops += data[i].ops;
+      }
+
+      // Find the lock that was contended the most...
+      num_after     = cupsThreadGetLockStats(after, 512);
+      contended     = 0;
+      top_contended = 0;
+      top_name      = "-";
+
+      for (i = 0, stat = after; i < num_after && i < 512; i ++, stat ++)
+      {
+        size_t	count = stat->contended;// Contended acquisitions during run
+
+        for (bstat = before; bstat < (before + num_before) && bstat < (before + 512); bstat ++)
+        {
+          if (bstat->lock == stat->lock)
+          {
+            count -= bstat->contended;
+            break;
+          }
+        }
+
+        contended += count;
+
+        if (count > top_contended)
+        {
+          top_contended = count;
+          top_name      = stat->name ? stat->name : "(unnamed)";
+        }
+      }
+
+      rate = ops / duration;
+
+      if (num_threads == 1)
+        rate1 = rate;
+
+      printf("%-20s %7u %12.0f %12.0f %7.2f %10u  %s\n", scale_tests[test], (unsigned)num_threads, rate, rate / num_threads, rate1 > 0.0 ? rate / rate1 : 0.0, (unsigned)contended, top_name);
+
+      if (num_threads == max_threads)
+        break;
+    }
+  }
+
+  for (i = 0; i < (sizeof(strs) / sizeof(strs[0])); i ++)
+    _cupsStrFree(strs[i]);
+
+  free(data);
+  free(threads);
+  free(before);
+  free(after);
+
+  return (true);
+}
+
 
 //
 // 'show_supported()' - Show supported options, values, etc.
@@ -12,12 +12,59 @@
 #include "thread.h"
 
 
+//
+// Local constants...
+//
+
+#define _CUPS_LOCK_STATS_HASH	1024	// Size of lock statistics hash table
+#define _CUPS_LOCK_STATS_MAX	512	// Maximum number of locks with statistics
+#define _CUPS_SPIN_COUNT	100	// Number of times to spin before parking
+
+
+//
+// Local types...
+//
+
+typedef struct _cups_lstats_s		// Lock statistics entry
+{
+  cups_spinlock_t	spinlock;	// Lock for statistics
+  cups_lock_stats_t	stats;		// Statistics
+} _cups_lstats_t;
+
+
+//
+// Local globals...
+//
+
+static cups_atomic_t	lock_stats_count = 0;
+					// Number of locks with statistics
+static cups_atomic_t	lock_stats_hash[_CUPS_LOCK_STATS_HASH];
+					// Hash table of statistics (index + 1)
+static cups_spinlock_t	lock_stats_lock = CUPS_SPINLOCK_INITIALIZER;
+					// Lock for adding statistics
+static cups_atomic_t	lock_stats_state = 0;
+					// 0 = unknown, 1 = disabled, 2 = enabled
+static _cups_lstats_t	lock_stats[_CUPS_LOCK_STATS_MAX];
+					// Lock statistics
+
+
+//
+// Local functions...
+//
+
+static void		lock_stats_add(const void *lock, double start);
+static bool		lock_stats_enabled(void);
+static _cups_lstats_t	*lock_stats_find(const void *lock);
+static double		lock_stats_time(void);
+
+
 //
 // Windows threading...
 //
 
 #if _WIN32
 #  include <setjmp.h>
+#  include <synchapi.h>
 
 
 //
@@ -45,6 +92,54 @@ static DWORD		win32_tls(void);
 static int		win32_wrapper(cups_thread_t thread);
 
 
+//
+// 'cupsAtomicCAS()' - Atomically replace a value if it has not changed.
+//
+// This function stores "newval" in "value" if the current value is "oldval".
+//
+
+bool					// O - `true` if replaced, `false` otherwise
+cupsAtomicCAS(cups_atomic_t *value,	// I - Atomic value
+              cups_atomic_t oldval,	// I - Expected value
+              cups_atomic_t newval)	// I - New value
+{
+  return (InterlockedCompareExchange(value, newval, oldval) == oldval);
+}
+
+
+//
+// 'cupsAtomicDec()' - Atomically decrement a value.
+//
+
+cups_atomic_t				// O - New value
+cupsAtomicDec(cups_atomic_t *value)	// I - Atomic value
+{
+  return (InterlockedDecrement(value));
+}
+
+
+//
+// 'cupsAtomicGet()' - Atomically get a value.
+//
+
+cups_atomic_t				// O - Current value
+cupsAtomicGet(cups_atomic_t *value)	// I - Atomic value
+{
+  return (InterlockedCompareExchange(value, 0, 0));
+}
+
+
+//
+// 'cupsAtomicInc()' - Atomically increment a value.
+//
+
+cups_atomic_t				// O - New value
+cupsAtomicInc(cups_atomic_t *value)	// I - Atomic value
+{
+  return (InterlockedIncrement(value));
+}
+
+
 //
 // 'cupsCondBroadcast()' - Wake up waiting threads.
 //
@@ -131,8 +226,26 @@ cupsMutexInit(cups_mutex_t *mutex)	// I - Mutex
 void
 cupsMutexLock(cups_mutex_t *mutex)	// I - Mutex
 {
-  if (mutex)
+  if (!mutex)
+  {
+    return;
+  }
+  else if (lock_stats_enabled())
+  {
+    double	start = 0.0;		// Start of wait
+
+    if (!TryEnterCriticalSection(mutex))
+    {
+      start = lock_stats_time();
+      EnterCriticalSection(mutex);
+    }
+
+    lock_stats_add(mutex, start);
+  }
+  else
+  {
     EnterCriticalSection(mutex);
+  }
 }
 
 
@@ -178,8 +291,26 @@ cupsRWInit(cups_rwlock_t *rwlock)	// I - Reader/writer lock
 void
 cupsRWLockRead(cups_rwlock_t *rwlock)	// I - Reader/writer lock
 {
-  if (rwlock)
+  if (!rwlock)
+  {
+    return;
+  }
+  else if (lock_stats_enabled())
+  {
+    double	start = 0.0;		// Start of wait
+
+    if (!TryAcquireSRWLockShared(rwlock))
+    {
+      start = lock_stats_time();
+      AcquireSRWLockShared(rwlock);
+    }
+
+    lock_stats_add(rwlock, start);
+  }
+  else
+  {
     AcquireSRWLockShared(rwlock);
+  }
 }
 
 
@@ -190,8 +321,26 @@ cupsRWLockRead(cups_rwlock_t *rwlock)	// I - Reader/writer lock
 void
 cupsRWLockWrite(cups_rwlock_t *rwlock)// I - Reader/writer lock
 {
-  if (rwlock)
+  if (!rwlock)
+  {
+    return;
+  }
+  else if (lock_stats_enabled())
+  {
+    double	start = 0.0;		// Start of wait
+
+    if (!TryAcquireSRWLockExclusive(rwlock))
+    {
+      start = lock_stats_time();
+      AcquireSRWLockExclusive(rwlock);
+    }
+
+    lock_stats_add(rwlock, start);
+  }
+  else
+  {
     AcquireSRWLockExclusive(rwlock);
+  }
 }
 
 
@@ -214,6 +363,48 @@ cupsRWUnlock(cups_rwlock_t *rwlock)	// I - Reader/writer lock
 }
 
 
+//
+// 'cupsSpinLock()' - Acquire a spin-then-park lock.
+//
+// This function spins briefly waiting for the lock and then sleeps until it is
+// released.  Spin locks are intended for short critical sections and are not
+// recursive.
+//
+
+void
+cupsSpinLock(cups_spinlock_t *lock)	// I - Spin lock
+{
+  int		i;			// Looping var
+  cups_atomic_t	locked = 2;		// Locked with waiters
+
+
+  // Spin briefly (0 = unlocked, 1 = locked, 2 = locked with waiters)...
+  for (i = 0; i < _CUPS_SPIN_COUNT; i ++)
+  {
+    if (*lock == 0 && InterlockedCompareExchange(lock, 1, 0) == 0)
+      return;
+
+    YieldProcessor();
+  }
+
+  // Then wait until unlocked...
+  while (InterlockedExchange(lock, 2) != 0)
+    WaitOnAddress(lock, &locked, sizeof(cups_atomic_t), INFINITE);
+}
+
+
+//
+// 'cupsSpinUnlock()' - Release a spin-then-park lock.
+//
+
+void
+cupsSpinUnlock(cups_spinlock_t *lock)	// I - Spin lock
+{
+  if (InterlockedExchange(lock, 0) == 2)
+    WakeByAddressSingle((PVOID)lock);
+}
+
+
 //
 // 'cupsThreadCancel()' - Cancel (kill) a thread.
 //
@@ -241,7 +432,7 @@ cupsThreadCreate(
   if (!func)
     return (CUPS_THREAD_INVALID);
 
-  if ((thread = (cups_thread_t)calloc(1, sizeof(struct _cups_thread_s))) == NULL)
+  if ((thread = (cups_thread_t)_cupsMemCalloc(CUPS_MEMTYPE_OTHER, 1, sizeof(struct _cups_thread_s))) == NULL)
     return (CUPS_THREAD_INVALID);
 
   thread->func = func;
@@ -250,7 +441,7 @@ cupsThreadCreate(
 
   if (thread->h == 0 || thread->h == (HANDLE)-1)
   {
-    free(thread);
+    _cupsMemFree(thread);
     return (CUPS_THREAD_INVALID);
   }
 
@@ -296,7 +487,7 @@ cupsThreadWait(cups_thread_t thread)	// I - Thread ID
 
   retval = thread->retval;
 
-  free(thread);
+  _cupsMemFree(thread);
 
   return (retval);
 }
@@ -315,7 +506,7 @@ win32_self(void)
   if ((thread = TlsGetValue(win32_tls())) == NULL)
   {
     // Main thread, so create the info we need...
-    if ((thread = (cups_thread_t)calloc(1, sizeof(struct _cups_thread_s))) != NULL)
+    if ((thread = (cups_thread_t)_cupsMemCalloc(CUPS_MEMTYPE_OTHER, 1, sizeof(struct _cups_thread_s))) != NULL)
     {
       thread->h = GetCurrentThread();
       TlsSetValue(win32_tls(), thread);
@@ -323,7 +514,7 @@ win32_self(void)
       if (setjmp(thread->jumpbuf))
       {
         if (!thread->h)
-          free(thread);
+          _cupsMemFree(thread);
 
         _endthreadex(0);
       }
@@ -399,7 +590,7 @@ win32_wrapper(cups_thread_t thread)	// I - Thread
 
   // Free if detached...
   if (!thread->h)
-    free(thread);
+    _cupsMemFree(thread);
 
   return (0);
 }
@@ -410,6 +601,70 @@ win32_wrapper(cups_thread_t thread)	// I - Thread
 // POSIX threading...
 //
 
+#  ifdef __linux
+#    include <linux/futex.h>
+#    include <sys/syscall.h>
+#    include <unistd.h>
+#  else
+#    include <sched.h>
+#  endif // __linux
+#  if defined(__x86_64__) || defined(__i386__)
+#    define _CUPS_SPIN_PAUSE() __builtin_ia32_pause()
+#  elif defined(__aarch64__)
+#    define _CUPS_SPIN_PAUSE() __asm__ __volatile__("yield")
+#  else
+#    define _CUPS_SPIN_PAUSE()
+#  endif // __x86_64__ || __i386__
+
+
+//
+// 'cupsAtomicCAS()' - Atomically replace a value if it has not changed.
+//
+// This function stores "newval" in "value" if the current value is "oldval".
+//
+
+bool					// O - `true` if replaced, `false` otherwise
+cupsAtomicCAS(cups_atomic_t *value,	// I - Atomic value
+              cups_atomic_t oldval,	// I - Expected value
+              cups_atomic_t newval)	// I - New value
+{
+  return (__atomic_compare_exchange_n(value, &oldval, newval, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST));
+}
+
+
+//
+// 'cupsAtomicDec()' - Atomically decrement a value.
+//
+
+cups_atomic_t				// O - New value
+cupsAtomicDec(cups_atomic_t *value)	// I - Atomic value
+{
+  return (__atomic_sub_fetch(value, 1, __ATOMIC_SEQ_CST));
+}
+
+
+//
+// 'cupsAtomicGet()' - Atomically get a value.
+//
+
+cups_atomic_t				// O - Current value
+cupsAtomicGet(cups_atomic_t *value)	// I - Atomic value
+{
+  return (__atomic_load_n(value, __ATOMIC_SEQ_CST));
+}
+
+
+//
+// 'cupsAtomicInc()' - Atomically increment a value.
+//
+
+cups_atomic_t				// O - New value
+cupsAtomicInc(cups_atomic_t *value)	// I - Atomic value
+{
+  return (__atomic_add_fetch(value, 1, __ATOMIC_SEQ_CST));
+}
+
+
 //
 // 'cupsCondBroadcast()' - Wake up waiting threads.
 //
@@ -503,7 +758,22 @@ cupsMutexInit(cups_mutex_t *mutex)	// I - Mutex
 void
 cupsMutexLock(cups_mutex_t *mutex)	// I - Mutex
 {
-  pthread_mutex_lock(mutex);
+  if (lock_stats_enabled())
+  {
+    double	start = 0.0;		// Start of wait
+
+    if (pthread_mutex_trylock(mutex))
+    {
+      start = lock_stats_time();
+      pthread_mutex_lock(mutex);
+    }
+
+    lock_stats_add(mutex, start);
+  }
+  else
+  {
+    pthread_mutex_lock(mutex);
+  }
 }
 
 
@@ -547,7 +817,22 @@ cupsRWInit(cups_rwlock_t *rwlock)	// I - Reader/writer lock
 void
 cupsRWLockRead(cups_rwlock_t *rwlock)	// I - Reader/writer lock
 {
-  pthread_rwlock_rdlock(rwlock);
+  if (lock_stats_enabled())
+  {
+    double	start = 0.0;		// Start of wait
+
+    if (pthread_rwlock_tryrdlock(rwlock))
+    {
+      start = lock_stats_time();
+      pthread_rwlock_rdlock(rwlock);
+    }
+
+    lock_stats_add(rwlock, start);
+  }
+  else
+  {
+    pthread_rwlock_rdlock(rwlock);
+  }
 }
 
 
@@ -558,7 +843,22 @@ cupsRWLockRead(cups_rwlock_t *rwlock)	// I - Reader/writer lock
 void
 cupsRWLockWrite(cups_rwlock_t *rwlock)// I - Reader/writer lock
 {
-  pthread_rwlock_wrlock(rwlock);
+  if (lock_stats_enabled())
+  {
+    double	start = 0.0;		// Start of wait
+
+    if (pthread_rwlock_trywrlock(rwlock))
+    {
+      start = lock_stats_time();
+      pthread_rwlock_wrlock(rwlock);
+    }
+
+    lock_stats_add(rwlock, start);
+  }
+  else
+  {
+    pthread_rwlock_wrlock(rwlock);
+  }
 }
 
 
@@ -573,6 +873,60 @@ cupsRWUnlock(cups_rwlock_t *rwlock)	// I - Reader/writer lock
 }
 
 
+//
+// 'cupsSpinLock()' - Acquire a spin-then-park lock.
+//
+// This function spins briefly waiting for the lock and then sleeps until it is
+// released.  Spin locks are intended for short critical sections and are not
+// recursive.
+//
+
+void
+cupsSpinLock(cups_spinlock_t *lock)	// I - Spin lock
+{
+  int		i;			// Looping var
+  cups_atomic_t	unlocked;		// Expected unlocked value
+
+
+  // Spin briefly (0 = unlocked, 1 = locked, 2 = locked with waiters)...
+  for (i = 0; i < _CUPS_SPIN_COUNT; i ++)
+  {
+    unlocked = 0;
+
+    if (__atomic_load_n(lock, __ATOMIC_RELAXED) == 0 && __atomic_compare_exchange_n(lock, &unlocked, 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+      return;
+
+    _CUPS_SPIN_PAUSE();
+  }
+
+  // Then wait until unlocked...
+  while (__atomic_exchange_n(lock, 2, __ATOMIC_ACQUIRE) != 0)
+  {
+#  ifdef __linux
+    syscall(SYS_futex, lock, FUTEX_WAIT_PRIVATE, 2, NULL, NULL, 0);
+#  else
+    sched_yield();
+#  endif // __linux
+  }
+}
+
+
+//
+// 'cupsSpinUnlock()' - Release a spin-then-park lock.
+//
+
+void
+cupsSpinUnlock(cups_spinlock_t *lock)	// I - Spin lock
+{
+#  ifdef __linux
+  if (__atomic_exchange_n(lock, 0, __ATOMIC_RELEASE) == 2)
+    syscall(SYS_futex, lock, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+#  else
+  __atomic_store_n(lock, 0, __ATOMIC_RELEASE);
+#  endif // __linux
+}
+
+
 //
 // 'cupsThreadCancel()' - Cancel (kill) a thread.
 //
@@ -630,3 +984,713 @@ cupsThreadWait(cups_thread_t thread)	// I - Thread ID
     return (ret);
 }
 #endif // _WIN32
+
+
+//
+// Lock statistics...
+//
+
+//
+// 'cupsMutexSetName()' - Set the name of a mutex for lock statistics.
+//
+// This function associates a name with a mutex for the statistics returned by
+// @link cupsThreadGetLockStats@.  The "name" string must remain valid for the
+// life of the program.  Nothing is recorded unless lock statistics are
+// enabled.
+//
+
+void
+cupsMutexSetName(cups_mutex_t *mutex,	// I - Mutex
+                 const char   *name)	// I - Name of mutex
+{
+  _cups_lstats_t	*ls;		// Lock statistics
+
+
+  if (mutex && lock_stats_enabled() && (ls = lock_stats_find(mutex)) != NULL)
+  {
+    cupsSpinLock(&ls->spinlock);
+    ls->stats.name = name;
+    cupsSpinUnlock(&ls->spinlock);
+  }
+}
+
+
+//
+// 'cupsRWSetName()' - Set the name of a reader/writer lock for lock statistics.
+//
+// This function associates a name with a reader/writer lock for the statistics
+// returned by @link cupsThreadGetLockStats@.  The "name" string must remain
+// valid for the life of the program.  Nothing is recorded unless lock
+// statistics are enabled.
+//
+
+void
+cupsRWSetName(cups_rwlock_t *rwlock,	// I - Reader/writer lock
+              const char    *name)	// I - Name of lock
+{
+  _cups_lstats_t	*ls;		// Lock statistics
+
+
+  if (rwlock && lock_stats_enabled() && (ls = lock_stats_find(rwlock)) != NULL)
+  {
+    cupsSpinLock(&ls->spinlock);
+    ls->stats.name = name;
+    cupsSpinUnlock(&ls->spinlock);
+  }
+}
+
+
+//
+// 'cupsThreadGetLockStats()' - Get lock contention statistics.
+//
+// This function copies up to "max_stats" lock statistics to "stats" and
+// returns the total number of locks with statistics.  Statistics are only
+// collected when the `CUPS_LOCK_STATS` environment variable is set to a
+// non-zero value, in which case @link cupsMutexLock@, @link cupsRWLockRead@,
+// and @link cupsRWLockWrite@ record the number of acquisitions, contended
+// acquisitions, and a histogram of wait times for each lock.  Locks can be
+// named using the @link cupsMutexSetName@ and @link cupsRWSetName@ functions.
+//
+
+size_t					// O - Number of locks with statistics
+cupsThreadGetLockStats(
+    cups_lock_stats_t *stats,		// I - Array for statistics or `NULL`
+    size_t            max_stats)	// I - Size of array
+{
+  size_t	i,			// Looping var
+		count;			// Number of locks
+
+
+  if (!lock_stats_enabled())
+    return (0);
+
+  count = (size_t)cupsAtomicGet(&lock_stats_count);
+
+  for (i = 0; stats && i < count && i < max_stats; i ++)
+  {
+    cupsSpinLock(&lock_stats[i].spinlock);
+    stats[i] = lock_stats[i].stats;
+    cupsSpinUnlock(&lock_stats[i].spinlock);
+  }
+
+  return (count);
+}
+
+
+//
+// 'lock_stats_add()' - Record a lock acquisition.
+//
+// The "start" argument is the time when the thread started waiting for the
+// lock or `0.0` if the lock was acquired without waiting.
+//
+
+static void
+lock_stats_add(const void *lock,	// I - Lock
+               double     start)	// I - Start of wait or `0.0` for none
+{
+  _cups_lstats_t	*ls;		// Lock statistics
+  double		wait = 0.0;	// Wait time in seconds
+  size_t		bucket = 0;	// Histogram bucket
+
+
+  if ((ls = lock_stats_find(lock)) == NULL)
+    return;
+
+  if (start > 0.0)
+  {
+    double usecs;			// Wait time in microseconds
+
+    wait  = lock_stats_time() - start;
+    usecs = wait * 1000000.0;
+
+    while (bucket < (CUPS_LOCK_STATS_BUCKETS - 1) && usecs >= (double)(1 << bucket))
+      bucket ++;
+  }
+
+  cupsSpinLock(&ls->spinlock);
+
+  ls->stats.acquired ++;
+
+  if (start > 0.0)
+  {
+    ls->stats.contended ++;
+    ls->stats.wait_time += wait;
+    ls->stats.waits[bucket] ++;
+  }
+
+  cupsSpinUnlock(&ls->spinlock);
+}
+
+
+//
+// 'lock_stats_enabled()' - Determine whether lock statistics are enabled.
+//
+
+static bool				// O - `true` if enabled, `false` otherwise
+lock_stats_enabled(void)
+{
+  cups_atomic_t	state;			// Current state
+
+
+  if ((state = cupsAtomicGet(&lock_stats_state)) == 0)
+  {
+    const char *value = getenv("CUPS_LOCK_STATS");
+					// Environment variable
+
+    state = (value && *value && strcmp(value, "0")) ? 2 : 1;
+
+    cupsAtomicCAS(&lock_stats_state, 0, state);
+  }
+
+  return (state == 2);
+}
+
+
+//
+// 'lock_stats_find()' - Find or add the statistics for a lock.
+//
+
+static _cups_lstats_t *			// O - Lock statistics or `NULL` if the table is full
+lock_stats_find(const void *lock)	// I - Lock
+{
+  size_t	i,			// Current hash table entry
+		count;			// Number of entries to check
+  cups_atomic_t	index;			// Statistics index + 1
+
+
+  for (i = (((size_t)lock >> 4) * 2654435761U) % _CUPS_LOCK_STATS_HASH, count = _CUPS_LOCK_STATS_HASH; count > 0; i = (i + 1) % _CUPS_LOCK_STATS_HASH, count --)
+  {
+    if ((index = cupsAtomicGet(lock_stats_hash + i)) == 0)
+    {
+      // Add statistics for this lock, checking that another thread hasn't just
+      // done so...
+      cupsSpinLock(&lock_stats_lock);
+
+      if ((index = cupsAtomicGet(lock_stats_hash + i)) == 0)
+      {
+        if ((index = cupsAtomicGet(&lock_stats_count)) >= _CUPS_LOCK_STATS_MAX)
+        {
+          cupsSpinUnlock(&lock_stats_lock);
+          return (NULL);
+        }
+
+        lock_stats[index].stats.lock = lock;
+
+        cupsAtomicInc(&lock_stats_count);
+        cupsAtomicCAS(lock_stats_hash + i, 0, ++ index);
+      }
+
+      cupsSpinUnlock(&lock_stats_lock);
+    }
+
+    if (lock_stats[index - 1].stats.lock == lock)
+      return (lock_stats + index - 1);
+  }
+
+  return (NULL);
+}
+
+
+//
+// 'lock_stats_time()' - Get the current time in seconds.
+//
+
+static double				// O - Time in seconds
+lock_stats_time(void)
+{
+#ifdef CLOCK_MONOTONIC
+  struct timespec	curtime;	// Current time
+
+
+  clock_gettime(CLOCK_MONOTONIC, &curtime);
+  return (curtime.tv_sec + 0.000000001 * curtime.tv_nsec);
+
+#else
+  struct timeval	curtime;	// Current time
+
+
+  gettimeofday(&curtime, NULL);
+  return (curtime.tv_sec + 0.000001 * curtime.tv_usec);
+#endif // CLOCK_MONOTONIC
+}
+
+
+//
+// Thread pools...
+//
+
+typedef struct _cups_tpwork_s		// Queued work
+{
+  cups_thread_func_t	func;		// Function to call
+  void			*arg;		// Argument for function
+} _cups_tpwork_t;
+
+typedef struct _cups_tpqueue_s		// Work queue (ring buffer)
+{
+  size_t		num_work,	// Number of queued items
+			alloc_work,	// Allocated queue items
+			first_work;	// First queued item
+  _cups_tpwork_t	*work;		// Queued items
+} _cups_tpqueue_t;
+
+typedef struct _cups_tpworker_s		// Worker thread
+{
+  cups_thread_pool_t	*pool;		// Thread pool
+  cups_thread_t		thread;		// Thread
+  _cups_tpqueue_t	queue;		// Local work queue
+} _cups_tpworker_t;
+
+struct _cups_thread_pool_s		// Pool of worker threads
+{
+  cups_mutex_t		mutex;		// Mutex for pool
+  cups_cond_t		work_cond,	// Condition for queued work
+			done_cond;	// Condition for dequeued/finished work
+  size_t		max_threads,	// Maximum number of worker threads
+			num_threads,	// Number of worker threads
+			num_idle,	// Number of idle worker threads
+			num_active,	// Number of running work items
+			max_queue,	// Maximum number of queued items (0 = unlimited)
+			num_queue;	// Number of queued items (shared + local)
+  _cups_tpqueue_t	queue;		// Shared work queue
+  _cups_tpworker_t	*workers;	// Worker threads
+  bool			deleting,	// Deleting the pool?
+			stealing;	// Use local queues and work stealing?
+};
+
+
+//
+// Local functions...
+//
+
+static bool		cups_thread_pool_add(cups_thread_pool_t *pool, cups_thread_func_t func, void *arg, bool wait);
+static bool		cups_thread_pool_pop(_cups_tpqueue_t *queue, bool last, _cups_tpwork_t *work);
+static bool		cups_thread_pool_push(_cups_tpqueue_t *queue, cups_thread_func_t func, void *arg);
+static _cups_tpworker_t	*cups_thread_pool_self(cups_thread_pool_t *pool);
+static void		*cups_thread_pool_worker(_cups_tpworker_t *worker);
+
+
+//
+// 'cupsThreadPoolAdd()' - Queue a function to run on a worker thread.
+//
+// This function queues a call to "func" with "arg" and starts a new worker
+// thread if there are no idle workers and the maximum number of threads has not
+// been reached.  If the queue is full, this function waits until a worker
+// dequeues another item.  When called from one of the pool's own worker
+// threads with a full queue, "func" is instead called immediately on the
+// current thread so that nested work cannot deadlock the pool.  The return
+// value of "func" is ignored.
+//
+
+bool					// O - `true` on success, `false` on error
+cupsThreadPoolAdd(
+    cups_thread_pool_t *pool,		// I - Thread pool
+    cups_thread_func_t func,		// I - Function to call
+    void               *arg)		// I - Argument for function
+{
+  return (cups_thread_pool_add(pool, func, arg, true));
+}
+
+
+//
+// 'cupsThreadPoolDelete()' - Delete a thread pool.
+//
+// This function waits for all queued and running work to finish before
+// stopping the worker threads and freeing the pool.
+//
+
+void
+cupsThreadPoolDelete(
+    cups_thread_pool_t *pool)		// I - Thread pool
+{
+  size_t	i;			// Looping var
+
+
+  if (!pool)
+    return;
+
+  cupsMutexLock(&pool->mutex);
+  pool->deleting = true;
+  cupsCondBroadcast(&pool->work_cond);
+  cupsCondBroadcast(&pool->done_cond);
+  cupsMutexUnlock(&pool->mutex);
+
+  for (i = 0; i < pool->num_threads; i ++)
+  {
+    cupsThreadWait(pool->workers[i].thread);
+    _cupsMemFree(pool->workers[i].queue.work);
+  }
+
+  cupsCondDestroy(&pool->work_cond);
+  cupsCondDestroy(&pool->done_cond);
+  cupsMutexDestroy(&pool->mutex);
+
+  _cupsMemFree(pool->queue.work);
+  _cupsMemFree(pool->workers);
+  _cupsMemFree(pool);
+}
+
+
+//
+// 'cupsThreadPoolNew()' - Create a pool of worker threads.
+//
+// This function creates a pool of up to "max_threads" worker threads that run
+// functions queued with @link cupsThreadPoolAdd@.  Worker threads are started
+// as needed and then wait for more work until the pool is deleted.  The
+// "max_queue" argument specifies the maximum number of queued functions that
+// are waiting for a worker thread, with `0` meaning no limit.
+//
+
+cups_thread_pool_t *			// O - Thread pool or `NULL` on error
+cupsThreadPoolNew(size_t max_threads,	// I - Maximum number of worker threads
+                  size_t max_queue)	// I - Maximum number of queued functions or `0` for no limit
+{
+  cups_thread_pool_t	*pool;		// Thread pool
+
+
+  if (max_threads == 0)
+    return (NULL);
+
+  if ((pool = (cups_thread_pool_t *)_cupsMemCalloc(CUPS_MEMTYPE_OTHER, 1, sizeof(cups_thread_pool_t))) == NULL)
+    return (NULL);
+
+  if ((pool->workers = (_cups_tpworker_t *)_cupsMemCalloc(CUPS_MEMTYPE_OTHER, max_threads, sizeof(_cups_tpworker_t))) == NULL)
+  {
+    _cupsMemFree(pool);
+    return (NULL);
+  }
+
+  cupsMutexInit(&pool->mutex);
+  cupsCondInit(&pool->work_cond);
+  cupsCondInit(&pool->done_cond);
+
+  pool->max_threads = max_threads;
+  pool->max_queue   = max_queue;
+
+  return (pool);
+}
+
+
+//
+// 'cupsThreadPoolSetStealing()' - Enable or disable work stealing.
+//
+// This function controls whether functions queued from one of the pool's own
+// worker threads go on a local queue for that worker.  Each worker runs its
+// most recently queued local work first and idle workers take ("steal") the
+// oldest work from the shared queue and then from the other workers' local
+// queues.  This keeps recursive or fan-out work on the thread that produced
+// it.  Work stealing is disabled by default.
+//
+
+void
+cupsThreadPoolSetStealing(
+    cups_thread_pool_t *pool,		// I - Thread pool
+    bool               enable)		// I - `true` to enable work stealing, `false` to disable
+{
+  if (!pool)
+    return;
+
+  cupsMutexLock(&pool->mutex);
+  pool->stealing = enable;
+  cupsMutexUnlock(&pool->mutex);
+}
+
+
+//
+// 'cupsThreadPoolTryAdd()' - Queue a function to run on a worker thread without waiting.
+//
+// This function works like @link cupsThreadPoolAdd@ but returns `false` and
+// sets `errno` to `EAGAIN` instead of waiting when the queue is full.
+//
+
+bool					// O - `true` on success, `false` on error or full queue
+cupsThreadPoolTryAdd(
+    cups_thread_pool_t *pool,		// I - Thread pool
+    cups_thread_func_t func,		// I - Function to call
+    void               *arg)		// I - Argument for function
+{
+  return (cups_thread_pool_add(pool, func, arg, false));
+}
+
+
+//
+// 'cupsThreadPoolWait()' - Wait for all queued and running work to finish.
+//
+
+void
+cupsThreadPoolWait(
+    cups_thread_pool_t *pool)		// I - Thread pool
+{
+  if (!pool)
+    return;
+
+  cupsMutexLock(&pool->mutex);
+
+  while (pool->num_queue > 0 || pool->num_active > 0)
+    cupsCondWait(&pool->done_cond, &pool->mutex, 0.0);
+
+  cupsMutexUnlock(&pool->mutex);
+}
+
+
+//
+// 'cups_thread_pool_add()' - Queue a function, optionally waiting for room.
+//
+
+static bool				// O - `true` on success, `false` on error
+cups_thread_pool_add(
+    cups_thread_pool_t *pool,		// I - Thread pool
+    cups_thread_func_t func,		// I - Function to call
+    void               *arg,		// I - Argument for function
+    bool               wait)		// I - Wait for room in the queue?
+{
+  _cups_tpworker_t	*self;		// Current worker, if any
+  _cups_tpqueue_t	*queue;		// Queue to use
+  _cups_tpworker_t	*worker;	// New worker
+
+
+  if (!pool || !func)
+    return (false);
+
+  cupsMutexLock(&pool->mutex);
+
+  self = cups_thread_pool_self(pool);
+
+  // Wait for room in the queue...
+  while (!pool->deleting && pool->max_queue > 0 && pool->num_queue >= pool->max_queue)
+  {
+    if (!wait)
+    {
+      cupsMutexUnlock(&pool->mutex);
+      errno = EAGAIN;
+      return (false);
+    }
+    else if (self)
+    {
+      // Workers never wait on their own pool, run the function here...
+      cupsMutexUnlock(&pool->mutex);
+      (func)(arg);
+      return (true);
+    }
+
+    cupsCondWait(&pool->done_cond, &pool->mutex, 0.0);
+  }
+
+  if (pool->deleting && !self)
+  {
+    cupsMutexUnlock(&pool->mutex);
+    return (false);
+  }
+
+  queue = (self && pool->stealing) ? &self->queue : &pool->queue;
+
+  if (!cups_thread_pool_push(queue, func, arg))
+  {
+    cupsMutexUnlock(&pool->mutex);
+    return (false);
+  }
+
+  pool->num_queue ++;
+
+  // Start another worker as needed...
+  if (pool->num_idle < pool->num_queue && pool->num_threads < pool->max_threads)
+  {
+    worker = pool->workers + pool->num_threads;
+    worker->pool = pool;
+
+    if ((worker->thread = cupsThreadCreate((cups_thread_func_t)cups_thread_pool_worker, worker)) != CUPS_THREAD_INVALID)
+    {
+      pool->num_threads ++;
+    }
+    else if (pool->num_threads == 0)
+    {
+      // No workers to run anything...
+      cups_thread_pool_pop(queue, true, NULL);
+      pool->num_queue --;
+      cupsMutexUnlock(&pool->mutex);
+      return (false);
+    }
+  }
+
+  // Wake up one idle worker...
+#if _WIN32
+  WakeConditionVariable(&pool->work_cond);
+#else
+  pthread_cond_signal(&pool->work_cond);
+#endif // _WIN32
+
+  cupsMutexUnlock(&pool->mutex);
+
+  return (true);
+}
+
+
+//
+// 'cups_thread_pool_pop()' - Remove the first or last item from a queue.
+//
+
+static bool				// O - `true` if an item was removed, `false` if empty
+cups_thread_pool_pop(
+    _cups_tpqueue_t *queue,		// I - Queue
+    bool            last,		// I - Remove the last (newest) item?
+    _cups_tpwork_t  *work)		// O - Removed item or `NULL`
+{
+  size_t	i;			// Index of item
+
+
+  if (queue->num_work == 0)
+    return (false);
+
+  if (last)
+  {
+    i = (queue->first_work + queue->num_work - 1) % queue->alloc_work;
+  }
+  else
+  {
+    i                 = queue->first_work;
+    queue->first_work = (queue->first_work + 1) % queue->alloc_work;
+  }
+
+  queue->num_work --;
+
+  if (work)
+    *work = queue->work[i];
+
+  return (true);
+}
+
+
+//
+// 'cups_thread_pool_push()' - Add an item to the end of a queue.
+//
+
+static bool				// O - `true` on success, `false` on error
+cups_thread_pool_push(
+    _cups_tpqueue_t    *queue,		// I - Queue
+    cups_thread_func_t func,		// I - Function to call
+    void               *arg)		// I - Argument for function
+{
+  size_t	i;			// Index of new item
+
+
+  if (queue->num_work >= queue->alloc_work)
+  {
+    // Expand the queue, keeping the queued items in order...
+    _cups_tpwork_t	*temp;		// New queue
+    size_t		alloc_work = queue->alloc_work + 16;
+					// New size of queue
+
+    if ((temp = _cupsMemAlloc(CUPS_MEMTYPE_OTHER, alloc_work * sizeof(_cups_tpwork_t))) == NULL)
+      return (false);
+
+    for (i = 0; i < queue->num_work; i ++)
+      temp[i] = queue->work[(queue->first_work + i) % queue->alloc_work];
+
+    _cupsMemFree(queue->work);
+
+    queue->work       = temp;
+    queue->alloc_work = alloc_work;
+    queue->first_work = 0;
+  }
+
+  i = (queue->first_work + queue->num_work) % queue->alloc_work;
+
+  queue->work[i].func = func;
+  queue->work[i].arg  = arg;
+  queue->num_work ++;
+
+  return (true);
+}
+
+
+//
+// 'cups_thread_pool_self()' - Find the worker for the current thread.
+//
+// The pool mutex must be held by the caller.
+//
+
+static _cups_tpworker_t *		// O - Worker or `NULL` if not a worker thread
+cups_thread_pool_self(
+    cups_thread_pool_t *pool)		// I - Thread pool
+{
+  size_t	i;			// Looping var
+#if _WIN32
+  cups_thread_t	current = win32_self();	// Current thread
+#else
+  pthread_t	current = pthread_self();	// Current thread
+#endif // _WIN32
+
+
+  for (i = 0; i < pool->num_threads; i ++)
+  {
+#if _WIN32
+    if (pool->workers[i].thread == current)
+#else
+    if (pthread_equal(pool->workers[i].thread, current))
+#endif // _WIN32
+      return (pool->workers + i);
+  }
+
+  return (NULL);
+}
+
+
+//
+// 'cups_thread_pool_worker()' - Run queued work for a thread pool.
+//
+
+static void *				// O - Thread exit status
+cups_thread_pool_worker(
+    _cups_tpworker_t *worker)		// I - Worker
+{
+  cups_thread_pool_t	*pool = worker->pool;
+					// Thread pool
+  _cups_tpwork_t	work;		// Current work
+  size_t		i,		// Looping var
+			count;		// Number of other workers
+
+
+  cupsMutexLock(&pool->mutex);
+
+  for (;;)
+  {
+    // Wait for work...
+    while (pool->num_queue == 0 && !pool->deleting)
+    {
+      pool->num_idle ++;
+      cupsCondWait(&pool->work_cond, &pool->mutex, 0.0);
+      pool->num_idle --;
+    }
+
+    if (pool->num_queue == 0)
+      break;				// Pool is being deleted and there is no more work
+
+    // Dequeue the newest local work, then the oldest shared work, and finally
+    // steal the oldest work from another worker...
+    if (!cups_thread_pool_pop(&worker->queue, true, &work) && !cups_thread_pool_pop(&pool->queue, false, &work))
+    {
+      for (i = (size_t)(worker - pool->workers) + 1, count = pool->num_threads; count > 1; i ++, count --)
+      {
+        if (cups_thread_pool_pop(&pool->workers[i % pool->num_threads].queue, false, &work))
+          break;
+      }
+    }
+
+    pool->num_queue --;
+    pool->num_active ++;
+
+    cupsCondBroadcast(&pool->done_cond);
+    cupsMutexUnlock(&pool->mutex);
+
+    (work.func)(work.arg);
+
+    cupsMutexLock(&pool->mutex);
+
+    pool->num_active --;
+
+    cupsCondBroadcast(&pool->done_cond);
+  }
+
+  cupsMutexUnlock(&pool->mutex);
+
+  return (NULL);
+}
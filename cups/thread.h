@@ -26,6 +26,7 @@ extern "C" {
 #    include <windows.h>
 typedef void *(__stdcall *cups_thread_func_t)(void *arg);
 					// Thread function
+typedef LONG cups_atomic_t;		// Atomic integer
 typedef struct _cups_thread_s *cups_thread_t;
 					// Thread identifier
 typedef CONDITION_VARIABLE cups_cond_t;	// Condition variable
@@ -48,6 +49,7 @@ typedef DWORD	cups_thread_key_t;	// Thread data key
 #    include <pthread.h>
 typedef void *(*cups_thread_func_t)(void *arg);
 					// Thread function
+typedef int cups_atomic_t;		// Atomic integer
 typedef pthread_t cups_thread_t;	// Thread identifier
 typedef pthread_cond_t cups_cond_t;	// Condition variable
 typedef pthread_mutex_t cups_mutex_t;	// Mutual exclusion lock
@@ -63,11 +65,35 @@ typedef pthread_key_t	cups_thread_key_t;
 #  endif // _WIN32
 #  define CUPS_THREAD_INVALID (cups_thread_t)0
 
+typedef cups_atomic_t cups_spinlock_t;	// Spin-then-park lock
+#  define CUPS_SPINLOCK_INITIALIZER 0
+
+typedef struct _cups_thread_pool_s cups_thread_pool_t;
+					// Pool of worker threads
+
+#  define CUPS_LOCK_STATS_BUCKETS 24	// Number of lock wait time histogram buckets
+
+typedef struct cups_lock_stats_s	// Lock contention statistics
+{
+  const char		*name;		// Name of lock or `NULL` if not named
+  const void		*lock;		// Address of lock
+  size_t		acquired,	// Number of acquisitions
+			contended;	// Number of acquisitions that waited for another thread
+  double		wait_time;	// Total seconds spent waiting
+  size_t		waits[CUPS_LOCK_STATS_BUCKETS];
+					// Number of waits under 2^N microseconds (last bucket counts all longer waits)
+} cups_lock_stats_t;
+
 
 //
 // Functions...
 //
 
+extern bool	cupsAtomicCAS(cups_atomic_t *value, cups_atomic_t oldval, cups_atomic_t newval) _CUPS_PUBLIC;
+extern cups_atomic_t cupsAtomicDec(cups_atomic_t *value) _CUPS_PUBLIC;
+extern cups_atomic_t cupsAtomicGet(cups_atomic_t *value) _CUPS_PUBLIC;
+extern cups_atomic_t cupsAtomicInc(cups_atomic_t *value) _CUPS_PUBLIC;
+
 extern void	cupsCondBroadcast(cups_cond_t *cond) _CUPS_PUBLIC;
 extern void	cupsCondDestroy(cups_cond_t *cond) _CUPS_PUBLIC;
 extern void	cupsCondInit(cups_cond_t *cond) _CUPS_PUBLIC;
@@ -76,19 +102,32 @@ extern void	cupsCondWait(cups_cond_t *cond, cups_mutex_t *mutex, double timeout)
 extern void	cupsMutexDestroy(cups_mutex_t *mutex) _CUPS_PUBLIC;
 extern void	cupsMutexInit(cups_mutex_t *mutex) _CUPS_PUBLIC;
 extern void	cupsMutexLock(cups_mutex_t *mutex) _CUPS_PUBLIC;
+extern void	cupsMutexSetName(cups_mutex_t *mutex, const char *name) _CUPS_PUBLIC;
 extern void	cupsMutexUnlock(cups_mutex_t *mutex) _CUPS_PUBLIC;
 
 extern void	cupsRWDestroy(cups_rwlock_t *rwlock) _CUPS_PUBLIC;
 extern void	cupsRWInit(cups_rwlock_t *rwlock) _CUPS_PUBLIC;
 extern void	cupsRWLockRead(cups_rwlock_t *rwlock) _CUPS_PUBLIC;
 extern void	cupsRWLockWrite(cups_rwlock_t *rwlock) _CUPS_PUBLIC;
+extern void	cupsRWSetName(cups_rwlock_t *rwlock, const char *name) _CUPS_PUBLIC;
 extern void	cupsRWUnlock(cups_rwlock_t *rwlock) _CUPS_PUBLIC;
 
+extern void	cupsSpinLock(cups_spinlock_t *lock) _CUPS_PUBLIC;
+extern void	cupsSpinUnlock(cups_spinlock_t *lock) _CUPS_PUBLIC;
+
 extern void	cupsThreadCancel(cups_thread_t thread) _CUPS_PUBLIC;
 extern cups_thread_t cupsThreadCreate(cups_thread_func_t func, void *arg) _CUPS_PUBLIC;
 extern void     cupsThreadDetach(cups_thread_t thread) _CUPS_PUBLIC;
+extern size_t	cupsThreadGetLockStats(cups_lock_stats_t *stats, size_t max_stats) _CUPS_PUBLIC;
 extern void	*cupsThreadWait(cups_thread_t thread) _CUPS_PUBLIC;
 
+extern bool	cupsThreadPoolAdd(cups_thread_pool_t *pool, cups_thread_func_t func, void *arg) _CUPS_PUBLIC;
+extern void	cupsThreadPoolDelete(cups_thread_pool_t *pool) _CUPS_PUBLIC;
+extern cups_thread_pool_t *cupsThreadPoolNew(size_t max_threads, size_t max_queue) _CUPS_PUBLIC;
+extern void	cupsThreadPoolSetStealing(cups_thread_pool_t *pool, bool enable) _CUPS_PUBLIC;
+extern bool	cupsThreadPoolTryAdd(cups_thread_pool_t *pool, cups_thread_func_t func, void *arg) _CUPS_PUBLIC;
+extern void	cupsThreadPoolWait(cups_thread_pool_t *pool) _CUPS_PUBLIC;
+
 
 #  ifdef __cplusplus
 }
@@ -29,6 +29,10 @@ static void		gnutls_load_crl(void);
 //
 
 static gnutls_x509_crl_t tls_crl = NULL;// Certificate revocation list
+static time_t		tls_crl_mtime = 0;
+					// Modification time of CRL file
+static gnutls_datum_t	tls_ticket_key = { NULL, 0 };
+					// Server session ticket key
 
 
 //
@@ -213,7 +217,8 @@ cupsCreateCredentials(
   // Create the encryption key...
   DEBUG_puts("1cupsCreateCredentials: Creating key pair.");
 
-  key = gnutls_create_key(type);
+  if ((key = http_copy_pool_key(type)) == NULL)
+    key = gnutls_create_key(type);
 
   DEBUG_puts("1cupsCreateCredentials: Key pair created.");
 
@@ -531,7 +536,8 @@ cupsCreateCredentialsRequest(
   // Create the encryption key...
   DEBUG_puts("1cupsCreateCredentialsRequest: Creating key pair.");
 
-  key = gnutls_create_key(type);
+  if ((key = http_copy_pool_key(type)) == NULL)
+    key = gnutls_create_key(type);
 
   DEBUG_puts("1cupsCreateCredentialsRequest: Key pair created.");
 
@@ -777,6 +783,7 @@ cupsGetCredentialsTrust(
  			*tcreds = NULL;	// Trusted credentials
   unsigned		num_certs = 16;	// Number of certificates
   gnutls_x509_crt_t	certs[16];	// Certificates
+  _http_tls_trust_t	ctrust;		// Cached trust lookup data
   _cups_globals_t	*cg = _cupsGlobals();
 					// Per-thread globals
 
@@ -791,6 +798,17 @@ cupsGetCredentialsTrust(
     return (HTTP_TRUST_UNKNOWN);
   }
 
+  if (cg->any_root < 0)
+    _cupsSetDefaults();
+
+  gnutls_load_crl();
+
+  // See if we've recently trusted these credentials...
+  http_make_trust(&ctrust, path, common_name, credentials);
+
+  if (http_find_trust(&ctrust))
+    return (HTTP_TRUST_OK);
+
   // Load the credentials...
   if (!gnutls_import_certs(credentials, &num_certs, certs))
   {
@@ -798,12 +816,6 @@ cupsGetCredentialsTrust(
     return (HTTP_TRUST_UNKNOWN);
   }
 
-  if (cg->any_root < 0)
-  {
-    _cupsSetDefaults();
-    gnutls_load_crl();
-  }
-
   // Look this common name up in the default keychains...
   if ((tcreds = cupsCopyCredentials(path, common_name)) != NULL)
   {
@@ -902,6 +914,9 @@ cupsGetCredentialsTrust(
     trust = HTTP_TRUST_INVALID;
   }
 
+  if (trust == HTTP_TRUST_OK)
+    http_save_trust(&ctrust, gnutls_x509_crt_get_expiration_time(certs[0]));
+
   gnutls_free_certs(num_certs, certs);
 
   return (trust);
@@ -1350,13 +1365,13 @@ _httpCreateCredentials(
   if (!credentials || !*credentials || !key || !*key)
     return (NULL);
 
-  if ((hcreds = calloc(1, sizeof(_http_tls_credentials_t))) == NULL)
+  if ((hcreds = _cupsMemCalloc(CUPS_MEMTYPE_TLS, 1, sizeof(_http_tls_credentials_t))) == NULL)
     return (NULL);
 
   if ((err = gnutls_certificate_allocate_credentials(&hcreds->creds)) < 0)
   {
     DEBUG_printf("1_httpCreateCredentials: allocate_credentials error: %s", gnutls_strerror(err));
-    free(hcreds);
+    _cupsMemFree(hcreds);
     return (NULL);
   }
 
@@ -1372,7 +1387,7 @@ _httpCreateCredentials(
     DEBUG_printf("1_httpCreateCredentials: set_x509_key_mem error: %s", gnutls_strerror(err));
 
     gnutls_certificate_free_credentials(hcreds->creds);
-    free(hcreds);
+    _cupsMemFree(hcreds);
     hcreds = NULL;
   }
 
@@ -1400,7 +1415,21 @@ _httpFreeCredentials(
     return;
 
   gnutls_certificate_free_credentials(hcreds->creds);
-  free(hcreds);
+  _cupsMemFree(hcreds);
+}
+
+
+//
+// '_httpTLSCanSendfile()' - Return whether `sendfile()` can be used on a TLS
+//                           connection.
+//
+
+bool					// O - `true` if `sendfile()` works, `false` otherwise
+_httpTLSCanSendfile(http_t *http)	// I - HTTP connection
+{
+  (void)http;
+
+  return (false);
 }
 
 
@@ -1659,7 +1688,7 @@ _httpTLSStart(http_t *http)		// I - Connection to server
 
     DEBUG_printf("4_httpTLSStart: Using certificate \"%s\" and private key \"%s\".", crtfile, keyfile);
 
-    if ((credentials = calloc(1, sizeof(_http_tls_credentials_t))) == NULL)
+    if ((credentials = _cupsMemCalloc(CUPS_MEMTYPE_TLS, 1, sizeof(_http_tls_credentials_t))) == NULL)
     {
       DEBUG_puts("4_httpTLSStart: cupsCreateCredentials failed.");
       http->error  = errno = EINVAL;
@@ -1677,6 +1706,31 @@ _httpTLSStart(http_t *http)		// I - Connection to server
   if (!status && credentials)
     status = gnutls_credentials_set(http->tls, GNUTLS_CRD_CERTIFICATE, credentials->creds);
 
+  if (!status && http->mode == _HTTP_MODE_CLIENT && !credentials)
+  {
+    // Try resuming a previous session with this server...
+    unsigned char	*data;		// Session data
+    size_t		datalen;	// Length of session data
+
+    if ((data = http_copy_session(http, &datalen)) != NULL)
+    {
+      DEBUG_puts("4_httpTLSStart: Resuming previous session.");
+      gnutls_session_set_data(http->tls, data, datalen);
+      _cupsMemFree(data);
+    }
+  }
+  else if (!status && http->mode == _HTTP_MODE_SERVER)
+  {
+    // Use the same session ticket key for every connection so that clients
+    // can resume their sessions...
+    cupsMutexLock(&tls_mutex);
+    if (!tls_ticket_key.data && gnutls_session_ticket_key_generate(&tls_ticket_key) < 0)
+      tls_ticket_key.data = NULL;
+    if (tls_ticket_key.data)
+      gnutls_session_ticket_enable_server(http->tls, &tls_ticket_key);
+    cupsMutexUnlock(&tls_mutex);
+  }
+
   if (status)
   {
     http->error  = EIO;
@@ -1800,6 +1854,18 @@ _httpTLSStop(http_t *http)		// I - Connection to server
   int	error;				// Error code
 
 
+  if (http->mode == _HTTP_MODE_CLIENT && !http->tls_credentials)
+  {
+    // Save the session (with any tickets received) for the next connection...
+    gnutls_datum_t	data;		// Session data
+
+    if (!gnutls_session_get_data2(http->tls, &data))
+    {
+      http_save_session(http, data.data, data.size);
+      gnutls_free(data.data);
+    }
+  }
+
   error = gnutls_bye(http->tls, http->mode == _HTTP_MODE_CLIENT ? GNUTLS_SHUT_RDWR : GNUTLS_SHUT_WR);
   if (error != GNUTLS_E_SUCCESS)
     _cupsSetError(IPP_STATUS_ERROR_INTERNAL, gnutls_strerror(errno), 0);
@@ -1966,6 +2032,8 @@ gnutls_http_read(
     }
   }
 
+  http->stats.read_calls ++;
+
   bytes = recv(http->fd, data, length, 0);
   DEBUG_printf("5gnutls_http_read: bytes=%d", (int)bytes);
   return (bytes);
@@ -1986,6 +2054,8 @@ gnutls_http_write(
 
 
   DEBUG_printf("5gnutls_http_write(ptr=%p, data=%p, length=%d)", ptr, data, (int)length);
+  ((http_t *)ptr)->stats.write_calls ++;
+
   bytes = send(((http_t *)ptr)->fd, data, length, 0);
   DEBUG_printf("5gnutls_http_write: bytes=%d", (int)bytes);
 
@@ -2024,17 +2094,44 @@ gnutls_import_certs(
 //
 // 'gnutls_load_crl()' - Load the certificate revocation list, if any.
 //
+// The CRL is only (re)loaded when the "site.crl" file changes.
+//
 
 static void
 gnutls_load_crl(void)
 {
+  char		filename[1024];		// site.crl
+  struct stat	fileinfo;		// File information
+  time_t	mtime;			// Modification time of site.crl
+
+
+  http_make_path(filename, sizeof(filename), CUPS_SERVERROOT, "site", "crl");
+  mtime = stat(filename, &fileinfo) ? 0 : fileinfo.st_mtime;
+
   cupsMutexLock(&tls_mutex);
 
+  if (tls_crl && mtime == tls_crl_mtime)
+  {
+    // Already loaded...
+    cupsMutexUnlock(&tls_mutex);
+    return;
+  }
+
+  if (tls_crl)
+  {
+    // Free the old CRL and forget any trust decisions that used it...
+    gnutls_x509_crl_deinit(tls_crl);
+    tls_crl = NULL;
+
+    http_clear_trust();
+  }
+
+  tls_crl_mtime = mtime;
+
   if (!gnutls_x509_crl_init(&tls_crl))
   {
     cups_file_t		*fp;		// CRL file
-    char		filename[1024],	// site.crl
-			line[256];	// Base64-encoded line
+    char		line[256];	// Base64-encoded line
     unsigned char	*data = NULL;	// Buffer for cert data
     size_t		alloc_data = 0,	// Bytes allocated
 			num_data = 0;	// Bytes used
@@ -2042,8 +2139,6 @@ gnutls_load_crl(void)
     gnutls_datum_t	datum;		// Data record
 
 
-    http_make_path(filename, sizeof(filename), CUPS_SERVERROOT, "site", "crl");
-
     if ((fp = cupsFileOpen(filename, "r")) != NULL)
     {
       while (cupsFileGets(fp, line, sizeof(line)))
@@ -2075,7 +2170,7 @@ gnutls_load_crl(void)
 	{
 	  if (alloc_data == 0)
 	  {
-	    data       = malloc(2048);
+	    data       = _cupsMemAlloc(CUPS_MEMTYPE_TLS, 2048);
 	    alloc_data = 2048;
 
 	    if (!data)
@@ -2083,7 +2178,7 @@ gnutls_load_crl(void)
 	  }
 	  else if ((num_data + strlen(line)) >= alloc_data)
 	  {
-	    unsigned char *tdata = realloc(data, alloc_data + 1024);
+	    unsigned char *tdata = _cupsMemRealloc(CUPS_MEMTYPE_TLS, data, alloc_data + 1024);
 					    // Expanded buffer
 
 	    if (!tdata)
@@ -2102,7 +2197,7 @@ gnutls_load_crl(void)
       cupsFileClose(fp);
 
       if (data)
-	free(data);
+	_cupsMemFree(data);
     }
   }
 
@@ -17,12 +17,42 @@
 #include <openssl/obj_mac.h>
 
 
+//
+// Local constants...
+//
+
+#define _HTTP_TLS_MAX_CONTEXTS	16	// Maximum number of cached server contexts
+
+
+//
+// Local types...
+//
+
+typedef struct _http_tls_context_s	// Cached server context
+{
+  char			crtfile[1024],	// Certificate file
+			keyfile[1024];	// Private key file
+  struct stat		crtinfo,	// Certificate file information
+			keyinfo;	// Private key file information
+  int			options,	// TLS options
+			min_version,	// Minimum TLS version
+			max_version;	// Maximum TLS version
+  size_t		used;		// Last use counter
+  SSL_CTX		*context;	// Server context
+} _http_tls_context_t;
+
+
 //
 // Local functions...
 //
 
 static long		http_bio_ctrl(BIO *h, int cmd, long arg1, void *arg2);
 static int		http_bio_free(BIO *data);
+#if defined(SSL_OP_ENABLE_KTLS) && !defined(OPENSSL_NO_KTLS)
+static long		http_bio_ktls_ctrl(BIO *h, int cmd, long arg1, void *arg2);
+static int		http_bio_ktls_read(BIO *h, char *buf, int size);
+static int		http_bio_ktls_write(BIO *h, const char *buf, int num);
+#endif // SSL_OP_ENABLE_KTLS && !OPENSSL_NO_KTLS
 static int		http_bio_new(BIO *h);
 static int		http_bio_puts(BIO *h, const char *str);
 static int		http_bio_read(BIO *h, char *buf, int size);
@@ -32,9 +62,12 @@ static bool		openssl_add_ext(STACK_OF(X509_EXTENSION) *exts, int nid, const char
 static X509_NAME	*openssl_create_name(const char *organization, const char *org_unit, const char *locality, const char *state_province, const char *country, const char *common_name, const char *email);
 static EVP_PKEY		*openssl_create_key(cups_credtype_t type);
 static X509_EXTENSION	*openssl_create_san(const char *common_name, size_t num_alt_names, const char * const *alt_names);
+static SSL_CTX		*openssl_find_context(const char *crtfile, const char *keyfile, struct stat *crtinfo, struct stat *keyinfo);
 static time_t		openssl_get_date(X509 *cert, int which);
 //static void		openssl_load_crl(void);
 static STACK_OF(X509 *)	openssl_load_x509(const char *credentials);
+static void		openssl_save_context(const char *crtfile, const char *keyfile, struct stat *crtinfo, struct stat *keyinfo, SSL_CTX *context);
+static void		openssl_set_options(SSL_CTX *context, http_t *http);
 
 
 //
@@ -43,6 +76,18 @@ static STACK_OF(X509 *)	openssl_load_x509(const char *credentials);
 
 static BIO_METHOD	*tls_bio_method = NULL;
 					// OpenSSL BIO method
+#if defined(SSL_OP_ENABLE_KTLS) && !defined(OPENSSL_NO_KTLS)
+static BIO_METHOD	*tls_ktls_method = NULL;
+					// OpenSSL filter BIO method for kernel TLS
+#endif // SSL_OP_ENABLE_KTLS && !OPENSSL_NO_KTLS
+static _http_tls_context_t tls_contexts[_HTTP_TLS_MAX_CONTEXTS];
+					// Cached server contexts
+static size_t		tls_contexts_used = 0;
+					// Server context use counter
+static bool		tls_have_ticket_keys = false;
+					// Have server session ticket keys?
+static unsigned char	tls_ticket_keys[80];
+					// Server session ticket keys
 static const char * const tls_purpose_oids[] =
 {					// OIDs for each key purpose value
   "1.3.6.1.5.5.7.3.1",			// serverAuth
@@ -213,7 +258,7 @@ cupsCreateCredentials(
   // Create the encryption key...
   DEBUG_puts("1cupsCreateCredentials: Creating key pair.");
 
-  if ((pkey = openssl_create_key(type)) == NULL)
+  if ((pkey = http_copy_pool_key(type)) == NULL && (pkey = openssl_create_key(type)) == NULL)
     return (false);
 
   DEBUG_puts("1cupsCreateCredentials: Key pair created.");
@@ -515,7 +560,7 @@ cupsCreateCredentialsRequest(
   // Create the encryption key...
   DEBUG_puts("1cupsCreateCredentialsRequest: Creating key pair.");
 
-  if ((pkey = openssl_create_key(type)) == NULL)
+  if ((pkey = http_copy_pool_key(type)) == NULL && (pkey = openssl_create_key(type)) == NULL)
     return (false);
 
   DEBUG_puts("1cupsCreateCredentialsRequest: Key pair created.");
@@ -749,6 +794,7 @@ cupsGetCredentialsTrust(
   X509			*cert;		// Certificate
   char			*tcreds = NULL;	// Trusted credentials
   char			defpath[1024];	// Default path
+  _http_tls_trust_t	ctrust;		// Cached trust lookup data
   _cups_globals_t *cg = _cupsGlobals();	// Per-thread globals
 
 
@@ -762,6 +808,18 @@ cupsGetCredentialsTrust(
     return (HTTP_TRUST_UNKNOWN);
   }
 
+  if (cg->any_root < 0)
+  {
+    _cupsSetDefaults();
+//    openssl_load_crl();
+  }
+
+  // See if we've recently trusted these credentials...
+  http_make_trust(&ctrust, path, common_name, credentials);
+
+  if (http_find_trust(&ctrust))
+    return (HTTP_TRUST_OK);
+
   // Load the credentials...
   if ((certs = openssl_load_x509(credentials)) == NULL)
   {
@@ -771,12 +829,6 @@ cupsGetCredentialsTrust(
 
   cert = sk_X509_value(certs, 0);
 
-  if (cg->any_root < 0)
-  {
-    _cupsSetDefaults();
-//    openssl_load_crl();
-  }
-
   // Look this common name up in the default keychains...
   if ((tcreds = cupsCopyCredentials(path, common_name)) != NULL)
   {
@@ -875,6 +927,9 @@ cupsGetCredentialsTrust(
     trust = HTTP_TRUST_INVALID;
   }
 
+  if (trust == HTTP_TRUST_OK)
+    http_save_trust(&ctrust, openssl_get_date(cert, 1));
+
   sk_X509_free(certs);
 
   return (trust);
@@ -1392,7 +1447,7 @@ _httpCreateCredentials(
   if (!credentials || !*credentials || !key || !*key)
     return (NULL);
 
-  if ((hcreds = calloc(1, sizeof(_http_tls_credentials_t))) == NULL)
+  if ((hcreds = _cupsMemCalloc(CUPS_MEMTYPE_TLS, 1, sizeof(_http_tls_credentials_t))) == NULL)
     return (NULL);
 
   hcreds->use = 1;
@@ -1445,7 +1500,28 @@ _httpFreeCredentials(
     return;
 
   sk_X509_free(hcreds->certs);
-  free(hcreds);
+  _cupsMemFree(hcreds);
+}
+
+
+//
+// '_httpTLSCanSendfile()' - Return whether `sendfile()` can be used on a TLS
+//                           connection.
+//
+// This is only possible when record encryption has been offloaded to the
+// kernel.
+//
+
+bool					// O - `true` if `sendfile()` works, `false` otherwise
+_httpTLSCanSendfile(http_t *http)	// I - HTTP connection
+{
+#if defined(SSL_OP_ENABLE_KTLS) && !defined(OPENSSL_NO_KTLS)
+  return (http->tls && BIO_get_ktls_send(SSL_get_wbio(http->tls)));
+#else
+  (void)http;
+
+  return (false);
+#endif // SSL_OP_ENABLE_KTLS && !OPENSSL_NO_KTLS
 }
 
 
@@ -1499,23 +1575,8 @@ _httpTLSStart(http_t *http)		// I - Connection to server
   const char	*keypath;		// Certificate store path
   BIO		*bio;			// Basic input/output context
   SSL_CTX	*context;		// Encryption context
-  char		hostname[256],		// Hostname
-		cipherlist[256];	// List of cipher suites
+  char		hostname[256];		// Hostname
   unsigned long	error;			// Error code, if any
-  static const uint16_t versions[] =	// SSL/TLS versions
-  {
-    TLS1_VERSION,			// No more SSL support in OpenSSL
-    TLS1_VERSION,			// TLS/1.0
-    TLS1_1_VERSION,			// TLS/1.1
-    TLS1_2_VERSION,			// TLS/1.2
-#ifdef TLS1_3_VERSION
-    TLS1_3_VERSION,			// TLS/1.3
-    TLS1_3_VERSION			// TLS/1.3 (max)
-#else
-    TLS1_2_VERSION,			// TLS/1.2
-    TLS1_2_VERSION			// TLS/1.2 (max)
-#endif // TLS1_3_VERSION
-  };
 
 
   DEBUG_printf("3_httpTLSStart(http=%p)", http);
@@ -1558,6 +1619,8 @@ _httpTLSStart(http_t *http)		// I - Connection to server
       for (i = 1; i < count; i ++)
         SSL_CTX_add_extra_chain_cert(context, sk_X509_value(http->tls_credentials->certs, i));
     }
+
+    openssl_set_options(context, http);
   }
   else
   {
@@ -1567,8 +1630,8 @@ _httpTLSStart(http_t *http)		// I - Connection to server
     const char	*cn,			// Common name to lookup
 		*cnptr;			// Pointer into common name
     bool	have_creds = false;	// Have credentials?
-
-    context = SSL_CTX_new(TLS_server_method());
+    struct stat	crtinfo,		// Certificate file information
+		keyinfo;		// Private key file information
 
     // Find the TLS certificate...
     if (http->fields[HTTP_FIELD_HOST])
@@ -1658,7 +1721,6 @@ _httpTLSStart(http_t *http)		// I - Connection to server
 	http->error  = errno = EINVAL;
 	http->status = HTTP_STATUS_ERROR;
 	_cupsSetError(IPP_STATUS_ERROR_INTERNAL, _("Unable to create server credentials."), 1);
-	SSL_CTX_free(context);
         cupsMutexUnlock(&tls_mutex);
 
 	return (false);
@@ -1670,6 +1732,13 @@ _httpTLSStart(http_t *http)		// I - Connection to server
     DEBUG_printf("4_httpTLSStart: Using private key file '%s'.", keyfile);
     DEBUG_printf("4_httpTLSStart: Using certificate file '%s'.", crtfile);
 
+    // Reuse the server context for these credentials unless the files have
+    // changed...
+    if ((context = openssl_find_context(crtfile, keyfile, &crtinfo, &keyinfo)) != NULL)
+      goto setup_session;
+
+    context = SSL_CTX_new(TLS_server_method());
+
     if (!SSL_CTX_use_PrivateKey_file(context, keyfile, SSL_FILETYPE_PEM) || !SSL_CTX_use_certificate_chain_file(context, crtfile))
     {
       // Unable to load private key or certificate...
@@ -1684,41 +1753,71 @@ _httpTLSStart(http_t *http)		// I - Connection to server
 
       return (false);
     }
-  }
 
-  // Set TLS options...
-  cupsCopyString(cipherlist, "HIGH:!DH:+DHE", sizeof(cipherlist));
-  if ((tls_options & _HTTP_TLS_ALLOW_RC4) && http->mode == _HTTP_MODE_CLIENT)
-    cupsConcatString(cipherlist, ":+RC4", sizeof(cipherlist));
-  else
-    cupsConcatString(cipherlist, ":!RC4", sizeof(cipherlist));
-  if (tls_options & _HTTP_TLS_DENY_CBC)
-    cupsConcatString(cipherlist, ":!SHA1:!SHA256:!SHA384", sizeof(cipherlist));
-  cupsConcatString(cipherlist, ":@STRENGTH", sizeof(cipherlist));
+    // Use the same session ticket keys for every connection so that clients
+    // can resume their sessions...
+    cupsMutexLock(&tls_mutex);
+    if (!tls_have_ticket_keys)
+      tls_have_ticket_keys = RAND_bytes(tls_ticket_keys, sizeof(tls_ticket_keys)) == 1;
+    if (tls_have_ticket_keys)
+      SSL_CTX_set_tlsext_ticket_keys(context, tls_ticket_keys, sizeof(tls_ticket_keys));
+    cupsMutexUnlock(&tls_mutex);
 
-  DEBUG_printf("4_httpTLSStart: cipherlist='%s', tls_min_version=%d, tls_max_version=%d", cipherlist, tls_min_version, tls_max_version);
+    SSL_CTX_set_session_id_context(context, (const unsigned char *)"libcups", 7);
 
-  SSL_CTX_set_min_proto_version(context, versions[tls_min_version]);
-  SSL_CTX_set_max_proto_version(context, versions[tls_max_version]);
-  SSL_CTX_set_cipher_list(context, cipherlist);
+    openssl_set_options(context, http);
+    openssl_save_context(crtfile, keyfile, &crtinfo, &keyinfo, context);
+  }
 
   // Setup a TLS session
-  cupsMutexLock(&tls_mutex);
-  if (!tls_bio_method)
+  setup_session:
+
+#if defined(SSL_OP_ENABLE_KTLS) && !defined(OPENSSL_NO_KTLS)
+  if (tls_options & _HTTP_TLS_ALLOW_KTLS)
   {
-    tls_bio_method = BIO_meth_new(BIO_get_new_index(), "http");
-    BIO_meth_set_ctrl(tls_bio_method, http_bio_ctrl);
-    BIO_meth_set_create(tls_bio_method, http_bio_new);
-    BIO_meth_set_destroy(tls_bio_method, http_bio_free);
-    BIO_meth_set_read(tls_bio_method, http_bio_read);
-    BIO_meth_set_puts(tls_bio_method, http_bio_puts);
-    BIO_meth_set_write(tls_bio_method, http_bio_write);
+    // Kernel TLS needs a socket BIO - OpenSSL falls back to user space
+    // encryption if the kernel or cipher suite does not support it.  Put a
+    // filter in front of the socket BIO so that reads still wait for data
+    // and update the connection statistics...
+    DEBUG_puts("4_httpTLSStart: Allowing kernel TLS offload.");
+
+    cupsMutexLock(&tls_mutex);
+    if (!tls_ktls_method)
+    {
+      tls_ktls_method = BIO_meth_new(BIO_get_new_index() | BIO_TYPE_FILTER, "http-ktls");
+      BIO_meth_set_ctrl(tls_ktls_method, http_bio_ktls_ctrl);
+      BIO_meth_set_create(tls_ktls_method, http_bio_new);
+      BIO_meth_set_destroy(tls_ktls_method, http_bio_free);
+      BIO_meth_set_read(tls_ktls_method, http_bio_ktls_read);
+      BIO_meth_set_write(tls_ktls_method, http_bio_ktls_write);
+    }
+
+    bio = BIO_new(tls_ktls_method);
+    cupsMutexUnlock(&tls_mutex);
+
+    BIO_ctrl(bio, BIO_C_SET_FILE_PTR, 0, (char *)http);
+    BIO_push(bio, BIO_new_socket(http->fd, BIO_NOCLOSE));
   }
+  else
+#endif // SSL_OP_ENABLE_KTLS && !OPENSSL_NO_KTLS
+  {
+    cupsMutexLock(&tls_mutex);
+    if (!tls_bio_method)
+    {
+      tls_bio_method = BIO_meth_new(BIO_get_new_index(), "http");
+      BIO_meth_set_ctrl(tls_bio_method, http_bio_ctrl);
+      BIO_meth_set_create(tls_bio_method, http_bio_new);
+      BIO_meth_set_destroy(tls_bio_method, http_bio_free);
+      BIO_meth_set_read(tls_bio_method, http_bio_read);
+      BIO_meth_set_puts(tls_bio_method, http_bio_puts);
+      BIO_meth_set_write(tls_bio_method, http_bio_write);
+    }
 
-  bio = BIO_new(tls_bio_method);
-  cupsMutexUnlock(&tls_mutex);
+    bio = BIO_new(tls_bio_method);
+    cupsMutexUnlock(&tls_mutex);
 
-  BIO_ctrl(bio, BIO_C_SET_FILE_PTR, 0, (char *)http);
+    BIO_ctrl(bio, BIO_C_SET_FILE_PTR, 0, (char *)http);
+  }
 
   http->tls = SSL_new(context);
   SSL_set_bio(http->tls, bio, bio);
@@ -1729,6 +1828,29 @@ _httpTLSStart(http_t *http)		// I - Connection to server
     DEBUG_printf("4_httpTLSStart: Setting server name TLS extension to '%s'...", http->hostname);
     SSL_set_tlsext_host_name(http->tls, http->hostname);
 
+    if (!http->tls_credentials)
+    {
+      // Try resuming a previous session with this server...
+      unsigned char	*data;		// Session data
+      const unsigned char *dataptr;	// Pointer into session data
+      size_t		datalen;	// Length of session data
+      SSL_SESSION	*session;	// Previous session
+
+      if ((data = http_copy_session(http, &datalen)) != NULL)
+      {
+        dataptr = data;
+
+        if ((session = d2i_SSL_SESSION(NULL, &dataptr, (long)datalen)) != NULL)
+        {
+          DEBUG_puts("4_httpTLSStart: Resuming previous session.");
+          SSL_set_session(http->tls, session);
+          SSL_SESSION_free(session);
+        }
+
+        _cupsMemFree(data);
+      }
+    }
+
     DEBUG_puts("4_httpTLSStart: Calling SSL_connect...");
     if (SSL_connect(http->tls) < 1)
     {
@@ -1773,6 +1895,10 @@ _httpTLSStart(http_t *http)		// I - Connection to server
     }
   }
 
+#if defined(SSL_OP_ENABLE_KTLS) && !defined(OPENSSL_NO_KTLS)
+  DEBUG_printf("4_httpTLSStart: Kernel TLS send=%d, recv=%d", (int)BIO_get_ktls_send(SSL_get_wbio(http->tls)), (int)BIO_get_ktls_recv(SSL_get_rbio(http->tls)));
+#endif // SSL_OP_ENABLE_KTLS && !OPENSSL_NO_KTLS
+
   DEBUG_puts("4_httpTLSStart: Returning true.");
 
   return (true);
@@ -1791,6 +1917,28 @@ _httpTLSStop(http_t *http)		// I - Connection to server
 
   context = SSL_get_SSL_CTX(http->tls);
 
+  if (http->mode == _HTTP_MODE_CLIENT && !http->tls_credentials)
+  {
+    // Save the session (with any tickets received) for the next connection...
+    SSL_SESSION	*session;		// Current session
+    int		datalen;		// Length of session data
+    unsigned char *data,		// Session data
+		*dataptr;		// Pointer into session data
+
+    if ((session = SSL_get1_session(http->tls)) != NULL)
+    {
+      if (SSL_SESSION_is_resumable(session) && (datalen = i2d_SSL_SESSION(session, NULL)) > 0 && (data = _cupsMemAlloc(CUPS_MEMTYPE_TLS, (size_t)datalen)) != NULL)
+      {
+        dataptr = data;
+        i2d_SSL_SESSION(session, &dataptr);
+        http_save_session(http, data, (size_t)datalen);
+        _cupsMemFree(data);
+      }
+
+      SSL_SESSION_free(session);
+    }
+  }
+
   SSL_shutdown(http->tls);
   SSL_CTX_free(context);
   SSL_free(http->tls);
@@ -1890,6 +2038,119 @@ http_bio_free(BIO *h)			// I - BIO data
 }
 
 
+#if defined(SSL_OP_ENABLE_KTLS) && !defined(OPENSSL_NO_KTLS)
+//
+// 'http_bio_ktls_ctrl()' - Control the kernel TLS filter.
+//
+// Everything except the HTTP connection pointer is passed to the socket BIO,
+// which implements kernel TLS.
+//
+
+static long				// O - Result/data
+http_bio_ktls_ctrl(BIO  *h,		// I - BIO data
+                   int  cmd,		// I - Control command
+		   long arg1,		// I - First argument
+		   void *arg2)		// I - Second argument
+{
+  DEBUG_printf("8http_bio_ktls_ctrl(h=%p, cmd=%d, arg1=%ld, arg2=%p)", (void *)h, cmd, arg1, arg2);
+
+  switch (cmd)
+  {
+    case BIO_C_SET_FILE_PTR :
+        BIO_set_data(h, arg2);
+        BIO_set_init(h, 1);
+	return (1);
+
+    case BIO_C_GET_FILE_PTR :
+        if (arg2)
+	{
+	  *((void **)arg2) = BIO_get_data(h);
+	  return (1);
+	}
+	else
+	  return (0);
+
+    default :
+        if (!BIO_next(h))
+          return (0);
+
+        return (BIO_ctrl(BIO_next(h), cmd, arg1, arg2));
+  }
+}
+
+
+//
+// 'http_bio_ktls_read()' - Read data for OpenSSL using kernel TLS.
+//
+
+static int				// O - Bytes read
+http_bio_ktls_read(BIO  *h,		// I - BIO data
+                   char *buf,		// I - Buffer
+		   int  size)		// I - Number of bytes to read
+{
+  http_t	*http;			// HTTP connection
+  int		bytes;			// Bytes read
+
+
+  DEBUG_printf("8http_bio_ktls_read(h=%p, buf=%p, size=%d)", (void *)h, (void *)buf, size);
+
+  http = (http_t *)BIO_get_data(h);
+
+  if (!http->blocking)
+  {
+    // Make sure we have data before we read...
+    if (!_httpWait(http, 10000, 0))
+    {
+#ifdef WIN32
+      http->error = WSAETIMEDOUT;
+#else
+      http->error = ETIMEDOUT;
+#endif // WIN32
+
+      DEBUG_puts("9http_bio_ktls_read: Timeout, returning -1.");
+      return (-1);
+    }
+  }
+
+  http->stats.read_calls ++;
+
+  BIO_clear_retry_flags(h);
+  bytes = BIO_read(BIO_next(h), buf, size);
+  BIO_copy_next_retry(h);
+
+  DEBUG_printf("9http_bio_ktls_read: Returning %d.", bytes);
+
+  return (bytes);
+}
+
+
+//
+// 'http_bio_ktls_write()' - Write data for OpenSSL using kernel TLS.
+//
+
+static int				// O - Bytes written
+http_bio_ktls_write(BIO        *h,	// I - BIO data
+                    const char *buf,	// I - Buffer to write
+		    int        num)	// I - Number of bytes to write
+{
+  int	bytes;				// Bytes written
+
+
+  DEBUG_printf("8http_bio_ktls_write(h=%p, buf=%p, num=%d)", (void *)h, (void *)buf, num);
+
+  ((http_t *)BIO_get_data(h))->stats.write_calls ++;
+
+  BIO_clear_retry_flags(h);
+  bytes = BIO_write(BIO_next(h), buf, num);
+  BIO_copy_next_retry(h);
+
+  DEBUG_printf("9http_bio_ktls_write: Returning %d.", bytes);
+
+  return (bytes);
+}
+#endif // SSL_OP_ENABLE_KTLS && !OPENSSL_NO_KTLS
+
+
 //
 // 'http_bio_new()' - Initialize an OpenSSL BIO structure.
 //
@@ -1961,6 +2222,8 @@ http_bio_read(BIO  *h,			// I - BIO data
     }
   }
 
+  http->stats.read_calls ++;
+
   bytes = (int)recv(http->fd, buf, (size_t)size, 0);
   DEBUG_printf("9http_bio_read: Returning %d.", bytes);
 
@@ -1982,6 +2245,8 @@ http_bio_write(BIO        *h,		// I - BIO data
 
   DEBUG_printf("8http_bio_write(h=%p, buf=%p, num=%d)", (void *)h, (void *)buf, num);
 
+  ((http_t *)BIO_get_data(h))->stats.write_calls ++;
+
   bytes = (int)send(((http_t *)BIO_get_data(h))->fd, buf, (size_t)num, 0);
 
   DEBUG_printf("9http_bio_write: Returning %d.", bytes);
@@ -2173,6 +2438,59 @@ openssl_create_san(
 }
 
 
+//
+// 'openssl_find_context()' - Find a cached server context.
+//
+// The certificate and private key file information is returned for use with
+// `openssl_save_context`.  The returned context must be freed using
+// `SSL_CTX_free`.
+//
+
+static SSL_CTX *			// O - Server context or `NULL` if not cached
+openssl_find_context(
+    const char  *crtfile,		// I - Certificate file
+    const char  *keyfile,		// I - Private key file
+    struct stat *crtinfo,		// O - Certificate file information
+    struct stat *keyinfo)		// O - Private key file information
+{
+  size_t		i;		// Looping var
+  _http_tls_context_t	*tc;		// Current context
+  SSL_CTX		*context = NULL;// Server context
+
+
+  if (stat(crtfile, crtinfo) || stat(keyfile, keyinfo))
+  {
+    memset(crtinfo, 0, sizeof(struct stat));
+    memset(keyinfo, 0, sizeof(struct stat));
+    return (NULL);
+  }
+
+  cupsMutexLock(&tls_mutex);
+
+  for (i = 0, tc = tls_contexts; i < _HTTP_TLS_MAX_CONTEXTS; i ++, tc ++)
+  {
+    if (tc->context && !strcmp(tc->crtfile, crtfile) && !strcmp(tc->keyfile, keyfile))
+    {
+      // Only use the context if the files and TLS options are unchanged...
+      if (tc->crtinfo.st_ino == crtinfo->st_ino && tc->crtinfo.st_size == crtinfo->st_size && tc->crtinfo.st_mtime == crtinfo->st_mtime && tc->keyinfo.st_ino == keyinfo->st_ino && tc->keyinfo.st_size == keyinfo->st_size && tc->keyinfo.st_mtime == keyinfo->st_mtime && tc->options == tls_options && tc->min_version == tls_min_version && tc->max_version == tls_max_version)
+      {
+	context  = tc->context;
+	tc->used = ++ tls_contexts_used;
+
+	SSL_CTX_up_ref(context);
+      }
+      break;
+    }
+  }
+
+  cupsMutexUnlock(&tls_mutex);
+
+  DEBUG_printf("4openssl_find_context: Returning %p.", (void *)context);
+
+  return (context);
+}
+
+
 //
 // 'openssl_get_date()' - Get the notBefore or notAfter date of a certificate.
 //
@@ -2254,7 +2572,7 @@ openssl_load_crl(void)
 	{
 	  if (alloc_data == 0)
 	  {
-	    data       = malloc(2048);
+	    data       = _cupsMemAlloc(CUPS_MEMTYPE_TLS, 2048);
 	    alloc_data = 2048;
 
 	    if (!data)
@@ -2262,7 +2580,7 @@ openssl_load_crl(void)
 	  }
 	  else if ((num_data + strlen(line)) >= alloc_data)
 	  {
-	    unsigned char *tdata = realloc(data, alloc_data + 1024);
+	    unsigned char *tdata = _cupsMemRealloc(CUPS_MEMTYPE_TLS, data, alloc_data + 1024);
 					    // Expanded buffer
 
 	    if (!tdata)
@@ -2281,7 +2599,7 @@ openssl_load_crl(void)
       cupsFileClose(fp);
 
       if (data)
-	free(data);
+	_cupsMemFree(data);
     }
   }
 
@@ -2337,3 +2655,106 @@ openssl_load_x509(
 
   return (certs);
 }
+
+
+//
+// 'openssl_save_context()' - Cache a server context.
+//
+// The least recently used context is replaced if the certificate and private
+// key files are not already cached.
+//
+
+static void
+openssl_save_context(
+    const char  *crtfile,		// I - Certificate file
+    const char  *keyfile,		// I - Private key file
+    struct stat *crtinfo,		// I - Certificate file information
+    struct stat *keyinfo,		// I - Private key file information
+    SSL_CTX     *context)		// I - Server context
+{
+  size_t		i;		// Looping var
+  _http_tls_context_t	*tc,		// Current context
+			*oldest = NULL;	// Least recently used context
+
+
+  // Don't cache contexts for files that could not be checked...
+  if (!crtinfo->st_mtime || !keyinfo->st_mtime || strlen(crtfile) >= sizeof(tc->crtfile) || strlen(keyfile) >= sizeof(tc->keyfile))
+    return;
+
+  cupsMutexLock(&tls_mutex);
+
+  for (i = 0, tc = tls_contexts; i < _HTTP_TLS_MAX_CONTEXTS; i ++, tc ++)
+  {
+    if (tc->context && !strcmp(tc->crtfile, crtfile) && !strcmp(tc->keyfile, keyfile))
+    {
+      oldest = tc;
+      break;
+    }
+    else if (!oldest || tc->used < oldest->used)
+    {
+      oldest = tc;
+    }
+  }
+
+  SSL_CTX_free(oldest->context);
+  SSL_CTX_up_ref(context);
+
+  cupsCopyString(oldest->crtfile, crtfile, sizeof(oldest->crtfile));
+  cupsCopyString(oldest->keyfile, keyfile, sizeof(oldest->keyfile));
+  oldest->crtinfo     = *crtinfo;
+  oldest->keyinfo     = *keyinfo;
+  oldest->options     = tls_options;
+  oldest->min_version = tls_min_version;
+  oldest->max_version = tls_max_version;
+  oldest->used        = ++ tls_contexts_used;
+  oldest->context     = context;
+
+  cupsMutexUnlock(&tls_mutex);
+}
+
+
+//
+// 'openssl_set_options()' - Set the TLS options for a context.
+//
+
+static void
+openssl_set_options(SSL_CTX *context,	// I - Context
+                    http_t  *http)	// I - HTTP connection
+{
+  char		cipherlist[256];	// List of cipher suites
+  static const uint16_t versions[] =	// SSL/TLS versions
+  {
+    TLS1_VERSION,			// No more SSL support in OpenSSL
+    TLS1_VERSION,			// TLS/1.0
+    TLS1_1_VERSION,			// TLS/1.1
+    TLS1_2_VERSION,			// TLS/1.2
+#ifdef TLS1_3_VERSION
+    TLS1_3_VERSION,			// TLS/1.3
+    TLS1_3_VERSION			// TLS/1.3 (max)
+#else
+    TLS1_2_VERSION,			// TLS/1.2
+    TLS1_2_VERSION			// TLS/1.2 (max)
+#endif // TLS1_3_VERSION
+  };
+
+
+  cupsCopyString(cipherlist, "HIGH:!DH:+DHE", sizeof(cipherlist));
+  if ((tls_options & _HTTP_TLS_ALLOW_RC4) && http->mode == _HTTP_MODE_CLIENT)
+    cupsConcatString(cipherlist, ":+RC4", sizeof(cipherlist));
+  else
+    cupsConcatString(cipherlist, ":!RC4", sizeof(cipherlist));
+  if (tls_options & _HTTP_TLS_DENY_CBC)
+    cupsConcatString(cipherlist, ":!SHA1:!SHA256:!SHA384", sizeof(cipherlist));
+  cupsConcatString(cipherlist, ":@STRENGTH", sizeof(cipherlist));
+
+  DEBUG_printf("4openssl_set_options: cipherlist='%s', tls_min_version=%d, tls_max_version=%d", cipherlist, tls_min_version, tls_max_version);
+
+  SSL_CTX_set_min_proto_version(context, versions[tls_min_version]);
+  SSL_CTX_set_max_proto_version(context, versions[tls_max_version]);
+  SSL_CTX_set_cipher_list(context, cipherlist);
+
+#if defined(SSL_OP_ENABLE_KTLS) && !defined(OPENSSL_NO_KTLS)
+  if (tls_options & _HTTP_TLS_ALLOW_KTLS)
+    SSL_CTX_set_options(context, SSL_OP_ENABLE_KTLS);
+#endif // SSL_OP_ENABLE_KTLS && !OPENSSL_NO_KTLS
+}
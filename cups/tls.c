@@ -23,6 +23,68 @@
 #endif // _WIN32
 
 
+//
+// Local constants...
+//
+
+#define _HTTP_TLS_MAX_SESSIONS	32	// Maximum number of cached client sessions
+#define _HTTP_TLS_SESSION_TIME	7200	// Maximum age of a cached session in seconds
+#define _HTTP_TLS_MAX_TRUSTS	32	// Maximum number of cached trust decisions
+#define _HTTP_TLS_TRUST_TIME	300	// Maximum age of a cached trust decision in seconds
+#define _HTTP_TLS_MAX_POOL_KEYS	32	// Maximum number of pre-generated keys
+
+
+//
+// Local types...
+//
+
+typedef struct _http_tls_session_s	// Cached client TLS session
+{
+  char			key[300];	// "hostname:port"
+  time_t		time;		// Time the session was saved
+  size_t		datalen;	// Length of session data
+  unsigned char		*data;		// Serialized session data
+} _http_tls_session_t;
+
+typedef struct _http_tls_trust_s	// Cached trust decision
+{
+  char			key[1100];	// "path/common_name:settings"
+  unsigned char		hash[32];	// SHA-256 hash of credentials
+  time_t		expires,	// Time the decision expires
+			cmtime,		// Modification time of stored credentials
+			smtime;		// Modification time of site CA credentials
+} _http_tls_trust_t;
+
+typedef struct _http_tls_create_s	// Asynchronous credential creation
+{
+  char			*path;		// Directory path for certificate/key store
+  bool			ca_cert;	// Create a CA certificate?
+  cups_credpurpose_t	purpose;	// Credential purposes
+  cups_credtype_t	type;		// Credential type
+  cups_credusage_t	usage;		// Credential usages
+  char			*organization,	// Organization
+			*org_unit,	// Organizational unit
+			*locality,	// City/town
+			*state_province,// State/province
+			*country,	// Country
+			*common_name,	// Common name
+			*email;		// Email address
+  size_t		num_alt_names;	// Number of subject alternate names
+  char			**alt_names;	// Subject alternate names
+  char			*root_name;	// Root certificate/domain name
+  time_t		expiration_date;// Expiration date
+  cups_cred_cb_t	cb;		// Completion callback
+  void			*cb_data;	// Callback data
+} _http_tls_create_t;
+
+#ifdef HAVE_OPENSSL
+typedef EVP_PKEY *_http_tls_key_t;	// Private key
+#else // HAVE_GNUTLS
+typedef gnutls_x509_privkey_t _http_tls_key_t;
+					// Private key
+#endif // HAVE_OPENSSL
+
+
 //
 // Local globals...
 //
@@ -35,20 +97,65 @@ static char		*tls_keypath = NULL;
 					// Certificate store path
 static cups_mutex_t	tls_mutex = CUPS_MUTEX_INITIALIZER;
 					// Mutex for certificates
+static cups_cond_t	tls_pool_cond = CUPS_COND_INITIALIZER;
+					// Condition for key pool
+static size_t		tls_pool_count = 0;
+					// Number of pre-generated keys
+static _http_tls_key_t	tls_pool_keys[_HTTP_TLS_MAX_POOL_KEYS];
+					// Pre-generated keys
+static size_t		tls_pool_max = 0;
+					// Maximum number of pre-generated keys
+static cups_mutex_t	tls_pool_mutex = CUPS_MUTEX_INITIALIZER;
+					// Mutex for key pool
+#ifndef _WIN32
+static pthread_once_t	tls_pool_once = PTHREAD_ONCE_INIT;
+					// One-time initialization of fork handlers
+#endif // !_WIN32
+static bool		tls_pool_running = false;
+					// Is the key pool thread running?
+static cups_credtype_t	tls_pool_type = CUPS_CREDTYPE_DEFAULT;
+					// Type of pre-generated keys
 static int		tls_options = -1,// Options for TLS connections
 			tls_min_version = _HTTP_TLS_1_2,
 			tls_max_version = _HTTP_TLS_MAX;
+static cups_mutex_t	tls_session_mutex = CUPS_MUTEX_INITIALIZER;
+					// Mutex for client session cache
+static _http_tls_session_t tls_sessions[_HTTP_TLS_MAX_SESSIONS];
+					// Client session cache
+static cups_mutex_t	tls_trust_mutex = CUPS_MUTEX_INITIALIZER;
+					// Mutex for trust cache
+static _http_tls_trust_t tls_trusts[_HTTP_TLS_MAX_TRUSTS];
+					// Trust cache
 
 
 //
 // Local functions...
 //
 
+static void		http_clear_trust(void);
 static char		*http_copy_file(const char *path, const char *common_name, const char *ext);
+static _http_tls_key_t	http_copy_pool_key(cups_credtype_t type);
+static unsigned char	*http_copy_session(http_t *http, size_t *datalen);
+static void		*http_create_thread(_http_tls_create_t *create);
 static const char	*http_default_path(char *buffer, size_t bufsize);
 static bool		http_default_san_cb(const char *common_name, const char *subject_alt_name, void *data);
+static bool		http_find_trust(_http_tls_trust_t *trust);
+static void		http_free_create(_http_tls_create_t *create);
+static void		http_free_pool_key(_http_tls_key_t key);
+#ifndef _WIN32
+static void		http_key_pool_child(void);
+static void		http_key_pool_init_once(void);
+static void		http_key_pool_parent(void);
+static void		http_key_pool_prepare(void);
+#endif // !_WIN32
+static bool		http_key_pool_start(void);
+static void		*http_key_pool_thread(void *data);
 static const char	*http_make_path(char *buffer, size_t bufsize, const char *dirname, const char *filename, const char *ext);
+static void		http_make_trust(_http_tls_trust_t *trust, const char *path, const char *common_name, const char *credentials);
 static bool		http_save_file(const char *path, const char *common_name, const char *ext, const char *value);
+static void		http_save_session(http_t *http, const unsigned char *data, size_t datalen);
+static void		http_save_trust(_http_tls_trust_t *trust, time_t expiration);
+static char		*http_session_key(http_t *http, char *buffer, size_t bufsize);
 
 
 //
@@ -101,6 +208,96 @@ cupsCopyCredentialsRequest(
 }
 
 
+//
+// 'cupsCreateCredentialsAsync()' - Make an X.509 certificate and private key pair in the background.
+//
+// This function creates the same credentials as @link cupsCreateCredentials@
+// using a separate thread.  The callback function "cb" is called from that
+// thread with the common name and whether the credentials were created
+// successfully.
+//
+// Use @link cupsSetCredentialsKeyPool@ to pre-generate keys for new
+// credentials.
+//
+
+bool					// O - `true` if creation was started, `false` on error
+cupsCreateCredentialsAsync(
+    const char         *path,		// I - Directory path for certificate/key store or `NULL` for default
+    bool               ca_cert,		// I - `true` to create a CA certificate, `false` for a client/server certificate
+    cups_credpurpose_t purpose,		// I - Credential purposes
+    cups_credtype_t    type,		// I - Credential type
+    cups_credusage_t   usage,		// I - Credential usages
+    const char         *organization,	// I - Organization or `NULL` to use common name
+    const char         *org_unit,	// I - Organizational unit or `NULL` for none
+    const char         *locality,	// I - City/town or `NULL` for "Unknown"
+    const char         *state_province,	// I - State/province or `NULL` for "Unknown"
+    const char         *country,	// I - Country or `NULL` for locale-based default
+    const char         *common_name,	// I - Common name
+    const char         *email,		// I - Email address or `NULL` for none
+    size_t             num_alt_names,	// I - Number of subject alternate names
+    const char * const *alt_names,	// I - Subject Alternate Names
+    const char         *root_name,	// I - Root certificate/domain name or `NULL` for site/self-signed
+    time_t             expiration_date,	// I - Expiration date
+    cups_cred_cb_t     cb,		// I - Completion callback
+    void               *cb_data)	// I - Callback data
+{
+  _http_tls_create_t	*create;	// Creation data
+  size_t		i;		// Looping var
+  cups_thread_t		thread;		// Creation thread
+
+
+  DEBUG_printf("cupsCreateCredentialsAsync(path=\"%s\", ca_cert=%s, purpose=0x%x, type=%d, usage=0x%x, organization=\"%s\", org_unit=\"%s\", locality=\"%s\", state_province=\"%s\", country=\"%s\", common_name=\"%s\", num_alt_names=%u, alt_names=%p, root_name=\"%s\", expiration_date=%ld, cb=%p, cb_data=%p)", path, ca_cert ? "true" : "false", purpose, type, usage, organization, org_unit, locality, state_province, country, common_name, (unsigned)num_alt_names, alt_names, root_name, (long)expiration_date, cb, cb_data);
+
+  // Range check input...
+  if (!common_name || !cb || (num_alt_names > 0 && !alt_names))
+  {
+    _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(EINVAL), 0);
+    return (false);
+  }
+
+  // Copy the arguments for the creation thread...
+  if ((create = _cupsMemCalloc(CUPS_MEMTYPE_TLS, 1, sizeof(_http_tls_create_t) + num_alt_names * sizeof(char *))) == NULL)
+  {
+    _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(errno), 0);
+    return (false);
+  }
+
+  create->path            = _cupsStrAlloc(path);
+  create->ca_cert         = ca_cert;
+  create->purpose         = purpose;
+  create->type            = type;
+  create->usage           = usage;
+  create->organization    = _cupsStrAlloc(organization);
+  create->org_unit        = _cupsStrAlloc(org_unit);
+  create->locality        = _cupsStrAlloc(locality);
+  create->state_province  = _cupsStrAlloc(state_province);
+  create->country         = _cupsStrAlloc(country);
+  create->common_name     = _cupsStrAlloc(common_name);
+  create->email           = _cupsStrAlloc(email);
+  create->num_alt_names   = num_alt_names;
+  create->alt_names       = (char **)(create + 1);
+  create->root_name       = _cupsStrAlloc(root_name);
+  create->expiration_date = expiration_date;
+  create->cb              = cb;
+  create->cb_data         = cb_data;
+
+  for (i = 0; i < num_alt_names; i ++)
+    create->alt_names[i] = _cupsStrAlloc(alt_names[i]);
+
+  // Start the creation thread...
+  if ((thread = cupsThreadCreate((cups_thread_func_t)http_create_thread, create)) == CUPS_THREAD_INVALID)
+  {
+    _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(errno), 0);
+    http_free_create(create);
+    return (false);
+  }
+
+  cupsThreadDetach(thread);
+
+  return (true);
+}
+
+
 //
 // 'cupsSaveCredentials()' - Save the credentials associated with a printer/server.
 //
@@ -128,6 +325,66 @@ cupsSaveCredentials(
 }
 
 
+//
+// 'cupsSetCredentialsKeyPool()' - Set the number of pre-generated credential keys.
+//
+// This function starts a background thread that keeps up to "num_keys"
+// private keys of the specified type generated for use by
+// @link cupsCreateCredentials@, @link cupsCreateCredentialsAsync@, and
+// @link cupsCreateCredentialsRequest@.  Credentials using other key types
+// generate their keys as usual.
+//
+// Specify a "num_keys" value of `0` to stop the thread and free any unused
+// keys.
+//
+// Note: The key pool is shared by all threads in the running process.  This
+// function is threadsafe.  A child process created with `fork` discards the
+// keys inherited from its parent and generates its own.
+//
+
+bool					// O - `true` on success, `false` on error
+cupsSetCredentialsKeyPool(
+    cups_credtype_t type,		// I - Credential type
+    size_t          num_keys)		// I - Number of keys to pre-generate or `0` to disable
+{
+  bool		ret = true;		// Return value
+
+
+  DEBUG_printf("cupsSetCredentialsKeyPool(type=%d, num_keys=%u)", type, (unsigned)num_keys);
+
+  if (type == CUPS_CREDTYPE_DEFAULT)
+    type = CUPS_CREDTYPE_RSA_3072_SHA256;
+
+  if (num_keys > _HTTP_TLS_MAX_POOL_KEYS)
+    num_keys = _HTTP_TLS_MAX_POOL_KEYS;
+
+#ifndef _WIN32
+  pthread_once(&tls_pool_once, http_key_pool_init_once);
+#endif // !_WIN32
+
+  cupsMutexLock(&tls_pool_mutex);
+
+  // Free any keys that are no longer needed...
+  while (tls_pool_count > 0 && (type != tls_pool_type || tls_pool_count > num_keys))
+    http_free_pool_key(tls_pool_keys[-- tls_pool_count]);
+
+  tls_pool_type = type;
+  tls_pool_max  = num_keys;
+
+  // Start the key pool thread as needed...
+  if (num_keys > 0 && !tls_pool_running && !http_key_pool_start())
+  {
+    _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(errno), 0);
+    ret = false;
+  }
+
+  cupsCondBroadcast(&tls_pool_cond);
+  cupsMutexUnlock(&tls_pool_mutex);
+
+  return (ret);
+}
+
+
 //
 // 'cupsSetServerCredentials()' - Set the default server credentials.
 //
@@ -195,6 +452,19 @@ _httpTLSSetOptions(int options,		// I - Options
 }
 
 
+//
+// 'http_clear_trust()' - Clear the trust cache.
+//
+
+static void
+http_clear_trust(void)
+{
+  cupsMutexLock(&tls_trust_mutex);
+  memset(tls_trusts, 0, sizeof(tls_trusts));
+  cupsMutexUnlock(&tls_trust_mutex);
+}
+
+
 //
 // 'http_copy_file()' - Copy the contents of a file to a string.
 //
@@ -249,6 +519,111 @@ http_copy_file(const char *path,	// I - Directory
 }
 
 
+//
+// 'http_copy_pool_key()' - Copy a pre-generated key from the key pool.
+//
+
+static _http_tls_key_t			// O - Private key or `NULL` if none
+http_copy_pool_key(
+    cups_credtype_t type)		// I - Credential type
+{
+  _http_tls_key_t	key = NULL;	// Private key
+
+
+  if (type == CUPS_CREDTYPE_DEFAULT)
+    type = CUPS_CREDTYPE_RSA_3072_SHA256;
+
+  cupsMutexLock(&tls_pool_mutex);
+
+  if (tls_pool_count > 0 && tls_pool_type == type)
+  {
+    // Use the last key and let the key pool thread make another...
+    key = tls_pool_keys[-- tls_pool_count];
+
+    cupsCondBroadcast(&tls_pool_cond);
+  }
+  else if (tls_pool_max > 0 && !tls_pool_running)
+  {
+    // Restart the key pool thread in a child process...
+    http_key_pool_start();
+  }
+
+  cupsMutexUnlock(&tls_pool_mutex);
+
+  DEBUG_printf("4http_copy_pool_key: Returning %p.", (void *)key);
+
+  return (key);
+}
+
+
+//
+// 'http_copy_session()' - Copy the cached client session for a connection.
+//
+// The session cache is keyed by hostname and port and shared by all threads.
+// The returned data must be freed using `_cupsMemFree`.
+//
+
+static unsigned char *			// O - Serialized session data or `NULL` for none
+http_copy_session(http_t *http,		// I - HTTP connection
+                  size_t *datalen)	// O - Length of session data
+{
+  unsigned char		*data = NULL;	// Session data
+  char			key[300];	// Session key
+  _http_tls_session_t	*session;	// Current session
+  size_t		i;		// Looping var
+  time_t		curtime = time(NULL);
+					// Current time
+
+
+  *datalen = 0;
+
+  if (!http_session_key(http, key, sizeof(key)))
+    return (NULL);
+
+  cupsMutexLock(&tls_session_mutex);
+
+  for (i = 0, session = tls_sessions; i < _HTTP_TLS_MAX_SESSIONS; i ++, session ++)
+  {
+    if (session->data && !strcmp(session->key, key))
+    {
+      if ((curtime - session->time) < _HTTP_TLS_SESSION_TIME && (data = _cupsMemAlloc(CUPS_MEMTYPE_TLS, session->datalen)) != NULL)
+      {
+        memcpy(data, session->data, session->datalen);
+        *datalen = session->datalen;
+      }
+      break;
+    }
+  }
+
+  cupsMutexUnlock(&tls_session_mutex);
+
+  DEBUG_printf("4http_copy_session: key=\"%s\", datalen=%u", key, (unsigned)*datalen);
+
+  return (data);
+}
+
+
+//
+// 'http_create_thread()' - Create credentials in the background.
+//
+
+static void *				// O - Thread exit status
+http_create_thread(
+    _http_tls_create_t *create)		// I - Creation data
+{
+  bool	result;				// Result of creation
+
+
+  result = cupsCreateCredentials(create->path, create->ca_cert, create->purpose, create->type, create->usage, create->organization, create->org_unit, create->locality, create->state_province, create->country, create->common_name, create->email, create->num_alt_names, (const char * const *)create->alt_names, create->root_name, create->expiration_date);
+
+  (create->cb)(create->cb_data, create->common_name, result);
+
+  http_free_create(create);
+
+  return (NULL);
+}
+
+
 //
 // 'http_default_path()' - Get the default credential store path.
 //
@@ -325,6 +700,232 @@ http_default_san_cb(
 }
 
 
+//
+// 'http_find_trust()' - Find a cached trust decision.
+//
+// Only successful (`HTTP_TRUST_OK`) trust decisions are cached.  A cached
+// decision is used if the credentials, common name, store path, and trust
+// settings match and the stored credentials have not changed since the
+// decision was made.
+//
+
+static bool				// O - `true` if the credentials are trusted, `false` if unknown
+http_find_trust(
+    _http_tls_trust_t *trust)		// I - Trust lookup data
+{
+  bool			found = false;	// Found trust decision?
+  _http_tls_trust_t	*current;	// Current trust decision
+  size_t		i;		// Looping var
+  time_t		curtime = time(NULL);
+					// Current time
+
+
+  cupsMutexLock(&tls_trust_mutex);
+
+  for (i = 0, current = tls_trusts; i < _HTTP_TLS_MAX_TRUSTS; i ++, current ++)
+  {
+    if (current->expires > curtime && !memcmp(current->hash, trust->hash, sizeof(trust->hash)) && !strcmp(current->key, trust->key))
+    {
+      found = current->cmtime == trust->cmtime && current->smtime == trust->smtime;
+      break;
+    }
+  }
+
+  cupsMutexUnlock(&tls_trust_mutex);
+
+  DEBUG_printf("4http_find_trust: key=\"%s\", found=%s", trust->key, found ? "true" : "false");
+
+  return (found);
+}
+
+
+//
+// 'http_free_create()' - Free asynchronous credential creation data.
+//
+
+static void
+http_free_create(
+    _http_tls_create_t *create)		// I - Creation data
+{
+  size_t	i;			// Looping var
+
+
+  _cupsStrFree(create->path);
+  _cupsStrFree(create->organization);
+  _cupsStrFree(create->org_unit);
+  _cupsStrFree(create->locality);
+  _cupsStrFree(create->state_province);
+  _cupsStrFree(create->country);
+  _cupsStrFree(create->common_name);
+  _cupsStrFree(create->email);
+  _cupsStrFree(create->root_name);
+
+  for (i = 0; i < create->num_alt_names; i ++)
+    _cupsStrFree(create->alt_names[i]);
+
+  _cupsMemFree(create);
+}
+
+
+//
+// 'http_free_pool_key()' - Free a pre-generated key.
+//
+
+static void
+http_free_pool_key(_http_tls_key_t key)	// I - Private key
+{
+#ifdef HAVE_OPENSSL
+  EVP_PKEY_free(key);
+#else // HAVE_GNUTLS
+  gnutls_x509_privkey_deinit(key);
+#endif // HAVE_OPENSSL
+}
+
+
+#ifndef _WIN32
+//
+// 'http_key_pool_child()' - Discard the parent's keys in a child process.
+//
+// The key pool thread does not exist in the child, and the child must not use
+// the same keys as its parent.  The thread is restarted by the next call to
+// http_copy_pool_key().
+//
+
+static void
+http_key_pool_child(void)
+{
+  while (tls_pool_count > 0)
+    http_free_pool_key(tls_pool_keys[-- tls_pool_count]);
+
+  tls_pool_running = false;
+
+  pthread_cond_init(&tls_pool_cond, NULL);
+  cupsMutexUnlock(&tls_pool_mutex);
+}
+
+
+//
+// 'http_key_pool_init_once()' - Register the fork handlers.
+//
+
+static void
+http_key_pool_init_once(void)
+{
+  pthread_atfork(http_key_pool_prepare, http_key_pool_parent, http_key_pool_child);
+}
+
+
+//
+// 'http_key_pool_parent()' - Unlock the key pool in the parent process.
+//
+
+static void
+http_key_pool_parent(void)
+{
+  cupsMutexUnlock(&tls_pool_mutex);
+}
+
+
+//
+// 'http_key_pool_prepare()' - Lock the key pool before forking.
+//
+
+static void
+http_key_pool_prepare(void)
+{
+  cupsMutexLock(&tls_pool_mutex);
+}
+#endif // !_WIN32
+
+
+//
+// 'http_key_pool_start()' - Start the key pool thread.
+//
+// The key pool mutex must be held by the caller.
+//
+
+static bool				// O - `true` on success, `false` on error
+http_key_pool_start(void)
+{
+  cups_thread_t	thread;			// Key pool thread
+
+
+  if ((thread = cupsThreadCreate((cups_thread_func_t)http_key_pool_thread, NULL)) == CUPS_THREAD_INVALID)
+  {
+    tls_pool_max = 0;
+    return (false);
+  }
+
+  cupsThreadDetach(thread);
+  tls_pool_running = true;
+
+  return (true);
+}
+
+
+//
+// 'http_key_pool_thread()' - Pre-generate keys for new credentials.
+//
+
+static void *				// O - Thread exit status
+http_key_pool_thread(void *data)	// I - Thread data (unused)
+{
+  cups_credtype_t	type;		// Credential type
+  _http_tls_key_t	key;		// New private key
+
+
+  (void)data;
+
+  cupsMutexLock(&tls_pool_mutex);
+
+  while (tls_pool_max > 0)
+  {
+    if (tls_pool_count >= tls_pool_max)
+    {
+      // Wait for a key to be used or the pool to be changed...
+      cupsCondWait(&tls_pool_cond, &tls_pool_mutex, 0.0);
+      continue;
+    }
+
+    // Generate a key without holding the pool lock...
+    type = tls_pool_type;
+
+    cupsMutexUnlock(&tls_pool_mutex);
+
+#ifdef HAVE_OPENSSL
+    key = openssl_create_key(type);
+#else // HAVE_GNUTLS
+    key = gnutls_create_key(type);
+#endif // HAVE_OPENSSL
+
+    cupsMutexLock(&tls_pool_mutex);
+
+    if (!key)
+    {
+      // Stop if we are unable to generate keys...
+      DEBUG_printf("4http_key_pool_thread: Unable to create key: %s", cupsGetErrorString());
+      tls_pool_max = 0;
+      break;
+    }
+    else if (type == tls_pool_type && tls_pool_count < tls_pool_max)
+    {
+      tls_pool_keys[tls_pool_count ++] = key;
+    }
+    else
+    {
+      // Pool changed while generating the key...
+      http_free_pool_key(key);
+    }
+  }
+
+  tls_pool_running = false;
+
+  cupsMutexUnlock(&tls_pool_mutex);
+
+  return (NULL);
+}
+
+
 //
 // 'http_make_path()' - Format a filename for a certificate or key file.
 //
@@ -363,6 +964,36 @@ http_make_path(
 }
 
 
+//
+// 'http_make_trust()' - Make the trust cache lookup data for credentials.
+//
+
+static void
+http_make_trust(
+    _http_tls_trust_t *trust,		// I - Trust lookup data
+    const char        *path,		// I - Directory path for certificate/key store
+    const char        *common_name,	// I - Common name for trust lookup
+    const char        *credentials)	// I - Credentials
+{
+  _cups_globals_t *cg = _cupsGlobals();	// Per-thread globals
+  char		filename[1024];		// Credentials filename
+  struct stat	fileinfo;		// File information
+
+
+  memset(trust, 0, sizeof(_http_tls_trust_t));
+
+  snprintf(trust->key, sizeof(trust->key), "%s/%s:%d,%d,%d,%d", path, common_name, cg->any_root, cg->expired_certs, cg->trust_first, cg->validate_certs);
+
+  cupsHashData("sha2-256", credentials, strlen(credentials), trust->hash, sizeof(trust->hash));
+
+  if (!stat(http_make_path(filename, sizeof(filename), path, common_name, "crt"), &fileinfo))
+    trust->cmtime = fileinfo.st_mtime;
+
+  if (!stat(http_make_path(filename, sizeof(filename), path, "_site_", "crt"), &fileinfo))
+    trust->smtime = fileinfo.st_mtime;
+}
+
+
 //
 // 'http_save_file()' - Save a string to a file.
 //
@@ -398,7 +1029,131 @@ http_save_file(const char *path,	// I - Directory path for certificate/key store
 
   close(fd);
 
+  // Forget any trust decisions that might depend on the old file...
+  http_clear_trust();
+
   return (true);
 }
 
 
+//
+// 'http_save_session()' - Save the client session for a connection.
+//
+// The oldest session is replaced when the cache is full.
+//
+
+static void
+http_save_session(
+    http_t              *http,		// I - HTTP connection
+    const unsigned char *data,		// I - Serialized session data
+    size_t              datalen)	// I - Length of session data
+{
+  char			key[300];	// Session key
+  _http_tls_session_t	*session,	// Current session
+			*oldest;	// Oldest (or matching) session
+  size_t		i;		// Looping var
+  unsigned char		*copy;		// Copy of session data
+
+
+  if (!data || datalen == 0 || !http_session_key(http, key, sizeof(key)))
+    return;
+
+  if ((copy = _cupsMemAlloc(CUPS_MEMTYPE_TLS, datalen)) == NULL)
+    return;
+
+  memcpy(copy, data, datalen);
+
+  DEBUG_printf("4http_save_session: key=\"%s\", datalen=%u", key, (unsigned)datalen);
+
+  cupsMutexLock(&tls_session_mutex);
+
+  for (i = 0, session = tls_sessions, oldest = tls_sessions; i < _HTTP_TLS_MAX_SESSIONS; i ++, session ++)
+  {
+    if (session->data && !strcmp(session->key, key))
+    {
+      oldest = session;
+      break;
+    }
+    else if (!session->data || (oldest->data && session->time < oldest->time))
+    {
+      oldest = session;
+    }
+  }
+
+  _cupsMemFree(oldest->data);
+
+  cupsCopyString(oldest->key, key, sizeof(oldest->key));
+  oldest->time    = time(NULL);
+  oldest->data    = copy;
+  oldest->datalen = datalen;
+
+  cupsMutexUnlock(&tls_session_mutex);
+}
+
+
+//
+// 'http_save_trust()' - Save a successful trust decision.
+//
+// Decisions are kept for up to five minutes but never past the expiration
+// date of the credentials.  The oldest decision is replaced when the cache is
+// full.
+//
+
+static void
+http_save_trust(
+    _http_tls_trust_t *trust,		// I - Trust lookup data
+    time_t            expiration)	// I - Expiration date of credentials
+{
+  _http_tls_trust_t	*current,	// Current trust decision
+			*oldest;	// Oldest (or matching) trust decision
+  size_t		i;		// Looping var
+
+
+  trust->expires = time(NULL) + _HTTP_TLS_TRUST_TIME;
+
+  if (!_cupsGlobals()->expired_certs && expiration < trust->expires)
+    trust->expires = expiration;
+
+  DEBUG_printf("4http_save_trust: key=\"%s\", expires=%ld", trust->key, (long)trust->expires);
+
+  cupsMutexLock(&tls_trust_mutex);
+
+  for (i = 0, current = tls_trusts, oldest = tls_trusts; i < _HTTP_TLS_MAX_TRUSTS; i ++, current ++)
+  {
+    if (!memcmp(current->hash, trust->hash, sizeof(trust->hash)) && !strcmp(current->key, trust->key))
+    {
+      oldest = current;
+      break;
+    }
+    else if (current->expires < oldest->expires)
+    {
+      oldest = current;
+    }
+  }
+
+  *oldest = *trust;
+
+  cupsMutexUnlock(&tls_trust_mutex);
+}
+
+
+//
+// 'http_session_key()' - Make the session cache key for a connection.
+//
+// Sessions are only cached for client connections.
+//
+
+static char *				// O - Session key or `NULL` if not cached
+http_session_key(http_t *http,		// I - HTTP connection
+                 char   *buffer,	// I - Key buffer
+                 size_t bufsize)	// I - Size of key buffer
+{
+  if (http->mode != _HTTP_MODE_CLIENT || !http->hostaddr || !http->hostname[0])
+    return (NULL);
+
+  snprintf(buffer, bufsize, "%s:%d", http->hostname, httpAddrGetPort(http->hostaddr));
+
+  return (buffer);
+}
+
+
@@ -19,6 +19,12 @@
 #ifdef HAVE_ICONV_H
 #  include <iconv.h>
 #endif // HAVE_ICONV_H
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#  include <arm_neon.h>
+#  define _CUPS_TRANSCODE_NEON 1
+#endif // __SSE2__
 
 
 //
@@ -111,6 +117,7 @@ static cups_encoding_t	map_encoding = CUPS_ENCODING_AUTO;
 // Local functions...
 //
 
+static size_t		count_ascii(const char *s, size_t len);
 static void		flush_map(void);
 
 
@@ -126,9 +133,10 @@ cupsCharsetToUTF8(
     const cups_encoding_t encoding)	// I - Encoding
 {
   char		*destptr;		// Pointer into UTF-8 buffer
-#ifdef HAVE_ICONV_H
   size_t	srclen,			// Length of source string
-		outBytesLeft;		// Bytes remaining in output buffer
+		count;			// Number of US-ASCII characters
+#ifdef HAVE_ICONV_H
+  size_t	outBytesLeft;		// Bytes remaining in output buffer
 #endif // HAVE_ICONV_H
 
 
@@ -148,6 +156,22 @@ cupsCharsetToUTF8(
     return ((ssize_t)strlen((char *)dest));
   }
 
+  // Single-byte character sets are all supersets of US-ASCII, so copy pure
+  // US-ASCII strings as-is (ISO-8859-1 is handled below)...
+  srclen = strlen(src);
+  count  = count_ascii(src, srclen);
+
+  if (count == srclen && encoding < CUPS_ENCODING_SBCS_END && encoding != CUPS_ENCODING_ISO8859_1)
+  {
+    if (count > (maxout - 1))
+      count = maxout - 1;
+
+    memcpy(dest, src, count);
+    dest[count] = '\0';
+
+    return ((ssize_t)count);
+  }
+
   // Handle ISO-8859-1 to UTF-8 directly...
   destptr = dest;
 
@@ -155,12 +179,25 @@ cupsCharsetToUTF8(
   {
     int		ch;			// Character from string
     char	*destend;		// End of UTF-8 buffer
+    const char	*srcend;		// End of source string
 
 
     destend = dest + maxout - 2;
+    srcend  = src + srclen;
 
     while (*src && destptr < destend)
     {
+      // Copy any run of US-ASCII characters...
+      if ((count = count_ascii(src, (size_t)(srcend - src))) > (size_t)(destend - destptr))
+        count = (size_t)(destend - destptr);
+
+      memcpy(destptr, src, count);
+      destptr += count;
+      src     += count;
+
+      if (!*src || destptr >= destend)
+        break;
+
       ch = *src++ & 255;
 
       if (ch & 128)
@@ -198,7 +235,6 @@ cupsCharsetToUTF8(
   {
     char *altdestptr = (char *)dest;	// Silence bogus GCC type-punned
 
-    srclen       = strlen(src);
     outBytesLeft = maxout - 1;
 
     iconv(map_to_utf8, (char **)&src, &srclen, &altdestptr, &outBytesLeft);
@@ -270,9 +306,10 @@ cupsUTF8ToCharset(
     const cups_encoding_t encoding)	// I - Encoding
 {
   char		*destptr;		// Pointer into destination
-#ifdef HAVE_ICONV_H
   size_t	srclen,			// Length of source string
-		outBytesLeft;		// Bytes remaining in output buffer
+		count;			// Number of US-ASCII characters
+#ifdef HAVE_ICONV_H
+  size_t	outBytesLeft;		// Bytes remaining in output buffer
 #endif // HAVE_ICONV_H
 
 
@@ -292,6 +329,22 @@ cupsUTF8ToCharset(
     return ((ssize_t)strlen(dest));
   }
 
+  // Single-byte character sets are all supersets of US-ASCII, so copy pure
+  // US-ASCII strings as-is...
+  srclen = strlen(src);
+  count  = count_ascii(src, srclen);
+
+  if (count == srclen && encoding < CUPS_ENCODING_SBCS_END)
+  {
+    if (count > (maxout - 1))
+      count = maxout - 1;
+
+    memcpy(dest, src, count);
+    dest[count] = '\0';
+
+    return ((ssize_t)count);
+  }
+
  /*
   * Handle UTF-8 to ISO-8859-1 directly...
   */
@@ -303,16 +356,32 @@ cupsUTF8ToCharset(
     int		ch,			// Character from string
 		maxch;			// Maximum character for charset
     char	*destend;		// End of ISO-8859-1 buffer
+    const char	*srcend;		// End of source string
 
     maxch   = encoding == CUPS_ENCODING_ISO8859_1 ? 256 : 128;
     destend = dest + maxout - 1;
+    srcend  = src + srclen;
 
     while (*src && destptr < destend)
     {
+      // Copy any run of US-ASCII characters...
+      if ((count = count_ascii(src, (size_t)(srcend - src))) > (size_t)(destend - destptr))
+        count = (size_t)(destend - destptr);
+
+      memcpy(destptr, src, count);
+      destptr += count;
+      src     += count;
+
+      if (!*src || destptr >= destend)
+        break;
+
       ch = *src++;
 
       if ((ch & 0xe0) == 0xc0)
       {
+        if (!*src)
+          break;			// Don't read past a truncated sequence
+
 	ch = ((ch & 0x1f) << 6) | (*src++ & 0x3f);
 
 	if (ch < maxch)
@@ -356,7 +425,6 @@ cupsUTF8ToCharset(
   {
     char *altsrc = (char *)src;		// Silence bogus GCC type-punned
 
-    srclen       = strlen((char *)src);
     outBytesLeft = maxout - 1;
 
     iconv(map_from_utf8, &altsrc, &srclen, &destptr, &outBytesLeft);
@@ -390,7 +458,10 @@ cupsUTF8ToUTF32(
     const char   *src,			// I - Source string
     const size_t maxout)		// I - Max output in words
 {
-  size_t	i;			// Looping variable
+  size_t	i,			// Looping variable
+		count,			// Number of US-ASCII characters
+		srclen;			// Length of source string
+  const char	*srcend;		// End of source string
   int		ch,			// Character value
 		next;			// Next character value
   cups_utf32_t	ch32;			// UTF-32 character value
@@ -404,8 +475,24 @@ cupsUTF8ToUTF32(
     return (-1);
 
   // Convert input UTF-8 to output UTF-32...
+  srclen = strnlen(src, 4 * maxout);
+  srcend = src + srclen;
+
   for (i = maxout - 1; *src && i > 0; i --)
   {
+    // Widen any run of US-ASCII characters...
+    if ((count = count_ascii(src, (size_t)(srcend - src))) > 1)
+    {
+      if (count > i)
+        count = i;
+
+      for (i -= count; count > 0; count --)
+        *dest++ = (cups_utf32_t)*src++;
+
+      if (!*src || i == 0)
+        break;
+    }
+
     ch = *src++;
 
     // Convert UTF-8 character(s) to UTF-32 character...
@@ -589,6 +676,44 @@ cupsUTF32ToUTF8(
 }
 
 
+//
+// 'count_ascii()' - Count the leading US-ASCII characters in a string.
+//
+// The string must not contain a `nul` within the first "len" characters.
+//
+
+static size_t				// O - Number of US-ASCII characters
+count_ascii(const char *s,		// I - String
+            size_t     len)		// I - Number of characters to check
+{
+  size_t	count = 0;		// Number of US-ASCII characters
+
+
+#ifdef __SSE2__
+  // Check 16 characters at a time using the sign bit of each byte...
+  for (; (count + 16) <= len; count += 16)
+  {
+    if (_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)(s + count))))
+      break;
+  }
+
+#elif defined(_CUPS_TRANSCODE_NEON)
+  // Check 16 characters at a time using the maximum byte value...
+  for (; (count + 16) <= len; count += 16)
+  {
+    if (vmaxvq_u8(vld1q_u8((const uint8_t *)s + count)) & 0x80)
+      break;
+  }
+#endif // __SSE2__
+
+  // Check the remaining characters one at a time...
+  while (count < len && !(s[count] & 0x80))
+    count ++;
+
+  return (count);
+}
+
+
 //
 // 'flush_map()' - Flush all character set maps out of cache.
 //
@@ -80,6 +80,17 @@ typedef struct _cups_client_conf_s	// client.conf config data
 } _cups_client_conf_t;
 
 
+//
+// Local globals...
+//
+
+static cups_mutex_t	cups_conf_mutex = CUPS_MUTEX_INITIALIZER;
+					// Mutex for cached client.conf values
+static char		cups_conf_key[2048] = "";
+					// Key for cached client.conf values
+static _cups_client_conf_t cups_conf;	// Cached client.conf values
+
+
 //
 // Local functions...
 //
@@ -91,7 +102,8 @@ static int	cups_apple_get_string(CFStringRef key, char *value, size_t valsize);
 static int	cups_boolean_value(const char *value);
 static void	cups_finalize_client_conf(_cups_client_conf_t *cc);
 static void	cups_init_client_conf(_cups_client_conf_t *cc);
-static void	cups_read_client_conf(cups_file_t *fp, _cups_client_conf_t *cc);
+static bool	cups_make_conf_key(_cups_globals_t *cg, char *key, size_t keysize);
+static void	cups_read_client_conf(cups_conf_t *conf, _cups_client_conf_t *cc);
 static void	cups_set_default_ipp_port(_cups_globals_t *cg);
 static void	cups_set_digestoptions(_cups_client_conf_t *cc, const char *value);
 static void	cups_set_encryption(_cups_client_conf_t *cc, const char *value);
@@ -821,39 +833,63 @@ _cupsGetPassword(const char *prompt)	// I - Prompt string
 void
 _cupsSetDefaults(void)
 {
-  cups_file_t	*fp;			// File
-  char		filename[1024];		// Filename
+  cups_conf_t	*conf;			// client.conf file
+  char		filename[1024],		// Filename
+		key[2048];		// Key for cached values
+  bool		cacheable;		// Can the values be cached?
   _cups_client_conf_t cc;		// client.conf values
   _cups_globals_t *cg = _cupsGlobals();	// Pointer to library globals
 
 
   DEBUG_puts("_cupsSetDefaults()");
 
-  // Load initial client.conf values...
-  cups_init_client_conf(&cc);
+  // The client.conf values are shared by all threads until the files or
+  // environment variables change...
+  cacheable = cups_make_conf_key(cg, key, sizeof(key));
 
-  // Read the /etc/cups/client.conf and ~/.cups/client.conf files, if present.
-  snprintf(filename, sizeof(filename), "%s/client.conf", cg->sysconfig);
-  if ((fp = cupsFileOpen(filename, "r")) != NULL)
+  cupsMutexLock(&cups_conf_mutex);
+
+  if (cacheable && !strcmp(key, cups_conf_key))
   {
-    cups_read_client_conf(fp, &cc);
-    cupsFileClose(fp);
+    DEBUG_puts("1_cupsSetDefaults: Using cached client.conf values.");
+    cc = cups_conf;
   }
-
-  if (cg->userconfig)
+  else
   {
-    // Look for client.conf...
-    snprintf(filename, sizeof(filename), "%s/client.conf", cg->userconfig);
+    // Load initial client.conf values...
+    cups_init_client_conf(&cc);
 
-    if ((fp = cupsFileOpen(filename, "r")) != NULL)
+    // Read the /etc/cups/client.conf and ~/.cups/client.conf files, if present.
+    snprintf(filename, sizeof(filename), "%s/client.conf", cg->sysconfig);
+    if ((conf = cupsConfOpen(filename)) != NULL)
     {
-      cups_read_client_conf(fp, &cc);
-      cupsFileClose(fp);
+      cups_read_client_conf(conf, &cc);
+      cupsConfClose(conf);
+    }
+
+    if (cg->userconfig)
+    {
+      // Look for client.conf...
+      snprintf(filename, sizeof(filename), "%s/client.conf", cg->userconfig);
+
+      if ((conf = cupsConfOpen(filename)) != NULL)
+      {
+	cups_read_client_conf(conf, &cc);
+	cupsConfClose(conf);
+      }
+    }
+
+    // Finalize things so every client.conf value is set...
+    cups_finalize_client_conf(&cc);
+
+    if (cacheable)
+    {
+      cups_conf = cc;
+      cupsCopyString(cups_conf_key, key, sizeof(cups_conf_key));
     }
   }
 
-  // Finalize things so every client.conf value is set...
-  cups_finalize_client_conf(&cc);
+  cupsMutexUnlock(&cups_conf_mutex);
 
   cg->uatokens = cc.uatokens;
 
@@ -1080,26 +1116,30 @@ cups_finalize_client_conf(
     const char *envuser = getenv("USER");	// Default username
     struct passwd pw;				// Account information
     struct passwd *result = NULL;		// Auxiliary pointer
-    _cups_globals_t *cg = _cupsGlobals();	// Pointer to library globals
+    char	*pw_buf;			// Buffer for account information
 
-    if (envuser)
+    if ((pw_buf = _cupsBufferGet(PW_BUF_SIZE)) != NULL)
     {
-      // Validate USER matches the current UID, otherwise don't allow it to
-      // override things.  This makes sure that printing after doing su or sudo
-      // records the correct username.
-      getpwnam_r(envuser, &pw, cg->pw_buf, PW_BUF_SIZE, &result);
-      if (result && pw.pw_uid != getuid())
-        result = NULL;
-    }
+      if (envuser)
+      {
+	// Validate USER matches the current UID, otherwise don't allow it to
+	// override things.  This makes sure that printing after doing su or
+	// sudo records the correct username.
+	getpwnam_r(envuser, &pw, pw_buf, PW_BUF_SIZE, &result);
+	if (result && pw.pw_uid != getuid())
+	  result = NULL;
+      }
 
-    if (!result)
-      getpwuid_r(getuid(), &pw, cg->pw_buf, PW_BUF_SIZE, &result);
+      if (!result)
+	getpwuid_r(getuid(), &pw, pw_buf, PW_BUF_SIZE, &result);
 
-    if (result)
-    {
-      cupsCopyString(cc->user, pw.pw_name, sizeof(cc->user));
+      if (result)
+	cupsCopyString(cc->user, pw.pw_name, sizeof(cc->user));
+
+      _cupsBufferRelease(pw_buf);
     }
-    else
+
+    if (!result)
 #endif // _WIN32
     {
       // Use the default "unknown" user name...
@@ -1188,50 +1228,116 @@ cups_init_client_conf(
 }
 
 
+//
+// 'cups_make_conf_key()' - Make a key for the cached client.conf values.
+//
+// The key combines the modification time and size of each client.conf file
+// with the environment variables that override them.
+//
+
+static bool				// O - `true` on success, `false` if the key is too long
+cups_make_conf_key(
+    _cups_globals_t *cg,		// I - Global data
+    char            *key,		// I - Key buffer
+    size_t          keysize)		// I - Size of key buffer
+{
+  char		*keyptr,		// Pointer into key
+		*keyend,		// End of key
+		filename[1024];		// client.conf filename
+  struct stat	fileinfo;		// client.conf information
+  const char	*value;			// Environment variable value
+  size_t	i;			// Looping var
+  int		bytes;			// Bytes added
+  static const char * const envvars[] =	// Environment variables
+  {
+    "CUPS_ANYROOT",
+    "CUPS_ENCRYPTION",
+    "CUPS_EXPIREDCERTS",
+    "CUPS_SERVER",
+    "CUPS_TRUSTFIRST",
+    "CUPS_USER",
+    "CUPS_VALIDATECERTS",
+    "USER"
+  };
+
+
+  keyptr = key;
+  keyend = key + keysize;
+
+  for (i = 0; i < 2; i ++)
+  {
+    if (i == 0)
+      snprintf(filename, sizeof(filename), "%s/client.conf", cg->sysconfig);
+    else if (cg->userconfig)
+      snprintf(filename, sizeof(filename), "%s/client.conf", cg->userconfig);
+    else
+      break;
+
+    if (stat(filename, &fileinfo))
+      bytes = snprintf(keyptr, (size_t)(keyend - keyptr), "-;");
+    else
+      bytes = snprintf(keyptr, (size_t)(keyend - keyptr), "%ld.%ld;", (long)fileinfo.st_mtime, (long)fileinfo.st_size);
+
+    if (bytes < 0 || bytes >= (keyend - keyptr))
+      return (false);
+
+    keyptr += bytes;
+  }
+
+  for (i = 0; i < (sizeof(envvars) / sizeof(envvars[0])); i ++)
+  {
+    if ((value = getenv(envvars[i])) != NULL)
+      bytes = snprintf(keyptr, (size_t)(keyend - keyptr), "=%s\n", value);
+    else
+      bytes = snprintf(keyptr, (size_t)(keyend - keyptr), "!");
+
+    if (bytes < 0 || bytes >= (keyend - keyptr))
+      return (false);
+
+    keyptr += bytes;
+  }
+
+  return (true);
+}
+
+
 //
 // 'cups_read_client_conf()' - Read a client.conf file.
 //
 
 static void
 cups_read_client_conf(
-    cups_file_t         *fp,		// I - File to read
+    cups_conf_t         *conf,		// I - client.conf file
     _cups_client_conf_t *cc)		// I - client.conf values
 {
-  int	linenum;			// Current line number
-  char	line[1024],			// Line from file
-        *value;				// Pointer into line
+  const char	*value;			// Directive value
 
 
-  // Read from the file...
-  linenum = 0;
-  while (cupsFileGetConf(fp, line, sizeof(line), &value, &linenum))
-  {
-    if (!_cups_strcasecmp(line, "DigestOptions") && value)
-      cups_set_digestoptions(cc, value);
-    else if (!_cups_strcasecmp(line, "Encryption") && value)
-      cups_set_encryption(cc, value);
+  // Look up the directives we support; later lines override earlier ones...
+  if ((value = cupsConfGetValue(conf, "DigestOptions")) != NULL)
+    cups_set_digestoptions(cc, value);
+  if ((value = cupsConfGetValue(conf, "Encryption")) != NULL)
+    cups_set_encryption(cc, value);
 #ifndef __APPLE__
-    // The ServerName directive is not supported on macOS due to app
-    // sandboxing restrictions, i.e. not all apps request network access.
-    else if (!_cups_strcasecmp(line, "ServerName") && value)
-      cups_set_server_name(cc, value);
+  // The ServerName directive is not supported on macOS due to app
+  // sandboxing restrictions, i.e. not all apps request network access.
+  if ((value = cupsConfGetValue(conf, "ServerName")) != NULL)
+    cups_set_server_name(cc, value);
 #endif // !__APPLE__
-    else if (!_cups_strcasecmp(line, "User") && value)
-      cups_set_user(cc, value);
-    else if (!_cups_strcasecmp(line, "UserAgentTokens") && value)
-      cups_set_uatokens(cc, value);
-    else if (!_cups_strcasecmp(line, "TrustOnFirstUse") && value)
-      cc->trust_first = cups_boolean_value(value);
-    else if (!_cups_strcasecmp(line, "AllowAnyRoot") && value)
-      cc->any_root = cups_boolean_value(value);
-    else if (!_cups_strcasecmp(line, "AllowExpiredCerts") &&
-             value)
-      cc->expired_certs = cups_boolean_value(value);
-    else if (!_cups_strcasecmp(line, "ValidateCerts") && value)
-      cc->validate_certs = cups_boolean_value(value);
-    else if (!_cups_strcasecmp(line, "SSLOptions") && value)
-      cups_set_ssl_options(cc, value);
-  }
+  if ((value = cupsConfGetValue(conf, "User")) != NULL)
+    cups_set_user(cc, value);
+  if ((value = cupsConfGetValue(conf, "UserAgentTokens")) != NULL)
+    cups_set_uatokens(cc, value);
+  if ((value = cupsConfGetValue(conf, "TrustOnFirstUse")) != NULL)
+    cc->trust_first = cups_boolean_value(value);
+  if ((value = cupsConfGetValue(conf, "AllowAnyRoot")) != NULL)
+    cc->any_root = cups_boolean_value(value);
+  if ((value = cupsConfGetValue(conf, "AllowExpiredCerts")) != NULL)
+    cc->expired_certs = cups_boolean_value(value);
+  if ((value = cupsConfGetValue(conf, "ValidateCerts")) != NULL)
+    cc->validate_certs = cups_boolean_value(value);
+  if ((value = cupsConfGetValue(conf, "SSLOptions")) != NULL)
+    cups_set_ssl_options(cc, value);
 }
 
 
@@ -1318,7 +1424,7 @@ cups_set_ssl_options(
     _cups_client_conf_t *cc,		// I - client.conf values
     const char          *value)		// I - Value
 {
-  // SSLOptions [AllowRC4] [AllowSSL3] [AllowDH] [DenyTLS1.0] [None]
+  // SSLOptions [AllowRC4] [AllowSSL3] [AllowDH] [AllowKTLS] [DenyTLS1.0] [None]
   int	options = _HTTP_TLS_NONE,	// TLS options
 	min_version = _HTTP_TLS_1_0,	// Minimum TLS version
 	max_version = _HTTP_TLS_MAX;	// Maximum TLS version
@@ -1346,6 +1452,8 @@ cups_set_ssl_options(
       min_version = _HTTP_TLS_SSL3;
     else if (!_cups_strcasecmp(start, "AllowDH"))
       options |= _HTTP_TLS_ALLOW_DH;
+    else if (!_cups_strcasecmp(start, "AllowKTLS"))
+      options |= _HTTP_TLS_ALLOW_KTLS;
     else if (!_cups_strcasecmp(start, "DenyCBC"))
       options |= _HTTP_TLS_DENY_CBC;
     else if (!_cups_strcasecmp(start, "DenyTLS1.0"))
@@ -19,6 +19,46 @@
 #endif // _WIN32 || __EMX__
 
 
+//
+// Local types...
+//
+
+typedef struct _cups_joblist_s		// cupsGetJobs job list
+{
+  size_t	num_jobs,		// Number of jobs
+		alloc_jobs;		// Allocated jobs
+  cups_job_t	*jobs;			// Jobs
+  bool		error;			// Out of memory?
+} _cups_joblist_t;
+
+typedef struct _cups_jobs_s		// cupsGetJobsIter decoding data
+{
+  cups_job_cb_t	cb;			// Job callback function
+  void		*cb_data;		// Job callback data
+  size_t	count,			// Number of jobs in this response
+		skip;			// Number of jobs to skip
+  int		first_id;		// First job ID in this response
+  bool		in_job,			// In a job group?
+		retry,			// Retry without "first-index"?
+		stopped,		// Did the callback stop?
+		unpaged;		// Is "first-index" unsupported?
+  cups_job_t	job;			// Current job
+  char		dest[256],		// Printer or class name
+		format[256],		// Document format
+		title[1024],		// Title/job name
+		user[256];		// User that submitted the job
+} _cups_jobs_t;
+
+
+//
+// Local functions...
+//
+
+static bool	cups_joblist_cb(_cups_joblist_t *list, const cups_job_t *job);
+static bool	cups_jobs_cb(_cups_jobs_t *data, ipp_tag_t group, ipp_attribute_t *attr);
+static bool	cups_jobs_finish(_cups_jobs_t *data);
+
+
 //
 // 'cupsFreeJobs()' - Free memory used by job data.
 //
@@ -42,7 +82,7 @@ cupsFreeJobs(size_t     num_jobs,	// I - Number of jobs
     _cupsStrFree(job->title);
   }
 
-  free(jobs);
+  _cupsMemFree(jobs);
 }
 
 
@@ -121,6 +161,9 @@ cupsGetDefault(http_t *http)		// I - Connection to server or `CUPS_HTTP_DEFAULT`
 // and `CUPS_WHICHJOBS_COMPLETED` to return jobs that are stopped, canceled,
 // aborted, or completed.
 //
+// Use @link cupsGetJobsIter@ to process large numbers of jobs without
+// holding them all in memory.
+//
 
 size_t					// O - Number of jobs
 cupsGetJobs(http_t           *http,	// I - Connection to server or `CUPS_HTTP_DEFAULT`
@@ -129,22 +172,74 @@ cupsGetJobs(http_t           *http,	// I - Connection to server or `CUPS_HTTP_DE
             bool             myjobs,	// I - `false` = all users, `true` = mine
 	    cups_whichjobs_t whichjobs)	// I - `CUPS_WHICHJOBS_ALL`, `CUPS_WHICHJOBS_ACTIVE`, or `CUPS_WHICHJOBS_COMPLETED`
 {
-  size_t	n;			// Number of jobs
+  _cups_joblist_t	list;		// Job list
+
+
+  // Range check input...
+  if (!jobs)
+  {
+    _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(EINVAL), false);
+
+    return (0);
+  }
+
+  // Collect the jobs...
+  memset(&list, 0, sizeof(list));
+
+  if (!cupsGetJobsIter(http, name, myjobs, whichjobs, 0, 0, (cups_job_cb_t)cups_joblist_cb, &list) || list.error)
+  {
+    if (list.error)
+      _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(ENOMEM), false);
+
+    cupsFreeJobs(list.num_jobs, list.jobs);
+
+    *jobs = NULL;
+
+    return (0);
+  }
+
+  *jobs = list.jobs;
+
+  return (list.num_jobs);
+}
+
+
+//
+// 'cupsGetJobsIter()' - Get the jobs from the specified server one at a time.
+//
+// This function gets the jobs from the specified server and calls the "cb"
+// function for each job as it is read, so that only one job is held in memory
+// at any time.  The job data passed to the callback, including its strings, is
+// only valid until the callback returns.  The callback returns `true` to
+// continue or `false` to stop.
+//
+// The "name", "myjobs", and "whichjobs" arguments are the same as for
+// @link cupsGetJobs@.
+//
+// The "first_index" argument specifies the first job to return, starting at
+// `1`, or `0` to start with the first job.  The "limit" argument specifies the
+// number of jobs to request from the server at a time, or `0` to get all of
+// the jobs with a single request.  When a limit is specified, Get-Jobs requests
+// with the "first-index" and "limit" attributes are sent until the server
+// returns fewer than "limit" jobs.
+//
+
+bool					// O - `true` on success, `false` on error
+cupsGetJobsIter(
+    http_t           *http,		// I - Connection to server or `CUPS_HTTP_DEFAULT`
+    const char       *name,		// I - `NULL` = all destinations, otherwise show jobs for named destination
+    bool             myjobs,		// I - `false` = all users, `true` = mine
+    cups_whichjobs_t whichjobs,		// I - `CUPS_WHICHJOBS_ALL`, `CUPS_WHICHJOBS_ACTIVE`, or `CUPS_WHICHJOBS_COMPLETED`
+    size_t           first_index,	// I - First job to return, starting at `1`
+    size_t           limit,		// I - Jobs per request or `0` for all
+    cups_job_cb_t    cb,		// I - Job callback function
+    void             *cb_data)		// I - Job callback data
+{
+  _cups_jobs_t	data;			// Job decoding data
   ipp_t		*request,		// IPP Request
 		*response;		// IPP Response
-  ipp_attribute_t *attr;		// Current attribute
-  cups_job_t	*temp;			// Temporary pointer
-  int		job_id,			// job-id
-		priority,		// job-priority
-		size;			// job-k-octets
-  ipp_jstate_t	state;			// job-state
-  time_t	completed_time,		// time-at-completed
-		creation_time,		// time-at-creation
-		processing_time;	// time-at-processing
-  const char	*dest,			// job-printer-uri
-		*format,		// document-format
-		*title,			// job-name
-		*user;			// job-originating-user-name
+  ipp_status_t	status;			// IPP status code
+  int		last_id = 0;		// First job ID in the last page
   char		uri[HTTP_MAX_URI];	// URI for jobs
   static const char * const attrs[] =	// Requested attributes
 		{
@@ -163,13 +258,22 @@ cupsGetJobs(http_t           *http,	// I - Connection to server or `CUPS_HTTP_DE
 
 
   // Range check input...
-  if (!jobs)
+  if (!cb)
   {
     _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(EINVAL), false);
 
-    return (0);
+    return (false);
   }
 
+  if (first_index == 0)
+    first_index = 1;
+
+  if (first_index > INT_MAX)
+    return (true);
+
+  if (limit > INT_MAX)
+    limit = INT_MAX;
+
   // Get the right URI...
   if (name)
   {
@@ -177,7 +281,7 @@ cupsGetJobs(http_t           *http,	// I - Connection to server or `CUPS_HTTP_DE
     {
       _cupsSetError(IPP_STATUS_ERROR_INTERNAL, _("Unable to create printer-uri"), true);
 
-      return (0);
+      return (false);
     }
   }
   else
@@ -188,168 +292,291 @@ cupsGetJobs(http_t           *http,	// I - Connection to server or `CUPS_HTTP_DE
   if (!http)
   {
     if ((http = _cupsConnect()) == NULL)
-      return (0);
+      return (false);
   }
 
-  //
-  // Build an IPP_GET_JOBS request, which requires the following
-  // attributes:
-  //
-  //   attributes-charset
-  //   attributes-natural-language
-  //   printer-uri
-  //   requesting-user-name
-  //   which-jobs
-  //   my-jobs
-  //   requested-attributes
-  //
+  memset(&data, 0, sizeof(data));
+  data.cb      = cb;
+  data.cb_data = cb_data;
+
+  for (;;)
+  {
+    //
+    // Build an IPP_GET_JOBS request, which requires the following
+    // attributes:
+    //
+    //   attributes-charset
+    //   attributes-natural-language
+    //   printer-uri
+    //   requesting-user-name
+    //   which-jobs
+    //   my-jobs
+    //   first-index
+    //   limit
+    //   requested-attributes
+    //
+
+    request = ippNewRequest(IPP_OP_GET_JOBS);
+
+    ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_URI, "printer-uri", NULL, uri);
+
+    ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_NAME, "requesting-user-name", NULL, cupsGetUser());
+
+    if (myjobs)
+      ippAddBoolean(request, IPP_TAG_OPERATION, "my-jobs", true);
+
+    if (whichjobs == CUPS_WHICHJOBS_COMPLETED)
+      ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_KEYWORD, "which-jobs", NULL, "completed");
+    else if (whichjobs == CUPS_WHICHJOBS_ALL)
+      ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_KEYWORD, "which-jobs", NULL, "all");
+
+    if (data.unpaged)
+    {
+      // The server does not support "first-index", so get all of the jobs and
+      // skip the leading ones ourselves...
+      data.skip = first_index - 1;
+      limit     = 0;
+    }
+    else if (first_index > 1)
+    {
+      ippAddInteger(request, IPP_TAG_OPERATION, IPP_TAG_INTEGER, "first-index", (int)first_index);
+    }
 
-  request = ippNewRequest(IPP_OP_GET_JOBS);
+    if (limit > 0)
+      ippAddInteger(request, IPP_TAG_OPERATION, IPP_TAG_INTEGER, "limit", (int)limit);
 
-  ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_URI, "printer-uri", NULL, uri);
+    ippAddStrings(request, IPP_TAG_OPERATION, IPP_TAG_KEYWORD, "requested-attributes", sizeof(attrs) / sizeof(attrs[0]), NULL, attrs);
 
-  ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_NAME, "requesting-user-name", NULL, cupsGetUser());
+    // Do the request and decode each job as it is read...
+    data.count    = 0;
+    data.first_id = 0;
+    data.in_job   = false;
 
-  if (myjobs)
-    ippAddBoolean(request, IPP_TAG_OPERATION, "my-jobs", true);
+    if ((response = _cupsDoStreamRequest(http, request, "/", (ipp_stream_cb_t)cups_jobs_cb, &data)) == NULL)
+      return (false);
 
-  if (whichjobs == CUPS_WHICHJOBS_COMPLETED)
-    ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_KEYWORD, "which-jobs", NULL, "completed");
-  else if (whichjobs == CUPS_WHICHJOBS_ALL)
-    ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_KEYWORD, "which-jobs", NULL, "all");
+    status = ippGetStatusCode(response);
 
-  ippAddStrings(request, IPP_TAG_OPERATION, IPP_TAG_KEYWORD, "requested-attributes", sizeof(attrs) / sizeof(attrs[0]), NULL, attrs);
+    ippDelete(response);
 
-  // Do the request and get back a response...
-  n     = 0;
-  *jobs = NULL;
+    if (data.stopped)
+      break;
 
-  if ((response = cupsDoRequest(http, request, "/")) != NULL)
+    if (data.retry)
+    {
+      // Try again without "first-index"...
+      data.retry   = false;
+      data.unpaged = true;
+      continue;
+    }
+
+    if (status > IPP_STATUS_OK_EVENTS_COMPLETE)
+      return (false);
+
+    // Deliver the last job in the response...
+    if (!cups_jobs_finish(&data))
+      break;
+
+    // Stop after the last page or if the server returns the same page again...
+    if (limit == 0 || data.count < limit || (data.first_id && data.first_id == last_id))
+      break;
+
+    last_id     = data.first_id;
+    first_index += data.count;
+
+    if (first_index > INT_MAX)
+      break;
+  }
+
+  return (true);
+}
+
+
+//
+// 'cups_joblist_cb()' - Add a job to a job list.
+//
+
+static bool				// O - `true` to continue, `false` to stop
+cups_joblist_cb(
+    _cups_joblist_t  *list,		// I - Job list
+    const cups_job_t *job)		// I - Job
+{
+  cups_job_t	*temp;			// New job
+
+
+  // Allocate memory for the job...
+  if (list->num_jobs >= list->alloc_jobs)
   {
-    for (attr = response->attrs; attr; attr = attr->next)
+    size_t alloc_jobs = list->alloc_jobs ? 2 * list->alloc_jobs : 16;
+					// New allocation
+
+    if ((temp = _cupsMemRealloc(CUPS_MEMTYPE_OTHER, list->jobs, alloc_jobs * sizeof(cups_job_t))) == NULL)
     {
-      // Skip leading attributes until we hit a job...
-      while (attr && attr->group_tag != IPP_TAG_JOB)
-        attr = attr->next;
-
-      if (!attr)
-        break;
-
-      // Pull the needed attributes from this job...
-      job_id          = 0;
-      size            = 0;
-      priority        = 50;
-      state           = IPP_JSTATE_PENDING;
-      user            = "unknown";
-      dest            = NULL;
-      format          = "application/octet-stream";
-      title           = "untitled";
-      creation_time   = 0;
-      completed_time  = 0;
-      processing_time = 0;
-
-      while (attr && attr->group_tag == IPP_TAG_JOB)
-      {
-        if (!strcmp(attr->name, "job-id") && attr->value_tag == IPP_TAG_INTEGER)
-        {
-	  job_id = attr->values[0].integer;
-        }
-        else if (!strcmp(attr->name, "job-state") && attr->value_tag == IPP_TAG_ENUM)
-	{
-	  state = (ipp_jstate_t)attr->values[0].integer;
-        }
-        else if (!strcmp(attr->name, "job-priority") && attr->value_tag == IPP_TAG_INTEGER)
-	{
-	  priority = attr->values[0].integer;
-        }
-        else if (!strcmp(attr->name, "job-k-octets") && attr->value_tag == IPP_TAG_INTEGER)
-	{
-	  size = attr->values[0].integer;
-        }
-        else if (!strcmp(attr->name, "time-at-completed") && attr->value_tag == IPP_TAG_INTEGER)
-	{
-	  completed_time = attr->values[0].integer;
-        }
-        else if (!strcmp(attr->name, "time-at-creation") && attr->value_tag == IPP_TAG_INTEGER)
-	{
-	  creation_time = attr->values[0].integer;
-        }
-        else if (!strcmp(attr->name, "time-at-processing") && attr->value_tag == IPP_TAG_INTEGER)
-	{
-	  processing_time = attr->values[0].integer;
-        }
-        else if (!strcmp(attr->name, "job-printer-uri") && attr->value_tag == IPP_TAG_URI)
-	{
-	  if ((dest = strrchr(attr->values[0].string.text, '/')) != NULL)
-	    dest ++;
-        }
-        else if (!strcmp(attr->name, "job-originating-user-name") && attr->value_tag == IPP_TAG_NAME)
-	{
-	  user = attr->values[0].string.text;
-        }
-        else if (!strcmp(attr->name, "document-format") && attr->value_tag == IPP_TAG_MIMETYPE)
-        {
-	  format = attr->values[0].string.text;
-        }
-        else if (!strcmp(attr->name, "job-name") && (attr->value_tag == IPP_TAG_TEXT || attr->value_tag == IPP_TAG_NAME))
-        {
-	  title = attr->values[0].string.text;
-        }
-
-        attr = attr->next;
-      }
-
-      // See if we have everything needed...
-      if (!dest || !job_id)
-      {
-        if (!attr)
-	  break;
-	else
-          continue;
-      }
-
-      // Allocate memory for the job...
-      if (n == 0)
-        temp = malloc(sizeof(cups_job_t));
-      else
-	temp = realloc(*jobs, sizeof(cups_job_t) * (size_t)(n + 1));
-
-      if (!temp)
-      {
-        // Ran out of memory!
-        _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(ENOMEM), false);
-
-	cupsFreeJobs(n, *jobs);
-	*jobs = NULL;
-
-        ippDelete(response);
-
-	return (0);
-      }
-
-      *jobs = temp;
-      temp  += n;
-      n ++;
-
-      // Copy the data over...
-      temp->dest            = _cupsStrAlloc(dest);
-      temp->user            = _cupsStrAlloc(user);
-      temp->format          = _cupsStrAlloc(format);
-      temp->title           = _cupsStrAlloc(title);
-      temp->id              = job_id;
-      temp->priority        = priority;
-      temp->state           = state;
-      temp->size            = size;
-      temp->completed_time  = completed_time;
-      temp->creation_time   = creation_time;
-      temp->processing_time = processing_time;
-
-      if (!attr)
-        break;
+      // Ran out of memory!
+      list->error = true;
+      return (false);
     }
 
-    ippDelete(response);
+    list->jobs       = temp;
+    list->alloc_jobs = alloc_jobs;
+  }
+
+  // Copy the data over...
+  temp = list->jobs + list->num_jobs;
+  list->num_jobs ++;
+
+  *temp        = *job;
+  temp->dest   = _cupsStrAlloc(job->dest);
+  temp->user   = _cupsStrAlloc(job->user);
+  temp->format = _cupsStrAlloc(job->format);
+  temp->title  = _cupsStrAlloc(job->title);
+
+  return (true);
+}
+
+
+//
+// 'cups_jobs_cb()' - Decode a streamed Get-Jobs attribute.
+//
+
+static bool				// O - `true` to continue, `false` to stop
+cups_jobs_cb(_cups_jobs_t    *data,	// I - Job decoding data
+             ipp_tag_t       group,	// I - Group tag
+             ipp_attribute_t *attr)	// I - Attribute or `NULL` for a group tag
+{
+  const char	*name,			// Attribute name
+		*dest;			// Destination name
+  ipp_tag_t	value_tag;		// Value tag
+
+
+  if (!attr)
+  {
+    // Start of a group, finish the current job...
+    if (!cups_jobs_finish(data))
+      return (false);
+
+    if (group == IPP_TAG_JOB)
+    {
+      // Start a new job with default values...
+      data->in_job = true;
+      data->count ++;
+
+      memset(&data->job, 0, sizeof(data->job));
+
+      data->job.priority = 50;
+      data->job.state    = IPP_JSTATE_PENDING;
+
+      cupsCopyString(data->user, "unknown", sizeof(data->user));
+      cupsCopyString(data->format, "application/octet-stream", sizeof(data->format));
+      cupsCopyString(data->title, "untitled", sizeof(data->title));
+    }
+
+    return (true);
+  }
+
+  if ((name = ippGetName(attr)) == NULL)
+    return (true);
+
+  if (group == IPP_TAG_UNSUPPORTED_GROUP && !strcmp(name, "first-index"))
+  {
+    // The server cannot page from "first-index", stop and try again...
+    data->retry = true;
+    return (false);
+  }
+
+  if (!data->in_job || group != IPP_TAG_JOB)
+    return (true);
+
+  // Pull the needed attributes from this job...
+  value_tag = ippGetValueTag(attr);
+
+  if (!strcmp(name, "job-id") && value_tag == IPP_TAG_INTEGER)
+  {
+    data->job.id = ippGetInteger(attr, 0);
+  }
+  else if (!strcmp(name, "job-state") && value_tag == IPP_TAG_ENUM)
+  {
+    data->job.state = (ipp_jstate_t)ippGetInteger(attr, 0);
+  }
+  else if (!strcmp(name, "job-priority") && value_tag == IPP_TAG_INTEGER)
+  {
+    data->job.priority = ippGetInteger(attr, 0);
+  }
+  else if (!strcmp(name, "job-k-octets") && value_tag == IPP_TAG_INTEGER)
+  {
+    data->job.size = ippGetInteger(attr, 0);
+  }
+  else if (!strcmp(name, "time-at-completed") && value_tag == IPP_TAG_INTEGER)
+  {
+    data->job.completed_time = ippGetInteger(attr, 0);
+  }
+  else if (!strcmp(name, "time-at-creation") && value_tag == IPP_TAG_INTEGER)
+  {
+    data->job.creation_time = ippGetInteger(attr, 0);
+  }
+  else if (!strcmp(name, "time-at-processing") && value_tag == IPP_TAG_INTEGER)
+  {
+    data->job.processing_time = ippGetInteger(attr, 0);
+  }
+  else if (!strcmp(name, "job-printer-uri") && value_tag == IPP_TAG_URI)
+  {
+    if ((dest = strrchr(ippGetString(attr, 0, NULL), '/')) != NULL)
+    {
+      cupsCopyString(data->dest, dest + 1, sizeof(data->dest));
+      data->job.dest = data->dest;
+    }
+  }
+  else if (!strcmp(name, "job-originating-user-name") && value_tag == IPP_TAG_NAME)
+  {
+    cupsCopyString(data->user, ippGetString(attr, 0, NULL), sizeof(data->user));
+  }
+  else if (!strcmp(name, "document-format") && value_tag == IPP_TAG_MIMETYPE)
+  {
+    cupsCopyString(data->format, ippGetString(attr, 0, NULL), sizeof(data->format));
+  }
+  else if (!strcmp(name, "job-name") && (value_tag == IPP_TAG_TEXT || value_tag == IPP_TAG_NAME))
+  {
+    cupsCopyString(data->title, ippGetString(attr, 0, NULL), sizeof(data->title));
+  }
+
+  return (true);
+}
+
+
+//
+// 'cups_jobs_finish()' - Deliver the current job to the callback.
+//
+
+static bool				// O - `true` to continue, `false` to stop
+cups_jobs_finish(_cups_jobs_t *data)	// I - Job decoding data
+{
+  if (!data->in_job)
+    return (true);
+
+  data->in_job = false;
+
+  // See if we have everything needed...
+  if (!data->job.dest || !data->job.id)
+    return (true);
+
+  if (!data->first_id)
+    data->first_id = data->job.id;
+
+  if (data->skip > 0)
+  {
+    data->skip --;
+    return (true);
+  }
+
+  data->job.user   = data->user;
+  data->job.format = data->format;
+  data->job.title  = data->title;
+
+  if (!(data->cb)(data->cb_data, &data->job))
+  {
+    data->stopped = true;
+    return (false);
   }
 
-  return (n);
+  return (true);
 }
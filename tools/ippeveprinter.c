@@ -129,6 +129,55 @@ static const char * const ippeve_preason_strings[] =
 #define WEB_SCHEME "https"
 
 
+//
+// Seconds to keep idle client connections open...
+//
+
+#define IPPEVE_KEEPALIVE_TIMEOUT 30
+
+
+//
+// Get-Jobs responses with more jobs than this are streamed to the client...
+//
+
+#define IPPEVE_STREAM_JOBS 100
+
+
+//
+// Maximum number of icons and strings files to keep in memory...
+//
+
+#define IPPEVE_MAX_RESOURCES 32
+
+
+//
+// Metrics...
+//
+
+#define IPPEVE_METRICS_BUCKETS	12	// Number of histogram buckets
+#define IPPEVE_METRICS_OPS	0x0080	// Number of tracked IPP operation codes
+
+static const double ippeve_metrics_buckets[IPPEVE_METRICS_BUCKETS] =
+{					// Histogram bucket upper bounds in seconds
+  0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 5.0, 10.0
+};
+
+typedef enum ippeve_lock_e		// Lock types for metrics
+{
+  IPPEVE_LOCK_PRINTER,			// printer->rwlock
+  IPPEVE_LOCK_JOBS,			// printer->jobs_rwlock
+  IPPEVE_LOCK_JOB,			// job->rwlock
+  IPPEVE_LOCK_MAX			// Number of lock types
+} ippeve_lock_t;
+
+static const char * const ippeve_lock_strings[] =
+{					// Lock type names for metrics
+  "printer",
+  "jobs",
+  "job"
+};
+
+
 //
 // Structures...
 //
@@ -147,6 +196,35 @@ typedef struct ippeve_filter_s		// Attribute filter
   ipp_tag_t		group_tag;	// Group to copy
 } ippeve_filter_t;
 
+typedef struct ippeve_histogram_s	// Time histogram
+{
+  size_t		buckets[IPPEVE_METRICS_BUCKETS],
+					// Number of values in each bucket
+			count;		// Total number of values
+  double		sum;		// Sum of values in seconds
+} ippeve_histogram_t;
+
+typedef struct ippeve_metrics_s		// Server metrics
+{
+  cups_mutex_t		mutex;		// Mutex for metrics
+  ippeve_histogram_t	ipp[IPPEVE_METRICS_OPS],
+					// IPP requests by operation code
+			http[HTTP_STATE_MAX],
+					// Other HTTP requests by method
+			jobs;		// Job processing times
+  size_t		connections,	// Open connections
+			connections_total,
+					// Total accepted connections
+			bytes_in,	// Bytes received
+			bytes_out;	// Bytes sent
+  double		transform_cpu,	// Transform CPU seconds
+			transform_wall;	// Transform wall clock seconds
+  size_t		lock_count[IPPEVE_LOCK_MAX];
+					// Lock acquisitions
+  double		lock_wait[IPPEVE_LOCK_MAX];
+					// Lock wait times in seconds
+} ippeve_metrics_t;
+
 typedef struct ippeve_job_s ippeve_job_t;
 
 typedef struct ippeve_printer_s		// Printer data
@@ -176,10 +254,15 @@ typedef struct ippeve_printer_s		// Printer data
   ipp_pstate_t		state;		// printer-state value
   ippeve_preason_t	state_reasons;	// printer-state-reasons values
   time_t		state_time;	// printer-state-change-time
-  cups_array_t		*jobs;		// Jobs
+  ippeve_job_t		**jobs;		// Job table indexed by job-id (ring buffer)
+  size_t		alloc_jobs,	// Allocated job table entries
+			first_job,	// Job table index of first_job_id
+			num_jobs;	// Number of jobs
   ippeve_job_t		*active_job;	// Current active/pending job
-  int			next_job_id;	// Next job-id value
-  cups_rwlock_t		rwlock;		// Printer lock
+  int			first_job_id,	// Oldest job-id in job table
+			next_job_id;	// Next job-id value
+  cups_rwlock_t		jobs_rwlock,	// Lock for job table and active_job
+			rwlock;		// Lock for attributes and state
 } ippeve_printer_t;
 
 struct ippeve_job_s			// Job data
@@ -200,9 +283,28 @@ struct ippeve_job_s			// Job data
   int			cancel;		// Non-zero when job canceled
   char			*filename;	// Print file name
   int			fd;		// Print file descriptor
+  int			pipe_fd;	// Pipe for streaming print data to command, if any
+  int			spool_fd;	// Memory spool file, if any
+  char			hash[65];	// SHA-256 hash of document data, if any
   ippeve_printer_t	*printer;	// Printer
+  cups_rwlock_t		rwlock;		// Lock for state and attributes
 };
 
+typedef struct ippeve_resource_s	// Cached static resource
+{
+  size_t		refcount;	// Reference count
+  char			*filename;	// Filename or `NULL` for built-in data
+  struct stat		fileinfo;	// File information
+  const unsigned char	*data;		// Resource data
+  size_t		length;		// Length of resource data
+  char			etag[35];	// Strong entity tag
+} ippeve_resource_t;
+
+// Locks are always acquired in the order printer->jobs_rwlock, job->rwlock,
+// and then printer->rwlock.  Printer and job queries only take the locks
+// for the objects they report on, so they do not contend with each other
+// or with job processing.
+
 typedef struct ippeve_client_s		// Client data
 {
   http_t		*http;		// HTTP connection
@@ -211,6 +313,9 @@ typedef struct ippeve_client_s		// Client data
   time_t		start;		// Request start time
   http_state_t		operation;	// Request operation
   ipp_op_t		operation_id;	// IPP operation-id
+  int			*stream_ids;	// Job IDs for streamed Get-Jobs response
+  size_t		num_stream_ids;	// Number of job IDs
+  cups_array_t		*stream_ra;	// requested-attributes for streamed response
   char			uri[1024],	// Request URI
 			*options,	// URI options
 			host_field[HTTP_MAX_VALUE];
@@ -222,6 +327,8 @@ typedef struct ippeve_client_s		// Client data
 					// Authenticated username, if any
   ippeve_printer_t	*printer;	// Printer
   ippeve_job_t		*job;		// Current job, if any
+  bool			started;	// Has the first request been seen?
+  const char		*etag;		// ETag for response, if any
 } ippeve_client_t;
 
 
@@ -230,13 +337,14 @@ typedef struct ippeve_client_s		// Client data
 //
 
 static http_status_t	authenticate_request(ippeve_client_t *client);
+static char		*cache_filename(const char *cachedir, const char *attrfile, const char *servername, int serverport, const char *make, const char *model, int ppm, int ppm_color, int duplex, cups_array_t *docformats, char *buffer, size_t bufsize);
 static void		clean_jobs(ippeve_printer_t *printer);
-static int		compare_jobs(ippeve_job_t *a, ippeve_job_t *b);
 static void		copy_attributes(ipp_t *to, ipp_t *from, cups_array_t *ra, ipp_tag_t group_tag, bool quickcopy);
-static void		copy_job_attributes(ippeve_client_t *client, ippeve_job_t *job, cups_array_t *ra);
+static void		copy_job_attributes(ipp_t *ipp, ippeve_job_t *job, cups_array_t *ra);
 static ippeve_client_t	*create_client(ippeve_printer_t *printer, int sock);
 static ippeve_job_t	*create_job(ippeve_client_t *client);
 static int		create_job_file(ippeve_job_t *job, char *fname, size_t fnamesize, const char *dir, const char *ext);
+static int		create_spool_file(ippeve_job_t *job, char *fname, size_t fnamesize);
 static int		create_listener(const char *name, int port, int family);
 static ipp_t		*create_media_col(const char *media, const char *source, const char *type, ipp_t *media_size, int bottom, int left, int right, int top);
 static ipp_t		*create_media_size(int width, int length);
@@ -250,13 +358,20 @@ static void		dnssd_callback(cups_dnssd_service_t *service, ippeve_printer_t *pri
 static int		filter_cb(ippeve_filter_t *filter, ipp_t *dst, ipp_attribute_t *attr);
 static ippeve_job_t	*find_job(ippeve_client_t *client);
 static void		finish_document_data(ippeve_client_t *client, ippeve_job_t *job);
+#ifndef _WIN32
+static void		finish_document_pipe(ippeve_client_t *client, ippeve_job_t *job);
+#endif // !_WIN32
 static void		finish_document_uri(ippeve_client_t *client, ippeve_job_t *job);
 static void		flush_document_data(ippeve_client_t *client);
+static ippeve_job_t	*get_job(ippeve_printer_t *printer, int id);
+static ippeve_resource_t *get_resource(const char *filename, const unsigned char *data, size_t length);
 static bool		have_document_data(ippeve_client_t *client);
 static bool		html_escape(ippeve_client_t *client, const char *s, size_t slen);
 static bool		html_footer(ippeve_client_t *client);
 static bool		html_header(ippeve_client_t *client, const char *title, int refresh);
 static bool		html_printf(ippeve_client_t *client, const char *format, ...) _CUPS_FORMAT(2, 3);
+static void		idle_client(ippeve_client_t *client);
+static bool		idle_client_cb(http_loop_t *loop, http_t *http, http_loop_events_t events, ippeve_client_t *client);
 static void		ipp_cancel_job(ippeve_client_t *client);
 static void		ipp_cancel_my_jobs(ippeve_client_t *client);
 static void		ipp_close_job(ippeve_client_t *client);
@@ -270,8 +385,17 @@ static void		ipp_print_uri(ippeve_client_t *client);
 static void		ipp_send_document(ippeve_client_t *client);
 static void		ipp_send_uri(ippeve_client_t *client);
 static void		ipp_validate_job(ippeve_client_t *client);
+static ipp_t		*load_cached_attributes(const char *filename);
 static ipp_t		*load_ippserver_attributes(const char *servername, int serverport, const char *filename, cups_array_t *docformats);
 static ipp_t		*load_legacy_attributes(const char *make, const char *model, int ppm, int ppm_color, int duplex, cups_array_t *docformats);
+static void		lock_read(cups_rwlock_t *rwlock, ippeve_lock_t type);
+static void		lock_write(cups_rwlock_t *rwlock, ippeve_lock_t type);
+static void		metrics_observe(ippeve_histogram_t *h, double value);
+static bool		metrics_printf(ippeve_client_t *client, const char *format, ...) _CUPS_FORMAT(2, 3);
+static void		metrics_request(ippeve_client_t *client, double start, http_stats_t *before);
+static double		metrics_time(void);
+static bool		output_cache_enabled(ippeve_job_t *job);
+static char		*output_cache_filename(ippeve_job_t *job, char **envp, char *buffer, size_t bufsize);
 #if HAVE_LIBPAM
 static int		pam_func(int, const struct pam_message **, struct pam_response **, void *);
 #endif // HAVE_LIBPAM
@@ -283,17 +407,23 @@ static int		process_ipp(ippeve_client_t *client);
 static void		*process_job(ippeve_job_t *job);
 static void		process_state_message(ippeve_job_t *job, char *message);
 static bool		register_printer(ippeve_printer_t *printer);
+static void		release_resource(ippeve_resource_t *resource);
 static bool		respond_http(ippeve_client_t *client, http_status_t code, const char *content_coding, const char *type, size_t length);
 static void		respond_ignored(ippeve_client_t *client, ipp_attribute_t *attr);
 static void		respond_ipp(ippeve_client_t *client, ipp_status_t status, const char *message, ...) _CUPS_FORMAT(3, 4);
+static int		respond_resource(ippeve_client_t *client, const char *type, const char *filename, const unsigned char *data, size_t length);
 static void		respond_unsupported(ippeve_client_t *client, ipp_attribute_t *attr);
-static void		run_printer(ippeve_printer_t *printer);
+static void		*run_clients(void *data);
+static void		run_printers(cups_array_t *printers);
+static void		save_cached_attributes(const char *filename, ipp_t *attrs);
 static int		show_media(ippeve_client_t *client);
+static int		show_metrics(ippeve_client_t *client);
 static int		show_status(ippeve_client_t *client);
 static int		show_supplies(ippeve_client_t *client);
 #ifndef _WIN32
 static void		signal_handler(int signum);
 #endif // !_WIN32
+static bool		stream_jobs(ippeve_client_t *client);
 static char		*time_string(time_t tv, char *buffer, size_t bufsize);
 static int		usage(FILE *out);
 static bool		valid_doc_attributes(ippeve_client_t *client);
@@ -304,12 +434,37 @@ static bool		valid_job_attributes(ippeve_client_t *client);
 // Globals...
 //
 
+static cups_cond_t	ClientCond = CUPS_COND_INITIALIZER;
+					// Condition for idle clients
+static cups_array_t	*ClientIdle = NULL;
+					// Idle clients to add to the loop
+static http_loop_t	*ClientLoop = NULL;
+					// Event loop for idle clients
+static cups_mutex_t	ClientMutex = CUPS_MUTEX_INITIALIZER;
+					// Mutex for idle clients
+static cups_thread_pool_t *ClientPool = NULL;
+					// Worker threads for clients
+static cups_dnssd_t	*DNSSD = NULL;	// DNS-SD context for all printers
+static cups_thread_pool_t *JobPool = NULL;
+					// Worker threads for jobs
 static bool		KeepFiles = false;
 					// Keep spooled job files?
+static bool		MemorySpool = false;
+					// Spool job files in memory?
 static int		MaxVersion = 20,// Maximum IPP version (20 = 2.0, 11 = 1.1, etc.)
 			Verbosity = 0;	// Verbosity level
+static ippeve_metrics_t	Metrics = { CUPS_MUTEX_INITIALIZER };
+					// Server metrics
+static size_t		NumLoopClients = 0;
+					// Number of clients in the event loop
+static const char	*OutputCache = NULL;
+					// Print command output cache directory
 static const char	*PAMService = NULL;
 					// PAM service
+static cups_mutex_t	ResourceMutex = CUPS_MUTEX_INITIALIZER;
+					// Mutex for cached static resources
+static ippeve_resource_t *Resources[IPPEVE_MAX_RESOURCES];
+					// Cached static resources
 #ifndef _WIN32
 static bool		StopPrinter = false;
 					// Stop the printer server?
@@ -327,6 +482,7 @@ main(int  argc,				// I - Number of command-line args
   int		i;			// Looping var
   const char	*opt,			// Current option character
 		*attrfile = NULL,	// ippserver attributes file
+		*cachedir = NULL,	// Attribute cache directory
 		*command = NULL,	// Command to run with job files
 		*device_uri = NULL,	// Device URI
 		*output_format = NULL,	// Output format
@@ -343,12 +499,18 @@ main(int  argc,				// I - Number of command-line args
 		web_forms = true;	// Enable web site forms?
   int		ppm = 10,		// Pages per minute for mono
 		ppm_color = 0;		// Pages per minute for color
+  long		max_clients = 100,	// Maximum number of concurrent clients
+		max_jobs = 10,		// Maximum number of concurrent jobs
+		num_printers = 1;	// Number of printers
+  cups_thread_t	client_thread;		// Client event loop thread
   ipp_t		*attrs = NULL;		// Printer attributes
-  char		directory[1024] = "";	// Spool directory
+  char		directory[1024] = "",	// Spool directory
+		cachefile[1024];	// Attribute cache file
   cups_array_t	*docformats = NULL;	// Supported formats
   const char	*servername = NULL;	// Server host name
   int		serverport = 0;		// Server port number (0 = auto)
   ippeve_printer_t *printer;		// Printer object
+  cups_array_t	*printers;		// Printer objects
 
 
   cupsLangSetLocale(argv);
@@ -356,14 +518,58 @@ main(int  argc,				// I - Number of command-line args
   // Parse command-line arguments...
   for (i = 1; i < argc; i ++)
   {
-    if (!strcmp(argv[i], "--help"))
+    if (!strcmp(argv[i], "--cache-directory"))
+    {
+      i ++;
+      if (i >= argc)
+      {
+        cupsLangPrintf(stderr, _("%s: Missing directory after '--cache-directory'."), "ippeveprinter");
+        return (usage(stderr));
+      }
+
+      cachedir = argv[i];
+    }
+    else if (!strcmp(argv[i], "--help"))
     {
       return (usage(stdout));
     }
+    else if (!strcmp(argv[i], "--max-clients") || !strcmp(argv[i], "--max-jobs") || !strcmp(argv[i], "--printers"))
+    {
+      const char *option = argv[i];	// Option name
+
+      i ++;
+      if (i >= argc || strtol(argv[i], NULL, 10) < 1)
+      {
+        cupsLangPrintf(stderr, _("%s: Missing or bad number after '%s'."), "ippeveprinter", option);
+        return (usage(stderr));
+      }
+
+      if (!strcmp(option, "--max-clients"))
+        max_clients = strtol(argv[i], NULL, 10);
+      else if (!strcmp(option, "--max-jobs"))
+        max_jobs = strtol(argv[i], NULL, 10);
+      else
+        num_printers = strtol(argv[i], NULL, 10);
+    }
+    else if (!strcmp(argv[i], "--memory-spool"))
+    {
+      MemorySpool = true;
+    }
     else if (!strcmp(argv[i], "--no-web-forms"))
     {
       web_forms = false;
     }
+    else if (!strcmp(argv[i], "--output-cache"))
+    {
+      i ++;
+      if (i >= argc)
+      {
+        cupsLangPrintf(stderr, _("%s: Missing directory after '--output-cache'."), "ippeveprinter");
+        return (usage(stderr));
+      }
+
+      OutputCache = argv[i];
+    }
     else if (!strcmp(argv[i], "--pam-service"))
     {
       i ++;
@@ -674,26 +880,105 @@ main(int  argc,				// I - Number of command-line args
   }
 
   // Create the printer...
-  if (attrfile)
-    attrs = load_ippserver_attributes(servername, serverport, attrfile, docformats);
+  if (cachedir && cache_filename(cachedir, attrfile, servername, serverport, make, model, ppm, ppm_color, duplex, docformats, cachefile, sizeof(cachefile)))
+    attrs = load_cached_attributes(cachefile);
   else
-    attrs = load_legacy_attributes(make, model, ppm, ppm_color, duplex, docformats);
+    cachedir = NULL;
+
+  if (!attrs)
+  {
+    if (attrfile)
+      attrs = load_ippserver_attributes(servername, serverport, attrfile, docformats);
+    else
+      attrs = load_legacy_attributes(make, model, ppm, ppm_color, duplex, docformats);
+
+    if (cachedir && attrs)
+      save_cached_attributes(cachefile, attrs);
+  }
 
   if (!docformats && !ippFindAttribute(attrs, "document-format-supported", IPP_TAG_MIMETYPE))
     docformats = cupsArrayNewStrings(ppm_color > 0 ? "image/jpeg,image/pwg-raster,image/urf": "image/pwg-raster,image/urf", ',');
 
-  if ((printer = create_printer(servername, serverport, name, location, icon, strings, docformats, subtypes, directory, command, device_uri, output_format, attrs)) == NULL)
+  // Multiple printers share a frozen copy of the capability attributes, and
+  // each one gets its own name, port, and spool directory...
+  if (num_printers > 1 && !ippFreeze(attrs))
+  {
+    cupsLangPrintf(stderr, _("%s: Out of memory."), "ippeveprinter");
     return (1);
+  }
+
+  DNSSD    = cupsDNSSDNew(NULL, NULL);
+  printers = cupsArrayNew(NULL, NULL, NULL, 0, NULL, NULL);
+
+  for (i = 0; i < num_printers; i ++)
+  {
+    if (num_printers == 1)
+    {
+      printer = create_printer(servername, serverport, name, location, icon, strings, docformats, subtypes, directory, command, device_uri, output_format, attrs);
+    }
+    else
+    {
+      char	pname[256],		// Printer name
+		pdirectory[1024];	// Printer spool directory
+      ipp_t	*pattrs;		// Printer attributes
+
+      snprintf(pname, sizeof(pname), "%s %d", name, i + 1);
+      snprintf(pdirectory, sizeof(pdirectory), "%s/%d", directory, i + 1);
+
+      if (mkdir(pdirectory, 0755) && errno != EEXIST)
+      {
+        cupsLangPrintf(stderr, _("%s: Unable to create spool directory '%s': %s"), "ippeveprinter", pdirectory, strerror(errno));
+        return (1);
+      }
 
-  printer->web_forms = web_forms;
+      pattrs = ippNew();
+      ippCopyAttributes(pattrs, attrs, true, /*cb*/NULL, /*cb_data*/NULL);
+
+      printer = create_printer(servername, serverport ? serverport + i : 0, pname, location, icon, strings, docformats, subtypes, pdirectory, command, device_uri, output_format, pattrs);
+    }
+
+    if (!printer)
+      return (1);
+
+    printer->web_forms = web_forms;
+
+    cupsArrayAdd(printers, printer);
+  }
+
+  printer = (ippeve_printer_t *)cupsArrayGetFirst(printers);
 
   cupsSetServerCredentials(keypath, printer->hostname, 1);
 
+  // Create the worker threads for clients and jobs - up to one pending
+  // connection is queued for each client thread...
+  if ((ClientPool = cupsThreadPoolNew((size_t)max_clients, (size_t)max_clients)) == NULL || (JobPool = cupsThreadPoolNew((size_t)max_jobs, 0)) == NULL)
+  {
+    perror("Unable to create worker threads");
+    return (1);
+  }
+
+  // Idle connections wait for their next request in an event loop on a
+  // separate thread...
+  if ((ClientLoop = httpLoopNew()) == NULL || (ClientIdle = cupsArrayNew(NULL, NULL, NULL, 0, NULL, NULL)) == NULL || (client_thread = cupsThreadCreate(run_clients, NULL)) == CUPS_THREAD_INVALID)
+  {
+    perror("Unable to create client event loop");
+    return (1);
+  }
+
+  cupsThreadDetach(client_thread);
+
   // Run the print service...
-  run_printer(printer);
+  run_printers(printers);
 
-  // Destroy the printer and exit...
-  delete_printer(printer);
+  // Destroy the printers and exit...
+  for (printer = (ippeve_printer_t *)cupsArrayGetFirst(printers); printer; printer = (ippeve_printer_t *)cupsArrayGetNext(printers))
+    delete_printer(printer);
+
+  cupsArrayDelete(printers);
+  cupsDNSSDDelete(DNSSD);
+
+  if (num_printers > 1)
+    ippDelete(attrs);
 
   return (0);
 }
@@ -792,45 +1077,109 @@ authenticate_request(
 
 
 //
-// 'clean_jobs()' - Clean out old (completed) jobs.
+// 'cache_filename()' - Get the attribute cache filename for the printer.
+//
+// The filename is a SHA-256 hash of the attributes file name, size, and
+// modification time and the command-line options that are used to build the
+// printer attributes, so a change to any of them uses a new cache file.
+// Files included by the attributes file are not checked.
 //
 
-static void
-clean_jobs(ippeve_printer_t *printer)	// I - Printer
+static char *				// O - Cache filename or `NULL` on error
+cache_filename(
+    const char   *cachedir,		// I - Cache directory
+    const char   *attrfile,		// I - ippserver attributes file or `NULL`
+    const char   *servername,		// I - Server name or `NULL` for default
+    int          serverport,		// I - Server port number
+    const char   *make,			// I - Manufacturer name
+    const char   *model,		// I - Model name
+    int          ppm,			// I - pages-per-minute
+    int          ppm_color,		// I - pages-per-minute-color
+    int          duplex,		// I - Duplex support?
+    cups_array_t *docformats,		// I - document-format-supported values
+    char         *buffer,		// I - Filename buffer
+    size_t       bufsize)		// I - Size of filename buffer
 {
-  ippeve_job_t	*job;			// Current job
-  time_t	cleantime;		// Clean time
-
+  char		key[2048],		// Cache key
+		*keyptr,		// Pointer into key
+		hostname[256],		// Server hostname
+		hash[65];		// Hex hash of key
+  const char	*format;		// Current document format
+  unsigned char	sha256[32];		// SHA-256 hash of key
+  struct stat	fileinfo;		// Attributes file information
 
-  if (cupsArrayGetCount(printer->jobs) == 0)
-    return;
 
-  cleantime = time(NULL) - 60;
+  if (!servername)
+  {
+    httpGetHostname(NULL, hostname, sizeof(hostname));
+    servername = hostname;
+  }
 
-  cupsRWLockWrite(&(printer->rwlock));
-  for (job = (ippeve_job_t *)cupsArrayGetFirst(printer->jobs);
-       job;
-       job = (ippeve_job_t *)cupsArrayGetNext(printer->jobs))
-    if (job->completed && job->completed < cleantime)
+  if (attrfile)
+  {
+    if (stat(attrfile, &fileinfo))
     {
-      cupsArrayRemove(printer->jobs, job);
-      delete_job(job);
+      fprintf(stderr, "Unable to access \"%s\": %s\n", attrfile, strerror(errno));
+      return (NULL);
     }
-    else
-      break;
-  cupsRWUnlock(&(printer->rwlock));
+
+    snprintf(key, sizeof(key), "ippserver\n%s\n%ld\n%ld\n%s\n%d\n", attrfile, (long)fileinfo.st_size, (long)fileinfo.st_mtime, servername, serverport);
+  }
+  else
+  {
+    snprintf(key, sizeof(key), "legacy\n%s\n%s\n%d\n%d\n%d\n", make, model, ppm, ppm_color, duplex);
+  }
+
+  for (format = (const char *)cupsArrayGetFirst(docformats), keyptr = key + strlen(key); format; format = (const char *)cupsArrayGetNext(docformats), keyptr += strlen(keyptr))
+    snprintf(keyptr, sizeof(key) - (size_t)(keyptr - key), "%s\n", format);
+
+  cupsHashData("sha2-256", key, strlen(key), sha256, sizeof(sha256));
+  cupsHashString(sha256, sizeof(sha256), hash, sizeof(hash));
+
+  snprintf(buffer, bufsize, "%s/%s.ipp", cachedir, hash);
+
+  return (buffer);
 }
 
 
 //
-// 'compare_jobs()' - Compare two jobs.
+// 'clean_jobs()' - Clean out old (completed) jobs.
+//
+// Only one job is active at a time, so jobs complete in job-id order and
+// the oldest jobs are always at the front of the job table.
 //
 
-static int				// O - Result of comparison
-compare_jobs(ippeve_job_t *a,		// I - First job
-             ippeve_job_t *b)		// I - Second job
+static void
+clean_jobs(ippeve_printer_t *printer)	// I - Printer
 {
-  return (b->id - a->id);
+  ippeve_job_t	*job;			// Current job
+  time_t	cleantime,		// Clean time
+		completed;		// Job completion time
+
+
+  cleantime = time(NULL) - 60;
+
+  lock_write(&(printer->jobs_rwlock), IPPEVE_LOCK_JOBS);
+  while (printer->num_jobs > 0 && printer->first_job_id < printer->next_job_id)
+  {
+    if ((job = printer->jobs[printer->first_job]) != NULL)
+    {
+      lock_read(&(job->rwlock), IPPEVE_LOCK_JOB);
+      completed = job->completed;
+      cupsRWUnlock(&(job->rwlock));
+
+      if (!completed || completed >= cleantime)
+        break;
+
+      delete_job(job);
+      printer->num_jobs --;
+    }
+
+    printer->jobs[printer->first_job] = NULL;
+    printer->first_job                = (printer->first_job + 1) % printer->alloc_jobs;
+    printer->first_job_id ++;
+  }
+  cupsRWUnlock(&(printer->jobs_rwlock));
 }
 
 
@@ -861,84 +1210,86 @@ copy_attributes(ipp_t        *to,	// I - Destination request
 
 static void
 copy_job_attributes(
-    ippeve_client_t *client,		// I - Client
+    ipp_t         *ipp,			// I - IPP message
     ippeve_job_t    *job,			// I - Job
     cups_array_t  *ra)			// I - requested-attributes
 {
-  copy_attributes(client->response, job->attrs, ra, IPP_TAG_JOB, 0);
+  lock_read(&(job->rwlock), IPPEVE_LOCK_JOB);
+
+  copy_attributes(ipp, job->attrs, ra, IPP_TAG_JOB, 0);
 
   if (!ra || cupsArrayFind(ra, "date-time-at-completed"))
   {
     if (job->completed)
-      ippAddDate(client->response, IPP_TAG_JOB, "date-time-at-completed", ippTimeToDate(job->completed));
+      ippAddDate(ipp, IPP_TAG_JOB, "date-time-at-completed", ippTimeToDate(job->completed));
     else
-      ippAddOutOfBand(client->response, IPP_TAG_JOB, IPP_TAG_NOVALUE, "date-time-at-completed");
+      ippAddOutOfBand(ipp, IPP_TAG_JOB, IPP_TAG_NOVALUE, "date-time-at-completed");
   }
 
   if (!ra || cupsArrayFind(ra, "date-time-at-processing"))
   {
     if (job->processing)
-      ippAddDate(client->response, IPP_TAG_JOB, "date-time-at-processing", ippTimeToDate(job->processing));
+      ippAddDate(ipp, IPP_TAG_JOB, "date-time-at-processing", ippTimeToDate(job->processing));
     else
-      ippAddOutOfBand(client->response, IPP_TAG_JOB, IPP_TAG_NOVALUE, "date-time-at-processing");
+      ippAddOutOfBand(ipp, IPP_TAG_JOB, IPP_TAG_NOVALUE, "date-time-at-processing");
   }
 
   if (!ra || cupsArrayFind(ra, "job-impressions"))
-    ippAddInteger(client->response, IPP_TAG_JOB, IPP_TAG_INTEGER, "job-impressions", job->impressions);
+    ippAddInteger(ipp, IPP_TAG_JOB, IPP_TAG_INTEGER, "job-impressions", job->impressions);
 
   if (!ra || cupsArrayFind(ra, "job-impressions-completed"))
-    ippAddInteger(client->response, IPP_TAG_JOB, IPP_TAG_INTEGER, "job-impressions-completed", job->impcompleted);
+    ippAddInteger(ipp, IPP_TAG_JOB, IPP_TAG_INTEGER, "job-impressions-completed", job->impcompleted);
 
   if (!ra || cupsArrayFind(ra, "job-printer-up-time"))
-    ippAddInteger(client->response, IPP_TAG_JOB, IPP_TAG_INTEGER, "job-printer-up-time", (int)(time(NULL) - client->printer->start_time));
+    ippAddInteger(ipp, IPP_TAG_JOB, IPP_TAG_INTEGER, "job-printer-up-time", (int)(time(NULL) - job->printer->start_time));
 
   if (!ra || cupsArrayFind(ra, "job-state"))
-    ippAddInteger(client->response, IPP_TAG_JOB, IPP_TAG_ENUM, "job-state", (int)job->state);
+    ippAddInteger(ipp, IPP_TAG_JOB, IPP_TAG_ENUM, "job-state", (int)job->state);
 
   if (!ra || cupsArrayFind(ra, "job-state-message"))
   {
     if (job->message)
     {
-      ippAddString(client->response, IPP_TAG_JOB, IPP_TAG_TEXT, "job-state-message", NULL, job->message);
+      ippAddString(ipp, IPP_TAG_JOB, IPP_TAG_TEXT, "job-state-message", NULL, job->message);
     }
     else
     {
       switch (job->state)
       {
 	case IPP_JSTATE_PENDING :
-	    ippAddString(client->response, IPP_TAG_JOB, IPP_CONST_TAG(IPP_TAG_TEXT), "job-state-message", NULL, "Job pending.");
+	    ippAddString(ipp, IPP_TAG_JOB, IPP_CONST_TAG(IPP_TAG_TEXT), "job-state-message", NULL, "Job pending.");
 	    break;
 
 	case IPP_JSTATE_HELD :
 	    if (job->fd >= 0)
-	      ippAddString(client->response, IPP_TAG_JOB, IPP_CONST_TAG(IPP_TAG_TEXT), "job-state-message", NULL, "Job incoming.");
+	      ippAddString(ipp, IPP_TAG_JOB, IPP_CONST_TAG(IPP_TAG_TEXT), "job-state-message", NULL, "Job incoming.");
 	    else if (ippFindAttribute(job->attrs, "job-hold-until", IPP_TAG_ZERO))
-	      ippAddString(client->response, IPP_TAG_JOB, IPP_CONST_TAG(IPP_TAG_TEXT), "job-state-message", NULL, "Job held.");
+	      ippAddString(ipp, IPP_TAG_JOB, IPP_CONST_TAG(IPP_TAG_TEXT), "job-state-message", NULL, "Job held.");
 	    else
-	      ippAddString(client->response, IPP_TAG_JOB, IPP_CONST_TAG(IPP_TAG_TEXT), "job-state-message", NULL, "Job created.");
+	      ippAddString(ipp, IPP_TAG_JOB, IPP_CONST_TAG(IPP_TAG_TEXT), "job-state-message", NULL, "Job created.");
 	    break;
 
 	case IPP_JSTATE_PROCESSING :
 	    if (job->cancel)
-	      ippAddString(client->response, IPP_TAG_JOB, IPP_CONST_TAG(IPP_TAG_TEXT), "job-state-message", NULL, "Job canceling.");
+	      ippAddString(ipp, IPP_TAG_JOB, IPP_CONST_TAG(IPP_TAG_TEXT), "job-state-message", NULL, "Job canceling.");
 	    else
-	      ippAddString(client->response, IPP_TAG_JOB, IPP_CONST_TAG(IPP_TAG_TEXT), "job-state-message", NULL, "Job printing.");
+	      ippAddString(ipp, IPP_TAG_JOB, IPP_CONST_TAG(IPP_TAG_TEXT), "job-state-message", NULL, "Job printing.");
 	    break;
 
 	case IPP_JSTATE_STOPPED :
-	    ippAddString(client->response, IPP_TAG_JOB, IPP_CONST_TAG(IPP_TAG_TEXT), "job-state-message", NULL, "Job stopped.");
+	    ippAddString(ipp, IPP_TAG_JOB, IPP_CONST_TAG(IPP_TAG_TEXT), "job-state-message", NULL, "Job stopped.");
 	    break;
 
 	case IPP_JSTATE_CANCELED :
-	    ippAddString(client->response, IPP_TAG_JOB, IPP_CONST_TAG(IPP_TAG_TEXT), "job-state-message", NULL, "Job canceled.");
+	    ippAddString(ipp, IPP_TAG_JOB, IPP_CONST_TAG(IPP_TAG_TEXT), "job-state-message", NULL, "Job canceled.");
 	    break;
 
 	case IPP_JSTATE_ABORTED :
-	    ippAddString(client->response, IPP_TAG_JOB, IPP_CONST_TAG(IPP_TAG_TEXT), "job-state-message", NULL, "Job aborted.");
+	    ippAddString(ipp, IPP_TAG_JOB, IPP_CONST_TAG(IPP_TAG_TEXT), "job-state-message", NULL, "Job aborted.");
 	    break;
 
 	case IPP_JSTATE_COMPLETED :
-	    ippAddString(client->response, IPP_TAG_JOB, IPP_CONST_TAG(IPP_TAG_TEXT), "job-state-message", NULL, "Job completed.");
+	    ippAddString(ipp, IPP_TAG_JOB, IPP_CONST_TAG(IPP_TAG_TEXT), "job-state-message", NULL, "Job completed.");
 	    break;
       }
     }
@@ -949,57 +1300,57 @@ copy_job_attributes(
     switch (job->state)
     {
       case IPP_JSTATE_PENDING :
-	  ippAddString(client->response, IPP_TAG_JOB,
+	  ippAddString(ipp, IPP_TAG_JOB,
 	               IPP_CONST_TAG(IPP_TAG_KEYWORD), "job-state-reasons",
 		       NULL, "none");
 	  break;
 
       case IPP_JSTATE_HELD :
           if (job->fd >= 0)
-	    ippAddString(client->response, IPP_TAG_JOB,
+	    ippAddString(ipp, IPP_TAG_JOB,
 	                 IPP_CONST_TAG(IPP_TAG_KEYWORD),
 	                 "job-state-reasons", NULL, "job-incoming");
 	  else if (ippFindAttribute(job->attrs, "job-hold-until", IPP_TAG_ZERO))
-	    ippAddString(client->response, IPP_TAG_JOB,
+	    ippAddString(ipp, IPP_TAG_JOB,
 	                 IPP_CONST_TAG(IPP_TAG_KEYWORD),
 	                 "job-state-reasons", NULL, "job-hold-until-specified");
           else
-	    ippAddString(client->response, IPP_TAG_JOB,
+	    ippAddString(ipp, IPP_TAG_JOB,
 	                 IPP_CONST_TAG(IPP_TAG_KEYWORD),
 	                 "job-state-reasons", NULL, "job-data-insufficient");
 	  break;
 
       case IPP_JSTATE_PROCESSING :
 	  if (job->cancel)
-	    ippAddString(client->response, IPP_TAG_JOB,
+	    ippAddString(ipp, IPP_TAG_JOB,
 	                 IPP_CONST_TAG(IPP_TAG_KEYWORD),
 	                 "job-state-reasons", NULL, "processing-to-stop-point");
 	  else
-	    ippAddString(client->response, IPP_TAG_JOB,
+	    ippAddString(ipp, IPP_TAG_JOB,
 	                 IPP_CONST_TAG(IPP_TAG_KEYWORD),
 	                 "job-state-reasons", NULL, "job-printing");
 	  break;
 
       case IPP_JSTATE_STOPPED :
-	  ippAddString(client->response, IPP_TAG_JOB,
+	  ippAddString(ipp, IPP_TAG_JOB,
 	               IPP_CONST_TAG(IPP_TAG_KEYWORD), "job-state-reasons",
 		       NULL, "job-stopped");
 	  break;
 
       case IPP_JSTATE_CANCELED :
-	  ippAddString(client->response, IPP_TAG_JOB,
+	  ippAddString(ipp, IPP_TAG_JOB,
 	               IPP_CONST_TAG(IPP_TAG_KEYWORD), "job-state-reasons",
 		       NULL, "job-canceled-by-user");
 	  break;
 
       case IPP_JSTATE_ABORTED :
-	  ippAddString(client->response, IPP_TAG_JOB,
+	  ippAddString(ipp, IPP_TAG_JOB,
 	               IPP_CONST_TAG(IPP_TAG_KEYWORD), "job-state-reasons",
 		       NULL, "aborted-by-system");
 	  break;
 
       case IPP_JSTATE_COMPLETED :
-	  ippAddString(client->response, IPP_TAG_JOB,
+	  ippAddString(ipp, IPP_TAG_JOB,
 	               IPP_CONST_TAG(IPP_TAG_KEYWORD), "job-state-reasons",
 		       NULL, "job-completed-successfully");
 	  break;
@@ -1007,14 +1358,16 @@ copy_job_attributes(
   }
 
   if (!ra || cupsArrayFind(ra, "time-at-completed"))
-    ippAddInteger(client->response, IPP_TAG_JOB,
+    ippAddInteger(ipp, IPP_TAG_JOB,
                   job->completed ? IPP_TAG_INTEGER : IPP_TAG_NOVALUE,
-                  "time-at-completed", (int)(job->completed - client->printer->start_time));
+                  "time-at-completed", (int)(job->completed - job->printer->start_time));
 
   if (!ra || cupsArrayFind(ra, "time-at-processing"))
-    ippAddInteger(client->response, IPP_TAG_JOB,
+    ippAddInteger(ipp, IPP_TAG_JOB,
                   job->processing ? IPP_TAG_INTEGER : IPP_TAG_NOVALUE,
-                  "time-at-processing", (int)(job->processing - client->printer->start_time));
+                  "time-at-processing", (int)(job->processing - job->printer->start_time));
+
+  cupsRWUnlock(&(job->rwlock));
 }
 
 
@@ -1050,9 +1403,17 @@ create_client(ippeve_printer_t *printer,	// I - Printer
 
   httpGetHostname(client->http, client->hostname, sizeof(client->hostname));
 
+  // Send the responses to pipelined requests together...
+  httpSetWriteCoalescing(client->http, true);
+
   if (Verbosity)
     fprintf(stderr, "Accepted connection from %s\n", client->hostname);
 
+  cupsMutexLock(&Metrics.mutex);
+  Metrics.connections ++;
+  Metrics.connections_total ++;
+  cupsMutexUnlock(&Metrics.mutex);
+
   return (client);
 }
 
@@ -1071,12 +1432,12 @@ create_job(ippeve_client_t *client)	// I - Client
 			uuid[64];	// job-uuid value
 
 
-  cupsRWLockWrite(&(client->printer->rwlock));
+  lock_write(&(client->printer->jobs_rwlock), IPPEVE_LOCK_JOBS);
   if (client->printer->active_job &&
       client->printer->active_job->state < IPP_JSTATE_CANCELED)
   {
     // Only accept a single job at a time...
-    cupsRWUnlock(&(client->printer->rwlock));
+    cupsRWUnlock(&(client->printer->jobs_rwlock));
     return (NULL);
   }
 
@@ -1084,25 +1445,31 @@ create_job(ippeve_client_t *client)	// I - Client
   if ((job = calloc(1, sizeof(ippeve_job_t))) == NULL)
   {
     perror("Unable to allocate memory for job");
-    cupsRWUnlock(&(client->printer->rwlock));
+    cupsRWUnlock(&(client->printer->jobs_rwlock));
     return (NULL);
   }
 
+  cupsRWInit(&(job->rwlock));
+
   job->printer    = client->printer;
   job->attrs      = ippNew();
   job->state      = IPP_JSTATE_HELD;
   job->fd         = -1;
+  job->spool_fd   = -1;
+  job->pipe_fd    = -1;
 
   // Copy all of the job attributes...
   copy_attributes(job->attrs, client->request, NULL, IPP_TAG_JOB, 0);
 
-  // Get the requesting-user-name, document format, and priority...
+  // Get the requesting-user-name, document format, and priority (strings
+  // point into the job attributes since the request is freed before the job
+  // is...)
   if ((attr = ippFindAttribute(client->request, "requesting-user-name", IPP_TAG_NAME)) != NULL)
     job->username = ippGetString(attr, 0, NULL);
   else
     job->username = "anonymous";
 
-  ippAddString(job->attrs, IPP_TAG_JOB, IPP_TAG_NAME, "job-originating-user-name", NULL, job->username);
+  job->username = ippGetString(ippAddString(job->attrs, IPP_TAG_JOB, IPP_TAG_NAME, "job-originating-user-name", NULL, job->username), 0, NULL);
 
   if (ippGetOperation(client->request) != IPP_OP_CREATE_JOB)
   {
@@ -1117,10 +1484,40 @@ create_job(ippeve_client_t *client)	// I - Client
   if ((attr = ippFindAttribute(client->request, "job-impressions", IPP_TAG_INTEGER)) != NULL)
     job->impressions = ippGetInteger(attr, 0);
 
-  if ((attr = ippFindAttribute(client->request, "job-name", IPP_TAG_NAME)) != NULL)
+  if ((attr = ippFindAttribute(job->attrs, "job-name", IPP_TAG_NAME)) != NULL)
     job->name = ippGetString(attr, 0, NULL);
 
-  // Add job description attributes and add to the jobs array...
+  // Add job description attributes and add to the job table...
+  if ((size_t)(client->printer->next_job_id - client->printer->first_job_id) >= client->printer->alloc_jobs)
+  {
+    // Grow the job table, keeping the jobs in order...
+    ippeve_printer_t	*printer = client->printer;
+					// Printer
+    ippeve_job_t	**temp;		// New job table
+    size_t		i,		// Looping var
+			alloc_jobs = printer->alloc_jobs ? 2 * printer->alloc_jobs : 64;
+					// New size of job table
+
+    if ((temp = calloc(alloc_jobs, sizeof(ippeve_job_t *))) == NULL)
+    {
+      perror("Unable to allocate memory for job table");
+      cupsRWUnlock(&(printer->jobs_rwlock));
+      cupsRWDestroy(&(job->rwlock));
+      ippDelete(job->attrs);
+      free(job);
+      return (NULL);
+    }
+
+    for (i = 0; i < printer->alloc_jobs; i ++)
+      temp[i] = printer->jobs[(printer->first_job + i) % printer->alloc_jobs];
+
+    free(printer->jobs);
+
+    printer->jobs       = temp;
+    printer->alloc_jobs = alloc_jobs;
+    printer->first_job  = 0;
+  }
+
   job->id = client->printer->next_job_id ++;
 
   if ((attr = ippFindAttribute(client->request, "printer-uri", IPP_TAG_URI)) != NULL)
@@ -1148,10 +1545,11 @@ create_job(ippeve_client_t *client)	// I - Client
 
   ippAddInteger(job->attrs, IPP_TAG_JOB, IPP_TAG_INTEGER, "time-at-creation", (int)(job->created - client->printer->start_time));
 
-  cupsArrayAdd(client->printer->jobs, job);
+  client->printer->jobs[(client->printer->first_job + (size_t)(job->id - client->printer->first_job_id)) % client->printer->alloc_jobs] = job;
+  client->printer->num_jobs ++;
   client->printer->active_job = job;
 
-  cupsRWUnlock(&(client->printer->rwlock));
+  cupsRWUnlock(&(client->printer->jobs_rwlock));
 
   return (job);
 }
@@ -1223,6 +1621,42 @@ create_job_file(
 }
 
 
+//
+// 'create_spool_file()' - Create the spool file for the document in a job.
+//
+// When spooling in memory, the file has no name so "fname" is set to the empty
+// string.  The file is passed to the print command as file descriptor 3.
+//
+
+static int				// O - File descriptor or -1 on error
+create_spool_file(
+    ippeve_job_t *job,			// I - Job
+    char         *fname,		// I - Filename buffer
+    size_t       fnamesize)		// I - Size of filename buffer
+{
+#ifndef _WIN32
+  if (MemorySpool)
+  {
+    int	fd;				// Memory file
+
+    *fname = '\0';
+
+    if ((fd = cupsCreateAnonymousFd(true)) >= 0)
+    {
+      fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+      if (Verbosity)
+	fprintf(stderr, "[Job %d] Created memory spool file, format \"%s\".\n", job->id, job->format);
+    }
+
+    return (fd);
+  }
+#endif // !_WIN32
+
+  return (create_job_file(job, fname, fnamesize, job->printer->directory, NULL));
+}
+
+
 //
 // 'create_listener()' - Create a listener socket.
 //
@@ -1421,9 +1855,15 @@ create_printer(
   };
   static const char * const compressions[] =// compression-supported values
   {
+#ifdef HAVE_BROTLI
+    "br",
+#endif // HAVE_BROTLI
     "deflate",
     "gzip",
-    "none"
+    "none",
+#ifdef HAVE_ZSTD
+    "zstd",
+#endif // HAVE_ZSTD
   };
   static const char * const identify_actions[] =
   {
@@ -1575,7 +2015,7 @@ create_printer(
   printer->ipv4           = -1;
   printer->ipv6           = -1;
   printer->name           = strdup(name);
-  printer->dnssd          = cupsDNSSDNew(NULL, NULL);
+  printer->dnssd          = DNSSD;
   printer->dnssd_name     = strdup(name);
   printer->dnssd_subtypes = subtypes ? strdup(subtypes) : NULL;
   printer->command        = command ? strdup(command) : NULL;
@@ -1590,7 +2030,7 @@ create_printer(
   printer->state          = IPP_PSTATE_IDLE;
   printer->state_reasons  = IPPEVE_PREASON_NONE;
   printer->state_time     = printer->start_time;
-  printer->jobs           = cupsArrayNew((cups_array_cb_t)compare_jobs, NULL, NULL, 0, NULL, NULL);
+  printer->first_job_id   = 1;
   printer->next_job_id    = 1;
 
   if (printer->icons[0])
@@ -1623,7 +2063,10 @@ create_printer(
     printer->hostname = strdup(cupsDNSSDCopyHostName(printer->dnssd, temp, sizeof(temp)));
   }
 
+  cupsRWInit(&(printer->jobs_rwlock));
+  cupsRWSetName(&(printer->jobs_rwlock), "printer->jobs_rwlock");
   cupsRWInit(&(printer->rwlock));
+  cupsRWSetName(&(printer->rwlock), "printer->rwlock");
 
   // Create the listener sockets...
   if (printer->port)
@@ -1966,7 +2409,14 @@ delete_client(ippeve_client_t *client)	// I - Client
   ippDelete(client->request);
   ippDelete(client->response);
 
+  free(client->stream_ids);
+  cupsArrayDelete(client->stream_ra);
+
   free(client);
+
+  cupsMutexLock(&Metrics.mutex);
+  Metrics.connections --;
+  cupsMutexUnlock(&Metrics.mutex);
 }
 
 
@@ -1988,12 +2438,17 @@ delete_job(ippeve_job_t *job)		// I - Job
 
   if (job->filename)
   {
-    if (!KeepFiles)
+    if (!KeepFiles && job->filename[0])
       unlink(job->filename);
 
     free(job->filename);
   }
 
+  if (job->spool_fd >= 0)
+    close(job->spool_fd);
+
+  cupsRWDestroy(&(job->rwlock));
+
   free(job);
 }
 
@@ -2013,7 +2468,7 @@ delete_printer(
   if (printer->ipv6 >= 0)
     close(printer->ipv6);
 
-  cupsDNSSDDelete(printer->dnssd);
+  cupsDNSSDServiceDelete(printer->services);
 
   if (printer->dnssd_name)
     free(printer->dnssd_name);
@@ -2033,7 +2488,7 @@ delete_printer(
     free(printer->hostname);
 
   ippDelete(printer->attrs);
-  cupsArrayDelete(printer->jobs);
+  free(printer->jobs);
 
   free(printer);
 }
@@ -2091,8 +2546,8 @@ static ippeve_job_t *			// O - Job or NULL
 find_job(ippeve_client_t *client)		// I - Client
 {
   ipp_attribute_t	*attr;		// job-id or job-uri attribute
-  ippeve_job_t		key,		// Job search key
-			*job;		// Matching job, if any
+  int			id = 0;		// Job ID
+  ippeve_job_t		*job;		// Matching job, if any
 
 
   if ((attr = ippFindAttribute(client->request, "job-uri", IPP_TAG_URI)) != NULL)
@@ -2103,16 +2558,16 @@ find_job(ippeve_client_t *client)		// I - Client
 					// Pointer to the last slash in the URI
 
     if (uriptr && isdigit(uriptr[1] & 255))
-      key.id = atoi(uriptr + 1);
+      id = atoi(uriptr + 1);
     else
       return (NULL);
   }
   else if ((attr = ippFindAttribute(client->request, "job-id", IPP_TAG_INTEGER)) != NULL)
-    key.id = ippGetInteger(attr, 0);
+    id = ippGetInteger(attr, 0);
 
-  cupsRWLockRead(&(client->printer->rwlock));
-  job = (ippeve_job_t *)cupsArrayFind(client->printer->jobs, &key);
-  cupsRWUnlock(&(client->printer->rwlock));
+  lock_read(&(client->printer->jobs_rwlock), IPPEVE_LOCK_JOBS);
+  job = get_job(client->printer, id);
+  cupsRWUnlock(&(client->printer->jobs_rwlock));
 
   return (job);
 }
@@ -2127,81 +2582,98 @@ finish_document_data(
     ippeve_client_t *client,		// I - Client
     ippeve_job_t    *job)		// I - Job
 {
-  char			filename[1024],	// Filename buffer
-			buffer[4096];	// Copy buffer
+  char			filename[1024];	// Filename buffer
   ssize_t		bytes;		// Bytes read
+  cups_hash_t		*hash = NULL;	// Document hash for output cache
+  unsigned char		sha256[32];	// SHA-256 hash of document
   cups_array_t		*ra;		// Attributes to send in response
-  cups_thread_t        t;              // Thread
 
 
+#ifndef _WIN32
+  // Raster data is piped to ipptransform as it is received...
+  if (job->printer->command && (!strcmp(job->format, "image/pwg-raster") || !strcmp(job->format, "image/urf")) && ippGetInteger(ippFindAttribute(job->attrs, "copies", IPP_TAG_INTEGER), 0) <= 1)
+  {
+    const char *command = strrchr(job->printer->command, '/');
+					// Basename of command
+
+    command = command ? command + 1 : job->printer->command;
+
+    if (!strcmp(command, "ipptransform"))
+    {
+      finish_document_pipe(client, job);
+      return;
+    }
+  }
+#endif // !_WIN32
+
   // Create a file for the request data...
-  //
-  // TODO: Update code to support piping large raster data to the print command.
-  if ((job->fd = create_job_file(job, filename, sizeof(filename), client->printer->directory, NULL)) < 0)
+  if ((job->fd = create_spool_file(job, filename, sizeof(filename))) < 0)
   {
     respond_ipp(client, IPP_STATUS_ERROR_INTERNAL, "Unable to create print file: %s", strerror(errno));
 
     goto abort_job;
   }
 
-  if (Verbosity)
+  if (Verbosity && filename[0])
     fprintf(stderr, "Created job file \"%s\", format \"%s\".\n", filename, job->format);
 
-  while ((bytes = httpRead(client->http, buffer, sizeof(buffer))) > 0)
-  {
-    if (write(job->fd, buffer, (size_t)bytes) < bytes)
-    {
-      int error = errno;		// Write error
+  // Hash the document data for the output cache as it is received...
+  if (OutputCache && (hash = cupsHashInit("sha2-256")) != NULL)
+    httpSetHash(client->http, hash);
 
-      close(job->fd);
-      job->fd = -1;
+  // Copy the document data to the file, directly from the socket when possible...
+  while ((bytes = _httpReadFile(client->http, job->fd)) > 0);
 
-      unlink(filename);
+  if (hash)
+  {
+    httpSetHash(client->http, NULL);
 
-      respond_ipp(client, IPP_STATUS_ERROR_INTERNAL, "Unable to write print file: %s", strerror(error));
+    if (cupsHashFinish(hash, sha256, sizeof(sha256)) > 0)
+      cupsHashString(sha256, sizeof(sha256), job->hash, sizeof(job->hash));
 
-      goto abort_job;
-    }
+    hash = NULL;
   }
 
   if (bytes < 0)
   {
-    // Got an error while reading the print data, so abort this job.
+    // Got an error while reading or writing the print data, so abort this job.
+    int error = httpGetError(client->http);
+					// Read/write error
+
     close(job->fd);
     job->fd = -1;
 
-    unlink(filename);
+    if (filename[0])
+      unlink(filename);
 
-    respond_ipp(client, IPP_STATUS_ERROR_INTERNAL, "Unable to read print file.");
+    respond_ipp(client, IPP_STATUS_ERROR_INTERNAL, "Unable to spool print file: %s", strerror(error));
 
     goto abort_job;
   }
 
-  if (close(job->fd))
+  if (filename[0] && close(job->fd))
   {
     int error = errno;			// Write error
 
     job->fd = -1;
 
-    unlink(filename);
+    if (filename[0])
+      unlink(filename);
 
     respond_ipp(client, IPP_STATUS_ERROR_INTERNAL, "Unable to write print file: %s", strerror(error));
 
     goto abort_job;
   }
 
+  lock_write(&(job->rwlock), IPPEVE_LOCK_JOB);
+  job->spool_fd = filename[0] ? -1 : job->fd;
   job->fd       = -1;
   job->filename = strdup(filename);
   job->state    = IPP_JSTATE_PENDING;
+  cupsRWUnlock(&(job->rwlock));
 
   // Process the job...
-  t = cupsThreadCreate((cups_thread_func_t)process_job, job);
-
-  if (t)
-  {
-    cupsThreadDetach(t);
-  }
-  else
+  if (!cupsThreadPoolAdd(JobPool, (cups_thread_func_t)process_job, job))
   {
     respond_ipp(client, IPP_STATUS_ERROR_INTERNAL, "Unable to process job.");
     goto abort_job;
@@ -2217,15 +2689,17 @@ finish_document_data(
   cupsArrayAdd(ra, "job-state-reasons");
   cupsArrayAdd(ra, "job-uri");
 
-  copy_job_attributes(client, job, ra);
+  copy_job_attributes(client->response, job, ra);
   cupsArrayDelete(ra);
   return;
 
   // If we get here we had to abort the job...
   abort_job:
 
+  lock_write(&(job->rwlock), IPPEVE_LOCK_JOB);
   job->state     = IPP_JSTATE_ABORTED;
   job->completed = time(NULL);
+  cupsRWUnlock(&(job->rwlock));
 
   ra = cupsArrayNew((cups_array_cb_t)strcmp, NULL, NULL, 0, NULL, NULL);
   cupsArrayAdd(ra, "job-id");
@@ -2233,56 +2707,171 @@ finish_document_data(
   cupsArrayAdd(ra, "job-state-reasons");
   cupsArrayAdd(ra, "job-uri");
 
-  copy_job_attributes(client, job, ra);
+  copy_job_attributes(client->response, job, ra);
   cupsArrayDelete(ra);
 }
 
 
+#ifndef _WIN32
 //
-// 'finish_uri()' - Finish fetching a document URI and start processing.
+// 'finish_document_pipe()' - Pipe document data to the command as it is received.
+//
+// The command is started before the document data is read and gets the
+// document on the standard input with a filename of "-".
 //
 
 static void
-finish_document_uri(
+finish_document_pipe(
     ippeve_client_t *client,		// I - Client
     ippeve_job_t    *job)		// I - Job
 {
-  ipp_attribute_t	*uri;		// document-uri
-  char			scheme[256],	// URI scheme
-			userpass[256],	// Username and password info
-			hostname[256],	// Hostname
-			resource[1024];	// Resource path
-  int			port;		// Port number
-  http_uri_status_t	uri_status;	// URI decode status
-  http_encryption_t	encryption;	// Encryption to use, if any
-  http_t		*http;		// Connection for http/https URIs
-  http_status_t		status;		// Access status for http/https URIs
-  int			infile;		// Input file for local file URIs
-  char			filename[1024],	// Filename buffer
-			buffer[4096];	// Copy buffer
+  int			fds[2];		// Pipe to command
+  char			buffer[65536];	// Copy buffer
   ssize_t		bytes;		// Bytes read
-  ipp_attribute_t	*attr;		// Current attribute
+  bool			write_error = false;
+					// Did the command stop reading?
   cups_array_t		*ra;		// Attributes to send in response
 
 
-  // Do we have a file to print?
-  if (have_document_data(client))
+  // Create the pipe, which is not inherited by other commands...
+  if (pipe(fds))
   {
-    flush_document_data(client);
-    respond_ipp(client, IPP_STATUS_ERROR_BAD_REQUEST, "Unexpected document data following request.");
+    respond_ipp(client, IPP_STATUS_ERROR_INTERNAL, "Unable to create print pipe: %s", strerror(errno));
 
     goto abort_job;
   }
 
-  // Do we have a document URI?
-  if ((uri = ippFindAttribute(client->request, "document-uri", IPP_TAG_URI)) == NULL)
-  {
-    respond_ipp(client, IPP_STATUS_ERROR_BAD_REQUEST, "Missing document-uri.");
+  fcntl(fds[0], F_SETFD, fcntl(fds[0], F_GETFD) | FD_CLOEXEC);
+  fcntl(fds[1], F_SETFD, fcntl(fds[1], F_GETFD) | FD_CLOEXEC);
 
-    goto abort_job;
-  }
+  if (Verbosity)
+    fprintf(stderr, "Piping job data to command, format \"%s\".\n", job->format);
 
-  if (ippGetCount(uri) != 1)
+  lock_write(&(job->rwlock), IPPEVE_LOCK_JOB);
+  job->pipe_fd = fds[0];
+  job->fd      = fds[1];
+  job->state   = IPP_JSTATE_PENDING;
+  cupsRWUnlock(&(job->rwlock));
+
+  // Start processing the job...
+  if (!cupsThreadPoolAdd(JobPool, (cups_thread_func_t)process_job, job))
+  {
+    close(job->pipe_fd);
+    close(job->fd);
+    job->pipe_fd = -1;
+    job->fd      = -1;
+
+    respond_ipp(client, IPP_STATUS_ERROR_INTERNAL, "Unable to process job.");
+    goto abort_job;
+  }
+
+  // Copy the document data to the command, reading the rest of the request if
+  // the command exits early...
+  while ((bytes = httpRead(client->http, buffer, sizeof(buffer))) > 0)
+  {
+    if (!write_error && write(job->fd, buffer, (size_t)bytes) < bytes)
+    {
+      fprintf(stderr, "[Job %d] Print command stopped reading print data.\n", job->id);
+      write_error = true;
+    }
+  }
+
+  close(job->fd);
+  job->fd = -1;
+
+  if (bytes < 0)
+  {
+    // Got an error while reading the print data, so cancel this job.
+    lock_write(&(job->rwlock), IPPEVE_LOCK_JOB);
+    job->cancel = 1;
+    cupsRWUnlock(&(job->rwlock));
+
+    respond_ipp(client, IPP_STATUS_ERROR_INTERNAL, "Unable to read print file.");
+  }
+  else
+  {
+    respond_ipp(client, IPP_STATUS_OK, NULL);
+  }
+
+  // Return the job info...
+  ra = cupsArrayNew((cups_array_cb_t)strcmp, NULL, NULL, 0, NULL, NULL);
+  cupsArrayAdd(ra, "job-id");
+  cupsArrayAdd(ra, "job-state");
+  cupsArrayAdd(ra, "job-state-message");
+  cupsArrayAdd(ra, "job-state-reasons");
+  cupsArrayAdd(ra, "job-uri");
+
+  copy_job_attributes(client->response, job, ra);
+  cupsArrayDelete(ra);
+  return;
+
+  // If we get here we had to abort the job...
+  abort_job:
+
+  lock_write(&(job->rwlock), IPPEVE_LOCK_JOB);
+  job->state     = IPP_JSTATE_ABORTED;
+  job->completed = time(NULL);
+  cupsRWUnlock(&(job->rwlock));
+
+  ra = cupsArrayNew((cups_array_cb_t)strcmp, NULL, NULL, 0, NULL, NULL);
+  cupsArrayAdd(ra, "job-id");
+  cupsArrayAdd(ra, "job-state");
+  cupsArrayAdd(ra, "job-state-reasons");
+  cupsArrayAdd(ra, "job-uri");
+
+  copy_job_attributes(client->response, job, ra);
+  cupsArrayDelete(ra);
+}
+#endif // !_WIN32
+
+
+//
+// 'finish_uri()' - Finish fetching a document URI and start processing.
+//
+
+static void
+finish_document_uri(
+    ippeve_client_t *client,		// I - Client
+    ippeve_job_t    *job)		// I - Job
+{
+  ipp_attribute_t	*uri;		// document-uri
+  char			scheme[256],	// URI scheme
+			userpass[256],	// Username and password info
+			hostname[256],	// Hostname
+			resource[1024];	// Resource path
+  int			port;		// Port number
+  http_uri_status_t	uri_status;	// URI decode status
+  http_encryption_t	encryption;	// Encryption to use, if any
+  http_t		*http;		// Connection for http/https URIs
+  http_status_t		status;		// Access status for http/https URIs
+  int			infile;		// Input file for local file URIs
+  char			filename[1024],	// Filename buffer
+			buffer[4096];	// Copy buffer
+  ssize_t		bytes;		// Bytes read
+  cups_hash_t		*hash = NULL;	// Document hash for output cache
+  unsigned char		sha256[32];	// SHA-256 hash of document
+  ipp_attribute_t	*attr;		// Current attribute
+  cups_array_t		*ra;		// Attributes to send in response
+
+
+  // Do we have a file to print?
+  if (have_document_data(client))
+  {
+    flush_document_data(client);
+    respond_ipp(client, IPP_STATUS_ERROR_BAD_REQUEST, "Unexpected document data following request.");
+
+    goto abort_job;
+  }
+
+  // Do we have a document URI?
+  if ((uri = ippFindAttribute(client->request, "document-uri", IPP_TAG_URI)) == NULL)
+  {
+    respond_ipp(client, IPP_STATUS_ERROR_BAD_REQUEST, "Missing document-uri.");
+
+    goto abort_job;
+  }
+
+  if (ippGetCount(uri) != 1)
   {
     respond_ipp(client, IPP_STATUS_ERROR_BAD_REQUEST, "Too many document-uri values.");
 
@@ -2308,7 +2897,7 @@ finish_document_uri(
   }
 
   // Get the document format for the job...
-  cupsRWLockWrite(&(client->printer->rwlock));
+  lock_write(&(job->rwlock), IPPEVE_LOCK_JOB);
 
   if ((attr = ippFindAttribute(job->attrs, "document-format", IPP_TAG_MIMETYPE)) != NULL)
     job->format = ippGetString(attr, 0, NULL);
@@ -2316,16 +2905,20 @@ finish_document_uri(
     job->format = "application/octet-stream";
 
   // Create a file for the request data...
-  if ((job->fd = create_job_file(job, filename, sizeof(filename), client->printer->directory, NULL)) < 0)
+  if ((job->fd = create_spool_file(job, filename, sizeof(filename))) < 0)
   {
-    cupsRWUnlock(&(client->printer->rwlock));
+    cupsRWUnlock(&(job->rwlock));
 
     respond_ipp(client, IPP_STATUS_ERROR_INTERNAL, "Unable to create print file: %s", strerror(errno));
 
     goto abort_job;
   }
 
-  cupsRWUnlock(&(client->printer->rwlock));
+  cupsRWUnlock(&(job->rwlock));
+
+  // Hash the document data for the output cache as it is copied...
+  if (OutputCache)
+    hash = cupsHashInit("sha2-256");
 
   if (!strcmp(scheme, "file"))
   {
@@ -2350,13 +2943,18 @@ finish_document_uri(
 	close(job->fd);
 	job->fd = -1;
 
-	unlink(filename);
+	if (filename[0])
+	  unlink(filename);
 	close(infile);
 
 	respond_ipp(client, IPP_STATUS_ERROR_INTERNAL, "Unable to write print file: %s", strerror(error));
 
         goto abort_job;
       }
+      else if (bytes > 0 && hash)
+      {
+        cupsHashUpdate(hash, buffer, (size_t)bytes);
+      }
     }
     while (bytes > 0);
 
@@ -2376,7 +2974,8 @@ finish_document_uri(
       close(job->fd);
       job->fd = -1;
 
-      unlink(filename);
+      if (filename[0])
+        unlink(filename);
 
       goto abort_job;
     }
@@ -2390,7 +2989,8 @@ finish_document_uri(
       close(job->fd);
       job->fd = -1;
 
-      unlink(filename);
+      if (filename[0])
+        unlink(filename);
       httpClose(http);
 
       goto abort_job;
@@ -2405,12 +3005,15 @@ finish_document_uri(
       close(job->fd);
       job->fd = -1;
 
-      unlink(filename);
+      if (filename[0])
+        unlink(filename);
       httpClose(http);
 
       goto abort_job;
     }
 
+    httpSetHash(http, hash);
+
     while ((bytes = httpRead(http, buffer, sizeof(buffer))) > 0)
     {
       if (write(job->fd, buffer, (size_t)bytes) < bytes)
@@ -2420,7 +3023,8 @@ finish_document_uri(
 	close(job->fd);
 	job->fd = -1;
 
-	unlink(filename);
+	if (filename[0])
+	  unlink(filename);
 	httpClose(http);
 
 	respond_ipp(client, IPP_STATUS_ERROR_INTERNAL,
@@ -2433,26 +3037,36 @@ finish_document_uri(
     httpClose(http);
   }
 
-  if (close(job->fd))
+  if (filename[0] && close(job->fd))
   {
     int error = errno;		// Write error
 
     job->fd = -1;
 
-    unlink(filename);
+    if (filename[0])
+      unlink(filename);
 
     respond_ipp(client, IPP_STATUS_ERROR_INTERNAL, "Unable to write print file: %s", strerror(error));
 
     goto abort_job;
   }
 
-  cupsRWLockWrite(&(client->printer->rwlock));
+  if (hash)
+  {
+    if (cupsHashFinish(hash, sha256, sizeof(sha256)) > 0)
+      cupsHashString(sha256, sizeof(sha256), job->hash, sizeof(job->hash));
+
+    hash = NULL;
+  }
+
+  lock_write(&(job->rwlock), IPPEVE_LOCK_JOB);
 
+  job->spool_fd = filename[0] ? -1 : job->fd;
   job->fd       = -1;
   job->filename = strdup(filename);
   job->state    = IPP_JSTATE_PENDING;
 
-  cupsRWUnlock(&(client->printer->rwlock));
+  cupsRWUnlock(&(job->rwlock));
 
   // Process the job...
   process_job(job);
@@ -2466,15 +3080,20 @@ finish_document_uri(
   cupsArrayAdd(ra, "job-state-reasons");
   cupsArrayAdd(ra, "job-uri");
 
-  copy_job_attributes(client, job, ra);
+  copy_job_attributes(client->response, job, ra);
   cupsArrayDelete(ra);
   return;
 
   // If we get here we had to abort the job...
   abort_job:
 
+  if (hash)
+    cupsHashFinish(hash, NULL, 0);
+
+  lock_write(&(job->rwlock), IPPEVE_LOCK_JOB);
   job->state     = IPP_JSTATE_ABORTED;
   job->completed = time(NULL);
+  cupsRWUnlock(&(job->rwlock));
 
   ra = cupsArrayNew((cups_array_cb_t)strcmp, NULL, NULL, 0, NULL, NULL);
   cupsArrayAdd(ra, "job-id");
@@ -2482,7 +3101,7 @@ finish_document_uri(
   cupsArrayAdd(ra, "job-state-reasons");
   cupsArrayAdd(ra, "job-uri");
 
-  copy_job_attributes(client, job, ra);
+  copy_job_attributes(client->response, job, ra);
   cupsArrayDelete(ra);
 }
 
@@ -2505,6 +3124,147 @@ flush_document_data(
 }
 
 
+//
+// 'get_job()' - Get a job by ID.
+//
+// The caller must hold the printer's jobs_rwlock.
+//
+
+static ippeve_job_t *			// O - Job or `NULL`
+get_job(ippeve_printer_t *printer,	// I - Printer
+        int              id)		// I - Job ID
+{
+  if (id < printer->first_job_id || id >= printer->next_job_id)
+    return (NULL);
+
+  return (printer->jobs[(printer->first_job + (size_t)(id - printer->first_job_id)) % printer->alloc_jobs]);
+}
+
+
+//
+// 'get_resource()' - Get a cached static resource.
+//
+// Files are read into memory the first time they are requested and again
+// whenever they change.  The returned resource must be released using
+// `release_resource`.
+//
+
+static ippeve_resource_t *		// O - Resource or `NULL` on error
+get_resource(
+    const char          *filename,	// I - Filename or `NULL` for built-in data
+    const unsigned char *data,		// I - Built-in data
+    size_t              length)		// I - Length of built-in data
+{
+  size_t		i;		// Looping var
+  ippeve_resource_t	*resource,	// Resource
+			**slot = NULL;	// Cache slot for new resource
+  struct stat		fileinfo;	// File information
+  unsigned char		hash[32];	// SHA-256 hash of data
+  char			hashstr[65];	// Hash string
+
+
+  if (filename && stat(filename, &fileinfo))
+    return (NULL);
+
+  // See if we already have the resource...
+  cupsMutexLock(&ResourceMutex);
+
+  for (i = 0; i < IPPEVE_MAX_RESOURCES; i ++)
+  {
+    if ((resource = Resources[i]) == NULL)
+    {
+      if (!slot)
+        slot = Resources + i;
+    }
+    else if (filename ? (resource->filename && !strcmp(resource->filename, filename)) : resource->data == data)
+    {
+      if (!filename || (resource->fileinfo.st_ino == fileinfo.st_ino && resource->fileinfo.st_size == fileinfo.st_size && resource->fileinfo.st_mtime == fileinfo.st_mtime))
+      {
+        resource->refcount ++;
+	cupsMutexUnlock(&ResourceMutex);
+	return (resource);
+      }
+
+      // File has changed, replace it...
+      slot = Resources + i;
+      break;
+    }
+  }
+
+  cupsMutexUnlock(&ResourceMutex);
+
+  // Load the resource...
+  if (filename)
+  {
+    int		fd;			// File descriptor
+    ssize_t	bytes;			// Bytes read
+    size_t	total;			// Total bytes read
+
+    if ((fd = open(filename, O_RDONLY | O_BINARY)) < 0)
+      return (NULL);
+
+    if (fstat(fd, &fileinfo) || (resource = calloc(1, sizeof(ippeve_resource_t) + (size_t)fileinfo.st_size)) == NULL)
+    {
+      close(fd);
+      return (NULL);
+    }
+
+    resource->filename = strdup(filename);
+    resource->fileinfo = fileinfo;
+    resource->data     = (unsigned char *)(resource + 1);
+    resource->length   = (size_t)fileinfo.st_size;
+
+    for (total = 0; total < resource->length; total += (size_t)bytes)
+    {
+      if ((bytes = read(fd, (unsigned char *)resource->data + total, resource->length - total)) <= 0)
+        break;
+    }
+
+    close(fd);
+
+    if (total < resource->length || !resource->filename)
+    {
+      free(resource->filename);
+      free(resource);
+      return (NULL);
+    }
+  }
+  else
+  {
+    if ((resource = calloc(1, sizeof(ippeve_resource_t))) == NULL)
+      return (NULL);
+
+    resource->data   = data;
+    resource->length = length;
+  }
+
+  // Use the first 128 bits of the SHA-256 hash as a strong entity tag...
+  cupsHashData("sha2-256", resource->data, resource->length, hash, sizeof(hash));
+  cupsHashString(hash, 16, hashstr, sizeof(hashstr));
+  snprintf(resource->etag, sizeof(resource->etag), "\"%s\"", hashstr);
+
+  resource->refcount = 1;
+
+  // Cache it if there is room...
+  if (slot)
+  {
+    ippeve_resource_t	*old;		// Old resource
+
+    cupsMutexLock(&ResourceMutex);
+
+    old   = *slot;
+    *slot = resource;
+    resource->refcount ++;
+
+    cupsMutexUnlock(&ResourceMutex);
+
+    release_resource(old);
+  }
+
+  return (resource);
+}
+
+
 //
 // 'have_document_data()' - Determine whether we have more document data.
 //
@@ -2878,6 +3638,57 @@ html_printf(ippeve_client_t *client,	// I - Client
 }
 
 
+//
+// 'idle_client()' - Add a client to the idle client event loop.
+//
+
+static void
+idle_client(ippeve_client_t *client)	// I - Client
+{
+  cupsMutexLock(&ClientMutex);
+  cupsArrayAdd(ClientIdle, client);
+  cupsCondBroadcast(&ClientCond);
+  cupsMutexUnlock(&ClientMutex);
+
+  httpLoopWake(ClientLoop);
+}
+
+
+//
+// 'idle_client_cb()' - Dispatch or close an idle client.
+//
+
+static bool				// O - `true` to keep waiting, `false` to remove from loop
+idle_client_cb(
+    http_loop_t        *loop,		// I - Event loop
+    http_t             *http,		// I - HTTP connection
+    http_loop_events_t events,		// I - Events
+    ippeve_client_t    *client)		// I - Client
+{
+  (void)loop;
+  (void)http;
+
+  NumLoopClients --;
+
+  if (events & HTTP_LOOP_READ)
+  {
+    // Process the request on a worker thread...
+    if (!cupsThreadPoolAdd(ClientPool, (cups_thread_func_t)process_client, client))
+    {
+      perror("Unable to queue client");
+      delete_client(client);
+    }
+  }
+  else
+  {
+    // Closed by the client or timed out...
+    delete_client(client);
+  }
+
+  return (false);
+}
+
+
 //
 // 'ipp_cancel_job()' - Cancel a job.
 //
@@ -2915,7 +3726,7 @@ ipp_cancel_job(ippeve_client_t *client)	// I - Client
 
     default :
         // Cancel the job...
-	cupsRWLockWrite(&(client->printer->rwlock));
+	lock_write(&(job->rwlock), IPPEVE_LOCK_JOB);
 
 	if (job->state == IPP_JSTATE_PROCESSING ||
 	    (job->state == IPP_JSTATE_HELD && job->fd >= 0))
@@ -2926,7 +3737,7 @@ ipp_cancel_job(ippeve_client_t *client)	// I - Client
 	  job->completed = time(NULL);
 	}
 
-	cupsRWUnlock(&(client->printer->rwlock));
+	cupsRWUnlock(&(job->rwlock));
 
 	respond_ipp(client, IPP_STATUS_OK, NULL);
         break;
@@ -2948,10 +3759,12 @@ ipp_cancel_my_jobs(
   ippeve_job_t		*job;		// Job information
 
 
-  cupsRWLockWrite(&client->printer->rwlock);
+  lock_read(&client->printer->jobs_rwlock, IPPEVE_LOCK_JOBS);
 
   if ((job = client->printer->active_job) != NULL)
   {
+    lock_write(&job->rwlock, IPPEVE_LOCK_JOB);
+
     // See if the job is already completed, canceled, or aborted; if so, we can't cancel...
     if (job->state < IPP_JSTATE_CANCELED)
     {
@@ -2966,11 +3779,13 @@ ipp_cancel_my_jobs(
 	job->completed = time(NULL);
       }
     }
+
+    cupsRWUnlock(&job->rwlock);
   }
 
   respond_ipp(client, IPP_STATUS_OK, NULL);
 
-  cupsRWUnlock(&client->printer->rwlock);
+  cupsRWUnlock(&client->printer->jobs_rwlock);
 }
 
 
@@ -3063,7 +3878,7 @@ ipp_create_job(ippeve_client_t *client)	// I - Client
   cupsArrayAdd(ra, "job-state-reasons");
   cupsArrayAdd(ra, "job-uri");
 
-  copy_job_attributes(client, job, ra);
+  copy_job_attributes(client->response, job, ra);
   cupsArrayDelete(ra);
 }
 
@@ -3089,7 +3904,7 @@ ipp_get_job_attributes(
   respond_ipp(client, IPP_STATUS_OK, NULL);
 
   ra = ippCreateRequestedArray(client->request);
-  copy_job_attributes(client, job, ra);
+  copy_job_attributes(client->response, job, ra);
   cupsArrayDelete(ra);
 }
 
@@ -3107,8 +3922,13 @@ ipp_get_jobs(ippeve_client_t *client)	// I - Client
   int			job_comparison;	// Job comparison
   ipp_jstate_t		job_state;	// job-state value
   int			first_job_id,	// First job ID
+			first_index,	// First matching job to return
 			limit,		// Maximum number of jobs to return
-			count;		// Number of jobs that match
+			count,		// Number of jobs that match
+			id;		// Current job ID
+  int			*ids = NULL;	// Job IDs to return
+  size_t		num_ids = 0,	// Number of job IDs
+			alloc_ids = 0;	// Allocated job IDs
   const char		*username;	// Username
   ippeve_job_t		*job;		// Current job pointer
   cups_array_t		*ra;		// Requested attributes array
@@ -3198,6 +4018,23 @@ ipp_get_jobs(ippeve_client_t *client)	// I - Client
     first_job_id = 1;
   }
 
+  if ((attr = ippFindAttribute(client->request, "first-index", IPP_TAG_INTEGER)) != NULL)
+  {
+    first_index = ippGetInteger(attr, 0);
+
+    fprintf(stderr, "%s Get-Jobs first-index=%d", client->hostname, first_index);
+
+    if (first_index < 1)
+    {
+      respond_unsupported(client, attr);
+      return;
+    }
+  }
+  else
+  {
+    first_index = 1;
+  }
+
   // See if we only want to see jobs for a specific user...
   username = NULL;
 
@@ -3226,28 +4063,116 @@ ipp_get_jobs(ippeve_client_t *client)	// I - Client
 
   respond_ipp(client, IPP_STATUS_OK, NULL);
 
-  cupsRWLockRead(&(client->printer->rwlock));
+  lock_read(&(client->printer->jobs_rwlock), IPPEVE_LOCK_JOBS);
 
-  for (count = 0, job = (ippeve_job_t *)cupsArrayGetFirst(client->printer->jobs); (limit <= 0 || count < limit) && job; job = (ippeve_job_t *)cupsArrayGetNext(client->printer->jobs))
+  if ((attr = ippFindAttribute(client->request, "job-ids", IPP_TAG_INTEGER)) != NULL)
   {
-    // Filter out jobs that don't match...
-    if ((job_comparison < 0 && job->state > job_state) ||
-	(job_comparison == 0 && job->state != job_state) ||
-	(job_comparison > 0 && job->state < job_state) ||
-	job->id < first_job_id ||
-	(username && job->username && strcasecmp(username, job->username)))
-      continue;
+    // Report the requested jobs in the order they were listed...
+    size_t	i,			// Looping var
+		num_job_ids = ippGetCount(attr);
+					// Number of job-ids values
+
+    if ((ids = calloc(num_job_ids, sizeof(int))) == NULL)
+    {
+      respond_ipp(client, IPP_STATUS_ERROR_INTERNAL, "Unable to allocate memory: %s", strerror(errno));
+      cupsArrayDelete(ra);
+      cupsRWUnlock(&(client->printer->jobs_rwlock));
+      return;
+    }
+
+    for (i = 0; i < num_job_ids; i ++)
+    {
+      id = ippGetInteger(attr, i);
+
+      if ((job = get_job(client->printer, id)) == NULL || (username && job->username && strcasecmp(username, job->username)))
+        continue;
+
+      ids[num_ids ++] = id;
+    }
+  }
+  else
+  {
+    if (job_state < IPP_JSTATE_CANCELED && job_comparison <= 0)
+    {
+      // Only the active job can be pending, held, processing, or stopped...
+      if ((job = client->printer->active_job) != NULL)
+        id = job->id;
+      else
+        id = 0;
 
-    if (count > 0)
-      ippAddSeparator(client->response);
+      if (first_job_id < id)
+        first_job_id = id;
+    }
+    else
+    {
+      // Report jobs from newest to oldest...
+      id = client->printer->next_job_id - 1;
+    }
 
-    count ++;
-    copy_job_attributes(client, job, ra);
+    if (first_job_id < client->printer->first_job_id)
+      first_job_id = client->printer->first_job_id;
+
+    for (count = 0; (limit <= 0 || num_ids < (size_t)limit) && id >= first_job_id; id --)
+    {
+      if ((job = get_job(client->printer, id)) == NULL)
+        continue;
+
+      // Filter out jobs that don't match...
+      if ((job_comparison < 0 && job->state > job_state) ||
+	  (job_comparison == 0 && job->state != job_state) ||
+	  (job_comparison > 0 && job->state < job_state) ||
+	  (username && job->username && strcasecmp(username, job->username)))
+        continue;
+
+      // Skip jobs before the first-index...
+      if (++ count < first_index)
+        continue;
+
+      if (num_ids >= alloc_ids)
+      {
+        int *temp;			// New job IDs
+
+        if ((temp = realloc(ids, (alloc_ids + 1024) * sizeof(int))) == NULL)
+        {
+	  respond_ipp(client, IPP_STATUS_ERROR_INTERNAL, "Unable to allocate memory: %s", strerror(errno));
+	  free(ids);
+	  cupsArrayDelete(ra);
+	  cupsRWUnlock(&(client->printer->jobs_rwlock));
+	  return;
+        }
+
+        ids       = temp;
+        alloc_ids += 1024;
+      }
+
+      ids[num_ids ++] = id;
+    }
   }
 
-  cupsArrayDelete(ra);
+  if (num_ids > IPPEVE_STREAM_JOBS)
+  {
+    // Stream large responses from respond_http()...
+    client->stream_ids     = ids;
+    client->num_stream_ids = num_ids;
+    client->stream_ra      = ra;
+  }
+  else
+  {
+    size_t	i;			// Looping var
 
-  cupsRWUnlock(&(client->printer->rwlock));
+    for (i = 0; i < num_ids; i ++)
+    {
+      if (i > 0)
+	ippAddSeparator(client->response);
+
+      copy_job_attributes(client->response, get_job(client->printer, ids[i]), ra);
+    }
+
+    free(ids);
+    cupsArrayDelete(ra);
+  }
+
+  cupsRWUnlock(&(client->printer->jobs_rwlock));
 }
 
 
@@ -3261,6 +4186,7 @@ ipp_get_printer_attributes(
 {
   cups_array_t		*ra;		// Requested attributes array
   ippeve_printer_t	*printer;	// Printer
+  int			queued;		// queued-job-count value
 
 
   // Send the attributes...
@@ -3269,7 +4195,11 @@ ipp_get_printer_attributes(
 
   respond_ipp(client, IPP_STATUS_OK, NULL);
 
-  cupsRWLockRead(&(printer->rwlock));
+  lock_read(&(printer->jobs_rwlock), IPPEVE_LOCK_JOBS);
+  queued = printer->active_job && printer->active_job->state < IPP_JSTATE_CANCELED;
+  cupsRWUnlock(&(printer->jobs_rwlock));
+
+  lock_read(&(printer->rwlock), IPPEVE_LOCK_PRINTER);
 
   copy_attributes(client->response, printer->attrs, ra, IPP_TAG_ZERO,
 		  IPP_TAG_CUPS_CONST);
@@ -3385,7 +4315,7 @@ ipp_get_printer_attributes(
   }
 
   if (!ra || cupsArrayFind(ra, "queued-job-count"))
-    ippAddInteger(client->response, IPP_TAG_PRINTER, IPP_TAG_INTEGER, "queued-job-count", printer->active_job && printer->active_job->state < IPP_JSTATE_CANCELED);
+    ippAddInteger(client->response, IPP_TAG_PRINTER, IPP_TAG_INTEGER, "queued-job-count", queued);
 
   cupsRWUnlock(&(printer->rwlock));
 
@@ -3568,7 +4498,7 @@ ipp_send_document(
     job->state = IPP_JSTATE_ABORTED;
 
   // Then finish getting the document data and process things...
-  cupsRWLockWrite(&(client->printer->rwlock));
+  lock_write(&(job->rwlock), IPPEVE_LOCK_JOB);
 
   copy_attributes(job->attrs, client->request, NULL, IPP_TAG_JOB, 0);
 
@@ -3579,7 +4509,7 @@ ipp_send_document(
   else
     job->format = "application/octet-stream";
 
-  cupsRWUnlock(&(client->printer->rwlock));
+  cupsRWUnlock(&(job->rwlock));
 
   if (have_data)
     finish_document_data(client, job);
@@ -3642,7 +4572,7 @@ ipp_send_uri(ippeve_client_t *client)	// I - Client
   }
 
   // Then finish getting the document data and process things...
-  cupsRWLockWrite(&(client->printer->rwlock));
+  lock_write(&(job->rwlock), IPPEVE_LOCK_JOB);
 
   copy_attributes(job->attrs, client->request, NULL, IPP_TAG_JOB, 0);
 
@@ -3653,7 +4583,7 @@ ipp_send_uri(ippeve_client_t *client)	// I - Client
   else
     job->format = "application/octet-stream";
 
-  cupsRWUnlock(&(client->printer->rwlock));
+  cupsRWUnlock(&(job->rwlock));
 
   finish_document_uri(client, job);
 }
@@ -3793,6 +4723,41 @@ ippserver_error_cb(
 }
 
 
+//
+// 'load_cached_attributes()' - Load IPP attributes from the cache.
+//
+
+static ipp_t *				// O - IPP attributes or `NULL` if not cached
+load_cached_attributes(
+    const char *filename)		// I - Cache filename
+{
+  int		fd;			// Cache file
+  ipp_t		*attrs;			// IPP attributes
+  ipp_state_t	state;			// Read state
+
+
+  if ((fd = open(filename, O_RDONLY | O_BINARY)) < 0)
+    return (NULL);
+
+  attrs = ippNew();
+  state = ippReadFile(fd, attrs);
+
+  close(fd);
+
+  if (state != IPP_STATE_DATA)
+  {
+    fprintf(stderr, "Ignoring bad attribute cache file \"%s\".\n", filename);
+    ippDelete(attrs);
+    return (NULL);
+  }
+
+  if (Verbosity)
+    fprintf(stderr, "Loaded cached attributes from \"%s\".\n", filename);
+
+  return (attrs);
+}
+
+
 //
 // 'load_ippserver_attributes()' - Load IPP attributes from an ippserver file.
 //
@@ -4505,80 +5470,308 @@ load_legacy_attributes(
       ippSetOctetString(attrs, &attr, i, printer_input_tray[i], strlen(printer_input_tray[i]));
   }
 
-  // printer-make-and-model
-  snprintf(make_model, sizeof(make_model), "%s %s", make, model);
-  ippAddString(attrs, IPP_TAG_PRINTER, IPP_TAG_TEXT, "printer-make-and-model", NULL, make_model);
+  // printer-make-and-model
+  snprintf(make_model, sizeof(make_model), "%s %s", make, model);
+  ippAddString(attrs, IPP_TAG_PRINTER, IPP_TAG_TEXT, "printer-make-and-model", NULL, make_model);
+
+  // printer-resolution-default
+  ippAddResolution(attrs, IPP_TAG_PRINTER, "printer-resolution-default", IPP_RES_PER_INCH, 600, 600);
+
+  // printer-resolution-supported
+  ippAddResolution(attrs, IPP_TAG_PRINTER, "printer-resolution-supported", IPP_RES_PER_INCH, 600, 600);
+
+  // printer-supply and printer-supply-description
+  if (ppm_color > 0)
+  {
+    attr = ippAddOctetString(attrs, IPP_TAG_PRINTER, "printer-supply", printer_supply_color[0], strlen(printer_supply_color[0]));
+    for (i = 1; i < (int)(sizeof(printer_supply_color) / sizeof(printer_supply_color[0])); i ++)
+      ippSetOctetString(attrs, &attr, i, printer_supply_color[i], strlen(printer_supply_color[i]));
+
+    ippAddStrings(attrs, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_TEXT), "printer-supply-description", (int)(sizeof(printer_supply_description_color) / sizeof(printer_supply_description_color[0])), NULL, printer_supply_description_color);
+  }
+  else
+  {
+    attr = ippAddOctetString(attrs, IPP_TAG_PRINTER, "printer-supply", printer_supply[0], strlen(printer_supply[0]));
+    for (i = 1; i < (int)(sizeof(printer_supply) / sizeof(printer_supply[0])); i ++)
+      ippSetOctetString(attrs, &attr, i, printer_supply[i], strlen(printer_supply[i]));
+
+    ippAddStrings(attrs, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_TEXT), "printer-supply-description", (int)(sizeof(printer_supply_description) / sizeof(printer_supply_description[0])), NULL, printer_supply_description);
+  }
+
+  // pwg-raster-document-xxx-supported
+  if (cupsArrayFind(docformats, (void *)"image/pwg-raster"))
+  {
+    ippAddResolutions(attrs, IPP_TAG_PRINTER, "pwg-raster-document-resolution-supported", (int)(sizeof(pwg_raster_document_resolution_supported) / sizeof(pwg_raster_document_resolution_supported[0])), IPP_RES_PER_INCH, pwg_raster_document_resolution_supported, pwg_raster_document_resolution_supported);
+
+    if (ppm_color > 0 && duplex)
+      ippAddString(attrs, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "pwg-raster-document-sheet-back", NULL, "rotated");
+    else if (duplex)
+      ippAddString(attrs, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "pwg-raster-document-sheet-back", NULL, "normal");
+
+    if (ppm_color > 0)
+      ippAddStrings(attrs, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "pwg-raster-document-type-supported", (int)(sizeof(pwg_raster_document_type_supported_color) / sizeof(pwg_raster_document_type_supported_color[0])), NULL, pwg_raster_document_type_supported_color);
+    else
+      ippAddStrings(attrs, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "pwg-raster-document-type-supported", (int)(sizeof(pwg_raster_document_type_supported) / sizeof(pwg_raster_document_type_supported[0])), NULL, pwg_raster_document_type_supported);
+  }
+
+  // sides-default
+  ippAddString(attrs, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "sides-default", NULL, "one-sided");
+
+  // sides-supported
+  if (duplex)
+    ippAddStrings(attrs, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "sides-supported", (int)(sizeof(sides_supported) / sizeof(sides_supported[0])), NULL, sides_supported);
+  else
+    ippAddString(attrs, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "sides-supported", NULL, "one-sided");
+
+  // urf-supported
+  if (cupsArrayFind(docformats, (void *)"image/urf"))
+  {
+    if (ppm_color > 0)
+    {
+      if (duplex)
+	ippAddStrings(attrs, IPP_TAG_PRINTER, IPP_TAG_KEYWORD, "urf-supported", (int)(sizeof(urf_supported_color_duplex) / sizeof(urf_supported_color_duplex[0])), NULL, urf_supported_color_duplex);
+      else
+	ippAddStrings(attrs, IPP_TAG_PRINTER, IPP_TAG_KEYWORD, "urf-supported", (int)(sizeof(urf_supported_color) / sizeof(urf_supported_color[0])), NULL, urf_supported_color);
+    }
+    else if (duplex)
+    {
+      ippAddStrings(attrs, IPP_TAG_PRINTER, IPP_TAG_KEYWORD, "urf-supported", (int)(sizeof(urf_supported_duplex) / sizeof(urf_supported_duplex[0])), NULL, urf_supported_duplex);
+    }
+    else
+    {
+      ippAddStrings(attrs, IPP_TAG_PRINTER, IPP_TAG_KEYWORD, "urf-supported", (int)(sizeof(urf_supported) / sizeof(urf_supported[0])), NULL, urf_supported);
+    }
+  }
+
+  return (attrs);
+}
+
+
+//
+// 'lock_read()' - Acquire a reader lock, recording the wait time.
+//
+
+static void
+lock_read(cups_rwlock_t *rwlock,	// I - Reader/writer lock
+          ippeve_lock_t type)		// I - Type of lock
+{
+  double	start = metrics_time();	// Start time
+
+
+  cupsRWLockRead(rwlock);
+
+  cupsMutexLock(&Metrics.mutex);
+  Metrics.lock_count[type] ++;
+  Metrics.lock_wait[type] += metrics_time() - start;
+  cupsMutexUnlock(&Metrics.mutex);
+}
+
+
+//
+// 'lock_write()' - Acquire a writer lock, recording the wait time.
+//
+
+static void
+lock_write(cups_rwlock_t *rwlock,	// I - Reader/writer lock
+           ippeve_lock_t type)		// I - Type of lock
+{
+  double	start = metrics_time();	// Start time
+
+
+  cupsRWLockWrite(rwlock);
+
+  cupsMutexLock(&Metrics.mutex);
+  Metrics.lock_count[type] ++;
+  Metrics.lock_wait[type] += metrics_time() - start;
+  cupsMutexUnlock(&Metrics.mutex);
+}
+
+
+//
+// 'metrics_observe()' - Add a time to a histogram.
+//
+// The metrics mutex must be held by the caller.
+//
+
+static void
+metrics_observe(ippeve_histogram_t *h,	// I - Histogram
+                double             value)// I - Time in seconds
+{
+  size_t	i;			// Looping var
+
+
+  for (i = 0; i < IPPEVE_METRICS_BUCKETS; i ++)
+  {
+    if (value <= ippeve_metrics_buckets[i])
+    {
+      h->buckets[i] ++;
+      break;
+    }
+  }
+
+  h->count ++;
+  h->sum += value;
+}
+
+
+//
+// 'metrics_printf()' - Send formatted text for the metrics resource.
+//
+
+static bool				// O - `true` on success, `false` on error
+metrics_printf(
+    ippeve_client_t *client,		// I - Client
+    const char      *format,		// I - Printf-style format string
+    ...)				// I - Additional arguments as needed
+{
+  char		buffer[1024];		// Output buffer
+  int		bytes;			// Number of bytes
+  va_list	ap;			// Pointer to arguments
+
+
+  va_start(ap, format);
+  bytes = vsnprintf(buffer, sizeof(buffer), format, ap);
+  va_end(ap);
+
+  if (bytes < 0 || (size_t)bytes >= sizeof(buffer))
+    return (false);
+
+  return (httpWrite(client->http, buffer, (size_t)bytes) >= 0);
+}
+
+
+//
+// 'metrics_request()' - Record the time and traffic for a request.
+//
+
+static void
+metrics_request(
+    ippeve_client_t *client,		// I - Client
+    double          start,		// I - Start time
+    http_stats_t    *before)		// I - Connection statistics before the request
+{
+  http_stats_t	after;			// Connection statistics after the request
+  double	elapsed = metrics_time() - start;
+					// Elapsed time
+
+
+  httpGetStats(client->http, &after);
+
+  cupsMutexLock(&Metrics.mutex);
+
+  Metrics.bytes_in  += after.bytes_read - before->bytes_read;
+  Metrics.bytes_out += after.bytes_written - before->bytes_written;
+
+  if (client->operation_id != IPP_OP_CUPS_INVALID)
+  {
+    // IPP request, unknown and vendor operations are tracked as 0...
+    metrics_observe(Metrics.ipp + ((int)client->operation_id < IPPEVE_METRICS_OPS ? client->operation_id : 0), elapsed);
+  }
+  else if (client->operation > HTTP_STATE_WAITING && client->operation < HTTP_STATE_MAX)
+  {
+    // Other HTTP request...
+    metrics_observe(Metrics.http + client->operation, elapsed);
+  }
+
+  cupsMutexUnlock(&Metrics.mutex);
+}
+
+
+//
+// 'metrics_time()' - Get the current monotonic time in seconds.
+//
+
+static double				// O - Time in seconds
+metrics_time(void)
+{
+#ifdef _WIN32
+  return (0.001 * GetTickCount64());
+
+#else
+  struct timespec curtime;		// Current time
+
+
+  clock_gettime(CLOCK_MONOTONIC, &curtime);
+
+  return (curtime.tv_sec + 0.000000001 * curtime.tv_nsec);
+#endif // _WIN32
+}
+
+
+//
+// 'output_cache_enabled()' - Determine whether a job's output can be cached.
+//
+// Jobs with banner pages are not cached since the banners change with every
+// job.  Jobs for devices other than "file" and "socket" are not cached either
+// since the print command delivers the output to those devices itself.
+//
+
+static bool				// O - `true` if cached, `false` otherwise
+output_cache_enabled(ippeve_job_t *job)	// I - Job
+{
+  ipp_attribute_t	*attr;		// Job attribute
+  char			scheme[32],	// URI scheme
+			userpass[256],	// username:password (unused)
+			host[256],	// Hostname or IP address
+			resource[256];	// Resource path
+  int			port;		// Port number
+
 
-  // printer-resolution-default
-  ippAddResolution(attrs, IPP_TAG_PRINTER, "printer-resolution-default", IPP_RES_PER_INCH, 600, 600);
+  if (!OutputCache || !job->hash[0] || !job->printer->command)
+    return (false);
 
-  // printer-resolution-supported
-  ippAddResolution(attrs, IPP_TAG_PRINTER, "printer-resolution-supported", IPP_RES_PER_INCH, 600, 600);
+  if ((attr = ippFindAttribute(job->attrs, "job-sheets", IPP_TAG_ZERO)) != NULL && strcmp(ippGetString(attr, 0, NULL), "none"))
+    return (false);
 
-  // printer-supply and printer-supply-description
-  if (ppm_color > 0)
-  {
-    attr = ippAddOctetString(attrs, IPP_TAG_PRINTER, "printer-supply", printer_supply_color[0], strlen(printer_supply_color[0]));
-    for (i = 1; i < (int)(sizeof(printer_supply_color) / sizeof(printer_supply_color[0])); i ++)
-      ippSetOctetString(attrs, &attr, i, printer_supply_color[i], strlen(printer_supply_color[i]));
+  if (job->printer->device_uri && (httpSeparateURI(HTTP_URI_CODING_ALL, job->printer->device_uri, scheme, sizeof(scheme), userpass, sizeof(userpass), host, sizeof(host), &port, resource, sizeof(resource)) < HTTP_URI_STATUS_OK || (strcmp(scheme, "file") && strcmp(scheme, "socket"))))
+    return (false);
 
-    ippAddStrings(attrs, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_TEXT), "printer-supply-description", (int)(sizeof(printer_supply_description_color) / sizeof(printer_supply_description_color[0])), NULL, printer_supply_description_color);
-  }
-  else
-  {
-    attr = ippAddOctetString(attrs, IPP_TAG_PRINTER, "printer-supply", printer_supply[0], strlen(printer_supply[0]));
-    for (i = 1; i < (int)(sizeof(printer_supply) / sizeof(printer_supply[0])); i ++)
-      ippSetOctetString(attrs, &attr, i, printer_supply[i], strlen(printer_supply[i]));
+  return (true);
+}
 
-    ippAddStrings(attrs, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_TEXT), "printer-supply-description", (int)(sizeof(printer_supply_description) / sizeof(printer_supply_description[0])), NULL, printer_supply_description);
-  }
 
-  // pwg-raster-document-xxx-supported
-  if (cupsArrayFind(docformats, (void *)"image/pwg-raster"))
-  {
-    ippAddResolutions(attrs, IPP_TAG_PRINTER, "pwg-raster-document-resolution-supported", (int)(sizeof(pwg_raster_document_resolution_supported) / sizeof(pwg_raster_document_resolution_supported[0])), IPP_RES_PER_INCH, pwg_raster_document_resolution_supported, pwg_raster_document_resolution_supported);
+//
+// 'output_cache_filename()' - Get the output cache filename for a job.
+//
+// The filename is a SHA-256 hash of the document data, print command, and the
+// CONTENT_TYPE, OUTPUT_TYPE, and IPP_xxx environment variables passed to the
+// command, so jobs share a cache file only when the command sees the same
+// document and environment.
+//
 
-    if (ppm_color > 0 && duplex)
-      ippAddString(attrs, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "pwg-raster-document-sheet-back", NULL, "rotated");
-    else if (duplex)
-      ippAddString(attrs, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "pwg-raster-document-sheet-back", NULL, "normal");
+static char *				// O - Cache filename or `NULL` if not cached
+output_cache_filename(
+    ippeve_job_t *job,			// I - Job
+    char         **envp,		// I - Job environment variables
+    char         *buffer,		// I - Filename buffer
+    size_t       bufsize)		// I - Size of filename buffer
+{
+  cups_hash_t		*ctx;		// Hash context
+  char			value[2048],	// Document hash and command
+			hash[65];	// Hex hash of key
+  unsigned char		sha256[32];	// SHA-256 hash of key
 
-    if (ppm_color > 0)
-      ippAddStrings(attrs, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "pwg-raster-document-type-supported", (int)(sizeof(pwg_raster_document_type_supported_color) / sizeof(pwg_raster_document_type_supported_color[0])), NULL, pwg_raster_document_type_supported_color);
-    else
-      ippAddStrings(attrs, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "pwg-raster-document-type-supported", (int)(sizeof(pwg_raster_document_type_supported) / sizeof(pwg_raster_document_type_supported[0])), NULL, pwg_raster_document_type_supported);
-  }
 
-  // sides-default
-  ippAddString(attrs, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "sides-default", NULL, "one-sided");
+  if ((ctx = cupsHashInit("sha2-256")) == NULL)
+    return (NULL);
 
-  // sides-supported
-  if (duplex)
-    ippAddStrings(attrs, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "sides-supported", (int)(sizeof(sides_supported) / sizeof(sides_supported[0])), NULL, sides_supported);
-  else
-    ippAddString(attrs, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "sides-supported", NULL, "one-sided");
+  snprintf(value, sizeof(value), "%s\n%s\n", job->hash, job->printer->command);
+  cupsHashUpdate(ctx, value, strlen(value));
 
-  // urf-supported
-  if (cupsArrayFind(docformats, (void *)"image/urf"))
+  for (; *envp; envp ++)
   {
-    if (ppm_color > 0)
-    {
-      if (duplex)
-	ippAddStrings(attrs, IPP_TAG_PRINTER, IPP_TAG_KEYWORD, "urf-supported", (int)(sizeof(urf_supported_color_duplex) / sizeof(urf_supported_color_duplex[0])), NULL, urf_supported_color_duplex);
-      else
-	ippAddStrings(attrs, IPP_TAG_PRINTER, IPP_TAG_KEYWORD, "urf-supported", (int)(sizeof(urf_supported_color) / sizeof(urf_supported_color[0])), NULL, urf_supported_color);
-    }
-    else if (duplex)
-    {
-      ippAddStrings(attrs, IPP_TAG_PRINTER, IPP_TAG_KEYWORD, "urf-supported", (int)(sizeof(urf_supported_duplex) / sizeof(urf_supported_duplex[0])), NULL, urf_supported_duplex);
-    }
-    else
-    {
-      ippAddStrings(attrs, IPP_TAG_PRINTER, IPP_TAG_KEYWORD, "urf-supported", (int)(sizeof(urf_supported) / sizeof(urf_supported[0])), NULL, urf_supported);
-    }
+    cupsHashUpdate(ctx, *envp, strlen(*envp));
+    cupsHashUpdate(ctx, "\n", 1);
   }
 
-  return (attrs);
+  if (cupsHashFinish(ctx, sha256, sizeof(sha256)) <= 0)
+    return (NULL);
+
+  cupsHashString(sha256, sizeof(sha256), hash, sizeof(hash));
+
+  snprintf(buffer, bufsize, "%s/%s.prn", OutputCache, hash);
+
+  return (buffer);
 }
 
 
@@ -4714,7 +5907,7 @@ process_attr_message(
     else if (!strncmp(option->name, "marker-", 7) || !strcmp(option->name, "printer-alert") || !strcmp(option->name, "printer-alert-description") || !strcmp(option->name, "printer-supply") || !strcmp(option->name, "printer-supply-description"))
     {
       // Update Printer Status attribute...
-      cupsRWLockWrite(&job->printer->rwlock);
+      lock_write(&job->printer->rwlock, IPPEVE_LOCK_PRINTER);
 
       if ((attr = ippFindAttribute(job->printer->attrs, option->name, IPP_TAG_ZERO)) != NULL)
         ippDeleteAttribute(job->printer->attrs, attr);
@@ -4723,6 +5916,32 @@ process_attr_message(
 
       cupsRWUnlock(&job->printer->rwlock);
     }
+    else if (!strncmp(option->name, "ipptransform-", 13))
+    {
+      // Record ipptransform statistics as integer Job Status attributes...
+      lock_write(&job->rwlock, IPPEVE_LOCK_JOB);
+
+      if ((attr = ippFindAttribute(job->attrs, option->name, IPP_TAG_ZERO)) != NULL)
+        ippDeleteAttribute(job->attrs, attr);
+
+      ippAddInteger(job->attrs, IPP_TAG_JOB, IPP_TAG_INTEGER, option->name, (int)strtol(option->value, NULL, 10));
+
+      cupsRWUnlock(&job->rwlock);
+
+      if (!strcmp(option->name, "ipptransform-wall-msec") || !strcmp(option->name, "ipptransform-cpu-msec"))
+      {
+        // Accumulate transform times for the metrics resource...
+        double msec = strtod(option->value, NULL);
+					// Milliseconds
+
+        cupsMutexLock(&Metrics.mutex);
+        if (option->name[13] == 'w')
+          Metrics.transform_wall += 0.001 * msec;
+        else
+          Metrics.transform_cpu += 0.001 * msec;
+        cupsMutexUnlock(&Metrics.mutex);
+      }
+    }
     else
     {
       // Something else that isn't currently supported...
@@ -4737,42 +5956,58 @@ process_attr_message(
 //
 // 'process_client()' - Process client requests on a thread.
 //
+// This function is called from the client thread pool when a request starts
+// arriving on a connection.  Once there are no more pipelined requests the
+// connection is returned to the idle client event loop.
+//
 
 static void *				// O - Exit status
 process_client(ippeve_client_t *client)	// I - Client
 {
-  // Loop until we are out of requests or timeout (30 seconds)...
-  bool first_time = true;		// First time request?
-
-  while (httpWait(client->http, 30000))
+  if (!client->started)
   {
-    if (first_time)
+    // See if we need to negotiate a TLS connection...
+    char buf[1];			// First byte from client
+
+    if (recv(httpGetFd(client->http), buf, 1, MSG_PEEK) == 1 && (!buf[0] || !strchr("DGHOPT", buf[0])))
     {
-      // See if we need to negotiate a TLS connection...
-      char buf[1];			// First byte from client
+      fprintf(stderr, "%s Starting HTTPS session.\n", client->hostname);
 
-      if (recv(httpGetFd(client->http), buf, 1, MSG_PEEK) == 1 && (!buf[0] || !strchr("DGHOPT", buf[0])))
+      if (!httpSetEncryption(client->http, HTTP_ENCRYPTION_ALWAYS))
       {
-        fprintf(stderr, "%s Starting HTTPS session.\n", client->hostname);
-
-	if (!httpSetEncryption(client->http, HTTP_ENCRYPTION_ALWAYS))
-	{
-	  fprintf(stderr, "%s Unable to encrypt connection: %s\n", client->hostname, cupsGetErrorString());
-	  break;
-        }
-
-        fprintf(stderr, "%s Connection now encrypted.\n", client->hostname);
+	fprintf(stderr, "%s Unable to encrypt connection: %s\n", client->hostname, cupsGetErrorString());
+	delete_client(client);
+	return (NULL);
       }
 
-      first_time = false;
+      fprintf(stderr, "%s Connection now encrypted.\n", client->hostname);
     }
 
+    client->started = true;
+  }
+
+  // Process requests until there are no more buffered or pending requests...
+  do
+  {
+    double	start = metrics_time();	// Start of request
+    http_stats_t before;		// Connection statistics before request
+
+    httpGetStats(client->http, &before);
+
     if (!process_http(client))
-      break;
+    {
+      // Close the conection to the client and return...
+      metrics_request(client, start, &before);
+      delete_client(client);
+      return (NULL);
+    }
+
+    metrics_request(client, start, &before);
   }
+  while (httpWait(client->http, 0));
 
-  // Close the conection to the client and return...
-  delete_client(client);
+  // Wait for the next request without tying up a thread...
+  idle_client(client);
 
   return (NULL);
 }
@@ -4802,10 +6037,16 @@ process_http(ippeve_client_t *client)	// I - Client connection
 
   ippDelete(client->request);
   ippDelete(client->response);
+  free(client->stream_ids);
+  cupsArrayDelete(client->stream_ra);
 
-  client->request   = NULL;
-  client->response  = NULL;
-  client->operation = HTTP_STATE_WAITING;
+  client->request        = NULL;
+  client->response       = NULL;
+  client->operation      = HTTP_STATE_WAITING;
+  client->operation_id   = IPP_OP_CUPS_INVALID;
+  client->stream_ids     = NULL;
+  client->num_stream_ids = 0;
+  client->stream_ra      = NULL;
 
   // Read a request from the connection...
   while ((http_state = httpReadRequest(client->http, uri, sizeof(uri))) == HTTP_STATE_WAITING)
@@ -4929,6 +6170,8 @@ process_http(ippeve_client_t *client)	// I - Client connection
 	  return (respond_http(client, HTTP_STATUS_OK, NULL, "image/png", 0));
 	else if (!strcmp(client->uri, "/") || !strcmp(client->uri, "/media") || !strcmp(client->uri, "/supplies"))
 	  return (respond_http(client, HTTP_STATUS_OK, NULL, "text/html", 0));
+	else if (!strcmp(client->uri, "/metrics"))
+	  return (respond_http(client, HTTP_STATUS_OK, NULL, "text/plain; version=0.0.4", 0));
 	else
 	  return (respond_http(client, HTTP_STATUS_NOT_FOUND, NULL, NULL, 0));
 
@@ -4937,35 +6180,7 @@ process_http(ippeve_client_t *client)	// I - Client connection
 	{
 	  // Send strings file.
           if (client->printer->strings)
-          {
-	    int		fd;		// Icon file
-	    struct stat	fileinfo;	// Icon file information
-	    char	buffer[4096];	// Copy buffer
-	    ssize_t	bytes;		// Bytes
-
-	    if ((fd = open(client->printer->strings, O_RDONLY | O_BINARY)) >= 0)
-	    {
-	      if (fstat(fd, &fileinfo))
-	      {
-		close(fd);
-		return (0);
-	      }
-	      else if (!respond_http(client, HTTP_STATUS_OK, NULL, "text/strings", (size_t)fileinfo.st_size))
-	      {
-		close(fd);
-		return (0);
-	      }
-
-	      while ((bytes = read(fd, buffer, sizeof(buffer))) > 0)
-		httpWrite(client->http, buffer, (size_t)bytes);
-
-	      httpFlushWrite(client->http);
-
-	      close(fd);
-	    }
-	    else
-	      return (respond_http(client, HTTP_STATUS_NOT_FOUND, NULL, NULL, 0));
-	  }
+	    return (respond_resource(client, "text/strings", client->printer->strings, NULL, 0));
 	  else
 	    return (respond_http(client, HTTP_STATUS_NOT_FOUND, NULL, NULL, 0));
         }
@@ -4973,133 +6188,25 @@ process_http(ippeve_client_t *client)	// I - Client connection
 	{
 	  // Send medium PNG icon file.
           if (client->printer->icons[1])
-          {
-	    int		fd;		// Icon file
-	    struct stat	fileinfo;	// Icon file information
-	    char	buffer[4096];	// Copy buffer
-	    ssize_t	bytes;		// Bytes
-
-	    if ((fd = open(client->printer->icons[1], O_RDONLY | O_BINARY)) >= 0)
-	    {
-	      if (fstat(fd, &fileinfo))
-	      {
-		close(fd);
-		return (0);
-	      }
-	      else if (!respond_http(client, HTTP_STATUS_OK, NULL, "image/png", (size_t)fileinfo.st_size))
-	      {
-		close(fd);
-		return (0);
-	      }
-
-	      while ((bytes = read(fd, buffer, sizeof(buffer))) > 0)
-		httpWrite(client->http, buffer, (size_t)bytes);
-
-	      httpFlushWrite(client->http);
-
-	      close(fd);
-	    }
-	    else
-	      return (respond_http(client, HTTP_STATUS_NOT_FOUND, NULL, NULL, 0));
-	  }
+	    return (respond_resource(client, "image/png", client->printer->icons[1], NULL, 0));
 	  else
-	  {
-	    fputs("Icon file is internal printer.png.\n", stderr);
-
-	    if (!respond_http(client, HTTP_STATUS_OK, NULL, "image/png", sizeof(printer_png)))
-	      return (0);
-
-            httpWrite(client->http, (const char *)printer_png, sizeof(printer_png));
-	    httpFlushWrite(client->http);
-	  }
+	    return (respond_resource(client, "image/png", NULL, printer_png, sizeof(printer_png)));
 	}
         else if (!strcmp(client->uri, "/icon-lg.png"))
 	{
 	  // Send large PNG icon file.
           if (client->printer->icons[2])
-          {
-	    int		fd;		// Icon file
-	    struct stat	fileinfo;	// Icon file information
-	    char	buffer[4096];	// Copy buffer
-	    ssize_t	bytes;		// Bytes
-
-	    if ((fd = open(client->printer->icons[2], O_RDONLY | O_BINARY)) >= 0)
-	    {
-	      if (fstat(fd, &fileinfo))
-	      {
-		close(fd);
-		return (0);
-	      }
-	      else if (!respond_http(client, HTTP_STATUS_OK, NULL, "image/png", (size_t)fileinfo.st_size))
-	      {
-		close(fd);
-		return (0);
-	      }
-
-	      while ((bytes = read(fd, buffer, sizeof(buffer))) > 0)
-		httpWrite(client->http, buffer, (size_t)bytes);
-
-	      httpFlushWrite(client->http);
-
-	      close(fd);
-	    }
-	    else
-	      return (respond_http(client, HTTP_STATUS_NOT_FOUND, NULL, NULL, 0));
-	  }
+	    return (respond_resource(client, "image/png", client->printer->icons[2], NULL, 0));
 	  else
-	  {
-	    fputs("Icon file is internal printer-lg.png.\n", stderr);
-
-	    if (!respond_http(client, HTTP_STATUS_OK, NULL, "image/png", sizeof(printer_lg_png)))
-	      return (0);
-
-            httpWrite(client->http, (const char *)printer_lg_png, sizeof(printer_lg_png));
-	    httpFlushWrite(client->http);
-	  }
+	    return (respond_resource(client, "image/png", NULL, printer_lg_png, sizeof(printer_lg_png)));
 	}
         else if (!strcmp(client->uri, "/icon-sm.png"))
 	{
 	  // Send small PNG icon file.
           if (client->printer->icons[0])
-          {
-	    int		fd;		// Icon file
-	    struct stat	fileinfo;	// Icon file information
-	    char	buffer[4096];	// Copy buffer
-	    ssize_t	bytes;		// Bytes
-
-	    if ((fd = open(client->printer->icons[0], O_RDONLY | O_BINARY)) >= 0)
-	    {
-	      if (fstat(fd, &fileinfo))
-	      {
-		close(fd);
-		return (0);
-	      }
-	      else if (!respond_http(client, HTTP_STATUS_OK, NULL, "image/png", (size_t)fileinfo.st_size))
-	      {
-		close(fd);
-		return (0);
-	      }
-
-	      while ((bytes = read(fd, buffer, sizeof(buffer))) > 0)
-		httpWrite(client->http, buffer, (size_t)bytes);
-
-	      httpFlushWrite(client->http);
-
-	      close(fd);
-	    }
-	    else
-	      return (respond_http(client, HTTP_STATUS_NOT_FOUND, NULL, NULL, 0));
-	  }
+	    return (respond_resource(client, "image/png", client->printer->icons[0], NULL, 0));
 	  else
-	  {
-	    fputs("Icon file is internal printer-sm.png.\n", stderr);
-
-	    if (!respond_http(client, HTTP_STATUS_OK, NULL, "image/png", sizeof(printer_sm_png)))
-	      return (0);
-
-            httpWrite(client->http, (const char *)printer_sm_png, sizeof(printer_sm_png));
-	    httpFlushWrite(client->http);
-	  }
+	    return (respond_resource(client, "image/png", NULL, printer_sm_png, sizeof(printer_sm_png)));
 	}
 	else
 	{
@@ -5119,6 +6226,11 @@ process_http(ippeve_client_t *client)	// I - Client connection
 	    // Show web media page...
 	    return (show_media(client));
 	  }
+	  else if (!strcmp(client->uri, "/metrics"))
+	  {
+	    // Show server metrics...
+	    return (show_metrics(client));
+	  }
 	  else if (!strcmp(client->uri, "/supplies"))
 	  {
 	    // Show web supplies page...
@@ -5380,7 +6492,7 @@ process_ipp(ippeve_client_t *client)	// I - Client
   if (httpGetState(client->http) != HTTP_STATE_POST_SEND)
     httpFlush(client->http);		// Flush trailing (junk) data
 
-  return (respond_http(client, HTTP_STATUS_OK, NULL, "application/ipp", ippGetLength(client->response)));
+  return (respond_http(client, HTTP_STATUS_OK, NULL, "application/ipp", client->stream_ids ? 0 : ippGetLength(client->response)));
 }
 
 
@@ -5391,18 +6503,30 @@ process_ipp(ippeve_client_t *client)	// I - Client
 static void *				// O - Thread exit status
 process_job(ippeve_job_t *job)		// I - Job
 {
-  job->state          = IPP_JSTATE_PROCESSING;
+  double	processing_start = metrics_time();
+					// Start of processing
+
+
+  lock_write(&job->rwlock, IPPEVE_LOCK_JOB);
+  job->state      = IPP_JSTATE_PROCESSING;
+  job->processing = time(NULL);
+  cupsRWUnlock(&job->rwlock);
+
+  lock_write(&job->printer->rwlock, IPPEVE_LOCK_PRINTER);
   job->printer->state = IPP_PSTATE_PROCESSING;
-  job->processing     = time(NULL);
 
   while (job->printer->state_reasons & IPPEVE_PREASON_MEDIA_EMPTY)
   {
     job->printer->state_reasons |= IPPEVE_PREASON_MEDIA_NEEDED;
 
+    // Don't hold the printer lock while waiting for media to be loaded...
+    cupsRWUnlock(&job->printer->rwlock);
     sleep(1);
+    lock_write(&job->printer->rwlock, IPPEVE_LOCK_PRINTER);
   }
 
   job->printer->state_reasons &= (ippeve_preason_t)~IPPEVE_PREASON_MEDIA_NEEDED;
+  cupsRWUnlock(&job->printer->rwlock);
 
   if (job->printer->command)
   {
@@ -5413,27 +6537,35 @@ process_job(ippeve_job_t *job)		// I - Job
 			end;		// End time
     char		*myargv[3],	// Command-line arguments
 			*myenvp[400];	// Environment variables
-    int			myenvc;		// Number of environment variables
+    int			myenvc,		// Number of environment variables
+			jobenvc;	// First job environment variable
     ipp_attribute_t	*attr;		// Job attribute
     char		val[1280],	// IPP_NAME=value
 			*valptr;	// Pointer into string
 #ifndef _WIN32
     int			mystdout = -1;	// File for stdout
     int			mypipe[2];	// Pipe for stderr
+    bool		caching = output_cache_enabled(job);
+					// Cache the command output?
+    char		cachefile[1024] = "",
+					// Output cache file
+			tempfile[1024];	// Temporary output cache file
+    int			cachefd = -1,	// Cached output
+			tempfd = -1;	// Command output for the cache
     char		line[2048],	// Line from stderr
 			*ptr,		// Pointer into line
 			*endptr;	// End of line
     ssize_t		bytes;		// Bytes read
 #endif // !_WIN32
 
-    fprintf(stderr, "[Job %d] Running command \"%s %s\".\n", job->id, job->printer->command, job->filename);
-    gettimeofday(&start, NULL);
-
-    // Setup the command-line arguments...
+    // Setup the command-line arguments, using "-" for piped print data and
+    // "/dev/fd/3" for memory spool files...
     myargv[0] = job->printer->command;
-    myargv[1] = job->filename;
+    myargv[1] = job->pipe_fd >= 0 ? "-" : job->spool_fd >= 0 ? "/dev/fd/3" : job->filename;
     myargv[2] = NULL;
 
+    gettimeofday(&start, NULL);
+
     // Copy the current environment, then add environment variables for every
     // Job attribute and Printer -default attributes...
     for (myenvc = 0; environ[myenvc] && myenvc < (int)(sizeof(myenvp) / sizeof(myenvp[0]) - 1); myenvc ++)
@@ -5446,10 +6578,18 @@ process_job(ippeve_job_t *job)		// I - Job
       goto error;
     }
 
+    jobenvc = myenvc;
+
     snprintf(val, sizeof(val), "CONTENT_TYPE=%s", job->format);
     myenvp[myenvc ++] = strdup(val);
 
+#ifndef _WIN32
+    // Cached output is sent to the device by ippeveprinter, so the command must
+    // write to the standard output instead of the device URI...
+    if (job->printer->device_uri && !caching)
+#else
     if (job->printer->device_uri)
+#endif // !_WIN32
     {
       snprintf(val, sizeof(val), "DEVICE_URI=%s", job->printer->device_uri);
       myenvp[myenvc ++] = strdup(val);
@@ -5503,6 +6643,13 @@ process_job(ippeve_job_t *job)		// I - Job
       if (!name)
         continue;
 
+#ifndef _WIN32
+      // Attributes that are unique to each job are not passed to the command
+      // when caching since the cached output would never be reused...
+      if (caching && (!strcmp(name, "job-id") || !strcmp(name, "job-uri") || !strcmp(name, "job-uuid") || !strncmp(name, "time-at-", 8) || !strncmp(name, "date-time-at-", 13)))
+        continue;
+#endif // !_WIN32
+
       valptr = val;
       *valptr++ = 'I';
       *valptr++ = 'P';
@@ -5532,6 +6679,15 @@ process_job(ippeve_job_t *job)		// I - Job
 
     myenvp[myenvc] = NULL;
 
+#ifndef _WIN32
+    // Use the cached output from a previous job with the same document and
+    // environment, if any...
+    if (caching && output_cache_filename(job, myenvp + jobenvc, cachefile, sizeof(cachefile)) && (cachefd = open(cachefile, O_RDONLY | O_BINARY)) >= 0)
+      fprintf(stderr, "[Job %d] Using cached print command output \"%s\".\n", job->id, cachefile);
+    else
+#endif // !_WIN32
+      fprintf(stderr, "[Job %d] Running command \"%s %s\".\n", job->id, myargv[0], myargv[1]);
+
     // Now run the program...
 #ifdef _WIN32
     status = _spawnvpe(_P_WAIT, job->printer->command, myargv, myenvp);
@@ -5604,7 +6760,7 @@ process_job(ippeve_job_t *job)		// I - Job
         fprintf(stderr, "[Job %d] Unsupported device URI scheme \"%s\".\n", job->id, scheme);
       }
     }
-    else if ((mystdout = create_job_file(job, line, sizeof(line), job->printer->directory, "prn")) >= 0)
+    else if (!MemorySpool && (mystdout = create_job_file(job, line, sizeof(line), job->printer->directory, "prn")) >= 0)
     {
       fprintf(stderr, "[Job %d] Saving print command output to \"%s\".\n", job->id, line);
     }
@@ -5615,16 +6771,55 @@ process_job(ippeve_job_t *job)		// I - Job
         fprintf(stderr, "[Job %d] Unable to redirect command output to /dev/null: %s", job->id, strerror(errno));
     }
 
-    if (pipe(mypipe))
+    if (cachefile[0] && cachefd < 0)
+    {
+      // Save the command output in a temporary file that replaces the cache
+      // file once the command completes successfully...
+      snprintf(tempfile, sizeof(tempfile), "%s.%d.tmp", cachefile, job->id);
+
+      if ((tempfd = open(tempfile, O_RDWR | O_CREAT | O_TRUNC | O_EXCL | O_BINARY, 0600)) < 0)
+        fprintf(stderr, "[Job %d] Unable to create \"%s\": %s\n", job->id, tempfile, strerror(errno));
+    }
+
+    if (cachefd >= 0)
+    {
+      // No command output when using the output cache...
+      mypipe[0] = mypipe[1] = -1;
+    }
+    else if (pipe(mypipe))
     {
       fprintf(stderr, "[Job %d] Unable to create pipe for stderr: %s\n", job->id, strerror(errno));
       mypipe[0] = mypipe[1] = -1;
     }
 
-    if ((pid = fork()) == 0)
+    if (cachefd >= 0)
+    {
+      // Free memory used for environment...
+      while (myenvc > 0)
+	free(myenvp[-- myenvc]);
+
+      status = 0;
+    }
+    else if ((pid = fork()) == 0)
     {
       // Child comes here...
-      if (mystdout >= 0)
+      if (job->pipe_fd >= 0)
+      {
+        close(0);
+        dup2(job->pipe_fd, 0);
+        close(job->pipe_fd);
+      }
+
+      if (tempfd >= 0)
+      {
+        close(1);
+        dup2(tempfd, 1);
+        close(tempfd);
+
+        if (mystdout >= 0)
+          close(mystdout);
+      }
+      else if (mystdout >= 0)
       {
         close(1);
         dup2(mystdout, 1);
@@ -5639,6 +6834,17 @@ process_job(ippeve_job_t *job)		// I - Job
 	close(mypipe[1]);
       }
 
+      if (job->spool_fd >= 0)
+      {
+        // Pass the memory spool file as file descriptor 3...
+        lseek(job->spool_fd, 0, SEEK_SET);
+
+        if (job->spool_fd == 3)
+          fcntl(3, F_SETFD, 0);
+        else
+          dup2(job->spool_fd, 3);
+      }
+
       execve(job->printer->command, myargv, myenvp);
       exit(errno);
     }
@@ -5648,9 +6854,6 @@ process_job(ippeve_job_t *job)		// I - Job
       fprintf(stderr, "[Job %d] Unable to start job processing command: %s\n", job->id, strerror(errno));
       status = -1;
 
-      if (mystdout >= 0)
-	close(mystdout);
-
       if (mypipe[0] >= 0)
       {
 	close(mypipe[0]);
@@ -5667,9 +6870,18 @@ process_job(ippeve_job_t *job)		// I - Job
       while (myenvc > 0)
 	free(myenvp[-- myenvc]);
 
-      // Close the output file in the parent process...
-      if (mystdout >= 0)
+      // Close the output file and print data pipe in the parent process...
+      if (mystdout >= 0 && tempfd < 0)
+      {
 	close(mystdout);
+	mystdout = -1;
+      }
+
+      if (job->pipe_fd >= 0)
+      {
+        close(job->pipe_fd);
+        job->pipe_fd = -1;
+      }
 
       // If the pipe exists, read from it until EOF...
       if (mypipe[0] >= 0)
@@ -5702,8 +6914,12 @@ process_job(ippeve_job_t *job)		// I - Job
 	    {
 	      // Error message...
               level         = 0;
+
+              lock_write(&job->rwlock, IPPEVE_LOCK_JOB);
+              free(job->message);
               job->message  = strdup(line + 6);
               job->msglevel = 0;
+              cupsRWUnlock(&job->rwlock);
 	    }
 	    else if (!strncmp(line, "INFO:", 5))
 	    {
@@ -5711,8 +6927,11 @@ process_job(ippeve_job_t *job)		// I - Job
               level = 1;
               if (job->msglevel)
               {
+                lock_write(&job->rwlock, IPPEVE_LOCK_JOB);
+                free(job->message);
                 job->message  = strdup(line + 5);
                 job->msglevel = 1;
+                cupsRWUnlock(&job->rwlock);
 	      }
 	    }
 	    else if (!strncmp(line, "STATE:", 6))
@@ -5732,16 +6951,63 @@ process_job(ippeve_job_t *job)		// I - Job
 	  }
 	}
 
-	close(mypipe[0]);
+	close(mypipe[0]);
+      }
+
+      // Wait for child to complete...
+#  ifdef HAVE_WAITPID
+      while (waitpid(pid, &status, 0) < 0);
+#  else
+      while (wait(&status) < 0);
+#  endif // HAVE_WAITPID
+    }
+
+    if (tempfd >= 0)
+    {
+      if (status)
+      {
+        // Don't cache the output of a failed command...
+        close(tempfd);
+        unlink(tempfile);
+      }
+      else
+      {
+        // Add the command output to the cache and then send it...
+        if (rename(tempfile, cachefile))
+        {
+          fprintf(stderr, "[Job %d] Unable to save \"%s\": %s\n", job->id, cachefile, strerror(errno));
+          unlink(tempfile);
+        }
+        else
+        {
+          fprintf(stderr, "[Job %d] Saved print command output to \"%s\".\n", job->id, cachefile);
+        }
+
+        cachefd = tempfd;
+        lseek(cachefd, 0, SEEK_SET);
+      }
+    }
+
+    if (cachefd >= 0)
+    {
+      // Copy the cached output to the device or output file...
+      char	buffer[65536];		// Copy buffer
+
+      while ((bytes = read(cachefd, buffer, sizeof(buffer))) > 0)
+      {
+        if (mystdout >= 0 && write(mystdout, buffer, (size_t)bytes) < bytes)
+        {
+          fprintf(stderr, "[Job %d] Unable to write print command output: %s\n", job->id, strerror(errno));
+          job->state = IPP_JSTATE_ABORTED;
+          break;
+        }
       }
 
-      // Wait for child to complete...
-#  ifdef HAVE_WAITPID
-      while (waitpid(pid, &status, 0) < 0);
-#  else
-      while (wait(&status) < 0);
-#  endif // HAVE_WAITPID
+      close(cachefd);
     }
+
+    if (mystdout >= 0)
+      close(mystdout);
 #endif // _WIN32
 
     if (status)
@@ -5772,16 +7038,44 @@ process_job(ippeve_job_t *job)		// I - Job
     sleep((unsigned)(5 + (cupsGetRand() % 11)));
   }
 
+  lock_write(&job->rwlock, IPPEVE_LOCK_JOB);
   if (job->cancel)
     job->state = IPP_JSTATE_CANCELED;
   else if (job->state == IPP_JSTATE_PROCESSING)
     job->state = IPP_JSTATE_COMPLETED;
+  cupsRWUnlock(&job->rwlock);
 
   error:
 
-  job->completed           = time(NULL);
-  job->printer->state      = IPP_PSTATE_IDLE;
+  if (job->pipe_fd >= 0)
+  {
+    // Close the print data pipe so the client stops sending data...
+    close(job->pipe_fd);
+    job->pipe_fd = -1;
+  }
+
+  if (job->spool_fd >= 0)
+  {
+    // Free the memory spool file now that the command is done with it...
+    close(job->spool_fd);
+    job->spool_fd = -1;
+  }
+
+  lock_write(&job->rwlock, IPPEVE_LOCK_JOB);
+  job->completed = time(NULL);
+  cupsRWUnlock(&job->rwlock);
+
+  cupsMutexLock(&Metrics.mutex);
+  metrics_observe(&Metrics.jobs, metrics_time() - processing_start);
+  cupsMutexUnlock(&Metrics.mutex);
+
+  lock_write(&job->printer->rwlock, IPPEVE_LOCK_PRINTER);
+  job->printer->state = IPP_PSTATE_IDLE;
+  cupsRWUnlock(&job->printer->rwlock);
+
+  lock_write(&job->printer->jobs_rwlock, IPPEVE_LOCK_JOBS);
   job->printer->active_job = NULL;
+  cupsRWUnlock(&job->printer->jobs_rwlock);
 
   return (NULL);
 }
@@ -5821,6 +7115,8 @@ process_state_message(
   //
   // Keywords may or may not have a suffix (-report, -warning, -error) per
   // RFC 8011.
+  lock_write(&job->printer->rwlock, IPPEVE_LOCK_PRINTER);
+
   if (*message == '-')
   {
     remove        = 1;
@@ -5869,6 +7165,8 @@ process_state_message(
   }
 
   job->printer->state_reasons = state_reasons;
+
+  cupsRWUnlock(&job->printer->rwlock);
 }
 
 
@@ -5952,7 +7250,7 @@ register_printer(
     const char	*uuid = ippGetString(printer_uuid, 0, NULL);
 					// "printer-uuid" value
 
-    cupsRWLockWrite(&printer->rwlock);
+    lock_write(&printer->rwlock, IPPEVE_LOCK_PRINTER);
 
     snprintf(new_dnssd_name, sizeof(new_dnssd_name), "%s (%c%c%c%c%c%c)", printer->dnssd_name, toupper(uuid[39]), toupper(uuid[40]), toupper(uuid[41]), toupper(uuid[42]), toupper(uuid[43]), toupper(uuid[44]));
 
@@ -6033,6 +7331,32 @@ register_printer(
 }
 
 
+//
+// 'release_resource()' - Release a cached static resource.
+//
+
+static void
+release_resource(
+    ippeve_resource_t *resource)	// I - Resource
+{
+  bool	last;				// Last reference?
+
+
+  if (!resource)
+    return;
+
+  cupsMutexLock(&ResourceMutex);
+  last = --resource->refcount == 0;
+  cupsMutexUnlock(&ResourceMutex);
+
+  if (last)
+  {
+    free(resource->filename);
+    free(resource);
+  }
+}
+
+
 //
 // 'respond_http()' - Send a HTTP response.
 //
@@ -6045,7 +7369,8 @@ respond_http(
     const char    *type,		// I - MIME media type of response
     size_t        length)		// I - Length of response
 {
-  char	message[1024];			// Text message
+  char	message[1024],			// Text message
+	keep_alive[32];			// Keep-Alive value
 
 
   fprintf(stderr, "%s %s\n", client->hostname, httpStatusString(code));
@@ -6057,7 +7382,7 @@ respond_http(
   }
 
   // Format an error message...
-  if (!type && !length && code != HTTP_STATUS_OK && code != HTTP_STATUS_SWITCHING_PROTOCOLS)
+  if (!type && !length && code != HTTP_STATUS_OK && code != HTTP_STATUS_SWITCHING_PROTOCOLS && code != HTTP_STATUS_NOT_MODIFIED)
   {
     snprintf(message, sizeof(message), "%d - %s\n", code, httpStatusString(code));
 
@@ -6070,6 +7395,9 @@ respond_http(
   // Send the HTTP response header...
   httpClearFields(client->http);
 
+  snprintf(keep_alive, sizeof(keep_alive), "timeout=%d", IPPEVE_KEEPALIVE_TIMEOUT);
+  httpSetField(client->http, HTTP_FIELD_KEEP_ALIVE, keep_alive);
+
   if (code == HTTP_STATUS_METHOD_NOT_ALLOWED || client->operation == HTTP_STATE_OPTIONS)
     httpSetField(client->http, HTTP_FIELD_ALLOW, "GET, HEAD, OPTIONS, POST");
 
@@ -6092,7 +7420,11 @@ respond_http(
       httpSetField(client->http, HTTP_FIELD_CONTENT_ENCODING, content_encoding);
   }
 
-  httpSetLength(client->http, length);
+  if (client->etag)
+    httpSetField(client->http, HTTP_FIELD_ETAG, client->etag);
+
+  if (code != HTTP_STATUS_NOT_MODIFIED)
+    httpSetLength(client->http, length);	// 304 responses have no message body
 
   if (!httpWriteResponse(client->http, code))
     return (false);
@@ -6114,8 +7446,15 @@ respond_http(
 
     ippSetState(client->response, IPP_STATE_IDLE);
 
-    if (ippWrite(client->http, client->response) != IPP_STATE_DATA)
+    if (client->stream_ids)
+    {
+      if (!stream_jobs(client))
+        return (false);
+    }
+    else if (ippWrite(client->http, client->response) != IPP_STATE_DATA)
+    {
       return (false);
+    }
   }
 
   return (true);
@@ -6179,6 +7518,50 @@ respond_ipp(ippeve_client_t *client,	// I - Client
 }
 
 
+//
+// 'respond_resource()' - Send a cached static resource.
+//
+// A strong entity tag is sent with the resource so that clients can use
+// "If-None-Match" to revalidate it without transferring the data again.
+//
+
+static int				// O - 1 on success, 0 on failure
+respond_resource(
+    ippeve_client_t     *client,	// I - Client
+    const char          *type,		// I - MIME media type
+    const char          *filename,	// I - Filename or `NULL` for built-in data
+    const unsigned char *data,		// I - Built-in data
+    size_t              length)		// I - Length of built-in data
+{
+  int			ret;		// Return value
+  ippeve_resource_t	*resource;	// Resource
+  const char		*match;		// If-None-Match value
+
+
+  if ((resource = get_resource(filename, data, length)) == NULL)
+    return (respond_http(client, HTTP_STATUS_NOT_FOUND, NULL, NULL, 0));
+
+  client->etag = resource->etag;
+
+  if ((match = httpGetField(client->http, HTTP_FIELD_IF_NONE_MATCH)) != NULL && (!strcmp(match, "*") || strstr(match, resource->etag)))
+  {
+    // Client already has the current version...
+    ret = respond_http(client, HTTP_STATUS_NOT_MODIFIED, NULL, NULL, 0);
+  }
+  else if ((ret = respond_http(client, HTTP_STATUS_OK, NULL, type, resource->length)) != 0)
+  {
+    httpWrite(client->http, (const char *)resource->data, resource->length);
+    httpFlushWrite(client->http);
+  }
+
+  client->etag = NULL;
+
+  release_resource(resource);
+
+  return (ret);
+}
+
+
 //
 // 'respond_unsupported()' - Respond with an unsupported attribute.
 //
@@ -6199,31 +7582,96 @@ respond_unsupported(
 
 
 //
-// 'run_printer()' - Run the printer service.
+// 'run_clients()' - Run the event loop for idle clients.
+//
+// Idle connections only cost a file descriptor - they are dispatched to the
+// client thread pool when the next request arrives or closed after 30 seconds
+// of inactivity.
+//
+
+static void *				// O - Thread exit status
+run_clients(void *data)			// I - Callback data (unused)
+{
+  ippeve_client_t	*client;	// Current client
+
+
+  (void)data;
+
+  for (;;)
+  {
+    // Add any idle clients to the event loop, waiting as needed...
+    cupsMutexLock(&ClientMutex);
+
+    while (NumLoopClients == 0 && cupsArrayGetCount(ClientIdle) == 0)
+      cupsCondWait(&ClientCond, &ClientMutex, 0.0);
+
+    while ((client = (ippeve_client_t *)cupsArrayGetFirst(ClientIdle)) != NULL)
+    {
+      cupsArrayRemove(ClientIdle, client);
+
+      if (httpLoopAdd(ClientLoop, client->http, HTTP_LOOP_READ, 1000 * IPPEVE_KEEPALIVE_TIMEOUT, (http_loop_cb_t)idle_client_cb, client))
+      {
+        NumLoopClients ++;
+      }
+      else
+      {
+        fprintf(stderr, "%s Unable to wait for request: %s\n", client->hostname, cupsGetErrorString());
+        delete_client(client);
+      }
+    }
+
+    cupsMutexUnlock(&ClientMutex);
+
+    // Then wait for a request or wakeup...
+    if (httpLoopRun(ClientLoop, -1) < 0)
+    {
+      fprintf(stderr, "Unable to wait for client requests: %s\n", cupsGetErrorString());
+      sleep(1);
+    }
+  }
+
+  return (NULL);
+}
+
+
+//
+// 'run_printers()' - Run the printer services.
 //
 
 static void
-run_printer(ippeve_printer_t *printer)	// I - Printer
+run_printers(cups_array_t *printers)	// I - Printers
 {
-  int			num_fds;	// Number of file descriptors
-  struct pollfd		polldata[3];	// poll() data
+  size_t		i,		// Looping var
+			num_fds;	// Number of file descriptors
+  struct pollfd		*polldata;	// poll() data
+  ippeve_printer_t	*printer;	// Current printer
   ippeve_client_t	*client;	// New client
 
 
 #ifndef _WIN32
-  // Set signal handlers for SIGINT and SIGTERM...
+  // Set signal handlers for SIGINT and SIGTERM, and ignore SIGPIPE from
+  // commands that exit before reading all of the piped print data...
   signal(SIGINT, signal_handler);
   signal(SIGTERM, signal_handler);
+  signal(SIGPIPE, SIG_IGN);
 #endif // !_WIN32
 
-  // Setup poll() data for the DNS-SD service socket and IPv4/6 listeners...
-  polldata[0].fd     = printer->ipv4;
-  polldata[0].events = POLLIN;
+  // Setup poll() data for the IPv4/6 listeners of each printer...
+  num_fds = 2 * cupsArrayGetCount(printers);
 
-  polldata[1].fd     = printer->ipv6;
-  polldata[1].events = POLLIN;
+  if ((polldata = calloc(num_fds, sizeof(struct pollfd))) == NULL)
+  {
+    perror("Unable to allocate poll() data");
+    return;
+  }
 
-  num_fds = 2;
+  for (i = 0, printer = (ippeve_printer_t *)cupsArrayGetFirst(printers); printer; i += 2, printer = (ippeve_printer_t *)cupsArrayGetNext(printers))
+  {
+    polldata[i].fd         = printer->ipv4;
+    polldata[i].events     = POLLIN;
+    polldata[i + 1].fd     = printer->ipv6;
+    polldata[i + 1].events = POLLIN;
+  }
 
   // Loop until we are killed or have a hard error...
   for (;;)
@@ -6239,47 +7687,68 @@ run_printer(ippeve_printer_t *printer)	// I - Printer
       break;
 #endif // !_WIN32
 
-    if (polldata[0].revents & POLLIN)
+    for (i = 0; i < num_fds; i ++)
     {
-      if ((client = create_client(printer, printer->ipv4)) != NULL)
+      if (polldata[i].revents & POLLIN)
       {
-        cups_thread_t t = cupsThreadCreate((cups_thread_func_t)process_client, client);
+        // Listeners are in the same order as the printers...
+        printer = (ippeve_printer_t *)cupsArrayGetElement(printers, i / 2);
 
-        if (t)
-        {
-          cupsThreadDetach(t);
-        }
-        else
-	{
-	  perror("Unable to create client thread");
-	  delete_client(client);
-	}
+	if ((client = create_client(printer, polldata[i].fd)) != NULL)
+	  idle_client(client);
       }
     }
 
-    if (polldata[1].revents & POLLIN)
+    for (printer = (ippeve_printer_t *)cupsArrayGetFirst(printers); printer; printer = (ippeve_printer_t *)cupsArrayGetNext(printers))
     {
-      if ((client = create_client(printer, printer->ipv6)) != NULL)
-      {
-        cups_thread_t t = cupsThreadCreate((cups_thread_func_t)process_client, client);
+      if (printer->dnssd_collision)
+	register_printer(printer);
 
-        if (t)
-        {
-          cupsThreadDetach(t);
-        }
-        else
-	{
-	  perror("Unable to create client thread");
-	  delete_client(client);
-	}
-      }
+      // Clean out old jobs...
+      clean_jobs(printer);
     }
+  }
+
+  free(polldata);
+}
+
+
+//
+// 'save_cached_attributes()' - Save IPP attributes to the cache.
+//
+// The attributes are written to a temporary file that is then renamed so
+// that other printers starting from the same cache never see a partial file.
+//
+
+static void
+save_cached_attributes(
+    const char *filename,		// I - Cache filename
+    ipp_t      *attrs)			// I - IPP attributes
+{
+  int		fd;			// Cache file
+  char		tempfile[1024];		// Temporary filename
+  ipp_state_t	state;			// Write state
+
+
+  snprintf(tempfile, sizeof(tempfile), "%s.%d", filename, (int)getpid());
+
+  if ((fd = open(tempfile, O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0666)) < 0)
+  {
+    fprintf(stderr, "Unable to create attribute cache file \"%s\": %s\n", tempfile, strerror(errno));
+    return;
+  }
 
-    if (printer->dnssd_collision)
-      register_printer(printer);
+  ippSetState(attrs, IPP_STATE_IDLE);
+  state = ippWriteFile(fd, attrs);
 
-    // Clean out old jobs...
-    clean_jobs(printer);
+  if (close(fd) || state != IPP_STATE_DATA || rename(tempfile, filename))
+  {
+    fprintf(stderr, "Unable to write attribute cache file \"%s\": %s\n", filename, strerror(errno));
+    unlink(tempfile);
+  }
+  else if (Verbosity)
+  {
+    fprintf(stderr, "Saved attributes to cache file \"%s\".\n", filename);
   }
 }
 
@@ -6399,7 +7868,7 @@ show_media(ippeve_client_t  *client)	// I - Client connection
     const char	*val;			// Form value
     pwg_media_t	*media;			// Media info
 
-    cupsRWLockWrite(&printer->rwlock);
+    lock_write(&printer->rwlock, IPPEVE_LOCK_PRINTER);
 
     ippDeleteAttribute(printer->attrs, media_col_ready);
     media_col_ready = NULL;
@@ -6604,6 +8073,177 @@ show_media(ippeve_client_t  *client)	// I - Client connection
 }
 
 
+//
+// 'show_metrics()' - Show server metrics in the Prometheus text format.
+//
+
+static int				// O - 1 on success, 0 on failure
+show_metrics(ippeve_client_t *client)	// I - Client connection
+{
+  ippeve_printer_t *printer = client->printer;
+					// Printer
+  ippeve_metrics_t metrics;		// Copy of server metrics
+  int		i;			// Looping var
+  size_t	j,			// Looping var
+		count;			// Cumulative count
+  int		queued,			// Number of queued jobs
+		created;		// Number of created jobs
+  size_t	retained;		// Number of jobs in history
+  const char	*label;			// Label value
+  cups_lock_stats_t *lstats,		// libcups lock statistics
+		*lstat;			// Current lock statistics
+  size_t	num_lstats;		// Number of lock statistics
+  static const char * const families[3][3] =
+  {					// Histogram families
+    { "ippeve_request_duration_seconds", "IPP request processing time by operation.", "operation" },
+    { "ippeve_http_request_duration_seconds", "Other HTTP request processing time by method.", "method" },
+    { "ippeve_job_processing_seconds", "Job processing time.", NULL }
+  };
+
+
+  // Copy the current values so we don't hold the mutex while writing...
+  cupsMutexLock(&Metrics.mutex);
+  metrics = Metrics;
+  cupsMutexUnlock(&Metrics.mutex);
+
+  lock_read(&printer->jobs_rwlock, IPPEVE_LOCK_JOBS);
+  queued   = printer->active_job && printer->active_job->state < IPP_JSTATE_CANCELED;
+  created  = printer->next_job_id - 1;
+  retained = printer->num_jobs;
+  cupsRWUnlock(&printer->jobs_rwlock);
+
+  if (!respond_http(client, HTTP_STATUS_OK, NULL, "text/plain; version=0.0.4", 0))
+    return (0);
+
+  // Request, HTTP, and job histograms...
+  for (i = 0; i < 3; i ++)
+  {
+    ippeve_histogram_t	*h,		// Current histogram
+			*hend;		// End of histograms
+
+    metrics_printf(client, "# HELP %s %s\n# TYPE %s histogram\n", families[i][0], families[i][1], families[i][0]);
+
+    if (i == 0)
+    {
+      h    = metrics.ipp;
+      hend = metrics.ipp + IPPEVE_METRICS_OPS;
+    }
+    else if (i == 1)
+    {
+      h    = metrics.http;
+      hend = metrics.http + HTTP_STATE_MAX;
+    }
+    else
+    {
+      h    = &metrics.jobs;
+      hend = h + 1;
+    }
+
+    for (; h < hend; h ++)
+    {
+      char	labels[256],		// Label string
+		lelabels[32];		// "le" bucket value
+
+      if (!h->count && i < 2)
+        continue;
+
+      if (i == 0)
+        label = h == metrics.ipp ? "unknown" : ippOpString((ipp_op_t)(h - metrics.ipp));
+      else if (i == 1)
+        label = httpStateString((http_state_t)(h - metrics.http));
+      else
+        label = NULL;
+
+      if (label)
+        snprintf(labels, sizeof(labels), "{%s=\"%s\"}", families[i][2], label);
+      else
+        labels[0] = '\0';
+
+      for (j = 0, count = 0; j <= IPPEVE_METRICS_BUCKETS; j ++)
+      {
+        if (j < IPPEVE_METRICS_BUCKETS)
+        {
+          count += h->buckets[j];
+          snprintf(lelabels, sizeof(lelabels), "%g", ippeve_metrics_buckets[j]);
+        }
+        else
+        {
+          count = h->count;
+          cupsCopyString(lelabels, "+Inf", sizeof(lelabels));
+        }
+
+        if (label)
+          metrics_printf(client, "%s_bucket{%s=\"%s\",le=\"%s\"} %lu\n", families[i][0], families[i][2], label, lelabels, (unsigned long)count);
+        else
+          metrics_printf(client, "%s_bucket{le=\"%s\"} %lu\n", families[i][0], lelabels, (unsigned long)count);
+      }
+
+      metrics_printf(client, "%s_sum%s %.6f\n", families[i][0], labels, h->sum);
+      metrics_printf(client, "%s_count%s %lu\n", families[i][0], labels, (unsigned long)h->count);
+    }
+  }
+
+  // Connections and traffic...
+  metrics_printf(client, "# HELP ippeve_connections_active Open client connections.\n# TYPE ippeve_connections_active gauge\nippeve_connections_active %lu\n", (unsigned long)metrics.connections);
+  metrics_printf(client, "# HELP ippeve_connections_total Accepted client connections.\n# TYPE ippeve_connections_total counter\nippeve_connections_total %lu\n", (unsigned long)metrics.connections_total);
+  metrics_printf(client, "# HELP ippeve_received_bytes_total Bytes received from clients.\n# TYPE ippeve_received_bytes_total counter\nippeve_received_bytes_total %lu\n", (unsigned long)metrics.bytes_in);
+  metrics_printf(client, "# HELP ippeve_sent_bytes_total Bytes sent to clients.\n# TYPE ippeve_sent_bytes_total counter\nippeve_sent_bytes_total %lu\n", (unsigned long)metrics.bytes_out);
+
+  // Jobs...
+  metrics_printf(client, "# HELP ippeve_jobs_queued Jobs waiting for or being processed.\n# TYPE ippeve_jobs_queued gauge\nippeve_jobs_queued %d\n", queued);
+  metrics_printf(client, "# HELP ippeve_jobs_retained Jobs in the job history.\n# TYPE ippeve_jobs_retained gauge\nippeve_jobs_retained %lu\n", (unsigned long)retained);
+  metrics_printf(client, "# HELP ippeve_jobs_created_total Jobs created.\n# TYPE ippeve_jobs_created_total counter\nippeve_jobs_created_total %d\n", created);
+
+  // Transforms...
+  metrics_printf(client, "# HELP ippeve_transform_seconds_total Time reported by ipptransform.\n# TYPE ippeve_transform_seconds_total counter\nippeve_transform_seconds_total{clock=\"wall\"} %.3f\nippeve_transform_seconds_total{clock=\"cpu\"} %.3f\n", metrics.transform_wall, metrics.transform_cpu);
+
+  // Locks...
+  metrics_printf(client, "# HELP ippeve_lock_wait_seconds_total Time spent waiting for locks.\n# TYPE ippeve_lock_wait_seconds_total counter\n");
+  for (i = 0; i < IPPEVE_LOCK_MAX; i ++)
+    metrics_printf(client, "ippeve_lock_wait_seconds_total{lock=\"%s\"} %.6f\n", ippeve_lock_strings[i], metrics.lock_wait[i]);
+
+  metrics_printf(client, "# HELP ippeve_lock_acquisitions_total Lock acquisitions.\n# TYPE ippeve_lock_acquisitions_total counter\n");
+  for (i = 0; i < IPPEVE_LOCK_MAX; i ++)
+    metrics_printf(client, "ippeve_lock_acquisitions_total{lock=\"%s\"} %lu\n", ippeve_lock_strings[i], (unsigned long)metrics.lock_count[i]);
+
+  // libcups locks, when enabled with the CUPS_LOCK_STATS environment variable...
+  if ((num_lstats = cupsThreadGetLockStats(NULL, 0)) > 0 && (lstats = (cups_lock_stats_t *)calloc(num_lstats, sizeof(cups_lock_stats_t))) != NULL)
+  {
+    char	labels[256];		// Labels for lock
+
+    if ((j = cupsThreadGetLockStats(lstats, num_lstats)) < num_lstats)
+      num_lstats = j;
+
+    metrics_printf(client, "# HELP ippeve_libcups_lock_acquisitions_total libcups lock acquisitions.\n# TYPE ippeve_libcups_lock_acquisitions_total counter\n");
+    for (j = num_lstats, lstat = lstats; j > 0; j --, lstat ++)
+      metrics_printf(client, "ippeve_libcups_lock_acquisitions_total{lock=\"%s\",address=\"%p\"} %lu\n", lstat->name ? lstat->name : "unnamed", lstat->lock, (unsigned long)lstat->acquired);
+
+    metrics_printf(client, "# HELP ippeve_libcups_lock_wait_seconds Time spent waiting for contended libcups locks.\n# TYPE ippeve_libcups_lock_wait_seconds histogram\n");
+    for (j = num_lstats, lstat = lstats; j > 0; j --, lstat ++)
+    {
+      snprintf(labels, sizeof(labels), "lock=\"%s\",address=\"%p\"", lstat->name ? lstat->name : "unnamed", lstat->lock);
+
+      for (i = 0, count = 0; i < CUPS_LOCK_STATS_BUCKETS; i ++)
+      {
+        count += lstat->waits[i];
+
+        if (i < (CUPS_LOCK_STATS_BUCKETS - 1))
+          metrics_printf(client, "ippeve_libcups_lock_wait_seconds_bucket{%s,le=\"%g\"} %lu\n", labels, (1 << i) * 0.000001, (unsigned long)count);
+        else
+          metrics_printf(client, "ippeve_libcups_lock_wait_seconds_bucket{%s,le=\"+Inf\"} %lu\n", labels, (unsigned long)count);
+      }
+
+      metrics_printf(client, "ippeve_libcups_lock_wait_seconds_sum{%s} %.6f\n", labels, lstat->wait_time);
+      metrics_printf(client, "ippeve_libcups_lock_wait_seconds_count{%s} %lu\n", labels, (unsigned long)lstat->contended);
+    }
+
+    free(lstats);
+  }
+
+  return (httpWrite(client->http, "", 0) >= 0);
+}
+
+
 //
 // 'show_status()' - Show printer/system state.
 //
@@ -6614,6 +8254,7 @@ show_status(ippeve_client_t  *client)	// I - Client connection
   ippeve_printer_t *printer = client->printer;
 					// Printer
   ippeve_job_t		*job;		// Current job
+  int			id;		// Current job ID
   size_t		i;		// Looping var
   ippeve_preason_t	reason;		// Current reason
   static const char * const reasons[] =	// Reason strings
@@ -6648,22 +8289,25 @@ show_status(ippeve_client_t  *client)	// I - Client connection
 
   html_header(client, printer->name, printer->state == IPP_PSTATE_PROCESSING ? 5 : 15);
   html_printf(client, "<h1><img style=\"background: %s; border-radius: 10px; float: left; margin-right: 10px; padding: 10px;\" src=\"/icon.png\" width=\"64\" height=\"64\">%s Jobs</h1>\n", state_colors[printer->state - IPP_PSTATE_IDLE], printer->name);
-  html_printf(client, "<p>%s, %u job(s).", printer->state == IPP_PSTATE_IDLE ? "Idle" : printer->state == IPP_PSTATE_PROCESSING ? "Printing" : "Stopped", (unsigned)cupsArrayGetCount(printer->jobs));
+  html_printf(client, "<p>%s, %u job(s).", printer->state == IPP_PSTATE_IDLE ? "Idle" : printer->state == IPP_PSTATE_PROCESSING ? "Printing" : "Stopped", (unsigned)printer->num_jobs);
   for (i = 0, reason = 1; i < (sizeof(reasons) / sizeof(reasons[0])); i ++, reason <<= 1)
     if (printer->state_reasons & reason)
       html_printf(client, "\n<br>&nbsp;&nbsp;&nbsp;&nbsp;%s", reasons[i]);
   html_printf(client, "</p>\n");
 
-  if (cupsArrayGetCount(printer->jobs) > 0)
+  if (printer->num_jobs > 0)
   {
-    cupsRWLockRead(&(printer->rwlock));
+    lock_read(&(printer->jobs_rwlock), IPPEVE_LOCK_JOBS);
 
     html_printf(client, "<table class=\"striped\" summary=\"Jobs\"><thead><tr><th>Job #</th><th>Name</th><th>Owner</th><th>Status</th></tr></thead><tbody>\n");
-    for (job = (ippeve_job_t *)cupsArrayGetFirst(printer->jobs); job; job = (ippeve_job_t *)cupsArrayGetNext(printer->jobs))
+    for (id = printer->next_job_id - 1; id >= printer->first_job_id; id --)
     {
       char	when[256],		// When job queued/started/finished
 		hhmmss[64];		// Time HH:MM:SS
 
+      if ((job = get_job(printer, id)) == NULL)
+        continue;
+
       switch (job->state)
       {
 	case IPP_JSTATE_PENDING :
@@ -6689,7 +8333,7 @@ show_status(ippeve_client_t  *client)	// I - Client connection
     }
     html_printf(client, "</tbody></table>\n");
 
-    cupsRWUnlock(&(printer->rwlock));
+    cupsRWUnlock(&(printer->jobs_rwlock));
   }
 
   html_footer(client);
@@ -6791,7 +8435,7 @@ show_supplies(
     char	name[64];		// Form field
     const char	*val;			// Form value
 
-    cupsRWLockWrite(&printer->rwlock);
+    lock_write(&printer->rwlock, IPPEVE_LOCK_PRINTER);
 
     ippDeleteAttribute(printer->attrs, supply);
     supply = NULL;
@@ -6902,6 +8546,98 @@ signal_handler(int signum)		// I - Signal number (not used)
 #endif // !_WIN32
 
 
+//
+// 'stream_jobs()' - Stream the job groups of a Get-Jobs response.
+//
+// Each job is encoded and sent on its own so that only one job's attributes
+// are held in memory at a time.  The jobs lock is only held while copying
+// the attributes, and jobs that have been purged since the request was
+// processed are skipped.
+//
+
+static bool				// O - `true` on success, `false` on error
+stream_jobs(ippeve_client_t *client)	// I - Client
+{
+  bool		ret = false;		// Return value
+  size_t	i;			// Looping var
+  ippeve_job_t	*job;			// Current job
+  ipp_t		*ipp;			// Job attributes
+  void		*data;			// Encoded message
+  size_t	datalen;		// Length of encoded message
+  bool		encoded;		// Was the message encoded?
+  static const char end_tag = (char)IPP_TAG_END;
+					// End-of-attributes tag
+
+
+  // Send the message header and operation attributes without the
+  // end-of-attributes tag...
+  if (!ippWriteBuffer(client->response, &data, &datalen))
+    goto done;
+
+  if (httpWrite(client->http, data, datalen - 1) < 0)
+  {
+    free(data);
+    goto done;
+  }
+
+  free(data);
+
+  // Then send each job group...
+  for (i = 0; i < client->num_stream_ids; i ++)
+  {
+    lock_read(&(client->printer->jobs_rwlock), IPPEVE_LOCK_JOBS);
+
+    if ((job = get_job(client->printer, client->stream_ids[i])) != NULL)
+    {
+      ipp = ippNew();
+      copy_job_attributes(ipp, job, client->stream_ra);
+    }
+    else
+    {
+      ipp = NULL;
+    }
+
+    cupsRWUnlock(&(client->printer->jobs_rwlock));
+
+    if (!ipp)
+      continue;
+
+    encoded = ippWriteBuffer(ipp, &data, &datalen);
+
+    ippDelete(ipp);
+
+    if (!encoded)
+      goto done;
+
+    // Skip the 8 byte message header and the end-of-attributes tag - the
+    // job group tag at the start of the attributes separates the jobs...
+    if (datalen > 9 && httpWrite(client->http, (char *)data + 8, datalen - 9) < 0)
+    {
+      free(data);
+      goto done;
+    }
+
+    free(data);
+  }
+
+  if (httpWrite(client->http, &end_tag, 1) < 0 || httpWrite(client->http, "", 0) < 0)
+    goto done;
+
+  ret = true;
+
+  done:
+
+  free(client->stream_ids);
+  cupsArrayDelete(client->stream_ra);
+
+  client->stream_ids     = NULL;
+  client->num_stream_ids = 0;
+  client->stream_ra      = NULL;
+
+  return (ret);
+}
+
+
 //
 // 'time_string()' - Return the local time in hours, minutes, and seconds.
 //
@@ -6930,9 +8666,15 @@ usage(FILE *out)			// I - Output file
 {
   cupsLangPuts(out, _("Usage: ippeveprinter [OPTIONS] \"NAME\""));
   cupsLangPuts(out, _("Options:"));
+  cupsLangPuts(out, _("--cache-directory DIRECTORY    Cache printer attributes in the directory"));
   cupsLangPuts(out, _("--help                         Show this help"));
+  cupsLangPuts(out, _("--max-clients NUMBER           Set the maximum number of concurrent clients"));
+  cupsLangPuts(out, _("--max-jobs NUMBER              Set the maximum number of concurrent jobs"));
+  cupsLangPuts(out, _("--memory-spool                 Spool job files in memory"));
   cupsLangPuts(out, _("--no-web-forms                 Disable web forms for media and supplies"));
+  cupsLangPuts(out, _("--output-cache DIRECTORY       Cache print command output in the directory"));
   cupsLangPuts(out, _("--pam-service SERVICE          Use the named PAM service"));
+  cupsLangPuts(out, _("--printers NUMBER              Set the number of printers"));
   cupsLangPuts(out, _("--version                      Show the program version"));
   cupsLangPuts(out, _("-2                             Set 2-sided printing support (default=1-sided)"));
   cupsLangPuts(out, _("-a FILENAME                    Load printer attributes from IPP file"));
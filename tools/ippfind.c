@@ -12,6 +12,7 @@
 //
 
 #include <cups/cups-private.h>
+#include <sys/stat.h>
 #ifdef _WIN32
 #  include <process.h>
 #  include <sys/timeb.h>
@@ -102,9 +103,12 @@ typedef struct ippfind_srv_s		// Service information
   size_t	num_txt;		// Number of TXT record keys
   cups_option_t	*txt;			// TXT record keys
   int		port;			// Port number
+  time_t	resolve_time;		// Time of resolve data
   bool		is_local,		// Is a local service?
 		is_processed,		// Did we process the service?
-		is_resolved;		// Got the resolve data?
+		is_queued,		// Is the service queued for processing?
+		is_resolved,		// Got the resolve data?
+		is_true;		// Did the expressions match?
 } ippfind_srv_t;
 
 
@@ -116,23 +120,35 @@ static cups_dnssd_t *dnssd;		// DNS-SD context
 static int	address_family = AF_UNSPEC;
 					// Address family for LIST
 static bool	bonjour_error = false;	// Error browsing/resolving?
+static int	cache_time = 0;		// Maximum age of cached services in seconds
 static double	bonjour_timeout = 1.0;	// Timeout in seconds
+static ippfind_expr_t *eval_expressions = NULL;
+					// Expressions for worker threads
+static cups_mutex_t eval_mutex = CUPS_MUTEX_INITIALIZER;
+					// Mutex for processing results
 static int	ipp_version = 20;	// IPP version for LIST
+static size_t	max_jobs = 1;		// Maximum number of services to process at once
 
 
 //
 // Local functions...
 //
 
+static size_t		add_cached_services(ippfind_srvs_t *services, cups_array_t *cache, const char *name, const char *regtype, const char *domain);
 static void		browse_callback(cups_dnssd_browse_t *browse, void *context, cups_dnssd_flags_t flags, uint32_t if_index, const char *serviceName, const char *regtype, const char *replyDomain);
 static int		compare_services(ippfind_srv_t *a, ippfind_srv_t *b);
+static int		eval_browse_expr(ippfind_srv_t *service, ippfind_expr_t *expressions);
 static int		eval_expr(ippfind_srv_t *service, ippfind_expr_t *expressions);
+static void		*eval_service(ippfind_srv_t *service);
 static int		exec_program(ippfind_srv_t *service, size_t num_args, char **args);
+static void		free_service(ippfind_srv_t *service);
 static ippfind_srv_t	*get_service(ippfind_srvs_t *services, const char *serviceName, const char *regtype, const char *replyDomain) _CUPS_NONNULL(1,2,3,4);
 static double		get_time(void);
 static int		list_service(ippfind_srv_t *service);
+static cups_array_t	*load_cache(const char *filename);
 static ippfind_expr_t	*new_expr(ippfind_op_t op, bool invert, const char *value, const char *regex, char **args);
 static void		resolve_callback(cups_dnssd_resolve_t *resolve, void *context, cups_dnssd_flags_t flags, uint32_t if_index, const char *fullName, const char *hostTarget, uint16_t port, size_t num_txt, cups_option_t *txt);
+static void		save_cache(const char *filename, ippfind_srvs_t *services, cups_array_t *cache);
 static void		set_service_uri(ippfind_srv_t *service);
 static int		usage(FILE *out);
 #if _WIN32
@@ -169,6 +185,9 @@ main(int  argc,				// I - Number of command-line args
 					// Logic for next expression
   bool			invert = false;	// Invert expression?
   double		endtime;	// End time
+  cups_thread_pool_t	*pool = NULL;	// Pool for evaluating services
+  cups_array_t		*cache = NULL;	// Cached services
+  char			cachefile[1024];// Cache filename
   static const char * const ops[] =	// Node operation names
   {
     "NONE",
@@ -291,6 +310,38 @@ main(int  argc,				// I - Number of command-line args
 
           temp = new_expr(IPPFIND_OP_HOST_REGEX, invert, NULL, argv[i], NULL);
         }
+        else if (!strcmp(argv[i], "--cache-time"))
+        {
+          i ++;
+          if (i >= argc)
+          {
+            cupsLangPrintf(stderr, _("%s: Missing timeout for '%s'."), "ippfind", "--cache-time");
+            return (usage(stderr));
+          }
+
+          if ((cache_time = atoi(argv[i])) < 0)
+          {
+            cupsLangPrintf(stderr, _("%s: Invalid timeout '%s' for '%s'."), "ippfind", argv[i], "--cache-time");
+            return (usage(stderr));
+          }
+        }
+        else if (!strcmp(argv[i], "--jobs"))
+        {
+          i ++;
+          if (i >= argc)
+          {
+            cupsLangPrintf(stderr, _("%s: Missing count after '%s'."), "ippfind", "--jobs");
+            return (usage(stderr));
+          }
+
+          if (atoi(argv[i]) < 1)
+          {
+            cupsLangPrintf(stderr, _("%s: Invalid count '%s' for '%s'."), "ippfind", argv[i], "--jobs");
+            return (usage(stderr));
+          }
+
+          max_jobs = (size_t)atoi(argv[i]);
+        }
         else if (!strcmp(argv[i], "--ls"))
         {
           temp        = new_expr(IPPFIND_OP_LIST, invert, NULL, NULL, NULL);
@@ -888,6 +939,23 @@ main(int  argc,				// I - Number of command-line args
   if ((dnssd = cupsDNSSDNew(NULL, NULL)) == NULL)
     exit(IPPFIND_EXIT_BONJOUR);
 
+  // Load any cached services...
+  if (cache_time > 0)
+  {
+    _cups_globals_t *cg = _cupsGlobals();
+					// Global data
+
+    if (cg->userconfig)
+    {
+      snprintf(cachefile, sizeof(cachefile), "%s/ippfind.cache", cg->userconfig);
+      cache = load_cache(cachefile);
+    }
+    else
+    {
+      cache_time = 0;
+    }
+  }
+
   for (search = (const char *)cupsArrayGetFirst(searches); search; search = (const char *)cupsArrayGetNext(searches))
   {
     char	buf[1024],		// Full name string
@@ -941,6 +1009,13 @@ main(int  argc,				// I - Number of command-line args
       if (!domain)
         domain = "local.";
 
+      if (add_cached_services(&services, cache, name, regtype, domain))
+      {
+        if (getenv("IPPFIND_DEBUG"))
+          fprintf(stderr, "Using cached name=\"%s\", regtype=\"%s\", domain=\"%s\"\n", name, regtype, domain);
+        continue;
+      }
+
       service = get_service(&services, name, regtype, domain);
 
       if (getenv("IPPFIND_DEBUG"))
@@ -955,12 +1030,26 @@ main(int  argc,				// I - Number of command-line args
       if (getenv("IPPFIND_DEBUG"))
         fprintf(stderr, "Browsing for regtype=\"%s\", domain=\"%s\"\n", regtype, domain);
 
+      add_cached_services(&services, cache, NULL, regtype, domain);
+
       if (!cupsDNSSDBrowseNew(dnssd, CUPS_DNSSD_IF_INDEX_ANY, regtype, domain, browse_callback, &services))
 	exit(IPPFIND_EXIT_BONJOUR);
     }
   }
 
-  // Process browse/resolve requests...
+  // Process browse/resolve requests, evaluating the expressions on worker
+  // threads if requested...
+  if (max_jobs > 1)
+  {
+    if ((pool = cupsThreadPoolNew(max_jobs, 0)) == NULL)
+    {
+      cupsLangPrintf(stderr, _("%s: Out of memory."), "ippfind");
+      exit(IPPFIND_EXIT_MEMORY);
+    }
+
+    eval_expressions = expressions;
+  }
+
   if (bonjour_timeout > 1.0)
     endtime = get_time() + bonjour_timeout;
   else
@@ -980,13 +1069,25 @@ main(int  argc,				// I - Number of command-line args
     {
       service = (ippfind_srv_t *)cupsArrayGetElement(services.services, j);
 
+      cupsMutexLock(&eval_mutex);
       if (service->is_processed)
 	processed ++;
+      cupsMutexUnlock(&eval_mutex);
 
       if (service->is_resolved)
 	resolved ++;
 
-      if (!service->resolve && !service->is_resolved)
+      if (!service->resolve && !service->is_resolved && !service->is_queued && !eval_browse_expr(service, expressions))
+      {
+        // Found a service that cannot match, skip the resolve...
+        if (getenv("IPPFIND_DEBUG"))
+          fprintf(stderr, "SKIP %s\n", service->fullName);
+
+	service->is_queued    = true;
+	service->is_processed = true;
+	processed ++;
+      }
+      else if (!service->resolve && !service->is_resolved)
       {
         // Found a service, now resolve it (but limit to 50 active resolves...)
 	if (active < 50)
@@ -997,19 +1098,21 @@ main(int  argc,				// I - Number of command-line args
 	  active ++;
 	}
       }
-      else if (service->is_resolved && !service->is_processed)
+      else if (service->is_resolved && !service->is_queued)
       {
         // Resolved, not process this service against the expressions...
 	cupsDNSSDResolveDelete(service->resolve);
-	service->resolve = NULL;
+	service->resolve   = NULL;
+	service->is_queued = true;
 
         if (getenv("IPPFIND_DEBUG"))
           fprintf(stderr, "EVAL %s\n", service->uri);
 
-	if (eval_expr(service, expressions))
-	  status = IPPFIND_EXIT_TRUE;
-
-	service->is_processed = true;
+        if (!pool || !cupsThreadPoolAdd(pool, (cups_thread_func_t)eval_service, service))
+        {
+	  service->is_true      = eval_expr(service, expressions) != 0;
+	  service->is_processed = true;
+	}
       }
       else if (service->resolve)
       {
@@ -1029,6 +1132,21 @@ main(int  argc,				// I - Number of command-line args
     usleep(250000);
   }
 
+  // Wait for any running evaluations and then collect the results...
+  cupsThreadPoolDelete(pool);
+
+  cupsRWLockRead(&services.rwlock);
+  for (service = (ippfind_srv_t *)cupsArrayGetFirst(services.services); service; service = (ippfind_srv_t *)cupsArrayGetNext(services.services))
+  {
+    if (service->is_true)
+      status = IPPFIND_EXIT_TRUE;
+  }
+  cupsRWUnlock(&services.rwlock);
+
+  // Update the cache...
+  if (cache_time > 0)
+    save_cache(cachefile, &services, cache);
+
   if (bonjour_error)
     exit(IPPFIND_EXIT_BONJOUR);
   else
@@ -1036,6 +1154,56 @@ main(int  argc,				// I - Number of command-line args
 }
 
 
+//
+// 'add_cached_services()' - Add cached services matching a search.
+//
+// Cached services are added as already resolved so they can be processed
+// without waiting for a resolve.
+//
+
+static size_t				// O - Number of services added
+add_cached_services(
+    ippfind_srvs_t *services,		// I - Services array
+    cups_array_t   *cache,		// I - Cached services or `NULL`
+    const char     *name,		// I - Service instance name or `NULL` for any
+    const char     *regtype,		// I - Registration type
+    const char     *domain)		// I - Domain or `NULL` for any
+{
+  size_t	i, j,			// Looping vars
+		count,			// Number of cached services
+		added = 0;		// Number of services added
+  ippfind_srv_t	*cached,		// Cached service
+		*service;		// Service
+
+
+  for (i = 0, count = cupsArrayGetCount(cache); i < count; i ++)
+  {
+    cached = (ippfind_srv_t *)cupsArrayGetElement(cache, i);
+
+    if ((name && _cups_strcasecmp(cached->name, name)) || strcmp(cached->regtype, regtype) || (domain && _cups_strcasecmp(cached->domain, domain)))
+      continue;
+
+    if ((service = get_service(services, cached->name, cached->regtype, cached->domain)) == NULL || service->is_resolved || service->resolve)
+      continue;
+
+    service->host         = strdup(cached->host);
+    service->port         = cached->port;
+    service->resolve_time = cached->resolve_time;
+    service->is_local     = cached->is_local;
+
+    for (j = 0; j < cached->num_txt; j ++)
+      service->num_txt = cupsAddOption(cached->txt[j].name, cached->txt[j].value, service->num_txt, &service->txt);
+
+    set_service_uri(service);
+
+    service->is_resolved = true;
+    added ++;
+  }
+
+  return (added);
+}
+
+
 //
 // 'browse_callback()' - Browse devices.
 //
@@ -1081,6 +1249,95 @@ compare_services(ippfind_srv_t *a,	// I - First device
 }
 
 
+//
+// 'eval_browse_expr()' - Evaluate the expressions using only the browse data.
+//
+// Returns 1 for true, 0 for false, and -1 if the result depends on resolve
+// data or an output operation.  Results are only reported when no output
+// operation would have been run first, so a service that evaluates to 0
+// can be skipped without resolving it.
+//
+
+static int				// O - Result of evaluation
+eval_browse_expr(
+    ippfind_srv_t  *service,		// I - Service
+    ippfind_expr_t *expressions)	// I - Expressions
+{
+  ippfind_op_t		logic;		// Logical operation
+  int			result;		// Result of current expression
+  bool			unknown = false;// Did we see an unknown result?
+  ippfind_expr_t	*expression;	// Current expression
+
+
+  // Loop through the expressions...
+  if (expressions && expressions->parent)
+    logic = expressions->parent->op;
+  else
+    logic = IPPFIND_OP_AND;
+
+  for (expression = expressions; expression; expression = expression->next)
+  {
+    switch (expression->op)
+    {
+      case IPPFIND_OP_AND :
+      case IPPFIND_OP_OR :
+          if (expression->child)
+            result = eval_browse_expr(service, expression->child);
+          else
+            result = expression->op == IPPFIND_OP_AND;
+          break;
+      case IPPFIND_OP_TRUE :
+          result = 1;
+          break;
+      case IPPFIND_OP_FALSE :
+          result = 0;
+          break;
+      case IPPFIND_OP_IS_LOCAL :
+          result = service->is_local;
+          break;
+      case IPPFIND_OP_IS_REMOTE :
+          result = !service->is_local;
+          break;
+      case IPPFIND_OP_DOMAIN_REGEX :
+          result = !regexec(&(expression->re), service->domain, 0, NULL, 0);
+          break;
+      case IPPFIND_OP_NAME_REGEX :
+          result = !regexec(&(expression->re), service->name, 0, NULL, 0);
+          break;
+      case IPPFIND_OP_NAME_LITERAL :
+          result = !_cups_strcasecmp(expression->name, service->name);
+          break;
+      default :
+          // Everything else needs the resolve data or produces output...
+          result = -1;
+          break;
+    }
+
+    if (result < 0)
+    {
+      unknown = true;
+      continue;
+    }
+
+    if (expression->invert)
+      result = !result;
+
+    if (unknown)
+      continue;
+
+    if (logic == IPPFIND_OP_AND && !result)
+      return (0);
+    else if (logic == IPPFIND_OP_OR && result)
+      return (1);
+  }
+
+  if (unknown)
+    return (-1);
+  else
+    return (logic == IPPFIND_OP_AND);
+}
+
+
 //
 // 'eval_expr()' - Evaluate the expressions against the specified service.
 //
@@ -1192,6 +1449,26 @@ eval_expr(ippfind_srv_t  *service,	// I - Service
 }
 
 
+//
+// 'eval_service()' - Evaluate the expressions for a service on a worker thread.
+//
+
+static void *				// O - Thread exit status
+eval_service(ippfind_srv_t *service)	// I - Service
+{
+  bool	result = eval_expr(service, eval_expressions) != 0;
+					// Result of evaluation
+
+
+  cupsMutexLock(&eval_mutex);
+  service->is_true      = result;
+  service->is_processed = true;
+  cupsMutexUnlock(&eval_mutex);
+
+  return (NULL);
+}
+
+
 //
 // 'exec_program()' - Execute a program for a service.
 //
@@ -1447,6 +1724,25 @@ exec_program(ippfind_srv_t *service,	// I - Service
 }
 
 
+//
+// 'free_service()' - Free the memory used by a service.
+//
+
+static void
+free_service(ippfind_srv_t *service)	// I - Service
+{
+  free(service->name);
+  free(service->domain);
+  free(service->regtype);
+  free(service->fullName);
+  free(service->host);
+  free(service->resource);
+  free(service->uri);
+  cupsFreeOptions(service->num_txt, service->txt);
+  free(service);
+}
+
+
 //
 // 'get_service()' - Create or update a device.
 //
@@ -1706,6 +2002,83 @@ list_service(ippfind_srv_t *service)	// I - Service
 }
 
 
+//
+// 'load_cache()' - Load cached services.
+//
+// Only services that were resolved less than `cache_time` seconds ago are
+// loaded.
+//
+
+static cups_array_t *			// O - Cached services or `NULL` if none
+load_cache(const char *filename)	// I - Cache filename
+{
+  cups_array_t	*cache;			// Cached services
+  cups_file_t	*fp;			// Cache file
+  char		line[2048],		// Line from file
+		*fields[7],		// Fields in line
+		*ptr;			// Pointer into line
+  size_t	num_fields;		// Number of fields
+  ippfind_srv_t	*service = NULL;	// Current service
+  time_t	oldest = time(NULL) - cache_time;
+					// Oldest resolve time to use
+
+
+  if ((fp = cupsFileOpen(filename, "r")) == NULL)
+    return (NULL);
+
+  cache = cupsArrayNew(NULL, NULL, NULL, 0, NULL, (cups_afree_cb_t)free_service);
+
+  while (cupsFileGets(fp, line, sizeof(line)))
+  {
+    if (line[0] == '\t')
+    {
+      // "<TAB>key=value" adds a TXT key/value pair to the current service...
+      if (service && (ptr = strchr(line + 1, '=')) != NULL)
+      {
+        *ptr++ = '\0';
+        service->num_txt = cupsAddOption(line + 1, ptr, service->num_txt, &service->txt);
+      }
+      continue;
+    }
+
+    service = NULL;
+
+    if (line[0] == '#')
+      continue;
+
+    // "time<TAB>local<TAB>port<TAB>name<TAB>regtype<TAB>domain<TAB>host"
+    for (num_fields = 0, ptr = line; ptr && num_fields < 7; num_fields ++)
+    {
+      fields[num_fields] = ptr;
+
+      if ((ptr = strchr(ptr, '\t')) != NULL)
+        *ptr++ = '\0';
+    }
+
+    if (num_fields < 7 || (time_t)strtol(fields[0], NULL, 10) < oldest)
+      continue;
+
+    if ((service = calloc(1, sizeof(ippfind_srv_t))) == NULL)
+      break;
+
+    service->resolve_time = (time_t)strtol(fields[0], NULL, 10);
+    service->is_local     = atoi(fields[1]) != 0;
+    service->port         = atoi(fields[2]);
+    service->name         = strdup(fields[3]);
+    service->regtype      = strdup(fields[4]);
+    service->domain       = strdup(fields[5]);
+    service->host         = strdup(fields[6]);
+    service->is_resolved  = true;
+
+    cupsArrayAdd(cache, service);
+  }
+
+  cupsFileClose(fp);
+
+  return (cache);
+}
+
+
 //
 // 'new_expr()' - Create a new expression.
 //
@@ -1823,9 +2196,9 @@ resolve_callback(
     return;
   }
 
-  service->is_resolved = true;
-  service->host        = strdup(hostTarget);
-  service->port        = port;
+  service->host         = strdup(hostTarget);
+  service->port         = port;
+  service->resolve_time = time(NULL);
 
   value = service->host + strlen(service->host) - 1;
   if (value >= service->host && *value == '.')
@@ -1836,6 +2209,89 @@ resolve_callback(
     service->num_txt = cupsAddOption(txt[i].name, txt[i].value, service->num_txt, &service->txt);
 
   set_service_uri(service);
+
+  // Mark the service as resolved once all of the data is set...
+  service->is_resolved = true;
+}
+
+
+//
+// 'save_cache()' - Save resolved services to the cache.
+//
+// Services resolved by this run replace any cached copies, while cached
+// services that were not seen this time keep their original resolve time.
+//
+
+static void
+save_cache(const char     *filename,	// I - Cache filename
+           ippfind_srvs_t *services,	// I - Services array
+           cups_array_t   *cache)	// I - Cached services
+{
+  _cups_globals_t *cg = _cupsGlobals();	// Global data
+  cups_file_t	*fp;			// Cache file
+  char		tempfile[1024];		// Temporary cache file
+  cups_array_t	*array;			// Current array
+  ippfind_srv_t	*service,		// Current service
+		*temp;			// Resolved service
+  size_t	i, j,			// Looping vars
+		count,			// Number of services
+		scount,			// Number of resolved services
+		pass;			// Current pass
+
+
+  if (mkdir(cg->userconfig, 0700) && errno != EEXIST)
+    return;
+
+  snprintf(tempfile, sizeof(tempfile), "%s.%d", filename, (int)getpid());
+  if ((fp = cupsFileOpen(tempfile, "w")) == NULL)
+    return;
+
+  cupsFilePuts(fp, "# ippfind cache\n");
+
+  cupsRWLockRead(&services->rwlock);
+
+  for (pass = 0; pass < 2; pass ++)
+  {
+    array = pass ? cache : services->services;
+
+    for (i = 0, count = cupsArrayGetCount(array); i < count; i ++)
+    {
+      service = (ippfind_srv_t *)cupsArrayGetElement(array, i);
+
+      if (!service->is_resolved || !service->host || strpbrk(service->name, "\t\n") || strpbrk(service->regtype, "\t\n") || strpbrk(service->domain, "\t\n") || strpbrk(service->host, "\t\n"))
+        continue;
+
+      if (pass)
+      {
+        // Skip cached services that have been replaced...
+        for (j = 0, scount = cupsArrayGetCount(services->services); j < scount; j ++)
+        {
+          temp = (ippfind_srv_t *)cupsArrayGetElement(services->services, j);
+
+          if (temp->is_resolved && !_cups_strcasecmp(temp->name, service->name) && !strcmp(temp->regtype, service->regtype) && !_cups_strcasecmp(temp->domain, service->domain))
+            break;
+        }
+
+        if (j < scount)
+          continue;
+      }
+
+      // "time<TAB>local<TAB>port<TAB>name<TAB>regtype<TAB>domain<TAB>host"
+      // followed by "<TAB>key=value" lines for the TXT record...
+      cupsFilePrintf(fp, "%ld\t%d\t%d\t%s\t%s\t%s\t%s\n", (long)service->resolve_time, service->is_local ? 1 : 0, service->port, service->name, service->regtype, service->domain, service->host);
+
+      for (j = 0; j < service->num_txt; j ++)
+      {
+        if (!strpbrk(service->txt[j].name, "\t\n=") && !strpbrk(service->txt[j].value, "\t\n"))
+          cupsFilePrintf(fp, "\t%s=%s\n", service->txt[j].name, service->txt[j].value);
+      }
+    }
+  }
+
+  cupsRWUnlock(&services->rwlock);
+
+  if (!cupsFileClose(fp) || rename(tempfile, filename))
+    unlink(tempfile);
 }
 
 
@@ -1911,6 +2367,8 @@ usage(FILE *out)			// I - Output file
   cupsLangPuts(out, _("Options:"));
   cupsLangPuts(out, _("--help                         Show this help"));
   cupsLangPuts(out, _("--version                      Show the program version"));
+  cupsLangPuts(out, _("--cache-time SECONDS           Use services resolved in the last SECONDS"));
+  cupsLangPuts(out, _("--jobs COUNT                   Process up to COUNT services at the same time"));
   cupsLangPuts(out, _("-4                             Connect using IPv4"));
   cupsLangPuts(out, _("-6                             Connect using IPv6"));
   cupsLangPuts(out, _("-T SECONDS                     Set the timeout in seconds"));
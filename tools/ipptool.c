@@ -35,6 +35,7 @@
 #define MAX_EXPECT	1000		// Maximum number of EXPECT directives
 #define MAX_DISPLAY	200		// Maximum number of DISPLAY directives
 #define MAX_MONITOR	10		// Maximum number of MONITOR-PRINTER-STATE EXPECT directives
+#define MONITOR_LEASE	300		// MONITOR-PRINTER-STATE subscription lease in seconds
 
 
 //
@@ -101,6 +102,7 @@ typedef struct ipptool_expect_s		// Expected attribute info
 		repeat_no_match,	// Repeat test on no match
 		with_distinct;		// WITH-DISTINCT-VALUES?
   int		with_flags;		// WITH flags
+  regex_t	*with_regex;		// Compiled WITH-VALUE regular expression
   size_t	count;			// Expected count if > 0
   ipp_tag_t	in_group;		// IN-GROUP value
 } ipptool_expect_t;
@@ -132,6 +134,15 @@ typedef struct ipptool_status_s		// Status info
 		repeat_no_match;	// Repeat the test when it matches
 } ipptool_status_t;
 
+typedef struct ipptool_stat_s		// Operation latency statistics
+{
+  ipp_op_t	op;			// Operation code
+  size_t	count,			// Number of requests
+		errors,			// Number of failed requests
+		alloc_latencies;	// Allocated latencies
+  double	*latencies;		// Request latencies in seconds
+} ipptool_stat_t;
+
 typedef struct ipptool_test_s		// Test Data
 {
   // Global Options
@@ -154,7 +165,9 @@ typedef struct ipptool_test_s		// Test Data
 
   // Global State
   http_t	*http;			// HTTP connection to printer/server
-  cups_file_t	*outfile;		// Output file
+  cups_file_t	*outfile,		// Output file
+		*stdfile;		// Standard output or buffer for it
+  cups_array_t	*stats;			// Operation latency statistics, if any
   bool		show_header,		// Show the test header?
 		xml_header,		// `true` if XML plist header was written
 		pass;			// Have we passed all tests?
@@ -168,7 +181,7 @@ typedef struct ipptool_test_s		// Test Data
   cups_array_t	*errors;		// Errors array
   bool		prev_pass,		// Result of previous test
 		skip_previous;		// Skip on previous test failure?
-  char		compression[16];	// COMPRESSION value
+  char		compression[32];	// COMPRESSION value
   useconds_t	delay;                  // Initial delay
   size_t	num_displayed;		// Number of displayed attributes
   char		*displayed[MAX_DISPLAY];// Displayed attributes
@@ -204,6 +217,26 @@ typedef struct ipptool_test_s		// Test Data
   char		buffer[1024*1024];	// Output buffer
 } ipptool_test_t;
 
+typedef struct ipptool_target_s		// Parallel test target
+{
+  ipptool_test_t *data;			// Template test data
+  char		*uri,			// Printer URI
+		*testfile;		// Test file
+  http_encryption_t encryption;		// Encryption for connection
+  char		outname[1024],		// Output filename, if any
+		tempname[1024];		// Standard output buffer filename
+  bool		pass;			// Did all tests pass?
+  int		test_count,		// Number of tests (total)
+		pass_count,		// Number of tests that passed
+		fail_count,		// Number of tests that failed
+		skip_count;		// Number of tests that were skipped
+  cups_mutex_t	mutex;			// Mutex for load state
+  size_t	load_count,		// Number of runs for load tests
+		load_runs;		// Number of runs started
+  double	load_end;		// End time for load tests
+  cups_array_t	*stats;			// Merged latency statistics
+} ipptool_target_t;
+
 
 //
 // Globals...
@@ -216,10 +249,15 @@ static bool	Cancel = false;		// Cancel test?
 // Local functions...
 //
 
+static void	add_stat(cups_array_t *stats, ipp_op_t op, double latency, bool error);
 static void	add_stringf(cups_array_t *a, const char *s, ...) _CUPS_FORMAT(2, 3);
 static ipptool_test_t *alloc_data(void);
+static ipptool_test_t *alloc_target_data(ipptool_target_t *target);
 static void	clear_data(ipptool_test_t *data);
+static int	compare_latencies(const double *a, const double *b);
+static int	compare_stats(ipptool_stat_t *a, ipptool_stat_t *b, void *cb_data);
 static int	compare_uris(const char *a, const char *b);
+static bool	compile_with_regex(ipptool_test_t *data, ipptool_expect_t *expect);
 static http_t	*connect_printer(ipptool_test_t *data);
 static void	copy_hex_string(char *buffer, unsigned char *data, int datalen, size_t bufsize);
 static int	create_file(const char *filespec, const char *resource, size_t idx, char *filename, size_t filenamesize);
@@ -229,10 +267,19 @@ static bool	do_tests(const char *testfile, ipptool_test_t *data);
 static bool	error_cb(ipp_file_t *f, ipptool_test_t *data, const char *error);
 static bool	expect_matches(ipptool_expect_t *expect, ipp_attribute_t *attr);
 static void	free_data(ipptool_test_t *data);
+static void	free_stat(ipptool_stat_t *stat, void *cb_data);
 static http_status_t generate_file(http_t *http, ipptool_generate_t *params);
 static char	*get_filename(const char *testfile, char *dst, const char *src, size_t dstsize);
+static char	*get_real(double number, char *buffer, size_t bufsize);
 static const char *get_string(ipp_attribute_t *attr, size_t element, int flags, char *buffer, size_t bufsize);
-static char	*iso_date(const ipp_uchar_t *date);
+static double	get_time(void);
+static char	*iso_date(const ipp_uchar_t *date, char *buffer, size_t bufsize);
+static unsigned	monitor_hash(ipp_t *response, char *buffer, size_t bufsize);
+static void	monitor_sleep(ipptool_test_t *data, useconds_t usecs);
+static int	monitor_subscribe(ipptool_test_t *data, http_t *http, const char *resource, time_t *expire);
+static bool	monitor_timeout_cb(http_t *http, ipptool_test_t *data);
+static void	monitor_unsubscribe(ipptool_test_t *data, http_t *http, const char *resource, int sub_id);
+static bool	monitor_wait(ipptool_test_t *data, http_t *http, const char *resource, int sub_id, int *sequence, time_t *expire);
 static bool	parse_generate_file(ipp_file_t *f, ipptool_test_t *data);
 static bool	parse_monitor_printer_state(ipp_file_t *f, ipptool_test_t *data);
 static const char *password_cb(const char *prompt, http_t *http, const char *method, const char *resource, void *user_data);
@@ -245,9 +292,14 @@ static void	print_ippserver_string(ipptool_test_t *data, const char *s, size_t l
 static void	print_json_attr(ipptool_test_t *data, ipp_attribute_t *attr, int indent);
 static void	print_json_string(ipptool_test_t *data, const char *s, size_t len);
 static ipp_attribute_t *print_line(ipptool_test_t *data, ipp_t *ipp, ipp_attribute_t *attr, int num_displayed, char **displayed, size_t *widths);
+static void	print_load_report(ipptool_test_t *data, ipptool_target_t *target, size_t jobs, double elapsed);
 static void	print_xml_header(ipptool_test_t *data);
 static void	print_xml_string(cups_file_t *outfile, const char *element, const char *s);
 static void	print_xml_trailer(ipptool_test_t *data, int success, const char *message);
+static void	*run_load(ipptool_target_t *target);
+static bool	run_loads(ipptool_test_t *data, cups_array_t *targets, size_t jobs, size_t load_count, double load_time);
+static void	*run_target(ipptool_target_t *target);
+static bool	run_targets(ipptool_test_t *data, cups_array_t *targets, size_t jobs);
 #ifndef _WIN32
 static void	sigterm_handler(int sig);
 #endif // _WIN32
@@ -258,7 +310,7 @@ static bool	valid_image(const char *filename, int *width, int *height, int *dept
 static bool	with_content(cups_array_t *errors, ipp_attribute_t *attr, ipptool_content_t content, cups_array_t *mime_types, const char *filespec);
 static bool	with_distinct_values(cups_array_t *errors, ipp_attribute_t *attr);
 static const char *with_flags_string(int flags);
-static bool	with_value(ipptool_test_t *data, cups_array_t *errors, char *value, int flags, ipp_attribute_t *attr, char *matchbuf, size_t matchlen);
+static bool	with_value(ipptool_test_t *data, cups_array_t *errors, char *value, int flags, const regex_t *re, ipp_attribute_t *attr, char *matchbuf, size_t matchlen);
 static bool	with_value_from(cups_array_t *errors, ipp_attribute_t *fromattr, ipp_attribute_t *attr, char *matchbuf, size_t matchlen);
 
 
@@ -279,9 +331,16 @@ main(int  argc,				// I - Number of command-line args
 			testname[1024];	// Real test filename
   const char		*base,		// Base filename
 			*ext,		// Extension on filename
-			*testfile;	// Test file to use
+			*testfile,	// Test file to use
+			*joburi = NULL,	// Printer URI for parallel tests
+			*outname = NULL;// Output filename, if any
   int			interval,	// Test interval in microseconds
 			repeat;		// Repeat count
+  long			jobs = 1,	// Number of parallel tests
+			load_count = 0;	// Number of runs for load tests
+  double		load_time = 0.0;// Number of seconds for load tests
+  cups_array_t		*targets = NULL;// Parallel test targets
+  ipptool_target_t	*target;	// Current target
   ipptool_test_t	*data;		// Test data
   _cups_globals_t	*cg = _cupsGlobals();
 					// Global data
@@ -340,8 +399,85 @@ main(int  argc,				// I - Number of command-line args
 	return (1);
       }
 
+      outname      = argv[i];
       data->output = IPPTOOL_OUTPUT_IPPFILE;
     }
+    else if (!strcmp(argv[i], "--load-count") || !strcmp(argv[i], "--load-time"))
+    {
+      i ++;
+
+      if (i >= argc)
+      {
+	if (!strcmp(argv[i - 1], "--load-count"))
+	  cupsLangPrintf(stderr, _("%s: Missing count after '%s'."), "ipptool", argv[i - 1]);
+	else
+	  cupsLangPrintf(stderr, _("%s: Missing seconds after '%s'."), "ipptool", argv[i - 1]);
+	free_data(data);
+	return (usage(stderr));
+      }
+
+      if (!strcmp(argv[i - 1], "--load-count"))
+      {
+        if ((load_count = strtol(argv[i], NULL, 10)) < 1)
+        {
+	  cupsLangPrintf(stderr, _("%s: Invalid count '%s' for '%s'."), "ipptool", argv[i], argv[i - 1]);
+	  free_data(data);
+	  return (usage(stderr));
+        }
+      }
+      else if ((load_time = _cupsStrScand(argv[i], NULL, localeconv())) <= 0.0)
+      {
+	cupsLangPrintf(stderr, _("%s: Invalid seconds \"%s\" for '%s'."), "ipptool", argv[i], argv[i - 1]);
+	free_data(data);
+	return (usage(stderr));
+      }
+
+      if (ippFileGetVar(data->parent, "uri"))
+      {
+	cupsLangPrintf(stderr, _("%s: '%s' must come before the printer URI."), "ipptool", argv[i - 1]);
+	free_data(data);
+	return (usage(stderr));
+      }
+
+      if (interval || repeat)
+      {
+	cupsLangPrintf(stderr, _("%s: '-i' and '-n' are incompatible with '--load-count' and '--load-time'."), "ipptool");
+	free_data(data);
+	return (usage(stderr));
+      }
+    }
+    else if (!strcmp(argv[i], "--jobs"))
+    {
+      i ++;
+
+      if (i >= argc)
+      {
+	cupsLangPrintf(stderr, _("%s: Missing count after '%s'."), "ipptool", "--jobs");
+	free_data(data);
+	return (usage(stderr));
+      }
+
+      if ((jobs = strtol(argv[i], NULL, 10)) < 1)
+      {
+	cupsLangPrintf(stderr, _("%s: Invalid count '%s' for '%s'."), "ipptool", argv[i], "--jobs");
+	free_data(data);
+	return (usage(stderr));
+      }
+
+      if (ippFileGetVar(data->parent, "uri"))
+      {
+	cupsLangPrintf(stderr, _("%s: '%s' must come before the printer URI."), "ipptool", "--jobs");
+	free_data(data);
+	return (usage(stderr));
+      }
+
+      if (interval || repeat)
+      {
+	cupsLangPrintf(stderr, _("%s: '-i' and '-n' are incompatible with '--jobs'."), "ipptool");
+	free_data(data);
+	return (usage(stderr));
+      }
+    }
     else if (!strcmp(argv[i], "--stop-after-include-error"))
     {
       data->stop_after_include_error = true;
@@ -510,6 +646,18 @@ main(int  argc,				// I - Number of command-line args
 	        cupsLangPrintf(stderr, _("%s: '-i' and '-n' are incompatible with '--ippfile', '-P', and '-X'."), "ipptool");
 		return (usage(stderr));
 	      }
+
+              if (jobs > 1)
+	      {
+	        cupsLangPrintf(stderr, _("%s: '-i' and '-n' are incompatible with '--jobs'."), "ipptool");
+		return (usage(stderr));
+	      }
+
+              if (load_count || load_time > 0.0)
+	      {
+	        cupsLangPrintf(stderr, _("%s: '-i' and '-n' are incompatible with '--load-count' and '--load-time'."), "ipptool");
+		return (usage(stderr));
+	      }
 	      break;
 
           case 'I' : // Ignore errors
@@ -546,6 +694,18 @@ main(int  argc,				// I - Number of command-line args
 	        cupsLangPrintf(stderr, _("%s: '-i' and '-n' are incompatible with '--ippfile', '-P', and '-X'."), "ipptool");
 		return (usage(stderr));
 	      }
+
+              if (jobs > 1)
+	      {
+	        cupsLangPrintf(stderr, _("%s: '-i' and '-n' are incompatible with '--jobs'."), "ipptool");
+		return (usage(stderr));
+	      }
+
+              if (load_count || load_time > 0.0)
+	      {
+	        cupsLangPrintf(stderr, _("%s: '-i' and '-n' are incompatible with '--load-count' and '--load-time'."), "ipptool");
+		return (usage(stderr));
+	      }
 	      break;
 
           case 'P' : // Output to plist file
@@ -566,6 +726,7 @@ main(int  argc,				// I - Number of command-line args
                 exit(1);
               }
 
+	      outname      = argv[i];
 	      data->output = IPPTOOL_OUTPUT_PLIST;
 
               if (interval || repeat)
@@ -663,6 +824,26 @@ main(int  argc,				// I - Number of command-line args
     else if (!strncmp(argv[i], "ipp://", 6) || !strncmp(argv[i], "http://", 7) || !strncmp(argv[i], "ipps://", 7) || !strncmp(argv[i], "https://", 8))
     {
       // Set URI...
+      if (jobs > 1 || load_count || load_time > 0.0)
+      {
+        // Validate the URI and save it for the following test files...
+        char		scheme[32],	// URI scheme
+			userpass[256],	// URI username:password
+			hostname[256],	// URI hostname
+			resource[256];	// URI resource path
+        int		port;		// URI port number
+
+	if (!strstr(argv[i], "._tcp") && httpSeparateURI(HTTP_URI_CODING_ALL, argv[i], scheme, sizeof(scheme), userpass, sizeof(userpass), hostname, sizeof(hostname), &port, resource, sizeof(resource)) < HTTP_URI_STATUS_OK)
+	{
+	  cupsLangPrintf(stderr, _("ipptool: Bad URI '%s'."), argv[i]);
+	  free_data(data);
+	  return (1);
+	}
+
+        joburi = argv[i];
+        continue;
+      }
+
       if (ippFileGetVar(data->parent, "uri"))
       {
         cupsLangPuts(stderr, _("ipptool: May only specify a single URI."));
@@ -686,7 +867,7 @@ main(int  argc,				// I - Number of command-line args
     else
     {
       // Run test...
-      if (!ippFileGetVar(data->parent, "uri"))
+      if (!joburi && !ippFileGetVar(data->parent, "uri"))
       {
         cupsLangPuts(stderr, _("ipptool: URI required before test file."));
         cupsLangPuts(stderr, argv[i]);
@@ -716,24 +897,91 @@ main(int  argc,				// I - Number of command-line args
         cupsLangPrintf(stderr, _("%s: Unable to open '%s': %s"), "ipptool", testfile, strerror(errno));
         status = 1;
       }
+      else if (jobs > 1 || load_count || load_time > 0.0)
+      {
+        // Save the URI and test file for later...
+        if (!targets)
+          targets = cupsArrayNew(NULL, NULL, NULL, 0, NULL, NULL);
+
+        if ((target = (ipptool_target_t *)calloc(1, sizeof(ipptool_target_t))) == NULL)
+        {
+	  cupsLangPrintf(stderr, _("%s: Out of memory."), "ipptool");
+	  return (1);
+        }
+
+        target->data       = data;
+        target->uri        = strdup(joburi);
+        target->testfile   = strdup(testfile);
+        target->encryption = (!strncmp(joburi, "ipps://", 7) || !strncmp(joburi, "https://", 8)) ? HTTP_ENCRYPTION_ALWAYS : data->encryption;
+
+        if (!target->uri || !target->testfile || !cupsArrayAdd(targets, target))
+        {
+	  cupsLangPrintf(stderr, _("%s: Out of memory."), "ipptool");
+	  return (1);
+        }
+      }
       else if (!do_tests(testfile, data))
         status = 1;
     }
   }
 
-  if (!ippFileGetVar(data->parent, "uri") || !testfile)
+  if ((!ippFileGetVar(data->parent, "uri") && !targets) || !testfile)
   {
     free_data(data);
     return (usage(stderr));
   }
 
-  // Loop if the interval is set...
-  if (data->output == IPPTOOL_OUTPUT_PLIST)
+  if (targets && (load_count || load_time > 0.0))
+  {
+    // Run the test files as load tests...
+    if (data->output == IPPTOOL_OUTPUT_IPPFILE)
+    {
+      cupsLangPrintf(stderr, _("%s: '--ippfile' is incompatible with '--load-count' and '--load-time'."), "ipptool");
+      free_data(data);
+      return (usage(stderr));
+    }
+
+    if (!run_loads(data, targets, (size_t)jobs, (size_t)load_count, load_time))
+      status = 1;
+  }
+  else if (targets)
+  {
+    // Run the test files in parallel...
+    size_t	count;			// Target number
+
+    if (data->output == IPPTOOL_OUTPUT_PLIST && !outname)
+    {
+      cupsLangPrintf(stderr, _("%s: '%s' is incompatible with '%s'."), "ipptool", "-X", "--jobs");
+      free_data(data);
+      return (usage(stderr));
+    }
+
+    if (outname)
+    {
+      // Each target gets its own "NAME-N.EXT" output file...
+      cupsFileClose(data->outfile);
+      unlink(outname);
+      data->outfile = cupsFileStdout();
+
+      if ((base = strrchr(outname, '/')) == NULL)
+        base = outname;
+      if ((ext = strrchr(base, '.')) == NULL)
+        ext = base + strlen(base);
+
+      for (target = (ipptool_target_t *)cupsArrayGetFirst(targets), count = 1; target; target = (ipptool_target_t *)cupsArrayGetNext(targets), count ++)
+        snprintf(target->outname, sizeof(target->outname), "%.*s-%u%s", (int)(ext - outname), outname, (unsigned)count, ext);
+    }
+
+    if (!run_targets(data, targets, (size_t)jobs))
+      status = 1;
+  }
+  else if (data->output == IPPTOOL_OUTPUT_PLIST)
   {
     print_xml_trailer(data, !status, NULL);
   }
   else if (interval > 0 && repeat > 0)
   {
+    // Loop if the interval is set...
     while (repeat > 1)
     {
       usleep((useconds_t)interval);
@@ -750,6 +998,15 @@ main(int  argc,				// I - Number of command-line args
     }
   }
 
+  for (target = (ipptool_target_t *)cupsArrayGetFirst(targets); target; target = (ipptool_target_t *)cupsArrayGetNext(targets))
+  {
+    free(target->uri);
+    free(target->testfile);
+    free(target);
+  }
+
+  cupsArrayDelete(targets);
+
   if ((data->output == IPPTOOL_OUTPUT_TEST || (data->output == IPPTOOL_OUTPUT_PLIST && data->outfile)) && data->test_count > 1)
   {
     // Show a summary report if there were multiple tests...
@@ -764,6 +1021,55 @@ main(int  argc,				// I - Number of command-line args
 }
 
 
+//
+// 'add_stat()' - Add a request latency to the operation statistics.
+//
+
+static void
+add_stat(cups_array_t *stats,		// I - Operation statistics
+         ipp_op_t     op,		// I - Operation code
+         double       latency,		// I - Request latency in seconds
+         bool         error)		// I - Did the request fail?
+{
+  ipptool_stat_t	key,		// Search key
+			*stat;		// Operation statistics
+
+
+  // Find or add the statistics for this operation...
+  key.op = op;
+
+  if ((stat = (ipptool_stat_t *)cupsArrayFind(stats, &key)) == NULL)
+  {
+    if ((stat = (ipptool_stat_t *)calloc(1, sizeof(ipptool_stat_t))) == NULL)
+      return;
+
+    stat->op = op;
+
+    cupsArrayAdd(stats, stat);
+  }
+
+  // Expand the latencies array as needed...
+  if (stat->count >= stat->alloc_latencies)
+  {
+    size_t	alloc_latencies = stat->alloc_latencies ? 2 * stat->alloc_latencies : 1024;
+					// New allocation size
+    double	*latencies;		// New latencies array
+
+    if ((latencies = (double *)realloc(stat->latencies, alloc_latencies * sizeof(double))) == NULL)
+      return;
+
+    stat->latencies       = latencies;
+    stat->alloc_latencies = alloc_latencies;
+  }
+
+  // Save the latency...
+  stat->latencies[stat->count ++] = latency;
+
+  if (error)
+    stat->errors ++;
+}
+
+
 //
 // 'add_stringf()' - Add a formatted string to an array.
 //
@@ -799,6 +1105,7 @@ static ipptool_test_t *		// O - Test data
 alloc_data(void)
 {
   ipptool_test_t *data;		// Test data
+  char		datestr[32];		// ISO 8601 date/time string
 
 
   if ((data = calloc(1, sizeof(ipptool_test_t))) == NULL)
@@ -810,6 +1117,7 @@ alloc_data(void)
   data->parent       = ippFileNew(/*parent*/NULL, /*attr_cb*/NULL, (ipp_ferror_cb_t)error_cb, data);
   data->output       = IPPTOOL_OUTPUT_LIST;
   data->outfile      = cupsFileStdout();
+  data->stdfile      = cupsFileStdout();
   data->family       = AF_UNSPEC;
   data->def_transfer = IPPTOOL_TRANSFER_AUTO;
   data->def_version  = 20;
@@ -819,7 +1127,55 @@ alloc_data(void)
   data->request_id   = (cupsGetRand() % 1000) * 137;
   data->show_header  = true;
 
-  ippFileSetVar(data->parent, "date-start", iso_date(ippTimeToDate(time(NULL))));
+  ippFileSetVar(data->parent, "date-start", iso_date(ippTimeToDate(time(NULL)), datestr, sizeof(datestr)));
+
+  return (data);
+}
+
+
+//
+// 'alloc_target_data()' - Allocate test data for a parallel test target.
+//
+// The global options are copied from the template test data and variables are
+// looked up in the template's parent file.  `NULL` is returned if the target's
+// URI cannot be used.
+//
+
+static ipptool_test_t *			// O - Test data or `NULL` on error
+alloc_target_data(
+    ipptool_target_t *target)		// I - Test target
+{
+  ipptool_test_t	*data,		// Test data for this target
+			*tdata = target->data;
+					// Template test data
+
+
+  data = alloc_data();
+
+  ippFileDelete(data->parent);
+  data->parent = ippFileNew(tdata->parent, /*attr_cb*/NULL, (ipp_ferror_cb_t)error_cb, data);
+
+  data->encryption               = target->encryption;
+  data->family                   = tdata->family;
+  data->output                   = tdata->output;
+  data->repeat_on_busy           = tdata->repeat_on_busy;
+  data->stop_after_include_error = tdata->stop_after_include_error;
+  data->timeout                  = tdata->timeout;
+  data->validate_headers         = tdata->validate_headers;
+  data->verbosity                = tdata->verbosity;
+  data->def_ignore_errors        = tdata->def_ignore_errors;
+  data->def_transfer             = tdata->def_transfer;
+  data->def_version              = tdata->def_version;
+
+  if (!ippFileSetVar(data->parent, "uri", target->uri))
+  {
+    cupsLangPrintf(stderr, _("ipptool: Bad URI '%s'."), target->uri);
+    free_data(data);
+    return (NULL);
+  }
+
+  if (ippFileGetVar(data->parent, "uriuser") && ippFileGetVar(data->parent, "uripassword"))
+    cupsSetPasswordCB(password_cb, data->parent);
 
   return (data);
 }
@@ -850,6 +1206,11 @@ clear_data(ipptool_test_t *data)	// I - Test data
     free(expect->if_defined);
     free(expect->if_not_defined);
     free(expect->with_value);
+    if (expect->with_regex)
+    {
+      regfree(expect->with_regex);
+      free(expect->with_regex);
+    }
     free(expect->define_match);
     free(expect->define_no_match);
     free(expect->define_value);
@@ -880,6 +1241,11 @@ clear_data(ipptool_test_t *data)	// I - Test data
     free(expect->if_defined);
     free(expect->if_not_defined);
     free(expect->with_value);
+    if (expect->with_regex)
+    {
+      regfree(expect->with_regex);
+      free(expect->with_regex);
+    }
     free(expect->define_match);
     free(expect->define_no_match);
     free(expect->define_value);
@@ -892,6 +1258,33 @@ clear_data(ipptool_test_t *data)	// I - Test data
 }
 
 
+//
+// 'compare_latencies()' - Compare two request latencies.
+//
+
+static int				// O - Result of comparison
+compare_latencies(const double *a,	// I - First latency
+                  const double *b)	// I - Second latency
+{
+  return ((*a > *b) - (*a < *b));
+}
+
+
+//
+// 'compare_stats()' - Compare the operation codes of two statistics.
+//
+
+static int				// O - Result of comparison
+compare_stats(ipptool_stat_t *a,	// I - First statistics
+              ipptool_stat_t *b,	// I - Second statistics
+              void           *cb_data)	// I - Callback data (not used)
+{
+  (void)cb_data;
+
+  return ((int)a->op - (int)b->op);
+}
+
+
 //
 // 'compare_uris()' - Compare two URIs...
 //
@@ -948,9 +1341,50 @@ compare_uris(const char *a,             // I - First URI
 }
 
 
+//
+// 'compile_with_regex()' - Compile a WITH-VALUE regular expression.
+//
+
+static bool				// O - `true` on success, `false` on error
+compile_with_regex(
+    ipptool_test_t   *data,		// I - Test data
+    ipptool_expect_t *expect)		// I - Expected attribute
+{
+  int	r;				// Error, if any
+  char	temp[1024];			// Error message
+
+
+  if (expect->with_regex)
+    regfree(expect->with_regex);
+  else if ((expect->with_regex = (regex_t *)calloc(1, sizeof(regex_t))) == NULL)
+  {
+    print_fatal_error(data, "Unable to allocate memory for WITH-VALUE regular expression.");
+    return (false);
+  }
+
+  if ((r = regcomp(expect->with_regex, expect->with_value, REG_EXTENDED | REG_NOSUB)) != 0)
+  {
+    regerror(r, expect->with_regex, temp, sizeof(temp));
+
+    print_fatal_error(data, "Unable to compile WITH-VALUE regular expression \"%s\" - %s", expect->with_value, temp);
+
+    free(expect->with_regex);
+    expect->with_regex = NULL;
+    data->pass         = false;
+
+    return (false);
+  }
+
+  return (true);
+}
+
+
 //
 // 'connect_printer()' - Connect to the printer.
 //
+// Idle connections from previous tests and files are reused when possible.
+// Call "httpReleaseConnection()" when done with the connection.
+//
 
 static http_t *				// O - HTTP connection or `NULL` on error
 connect_printer(ipptool_test_t *data)	// I - Test data
@@ -975,13 +1409,13 @@ connect_printer(ipptool_test_t *data)	// I - Test data
   else
     encryption = data->encryption;
 
-  if ((http = httpConnect(hostname, atoi(port), NULL, data->family, encryption, 1, 30000, NULL)) == NULL)
+  if ((http = httpAcquireConnection(hostname, atoi(port), data->family, encryption, true, 30000, NULL)) == NULL)
   {
     print_fatal_error(data, "Unable to connect to \"%s\" on port %s: %s", hostname, port, cupsGetErrorString());
     return (NULL);
   }
 
-  httpSetDefaultField(data->http, HTTP_FIELD_ACCEPT_ENCODING, "deflate, gzip, identity");
+  httpSetDefaultField(http, HTTP_FIELD_ACCEPT_ENCODING, "deflate, gzip, identity");
 
   if (data->timeout > 0.0)
     httpSetTimeout(http, data->timeout, timeout_cb, NULL);
@@ -1150,6 +1584,13 @@ do_monitor_printer_state(
   char		buffer[131072];		// Copy buffer
   size_t	num_pattrs;		// Number of printer attributes
   const char	*pattrs[100];		// Printer attributes we care about
+  int		sub_id,			// Subscription ID, if any
+		sequence = 1;		// Next event sequence number
+  time_t	expire = 0;		// Subscription lease expiration
+  unsigned	hash,			// Hash of current printer attributes
+		prev_hash = 0;		// Hash of previous printer attributes
+  useconds_t	interval,		// Current polling interval
+		max_interval;		// Maximum polling interval
 
 
   if (getenv("IPPTOOL_DEBUG"))
@@ -1167,7 +1608,7 @@ do_monitor_printer_state(
   else
     encryption = data->encryption;
 
-  if ((http = httpConnect(host, port, NULL, data->family, encryption, 1, 30000, NULL)) == NULL)
+  if ((http = httpAcquireConnection(host, port, data->family, encryption, true, 30000, NULL)) == NULL)
   {
     print_fatal_error(data, "Unable to connect to \"%s\" on port %d: %s", host, port, cupsGetErrorString());
     return (0);
@@ -1175,12 +1616,23 @@ do_monitor_printer_state(
 
   httpSetDefaultField(http, HTTP_FIELD_ACCEPT_ENCODING, "deflate, gzip, identity");
 
-  if (data->timeout > 0.0)
-    httpSetTimeout(http, data->timeout, timeout_cb, NULL);
+  // Keep waiting for responses (including Get-Notifications requests that are
+  // held by the printer) until the test is done...
+  httpSetTimeout(http, 1.0, (http_timeout_cb_t)monitor_timeout_cb, data);
 
   // Wait for the initial delay as needed...
   if (data->monitor_delay)
-    usleep(data->monitor_delay);
+    monitor_sleep(data, data->monitor_delay);
+
+  // Use event notifications when the printer supports them, otherwise poll
+  // with an adaptive backoff when the printer state does not change...
+  sub_id   = monitor_subscribe(data, http, resource, &expire);
+  interval = data->monitor_interval;
+
+  if (data->monitor_interval >= 7500000)
+    max_interval = data->monitor_interval > 30000000 ? data->monitor_interval : 30000000;
+  else
+    max_interval = 4 * data->monitor_interval;
 
   // Create a query request that we'll reuse...
   request = ippNewRequest(IPP_OP_GET_PRINTER_ATTRIBUTES);
@@ -1217,11 +1669,11 @@ do_monitor_printer_state(
       status   = httpGetStatus(http);
     }
 
-    if (!data->monitor_done && !Cancel && status == HTTP_STATUS_ERROR && httpGetError(data->http) != EINVAL &&
+    if (!data->monitor_done && !Cancel && status == HTTP_STATUS_ERROR && httpGetError(http) != EINVAL &&
 #ifdef _WIN32
-	httpGetError(data->http) != WSAETIMEDOUT)
+	httpGetError(http) != WSAETIMEDOUT)
 #else
-	httpGetError(data->http) != ETIMEDOUT)
+	httpGetError(http) != ETIMEDOUT)
 #endif // _WIN32
     {
       if (!httpReconnect(http, 30000, NULL))
@@ -1268,7 +1720,7 @@ do_monitor_printer_state(
       if (found)
 	ippAttributeString(found, buffer, sizeof(buffer));
 
-      if (found && !with_value(data, NULL, expect->with_value, expect->with_flags, found, buffer, sizeof(buffer)))
+      if (found && !with_value(data, NULL, expect->with_value, expect->with_flags, expect->with_regex, found, buffer, sizeof(buffer)))
       {
 	if (expect->define_no_match)
 	{
@@ -1288,8 +1740,8 @@ do_monitor_printer_state(
 	break;
       }
 
-      if (found && expect->display_match && (data->output == IPPTOOL_OUTPUT_TEST || (data->output == IPPTOOL_OUTPUT_PLIST && data->outfile != cupsFileStdout())))
-	cupsFilePrintf(cupsFileStdout(), "CONT]\n\n%s\n\n    %-68.68s [", expect->display_match, data->name);
+      if (found && expect->display_match && (data->output == IPPTOOL_OUTPUT_TEST || (data->output == IPPTOOL_OUTPUT_PLIST && data->outfile != data->stdfile)))
+	cupsFilePrintf(data->stdfile, "CONT]\n\n%s\n\n    %-68.68s [", expect->display_match, data->name);
 
       if (found && expect->define_match)
       {
@@ -1345,18 +1797,46 @@ do_monitor_printer_state(
     if (i == 0)
       data->monitor_done = 1;		// All tests passed
 
+    hash = monitor_hash(response, buffer, sizeof(buffer));
+
     ippDelete(response);
     response = NULL;
 
-    // Sleep between requests...
+    // Wait for the next event or poll interval...
     if (data->monitor_done || Cancel)
       break;
 
-    usleep(data->monitor_interval);
+    if (sub_id > 0)
+    {
+      if (monitor_wait(data, http, resource, sub_id, &sequence, &expire))
+        continue;
+      else if (data->monitor_done || Cancel)
+        break;
+
+      // Fall back on polling if the printer stops reporting events...
+      if (getenv("IPPTOOL_DEBUG"))
+        fprintf(stderr, "ipptool: Notifications for '%s' failed (%s), polling.\n", data->monitor_uri, cupsGetErrorString());
+
+      monitor_unsubscribe(data, http, resource, sub_id);
+      sub_id = 0;
+      continue;
+    }
+
+    if (hash != prev_hash)
+      interval = data->monitor_interval;
+    else if ((interval *= 2) > max_interval)
+      interval = max_interval;
+
+    prev_hash = hash;
+
+    monitor_sleep(data, interval);
   }
 
-  // Close the connection to the printer and return...
-  httpClose(http);
+  // Release the connection to the printer and return...
+  if (sub_id > 0 && httpGetState(http) == HTTP_STATE_WAITING)
+    monitor_unsubscribe(data, http, resource, sub_id);
+
+  httpReleaseConnection(http);
   ippDelete(request);
   ippDelete(response);
 
@@ -1391,6 +1871,7 @@ do_test(ipp_file_t     *f,		// I - IPP data file
   ssize_t	bytes;			// Bytes read/written
   size_t	widths[200];		// Width of columns
   const char	*error;			// Current error
+  double	start;			// Start time for request
 
 
   if (Cancel)
@@ -1459,17 +1940,17 @@ do_test(ipp_file_t     *f,		// I - IPP data file
     cupsFilePuts(data->outfile, "</array>\n");
   }
 
-  if (data->output == IPPTOOL_OUTPUT_TEST || (data->output == IPPTOOL_OUTPUT_PLIST && data->outfile != cupsFileStdout()))
+  if (data->output == IPPTOOL_OUTPUT_TEST || (data->output == IPPTOOL_OUTPUT_PLIST && data->outfile != data->stdfile))
   {
     if (data->verbosity)
     {
-      cupsFilePrintf(cupsFileStdout(), "    %s:\n", ippOpString(ippGetOperation(request)));
+      cupsFilePrintf(data->stdfile, "    %s:\n", ippOpString(ippGetOperation(request)));
 
       for (attrptr = ippGetFirstAttribute(request); attrptr; attrptr = ippGetNextAttribute(request))
-	print_attr(cupsFileStdout(), IPPTOOL_OUTPUT_TEST, attrptr, NULL);
+	print_attr(data->stdfile, IPPTOOL_OUTPUT_TEST, attrptr, NULL);
     }
 
-    cupsFilePrintf(cupsFileStdout(), "    %-68.68s [", data->name);
+    cupsFilePrintf(data->stdfile, "    %-68.68s [", data->name);
   }
 
   if ((data->skip_previous && !data->prev_pass) || data->skip_test || data->pass_test)
@@ -1499,12 +1980,12 @@ do_test(ipp_file_t     *f,		// I - IPP data file
       cupsFilePuts(data->outfile, "<dict />\n");
     }
 
-    if (data->output == IPPTOOL_OUTPUT_TEST || (data->output == IPPTOOL_OUTPUT_PLIST && data->outfile != cupsFileStdout()))
+    if (data->output == IPPTOOL_OUTPUT_TEST || (data->output == IPPTOOL_OUTPUT_PLIST && data->outfile != data->stdfile))
     {
       if (data->pass_test)
-	cupsFilePuts(cupsFileStdout(), "PASS]\n");
+	cupsFilePuts(data->stdfile, "PASS]\n");
       else
-	cupsFilePuts(cupsFileStdout(), "SKIP]\n");
+	cupsFilePuts(data->stdfile, "SKIP]\n");
     }
 
     goto skip_error;
@@ -1549,6 +2030,7 @@ do_test(ipp_file_t     *f,		// I - IPP data file
     data->prev_pass = true;
     repeat_test     = false;
     response        = NULL;
+    start           = data->stats ? get_time() : 0.0;
 
     if (status != HTTP_STATUS_ERROR)
     {
@@ -1622,6 +2104,9 @@ do_test(ipp_file_t     *f,		// I - IPP data file
       }
     }
 
+    if (data->stats)
+      add_stat(data->stats, ippGetOperation(request), get_time() - start, !response || ippGetStatusCode(response) >= IPP_STATUS_ERROR_BAD_REQUEST);
+
     if (!Cancel && status == HTTP_STATUS_ERROR && httpGetError(data->http) != EINVAL &&
 #ifdef _WIN32
 	httpGetError(data->http) != WSAETIMEDOUT)
@@ -1995,7 +2480,7 @@ do_test(ipp_file_t     *f,		// I - IPP data file
             ippRestore(response);
 	    break;
 	  }
-	  else if (found && !with_value(data, NULL, expect->with_value, expect->with_flags, found, data->buffer, sizeof(data->buffer)))
+	  else if (found && !with_value(data, NULL, expect->with_value, expect->with_flags, expect->with_regex, found, data->buffer, sizeof(data->buffer)))
 	  {
 	    if (expect->define_no_match)
 	    {
@@ -2010,7 +2495,7 @@ do_test(ipp_file_t     *f,		// I - IPP data file
 	      else
 		add_stringf(exp_errors, "EXPECTED: %s %s \"%s\"", expect->name, with_flags_string(expect->with_flags), expect->with_value);
 
-	      with_value(data, exp_errors, expect->with_value, expect->with_flags, found, data->buffer, sizeof(data->buffer));
+	      with_value(data, exp_errors, expect->with_value, expect->with_flags, expect->with_regex, found, data->buffer, sizeof(data->buffer));
 	    }
 
 	    if (expect->repeat_no_match && repeat_count < expect->repeat_limit)
@@ -2071,8 +2556,8 @@ do_test(ipp_file_t     *f,		// I - IPP data file
 	    }
 	  }
 
-	  if (found && expect->display_match && (data->output == IPPTOOL_OUTPUT_TEST || (data->output == IPPTOOL_OUTPUT_PLIST && data->outfile != cupsFileStdout())))
-	    cupsFilePrintf(cupsFileStdout(), "\n%s\n\n", expect->display_match);
+	  if (found && expect->display_match && (data->output == IPPTOOL_OUTPUT_TEST || (data->output == IPPTOOL_OUTPUT_PLIST && data->outfile != data->stdfile)))
+	    cupsFilePrintf(data->stdfile, "\n%s\n\n", expect->display_match);
 
 	  if (found && expect->define_match)
 	  {
@@ -2163,9 +2648,9 @@ do_test(ipp_file_t     *f,		// I - IPP data file
     // If we are going to repeat this test, display intermediate results...
     if (repeat_test)
     {
-      if (data->output == IPPTOOL_OUTPUT_TEST || (data->output == IPPTOOL_OUTPUT_PLIST && data->outfile != cupsFileStdout()))
+      if (data->output == IPPTOOL_OUTPUT_TEST || (data->output == IPPTOOL_OUTPUT_PLIST && data->outfile != data->stdfile))
       {
-	cupsFilePrintf(cupsFileStdout(), "%04d]\n", repeat_count);
+	cupsFilePrintf(data->stdfile, "%04d]\n", repeat_count);
 \
 	if (data->num_displayed > 0)
 	{
@@ -2178,7 +2663,7 @@ do_test(ipp_file_t     *f,		// I - IPP data file
 	      {
 		if (!strcmp(data->displayed[i], attrname))
 		{
-		  print_attr(cupsFileStdout(), IPPTOOL_OUTPUT_TEST, attrptr, NULL);
+		  print_attr(data->stdfile, IPPTOOL_OUTPUT_TEST, attrptr, NULL);
 		  break;
 		}
 	      }
@@ -2187,9 +2672,9 @@ do_test(ipp_file_t     *f,		// I - IPP data file
 	}
       }
 
-      if (data->output == IPPTOOL_OUTPUT_TEST || (data->output == IPPTOOL_OUTPUT_PLIST && data->outfile != cupsFileStdout()))
+      if (data->output == IPPTOOL_OUTPUT_TEST || (data->output == IPPTOOL_OUTPUT_PLIST && data->outfile != data->stdfile))
       {
-	cupsFilePrintf(cupsFileStdout(), "    %-68.68s [", data->name);
+	cupsFilePrintf(data->stdfile, "    %-68.68s [", data->name);
       }
 
       ippDelete(response);
@@ -2273,19 +2758,19 @@ do_test(ipp_file_t     *f,		// I - IPP data file
     cupsFilePuts(data->outfile, "]\n");
   }
 
-  if (data->output == IPPTOOL_OUTPUT_TEST || (data->output == IPPTOOL_OUTPUT_PLIST && data->outfile != cupsFileStdout()))
+  if (data->output == IPPTOOL_OUTPUT_TEST || (data->output == IPPTOOL_OUTPUT_PLIST && data->outfile != data->stdfile))
   {
-    cupsFilePuts(cupsFileStdout(), data->prev_pass ? "PASS]\n" : "FAIL]\n");
+    cupsFilePuts(data->stdfile, data->prev_pass ? "PASS]\n" : "FAIL]\n");
 
     if (!data->prev_pass || (data->verbosity && response))
     {
-      cupsFilePrintf(cupsFileStdout(), "        RECEIVED: %lu bytes in response\n", (unsigned long)ippGetLength(response));
-      cupsFilePrintf(cupsFileStdout(), "        status-code = %s (%s)\n", ippErrorString(cupsGetError()), cupsGetErrorString());
+      cupsFilePrintf(data->stdfile, "        RECEIVED: %lu bytes in response\n", (unsigned long)ippGetLength(response));
+      cupsFilePrintf(data->stdfile, "        status-code = %s (%s)\n", ippErrorString(cupsGetError()), cupsGetErrorString());
 
       if (data->verbosity && response)
       {
 	for (attrptr = ippGetFirstAttribute(response); attrptr; attrptr = ippGetNextAttribute(response))
-	  print_attr(cupsFileStdout(), IPPTOOL_OUTPUT_TEST, attrptr, NULL);
+	  print_attr(data->stdfile, IPPTOOL_OUTPUT_TEST, attrptr, NULL);
       }
     }
   }
@@ -2349,16 +2834,16 @@ do_test(ipp_file_t     *f,		// I - IPP data file
       cupsFilePuts(data->outfile, "</array>\n");
     }
 
-    if (data->output == IPPTOOL_OUTPUT_TEST || (data->output == IPPTOOL_OUTPUT_PLIST && data->outfile != cupsFileStdout()))
+    if (data->output == IPPTOOL_OUTPUT_TEST || (data->output == IPPTOOL_OUTPUT_PLIST && data->outfile != data->stdfile))
     {
       for (error = (char *)cupsArrayGetFirst(data->errors);
 	   error;
 	   error = (char *)cupsArrayGetNext(data->errors))
-	cupsFilePrintf(cupsFileStdout(), "        %s\n", error);
+	cupsFilePrintf(data->stdfile, "        %s\n", error);
     }
   }
 
-  if (data->num_displayed > 0 && !data->verbosity && response && (data->output == IPPTOOL_OUTPUT_TEST || (data->output == IPPTOOL_OUTPUT_PLIST && data->outfile != cupsFileStdout())))
+  if (data->num_displayed > 0 && !data->verbosity && response && (data->output == IPPTOOL_OUTPUT_TEST || (data->output == IPPTOOL_OUTPUT_PLIST && data->outfile != data->stdfile)))
   {
     for (attrptr = ippGetFirstAttribute(response); attrptr; attrptr = ippGetNextAttribute(response))
     {
@@ -2405,12 +2890,17 @@ do_tests(const char     *testfile,	// I - Test file to use
          ipptool_test_t *data)		// I - Test data
 {
   ipp_file_t	*file;			// IPP data file
+  http_t	*http = NULL;		// Connection opened for this file
 
 
-  // Connect to the printer/server...
-  data->http = connect_printer(data);
+  // Connect to the printer/server, reusing the connection from the including
+  // file, if any...
+  if (!data->http)
+    data->http = http = connect_printer(data);
 
-  // Run tests...
+  // Run tests...  Each test is parsed just before it is run because variable
+  // expansion and the IF-DEFINED/IF-NOT-DEFINED directives depend on values
+  // from earlier responses, so parsed tests are not cached between runs.
   if ((file = ippFileNew(data->parent, NULL, (ipp_ferror_cb_t)error_cb, data)) == NULL)
   {
     print_fatal_error(data, "Unable to create test file parser: %s", cupsGetErrorString());
@@ -2427,9 +2917,12 @@ do_tests(const char     *testfile,	// I - Test file to use
 
   ippFileDelete(file);
 
-  // Close connection and return...
-  httpClose(data->http);
-  data->http = NULL;
+  // Release connection and return...
+  if (http)
+  {
+    httpReleaseConnection(http);
+    data->http = NULL;
+  }
 
   return (data->pass);
 }
@@ -2660,6 +3153,21 @@ free_data(ipptool_test_t *data)		// I - Test data
 }
 
 
+//
+// 'free_stat()' - Free operation statistics.
+//
+
+static void
+free_stat(ipptool_stat_t *stat,		// I - Operation statistics
+          void           *cb_data)	// I - Callback data (not used)
+{
+  (void)cb_data;
+
+  free(stat->latencies);
+  free(stat);
+}
+
+
 //
 // 'generate_file()' - Generate a print file.
 //
@@ -2786,6 +3294,24 @@ get_filename(const char *testfile,	// I - Current test file
 }
 
 
+//
+// 'get_real()' - Format a real number with up to 3 decimal places.
+//
+// The number is always formatted using "." as the decimal point, as required
+// for JSON and XML output.
+//
+
+static char *				// O - Formatted number
+get_real(double number,			// I - Number
+         char   *buffer,		// I - String buffer
+         size_t bufsize)		// I - Size of string buffer
+{
+  _cupsStrFormatd(buffer, buffer + bufsize - 1, (double)(long long)(number * 1000.0 + 0.5) / 1000.0, localeconv());
+
+  return (buffer);
+}
+
+
 //
 // 'get_string()' - Get a pointer to a string value or the portion of interest.
 //
@@ -2860,27 +3386,341 @@ get_string(ipp_attribute_t *attr,	// I - IPP attribute
 }
 
 
-//
-// 'iso_date()' - Return an ISO 8601 date/time string for the given IPP dateTime
-//                value.
-//
+//
+// 'get_time()' - Get the current monotonic time in seconds.
+//
+
+static double				// O - Time in seconds
+get_time(void)
+{
+#ifdef _WIN32
+  return (0.001 * GetTickCount64());
+
+#else
+  struct timespec curtime;		// Current time
+
+
+  clock_gettime(CLOCK_MONOTONIC, &curtime);
+
+  return (curtime.tv_sec + 0.000000001 * curtime.tv_nsec);
+#endif // _WIN32
+}
+
+
+//
+// 'iso_date()' - Return an ISO 8601 date/time string for the given IPP dateTime
+//                value.
+//
+
+static char *				// O - ISO 8601 date/time string
+iso_date(const ipp_uchar_t *date,	// I - IPP (RFC 1903) date/time value
+         char              *buffer,	// I - String buffer
+         size_t            bufsize)	// I - Size of string buffer
+{
+  time_t	utctime;		// UTC time since 1970
+  struct tm	utcdate;		// UTC date/time
+
+
+  utctime = ippDateToTime(date);
+  gmtime_r(&utctime, &utcdate);
+
+  snprintf(buffer, bufsize, "%04d-%02d-%02dT%02d:%02d:%02dZ",
+	   utcdate.tm_year + 1900, utcdate.tm_mon + 1, utcdate.tm_mday,
+	   utcdate.tm_hour, utcdate.tm_min, utcdate.tm_sec);
+
+  return (buffer);
+}
+
+
+//
+// 'monitor_hash()' - Compute a hash of the monitored printer attributes.
+//
+
+static unsigned				// O - Hash value
+monitor_hash(ipp_t  *response,		// I - Get-Printer-Attributes response
+             char   *buffer,		// I - Value buffer
+             size_t bufsize)		// I - Size of value buffer
+{
+  unsigned	hash = 2166136261U;	// FNV-1a hash value
+  ipp_attribute_t *attr;		// Current attribute
+  const char	*name,			// Attribute name
+		*ptr;			// Pointer into name/value
+
+
+  for (attr = ippGetFirstAttribute(response); attr; attr = ippGetNextAttribute(response))
+  {
+    if ((name = ippGetName(attr)) == NULL || ippGetGroupTag(attr) != IPP_TAG_PRINTER)
+      continue;
+
+    ippAttributeString(attr, buffer, bufsize);
+
+    for (ptr = name; *ptr; ptr ++)
+      hash = (hash ^ (unsigned char)*ptr) * 16777619U;
+
+    hash = (hash ^ '=') * 16777619U;
+
+    for (ptr = buffer; *ptr; ptr ++)
+      hash = (hash ^ (unsigned char)*ptr) * 16777619U;
+  }
+
+  return (hash);
+}
+
+
+//
+// 'monitor_sleep()' - Sleep between MONITOR-PRINTER-STATE polls.
+//
+
+static void
+monitor_sleep(ipptool_test_t *data,	// I - Test data
+              useconds_t     usecs)	// I - Microseconds to sleep
+{
+  useconds_t	delay;			// Current delay
+
+
+  // Sleep in short intervals so that the monitor stops promptly...
+  while (usecs > 0 && !data->monitor_done && !Cancel)
+  {
+    if ((delay = usecs) > 100000)
+      delay = 100000;
+
+    usleep(delay);
+    usecs -= delay;
+  }
+}
+
+
+//
+// 'monitor_subscribe()' - Subscribe to printer state events, if supported.
+//
+
+static int				// O - Subscription ID or `0` if not supported
+monitor_subscribe(
+    ipptool_test_t *data,		// I - Test data
+    http_t         *http,		// I - Connection to printer
+    const char     *resource,		// I - Resource path
+    time_t         *expire)		// O - Lease expiration time or `0` for none
+{
+  int		sub_id = 0;		// Subscription ID
+  ipp_t		*request,		// IPP request
+		*response;		// IPP response
+  ipp_attribute_t *attr;		// Attribute
+  size_t	num_events = 0;		// Number of events
+  const char	*events[2];		// Events to subscribe to
+  static const char * const pattrs[] =	// Printer attributes
+  {
+    "notify-events-supported",
+    "notify-pull-method-supported"
+  };
+
+
+  // See whether the printer supports "ippget" notifications...
+  request = ippNewRequest(IPP_OP_GET_PRINTER_ATTRIBUTES);
+  ippSetVersion(request, data->version / 10, data->version % 10);
+  ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_URI, "printer-uri", NULL, data->monitor_uri);
+  ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_NAME, "requesting-user-name", NULL, cupsGetUser());
+  ippAddStrings(request, IPP_TAG_OPERATION, IPP_CONST_TAG(IPP_TAG_KEYWORD), "requested-attributes", sizeof(pattrs) / sizeof(pattrs[0]), NULL, pattrs);
+
+  response = cupsDoRequest(http, request, resource);
+
+  if (ippContainsString(ippFindAttribute(response, "notify-pull-method-supported", IPP_TAG_KEYWORD), "ippget"))
+  {
+    attr = ippFindAttribute(response, "notify-events-supported", IPP_TAG_KEYWORD);
+
+    if (ippContainsString(attr, "printer-config-changed"))
+      events[num_events ++] = "printer-config-changed";
+    if (ippContainsString(attr, "printer-state-changed"))
+      events[num_events ++] = "printer-state-changed";
+  }
+
+  ippDelete(response);
+
+  if (num_events == 0)
+    return (0);
+
+  // Create the subscription...
+  request = ippNewRequest(IPP_OP_CREATE_PRINTER_SUBSCRIPTIONS);
+  ippSetVersion(request, data->version / 10, data->version % 10);
+  ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_URI, "printer-uri", NULL, data->monitor_uri);
+  ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_NAME, "requesting-user-name", NULL, cupsGetUser());
+  ippAddString(request, IPP_TAG_SUBSCRIPTION, IPP_CONST_TAG(IPP_TAG_KEYWORD), "notify-pull-method", NULL, "ippget");
+  ippAddStrings(request, IPP_TAG_SUBSCRIPTION, IPP_CONST_TAG(IPP_TAG_KEYWORD), "notify-events", num_events, NULL, events);
+  ippAddInteger(request, IPP_TAG_SUBSCRIPTION, IPP_TAG_INTEGER, "notify-lease-duration", MONITOR_LEASE);
+
+  response = cupsDoRequest(http, request, resource);
+
+  if (cupsGetError() <= IPP_STATUS_OK_CONFLICTING && (attr = ippFindAttribute(response, "notify-subscription-id", IPP_TAG_INTEGER)) != NULL)
+  {
+    sub_id = ippGetInteger(attr, 0);
+
+    if ((attr = ippFindAttribute(response, "notify-lease-duration", IPP_TAG_INTEGER)) == NULL)
+      *expire = time(NULL) + MONITOR_LEASE;
+    else if (ippGetInteger(attr, 0) > 0)
+      *expire = time(NULL) + ippGetInteger(attr, 0);
+    else
+      *expire = 0;
+
+    if (getenv("IPPTOOL_DEBUG"))
+      fprintf(stderr, "ipptool: Using notification subscription %d for '%s'.\n", sub_id, data->monitor_uri);
+  }
+
+  ippDelete(response);
+
+  return (sub_id);
+}
+
+
+//
+// 'monitor_timeout_cb()' - Keep waiting on the monitor connection until stopped.
+//
+
+static bool				// O - `true` to continue, `false` to stop
+monitor_timeout_cb(
+    http_t         *http,		// I - Connection to printer (unused)
+    ipptool_test_t *data)		// I - Test data
+{
+  (void)http;
+
+  return (!data->monitor_done && !Cancel);
+}
+
+
+//
+// 'monitor_unsubscribe()' - Cancel a printer state subscription.
+//
+
+static void
+monitor_unsubscribe(
+    ipptool_test_t *data,		// I - Test data
+    http_t         *http,		// I - Connection to printer
+    const char     *resource,		// I - Resource path
+    int            sub_id)		// I - Subscription ID
+{
+  ipp_t	*request;			// IPP request
+
+
+  request = ippNewRequest(IPP_OP_CANCEL_SUBSCRIPTION);
+  ippSetVersion(request, data->version / 10, data->version % 10);
+  ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_URI, "printer-uri", NULL, data->monitor_uri);
+  ippAddInteger(request, IPP_TAG_OPERATION, IPP_TAG_INTEGER, "notify-subscription-id", sub_id);
+  ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_NAME, "requesting-user-name", NULL, cupsGetUser());
+
+  ippDelete(cupsDoRequest(http, request, resource));
+}
+
+
+//
+// 'monitor_wait()' - Wait for printer state events.
+//
+// The printer holds each Get-Notifications request until an event is available
+// when it supports "notify-wait", otherwise the "notify-get-interval" value
+// (limited to the MONITOR-PRINTER-STATE interval) is used between requests.
+//
+
+static bool				// O - `true` to poll the printer, `false` on error
+monitor_wait(ipptool_test_t *data,	// I  - Test data
+             http_t         *http,	// I  - Connection to printer
+             const char     *resource,	// I  - Resource path
+             int            sub_id,	// I  - Subscription ID
+             int            *sequence,	// IO - Next event sequence number
+             time_t         *expire)	// IO - Lease expiration time
+{
+  ipp_t		*request,		// IPP request
+		*response;		// IPP response
+  ipp_attribute_t *attr;		// Current attribute
+  ipp_status_t	status;			// Response status
+  bool		events;			// Got any events?
+  int		interval,		// Seconds before the next request
+		number;			// Event sequence number
+  useconds_t	usecs;			// Microseconds before the next request
+
+
+  while (!data->monitor_done && !Cancel)
+  {
+    // Renew the subscription before the lease expires...
+    if (*expire && time(NULL) >= (*expire - MONITOR_LEASE / 4))
+    {
+      request = ippNewRequest(IPP_OP_RENEW_SUBSCRIPTION);
+      ippSetVersion(request, data->version / 10, data->version % 10);
+      ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_URI, "printer-uri", NULL, data->monitor_uri);
+      ippAddInteger(request, IPP_TAG_OPERATION, IPP_TAG_INTEGER, "notify-subscription-id", sub_id);
+      ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_NAME, "requesting-user-name", NULL, cupsGetUser());
+      ippAddInteger(request, IPP_TAG_OPERATION, IPP_TAG_INTEGER, "notify-lease-duration", MONITOR_LEASE);
+
+      response = cupsDoRequest(http, request, resource);
+
+      if (cupsGetError() > IPP_STATUS_OK_CONFLICTING)
+      {
+        ippDelete(response);
+        return (false);
+      }
+
+      if ((attr = ippFindAttribute(response, "notify-lease-duration", IPP_TAG_INTEGER)) == NULL)
+        *expire = time(NULL) + MONITOR_LEASE;
+      else if (ippGetInteger(attr, 0) > 0)
+        *expire = time(NULL) + ippGetInteger(attr, 0);
+      else
+        *expire = 0;
+
+      ippDelete(response);
+    }
+
+    // Get any new events...
+    request = ippNewRequest(IPP_OP_GET_NOTIFICATIONS);
+    ippSetVersion(request, data->version / 10, data->version % 10);
+    ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_URI, "printer-uri", NULL, data->monitor_uri);
+    ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_NAME, "requesting-user-name", NULL, cupsGetUser());
+    ippAddInteger(request, IPP_TAG_OPERATION, IPP_TAG_INTEGER, "notify-subscription-ids", sub_id);
+    ippAddInteger(request, IPP_TAG_OPERATION, IPP_TAG_INTEGER, "notify-sequence-numbers", *sequence);
+    ippAddBoolean(request, IPP_TAG_OPERATION, "notify-wait", true);
+
+    response = cupsDoRequest(http, request, resource);
+    status   = cupsGetError();
+
+    if (status > IPP_STATUS_OK_CONFLICTING)
+    {
+      // Error or "successful-ok-events-complete"...
+      ippDelete(response);
+      return (false);
+    }
+
+    for (attr = ippGetFirstAttribute(response), events = false, interval = 0; attr; attr = ippGetNextAttribute(response))
+    {
+      const char *name = ippGetName(attr);
+					// Attribute name
+
+      if (!name || ippGetValueTag(attr) != IPP_TAG_INTEGER)
+        continue;
+
+      if (ippGetGroupTag(attr) == IPP_TAG_OPERATION && !strcmp(name, "notify-get-interval"))
+      {
+        interval = ippGetInteger(attr, 0);
+      }
+      else if (ippGetGroupTag(attr) == IPP_TAG_EVENT_NOTIFICATION && !strcmp(name, "notify-sequence-number") && (number = ippGetInteger(attr, 0)) >= *sequence)
+      {
+        *sequence = number + 1;
+        events    = true;
+      }
+    }
+
+    ippDelete(response);
 
-static char *				// O - ISO 8601 date/time string
-iso_date(const ipp_uchar_t *date)	// I - IPP (RFC 1903) date/time value
-{
-  time_t	utctime;		// UTC time since 1970
-  struct tm	utcdate;		// UTC date/time
-  static char	buffer[255];		// String buffer
+    if (events)
+      return (true);
 
+    // No events yet, wait before asking again...
+    if (interval < 1)
+      interval = 1;
+    else if (interval > 60)
+      interval = 60;
 
-  utctime = ippDateToTime(date);
-  gmtime_r(&utctime, &utcdate);
+    if ((usecs = (useconds_t)interval * 1000000) > data->monitor_interval)
+      usecs = data->monitor_interval > 1000000 ? data->monitor_interval : 1000000;
 
-  snprintf(buffer, sizeof(buffer), "%04d-%02d-%02dT%02d:%02d:%02dZ",
-	   utcdate.tm_year + 1900, utcdate.tm_mon + 1, utcdate.tm_mday,
-	   utcdate.tm_hour, utcdate.tm_min, utcdate.tm_sec);
+    monitor_sleep(data, usecs);
+  }
 
-  return (buffer);
+  return (true);
 }
 
 
@@ -2964,8 +3804,8 @@ parse_generate_file(
     return (0);
   }
 
-  // Get printer attributes...
-  if ((http = connect_printer(data)) == NULL)
+  // Get printer attributes, using the current connection if possible...
+  if ((http = data->http) == NULL && (http = connect_printer(data)) == NULL)
   {
     print_fatal_error(data, "GENERATE-FILE connection failure on line %d of '%s'.", ippFileGetLineNumber(f), ippFileGetFilename(f));
     return (false);
@@ -2976,7 +3816,8 @@ parse_generate_file(
 
   response = cupsDoRequest(http, request, ippFileGetVar(data->parent, "resource"));
 
-  httpClose(http);
+  if (http != data->http)
+    httpReleaseConnection(http);
 
   if (cupsGetError() >= IPP_STATUS_ERROR_BAD_REQUEST)
   {
@@ -3928,7 +4769,12 @@ parse_monitor_printer_state(
 	  data->last_expect->with_flags |= IPPTOOL_WITH_REGEX;
 
 	  if (data->last_expect->with_value)
+	  {
 	    memcpy(data->last_expect->with_value, value + 1, (size_t)(ptr - value - 1));
+
+	    if (!compile_with_regex(data, data->last_expect))
+	      return (false);
+	  }
 	}
 	else
 	{
@@ -4088,6 +4934,7 @@ print_attr(cups_file_t      *outfile,	// I  - Output file
   size_t		i,		// Looping var
 			count;		// Number of values
   ipp_attribute_t	*colattr;	// Collection attribute
+  char			datestr[32];	// ISO 8601 date/time string
 
 
   if (output == IPPTOOL_OUTPUT_PLIST)
@@ -4147,7 +4994,7 @@ print_attr(cups_file_t      *outfile,	// I  - Output file
 
       case IPP_TAG_DATE :
 	  for (i = 0; i < count; i ++)
-	    cupsFilePrintf(outfile, "<date>%s</date>\n", iso_date(ippGetDate(attr, i)));
+	    cupsFilePrintf(outfile, "<date>%s</date>\n", iso_date(ippGetDate(attr, i), datestr, sizeof(datestr)));
 	  break;
 
       case IPP_TAG_STRING :
@@ -4215,14 +5062,10 @@ print_attr(cups_file_t      *outfile,	// I  - Output file
   else
   {
     size_t		attrsize;	// Size of current attribute
-    static char		*buffer = NULL;	// Value buffer
-    static size_t	bufsize = 0;	// Current size of value buffer
-
-    if (!buffer)
-    {
-      bufsize = 65536;
-      buffer  = malloc(bufsize);
-    }
+    char		temp[8192],	// Temporary value buffer
+			*buffer = temp;	// Value buffer
+    size_t		bufsize = sizeof(temp);
+					// Current size of value buffer
 
     if (output == IPPTOOL_OUTPUT_TEST)
     {
@@ -4237,20 +5080,23 @@ print_attr(cups_file_t      *outfile,	// I  - Output file
 
     if ((attrsize = ippAttributeString(attr, buffer, bufsize)) >= bufsize)
     {
-      // Expand attribute value buffer...
-      char *temp = realloc(buffer, attrsize + 1);
+      // Use a larger attribute value buffer...
+      char *large = malloc(attrsize + 1);
 					// New buffer pointer
 
-      if (temp)
+      if (large)
       {
-        buffer  = temp;
+        buffer  = large;
         bufsize = attrsize + 1;
 
 	ippAttributeString(attr, buffer, bufsize);
       }
-
     }
+
     cupsFilePrintf(outfile, "%s\n", buffer);
+
+    if (buffer != temp)
+      free(buffer);
   }
 }
 
@@ -4316,13 +5162,21 @@ print_csv(
 
       if (strchr(values[i], ',') != NULL || strchr(values[i], '\"') != NULL || strchr(values[i], '\\') != NULL)
       {
-        // Quoted value...
+        // Quoted value, write runs of characters between the ones that need
+        // escaping...
+        size_t	len;			// Length of run
+
         cupsFilePutChar(data->outfile, '\"');
-        for (valptr = values[i]; *valptr; valptr ++)
+        for (valptr = values[i]; *valptr; valptr += len)
         {
-          if (*valptr == '\\' || *valptr == '\"')
+          if ((len = strcspn(valptr, "\\\"")) > 0)
+            cupsFileWrite(data->outfile, valptr, len);
+
+          if (valptr[len])
+          {
             cupsFilePutChar(data->outfile, '\\');
-          cupsFilePutChar(data->outfile, *valptr);
+            cupsFilePutChar(data->outfile, valptr[len ++]);
+          }
         }
         cupsFilePutChar(data->outfile, '\"');
       }
@@ -4397,6 +5251,7 @@ print_ippserver_attr(
 			count = ippGetCount(attr);
 					// Number of values
   ipp_attribute_t	*colattr;	// Collection attribute
+  char			datestr[32];	// ISO 8601 date/time string
 
 
   if (indent == 0)
@@ -4440,7 +5295,7 @@ print_ippserver_attr(
 
     case IPP_TAG_DATE :
 	for (i = 0; i < count; i ++)
-	  cupsFilePrintf(data->outfile, "%s%s", i ? "," : " ", iso_date(ippGetDate(attr, i)));
+	  cupsFilePrintf(data->outfile, "%s%s", i ? "," : " ", iso_date(ippGetDate(attr, i), datestr, sizeof(datestr)));
 	break;
 
     case IPP_TAG_STRING :
@@ -4504,16 +5359,26 @@ print_ippserver_string(
     const char     *s,			// I - String to print
     size_t         len)			// I - Length of string
 {
+  const char	*start,			// Start of current run
+		*end = s + len;		// End of string
+
+
+  // Write runs of characters between the ones that need escaping...
   cupsFilePutChar(data->outfile, '\"');
-  while (len > 0)
+  for (start = s; s < end; s ++)
   {
-    if (*s == '\"' || *s == '\\')
-      cupsFilePutChar(data->outfile, '\\');
-    cupsFilePutChar(data->outfile, *s);
+    if (*s != '\"' && *s != '\\')
+      continue;
+
+    if (s > start)
+      cupsFileWrite(data->outfile, start, (size_t)(s - start));
 
-    s ++;
-    len --;
+    cupsFilePutChar(data->outfile, '\\');
+    start = s;
   }
+
+  if (s > start)
+    cupsFileWrite(data->outfile, start, (size_t)(s - start));
   cupsFilePutChar(data->outfile, '\"');
 }
 
@@ -4534,6 +5399,7 @@ print_json_attr(
 		count = ippGetCount(attr);
 					// Number of values
   ipp_attribute_t *colattr;		// Collection attribute
+  char		datestr[32];		// ISO 8601 date/time string
 
 
   cupsFilePrintf(data->outfile, "%*s", indent, "");
@@ -4615,13 +5481,13 @@ print_json_attr(
     case IPP_TAG_DATE :
         if (count == 1)
         {
-	  cupsFilePrintf(data->outfile, ": \"%s\"", iso_date(ippGetDate(attr, 0)));
+	  cupsFilePrintf(data->outfile, ": \"%s\"", iso_date(ippGetDate(attr, 0), datestr, sizeof(datestr)));
         }
         else
         {
           cupsFilePuts(data->outfile, ": [\n");
 	  for (i = 0; i < count; i ++)
-	    cupsFilePrintf(data->outfile, "%*s\"%s\"%s", indent + 4, "", iso_date(ippGetDate(attr, i)), (i + 1) < count ? ",\n" : "\n");
+	    cupsFilePrintf(data->outfile, "%*s\"%s\"%s", indent + 4, "", iso_date(ippGetDate(attr, i), datestr, sizeof(datestr)), (i + 1) < count ? ",\n" : "\n");
           cupsFilePrintf(data->outfile, "%*s]", indent, "");
 	}
 	break;
@@ -4746,40 +5612,53 @@ print_json_string(
     const char     *s,			// I - String to print
     size_t         len)			// I - Length of string
 {
+  const char	*start,			// Start of current run
+		*end = s + len;		// End of string
+  char		temp[8];		// Escaped character
+
+
+  // Write runs of characters between the ones that need escaping...
   cupsFilePutChar(data->outfile, '\"');
-  while (len > 0)
+  for (start = s; s < end; s ++)
   {
     switch (*s)
     {
       case '\"' :
       case '\\' :
-          cupsFilePutChar(data->outfile, '\\');
-	  cupsFilePutChar(data->outfile, *s);
+          temp[0] = '\\';
+          temp[1] = *s;
+          temp[2] = '\0';
 	  break;
 
       case '\n' :
-	  cupsFilePuts(data->outfile, "\\n");
+          cupsCopyString(temp, "\\n", sizeof(temp));
 	  break;
 
       case '\r' :
-	  cupsFilePuts(data->outfile, "\\r");
+          cupsCopyString(temp, "\\r", sizeof(temp));
 	  break;
 
       case '\t' :
-	  cupsFilePuts(data->outfile, "\\t");
+          cupsCopyString(temp, "\\t", sizeof(temp));
 	  break;
 
       default :
-          if (*s < ' ' && *s >= 0)
-            cupsFilePrintf(data->outfile, "\\%03o", *s);
-          else
-	    cupsFilePutChar(data->outfile, *s);
+          if (*s >= ' ' || *s < 0)
+            continue;
+
+          snprintf(temp, sizeof(temp), "\\u%04x", *s);
 	  break;
     }
 
-    s ++;
-    len --;
+    if (s > start)
+      cupsFileWrite(data->outfile, start, (size_t)(s - start));
+
+    cupsFilePuts(data->outfile, temp);
+    start = s + 1;
   }
+
+  if (s > start)
+    cupsFileWrite(data->outfile, start, (size_t)(s - start));
   cupsFilePutChar(data->outfile, '\"');
 }
 
@@ -4880,6 +5759,112 @@ print_line(
 }
 
 
+//
+// 'print_load_report()' - Print the throughput and latencies for a load test.
+//
+
+static void
+print_load_report(
+    ipptool_test_t   *data,		// I - Test data
+    ipptool_target_t *target,		// I - Test target
+    size_t           jobs,		// I - Number of connections
+    double           elapsed)		// I - Elapsed time in seconds
+{
+  ipptool_stat_t	*stat;		// Current operation statistics
+  double		rate,		// Requests per second
+			p50,		// 50th percentile latency in milliseconds
+			p90,		// 90th percentile latency in milliseconds
+			p99,		// 99th percentile latency in milliseconds
+			pmax;		// Maximum latency in milliseconds
+  char			temp[5][64];	// Formatted numbers
+
+
+  if (elapsed <= 0.0)
+    elapsed = 0.000001;
+
+  // Sort the latencies for the percentiles...
+  for (stat = (ipptool_stat_t *)cupsArrayGetFirst(target->stats); stat; stat = (ipptool_stat_t *)cupsArrayGetNext(target->stats))
+    qsort(stat->latencies, stat->count, sizeof(double), (int (*)(const void *, const void *))compare_latencies);
+
+#define PERCENTILE(s,p)	(1000.0 * (s)->latencies[((s)->count * (p) + 99) / 100 - 1])
+
+  if (data->output == IPPTOOL_OUTPUT_JSON)
+  {
+    cupsFilePuts(data->outfile, "{\n    \"uri\": ");
+    print_json_string(data, target->uri, strlen(target->uri));
+    cupsFilePuts(data->outfile, ",\n    \"file\": ");
+    print_json_string(data, target->testfile, strlen(target->testfile));
+    cupsFilePrintf(data->outfile, ",\n    \"connections\": %u,\n    \"runs\": %u,\n    \"elapsed\": %s,\n    \"runs-per-second\": %s,\n    \"operations\": [", (unsigned)jobs, (unsigned)target->load_runs, get_real(elapsed, temp[0], sizeof(temp[0])), get_real(target->load_runs / elapsed, temp[1], sizeof(temp[1])));
+
+    for (stat = (ipptool_stat_t *)cupsArrayGetFirst(target->stats); stat; stat = (ipptool_stat_t *)cupsArrayGetNext(target->stats))
+    {
+      cupsFilePrintf(data->outfile, "%s\n        {\n            \"operation\": \"%s\",\n            \"requests\": %u,\n            \"errors\": %u,\n            \"requests-per-second\": %s,\n", stat == cupsArrayGetFirst(target->stats) ? "" : ",", ippOpString(stat->op), (unsigned)stat->count, (unsigned)stat->errors, get_real(stat->count / elapsed, temp[0], sizeof(temp[0])));
+      cupsFilePrintf(data->outfile, "            \"latency-p50\": %s,\n            \"latency-p90\": %s,\n            \"latency-p99\": %s,\n            \"latency-max\": %s\n        }", get_real(PERCENTILE(stat, 50), temp[1], sizeof(temp[1])), get_real(PERCENTILE(stat, 90), temp[2], sizeof(temp[2])), get_real(PERCENTILE(stat, 99), temp[3], sizeof(temp[3])), get_real(PERCENTILE(stat, 100), temp[4], sizeof(temp[4])));
+    }
+
+    cupsFilePuts(data->outfile, "\n    ]\n}");
+    return;
+  }
+  else if (data->output == IPPTOOL_OUTPUT_PLIST)
+  {
+    cupsFilePuts(data->outfile, "<dict>\n");
+    cupsFilePuts(data->outfile, "<key>Name</key>\n");
+    print_xml_string(data->outfile, "string", target->testfile);
+    cupsFilePuts(data->outfile, "<key>URI</key>\n");
+    print_xml_string(data->outfile, "string", target->uri);
+    cupsFilePrintf(data->outfile, "<key>Connections</key>\n<integer>%u</integer>\n", (unsigned)jobs);
+    cupsFilePrintf(data->outfile, "<key>Runs</key>\n<integer>%u</integer>\n", (unsigned)target->load_runs);
+    cupsFilePrintf(data->outfile, "<key>Elapsed</key>\n<real>%s</real>\n", get_real(elapsed, temp[0], sizeof(temp[0])));
+    cupsFilePrintf(data->outfile, "<key>RunsPerSecond</key>\n<real>%s</real>\n", get_real(target->load_runs / elapsed, temp[0], sizeof(temp[0])));
+    cupsFilePuts(data->outfile, "<key>Operations</key>\n");
+    cupsFilePuts(data->outfile, "<array>\n");
+
+    for (stat = (ipptool_stat_t *)cupsArrayGetFirst(target->stats); stat; stat = (ipptool_stat_t *)cupsArrayGetNext(target->stats))
+    {
+      cupsFilePuts(data->outfile, "<dict>\n");
+      cupsFilePuts(data->outfile, "<key>Operation</key>\n");
+      print_xml_string(data->outfile, "string", ippOpString(stat->op));
+      cupsFilePrintf(data->outfile, "<key>Requests</key>\n<integer>%u</integer>\n", (unsigned)stat->count);
+      cupsFilePrintf(data->outfile, "<key>Errors</key>\n<integer>%u</integer>\n", (unsigned)stat->errors);
+      cupsFilePrintf(data->outfile, "<key>RequestsPerSecond</key>\n<real>%s</real>\n", get_real(stat->count / elapsed, temp[0], sizeof(temp[0])));
+      cupsFilePrintf(data->outfile, "<key>LatencyP50</key>\n<real>%s</real>\n", get_real(PERCENTILE(stat, 50), temp[0], sizeof(temp[0])));
+      cupsFilePrintf(data->outfile, "<key>LatencyP90</key>\n<real>%s</real>\n", get_real(PERCENTILE(stat, 90), temp[0], sizeof(temp[0])));
+      cupsFilePrintf(data->outfile, "<key>LatencyP99</key>\n<real>%s</real>\n", get_real(PERCENTILE(stat, 99), temp[0], sizeof(temp[0])));
+      cupsFilePrintf(data->outfile, "<key>LatencyMax</key>\n<real>%s</real>\n", get_real(PERCENTILE(stat, 100), temp[0], sizeof(temp[0])));
+      cupsFilePuts(data->outfile, "</dict>\n");
+    }
+
+    cupsFilePuts(data->outfile, "</array>\n");
+    cupsFilePuts(data->outfile, "</dict>\n");
+
+    if (data->outfile == data->stdfile)
+      return;
+  }
+  else if (data->output == IPPTOOL_OUTPUT_QUIET)
+  {
+    return;
+  }
+
+  // Show a plain text report...
+  cupsFilePrintf(data->stdfile, "\"%s\" (%s):\n", target->testfile, target->uri);
+  cupsFilePrintf(data->stdfile, "    %u runs in %.3f seconds using %u connection(s), %.1f runs/second\n", (unsigned)target->load_runs, elapsed, (unsigned)jobs, target->load_runs / elapsed);
+  cupsFilePrintf(data->stdfile, "    %-32s %8s %7s %9s %8s %8s %8s %8s\n", "Operation", "Requests", "Errors", "Req/sec", "p50 ms", "p90 ms", "p99 ms", "max ms");
+
+  for (stat = (ipptool_stat_t *)cupsArrayGetFirst(target->stats); stat; stat = (ipptool_stat_t *)cupsArrayGetNext(target->stats))
+  {
+    rate = stat->count / elapsed;
+    p50  = PERCENTILE(stat, 50);
+    p90  = PERCENTILE(stat, 90);
+    p99  = PERCENTILE(stat, 99);
+    pmax = PERCENTILE(stat, 100);
+
+    cupsFilePrintf(data->stdfile, "    %-32s %8u %7u %9.1f %8.3f %8.3f %8.3f %8.3f\n", ippOpString(stat->op), (unsigned)stat->count, (unsigned)stat->errors, rate, p50, p90, p99, pmax);
+  }
+
+#undef PERCENTILE
+}
+
+
 //
 // 'print_xml_header()' - Print a standard XML plist header.
 //
@@ -4914,81 +5899,66 @@ print_xml_string(cups_file_t *outfile,	// I - Test data
 		 const char  *element,	// I - Element name or NULL
 		 const char  *s)	// I - String to print
 {
+  const char	*start,			// Start of current run
+		*repl;			// Replacement text
+
+
   if (element)
     cupsFilePrintf(outfile, "<%s>", element);
 
-  while (*s)
+  // Write runs of valid characters between the ones that need replacing...
+  for (start = s; *s; s ++)
   {
     if (*s == '&')
     {
-      cupsFilePuts(outfile, "&amp;");
+      repl = "&amp;";
     }
     else if (*s == '<')
     {
-      cupsFilePuts(outfile, "&lt;");
+      repl = "&lt;";
     }
     else if (*s == '>')
     {
-      cupsFilePuts(outfile, "&gt;");
+      repl = "&gt;";
     }
-    else if ((*s & 0xe0) == 0xc0)
+    else if ((*s & 0xe0) == 0xc0 && (s[1] & 0xc0) == 0x80)
     {
-      // Validate UTF-8 two-byte sequence...
-      if ((s[1] & 0xc0) != 0x80)
-      {
-        cupsFilePutChar(outfile, '?');
-        s ++;
-      }
-      else
-      {
-        cupsFilePutChar(outfile, *s++);
-        cupsFilePutChar(outfile, *s);
-      }
+      // Valid UTF-8 two-byte sequence...
+      s += 1;
+      continue;
     }
-    else if ((*s & 0xf0) == 0xe0)
+    else if ((*s & 0xf0) == 0xe0 && (s[1] & 0xc0) == 0x80 && (s[2] & 0xc0) == 0x80)
     {
-      // Validate UTF-8 three-byte sequence...
-      if ((s[1] & 0xc0) != 0x80 || (s[2] & 0xc0) != 0x80)
-      {
-        cupsFilePutChar(outfile, '?');
-        s += 2;
-      }
-      else
-      {
-        cupsFilePutChar(outfile, *s++);
-        cupsFilePutChar(outfile, *s++);
-        cupsFilePutChar(outfile, *s);
-      }
+      // Valid UTF-8 three-byte sequence...
+      s += 2;
+      continue;
     }
-    else if ((*s & 0xf8) == 0xf0)
+    else if ((*s & 0xf8) == 0xf0 && (s[1] & 0xc0) == 0x80 && (s[2] & 0xc0) == 0x80 && (s[3] & 0xc0) == 0x80)
     {
-      // Validate UTF-8 four-byte sequence...
-      if ((s[1] & 0xc0) != 0x80 || (s[2] & 0xc0) != 0x80 || (s[3] & 0xc0) != 0x80)
-      {
-        cupsFilePutChar(outfile, '?');
-        s += 3;
-      }
-      else
-      {
-        cupsFilePutChar(outfile, *s++);
-        cupsFilePutChar(outfile, *s++);
-        cupsFilePutChar(outfile, *s++);
-        cupsFilePutChar(outfile, *s);
-      }
+      // Valid UTF-8 four-byte sequence...
+      s += 3;
+      continue;
     }
     else if ((*s & 0x80) || (*s < ' ' && !isspace(*s & 255)))
     {
-      // Invalid control character...
-      cupsFilePutChar(outfile, '?');
+      // Invalid UTF-8 or control character...
+      repl = "?";
     }
     else
     {
-      cupsFilePutChar(outfile, *s);
+      continue;
     }
 
-    s ++;
+    if (s > start)
+      cupsFileWrite(outfile, start, (size_t)(s - start));
+
+    cupsFilePuts(outfile, repl);
+    start = s + 1;
   }
 
+  if (s > start)
+    cupsFileWrite(outfile, start, (size_t)(s - start));
+
   if (element)
     cupsFilePrintf(outfile, "</%s>\n", element);
 }
@@ -5022,6 +5992,280 @@ print_xml_trailer(
 }
 
 
+//
+// 'run_load()' - Repeatedly run a test file for a load test.
+//
+// Each worker uses its own connection and runs the test file until the run
+// count or time limit for the target is reached.
+//
+
+static void *				// O - Thread exit status
+run_load(ipptool_target_t *target)	// I - Test target
+{
+  ipptool_test_t	*data;		// Test data for this worker
+  ipptool_stat_t	*stat;		// Current operation statistics
+  size_t		i;		// Looping var
+
+
+  if ((data = alloc_target_data(target)) == NULL)
+    return (NULL);
+
+  data->output = IPPTOOL_OUTPUT_QUIET;
+  data->stats  = cupsArrayNew((cups_array_cb_t)compare_stats, NULL, NULL, 0, NULL, (cups_afree_cb_t)free_stat);
+  data->http   = connect_printer(data);
+
+  // Run the test file until we are done...
+  for (;;)
+  {
+    cupsMutexLock(&target->mutex);
+
+    if (Cancel || (target->load_count && target->load_runs >= target->load_count) || (!target->load_count && get_time() >= target->load_end))
+    {
+      cupsMutexUnlock(&target->mutex);
+      break;
+    }
+
+    target->load_runs ++;
+
+    cupsMutexUnlock(&target->mutex);
+
+    do_tests(target->testfile, data);
+  }
+
+  // Merge the results...
+  cupsMutexLock(&target->mutex);
+
+  for (stat = (ipptool_stat_t *)cupsArrayGetFirst(data->stats); stat; stat = (ipptool_stat_t *)cupsArrayGetNext(data->stats))
+  {
+    for (i = 0; i < stat->count; i ++)
+      add_stat(target->stats, stat->op, stat->latencies[i], i < stat->errors);
+  }
+
+  if (!data->pass)
+    target->pass = false;
+
+  target->test_count += data->test_count;
+  target->pass_count += data->pass_count;
+  target->fail_count += data->fail_count;
+  target->skip_count += data->skip_count;
+
+  cupsMutexUnlock(&target->mutex);
+
+  // Clean up and return...
+  httpReleaseConnection(data->http);
+  data->http = NULL;
+
+  cupsArrayDelete(data->stats);
+  free_data(data);
+
+  return (NULL);
+}
+
+
+//
+// 'run_loads()' - Run load tests and show the results.
+//
+// The test files are run one after another, each using "jobs" connections.
+//
+
+static bool				// O - `true` if all tests passed, `false` otherwise
+run_loads(ipptool_test_t *data,		// I - Test data
+          cups_array_t   *targets,	// I - Test targets
+          size_t         jobs,		// I - Number of connections
+          size_t         load_count,	// I - Number of runs or `0` for a time limit
+          double         load_time)	// I - Number of seconds
+{
+  bool			ret = true;	// Return value
+  cups_thread_pool_t	*pool;		// Pool of test threads
+  ipptool_target_t	*target;	// Current target
+  size_t		i;		// Looping var
+  double		start;		// Start time
+
+
+  if (data->output == IPPTOOL_OUTPUT_JSON)
+    cupsFilePuts(data->outfile, "[\n");
+  else if (data->output == IPPTOOL_OUTPUT_PLIST)
+    print_xml_header(data);
+
+  for (target = (ipptool_target_t *)cupsArrayGetFirst(targets); target && !Cancel; target = (ipptool_target_t *)cupsArrayGetNext(targets))
+  {
+    // Start the workers and wait for them to finish...
+    if ((pool = cupsThreadPoolNew(jobs, 0)) == NULL)
+    {
+      cupsLangPrintf(stderr, _("%s: Unable to create test threads: %s"), "ipptool", strerror(errno));
+      return (false);
+    }
+
+    cupsMutexInit(&target->mutex);
+
+    target->pass       = true;
+    target->load_count = load_count;
+    target->stats      = cupsArrayNew((cups_array_cb_t)compare_stats, NULL, NULL, 0, NULL, (cups_afree_cb_t)free_stat);
+    start              = get_time();
+    target->load_end   = start + load_time;
+
+    for (i = 0; i < jobs; i ++)
+    {
+      if (!cupsThreadPoolAdd(pool, (cups_thread_func_t)run_load, target))
+        break;
+    }
+
+    cupsThreadPoolDelete(pool);
+
+    // Show the results...
+    if (data->output == IPPTOOL_OUTPUT_JSON && target != cupsArrayGetFirst(targets))
+      cupsFilePuts(data->outfile, ",\n");
+
+    print_load_report(data, target, jobs, get_time() - start);
+
+    if (!target->pass)
+      ret = false;
+
+    data->test_count += target->test_count;
+    data->pass_count += target->pass_count;
+    data->fail_count += target->fail_count;
+    data->skip_count += target->skip_count;
+
+    cupsArrayDelete(target->stats);
+    target->stats = NULL;
+
+    cupsMutexDestroy(&target->mutex);
+  }
+
+  if (data->output == IPPTOOL_OUTPUT_JSON)
+    cupsFilePuts(data->outfile, "\n]\n");
+  else if (data->output == IPPTOOL_OUTPUT_PLIST)
+    print_xml_trailer(data, ret, NULL);
+
+  cupsFileFlush(data->outfile);
+
+  return (ret);
+}
+
+
+//
+// 'run_target()' - Run a test file for a parallel test target.
+//
+// The standard output is buffered in a temporary file so that "run_targets()"
+// can show the results in command-line order.
+//
+
+static void *				// O - Thread exit status
+run_target(ipptool_target_t *target)	// I - Test target
+{
+  ipptool_test_t	*data;		// Test data for this target
+
+
+  if ((data = alloc_target_data(target)) == NULL)
+    return (NULL);
+
+  // Open the output files...
+  if ((data->stdfile = cupsCreateTempFile("ipptool", NULL, target->tempname, sizeof(target->tempname))) == NULL)
+  {
+    cupsLangPrintf(stderr, _("%s: Unable to create temporary file: %s"), "ipptool", strerror(errno));
+    target->tempname[0] = '\0';
+    goto done;
+  }
+
+  if (!target->outname[0])
+  {
+    data->outfile = data->stdfile;
+  }
+  else if ((data->outfile = cupsFileOpen(target->outname, "w")) == NULL)
+  {
+    cupsLangPrintf(stderr, _("%s: Unable to open '%s': %s"), "ipptool", target->outname, strerror(errno));
+    goto done;
+  }
+
+  // Run the tests...
+  target->pass = do_tests(target->testfile, data);
+
+  if (data->output == IPPTOOL_OUTPUT_PLIST)
+    print_xml_trailer(data, target->pass, NULL);
+
+  target->test_count = data->test_count;
+  target->pass_count = data->pass_count;
+  target->fail_count = data->fail_count;
+  target->skip_count = data->skip_count;
+
+  // Clean up and return...
+  done:
+
+  if (data->outfile && data->outfile != data->stdfile && data->outfile != cupsFileStdout())
+    cupsFileClose(data->outfile);
+
+  if (data->stdfile && data->stdfile != cupsFileStdout())
+    cupsFileClose(data->stdfile);
+
+  free_data(data);
+
+  return (NULL);
+}
+
+
+//
+// 'run_targets()' - Run test files in parallel and show the results.
+//
+
+static bool				// O - `true` if all tests passed, `false` otherwise
+run_targets(ipptool_test_t *data,	// I - Test data
+            cups_array_t   *targets,	// I - Test targets
+            size_t         jobs)	// I - Number of parallel tests
+{
+  bool			ret = true;	// Return value
+  cups_thread_pool_t	*pool;		// Pool of test threads
+  ipptool_target_t	*target;	// Current target
+  cups_file_t		*fp;		// Standard output buffer file
+  char			buffer[8192];	// Copy buffer
+  ssize_t		bytes;		// Bytes read
+
+
+  // Run the test files and wait for them to finish...
+  if ((pool = cupsThreadPoolNew(jobs, 0)) == NULL)
+  {
+    cupsLangPrintf(stderr, _("%s: Unable to create test threads: %s"), "ipptool", strerror(errno));
+    return (false);
+  }
+
+  for (target = (ipptool_target_t *)cupsArrayGetFirst(targets); target; target = (ipptool_target_t *)cupsArrayGetNext(targets))
+  {
+    if (!cupsThreadPoolAdd(pool, (cups_thread_func_t)run_target, target))
+      run_target(target);
+  }
+
+  cupsThreadPoolDelete(pool);
+
+  // Show the output and tally the results in command-line order...
+  for (target = (ipptool_target_t *)cupsArrayGetFirst(targets); target; target = (ipptool_target_t *)cupsArrayGetNext(targets))
+  {
+    if (target->tempname[0])
+    {
+      if ((fp = cupsFileOpen(target->tempname, "r")) != NULL)
+      {
+        while ((bytes = cupsFileRead(fp, buffer, sizeof(buffer))) > 0)
+          cupsFileWrite(cupsFileStdout(), buffer, (size_t)bytes);
+
+        cupsFileClose(fp);
+      }
+
+      unlink(target->tempname);
+    }
+
+    if (!target->pass)
+      ret = false;
+
+    data->test_count += target->test_count;
+    data->pass_count += target->pass_count;
+    data->fail_count += target->fail_count;
+    data->skip_count += target->skip_count;
+  }
+
+  cupsFileFlush(cupsFileStdout());
+
+  return (ret);
+}
+
+
 #ifndef _WIN32
 //
 // 'sigterm_handler()' - Handle SIGINT and SIGTERM.
@@ -5086,7 +6330,8 @@ token_cb(ipp_file_t     *f,		// I - IPP file data
   char	name[1024],			// Name string
 	temp[1024],			// Temporary string
 	value[1024],			// Value string
-	*ptr;				// Pointer into value
+	*ptr,				// Pointer into value
+	datestr[32];			// ISO 8601 date/time string
 
 
   if (getenv("IPPTOOL_DEBUG"))
@@ -5170,10 +6415,19 @@ token_cb(ipp_file_t     *f,		// I - IPP file data
       // COMPRESSION none
       // COMPRESSION deflate
       // COMPRESSION gzip
+      // COMPRESSION br
+      // COMPRESSION zstd
       if (ippFileReadToken(f, temp, sizeof(temp)))
       {
 	ippFileExpandVars(f, data->compression, temp, sizeof(data->compression));
-	if (strcmp(data->compression, "none") && strcmp(data->compression, "deflate") && strcmp(data->compression, "gzip"))
+	if (strcmp(data->compression, "none") && strcmp(data->compression, "deflate") && strcmp(data->compression, "gzip")
+#ifdef HAVE_BROTLI
+	    && strcmp(data->compression, "br")
+#endif // HAVE_BROTLI
+#ifdef HAVE_ZSTD
+	    && strcmp(data->compression, "zstd")
+#endif // HAVE_ZSTD
+	    )
 	{
 	  print_fatal_error(data, "Unsupported COMPRESSION value \"%s\" on line %d of '%s'.", data->compression, ippFileGetLineNumber(f), ippFileGetFilename(f));
 	  return (false);
@@ -6030,7 +7284,12 @@ token_cb(ipp_file_t     *f,		// I - IPP file data
 	  data->last_expect->with_flags |= IPPTOOL_WITH_REGEX;
 
 	  if (data->last_expect->with_value)
+	  {
 	    memcpy(data->last_expect->with_value, value + 1, (size_t)(ptr - value - 1));
+
+	    if (!compile_with_regex(data, data->last_expect))
+	      return (false);
+	  }
 	}
 	else
 	{
@@ -6117,8 +7376,8 @@ token_cb(ipp_file_t     *f,		// I - IPP file data
 	if (data->output == IPPTOOL_OUTPUT_PLIST)
 	  print_xml_header(data);
 
-	if (data->output == IPPTOOL_OUTPUT_TEST || (data->output == IPPTOOL_OUTPUT_PLIST && data->outfile != cupsFileStdout()))
-	  cupsFilePrintf(cupsFileStdout(), "\"%s\":\n", ippFileGetFilename(f));
+	if (data->output == IPPTOOL_OUTPUT_TEST || (data->output == IPPTOOL_OUTPUT_PLIST && data->outfile != data->stdfile))
+	  cupsFilePrintf(data->stdfile, "\"%s\":\n", ippFileGetFilename(f));
 
 	data->show_header = false;
       }
@@ -6153,14 +7412,14 @@ token_cb(ipp_file_t     *f,		// I - IPP file data
       data->num_monitor_expects = 0;
 
       ippFileSetAttributes(f, ippNew());
-      ippFileSetVar(f, "date-current", iso_date(ippTimeToDate(time(NULL))));
+      ippFileSetVar(f, "date-current", iso_date(ippTimeToDate(time(NULL)), datestr, sizeof(datestr)));
     }
     else if (!strcmp(token, "DEFINE"))
     {
       // DEFINE name value
       if (ippFileReadToken(f, name, sizeof(name)) && ippFileReadToken(f, temp, sizeof(temp)))
       {
-        ippFileSetVar(f, "date-current", iso_date(ippTimeToDate(time(NULL))));
+        ippFileSetVar(f, "date-current", iso_date(ippTimeToDate(time(NULL)), datestr, sizeof(datestr)));
         ippFileExpandVars(f, value, temp, sizeof(value));
 	ippFileSetVar(f, name, value);
       }
@@ -6177,7 +7436,7 @@ token_cb(ipp_file_t     *f,		// I - IPP file data
       {
         if (!ippFileGetVar(f, name))
         {
-          ippFileSetVar(f, "date-current", iso_date(ippTimeToDate(time(NULL))));
+          ippFileSetVar(f, "date-current", iso_date(ippTimeToDate(time(NULL)), datestr, sizeof(datestr)));
 	  ippFileExpandVars(f, value, temp, sizeof(value));
 	  ippFileSetVar(f, name, value);
 	}
@@ -6193,7 +7452,7 @@ token_cb(ipp_file_t     *f,		// I - IPP file data
       // FILE-ID "string"
       if (ippFileReadToken(f, temp, sizeof(temp)))
       {
-        ippFileSetVar(f, "date-current", iso_date(ippTimeToDate(time(NULL))));
+        ippFileSetVar(f, "date-current", iso_date(ippTimeToDate(time(NULL)), datestr, sizeof(datestr)));
         ippFileExpandVars(f, data->file_id, temp, sizeof(data->file_id));
       }
       else
@@ -6232,7 +7491,6 @@ token_cb(ipp_file_t     *f,		// I - IPP file data
         inc_data.pass_count  = 0;
         inc_data.fail_count  = 0;
         inc_data.skip_count  = 0;
-        inc_data.http        = NULL;
 	inc_data.pass        = true;
 	inc_data.prev_pass   = true;
 	inc_data.show_header = true;
@@ -6274,7 +7532,6 @@ token_cb(ipp_file_t     *f,		// I - IPP file data
         inc_data.pass_count  = 0;
         inc_data.fail_count  = 0;
         inc_data.skip_count  = 0;
-        inc_data.http        = NULL;
 	inc_data.pass        = true;
 	inc_data.prev_pass   = true;
 	inc_data.show_header = true;
@@ -6316,7 +7573,6 @@ token_cb(ipp_file_t     *f,		// I - IPP file data
         inc_data.pass_count  = 0;
         inc_data.fail_count  = 0;
         inc_data.skip_count  = 0;
-        inc_data.http        = NULL;
 	inc_data.pass        = true;
 	inc_data.prev_pass   = true;
 	inc_data.show_header = true;
@@ -6457,6 +7713,9 @@ usage(FILE *out)
   cupsLangPuts(out, _("Options:"));
   cupsLangPuts(out, _("--help                         Show this help"));
   cupsLangPuts(out, _("--ippfile FILENAME             Produce IPP attribute file"));
+  cupsLangPuts(out, _("--jobs COUNT                   Run up to COUNT test files in parallel"));
+  cupsLangPuts(out, _("--load-count COUNT             Run each test file COUNT times and report latencies"));
+  cupsLangPuts(out, _("--load-time SECONDS            Run each test file for SECONDS and report latencies"));
   cupsLangPuts(out, _("--stop-after-include-error     Stop tests after a failed INCLUDE"));
   cupsLangPuts(out, _("--version                      Show the program version"));
   cupsLangPuts(out, _("-4                             Connect using IPv4"));
@@ -6671,7 +7930,7 @@ with_content(
 
     encryption = (!strcmp(scheme, "https") || !strcmp(scheme, "ipps") || port == 443) ? HTTP_ENCRYPTION_ALWAYS : HTTP_ENCRYPTION_IF_REQUESTED;
 
-    if ((http = httpConnect(host, port, NULL, AF_UNSPEC, encryption, 1, 30000, NULL)) == NULL)
+    if ((http = httpAcquireConnection(host, port, AF_UNSPEC, encryption, true, 30000, NULL)) == NULL)
     {
       add_stringf(errors, "Unable to connect to \"%s\" on port %d: %s", host, port, cupsGetErrorString());
       ret = false;
@@ -6823,7 +8082,7 @@ with_content(
 
     http_done:
 
-    httpClose(http);
+    httpReleaseConnection(http);
   }
 
   return (ret);
@@ -6995,6 +8254,7 @@ with_value(ipptool_test_t  *data,	// I - Test data
            cups_array_t    *errors,	// I - Errors array
            char            *value,	// I - Value string
            int             flags,	// I - Flags for match
+           const regex_t   *re,		// I - Compiled regular expression, if any
            ipp_attribute_t *attr,	// I - Attribute to compare
 	   char            *matchbuf,	// I - Buffer to hold matching value
 	   size_t          matchlen)	// I - Length of match buffer
@@ -7253,21 +8513,13 @@ with_value(ipptool_test_t  *data,	// I - Test data
         if (flags & IPPTOOL_WITH_REGEX)
 	{
 	  // Value is an extended, case-sensitive POSIX regular expression...
-          int		r;		// Error, if any
-	  regex_t	re;		// Regular expression
-
-          if ((r = regcomp(&re, value, REG_EXTENDED | REG_NOSUB)) != 0)
-	  {
-            regerror(r, &re, temp, sizeof(temp));
-
-	    print_fatal_error(data, "Unable to compile WITH-VALUE regular expression \"%s\" - %s", value, temp);
+	  if (!re)
 	    return (false);
-	  }
 
           // See if ALL of the values match the given regular expression.
 	  for (i = 0; i < count; i ++)
 	  {
-	    if (!regexec(&re, get_string(attr, i, flags, temp, sizeof(temp)),
+	    if (!regexec(re, get_string(attr, i, flags, temp, sizeof(temp)),
 	                 0, NULL, 0))
 	    {
 	      if (!matchbuf[0])
@@ -7285,8 +8537,6 @@ with_value(ipptool_test_t  *data,	// I - Test data
 	      break;
 	    }
 	  }
-
-	  regfree(&re);
 	}
 	else if (ippGetValueTag(attr) == IPP_TAG_URI && !(flags & (IPPTOOL_WITH_SCHEME | IPPTOOL_WITH_HOSTNAME | IPPTOOL_WITH_RESOURCE)))
 	{
@@ -7378,16 +8628,9 @@ with_value(ipptool_test_t  *data,	// I - Test data
 	  // Value is an extended, case-sensitive POSIX regular expression...
 	  void		*adata;		// Pointer to octetString data
 	  size_t	adatalen;	// Length of octetString
-	  int		r;		// Error, if any
-	  regex_t	re;		// Regular expression
 
-          if ((r = regcomp(&re, value, REG_EXTENDED | REG_NOSUB)) != 0)
-	  {
-            regerror(r, &re, temp, sizeof(temp));
-
-	    print_fatal_error(data, "Unable to compile WITH-VALUE regular expression \"%s\" - %s", value, temp);
+	  if (!re)
 	    return (false);
-	  }
 
           // See if ALL of the values match the given regular expression.
 	  for (i = 0; i < count; i ++)
@@ -7400,7 +8643,7 @@ with_value(ipptool_test_t  *data,	// I - Test data
             memcpy(temp, adata, (size_t)adatalen);
             temp[adatalen] = '\0';
 
-	    if (!regexec(&re, temp, 0, NULL, 0))
+	    if (!regexec(re, temp, 0, NULL, 0))
 	    {
 	      if (!matchbuf[0])
 		cupsCopyString(matchbuf, temp, matchlen);
@@ -7418,8 +8661,6 @@ with_value(ipptool_test_t  *data,	// I - Test data
 	    }
 	  }
 
-	  regfree(&re);
-
 	  if (!match && errors)
 	  {
 	    for (i = 0; i < count; i ++)
@@ -10,6 +10,7 @@
 //
 
 #include <cups/cups-private.h>
+#include <cups/json.h>
 #include <cups/raster.h>
 #include <cups/thread.h>
 #include "ipp-options.h"
@@ -25,17 +26,30 @@ extern void CGContextSetCTM(CGContextRef c, CGAffineTransform m);
 
 #include "dither.h"
 
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#  include <arm_neon.h>
+#  define XFORM_NEON 1
+#endif // __SSE2__
+
 #if _WIN32
 #  include <fcntl.h>
 #  include <io.h>
 #  include <process.h>
+#  include <sys/stat.h>
 #  define WEXITSTATUS(s) (s)
 #else
 extern char **environ;
 #  include <spawn.h>
 #  include <sys/fcntl.h>
+#  include <sys/resource.h>
+#  include <sys/stat.h>
 #  include <sys/wait.h>
 #endif // _WIN32
+#ifndef O_BINARY
+#  define O_BINARY 0
+#endif // !O_BINARY
 
 
 // Macros...
@@ -46,6 +60,11 @@ extern char **environ;
 #define XFORM_MAX_LAYOUT	16
 #define XFORM_MAX_PAGES		10000
 #define XFORM_MAX_RASTER	16777216
+#define XFORM_MAX_THREADS	64	// Maximum number of rendering threads
+#define XFORM_MAX_BUFFERED	268435456
+#define XFORM_MAX_CACHE		268435456
+					// Maximum bytes of page images to buffer
+#define XFORM_MONITOR_LEASE	300	// Printer subscription lease in seconds
 
 #define XFORM_TEXT_SIZE		10.0	// Point size of plain text output
 #define XFORM_TEXT_HEIGHT	12.0	// Point height of plain text output
@@ -132,6 +151,9 @@ struct xform_raster_s			// Raster context
   unsigned		out_blanks;	// Blank lines
   unsigned		out_length;	// Byte width of image box
   unsigned char		*comp_buffer;	// Compression buffer
+  unsigned char		*delta_buffer;	// Delta row compression buffer
+  unsigned char		*seed_buffer;	// Seed row for delta row compression
+  int			comp_mode;	// Current compression mode
 
   unsigned char		dither[64][64];	// Dither array
   unsigned char		white;		// White pixel value
@@ -144,6 +166,72 @@ struct xform_raster_s			// Raster context
   void			(*write_line)(xform_raster_t *, unsigned, const unsigned char *, xform_write_cb_t, void *);
 };
 
+#ifndef HAVE_COREGRAPHICS_H
+typedef struct xform_ppm_s		// PPM page image from pdftoppm or raster stream
+{
+  unsigned		page,		// Page number (0 if not yet rendered)
+			width,		// Width in pixels
+			height,		// Height in lines
+			bpp;		// Bytes per pixel
+  FILE			*fp;		// Pipe for streamed pixels
+  unsigned char		*pixels,	// Buffered pixels, if any
+			*pixptr,	// Next line in buffered pixels
+			*pixend;	// End of buffered pixels
+  cups_raster_t		*raster;	// Raster stream for streamed pixels
+  cups_page_header_t	rheader;	// Raster page header
+  unsigned		rcolors,	// Number of colors in raster page
+			rlines,		// Number of raster lines read
+			y;		// Current line in page image
+  unsigned char		*rbuffer;	// Raster line buffer
+} xform_ppm_t;
+
+typedef struct xform_ppmqueue_s		// Queue of pages rendered in parallel
+{
+  cups_mutex_t		mutex;		// Mutex for queue
+  cups_cond_t		cond;		// Condition for queue changes
+  xform_raster_t	*ras;		// Raster information
+  const char		*filename;	// PDF file
+  bool			poppler;	// Using Poppler's pdftoppm?
+  unsigned		num_pages,	// Number of pages
+			next_page,	// Next page to render
+			num_written,	// Number of pages written
+			depth;		// Number of page slots
+  bool			canceled;	// Stop rendering?
+  xform_ppm_t		*slots;		// Rendered pages
+} xform_ppmqueue_t;
+#endif // !HAVE_COREGRAPHICS_H
+
+typedef enum xform_stage_e		// Processing stages for statistics
+{
+  XFORM_STAGE_SETUP,			// Setup and everything else
+  XFORM_STAGE_PREPARE,			// Document preparation (PDFio)
+  XFORM_STAGE_RENDER,			// Page rendering or raster input
+  XFORM_STAGE_DITHER,			// Dithering and packing
+  XFORM_STAGE_COMPRESS,			// Compression and encoding
+  XFORM_STAGE_WRITE,			// Output I/O
+  XFORM_STAGE_MAX
+} xform_stage_t;
+
+typedef struct xform_stats_s		// Processing statistics
+{
+  bool			enabled,	// Collect statistics?
+			json;		// Report as JSON instead of ATTR: lines?
+  xform_stage_t		stage;		// Current stage
+  double		wall_start,	// Starting wall clock time
+			cpu_start,	// Starting CPU time
+			wall_last,	// Wall clock time of last stage change
+			cpu_last,	// CPU time of last stage change
+			wall[XFORM_STAGE_MAX],
+					// Wall clock time for each stage
+			cpu[XFORM_STAGE_MAX];
+					// CPU time for each stage
+  size_t		bytes_in,	// Bytes read
+			bytes_out;	// Bytes written
+  unsigned		pages;		// Pages produced
+  xform_write_cb_t	cb;		// Output write callback
+  void			*ctx;		// Output write context
+} xform_stats_t;
+
 
 // Local globals...
 static char		PdftopsCommand[1024] = "";
@@ -154,6 +242,7 @@ static char		PdftoppmCommand[1024] = "";
 #endif // !_HAVE_COREGRAPHICS_H
 static const char	*Prefix;	// Error message prefix (typically the command name or "ERROR" if running from ippeveprinter/ippserver
 static int		Verbosity = 0;	// Log level
+static xform_stats_t	Stats;		// Processing statistics
 
 
 // Local functions...
@@ -166,14 +255,19 @@ static bool	generate_job_error_sheet(xform_prepare_t *p);
 static bool	generate_job_sheets(xform_prepare_t *p);
 static void	media_to_rect(cups_media_t *size, pdfio_rect_t *media, pdfio_rect_t *crop);
 static void	*monitor_ipp(const char *device_uri);
+static int	monitor_subscribe(http_t *http, const char *device_uri, const char *resource, time_t *expire);
+static bool	monitor_timeout_cb(http_t *http, void *data);
+static bool	monitor_wait(http_t *http, const char *device_uri, const char *resource, int sub_id, int *sequence, time_t *expire);
 static void	pack_black(unsigned char *row, size_t num_pixels);
 #ifdef HAVE_COREGRAPHICS_H
 static void	pack_rgba(unsigned char *row, size_t num_pixels);
 static void	pack_rgba16(unsigned char *row, size_t num_pixels);
 #endif // HAVE_COREGRAPHICS_H
 static bool	page_dict_cb(pdfio_dict_t *dict, const char *key, xform_page_t *outpage);
+static size_t	pcl_delta_row(unsigned char *dst, size_t dstsize, const unsigned char *line, const unsigned char *seed, size_t length);
 static void	pcl_end_job(xform_raster_t *ras, xform_write_cb_t cb, void *ctx);
 static void	pcl_end_page(xform_raster_t *ras, unsigned page, xform_write_cb_t cb, void *ctx);
+static size_t	pcl_find_run(const unsigned char *line, const unsigned char *seed, size_t pos, size_t length, bool equal);
 static void	pcl_init(xform_raster_t *ras);
 static void	pcl_start_job(xform_raster_t *ras, xform_write_cb_t cb, void *ctx);
 static void	pcl_start_page(xform_raster_t *ras, unsigned page, xform_write_cb_t cb, void *ctx);
@@ -190,6 +284,16 @@ static void	pdfio_end_page(xform_prepare_t *p, pdfio_stream_t *st);
 static bool	pdfio_error_cb(pdfio_file_t *pdf, const char *message, void *cb_data);
 static const char *pdfio_password_cb(void *cb_data, const char *filename);
 static pdfio_stream_t *pdfio_start_page(xform_prepare_t *p, pdfio_dict_t *dict);
+#ifndef HAVE_COREGRAPHICS_H
+static void	ppm_command(char *command, size_t cmdsize, xform_raster_t *ras, const char *filename, bool poppler, unsigned page);
+static bool	ppm_read_header(FILE *fp, xform_ppm_t *ppm);
+static bool	ppm_read_line(xform_ppm_t *ppm, unsigned char *line);
+static bool	ppm_read_pixels(FILE *fp, xform_ppm_t *ppm);
+static int	ppm_read_raster(cups_raster_t *raster, xform_raster_t *ras, xform_ppm_t *ppm);
+static bool	ppm_render_page(xform_raster_t *ras, const char *filename, bool poppler, unsigned page, xform_ppm_t *ppm);
+static void	*ppm_thread(xform_ppmqueue_t *q);
+static bool	ppm_write_page(xform_raster_t *ras, xform_ppm_t *ppm, unsigned page, xform_write_cb_t cb, void *ctx);
+#endif // !HAVE_COREGRAPHICS_H
 static bool	prepare_documents(size_t num_documents, xform_document_t *documents, ipp_options_t *options, const char *sheet_back, char *outfile, size_t outsize, const char *outformat, unsigned *outpages, bool generate_copies);
 static void	prepare_log(xform_prepare_t *p, bool error, const char *message, ...);
 static void	prepare_number_up(xform_prepare_t *p);
@@ -201,11 +305,20 @@ static void	raster_start_job(xform_raster_t *ras, xform_write_cb_t cb, void *ctx
 static void	raster_start_page(xform_raster_t *ras, unsigned page, xform_write_cb_t cb, void *ctx);
 static void	raster_write_line(xform_raster_t *ras, unsigned y, const unsigned char *line, xform_write_cb_t cb, void *ctx);
 static bool	resource_dict_cb(pdfio_dict_t *dict, const char *key, xform_page_t *outpage);
+static void	stats_get_time(double *wall, double *cpu);
+static ssize_t	stats_read(int *fd, unsigned char *buffer, size_t bytes);
+static void	stats_report(void);
+static xform_stage_t stats_stage(xform_stage_t stage);
+static void	stats_start(const char *format);
+static ssize_t	stats_write(void *ctx, const void *buffer, size_t bytes);
 static int	usage(FILE *out);
 static ssize_t	write_fd(int *fd, const unsigned char *buffer, size_t bytes);
 static bool	xform_document(const char *filename, unsigned pages, ipp_options_t *options, const char *outformat, const char *resolutions, const char *sheet_back, const char *types, xform_write_cb_t cb, void *ctx);
 static bool	xform_separator(xform_raster_t *ras, xform_write_cb_t cb, void *ctx);
 static bool	xform_setup(xform_raster_t *ras, ipp_options_t *options, const char *outformat, const char *resolutions, const char *types, const char *sheet_back, bool color, unsigned pages);
+#ifndef HAVE_COREGRAPHICS_H
+static bool	xform_stream(size_t num_documents, xform_document_t *documents, ipp_options_t *options, const char *outformat, const char *resolutions, const char *sheet_back, const char *types, xform_write_cb_t cb, void *ctx);
+#endif // !HAVE_COREGRAPHICS_H
 
 
 //
@@ -223,7 +336,8 @@ main(int  argc,				// I - Number of command-line args
 		*sheet_back,		// pwg-raster-document-sheet-back
 		*types,			// pwg-raster-document-type-supported
 		*opt,			// Option character
-		*ext;			// Filename extension
+		*ext,			// Filename extension
+		*stats;			// Statistics format, if any
   size_t	num_files = 0;		// Number of files
   xform_document_t files[1000];		// Files to convert
   size_t	num_options = 0;	// Number of options
@@ -240,6 +354,7 @@ main(int  argc,				// I - Number of command-line args
 					// Write callback
   int		status = 0;		// Exit status
   cups_thread_t monitor = 0;		// Monitoring thread ID
+  size_t	num_raster = 0;		// Number of raster files
 
 
   // Process the command-line...
@@ -252,6 +367,7 @@ main(int  argc,				// I - Number of command-line args
   resolutions  = getenv("IPP_PWG_RASTER_DOCUMENT_RESOLUTION_SUPPORTED");
   sheet_back   = getenv("IPP_PWG_RASTER_DOCUMENT_SHEET_BACK");
   types        = getenv("IPP_PWG_RASTER_DOCUMENT_TYPE_SUPPORTED");
+  stats        = getenv("IPPTRANSFORM_STATS");
 
   if ((opt = getenv("SERVER_LOGLEVEL")) != NULL)
   {
@@ -289,6 +405,14 @@ main(int  argc,				// I - Number of command-line args
       {
         return (usage(stdout));
       }
+      else if (!strcmp(argv[i], "--stats"))
+      {
+        stats = "attr";
+      }
+      else if (!strcmp(argv[i], "--stats-json"))
+      {
+        stats = "json";
+      }
       else if (!strcmp(argv[i], "--version"))
       {
         puts(LIBCUPS_VERSION);
@@ -299,7 +423,7 @@ main(int  argc,				// I - Number of command-line args
 	return (usage(stderr));
       }
     }
-    else if (argv[i][0] == '-')
+    else if (argv[i][0] == '-' && argv[i][1])
     {
       for (opt = argv[i] + 1; *opt; opt ++)
       {
@@ -468,6 +592,12 @@ main(int  argc,				// I - Number of command-line args
 	cupsLangPrintf(stderr, _("%s: Unknown format for \"%s\", please specify with '-i' option."), Prefix, argv[i]);
 	return (usage(stderr));
       }
+#ifndef HAVE_COREGRAPHICS_H
+      else if (!strcmp(files[num_files].format, "image/pwg-raster") || !strcmp(files[num_files].format, "image/urf"))
+      {
+        num_raster ++;
+      }
+#endif // !HAVE_COREGRAPHICS_H
       else if (strcmp(files[num_files].format, "application/pdf") && strcmp(files[num_files].format, "image/jpeg") && strcmp(files[num_files].format, "image/png") && strcmp(files[num_files].format, "text/plain"))
       {
 	cupsLangPrintf(stderr, _("%s: Unsupported format '%s' for '%s'."), Prefix, files[num_files].format, argv[i]);
@@ -487,6 +617,20 @@ main(int  argc,				// I - Number of command-line args
   if (num_files == 0)
     return (usage(stderr));
 
+  if (stats && *stats)
+  {
+    // Collect processing statistics...
+    struct stat	fileinfo;		// Input file information
+
+    stats_start(stats);
+
+    for (i = 0; i < (int)num_files; i ++)
+    {
+      if (strcmp(files[i].filename, "-") && !stat(files[i].filename, &fileinfo))
+        Stats.bytes_in += (size_t)fileinfo.st_size;
+    }
+  }
+
   if (!output_type)
   {
     // See if we can default the output type from the (legacy) program name...
@@ -516,16 +660,29 @@ main(int  argc,				// I - Number of command-line args
     return (usage(stderr));
   }
 
-  // Prepare a (combined) PDF file from the input files for printing...
+  if (num_raster > 0 && (num_raster < num_files || !strcasecmp(output_type, "application/pdf")))
+  {
+    cupsLangPrintf(stderr, _("%s: Raster documents cannot be combined with other formats or converted to PDF."), Prefix);
+    return (1);
+  }
+
+  // Prepare a (combined) PDF file from the input files for printing - raster
+  // documents are streamed to the output instead...
   ipp_options = ippOptionsNew(num_options, options);
+  pdf_file[0] = '\0';
+  pdf_pages   = 0;
+
+  stats_stage(XFORM_STAGE_PREPARE);
 
-  if (!prepare_documents(num_files, files, ipp_options, sheet_back, pdf_file, sizeof(pdf_file), output_type, &pdf_pages, !strcasecmp(output_type, "application/pdf")))
+  if (!num_raster && !prepare_documents(num_files, files, ipp_options, sheet_back, pdf_file, sizeof(pdf_file), output_type, &pdf_pages, !strcasecmp(output_type, "application/pdf")))
   {
     // Unable to prepare documents, exit...
     ippOptionsDelete(ipp_options);
     return (1);
   }
 
+  stats_stage(XFORM_STAGE_SETUP);
+
   // If the device URI is specified, open the connection...
   if (device_uri)
   {
@@ -697,10 +854,20 @@ main(int  argc,				// I - Number of command-line args
     httpAddrFreeList(list);
   }
 
-  if (!strcasecmp(output_type, "application/postscript") && cupsFileFind("pdftops", getenv("PATH"), true, PdftopsCommand, sizeof(PdftopsCommand)))
+  if (Stats.enabled)
+  {
+    // Count and time the output...
+    Stats.cb  = write_cb;
+    Stats.ctx = write_ptr;
+    write_cb  = stats_write;
+    write_ptr = NULL;
+  }
+
+  if (!strcasecmp(output_type, "application/postscript") && pdf_file[0] && cupsFileFind("pdftops", getenv("PATH"), true, PdftopsCommand, sizeof(PdftopsCommand)))
   {
     // Do PostScript transform...
-    status = ps_convert_pdf(pdf_file, write_cb, write_ptr);
+    status      = ps_convert_pdf(pdf_file, write_cb, write_ptr);
+    Stats.pages = pdf_pages;
   }
   else if (strcasecmp(output_type, "application/pdf"))
   {
@@ -718,6 +885,14 @@ main(int  argc,				// I - Number of command-line args
     if (!types)
       types = "sgray_8";
 
+#ifndef HAVE_COREGRAPHICS_H
+    if (num_raster > 0)
+    {
+      if (!xform_stream(num_files, files, ipp_options, output_type, resolutions, sheet_back, types, write_cb, write_ptr))
+        status = 1;
+    }
+    else
+#endif // !HAVE_COREGRAPHICS_H
     if (!xform_document(pdf_file, pdf_pages, ipp_options, output_type, resolutions, sheet_back, types, write_cb, write_ptr))
       status = 1;
   }
@@ -747,6 +922,8 @@ main(int  argc,				// I - Number of command-line args
 
       cupsFileClose(fp);
     }
+
+    Stats.pages = pdf_pages;
   }
 
   ippOptionsDelete(ipp_options);
@@ -771,6 +948,9 @@ main(int  argc,				// I - Number of command-line args
   if (monitor)
     cupsThreadCancel(monitor);
 
+  if (Stats.enabled)
+    stats_report();
+
   return (status);
 }
 
@@ -1613,6 +1793,9 @@ copy_page(xform_prepare_t *p,		// I - Preparation data
 //
 // 'dither_gray()' - Dither grayscale pixels.
 //
+// Pixels are compared against the dither matrix 16 at a time using SSE2 or
+// NEON, producing two bytes of output per group.
+//
 
 static void
 dither_gray(xform_raster_t *ras,	// I - Raster info
@@ -1628,8 +1811,47 @@ dither_gray(xform_raster_t *ras,	// I - Raster info
 
 
   ditherline = ras->dither[y & 63];
+  x          = 0;
+  rowptr     = row;
+
+#ifdef __SSE2__
+  for (; (x + 16) <= num_pixels; x += 16, row += 16)
+  {
+    __m128i	pixels = _mm_loadu_si128((const __m128i *)row),
+					// 16 pixels
+		dither = _mm_loadu_si128((const __m128i *)(ditherline + (x & 63)));
+					// 16 dither thresholds
+    unsigned	mask = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(pixels, dither), pixels));
+					// Bits for pixels <= threshold
+
+    // movemask puts the first pixel in the low bit, so reverse the bits in each
+    // byte...
+    mask = ((mask & 0xf0f0) >> 4) | ((mask & 0x0f0f) << 4);
+    mask = ((mask & 0xcccc) >> 2) | ((mask & 0x3333) << 2);
+    mask = ((mask & 0xaaaa) >> 1) | ((mask & 0x5555) << 1);
+
+    *rowptr++ = (unsigned char)(ras->white ^ mask);
+    *rowptr++ = (unsigned char)(ras->white ^ (mask >> 8));
+  }
+
+#elif defined(XFORM_NEON)
+  static const uint8_t weights[16] = { 128, 64, 32, 16, 8, 4, 2, 1, 128, 64, 32, 16, 8, 4, 2, 1 };
+					// Bit for each pixel
+  uint8x16_t	bits = vld1q_u8(weights);
+					// Vector of bits
+
+  for (; (x + 16) <= num_pixels; x += 16, row += 16)
+  {
+    uint8x16_t	mask = vandq_u8(vcleq_u8(vld1q_u8(row), vld1q_u8(ditherline + (x & 63))), bits);
+					// Bits for pixels <= threshold
+
+    *rowptr++ = (unsigned char)(ras->white ^ vaddv_u8(vget_low_u8(mask)));
+    *rowptr++ = (unsigned char)(ras->white ^ vaddv_u8(vget_high_u8(mask)));
+  }
+#endif // __SSE2__
 
-  for (x = 0, bit = 128, byte = ras->white, rowptr = row; x < num_pixels; x ++, row ++)
+  // Dither any remaining pixels...
+  for (bit = 128, byte = ras->white; x < num_pixels; x ++, row ++)
   {
     if (*row <= ditherline[x & 63])
       byte ^= bit;
@@ -1845,6 +2067,10 @@ monitor_ipp(const char *device_uri)	// I - Device URI
   int		delay = 1,		// Current delay
 		next_delay,		// Next delay
 		prev_delay = 0;		// Previous delay
+  int		sub_id,			// Subscription ID, if any
+		sequence = 1;		// Next event sequence number
+  time_t	expire = 0;		// Subscription lease expiration
+  bool		changed;		// Did any values change?
   char		pvalues[10][1024];	// Current printer attribute values
   static const char * const pattrs[10] =// Printer attributes we need
   {
@@ -1874,16 +2100,17 @@ monitor_ipp(const char *device_uri)	// I - Device URI
     sleep(30);
   }
 
- /*
-  * Report printer state changes until we are canceled...
-  */
+  memset(pvalues, 0, sizeof(pvalues));
+
+  // Use event notifications when the printer supports them...
+  httpSetTimeout(http, 30.0, monitor_timeout_cb, NULL);
 
+  sub_id = monitor_subscribe(http, device_uri, resource, &expire);
+
+  // Report printer state changes until we are canceled...
   for (;;)
   {
-   /*
-    * Poll for the current state...
-    */
-
+    // Poll for the current state...
     request = ippNewRequest(IPP_OP_GET_PRINTER_ATTRIBUTES);
     ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_URI, "printer-uri", NULL, device_uri);
     ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_NAME, "requesting-user-name", NULL, cupsGetUser());
@@ -1891,11 +2118,8 @@ monitor_ipp(const char *device_uri)	// I - Device URI
 
     response = cupsDoRequest(http, request, resource);
 
-   /*
-    * Report any differences...
-    */
-
-    for (attr = ippGetFirstAttribute(response); attr; attr = ippGetNextAttribute(response))
+    // Report any differences...
+    for (attr = ippGetFirstAttribute(response), changed = false; attr; attr = ippGetNextAttribute(response))
     {
       const char *name = ippGetName(attr);
       char	value[1024];		// Name and value
@@ -1921,19 +2145,41 @@ monitor_ipp(const char *device_uri)	// I - Device URI
 	  fprintf(stderr, "ATTR: %s='%s'\n", name, value);
 
         cupsCopyString(pvalues[i], value, sizeof(pvalues[i]));
+        changed = true;
       }
     }
 
     ippDelete(response);
 
-   /*
-    * Sleep until the next update...
-    */
+    // Wait for the next event...
+    if (sub_id > 0)
+    {
+      if (monitor_wait(http, device_uri, resource, sub_id, &sequence, &expire))
+        continue;
+
+      // Fall back on polling if the printer stops reporting events; the
+      // subscription expires with its lease...
+      if (Verbosity)
+        fprintf(stderr, "DEBUG: Notifications failed (%s), polling.\n", cupsGetErrorString());
+
+      sub_id = 0;
+      continue;
+    }
+
+    // Otherwise sleep until the next update, backing off while the printer
+    // state does not change (1 1 2 3 5 8 13 21 30 30 ...)
+    if (changed)
+    {
+      delay      = 1;
+      prev_delay = 0;
+    }
 
     sleep((unsigned)delay);
 
-    next_delay = (delay + prev_delay) % 12;
-    prev_delay = next_delay < delay ? 0 : delay;
+    if ((next_delay = delay + prev_delay) > 30)
+      next_delay = 30;
+
+    prev_delay = delay;
     delay      = next_delay;
   }
 
@@ -1941,6 +2187,206 @@ monitor_ipp(const char *device_uri)	// I - Device URI
 }
 
 
+//
+// 'monitor_subscribe()' - Subscribe to printer state events, if supported.
+//
+
+static int				// O - Subscription ID or `0` if not supported
+monitor_subscribe(
+    http_t     *http,			// I - HTTP connection
+    const char *device_uri,		// I - Device URI
+    const char *resource,		// I - URI resource
+    time_t     *expire)			// O - Lease expiration time or `0` for none
+{
+  int		sub_id = 0;		// Subscription ID
+  ipp_t		*request,		// IPP request
+		*response;		// IPP response
+  ipp_attribute_t *attr;		// IPP response attribute
+  size_t	num_events = 0;		// Number of events
+  const char	*events[2];		// Events to subscribe to
+  static const char * const pattrs[] =	// Printer attributes we need
+  {
+    "notify-events-supported",
+    "notify-pull-method-supported"
+  };
+
+
+  // See whether the printer supports "ippget" notifications...
+  request = ippNewRequest(IPP_OP_GET_PRINTER_ATTRIBUTES);
+  ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_URI, "printer-uri", NULL, device_uri);
+  ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_NAME, "requesting-user-name", NULL, cupsGetUser());
+  ippAddStrings(request, IPP_TAG_OPERATION, IPP_TAG_KEYWORD, "requested-attributes", sizeof(pattrs) / sizeof(pattrs[0]), NULL, pattrs);
+
+  response = cupsDoRequest(http, request, resource);
+
+  if (ippContainsString(ippFindAttribute(response, "notify-pull-method-supported", IPP_TAG_KEYWORD), "ippget"))
+  {
+    // Marker and supply changes are reported as printer-config-changed or
+    // printer-state-changed events, depending on the printer...
+    attr = ippFindAttribute(response, "notify-events-supported", IPP_TAG_KEYWORD);
+
+    if (ippContainsString(attr, "printer-config-changed"))
+      events[num_events ++] = "printer-config-changed";
+    if (ippContainsString(attr, "printer-state-changed"))
+      events[num_events ++] = "printer-state-changed";
+  }
+
+  ippDelete(response);
+
+  if (num_events == 0)
+    return (0);
+
+  // Create the subscription...
+  request = ippNewRequest(IPP_OP_CREATE_PRINTER_SUBSCRIPTIONS);
+  ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_URI, "printer-uri", NULL, device_uri);
+  ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_NAME, "requesting-user-name", NULL, cupsGetUser());
+  ippAddString(request, IPP_TAG_SUBSCRIPTION, IPP_TAG_KEYWORD, "notify-pull-method", NULL, "ippget");
+  ippAddStrings(request, IPP_TAG_SUBSCRIPTION, IPP_TAG_KEYWORD, "notify-events", num_events, NULL, events);
+  ippAddInteger(request, IPP_TAG_SUBSCRIPTION, IPP_TAG_INTEGER, "notify-lease-duration", XFORM_MONITOR_LEASE);
+
+  response = cupsDoRequest(http, request, resource);
+
+  if (cupsGetError() <= IPP_STATUS_OK_CONFLICTING && (attr = ippFindAttribute(response, "notify-subscription-id", IPP_TAG_INTEGER)) != NULL)
+  {
+    sub_id = ippGetInteger(attr, 0);
+
+    if ((attr = ippFindAttribute(response, "notify-lease-duration", IPP_TAG_INTEGER)) == NULL)
+      *expire = time(NULL) + XFORM_MONITOR_LEASE;
+    else if (ippGetInteger(attr, 0) > 0)
+      *expire = time(NULL) + ippGetInteger(attr, 0);
+    else
+      *expire = 0;
+
+    if (Verbosity)
+      fprintf(stderr, "DEBUG: Using notification subscription %d.\n", sub_id);
+  }
+
+  ippDelete(response);
+
+  return (sub_id);
+}
+
+
+//
+// 'monitor_timeout_cb()' - Keep waiting for held Get-Notifications responses.
+//
+
+static bool				// O - `true` to continue
+monitor_timeout_cb(http_t *http,	// I - HTTP connection (unused)
+                   void   *data)	// I - Callback data (unused)
+{
+  (void)http;
+  (void)data;
+
+  return (true);
+}
+
+
+//
+// 'monitor_wait()' - Wait for printer state events.
+//
+// The printer holds each Get-Notifications request until an event is available
+// when it supports "notify-wait", otherwise the "notify-get-interval" value
+// (limited to 30 seconds) is used between requests.
+//
+
+static bool				// O - `true` to poll the printer, `false` on error
+monitor_wait(http_t     *http,		// I  - HTTP connection
+             const char *device_uri,	// I  - Device URI
+             const char *resource,	// I  - URI resource
+             int        sub_id,		// I  - Subscription ID
+             int        *sequence,	// IO - Next event sequence number
+             time_t     *expire)	// IO - Lease expiration time
+{
+  ipp_t		*request,		// IPP request
+		*response;		// IPP response
+  ipp_attribute_t *attr;		// IPP response attribute
+  bool		events;			// Got any events?
+  int		interval,		// Seconds before the next request
+		number;			// Event sequence number
+
+
+  for (;;)
+  {
+    // Renew the subscription before the lease expires...
+    if (*expire && time(NULL) >= (*expire - XFORM_MONITOR_LEASE / 4))
+    {
+      request = ippNewRequest(IPP_OP_RENEW_SUBSCRIPTION);
+      ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_URI, "printer-uri", NULL, device_uri);
+      ippAddInteger(request, IPP_TAG_OPERATION, IPP_TAG_INTEGER, "notify-subscription-id", sub_id);
+      ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_NAME, "requesting-user-name", NULL, cupsGetUser());
+      ippAddInteger(request, IPP_TAG_OPERATION, IPP_TAG_INTEGER, "notify-lease-duration", XFORM_MONITOR_LEASE);
+
+      response = cupsDoRequest(http, request, resource);
+
+      if (cupsGetError() > IPP_STATUS_OK_CONFLICTING)
+      {
+        ippDelete(response);
+        return (false);
+      }
+
+      if ((attr = ippFindAttribute(response, "notify-lease-duration", IPP_TAG_INTEGER)) == NULL)
+        *expire = time(NULL) + XFORM_MONITOR_LEASE;
+      else if (ippGetInteger(attr, 0) > 0)
+        *expire = time(NULL) + ippGetInteger(attr, 0);
+      else
+        *expire = 0;
+
+      ippDelete(response);
+    }
+
+    // Get any new events...
+    request = ippNewRequest(IPP_OP_GET_NOTIFICATIONS);
+    ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_URI, "printer-uri", NULL, device_uri);
+    ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_NAME, "requesting-user-name", NULL, cupsGetUser());
+    ippAddInteger(request, IPP_TAG_OPERATION, IPP_TAG_INTEGER, "notify-subscription-ids", sub_id);
+    ippAddInteger(request, IPP_TAG_OPERATION, IPP_TAG_INTEGER, "notify-sequence-numbers", *sequence);
+    ippAddBoolean(request, IPP_TAG_OPERATION, "notify-wait", true);
+
+    response = cupsDoRequest(http, request, resource);
+
+    if (cupsGetError() > IPP_STATUS_OK_CONFLICTING)
+    {
+      // Error or "successful-ok-events-complete"...
+      ippDelete(response);
+      return (false);
+    }
+
+    for (attr = ippGetFirstAttribute(response), events = false, interval = 0; attr; attr = ippGetNextAttribute(response))
+    {
+      const char *name = ippGetName(attr);
+					// Attribute name
+
+      if (!name || ippGetValueTag(attr) != IPP_TAG_INTEGER)
+        continue;
+
+      if (ippGetGroupTag(attr) == IPP_TAG_OPERATION && !strcmp(name, "notify-get-interval"))
+      {
+        interval = ippGetInteger(attr, 0);
+      }
+      else if (ippGetGroupTag(attr) == IPP_TAG_EVENT_NOTIFICATION && !strcmp(name, "notify-sequence-number") && (number = ippGetInteger(attr, 0)) >= *sequence)
+      {
+        *sequence = number + 1;
+        events    = true;
+      }
+    }
+
+    ippDelete(response);
+
+    if (events)
+      return (true);
+
+    // No events yet, wait before asking again...
+    if (interval < 1)
+      interval = 1;
+    else if (interval > 30)
+      interval = 30;
+
+    sleep((unsigned)interval);
+  }
+}
+
+
 //
 // 'pack_black()' - Pack grayscale lines into black lines.
 //
@@ -1949,6 +2395,29 @@ static void
 pack_black(unsigned char *row,		// I - Row of pixels to pack
            size_t        num_pixels)	// I - Number of pixels in row
 {
+  // Invert 16 (or 8) pixels at a time...
+#ifdef __SSE2__
+  __m128i	ones = _mm_set1_epi8(-1);// All bits set
+
+  for (; num_pixels >= 16; num_pixels -= 16, row += 16)
+    _mm_storeu_si128((__m128i *)row, _mm_xor_si128(_mm_loadu_si128((const __m128i *)row), ones));
+
+#elif defined(XFORM_NEON)
+  for (; num_pixels >= 16; num_pixels -= 16, row += 16)
+    vst1q_u8(row, vmvnq_u8(vld1q_u8(row)));
+
+#else
+  for (; num_pixels >= 8; num_pixels -= 8, row += 8)
+  {
+    uint64_t	v;			// 8 pixels
+
+    memcpy(&v, row, sizeof(v));
+    v = ~v;
+    memcpy(row, &v, sizeof(v));
+  }
+#endif // __SSE2__
+
+  // Then invert any remaining pixels...
   while (num_pixels > 0)
   {
     *row = 255 - *row;
@@ -1980,6 +2449,25 @@ pack_rgba(unsigned char *row,		// I - Row of pixels to pack
   unsigned char *dest_byte;		// Remaining destination bytes
 
 
+#ifdef XFORM_NEON
+ /*
+  * Copy groups of 16 pixels using interleaved loads and stores...
+  */
+
+  for (; num_quads >= 4; num_quads -= 4, quad_row += 16, dest += 12)
+  {
+    uint8x16x4_t rgbx = vld4q_u8((const uint8_t *)quad_row);
+					// De-interleaved RGBX pixels
+    uint8x16x3_t rgb;			// RGB pixels
+
+    rgb.val[0] = rgbx.val[0];
+    rgb.val[1] = rgbx.val[1];
+    rgb.val[2] = rgbx.val[2];
+
+    vst3q_u8((uint8_t *)dest, rgb);
+  }
+#endif // XFORM_NEON
+
  /*
   * Copy all of the groups of 4 pixels we can...
   */
@@ -2028,6 +2516,22 @@ pack_rgba16(unsigned char *row,		// I - Row of pixels to pack
 					// Destination pointer
 
 
+#ifdef XFORM_NEON
+  // Copy groups of 8 pixels using interleaved loads and stores...
+  for (; num_pixels >= 8; num_pixels -= 8, from += 16, dest += 12)
+  {
+    uint16x8x4_t rgbx = vld4q_u16((const uint16_t *)from);
+					// De-interleaved RGBX pixels
+    uint16x8x3_t rgb;			// RGB pixels
+
+    rgb.val[0] = rgbx.val[0];
+    rgb.val[1] = rgbx.val[1];
+    rgb.val[2] = rgbx.val[2];
+
+    vst3q_u16((uint16_t *)dest, rgb);
+  }
+#endif // XFORM_NEON
+
   while (num_pixels > 1)
   {
     *dest++ = from[0];
@@ -2138,6 +2642,74 @@ page_dict_cb(pdfio_dict_t *dict,	// I - Dictionary
 }
 
 
+//
+// 'pcl_delta_row()' - Compress a line using delta row (mode 3) compression.
+//
+// The line is encoded as the byte ranges that differ from the seed row, which
+// is the previous line sent to the printer.  If the encoded line needs
+// "dstsize" bytes or more, "dstsize" is returned and the buffer contents are
+// undefined.
+//
+
+static size_t				// O - Number of bytes or `dstsize`
+pcl_delta_row(
+    unsigned char       *dst,		// I - Compression buffer
+    size_t              dstsize,	// I - Size of compression buffer
+    const unsigned char *line,		// I - Pixels on line
+    const unsigned char *seed,		// I - Seed row
+    size_t              length)		// I - Length of line
+{
+  unsigned char	*dstptr = dst,		// Pointer into compression buffer
+		*dstend = dst + dstsize;// End of compression buffer
+  size_t	pos = 0,		// Position after last replaced byte
+		start,			// Start of changed bytes
+		stop,			// End of changed bytes
+		offset,			// Offset from last replaced byte
+		count;			// Number of bytes in command
+
+
+  while ((start = pcl_find_run(line, seed, pos, length, true)) < length)
+  {
+    stop   = pcl_find_run(line, seed, start, length, false);
+    offset = start - pos;
+
+    while (start < stop)
+    {
+      // Each command replaces up to 8 bytes, with an offset of up to 30 bytes
+      // in the command byte and any remainder in following offset bytes...
+      if ((count = stop - start) > 8)
+        count = 8;
+
+      if ((size_t)(dstend - dstptr) <= (count + 2 + offset / 255))
+        return (dstsize);
+
+      if (offset < 31)
+      {
+        *dstptr++ = (unsigned char)(((count - 1) << 5) | offset);
+      }
+      else
+      {
+        *dstptr++ = (unsigned char)(((count - 1) << 5) | 31);
+
+        for (offset -= 31; offset >= 255; offset -= 255)
+          *dstptr++ = 255;
+
+        *dstptr++ = (unsigned char)offset;
+      }
+
+      memcpy(dstptr, line + start, count);
+      dstptr += count;
+      start  += count;
+      offset = 0;
+    }
+
+    pos = stop;
+  }
+
+  return ((size_t)(dstptr - dst));
+}
+
+
 //
 // 'pcl_end_job()' - End a PCL "job".
 //
@@ -2179,6 +2751,67 @@ pcl_end_page(xform_raster_t   *ras,	// I - Raster information
 
   if (!(ras->header.Duplex && (page & 1)))
     (*cb)(ctx, (const unsigned char *)"\014", 1);
+
+ /*
+  * Free the compression buffers...
+  */
+
+  free(ras->comp_buffer);
+
+  ras->comp_buffer  = NULL;
+  ras->delta_buffer = NULL;
+  ras->seed_buffer  = NULL;
+}
+
+
+//
+// 'pcl_find_run()' - Find the end of a run of equal or changed bytes.
+//
+// Returns the position of the first byte at or after "pos" that is different
+// from the seed row ("equal" is `true`) or the same as the seed row ("equal"
+// is `false`), or "length" if there is no such byte.
+//
+
+static size_t				// O - Position of first byte not in run
+pcl_find_run(
+    const unsigned char *line,		// I - Pixels on line
+    const unsigned char *seed,		// I - Seed row
+    size_t              pos,		// I - Starting position
+    size_t              length,		// I - Length of line
+    bool                equal)		// I - Skip equal (`true`) or changed (`false`) bytes?
+{
+  // Skip 16 (or 8) bytes at a time...
+#ifdef __SSE2__
+  int	skipmask = equal ? 0xffff : 0;	// Mask for a run of 16 bytes
+
+  while ((pos + 16) <= length && _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(line + pos)), _mm_loadu_si128((const __m128i *)(seed + pos)))) == skipmask)
+    pos += 16;
+
+#elif defined(XFORM_NEON)
+  if (equal)
+  {
+    while ((pos + 16) <= length && vminvq_u8(vceqq_u8(vld1q_u8(line + pos), vld1q_u8(seed + pos))) == 0xff)
+      pos += 16;
+  }
+  else
+  {
+    while ((pos + 16) <= length && vmaxvq_u8(vceqq_u8(vld1q_u8(line + pos), vld1q_u8(seed + pos))) == 0)
+      pos += 16;
+  }
+
+#else
+  if (equal)
+  {
+    while ((pos + 8) <= length && !memcmp(line + pos, seed + pos, 8))
+      pos += 8;
+  }
+#endif // __SSE2__
+
+  // Then find the end of the run...
+  while (pos < length && (line[pos] == seed[pos]) == equal)
+    pos ++;
+
+  return (pos);
 }
 
 
@@ -2226,6 +2859,9 @@ pcl_start_page(xform_raster_t   *ras,	// I - Raster information
                xform_write_cb_t cb,	// I - Write callback
                void             *ctx)	// I - Write context
 {
+  unsigned	bytes;			// Bytes per line
+
+
   // Setup margins to be 1/6" top and bottom and 1/4" or .135" on the
   // left and right.
   ras->top    = ras->header.HWResolution[1] / 6;
@@ -2341,11 +2977,17 @@ pcl_start_page(xform_raster_t   *ras,	// I - Raster information
   pclps_printf(cb, ctx, "\033*r1A");	// Start graphics
 
  /*
-  * Allocate the output buffer...
+  * Allocate the output buffers - the seed row starts out blank for each
+  * page...
   */
 
-  ras->out_blanks  = 0;
-  ras->comp_buffer = malloc((ras->right - ras->left + 7) / 8 * 2 + 2);
+  bytes = (ras->right - ras->left + 7) / 8;
+
+  ras->out_blanks   = 0;
+  ras->comp_mode    = 2;
+  ras->comp_buffer  = calloc(5, bytes + 1);
+  ras->delta_buffer = ras->comp_buffer + 2 * bytes + 2;
+  ras->seed_buffer  = ras->delta_buffer + 2 * bytes + 2;
 }
 
 
@@ -2366,18 +3008,21 @@ pcl_write_line(
 			*start;		// Start of sequence
   unsigned char		*compptr;	// Pointer into compression buffer
   unsigned		count;		// Count of bytes for output
+  size_t		comp_length,	// Length of PackBits line
+			delta_length;	// Length of delta row line
+  int			mode;		// Compression mode for line
 
 
   (void)y;
 
-  if (line[0] == 255 && !memcmp(line, line + 1, ras->out_length - 1))
+  if (line[0] == ras->white && !memcmp(line, line + 1, ras->out_length - 1))
   {
     // Skip blank line...
     ras->out_blanks ++;
     return;
   }
 
-  // Apply compression...
+  // Apply PackBits compression...
   compptr = ras->comp_buffer;
   outptr  = line;
   outend  = line + ras->out_length;
@@ -2428,13 +3073,38 @@ pcl_write_line(
   // Output the line...
   if (ras->out_blanks > 0)
   {
-    // Skip blank lines first...
+    // Skip blank lines first, which also clears the seed row...
     pclps_printf(cb, ctx, "\033*b%dY", ras->out_blanks);
     ras->out_blanks = 0;
+
+    memset(ras->seed_buffer, 0, ras->out_length);
+  }
+
+  // Then use delta row compression if it is smaller than PackBits...
+  comp_length  = (size_t)(compptr - ras->comp_buffer);
+  delta_length = pcl_delta_row(ras->delta_buffer, comp_length, line, ras->seed_buffer, ras->out_length);
+  mode         = delta_length < comp_length ? 3 : 2;
+
+  if (mode == 3)
+  {
+    compptr     = ras->delta_buffer;
+    comp_length = delta_length;
+  }
+  else
+    compptr = ras->comp_buffer;
+
+  if (mode != ras->comp_mode)
+  {
+    // Change compression mode and send the line in one command...
+    pclps_printf(cb, ctx, "\033*b%dm%dW", mode, (int)comp_length);
+    ras->comp_mode = mode;
   }
+  else
+    pclps_printf(cb, ctx, "\033*b%dW", (int)comp_length);
 
-  pclps_printf(cb, ctx, "\033*b%dW", (int)(compptr - ras->comp_buffer));
-  (*cb)(ctx, ras->comp_buffer, (size_t)(compptr - ras->comp_buffer));
+  (*cb)(ctx, compptr, comp_length);
+
+  memcpy(ras->seed_buffer, line, ras->out_length);
 }
 
 
@@ -2525,11 +3195,16 @@ ps_convert_pdf(
     if (Verbosity)
       cupsLangPuts(stderr, _("DEBUG: Converting PDF to PostScript with pdftops."));
 
+    xform_stage_t stage = stats_stage(XFORM_STAGE_RENDER);
+					// Previous stage
+
     while ((stdout_bytes = read(stdout_pipe[0], stdout_buffer, sizeof(stdout_buffer))) > 0)
       (cb)(ctx, stdout_buffer, (size_t)stdout_bytes);
 
     close(stdout_pipe[0]);
 
+    stats_stage(stage);
+
     while (waitpid(pdftops_pid, &pdftops_status, 0) < 0)
     {
       if (errno != EINTR && errno != EAGAIN)
@@ -2880,240 +3555,796 @@ pdfio_start_page(xform_prepare_t *p,	// I - Preparation data
 }
 
 
+#ifndef HAVE_COREGRAPHICS_H
 //
-// 'prepare_documents()' - Prepare one or more documents for printing.
+// 'ppm_command()' - Build the pdftoppm command for some or all pages.
 //
-// This function generates a single PDF file containing the union of the input
-// documents and any job sheets.
+// There are two versions of the pdftoppm command - the one that comes with
+// Xpdf and the one that comes with Poppler which forked from Xpdf in the v3.0
+// days:
+//
+//   Poppler:
+//     pdftoppm [-gray] -aa no -r resolution -scale-to HEIGHT [-f PAGE -l PAGE] filename
+//
+//   Xpdf:
+//     pdftoppm [-gray] -aa no -r resolution [-f PAGE -l PAGE] filename -
 //
 
-static bool				// O - `true` on success, `false` on failure
-prepare_documents(
-    size_t           num_documents,	// I - Number of input documents
-    xform_document_t *documents,	// I - Input documents
-    ipp_options_t    *options,		// I - IPP options
-    const char       *sheet_back,	// I - Back side transform
-    char             *outfile,		// I - Output filename buffer
-    size_t           outsize,		// I - Output filename buffer size
-    const char       *outformat,	// I - Output format
-    unsigned         *outpages,		// O - Number of pages
-    bool             generate_copies)	// I - Generate copies in output PDF?
+static void
+ppm_command(char           *command,	// I - Command buffer
+            size_t         cmdsize,	// I - Size of command buffer
+            xform_raster_t *ras,	// I - Raster information
+            const char     *filename,	// I - PDF file
+            bool           poppler,	// I - Using Poppler's pdftoppm?
+            unsigned       page)	// I - Page number or `0` for all pages
 {
-  bool			ret = false;	// Return value
-  int			copies;		// Number of copies
-  size_t		i;		// Looping var
-  xform_prepare_t	p;		// Preparation data
-  xform_document_t	*d;		// Current document
-  xform_page_t		*outpage;	// Current output page
-  int			outdir;		// Output direction
-  bool			reverse_order;	// Should output be in reverse order?
-  size_t		layout;		// Layout cell
-  int			document;	// Document number
-  int			page;		// Current page number
-  bool			duplex = !strncmp(options->sides, "two-sided-", 10);
-					// Doing two-sided printing?
+  char	range[64];			// Page range options
 
 
-  // Initialize data for preparing input files for transform...
-  memset(&p, 0, sizeof(p));
-  p.options = options;
-  p.errors  = cupsArrayNew(NULL, NULL, NULL, 0, (cups_acopy_cb_t)strdup, (cups_afree_cb_t)free);
+  if (page)
+    snprintf(range, sizeof(range), " -f %u -l %u", page, page);
+  else
+    range[0] = '\0';
 
-  media_to_rect(&options->media, &p.media, &p.crop);
-  prepare_number_up(&p);
+  if (poppler)
+    snprintf(command, cmdsize, "%s %s -aa no -r %u -scale-to %u%s '%s'", PdftoppmCommand, ras->header.cupsBitsPerPixel <= 8 ? "-gray" : "", ras->header.HWResolution[0], ras->header.cupsHeight, range, filename);
+  else
+    snprintf(command, cmdsize, "%s %s -aa no -r %u%s '%s' -", PdftoppmCommand, ras->header.cupsBitsPerPixel <= 8 ? "-gray" : "", ras->header.HWResolution[0], range, filename);
+}
 
-  if (!strncmp(options->sides, "two-sided-", 10) && sheet_back && strcmp(sheet_back, "normal"))
-  {
-    // Need to do a transform on the back side of pages...
-    if (!strcmp(sheet_back, "flipped"))
-    {
-      if (!strcmp(options->sides, "two-sided-short-edge"))
-      {
-	p.use_duplex_xform   = true;
-        p.duplex_xform[0][0] = -1.0;
-        p.duplex_xform[0][1] = 0.0;
-        p.duplex_xform[1][0] = 0.0;
-        p.duplex_xform[1][1] = 1.0;
-        p.duplex_xform[2][0] = p.media.x2;
-        p.duplex_xform[2][1] = 0.0;
-      }
-      else
-      {
-	p.use_duplex_xform   = true;
-        p.duplex_xform[0][0] = 1.0;
-        p.duplex_xform[0][1] = 0.0;
-        p.duplex_xform[1][0] = 0.0;
-        p.duplex_xform[1][1] = -1.0;
-        p.duplex_xform[2][0] = 0.0;
-        p.duplex_xform[2][1] = p.media.y2;
-      }
-    }
-    else if ((!strcmp(sheet_back, "manual-tumble") && !strcmp(options->sides, "two-sided-short-edge")) || (!strcmp(sheet_back, "rotated") && !strcmp(options->sides, "two-sided-long-edge")))
-    {
-      p.use_duplex_xform   = true;
-      p.duplex_xform[0][0] = -1.0;
-      p.duplex_xform[0][1] = 0.0;
-      p.duplex_xform[1][0] = 0.0;
-      p.duplex_xform[1][1] = -1.0;
-      p.duplex_xform[2][0] = p.media.x2;
-      p.duplex_xform[2][1] = p.media.y2;
-    }
-  }
 
-  if ((p.pdf = pdfioFileCreateTemporary(outfile, outsize, "1.7", &p.media, &p.media, pdfio_error_cb, &p)) == NULL)
-    return (false);
+//
+// 'ppm_read_header()' - Read the header of the next page image from pdftoppm.
+//
 
-  // Loop through the input documents to count pages, etc.
-  for (i = num_documents, d = documents, document = 1, page = 1; i > 0; i --, d ++, document ++)
-  {
-    if (Verbosity)
-      fprintf(stderr, "DEBUG: Preparing document %d: '%s' (%s)\n", document, d->filename, d->format);
+static bool				// O - `true` on success, `false` on end of file or error
+ppm_read_header(FILE        *fp,	// I - Pipe from pdftoppm
+                xform_ppm_t *ppm)	// O - Page image
+{
+  char		header[256];		// Header from file
 
-    if (!strcmp(d->format, "application/pdf"))
-    {
-      // PDF file...
-      d->pdf_filename = d->filename;
-    }
-    else if (!strcmp(d->format, "image/jpeg") || !strcmp(d->format, "image/png"))
-    {
-      // JPEG or PNG image...
-      if (!convert_image(&p, d, document))
-        goto done;
-    }
-    else if (!strcmp(d->format, "text/plain"))
-    {
-      // Plain text file...
-      if (!convert_text(&p, d, document))
-        goto done;
-    }
-    else
-    {
-      // PWG or Apple raster file...
-      if (!convert_raster(&p, d, document))
-        goto done;
-    }
 
-    if (Verbosity)
-      fprintf(stderr, "DEBUG: Opening prepared document %d: '%s'.\n", document, d->pdf_filename);
+  memset(ppm, 0, sizeof(xform_ppm_t));
 
-    if ((d->pdf = pdfioFileOpen(d->pdf_filename, pdfio_password_cb, &document, pdfio_error_cb, &p)) == NULL)
-      goto done;
+  // Get the P5/6 header...
+  if (!fgets(header, sizeof(header), fp))
+    return (false);
 
-    if (options->multiple_document_handling < IPPOPT_HANDLING_SINGLE_DOCUMENT)
-    {
-      d->first_page = 1;
-      d->last_page  = (int)pdfioFileGetNumPages(d->pdf);
-    }
-    else
-    {
-      d->first_page = page;
-      d->last_page  = page + (int)pdfioFileGetNumPages(d->pdf) - 1;
-    }
+  if (!strcmp(header, "P5\n"))
+  {
+    ppm->bpp = 1;
+  }
+  else if (!strcmp(header, "P6\n"))
+  {
+    ppm->bpp = 3;
+  }
+  else
+  {
+    cupsLangPrintf(stderr, _("%s: Bad page header - <%02X%02X%02X%02X%02X%02X%02X%02X>"), Prefix, header[0] & 255, header[1] & 255, header[2] & 255, header[3] & 255, header[4] & 255, header[5] & 255, header[6] & 255, header[7] & 255);
+    return (false);
+  }
 
-    if (Verbosity)
-      fprintf(stderr, "DEBUG: Document %d: pages %d to %d.\n", document, d->first_page, d->last_page);
+  if (Verbosity)
+  {
+    header[strlen(header) - 1] = '\0';
+    fprintf(stderr, "DEBUG: '%s'\n", header);
+  }
 
-    while (page <= d->last_page)
-    {
-      if (options->multiple_document_handling < IPPOPT_HANDLING_SINGLE_DOCUMENT)
-      {
-        if (ippOptionsCheckPage(options, page - d->first_page + 1))
-          d->num_pages ++;
-      }
-      else if (ippOptionsCheckPage(options, page))
-      {
-        d->num_pages ++;
-      }
+  // Now get the bitmap dimensions...
+  if (!fgets(header, sizeof(header), fp))
+    return (false);
 
-      page ++;
-    }
+  if (Verbosity)
+  {
+    header[strlen(header) - 1] = '\0';
+    fprintf(stderr, "DEBUG: '%s'\n", header);
+  }
 
-    if ((d->last_page & 1) && duplex && options->multiple_document_handling != IPPOPT_HANDLING_SINGLE_DOCUMENT)
-    {
-      d->last_page ++;
-      page ++;
-    }
+  if (sscanf(header, "%u%u", &ppm->width, &ppm->height) != 2 || ppm->width > 0x10000000 || ppm->height > 0x40000000)
+  {
+    cupsLangPrintf(stderr, _("%s: Bad page dimensions - <%02X%02X%02X%02X%02X%02X%02X%02X>"), Prefix, header[0] & 255, header[1] & 255, header[2] & 255, header[3] & 255, header[4] & 255, header[5] & 255, header[6] & 255, header[7] & 255);
+    return (false);
+  }
 
-    if ((d->num_pages & 1) && duplex && options->multiple_document_handling != IPPOPT_HANDLING_SINGLE_DOCUMENT)
-      d->num_pages ++;
+  // Skip max value line...
+  if (!fgets(header, sizeof(header), fp))
+    return (false);
 
-    p.num_inpages += d->num_pages;
+  if (Verbosity)
+  {
+    header[strlen(header) - 1] = '\0';
+    fprintf(stderr, "DEBUG: '%s'\n", header);
   }
 
-  // When doing N-up or booklet printing, the default is to scale to fit unless
-  // fill is explicitly chosen...
-  if (p.num_layout > 1 && options->print_scaling != IPPOPT_SCALING_FILL)
-    options->print_scaling = IPPOPT_SCALING_FIT;
+  ppm->fp = fp;
 
-  // Prepare output pages...
-  prepare_pages(&p, num_documents, documents);
+  return (true);
+}
 
-  // Add job-sheets content...
-  if (options->job_sheets[0] && strcmp(options->job_sheets, "none"))
-    generate_job_sheets(&p);
 
-  // Copy pages to the output file...
-  for (copies = generate_copies ? options->copies : 1; copies > 0; copies --)
+//
+// 'ppm_read_line()' - Read a line from a page image.
+//
+
+static bool				// O - `true` on success, `false` on end of file
+ppm_read_line(xform_ppm_t   *ppm,	// I - Page image
+              unsigned char *line)	// I - Line buffer
+{
+  size_t	bytes = (size_t)ppm->width * ppm->bpp;
+					// Bytes per line
+
+
+  if (ppm->raster)
   {
-    reverse_order = !strcmp(options->output_bin, "face-up");
-    if (options->page_delivery >= IPPOPT_DELIVERY_REVERSE_ORDER_FACE_DOWN)
-      reverse_order = !reverse_order;
+    // Read and scale the next line from the raster stream...
+    unsigned		x,		// Current column
+			rx,		// Column in raster line
+			ry,		// Line in raster page
+			c,		// Current color
+			val[4],		// Color values
+			gray;		// Gray value
+    const unsigned char	*rptr;		// Pointer to raster pixel
+    uint16_t		rval;		// 16-bit raster value
+
+    if (ppm->y >= ppm->height)
+      return (false);
 
-    if (reverse_order)
-    {
-      outpage = p.outpages + p.num_outpages - 1;
-      outdir  = -1;
-    }
-    else
+    ry = (unsigned)((uint64_t)ppm->y * ppm->rheader.cupsHeight / ppm->height);
+    ppm->y ++;
+
+    while (ppm->rlines <= ry)
     {
-      outpage = p.outpages;
-      outdir  = 1;
+      if (!cupsRasterReadPixels(ppm->raster, ppm->rbuffer, ppm->rheader.cupsBytesPerLine))
+        return (false);
+
+      ppm->rlines ++;
     }
 
-    if (p.num_layout == 1 && options->print_scaling == IPPOPT_SCALING_NONE && strcasecmp(outformat, "image/pwg-raster") && strcasecmp(outformat, "image/urf"))
+    for (x = 0; x < ppm->width; x ++)
     {
-      // Simple path - no layout/scaling/rotation of pages so we can just copy the pages quickly.
-      if (Verbosity)
-	fputs("DEBUG: Doing fast copy of pages.\n", stderr);
+      rx = (unsigned)((uint64_t)x * ppm->rheader.cupsWidth / ppm->width);
 
-      for (i = p.num_outpages; i > 0; i --, outpage += outdir)
+      if (ppm->rheader.cupsBitsPerColor == 1)
       {
-	if (outpage->input[0])
-	  pdfioPageCopy(p.pdf, outpage->input[0]);
+        val[0] = (ppm->rbuffer[rx / 8] & (0x80 >> (rx & 7))) ? 255 : 0;
+      }
+      else if (ppm->rheader.cupsBitsPerColor == 8)
+      {
+        for (c = 0, rptr = ppm->rbuffer + rx * ppm->rcolors; c < ppm->rcolors; c ++)
+          val[c] = rptr[c];
+      }
+      else
+      {
+        for (c = 0, rptr = ppm->rbuffer + 2 * rx * ppm->rcolors; c < ppm->rcolors; c ++, rptr += 2)
+        {
+          memcpy(&rval, rptr, sizeof(rval));
+          val[c] = rval >> 8;
+        }
       }
-    }
-    else
-    {
-      // Layout path - merge page resources and do mapping of resources as needed
-      if (Verbosity)
-	fprintf(stderr, "DEBUG: Doing full layout of %u pages.\n", (unsigned)p.num_outpages);
 
-      for (i = p.num_outpages; i > 0; i --, outpage += outdir)
+      switch (ppm->rheader.cupsColorSpace)
       {
-	// Create a page dictionary that merges the resources from each of the
-	// input pages...
-	if (Verbosity)
-	  fprintf(stderr, "DEBUG: Laying out page %u/%u.\n", (unsigned)(outpage - p.outpages + 1), (unsigned)p.num_outpages);
+        case CUPS_CSPACE_K :
+            val[0] = 255 - val[0];
 
-	outpage->pagedict = pdfioDictCreate(p.pdf);
-	outpage->resdict  = pdfioDictCreate(p.pdf);
+        default :
+            val[1] = val[2] = val[0];
+            break;
 
-	pdfioDictSetRect(outpage->pagedict, "CropBox", &p.media);
-	pdfioDictSetRect(outpage->pagedict, "MediaBox", &p.media);
-	pdfioDictSetDict(outpage->pagedict, "Resources", outpage->resdict);
-	pdfioDictSetName(outpage->pagedict, "Type", "Page");
+        case CUPS_CSPACE_RGB :
+        case CUPS_CSPACE_SRGB :
+        case CUPS_CSPACE_ADOBERGB :
+            break;
 
-	for (layout = 0; layout < p.num_layout; layout ++)
-	{
-	  pdfio_dict_t	*pagedict,	// Page dictionary
-			*resdict;	// Resources dictionary
-	  pdfio_obj_t	*resobj;	// Resources object
+        case CUPS_CSPACE_CMYK :
+            val[0] = val[0] + val[3] < 255 ? 255 - val[0] - val[3] : 0;
+            val[1] = val[1] + val[3] < 255 ? 255 - val[1] - val[3] : 0;
+            val[2] = val[2] + val[3] < 255 ? 255 - val[2] - val[3] : 0;
+            break;
+      }
 
-	  if (!outpage->input[layout])
-	    continue;
+      if (ppm->bpp == 1)
+      {
+        gray    = (val[0] * 31 + val[1] * 61 + val[2] * 8) / 100;
+        *line++ = (unsigned char)gray;
+      }
+      else
+      {
+        *line++ = (unsigned char)val[0];
+        *line++ = (unsigned char)val[1];
+        *line++ = (unsigned char)val[2];
+      }
+    }
 
-	  outpage->layout  = layout;
-	  outpage->restype = NULL;
+    return (true);
+  }
+
+  if (!ppm->pixels)
+    return (fread(line, ppm->width, ppm->bpp, ppm->fp) > 0);
+
+  if ((size_t)(ppm->pixend - ppm->pixptr) < bytes)
+    return (false);
+
+  memcpy(line, ppm->pixptr, bytes);
+  ppm->pixptr += bytes;
+
+  return (true);
+}
+
+
+//
+// 'ppm_read_pixels()' - Read the pixels for a page image into memory.
+//
+// This function is called after ppm_read_header() and buffers the whole
+// page image so that it can be written later or more than once.
+//
+
+static bool				// O - `true` on success, `false` on error
+ppm_read_pixels(FILE        *fp,	// I - Pipe from pdftoppm
+                xform_ppm_t *ppm)	// I - Page image
+{
+  size_t	bytes = (size_t)ppm->width * ppm->height * ppm->bpp,
+					// Bytes in page image
+		total;			// Bytes read
+
+
+  if ((ppm->pixels = malloc(bytes > 0 ? bytes : 1)) == NULL)
+  {
+    cupsLangPrintf(stderr, _("%s: Out of memory."), Prefix);
+    memset(ppm, 0, sizeof(xform_ppm_t));
+    return (false);
+  }
+
+  total = fread(ppm->pixels, 1, bytes, fp);
+
+  ppm->fp     = NULL;
+  ppm->pixptr = ppm->pixels;
+  ppm->pixend = ppm->pixels + total;
+
+  return (true);
+}
+
+
+//
+// 'ppm_read_raster()' - Read the header of the next page from a raster stream.
+//
+// The page image is scaled to the output resolution and uses the same pixel
+// format as pdftoppm - grayscale for 8-bit and bitmap output and RGB otherwise.
+//
+
+static int				// O - 1 on success, 0 on end of file, -1 on error
+ppm_read_raster(cups_raster_t  *raster,	// I - Raster stream
+                xform_raster_t *ras,	// I - Raster information
+                xform_ppm_t    *ppm)	// O - Page image
+{
+  cups_page_header_t	*header = &ppm->rheader;
+					// Raster page header
+
+
+  memset(ppm, 0, sizeof(xform_ppm_t));
+
+  if (!cupsRasterReadHeader(raster, header))
+    return (0);
+
+  switch (header->cupsColorSpace)
+  {
+    case CUPS_CSPACE_W :
+    case CUPS_CSPACE_K :
+    case CUPS_CSPACE_SW :
+        ppm->rcolors = 1;
+        break;
+
+    case CUPS_CSPACE_RGB :
+    case CUPS_CSPACE_SRGB :
+    case CUPS_CSPACE_ADOBERGB :
+        ppm->rcolors = 3;
+        break;
+
+    case CUPS_CSPACE_CMYK :
+        ppm->rcolors = 4;
+        break;
+
+    default :
+        break;
+  }
+
+  if (!ppm->rcolors || header->cupsColorOrder != CUPS_ORDER_CHUNKED || (header->cupsBitsPerColor != 8 && header->cupsBitsPerColor != 16 && (header->cupsBitsPerColor != 1 || ppm->rcolors != 1)) || header->cupsBitsPerPixel != header->cupsBitsPerColor * ppm->rcolors || header->cupsWidth == 0 || header->cupsWidth > 0x10000000 || header->cupsHeight == 0 || header->cupsHeight > 0x40000000 || header->cupsBytesPerLine < (header->cupsWidth * header->cupsBitsPerPixel + 7) / 8 || header->HWResolution[0] == 0 || header->HWResolution[1] == 0)
+  {
+    cupsLangPrintf(stderr, _("%s: Unsupported raster page - %ux%u, %u bits per pixel, color space %d."), Prefix, header->cupsWidth, header->cupsHeight, header->cupsBitsPerPixel, header->cupsColorSpace);
+    return (-1);
+  }
+
+  if ((ppm->rbuffer = malloc(header->cupsBytesPerLine)) == NULL)
+  {
+    cupsLangPrintf(stderr, _("%s: Out of memory."), Prefix);
+    return (-1);
+  }
+
+  ppm->raster = raster;
+  ppm->bpp    = ras->header.cupsBitsPerPixel <= 8 ? 1 : 3;
+  ppm->width  = (unsigned)((uint64_t)header->cupsWidth * ras->header.HWResolution[0] / header->HWResolution[0]);
+  ppm->height = (unsigned)((uint64_t)header->cupsHeight * ras->header.HWResolution[1] / header->HWResolution[1]);
+
+  if (ppm->width == 0)
+    ppm->width = 1;
+  if (ppm->height == 0)
+    ppm->height = 1;
+
+  if (Verbosity)
+    fprintf(stderr, "DEBUG: Raster page %ux%u at %ux%udpi, %u bits per pixel, color space %d.\n", header->cupsWidth, header->cupsHeight, header->HWResolution[0], header->HWResolution[1], header->cupsBitsPerPixel, header->cupsColorSpace);
+
+  return (1);
+}
+
+
+//
+// 'ppm_render_page()' - Render a single page image with pdftoppm.
+//
+// The page image has no pixels on error.
+//
+
+static bool				// O - `true` on success, `false` on error
+ppm_render_page(xform_raster_t *ras,	// I - Raster information
+                const char     *filename,
+					// I - PDF file
+                bool           poppler,	// I - Using Poppler's pdftoppm?
+                unsigned       page,	// I - Page number
+                xform_ppm_t    *ppm)	// O - Page image
+{
+  char		command[1024];		// pdftoppm command
+  FILE		*fp;			// Pipe for output
+
+
+  memset(ppm, 0, sizeof(xform_ppm_t));
+
+  ppm_command(command, sizeof(command), ras, filename, poppler, page);
+
+  fprintf(stderr, "DEBUG: Running \"%s\".\n", command);
+#if _WIN32
+  if ((fp = _popen(command, "rb")) == NULL)
+#else
+  if ((fp = popen(command, "r")) == NULL)
+#endif // _WIN32
+  {
+    cupsLangPrintf(stderr, _("%s: Unable to run pdftoppm command: %s"), Prefix, strerror(errno));
+    return (false);
+  }
+
+  if (!ppm_read_header(fp, ppm) || !ppm_read_pixels(fp, ppm))
+    memset(ppm, 0, sizeof(xform_ppm_t));
+
+#if _WIN32
+  _pclose(fp);
+#else
+  pclose(fp);
+#endif // _WIN32
+
+  return (ppm->pixels != NULL);
+}
+
+
+//
+// 'ppm_thread()' - Render pages with pdftoppm for the page queue.
+//
+// Each thread renders the next unclaimed page, as long as there is a free slot
+// in the queue, and then posts the page image for the writer.
+//
+
+static void *				// O - Thread exit status
+ppm_thread(xform_ppmqueue_t *q)		// I - Page queue
+{
+  unsigned	page;			// Current page
+  xform_ppm_t	ppm;			// Page image
+
+
+  cupsMutexLock(&q->mutex);
+
+  for (;;)
+  {
+    // Wait for a free slot in the queue...
+    while (!q->canceled && q->next_page <= q->num_pages && q->next_page > (q->num_written + q->depth))
+      cupsCondWait(&q->cond, &q->mutex, 0.0);
+
+    if (q->canceled || q->next_page > q->num_pages)
+      break;
+
+    page = q->next_page ++;
+
+    cupsMutexUnlock(&q->mutex);
+
+    // Render the page and read the page image...
+    ppm_render_page(q->ras, q->filename, q->poppler, page, &ppm);
+
+    // Post the page image, which has no pixels on error...
+    ppm.page = page;
+
+    cupsMutexLock(&q->mutex);
+    q->slots[(page - 1) % q->depth] = ppm;
+    cupsCondBroadcast(&q->cond);
+  }
+
+  cupsMutexUnlock(&q->mutex);
+
+  return (NULL);
+}
+
+
+//
+// 'ppm_write_page()' - Write a page image from pdftoppm.
+//
+
+static bool				// O - `true` on success, `false` on error
+ppm_write_page(xform_raster_t   *ras,	// I - Raster information
+               xform_ppm_t      *ppm,	// I - Page image
+               unsigned         page,	// I - Page number
+               xform_write_cb_t cb,	// I - Write callback
+               void             *ctx)	// I - Write context
+{
+  unsigned	y,			// Current Y position
+		ystart,			// Start Y position
+		yend;			// End Y position
+  unsigned	width = ppm->width,	// Width of page image
+		height = ppm->height,	// Height of page image
+		bpp = ppm->bpp;		// Bytes per pixel
+  unsigned char	*line,			// Pixel line from file
+		*linein,		// Pointer to input pixels
+		*lineout;		// Pointer to output pixels
+  size_t	linesize;		// Size of a line...
+  xform_stage_t	stage;			// Previous statistics stage
+
+
+  if (width > ras->header.cupsWidth)
+    linesize = width * bpp;
+  else
+    linesize = ras->header.cupsWidth * bpp;
+
+  if ((line = malloc(linesize)) == NULL)
+  {
+    cupsLangPrintf(stderr, _("%s: Out of memory."), Prefix);
+    return (false);
+  }
+
+  if (width > ras->header.cupsWidth)
+  {
+    linein  = line;
+    lineout = line + ((width - ras->header.cupsWidth) / 2 + ras->left) * bpp;
+  }
+  else
+  {
+    linein  = line + (ras->header.cupsWidth - width) / 2 * bpp;
+    lineout = line + ras->left * bpp;
+  }
+
+  if (height > ras->header.cupsHeight)
+  {
+    ystart = (height - ras->header.cupsHeight) / 2;
+    yend   = ystart + ras->header.cupsHeight;
+  }
+  else
+  {
+    ystart = (ras->header.cupsHeight - height) / 2;
+    yend   = ystart + height;
+  }
+
+  memset(line, ras->white, linesize);
+
+  if (Verbosity)
+    fprintf(stderr, "DEBUG: width=%u, height=%u, bpp=%u, ystart=%u, yend=%u\n", width, height, bpp, ystart, yend);
+
+  // Send the page to the driver...
+  stage = stats_stage(XFORM_STAGE_COMPRESS);
+
+  (ras->start_page)(ras, page, cb, ctx);
+
+  ras->out_length = ((ras->right - ras->left) * ras->header.cupsBitsPerPixel + 7) / 8;
+
+  if (height > ras->header.cupsHeight)
+  {
+    // Skip leading lines...
+    stats_stage(XFORM_STAGE_RENDER);
+
+    for (y = 0; y < ystart; y ++)
+      ppm_read_line(ppm, linein);
+
+    stats_stage(XFORM_STAGE_COMPRESS);
+  }
+  else
+  {
+    // Write leading blank lines...
+    for (y = 0; y < ystart; y ++)
+      (ras->write_line)(ras, y, lineout, cb, ctx);
+  }
+
+  for (; y < yend; y ++)
+  {
+    // Copy lines...
+    memset(line, 255, linesize);
+
+    stats_stage(XFORM_STAGE_RENDER);
+
+    if (ppm_read_line(ppm, linein))
+    {
+      stats_stage(XFORM_STAGE_DITHER);
+
+      if (ras->header.cupsBitsPerPixel == 1)
+	dither_gray(ras, y, lineout, ras->right - ras->left);
+      else if (ras->header.cupsColorSpace == CUPS_CSPACE_K)
+	pack_black(lineout, ras->right - ras->left);
+
+      stats_stage(XFORM_STAGE_COMPRESS);
+
+      (ras->write_line)(ras, y, lineout, cb, ctx);
+    }
+  }
+
+  stats_stage(XFORM_STAGE_COMPRESS);
+
+  if (height > ras->header.cupsHeight)
+  {
+    // Skip trailing lines...
+    stats_stage(XFORM_STAGE_RENDER);
+
+    for (; y < height; y ++)
+      ppm_read_line(ppm, linein);
+
+    stats_stage(XFORM_STAGE_COMPRESS);
+  }
+  else
+  {
+    // Write trailing blank lines...
+    memset(line, ras->white, linesize);
+
+    for (; y < ras->header.cupsHeight; y ++)
+      (ras->write_line)(ras, y, lineout, cb, ctx);
+  }
+
+  (ras->end_page)(ras, page, cb, ctx);
+
+  stats_stage(stage);
+
+  Stats.pages ++;
+
+  free(line);
+
+  return (true);
+}
+#endif // !HAVE_COREGRAPHICS_H
+
+
+//
+// 'prepare_documents()' - Prepare one or more documents for printing.
+//
+// This function generates a single PDF file containing the union of the input
+// documents and any job sheets.
+//
+
+static bool				// O - `true` on success, `false` on failure
+prepare_documents(
+    size_t           num_documents,	// I - Number of input documents
+    xform_document_t *documents,	// I - Input documents
+    ipp_options_t    *options,		// I - IPP options
+    const char       *sheet_back,	// I - Back side transform
+    char             *outfile,		// I - Output filename buffer
+    size_t           outsize,		// I - Output filename buffer size
+    const char       *outformat,	// I - Output format
+    unsigned         *outpages,		// O - Number of pages
+    bool             generate_copies)	// I - Generate copies in output PDF?
+{
+  bool			ret = false;	// Return value
+  int			copies;		// Number of copies
+  size_t		i;		// Looping var
+  xform_prepare_t	p;		// Preparation data
+  xform_document_t	*d;		// Current document
+  xform_page_t		*outpage;	// Current output page
+  int			outdir;		// Output direction
+  bool			reverse_order;	// Should output be in reverse order?
+  size_t		layout;		// Layout cell
+  int			document;	// Document number
+  int			page;		// Current page number
+  bool			duplex = !strncmp(options->sides, "two-sided-", 10);
+					// Doing two-sided printing?
+
+
+  // Initialize data for preparing input files for transform...
+  memset(&p, 0, sizeof(p));
+  p.options = options;
+  p.errors  = cupsArrayNew(NULL, NULL, NULL, 0, (cups_acopy_cb_t)strdup, (cups_afree_cb_t)free);
+
+  media_to_rect(&options->media, &p.media, &p.crop);
+  prepare_number_up(&p);
+
+  if (!strncmp(options->sides, "two-sided-", 10) && sheet_back && strcmp(sheet_back, "normal"))
+  {
+    // Need to do a transform on the back side of pages...
+    if (!strcmp(sheet_back, "flipped"))
+    {
+      if (!strcmp(options->sides, "two-sided-short-edge"))
+      {
+	p.use_duplex_xform   = true;
+        p.duplex_xform[0][0] = -1.0;
+        p.duplex_xform[0][1] = 0.0;
+        p.duplex_xform[1][0] = 0.0;
+        p.duplex_xform[1][1] = 1.0;
+        p.duplex_xform[2][0] = p.media.x2;
+        p.duplex_xform[2][1] = 0.0;
+      }
+      else
+      {
+	p.use_duplex_xform   = true;
+        p.duplex_xform[0][0] = 1.0;
+        p.duplex_xform[0][1] = 0.0;
+        p.duplex_xform[1][0] = 0.0;
+        p.duplex_xform[1][1] = -1.0;
+        p.duplex_xform[2][0] = 0.0;
+        p.duplex_xform[2][1] = p.media.y2;
+      }
+    }
+    else if ((!strcmp(sheet_back, "manual-tumble") && !strcmp(options->sides, "two-sided-short-edge")) || (!strcmp(sheet_back, "rotated") && !strcmp(options->sides, "two-sided-long-edge")))
+    {
+      p.use_duplex_xform   = true;
+      p.duplex_xform[0][0] = -1.0;
+      p.duplex_xform[0][1] = 0.0;
+      p.duplex_xform[1][0] = 0.0;
+      p.duplex_xform[1][1] = -1.0;
+      p.duplex_xform[2][0] = p.media.x2;
+      p.duplex_xform[2][1] = p.media.y2;
+    }
+  }
+
+  if ((p.pdf = pdfioFileCreateTemporary(outfile, outsize, "1.7", &p.media, &p.media, pdfio_error_cb, &p)) == NULL)
+    return (false);
+
+  // Loop through the input documents to count pages, etc.
+  for (i = num_documents, d = documents, document = 1, page = 1; i > 0; i --, d ++, document ++)
+  {
+    if (Verbosity)
+      fprintf(stderr, "DEBUG: Preparing document %d: '%s' (%s)\n", document, d->filename, d->format);
+
+    if (!strcmp(d->format, "application/pdf"))
+    {
+      // PDF file...
+      d->pdf_filename = d->filename;
+    }
+    else if (!strcmp(d->format, "image/jpeg") || !strcmp(d->format, "image/png"))
+    {
+      // JPEG or PNG image...
+      if (!convert_image(&p, d, document))
+        goto done;
+    }
+    else if (!strcmp(d->format, "text/plain"))
+    {
+      // Plain text file...
+      if (!convert_text(&p, d, document))
+        goto done;
+    }
+    else
+    {
+      // PWG or Apple raster file...
+      if (!convert_raster(&p, d, document))
+        goto done;
+    }
+
+    if (Verbosity)
+      fprintf(stderr, "DEBUG: Opening prepared document %d: '%s'.\n", document, d->pdf_filename);
+
+    if ((d->pdf = pdfioFileOpen(d->pdf_filename, pdfio_password_cb, &document, pdfio_error_cb, &p)) == NULL)
+      goto done;
+
+    if (options->multiple_document_handling < IPPOPT_HANDLING_SINGLE_DOCUMENT)
+    {
+      d->first_page = 1;
+      d->last_page  = (int)pdfioFileGetNumPages(d->pdf);
+    }
+    else
+    {
+      d->first_page = page;
+      d->last_page  = page + (int)pdfioFileGetNumPages(d->pdf) - 1;
+    }
+
+    if (Verbosity)
+      fprintf(stderr, "DEBUG: Document %d: pages %d to %d.\n", document, d->first_page, d->last_page);
+
+    while (page <= d->last_page)
+    {
+      if (options->multiple_document_handling < IPPOPT_HANDLING_SINGLE_DOCUMENT)
+      {
+        if (ippOptionsCheckPage(options, page - d->first_page + 1))
+          d->num_pages ++;
+      }
+      else if (ippOptionsCheckPage(options, page))
+      {
+        d->num_pages ++;
+      }
+
+      page ++;
+    }
+
+    if ((d->last_page & 1) && duplex && options->multiple_document_handling != IPPOPT_HANDLING_SINGLE_DOCUMENT)
+    {
+      d->last_page ++;
+      page ++;
+    }
+
+    if ((d->num_pages & 1) && duplex && options->multiple_document_handling != IPPOPT_HANDLING_SINGLE_DOCUMENT)
+      d->num_pages ++;
+
+    p.num_inpages += d->num_pages;
+  }
+
+  // When doing N-up or booklet printing, the default is to scale to fit unless
+  // fill is explicitly chosen...
+  if (p.num_layout > 1 && options->print_scaling != IPPOPT_SCALING_FILL)
+    options->print_scaling = IPPOPT_SCALING_FIT;
+
+  // Prepare output pages...
+  prepare_pages(&p, num_documents, documents);
+
+  // Add job-sheets content...
+  if (options->job_sheets[0] && strcmp(options->job_sheets, "none"))
+    generate_job_sheets(&p);
+
+  // Copy pages to the output file...
+  for (copies = generate_copies ? options->copies : 1; copies > 0; copies --)
+  {
+    reverse_order = !strcmp(options->output_bin, "face-up");
+    if (options->page_delivery >= IPPOPT_DELIVERY_REVERSE_ORDER_FACE_DOWN)
+      reverse_order = !reverse_order;
+
+    if (reverse_order)
+    {
+      outpage = p.outpages + p.num_outpages - 1;
+      outdir  = -1;
+    }
+    else
+    {
+      outpage = p.outpages;
+      outdir  = 1;
+    }
+
+    if (p.num_layout == 1 && options->print_scaling == IPPOPT_SCALING_NONE && strcasecmp(outformat, "image/pwg-raster") && strcasecmp(outformat, "image/urf"))
+    {
+      // Simple path - no layout/scaling/rotation of pages so we can just copy the pages quickly.
+      if (Verbosity)
+	fputs("DEBUG: Doing fast copy of pages.\n", stderr);
+
+      for (i = p.num_outpages; i > 0; i --, outpage += outdir)
+      {
+	if (outpage->input[0])
+	  pdfioPageCopy(p.pdf, outpage->input[0]);
+      }
+    }
+    else
+    {
+      // Layout path - merge page resources and do mapping of resources as needed
+      if (Verbosity)
+	fprintf(stderr, "DEBUG: Doing full layout of %u pages.\n", (unsigned)p.num_outpages);
+
+      for (i = p.num_outpages; i > 0; i --, outpage += outdir)
+      {
+	// Create a page dictionary that merges the resources from each of the
+	// input pages...
+	if (Verbosity)
+	  fprintf(stderr, "DEBUG: Laying out page %u/%u.\n", (unsigned)(outpage - p.outpages + 1), (unsigned)p.num_outpages);
+
+	outpage->pagedict = pdfioDictCreate(p.pdf);
+	outpage->resdict  = pdfioDictCreate(p.pdf);
+
+	pdfioDictSetRect(outpage->pagedict, "CropBox", &p.media);
+	pdfioDictSetRect(outpage->pagedict, "MediaBox", &p.media);
+	pdfioDictSetDict(outpage->pagedict, "Resources", outpage->resdict);
+	pdfioDictSetName(outpage->pagedict, "Type", "Page");
+
+	for (layout = 0; layout < p.num_layout; layout ++)
+	{
+	  pdfio_dict_t	*pagedict,	// Page dictionary
+			*resdict;	// Resources dictionary
+	  pdfio_obj_t	*resobj;	// Resources object
+
+	  if (!outpage->input[layout])
+	    continue;
+
+	  outpage->layout  = layout;
+	  outpage->restype = NULL;
 
           pagedict = pdfioObjGetDict(outpage->input[layout]);
           if ((resdict = pdfioDictGetDict(pagedict, "Resources")) != NULL)
@@ -3650,6 +4881,239 @@ resource_dict_cb(
 }
 
 
+//
+// 'stats_get_time()' - Get the current wall clock and CPU times in seconds.
+//
+// The CPU time is for the calling thread when supported.
+//
+
+static void
+stats_get_time(double *wall,		// O - Wall clock time
+               double *cpu)		// O - CPU time
+{
+#if _WIN32
+  *wall = 0.001 * GetTickCount64();
+  *cpu  = (double)clock() / CLOCKS_PER_SEC;
+
+#else
+  struct timespec	curtime;	// Current time
+
+
+  clock_gettime(CLOCK_MONOTONIC, &curtime);
+  *wall = curtime.tv_sec + 0.000000001 * curtime.tv_nsec;
+
+#  ifdef CLOCK_THREAD_CPUTIME_ID
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &curtime);
+#  else
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &curtime);
+#  endif // CLOCK_THREAD_CPUTIME_ID
+  *cpu = curtime.tv_sec + 0.000000001 * curtime.tv_nsec;
+#endif // _WIN32
+}
+
+
+//
+// 'stats_read()' - Read and count input bytes.
+//
+
+static ssize_t				// O - Number of bytes read or -1 on error
+stats_read(int           *fd,		// I - File descriptor
+           unsigned char *buffer,	// I - Buffer
+           size_t        bytes)		// I - Maximum number of bytes to read
+{
+  ssize_t	count;			// Bytes read
+
+
+  while ((count = read(*fd, buffer, bytes)) < 0)
+  {
+    if (errno != EINTR && errno != EAGAIN)
+      return (-1);
+  }
+
+  Stats.bytes_in += (size_t)count;
+
+  return (count);
+}
+
+
+//
+// 'stats_report()' - Report processing statistics.
+//
+// The statistics are reported as "ATTR:" lines that the caller can record as
+// job attributes or as a single line JSON object.  "ATTR:" times are in
+// milliseconds and sizes in kilobytes.
+//
+
+static void
+stats_report(void)
+{
+  xform_stage_t	stage;			// Current stage
+  double	wall,			// Wall clock time
+		cpu,			// CPU time
+		helper = 0.0;		// CPU time for helper programs
+  long		rss = 0;		// Peak resident set size in bytes
+#if !_WIN32
+  struct rusage	usage;			// Resource usage
+#endif // !_WIN32
+  static const char * const names[] =	// Stage names
+  {
+    "setup",
+    "prepare",
+    "render",
+    "dither",
+    "compress",
+    "write"
+  };
+
+
+  // Finish timing the current stage...
+  stats_get_time(&wall, &cpu);
+
+  Stats.wall[Stats.stage] += wall - Stats.wall_last;
+  Stats.cpu[Stats.stage]  += cpu - Stats.cpu_last;
+
+  wall -= Stats.wall_start;
+  cpu  -= Stats.cpu_start;
+
+#if !_WIN32
+  // Use the total CPU time for all threads and helper programs...
+  if (!getrusage(RUSAGE_SELF, &usage))
+  {
+    cpu = usage.ru_utime.tv_sec + 0.000001 * usage.ru_utime.tv_usec + usage.ru_stime.tv_sec + 0.000001 * usage.ru_stime.tv_usec;
+#  ifdef __APPLE__
+    rss = usage.ru_maxrss;
+#  else
+    rss = usage.ru_maxrss * 1024;
+#  endif // __APPLE__
+  }
+
+  if (!getrusage(RUSAGE_CHILDREN, &usage))
+    helper = usage.ru_utime.tv_sec + 0.000001 * usage.ru_utime.tv_usec + usage.ru_stime.tv_sec + 0.000001 * usage.ru_stime.tv_usec;
+#endif // !_WIN32
+
+  if (Stats.json)
+  {
+    // Report statistics as a JSON object...
+    cups_json_t	*json,			// JSON object
+		*stages,		// Stages object
+		*sobj,			// Stage object
+		*current = NULL,	// Current value
+		*scurrent;		// Current stage value
+    char	*s;			// JSON string
+
+    json = cupsJSONNew(NULL, NULL, CUPS_JTYPE_OBJECT);
+
+    current = cupsJSONNewNumber(json, cupsJSONNewKey(json, current, "pages"), Stats.pages);
+    current = cupsJSONNewNumber(json, cupsJSONNewKey(json, current, "pages-per-second"), wall > 0.0 ? Stats.pages / wall : 0.0);
+    current = cupsJSONNewNumber(json, cupsJSONNewKey(json, current, "bytes-in"), Stats.bytes_in);
+    current = cupsJSONNewNumber(json, cupsJSONNewKey(json, current, "bytes-out"), Stats.bytes_out);
+    current = cupsJSONNewNumber(json, cupsJSONNewKey(json, current, "peak-rss"), rss);
+    current = cupsJSONNewNumber(json, cupsJSONNewKey(json, current, "wall-seconds"), wall);
+    current = cupsJSONNewNumber(json, cupsJSONNewKey(json, current, "cpu-seconds"), cpu);
+    current = cupsJSONNewNumber(json, cupsJSONNewKey(json, current, "helper-cpu-seconds"), helper);
+    stages  = cupsJSONNew(json, cupsJSONNewKey(json, current, "stages"), CUPS_JTYPE_OBJECT);
+
+    for (stage = XFORM_STAGE_SETUP, current = NULL; stage < XFORM_STAGE_MAX; stage ++)
+    {
+      sobj     = cupsJSONNew(stages, cupsJSONNewKey(stages, current, names[stage]), CUPS_JTYPE_OBJECT);
+      scurrent = cupsJSONNewNumber(sobj, cupsJSONNewKey(sobj, NULL, "wall-seconds"), Stats.wall[stage]);
+      cupsJSONNewNumber(sobj, cupsJSONNewKey(sobj, scurrent, "cpu-seconds"), Stats.cpu[stage]);
+      current = sobj;
+    }
+
+    if ((s = cupsJSONExportString(json)) != NULL)
+    {
+      fprintf(stderr, "%s\n", s);
+      free(s);
+    }
+
+    cupsJSONDelete(json);
+  }
+  else
+  {
+    // Report statistics as job attributes...
+    fprintf(stderr, "ATTR: ipptransform-pages=%u ipptransform-pages-per-minute=%d ipptransform-k-octets-in=%lu ipptransform-k-octets-out=%lu ipptransform-peak-rss-k-octets=%ld ipptransform-wall-msec=%d ipptransform-cpu-msec=%d ipptransform-helper-cpu-msec=%d\n", Stats.pages, wall > 0.0 ? (int)(60.0 * Stats.pages / wall) : 0, (unsigned long)((Stats.bytes_in + 1023) / 1024), (unsigned long)((Stats.bytes_out + 1023) / 1024), (rss + 1023) / 1024, (int)(1000.0 * wall), (int)(1000.0 * cpu), (int)(1000.0 * helper));
+
+    for (stage = XFORM_STAGE_SETUP; stage < XFORM_STAGE_MAX; stage ++)
+      fprintf(stderr, "ATTR: ipptransform-%s-wall-msec=%d ipptransform-%s-cpu-msec=%d\n", names[stage], (int)(1000.0 * Stats.wall[stage]), names[stage], (int)(1000.0 * Stats.cpu[stage]));
+  }
+}
+
+
+//
+// 'stats_stage()' - Change the current processing stage.
+//
+// The time since the last change is added to the previous stage, which is
+// returned so that nested stages can restore it.  Statistics are only
+// collected by the main thread.
+//
+
+static xform_stage_t			// O - Previous stage
+stats_stage(xform_stage_t stage)	// I - New stage
+{
+  xform_stage_t	prev = Stats.stage;	// Previous stage
+  double	wall,			// Wall clock time
+		cpu;			// CPU time
+
+
+  if (!Stats.enabled || stage == prev)
+    return (prev);
+
+  stats_get_time(&wall, &cpu);
+
+  Stats.wall[prev] += wall - Stats.wall_last;
+  Stats.cpu[prev]  += cpu - Stats.cpu_last;
+  Stats.wall_last  = wall;
+  Stats.cpu_last   = cpu;
+  Stats.stage      = stage;
+
+  return (prev);
+}
+
+
+//
+// 'stats_start()' - Start collecting processing statistics.
+//
+
+static void
+stats_start(const char *format)		// I - Report format ("json" or "attr")
+{
+  Stats.enabled = true;
+  Stats.json    = !strcasecmp(format, "json");
+  Stats.stage   = XFORM_STAGE_SETUP;
+
+  stats_get_time(&Stats.wall_start, &Stats.cpu_start);
+
+  Stats.wall_last = Stats.wall_start;
+  Stats.cpu_last  = Stats.cpu_start;
+}
+
+
+//
+// 'stats_write()' - Time and count output bytes.
+//
+
+static ssize_t				// O - Number of bytes written or -1 on error
+stats_write(void       *ctx,		// I - Write context (unused)
+            const void *buffer,		// I - Buffer
+            size_t     bytes)		// I - Number of bytes to write
+{
+  ssize_t	count;			// Bytes written
+  xform_stage_t	stage = stats_stage(XFORM_STAGE_WRITE);
+					// Previous stage
+
+
+  (void)ctx;
+
+  if ((count = (Stats.cb)(Stats.ctx, buffer, bytes)) > 0)
+    Stats.bytes_out += (size_t)count;
+
+  stats_stage(stage);
+
+  return (count);
+}
+
+
 //
 // 'usage()' - Show program usage.
 //
@@ -3660,6 +5124,8 @@ usage(FILE *out)			// I - Output file
   cupsLangPuts(out, _("Usage: ipptransform [OPTIONS] FILENAME [ ... FILENAME]"));
   cupsLangPuts(out, _("Options:"));
   cupsLangPuts(out, _("--help                         Show this help"));
+  cupsLangPuts(out, _("--stats                        Report processing statistics"));
+  cupsLangPuts(out, _("--stats-json                   Report processing statistics as JSON"));
   cupsLangPuts(out, _("--version                      Show the program version"));
   cupsLangPuts(out, _("-d DEVICE-URI                  Specify the output device"));
   cupsLangPuts(out, _("-f OUTPUT-FILENAME             Specify the output file"));
@@ -3681,6 +5147,7 @@ usage(FILE *out)			// I - Output file
   cupsLangPuts(out, _("image/jpeg                     Joint Photographic Experts Group (JPEG) image"));
   cupsLangPuts(out, _("image/png                      Portable Network Graphics (PNG) image"));
   cupsLangPuts(out, _("image/pwg-raster               PWG Raster Format document"));
+  cupsLangPuts(out, _("image/urf                      Apple raster document"));
   cupsLangPuts(out, _("text/plain                     Plain text document"));
 
   cupsLangPuts(out, _("Output Formats:"));
@@ -4005,6 +5472,8 @@ xform_document(
 	  if (Verbosity > 1)
 	    fprintf(stderr, "DEBUG: Drawing band from %u to %u.\n", band_starty, band_endy);
 
+	  stats_stage(XFORM_STAGE_RENDER);
+
 	  CGContextSaveGState(context);
 	    if (ras.header.cupsNumColors == 1)
 	      CGContextSetGrayFillColor(context, 1., 1.);
@@ -4027,6 +5496,8 @@ xform_document(
 	}
 
         // Prepare and write a line...
+	stats_stage(XFORM_STAGE_DITHER);
+
 	lineptr = ras.band_buffer + (y - band_starty) * band_size + ras.left * ras.band_bpp;
 	if (ras.header.cupsBitsPerPixel == 1)
 	  dither_gray(&ras, y, lineptr, ras.right - ras.left);
@@ -4037,11 +5508,17 @@ xform_document(
 	else if (ras.header.cupsBitsPerPixel == 48)
 	  pack_rgba16(lineptr, ras.right - ras.left);
 
+	stats_stage(XFORM_STAGE_COMPRESS);
+
 	(ras.write_line)(&ras, y, lineptr, cb, ctx);
       }
 
       (ras.end_page)(&ras, page, cb, ctx);
 
+      stats_stage(XFORM_STAGE_SETUP);
+
+      Stats.pages ++;
+
       // Log progress...
       impressions ++;
       fprintf(stderr, "ATTR: job-impressions-completed=%u\n", impressions);
@@ -4110,6 +5587,16 @@ xform_document(
 //
 // 'xform_document()' - Transform a file for printing.
 //
+// The "IPPTRANSFORM_THREADS" environment variable sets the number of pages
+// that are rendered at the same time by separate pdftoppm processes.  Rendered
+// pages are written in order and at most one page per thread is buffered in
+// memory.
+//
+// For collated copies, the page images from the first copy are cached and
+// reused for the remaining copies.  The "IPPTRANSFORM_MAX_CACHE" environment
+// variable sets the maximum number of bytes to cache, and pages that do not fit
+// are rendered again for each copy.
+//
 
 static bool				// O - `true` on success, `false` on error
 xform_document(
@@ -4132,12 +5619,24 @@ xform_document(
   char		command[1024],		// pdftoppm command
 		output[1024];		// Ouptut from pdftoppm
   FILE		*fp;			// Pipe for output
-  char		header[256];		// Header from file
-  unsigned char	*line = NULL,		// Pixel line from file
-		*linein,		// Pointer to input pixels
-		*lineout;		// Pointer to output pixels
-  size_t	linesize;		// Size of a line...
-  bool		poppler = false;	// Are we using Poppler's pdftoppm?
+  xform_ppm_t	ppm;			// Page image
+  bool		poppler = false,	// Are we using Poppler's pdftoppm?
+		ret = true;		// Return value
+  const char	*threads_env,		// IPPTRANSFORM_THREADS env var
+		*max_cache_env;		// IPPTRANSFORM_MAX_CACHE env var
+  unsigned	i,			// Looping var
+		inpage,			// Current input page
+		num_threads = 1,	// Number of rendering threads
+		num_created;		// Number of threads created
+  cups_thread_t	threads[XFORM_MAX_THREADS];
+					// Rendering threads
+  xform_ppmqueue_t queue;		// Page queue
+  xform_ppm_t	*cache = NULL;		// Cached page images for copies
+  size_t	cache_bytes = 0,	// Bytes in cached page images
+		max_cache = XFORM_MAX_CACHE;
+					// Maximum bytes to cache
+  unsigned	num_cached = 0;		// Number of cached page images
+  bool		use_cache;		// Write this copy from the cache?
 
 
   // Find the pdftoppm program...
@@ -4162,6 +5661,32 @@ xform_document(
   if (Verbosity > 1)
     fprintf(stderr, "DEBUG: cupsPageSize=[%g %g]\n", ras.header.cupsPageSize[0], ras.header.cupsPageSize[1]);
 
+  threads_env = getenv("IPPTRANSFORM_THREADS");
+  if (threads_env && strtol(threads_env, NULL, 10) > 1)
+  {
+    if ((num_threads = (unsigned)strtol(threads_env, NULL, 10)) > XFORM_MAX_THREADS)
+      num_threads = XFORM_MAX_THREADS;
+  }
+
+  if (num_threads > pages)
+    num_threads = pages;
+
+  if (num_threads > 1)
+  {
+    // Each rendering thread buffers a whole page image, so limit the number
+    // of threads for high resolution and large media...
+    size_t page_bytes = (size_t)ras.header.cupsWidth * ras.header.cupsHeight * (ras.header.cupsBitsPerPixel <= 8 ? 1 : 3);
+					// Bytes per page image
+
+    if (page_bytes > 0 && num_threads > XFORM_MAX_BUFFERED / page_bytes)
+    {
+      if ((num_threads = (unsigned)(XFORM_MAX_BUFFERED / page_bytes)) < 1)
+        num_threads = 1;
+
+      fprintf(stderr, "DEBUG: Limiting rendering to %u threads for %lu byte page images.\n", num_threads, (unsigned long)page_bytes);
+    }
+  }
+
   (ras.start_job)(&ras, cb, ctx);
 
   if (options->multiple_document_handling == IPPOPT_HANDLING_UNCOLLATED_COPIES)
@@ -4181,7 +5706,17 @@ xform_document(
     copies                    = options->copies;
   }
 
-  for (copy = 0; copy < copies; copy ++)
+  if (copies > 1)
+  {
+    // Cache the page images from the first copy...
+    if ((max_cache_env = getenv("IPPTRANSFORM_MAX_CACHE")) != NULL && strtol(max_cache_env, NULL, 10) >= 0)
+      max_cache = (size_t)strtol(max_cache_env, NULL, 10);
+
+    if (max_cache > 0)
+      cache = calloc(pages, sizeof(xform_ppm_t));
+  }
+
+  for (copy = 0; copy < copies && ret; copy ++)
   {
     // Write a separator sheet as needed...
     switch (options->separator_type)
@@ -4200,10 +5735,7 @@ xform_document(
           break;
     }
 
-    // There are two versions of the pdftoppm command - the one that comes with
-    // Xpdf and the one that comes with Poppler which forked from Xpdf in the
-    // v3.0 days.  Unfortunately, the two commands have drifted apart so we need
-    // to determine *which* pdftoppm command is available...
+    // Determine *which* pdftoppm command is available...
 #if _WIN32
     snprintf(command, sizeof(command), "%s -v", PdftoppmCommand);
     if ((fp = _popen(command, "r")) != NULL)
@@ -4223,208 +5755,256 @@ xform_document(
 #else
       pclose(fp);
 #endif // _WIN32
-
-      fprintf(stderr, "DEBUG: Using %s version of pdftoppm.\n", poppler ? "Poppler" : "Xpdf");
-    }
-    else
-    {
-      cupsLangPrintf(stderr, _("%s: Unable to run pdftoppm command: %s"), Prefix, strerror(errno));
-      return (false);
-    }
-
-    // Run the pdftoppm command:
-    //
-    //   Poppler:
-    //     pdftoppm [-gray] -thinlinemode solid -aa no -r resolution -scale-to HEIGHT filename
-    //
-    //   Xpdf:
-    //     pdftoppm [-gray] -aa no -r resolution filename -
-    if (poppler)
-      snprintf(command, sizeof(command), "%s %s -aa no -r %u -scale-to %u '%s'", PdftoppmCommand, ras.header.cupsBitsPerPixel <= 8 ? "-gray" : "", ras.header.HWResolution[0], ras.header.cupsHeight, filename);
-    else
-      snprintf(command, sizeof(command), "%s %s -aa no -r %u '%s' -", PdftoppmCommand, ras.header.cupsBitsPerPixel <= 8 ? "-gray" : "", ras.header.HWResolution[0], filename);
-
-    fprintf(stderr, "DEBUG: Running \"%s\".\n", command);
-#if _WIN32
-    if ((fp = _popen(command, "rb")) == NULL)
-#else
-    if ((fp = popen(command, "r")) == NULL)
-#endif // _WIN32
+
+      fprintf(stderr, "DEBUG: Using %s version of pdftoppm.\n", poppler ? "Poppler" : "Xpdf");
+    }
+    else
     {
       cupsLangPrintf(stderr, _("%s: Unable to run pdftoppm command: %s"), Prefix, strerror(errno));
       return (false);
     }
 
-    // Read lines from the file...
-    while (fgets(header, sizeof(header), fp))
-    {
-      // Got the P4/5/6 header...
-      unsigned	y,			// Current Y position
-		ystart,			// Start Y position
-		yend;			// End Y position
-      unsigned	width, height;		// Width and height from image...
-      unsigned	bpp;			// Bytes per pixel
+    num_created = 0;
+    use_cache   = copy > 0 && num_cached > 0;
 
-      if (!strcmp(header, "P5\n"))
-      {
-        bpp = 1;
-      }
-      else if (!strcmp(header, "P6\n"))
+    if (num_threads > 1 && !use_cache)
+    {
+      // Start threads to render pages in parallel...
+      memset(&queue, 0, sizeof(queue));
+      cupsMutexInit(&queue.mutex);
+      cupsCondInit(&queue.cond);
+
+      queue.ras       = &ras;
+      queue.filename  = filename;
+      queue.poppler   = poppler;
+      queue.num_pages = pages;
+      queue.next_page = 1;
+      queue.depth     = num_threads;
+
+      if ((queue.slots = calloc(queue.depth, sizeof(xform_ppm_t))) == NULL)
       {
-        bpp = 3;
+	cupsLangPrintf(stderr, _("%s: Out of memory."), Prefix);
+	return (false);
       }
-      else
+
+      for (; num_created < num_threads; num_created ++)
       {
-        cupsLangPrintf(stderr, _("%s: Bad page header - <%02X%02X%02X%02X%02X%02X%02X%02X>"), Prefix, header[0] & 255, header[1] & 255, header[2] & 255, header[3] & 255, header[4] & 255, header[5] & 255, header[6] & 255, header[7] & 255);
-        break;
+        if ((threads[num_created] = cupsThreadCreate((cups_thread_func_t)ppm_thread, &queue)) == CUPS_THREAD_INVALID)
+          break;
       }
 
-      if (Verbosity)
+      if (num_created == 0)
       {
-	header[strlen(header) - 1] = '\0';
-        fprintf(stderr, "DEBUG: '%s'\n", header);
+        // Unable to create threads, render pages sequentially instead...
+	free(queue.slots);
+	cupsCondDestroy(&queue.cond);
+	cupsMutexDestroy(&queue.mutex);
       }
+    }
 
-      // Now get the bitmap dimensions...
-      if (!fgets(header, sizeof(header), fp))
-        break;
+    if (use_cache)
+    {
+      // Write the cached page images, rendering any pages that did not fit...
+      fprintf(stderr, "DEBUG: Writing copy %d using %u cached pages.\n", copy + 1, num_cached);
 
-      if (Verbosity)
+      for (inpage = 1; inpage <= pages; inpage ++)
       {
-	header[strlen(header) - 1] = '\0';
-        fprintf(stderr, "DEBUG: '%s'\n", header);
-      }
+        if (cache[inpage - 1].pixels)
+        {
+          ppm        = cache[inpage - 1];
+          ppm.pixptr = ppm.pixels;
+        }
+        else
+        {
+	  xform_stage_t stage = stats_stage(XFORM_STAGE_RENDER);
+					// Previous statistics stage
 
-      if (sscanf(header, "%u%u", &width, &height) != 2 || width > 0x10000000 || height > 0x40000000)
-      {
-        cupsLangPrintf(stderr, _("%s: Bad page dimensions - <%02X%02X%02X%02X%02X%02X%02X%02X>"), Prefix, header[0] & 255, header[1] & 255, header[2] & 255, header[3] & 255, header[4] & 255, header[5] & 255, header[6] & 255, header[7] & 255);
-        break;
-      }
+          ppm_render_page(&ras, filename, poppler, inpage, &ppm);
 
-      if (width > ras.header.cupsWidth)
-        linesize = width * bpp;
-      else
-	linesize = ras.header.cupsWidth * bpp;
+          stats_stage(stage);
 
-      if ((line = malloc(linesize)) == NULL)
-      {
-	cupsLangPrintf(stderr, _("%s: Out of memory."), Prefix);
-#if _WIN32
-        _pclose(fp);
-#else
-        pclose(fp);
-#endif // _WIN32
-	return (false);
-      }
+          if (!ppm.pixels)
+          {
+            ret = false;
+            break;
+          }
+        }
 
-      if (width > ras.header.cupsWidth)
-      {
-        linein  = line;
-        lineout = line + ((width - ras.header.cupsWidth) / 2 + ras.left) * bpp;
-      }
-      else
-      {
-        linein  = line + (ras.header.cupsWidth - width) / 2 * bpp;
-        lineout = line + ras.left * bpp;
-      }
+        page ++;
 
-      if (height > ras.header.cupsHeight)
-      {
-        ystart = (height - ras.header.cupsHeight) / 2;
-        yend   = ystart + ras.header.cupsHeight;
-      }
-      else
-      {
-        ystart = (ras.header.cupsHeight - height) / 2;
-        yend   = ystart + height;
-      }
+        if (!ppm_write_page(&ras, &ppm, page, cb, ctx))
+          ret = false;
 
-      memset(line, ras.white, linesize);
+        if (!cache[inpage - 1].pixels)
+          free(ppm.pixels);
 
-      // Skip max value line...
-      if (!fgets(header, sizeof(header), fp))
-        break;
+        if (!ret)
+          break;
 
-      if (Verbosity)
-      {
-	header[strlen(header) - 1] = '\0';
-        fprintf(stderr, "DEBUG: '%s'\n", header);
-        fprintf(stderr, "DEBUG: width=%u, height=%u, bpp=%u, ystart=%u, yend=%u\n", width, height, bpp, ystart, yend);
+	// Log progress...
+	impressions ++;
+	fprintf(stderr, "ATTR: job-impressions-completed=%u\n", impressions);
+	if (!ras.header.Duplex || !(page & 1))
+	{
+	  media_sheets ++;
+	  fprintf(stderr, "ATTR: job-media-sheets-completed=%u\n", media_sheets);
+	}
       }
+    }
+    else if (num_created > 0)
+    {
+      // Write the rendered pages in order...
+      fprintf(stderr, "DEBUG: Rendering pages using %u threads.\n", num_created);
 
-      // Send the page to the driver...
-      page ++;
+      for (inpage = 1; inpage <= pages; inpage ++)
+      {
+        xform_ppm_t *slot = queue.slots + (inpage - 1) % queue.depth;
+					// Page slot
 
-      (ras.start_page)(&ras, page, cb, ctx);
+        // Wait for the page to be rendered...
+        xform_stage_t stage = stats_stage(XFORM_STAGE_RENDER);
+					// Previous statistics stage
 
-      ras.out_length = ((ras.right - ras.left) * ras.header.cupsBitsPerPixel + 7) / 8;
+        cupsMutexLock(&queue.mutex);
+        while (slot->page != inpage)
+          cupsCondWait(&queue.cond, &queue.mutex, 0.0);
+        ppm = *slot;
+        cupsMutexUnlock(&queue.mutex);
 
-      if (height > ras.header.cupsHeight)
-      {
-        // Skip leading lines...
-        for (y = 0; y < ystart; y ++)
-          fread(linein, width, bpp, fp);
-      }
-      else
-      {
-        // Write leading blank lines...
-        for (y = 0; y < ystart; y ++)
-          (ras.write_line)(&ras, y, lineout, cb, ctx);
-      }
+        stats_stage(stage);
 
-      for (; y < yend; y ++)
-      {
-        // Copy lines...
-        memset(line, 255, linesize);
+        if (!ppm.pixels)
+          break;
 
-        if (fread(linein, width, bpp, fp))
-        {
-	  if (ras.header.cupsBitsPerPixel == 1)
-	    dither_gray(&ras, y, lineout, ras.right - ras.left);
-	  else if (ras.header.cupsColorSpace == CUPS_CSPACE_K)
-	    pack_black(lineout, ras.right - ras.left);
+        page ++;
 
-          (ras.write_line)(&ras, y, lineout, cb, ctx);
+        if (!ppm_write_page(&ras, &ppm, page, cb, ctx))
+          ret = false;
+
+        if (cache && copy == 0 && (size_t)(ppm.pixend - ppm.pixels) <= max_cache - cache_bytes)
+        {
+          // Keep the page image for the remaining copies...
+          cache[inpage - 1] = ppm;
+          cache_bytes += (size_t)(ppm.pixend - ppm.pixels);
+          num_cached ++;
+        }
+        else
+        {
+          free(ppm.pixels);
         }
+
+        // Free the slot...
+        cupsMutexLock(&queue.mutex);
+        slot->page   = 0;
+        slot->pixels = NULL;
+        queue.num_written ++;
+        cupsCondBroadcast(&queue.cond);
+        cupsMutexUnlock(&queue.mutex);
+
+        if (!ret)
+          break;
+
+	// Log progress...
+	impressions ++;
+	fprintf(stderr, "ATTR: job-impressions-completed=%u\n", impressions);
+	if (!ras.header.Duplex || !(page & 1))
+	{
+	  media_sheets ++;
+	  fprintf(stderr, "ATTR: job-media-sheets-completed=%u\n", media_sheets);
+	}
       }
 
-      if (height > ras.header.cupsHeight)
+      // Stop any remaining rendering and clean up...
+      cupsMutexLock(&queue.mutex);
+      queue.canceled = true;
+      cupsCondBroadcast(&queue.cond);
+      cupsMutexUnlock(&queue.mutex);
+
+      for (i = 0; i < num_created; i ++)
+        cupsThreadWait(threads[i]);
+
+      for (i = 0; i < queue.depth; i ++)
+        free(queue.slots[i].pixels);
+
+      free(queue.slots);
+      cupsCondDestroy(&queue.cond);
+      cupsMutexDestroy(&queue.mutex);
+    }
+    else
+    {
+      // Run the pdftoppm command for all pages...
+      ppm_command(command, sizeof(command), &ras, filename, poppler, 0);
+
+      fprintf(stderr, "DEBUG: Running \"%s\".\n", command);
+#if _WIN32
+      if ((fp = _popen(command, "rb")) == NULL)
+#else
+      if ((fp = popen(command, "r")) == NULL)
+#endif // _WIN32
       {
-        // Skip trailing lines...
-        for (; y < height; y ++)
-          fread(linein, width, bpp, fp);
+	cupsLangPrintf(stderr, _("%s: Unable to run pdftoppm command: %s"), Prefix, strerror(errno));
+	return (false);
       }
-      else
+
+      // Read pages from the file...
+      stats_stage(XFORM_STAGE_RENDER);
+
+      while (ret && ppm_read_header(fp, &ppm))
       {
-        // Write trailing blank lines...
-        memset(line, ras.white, linesize);
+	size_t ppm_bytes = (size_t)ppm.width * ppm.height * ppm.bpp;
+					// Bytes in page image
 
-        for (; y < ras.header.cupsHeight; y ++)
-          (ras.write_line)(&ras, y, lineout, cb, ctx);
-      }
+	if (cache && copy == 0 && page < pages && ppm_bytes <= max_cache - cache_bytes && !ppm_read_pixels(fp, &ppm))
+	{
+	  // Unable to buffer the page image for the cache...
+	  ret = false;
+	  break;
+	}
 
-      (ras.end_page)(&ras, page, cb, ctx);
+	stats_stage(XFORM_STAGE_SETUP);
 
-      free(line);
-      line = NULL;
+	page ++;
 
-      // Log progress...
-      impressions ++;
-      fprintf(stderr, "ATTR: job-impressions-completed=%u\n", impressions);
-      if (!ras.header.Duplex || !(page & 1))
-      {
-	media_sheets ++;
-	fprintf(stderr, "ATTR: job-media-sheets-completed=%u\n", media_sheets);
+	if (!ppm_write_page(&ras, &ppm, page, cb, ctx))
+	{
+	  free(ppm.pixels);
+	  ret = false;
+	  break;
+	}
+
+	if (ppm.pixels)
+	{
+	  // Keep the page image for the remaining copies...
+	  cache[page - 1] = ppm;
+	  cache_bytes += ppm_bytes;
+	  num_cached ++;
+	}
+
+	// Log progress...
+	impressions ++;
+	fprintf(stderr, "ATTR: job-impressions-completed=%u\n", impressions);
+	if (!ras.header.Duplex || !(page & 1))
+	{
+	  media_sheets ++;
+	  fprintf(stderr, "ATTR: job-media-sheets-completed=%u\n", media_sheets);
+	}
+
+	stats_stage(XFORM_STAGE_RENDER);
       }
-    }
 
-    // Close things out...
+      // Close things out...
 #if _WIN32
-    _pclose(fp);
+      _pclose(fp);
 #else
-    pclose(fp);
+      pclose(fp);
 #endif // _WIN32
 
+      stats_stage(XFORM_STAGE_SETUP);
+    }
+
+    if (!ret)
+      break;
+
     // Write a separator sheet as needed...
     switch (options->separator_type)
     {
@@ -4440,11 +6020,18 @@ xform_document(
     }
   }
 
-  free(line);
+  if (ret)
+    (ras.end_job)(&ras, cb, ctx);
 
-  (ras.end_job)(&ras, cb, ctx);
+  if (cache)
+  {
+    for (i = 0; i < pages; i ++)
+      free(cache[i].pixels);
 
-  return (true);
+    free(cache);
+  }
+
+  return (ret);
 }
 #endif // HAVE_COREGRAPHICS_H
 
@@ -4533,6 +6120,196 @@ xform_separator(xform_raster_t   *ras,	// I - Raster information
 }
 
 
+#ifndef HAVE_COREGRAPHICS_H
+//
+// 'xform_stream()' - Transform raster documents as they are read.
+//
+// PWG and Apple raster documents are sent to the output one page at a time
+// without preparing a PDF file, so output starts as soon as the first page has
+// been read.  The filename "-" reads a document from the standard input.
+//
+
+static bool				// O - `true` on success, `false` on failure
+xform_stream(
+    size_t           num_documents,	// I - Number of input documents
+    xform_document_t *documents,	// I - Input documents
+    ipp_options_t    *options,		// I - IPP options
+    const char       *outformat,	// I - Output format (MIME media type)
+    const char       *resolutions,	// I - Supported resolutions
+    const char       *sheet_back,	// I - Back side transform
+    const char       *types,		// I - Supported types
+    xform_write_cb_t cb,		// I - Write callback
+    void             *ctx)		// I - Write context
+{
+  xform_raster_t ras;			// Raster information
+  int		copy,			// Current copy
+		copies;			// Number of collated copies
+  unsigned	page = 0,		// Current page
+		media_sheets = 0,
+		impressions = 0;	// Page/sheet counters
+  size_t	i;			// Looping var
+  xform_document_t *d;			// Current document
+  int		fd;			// Document file
+  cups_raster_t	*raster;		// Raster stream
+  xform_ppm_t	ppm;			// Page image
+  int		status;			// Status of page read
+  bool		ret = true;		// Return value
+
+
+  // Setup the raster headers - the number of pages is not known in advance...
+  if (!xform_setup(&ras, options, outformat, resolutions, sheet_back, types, true, 0))
+    return (false);
+
+  (ras.start_job)(&ras, cb, ctx);
+
+  if (options->multiple_document_handling == IPPOPT_HANDLING_UNCOLLATED_COPIES)
+  {
+    // Uncollated copies are handled by the printer/driver...
+    ras.header.NumCopies      = options->copies;
+    ras.back_header.NumCopies = options->copies;
+    ras.sep_header.NumCopies  = options->copies;
+    copies                    = 1;
+  }
+  else
+  {
+    // Collated copies are handled by ipptransform, which needs to read each
+    // document again...
+    ras.header.NumCopies      = 1;
+    ras.back_header.NumCopies = 1;
+    ras.sep_header.NumCopies  = 1;
+    copies                    = options->copies;
+
+    for (i = num_documents, d = documents; i > 0 && copies > 1; i --, d ++)
+    {
+      if (!strcmp(d->filename, "-"))
+      {
+        cupsLangPrintf(stderr, _("%s: Unable to print collated copies from the standard input."), Prefix);
+        return (false);
+      }
+    }
+  }
+
+  for (copy = 0; copy < copies && ret; copy ++)
+  {
+    // Write a separator sheet as needed...
+    switch (options->separator_type)
+    {
+      case IPPOPT_SEPTYPE_NONE :
+      case IPPOPT_SEPTYPE_END_SHEET :
+          break;
+
+      case IPPOPT_SEPTYPE_SLIP_SHEETS :
+          if (copy == 0)
+            break;
+
+      case IPPOPT_SEPTYPE_START_SHEET :
+      case IPPOPT_SEPTYPE_BOTH_SHEETS :
+          xform_separator(&ras, cb, ctx);
+          break;
+    }
+
+    for (i = num_documents, d = documents; i > 0 && ret; i --, d ++)
+    {
+      // Open the document...
+      if (!strcmp(d->filename, "-"))
+      {
+        fd = 0;
+      }
+      else if ((fd = open(d->filename, O_RDONLY | O_BINARY)) < 0)
+      {
+	cupsLangPrintf(stderr, _("%s: Unable to open '%s': %s"), Prefix, d->filename, strerror(errno));
+	ret = false;
+	break;
+      }
+
+      if (fd == 0 && Stats.enabled)
+        raster = cupsRasterOpenIO((cups_raster_cb_t)stats_read, &fd, CUPS_RASTER_READ);
+      else
+        raster = cupsRasterOpen(fd, CUPS_RASTER_READ);
+
+      if (!raster)
+      {
+	cupsLangPrintf(stderr, _("%s: Unable to open '%s': %s"), Prefix, d->filename, cupsGetErrorString());
+	ret = false;
+      }
+
+      // Write pages as they are read...
+      stats_stage(XFORM_STAGE_RENDER);
+
+      while (ret && (status = ppm_read_raster(raster, &ras, &ppm)) != 0)
+      {
+        stats_stage(XFORM_STAGE_SETUP);
+
+        if (status < 0)
+        {
+          ret = false;
+          break;
+        }
+
+	page ++;
+
+	if (!ppm_write_page(&ras, &ppm, page, cb, ctx))
+	  ret = false;
+
+        // Skip any raster lines that were not used...
+        stats_stage(XFORM_STAGE_RENDER);
+
+        while (ret && ppm.rlines < ppm.rheader.cupsHeight && cupsRasterReadPixels(raster, ppm.rbuffer, ppm.rheader.cupsBytesPerLine))
+          ppm.rlines ++;
+
+        stats_stage(XFORM_STAGE_SETUP);
+
+        free(ppm.rbuffer);
+
+        if (!ret)
+          break;
+
+	// Log progress...
+	impressions ++;
+	fprintf(stderr, "ATTR: job-impressions-completed=%u\n", impressions);
+	if (!ras.header.Duplex || !(page & 1))
+	{
+	  media_sheets ++;
+	  fprintf(stderr, "ATTR: job-media-sheets-completed=%u\n", media_sheets);
+	}
+
+	stats_stage(XFORM_STAGE_RENDER);
+      }
+
+      stats_stage(XFORM_STAGE_SETUP);
+
+      cupsRasterClose(raster);
+
+      if (fd > 0)
+        close(fd);
+    }
+
+    if (!ret)
+      break;
+
+    // Write a separator sheet as needed...
+    switch (options->separator_type)
+    {
+      case IPPOPT_SEPTYPE_NONE :
+      case IPPOPT_SEPTYPE_START_SHEET :
+      case IPPOPT_SEPTYPE_SLIP_SHEETS :
+	  break;
+
+      case IPPOPT_SEPTYPE_END_SHEET :
+      case IPPOPT_SEPTYPE_BOTH_SHEETS :
+          xform_separator(&ras, cb, ctx);
+          break;
+    }
+  }
+
+  if (ret)
+    (ras.end_job)(&ras, cb, ctx);
+
+  return (ret);
+}
+#endif // !HAVE_COREGRAPHICS_H
+
+
 //
 // 'xform_setup()' - Setup a raster context for printing.
 //